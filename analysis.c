@@ -44,6 +44,8 @@ When analyzing in the background, various menus are disabled so the user does no
 #include "config.h"
 
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -93,6 +95,18 @@ int afAnalysePlayers[2] = { TRUE, TRUE };
 
 evalcontext ecLuck = { TRUE, 0, FALSE, TRUE, 0.0 };
 
+/* the moves of an analysis kept besides the one played, or 0 for all */
+unsigned int nAnalysisMoves = 0;
+
+/* "analyse match triage" analyses everything with esTriage first, then
+ * the decisions in the phtTriage of its context again with the full
+ * setup */
+static evalsetup esTriage = { EVAL_EVAL, { TRUE, 0, FALSE, TRUE, 0.0 } };
+
+/* With "set analysis cubescreen", a cube decision no double is better
+ * than double by this much at 0 plies isn't analysed any deeper */
+#define CUBE_SCREEN_MARGIN 0.2f
+
 extern ratingtype
 GetRating(const float rError)
 {
@@ -106,18 +120,21 @@ GetRating(const float rError)
     return RAT_UNDEFINED;
 }
 
-static float
-LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, const evalcontext * pec)
+/* The equity of each roll of the first move, aar[i][j] with i > j for
+ * pci->fMove and i < j for the other player, and the mean over them */
+static int
+LuckFirst(const TanBoard anBoard, float aar[6][6], float *prMean, const cubeinfo * pci, const evalcontext * pec)
 {
 
     TanBoard anBoardTemp;
     int i, j;
-    float aar[6][6], ar[NUM_ROLLOUT_OUTPUTS], rMean = 0.0f;
-    cubeinfo ciOpp;
+    float ar[NUM_ROLLOUT_OUTPUTS], rMean = 0.0f;
+    cubeinfo ci, ciOpp;
     movelist ml;
 
     /* first with player pci->fMove on roll */
 
+    memcpy(&ci, pci, sizeof(cubeinfo));
     memcpy(&ciOpp, pci, sizeof(cubeinfo));
     ciOpp.fMove = !pci->fMove;
 
@@ -129,7 +146,7 @@ LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, co
             if (FindnSaveBestMoves(&ml, i + 1, j + 1, (ConstTanBoard) anBoardTemp, NULL, 0.0f,
                                    pci, pec, defaultFilters) < 0) {
                 g_free(ml.amMoves);
-                return ERR_VAL;
+                return -1;
             }
 
             if (!ml.cMoves) {
@@ -137,7 +154,7 @@ LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, co
                 SwapSides(anBoardTemp);
 
                 if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, &ciOpp, pec) < 0)
-                    return ERR_VAL;
+                    return -1;
 
                 if (pec->fCubeful) {
                     if (pci->nMatchTo)
@@ -167,15 +184,15 @@ LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, co
             if (FindnSaveBestMoves(&ml, i + 1, j + 1, (ConstTanBoard) anBoardTemp, NULL, 0.0f,
                                    &ciOpp, pec, defaultFilters) < 0) {
                 g_free(ml.amMoves);
-                return ERR_VAL;
+                return -1;
             }
 
             if (!ml.cMoves) {
 
                 SwapSides(anBoardTemp);
 
-                if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, pci, pec) < 0)
-                    return ERR_VAL;
+                if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, &ci, pec) < 0)
+                    return -1;
 
                 if (pec->fCubeful) {
                     if (pci->nMatchTo)
@@ -194,20 +211,20 @@ LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, co
 
         }
 
-    if (n0 > n1)
-        return aar[n0][n1] - rMean / 30.0f;
-    else
-        return aar[n1][n0] - rMean / 30.0f;
+    *prMean = rMean / 30.0f;
+
+    return 0;
 
 }
 
-static float
-LuckNormal(const TanBoard anBoard, const int n0, const int n1, const cubeinfo * pci, const evalcontext * pec)
+/* The equity of each roll, aar[i][j] with i >= j, and their mean */
+static int
+LuckNormal(const TanBoard anBoard, float aar[6][6], float *prMean, const cubeinfo * pci, const evalcontext * pec)
 {
 
     TanBoard anBoardTemp;
     int i, j;
-    float aar[6][6], ar[NUM_ROLLOUT_OUTPUTS], rMean = 0.0f;
+    float ar[NUM_ROLLOUT_OUTPUTS], rMean = 0.0f;
     cubeinfo ciOpp;
     movelist ml;
 
@@ -222,7 +239,7 @@ LuckNormal(const TanBoard anBoard, const int n0, const int n1, const cubeinfo *
             if (FindnSaveBestMoves(&ml, i + 1, j + 1, (ConstTanBoard) anBoardTemp, NULL, 0.0f,
                                    pci, pec, defaultFilters) < 0) {
                 g_free(ml.amMoves);
-                return ERR_VAL;
+                return -1;
             }
 
             if (!ml.cMoves) {
@@ -230,7 +247,7 @@ LuckNormal(const TanBoard anBoard, const int n0, const int n1, const cubeinfo *
                 SwapSides(anBoardTemp);
 
                 if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, &ciOpp, pec) < 0)
-                    return ERR_VAL;
+                    return -1;
 
                 if (pec->fCubeful) {
                     if (pci->nMatchTo)
@@ -249,16 +266,100 @@ LuckNormal(const TanBoard anBoard, const int n0, const int n1, const cubeinfo *
 
         }
 
-    return aar[n0][n1] - rMean / 36.0f;
+    *prMean = rMean / 36.0f;
+
+    return 0;
 
 }
 
-extern float
-LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms)
+/* The rolls of the positions whose luck was computed last: a position
+ * is met again when a match is analysed once more, a single move or
+ * game is analysed before the match, or with other chequer or cube
+ * settings, and each of its 21 rolls costs a move search at the ply
+ * of ecLuck */
+#define LUCK_CACHE_SIZE 1024    /* a power of 2 */
+
+typedef struct {
+    int fUsed;
+    int fFirst;
+    positionkey key;
+    cubeinfo ci;
+    evalcontext ec;
+    float aar[6][6];
+    float rMean;
+} luckentry;
+
+static luckentry *aleLuck;
+G_LOCK_DEFINE_STATIC(aleLuck);
+
+static luckentry *
+LuckEntry(const positionkey * pkey)
+{
+    unsigned int i, h = 0;
+
+    for (i = 0; i < 7; i++)
+        h = h * 0x9E3779B1u + pkey->data[i];
+
+    return &aleLuck[(h ^ (h >> 16)) & (LUCK_CACHE_SIZE - 1)];
+}
+
+static int
+LuckLookup(const positionkey * pkey, int fFirst, const cubeinfo * pci, const evalcontext * pec, float aar[6][6],
+           float *prMean)
+{
+    luckentry *ple;
+    int fHit = FALSE;
+
+    G_LOCK(aleLuck);
+
+    if (aleLuck) {
+        ple = LuckEntry(pkey);
+        if (ple->fUsed && ple->fFirst == fFirst && EqualKeys(ple->key, *pkey)
+            && !memcmp(&ple->ci, pci, sizeof(cubeinfo)) && ple->ec.nPlies == pec->nPlies
+            && ple->ec.fCubeful == pec->fCubeful && ple->ec.fUsePrune == pec->fUsePrune
+            && ple->ec.fDeterministic == pec->fDeterministic && ple->ec.rNoise == pec->rNoise) {
+            memcpy(aar, ple->aar, sizeof(ple->aar));
+            *prMean = ple->rMean;
+            fHit = TRUE;
+        }
+    }
+
+    G_UNLOCK(aleLuck);
+
+    return fHit;
+}
+
+static void
+LuckAdd(const positionkey * pkey, int fFirst, const cubeinfo * pci, const evalcontext * pec, float aar[6][6],
+        float rMean)
+{
+    luckentry *ple;
+
+    G_LOCK(aleLuck);
+
+    if (!aleLuck)
+        aleLuck = g_new0(luckentry, LUCK_CACHE_SIZE);
+
+    ple = LuckEntry(pkey);
+    ple->fUsed = TRUE;
+    ple->fFirst = fFirst;
+    CopyKey(*pkey, ple->key);
+    memcpy(&ple->ci, pci, sizeof(cubeinfo));
+    memcpy(&ple->ec, pec, sizeof(evalcontext));
+    memcpy(ple->aar, aar, sizeof(ple->aar));
+    ple->rMean = rMean;
+
+    G_UNLOCK(aleLuck);
+}
+
+static float
+AnalyseLuck(const TanBoard anBoard, int n0, int n1, matchstate * pms, const evalcontext * pec)
 {
     cubeinfo ci;
-    int is_init_board;
+    int is_init_board, fFirst, fCache;
     TanBoard init_board;
+    positionkey key;
+    float aar[6][6], rMean;
 
     GetMatchStateCubeInfo(&ci, pms);
     InitBoard(init_board, pms->bgv);
@@ -267,10 +368,27 @@ LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms)
     if (n0-- < n1--)            /* -- because as input n0 and n1 are dice [1..6] but in calls to LuckXX() they are array indexes [0..5] */
         swap(&n0, &n1);
 
-    if (is_init_board && n0 != n1)      /* FIXME: this fails if we return to the initial position after a few moves */
-        return LuckFirst(anBoard, n0, n1, &ci, &ecLuck);
-    else
-        return LuckNormal(anBoard, n0, n1, &ci, &ecLuck);
+    /* FIXME: this fails if we return to the initial position after a few moves */
+    fFirst = is_init_board && n0 != n1;
+
+    /* noise that isn't a function of the position must be drawn anew */
+    fCache = pec->rNoise == 0.0f || pec->fDeterministic;
+    PositionKey(anBoard, &key);
+
+    if (!fCache || !LuckLookup(&key, fFirst, &ci, pec, aar, &rMean)) {
+        if ((fFirst ? LuckFirst(anBoard, aar, &rMean, &ci, pec) : LuckNormal(anBoard, aar, &rMean, &ci, pec)) < 0)
+            return ERR_VAL;
+        if (fCache)
+            LuckAdd(&key, fFirst, &ci, pec, aar, rMean);
+    }
+
+    return aar[n0][n1] - rMean;
+}
+
+extern float
+LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms)
+{
+    return AnalyseLuck(anBoard, n0, n1, pms, &ecLuck);
 }
 
 extern lucktype
@@ -604,12 +722,782 @@ updateStatcontext(statcontext * psc, const moverecord * pmr, const matchstate *
 
 }
 
+/* The results of recent analyses, to be used again when a position
+ * comes up with the same dice, cube and setup: the openings and the
+ * usual replies to them are in almost every match.  An entry holds the
+ * moves found for a roll, or a cube decision with anDice 0.
+ *
+ * The analyses stored in matches can be added too (see
+ * AnalysisCacheMatch()), in phtResultSeed.  Those entries are kept
+ * until the cache is cleared and don't know the move filters and
+ * threshold the moves were found with, so they do for any.  All the
+ * entries are of the weights and evaluator settings of auchResult. */
+#define RESULT_CACHE_SIZE 512   /* a power of 2 */
+#define RESULT_SEED_MAX 262144
+
+typedef struct {
+    int fUsed;
+    positionkey key;
+    unsigned int anDice[2];
+    cubeinfo ci;
+    evalcontext ec;
+    float rThreshold;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    movelist ml;
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+    float aarStdDev[2][NUM_ROLLOUT_OUTPUTS];
+} resultentry;
+
+static resultentry *areResult;
+static GHashTable *phtResultSeed;
+static unsigned char auchResult[16];
+static int nResultFlush = -1;   /* nCacheFlush when auchResult was checked */
+G_LOCK_DEFINE_STATIC(areResult);
+
+/* Whether evaluations with pec give the same results every time */
+static int
+Repeatable(const evalcontext * pec)
+{
+    return pec->rNoise == 0.0f || pec->fDeterministic;
+}
+
+static int
+EqualEvalContexts(const evalcontext * pec0, const evalcontext * pec1)
+{
+    return pec0->nPlies == pec1->nPlies && pec0->fCubeful == pec1->fCubeful && pec0->fUsePrune == pec1->fUsePrune
+        && pec0->fDeterministic == pec1->fDeterministic && pec0->rNoise == pec1->rNoise;
+}
+
+static guint
+ResultHash(const positionkey * pkey, const unsigned int anDice[2])
+{
+    unsigned int i, h = anDice[0] * 7 + anDice[1];
+
+    for (i = 0; i < 7; i++)
+        h = h * 0x9E3779B1u + pkey->data[i];
+
+    return h ^ (h >> 16);
+}
+
+static guint
+ResultSeedHash(gconstpointer p)
+{
+    const resultentry *pre = (const resultentry *) p;
+
+    return ResultHash(&pre->key, pre->anDice);
+}
+
+static gboolean
+ResultSeedEqual(gconstpointer p0, gconstpointer p1)
+{
+    const resultentry *pre0 = (const resultentry *) p0;
+    const resultentry *pre1 = (const resultentry *) p1;
+
+    return EqualKeys(pre0->key, pre1->key) && pre0->anDice[0] == pre1->anDice[0]
+        && pre0->anDice[1] == pre1->anDice[1] && !memcmp(&pre0->ci, &pre1->ci, sizeof(cubeinfo))
+        && EqualEvalContexts(&pre0->ec, &pre1->ec);
+}
+
+static void
+ResultSeedFree(gpointer p)
+{
+    resultentry *pre = (resultentry *) p;
+
+    g_free(pre->ml.amMoves);
+    g_free(pre);
+}
+
+/* Drop the results if they are of other weights or evaluator settings
+ * than the evaluations now; with areResult locked */
+static void
+ResultCheckEvaluator(void)
+{
+    unsigned char auch[16];
+    int n = MT_SafeGet(&nCacheFlush);
+    unsigned int i;
+
+    if (n == nResultFlush)
+        return;
+
+    nResultFlush = n;
+    EvalChecksum(auch);
+    if (!memcmp(auch, auchResult, sizeof(auch)))
+        return;
+    memcpy(auchResult, auch, sizeof(auch));
+
+    if (areResult)
+        for (i = 0; i < RESULT_CACHE_SIZE; i++)
+            if (areResult[i].fUsed) {
+                g_free(areResult[i].ml.amMoves);
+                memset(&areResult[i], 0, sizeof(resultentry));
+            }
+
+    if (phtResultSeed) {
+        g_hash_table_destroy(phtResultSeed);
+        phtResultSeed = NULL;
+    }
+}
+
+static resultentry *
+ResultEntry(const positionkey * pkey, const unsigned int anDice[2], const cubeinfo * pci,
+            const evalcontext * pec, const movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], int fFind)
+{
+    resultentry *pre, re;
+
+    ResultCheckEvaluator();
+
+    if (!areResult) {
+        if (fFind && !phtResultSeed)
+            return NULL;
+        areResult = g_new0(resultentry, RESULT_CACHE_SIZE);
+    }
+
+    pre = &areResult[ResultHash(pkey, anDice) & (RESULT_CACHE_SIZE - 1)];
+
+    if (fFind && !(pre->fUsed && EqualKeys(pre->key, *pkey) && pre->anDice[0] == anDice[0]
+                   && pre->anDice[1] == anDice[1] && !memcmp(&pre->ci, pci, sizeof(cubeinfo))
+                   && EqualEvalContexts(&pre->ec, pec) && pre->rThreshold == arSkillLevel[SKILL_DOUBTFUL]
+                   && (!aamf || !memcmp(pre->aamf, aamf, sizeof(pre->aamf))))) {
+        if (!phtResultSeed)
+            return NULL;
+
+        CopyKey(*pkey, re.key);
+        re.anDice[0] = anDice[0];
+        re.anDice[1] = anDice[1];
+        memcpy(&re.ci, pci, sizeof(cubeinfo));
+        memcpy(&re.ec, pec, sizeof(evalcontext));
+        return (resultentry *) g_hash_table_lookup(phtResultSeed, &re);
+    }
+
+    return pre;
+}
+
+static void
+ResultFill(resultentry * pre, const positionkey * pkey, const unsigned int anDice[2], const cubeinfo * pci,
+           const evalcontext * pec, const movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    if (pre->fUsed && pre->ml.cMoves)
+        g_free(pre->ml.amMoves);
+
+    pre->fUsed = TRUE;
+    CopyKey(*pkey, pre->key);
+    pre->anDice[0] = anDice[0];
+    pre->anDice[1] = anDice[1];
+    memcpy(&pre->ci, pci, sizeof(cubeinfo));
+    memcpy(&pre->ec, pec, sizeof(evalcontext));
+    pre->rThreshold = arSkillLevel[SKILL_DOUBTFUL];
+    if (aamf)
+        memcpy(pre->aamf, aamf, sizeof(pre->aamf));
+    else
+        memset(pre->aamf, 0, sizeof(pre->aamf));
+    pre->ml.cMoves = 0;
+    pre->ml.amMoves = NULL;
+}
+
+/* Add an analysis of a match to the seeded results, with areResult
+ * locked; FALSE if there is no room for it */
+static int
+ResultSeed(const positionkey * pkey, const unsigned int anDice[2], const cubeinfo * pci,
+           const evalcontext * pec, const movelist * pml, float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
+           float aarStdDev[2][NUM_ROLLOUT_OUTPUTS])
+{
+    resultentry *pre;
+
+    ResultCheckEvaluator();
+
+    if (!phtResultSeed)
+        phtResultSeed = g_hash_table_new_full(ResultSeedHash, ResultSeedEqual, ResultSeedFree, NULL);
+    else if (g_hash_table_size(phtResultSeed) >= RESULT_SEED_MAX)
+        return FALSE;
+
+    pre = g_new0(resultentry, 1);
+    pre->fUsed = TRUE;
+    CopyKey(*pkey, pre->key);
+    pre->anDice[0] = anDice[0];
+    pre->anDice[1] = anDice[1];
+    memcpy(&pre->ci, pci, sizeof(cubeinfo));
+    memcpy(&pre->ec, pec, sizeof(evalcontext));
+
+    if (g_hash_table_lookup(phtResultSeed, pre)) {
+        /* the first analysis of the position is as good as any */
+        g_free(pre);
+        return TRUE;
+    }
+
+    if (pml)
+        CopyMoveList(&pre->ml, pml);
+    else {
+        memcpy(pre->aarOutput, aarOutput, sizeof(pre->aarOutput));
+        memcpy(pre->aarStdDev, aarStdDev, sizeof(pre->aarStdDev));
+    }
+    g_hash_table_insert(phtResultSeed, pre, pre);
+
+    return TRUE;
+}
+
+/* GeneralCubeDecision() for the analysis, through the result cache */
+static int
+AnalyseCube(float aarOutput[2][NUM_ROLLOUT_OUTPUTS], float aarStdDev[2][NUM_ROLLOUT_OUTPUTS],
+            const TanBoard anBoard, cubeinfo * pci, evalsetup * pes)
+{
+    static const unsigned int anNoDice[2] = { 0, 0 };
+    int fCache = pes->et == EVAL_EVAL && Repeatable(&pes->ec);
+    positionkey key;
+    resultentry *pre;
+
+    if (fCache) {
+        PositionKey(anBoard, &key);
+
+        G_LOCK(areResult);
+        if ((pre = ResultEntry(&key, anNoDice, pci, &pes->ec, NULL, TRUE)) != NULL) {
+            memcpy(aarOutput, pre->aarOutput, sizeof(pre->aarOutput));
+            memcpy(aarStdDev, pre->aarStdDev, sizeof(pre->aarStdDev));
+        }
+        G_UNLOCK(areResult);
+
+        if (pre)
+            return 0;
+    }
+
+    if (GeneralCubeDecision(aarOutput, aarStdDev, NULL, anBoard, pci, pes, NULL, NULL) < 0)
+        return -1;
+
+    if (fCache) {
+        G_LOCK(areResult);
+        pre = ResultEntry(&key, anNoDice, pci, &pes->ec, NULL, FALSE);
+        ResultFill(pre, &key, anNoDice, pci, &pes->ec, NULL);
+        memcpy(pre->aarOutput, aarOutput, sizeof(pre->aarOutput));
+        memcpy(pre->aarStdDev, aarStdDev, sizeof(pre->aarStdDev));
+        G_UNLOCK(areResult);
+    }
+
+    return 0;
+}
+
+/* getResignation() for the analysis, taking the evaluation of the
+ * position from a cube analysis of it at the same settings if there is
+ * one in the result cache */
+static int
+AnalyseResign(float arResign[NUM_ROLLOUT_OUTPUTS], TanBoard anBoard, cubeinfo * pci, evalsetup * pes)
+{
+    static const unsigned int anNoDice[2] = { 0, 0 };
+    positionkey key;
+    resultentry *pre;
+
+    if (pes->et == EVAL_EVAL && Repeatable(&pes->ec)) {
+        PositionKey((ConstTanBoard) anBoard, &key);
+
+        G_LOCK(areResult);
+        if ((pre = ResultEntry(&key, anNoDice, pci, &pes->ec, NULL, TRUE)) != NULL)
+            memcpy(arResign, pre->aarOutput[0], NUM_ROLLOUT_OUTPUTS * sizeof(float));
+        G_UNLOCK(areResult);
+
+        if (pre)
+            return ResignDecision(arResign, pci);
+    }
+
+    return getResignation(arResign, anBoard, pci, pes);
+}
+
+/* FindnSaveBestMoves() for the analysis of the move *pkey, through the
+ * result cache: moves found for another play of the roll do if they
+ * hold this one, evaluated as deep as the rest */
+static int
+AnalyseMoves(movelist * pml, const unsigned int anDice[2], const TanBoard anBoard, const positionkey * pkey,
+             const cubeinfo * pci, const evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    int fCache = Repeatable(pec);
+    positionkey keyBoard;
+    resultentry *pre;
+    unsigned int i;
+
+    if (fCache) {
+        PositionKey(anBoard, &keyBoard);
+
+        G_LOCK(areResult);
+        if ((pre = ResultEntry(&keyBoard, anDice, pci, pec, (ConstTmoveFilter) aamf, TRUE)) != NULL) {
+            for (i = 0; i < pre->ml.cMoves; i++)
+                if (EqualKeys(*pkey, pre->ml.amMoves[i].key))
+                    break;
+            if (i < pre->ml.cMoves && pre->ml.amMoves[i].esMove.ec.nPlies == pec->nPlies)
+                CopyMoveList(pml, &pre->ml);
+            else
+                pre = NULL;
+        }
+        G_UNLOCK(areResult);
+
+        if (pre)
+            return 0;
+    }
+
+    if (FindnSaveBestMoves(pml, (int) anDice[0], (int) anDice[1], anBoard, (positionkey *) pkey,
+                           arSkillLevel[SKILL_DOUBTFUL], pci, pec, aamf) < 0)
+        return -1;
+
+    if (fCache && pml->cMoves) {
+        G_LOCK(areResult);
+        pre = ResultEntry(&keyBoard, anDice, pci, pec, (ConstTmoveFilter) aamf, FALSE);
+        ResultFill(pre, &keyBoard, anDice, pci, pec, (ConstTmoveFilter) aamf);
+        CopyMoveList(&pre->ml, pml);
+        G_UNLOCK(areResult);
+    }
+
+    return 0;
+}
+
+/* Keep the analyses of plGame made with evaluations in the result
+ * cache, and their moves in the evaluation cache */
+static void
+AnalysisCacheGame(listOLD * plGame, unsigned int *pcMoves, unsigned int *pcCubes, int *pfFull)
+{
+    static const unsigned int anNoDice[2] = { 0, 0 };
+    listOLD *pl;
+    matchstate msPosition;
+    positionkey key;
+    cubeinfo ci;
+    unsigned int i;
+
+    for (pl = plGame->plNext; pl != plGame && !*pfFull; pl = pl->plNext) {
+        moverecord *pmr = pl->p;
+        const evalsetup *pesCube = NULL;
+
+        FixMatchState(&msPosition, pmr);
+
+        switch (pmr->mt) {
+        case MOVE_NORMAL:
+            if (pmr->fPlayer != msPosition.fMove) {
+                SwapSides(msPosition.anBoard);
+                msPosition.fMove = pmr->fPlayer;
+            }
+            GetMatchStateCubeInfo(&ci, &msPosition);
+            PositionKey((ConstTanBoard) msPosition.anBoard, &key);
+            pesCube = &pmr->CubeDecPtr->esDouble;
+
+            if (pmr->esChequer.et != EVAL_EVAL || !Repeatable(&pmr->esChequer.ec) || !pmr->ml.cMoves)
+                break;
+
+            G_LOCK(areResult);
+            if (ResultSeed(&key, pmr->anDice, &ci, &pmr->esChequer.ec, &pmr->ml, NULL, NULL))
+                (*pcMoves)++;
+            else
+                *pfFull = TRUE;
+            G_UNLOCK(areResult);
+
+            for (i = 0; i < pmr->ml.cMoves; i++)
+                EvalCacheSeedMove(&pmr->ml.amMoves[i], &ci);
+            break;
+
+        case MOVE_DOUBLE:
+            if (DoubleType(msPosition.fDoubled, msPosition.fMove, msPosition.fTurn) != DT_NORMAL)
+                break;
+            GetMatchStateCubeInfo(&ci, &msPosition);
+            PositionKey((ConstTanBoard) msPosition.anBoard, &key);
+            pesCube = &pmr->CubeDecPtr->esDouble;
+            break;
+
+        default:
+            break;
+        }
+
+        if (pesCube && pesCube->et == EVAL_EVAL && Repeatable(&pesCube->ec)) {
+            G_LOCK(areResult);
+            if (ResultSeed(&key, anNoDice, &ci, &pesCube->ec, NULL, pmr->CubeDecPtr->aarOutput,
+                           pmr->CubeDecPtr->aarStdDev))
+                (*pcCubes)++;
+            else
+                *pfFull = TRUE;
+            G_UNLOCK(areResult);
+        }
+
+        ApplyMoveRecord(&msPosition, plGame, pmr);
+    }
+}
+
+/* Keep the analyses stored in the match in the result cache and the
+ * evaluation cache, for the matches analysed later.  They are taken to
+ * be of the weights there are now.  FALSE if the cache is full. */
+extern int
+AnalysisCacheMatch(unsigned int *pcMoves, unsigned int *pcCubes)
+{
+    listOLD *pl;
+    int fFull = FALSE;
+
+    for (pl = lMatch.plNext; pl != &lMatch && !fFull; pl = pl->plNext)
+        AnalysisCacheGame(pl->p, pcMoves, pcCubes, &fFull);
+
+    return !fFull;
+}
+
+/* Keep the nMoves best moves of pml, which is sorted, and the one
+ * played, *pkey: the others take most of the memory of a long analysed
+ * session.  Clearing and analysing the move again brings them back. */
+static void
+TrimMoveList(movelist * pml, const positionkey * pkey, unsigned int nMoves)
+{
+    unsigned int i;
+
+    if (!nMoves || pml->cMoves <= nMoves)
+        return;
+
+    for (i = nMoves; i < pml->cMoves; i++)
+        if (EqualKeys(*pkey, pml->amMoves[i].key)) {
+            pml->amMoves[nMoves] = pml->amMoves[i];
+            pml->cMoves = nMoves + 1;
+            return;
+        }
+
+    pml->cMoves = nMoves;
+}
+
+/* The journal of an analysis of the match: each decision as its task
+ * is done, so that an analysis stopped half way (by an interrupt, or
+ * the machine going away) goes on with "analyse resume" from there.
+ * It is a journalheader, then a journalentry for each decision done,
+ * followed by the moves of its move list.  The layout is that of the
+ * build writing it: a journal is for resuming, not for keeping. */
+#define JOURNAL_MAGIC "gnubg-journal-1"
+
+typedef struct {
+    char szMagic[16];
+    unsigned int cbEntry, cbMove;       /* to tell another layout */
+    unsigned int cRecords;      /* of the match */
+    guint32 nFingerprint;       /* of its moves */
+    unsigned char auchWeights[16];      /* EvalChecksum() */
+} journalheader;
+
+typedef struct {
+    unsigned int iRecord;       /* in the match, counting the gameinfos */
+    movetype mt;
+    lucktype lt;
+    float rLuck;
+    evalsetup esChequer;
+    movelist ml;                /* its moves follow */
+    unsigned int iMove;
+    skilltype stMove;
+    skilltype stCube;
+    cubedecisiondata cd;        /* of MOVE_NORMAL and MOVE_DOUBLE */
+    xmoveresign r;              /* of MOVE_RESIGN */
+} journalentry;
+
+struct _analysisjournal {
+    char *szFile;
+    FILE *pf;
+    int fError;                 /* a write failed; nothing more goes */
+    journalheader jh;
+    moverecord **apmr;          /* the records of the match, in order */
+    GHashTable *phtIndex;       /* their index in apmr + 1 */
+    GHashTable *phtDone;        /* the ones read back */
+};
+
+G_LOCK_DEFINE_STATIC(journal);
+
+static guint32
+JournalFingerprint(void)
+{
+    listOLD *plGame, *pl;
+    guint32 h = 0;
+    unsigned int i;
+
+    for (plGame = lMatch.plNext; plGame != &lMatch; plGame = plGame->plNext)
+        for (pl = ((listOLD *) plGame->p)->plNext; pl != plGame->p; pl = pl->plNext) {
+            const moverecord *pmr = pl->p;
+
+            h = h * 0x9E3779B1u + (guint32) pmr->mt * 2 + (guint32) pmr->fPlayer;
+            h = h * 0x9E3779B1u + pmr->anDice[0] * 7 + pmr->anDice[1];
+            if (pmr->mt == MOVE_NORMAL)
+                for (i = 0; i < 8; i++)
+                    h = h * 0x9E3779B1u + (guint32) (pmr->n.anMove[i] + 1);
+        }
+
+    return h ^ (h >> 16);
+}
+
+/* A journal of the match, with nothing done yet */
+static analysisjournal *
+JournalNew(const char *szFile)
+{
+    analysisjournal *paj = g_new0(analysisjournal, 1);
+    listOLD *plGame, *pl;
+    unsigned int i = 0;
+
+    paj->szFile = g_strdup(szFile);
+    paj->phtIndex = g_hash_table_new(g_direct_hash, g_direct_equal);
+    paj->phtDone = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    for (plGame = lMatch.plNext; plGame != &lMatch; plGame = plGame->plNext)
+        for (pl = ((listOLD *) plGame->p)->plNext; pl != plGame->p; pl = pl->plNext)
+            paj->jh.cRecords++;
+
+    paj->apmr = g_new(moverecord *, paj->jh.cRecords);
+    for (plGame = lMatch.plNext; plGame != &lMatch; plGame = plGame->plNext)
+        for (pl = ((listOLD *) plGame->p)->plNext; pl != plGame->p; pl = pl->plNext) {
+            paj->apmr[i] = pl->p;
+            g_hash_table_insert(paj->phtIndex, pl->p, GUINT_TO_POINTER(++i));
+        }
+
+    memcpy(paj->jh.szMagic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    paj->jh.cbEntry = sizeof(journalentry);
+    paj->jh.cbMove = sizeof(move);
+    paj->jh.nFingerprint = JournalFingerprint();
+    EvalChecksum(paj->jh.auchWeights);
+
+    return paj;
+}
+
+static int
+JournalDone(const analysiscontext * pac, const moverecord * pmr)
+{
+    return pac->paj && g_hash_table_lookup(pac->paj->phtDone, pmr);
+}
+
+static int
+JournalWrite(FILE * pf, const moverecord * pmr, unsigned int iRecord)
+{
+    journalentry je;
+
+    memset(&je, 0, sizeof(je));
+    je.iRecord = iRecord;
+    je.mt = pmr->mt;
+    je.lt = pmr->lt;
+    je.rLuck = pmr->rLuck;
+    je.esChequer = pmr->esChequer;
+    if (pmr->mt == MOVE_NORMAL) {
+        je.ml = pmr->ml;
+        je.ml.amMoves = NULL;
+        je.iMove = pmr->n.iMove;
+        je.stMove = pmr->n.stMove;
+    }
+    je.stCube = pmr->stCube;
+    /* the take or drop shares the cube analysis of the double */
+    if (pmr->mt == MOVE_NORMAL || pmr->mt == MOVE_DOUBLE)
+        je.cd = *pmr->CubeDecPtr;
+    je.r = pmr->r;
+
+    if (fwrite(&je, sizeof(je), 1, pf) != 1)
+        return -1;
+    if (je.ml.cMoves && fwrite(pmr->ml.amMoves, sizeof(move), je.ml.cMoves, pf) != je.ml.cMoves)
+        return -1;
+
+    return 0;
+}
+
+/* Put the analysis of *pje and its moves, which it keeps, into pmr */
+static void
+JournalApply(moverecord * pmr, const journalentry * pje, move * amMoves)
+{
+    pmr->lt = pje->lt;
+    pmr->rLuck = pje->rLuck;
+    pmr->esChequer = pje->esChequer;
+    pmr->stCube = pje->stCube;
+
+    switch (pmr->mt) {
+    case MOVE_NORMAL:
+        if (pmr->ml.cMoves)
+            g_free(pmr->ml.amMoves);
+        pmr->ml = pje->ml;
+        pmr->ml.amMoves = amMoves;
+        pmr->n.iMove = pje->iMove;
+        pmr->n.stMove = pje->stMove;
+        *pmr->CubeDecPtr = pje->cd;
+        break;
+
+    case MOVE_DOUBLE:
+        *pmr->CubeDecPtr = pje->cd;
+        break;
+
+    case MOVE_RESIGN:
+        pmr->r.esResign = pje->r.esResign;
+        memcpy(pmr->r.arResign, pje->r.arResign, sizeof(pmr->r.arResign));
+        pmr->r.stResign = pje->r.stResign;
+        pmr->r.stAccept = pje->r.stAccept;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Read the journal back into the match, as far as it goes: the last
+ * entry can be cut short by the end of the analysis writing it */
+static int
+JournalRead(analysisjournal * paj)
+{
+    journalheader jh;
+    journalentry je;
+    FILE *pf;
+
+    if ((pf = g_fopen(paj->szFile, "rb")) == NULL) {
+        outputerr(paj->szFile);
+        return -1;
+    }
+
+    if (fread(&jh, sizeof(jh), 1, pf) != 1 || memcmp(jh.szMagic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))
+        || jh.cbEntry != paj->jh.cbEntry || jh.cbMove != paj->jh.cbMove) {
+        outputf(_("`%s' is not an analysis journal of this version of GNU Backgammon.\n"), paj->szFile);
+        fclose(pf);
+        return -1;
+    }
+
+    if (jh.cRecords != paj->jh.cRecords || jh.nFingerprint != paj->jh.nFingerprint) {
+        outputf(_("`%s' is the analysis journal of another match.\n"), paj->szFile);
+        fclose(pf);
+        return -1;
+    }
+
+    if (memcmp(jh.auchWeights, paj->jh.auchWeights, sizeof(jh.auchWeights))) {
+        outputf(_("`%s' was written with other neural net weights.\n"), paj->szFile);
+        fclose(pf);
+        return -1;
+    }
+
+    while (fread(&je, sizeof(je), 1, pf) == 1) {
+        moverecord *pmr;
+        move *amMoves = NULL;
+
+        if (je.iRecord >= paj->jh.cRecords || (pmr = paj->apmr[je.iRecord])->mt != je.mt
+            || (je.ml.cMoves && je.iMove >= je.ml.cMoves))
+            break;
+
+        if (je.ml.cMoves) {
+            amMoves = g_new(move, je.ml.cMoves);
+            if (fread(amMoves, sizeof(move), je.ml.cMoves, pf) != je.ml.cMoves) {
+                g_free(amMoves);
+                break;
+            }
+        }
+
+        JournalApply(pmr, &je, amMoves);
+        g_hash_table_insert(paj->phtDone, pmr, GINT_TO_POINTER(TRUE));
+    }
+
+    fclose(pf);
+
+    return 0;
+}
+
+/* Write the header and the decisions done so far to a new journal,
+ * which replaces the old one, and keep it open for the rest */
+static int
+JournalStart(analysisjournal * paj)
+{
+    char *szTemp = g_strconcat(paj->szFile, ".tmp", NULL);
+    unsigned int i;
+    FILE *pf;
+
+    if ((pf = g_fopen(szTemp, "wb")) == NULL) {
+        outputerr(szTemp);
+        g_free(szTemp);
+        return -1;
+    }
+
+    if (fwrite(&paj->jh, sizeof(paj->jh), 1, pf) != 1)
+        paj->fError = TRUE;
+    for (i = 0; i < paj->jh.cRecords && !paj->fError; i++)
+        if (g_hash_table_lookup(paj->phtDone, paj->apmr[i]) && JournalWrite(pf, paj->apmr[i], i) < 0)
+            paj->fError = TRUE;
+
+    if (fclose(pf) || paj->fError) {
+        outputerr(szTemp);
+        g_unlink(szTemp);
+        g_free(szTemp);
+        return -1;
+    }
+
+    /* a rename doesn't replace a file everywhere */
+    if (g_rename(szTemp, paj->szFile) && (g_unlink(paj->szFile) || g_rename(szTemp, paj->szFile))) {
+        outputerr(paj->szFile);
+        g_free(szTemp);
+        return -1;
+    }
+    g_free(szTemp);
+
+    if ((paj->pf = g_fopen(paj->szFile, "ab")) == NULL) {
+        outputerr(paj->szFile);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Append the decisions of a task, a double linked to its take or drop
+ * going with it, once they are all done */
+static void
+JournalTask(analysisjournal * paj, Task * task)
+{
+    G_LOCK(journal);
+
+    for (; task && !paj->fError; task = task->pLinkedTask) {
+        const moverecord *pmr = ((AnalyseMoveTask *) task)->pmr;
+        gpointer p = g_hash_table_lookup(paj->phtIndex, pmr);
+
+        if (p && JournalWrite(paj->pf, pmr, GPOINTER_TO_UINT(p) - 1) < 0)
+            paj->fError = TRUE;
+    }
+
+    if (!paj->fError && fflush(paj->pf))
+        paj->fError = TRUE;
+
+    G_UNLOCK(journal);
+}
+
+static void
+JournalClose(analysisjournal * paj)
+{
+    if (paj->pf && fclose(paj->pf))
+        paj->fError = TRUE;
+
+    if (paj->fError)
+        outputf(_("The analysis journal `%s' could not be written.\n"), paj->szFile);
+
+    g_hash_table_destroy(paj->phtIndex);
+    g_hash_table_destroy(paj->phtDone);
+    g_free(paj->apmr);
+    g_free(paj->szFile);
+    g_free(paj);
+}
+
+/* The setup to analyse pmr with: the quick one in the first pass of
+ * a triage, and in the second for the decisions it didn't flag */
+static const evalsetup *
+TriageSetup(const analysiscontext * pac, const moverecord * pmr, const evalsetup * pes)
+{
+    if (pac->phtTriage && !g_hash_table_lookup(pac->phtTriage, pmr))
+        return &esTriage;
+
+    return pes;
+}
+
+extern void
+GetAnalysisContext(analysiscontext * pac)
+{
+    pac->esChequer = esAnalysisChequer;
+    pac->esCube = esAnalysisCube;
+    memcpy(pac->aamf, aamfAnalysis, sizeof(pac->aamf));
+    pac->ecLuck = ecLuck;
+    pac->afPlayers[0] = afAnalysePlayers[0];
+    pac->afPlayers[1] = afAnalysePlayers[1];
+    pac->fMove = fAnalyseMove;
+    pac->fCube = fAnalyseCube;
+    pac->fDice = fAnalyseDice;
+    pac->fKeepLuck = FALSE;
+    pac->nMoves = nAnalysisMoves;
+    pac->phtTriage = NULL;
+    pac->fCubeScreen = fAnalyseCubeScreen;
+    pac->pcCubeScreened = NULL;
+    pac->paj = NULL;
+}
+
 extern int
 AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
-            statcontext * psc, const evalsetup * pesChequer, evalsetup * pesCube,
-            /* const */ movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], const int analysePlayers[2],
-            float *doubleError)
+            statcontext * psc, const analysiscontext * pac, float *doubleError)
 {
+    /* copies, as the evaluations take them writable */
+    evalsetup esChequer = *TriageSetup(pac, pmr, &pac->esChequer);
+    evalsetup esCube = *TriageSetup(pac, pmr, &pac->esCube);
+    evalsetup *pesChequer = &esChequer;
+    evalsetup *pesCube = &esCube;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    const int *analysePlayers = pac->afPlayers;
     TanBoard anBoardMove;
     cubeinfo ci;
     float rSkill, rChequerSkill;
@@ -620,6 +1508,16 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
     taketype tt;
     const xmovegameinfo *pmgi = &((moverecord *) plParentGame->plNext->p)->g;
     int is_initial_position = 1;
+    int fDone = JournalDone(pac, pmr);
+
+    memcpy(aamf, pac->aamf, sizeof(aamf));
+
+    /* a decision read back from the journal keeps its analysis, only
+     * the statistics are left to do */
+    if (fDone) {
+        esChequer = pmr->esChequer;
+        esCube = pmr->mt == MOVE_RESIGN ? pmr->r.esResign : pmr->CubeDecPtr->esDouble;
+    }
 
     /* analyze this move */
 
@@ -633,7 +1531,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         is_initial_position = !memcmp(anBoardMove, pms->anBoard, 2 * 25 * sizeof(int));
     }
 
-    MT_Exclusive();
+    MT_Lock(MT_LOCK_MATCH);
     switch (pmr->mt) {
     case MOVE_GAMEINFO:
 
@@ -656,17 +1554,35 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
         /* cube action? */
 
-        if (!is_initial_position && fAnalyseCube && pmgi->fCubeUse && GetDPEq(NULL, NULL, &ci)) {
+        if (!is_initial_position && pac->fCube && pmgi->fCubeUse && GetDPEq(NULL, NULL, &ci)) {
             float arDouble[NUM_CUBEFUL_OUTPUTS];
 
             if (cmp_evalsetup(pesCube, &pmr->CubeDecPtr->esDouble) > 0) {
-                MT_Release();
-                if (GeneralCubeDecision(aarOutput, aarStdDev, NULL,
-                                        (ConstTanBoard) pms->anBoard, &ci, pesCube, NULL, NULL) < 0)
+                evalsetup esScreen = esTriage;
+                evalsetup *pes = pesCube;
+
+                MT_Unlock(MT_LOCK_MATCH);
+
+                /* far from a double the deeper analysis can't tell
+                 * another story; it is worth it for a missed double */
+                if (pac->fCubeScreen && cmp_evalsetup(pesCube, &esScreen) > 0) {
+                    if (AnalyseCube(aarOutput, aarStdDev, (ConstTanBoard) pms->anBoard, &ci, &esScreen) < 0)
+                        return -1;
+
+                    FindCubeDecision(arDouble, aarOutput, &ci);
+                    if (arDouble[OUTPUT_NODOUBLE] - MIN(arDouble[OUTPUT_TAKE], arDouble[OUTPUT_DROP]) >=
+                        CUBE_SCREEN_MARGIN) {
+                        pes = &esScreen;
+                        if (pac->pcCubeScreened)
+                            MT_SafeInc(pac->pcCubeScreened);
+                    }
+                }
+
+                if (pes == pesCube && AnalyseCube(aarOutput, aarStdDev, (ConstTanBoard) pms->anBoard, &ci, pes) < 0)
                     return -1;
-                MT_Exclusive();
+                MT_Lock(MT_LOCK_MATCH);
 
-                pmr->CubeDecPtr->esDouble = *pesCube;
+                pmr->CubeDecPtr->esDouble = *pes;
 
                 memcpy(pmr->CubeDecPtr->aarOutput, aarOutput, sizeof(aarOutput));
                 memcpy(pmr->CubeDecPtr->aarStdDev, aarStdDev, sizeof(aarStdDev));
@@ -682,14 +1598,14 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
         /* luck analysis */
 
-        if (fAnalyseDice) {
-            pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
+        if (pac->fDice && !((pac->fKeepLuck || fDone) && pmr->rLuck != ERR_VAL)) {
+            pmr->rLuck = AnalyseLuck((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms, &pac->ecLuck);
             pmr->lt = Luck(pmr->rLuck);
         }
 
         /* evaluate move */
 
-        if (fAnalyseMove) {
+        if (pac->fMove) {
             positionkey key;
 
             /* evaluate move */
@@ -698,7 +1614,14 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
             ApplyMove(anBoardMove, pmr->n.anMove, FALSE);
             PositionKey((ConstTanBoard) anBoardMove, &key);
 
-            if (cmp_evalsetup(pesChequer, &pmr->esChequer) > 0) {
+            /* keep a stored analysis at least as good as asked for,
+             * unless the move played isn't in it (it was edited, or the
+             * analysis imported lists only the best moves) */
+            for (pmr->n.iMove = 0; pmr->n.iMove < pmr->ml.cMoves; pmr->n.iMove++)
+                if (EqualKeys(key, pmr->ml.amMoves[pmr->n.iMove].key))
+                    break;
+
+            if (cmp_evalsetup(pesChequer, &pmr->esChequer) > 0 || pmr->n.iMove == pmr->ml.cMoves) {
 
                 if (pmr->ml.cMoves) {
                     g_free(pmr->ml.amMoves);
@@ -709,15 +1632,14 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
                 {
                     movelist ml;
-                    MT_Release();
-                    if (FindnSaveBestMoves(&ml, pmr->anDice[0],
-                                           pmr->anDice[1],
-                                           (ConstTanBoard) pms->anBoard, &key,
-                                           arSkillLevel[SKILL_DOUBTFUL], &ci, &pesChequer->ec, aamf) < 0) {
+                    MT_Unlock(MT_LOCK_MATCH);
+                    if (AnalyseMoves(&ml, pmr->anDice, (ConstTanBoard) pms->anBoard, &key, &ci, &pesChequer->ec,
+                                     aamf) < 0) {
                         g_free(ml.amMoves);
                         return -1;
                     }
-                    MT_Exclusive();
+                    MT_Lock(MT_LOCK_MATCH);
+                    TrimMoveList(&ml, &key, pac->nMoves);
                     CopyMoveList(&pmr->ml, &ml);
                     if (ml.cMoves) {
                         g_free(ml.amMoves);
@@ -753,18 +1675,17 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
             break;
 
         /* cube action */
-        if (fAnalyseCube && pmgi->fCubeUse) {
+        if (pac->fCube && pmgi->fCubeUse) {
             GetMatchStateCubeInfo(&ci, pms);
 
             if (GetDPEq(NULL, NULL, &ci) || ci.fCubeOwner < 0 || ci.fCubeOwner == ci.fMove) {
                 float arDouble[NUM_CUBEFUL_OUTPUTS];
 
                 if (cmp_evalsetup(pesCube, &pmr->CubeDecPtr->esDouble) > 0) {
-                    MT_Release();
-                    if (GeneralCubeDecision(aarOutput, aarStdDev,
-                                            NULL, (ConstTanBoard) pms->anBoard, &ci, pesCube, NULL, NULL) < 0)
+                    MT_Unlock(MT_LOCK_MATCH);
+                    if (AnalyseCube(aarOutput, aarStdDev, (ConstTanBoard) pms->anBoard, &ci, pesCube) < 0)
                         return -1;
-                    MT_Exclusive();
+                    MT_Lock(MT_LOCK_MATCH);
 
                     pmr->CubeDecPtr->esDouble = *pesCube;
                 } else {
@@ -803,7 +1724,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         if (tt > TT_NORMAL)     /* TODO: analyse beavers */
             break;
 
-        if (fAnalyseCube && pmgi->fCubeUse && doubleError && (*doubleError != ERR_VAL)) {
+        if (pac->fCube && pmgi->fCubeUse && doubleError && (*doubleError != ERR_VAL)) {
             GetMatchStateCubeInfo(&ci, pms);
             pmr->stCube = Skill(-*doubleError);
         }
@@ -823,7 +1744,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         if (tt > TT_NORMAL)     /* TODO: analyse beavers */
             break;
 
-        if (fAnalyseCube && pmgi->fCubeUse && doubleError && (*doubleError != ERR_VAL)) {
+        if (pac->fCube && pmgi->fCubeUse && doubleError && (*doubleError != ERR_VAL)) {
             GetMatchStateCubeInfo(&ci, pms);
             pmr->stCube = Skill(*doubleError);
         }
@@ -854,7 +1775,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
             if (cmp_evalsetup(pesCube, &pmr->r.esResign) > 0) {
 
-                getResignation(pmr->r.arResign, pms->anBoard, &ci, pesCube);
+                AnalyseResign(pmr->r.arResign, pms->anBoard, &ci, pesCube);
 
             }
 
@@ -893,8 +1814,8 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
         GetMatchStateCubeInfo(&ci, pms);
 
-        if (fAnalyseDice) {
-            pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
+        if (pac->fDice && !((pac->fKeepLuck || fDone) && pmr->rLuck != ERR_VAL)) {
+            pmr->rLuck = AnalyseLuck((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms, &pac->ecLuck);
             pmr->lt = Luck(pmr->rLuck);
         }
 
@@ -912,13 +1833,13 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
     ApplyMoveRecord(pms, plParentGame, pmr);
 
     if (psc) {
-        psc->fMoves = fAnalyseMove;
-        psc->fCube = fAnalyseCube;
-        psc->fDice = fAnalyseDice;
+        psc->fMoves = pac->fMove;
+        psc->fCube = pac->fCube;
+        psc->fDice = pac->fDice;
     }
-    MT_Release();
+    MT_Unlock(MT_LOCK_MATCH);
 
-    return fInterrupt ? -1 : 0;
+    return MT_Cancelled() ? -1 : 0;
 }
 
 static int
@@ -949,20 +1870,29 @@ AnalyseMoveMT(Task * task)
     AnalyseMoveTask *amt;
     float doubleError = 0.0f;
 
+    Task *taskFirst = task;
+    int fFailed = FALSE;
+
   analyzeDouble:
     amt = (AnalyseMoveTask *) task;
-    if (AnalyzeMove(amt->pmr, &amt->ms, amt->plGame, amt->psc,
-                    &esAnalysisChequer, &esAnalysisCube, aamfAnalysis, afAnalysePlayers, &doubleError) < 0)
+    if (AnalyzeMove(amt->pmr, &amt->ms, amt->plGame, amt->psc, amt->pac, &doubleError) < 0) {
         MT_AbortTasks();
+        fFailed = TRUE;
+    }
 
     if (task->pLinkedTask) {    /* Need to analyze take/drop decision in sequence */
         task = task->pLinkedTask;
         goto analyzeDouble;
     }
+
+    if (amt->pac->paj && !fFailed)
+        JournalTask(amt->pac->paj, taskFirst);
 }
 
+/* Analyse plGame with the settings of *pac, which have to last until
+ * its tasks are done */
 static int
-AnalyzeGame(listOLD * plGame, int wait)
+AnalyzeGame(listOLD * plGame, const analysiscontext * pac, int wait)
 {
     unsigned int i;
     listOLD *pl = plGame->plNext;
@@ -971,11 +1901,11 @@ AnalyzeGame(listOLD * plGame, int wait)
     matchstate msAnalyse;
     unsigned int numMoves = NumberMovesGame(plGame);
     AnalyseMoveTask *pt = NULL, *pParentTask = NULL;
+    float doubleError = 0.0f;
 
     /* Analyse first move record (gameinfo) */
     g_assert(pmr->mt == MOVE_GAMEINFO);
-    if (AnalyzeMove(pmr, &msAnalyse, plGame, psc,
-                    &esAnalysisChequer, &esAnalysisCube, aamfAnalysis, afAnalysePlayers, NULL) < 0)
+    if (AnalyzeMove(pmr, &msAnalyse, plGame, psc, pac, NULL) < 0)
         return -1;              /* Interrupted */
 
     numMoves--;                 /* Done one - the gameinfo */
@@ -991,32 +1921,48 @@ AnalyzeGame(listOLD * plGame, int wait)
             break;
         }
 
-        if (!pParentTask)
-            pt = (AnalyseMoveTask *) g_malloc(sizeof(AnalyseMoveTask));
-
-        pt->task.fun = (AsyncFun) AnalyseMoveMT;
-        pt->task.data = pt;
-        pt->task.pLinkedTask = NULL;
-        pt->pmr = pmr;
-        pt->plGame = plGame;
-        pt->psc = psc;
-        memcpy(&pt->ms, &msAnalyse, sizeof(msAnalyse));
-
-        if (pmr->mt == MOVE_DOUBLE) {
-            doubletype dt = DoubleType(msAnalyse.fDoubled, msAnalyse.fMove, msAnalyse.fTurn);
-            moverecord *pNextmr = (moverecord *) pl->plNext->p;
-            if (pNextmr && dt == DT_NORMAL) {   /* Need to link the two tasks so executed together */
-                pParentTask = pt;
-                pt = (AnalyseMoveTask *) g_malloc(sizeof(AnalyseMoveTask));
-                pParentTask->task.pLinkedTask = (Task *) pt;
-            }
+        /* what the journal has is done here and not queued; a double
+         * goes with its take or drop, and isn't done without it */
+        if (!pParentTask && JournalDone(pac, pmr)
+            && (pmr->mt != MOVE_DOUBLE || !pl->plNext->p || JournalDone(pac, pl->plNext->p))) {
+            matchstate msDone;
+
+            memcpy(&msDone, &msAnalyse, sizeof(msAnalyse));
+            if (pmr->mt != MOVE_TAKE && pmr->mt != MOVE_DROP)
+                doubleError = 0.0f;
+            if (AnalyzeMove(pmr, &msDone, plGame, psc, pac, &doubleError) < 0)
+                return -1;
         } else {
-            if (pParentTask) {
-                pt = pParentTask;
-                pParentTask = NULL;
+            if (!pParentTask)
+                pt = (AnalyseMoveTask *) g_malloc(sizeof(AnalyseMoveTask));
+
+            pt->task.fun = (AsyncFun) AnalyseMoveMT;
+            pt->task.data = pt;
+            pt->task.pLinkedTask = NULL;
+            pt->task.priority = TASK_ANALYSIS;
+            pt->task.pct = MT_GetTLD()->pct;
+            pt->pmr = pmr;
+            pt->plGame = plGame;
+            pt->psc = psc;
+            pt->pac = pac;
+            memcpy(&pt->ms, &msAnalyse, sizeof(msAnalyse));
+
+            if (pmr->mt == MOVE_DOUBLE) {
+                doubletype dt = DoubleType(msAnalyse.fDoubled, msAnalyse.fMove, msAnalyse.fTurn);
+                moverecord *pNextmr = (moverecord *) pl->plNext->p;
+                if (pNextmr && dt == DT_NORMAL) {   /* Need to link the two tasks so executed together */
+                    pParentTask = pt;
+                    pt = (AnalyseMoveTask *) g_malloc(sizeof(AnalyseMoveTask));
+                    pParentTask->task.pLinkedTask = (Task *) pt;
+                }
+            } else {
+                if (pParentTask) {
+                    pt = pParentTask;
+                    pParentTask = NULL;
+                }
+                multi_debug("add task: analysis");
+                MT_AddTask((Task *) pt, TRUE);
             }
-            multi_debug("add task: analysis");
-            MT_AddTask((Task *) pt, TRUE);
         }
 
         FixMatchState(&msAnalyse, pmr);
@@ -1078,7 +2024,7 @@ AddStatcontext(const statcontext * pscA, statcontext * pscB)
 
     int i, j;
 
-    MT_Exclusive();
+    MT_Lock(MT_LOCK_MATCH);
 
     pscB->nGames++;
 
@@ -1140,7 +2086,285 @@ AddStatcontext(const statcontext * pscA, statcontext * pscB)
         }
 
     }
-    MT_Release();
+    MT_Unlock(MT_LOCK_MATCH);
+}
+
+/* Add pscA, the statistics of any number of games, to pscB: the
+ * variances of the results are pooled as in
+ * <URL:https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm> */
+extern void
+MergeStatcontext(const statcontext * pscA, statcontext * pscB)
+{
+    int i, n = pscA->nGames + pscB->nGames;
+    statcontext sc;
+
+    if (!pscA->nGames)
+        return;
+
+    memcpy(&sc, pscB, sizeof(sc));
+
+    /* the sums, and one game too many */
+    AddStatcontext(pscA, pscB);
+    pscB->nGames = n;
+
+    for (i = 0; i < 2; i++) {
+        float rDelta;
+
+        if (!sc.nGames) {
+            pscB->arVarianceActual[i] = pscA->arVarianceActual[i];
+            pscB->arVarianceLuckAdj[i] = pscA->arVarianceLuckAdj[i];
+            continue;
+        }
+
+        rDelta = pscA->arActualResult[i] / (float) pscA->nGames - sc.arActualResult[i] / (float) sc.nGames;
+        pscB->arVarianceActual[i] =
+            (pscA->arVarianceActual[i] * (float) (pscA->nGames - 1) + sc.arVarianceActual[i] * (float) (sc.nGames - 1) +
+             rDelta * rDelta * (float) pscA->nGames * (float) sc.nGames / (float) n) / (float) (n - 1);
+
+        rDelta = pscA->arLuckAdj[i] / (float) pscA->nGames - sc.arLuckAdj[i] / (float) sc.nGames;
+        pscB->arVarianceLuckAdj[i] =
+            (pscA->arVarianceLuckAdj[i] * (float) (pscA->nGames - 1) + sc.arVarianceLuckAdj[i] * (float) (sc.nGames - 1) +
+             rDelta * rDelta * (float) pscA->nGames * (float) sc.nGames / (float) n) / (float) (n - 1);
+    }
+}
+
+#define SWAP_SIDES(a) { \
+    char ach[sizeof((a)[0])]; \
+    memcpy(ach, &(a)[0], sizeof(ach)); memcpy(&(a)[0], &(a)[1], sizeof(ach)); memcpy(&(a)[1], ach, sizeof(ach)); }
+
+static void
+SwapStatcontext(statcontext * psc)
+{
+    SWAP_SIDES(psc->anUnforcedMoves);
+    SWAP_SIDES(psc->anTotalMoves);
+    SWAP_SIDES(psc->anTotalCube);
+    SWAP_SIDES(psc->anCloseCube);
+    SWAP_SIDES(psc->anDouble);
+    SWAP_SIDES(psc->anTake);
+    SWAP_SIDES(psc->anPass);
+    SWAP_SIDES(psc->anMoves);
+    SWAP_SIDES(psc->anLuck);
+    SWAP_SIDES(psc->anCubeMissedDoubleDP);
+    SWAP_SIDES(psc->anCubeMissedDoubleTG);
+    SWAP_SIDES(psc->anCubeWrongDoubleDP);
+    SWAP_SIDES(psc->anCubeWrongDoubleTG);
+    SWAP_SIDES(psc->anCubeWrongTake);
+    SWAP_SIDES(psc->anCubeWrongPass);
+    SWAP_SIDES(psc->arErrorCheckerplay);
+    SWAP_SIDES(psc->arErrorMissedDoubleDP);
+    SWAP_SIDES(psc->arErrorMissedDoubleTG);
+    SWAP_SIDES(psc->arErrorWrongDoubleDP);
+    SWAP_SIDES(psc->arErrorWrongDoubleTG);
+    SWAP_SIDES(psc->arErrorWrongTake);
+    SWAP_SIDES(psc->arErrorWrongPass);
+    SWAP_SIDES(psc->arLuck);
+    SWAP_SIDES(psc->arActualResult);
+    SWAP_SIDES(psc->arLuckAdj);
+    SWAP_SIDES(psc->arVarianceActual);
+    SWAP_SIDES(psc->arVarianceLuckAdj);
+}
+
+/*
+ * Statistics summaries: the statistics of an analysed match on one
+ * line, so that those of many matches can be added up without loading
+ * them.  The tab separated fields are
+ *
+ *   gnubg-summary <ints> <floats> <player 0> <player 1> <match length>
+ *   <games> then the ints of the statcontext, from fMoves to
+ *   anCubeWrongPass, and its floats, from arErrorCheckerplay to
+ *   arVarianceLuckAdj
+ *
+ * where <ints> and <floats> count them, to tell summaries of another
+ * layout.
+ */
+#define SUMMARY_INTS (offsetof(statcontext, arErrorCheckerplay) / sizeof(int))
+#define SUMMARY_FLOATS ((offsetof(statcontext, nGames) - offsetof(statcontext, arErrorCheckerplay)) / sizeof(float))
+
+char *szAnalysisSummary = NULL;
+char *szAnalysisJournal = NULL;
+
+extern int
+AppendSummary(const char *szFile, const statcontext * psc, const char *szPlayer0, const char *szPlayer1,
+              int nMatchTo)
+{
+    const int *pn = &psc->fMoves;
+    const float *pr = &psc->arErrorCheckerplay[0][0];
+    char sz[G_ASCII_DTOSTR_BUF_SIZE];
+    unsigned int i;
+    FILE *pf;
+
+    if ((pf = g_fopen(szFile, "a")) == NULL) {
+        outputerr(szFile);
+        return -1;
+    }
+
+    fprintf(pf, "gnubg-summary\t%u\t%u\t%s\t%s\t%d\t%d", (unsigned int) SUMMARY_INTS, (unsigned int) SUMMARY_FLOATS,
+            szPlayer0, szPlayer1, nMatchTo, psc->nGames);
+    for (i = 0; i < SUMMARY_INTS; i++)
+        fprintf(pf, "\t%d", pn[i]);
+    for (i = 0; i < SUMMARY_FLOATS; i++)
+        fprintf(pf, "\t%s", g_ascii_dtostr(sz, sizeof(sz), pr[i]));
+    fputc('\n', pf);
+
+    if (fclose(pf)) {
+        outputerr(szFile);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Read the summary line sz into psc and the players' names (pointing
+ * into the fields *pasz, to be freed with g_strfreev()) */
+static int
+ReadSummary(const char *sz, statcontext * psc, char ***pasz)
+{
+    char **asz = g_strsplit(sz, "\t", -1);
+    int *pn = &psc->fMoves;
+    float *pr = &psc->arErrorCheckerplay[0][0];
+    unsigned int i;
+
+    if (g_strv_length(asz) != 7 + SUMMARY_INTS + SUMMARY_FLOATS || strcmp(asz[0], "gnubg-summary")
+        || strtoul(asz[1], NULL, 10) != SUMMARY_INTS || strtoul(asz[2], NULL, 10) != SUMMARY_FLOATS) {
+        g_strfreev(asz);
+        return -1;
+    }
+
+    IniStatcontext(psc);
+    psc->nGames = (int) strtol(asz[6], NULL, 10);
+    for (i = 0; i < SUMMARY_INTS; i++)
+        pn[i] = (int) strtol(asz[7 + i], NULL, 10);
+    for (i = 0; i < SUMMARY_FLOATS; i++)
+        pr[i] = (float) g_ascii_strtod(asz[7 + SUMMARY_INTS + i], NULL);
+
+    *pasz = asz;
+
+    return 0;
+}
+
+typedef struct {
+    char *szName;
+    int cMatches;
+    statcontext sc;             /* the player's side first */
+} summarytotal;
+
+static gint
+CompareSummaryTotals(gconstpointer p0, gconstpointer p1)
+{
+    return g_utf8_collate((*(summarytotal * const *) p0)->szName, (*(summarytotal * const *) p1)->szName);
+}
+
+static void
+AddSummaryTotal(GHashTable * pht, const char *szName, const statcontext * psc)
+{
+    summarytotal *pst = g_hash_table_lookup(pht, szName);
+
+    if (!pst) {
+        pst = g_new0(summarytotal, 1);
+        pst->szName = g_strdup(szName);
+        IniStatcontext(&pst->sc);
+        g_hash_table_insert(pht, pst->szName, pst);
+    }
+
+    pst->cMatches++;
+    MergeStatcontext(psc, &pst->sc);
+}
+
+static void
+FreeSummaryTotal(gpointer p)
+{
+    summarytotal *pst = p;
+
+    g_free(pst->szName);
+    g_free(pst);
+}
+
+/* show statistics summary <file> [player]: add up the summaries in
+ * <file> line by line, for player against all of their opponents, or the
+ * error rates of every player */
+extern void
+CommandShowStatisticsSummary(char *sz)
+{
+    char *szFile = NextToken(&sz);
+    char *szPlayer = NextToken(&sz);
+    char szLine[4096], **asz;
+    FILE *pf;
+    GHashTable *pht;
+    statcontext sc;
+    summarytotal *pst;
+    int cBad = 0;
+
+    if (!szFile || !*szFile) {
+        outputl(_("You must specify a summary file (see `help show statistics summary')."));
+        return;
+    }
+
+    if ((pf = g_fopen(szFile, "r")) == NULL) {
+        outputerr(szFile);
+        return;
+    }
+
+    pht = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, FreeSummaryTotal);
+
+    while (fgets(szLine, sizeof(szLine), pf)) {
+        g_strchomp(szLine);
+        if (!*szLine)
+            continue;
+        if (ReadSummary(szLine, &sc, &asz) < 0) {
+            cBad++;
+            continue;
+        }
+
+        if (!szPlayer || !strcmp(asz[3], szPlayer))
+            AddSummaryTotal(pht, asz[3], &sc);
+        SwapStatcontext(&sc);
+        if (!szPlayer || !strcmp(asz[4], szPlayer))
+            AddSummaryTotal(pht, asz[4], &sc);
+
+        g_strfreev(asz);
+    }
+    fclose(pf);
+
+    if (cBad)
+        outputf(ngettext("%d line is not a statistics summary and was skipped.\n",
+                         "%d lines are not statistics summaries and were skipped.\n", cBad), cBad);
+
+    if (szPlayer) {
+        if (!(pst = g_hash_table_lookup(pht, szPlayer)))
+            outputf(_("No matches of %s in `%s'.\n"), szPlayer, szFile);
+        else {
+            char szOutput[STATCONTEXT_MAXSIZE];
+
+            outputf(ngettext("%s: %d match, %d games\n\n", "%s: %d matches, %d games\n\n", pst->cMatches),
+                    szPlayer, pst->cMatches, pst->sc.nGames);
+            DumpStatcontext(szOutput, &pst->sc, szPlayer, _("Opponents"), 0);
+            outputl(szOutput);
+        }
+    } else {
+        GPtrArray *pa = g_ptr_array_new();
+        GHashTableIter iter;
+        gpointer p;
+        unsigned int i;
+
+        g_hash_table_iter_init(&iter, pht);
+        while (g_hash_table_iter_next(&iter, NULL, &p))
+            g_ptr_array_add(pa, p);
+        g_ptr_array_sort(pa, CompareSummaryTotals);
+
+        outputf("%-24s %8s %8s %12s %12s\n", _("Player"), _("Matches"), _("Games"), _("Chequer"), _("Luck"));
+        for (i = 0; i < pa->len; i++) {
+            pst = g_ptr_array_index(pa, i);
+            outputf("%-24s %8d %8d %12.1f %12.1f\n", pst->szName, pst->cMatches, pst->sc.nGames,
+                    pst->sc.anUnforcedMoves[0] ? 1000.0f * pst->sc.arErrorCheckerplay[0][0] /
+                    (float) pst->sc.anUnforcedMoves[0] : 0.0f,
+                    pst->sc.anTotalMoves[0] ? 1000.0f * pst->sc.arLuck[0][0] / (float) pst->sc.anTotalMoves[0] : 0.0f);
+        }
+        outputl(_("\nChequer: error per unforced move, luck: per move, in millipoints."));
+
+        g_ptr_array_free(pa, TRUE);
+    }
+
+    g_hash_table_destroy(pht);
 }
 
 static int
@@ -1175,6 +2399,10 @@ CommandAnalyseGame(char *UNUSED(sz))
 {
     int nMoves;
     int fStore_crawford;
+    canceltoken ct = { FALSE };
+    canceltoken *pctOld;
+    analysiscontext ac;
+    int cScreened = 0;
 
     if (!CheckGameExists())
         return;
@@ -1182,6 +2410,8 @@ CommandAnalyseGame(char *UNUSED(sz))
     if (CheckSettings())
         return;
 
+    GetAnalysisContext(&ac);
+    ac.pcCubeScreened = &cScreened;
     fStore_crawford = ms.fCrawford;
     nMoves = NumberMovesGame(plGame);
 
@@ -1197,10 +2427,16 @@ CommandAnalyseGame(char *UNUSED(sz))
 #endif
         ProgressStartValue(_("Analysing game"), nMoves);
 
-    AnalyzeGame(plGame, TRUE);
+    /* a move that can't be analysed stops this analysis only */
+    pctOld = MT_SetJob(&ct);
+    AnalyzeGame(plGame, &ac, TRUE);
+    MT_SetJob(pctOld);
 
     ProgressEnd();
 
+    if (ac.fCubeScreen && ac.fCube)
+        outputf(_("%d cube decisions were clear at 0-ply and not analysed further.\n"), cScreened);
+
     if (fBackgroundAnalysis) {
         fAnalysisRunning = FALSE;
         ShowBoard(); /* hide unallowd toolbar items*/
@@ -1220,13 +2456,91 @@ CommandAnalyseGame(char *UNUSED(sz))
 }
 
 
-extern void
-CommandAnalyseMatch(char *UNUSED(sz))
+/* Whether the quick analysis of the cube decision of pmr could be
+ * wrong about it: the decision is close, or it was a mistake */
+static int
+TriageCube(const moverecord * pmr, const matchstate * pms)
+{
+    cubeinfo ci;
+    float arDouble[NUM_CUBEFUL_OUTPUTS];
+
+    if (!pmr->CubeDecPtr || pmr->CubeDecPtr->esDouble.et == EVAL_NONE)
+        return FALSE;
+
+    GetMatchStateCubeInfo(&ci, pms);
+    FindCubeDecision(arDouble, pmr->CubeDecPtr->aarOutput, &ci);
+
+    return isCloseCubedecision(arDouble) || pmr->stCube != SKILL_NONE;
+}
+
+/* Flag in pht the decisions of plGame the full analysis has to look at
+ * again: the moves that weren't the best one or only best by less than
+ * a doubtful move loses, and the cube decisions TriageCube() doubts */
+static void
+TriageGame(listOLD * plGame, GHashTable * pht)
+{
+    listOLD *pl;
+    matchstate msTriage;
+    int fFlagTake = FALSE;
+
+    for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
+        moverecord *pmr = pl->p;
+        int fFlag = FALSE;
+
+        FixMatchState(&msTriage, pmr);
+
+        switch (pmr->mt) {
+        case MOVE_NORMAL:
+            if (pmr->fPlayer != msTriage.fMove) {
+                SwapSides(msTriage.anBoard);
+                msTriage.fMove = pmr->fPlayer;
+            }
+            fFlag = TriageCube(pmr, &msTriage);
+            if (pmr->ml.cMoves > 1 && (pmr->n.iMove != 0 ||
+                                       pmr->ml.amMoves[0].rScore - pmr->ml.amMoves[1].rScore <
+                                       arSkillLevel[SKILL_DOUBTFUL]))
+                fFlag = TRUE;
+            break;
+
+        case MOVE_DOUBLE:
+            /* the take or drop shares its analysis */
+            fFlag = fFlagTake = TriageCube(pmr, &msTriage);
+            break;
+
+        case MOVE_TAKE:
+        case MOVE_DROP:
+            fFlag = fFlagTake;
+            fFlagTake = FALSE;
+            break;
+
+        default:
+            break;
+        }
+
+        if (fFlag)
+            g_hash_table_insert(pht, pmr, GINT_TO_POINTER(TRUE));
+
+        ApplyMoveRecord(&msTriage, plGame, pmr);
+    }
+}
+
+/* Analyse the match, with a journal of it in szJournal if not NULL
+ * going on from the decisions it has if fResume */
+static void
+AnalyseMatch(char *sz, const char *szJournal, int fResume)
 {
+    char *pch = NextToken(&sz);
     listOLD *pl;
     moverecord *pmr;
     int nMoves;
     int fStore_crawford;
+    int fIncomplete = FALSE;
+    int fTriage = FALSE;
+    int cScreened = 0;
+    canceltoken ct = { FALSE };
+    canceltoken *pctOld;
+    analysiscontext ac;
+    analysisjournal *paj = NULL;
 
     if (!CheckGameExists())
         return;
@@ -1234,9 +2548,36 @@ CommandAnalyseMatch(char *UNUSED(sz))
     if (CheckSettings())
         return;
 
+    GetAnalysisContext(&ac);
+    ac.pcCubeScreened = &cScreened;
     fStore_crawford = ms.fCrawford;
     nMoves = NumberMovesMatch(&lMatch);
 
+    if (szJournal) {
+        paj = JournalNew(szJournal);
+        if ((fResume && JournalRead(paj) < 0) || JournalStart(paj) < 0) {
+            JournalClose(paj);
+            return;
+        }
+
+        if (fResume) {
+            nMoves -= (int) g_hash_table_size(paj->phtDone);
+            outputf(_("%u of the %u records of the match were read back from `%s'.\n"),
+                    g_hash_table_size(paj->phtDone), paj->jh.cRecords, szJournal);
+        }
+    }
+
+    if (pch && *pch) {
+        /* chequer and cube decisions are only analysed again when the
+         * stored analysis is weaker than asked for; this leaves the
+         * dice too */
+        if (!StrNCaseCmp(pch, "incremental", strlen(pch)))
+            ac.fKeepLuck = TRUE;
+        /* a quick pass is only worth it below a deeper analysis */
+        else if (!StrNCaseCmp(pch, "triage", strlen(pch)))
+            fTriage = cmp_evalsetup(&ac.esChequer, &esTriage) > 0 || cmp_evalsetup(&ac.esCube, &esTriage) > 0;
+    }
+
     /* if we analyze in the background, we turn on a global flag
        to disable all sorts of buttons during the analysis */
 
@@ -1260,24 +2601,71 @@ CommandAnalyseMatch(char *UNUSED(sz))
 
     IniStatcontext(&scMatch);
 
-    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+    pctOld = MT_SetJob(&ct);
 
-        if (AnalyzeGame(pl->p, FALSE) < 0) {
-            /* analysis incomplete; erase partial summary */
+    if (fTriage) {
+        /* nothing flagged yet: all of the first pass is quick */
+        ac.phtTriage = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-            IniStatcontext(&scMatch);
-            break;
-        }
-        pmr = (moverecord *) ((listOLD *) pl->p)->plNext->p;
-        g_assert(pmr->mt == MOVE_GAMEINFO);
-        AddStatcontext(&pmr->g.sc, &scMatch);
+        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
+            if (AnalyzeGame(pl->p, &ac, FALSE) < 0) {
+                fIncomplete = TRUE;
+                break;
+            }
+
+        multi_debug("wait for all task: triage");
+        if (MT_WaitForTasks(UpdateProgressBar, 250, FALSE) < 0 || ct.fCancelled)
+            fIncomplete = TRUE;
+
+        if (!fIncomplete)
+            for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
+                TriageGame(pl->p, ac.phtTriage);
+
+        /* the second pass only redoes what was flagged */
+        ac.fKeepLuck = TRUE;
     }
 
+    /* only the final analysis goes into the journal */
+    ac.paj = paj;
+
+    /* queue the moves of every game before waiting, so the threads go
+     * on with the next game while the last moves of one are analysed */
+    for (pl = lMatch.plNext; pl != &lMatch && !fIncomplete; pl = pl->plNext)
+        if (AnalyzeGame(pl->p, &ac, FALSE) < 0)
+            fIncomplete = TRUE;
+
     multi_debug("wait for all task: analysis");
-    MT_WaitForTasks(UpdateProgressBar, 250, fAutoSaveAnalysis);
+    if (MT_WaitForTasks(UpdateProgressBar, 250, fAutoSaveAnalysis) < 0 || ct.fCancelled)
+        fIncomplete = TRUE;
+    MT_SetJob(pctOld);
+
+    if (ac.phtTriage)
+        g_hash_table_destroy(ac.phtTriage);
+
+    if (paj) {
+        if (fIncomplete && !paj->fError)
+            outputf(_("The analysis can go on from where it stopped with `analyse resume %s'.\n"), szJournal);
+        JournalClose(paj);
+    }
+
+    /* the statistics of a game are only complete once all its tasks
+     * are done; an incomplete analysis leaves no summary */
+    if (!fIncomplete) {
+        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+            pmr = (moverecord *) ((listOLD *) pl->p)->plNext->p;
+            g_assert(pmr->mt == MOVE_GAMEINFO);
+            AddStatcontext(&pmr->g.sc, &scMatch);
+        }
+
+        if (szAnalysisSummary)
+            AppendSummary(szAnalysisSummary, &scMatch, ap[0].szName, ap[1].szName, ms.nMatchTo);
+    }
 
     ProgressEnd();
 
+    if (ac.fCubeScreen && ac.fCube)
+        outputf(_("%d cube decisions were clear at 0-ply and not analysed further.\n"), cScreened);
+
 #if defined(USE_GTK)
     if (fBackgroundAnalysis && fX) {
         fAnalysisRunning = FALSE;
@@ -1296,6 +2684,27 @@ CommandAnalyseMatch(char *UNUSED(sz))
     playSound(SOUND_ANALYSIS_FINISHED);
 }
 
+extern void
+CommandAnalyseMatch(char *sz)
+{
+    AnalyseMatch(sz, szAnalysisJournal, FALSE);
+}
+
+extern void
+CommandAnalyseResume(char *sz)
+{
+    char *pch = NextToken(&sz);
+    const char *szJournal = pch && *pch ? pch : szAnalysisJournal;
+
+    if (!szJournal) {
+        outputl(_("You must specify the journal to resume the analysis from "
+                  "(see `help analyse resume')."));
+        return;
+    }
+
+    AnalyseMatch(NULL, szJournal, TRUE);
+}
+
 extern void
 CommandAnalyseSession(char *sz)
 {
@@ -1303,6 +2712,257 @@ CommandAnalyseSession(char *sz)
     CommandAnalyseMatch(sz);
 }
 
+/* A match of "analyse files" from its import to its save */
+typedef struct {
+    char *szOut;                /* where it goes */
+    canceltoken ct;             /* its analysis */
+    analysiscontext ac;         /* and its settings */
+    int fParked;                /* the match below is out of the globals */
+    listOLD lMatch;
+    matchinfo mi;
+    matchstate ms;
+    char aszName[2][MAX_NAME_LEN];
+} analysedfile;
+
+/* Move the current match out of the way of the next import, while its
+ * analysis goes on in the background */
+static void
+ParkMatch(analysedfile * paf)
+{
+    int i;
+
+    if (lMatch.plNext == &lMatch)
+        ListCreate(&paf->lMatch);
+    else {
+        paf->lMatch = lMatch;
+        paf->lMatch.plNext->plPrev = paf->lMatch.plPrev->plNext = &paf->lMatch;
+        ListCreate(&lMatch);
+    }
+    plGame = plLastMove = NULL;
+
+    paf->mi = mi;
+    memset(&mi, 0, sizeof(mi));
+    paf->ms = ms;
+    for (i = 0; i < 2; i++)
+        g_strlcpy(paf->aszName[i], ap[i].szName, MAX_NAME_LEN);
+
+    paf->fParked = TRUE;
+}
+
+static void
+UnparkMatch(analysedfile * paf)
+{
+    int i;
+
+    FreeMatch();
+    ClearMatch();
+
+    if (paf->lMatch.plNext != &paf->lMatch) {
+        lMatch = paf->lMatch;
+        lMatch.plNext->plPrev = lMatch.plPrev->plNext = &lMatch;
+        plGame = lMatch.plPrev->p;
+        plLastMove = plGame->plPrev;
+    }
+
+    mi = paf->mi;
+    ms = paf->ms;
+    for (i = 0; i < 2; i++)
+        g_strlcpy(ap[i].szName, paf->aszName[i], MAX_NAME_LEN);
+
+    paf->fParked = FALSE;
+}
+
+static gboolean
+KeepWaiting(gpointer UNUSED(unused))
+{
+    return TRUE;
+}
+
+/* Wait for the analysis of paf, put its match back and save it */
+static void
+FinishFile(analysedfile * paf)
+{
+    listOLD *pl;
+    char *sz;
+
+    if (paf->fParked) {
+        /* the tasks of the next file are queued behind it */
+        while (MT_JobBusy(&paf->ct)) {
+            if (MT_SafeGet(&fInterrupt))
+                MT_Cancel(&paf->ct);
+            ProcessEvents();
+            g_usleep(UI_UPDATETIME * 1000);
+        }
+        UnparkMatch(paf);
+    } else
+        MT_WaitForTasks(KeepWaiting, UI_UPDATETIME, FALSE);
+
+    if (!paf->ct.fCancelled && !MT_SafeGet(&fInterrupt) && plGame) {
+        IniStatcontext(&scMatch);
+        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+            moverecord *pmr = (moverecord *) ((listOLD *) pl->p)->plNext->p;
+            AddStatcontext(&pmr->g.sc, &scMatch);
+        }
+
+        if (szAnalysisSummary)
+            AppendSummary(szAnalysisSummary, &scMatch, ap[0].szName, ap[1].szName, ms.nMatchTo);
+
+        sz = g_strdup_printf("\"%s\"", paf->szOut);
+        CommandSaveMatch(sz);
+        g_free(sz);
+        outputf(_("Analysed match saved to `%s'\n"), paf->szOut);
+    }
+
+    g_free(paf->szOut);
+    g_free(paf);
+}
+
+static gint
+CompareFileNames(gconstpointer p0, gconstpointer p1)
+{
+    return strcmp(*(char *const *) p0, *(char *const *) p1);
+}
+
+/*
+ * analyse files <files> <folder>: import every match file matching
+ * the wildcards of <files>, analyse it and save it as <folder>/<name>.sgf.
+ * The next file is read while the threads analyse the current one, so
+ * they are kept busy from one file to the next.
+ */
+extern void
+CommandAnalyseFiles(char *sz)
+{
+    char *szFiles = NextToken(&sz);
+    char *szFolder = NextToken(&sz);
+    char *szDir, *szPattern;
+    const char *szEntry;
+    GDir *pd;
+    GPatternSpec *pps;
+    GPtrArray *pa;
+    GQueue q = G_QUEUE_INIT;
+    listOLD *pl;
+    unsigned int i, cAhead = 1;
+    int fConfirmNewOld = fConfirmNew, fConfirmSaveOld = fConfirmSave;
+    analysedfile *paf;
+
+    if (!szFiles || !szFolder) {
+        outputl(_("You must specify the files to analyse and a folder for the results "
+                  "(see `help analyse files')."));
+        return;
+    }
+
+    if (CheckSettings() || !get_input_discard())
+        return;
+
+    szDir = g_path_get_dirname(szFiles);
+    szPattern = g_path_get_basename(szFiles);
+
+    if (!(pd = g_dir_open(szDir, 0, NULL))) {
+        outputerrf(_("Cannot read the folder `%s'"), szDir);
+        g_free(szDir);
+        g_free(szPattern);
+        return;
+    }
+
+    pps = g_pattern_spec_new(szPattern);
+    pa = g_ptr_array_new_with_free_func(g_free);
+    while ((szEntry = g_dir_read_name(pd)) != NULL)
+        if (g_pattern_match_string(pps, szEntry))
+            g_ptr_array_add(pa, g_build_filename(szDir, szEntry, NULL));
+    g_dir_close(pd);
+    g_pattern_spec_free(pps);
+    g_free(szPattern);
+    g_free(szDir);
+
+    g_ptr_array_sort(pa, CompareFileNames);
+
+    if (!pa->len) {
+        outputf(_("No files match `%s'.\n"), szFiles);
+        g_ptr_array_free(pa, TRUE);
+        return;
+    }
+
+    if (g_mkdir_with_parents(szFolder, 0755) < 0) {
+        outputerrf(_("Cannot create the folder `%s'"), szFolder);
+        g_ptr_array_free(pa, TRUE);
+        return;
+    }
+#if !defined(USE_MULTITHREAD)
+    /* the tasks only run while we wait for them */
+    cAhead = 0;
+#endif
+#if defined(USE_GTK)
+    /* the board and the game list hold on to the current match */
+    if (fX)
+        cAhead = 0;
+#endif
+
+    fConfirmNew = fConfirmSave = FALSE;
+
+    for (i = 0; i < pa->len && !MT_SafeGet(&fInterrupt); i++) {
+        const char *szFile = g_ptr_array_index(pa, i);
+        char *szBase = g_path_get_basename(szFile);
+        char *pch = strrchr(szBase, '.');
+        char *szImport;
+        canceltoken *pctOld;
+
+        if (pch && pch != szBase)
+            *pch = 0;
+
+        /* make sure a failed import can't leave the last match in place */
+        FreeMatch();
+        ClearMatch();
+
+        szImport = g_strdup_printf("\"%s\"", szFile);
+        CommandImportAuto(szImport);
+        g_free(szImport);
+
+        if (!plGame || lMatch.plNext == &lMatch) {
+            outputf(_("Skipping `%s'\n"), szFile);
+            g_free(szBase);
+            continue;
+        }
+
+        paf = g_new0(analysedfile, 1);
+        szImport = g_strconcat(szBase, ".sgf", NULL);
+        paf->szOut = g_build_filename(szFolder, szImport, NULL);
+        g_free(szImport);
+        g_free(szBase);
+
+        GetAnalysisContext(&paf->ac);
+        pctOld = MT_SetJob(&paf->ct);
+        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
+            if (AnalyzeGame(pl->p, &paf->ac, FALSE) < 0) {
+                MT_Cancel(&paf->ct);
+                break;
+            }
+        MT_SetJob(pctOld);
+
+        if (cAhead)
+            ParkMatch(paf);
+        g_queue_push_tail(&q, paf);
+
+        while (g_queue_get_length(&q) > cAhead)
+            FinishFile(g_queue_pop_head(&q));
+    }
+
+    while ((paf = g_queue_pop_head(&q)) != NULL) {
+        if (MT_SafeGet(&fInterrupt))
+            MT_Cancel(&paf->ct);
+        FinishFile(paf);
+    }
+
+    /* nothing is left running; reset the counts of finished tasks */
+    MT_WaitForTasks(KeepWaiting, UI_UPDATETIME, FALSE);
+
+    fConfirmNew = fConfirmNewOld;
+    fConfirmSave = fConfirmSaveOld;
+
+    g_ptr_array_free(pa, TRUE);
+
+    playSound(SOUND_ANALYSIS_FINISHED);
+}
+
 
 
 extern void
@@ -1638,6 +3298,7 @@ CommandAnalyseMove(char *UNUSED(sz))
     if (plLastMove && plLastMove->plNext && plLastMove->plNext->p) {    /* analyse move */
         moveData md;
         matchstate msx;
+        analysiscontext ac;
 
         md.pmr = plLastMove->plNext->p;
 
@@ -1648,9 +3309,10 @@ CommandAnalyseMove(char *UNUSED(sz))
 
         memcpy(&msx, &ms, sizeof(matchstate));
         md.pms = &msx;
-        md.pesChequer = &esAnalysisChequer;
-        md.pesCube = &esAnalysisCube;
-        md.aamf = aamfAnalysis;
+        GetAnalysisContext(&ac);
+        /* whoever played it */
+        ac.afPlayers[0] = ac.afPlayers[1] = TRUE;
+        md.pac = &ac;
         RunAsyncProcess((AsyncFun) asyncAnalyzeMove, &md, _("Analysing move..."));
 
 #if defined(USE_GTK)
@@ -2278,6 +3940,22 @@ cmark_match_clear(listOLD * match)
     }
 }
 
+/* Sort the move list of pmr after a rollout of some of its plays, and
+ * find the one made, *pkey, in it again */
+static void
+cmark_move_update(moverecord * pmr, const positionkey * pkey)
+{
+    RefreshMoveList(&pmr->ml, NULL);
+
+    if (pmr->n.iMove != UINT_MAX)
+        for (pmr->n.iMove = 0; pmr->n.iMove < pmr->ml.cMoves; pmr->n.iMove++)
+            if (EqualKeys(*pkey, pmr->ml.amMoves[pmr->n.iMove].key)) {
+                pmr->n.stMove = Skill(pmr->ml.amMoves[pmr->n.iMove].rScore - pmr->ml.amMoves[0].rScore);
+
+                break;
+            }
+}
+
 static int
 cmark_move_rollout(moverecord * pmr, gboolean destroy)
 {
@@ -2326,15 +4004,117 @@ cmark_move_rollout(moverecord * pmr, gboolean destroy)
     g_free(ppm);
     g_free(ppci);
 
-    RefreshMoveList(&pmr->ml, NULL);
+    cmark_move_update(pmr, &key);
+
+#if defined(USE_GTK)
+    if (fX)
+        ChangeGame(NULL);
+    else
+#endif
+        ShowBoard();
+    return res == 0 ? c : res;
+}
+
+/* The marked plays of the positions of a match, rolled out together
+ * so that the threads have trials of some position to play until the
+ * last one is done */
+typedef struct {
+    GArray *apm;                /* the plays (move *) */
+    GArray *aci;                /* the cubeinfo of each play */
+    GArray *aiJob;              /* the position of each play */
+    GArray *aszMove;            /* each play, formatted */
+    GPtrArray *apmr;            /* the moverecord of each position */
+    GArray *akey;               /* the play made in each position */
+    GPtrArray *aszJob;          /* the name of each position */
+} cmarkjobs;
+
+static void
+cmark_jobs_init(cmarkjobs * pcj)
+{
+    pcj->apm = g_array_new(FALSE, FALSE, sizeof(move *));
+    pcj->aci = g_array_new(FALSE, FALSE, sizeof(cubeinfo));
+    pcj->aiJob = g_array_new(FALSE, FALSE, sizeof(int));
+    pcj->aszMove = g_array_new(FALSE, FALSE, FORMATEDMOVESIZE);
+    pcj->apmr = g_ptr_array_new();
+    pcj->akey = g_array_new(FALSE, FALSE, sizeof(positionkey));
+    pcj->aszJob = g_ptr_array_new_with_free_func(g_free);
+}
+
+static void
+cmark_jobs_free(cmarkjobs * pcj)
+{
+    g_array_free(pcj->apm, TRUE);
+    g_array_free(pcj->aci, TRUE);
+    g_array_free(pcj->aiJob, TRUE);
+    g_array_free(pcj->aszMove, TRUE);
+    g_ptr_array_free(pcj->apmr, TRUE);
+    g_array_free(pcj->akey, TRUE);
+    g_ptr_array_free(pcj->aszJob, TRUE);
+}
+
+/* Add the marked plays of pmr, move iMove of game iGame, at the
+ * current position to pcj */
+static void
+cmark_move_add_job(moverecord * pmr, cmarkjobs * pcj, int iGame, int iMove)
+{
+    cubeinfo ci;
+    positionkey key = { {0, 0, 0, 0, 0, 0, 0} };
+    int iJob = (int) pcj->apmr->len;
+    guint j;
+
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    for (j = 0; j < pmr->ml.cMoves; j++) {
+        move *pm = &pmr->ml.amMoves[j];
+        char sz[FORMATEDMOVESIZE];
+
+        if (pm->cmark != CMARK_ROLLOUT)
+            continue;
+
+        FormatMove(sz, msBoard(), pm->anMove);
+        g_array_append_val(pcj->apm, pm);
+        g_array_append_val(pcj->aci, ci);
+        g_array_append_val(pcj->aiJob, iJob);
+        g_array_append_vals(pcj->aszMove, sz, 1);
+    }
+
+    if (pcj->apm->len == 0 || g_array_index(pcj->aiJob, int, pcj->aiJob->len - 1) != iJob)
+        return;
 
     if (pmr->n.iMove != UINT_MAX)
-        for (pmr->n.iMove = 0; pmr->n.iMove < pmr->ml.cMoves; pmr->n.iMove++)
-            if (EqualKeys(key, pmr->ml.amMoves[pmr->n.iMove].key)) {
-                pmr->n.stMove = Skill(pmr->ml.amMoves[pmr->n.iMove].rScore - pmr->ml.amMoves[0].rScore);
+        CopyKey(pmr->ml.amMoves[pmr->n.iMove].key, key);
+    g_ptr_array_add(pcj->apmr, pmr);
+    g_array_append_val(pcj->akey, key);
+    g_ptr_array_add(pcj->aszJob, g_strdup_printf(_("game %d, move %d"), iGame, iMove));
+}
+
+/* Roll out the plays of pcj.  Returns as cmark_move_rollout(). */
+static int
+cmark_jobs_rollout(cmarkjobs * pcj)
+{
+    const int c = (int) pcj->apm->len;
+    cubeinfo **ppci;
+    guint i;
+    int res;
+    void *p;
+
+    if (c == 0)
+        return 0;
+
+    ppci = g_new(cubeinfo *, c);
+    for (i = 0; i < (guint) c; i++)
+        ppci[i] = &g_array_index(pcj->aci, cubeinfo, i);
+
+    RolloutProgressStart(ppci[0], c, NULL, &rcRollout, (char (*)[FORMATEDMOVESIZE]) pcj->aszMove->data, TRUE, &p);
+    ScoreMoveRolloutJobs((move **) pcj->apm->data, ppci, c, (const int *) pcj->aiJob->data, (int) pcj->apmr->len,
+                         (const char *const *) pcj->aszJob->pdata, RolloutProgress, p);
+    res = RolloutProgressEnd(&p, TRUE);
+
+    g_free(ppci);
+
+    for (i = 0; i < pcj->apmr->len; i++)
+        cmark_move_update(g_ptr_array_index(pcj->apmr, i), &g_array_index(pcj->akey, positionkey, i));
 
-                break;
-            }
 #if defined(USE_GTK)
     if (fX)
         ChangeGame(NULL);
@@ -2429,10 +4209,13 @@ move_change(listOLD * new_game, const listOLD * new_move)
     return (plLastMove == new_move);
 }
 
+/* With pcj, add the marked plays of game iGame to it, else roll out
+ * its marked cube decisions */
 static int
-cmark_game_rollout(listOLD * game)
+cmark_game_rollout(listOLD * game, cmarkjobs * pcj, int iGame)
 {
     listOLD *pl, *pl_hint = NULL;
+    int iMove = 0;
 
     g_return_val_if_fail(game, -1);
 
@@ -2450,14 +4233,17 @@ cmark_game_rollout(listOLD * game)
 
         switch (pmr->mt) {
         case MOVE_NORMAL:
+            iMove++;
             if (!move_change(game, pl->plPrev))
                 goto finished;
-            if (cmark_move_rollout(pmr, TRUE) < -1)
-                goto finished;
-            if (cmark_cube_rollout(pmr, TRUE) < -1)
+            if (pcj)
+                cmark_move_add_job(pmr, pcj, iGame, iMove);
+            else if (cmark_cube_rollout(pmr, TRUE) < -1)
                 goto finished;
             break;
         case MOVE_DOUBLE:
+            if (pcj)
+                break;
             pmr_prev = game->plPrev->p;
             if (pmr_prev->mt == MOVE_DOUBLE)
                 break;
@@ -2479,15 +4265,31 @@ cmark_game_rollout(listOLD * game)
     return -1;
 }
 
+/* Roll out the marked decisions of the games of match, or only of
+ * game if it is not NULL: the plays of all of them at once, then the
+ * cube decisions one at a time */
 static void
-cmark_match_rollout(listOLD * match)
+cmark_match_rollout(listOLD * match, const listOLD * game)
 {
+    cmarkjobs cj;
     listOLD *pl;
+    int iGame;
 
-    for (pl = match->plNext; pl != match; pl = pl->plNext) {
-        if (cmark_game_rollout(pl->p) < 0)
+    cmark_jobs_init(&cj);
+
+    for (pl = match->plNext, iGame = 1; pl != match; pl = pl->plNext, iGame++)
+        if ((!game || pl->p == game) && cmark_game_rollout(pl->p, &cj, iGame) < 0)
+            goto finished;
+
+    if (cmark_jobs_rollout(&cj) < -1)
+        goto finished;
+
+    for (pl = match->plNext, iGame = 1; pl != match; pl = pl->plNext, iGame++)
+        if ((!game || pl->p == game) && cmark_game_rollout(pl->p, NULL, iGame) < 0)
             break;
-    }
+
+  finished:
+    cmark_jobs_free(&cj);
 }
 
 static gint
@@ -2705,7 +4507,7 @@ CommandAnalyseRolloutGame(char *UNUSED(sz))
     if (!CheckGameExists())
         return;
 
-    cmark_game_rollout(plGame);
+    cmark_match_rollout(&lMatch, plGame);
 }
 
 extern void
@@ -2714,5 +4516,5 @@ CommandAnalyseRolloutMatch(char *UNUSED(sz))
     if (!CheckGameExists())
         return;
 
-    cmark_match_rollout(&lMatch);
+    cmark_match_rollout(&lMatch, NULL);
 }
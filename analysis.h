@@ -104,6 +104,9 @@ extern int afAnalysePlayers[2];
 extern ratingtype GetRating(const float rError);
 extern void IniStatcontext(statcontext * psc);
 extern void AddStatcontext(const statcontext * pscA, statcontext * pscB);
+extern void MergeStatcontext(const statcontext * pscA, statcontext * pscB);
+extern int AppendSummary(const char *szFile, const statcontext * psc, const char *szPlayer0,
+                         const char *szPlayer1, int nMatchTo);
 
 #define STATCONTEXT_MAXSIZE 8192
 
@@ -144,5 +147,6 @@ extern skilltype Skill(float r);
 extern int MatchAnalysed(void);
 extern float LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms);
 extern lucktype Luck(float r);
+extern int AnalysisCacheMatch(unsigned int *pcMoves, unsigned int *pcCubes);
 
 #endif
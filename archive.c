@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Binary match archives, see archive.h for the file format */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "archive.h"
+#include "backgammon.h"
+#include "sgf.h"
+#if USE_GTK
+#include "gtkgame.h"
+#endif
+
+typedef struct {
+    guint32 cGames;
+    guint64 offIndex;
+    guint32 cMatches;
+} archiveheader;
+
+static const char szMagic[8] = "GNUBGMA";
+
+static void
+PutU16(unsigned char *pch, unsigned int n)
+{
+    pch[0] = (unsigned char) (n & 0xFF);
+    pch[1] = (unsigned char) ((n >> 8) & 0xFF);
+}
+
+static void
+PutU32(unsigned char *pch, guint32 n)
+{
+    PutU16(pch, n & 0xFFFF);
+    PutU16(pch + 2, n >> 16);
+}
+
+static void
+PutU64(unsigned char *pch, guint64 n)
+{
+    PutU32(pch, (guint32) n);
+    PutU32(pch + 4, (guint32) (n >> 32));
+}
+
+static unsigned int
+GetU16(const unsigned char *pch)
+{
+    return pch[0] | (pch[1] << 8);
+}
+
+static guint32
+GetU32(const unsigned char *pch)
+{
+    return GetU16(pch) | ((guint32) GetU16(pch + 2) << 16);
+}
+
+static guint64
+GetU64(const unsigned char *pch)
+{
+    return GetU32(pch) | ((guint64) GetU32(pch + 4) << 32);
+}
+
+/* Archives may well be larger than a long can address */
+static int
+SeekTo(FILE * pf, guint64 off)
+{
+#if defined(WIN32)
+    return _fseeki64(pf, (__int64) off, SEEK_SET);
+#elif HAVE_FSEEKO
+    return fseeko(pf, (off_t) off, SEEK_SET);
+#else
+    return fseek(pf, (long) off, SEEK_SET);
+#endif
+}
+
+static guint64
+Tell(FILE * pf)
+{
+#if defined(WIN32)
+    return (guint64) _ftelli64(pf);
+#elif HAVE_FTELLO
+    return (guint64) ftello(pf);
+#else
+    return (guint64) ftell(pf);
+#endif
+}
+
+static int
+ReadHeader(FILE * pf, archiveheader * pah)
+{
+    unsigned char auch[ARCHIVE_HEADER_SIZE];
+
+    if (SeekTo(pf, 0) || fread(auch, 1, sizeof(auch), pf) != sizeof(auch)
+        || memcmp(auch, szMagic, sizeof(szMagic)) || GetU32(auch + 8) != ARCHIVE_VERSION)
+        return FALSE;
+
+    pah->cGames = GetU32(auch + 12);
+    pah->offIndex = GetU64(auch + 16);
+    pah->cMatches = GetU32(auch + 24);
+
+    return TRUE;
+}
+
+static int
+WriteHeader(FILE * pf, const archiveheader * pah)
+{
+    unsigned char auch[ARCHIVE_HEADER_SIZE];
+
+    memset(auch, 0, sizeof(auch));
+    memcpy(auch, szMagic, sizeof(szMagic));
+    PutU32(auch + 8, ARCHIVE_VERSION);
+    PutU32(auch + 12, pah->cGames);
+    PutU64(auch + 16, pah->offIndex);
+    PutU32(auch + 24, pah->cMatches);
+
+    return !SeekTo(pf, 0) && fwrite(auch, 1, sizeof(auch), pf) == sizeof(auch);
+}
+
+/* The index entry of plGame, less the offsets and sizes */
+static void
+MakeEntry(unsigned char auch[ARCHIVE_ENTRY_SIZE], const listOLD * plGame, guint32 iMatch)
+{
+    const moverecord *pmr = plGame->plNext->p;
+    unsigned int fFlags = 0;
+
+    g_assert(pmr->mt == MOVE_GAMEINFO);
+
+    if (pmr->g.fCrawfordGame)
+        fFlags |= ARCHIVE_FLAG_CRAWFORD;
+    if (pmr->g.fResigned)
+        fFlags |= ARCHIVE_FLAG_RESIGNED;
+    if (pmr->g.fCubeUse)
+        fFlags |= ARCHIVE_FLAG_CUBE;
+    if (pmr->g.fJacoby)
+        fFlags |= ARCHIVE_FLAG_JACOBY;
+
+    memset(auch, 0, ARCHIVE_ENTRY_SIZE);
+    PutU32(auch + 12, iMatch);
+    PutU16(auch + 16, (unsigned int) pmr->g.i);
+    PutU16(auch + 18, (unsigned int) pmr->g.nMatch);
+    PutU16(auch + 20, (unsigned int) pmr->g.anScore[0]);
+    PutU16(auch + 22, (unsigned int) pmr->g.anScore[1]);
+    PutU16(auch + 24, pmr->g.fWinner < 0 ? 0 : (unsigned int) pmr->g.nPoints);
+    auch[26] = (unsigned char) (signed char) pmr->g.fWinner;
+    auch[27] = (unsigned char) fFlags;
+    auch[28] = (unsigned char) pmr->g.bgv;
+    if (mi.nYear) {
+        auch[29] = (unsigned char) mi.nMonth;
+        auch[30] = (unsigned char) mi.nDay;
+        PutU16(auch + 32, mi.nYear);
+    }
+    g_strlcpy((char *) auch + 40, ap[0].szName, ARCHIVE_NAME_SIZE);
+    g_strlcpy((char *) auch + 84, ap[1].szName, ARCHIVE_NAME_SIZE);
+}
+
+/* The compact move records of plGame */
+static void
+AddRecords(GByteArray * pba, const listOLD * plGame)
+{
+    const listOLD *pl;
+
+    for (pl = plGame->plNext->plNext; pl != plGame; pl = pl->plNext) {
+        const moverecord *pmr = pl->p;
+        unsigned char auch[2 + 4 * 7];
+        guint cb = 2;
+        int i;
+
+        auch[0] = (unsigned char) pmr->mt;
+        auch[1] = (unsigned char) (signed char) pmr->fPlayer;
+
+        switch (pmr->mt) {
+        case MOVE_NORMAL:
+            auch[2] = (unsigned char) pmr->anDice[0];
+            auch[3] = (unsigned char) pmr->anDice[1];
+            for (i = 0; i < 8; i++)
+                auch[4 + i] = (unsigned char) (signed char) pmr->n.anMove[i];
+            cb = 12;
+            break;
+        case MOVE_RESIGN:
+            auch[2] = (unsigned char) pmr->r.nResigned;
+            cb = 3;
+            break;
+        case MOVE_SETBOARD:
+            for (i = 0; i < 7; i++)
+                PutU32(auch + 2 + 4 * i, pmr->sb.key.data[i]);
+            cb = 30;
+            break;
+        case MOVE_SETDICE:
+            auch[2] = (unsigned char) pmr->anDice[0];
+            auch[3] = (unsigned char) pmr->anDice[1];
+            cb = 4;
+            break;
+        case MOVE_SETCUBEVAL:
+            PutU32(auch + 2, (guint32) pmr->scv.nCube);
+            cb = 6;
+            break;
+        case MOVE_SETCUBEPOS:
+            auch[2] = (unsigned char) (signed char) pmr->scp.fCubeOwner;
+            cb = 3;
+            break;
+        default:
+            break;
+        }
+
+        g_byte_array_append(pba, auch, cb);
+    }
+}
+
+/* Write the block of plGame at the current position of pf and fill in
+ * its index entry */
+static int
+WriteGame(FILE * pf, listOLD * plGame, guint32 iMatch, unsigned char auchEntry[ARCHIVE_ENTRY_SIZE])
+{
+    GByteArray *pba = g_byte_array_new();
+    guint64 off = Tell(pf), offEnd;
+    guint32 cbRecords;
+    unsigned char auch[4] = { 0, 0, 0, 0 };
+    int fOK;
+
+    MakeEntry(auchEntry, plGame, iMatch);
+    AddRecords(pba, plGame);
+    cbRecords = pba->len;
+    PutU32(auchEntry + 36, cbRecords);
+
+    /* the offsets and the SGF length are filled in once it is written */
+    fOK = fwrite(auchEntry, 1, ARCHIVE_ENTRY_SIZE, pf) == ARCHIVE_ENTRY_SIZE
+        && fwrite(pba->data, 1, cbRecords, pf) == cbRecords && fwrite(auch, 1, 4, pf) == 4;
+    g_byte_array_free(pba, TRUE);
+    if (!fOK)
+        return FALSE;
+
+    SaveGame(pf, plGame);
+
+    offEnd = Tell(pf);
+    PutU64(auchEntry, off);
+    PutU32(auchEntry + 8, (guint32) (offEnd - off));
+    PutU32(auch, (guint32) (offEnd - off - ARCHIVE_ENTRY_SIZE - cbRecords - 4));
+
+    return !SeekTo(pf, off) && fwrite(auchEntry, 1, ARCHIVE_ENTRY_SIZE, pf) == ARCHIVE_ENTRY_SIZE
+        && !SeekTo(pf, off + ARCHIVE_ENTRY_SIZE + cbRecords) && fwrite(auch, 1, 4, pf) == 4 && !SeekTo(pf, offEnd);
+}
+
+struct _archive {
+    FILE *pf;
+    char *szFile;
+    archiveheader ah;
+    GByteArray *pbaIndex;       /* old entries, then the new ones */
+    int fOK;
+};
+
+/* Open the archive sz for adding matches; an existing archive is added
+ * to, anything else replaced.  Errors are reported, and NULL returned. */
+extern archive *
+ArchiveOpen(const char *sz)
+{
+    FILE *pf;
+    archive *pa;
+    archiveheader ah;
+    size_t cbOld;
+
+    if ((pf = g_fopen(sz, "r+b")) && !ReadHeader(pf, &ah)) {
+        fclose(pf);
+        if (!confirmOverwrite(sz, fConfirmSave))
+            return NULL;
+        pf = NULL;
+    }
+
+    if (!pf) {
+        if (!(pf = g_fopen(sz, "w+b"))) {
+            outputerr(sz);
+            return NULL;
+        }
+        ah.cGames = ah.cMatches = 0;
+        ah.offIndex = ARCHIVE_HEADER_SIZE;
+    }
+
+    /* the new games are written over the old index, so keep it */
+    cbOld = (size_t) ah.cGames * ARCHIVE_ENTRY_SIZE;
+    pa = g_new(archive, 1);
+    pa->pf = pf;
+    pa->szFile = g_strdup(sz);
+    pa->ah = ah;
+    pa->pbaIndex = g_byte_array_sized_new((guint) cbOld);
+    g_byte_array_set_size(pa->pbaIndex, (guint) cbOld);
+
+    if (SeekTo(pf, ah.offIndex) || fread(pa->pbaIndex->data, 1, cbOld, pf) != cbOld || SeekTo(pf, ah.offIndex)) {
+        outputerrf(_("%s: the archive index is damaged"), sz);
+        g_byte_array_free(pa->pbaIndex, TRUE);
+        g_free(pa->szFile);
+        g_free(pa);
+        fclose(pf);
+        return NULL;
+    }
+
+    pa->fOK = TRUE;
+
+    return pa;
+}
+
+/* Add the current match to pa */
+extern int
+ArchiveAddMatch(archive * pa)
+{
+    listOLD *pl;
+    unsigned char auchEntry[ARCHIVE_ENTRY_SIZE];
+
+    for (pl = lMatch.plNext; pa->fOK && pl != &lMatch; pl = pl->plNext) {
+        pa->fOK = WriteGame(pa->pf, pl->p, pa->ah.cMatches, auchEntry);
+        g_byte_array_append(pa->pbaIndex, auchEntry, ARCHIVE_ENTRY_SIZE);
+    }
+
+    if (pa->fOK)
+        pa->ah.cMatches++;
+    else
+        outputerr(pa->szFile);
+
+    return pa->fOK;
+}
+
+/* Write the index and header of pa and close it */
+extern int
+ArchiveClose(archive * pa)
+{
+    int fOK = pa->fOK;
+
+    if (fOK) {
+        pa->ah.offIndex = Tell(pa->pf);
+        pa->ah.cGames = pa->pbaIndex->len / ARCHIVE_ENTRY_SIZE;
+        fOK = fwrite(pa->pbaIndex->data, 1, pa->pbaIndex->len, pa->pf) == pa->pbaIndex->len
+            && WriteHeader(pa->pf, &pa->ah);
+    }
+
+    if (fclose(pa->pf))
+        fOK = FALSE;
+    if (pa->fOK && !fOK)
+        outputerr(pa->szFile);
+
+    g_byte_array_free(pa->pbaIndex, TRUE);
+    g_free(pa->szFile);
+    g_free(pa);
+
+    return fOK;
+}
+
+extern void
+CommandExportMatchArchive(char *sz)
+{
+    archive *pa;
+
+    sz = NextToken(&sz);
+
+    if (!plGame) {
+        outputl(_("No game in progress (type `new game' to start one)."));
+        return;
+    }
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to export to (see `help export " "match archive')."));
+        return;
+    }
+
+    if ((pa = ArchiveOpen(sz)) != NULL) {
+        ArchiveAddMatch(pa);
+        ArchiveClose(pa);
+    }
+}
+
+extern void
+CommandImportArchive(char *sz)
+{
+    FILE *pf;
+    char *szFile = NextToken(&sz);
+    archiveheader ah;
+    unsigned char auch[ARCHIVE_ENTRY_SIZE];
+    guint32 i;
+    int iMatch = 1, nGames = 0, fStarted = FALSE;
+
+    if (!szFile || !*szFile) {
+        outputl(_("You must specify an archive to import (see `help " "import archive')."));
+        return;
+    }
+
+    if (sz && *sz && (iMatch = ParseNumber(&sz)) < 1) {
+        outputl(_("You must specify a positive match number (see `help " "import archive')."));
+        return;
+    }
+
+    if (!(pf = g_fopen(szFile, "rb"))) {
+        outputerr(szFile);
+        return;
+    }
+
+    if (!ReadHeader(pf, &ah)) {
+        outputerrf(_("%s: not a GNU Backgammon match archive"), szFile);
+        fclose(pf);
+        return;
+    }
+
+    if ((guint32) iMatch > ah.cMatches) {
+        outputerrf(_("%s: the archive holds %u matches"), szFile, ah.cMatches);
+        fclose(pf);
+        return;
+    }
+
+    /* the games of a match are contiguous in the index */
+    for (i = 0; i < ah.cGames; i++) {
+        int n;
+
+        if (SeekTo(pf, ah.offIndex + (guint64) i * ARCHIVE_ENTRY_SIZE) || fread(auch, 1, sizeof(auch), pf) != sizeof(auch)) {
+            outputerrf(_("%s: the archive index is damaged"), szFile);
+            break;
+        }
+
+        if (GetU32(auch + 12) != (guint32) (iMatch - 1)) {
+            if (nGames)
+                break;
+            continue;
+        }
+
+        if (SeekTo(pf, GetU64(auch) + ARCHIVE_ENTRY_SIZE + GetU32(auch + 36) + 4)) {
+            outputerr(szFile);
+            break;
+        }
+
+        if ((n = SGFReadGame(pf, szFile, &fStarted)) < 0)
+            break;
+        nGames += n;
+    }
+
+    fclose(pf);
+
+    if (nGames > 0) {
+        UpdateSettings();
+
+#if USE_GTK
+        if (fX) {
+            GTKThaw();
+            GTKSet(ap);
+        }
+#endif
+
+        setDefaultFileName(szFile);
+        if (fUseKeyNames)
+            SmartSit();
+        if (fGotoFirstGame)
+            CommandFirstGame(NULL);
+    }
+}
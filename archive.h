@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+/*
+ * The match archive is a binary file holding any number of matches,
+ * with an index that lets a reader go straight to a game, or select
+ * games by player, result or date, without parsing the others.  All
+ * integers are little endian.
+ *
+ * Header (ARCHIVE_HEADER_SIZE bytes):
+ *
+ *   0  magic "GNUBGMA\0"
+ *   8  u32 format version (ARCHIVE_VERSION)
+ *  12  u32 number of games
+ *  16  u64 offset of the index
+ *  24  u32 number of matches
+ *  28  u32 reserved (0)
+ *
+ * The index is an array of entries of ARCHIVE_ENTRY_SIZE bytes, one per
+ * game, in the order the games were added:
+ *
+ *   0  u64 offset of the game block
+ *   8  u32 size of the game block
+ *  12  u32 match number (from 0)
+ *  16  u16 game number within the match (from 0)
+ *  18  u16 match length (0 for money)
+ *  20  u16 score of player 0 before the game
+ *  22  u16 score of player 1 before the game
+ *  24  u16 points won
+ *  26  i8  winner (-1 if the game is unfinished)
+ *  27  u8  flags (ARCHIVE_FLAG_*)
+ *  28  u8  variation (bgvariation)
+ *  29  u8  month (0 if the date is unknown)
+ *  30  u8  day
+ *  31  u8  reserved (0)
+ *  32  u16 year (0 if the date is unknown)
+ *  34  u16 reserved (0)
+ *  36  u32 size of the move records
+ *  40  name of player 0, NUL padded
+ *  84  name of player 1, NUL padded
+ *
+ * A game block starts with a copy of its index entry, so that the
+ * index can be rebuilt by walking the blocks.  The move records
+ * follow; each is a u8 movetype and an i8 player, then
+ *
+ *   MOVE_NORMAL      u8 dice[2], i8 anMove[8] (-1 for unused)
+ *   MOVE_RESIGN      u8 points resigned
+ *   MOVE_SETBOARD    u32 positionkey[7]
+ *   MOVE_SETDICE     u8 dice[2]
+ *   MOVE_SETCUBEVAL  u32 cube value
+ *   MOVE_SETCUBEPOS  i8 cube owner
+ *
+ * and nothing for MOVE_DOUBLE, MOVE_TAKE and MOVE_DROP.  Last comes a
+ * u32 length and the game as an SGF game tree, which holds everything
+ * else (analysis, comments, match information) and is what the game
+ * is restored from on import.
+ */
+
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_SIZE 32
+#define ARCHIVE_ENTRY_SIZE 128
+#define ARCHIVE_NAME_SIZE 44
+
+#define ARCHIVE_FLAG_CRAWFORD 1 /* Crawford game */
+#define ARCHIVE_FLAG_RESIGNED 2 /* ended by resignation */
+#define ARCHIVE_FLAG_CUBE 4     /* cube in use */
+#define ARCHIVE_FLAG_JACOBY 8   /* Jacoby rule in force */
+
+typedef struct _archive archive;
+
+extern archive *ArchiveOpen(const char *sz);
+extern int ArchiveAddMatch(archive * pa);
+extern int ArchiveClose(archive * pa);
+
+#endif                          /* ARCHIVE_H */
@@ -0,0 +1,826 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Arrow IPC export of analysed decisions, see arrow.h for the columns */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "arrow.h"
+#include "backgammon.h"
+#include "matchid.h"
+#include "positionid.h"
+
+/*
+ * The stream is a schema message, record batch messages and an end of
+ * stream marker.  Each message is a continuation marker (0xFFFFFFFF),
+ * the size of its metadata, the metadata, a flatbuffer padded to 8
+ * bytes, and the message body, the buffers of the record batch each
+ * padded to 8 bytes.  See the Arrow columnar format specification and
+ * Schema.fbs and Message.fbs for the tables written below.
+ */
+
+#define ARROW_METADATA_V5 4
+
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_RECORDBATCH 3
+
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_FLOATINGPOINT 3
+#define ARROW_TYPE_UTF8 5
+#define ARROW_TYPE_FIXEDSIZELIST 16
+
+#define ARROW_PRECISION_DOUBLE 2
+
+typedef enum {
+    COL_INT32,
+    COL_FLOAT64,
+    COL_UTF8,
+    COL_MOVE,                   /* fixed size list of 8 int8 */
+    COL_INT8                    /* only as the items of COL_MOVE */
+} coltype;
+
+typedef enum {
+    COL_SOURCE,
+    COL_GAME,
+    COL_RECORD,
+    COL_PLAYER,
+    COL_DECISION,
+    COL_POSITION_ID,
+    COL_MATCH_ID,
+    COL_DIE0,
+    COL_DIE1,
+    COL_CUBE,
+    COL_CUBE_OWNER,
+    COL_MATCH_LENGTH,
+    COL_SCORE0,
+    COL_SCORE1,
+    COL_CHOSEN,
+    COL_BEST,
+    COL_BEST_ACTION,
+    COL_CHOSEN_EQUITY,
+    COL_BEST_EQUITY,
+    COL_ERROR,
+    COL_LUCK,
+    NUM_COLUMNS
+} columnid;
+
+static const struct {
+    const char *szName;
+    coltype ct;
+} acs[NUM_COLUMNS] = {
+    { "source", COL_UTF8 },
+    { "game", COL_INT32 },
+    { "record", COL_INT32 },
+    { "player", COL_INT32 },
+    { "decision", COL_UTF8 },
+    { "position_id", COL_UTF8 },
+    { "match_id", COL_UTF8 },
+    { "die0", COL_INT32 },
+    { "die1", COL_INT32 },
+    { "cube", COL_INT32 },
+    { "cube_owner", COL_INT32 },
+    { "match_length", COL_INT32 },
+    { "score0", COL_INT32 },
+    { "score1", COL_INT32 },
+    { "chosen", COL_MOVE },
+    { "best", COL_MOVE },
+    { "best_action", COL_UTF8 },
+    { "chosen_equity", COL_FLOAT64 },
+    { "best_equity", COL_FLOAT64 },
+    { "error", COL_FLOAT64 },
+    { "luck", COL_FLOAT64 }
+};
+
+typedef struct {
+    GByteArray *pbaValid;       /* validity bitmap, a bit per row */
+    GByteArray *pbaValues;      /* values, or the characters of strings */
+    GByteArray *pbaOffsets;     /* string offsets, rows + 1 of them */
+    guint cNull;
+} column;
+
+struct _arrowwriter {
+    FILE *pf;
+    char *szFile;
+    column ac[NUM_COLUMNS];
+    guint cRows;                /* in the batch being built */
+    int fOK;
+};
+
+static const guint8 auchZero[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static void
+AppendU16(GByteArray * pba, guint n)
+{
+    guint8 auch[2];
+
+    auch[0] = (guint8) (n & 0xFF);
+    auch[1] = (guint8) ((n >> 8) & 0xFF);
+    g_byte_array_append(pba, auch, 2);
+}
+
+static void
+AppendU32(GByteArray * pba, guint32 n)
+{
+    AppendU16(pba, n & 0xFFFF);
+    AppendU16(pba, n >> 16);
+}
+
+static void
+AppendU64(GByteArray * pba, guint64 n)
+{
+    AppendU32(pba, (guint32) n);
+    AppendU32(pba, (guint32) (n >> 32));
+}
+
+static void
+PutU32(GByteArray * pba, guint off, guint32 n)
+{
+    pba->data[off] = (guint8) (n & 0xFF);
+    pba->data[off + 1] = (guint8) ((n >> 8) & 0xFF);
+    pba->data[off + 2] = (guint8) ((n >> 16) & 0xFF);
+    pba->data[off + 3] = (guint8) (n >> 24);
+}
+
+static guint
+Pad(GByteArray * pba, guint cbAlign)
+{
+    if (pba->len % cbAlign)
+        g_byte_array_append(pba, auchZero, cbAlign - pba->len % cbAlign);
+
+    return pba->len;
+}
+
+/*
+ * A minimal flatbuffer writer.  Flatbuffers are usually built back to
+ * front; here each table is written before what it refers to, and its
+ * offsets are patched by Link() once their targets are written.  Every
+ * table is preceded by its vtable and starts 8 byte aligned, so that
+ * aligning its fields within the table aligns them in the buffer.
+ */
+
+typedef struct {
+    guint cb;                   /* 1, 2, 4 or 8; 0 if the field is absent */
+    guint64 n;                  /* value; offsets are left 0 for Link() */
+} fbfield;
+
+#define FB_MAX_FIELDS 8
+
+/* Point the offset at off to the object at offTarget */
+static void
+Link(GByteArray * pba, guint off, guint offTarget)
+{
+    g_assert(offTarget > off);
+    PutU32(pba, off, offTarget - off);
+}
+
+/* Write a table of c fields, returning its position; aoff[] gets the
+ * position of each field */
+static guint
+Table(GByteArray * pba, unsigned int c, const fbfield af[], guint aoff[])
+{
+    guint aoffField[FB_MAX_FIELDS];
+    guint cbTable = 4, offVtable, offTable;
+    guint8 uch;
+    unsigned int i;
+
+    g_assert(c <= FB_MAX_FIELDS);
+
+    for (i = 0; i < c; i++)
+        if (af[i].cb) {
+            cbTable = (cbTable + af[i].cb - 1) / af[i].cb * af[i].cb;
+            aoffField[i] = cbTable;
+            cbTable += af[i].cb;
+        } else
+            aoffField[i] = 0;
+
+    offVtable = Pad(pba, 2);
+    AppendU16(pba, 4 + 2 * c);
+    AppendU16(pba, cbTable);
+    for (i = 0; i < c; i++)
+        AppendU16(pba, aoffField[i]);
+
+    offTable = Pad(pba, 8);
+    AppendU32(pba, offTable - offVtable);
+    for (i = 0; i < c; i++) {
+        if (!af[i].cb)
+            continue;
+        g_byte_array_append(pba, auchZero, offTable + aoffField[i] - pba->len);
+        switch (af[i].cb) {
+        case 1:
+            uch = (guint8) af[i].n;
+            g_byte_array_append(pba, &uch, 1);
+            break;
+        case 2:
+            AppendU16(pba, (guint) af[i].n);
+            break;
+        case 4:
+            AppendU32(pba, (guint32) af[i].n);
+            break;
+        default:
+            AppendU64(pba, af[i].n);
+            break;
+        }
+        if (aoff)
+            aoff[i] = offTable + aoffField[i];
+    }
+
+    return offTable;
+}
+
+/* Start a vector of c elements aligned to cbAlign, returning its
+ * position; the caller appends the elements */
+static guint
+Vector(GByteArray * pba, guint c, guint cbAlign)
+{
+    guint off;
+
+    Pad(pba, 4);
+    while ((pba->len + 4) % cbAlign)
+        AppendU32(pba, 0);
+    off = pba->len;
+    AppendU32(pba, c);
+
+    return off;
+}
+
+static guint
+String(GByteArray * pba, const char *sz)
+{
+    guint off = Vector(pba, (guint) strlen(sz), 4);
+
+    g_byte_array_append(pba, (const guint8 *) sz, (guint) strlen(sz) + 1);
+
+    return off;
+}
+
+/* The Field table describing a column of type ct, and its children */
+static guint
+Field(GByteArray * pba, const char *szName, coltype ct, int fNullable)
+{
+    static const guint8 aType[] = { ARROW_TYPE_INT, ARROW_TYPE_FLOATINGPOINT, ARROW_TYPE_UTF8,
+        ARROW_TYPE_FIXEDSIZELIST, ARROW_TYPE_INT
+    };
+    fbfield af[6] = { {4, 0}, {1, 0}, {1, 0}, {4, 0}, {0, 0}, {4, 0} };
+    fbfield afType[2] = { {0, 0}, {0, 0} };
+    guint aoff[6];
+    guint offField, offChildren;
+
+    af[1].n = fNullable;
+    af[2].n = aType[ct];
+    offField = Table(pba, 6, af, aoff);
+
+    Link(pba, aoff[0], String(pba, szName));
+
+    switch (ct) {
+    case COL_INT32:
+    case COL_INT8:
+        afType[0].cb = 4;
+        afType[0].n = ct == COL_INT32 ? 32 : 8;
+        afType[1].cb = 1;
+        afType[1].n = TRUE;
+        Link(pba, aoff[3], Table(pba, 2, afType, NULL));
+        break;
+    case COL_FLOAT64:
+        afType[0].cb = 2;
+        afType[0].n = ARROW_PRECISION_DOUBLE;
+        Link(pba, aoff[3], Table(pba, 1, afType, NULL));
+        break;
+    case COL_UTF8:
+        Link(pba, aoff[3], Table(pba, 0, afType, NULL));
+        break;
+    case COL_MOVE:
+        afType[0].cb = 4;
+        afType[0].n = 8;
+        Link(pba, aoff[3], Table(pba, 1, afType, NULL));
+        break;
+    }
+
+    /* readers insist on the children, even an empty list of them */
+    offChildren = Vector(pba, ct == COL_MOVE, 4);
+    Link(pba, aoff[5], offChildren);
+    if (ct == COL_MOVE) {
+        AppendU32(pba, 0);
+        Link(pba, offChildren + 4, Field(pba, "item", COL_INT8, FALSE));
+    }
+
+    return offField;
+}
+
+/* Start the metadata of a message, returning the position of the
+ * offset to its header */
+static guint
+Message(GByteArray * pba, guint8 header, guint64 cbBody)
+{
+    fbfield af[4] = { {2, ARROW_METADATA_V5}, {1, 0}, {4, 0}, {8, 0} };
+    guint aoff[4];
+
+    af[1].n = header;
+    af[3].n = cbBody;
+
+    AppendU32(pba, 0);
+    PutU32(pba, 0, Table(pba, 4, af, aoff));
+
+    return aoff[2];
+}
+
+/* Write a message with metadata pba and body pbaBody */
+static int
+WriteMessage(FILE * pf, GByteArray * pba, const GByteArray * pbaBody)
+{
+    guint8 auch[8];
+
+    Pad(pba, 8);
+    auch[0] = auch[1] = auch[2] = auch[3] = 0xFF;
+    auch[4] = (guint8) (pba->len & 0xFF);
+    auch[5] = (guint8) ((pba->len >> 8) & 0xFF);
+    auch[6] = (guint8) ((pba->len >> 16) & 0xFF);
+    auch[7] = (guint8) (pba->len >> 24);
+
+    return fwrite(auch, 1, 8, pf) == 8 && fwrite(pba->data, 1, pba->len, pf) == pba->len
+        && (!pbaBody || fwrite(pbaBody->data, 1, pbaBody->len, pf) == pbaBody->len);
+}
+
+static int
+WriteSchema(FILE * pf)
+{
+    GByteArray *pba = g_byte_array_new();
+    fbfield af[2] = { {0, 0}, {4, 0} };
+    guint aoff[2];
+    guint offHeader, offFields;
+    unsigned int i;
+    int fOK;
+
+    offHeader = Message(pba, ARROW_HEADER_SCHEMA, 0);
+    Link(pba, offHeader, Table(pba, 2, af, aoff));
+
+    offFields = Vector(pba, NUM_COLUMNS, 4);
+    Link(pba, aoff[1], offFields);
+    for (i = 0; i < NUM_COLUMNS; i++)
+        AppendU32(pba, 0);
+    for (i = 0; i < NUM_COLUMNS; i++)
+        Link(pba, offFields + 4 + 4 * i, Field(pba, acs[i].szName, acs[i].ct, TRUE));
+
+    fOK = WriteMessage(pf, pba, NULL);
+    g_byte_array_free(pba, TRUE);
+
+    return fOK;
+}
+
+/* Add a buffer to the body of a record batch and its position to
+ * pbaBuffers */
+static void
+AddBuffer(GByteArray * pbaBody, GByteArray * pbaBuffers, const GByteArray * pba, guint cb)
+{
+    AppendU64(pbaBuffers, pbaBody->len);
+    AppendU64(pbaBuffers, cb);
+    if (cb)
+        g_byte_array_append(pbaBody, pba->data, cb);
+    Pad(pbaBody, 8);
+}
+
+/* Write the rows built so far as a record batch and start a new one */
+static int
+WriteBatch(arrowwriter * paw)
+{
+    GByteArray *pba = g_byte_array_new();
+    GByteArray *pbaBody = g_byte_array_new();
+    GByteArray *pbaNodes = g_byte_array_new();
+    GByteArray *pbaBuffers = g_byte_array_new();
+    fbfield af[3] = { {8, 0}, {4, 0}, {4, 0} };
+    guint aoff[3];
+    guint offHeader, off;
+    unsigned int i;
+    int fOK;
+
+    for (i = 0; i < NUM_COLUMNS; i++) {
+        column *pc = &paw->ac[i];
+
+        AppendU64(pbaNodes, paw->cRows);
+        AppendU64(pbaNodes, pc->cNull);
+        AddBuffer(pbaBody, pbaBuffers, pc->pbaValid, pc->cNull ? pc->pbaValid->len : 0);
+
+        switch (acs[i].ct) {
+        case COL_UTF8:
+            AddBuffer(pbaBody, pbaBuffers, pc->pbaOffsets, pc->pbaOffsets->len);
+            AddBuffer(pbaBody, pbaBuffers, pc->pbaValues, pc->pbaValues->len);
+            break;
+        case COL_MOVE:
+            AppendU64(pbaNodes, (guint64) paw->cRows * 8);
+            AppendU64(pbaNodes, 0);
+            AddBuffer(pbaBody, pbaBuffers, pc->pbaValid, 0);
+            AddBuffer(pbaBody, pbaBuffers, pc->pbaValues, pc->pbaValues->len);
+            break;
+        default:
+            AddBuffer(pbaBody, pbaBuffers, pc->pbaValues, pc->pbaValues->len);
+            break;
+        }
+
+        g_byte_array_set_size(pc->pbaValid, 0);
+        g_byte_array_set_size(pc->pbaValues, 0);
+        if (pc->pbaOffsets) {
+            g_byte_array_set_size(pc->pbaOffsets, 0);
+            AppendU32(pc->pbaOffsets, 0);
+        }
+        pc->cNull = 0;
+    }
+
+    offHeader = Message(pba, ARROW_HEADER_RECORDBATCH, pbaBody->len);
+    af[0].n = paw->cRows;
+    Link(pba, offHeader, Table(pba, 3, af, aoff));
+
+    off = Vector(pba, pbaNodes->len / 16, 8);
+    Link(pba, aoff[1], off);
+    g_byte_array_append(pba, pbaNodes->data, pbaNodes->len);
+    off = Vector(pba, pbaBuffers->len / 16, 8);
+    Link(pba, aoff[2], off);
+    g_byte_array_append(pba, pbaBuffers->data, pbaBuffers->len);
+
+    fOK = WriteMessage(paw->pf, pba, pbaBody);
+    paw->cRows = 0;
+
+    g_byte_array_free(pbaBuffers, TRUE);
+    g_byte_array_free(pbaNodes, TRUE);
+    g_byte_array_free(pbaBody, TRUE);
+    g_byte_array_free(pba, TRUE);
+
+    return fOK;
+}
+
+static void
+SetValid(column * pc, guint iRow, int fValid)
+{
+    if (!(iRow % 8))
+        g_byte_array_append(pc->pbaValid, auchZero, 1);
+
+    if (fValid)
+        pc->pbaValid->data[iRow / 8] |= (guint8) (1 << (iRow % 8));
+    else
+        pc->cNull++;
+}
+
+static void
+AddNull(arrowwriter * paw, columnid i)
+{
+    column *pc = &paw->ac[i];
+    static const guint8 auchMove[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+    SetValid(pc, paw->cRows, FALSE);
+
+    switch (acs[i].ct) {
+    case COL_UTF8:
+        AppendU32(pc->pbaOffsets, pc->pbaValues->len);
+        break;
+    case COL_MOVE:
+        g_byte_array_append(pc->pbaValues, auchMove, 8);
+        break;
+    case COL_FLOAT64:
+        g_byte_array_append(pc->pbaValues, auchZero, 8);
+        break;
+    default:
+        g_byte_array_append(pc->pbaValues, auchZero, 4);
+        break;
+    }
+}
+
+static void
+AddInt(arrowwriter * paw, columnid i, int n)
+{
+    SetValid(&paw->ac[i], paw->cRows, TRUE);
+    AppendU32(paw->ac[i].pbaValues, (guint32) n);
+}
+
+static void
+AddDouble(arrowwriter * paw, columnid i, double r)
+{
+    guint64 n;
+
+    memcpy(&n, &r, sizeof(n));
+    SetValid(&paw->ac[i], paw->cRows, TRUE);
+    AppendU64(paw->ac[i].pbaValues, n);
+}
+
+static void
+AddString(arrowwriter * paw, columnid i, const char *sz)
+{
+    column *pc = &paw->ac[i];
+
+    if (!sz) {
+        AddNull(paw, i);
+        return;
+    }
+
+    SetValid(pc, paw->cRows, TRUE);
+    g_byte_array_append(pc->pbaValues, (const guint8 *) sz, (guint) strlen(sz));
+    AppendU32(pc->pbaOffsets, pc->pbaValues->len);
+}
+
+static void
+AddMove(arrowwriter * paw, columnid i, const int anMove[8])
+{
+    guint8 auch[8];
+    int j;
+
+    if (!anMove) {
+        AddNull(paw, i);
+        return;
+    }
+
+    for (j = 0; j < 8; j++)
+        auch[j] = (guint8) (gint8) anMove[j];
+    SetValid(&paw->ac[i], paw->cRows, TRUE);
+    g_byte_array_append(paw->ac[i].pbaValues, auch, 8);
+}
+
+/* Open the stream sz, replacing any file of that name.  Errors are
+ * reported, and NULL returned. */
+extern arrowwriter *
+ArrowOpen(const char *sz)
+{
+    FILE *pf;
+    arrowwriter *paw;
+    unsigned int i;
+
+    if (!confirmOverwrite(sz, fConfirmSave))
+        return NULL;
+
+    if (!(pf = g_fopen(sz, "wb"))) {
+        outputerr(sz);
+        return NULL;
+    }
+
+    if (!WriteSchema(pf)) {
+        outputerr(sz);
+        fclose(pf);
+        return NULL;
+    }
+
+    paw = g_new0(arrowwriter, 1);
+    paw->pf = pf;
+    paw->szFile = g_strdup(sz);
+    for (i = 0; i < NUM_COLUMNS; i++) {
+        paw->ac[i].pbaValid = g_byte_array_new();
+        paw->ac[i].pbaValues = g_byte_array_new();
+        if (acs[i].ct == COL_UTF8) {
+            paw->ac[i].pbaOffsets = g_byte_array_new();
+            AppendU32(paw->ac[i].pbaOffsets, 0);
+        }
+    }
+    paw->fOK = TRUE;
+
+    return paw;
+}
+
+/* A decision, and the state of the match it was taken in */
+typedef struct {
+    int iGame;
+    int iRecord;
+    const moverecord *pmr;
+    const matchstate *pms;
+    const char *szDecision;
+    const int *anChosen, *anBest;       /* NULL for cube decisions */
+    const char *szBestAction;   /* NULL for moves */
+    float rChosen, rBest;       /* ERR_VAL if not analysed */
+} decision;
+
+static void
+AddRow(arrowwriter * paw, const char *szSource, const decision * pd)
+{
+    const matchstate *pms = pd->pms;
+
+    AddString(paw, COL_SOURCE, szSource);
+    AddInt(paw, COL_GAME, pd->iGame);
+    AddInt(paw, COL_RECORD, pd->iRecord);
+    AddInt(paw, COL_PLAYER, pd->pmr->fPlayer);
+    AddString(paw, COL_DECISION, pd->szDecision);
+    AddString(paw, COL_POSITION_ID, PositionID((ConstTanBoard) pms->anBoard));
+    AddString(paw, COL_MATCH_ID, MatchIDFromMatchState(pms));
+    if (pd->anChosen) {
+        AddInt(paw, COL_DIE0, (int) pd->pmr->anDice[0]);
+        AddInt(paw, COL_DIE1, (int) pd->pmr->anDice[1]);
+    } else {
+        AddNull(paw, COL_DIE0);
+        AddNull(paw, COL_DIE1);
+    }
+    AddInt(paw, COL_CUBE, pms->nCube);
+    AddInt(paw, COL_CUBE_OWNER, pms->fCubeOwner);
+    AddInt(paw, COL_MATCH_LENGTH, pms->nMatchTo);
+    AddInt(paw, COL_SCORE0, pms->anScore[0]);
+    AddInt(paw, COL_SCORE1, pms->anScore[1]);
+    AddMove(paw, COL_CHOSEN, pd->anChosen);
+    AddMove(paw, COL_BEST, pd->anBest);
+    AddString(paw, COL_BEST_ACTION, pd->szBestAction);
+    if (pd->rChosen != ERR_VAL) {
+        AddDouble(paw, COL_CHOSEN_EQUITY, pd->rChosen);
+        AddDouble(paw, COL_BEST_EQUITY, pd->rBest);
+        AddDouble(paw, COL_ERROR, pd->rChosen - pd->rBest);
+    } else {
+        AddNull(paw, COL_CHOSEN_EQUITY);
+        AddNull(paw, COL_BEST_EQUITY);
+        AddNull(paw, COL_ERROR);
+    }
+    if (pd->anChosen && pd->pmr->rLuck != ERR_VAL)
+        AddDouble(paw, COL_LUCK, pd->pmr->rLuck);
+    else
+        AddNull(paw, COL_LUCK);
+
+    if (++paw->cRows == ARROW_BATCH_ROWS && paw->fOK)
+        paw->fOK = WriteBatch(paw);
+}
+
+/* The equities of the cube decision of pmr, as in updateStatcontext() */
+static int
+CubeEquities(const moverecord * pmr, const matchstate * pms, float arDouble[4])
+{
+    cubeinfo ci;
+
+    if (!pms->fCubeUse || !pmr->CubeDecPtr || pmr->CubeDecPtr->esDouble.et == EVAL_NONE)
+        return FALSE;
+
+    GetMatchStateCubeInfo(&ci, pms);
+    FindCubeDecision(arDouble, pmr->CubeDecPtr->aarOutput, &ci);
+
+    return TRUE;
+}
+
+static void
+ArrowAddGame(arrowwriter * paw, const char *szSource, listOLD * plGame, int iGame)
+{
+    listOLD *pl;
+    matchstate msPosition;
+    decision d;
+    float arDouble[4];
+
+    d.iGame = iGame;
+    d.iRecord = 0;
+    d.pms = &msPosition;
+
+    for (pl = plGame->plNext; pl != plGame; pl = pl->plNext, d.iRecord++) {
+        moverecord *pmr = pl->p;
+
+        d.pmr = pmr;
+        d.anChosen = d.anBest = NULL;
+        d.szBestAction = NULL;
+        d.rChosen = d.rBest = ERR_VAL;
+
+        FixMatchState(&msPosition, pmr);
+
+        switch (pmr->mt) {
+        case MOVE_NORMAL:
+            if (pmr->fPlayer != msPosition.fMove)
+                SwapSides(msPosition.anBoard);
+            msPosition.fTurn = msPosition.fMove = pmr->fPlayer;
+
+            if (CubeEquities(pmr, &msPosition, arDouble)) {
+                d.szDecision = "no double";
+                d.szBestAction = arDouble[OUTPUT_NODOUBLE] < arDouble[OUTPUT_OPTIMAL] ? "double" : "no double";
+                d.rChosen = arDouble[OUTPUT_NODOUBLE];
+                d.rBest = arDouble[OUTPUT_OPTIMAL];
+                AddRow(paw, szSource, &d);
+                d.szBestAction = NULL;
+                d.rChosen = d.rBest = ERR_VAL;
+            }
+
+            /* no legal move is no decision */
+            if (pmr->n.anMove[0] < 0)
+                break;
+
+            d.szDecision = "move";
+            d.anChosen = pmr->n.anMove;
+            if (pmr->ml.cMoves) {
+                d.anBest = pmr->ml.amMoves[0].anMove;
+                if (pmr->n.iMove < pmr->ml.cMoves) {
+                    d.rChosen = pmr->ml.amMoves[pmr->n.iMove].rScore;
+                    d.rBest = pmr->ml.amMoves[0].rScore;
+                }
+            }
+            AddRow(paw, szSource, &d);
+            break;
+
+        case MOVE_DOUBLE:
+            if (pmr->fPlayer != msPosition.fMove)
+                SwapSides(msPosition.anBoard);
+            msPosition.fMove = pmr->fPlayer;
+
+            if (DoubleType(msPosition.fDoubled, msPosition.fMove, msPosition.fTurn) != DT_NORMAL)
+                break;
+
+            d.szDecision = "double";
+            if (CubeEquities(pmr, &msPosition, arDouble)) {
+                d.szBestAction = arDouble[OUTPUT_NODOUBLE] < arDouble[OUTPUT_OPTIMAL] ? "double" : "no double";
+                d.rChosen = MIN(arDouble[OUTPUT_TAKE], arDouble[OUTPUT_DROP]);
+                d.rBest = arDouble[OUTPUT_OPTIMAL];
+            }
+            AddRow(paw, szSource, &d);
+            break;
+
+        case MOVE_TAKE:
+        case MOVE_DROP:
+            if ((taketype) DoubleType(msPosition.fDoubled, msPosition.fMove, msPosition.fTurn) > TT_NORMAL)
+                break;
+
+            d.szDecision = pmr->mt == MOVE_TAKE ? "take" : "drop";
+            if (CubeEquities(pmr, &msPosition, arDouble)) {
+                /* the equities are those of the doubler */
+                d.szBestAction = arDouble[OUTPUT_TAKE] < arDouble[OUTPUT_DROP] ? "take" : "drop";
+                d.rChosen = -arDouble[pmr->mt == MOVE_TAKE ? OUTPUT_TAKE : OUTPUT_DROP];
+                d.rBest = -MIN(arDouble[OUTPUT_TAKE], arDouble[OUTPUT_DROP]);
+            }
+            AddRow(paw, szSource, &d);
+            break;
+
+        default:
+            break;
+        }
+
+        ApplyMoveRecord(&msPosition, plGame, pmr);
+    }
+}
+
+/* Add the decisions of the current match to paw, their source being
+ * szSource (which may be NULL) */
+extern int
+ArrowAddMatch(arrowwriter * paw, const char *szSource)
+{
+    listOLD *pl;
+    int iGame = 0;
+
+    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
+        ArrowAddGame(paw, szSource, pl->p, ++iGame);
+
+    if (!paw->fOK)
+        outputerr(paw->szFile);
+
+    return paw->fOK;
+}
+
+/* Write the last rows and the end of stream marker, and close paw */
+extern int
+ArrowClose(arrowwriter * paw)
+{
+    static const guint8 auchEOS[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0 };
+    int fOK = paw->fOK;
+    unsigned int i;
+
+    if (fOK && paw->cRows)
+        fOK = WriteBatch(paw);
+    if (fOK)
+        fOK = fwrite(auchEOS, 1, sizeof(auchEOS), paw->pf) == sizeof(auchEOS);
+
+    if (fclose(paw->pf))
+        fOK = FALSE;
+    if (paw->fOK && !fOK)
+        outputerr(paw->szFile);
+
+    for (i = 0; i < NUM_COLUMNS; i++) {
+        g_byte_array_free(paw->ac[i].pbaValid, TRUE);
+        g_byte_array_free(paw->ac[i].pbaValues, TRUE);
+        if (paw->ac[i].pbaOffsets)
+            g_byte_array_free(paw->ac[i].pbaOffsets, TRUE);
+    }
+    g_free(paw->szFile);
+    g_free(paw);
+
+    return fOK;
+}
+
+extern void
+CommandExportMatchArrow(char *sz)
+{
+    arrowwriter *paw;
+
+    sz = NextToken(&sz);
+
+    if (!plGame) {
+        outputl(_("No game in progress (type `new game' to start one)."));
+        return;
+    }
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to export to (see `help export " "match arrow')."));
+        return;
+    }
+
+    if ((paw = ArrowOpen(sz)) != NULL) {
+        ArrowAddMatch(paw, szCurrentFileName);
+        ArrowClose(paw);
+    }
+}
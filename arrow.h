@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARROW_H
+#define ARROW_H
+
+/*
+ * Export of the analysed decisions of matches as an Apache Arrow IPC
+ * stream (the format of pyarrow.ipc.open_stream() and of the ".arrows"
+ * files of most data tools), one row per decision:
+ *
+ *   source          utf8      file the match was read from
+ *   game            int32     game number, from 1
+ *   record          int32     index of the move record in the game
+ *   player          int32     player deciding, 0 or 1
+ *   decision        utf8      "move", "no double", "double", "take" or
+ *                             "drop"
+ *   position_id     utf8      position ID, with the player on roll (the
+ *                             doubler for take and drop) to move
+ *   match_id        utf8      match ID
+ *   die0, die1      int32     dice, null for cube decisions
+ *   cube            int32     cube value
+ *   cube_owner      int32     player owning the cube, -1 if centred
+ *   match_length    int32     0 for money play
+ *   score0, score1  int32     score of each player
+ *   chosen          int8[8]   move played, as from and to points (see
+ *                             anMove in moverecord), -1 for unused
+ *   best            int8[8]   best move
+ *   best_action     utf8      best cube action, as for decision
+ *   chosen_equity   float64   equity of the decision taken, for the
+ *                             player deciding
+ *   best_equity     float64   equity of the best decision
+ *   error           float64   chosen_equity - best_equity, <= 0
+ *   luck            float64   luck of the roll
+ *
+ * Moves are null in cube rows and best_action in move rows; equities
+ * are null when the decision wasn't analysed and luck when the roll
+ * wasn't.  Rows are written in record batches of ARROW_BATCH_ROWS, so
+ * memory use doesn't grow with the number of matches exported.
+ */
+
+#define ARROW_BATCH_ROWS 65536
+
+typedef struct _arrowwriter arrowwriter;
+
+extern arrowwriter *ArrowOpen(const char *sz);
+extern int ArrowAddMatch(arrowwriter * paw, const char *szSource);
+extern int ArrowClose(arrowwriter * paw);
+
+#endif                          /* ARROW_H */
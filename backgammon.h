@@ -55,6 +55,9 @@ typedef struct command {
 typedef struct procrecorddata {
     /* Record handler */
     int (*pfProcessRecord) (struct procrecorddata *);
+    /* Handler of the provisional results of a hint, or NULL; see
+     * PROCREC_HINT_ARGOUT_PLIES */
+    int (*pfProcessStage) (struct procrecorddata *);
     void *pvUserData;
     void *avInputData[8];
     void *avOutputData[8];
@@ -62,11 +65,13 @@ typedef struct procrecorddata {
 
 #define PROCREC_HINT_ARGIN_SHOWPROGRESS 0
 #define PROCREC_HINT_ARGIN_MAXMOVES 1
+#define PROCREC_HINT_ARGIN_STAGE 2      /* data of pfProcessStage */
 #define PROCREC_HINT_ARGOUT_MATCHSTATE 0
 #define PROCREC_HINT_ARGOUT_CUBEINFO 1
 #define PROCREC_HINT_ARGOUT_MOVELIST 2
 #define PROCREC_HINT_ARGOUT_MOVERECORD 3
 #define PROCREC_HINT_ARGOUT_INDEX 4
+#define PROCREC_HINT_ARGOUT_PLIES 5     /* of the moves given to pfProcessStage */
 
 
 typedef enum {
@@ -228,12 +233,32 @@ typedef struct {
     int n;
 } decisionData;
 
+typedef struct _analysisjournal analysisjournal;
+
+/* The settings an analysis runs with, taken from the "set analysis"
+ * ones by GetAnalysisContext() when it starts.  Each analysis has its
+ * own, so that several can be under way at once. */
+typedef struct {
+    evalsetup esChequer;
+    evalsetup esCube;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    evalcontext ecLuck;
+    int afPlayers[2];           /* the players analysed */
+    int fMove;                  /* analyse chequer plays */
+    int fCube;                  /* analyse cube decisions */
+    int fDice;                  /* analyse the luck */
+    int fKeepLuck;              /* keep the luck of moves that have one */
+    unsigned int nMoves;        /* moves kept besides the one played, 0 for all */
+    GHashTable *phtTriage;      /* second pass of a triage: the decisions to redo */
+    int fCubeScreen;            /* look at cube decisions at 0 plies first */
+    int *pcCubeScreened;        /* if not NULL, counts those left at 0 plies */
+    analysisjournal *paj;       /* if not NULL, where the decisions done go */
+} analysiscontext;
+
 typedef struct {
     moverecord *pmr;
     matchstate *pms;
-    const evalsetup *pesChequer;
-    evalsetup *pesCube;
-    movefilter(*aamf)[MAX_FILTER_PLIES];
+    const analysiscontext *pac;
 } moveData;
 
 typedef struct {
@@ -316,6 +341,7 @@ extern listOLD *plLastMove;
 extern listOLD lMatch;
 
 extern int automaticTask;
+extern int fSpeculate;
 
 extern char *aszCopying[];
 extern const char *aszGameResult[];
@@ -337,6 +363,9 @@ extern char *szLang;
 extern const char *szPrompt;
 extern const char *szHomeDirectory;
 extern evalcontext ecLuck;
+extern char *szAnalysisSummary;
+extern char *szAnalysisJournal;
+extern unsigned int nAnalysisMoves;
 extern evalsetup esAnalysisChequer;
 extern evalsetup esAnalysisCube;
 extern evalsetup esEvalChequer;
@@ -349,6 +378,7 @@ extern float arSkillLevel[N_SKILLS];
 extern float rEvalsPerSec;
 extern float rRatingOffset;
 extern int fAnalyseCube;
+extern int fAnalyseCubeScreen;
 extern int fAnalyseDice;
 extern int fAnalyseMove;
 extern int fAutoBearoff;
@@ -377,7 +407,9 @@ extern int fInvertMET;
 extern int fJacoby;
 extern int fNextTurn;
 extern int fOutputRawboard;
+extern int fProgressiveHint;
 extern int fRecord;
+extern int fRolloutLogStream;
 extern int fShowProgress;
 extern int fStyledGamelist;
 extern int fTutor;
@@ -451,16 +483,16 @@ extern char *GetInput(char *szPrompt);
 extern char *GetLuckAnalysis(const matchstate * pms, float rLuck);
 extern const char *GetMoveString(moverecord * pmr, int *pPlayer, gboolean addSkillMarks);
 extern double get_time(void);
+extern guint64 get_time_ns(void);
 extern char *NextToken(char **ppch);
 extern char *NextTokenGeneral(char **ppch, const char *szTokens);
 extern char *SetupLanguage(const char *newLangCode);
 extern command *FindHelpCommand(command * pcBase, char *sz, char *pchCommand, char *pchUsage);
 extern float ParseReal(char **ppch);
+extern void GetAnalysisContext(analysiscontext * pac);
 extern int AnalyzeMove(moverecord * pmr, matchstate * pms,
                        const listOLD * plGame, statcontext * psc,
-                       const evalsetup * pesChequer, evalsetup * pesCube,
-                       movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
-                       const int afAnalysePlayers[2], float *doubleError);
+                       const analysiscontext * pac, float *doubleError);
 extern void EvaluateRoll(float ar[NUM_ROLLOUT_OUTPUTS], int nDie1, int nDie2, const TanBoard anBoard,
                          const cubeinfo * pci, const evalcontext * pec);
 extern int CompareNames(char *sz0, char *sz1);
@@ -481,8 +513,10 @@ extern int SetToggle(const char *szName, int *pf, char *sz, const char *szOn, co
 extern moverecord *get_current_moverecord(int *pfHistory);
 extern moverecord *LinkToDouble(moverecord * pmr);
 extern moverecord *NewMoveRecord(void);
+extern void ReleaseMoveRecord(moverecord * pmr);
 extern void HandleInterrupt(int idSignal);
 extern void AddGame(moverecord * pmr);
+extern void AccountMatchMemory(void);
 extern void AddMoveRecord(moverecord * pmr);
 extern void ApplyMoveRecord(matchstate * pms, const listOLD * plGame, const moverecord * pmr);
 extern void CalculateBoard(void);
@@ -534,9 +568,11 @@ extern void CommandAgree(char *);
 extern void CommandAnalyseClearGame(char *);
 extern void CommandAnalyseClearMatch(char *);
 extern void CommandAnalyseClearMove(char *);
+extern void CommandAnalyseFiles(char *);
 extern void CommandAnalyseGame(char *);
 extern void CommandAnalyseMatch(char *);
 extern void CommandAnalyseMove(char *);
+extern void CommandAnalyseResume(char *);
 extern void CommandAnalyseRolloutCube(char *);
 extern void CommandAnalyseRolloutGame(char *);
 extern void CommandAnalyseRolloutMatch(char *);
@@ -560,6 +596,7 @@ extern void CommandAnnotateUnlucky(char *);
 extern void CommandAnnotateVeryBad(char *);
 extern void CommandAnnotateVeryLucky(char *);
 extern void CommandAnnotateVeryUnlucky(char *);
+extern void CommandBenchmark(char *);
 extern void CommandCalibrate(char *);
 extern void CommandClearCache(char *);
 extern void CommandClearHint(char *);
@@ -591,6 +628,8 @@ extern void CommandExportGamePDF(char *);
 extern void CommandExportGamePS(char *);
 extern void CommandExportGameText(char *);
 extern void CommandExportHTMLImages(char *);
+extern void CommandExportMatchArchive(char *);
+extern void CommandExportMatchArrow(char *);
 extern void CommandExportMatchHtml(char *);
 extern void CommandExportMatchLaTeX(char *);
 extern void CommandExportMatchMat(char *);
@@ -614,7 +653,12 @@ extern void CommandFirstMove(char *);
 extern void CommandHelp(char *);
 extern void CommandHint(char *);
 extern void CommandHistory(char *);
+extern void CommandImportArchive(char *);
 extern void CommandImportAuto(char *);
+extern void CommandImportBatchArchive(char *);
+extern void CommandImportBatchArrow(char *);
+extern void CommandImportBatchCache(char *);
+extern void CommandImportBatchSGF(char *);
 extern void CommandImportBGRoom(char *);
 extern void CommandImportEmpire(char *);
 extern void CommandImportJF(char *);
@@ -631,6 +675,7 @@ extern void CommandLoadGame(char *);
 extern void CommandLoadMatch(char *);
 extern void CommandLoadPosition(char *);
 extern void CommandLoadPython(char *);
+extern void CommandLoadWeights(char *);
 extern void CommandMove(char *);
 extern void CommandMWC2Eq(char *);
 extern void CommandNewGame(char *);
@@ -644,8 +689,10 @@ extern void CommandQuit(char *);
 extern void CommandRedouble(char *);
 extern void CommandReject(char *);
 extern void CommandRelationalAddMatch(char *);
+extern void CommandRelationalAddMatches(char *);
 extern void CommandRelationalEraseAll(char *);
 extern void CommandRelationalErase(char *);
+extern void CommandRelationalFindPosition(char *);
 extern void CommandRelationalSelect(char *);
 extern void CommandRelationalSetup(char *);
 extern void CommandRelationalShowDetails(char *);
@@ -654,20 +701,28 @@ extern void CommandRelationalTest(char *);
 extern void CommandResign(char *);
 extern void CommandRoll(char *);
 extern void CommandRollout(char *);
+extern void CommandRolloutExtract(char *);
+extern void CommandRolloutResume(char *);
+extern void CommandRolloutWorker(char *);
 extern void CommandSaveGame(char *);
 extern void CommandSaveMatch(char *);
 extern void CommandSavePosition(char *);
 extern void CommandSaveSettings(char *);
+extern void CommandSelfPlay(char *);
 extern void CommandSetAnalysisChequerplay(char *);
 extern void CommandSetAnalysisCube(char *);
 extern void CommandSetAnalysisCubedecision(char *);
+extern void CommandSetAnalysisCubeScreen(char *);
 extern void CommandSetAnalysisFileSetting(char*);
 extern void CommandSetAnalysisBackground(char *);
+extern void CommandSetAnalysisCandidates(char *);
 extern void CommandSetAnalysisLimit(char *);
 extern void CommandSetAnalysisLuckAnalysis(char *);
 extern void CommandSetAnalysisLuck(char *);
 extern void CommandSetAnalysisMoveFilter(char *);
 extern void CommandSetAnalysisMoves(char *);
+extern void CommandSetAnalysisJournal(char *);
+extern void CommandSetAnalysisSummary(char *);
 extern void CommandSetAnalysisPlayerAnalyse(char *);
 extern void CommandSetAnalysisPlayer(char *);
 extern void CommandSetAnalysisThresholdBad(char *);
@@ -693,8 +748,13 @@ extern void CommandSetAutoSaveRollout(char *sz);
 extern void CommandSetAutoSaveTime(char *sz);
 extern void CommandSetBeavers(char *);
 extern void CommandSetBoard(char *);
+extern void CommandSetBoardCache(char *);
 extern void CommandSetBrowser(char *);
 extern void CommandSetCache(char *);
+extern void CommandSetCacheFile(char *);
+extern void CommandSetCacheHugePages(char *);
+extern void CommandSetCacheShared(char *);
+extern void CommandSetCacheStats(char *);
 extern void CommandSetCalibration(char *);
 extern void CommandSetCheatEnable(char *);
 extern void CommandSetCheatPlayer(char *);
@@ -731,7 +791,15 @@ extern void CommandSetEvalParamEvaluation(char *);
 extern void CommandSetEvalParamRollout(char *);
 extern void CommandSetEvalParamType(char *);
 extern void CommandSetEvalPlies(char *);
+extern void CommandSetEvalAdaptiveFilter(char *);
+extern void CommandSetEvalFilterBudget(char *);
+extern void CommandSetEvalEarlyExit(char *);
+extern void CommandSetEvalOpeningBook(char *);
+extern void CommandSetEvalRaceApprox(char *);
+extern void CommandSetEvalSigmoidFast(char *);
+extern void CommandSetEvalSigmoidTable(char *);
 extern void CommandSetEvalPrune(char *);
+extern void CommandSetEvalWeights(char *);
 extern void CommandSetEvalSameAsAnalysis(char *);
 extern void CommandSetExportCubeDisplayActual(char *);
 extern void CommandSetExportCubeDisplayBad(char *);
@@ -764,6 +832,7 @@ extern void CommandSetExportMovesParameters(char *);
 extern void CommandSetExportMovesProb(char *);
 extern void CommandSetExportParametersEvaluation(char *);
 extern void CommandSetExportParametersRollout(char *);
+extern void CommandSetExportPNGCache(char *);
 extern void CommandSetExportPNGSize(char *);
 extern void CommandSetExportShowBoard(char *);
 extern void CommandSetExportShowPlayer(char *);
@@ -835,6 +904,7 @@ extern void CommandSetPlayerHuman(char *);
 extern void CommandSetPlayerMoveFilter(char *);
 extern void CommandSetPlayerName(char *);
 extern void CommandSetPostCrawford(char *);
+extern void CommandSetProgressiveHint(char *);
 extern void CommandSetPriorityAboveNormal(char *);
 extern void CommandSetPriorityBelowNormal(char *);
 extern void CommandSetPriorityHighest(char *);
@@ -842,6 +912,8 @@ extern void CommandSetPriorityIdle(char *);
 extern void CommandSetPriorityNice(char *);
 extern void CommandSetPriorityNormal(char *);
 extern void CommandSetPriorityTimeCritical(char *);
+extern void CommandSetProfile(char *);
+extern void CommandSetPreset(char *);
 extern void CommandSetPrompt(char *);
 extern void CommandSetRatingOffset(char *);
 extern void CommandSetRecord(char *);
@@ -852,16 +924,19 @@ extern void CommandSetRNGIsaac(char *);
 extern void CommandSetRNGManual(char *);
 extern void CommandSetRNGMD5(char *);
 extern void CommandSetRNGMersenne(char *);
+extern void CommandSetRNGPhilox(char *);
 extern void CommandSetRNGRandomDotOrg(char *);
 extern void CommandSetRolloutBearoffTruncationExact(char *);
 extern void CommandSetRolloutBearoffTruncationOS(char *);
 extern void CommandSetRollout(char *);
+extern void CommandSetRolloutCheckpoint(char *);
 extern void CommandSetRolloutChequerplay(char *);
 extern void CommandSetRolloutCubedecision(char *);
 extern void CommandSetRolloutCubeEqualChequer(char *);
 extern void CommandSetRolloutCubeful(char *);
 extern void CommandSetRolloutInitial(char *);
 extern void CommandSetRolloutJsd(char *);
+extern void CommandSetRolloutJsdAdaptive(char *);
 extern void CommandSetRolloutJsdEnable(char *);
 extern void CommandSetRolloutJsdLimit(char *);
 extern void CommandSetRolloutJsdMinGames(char *);
@@ -875,8 +950,11 @@ extern void CommandSetRolloutLatePlies(char *);
 extern void CommandSetRolloutLimit(char *);
 extern void CommandSetRolloutLimitEnable(char *);
 extern void CommandSetRolloutLimitMinGames(char *);
+extern void CommandSetRolloutLimitTime(char *);
+extern void CommandSetRolloutLockstep(char *);
 extern void CommandSetRolloutLogEnable(char *);
 extern void CommandSetRolloutLogFile(char *);
+extern void CommandSetRolloutLogStream(char *);
 extern void CommandSetRolloutMaxError(char *);
 extern void CommandSetRolloutMoveFilter(char *);
 extern void CommandSetRolloutPlayer(char *);
@@ -887,8 +965,11 @@ extern void CommandSetRolloutPlayerLateCubedecision(char *);
 extern void CommandSetRolloutPlayerLateMoveFilter(char *);
 extern void CommandSetRolloutPlayerMoveFilter(char *);
 extern void CommandSetRolloutPlayersAreSame(char *);
+extern void CommandSetRolloutProgressLog(char *);
+extern void CommandSetRolloutQuickVarRedn(char *);
 extern void CommandSetRolloutRNG(char *);
 extern void CommandSetRolloutRotate(char *);
+extern void CommandSetRolloutSobol(char *);
 extern void CommandSetRolloutSeed(char *);
 extern void CommandSetRolloutTrials(char *);
 extern void CommandSetRolloutTruncation(char *);
@@ -898,6 +979,7 @@ extern void CommandSetRolloutTruncationEnable(char *);
 extern void CommandSetRolloutTruncationEqualPlayer0(char *);
 extern void CommandSetRolloutTruncationPlies(char *);
 extern void CommandSetRolloutVarRedn(char *);
+extern void CommandSetRolloutWorkers(char *);
 extern void CommandSetScore(char *);
 extern void CommandSetScoreMapPly(char*);
 extern void CommandSetScoreMapMatchLength(char*);
@@ -932,6 +1014,10 @@ extern void CommandSetSoundSystemCommand(char *);
 extern void CommandSetStyledGameList(char *);
 extern void CommandSetTheoryWindow(char *);
 extern void CommandSetThreads(char *);
+extern void CommandSetThreadsAffinity(char *);
+extern void CommandSetThreadsNuma(char *);
+extern void CommandSetThreadsShare(char *);
+extern void CommandSetThreadsSpeculate(char *);
 extern void CommandSetToolbar(char *);
 extern void CommandSetTurn(char *);
 extern void CommandSetTutorChequer(char *);
@@ -989,23 +1075,30 @@ extern void CommandShowMatchEquityTable(char *);
 extern void CommandShowMatchInfo(char *);
 extern void CommandShowMatchLength(char *);
 extern void CommandShowMatchResult(char *);
+extern void CommandShowMemory(char *);
+extern void CommandShowMetrics(char *);
 extern void CommandShowOneSidedRollout(char *);
 extern void CommandShowOutput(char *);
 extern void CommandShowPanels(char *);
 extern void CommandShowPipCount(char *);
 extern void CommandShowPlayer(char *);
 extern void CommandShowPostCrawford(char *);
+extern void CommandShowProfile(char *);
+extern void CommandShowPresets(char *);
 extern void CommandShowPrompt(char *);
 extern void CommandShowRatingOffset(char *);
 extern void CommandShowRNG(char *);
 extern void CommandShowRollout(char *);
 extern void CommandShowRolls(char *);
 extern void CommandShowScore(char *);
+extern void CommandShowScoreGrid(char *);
 extern void CommandShowScoreSheet(char *);
 extern void CommandShowSeed(char *);
 extern void CommandShowSound(char *);
+extern void CommandShowStartup(char *);
 extern void CommandShowStatisticsGame(char *);
 extern void CommandShowStatisticsMatch(char *);
+extern void CommandShowStatisticsSummary(char *);
 extern void CommandShowStatisticsSession(char *);
 extern void CommandShowTemperatureMap(char *);
 extern void CommandShowScoreMap(char *);
@@ -1037,8 +1130,10 @@ extern void game_remove_pmr_hint(listOLD * pl_hint);
 extern gboolean game_is_last(const listOLD * plGame);
 extern void pmr_hint_destroy(void);
 extern void StopAutomaticPlay(void);
+extern void StopSpeculation(void);
 extern gboolean save_autosave(gpointer unused);
 extern void delete_autosave(void);
+extern void FinishAutosave(void);
 extern int get_input_discard(void);
 extern void SaveGame(FILE * pf, listOLD * plGame);
 
@@ -27,9 +27,23 @@
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if defined(HAVE_POSIX_FADVISE) || HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(WIN32)
+#include <windows.h>
+#include <io.h>
+#endif
 
 #include "bearoffgammon.h"
 #include "positionid.h"
+#include "simd.h"
+#include "memusage.h"
 
 #include <glib/gstdio.h>
 #include <stdlib.h>
@@ -61,7 +75,7 @@ setGammonProb(const TanBoard anBoard, unsigned int bp0, unsigned int bp1, float
     *g1 = 0.0;
 
     if (tot0 == 15) {
-        struct GammonProbs *gp = getBearoffGammonProbs(anBoard[0]);
+        const struct GammonProbs *gp = getBearoffGammonProbs(anBoard[0]);
         double make[3];
 
         if (BearoffDist(pbc1, bp1, NULL, NULL, NULL, prob, NULL))
@@ -77,7 +91,7 @@ setGammonProb(const TanBoard anBoard, unsigned int bp0, unsigned int bp1, float
     }
 
     if (tot1 == 15) {
-        struct GammonProbs *gp = getBearoffGammonProbs(anBoard[1]);
+        const struct GammonProbs *gp = getBearoffGammonProbs(anBoard[1]);
         double make[3];
 
         if (BearoffDist(pbc1, bp0, NULL, NULL, NULL, prob, NULL))
@@ -241,6 +255,9 @@ HeuristicDatabase(void (*pfProgress) (unsigned int))
     if (!pm)
         return NULL;
 
+    /* the header it has when saved, see HeuristicFile() */
+    memcpy(pm, "gnubg-OS-06-15-0-0-0-Hxxxxxxxxxxxxxxxxx\n", 40);
+
     p = pm + 40;
     p[0] = p[1] = 0xFF;
     for (i = 2; i < 64; i++)
@@ -256,33 +273,266 @@ HeuristicDatabase(void (*pfProgress) (unsigned int))
 }
 
 
+/*
+ * Read with an explicit offset where the system has it, so that the
+ * threads don't share a file position and don't have to take turns
+ * for a database that isn't held in memory.  Returns the number of
+ * bytes read.
+ */
+
+static size_t
+ReadAt(FILE * pf, guint64 offset, unsigned char *buf, unsigned int nBytes)
+{
+#if defined(WIN32)
+    HANDLE h = (HANDLE) _get_osfhandle(_fileno(pf));
+    OVERLAPPED ov;
+    DWORD cb = 0;
+
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD) offset;
+    ov.OffsetHigh = (DWORD) (offset >> 32);
+
+    if (h == INVALID_HANDLE_VALUE || !ReadFile(h, buf, nBytes, &cb, &ov))
+        return 0;
+
+    return cb;
+#elif HAVE_PREAD
+    size_t cb = 0;
+
+    while (cb < nBytes) {
+        ssize_t n = pread(fileno(pf), buf + cb, nBytes - cb, (off_t) (offset + cb));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        cb += (size_t) n;
+    }
+
+    return cb;
+#else
+    size_t cb = 0;
+
+    MT_Lock(MT_LOCK_BEAROFF);
+    if (fseek(pf, (long) offset, SEEK_SET) == 0)
+        cb = fread(buf, 1, nBytes, pf);
+    MT_Unlock(MT_LOCK_BEAROFF);
+
+    return cb;
+#endif
+}
+
+/*
+ * The offset is the one in a database in a single file.  A database
+ * split over several files has the rows of nShardRows positions of the
+ * player on roll in each, after a header of its own, and entries
+ * never straddle two files.
+ */
+
+static FILE *
+ShardFile(const bearoffcontext * pbc, guint64 * poffset)
+{
+    guint64 cbShard, iShard;
+
+    if (pbc->cShards <= 1)
+        return pbc->pf;
+
+    cbShard = (guint64) pbc->nShardRows * Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints)
+        * (pbc->fCubeful ? 8 : 2);
+    iShard = (*poffset - 40) / cbShard;
+    *poffset = 40 + (*poffset - 40) % cbShard;
+
+    return iShard ? pbc->apfShard[iShard - 1] : pbc->pf;
+}
+
 static void
-ReadBearoffFile(const bearoffcontext * pbc, unsigned int offset, unsigned char *buf, unsigned int nBytes)
+ReadBearoffFile(const bearoffcontext * pbc, guint64 offset, unsigned char *buf, unsigned int nBytes)
 {
-    MT_Exclusive();
+    FILE *pf = ShardFile(pbc, &offset);
+
+    errno = 0;
 
-    if ((fseek(pbc->pf, (long) offset, SEEK_SET) < 0) || (fread(buf, 1, nBytes, pbc->pf) < nBytes)) {
+    if (ReadAt(pf, offset, buf, nBytes) < nBytes) {
         if (errno)
             perror(_("bearoff database"));
         else
             fprintf(stderr, _("Error reading bearoff database"));
 
         memset(buf, 0, nBytes);
-        return;
     }
+}
+
+/*
+ * Ask for nBytes at offset to be fetched into the CPU cache, or into
+ * the page cache for a database on disk, without waiting for them.
+ */
+
+static void
+PrefetchAt(const bearoffcontext * pbc, guint64 offset, const unsigned int nBytes)
+{
+    if (pbc->p) {
+#if defined(__GNUC__)
+        __builtin_prefetch(pbc->p + offset);
+        __builtin_prefetch(pbc->p + offset + nBytes - 1);
+#endif
+    } else {
+#if defined(HAVE_POSIX_FADVISE)
+        FILE *pf = ShardFile(pbc, &offset);
+
+        (void) posix_fadvise(fileno(pf), (off_t) offset, (off_t) nBytes, POSIX_FADV_WILLNEED);
+#else
+        (void) offset;
+        (void) nBytes;
+#endif
+    }
+}
+
+/*
+ * A compressed two-sided database has, after the header, the offsets
+ * of its blocks of BEAROFF_BLOCK positions and of the end of the last
+ * block, as 64-bit little endian numbers.  In a block each equity is
+ * the difference from the same equity of the position before (from
+ * zero for the first one), zigzag coded and written seven bits at a
+ * time, low bits first, with the top bit set in all bytes but the
+ * last.  Neighbouring positions have close equities, so most take a
+ * byte.
+ *
+ * The most recently decoded blocks are kept in a cache, so lookups of
+ * nearby positions, as in an evaluation, only decode a block once.
+ */
+
+#define BLOCK_CACHE_SIZE 64
+
+struct _bearoffblockcache {
+#if defined(USE_MULTITHREAD)
+    Mutex lock;
+#endif
+    guint64 aiBlock[BLOCK_CACHE_SIZE];  /* G_MAXUINT64 if empty */
+    unsigned int aiUsed[BLOCK_CACHE_SIZE];      /* for finding the least recently used */
+    unsigned int iClock;
+    unsigned short int aaus[BLOCK_CACHE_SIZE][BEAROFF_BLOCK * 4];
+};
+
+static guint64
+GetUInt64(const unsigned char *pc)
+{
+    guint64 n = 0;
+    int i;
+
+    for (i = 7; i >= 0; --i)
+        n = (n << 8) | pc[i];
+
+    return n;
+}
+
+static void
+DecodeBlock(const bearoffcontext * pbc, const guint64 iBlock, unsigned short int aus[BEAROFF_BLOCK * 4])
+{
+    unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
+    unsigned int i, k = (pbc->fCubeful) ? 4 : 1;
+    unsigned int cValues = (unsigned int) MIN(BEAROFF_BLOCK, (guint64) n * n - iBlock * BEAROFF_BLOCK) * k;
+    unsigned char ac[16], acBlock[BEAROFF_BLOCK * 4 * 3];
+    const unsigned char *pc;
+    const unsigned char *pcEnd;
+    unsigned short int ausLast[4] = { 0, 0, 0, 0 };
+    guint64 iStart, iEnd;
+
+    if (pbc->p)
+        pc = pbc->p + 40 + 8 * iBlock;
+    else {
+        ReadBearoffFile(pbc, 40 + 8 * iBlock, ac, 16);
+        pc = ac;
+    }
+    iStart = GetUInt64(pc);
+    iEnd = GetUInt64(pc + 8);
+
+    if (iEnd < iStart || iEnd - iStart > sizeof(acBlock)) {
+        g_printerr("%s: %s\n", pbc->szFilename, _("corrupt compressed bearoff database"));
+        iEnd = iStart;
+    }
+
+    if (pbc->p)
+        pc = pbc->p + iStart;
+    else {
+        ReadBearoffFile(pbc, iStart, acBlock, (unsigned int) (iEnd - iStart));
+        pc = acBlock;
+    }
+    pcEnd = pc + (iEnd - iStart);
+
+    for (i = 0; i < cValues; ++i) {
+        unsigned int z = 0;
+        int nShift = 0;
+        int d;
 
-    MT_Release();
+        while (pc < pcEnd && nShift < 21) {
+            z |= (unsigned int) (*pc & 0x7F) << nShift;
+            nShift += 7;
+            if (!(*pc++ & 0x80))
+                break;
+        }
+        d = (z & 1) ? -(int) (z >> 1) - 1 : (int) (z >> 1);
+
+        aus[i] = ausLast[i % k] = (unsigned short int) (ausLast[i % k] + d);
+    }
+}
+
+static void
+ReadBlockBearoff(const bearoffcontext * pbc, const guint64 iPos, unsigned short int aus[4])
+{
+    struct _bearoffblockcache *pcache = pbc->pcache;
+    guint64 iBlock = iPos / BEAROFF_BLOCK;
+    unsigned int k = (pbc->fCubeful) ? 4 : 1;
+    unsigned int iValue = (unsigned int) (iPos % BEAROFF_BLOCK) * k;
+    unsigned short int ausBlock[BEAROFF_BLOCK * 4];
+    unsigned int i, iSlot = 0;
+
+#if defined(USE_MULTITHREAD)
+    Mutex_Lock(&pcache->lock);
+#endif
+    for (i = 0; i < BLOCK_CACHE_SIZE; ++i)
+        if (pcache->aiBlock[i] == iBlock) {
+            pcache->aiUsed[i] = ++pcache->iClock;
+            memcpy(aus, pcache->aaus[i] + iValue, k * sizeof(unsigned short int));
+#if defined(USE_MULTITHREAD)
+            Mutex_Release(&pcache->lock);
+#endif
+            return;
+        }
+#if defined(USE_MULTITHREAD)
+    Mutex_Release(&pcache->lock);
+#endif
+
+    /* the other threads can use the cache while this one decodes */
+
+    DecodeBlock(pbc, iBlock, ausBlock);
+    memcpy(aus, ausBlock + iValue, k * sizeof(unsigned short int));
+
+#if defined(USE_MULTITHREAD)
+    Mutex_Lock(&pcache->lock);
+#endif
+    for (i = 1; i < BLOCK_CACHE_SIZE; ++i)
+        if (pcache->iClock - pcache->aiUsed[i] > pcache->iClock - pcache->aiUsed[iSlot])
+            iSlot = i;
+    pcache->aiBlock[iSlot] = iBlock;
+    pcache->aiUsed[iSlot] = ++pcache->iClock;
+    memcpy(pcache->aaus[iSlot], ausBlock, sizeof(ausBlock));
+#if defined(USE_MULTITHREAD)
+    Mutex_Release(&pcache->lock);
+#endif
 }
 
 /* BEAROFF_GNUBG: read two sided bearoff database */
 static void
-ReadTwoSidedBearoff(const bearoffcontext * pbc, const unsigned int iPos, float ar[4], unsigned short int aus[4])
+ReadTwoSidedBearoff(const bearoffcontext * pbc, const guint64 iPos, float ar[4], unsigned short int aus[4])
 {
     unsigned int i, k = (pbc->fCubeful) ? 4 : 1;
     unsigned char ac[8];
     unsigned char *pc = NULL;
+    unsigned short int ausBlock[4];
 
-    if (pbc->p)
+    if (pbc->fCompressed)
+        ReadBlockBearoff(pbc, iPos, ausBlock);
+    else if (pbc->p)
         pc = pbc->p + 40 + 2 * iPos * k;
     else {
         ReadBearoffFile(pbc, 40 + 2 * iPos * k, ac, k * 2);
@@ -291,7 +541,7 @@ ReadTwoSidedBearoff(const bearoffcontext * pbc, const unsigned int iPos, float a
     /* add to cache */
 
     for (i = 0; i < k; ++i) {
-        unsigned short int us = pc[2 * i] | (unsigned short) (pc[2 * i + 1] << 8);
+        unsigned short int us = pc ? pc[2 * i] | (unsigned short) (pc[2 * i + 1] << 8) : ausBlock[i];
 
         if (aus)
             aus[i] = us;
@@ -301,7 +551,7 @@ ReadTwoSidedBearoff(const bearoffcontext * pbc, const unsigned int iPos, float a
 }
 
 extern int
-BearoffCubeful(const bearoffcontext * pbc, const unsigned int iPos, float ar[4], unsigned short int aus[4])
+BearoffCubeful(const bearoffcontext * pbc, const guint64 iPos, float ar[4], unsigned short int aus[4])
 {
     g_return_val_if_fail(pbc, -1);
     g_return_val_if_fail(pbc->fCubeful, -1);
@@ -318,7 +568,7 @@ BearoffEvalTwoSided(const bearoffcontext * pbc, const TanBoard anBoard, float ar
     unsigned int nUs = PositionBearoff(anBoard[1], pbc->nPoints, pbc->nChequers);
     unsigned int nThem = PositionBearoff(anBoard[0], pbc->nPoints, pbc->nChequers);
     unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
-    unsigned int iPos = nUs * n + nThem;
+    guint64 iPos = (guint64) nUs * n + nThem;
     float ar[4];
 
     ReadTwoSidedBearoff(pbc, iPos, ar, NULL);
@@ -342,9 +592,9 @@ ReadHypergammon(const bearoffcontext * pbc, const unsigned int iPos, float arOut
     const int x = 28;
 
     if (pbc->p)
-        pc = pbc->p + 40 + x * iPos;
+        pc = pbc->p + 40 + (size_t) x * iPos;
     else {
-        ReadBearoffFile(pbc, 40 + x * iPos, ac, x);
+        ReadBearoffFile(pbc, 40 + (guint64) x * iPos, ac, x);
         pc = ac;
     }
 
@@ -374,23 +624,29 @@ BearoffEvalOneSided(const bearoffcontext * pbc, const TanBoard anBoard, float ar
     float r;
     unsigned int anOn[2] = { 0 };
     unsigned int an[2];
-    float ar[2][4];
+    const float *apr[2] = { NULL, NULL };
 
     /* get bearoff probabilities */
 
     for (i = 0; i < 2; ++i) {
 
         an[i] = PositionBearoff(anBoard[i], pbc->nPoints, pbc->nChequers);
-        if (BearoffDist(pbc, an[i], aarProb[i], aarGammonProb[i], ar[i], NULL, NULL))
+        if (pbc->arDist)
+            apr[i] = pbc->arDist + an[i] * (pbc->fGammon ? 128 : 64);
+        else if (BearoffDist(pbc, an[i], aarProb[i], aarGammonProb[i], NULL, NULL, NULL))
             return -1;
     }
 
     /* calculate winning chance */
 
-    r = 0.0;
-    for (i = 0; i < 32; ++i)
-        for (j = i; j < 32; ++j)
-            r += aarProb[1][i] * aarProb[0][j];
+    if (pbc->arDist)
+        r = DistProduct(apr[1], apr[0] + 32);
+    else {
+        r = 0.0;
+        for (i = 0; i < 32; ++i)
+            for (j = i; j < 32; ++j)
+                r += aarProb[1][i] * aarProb[0][j];
+    }
 
     arOutput[OUTPUT_WIN] = r;
 
@@ -402,7 +658,12 @@ BearoffEvalOneSided(const bearoffcontext * pbc, const TanBoard anBoard, float ar
 
     if (anOn[0] == 15 || anOn[1] == 15) {
 
-        if (pbc->fGammon) {
+        if (pbc->fGammon && pbc->arDist) {
+
+            arOutput[OUTPUT_WINGAMMON] = DistProduct(apr[1], apr[0] + 64);
+            arOutput[OUTPUT_LOSEGAMMON] = DistProduct(apr[0], apr[1] + 96);
+
+        } else if (pbc->fGammon) {
 
             /* my gammon chance: I'm out in i rolls and my opponent isn't inside
              * home quadrant in less than i rolls */
@@ -469,21 +730,76 @@ BearoffEvalHypergammon(const bearoffcontext * pbc, const TanBoard anBoard, float
 extern int
 BearoffEval(const bearoffcontext * pbc, const TanBoard anBoard, float arOutput[])
 {
+    guint64 tProfile;
+    int n;
+
     g_return_val_if_fail(pbc, 0);
 
+    PROFILE_START(tProfile);
+
     switch (pbc->bt) {
     case BEAROFF_TWOSIDED:
-        return BearoffEvalTwoSided(pbc, anBoard, arOutput);
+        n = BearoffEvalTwoSided(pbc, anBoard, arOutput);
+        break;
     case BEAROFF_ONESIDED:
-        return BearoffEvalOneSided(pbc, anBoard, arOutput);
+        n = BearoffEvalOneSided(pbc, anBoard, arOutput);
+        break;
     case BEAROFF_HYPERGAMMON:
-        return BearoffEvalHypergammon(pbc, anBoard, arOutput);
+        n = BearoffEvalHypergammon(pbc, anBoard, arOutput);
+        break;
     case BEAROFF_INVALID:
     default:
         g_warning(_("Invalid bearoff database type"));
         g_assert_not_reached();
         return 0;
     }
+
+    PROFILE_STOP(tProfile, PROFILE_BEAROFF);
+
+    return n;
+}
+
+/*
+ * The first half of BearoffEval(): ask for what it will read for
+ * anBoard, so that the reads for several positions overlap.  For a
+ * compressed database that is the index entry.
+ */
+
+extern void
+BearoffPrefetch(const bearoffcontext * pbc, const TanBoard anBoard)
+{
+    unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
+    unsigned int i;
+
+    switch (pbc->bt) {
+    case BEAROFF_TWOSIDED:{
+            guint64 iPos = (guint64) PositionBearoff(anBoard[1], pbc->nPoints, pbc->nChequers) * n
+                + PositionBearoff(anBoard[0], pbc->nPoints, pbc->nChequers);
+            unsigned int k = (pbc->fCubeful) ? 4 : 1;
+
+            if (pbc->fCompressed)
+                PrefetchAt(pbc, 40 + 8 * (iPos / BEAROFF_BLOCK), 16);
+            else
+                PrefetchAt(pbc, 40 + 2 * iPos * k, 2 * k);
+            break;
+        }
+    case BEAROFF_ONESIDED:
+        for (i = 0; i < 2; ++i) {
+            unsigned int nPosID = PositionBearoff(anBoard[i], pbc->nPoints, pbc->nChequers);
+
+            if (pbc->fND)
+                PrefetchAt(pbc, 40 + (guint64) nPosID * 16, 16);
+            else if (pbc->fCompressed)
+                PrefetchAt(pbc, 40 + (guint64) nPosID * (pbc->fGammon ? 8 : 6), pbc->fGammon ? 8 : 6);
+            else
+                PrefetchAt(pbc, 40 + (guint64) nPosID * (pbc->fGammon ? 128 : 64), pbc->fGammon ? 128 : 64);
+        }
+        break;
+    case BEAROFF_HYPERGAMMON:
+    case BEAROFF_INVALID:
+    default:
+        break;
+    }
 }
 
 extern void
@@ -520,6 +836,14 @@ BearoffStatus(const bearoffcontext * pbc, char *sz)
     case BEAROFF_TWOSIDED:
         sz += sprintf(sz, "   - %s\n", pbc->fCubeful ? _("database includes both cubeful and cubeless equities")
                       : _("cubeless database"));
+        if (pbc->cShards > 1) {
+            sprintf(buf, _("split over %u files of %u positions per player on roll"), pbc->cShards, pbc->nShardRows);
+            sz += sprintf(sz, "   - %s\n", buf);
+        }
+        if (pbc->fCompressed) {
+            sprintf(buf, _("compressed in blocks of %u positions"), BEAROFF_BLOCK);
+            sz += sprintf(sz, "   - %s\n", buf);
+        }
         break;
 
     case BEAROFF_ONESIDED:
@@ -545,7 +869,7 @@ BearoffDumpTwoSided(const bearoffcontext * pbc, const TanBoard anBoard, char *sz
     unsigned int nUs = PositionBearoff(anBoard[1], pbc->nPoints, pbc->nChequers);
     unsigned int nThem = PositionBearoff(anBoard[0], pbc->nPoints, pbc->nChequers);
     unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
-    unsigned int iPos = nUs * n + nThem;
+    guint64 iPos = (guint64) nUs * n + nThem;
     float ar[4];
     const char *aszEquity[] = {
         N_("Cubeless equity"),
@@ -716,20 +1040,56 @@ BearoffDump(const bearoffcontext * pbc, const TanBoard anBoard, char *sz)
     }
 }
 
+/* cb more bytes held by pbc, given back by BearoffClose() */
+static void
+BearoffAccount(bearoffcontext * pbc, size_t cb)
+{
+    pbc->cbMemory += cb;
+    MemAccount(MEM_BEAROFF, (gssize) cb);
+}
+
 extern void
 BearoffClose(bearoffcontext * pbc)
 {
     if (!pbc)
         return;
 
+    MemAccount(MEM_BEAROFF, -(gssize) pbc->cbMemory);
+
     if (pbc->pf)
         fclose(pbc->pf);
 
+    if (pbc->apfShard) {
+        unsigned int i;
+
+        for (i = 0; i < pbc->cShards - 1; ++i)
+            if (pbc->apfShard[i])
+                fclose(pbc->apfShard[i]);
+        g_free(pbc->apfShard);
+    }
+
+    if (pbc->pcache) {
+#if defined(USE_MULTITHREAD)
+        FreeMutex(&pbc->pcache->lock);
+#endif
+        g_free(pbc->pcache);
+    }
+
+    if (pbc->arDist)
+        sse_free(pbc->arDist);
+
     if (pbc->map) {
         g_mapped_file_unref(pbc->map);
         pbc->p = NULL;
     }
 
+#if HAVE_SYS_MMAN_H
+    if (pbc->cbMap) {
+        munmap(pbc->p, pbc->cbMap);
+        pbc->p = NULL;
+    }
+#endif
+
     if (pbc->p)
         free(pbc->p);
 
@@ -740,9 +1100,35 @@ BearoffClose(bearoffcontext * pbc)
 }
 
 static unsigned char *
-ReadIntoMemory(bearoffcontext * pbc)
+ReadIntoMemory(bearoffcontext * pbc, const unsigned int bo)
 {
     GError *error = NULL;
+
+#if HAVE_SYS_MMAN_H && defined(MAP_POPULATE)
+    /* read the whole file in now, so that a process started after
+     * another has loaded it takes no page faults on it */
+    if (bo & BO_POPULATE) {
+        int h = g_open(pbc->szFilename, O_RDONLY, 0);
+        struct stat st;
+
+        if (h >= 0 && !fstat(h, &st) && st.st_size > 0) {
+            void *p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED | MAP_POPULATE, h, 0);
+
+            if (p != MAP_FAILED) {
+                close(h);
+                pbc->cbMap = (size_t) st.st_size;
+                pbc->p = (unsigned char *) p;
+                BearoffAccount(pbc, pbc->cbMap);
+                return pbc->p;
+            }
+        }
+        if (h >= 0)
+            close(h);
+    }
+#else
+    (void) bo;
+#endif
+
     pbc->map = g_mapped_file_new(pbc->szFilename, FALSE, &error);
     if (!pbc->map) {
         g_printerr(_("%s: Failed to map bearoff database %s\n"), pbc->szFilename, error->message);
@@ -750,6 +1136,7 @@ ReadIntoMemory(bearoffcontext * pbc)
         return NULL;
     }
     pbc->p = (unsigned char *) g_mapped_file_get_contents(pbc->map);
+    BearoffAccount(pbc, g_mapped_file_get_length(pbc->map));
     return pbc->p;
 }
 
@@ -777,6 +1164,193 @@ InvalidDb(bearoffcontext * pbc)
     BearoffClose(pbc);
 }
 
+/*
+ * A two-sided database in several files is given by its first file,
+ * with "-S<file>-<files>" after the options in the header.  The other
+ * files are named after it with ".1", ".2" and so on added.
+ */
+
+static int
+OpenShards(bearoffcontext * pbc, const char *szHeader)
+{
+    unsigned int i, n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
+
+    pbc->cShards = (unsigned int) atoi(szHeader + 22);
+    if (atoi(szHeader + 18) != 0 || pbc->cShards < 1 || pbc->cShards > n) {
+        g_printerr("%s: %s\n", pbc->szFilename, _("not the first file of a split bearoff database"));
+        return FALSE;
+    }
+    pbc->nShardRows = (n + pbc->cShards - 1) / pbc->cShards;
+    pbc->apfShard = g_new0(FILE *, pbc->cShards);
+
+    for (i = 1; i < pbc->cShards; ++i) {
+        char *szShard = g_strdup_printf("%s.%u", pbc->szFilename, i);
+        char sz[41];
+
+        if (!(pbc->apfShard[i - 1] = g_fopen(szShard, "rb")) || fread(sz, 1, 40, pbc->apfShard[i - 1]) < 40
+            || strncmp(sz, szHeader, 17) || (unsigned int) atoi(sz + 18) != i
+            || (unsigned int) atoi(sz + 22) != pbc->cShards) {
+            g_printerr("%s: %s\n", szShard, _("missing or wrong part of split bearoff database"));
+            g_free(szShard);
+            return FALSE;
+        }
+        g_free(szShard);
+    }
+
+    return TRUE;
+}
+
+/*
+ * A compressed two-sided database has "-Z<positions per block>" after
+ * the options in the header.
+ */
+
+static int
+OpenBlocks(bearoffcontext * pbc, const char *szHeader)
+{
+    unsigned int i;
+
+    if (atoi(szHeader + 18) != BEAROFF_BLOCK) {
+        g_printerr("%s: %s\n", pbc->szFilename, _("unsupported block size of compressed bearoff database"));
+        return FALSE;
+    }
+
+    pbc->fCompressed = TRUE;
+    pbc->pcache = g_new(struct _bearoffblockcache, 1);
+    BearoffAccount(pbc, sizeof(struct _bearoffblockcache));
+#if defined(USE_MULTITHREAD)
+    InitMutex(&pbc->pcache->lock);
+#endif
+    for (i = 0; i < BLOCK_CACHE_SIZE; ++i) {
+        pbc->pcache->aiBlock[i] = G_MAXUINT64;
+        pbc->pcache->aiUsed[i] = 0;
+    }
+    pbc->pcache->iClock = 0;
+
+    return TRUE;
+}
+
+/*
+ * For a small one-sided database in memory BearoffEvalOneSided()
+ * uses a table of the distributions as floats, aligned for
+ * DistProduct(), which turns each of its sums over pairs of rolls
+ * into one product of two distributions.  For each position it has
+ * the probabilities of bearing off in i rolls, of bearing off in i
+ * or more rolls, and with gammons those of saving the gammon in i or
+ * more and in more than i rolls.
+ */
+
+#define MAX_DIST_TABLE 65536
+
+static void
+BuildDistTable(bearoffcontext * pbc)
+{
+    unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
+    unsigned int k = pbc->fGammon ? 128 : 64;
+    unsigned int i, j;
+    float *ar;
+
+    pbc->arDist = sse_malloc((size_t) n * k * sizeof(float));
+
+    for (i = 0; i < n; ++i) {
+        float arProb[32], arGammonProb[32];
+
+        ar = pbc->arDist + (size_t) i * k;
+
+        if (BearoffDist(pbc, i, arProb, arGammonProb, NULL, NULL, NULL)) {
+            sse_free(pbc->arDist);
+            pbc->arDist = NULL;
+            return;
+        }
+
+        memcpy(ar, arProb, sizeof(arProb));
+        ar[32 + 31] = arProb[31];
+        for (j = 31; j-- > 0;)
+            ar[32 + j] = ar[32 + j + 1] + arProb[j];
+
+        if (pbc->fGammon) {
+            ar[64 + 31] = arGammonProb[31];
+            ar[96 + 31] = 0.0f;
+            for (j = 31; j-- > 0;) {
+                ar[64 + j] = ar[64 + j + 1] + arGammonProb[j];
+                ar[96 + j] = ar[64 + j + 1];
+            }
+        }
+    }
+
+    BearoffAccount(pbc, (size_t) n * k * sizeof(float));
+}
+
+/*
+ * The heuristic database kept in szFilename, which is written the
+ * first time and then only mapped, so that the processes given the
+ * same file share one copy and don't each spend the time building it.
+ * Processes starting together may all build it; the file is renamed
+ * into place, so they never see it half written.
+ */
+
+static bearoffcontext *
+HeuristicFile(const char *szFilename, const unsigned int bo, void (*p) (unsigned int))
+{
+    const unsigned int boFile = (bo & ~BO_HEURISTIC) | BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED;
+    bearoffcontext *pbc;
+    unsigned char *pm;
+    char *szTmp;
+    int h = -1;
+    int fWritten;
+
+    if (g_file_test(szFilename, G_FILE_TEST_IS_REGULAR)
+        && (pbc = BearoffInit(szFilename, boFile, NULL)) != NULL) {
+        if (pbc->fHeuristic && pbc->p)
+            return pbc;
+        BearoffClose(pbc);
+    }
+
+    pm = HeuristicDatabase(p);
+
+    szTmp = g_strdup_printf("%s.XXXXXX", szFilename);
+
+    fWritten = pm && (h = g_mkstemp(szTmp)) >= 0;
+    if (fWritten) {
+        FILE *pf = fdopen(h, "wb");
+
+        fWritten = pf && fwrite(pm, 1, 40 + 54264 * 64, pf) == 40 + 54264 * 64;
+        if (pf)
+            fWritten = !fclose(pf) && fWritten;
+        else
+            close(h);
+        if (fWritten) {
+            g_unlink(szFilename);
+            fWritten = !g_rename(szTmp, szFilename);
+        }
+        if (!fWritten)
+            g_unlink(szTmp);
+    }
+    if (pm && !fWritten)
+        g_printerr(_("%s: Failed to save heuristic bearoff database\n"), szFilename);
+    g_free(szTmp);
+
+    if (fWritten && (pbc = BearoffInit(szFilename, boFile, NULL)) != NULL) {
+        free(pm);
+        return pbc;
+    }
+
+    /* use this process' copy after all */
+
+    pbc = g_new0(bearoffcontext, 1);
+    pbc->bt = BEAROFF_ONESIDED;
+    pbc->nPoints = HEURISTIC_P;
+    pbc->nChequers = HEURISTIC_C;
+    pbc->fHeuristic = TRUE;
+    pbc->p = pm;
+    if (pbc->p) {
+        BearoffAccount(pbc, 40 + 54264 * 64);
+        BuildDistTable(pbc);
+    }
+
+    return pbc;
+}
+
 /*
  * Initialise bearoff database
  *
@@ -796,6 +1370,9 @@ BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned i
     bearoffcontext *pbc;
     char sz[41];
 
+    if ((bo & BO_HEURISTIC) && szFilename && *szFilename)
+        return HeuristicFile(szFilename, bo, p);
+
     pbc = g_new0(bearoffcontext, 1);
 
     if (bo & BO_HEURISTIC) {
@@ -804,6 +1381,10 @@ BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned i
         pbc->nChequers = HEURISTIC_C;
         pbc->fHeuristic = TRUE;
         pbc->p = HeuristicDatabase(p);
+        if (pbc->p) {
+            BearoffAccount(pbc, 40 + 54264 * 64);
+            BuildDistTable(pbc);
+        }
         return pbc;
     }
 
@@ -908,12 +1489,21 @@ BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned i
     case BEAROFF_TWOSIDED:
         /* options for two-sided dbs */
         pbc->fCubeful = atoi(sz + 15);
+        if (sz[16] == '-' && sz[17] == 'S' && !OpenShards(pbc, sz)) {
+            InvalidDb(pbc);
+            return NULL;
+        }
+        if (sz[16] == '-' && sz[17] == 'Z' && !OpenBlocks(pbc, sz)) {
+            InvalidDb(pbc);
+            return NULL;
+        }
         break;
     case BEAROFF_ONESIDED:
         /* options for one-sided dbs */
         pbc->fGammon = atoi(sz + 15);
         pbc->fCompressed = atoi(sz + 17);
         pbc->fND = atoi(sz + 19);
+        pbc->fHeuristic = !strncmp(sz + 20, "-H", 2);
         break;
     case BEAROFF_HYPERGAMMON:
     case BEAROFF_INVALID:
@@ -925,15 +1515,18 @@ BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned i
      * read database into memory if requested 
      */
 
-    if (bo & BO_IN_MEMORY) {
+    if ((bo & BO_IN_MEMORY) && pbc->cShards <= 1) {
         fclose(pbc->pf);
         pbc->pf = NULL;
-        if ((ReadIntoMemory(pbc) == NULL))
+        if ((ReadIntoMemory(pbc, bo) == NULL))
             if ((pbc->pf = g_fopen(szFilename, "rb")) == 0) {
                 g_printerr("%s\n", _("Invalid or nonexistent database"));
                 InvalidDb(pbc);
                 return NULL;
             }
+        if (pbc->p && pbc->bt == BEAROFF_ONESIDED && !pbc->fND
+            && Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints) <= MAX_DIST_TABLE)
+            BuildDistTable(pbc);
     }
 
     return pbc;
@@ -32,6 +32,9 @@ typedef enum {
     BEAROFF_HYPERGAMMON
 } bearofftype;
 
+/* positions in each block of a compressed two-sided database */
+#define BEAROFF_BLOCK 1024
+
 typedef struct {
     bearofftype bt;             /* type of bearoff database */
     unsigned int nPoints;       /* number of points covered by database */
@@ -44,9 +47,18 @@ typedef struct {
     /* two sided dbs */
     int fCubeful;               /* cubeful equities included */
     FILE *pf;                   /* file pointer */
+    /* two sided dbs split over several files */
+    unsigned int cShards;       /* number of files */
+    unsigned int nShardRows;    /* positions of the player on roll per file */
+    FILE **apfShard;            /* the files after the first */
+    /* compressed two sided dbs, see BEAROFF_BLOCK */
+    struct _bearoffblockcache *pcache;  /* recently decoded blocks */
+    float *arDist;              /* one sided dbs in memory, see BuildDistTable() */
     char *szFilename;           /* filename */
     GMappedFile *map;
+    size_t cbMap;               /* length, when mapped with BO_POPULATE */
     unsigned char *p;           /* pointer to data in memory */
+    size_t cbMemory;            /* counted in MEM_BEAROFF, see memusage.h */
 } bearoffcontext;
 
 enum bearoffoptions {
@@ -54,7 +66,8 @@ enum bearoffoptions {
     BO_IN_MEMORY = 1,
     BO_MUST_BE_ONE_SIDED = 2,
     BO_MUST_BE_TWO_SIDED = 4,
-    BO_HEURISTIC = 8
+    BO_HEURISTIC = 8,
+    BO_POPULATE = 16            /* read in the whole file when mapping it */
 };
 
 extern bearoffcontext *BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned int));
@@ -76,10 +89,12 @@ BearoffDist(const bearoffcontext * pbc, const unsigned int nPosID,
             float ar[4], unsigned short int ausProb[32], unsigned short int ausGammonProb[32]);
 
 extern int
- BearoffCubeful(const bearoffcontext * pbc, const unsigned int iPos, float ar[4], unsigned short int aus[4]);
+ BearoffCubeful(const bearoffcontext * pbc, const guint64 iPos, float ar[4], unsigned short int aus[4]);
 
 extern void BearoffClose(bearoffcontext * pbc);
 
+extern void BearoffPrefetch(const bearoffcontext * pbc, const TanBoard anBoard);
+
 extern int
  isBearoff(const bearoffcontext * pbc, const TanBoard anBoard);
 
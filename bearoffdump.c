@@ -43,13 +43,13 @@ main(int argc, char **argv)
 {
 
     char *filename, *szPosID = NULL;
-    unsigned int id = 0;
+    gint64 id = 0;
     bearoffcontext *pbc;
     char sz[4096];
     TanBoard anBoard;
 
     GOptionEntry ao[] = {
-        {"index", 'n', 0, G_OPTION_ARG_INT, &id,
+        {"index", 'n', 0, G_OPTION_ARG_INT64, &id,
          N_("index"), NULL},
         {"posid", 'p', 0, G_OPTION_ARG_STRING, &szPosID,
          N_("Position ID"), NULL},
@@ -74,7 +74,7 @@ main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    if ((szPosID && id) || (!szPosID && !id)) {
+    if ((szPosID && id) || (!szPosID && id <= 0)) {
         g_printerr(_("Either Position ID or index is required.\n" "For more help try `bearoffdump --help'\n"));
         exit(EXIT_FAILURE);
     }
@@ -90,7 +90,7 @@ main(int argc, char **argv)
     if (!id) {
         g_print(_("Position ID     : %s\n"), szPosID);
     } else {
-        g_print(_("Position number : %u\n"), id);
+        g_print(_("Position number : %" G_GINT64_FORMAT "\n"), id);
     }
 
     /* This is needed since we call ReadBearoffFile() from bearoff.c */
@@ -120,11 +120,11 @@ main(int argc, char **argv)
     } else {
         unsigned int n, nUs, nThem;
 
-        g_print(_("\n" "Dump of position#: %u\n\n"), id);
+        g_print(_("\n" "Dump of position#: %" G_GINT64_FORMAT "\n\n"), id);
 
         n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
-        nUs = id / n;
-        nThem = id % n;
+        nUs = (unsigned int) ((guint64) id / n);
+        nThem = (unsigned int) ((guint64) id % n);
         PositionFromBearoff(anBoard[0], nThem, pbc->nPoints, pbc->nChequers);
         PositionFromBearoff(anBoard[1], nUs, pbc->nPoints, pbc->nChequers);
     }
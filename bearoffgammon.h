@@ -29,9 +29,9 @@ struct GammonProbs {
     unsigned int p0:8;          /* 0 - 36   */
 };
 
-extern struct GammonProbs *getBearoffGammonProbs(const unsigned int board[6]);
+extern const struct GammonProbs *getBearoffGammonProbs(const unsigned int board[6]);
 
-extern long *getRaceBGprobs(const unsigned int board[6]);
+extern const unsigned int *getRaceBGprobs(const unsigned int board[6]);
 
 #define RBG_NPROBS 5
 
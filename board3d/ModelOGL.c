@@ -62,24 +62,18 @@ void OglModelDraw(const ModelManager* modelManager, int modelNumber, const Mater
 	float* data = &modelManager->vertexData[modelManager->models[modelNumber].dataStart];
 	int dataLength = modelManager->models[modelNumber].dataLength;
 
-	int usesTexture = (pMat && pMat->pTexture);
 	setMaterial(pMat);
 
 	glPushMatrix();
 	glLoadMatrixf(GetModelViewMatrix());
 
-	glBegin(GL_TRIANGLES);
-	for (int vertex = 0; vertex < dataLength / VERTEX_STRIDE; vertex++)
-	{
-		if (usesTexture)
-		{
-			glTexCoord2f(data[0], data[1]);
-		}
-		glNormal3f(data[2], data[3], data[4]);
-		glVertex3f(data[5], data[6], data[7]);
-		data += VERTEX_STRIDE;
-	}
-	glEnd();
+	/* The vertices are laid out as texture coordinates, normal and position, so the
+	whole model goes to the driver in one call (texture coordinates are ignored
+	when texturing is off) */
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glInterleavedArrays(GL_T2F_N3F_V3F, 0, data);
+	glDrawArrays(GL_TRIANGLES, 0, dataLength / VERTEX_STRIDE);
+	glPopClientAttrib();
 
 	glPopMatrix();
 }
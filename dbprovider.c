@@ -29,6 +29,7 @@
 
 DBProviderType dbProviderType = (DBProviderType)INVALID_PROVIDER ;
 int storeGameStats = TRUE;
+int storePositions = FALSE;
 
 #if defined(USE_PYTHON)
 #include "pylocdefs.h"
@@ -43,7 +44,10 @@ static int PyMySQLConnect(const char *dbfilename, const char *user, const char *
 static void PyDisconnect(void);
 static RowSet *PySelect(const char *str);
 static int PyUpdateCommand(const char *str);
+static int PyUpdateCommandBind(const char *str, unsigned int n, const char *const *values);
+static int PyBeginTransaction(void);
 static void PyCommit(void);
+static void PyRollback(void);
 static int PyPostgreConnect(const char *dbfilename, const char *user, const char *password, const char *hostname);
 static GList *PyPostgreGetDatabaseList(const char *user, const char *password, const char *hostname);
 static int PyPostgreDeleteDatabase(const char *dbfilename, const char *user, const char *password,
@@ -56,7 +60,34 @@ static int SQLiteConnect(const char *dbfilename, const char *user, const char *p
 static void SQLiteDisconnect(void);
 static RowSet *SQLiteSelect(const char *str);
 static int SQLiteUpdateCommand(const char *str);
+static int SQLiteUpdateCommandBind(const char *str, unsigned int n, const char *const *values);
+static int SQLiteBeginTransaction(void);
 static void SQLiteCommit(void);
+static void SQLiteRollback(void);
+#endif
+#if defined(USE_LIBPQ)
+static int PGConnect(const char *dbfilename, const char *user, const char *password, const char *hostname);
+static void PGDisconnect(void);
+static RowSet *PGSelect(const char *str);
+static int PGUpdateCommand(const char *str);
+static int PGUpdateCommandBind(const char *str, unsigned int n, const char *const *values);
+static int PGBeginTransaction(void);
+static void PGCommit(void);
+static void PGRollback(void);
+static GList *PGGetDatabaseList(const char *user, const char *password, const char *hostname);
+static int PGDeleteDatabase(const char *dbfilename, const char *user, const char *password, const char *hostname);
+#endif
+#if defined(USE_MYSQL)
+static int MySQLConnect(const char *dbfilename, const char *user, const char *password, const char *hostname);
+static void MySQLDisconnect(void);
+static RowSet *MySQLSelect(const char *str);
+static int MySQLUpdateCommand(const char *str);
+static int MySQLUpdateCommandBind(const char *str, unsigned int n, const char *const *values);
+static int MySQLBeginTransaction(void);
+static void MySQLCommit(void);
+static void MySQLRollback(void);
+static GList *MySQLGetDatabaseList(const char *user, const char *password, const char *hostname);
+static int MySQLDeleteDatabase(const char *dbfilename, const char *user, const char *password, const char *hostname);
 #endif
 
 #if NUM_PROVIDERS
@@ -69,7 +100,10 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Disconnect = SQLiteDisconnect,
 	.Select = SQLiteSelect,
 	.UpdateCommand = SQLiteUpdateCommand,
+	.UpdateCommandBind = SQLiteUpdateCommandBind,
+	.BeginTransaction = SQLiteBeginTransaction,
 	.Commit = SQLiteCommit,
+	.Rollback = SQLiteRollback,
 	.GetDatabaseList = SQLiteGetDatabaseList,
 	.DeleteDatabase = SQLiteDeleteDatabase,
 	.name = "SQLite",
@@ -90,7 +124,10 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Disconnect = PyDisconnect,
 	.Select = PySelect,
 	.UpdateCommand = PyUpdateCommand,
+	.UpdateCommandBind = PyUpdateCommandBind,
+	.BeginTransaction = PyBeginTransaction,
 	.Commit = PyCommit,
+	.Rollback = PyRollback,
 	.GetDatabaseList = SQLiteGetDatabaseList,
 	.DeleteDatabase = SQLiteDeleteDatabase,
 	.name = "SQLite (Python)",
@@ -109,7 +146,10 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Disconnect = PyDisconnect,
 	.Select = PySelect,
 	.UpdateCommand = PyUpdateCommand,
+	.UpdateCommandBind = PyUpdateCommandBind,
+	.BeginTransaction = PyBeginTransaction,
 	.Commit = PyCommit,
+	.Rollback = PyRollback,
 	.GetDatabaseList = PyMySQLGetDatabaseList,
 	.DeleteDatabase = PyMySQLDeleteDatabase,
 	.name = "MySQL (Python)",
@@ -127,7 +167,10 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Disconnect = PyDisconnect,
 	.Select = PySelect,
 	.UpdateCommand = PyUpdateCommand,
+	.UpdateCommandBind = PyUpdateCommandBind,
+	.BeginTransaction = PyBeginTransaction,
 	.Commit = PyCommit,
+	.Rollback = PyRollback,
 	.GetDatabaseList = PyPostgreGetDatabaseList,
 	.DeleteDatabase = PyPostgreDeleteDatabase,
 	.name = "PostgreSQL (Python)",
@@ -139,7 +182,53 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.username = NULL,
 	.password = NULL,
 	.hostname = NULL
-    }
+    },
+#endif
+#if defined(USE_LIBPQ)
+    {
+	.Connect = PGConnect,
+	.Disconnect = PGDisconnect,
+	.Select = PGSelect,
+	.UpdateCommand = PGUpdateCommand,
+	.UpdateCommandBind = PGUpdateCommandBind,
+	.BeginTransaction = PGBeginTransaction,
+	.Commit = PGCommit,
+	.Rollback = PGRollback,
+	.GetDatabaseList = PGGetDatabaseList,
+	.DeleteDatabase = PGDeleteDatabase,
+	.name = "PostgreSQL",
+	.shortname = "PostgreSQL",
+	.desc = N_("Direct PostgreSQL connection"),
+	.HasUserDetails = TRUE,
+	.storeGameStats = TRUE,
+	.database = NULL,
+	.username = NULL,
+	.password = NULL,
+	.hostname = NULL
+    },
+#endif
+#if defined(USE_MYSQL)
+    {
+	.Connect = MySQLConnect,
+	.Disconnect = MySQLDisconnect,
+	.Select = MySQLSelect,
+	.UpdateCommand = MySQLUpdateCommand,
+	.UpdateCommandBind = MySQLUpdateCommandBind,
+	.BeginTransaction = MySQLBeginTransaction,
+	.Commit = MySQLCommit,
+	.Rollback = MySQLRollback,
+	.GetDatabaseList = MySQLGetDatabaseList,
+	.DeleteDatabase = MySQLDeleteDatabase,
+	.name = "MySQL",
+	.shortname = "MySQL",
+	.desc = N_("Direct MySQL/MariaDB connection"),
+	.HasUserDetails = TRUE,
+	.storeGameStats = TRUE,
+	.database = NULL,
+	.username = NULL,
+	.password = NULL,
+	.hostname = NULL
+    },
 #endif
 };
 #else
@@ -149,7 +238,10 @@ DBProvider providers[1] = {
 	.Disconnect = NULL,
 	.Select = NULL,
 	.UpdateCommand = NULL,
+	.UpdateCommandBind = NULL,
+	.BeginTransaction = NULL,
 	.Commit = NULL,
+	.Rollback = NULL,
 	.GetDatabaseList = NULL,
 	.DeleteDatabase = NULL,
 	.name = "No Providers",
@@ -165,7 +257,7 @@ DBProvider providers[1] = {
 };
 #endif
 
-#if defined(USE_PYTHON) || defined(USE_SQLITE)
+#if NUM_PROVIDERS
 static RowSet *
 MallocRowset(size_t rows, size_t cols)
 {
@@ -293,6 +385,16 @@ DefaultDBSettings(void)
     providers[i].hostname = g_strdup("localhost:5432");
     providers[i++].database = g_strdup("gnubg");
 #endif
+#if defined(USE_LIBPQ)
+    /* native PostgreSQL */
+    providers[i].hostname = g_strdup("localhost:5432");
+    providers[i++].database = g_strdup("gnubg");
+#endif
+#if defined(USE_MYSQL)
+    /* native MySQL / MariaDB */
+    providers[i].hostname = g_strdup("localhost:3306");
+    providers[i++].database = g_strdup("gnubg");
+#endif
 #endif
 }
 
@@ -347,6 +449,7 @@ RelationalSaveSettings(FILE * pf)
 {
     int i;
     fprintf(pf, "relational setup storegamestats=%s\n", storeGameStats ? "yes" : "no");
+    fprintf(pf, "relational setup storepositions=%s\n", storePositions ? "yes" : "no");
 
     if (dbProviderType != INVALID_PROVIDER)
         fprintf(pf, "relational setup dbtype=%s\n", providers[dbProviderType].shortname);
@@ -516,6 +619,46 @@ PyUpdateCommand(const char *str)
         return TRUE;
 }
 
+/* The Python DB-API modules disagree on the parameter style, so the
+ * values are quoted into the statement here instead */
+static int
+PyUpdateCommandBind(const char *str, unsigned int n, const char *const *values)
+{
+    GString *sql = g_string_new(NULL);
+    unsigned int i = 0;
+    int ret;
+
+    for (; *str; str++) {
+        const char *pch;
+
+        if (*str != '?' || i == n) {
+            g_string_append_c(sql, *str);
+            continue;
+        }
+        if ((pch = values[i++]) == NULL) {
+            g_string_append(sql, "NULL");
+            continue;
+        }
+        g_string_append_c(sql, '\'');
+        for (; *pch; pch++) {
+            if (*pch == '\'')
+                g_string_append_c(sql, '\'');
+            g_string_append_c(sql, *pch);
+        }
+        g_string_append_c(sql, '\'');
+    }
+
+    ret = PyUpdateCommand(sql->str);
+    g_string_free(sql, TRUE);
+    return ret;
+}
+
+static int
+PyBeginTransaction(void)
+{                               /* The DB-API opens a transaction implicitly */
+    return TRUE;
+}
+
 static void
 PyCommit(void)
 {
@@ -523,6 +666,13 @@ PyCommit(void)
         PyErr_Print();
 }
 
+static void
+PyRollback(void)
+{
+    if (!PyRun_String("PyRollback()", Py_eval_input, pdict, pdict))
+        PyErr_Print();
+}
+
 static RowSet *
 ConvertPythonToRowset(PyObject * v)
 {
@@ -679,6 +829,13 @@ PyPostgreDeleteDatabase(const char *dbfilename, const char *user, const char *pa
 #include <sqlite3.h>
 
 static sqlite3 *connection;
+static GHashTable *htStatements;      /* prepared statements, keyed by SQL */
+
+static void
+SQLiteFinalize(gpointer p)
+{
+    sqlite3_finalize((sqlite3_stmt *) p);
+}
 
 int
 SQLiteConnect(const char *dbfilename, const char *UNUSED(user), const char *UNUSED(password),
@@ -696,8 +853,10 @@ SQLiteConnect(const char *dbfilename, const char *UNUSED(user), const char *UNUS
     g_free(name);
     g_free(filename);
 
-    if (ret == SQLITE_OK)
+    if (ret == SQLITE_OK) {
+        htStatements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, SQLiteFinalize);
         return exists ? 1 : 0;
+    }
     else
         return -1;
 }
@@ -705,6 +864,10 @@ SQLiteConnect(const char *dbfilename, const char *UNUSED(user), const char *UNUS
 static void
 SQLiteDisconnect(void)
 {
+    if (htStatements) {
+        g_hash_table_destroy(htStatements);
+        htStatements = NULL;
+    }
     if (sqlite3_close(connection) != SQLITE_OK)
         outputerrf("SQL error: %s in sqlite3_close()", sqlite3_errmsg(connection));
 }
@@ -772,9 +935,59 @@ SQLiteUpdateCommand(const char *str)
     return (ret == SQLITE_OK);
 }
 
+int
+SQLiteUpdateCommandBind(const char *str, unsigned int n, const char *const *values)
+{
+    sqlite3_stmt *pStmt = g_hash_table_lookup(htStatements, str);
+    unsigned int i;
+    int ret;
+
+    if (!pStmt) {
+#if SQLITE_VERSION_NUMBER >= 3003011
+        ret = sqlite3_prepare_v2(connection, str, -1, &pStmt, NULL);
+#else
+        ret = sqlite3_prepare(connection, str, -1, &pStmt, NULL);
+#endif
+        if (ret != SQLITE_OK) {
+            outputerrf("SQL error: %s\nfrom '%s'", sqlite3_errmsg(connection), str);
+            return FALSE;
+        }
+        g_hash_table_insert(htStatements, g_strdup(str), pStmt);
+    }
+
+    for (i = 0, ret = SQLITE_OK; i < n && ret == SQLITE_OK; i++)
+        ret = values[i] ? sqlite3_bind_text(pStmt, (int) i + 1, values[i], -1, SQLITE_TRANSIENT)
+            : sqlite3_bind_null(pStmt, (int) i + 1);
+
+    if (ret == SQLITE_OK && (ret = sqlite3_step(pStmt)) == SQLITE_DONE)
+        ret = SQLITE_OK;
+
+    if (ret != SQLITE_OK)
+        outputerrf("SQL error: %s\nfrom '%s'", sqlite3_errmsg(connection), str);
+
+    sqlite3_reset(pStmt);
+    sqlite3_clear_bindings(pStmt);
+    return (ret == SQLITE_OK);
+}
+
+static int
+SQLiteBeginTransaction(void)
+{                               /* sqlite runs in autocommit mode by default */
+    return SQLiteUpdateCommand("BEGIN");
+}
+
 static void
 SQLiteCommit(void)
-{                               /* No transaction in sqlite by default */
+{
+    if (!sqlite3_get_autocommit(connection))
+        SQLiteUpdateCommand("COMMIT");
+}
+
+static void
+SQLiteRollback(void)
+{
+    if (!sqlite3_get_autocommit(connection))
+        SQLiteUpdateCommand("ROLLBACK");
 }
 #endif
 
@@ -815,3 +1028,478 @@ SQLiteDeleteDatabase(const char *dbfilename, const char *UNUSED(user), const cha
     return (ret == 0);
 }
 #endif
+
+#if defined(USE_LIBPQ)
+
+#include <libpq-fe.h>
+
+static PGconn *pgconn;
+static GHashTable *htPGStatements;    /* prepared statement names, keyed by SQL */
+
+/* hostname is host[:port], as for the Python providers */
+static PGconn *
+PGConnectTo(const char *dbname, const char *user, const char *password, const char *hostname)
+{
+    const char *const keywords[] = { "host", "port", "dbname", "user", "password", NULL };
+    const char *values[6];
+    char *host = g_strdup(hostname ? hostname : "");
+    char *port = strchr(host, ':');
+    PGconn *conn;
+
+    if (port)
+        *port++ = '\0';
+
+    values[0] = host;
+    values[1] = port;
+    values[2] = dbname;
+    values[3] = user;
+    values[4] = password;
+    values[5] = NULL;
+
+    conn = PQconnectdbParams(keywords, values, 0);
+    g_free(host);
+    return conn;
+}
+
+static int
+PGCommandOK(PGconn * conn, PGresult * res, const char *str)
+{
+    ExecStatusType status = PQresultStatus(res);
+    int ok = (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK);
+
+    if (!ok)
+        outputerrf("SQL error: %s\nfrom '%s'", PQerrorMessage(conn), str);
+    PQclear(res);
+    return ok;
+}
+
+int
+PGConnect(const char *dbfilename, const char *user, const char *password, const char *hostname)
+{
+    PGconn *conn;
+    PGresult *res;
+    char *id, *buf;
+    int exists;
+
+    pgconn = PGConnectTo(dbfilename, user, password, hostname);
+    if (PQstatus(pgconn) == CONNECTION_OK) {
+        htPGStatements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        return 1;
+    }
+    PQfinish(pgconn);
+    pgconn = NULL;
+
+    /* See if the server is there and the database just needs creating */
+    conn = PGConnectTo("postgres", user, password, hostname);
+    if (PQstatus(conn) != CONNECTION_OK) {
+        outputerrf("%s", PQerrorMessage(conn));
+        PQfinish(conn);
+        return -1;
+    }
+
+    res = PQexecParams(conn, "SELECT 1 FROM pg_database WHERE datname = $1", 1, NULL, &dbfilename, NULL, NULL, 0);
+    exists = (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) > 0);
+    PQclear(res);
+    if (exists) {               /* database is there, but we cannot use it */
+        PQfinish(conn);
+        return -1;
+    }
+
+    id = PQescapeIdentifier(conn, dbfilename, strlen(dbfilename));
+    buf = g_strdup_printf("CREATE DATABASE %s", id);
+    PQfreemem(id);
+    exists = PGCommandOK(conn, PQexec(conn, buf), buf);
+    g_free(buf);
+    PQfinish(conn);
+    if (!exists)
+        return -1;
+
+    pgconn = PGConnectTo(dbfilename, user, password, hostname);
+    if (PQstatus(pgconn) != CONNECTION_OK) {
+        outputerrf("%s", PQerrorMessage(pgconn));
+        PQfinish(pgconn);
+        pgconn = NULL;
+        return -1;
+    }
+    htPGStatements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    return 0;
+}
+
+static void
+PGDisconnect(void)
+{
+    if (htPGStatements) {
+        g_hash_table_destroy(htPGStatements);
+        htPGStatements = NULL;
+    }
+    PQfinish(pgconn);
+    pgconn = NULL;
+}
+
+/* The text of the result is used as is, instead of going through
+ * Python objects */
+static RowSet *
+PGSelect(const char *str)
+{
+    char *buf = g_strdup_printf("SELECT %s;", str);
+    PGresult *res = PQexec(pgconn, buf);
+    RowSet *rs = NULL;
+
+    g_free(buf);
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        size_t numRows = (size_t) PQntuples(res);
+        size_t numCols = (size_t) PQnfields(res);
+        size_t i, row;
+
+        rs = MallocRowset(numRows + 1, numCols);        /* first row is headings */
+
+        for (i = 0; i < numCols; i++)
+            SetRowsetData(rs, 0, i, PQfname(res, (int) i));
+
+        for (row = 0; row < numRows; row++)
+            for (i = 0; i < numCols; i++)
+                SetRowsetData(rs, row + 1, i,
+                              PQgetisnull(res, (int) row, (int) i) ? NULL : PQgetvalue(res, (int) row, (int) i));
+    } else
+        outputerrf("SQL error: %s\nfrom '%s'", PQerrorMessage(pgconn), str);
+
+    PQclear(res);
+    return rs;
+}
+
+static int
+PGUpdateCommand(const char *str)
+{
+    return PGCommandOK(pgconn, PQexec(pgconn, str), str);
+}
+
+static int
+PGUpdateCommandBind(const char *str, unsigned int n, const char *const *values)
+{
+    const char *name = g_hash_table_lookup(htPGStatements, str);
+
+    if (!name) {
+        /* PostgreSQL numbers its parameters, so rewrite the ? outside
+         * of string literals as $1, $2, ... */
+        GString *sql = g_string_new(NULL);
+        const char *pch;
+        int quoted = FALSE;
+        unsigned int i = 0;
+        char *newname;
+
+        for (pch = str; *pch; pch++) {
+            if (*pch == '\'')
+                quoted = !quoted;
+            if (*pch == '?' && !quoted)
+                g_string_append_printf(sql, "$%u", ++i);
+            else
+                g_string_append_c(sql, *pch);
+        }
+
+        newname = g_strdup_printf("gnubg%u", g_hash_table_size(htPGStatements));
+        if (!PGCommandOK(pgconn, PQprepare(pgconn, newname, sql->str, (int) i, NULL), str)) {
+            g_free(newname);
+            g_string_free(sql, TRUE);
+            return FALSE;
+        }
+        g_string_free(sql, TRUE);
+        g_hash_table_insert(htPGStatements, g_strdup(str), newname);
+        name = newname;
+    }
+
+    return PGCommandOK(pgconn, PQexecPrepared(pgconn, name, (int) n, values, NULL, NULL, 0), str);
+}
+
+static int
+PGBeginTransaction(void)
+{
+    return PGUpdateCommand("BEGIN");
+}
+
+static void
+PGCommit(void)
+{                               /* libpq is in autocommit mode outside BEGIN */
+    if (PQtransactionStatus(pgconn) != PQTRANS_IDLE)
+        PGUpdateCommand("COMMIT");
+}
+
+static void
+PGRollback(void)
+{
+    if (PQtransactionStatus(pgconn) != PQTRANS_IDLE)
+        PGUpdateCommand("ROLLBACK");
+}
+
+static GList *
+PGGetDatabaseList(const char *user, const char *password, const char *hostname)
+{
+    PGconn *conn = PGConnectTo("postgres", user, password, hostname);
+    PGresult *res;
+    GList *glist = NULL;
+
+    if (PQstatus(conn) != CONNECTION_OK) {
+        PQfinish(conn);
+        return NULL;
+    }
+
+    res = PQexec(conn, "SELECT datname FROM pg_database WHERE NOT datistemplate");
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        int i;
+        for (i = 0; i < PQntuples(res); i++)
+            glist = g_list_append(glist, g_strdup(PQgetvalue(res, i, 0)));
+    }
+    PQclear(res);
+    PQfinish(conn);
+    return glist;
+}
+
+static int
+PGDeleteDatabase(const char *dbfilename, const char *user, const char *password, const char *hostname)
+{
+    PGconn *conn = PGConnectTo("postgres", user, password, hostname);
+    char *id, *buf;
+    int ret;
+
+    if (PQstatus(conn) != CONNECTION_OK) {
+        PQfinish(conn);
+        return FALSE;
+    }
+
+    id = PQescapeIdentifier(conn, dbfilename, strlen(dbfilename));
+    buf = g_strdup_printf("DROP DATABASE %s", id);
+    PQfreemem(id);
+    ret = PGCommandOK(conn, PQexec(conn, buf), buf);
+    g_free(buf);
+    PQfinish(conn);
+    return ret;
+}
+#endif
+
+#if defined(USE_MYSQL)
+
+#include <mysql.h>
+
+static MYSQL *myconn;
+static GHashTable *htMySQLStatements; /* prepared statements, keyed by SQL */
+
+static void
+MySQLStmtClose(gpointer p)
+{
+    mysql_stmt_close((MYSQL_STMT *) p);
+}
+
+/* hostname is host[:port], as for the Python providers */
+static MYSQL *
+MySQLConnectTo(const char *dbname, const char *user, const char *password, const char *hostname)
+{
+    MYSQL *conn = mysql_init(NULL);
+    char *host = g_strdup(hostname && *hostname ? hostname : "localhost");
+    char *port = strchr(host, ':');
+    unsigned int nPort = 3306;
+
+    if (port) {
+        *port++ = '\0';
+        nPort = (unsigned int) strtoul(port, NULL, 10);
+    }
+
+    if (conn && !mysql_real_connect(conn, host, user, password, dbname, nPort, NULL, 0)) {
+        mysql_close(conn);
+        conn = NULL;
+    }
+    g_free(host);
+    return conn;
+}
+
+int
+MySQLConnect(const char *dbfilename, const char *user, const char *password, const char *hostname)
+{
+    char *buf;
+    int ok;
+
+    if ((myconn = MySQLConnectTo(dbfilename, user, password, hostname)) != NULL) {
+        htMySQLStatements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, MySQLStmtClose);
+        return 1;
+    }
+
+    /* See if the server is there and the database just needs creating */
+    if ((myconn = MySQLConnectTo(NULL, user, password, hostname)) == NULL)
+        return -1;
+
+    if (!mysql_select_db(myconn, dbfilename)) {
+        /* database is there, but we could not connect to it */
+        mysql_close(myconn);
+        myconn = NULL;
+        return -1;
+    }
+
+    buf = g_strdup_printf("CREATE DATABASE `%s`", dbfilename);
+    ok = !mysql_query(myconn, buf) && !mysql_select_db(myconn, dbfilename);
+    if (!ok) {
+        outputerrf("SQL error: %s\nfrom '%s'", mysql_error(myconn), buf);
+        mysql_close(myconn);
+        myconn = NULL;
+    }
+    g_free(buf);
+    if (!ok)
+        return -1;
+
+    htMySQLStatements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, MySQLStmtClose);
+    return 0;
+}
+
+static void
+MySQLDisconnect(void)
+{
+    if (htMySQLStatements) {
+        g_hash_table_destroy(htMySQLStatements);
+        htMySQLStatements = NULL;
+    }
+    mysql_close(myconn);
+    myconn = NULL;
+}
+
+static RowSet *
+MySQLSelect(const char *str)
+{
+    char *buf = g_strdup_printf("SELECT %s", str);
+    MYSQL_RES *res = NULL;
+    RowSet *rs = NULL;
+
+    if (!mysql_query(myconn, buf) && (res = mysql_store_result(myconn)) != NULL) {
+        size_t numRows = (size_t) mysql_num_rows(res);
+        size_t numCols = (size_t) mysql_num_fields(res);
+        MYSQL_FIELD *fields = mysql_fetch_fields(res);
+        MYSQL_ROW row;
+        size_t i, r = 0;
+
+        rs = MallocRowset(numRows + 1, numCols);        /* first row is headings */
+
+        for (i = 0; i < numCols; i++)
+            SetRowsetData(rs, 0, i, fields[i].name);
+
+        while ((row = mysql_fetch_row(res)) != NULL) {
+            r++;
+            for (i = 0; i < numCols; i++)
+                SetRowsetData(rs, r, i, row[i]);
+        }
+        mysql_free_result(res);
+    } else
+        outputerrf("SQL error: %s\nfrom '%s'", mysql_error(myconn), str);
+
+    g_free(buf);
+    return rs;
+}
+
+static int
+MySQLUpdateCommand(const char *str)
+{
+    MYSQL_RES *res;
+
+    if (mysql_query(myconn, str)) {
+        outputerrf("SQL error: %s\nfrom '%s'", mysql_error(myconn), str);
+        return FALSE;
+    }
+    /* discard any result so the connection can be used again */
+    if ((res = mysql_store_result(myconn)) != NULL)
+        mysql_free_result(res);
+    return TRUE;
+}
+
+static int
+MySQLUpdateCommandBind(const char *str, unsigned int n, const char *const *values)
+{
+    MYSQL_STMT *stmt = g_hash_table_lookup(htMySQLStatements, str);
+    MYSQL_BIND *binds;
+    unsigned int i;
+    int ok;
+
+    if (!stmt) {
+        if ((stmt = mysql_stmt_init(myconn)) == NULL) {
+            outputerrf("SQL error: %s\nfrom '%s'", mysql_error(myconn), str);
+            return FALSE;
+        }
+        if (mysql_stmt_prepare(stmt, str, (unsigned long) strlen(str))) {
+            outputerrf("SQL error: %s\nfrom '%s'", mysql_stmt_error(stmt), str);
+            mysql_stmt_close(stmt);
+            return FALSE;
+        }
+        g_hash_table_insert(htMySQLStatements, g_strdup(str), stmt);
+    }
+
+    binds = g_new0(MYSQL_BIND, n ? n : 1);
+    for (i = 0; i < n; i++) {
+        if (values[i]) {
+            binds[i].buffer_type = MYSQL_TYPE_STRING;
+            binds[i].buffer = (void *) values[i];
+            binds[i].buffer_length = (unsigned long) strlen(values[i]);
+        } else
+            binds[i].buffer_type = MYSQL_TYPE_NULL;
+    }
+
+    ok = !mysql_stmt_bind_param(stmt, binds) && !mysql_stmt_execute(stmt);
+    if (!ok)
+        outputerrf("SQL error: %s\nfrom '%s'", mysql_stmt_error(stmt), str);
+
+    g_free(binds);
+    return ok;
+}
+
+static int
+MySQLBeginTransaction(void)
+{
+    return MySQLUpdateCommand("START TRANSACTION");
+}
+
+static void
+MySQLCommit(void)
+{
+    if (mysql_commit(myconn))
+        outputerrf("SQL error: %s in mysql_commit()", mysql_error(myconn));
+}
+
+static void
+MySQLRollback(void)
+{
+    if (mysql_rollback(myconn))
+        outputerrf("SQL error: %s in mysql_rollback()", mysql_error(myconn));
+}
+
+static GList *
+MySQLGetDatabaseList(const char *user, const char *password, const char *hostname)
+{
+    MYSQL *conn = MySQLConnectTo(NULL, user, password, hostname);
+    MYSQL_RES *res;
+    GList *glist = NULL;
+
+    if (!conn)
+        return NULL;
+
+    if (!mysql_query(conn, "SHOW DATABASES") && (res = mysql_store_result(conn)) != NULL) {
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(res)) != NULL)
+            glist = g_list_append(glist, g_strdup(row[0]));
+        mysql_free_result(res);
+    }
+    mysql_close(conn);
+    return glist;
+}
+
+static int
+MySQLDeleteDatabase(const char *dbfilename, const char *user, const char *password, const char *hostname)
+{
+    MYSQL *conn = MySQLConnectTo(NULL, user, password, hostname);
+    char *buf;
+    int ret;
+
+    if (!conn)
+        return FALSE;
+
+    buf = g_strdup_printf("DROP DATABASE `%s`", dbfilename);
+    ret = !mysql_query(conn, buf);
+    if (!ret)
+        outputerrf("SQL error: %s\nfrom '%s'", mysql_error(conn), buf);
+    g_free(buf);
+    mysql_close(conn);
+    return ret;
+}
+#endif
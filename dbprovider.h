@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <glib.h>
 extern int storeGameStats;
+extern int storePositions;
 
 typedef struct {
     size_t cols, rows;
@@ -36,7 +37,12 @@ typedef struct {
     void (*Disconnect) (void);
     RowSet *(*Select) (const char *str);
     int (*UpdateCommand) (const char *str);
+    /* As UpdateCommand, with each '?' in str replaced by the next of
+     * the n values (NULL for SQL NULL) */
+    int (*UpdateCommandBind) (const char *str, unsigned int n, const char *const *values);
+    int (*BeginTransaction) (void);
     void (*Commit) (void);
+    void (*Rollback) (void);
     GList *(*GetDatabaseList) (const char *user, const char *password, const char *hostname);
     int (*DeleteDatabase) (const char *database, const char *user, const char *password, const char *hostname);
 
@@ -61,18 +67,38 @@ typedef enum {
     PYTHON_SQLITE,
 #endif
     PYTHON_MYSQL,
-    PYTHON_POSTGRES
+    PYTHON_POSTGRES,
+#endif
+#if defined(USE_LIBPQ)
+    NATIVE_POSTGRES,
+#endif
+#if defined(USE_MYSQL)
+    NATIVE_MYSQL,
 #endif
 } DBProviderType;
 
 #if defined(USE_PYTHON)
-#define NUM_PROVIDERS 3
+#define NUM_BASE_PROVIDERS 3
 #elif defined(USE_SQLITE)
-#define NUM_PROVIDERS 1
+#define NUM_BASE_PROVIDERS 1
+#else
+#define NUM_BASE_PROVIDERS 0
+#endif
+
+#if defined(USE_LIBPQ)
+#define NUM_LIBPQ_PROVIDERS 1
 #else
-#define NUM_PROVIDERS 0
+#define NUM_LIBPQ_PROVIDERS 0
 #endif
 
+#if defined(USE_MYSQL)
+#define NUM_MYSQL_PROVIDERS 1
+#else
+#define NUM_MYSQL_PROVIDERS 0
+#endif
+
+#define NUM_PROVIDERS (NUM_BASE_PROVIDERS + NUM_LIBPQ_PROVIDERS + NUM_MYSQL_PROVIDERS)
+
 extern DBProviderType dbProviderType;
 
 DBProvider *GetDBProvider(DBProviderType dbType);
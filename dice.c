@@ -62,6 +62,7 @@ const char *aszRNG[NUM_RNGS] = {
     "ISAAC",
     "MD5",
     N_("Mersenne Twister"),
+    "Philox",
     N_("manual dice"),
     "www.random.org",
     N_("read from file")
@@ -72,6 +73,8 @@ const char *aszRNGTip[NUM_RNGS] = {
     N_("Bob Jenkins' Indirection, Shift, Accumulate, Add and Count " "cryptographic generator"),
     N_("A generator based on the Message Digest 5 algorithm"),
     N_("Makoto Matsumoto and Mutsuo Saito's generator"),
+    N_("Salmon, Moraes, Dror and Shaw's counter-based generator, "
+       "which seeds in constant time"),
     N_("Enter each dice roll by hand"),
     N_("The online non-deterministic generator from random.org"),
     N_("Dice loaded from a file"),
@@ -82,8 +85,13 @@ rngcontext *rngctxCurrent = NULL;
 
 struct rngcontext {
 
-    /* RNG_FILE */
-    FILE *fDice;
+    /* RNG_FILE: the mapped file and the next byte, or in a packed
+     * file the next die, see ReadDiceFile() */
+    GMappedFile *pmfDice;
+    const unsigned char *puchDice;
+    size_t cbDice;
+    size_t iDice;
+    int fPackedDice;
     char *szDiceFilename;
 
     /* RNG_ISAAC */
@@ -95,6 +103,13 @@ struct rngcontext {
     /* RNG_MERSENNE */
     sfmt_t sfmt;
 
+    /* RNG_PHILOX: block nPhilox of the stream of key auPhiloxKey, of
+     * which iPhilox numbers are used */
+    uint32_t auPhiloxKey[2];
+    uint64_t nPhilox;
+    uint32_t auPhilox[4];
+    unsigned int iPhilox;
+
     /* RNG_BBS */
 
 #if defined(HAVE_LIBGMP)
@@ -110,6 +125,12 @@ struct rngcontext {
 #endif
     unsigned int n;             /* seed */
 
+    /* rolls drawn ahead by RollDiceBuffered(), emptied when the
+     * generator is seeded or closed */
+    unsigned char aanBuffer[DICE_BUFFER][2];
+    unsigned int iBuffer, cBuffer;
+    unsigned int cNextBatch;
+
 };
 
 
@@ -353,6 +374,7 @@ PrintRNGCounter(const rng rngx, rngcontext * rngctx)
     case RNG_BBS:
     case RNG_ISAAC:
     case RNG_MD5:
+    case RNG_PHILOX:
         g_print(_("Number of calls since last seed: %lu."), rngctx->c);
         g_print("\n");
 
@@ -440,6 +462,7 @@ PrintRNGSeed(const rng rngx, rngcontext * rngctx)
 
     case RNG_ISAAC:
     case RNG_MERSENNE:
+    case RNG_PHILOX:
 #if defined(HAVE_LIBGMP)
         PrintRNGSeedMP(rngctx->nz);
 #else
@@ -454,12 +477,69 @@ PrintRNGSeed(const rng rngx, rngcontext * rngctx)
     g_printerr("\n");
 }
 
+/* Philox4x32-10 of Salmon et al., "Parallel random numbers: as easy
+ * as 1, 2, 3" (SC11).  Block n of the stream of a key is a function of
+ * the two alone, so seeding is setting the key and any game of a
+ * rollout can be played without generating the ones before it. */
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+static void
+PhiloxBlock(const uint32_t auKey[2], uint64_t n, uint32_t au[4])
+{
+    uint32_t k0 = auKey[0], k1 = auKey[1];
+    uint32_t c0 = (uint32_t) n, c1 = (uint32_t) (n >> 32), c2 = 0, c3 = 0;
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    au[0] = c0;
+    au[1] = c1;
+    au[2] = c2;
+    au[3] = c3;
+}
+
+static void
+PhiloxSeed(rngcontext * rngctx, uint32_t u0, uint32_t u1)
+{
+    rngctx->auPhiloxKey[0] = u0;
+    rngctx->auPhiloxKey[1] = u1;
+    rngctx->nPhilox = 0;
+    rngctx->iPhilox = 4;
+}
+
+static inline uint32_t
+PhiloxNext(rngcontext * rngctx)
+{
+    if (rngctx->iPhilox == 4) {
+        PhiloxBlock(rngctx->auPhiloxKey, rngctx->nPhilox++, rngctx->auPhilox);
+        rngctx->iPhilox = 0;
+    }
+
+    return rngctx->auPhilox[rngctx->iPhilox++];
+}
+
 extern void
 InitRNGSeed(unsigned int n, const rng rngx, rngcontext * rngctx)
 {
 
     rngctx->n = n;
     rngctx->c = 0;
+    rngctx->iBuffer = rngctx->cBuffer = rngctx->cNextBatch = 0;
 
     switch (rngx) {
 
@@ -492,6 +572,10 @@ InitRNGSeed(unsigned int n, const rng rngx, rngcontext * rngctx)
         sfmt_init_gen_rand(&rngctx->sfmt, n);
         break;
 
+    case RNG_PHILOX:
+        PhiloxSeed(rngctx, n, 0);
+        break;
+
     case RNG_MANUAL:
     case RNG_RANDOM_DOT_ORG:
     case RNG_FILE:
@@ -504,6 +588,19 @@ InitRNGSeed(unsigned int n, const rng rngx, rngcontext * rngctx)
     }
 }
 
+/* Seed rngctx for game iTrial of a rollout with seed nSeed.  Philox
+ * takes the two as its key, so no two games of any rollouts share
+ * dice; the others keep the seed nSeed + (iTrial << 8) they have always
+ * used, so that rollouts made before are reproduced. */
+extern void
+InitRNGSeedTrial(unsigned int nSeed, unsigned int iTrial, const rng rngx, rngcontext * rngctx)
+{
+    InitRNGSeed(nSeed + (iTrial << 8), rngx, rngctx);
+
+    if (rngx == RNG_PHILOX)
+        PhiloxSeed(rngctx, nSeed, iTrial);
+}
+
 #if defined(HAVE_LIBGMP)
 static void
 InitRNGSeedMP(mpz_t n, rng rng, rngcontext * rngctx)
@@ -511,6 +608,7 @@ InitRNGSeedMP(mpz_t n, rng rng, rngcontext * rngctx)
 
     mpz_set(rngctx->nz, n);
     rngctx->c = 0;
+    rngctx->iBuffer = rngctx->cBuffer = rngctx->cNextBatch = 0;
 
     switch (rng) {
 
@@ -540,6 +638,18 @@ InitRNGSeedMP(mpz_t n, rng rng, rngcontext * rngctx)
         InitRNGSeed((unsigned int) (mpz_get_ui(n) % UINT_MAX), rng, rngctx);
         break;
 
+    case RNG_PHILOX:{
+            /* the key is the low 64 bits of the seed */
+            uint32_t *au;
+            size_t c;
+
+            au = mpz_export(NULL, &c, -1, sizeof(uint32_t), 0, 0, n);
+            PhiloxSeed(rngctx, c > 0 ? au[0] : 0, c > 1 ? au[1] : 0);
+            free(au);
+
+            break;
+        }
+
     case RNG_BBS:
         g_assert(rngctx->fZInit);
         mpz_set(rngctx->zSeed, n);
@@ -600,14 +710,16 @@ InitRNGSeedLong(char *sz, rng rng, rngcontext * rngctx)
 static void
 CloseDiceFile(rngcontext * rngctx)
 {
-    if (rngctx->fDice)
-        fclose(rngctx->fDice);
+    if (rngctx->pmfDice) {
+        g_mapped_file_unref(rngctx->pmfDice);
+        rngctx->pmfDice = NULL;
+    }
 }
 
 extern void
 CloseRNG(const rng rngx, rngcontext * rngctx)
 {
-
+    rngctx->iBuffer = rngctx->cBuffer = rngctx->cNextBatch = 0;
 
     switch (rngx) {
     case RNG_FILE:
@@ -615,6 +727,13 @@ CloseRNG(const rng rngx, rngcontext * rngctx)
         CloseDiceFile(rngctx);
         break;
 
+#if defined(LIBCURL_PROTOCOL_HTTPS)
+    case RNG_RANDOM_DOT_ORG:
+        /* stop fetching dice */
+        CloseRandomDotOrg();
+        break;
+#endif
+
     default:
         /* no-op */
         ;
@@ -765,6 +884,15 @@ RollDice(unsigned int anDice[2], rng * prng, rngcontext * rngctx)
     const unsigned long exp232_q = 715827882;
     const unsigned long exp232_l = 4294967292U;
 
+    if (rngctx->iBuffer < rngctx->cBuffer) {
+        /* keep the sequence of rolls the same as without the buffer */
+        anDice[0] = rngctx->aanBuffer[rngctx->iBuffer][0];
+        anDice[1] = rngctx->aanBuffer[rngctx->iBuffer][1];
+        rngctx->iBuffer++;
+        rngctx->c += 2;
+        return 0;
+    }
+
     anDice[0] = anDice[1] = 0;
 
     switch (*prng) {
@@ -823,6 +951,14 @@ RollDice(unsigned int anDice[2], rng * prng, rngcontext * rngctx)
         rngctx->c += 2;
         break;
 
+    case RNG_PHILOX:
+        while ((tmprnd = PhiloxNext(rngctx)) >= exp232_l);
+        anDice[0] = 1 + (unsigned int) (tmprnd / exp232_q);
+        while ((tmprnd = PhiloxNext(rngctx)) >= exp232_l);
+        anDice[1] = 1 + (unsigned int) (tmprnd / exp232_q);
+        rngctx->c += 2;
+        break;
+
     case RNG_RANDOM_DOT_ORG:
 #if defined(LIBCURL_PROTOCOL_HTTPS)
         anDice[0] = getDiceRandomDotOrg();
@@ -853,44 +989,171 @@ RollDice(unsigned int anDice[2], rng * prng, rngcontext * rngctx)
     return 0;
 }
 
-extern FILE *
+/* Generate n rolls of the generator rngx into aanDice, the same ones n
+ * calls of RollDice() would give but without the dispatch for each
+ * roll.  The counter isn't changed.  Returns -1, generating nothing,
+ * for the generators that can't be drawn ahead: manual dice, dice read
+ * from a file or random.org, and BBS, which checks its seed on each
+ * roll. */
+extern int
+RollDiceBatch(rngcontext * rngctx, rng rngx, unsigned int n, unsigned char aanDice[][2])
+{
+    const unsigned long exp232_q = 715827882;
+    const unsigned long exp232_l = 4294967292U;
+    unsigned int i, j;
+    unsigned long r;
+
+    switch (rngx) {
+
+    case RNG_ISAAC:
+        for (i = 0; i < n; i++)
+            for (j = 0; j < 2; j++) {
+                while ((r = irand(&rngctx->rc)) >= exp232_l);
+                aanDice[i][j] = (unsigned char) (1 + r / exp232_q);
+            }
+        return 0;
+
+    case RNG_MERSENNE:
+        /* sfmt_genrand_uint32() refills the state a whole block at a
+         * time with the SIMD code of SFMT, leaving this loop the
+         * rejections and divisions */
+        for (i = 0; i < n; i++)
+            for (j = 0; j < 2; j++) {
+                while ((r = sfmt_genrand_uint32(&rngctx->sfmt)) >= exp232_l);
+                aanDice[i][j] = (unsigned char) (1 + r / exp232_q);
+            }
+        return 0;
+
+    case RNG_PHILOX:
+        for (i = 0; i < n; i++)
+            for (j = 0; j < 2; j++) {
+                while ((r = PhiloxNext(rngctx)) >= exp232_l);
+                aanDice[i][j] = (unsigned char) (1 + r / exp232_q);
+            }
+        return 0;
+
+    case RNG_MD5:
+        for (i = 0; i < n; i++) {
+            union _hash {
+                char ach[16];
+                md5_uint32 an[2];
+            } h;
+
+            md5_buffer((char *) &rngctx->nMD5, sizeof rngctx->nMD5, &h);
+            while (h.an[0] >= exp232_l || h.an[1] >= exp232_l) {
+                md5_buffer((char *) &rngctx->nMD5, sizeof rngctx->nMD5, &h);
+                rngctx->nMD5++;
+            }
+
+            aanDice[i][0] = (unsigned char) (h.an[0] / exp232_q + 1);
+            aanDice[i][1] = (unsigned char) (h.an[1] / exp232_q + 1);
+
+            rngctx->nMD5++;
+        }
+        return 0;
+
+    default:
+        return -1;
+
+    }
+}
+
+/* RollDice() drawing the rolls DICE_BUFFER or fewer at a time with
+ * RollDiceBatch().  The rolls are the same as RollDice() would give.
+ * As rollouts seed the generator for each game, the batches start
+ * small after seeding and double, so that short games don't pay for
+ * rolls they never use. */
+extern int
+RollDiceBuffered(unsigned int anDice[2], rng * prng, rngcontext * rngctx)
+{
+    if (rngctx->iBuffer == rngctx->cBuffer) {
+        unsigned int n = rngctx->cNextBatch ? rngctx->cNextBatch : 8;
+
+        if (RollDiceBatch(rngctx, *prng, n, rngctx->aanBuffer))
+            return RollDice(anDice, prng, rngctx);
+
+        rngctx->iBuffer = 0;
+        rngctx->cBuffer = n;
+        rngctx->cNextBatch = MIN(2 * n, DICE_BUFFER);
+    }
+
+    return RollDice(anDice, prng, rngctx);
+}
+
+/* Dice files are read through a memory map.  They are either text,
+ * of which the digits 1 to 6 are the dice and everything else is
+ * skipped, or packed: DICEFILE_MAGIC followed by a byte 6 * (die0 - 1)
+ * + die1 - 1 for each roll.  Both start over at the end. */
+
+#define DICEFILE_MAGIC "gnubgdc"
+
+extern int
 OpenDiceFile(rngcontext * rngctx, const char *sz)
 {
     g_free(rngctx->szDiceFilename);     /* initialized to NULL */
     rngctx->szDiceFilename = g_strdup(sz);
 
-    return (rngctx->fDice = g_fopen(sz, "r"));
+    CloseDiceFile(rngctx);
+
+    if ((rngctx->pmfDice = g_mapped_file_new(sz, FALSE, NULL)) == NULL)
+        return -1;
+
+    rngctx->puchDice = (const unsigned char *) g_mapped_file_get_contents(rngctx->pmfDice);
+    rngctx->cbDice = g_mapped_file_get_length(rngctx->pmfDice);
+    rngctx->iDice = 0;
+    rngctx->fPackedDice = rngctx->cbDice >= sizeof(DICEFILE_MAGIC)
+        && !memcmp(rngctx->puchDice, DICEFILE_MAGIC, sizeof(DICEFILE_MAGIC));
+
+    if (rngctx->fPackedDice) {
+        rngctx->puchDice += sizeof(DICEFILE_MAGIC);
+        rngctx->cbDice -= sizeof(DICEFILE_MAGIC);
+    }
+
+    return 0;
 }
 
 static unsigned int
 ReadDiceFile(rngcontext * rngctx)
 {
+    int fRewound = FALSE;
 
-    unsigned char uch;
-    size_t n;
-
-    if (rngctx->fDice == NULL)
+    if (rngctx->pmfDice == NULL)
         return (unsigned int) (-1);
 
-  uglyloop:
-    {
+    for (;;) {
+
+        if (rngctx->fPackedDice) {
+            /* iDice counts dice, two to a byte */
+            while (rngctx->iDice < 2 * rngctx->cbDice) {
+                unsigned int n = rngctx->puchDice[rngctx->iDice / 2];
 
-        n = fread(&uch, 1, 1, rngctx->fDice);
+                if (n < 36)
+                    return (rngctx->iDice++ & 1) ? n % 6 + 1 : n / 6 + 1;
 
-        if (feof(rngctx->fDice)) {
-            /* end of file */
-            g_print(_("Rewinding dice file (%s)"), rngctx->szDiceFilename);
-            g_printf("\n");
-            fseek(rngctx->fDice, 0, SEEK_SET);
-        } else if (n != 1) {
+                /* skip the roll */
+                rngctx->iDice = (rngctx->iDice | 1) + 1;
+            }
+        } else {
+            while (rngctx->iDice < rngctx->cbDice) {
+                unsigned char uch = rngctx->puchDice[rngctx->iDice++];
+
+                if (uch >= '1' && uch <= '6')
+                    return (uch - '0');
+            }
+        }
+
+        if (fRewound) {
+            /* not a single die in it */
             g_printerr("%s", rngctx->szDiceFilename);
             return (unsigned int) (-1);
-        } else if (uch >= '1' && uch <= '6')
-            return (uch - '0');
+        }
 
+        /* end of file */
+        g_print(_("Rewinding dice file (%s)"), rngctx->szDiceFilename);
+        g_printf("\n");
+        rngctx->iDice = 0;
+        fRewound = TRUE;
     }
-    goto uglyloop;              /* This logic should be reconsidered */
-
 }
 
 extern char *
@@ -24,13 +24,16 @@
 #include <stdio.h>
 
 typedef enum {
-    RNG_BBS, RNG_ISAAC, RNG_MD5, RNG_MERSENNE,
+    RNG_BBS, RNG_ISAAC, RNG_MD5, RNG_MERSENNE, RNG_PHILOX,
     RNG_MANUAL, RNG_RANDOM_DOT_ORG, RNG_FILE,
     NUM_RNGS
 } rng;
 
 typedef struct rngcontext rngcontext;
 
+/* most rolls RollDiceBuffered() draws at a time */
+#define DICE_BUFFER 64
+
 extern const char *aszRNG[NUM_RNGS];
 extern const char *aszRNGTip[NUM_RNGS];
 extern char szDiceFilename[];
@@ -46,9 +49,12 @@ extern void DestroyRNG(const rng rngx, rngcontext ** rngctx);
 extern void PrintRNGSeed(const rng rngx, rngcontext * rngctx);
 extern void PrintRNGCounter(const rng rngx, rngcontext * rngctx);
 extern void InitRNGSeed(unsigned int n, const rng rngx, rngcontext * rngctx);
+extern void InitRNGSeedTrial(unsigned int nSeed, unsigned int iTrial, const rng rngx, rngcontext * rngctx);
 extern int RNGSystemSeed(const rng rngx, void *p, unsigned long *pnSeed);
 
 extern int RollDice(unsigned int anDice[2], rng * prng, rngcontext * rngctx);
+extern int RollDiceBatch(rngcontext * rngctx, rng rngx, unsigned int n, unsigned char aanDice[][2]);
+extern int RollDiceBuffered(unsigned int anDice[2], rng * prng, rngcontext * rngctx);
 
 #if defined(HAVE_LIBGMP)
 extern int InitRNGSeedLong(char *sz, rng rng, rngcontext * rngctx);
@@ -56,7 +62,7 @@ extern int InitRNGBBSModulus(const char *sz, rngcontext * rngctx);
 extern int InitRNGBBSFactors(char *sz0, char *sz1, rngcontext * rngctx);
 #endif
 
-extern FILE *OpenDiceFile(rngcontext * rngctx, const char *sz);
+extern int OpenDiceFile(rngcontext * rngctx, const char *sz);
 
 extern char *GetDiceFileName(rngcontext * rngctx);
 
@@ -23,7 +23,11 @@
 #include <locale.h>
 #include <string.h>
 #include <errno.h>
+#include <float.h>
 #include <stdlib.h>
+#if defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
 #include "isaac.h"
 #include "md5.h"
 #include "bearoffgammon.h"
@@ -34,7 +38,16 @@
 #include "simd.h"
 #include "multithread.h"
 #include "util.h"
+#include "memusage.h"
+#include "profile.h"
 #include "lib/simd.h"
+#if defined(USE_SIMD_INSTRUCTIONS)
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#elif defined(USE_SSE2) || defined(USE_AVX)
+#include <emmintrin.h>
+#endif
+#endif
 
 typedef void (*classstatusfunc) (char *szOutput);
 typedef int (*cfunc) (const void *, const void *);
@@ -193,24 +206,40 @@ enum {
 #define NUM_RACE_INPUTS ( HALF_RACE_INPUTS * 2 )
 #define NUM_PRUNING_INPUTS (25 * MINPPERPOINT * 2)
 
+/* The cache statistics of one thread, padded to whole cache lines */
+typedef union {
+    evalcachestats ecs;
+    char ach[(sizeof(evalcachestats) + 63) & ~(size_t) 63];
+} threadcachestats;
+
+#define CACHESTATS_PLY(n) MIN((n), CACHESTATS_PLIES - 1)
 
 #if !defined(LOCKING_VERSION)
 
 f_FindnSaveBestMoves FindnSaveBestMoves = FindnSaveBestMovesNoLocking;
+f_FindnSaveBestMovesStaged FindnSaveBestMovesStaged = FindnSaveBestMovesStagedNoLocking;
 f_FindBestMove FindBestMove = FindBestMoveNoLocking;
 f_EvaluatePosition EvaluatePosition = EvaluatePositionNoLocking;
 f_ScoreMove ScoreMove = ScoreMoveNoLocking;
 f_GeneralCubeDecisionE GeneralCubeDecisionE = GeneralCubeDecisionENoLocking;
+f_GeneralCubeDecisionScores GeneralCubeDecisionScores = GeneralCubeDecisionScoresNoLocking;
+f_GeneralCubeDecisionEPlies GeneralCubeDecisionEPlies = GeneralCubeDecisionEPliesNoLocking;
 f_GeneralEvaluationE GeneralEvaluationE = GeneralEvaluationENoLocking;
+f_PrefetchMoves PrefetchMoves = PrefetchMovesNoLocking;
 
 #define FindnSaveBestMoves FindnSaveBestMovesNoLocking
+#define FindnSaveBestMovesStaged FindnSaveBestMovesStagedNoLocking
 #define FindBestMove FindBestMoveNoLocking
 #define EvaluatePosition EvaluatePositionNoLocking
 #define ScoreMove ScoreMoveNoLocking
 #define GeneralCubeDecisionE GeneralCubeDecisionENoLocking
+#define GeneralCubeDecisionScores GeneralCubeDecisionScoresNoLocking
+#define GeneralCubeDecisionEPlies GeneralCubeDecisionEPliesNoLocking
 #define GeneralEvaluationE GeneralEvaluationENoLocking
+#define PrefetchMoves PrefetchMovesNoLocking
 #define EvaluatePositionCache EvaluatePositionCacheNoLocking
 #define FindBestMovePlied FindBestMovePliedNoLocking
+#define FindnKeepBestMoves FindnKeepBestMovesNoLocking
 #define GeneralEvaluationEPlied GeneralEvaluationEPliedNoLocking
 #define EvaluatePositionCubeful3 EvaluatePositionCubeful3NoLocking
 #define ScoreMoves ScoreMovesNoLocking
@@ -218,6 +247,7 @@ f_GeneralEvaluationE GeneralEvaluationE = GeneralEvaluationENoLocking;
 #define FindBestMoveInEval FindBestMoveInEvalNoLocking
 #define GeneralEvaluationEPliedCubeful GeneralEvaluationEPliedCubefulNoLocking
 #define EvaluatePositionCubeful4 EvaluatePositionCubeful4NoLocking
+#define EvaluatePositionCubefulPlies EvaluatePositionCubefulPliesNoLocking
 #define CacheAdd CacheAddNoLocking
 #define CacheLookup CacheLookupNoLocking
 
@@ -227,6 +257,10 @@ static int EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, flo
 static int FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
                              TanBoard anBoard, const cubeinfo * pci,
                              const evalcontext * pec, int nPlies, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
+static int FindnKeepBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoard, positionkey * keyMove,
+                              const float rThr, const cubeinfo * pci, const evalcontext * pec,
+                              movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], int fScratch,
+                              movestagefunc pfStage, void *pStage);
 
 static int anEscapes[0x1000];
 static int anEscapes1[0x1000];
@@ -237,15 +271,74 @@ neuralnet nnContact, nnRace, nnCrashed;
 
 neuralnet nnpContact, nnpRace, nnpCrashed;
 
+/* Hidden layer activation of all nets, see sigmoid_fast() */
+static int fFastSigmoid = FALSE;
+
+/* Evaluator of large batches of race, crashed and contact positions,
+ * or NULL for the built in one */
+static const nnbackend *pnbBackend = NULL;
+
+/* The nets of a weight set, in the order of the weights files */
+enum { WN_CONTACT, WN_RACE, WN_CRASHED, WN_PCONTACT, WN_PCRASHED, WN_PRACE, N_WEIGHT_NETS };
+
+/* The weight sets, see EvalLoadWeights().  Set 0 is the nets above and
+ * the only one with fixed point copies and the backend; the nets of
+ * the others are float only. */
+typedef struct {
+    const char *szName;         /* NULL if the set is not loaded */
+    neuralnet *apnn[N_WEIGHT_NETS];
+    GMappedFile *pmf;           /* mapping the nets point into, if any */
+} weightset;
+
+static weightset aws[MAX_WEIGHT_SETS] = {
+    {"gnubg", {&nnContact, &nnRace, &nnCrashed, &nnpContact, &nnpCrashed, &nnpRace}, NULL}
+};
+
 bearoffcontext *pbcOS = NULL;
 bearoffcontext *pbcTS = NULL;
 bearoffcontext *pbc1 = NULL;
 bearoffcontext *pbc2 = NULL;
 bearoffcontext *apbcHyper[3] = { NULL, NULL, NULL };
+char *szBearoffShared = NULL;
+int fLazyBearoff = FALSE;
+
+/* pbcTS and apbcHyper[] are read by GetBearoffTS() and GetBearoffHyper(),
+ * at EvalInitialise() or, with fLazyBearoff, when first asked for */
+static int fBearoffFiles;
+static GOnce onceTS = G_ONCE_INIT;
+static GOnce aonceHyper[3] = { G_ONCE_INIT, G_ONCE_INIT, G_ONCE_INIT };
 
 evalCache cEval;
 evalCache cpEval;
+/* the cubeful equities of positions evaluated with sets of cube
+ * positions, see EvaluatePositionCubeful3() */
+cubefulCache ccEval;
 unsigned int cCache;
+/* number of flushes of cEval, the per-thread caches are cleared when
+ * they see it change */
+int nCacheFlush;
+static void CacheFileWrite(void);
+
+/* Cache statistics, counted when fCacheStats in a copy per thread (of
+ * index id + 1, the main thread has id -1) so that the lookups write
+ * nothing shared. */
+int fCacheStats = FALSE;
+threadcachestats aCacheStats[MAX_NUMTHREADS + 1];
+
+/* Carry fewer moves to the next ply of FindnSaveBestMoves() when the
+ * scores show a clear break, and stop deepening a move decision after
+ * rFilterBudget seconds (if > 0) */
+int fAdaptiveFilter = FALSE;
+double rFilterBudget = 0.0;
+/* Stop scoring the moves of a ply once the ones left, in the order of
+ * the ply before, trail the best by more than rEarlyExit (if > 0) even
+ * with the largest gain seen so far */
+float rEarlyExit = 0.0f;
+/* Score race positions with RaceApprox() instead of the nets where a
+ * rough evaluation does: the pruning of race moves and the truncation
+ * of cubeless rollouts */
+int fRaceApprox = FALSE;
+
 int fInterrupt = FALSE;
 int fMatchCancelled = FALSE;
 
@@ -412,18 +505,34 @@ ComputeTable0(void)
     }
 }
 
-static int
-Escapes(const unsigned int anBoard[25], int n)
+/* Bit i of the result is set if point i of anBoard is made; Escapes()
+ * and Escapes1() look up their tables from it with shifts instead of
+ * testing the points one by one */
+static inline unsigned int
+MadePoints(const unsigned int anBoard[25])
 {
+    unsigned int i, nMade = 0;
+
+    for (i = 0; i < 25; i++)
+        nMade |= (unsigned int) anPoint[anBoard[i]] << i;
 
-    int i, af = 0, m;
+    return nMade;
+}
 
-    m = (n < 12) ? n : 12;
+/* Points 24 - n to 24 - n + m - 1 of the board of nMade, m = MIN(n, 12) */
+static inline unsigned int
+EscapeMask(unsigned int nMade, int n)
+{
+    if (n <= 0)
+        return 0;
 
-    for (i = 0; i < m; i++)
-        af |= (anPoint[anBoard[24 + i - n]] << i);
+    return (nMade >> (24 - n)) & ((1u << MIN(n, 12)) - 1);
+}
 
-    return anEscapes[af];
+static inline int
+Escapes(unsigned int nMade, int n)
+{
+    return anEscapes[EscapeMask(nMade, n)];
 }
 
 static void
@@ -453,38 +562,115 @@ ComputeTable1(void)
     }
 }
 
+static inline int
+Escapes1(unsigned int nMade, int n)
+{
+    return anEscapes1[EscapeMask(nMade, n)];
+}
+
+
+static void
+ComputeTable(void)
+{
+    ComputeTable0();
+    ComputeTable1();
+}
+
+/* Point the nets of a weight set into a read-only mapping of szFile,
+ * stored in *ppmf */
 static int
-Escapes1(const unsigned int anBoard[25], int n)
+MapWeights(const char *szFile, neuralnet * const apnn[N_WEIGHT_NETS], GMappedFile ** ppmf)
 {
+    GError *error = NULL;
+    GMappedFile *pmf;
 
-    int i, af = 0, m;
+    if (!g_file_test(szFile, G_FILE_TEST_IS_REGULAR))
+        return -1;
 
-    m = (n < 12) ? n : 12;
+    if ((pmf = g_mapped_file_new(szFile, FALSE, &error)) == NULL) {
+        g_print(_("couldn't open %s"), szFile);
+        g_print(": %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
 
-    for (i = 0; i < m; i++)
-        af |= (anPoint[anBoard[24 + i - n]] << i);
+    if (NeuralNetMapped(g_mapped_file_get_contents(pmf), g_mapped_file_get_length(pmf), WEIGHTS_VERSION,
+                        apnn, N_WEIGHT_NETS)) {
+        g_print(_("%s is not a weights file"), szFile);
+        g_print("\n");
+        g_mapped_file_unref(pmf);
+        return -1;
+    }
 
-    return anEscapes1[af];
+    *ppmf = pmf;
+    return 0;
 }
 
-
 static void
-ComputeTable(void)
+DestroyWeightSet(weightset * pws)
 {
-    ComputeTable0();
-    ComputeTable1();
+    unsigned int i;
+
+    for (i = 0; i < N_WEIGHT_NETS; i++)
+        NeuralNetDestroy(pws->apnn[i]);
+
+    if (pws->pmf) {
+        g_mapped_file_unref(pws->pmf);
+        pws->pmf = NULL;
+    }
 }
 
 static void
 DestroyWeights(void)
 {
-    NeuralNetDestroy(&nnContact);
-    NeuralNetDestroy(&nnCrashed);
-    NeuralNetDestroy(&nnRace);
+    unsigned int i;
+
+    DestroyWeightSet(&aws[0]);
+
+    /* the nets of the loaded sets are allocated together */
+    for (i = 1; i < MAX_WEIGHT_SETS; i++)
+        if (aws[i].szName) {
+            DestroyWeightSet(&aws[i]);
+            g_free(aws[i].apnn[0]);
+            g_free((char *) aws[i].szName);
+            aws[i].szName = NULL;
+        }
+}
+
+static gsize
+NetMemory(const neuralnet * pnn)
+{
+    gsize c;
+
+    if (!pnn->arHiddenWeight)
+        return 0;
+
+    c = pnn->cInput * pnn->cHidden + pnn->cHidden * pnn->cOutput + pnn->cHidden + pnn->cOutput;
+
+    return c * sizeof(float);
+}
+
+/* Bring MEM_CACHE and MEM_WEIGHTS up to date with the caches and nets
+ * there are now */
+static void
+EvalAccountMemory(void)
+{
+    static gsize cbCache, cbWeights;
+    unsigned int i, j;
+    gsize cb;
+
+    cb = (cEval.entries ? CacheMemory(cEval.size) : 0) + (cpEval.entries ? CacheMemory(cpEval.size) : 0)
+        + (ccEval.entries ? (ccEval.hashMask + 1) * sizeof(cubefulCacheEntry) : 0);
+    MemAccount(MEM_CACHE, (gssize) cb - (gssize) cbCache);
+    cbCache = cb;
 
-    NeuralNetDestroy(&nnpContact);
-    NeuralNetDestroy(&nnpCrashed);
-    NeuralNetDestroy(&nnpRace);
+    cb = 0;
+    for (i = 0; i < MAX_WEIGHT_SETS; i++)
+        if (aws[i].szName)
+            for (j = 0; j < N_WEIGHT_NETS; j++)
+                cb += NetMemory(aws[i].apnn[j]);
+    MemAccount(MEM_WEIGHTS, (gssize) cb - (gssize) cbWeights);
+    cbWeights = cb;
 }
 
 extern int
@@ -502,6 +688,11 @@ EvalShutdown(void)
     for (i = 0; i < 3; ++i)
         BearoffClose(apbcHyper[i]);
 
+    /* save the cache while the weights it belongs to are there */
+
+    CacheFileWrite();
+    EvalSetCacheFile(NULL);
+
     /* destroy neural nets */
 
     DestroyWeights();
@@ -510,11 +701,73 @@ EvalShutdown(void)
 
     CacheDestroy(&cEval);
     CacheDestroy(&cpEval);
+    CubefulCacheDestroy(&ccEval);
+    cEval.entries = cpEval.entries = NULL;
+    ccEval.entries = NULL;
+
+    EvalAccountMemory();
 
     return 0;
 
 }
 
+static gpointer
+LoadBearoffTS(gpointer UNUSED(p))
+{
+    guint64 t = get_time_ns();
+    char *sz;
+
+    if (!fBearoffFiles)
+        return NULL;
+
+    sz = BuildFilename("gnubg_ts.bd");
+    pbcTS = BearoffInit(sz, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED | (szBearoffShared ? BO_POPULATE : 0), NULL);
+    g_free(sz);
+
+    if (fLazyBearoff)
+        ProfileStartup(N_("Two-sided bearoff database"), get_time_ns() - t, TRUE);
+
+    return pbcTS;
+}
+
+static gpointer
+LoadBearoffHyper(gpointer p)
+{
+    static const char *aszHyper[3] = {
+        N_("Hypergammon-1 database"), N_("Hypergammon-2 database"), N_("Hypergammon-3 database")
+    };
+    unsigned int i = GPOINTER_TO_UINT(p);
+    guint64 t = get_time_ns();
+    char sz[10], *pch;
+
+    if (!fBearoffFiles)
+        return NULL;
+
+    sprintf(sz, "hyper%c.bd", i + '1');
+    pch = BuildFilename(sz);
+    apbcHyper[i] = BearoffInit(pch, BO_IN_MEMORY | (szBearoffShared ? BO_POPULATE : 0), NULL);
+    g_free(pch);
+
+    if (fLazyBearoff)
+        ProfileStartup(aszHyper[i], get_time_ns() - t, TRUE);
+
+    return apbcHyper[i];
+}
+
+/* The large two-sided bearoff database, or NULL if there is none */
+extern bearoffcontext *
+GetBearoffTS(void)
+{
+    return (bearoffcontext *) g_once(&onceTS, LoadBearoffTS, NULL);
+}
+
+/* The database of hypergammon with i + 1 chequers, or NULL */
+extern bearoffcontext *
+GetBearoffHyper(unsigned int i)
+{
+    return (bearoffcontext *) g_once(&aonceHyper[i], LoadBearoffHyper, GUINT_TO_POINTER(i));
+}
+
 static int
 binary_weights_failed(char *filename, FILE * weights)
 {
@@ -575,6 +828,8 @@ weights_failed(char *filename, FILE * weights)
     return 0;
 }
 
+static void InitRaceRolls(void);
+
 extern void
 EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pfProgress) (unsigned int))
 {
@@ -628,7 +883,13 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
             return;
         }
 
+        if (CubefulCacheCreate(&ccEval, 0x1 << 16)) {
+            PrintError(_("Evaluation cache allocation failed"));
+            return;
+        }
+
         ComputeTable();
+        InitRaceRolls();
 
         rc.randrsl[0] = (ub4) time(NULL);
         for (i = 0; i < RANDSIZ; i++)
@@ -641,18 +902,19 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
     if (!fNoBearoff) {
         char *gnubg_bearoff;
         char *gnubg_bearoff_os;
+        const unsigned int boShared = szBearoffShared ? BO_POPULATE : 0;
 
         gnubg_bearoff_os = BuildFilename("gnubg_os0.bd");
         if (!pbc1)
-            pbc1 = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
+            pbc1 = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED | boShared, NULL);
         g_free(gnubg_bearoff_os);
 
         if (!pbc1)
-            pbc1 = BearoffInit(NULL, BO_HEURISTIC, pfProgress);
+            pbc1 = BearoffInit(szBearoffShared, BO_HEURISTIC | boShared, pfProgress);
 
         /* read two-sided db from gnubg.bd */
         gnubg_bearoff = BuildFilename("gnubg_ts0.bd");
-        pbc2 = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
+        pbc2 = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED | boShared, NULL);
         g_free(gnubg_bearoff);
 
         if (!pbc2)
@@ -666,28 +928,30 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
 
         gnubg_bearoff_os = BuildFilename("gnubg_os.bd");
         /* init one-sided db */
-        pbcOS = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
+        pbcOS = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED | boShared, NULL);
         g_free(gnubg_bearoff_os);
 
-        gnubg_bearoff = BuildFilename("gnubg_ts.bd");
-        /* init two-sided db */
-        pbcTS = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
-        g_free(gnubg_bearoff);
-
-        /* hyper-gammon databases */
+        /* the large two-sided db and the hyper-gammon databases */
 
-        for (i = 0; i < 3; ++i) {
-            char *fn;
-            char sz[10];
-            sprintf(sz, "hyper%c.bd", i + '1');
-            fn = BuildFilename(sz);
-            apbcHyper[i] = BearoffInit(fn, BO_IN_MEMORY, NULL);
-            g_free(fn);
+        fBearoffFiles = TRUE;
+        if (!fLazyBearoff) {
+            GetBearoffTS();
+            for (i = 0; i < 3; ++i)
+                GetBearoffHyper((unsigned int) i);
         }
 
     }
 
-    if (szWeightsBinary) {
+    {
+        /* the mappable weights, shared in the page cache by all the
+         * processes using them, are tried first */
+        char *szWeightsMapped = BuildFilename("gnubg.wm");
+
+        fReadWeights = !MapWeights(szWeightsMapped, aws[0].apnn, &aws[0].pmf);
+        g_free(szWeightsMapped);
+    }
+
+    if (!fReadWeights && szWeightsBinary) {
         pfWeights = g_fopen(szWeightsBinary, "rb");
         if (!binary_weights_failed(szWeightsBinary, pfWeights)) {
             if (!fReadWeights && !(fReadWeights =
@@ -739,14 +1003,192 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
         exit(EXIT_FAILURE);
     }
 
+    EvalSetFastSigmoid(fFastSigmoid);
+
+    EvalAccountMemory();
+}
+
+/* Read the nets of a weight set from szFile, in any of the formats
+ * EvalInitialise() reads */
+static int
+ReadWeightSet(const char *szFile, neuralnet * const apnn[N_WEIGHT_NETS], GMappedFile ** ppmf)
+{
+    char sz[sizeof(NN_MAPPED_MAGIC)];
+    FILE *pf;
+    float r;
+    size_t cb;
+    unsigned int i;
+    int fRead = FALSE;
+
+    if ((pf = g_fopen(szFile, "rb")) == NULL) {
+        g_print(_("couldn't open %s"), szFile);
+        g_print("\n");
+        return -1;
+    }
+
+    cb = fread(sz, 1, sizeof(sz), pf);
+    memcpy(&r, sz, sizeof(r));
+
+    if (cb == sizeof(sz) && !memcmp(sz, NN_MAPPED_MAGIC, sizeof(sz))) {
+        fclose(pf);
+        return MapWeights(szFile, apnn, ppmf);
+    }
+
+    if (cb >= sizeof(r) && r == WEIGHTS_MAGIC_BINARY) {
+        rewind(pf);
+        if (!binary_weights_failed((char *) szFile, pf)) {
+            for (fRead = TRUE, i = 0; fRead && i < N_WEIGHT_NETS; i++)
+                fRead = !NeuralNetLoadBinary(apnn[i], pf);
+            if (!fRead)
+                perror(szFile);
+        }
+        fclose(pf);
+    } else {
+        fclose(pf);
+        pf = g_fopen(szFile, "r");
+        if (!weights_failed((char *) szFile, pf)) {
+            setlocale(LC_ALL, "C");
+            for (fRead = TRUE, i = 0; fRead && i < N_WEIGHT_NETS; i++)
+                fRead = !NeuralNetLoad(apnn[i], pf);
+            setlocale(LC_ALL, "");
+            if (!fRead)
+                perror(szFile);
+        }
+        if (pf)
+            fclose(pf);
+    }
+
+    return fRead ? 0 : -1;
+}
+
+/* Load the weights in szFile as the weight set szName, replacing the
+ * set of that name if there is one.  The nets must have the sizes of
+ * those of set 0, whose incremental evaluation buffers they share.
+ * A replaced set is freed and the cache may be flushed, so no thread
+ * may be evaluating meanwhile, see MT_WaitIdle().  Returns the number
+ * of the set, or -1. */
+extern int
+EvalLoadWeights(const char *szName, const char *szFile)
+{
+    weightset ws = { NULL, {NULL}, NULL };
+    neuralnet *ann;
+    int iWeights, fFlush = FALSE;
+    unsigned int i;
+
+    if ((iWeights = EvalFindWeights(szName)) == 0) {
+        outputerrf(_("The weights `%s' can't be replaced."), szName);
+        return -1;
+    }
+
+    if (iWeights < 0) {
+        for (iWeights = 1; iWeights < MAX_WEIGHT_SETS && aws[iWeights].szName; iWeights++);
+        if (iWeights == MAX_WEIGHT_SETS) {
+            outputerrf(_("No more than %d weight sets can be loaded."), MAX_WEIGHT_SETS);
+            return -1;
+        }
+    }
+
+    ann = g_new0(neuralnet, N_WEIGHT_NETS);
+    for (i = 0; i < N_WEIGHT_NETS; i++)
+        ws.apnn[i] = ann + i;
+
+    if (ReadWeightSet(szFile, ws.apnn, &ws.pmf)) {
+        DestroyWeightSet(&ws);
+        g_free(ann);
+        return -1;
+    }
+
+    for (i = 0; i < N_WEIGHT_NETS; i++)
+        if (ann[i].cInput != aws[0].apnn[i]->cInput || ann[i].cHidden != aws[0].apnn[i]->cHidden
+            || ann[i].cOutput != aws[0].apnn[i]->cOutput) {
+            outputerrf(_("The nets in %s don't have the sizes of the ones gnubg uses."), szFile);
+            DestroyWeightSet(&ws);
+            g_free(ann);
+            return -1;
+        }
+
+    for (i = 0; i < N_WEIGHT_NETS; i++)
+        ann[i].fFastSigmoid = fFastSigmoid;
+
+    if (aws[iWeights].szName) {
+        ws.szName = aws[iWeights].szName;
+        DestroyWeightSet(&aws[iWeights]);
+        g_free(aws[iWeights].apnn[0]);
+        fFlush = TRUE;
+    } else
+        ws.szName = g_strdup(szName);
+
+    aws[iWeights] = ws;
+    EvalAccountMemory();
+
+    /* the cache has evaluations of the old set under this number, and
+     * a shared one must be that of the weights loaded */
+    if (fFlush || cEval.szShared)
+        EvalCacheFlush();
+
+    return iWeights;
+}
+
+/* The number of the weight set szName, or -1 if none is loaded */
+extern int
+EvalFindWeights(const char *szName)
+{
+    int i;
+
+    for (i = 0; i < MAX_WEIGHT_SETS; i++)
+        if (aws[i].szName && !strcmp(aws[i].szName, szName))
+            return i;
+
+    return -1;
+}
+
+/* The name of weight set iWeights, or NULL if it is not loaded */
+extern const char *
+EvalWeightsName(unsigned int iWeights)
+{
+    return iWeights < MAX_WEIGHT_SETS ? aws[iWeights].szName : NULL;
+}
+
+/* Evaluate with weight set iWeights on this thread from now on, or
+ * with set 0 if it is not loaded.  The incremental states of the nets
+ * were computed with the previous set, so they are started again. */
+extern void
+EvalUseWeights(unsigned int iWeights)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    int i;
+
+    if (iWeights >= MAX_WEIGHT_SETS || !aws[iWeights].szName)
+        iWeights = 0;
+
+    if (iWeights == ptld->iWeights)
+        return;
+
+    ptld->iWeights = iWeights;
+    for (i = 0; i < 3; i++)
+        if (ptld->pnnState[i].state == NNSTATE_DONE)
+            ptld->pnnState[i].state = NNSTATE_INCREMENTAL;
+}
+
+/* The pruning net of class pc (CLASS_RACE to CLASS_CONTACT) of weight
+ * set iWeights */
+extern const neuralnet *
+EvalPruningNet(unsigned int iWeights, positionclass pc)
+{
+    static const int aiNet[] = { WN_PRACE, WN_PCRASHED, WN_PCONTACT };
+
+    return aws[iWeights].apnn[aiNet[pc - CLASS_RACE]];
 }
 
-/* Calculates inputs for any contact position, for one player only. */
+/* Calculates inputs for any contact position, for one player only.
+ * nMade and nMadeOpp are the MadePoints() of the two boards. */
 
 static void
-CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOpp[25], float afInput[])
+CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOpp[25], unsigned int nMade,
+                    unsigned int nMadeOpp, float afInput[])
 {
     int i, j, k, l, nOppBack, n, aHit[39], nBoard;
+    unsigned int nHitters = 0, nMadeRev = 0, nBeyond, nShots = 0;
 
     /* aanCombination[n] -
      * How many ways to hit from a distance of n pips.
@@ -1010,52 +1452,61 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
     for (i = (nBoard > 2) ? 23 : 21; i >= 0; i--)
         /* if there's a blot there, then */
 
-        if (unlikely(anBoardOpp[i] == 1))
-            /* for every point beyond */
+        if (unlikely(anBoardOpp[i] == 1)) {
+            if (!nHitters) {
+                /* the points we have a hitter on and are willing to
+                 * hit from, and the opponent's made points seen from
+                 * the blots (bit 23 - p for point p) */
 
-            for (j = 24 - i; j < 25; j++)
-                /* if we have a hitter and are willing to hit */
+                for (j = 0; j < 25; j++)
+                    if (anBoard[j] && !(j < 6 && anBoard[j] == 2))
+                        nHitters |= 1u << j;
 
-                if (anBoard[j] && !(j < 6 && anBoard[j] == 2))
-                    /* for every roll that can hit from that point */
+                for (j = 0; j < 24; j++)
+                    if (nMadeOpp & (1u << j))
+                        nMadeRev |= 1u << (23 - j);
 
-                    for (n = 0; n < 5; n++) {
-                        if (aanCombination[j - 24 + i][n] == -1)
-                            break;
+                if (!nHitters)
+                    break;
+            }
 
-                        /* find the intermediate points required to play */
+            /* for every point beyond with a hitter */
 
-                        pi = aIntermediate + aanCombination[j - 24 + i][n];
+            for (nBeyond = nHitters >> (24 - i); nBeyond; nBeyond ^= 1u << l) {
+                l = msb32((int) nBeyond);
+                j = l + 24 - i;
 
-                        if (pi->fAll) {
-                            /* if nFaces is 1, there are no intermediate points */
+                /* for every roll that can hit from that point */
 
-                            if (pi->nFaces > 1) {
-                                /* all the intermediate points are required */
+                for (n = 0; n < 5 && aanCombination[l][n] >= 0; n++) {
+                    unsigned int nBlock;
 
-                                for (k = 0; k < 3 && pi->anIntermediate[k] > 0; k++)
-                                    if (anBoardOpp[i - pi->anIntermediate[k]] > 1)
-                                        /* point is blocked; look for other hits */
-                                        goto cannot_hit;
-                            }
-                        } else {
-                            /* either of two points are required */
+                    /* find the intermediate points required to play */
 
-                            if (anBoardOpp[i - pi->anIntermediate[0]] > 1 && anBoardOpp[i - pi->anIntermediate[1]] > 1) {
-                                /* both are blocked; look for other hits */
-                                goto cannot_hit;
-                            }
-                        }
+                    pi = aIntermediate + aanCombination[l][n];
 
-                        /* enter this shot as available */
+                    nBlock = ((1u << pi->anIntermediate[0]) | (1u << pi->anIntermediate[1]) |
+                              (1u << pi->anIntermediate[2])) & ~1u;
+                    nBlock <<= 23 - i;
 
-                        aHit[aanCombination[j - 24 + i][n]] |= 1 << j;
-                    cannot_hit:;
-                    }
+                    if (pi->fAll ? (nMadeRev & nBlock) != 0 : (nMadeRev & nBlock) == nBlock)
+                        /* all of them, or both of either two, are blocked;
+                         * look for other hits */
+                        continue;
+
+                    /* enter this shot as available */
+
+                    aHit[aanCombination[l][n]] |= 1 << j;
+                    nShots++;
+                }
+            }
+        }
 
     memset(aRoll, 0, sizeof(aRoll));
 
-    if (!anBoard[24]) {
+    if (!nShots) {
+        /* no roll hits */
+    } else if (!anBoard[24]) {
         /* we're not on the bar; for each roll, */
 
         for (i = 0; i < 21; i++) {
@@ -1257,12 +1708,12 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
         afInput[I_P2] = (float) n2 / 36.0f;
     }
 
-    afInput[I_BACKESCAPES] = (float) Escapes(anBoard, 23 - nOppBack) / 36.0f;
+    afInput[I_BACKESCAPES] = (float) Escapes(nMade, 23 - nOppBack) / 36.0f;
 
-    afInput[I_BACKRESCAPES] = (float) Escapes1(anBoard, 23 - nOppBack) / 36.0f;
+    afInput[I_BACKRESCAPES] = (float) Escapes1(nMade, 23 - nOppBack) / 36.0f;
 
     for (n = 36, i = 15; i < 24 - nOppBack; i++)
-        if ((j = Escapes(anBoard, i)) < n)
+        if ((j = Escapes(nMade, i)) < n)
             n = j;
 
     afInput[I_ACONTAIN] = (float) (36 - n) / 36.0f;
@@ -1275,7 +1726,7 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
     }
 
     for (; i < 24; i++)
-        if ((j = Escapes(anBoard, i)) < n)
+        if ((j = Escapes(nMade, i)) < n)
             n = j;
 
 
@@ -1284,7 +1735,7 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
 
     for (n = 0, i = 6; i < 25; i++)
         if (anBoard[i])
-            n += (i - 5) * anBoard[i] * Escapes(anBoardOpp, i);
+            n += (i - 5) * anBoard[i] * Escapes(nMadeOpp, i);
 
     afInput[I_MOBILITY] = (float) n / 3600.0f;
 
@@ -1540,6 +1991,8 @@ menOffNonCrashed(const unsigned int *anBoard, float *afInput)
 static void
 CalculateContactInputs(const TanBoard anBoard, float arInput[])
 {
+    const unsigned int anMade[2] = { MadePoints(anBoard[0]), MadePoints(anBoard[1]) };
+
     baseInputs(anBoard, arInput);
 
     {
@@ -1548,7 +2001,7 @@ CalculateContactInputs(const TanBoard anBoard, float arInput[])
         /* I accidentally switched sides (0 and 1) when I trained the net */
         menOffNonCrashed(anBoard[0], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[1], anBoard[0], b);
+        CalculateHalfInputs(anBoard[1], anBoard[0], anMade[1], anMade[0], b);
     }
 
     {
@@ -1556,7 +2009,7 @@ CalculateContactInputs(const TanBoard anBoard, float arInput[])
 
         menOffNonCrashed(anBoard[1], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[0], anBoard[1], b);
+        CalculateHalfInputs(anBoard[0], anBoard[1], anMade[0], anMade[1], b);
     }
 }
 
@@ -1565,6 +2018,8 @@ CalculateContactInputs(const TanBoard anBoard, float arInput[])
 static void
 CalculateCrashedInputs(const TanBoard anBoard, float arInput[])
 {
+    const unsigned int anMade[2] = { MadePoints(anBoard[0]), MadePoints(anBoard[1]) };
+
     baseInputs(anBoard, arInput);
 
     {
@@ -1572,7 +2027,7 @@ CalculateCrashedInputs(const TanBoard anBoard, float arInput[])
 
         menOffAll(anBoard[1], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[1], anBoard[0], b);
+        CalculateHalfInputs(anBoard[1], anBoard[0], anMade[1], anMade[0], b);
     }
 
     {
@@ -1580,9 +2035,136 @@ CalculateCrashedInputs(const TanBoard anBoard, float arInput[])
 
         menOffAll(anBoard[0], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[0], anBoard[1], b);
+        CalculateHalfInputs(anBoard[0], anBoard[1], anMade[0], anMade[1], b);
+    }
+}
+
+/* The inputs of the net of class pc (CLASS_RACE, CLASS_CRASHED or
+ * CLASS_CONTACT) for anBoard, for training it */
+extern void
+EvalNetInputs(const TanBoard anBoard, positionclass pc, float arInput[])
+{
+    static void (*const inputfunc[]) (const TanBoard, float[]) = {
+        CalculateRaceInputs, CalculateCrashedInputs, CalculateContactInputs
+    };
+
+    g_assert(pc >= CLASS_RACE && pc <= CLASS_CONTACT);
+    inputfunc[pc - CLASS_RACE] (anBoard, arInput);
+}
+
+/* The number of inputs EvalNetInputs() gives for class pc */
+extern unsigned int
+EvalNetInputCount(positionclass pc)
+{
+    return pc == CLASS_RACE ? NUM_RACE_INPUTS : NUM_INPUTS;
+}
+
+#if defined(USE_SIMD_INSTRUCTIONS)
+/* The input functions above for NeuralNetEvaluateSparse(): the
+ * non-zero inputs only, indices in increasing order in ai[] and values
+ * in ar[], returning their number.  The point inputs, most of them
+ * zero, come from the board directly; the few others are computed as
+ * usual and the non-zero ones appended. */
+
+static unsigned int
+SparseAppend(const float arMore[], unsigned int cMore, unsigned int iFirst, unsigned int ai[], float ar[],
+             unsigned int c)
+{
+    unsigned int i;
+
+    for (i = 0; i < cMore; i++)
+        if (arMore[i] != 0.0f) {
+            ai[c] = iFirst + i;
+            ar[c++] = arMore[i];
+        }
+
+    return c;
+}
+
+static unsigned int
+CalculateRaceInputsSparse(const TanBoard anBoard, unsigned int ai[], float ar[])
+{
+    unsigned int side, c = 0;
+
+    for (side = 0; side < 2; ++side) {
+        const unsigned int *const board = anBoard[side];
+        const unsigned int iBase = side * HALF_RACE_INPUTS;
+        unsigned int menOff = 15, nCross = 0, i;
+
+        g_assert(board[23] == 0 && board[24] == 0);
+
+        /* Points */
+        for (i = 0; i < 23; ++i) {
+            unsigned int const nc = board[i];
+            unsigned int const k = iBase + i * 4;
+
+            if (!nc)
+                continue;
+
+            menOff -= nc;
+            nCross += nc * (i / 6);
+
+            if (nc < 3) {
+                ai[c] = k + nc - 1;
+                ar[c++] = 1.0f;
+            } else {
+                ai[c] = k + 2;
+                ar[c++] = 1.0f;
+                if (nc > 3) {
+                    ai[c] = k + 3;
+                    ar[c++] = (float) (nc - 3) / 2.0f;
+                }
+            }
+        }
+
+        /* Men off */
+        if (menOff >= 1 && menOff <= 14) {
+            ai[c] = iBase + RI_OFF + menOff - 1;
+            ar[c++] = 1.0f;
+        }
+
+        if (nCross) {
+            ai[c] = iBase + RI_NCROSS;
+            ar[c++] = (float) nCross / 10.0f;
+        }
     }
+
+    return c;
+}
+
+static unsigned int
+CalculateContactInputsSparse(const TanBoard anBoard, unsigned int ai[], float ar[])
+{
+    const unsigned int anMade[2] = { MadePoints(anBoard[0]), MadePoints(anBoard[1]) };
+    float arMore[2 * MORE_INPUTS];
+    unsigned int c = baseInputsSparse(anBoard, ai, ar);
+
+    /* I accidentally switched sides (0 and 1) when I trained the net */
+    menOffNonCrashed(anBoard[0], arMore + I_OFF1);
+    CalculateHalfInputs(anBoard[1], anBoard[0], anMade[1], anMade[0], arMore);
+
+    menOffNonCrashed(anBoard[1], arMore + MORE_INPUTS + I_OFF1);
+    CalculateHalfInputs(anBoard[0], anBoard[1], anMade[0], anMade[1], arMore + MORE_INPUTS);
+
+    return SparseAppend(arMore, 2 * MORE_INPUTS, MINPPERPOINT * 25 * 2, ai, ar, c);
+}
+
+static unsigned int
+CalculateCrashedInputsSparse(const TanBoard anBoard, unsigned int ai[], float ar[])
+{
+    const unsigned int anMade[2] = { MadePoints(anBoard[0]), MadePoints(anBoard[1]) };
+    float arMore[2 * MORE_INPUTS];
+    unsigned int c = baseInputsSparse(anBoard, ai, ar);
+
+    menOffAll(anBoard[1], arMore + I_OFF1);
+    CalculateHalfInputs(anBoard[1], anBoard[0], anMade[1], anMade[0], arMore);
+
+    menOffAll(anBoard[0], arMore + MORE_INPUTS + I_OFF1);
+    CalculateHalfInputs(anBoard[0], anBoard[1], anMade[0], anMade[1], arMore + MORE_INPUTS);
+
+    return SparseAppend(arMore, 2 * MORE_INPUTS, MINPPERPOINT * 25 * 2, ai, ar, c);
 }
+#endif
 
 extern void
 swap_us(unsigned int *p0, unsigned int *p1)
@@ -1630,61 +2212,96 @@ MaxTurns(int id)
     return -1;
 }
 
-extern void
-SanityCheck(const TanBoard anBoard, float arOutput[])
+/* The points of one side with chequers on them, bit i for point i and
+ * bit 24 for the bar, so that the back chequer is the highest bit set */
+static inline unsigned int
+OccupiedPoints(const unsigned int anPoints[25])
+#if defined(USE_SIMD_INSTRUCTIONS) && (defined(USE_SSE2) || defined(USE_AVX))
 {
-    int i, j, nciq, ac[2], anBack[2], anCross[2], anGammonCross[2], anMaxTurns[2], fContact;
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int n = 0;
+    int i;
 
-    g_assert(arOutput[OUTPUT_WIN] >= 0.0f && arOutput[OUTPUT_WIN] <= 1.0f);
-    g_assert(arOutput[OUTPUT_WINGAMMON] >= 0.0f && arOutput[OUTPUT_WINGAMMON] <= 1.0f);
-    g_assert(arOutput[OUTPUT_WINBACKGAMMON] >= 0.0f && arOutput[OUTPUT_WINBACKGAMMON] <= 1.0f);
-    g_assert(arOutput[OUTPUT_LOSEGAMMON] >= 0.0f && arOutput[OUTPUT_LOSEGAMMON] <= 1.0f);
-    g_assert(arOutput[OUTPUT_LOSEBACKGAMMON] >= 0.0f && arOutput[OUTPUT_LOSEBACKGAMMON] <= 1.0f);
+    for (i = 0; i < 24; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (const void *) (anPoints + i));
 
-    ac[0] = ac[1] = anBack[0] = anBack[1] = anCross[0] = anCross[1] = 0;
-    anGammonCross[0] = anGammonCross[1] = 1;
+        n |= (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, zero))) << i;
+    }
+
+    return (~n & 0xFFFFFF) | (anPoints[24] ? 1u << 24 : 0);
+}
+#elif defined(USE_SIMD_INSTRUCTIONS) && defined(USE_NEON) && defined(__aarch64__)
+{
+    static const uint32_t anBit[4] = { 1, 2, 4, 8 };
+    const uint32x4_t bit = vld1q_u32(anBit);
+    unsigned int n = 0;
+    int i;
+
+    for (i = 0; i < 24; i += 4) {
+        uint32x4_t v = vld1q_u32(anPoints + i);
+
+        n |= vaddvq_u32(vandq_u32(vtstq_u32(v, v), bit)) << i;
+    }
+
+    return n | (anPoints[24] ? 1u << 24 : 0);
+}
+#else
+{
+    unsigned int n = 0;
+    int i;
+
+    for (i = 0; i < 25; i++)
+        n |= (anPoints[i] != 0) << i;
+
+    return n;
+}
+#endif
+
+extern void
+SanityCheck(const TanBoard anBoard, float arOutput[])
+{
+    int i, j, nciq, ac[2], anBack[2], anCross[2], anGammonCross[2], anMaxTurns[2], fContact;
+
+    g_assert(arOutput[OUTPUT_WIN] >= 0.0f && arOutput[OUTPUT_WIN] <= 1.0f);
+    g_assert(arOutput[OUTPUT_WINGAMMON] >= 0.0f && arOutput[OUTPUT_WINGAMMON] <= 1.0f);
+    g_assert(arOutput[OUTPUT_WINBACKGAMMON] >= 0.0f && arOutput[OUTPUT_WINBACKGAMMON] <= 1.0f);
+    g_assert(arOutput[OUTPUT_LOSEGAMMON] >= 0.0f && arOutput[OUTPUT_LOSEGAMMON] <= 1.0f);
+    g_assert(arOutput[OUTPUT_LOSEBACKGAMMON] >= 0.0f && arOutput[OUTPUT_LOSEBACKGAMMON] <= 1.0f);
+
+    ac[0] = ac[1] = anCross[0] = anCross[1] = 0;
+    anGammonCross[0] = anGammonCross[1] = 1;
 
     for (j = 0; j < 2; j++) {
+        unsigned int n = OccupiedPoints(anBoard[j]);
+
+        /* Empty points add nothing to the counts below */
+        anBack[j] = n ? msb32((int) n) : 0;
+
         for (i = 0, nciq = 0; i < 6; i++)
-            if (anBoard[j][i]) {
-                anBack[j] = i;
-                nciq += anBoard[j][i];
-            }
+            nciq += anBoard[j][i];
         ac[j] = anCross[j] = nciq;
 
         for (i = 6, nciq = 0; i < 12; i++)
-            if (anBoard[j][i]) {
-                anBack[j] = i;
-                nciq += anBoard[j][i];
-            }
+            nciq += anBoard[j][i];
         ac[j] += nciq;
         anCross[j] += 2 * nciq;
         anGammonCross[j] += nciq;
 
         for (i = 12, nciq = 0; i < 18; i++)
-            if (anBoard[j][i]) {
-                anBack[j] = i;
-                nciq += anBoard[j][i];
-            }
+            nciq += anBoard[j][i];
         ac[j] += nciq;
         anCross[j] += 3 * nciq;
         anGammonCross[j] += 2 * nciq;
 
         for (i = 18, nciq = 0; i < 24; i++)
-            if (anBoard[j][i]) {
-                anBack[j] = i;
-                nciq += anBoard[j][i];
-            }
+            nciq += anBoard[j][i];
         ac[j] += nciq;
         anCross[j] += 4 * nciq;
         anGammonCross[j] += 3 * nciq;
 
-        if (anBoard[j][24]) {
-            anBack[j] = 24;
-            ac[j] += anBoard[j][24];
-            anCross[j] += 5 * anBoard[j][24];
-            anGammonCross[j] += 4 * anBoard[j][24];
-        }
+        ac[j] += anBoard[j][24];
+        anCross[j] += 5 * anBoard[j][24];
+        anGammonCross[j] += 4 * anBoard[j][24];
     }
 
     fContact = anBack[0] + anBack[1] >= 24;
@@ -1771,97 +2388,106 @@ SanityCheck(const TanBoard anBoard, float arOutput[])
 }
 
 
-extern positionclass
-ClassifyPosition(const TanBoard anBoard, const bgvariation bgv)
+/* The index of the back chequers of both sides, -1 for a side with
+ * none left */
+static inline int
+BackChequers(const TanBoard anBoard)
 {
-    int nOppBack, nBack;
-
-    for (nOppBack = 24; nOppBack >= 0; --nOppBack) {
-        if (anBoard[0][nOppBack]) {
-            break;
-        }
-    }
-
-    for (nBack = 24; nBack >= 0; --nBack) {
-        if (anBoard[1][nBack]) {
-            break;
-        }
-    }
-
-    if (unlikely(nBack < 0 || nOppBack < 0))
-        return CLASS_OVER;
-
-    /* special classes for hypergammon variants */
-
-    switch (bgv) {
-    case VARIATION_HYPERGAMMON_1:
-        return CLASS_HYPERGAMMON1;
+    unsigned int nOpp = OccupiedPoints(anBoard[0]);
+    unsigned int n = OccupiedPoints(anBoard[1]);
 
-    case VARIATION_HYPERGAMMON_2:
-        return CLASS_HYPERGAMMON2;
+    if (unlikely(!n || !nOpp))
+        return -1;
 
-    case VARIATION_HYPERGAMMON_3:
-        return CLASS_HYPERGAMMON3;
+    return msb32((int) n) + msb32((int) nOpp);
+}
 
-    case VARIATION_STANDARD:
-    case VARIATION_NACKGAMMON:
+/* ClassifyPosition() for standard backgammon and nackgammon, with no
+ * variant tests; the callers that know their variant use it directly */
+extern positionclass
+ClassifyPositionStandard(const TanBoard anBoard)
+{
+    int nBackSum = BackChequers(anBoard);
 
-        /* normal backgammon */
+    if (unlikely(nBackSum < 0))
+        return CLASS_OVER;
 
-        if (nBack + nOppBack > 22) {
+    if (nBackSum > 22) {
 
-            /* contact position */
+        /* contact position */
 
-            unsigned int const N = 6;
-            unsigned int i;
-            unsigned int side;
+        unsigned int const N = 6;
+        unsigned int i;
+        unsigned int side;
 
-            for (side = 0; side < 2; ++side) {
-                unsigned int tot = 0;
+        for (side = 0; side < 2; ++side) {
+            unsigned int tot = 0;
 
-                const unsigned int *board = anBoard[side];
+            const unsigned int *board = anBoard[side];
 
-                for (i = 0; i < 25; ++i) {
-                    tot += board[i];
-                }
+            for (i = 0; i < 25; ++i) {
+                tot += board[i];
+            }
 
-                if (unlikely(tot <= N)) {
-                    return CLASS_CRASHED;
-                } else {
-                    if (unlikely(board[0] > 1)) {
-                        if (unlikely(tot <= (N + board[0]))) {
-                            return CLASS_CRASHED;
-                        } else {
-                            if (unlikely((1 + tot - (board[0] + board[1])) <= N) && board[1] > 1) {
-                                return CLASS_CRASHED;
-                            }
-                        }
+            if (unlikely(tot <= N)) {
+                return CLASS_CRASHED;
+            } else {
+                if (unlikely(board[0] > 1)) {
+                    if (unlikely(tot <= (N + board[0]))) {
+                        return CLASS_CRASHED;
                     } else {
-                        if (unlikely(tot <= (N + (board[1] - 1)))) {
+                        if (unlikely((1 + tot - (board[0] + board[1])) <= N) && board[1] > 1) {
                             return CLASS_CRASHED;
                         }
                     }
+                } else {
+                    if (unlikely(tot <= (N + (board[1] - 1)))) {
+                        return CLASS_CRASHED;
+                    }
                 }
             }
+        }
 
-            return CLASS_CONTACT;
-        } else {
+        return CLASS_CONTACT;
+    } else {
 
-            if (unlikely(isBearoff(pbc2, anBoard)))
-                return CLASS_BEAROFF2;
+        if (unlikely(isBearoff(pbc2, anBoard)))
+            return CLASS_BEAROFF2;
 
-            if (unlikely(isBearoff(pbcTS, anBoard)))
-                return CLASS_BEAROFF_TS;
+        if (unlikely(isBearoff(GetBearoffTS(), anBoard)))
+            return CLASS_BEAROFF_TS;
 
-            if (unlikely(isBearoff(pbc1, anBoard)))
-                return CLASS_BEAROFF1;
+        if (unlikely(isBearoff(pbc1, anBoard)))
+            return CLASS_BEAROFF1;
 
-            if (unlikely(isBearoff(pbcOS, anBoard)))
-                return CLASS_BEAROFF_OS;
+        if (unlikely(isBearoff(pbcOS, anBoard)))
+            return CLASS_BEAROFF_OS;
 
-            return CLASS_RACE;
+        return CLASS_RACE;
 
-        }
+    }
+}
+
+extern positionclass
+ClassifyPosition(const TanBoard anBoard, const bgvariation bgv)
+{
+    if (likely(bgv == VARIATION_STANDARD || bgv == VARIATION_NACKGAMMON))
+        return ClassifyPositionStandard(anBoard);
+
+    /* special classes for hypergammon variants */
+
+    if (unlikely(BackChequers(anBoard) < 0))
+        return CLASS_OVER;
+
+    switch (bgv) {
+    case VARIATION_HYPERGAMMON_1:
+        return CLASS_HYPERGAMMON1;
+
+    case VARIATION_HYPERGAMMON_2:
+        return CLASS_HYPERGAMMON2;
+
+    case VARIATION_HYPERGAMMON_3:
+        return CLASS_HYPERGAMMON3;
 
     default:
 
@@ -1893,7 +2519,7 @@ static int
 EvalBearoffTS(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(pbcTS, anBoard, arOutput);
+    return BearoffEval(GetBearoffTS(), anBoard, arOutput);
 
 }
 
@@ -1901,7 +2527,7 @@ static int
 EvalHypergammon1(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[0], anBoard, arOutput);
+    return BearoffEval(GetBearoffHyper(0), anBoard, arOutput);
 
 }
 
@@ -1909,7 +2535,7 @@ static int
 EvalHypergammon2(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[1], anBoard, arOutput);
+    return BearoffEval(GetBearoffHyper(1), anBoard, arOutput);
 
 }
 
@@ -1917,7 +2543,7 @@ static int
 EvalHypergammon3(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[2], anBoard, arOutput);
+    return BearoffEval(GetBearoffHyper(2), anBoard, arOutput);
 
 }
 
@@ -1977,7 +2603,7 @@ raceBGprob(const TanBoard anBoard, int side, const bgvariation bgv)
 
     {
         float p = 0.0f;
-        const long *bgp = getRaceBGprobs(dummy[1 - side]);
+        const unsigned int *bgp = getRaceBGprobs(dummy[1 - side]);
         if (bgp) {
             int k = PositionBearoff(anBoard[side], pbc1->nPoints, pbc1->nChequers);
             unsigned short int aProb[32];
@@ -2103,16 +2729,32 @@ static int
 EvalRace(const TanBoard anBoard, float arOutput[], const bgvariation bgv, NNState * nnStates)
 {
     SSE_ALIGN(float arInput[NUM_RACE_INPUTS]);
+    guint64 tProfile;
+    const neuralnet *pnn = aws[MT_GetTLD()->iWeights].apnn[WN_RACE];
+    int n;
+#if defined(USE_SIMD_INSTRUCTIONS)
+    unsigned int aiInput[NUM_RACE_INPUTS];
+    unsigned int c;
 
+    PROFILE_START(tProfile);
+    c = CalculateRaceInputsSparse(anBoard, aiInput, arInput);
+    PROFILE_STOP(tProfile, PROFILE_INPUTS);
+#else
+    PROFILE_START(tProfile);
     CalculateRaceInputs(anBoard, arInput);
+    PROFILE_STOP(tProfile, PROFILE_INPUTS);
+#endif
 
+    PROFILE_START(tProfile);
 #if defined(USE_SIMD_INSTRUCTIONS)
-    // cppcheck-suppress duplicateExpression
-    if (NeuralNetEvaluateSSE(&nnRace, arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL))
+    n = NeuralNetEvaluateSparse(pnn, aiInput, arInput, c, arOutput);
 #else
     // cppcheck-suppress duplicateExpression
-    if (NeuralNetEvaluate(&nnRace, arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL))
+    n = NeuralNetEvaluate(pnn, arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL);
 #endif
+    PROFILE_STOP(tProfile, PROFILE_NN);
+
+    if (n)
         return -1;
 
     /* special evaluation of backgammons overrides net output */
@@ -2124,34 +2766,170 @@ EvalRace(const TanBoard anBoard, float arOutput[], const bgvariation bgv, NNStat
     return 0;
 }
 
+/* The effective pip counts RaceApprox() has distributions for, and the
+ * number of rolls they go up to */
+#define RACE_MAX_EPC 480
+#define RACE_ROLLS 96
+
+/* Pips wasted in a typical race on top of what the shape of the home
+ * board shows */
+#define RACE_WASTAGE 4
+
+/* The chance of bearing off within n rolls, aarRaceRolls[e][n], for an
+ * effective pip count of e.  The number of rolls is taken as normally
+ * distributed, with the mean and variance of the rolls it takes the
+ * dice to cover e pips: 8.167 pips a roll, with a variance of 18.47. */
+static float aarRaceRolls[RACE_MAX_EPC + 1][RACE_ROLLS];
+
+static void
+InitRaceRolls(void)
+{
+    int e, n;
+
+    for (e = 0; e <= RACE_MAX_EPC; e++) {
+        float mu = (float) e / 8.167f;
+        float sigma = MAX(sqrtf((float) e * 18.47f / (8.167f * 8.167f * 8.167f)), 0.5f);
+        float ar[RACE_ROLLS];
+        float rSum = 0.0f, r = 0.0f;
+
+        /* it takes at least one roll */
+        ar[0] = 0.0f;
+        for (n = 1; n < RACE_ROLLS; n++)
+            rSum += ar[n] = fnd((float) n, mu, sigma);
+
+        for (n = 0; n < RACE_ROLLS; n++) {
+            r += ar[n] / rSum;
+            aarRaceRolls[e][n] = MIN(r, 1.0f);
+        }
+        aarRaceRolls[e][RACE_ROLLS - 1] = 1.0f;
+    }
+}
+
+/* The effective pip counts of one side of a race: to bear off all its
+ * chequers, and to bear off the first one (bring the others home and
+ * take one off).  The wastage of the home board is that of Keith's
+ * count. */
+static void
+RaceEPC(const unsigned int anPoints[25], int *pnAll, int *pnFirst)
+{
+    int i, nPips = 0, nHome = 6;
+
+    for (i = 0; i < 24; i++) {
+        nPips += (i + 1) * (int) anPoints[i];
+        if (i >= 6)
+            nHome += (i - 5) * (int) anPoints[i];
+    }
+
+    nPips += RACE_WASTAGE + 2 * (MAX(1, (int) anPoints[0]) - 1) + MAX(1, (int) anPoints[1]) - 1
+        + MAX(3, (int) anPoints[2]) - 3 + !anPoints[3] + !anPoints[4] + !anPoints[5];
+
+    *pnAll = MIN(nPips, RACE_MAX_EPC);
+    *pnFirst = MIN(nHome, RACE_MAX_EPC);
+}
+
+/* A quick evaluation of a race from the effective pip counts of the two
+ * sides, as a stand in for the race net where a rough one does.  The
+ * player on roll (anBoard[1]) wins if they need no more rolls than the
+ * opponent, and wins a gammon if they need no more than the opponent
+ * does to take their first chequer off.  Backgammons are EvalRaceBG()'s. */
+extern void
+RaceApprox(const TanBoard anBoard, float arOutput[NUM_OUTPUTS], const bgvariation bgv)
+{
+    int anAll[2], anFirst[2], n;
+    unsigned int anMen[2] = { 0, 0 };
+    const float *ar0, *ar1, *arFirst0, *arFirst1;
+    float rWin = 0.0f, rWinG = 0.0f, rLoseG = 0.0f;
+
+    for (n = 0; n < 25; n++) {
+        anMen[0] += anBoard[0][n];
+        anMen[1] += anBoard[1][n];
+    }
+
+    RaceEPC(anBoard[0], &anAll[0], &anFirst[0]);
+    RaceEPC(anBoard[1], &anAll[1], &anFirst[1]);
+    ar0 = aarRaceRolls[anAll[0]];
+    ar1 = aarRaceRolls[anAll[1]];
+    arFirst0 = aarRaceRolls[anFirst[0]];
+    arFirst1 = aarRaceRolls[anFirst[1]];
+
+    for (n = 1; n < RACE_ROLLS; n++) {
+        float p1 = ar1[n] - ar1[n - 1];
+        float p0 = ar0[n] - ar0[n - 1];
+
+        rWin += p1 * (1.0f - ar0[n - 1]);
+        rWinG += p1 * (1.0f - arFirst0[n - 1]);
+        rLoseG += p0 * (1.0f - arFirst1[n]);
+    }
+
+    arOutput[OUTPUT_WIN] = rWin;
+    arOutput[OUTPUT_WINGAMMON] = anMen[0] == 15 ? rWinG : 0.0f;
+    arOutput[OUTPUT_LOSEGAMMON] = anMen[1] == 15 ? rLoseG : 0.0f;
+    arOutput[OUTPUT_WINBACKGAMMON] = arOutput[OUTPUT_LOSEBACKGAMMON] = 0.0f;
+
+    EvalRaceBG(anBoard, arOutput, bgv);
+    SanityCheck(anBoard, arOutput);
+}
+
 static int
 EvalContact(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * nnStates)
 {
     SSE_ALIGN(float arInput[NUM_INPUTS]);
+    guint64 tProfile;
+    const unsigned int iWeights = MT_GetTLD()->iWeights;
+    int n;
+#if defined(USE_SIMD_INSTRUCTIONS)
+    unsigned int aiInput[NUM_INPUTS];
+    unsigned int c;
+#endif
 
+    PROFILE_START(tProfile);
+#if defined(USE_SIMD_INSTRUCTIONS)
+    c = CalculateContactInputsSparse(anBoard, aiInput, arInput);
+#else
     CalculateContactInputs(anBoard, arInput);
+#endif
+    PROFILE_STOP(tProfile, PROFILE_INPUTS);
 
+    PROFILE_START(tProfile);
 #if defined(USE_SIMD_INSTRUCTIONS)
-    return NeuralNetEvaluateSSE(&nnContact, arInput, arOutput,
-                                nnStates ? nnStates + (CLASS_CONTACT - CLASS_RACE) : NULL);
+    n = NeuralNetEvaluateSparse(aws[iWeights].apnn[WN_CONTACT], aiInput, arInput, c, arOutput);
 #else
-    return NeuralNetEvaluate(&nnContact, arInput, arOutput, nnStates ? nnStates + (CLASS_CONTACT - CLASS_RACE) : NULL);
+    n = NeuralNetEvaluate(aws[iWeights].apnn[WN_CONTACT], arInput, arOutput, nnStates ? nnStates + (CLASS_CONTACT - CLASS_RACE) : NULL);
 #endif
+    PROFILE_STOP(tProfile, PROFILE_NN);
+
+    return n;
 }
 
 static int
 EvalCrashed(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * nnStates)
 {
     SSE_ALIGN(float arInput[NUM_INPUTS]);
+    guint64 tProfile;
+    const unsigned int iWeights = MT_GetTLD()->iWeights;
+    int n;
+#if defined(USE_SIMD_INSTRUCTIONS)
+    unsigned int aiInput[NUM_INPUTS];
+    unsigned int c;
+#endif
 
+    PROFILE_START(tProfile);
+#if defined(USE_SIMD_INSTRUCTIONS)
+    c = CalculateCrashedInputsSparse(anBoard, aiInput, arInput);
+#else
     CalculateCrashedInputs(anBoard, arInput);
+#endif
+    PROFILE_STOP(tProfile, PROFILE_INPUTS);
 
+    PROFILE_START(tProfile);
 #if defined(USE_SIMD_INSTRUCTIONS)
-    return NeuralNetEvaluateSSE(&nnCrashed, arInput, arOutput,
-                                nnStates ? nnStates + (CLASS_CRASHED - CLASS_RACE) : NULL);
+    n = NeuralNetEvaluateSparse(aws[iWeights].apnn[WN_CRASHED], aiInput, arInput, c, arOutput);
 #else
-    return NeuralNetEvaluate(&nnCrashed, arInput, arOutput, nnStates ? nnStates + (CLASS_CRASHED - CLASS_RACE) : NULL);
+    n = NeuralNetEvaluate(aws[iWeights].apnn[WN_CRASHED], arInput, arOutput, nnStates ? nnStates + (CLASS_CRASHED - CLASS_RACE) : NULL);
 #endif
+    PROFILE_STOP(tProfile, PROFILE_NN);
+
+    return n;
 }
 
 extern int
@@ -2241,134 +3019,428 @@ classevalfunc acef[N_CLASSES] = {
     EvalRace, EvalCrashed, EvalContact
 };
 
-extern float
-Noise(const evalcontext * pec, const TanBoard anBoard, int iOutput)
+/* Evaluate the c positions of arInputs of a contact or crashed class
+ * against the first one.  The candidates of a 0-ply move search
+ * differ on few points, so after the hidden sums of the base inputs
+ * of the first position, the others only add the weight rows of the
+ * base inputs that changed and of their own non zero other inputs. */
+
+static void
+EvaluateDeltaBlock(const neuralnet * pnn, const TanBoard aanBoard[], const unsigned int ai[], unsigned int c,
+                   const float arInputs[], float arOutputs[])
+{
+    SSE_ALIGN(float arBase[pnn->cHidden]);
+    unsigned int aiDelta[MINPPERPOINT * 25 * 2];
+    float arDelta[MINPPERPOINT * 25 * 2];
+    const unsigned int(*anBase)[25] = aanBoard[ai[0]];
+    unsigned int k;
+
+    NeuralNetHiddenSums(pnn, arInputs, MINPPERPOINT * 25 * 2, arBase);
+
+    for (k = 0; k < c; k++) {
+        const float *arInput = arInputs + k * pnn->cInput;
+        unsigned int cDelta = 0, s, p, j;
+
+        for (s = 0; s < 2; s++)
+            for (p = 0; p < 25; p++)
+                if (aanBoard[ai[k]][s][p] != anBase[s][p])
+                    for (j = (s * 25 + p) * MINPPERPOINT; j < (s * 25 + p + 1) * MINPPERPOINT; j++)
+                        if (arInput[j] != arInputs[j]) {
+                            aiDelta[cDelta] = j;
+                            arDelta[cDelta++] = arInput[j] - arInputs[j];
+                        }
+
+        NeuralNetEvaluateDelta(pnn, arBase, MINPPERPOINT * 25 * 2, aiDelta, arDelta, cDelta, arInput,
+                               arOutputs + k * NUM_OUTPUTS);
+    }
+}
+
+static void
+FinishBatchNN(const TanBoard aanBoard[], const unsigned int ai[], unsigned int c, positionclass pc,
+              const bgvariation bgv, const float arOutputs[], float aarOutput[][NUM_OUTPUTS])
 {
-    float r;
+    unsigned int k;
 
-    if (pec->fDeterministic) {
-        char auchBoard[50], auch[16];
-        int i;
+    for (k = 0; k < c; k++) {
+        float *arOutput = aarOutput[ai[k]];
 
-        for (i = 0; i < 25; i++) {
-            auchBoard[i << 1] = (char) anBoard[0][i];
-            auchBoard[(i << 1) + 1] = (char) anBoard[1][i];
-        }
+        memcpy(arOutput, arOutputs + k * NUM_OUTPUTS, NUM_OUTPUTS * sizeof(float));
 
-        auchBoard[0] += (char) iOutput;
+        if (pc == CLASS_RACE)
+            /* special evaluation of backgammons overrides net output */
+            EvalRaceBG(aanBoard[ai[k]], arOutput, bgv);
 
-        md5_buffer(auchBoard, 50, auch);
+        SanityCheck(aanBoard[ai[k]], arOutput);
+    }
+}
 
-        /* We can't use a Box-Muller transform here, because generating
-         * a point in the unit circle requires a potentially unbounded
-         * number of integers, and all we have is the board.  So we
-         * just take the sum of the bytes in the hash, which (by the
-         * central limit theorem) should have a normal-ish distribution. */
+/* Evaluate all the positions of class pc with pnbBackend, in one
+ * batch.  Returns non zero, with nothing evaluated, if there are fewer
+ * than its cBatchMin or it failed. */
 
-        r = 0.0f;
-        for (i = 0; i < 16; i++)
-            r += auch[i];
+static int
+EvaluateBackendNN(const neuralnet * pnn, void (*inputfunc) (const TanBoard, float[]),
+                  const TanBoard aanBoard[], const positionclass apc[], unsigned int n, positionclass pc,
+                  const bgvariation bgv, float aarOutput[][NUM_OUTPUTS])
+{
+    unsigned int *ai;
+    float *arInputs, *arOutputs;
+    scratchmark mark;
+    unsigned int c = 0, i;
+    int r = -1;
 
-        r -= 2040.0f;
-        r /= 295.6f;
-    } else {
-        /* Box-Muller transform of a point in the unit circle. */
-        float x, y;
+    for (i = 0; i < n; i++)
+        if (apc[i] == pc)
+            c++;
 
-        do {
-            x = (float) irand(&rc) * 2.0f / (float) UB4MAXVAL - 1.0f;
-            y = (float) irand(&rc) * 2.0f / (float) UB4MAXVAL - 1.0f;
-            r = x * x + y * y;
-        } while (r > 1.0f || r == 0.0f);
+    if (!c || c < pnbBackend->cBatchMin)
+        return -1;
 
-        r = y * sqrtf(-2.0f * logf(r) / r);
-        (void) x;
-    }
+    mark = MT_ScratchMark();
+    ai = (unsigned int *) MT_ScratchAlloc(c * sizeof(unsigned int));
+    arInputs = (float *) MT_ScratchAlloc(c * pnn->cInput * sizeof(float));
+    arOutputs = (float *) MT_ScratchAlloc(c * NUM_OUTPUTS * sizeof(float));
 
-    r *= pec->rNoise;
+    for (c = 0, i = 0; i < n; i++)
+        if (apc[i] == pc) {
+            inputfunc(aanBoard[i], arInputs + c * pnn->cInput);
+            ai[c++] = i;
+        }
 
-    if (iOutput == OUTPUT_WINGAMMON || iOutput == OUTPUT_LOSEGAMMON)
-        r *= 0.25f;
-    else if (iOutput == OUTPUT_WINBACKGAMMON || iOutput == OUTPUT_LOSEBACKGAMMON)
-        r *= 0.01f;
+    if (!(r = pnbBackend->pfEvaluateBatch(pnn, arInputs, c, arOutputs)))
+        FinishBatchNN(aanBoard, ai, c, pc, bgv, arOutputs, aarOutput);
+
+    MT_ScratchRelease(mark);
 
     return r;
 }
 
-extern int
-EvalKey(const evalcontext * pec, const int nPlies, const cubeinfo * pci, int fCubefulEquity)
+/* Evaluate n positions of the neural net classes (CLASS_RACE,
+ * CLASS_CRASHED and CLASS_CONTACT) at 0-ply.  The results are the
+ * same as acef[] followed by SanityCheck(), but the net evaluations
+ * are batched so that the weights are streamed once per block of
+ * positions instead of once per position, and those of the contact
+ * and crashed nets are incremental.  With a backend set, classes with
+ * enough positions go to it in one batch instead.  The nets are those
+ * of weight set iWeights. */
+
+extern void
+EvaluateBatchNN(const TanBoard aanBoard[], const positionclass apc[], unsigned int n, const bgvariation bgv,
+                unsigned int iWeights, float aarOutput[][NUM_OUTPUTS])
 {
+    static void (*const inputfunc[]) (const TanBoard, float[]) = {
+        CalculateRaceInputs, CalculateCrashedInputs, CalculateContactInputs
+    };
+    neuralnet *const *apnn = aws[iWeights].apnn;
+    const neuralnet *const nets[] = { apnn[WN_RACE], apnn[WN_CRASHED], apnn[WN_CONTACT] };
+    SSE_ALIGN(float arInputs[NN_BATCH_BLOCK * NUM_INPUTS]);
+    SSE_ALIGN(float arOutputs[NN_BATCH_BLOCK * NUM_OUTPUTS]);
+    unsigned int ai[NN_BATCH_BLOCK];
+    positionclass pc;
+    threadstats *pts = &MT_GetTLD()->ts;
+    unsigned int j;
 
-    int iKey;
-    /*
-     * Bit 00-03: nPlies
-     * Bit 04   : fCubeful
-     * Bit 05   : fMove
-     * Bit 06   : fUsePrune
-     * Bit 07-12: anScore[ 0 ]
-     * Bit 13-18: anScore[ 1 ]
-     * Bit 19-22: log2(nCube)
-     * Bit 23-24: fCubeOwner
-     * Bit 25   : fCrawford
-     * Bit 26   : fJacoby
-     * Bit 27   : fBeavers
-     */
+    for (j = 0; j < n; j++)
+        pts->acEval[apc[j]]++;
 
-    iKey = (nPlies | (pec->fCubeful << 4) | (pci->fMove << 5));
+    for (pc = CLASS_RACE; pc <= CLASS_CONTACT; pc++) {
+        const neuralnet *pnn = nets[pc - CLASS_RACE];
+        unsigned int i = 0;
 
-    if (nPlies)
-        iKey ^= ((pec->fUsePrune) << 6);
+        if (pnbBackend && !iWeights
+            && !EvaluateBackendNN(pnn, inputfunc[pc - CLASS_RACE], aanBoard, apc, n, pc, bgv, aarOutput))
+            continue;
 
+        while (i < n) {
+            unsigned int c = 0;
 
-    if (nPlies || fCubefulEquity) {
-        /* In match play, the score and cube value and position are important. */
-        if (pci->nMatchTo)
-            iKey ^=
-                ((pci->nMatchTo - pci->anScore[pci->fMove] - 1) << 7) ^
-                ((pci->nMatchTo - pci->anScore[!pci->fMove] - 1) << 13) ^
-                (LogCube(pci->nCube) << 19) ^
-                ((pci->fCubeOwner < 0 ? 2 : pci->fCubeOwner == pci->fMove) << 23) ^ (pci->fCrawford << 25);
-        else if (pec->fCubeful || fCubefulEquity)
-            /* in cubeful money games the cube position and rules are important. */
-            iKey ^=
-                ((pci->fCubeOwner < 0 ? 2 :
-                  pci->fCubeOwner == pci->fMove) << 23) ^ (pci->fJacoby << 26) ^ (pci->fBeavers << 27);
+            /* collect the next block of positions of this class */
+            for (; i < n && c < NN_BATCH_BLOCK; i++)
+                if (apc[i] == pc) {
+                    inputfunc[pc - CLASS_RACE] (aanBoard[i], arInputs + c * pnn->cInput);
+                    ai[c++] = i;
+                }
 
-        if (fCubefulEquity)
-            iKey ^= 0x6a47b47e;
+            if (!c)
+                break;
+
+            if (pc != CLASS_RACE && c > 1)
+                EvaluateDeltaBlock(pnn, aanBoard, ai, c, arInputs, arOutputs);
+            else
+                NeuralNetEvaluateBatch(pnn, arInputs, c, arOutputs);
+
+            FinishBatchNN(aanBoard, ai, c, pc, bgv, arOutputs, aarOutput);
+        }
     }
+}
 
-    return iKey;
+extern const nnbackend *
+EvalGetBackend(void)
+{
+    return pnbBackend;
+}
 
+/* Set the evaluator of large batches, NULL for the built in one.  The
+ * backends need not agree to the last bit, so the cache is flushed. */
+extern void
+EvalSetBackend(const nnbackend * pnb)
+{
+    if (pnb != pnbBackend) {
+        pnbBackend = pnb;
+        EvalCacheFlush();
+    }
 }
 
 extern int
-PerfectCubeful(bearoffcontext * pbc, const TanBoard anBoard, float arEquity[])
+EvalGetAdaptiveFilter(void)
 {
+    return fAdaptiveFilter;
+}
 
-    unsigned int nUs = PositionBearoff(anBoard[1], pbc->nPoints, pbc->nChequers);
-    unsigned int nThem = PositionBearoff(anBoard[0], pbc->nPoints, pbc->nChequers);
-    unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
-    unsigned int iPos = nUs * n + nThem;
+extern void
+EvalSetAdaptiveFilter(int f)
+{
+    fAdaptiveFilter = f;
+}
 
-    return BearoffCubeful(pbc, iPos, arEquity, NULL);
+extern double
+EvalGetFilterBudget(void)
+{
+    return rFilterBudget;
+}
 
+extern void
+EvalSetFilterBudget(double r)
+{
+    rFilterBudget = r > 0.0 ? r : 0.0;
+}
+
+extern float
+EvalGetEarlyExit(void)
+{
+    return rEarlyExit;
 }
 
+extern void
+EvalSetEarlyExit(float r)
+{
+    rEarlyExit = r > 0.0f ? r : 0.0f;
+}
 
 extern int
-EvaluatePerfectCubeful(const TanBoard anBoard, float arEquity[], const bgvariation bgv)
+EvalGetRaceApprox(void)
 {
+    return fRaceApprox;
+}
 
-    positionclass pc = ClassifyPosition(anBoard, bgv);
+extern void
+EvalSetRaceApprox(int f)
+{
+    fRaceApprox = f;
+}
 
-    g_assert(pc <= CLASS_PERFECT);
+extern int
+EvalGetFastSigmoid(void)
+{
+    return fFastSigmoid;
+}
+
+extern void
+EvalSetFastSigmoid(int f)
+{
+    unsigned int i, j;
+
+    for (i = 0; i < MAX_WEIGHT_SETS; i++)
+        if (aws[i].szName)
+            for (j = 0; j < N_WEIGHT_NETS; j++)
+                aws[i].apnn[j]->fFastSigmoid = f;
+
+    if (f != fFastSigmoid) {
+        fFastSigmoid = f;
+        /* cached evaluations were made with the other sigmoid */
+        EvalCacheFlush();
+    }
+}
+
+static inline uint64_t
+Mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/* The hash of a position the deterministic noise of its outputs is
+ * drawn from */
+static uint64_t
+NoiseHash(const TanBoard anBoard)
+{
+    positionkey key;
+    uint64_t h = 0;
+    int i;
+
+    PositionKey(anBoard, &key);
+    for (i = 0; i < 7; i++)
+        h = Mix64(h ^ key.data[i]);
+
+    return h;
+}
+
+/* The deterministic noise of output iOutput of the position of hash h.
+ * We can't use a Box-Muller transform here, because generating a point
+ * in the unit circle requires a potentially unbounded number of
+ * integers, and all we have is the board.  So we just take the sum of
+ * 16 bytes of a hash, which (by the central limit theorem) should have
+ * a normal-ish distribution.  The bytes are summed 4 and 8 at a time
+ * in the lanes of a word. */
+static float
+NoiseDeterministic(uint64_t h, int iOutput)
+{
+    const uint64_t m8 = 0x00ff00ff00ff00ffULL, m16 = 0x0000ffff0000ffffULL;
+    uint64_t a, b;
+
+    a = Mix64(h + 0x9e3779b97f4a7c15ULL * (uint64_t) (iOutput + 1));
+    b = Mix64(a + 0x9e3779b97f4a7c15ULL);
+
+    a = (a & m8) + ((a >> 8) & m8) + (b & m8) + ((b >> 8) & m8);
+    a = (a & m16) + ((a >> 16) & m16);
+    a = (a + (a >> 32)) & 0xffffffffULL;
+
+    return ((float) a - 2040.0f) / 295.6f;
+}
+
+static float
+NoiseScale(const evalcontext * pec, float r, int iOutput)
+{
+    r *= pec->rNoise;
+
+    if (iOutput == OUTPUT_WINGAMMON || iOutput == OUTPUT_LOSEGAMMON)
+        r *= 0.25f;
+    else if (iOutput == OUTPUT_WINBACKGAMMON || iOutput == OUTPUT_LOSEBACKGAMMON)
+        r *= 0.01f;
+
+    return r;
+}
+
+extern float
+Noise(const evalcontext * pec, const TanBoard anBoard, int iOutput)
+{
+    float r;
+
+    if (pec->fDeterministic)
+        r = NoiseDeterministic(NoiseHash(anBoard), iOutput);
+    else {
+        /* Box-Muller transform of a point in the unit circle. */
+        float x, y;
+
+        do {
+            x = (float) irand(&rc) * 2.0f / (float) UB4MAXVAL - 1.0f;
+            y = (float) irand(&rc) * 2.0f / (float) UB4MAXVAL - 1.0f;
+            r = x * x + y * y;
+        } while (r > 1.0f || r == 0.0f);
+
+        r = y * sqrtf(-2.0f * logf(r) / r);
+        (void) x;
+    }
+
+    return NoiseScale(pec, r, iOutput);
+}
+
+/* Noise() on all the outputs of anBoard, hashing the board once */
+extern void
+AddNoise(const evalcontext * pec, const TanBoard anBoard, float arOutput[NUM_OUTPUTS])
+{
+    uint64_t h = pec->fDeterministic ? NoiseHash(anBoard) : 0;
+    int i;
+
+    for (i = 0; i < NUM_OUTPUTS; i++) {
+        arOutput[i] += pec->fDeterministic ? NoiseScale(pec, NoiseDeterministic(h, i), i) : Noise(pec, anBoard, i);
+        arOutput[i] = MAX(arOutput[i], 0.0f);
+        arOutput[i] = MIN(arOutput[i], 1.0f);
+    }
+}
+
+extern int
+EvalKey(const evalcontext * pec, const int nPlies, const cubeinfo * pci, int fCubefulEquity)
+{
+
+    int iKey;
+    /*
+     * Bit 00-03: nPlies
+     * Bit 04   : fCubeful
+     * Bit 05   : fMove
+     * Bit 06   : fUsePrune
+     * Bit 07-13: anScore[ 0 ] (match play)
+     * Bit 14-20: anScore[ 1 ] (match play)
+     * Bit 07   : fJacoby (money play)
+     * Bit 08   : fBeavers (money play)
+     * Bit 21-24: log2(nCube)
+     * Bit 25-26: fCubeOwner
+     * Bit 27   : fCrawford
+     * Bit 28-29: iWeights
+     * Bit 30   : only set by the fCubefulEquity constant, which keeps
+     *            those keys apart from the cubeless ones
+     */
+
+    iKey = (nPlies | (pec->fCubeful << 4) | (pci->fMove << 5));
+
+    if (nPlies)
+        iKey ^= ((pec->fUsePrune) << 6);
+
+
+    if (nPlies || fCubefulEquity) {
+        /* In match play, the score and cube value and position are important. */
+        if (pci->nMatchTo)
+            iKey ^=
+                ((pci->nMatchTo - pci->anScore[pci->fMove] - 1) << 7) ^
+                ((pci->nMatchTo - pci->anScore[!pci->fMove] - 1) << 14) ^
+                (LogCube(pci->nCube) << 21) ^
+                ((pci->fCubeOwner < 0 ? 2 : pci->fCubeOwner == pci->fMove) << 25) ^ (pci->fCrawford << 27);
+        else if (pec->fCubeful || fCubefulEquity)
+            /* in cubeful money games the cube position and rules are important. */
+            iKey ^=
+                ((pci->fCubeOwner < 0 ? 2 :
+                  pci->fCubeOwner == pci->fMove) << 25) ^ (pci->fJacoby << 7) ^ (pci->fBeavers << 8);
+
+        if (fCubefulEquity)
+            iKey ^= 0x6a47b47e;
+    }
+
+    iKey ^= (int) (pec->iWeights << 28);
+
+    return iKey;
+
+}
+
+extern int
+PerfectCubeful(bearoffcontext * pbc, const TanBoard anBoard, float arEquity[])
+{
+
+    unsigned int nUs = PositionBearoff(anBoard[1], pbc->nPoints, pbc->nChequers);
+    unsigned int nThem = PositionBearoff(anBoard[0], pbc->nPoints, pbc->nChequers);
+    unsigned int n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
+    guint64 iPos = (guint64) nUs * n + nThem;
+
+    return BearoffCubeful(pbc, iPos, arEquity, NULL);
+
+}
+
+
+extern int
+EvaluatePerfectCubeful(const TanBoard anBoard, float arEquity[], const bgvariation bgv)
+{
+
+    positionclass pc = ClassifyPosition(anBoard, bgv);
+
+    g_assert(pc <= CLASS_PERFECT);
 
     switch (pc) {
     case CLASS_BEAROFF2:
         return PerfectCubeful(pbc2, anBoard, arEquity);
     case CLASS_BEAROFF_TS:
-        return PerfectCubeful(pbcTS, anBoard, arEquity);
+        return PerfectCubeful(GetBearoffTS(), anBoard, arEquity);
     default:
         g_assert_not_reached();
     }
@@ -2443,7 +3515,7 @@ GameStatus(const TanBoard anBoard, const bgvariation bgv)
  */
 
 extern float
-Utility(float ar[NUM_OUTPUTS], const cubeinfo * pci)
+Utility(const float ar[NUM_OUTPUTS], const cubeinfo * pci)
 {
 
     if (!pci->nMatchTo) {
@@ -2664,14 +3736,151 @@ ApplyMove(TanBoard anBoard, const int anMove[8], const int fCheckLegal)
     return 0;
 }
 
+/* Play the submoves of anMove from the i-th on, each with one of the
+ * dice in anRoll not yet in fUsed; 0 is an absent die.  When only a
+ * larger die can bear the rearmost chequer off, either may be needed
+ * later, so every die that fits is tried. */
+static int
+CheckSubMoves(const TanBoard anBoard, const int anMove[8], int i, const int anRoll[4], unsigned int fUsed)
+{
+    int iSrc, iDest, nPips, iBack = 0, j;
+
+    if (i == 8 || anMove[i] < 0)
+        return 0;
+
+    iSrc = anMove[i];
+    iDest = anMove[i + 1];
+    nPips = iSrc - iDest;
+
+    if (iSrc > 24 || iDest < -1 || iDest >= iSrc || anBoard[1][iSrc] < 1)
+        return -1;
+
+    if (anBoard[1][24] && iSrc != 24)
+        /* chequers on the bar must enter first */
+        return -1;
+
+    if (iDest >= 0) {
+        if (anBoard[0][23 - iDest] > 1)
+            return -1;
+    } else {
+        for (iBack = 24; iBack > 0 && !anBoard[1][iBack]; iBack--);
+
+        if (iBack > 5)
+            /* not all chequers are home */
+            return -1;
+    }
+
+    for (j = 0; j < 4; j++) {
+        TanBoard an;
+
+        if ((fUsed & (1u << j)) || (anRoll[j] != nPips && !(iDest < 0 && iSrc == iBack && anRoll[j] > nPips)))
+            continue;
+
+        if (j && anRoll[j] == anRoll[j - 1] && !(fUsed & (1u << (j - 1))))
+            /* the same as the die just tried */
+            continue;
+
+        memcpy(an, anBoard, sizeof(an));
+        ApplySubMove(an, iSrc, nPips, FALSE);
+
+        if (!CheckSubMoves(an, anMove, i + 2, anRoll, fUsed | (1u << j)))
+            return 0;
+    }
+
+    return -1;
+}
+
+/* Check that anMove, played in the order given, is a legal way of
+ * moving the chequers of the player on roll in anBoard with anDice:
+ * each submove uses a die of its own, chequers on the bar enter first,
+ * points made by the opponent are avoided and chequers are borne off
+ * only when all of them are home, with a larger die only from the
+ * rearmost point.  This takes a few steps per submove rather than
+ * generating all moves, so whether the move uses as much of the roll
+ * as possible is not checked.  Returns 0 if the move is legal. */
+extern int
+CheckMove(const TanBoard anBoard, const int anMove[8], const unsigned int anDice[2])
+{
+    int anRoll[4];
+
+    if (anDice[0] < 1 || anDice[0] > 6 || anDice[1] < 1 || anDice[1] > 6)
+        return -1;
+
+    anRoll[0] = (int) anDice[0];
+    anRoll[1] = (int) anDice[1];
+    anRoll[2] = anRoll[3] = anDice[0] == anDice[1] ? (int) anDice[0] : 0;
+
+    return CheckSubMoves(anBoard, anMove, 0, anRoll, 0);
+}
+
+/* The state of one GenerateMoves(): the position is changed in place
+ * as the chequers are moved and put back, and the moves found so far
+ * are hashed by position in pmh.  The key of the position is kept up
+ * to date with it, a nibble at a time, rather than packed again from
+ * the whole board for every move found. */
+typedef struct {
+    movelist *pml;
+    movehash *pmh;
+    int anRoll[4];
+    int anMoves[8];
+    int iBack;                  /* the rearmost chequer of the player on roll, 0 if none */
+    int fPartial;
+    TanBoard anBoard;
+    positionkey key;            /* PositionKey() of anBoard */
+} movegen;
+
+/* Where PositionKey() packs the chequers of side s on point i: the
+ * points of side 1 in words 0 to 2, those of side 0 in words 3 to 5,
+ * and both bars in word 6 */
+static inline void
+KeyAddChequer(positionkey * pkey, int s, int i)
+{
+    if (i < 24)
+        pkey->data[(s ? 0 : 3) + (i >> 3)] += 1u << ((i & 7) << 2);
+    else
+        pkey->data[6] += 1u << (s ? 4 : 0);
+}
+
+static inline void
+KeyRemoveChequer(positionkey * pkey, int s, int i)
+{
+    if (i < 24)
+        pkey->data[(s ? 0 : 3) + (i >> 3)] -= 1u << ((i & 7) << 2);
+    else
+        pkey->data[6] -= 1u << (s ? 4 : 0);
+}
+
+static inline unsigned int
+MoveHashKey(const positionkey * pkey)
+{
+    unsigned int h = 0, i;
+
+    for (i = 0; i < 7; i++)
+        h = (h ^ pkey->data[i]) * 0x9e3779b1u;
+
+    return (h ^ (h >> 16)) & (MOVE_HASH_SIZE - 1);
+}
+
+static inline void
+MoveHashClear(movehash * pmh)
+{
+    if (++pmh->nStamp == 0) {
+        memset(pmh->anStamp, 0, sizeof(pmh->anStamp));
+        pmh->nStamp = 1;
+    }
+}
+
 static void
-SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[], const TanBoard anBoard, int fPartial)
+SaveMoves(movegen * pmg, unsigned int cMoves, unsigned int cPip)
 {
-    unsigned int i, j;
+    movelist *pml = pmg->pml;
+    movehash *pmh = pmg->pmh;
+    const int *anMoves = pmg->anMoves;
+    const positionkey *pkey = &pmg->key;
+    unsigned int i, h;
     move *pm;
-    positionkey key;
 
-    if (fPartial) {
+    if (pmg->fPartial) {
         /* Save all moves, even incomplete ones */
         if (cMoves > pml->cMaxMoves)
             pml->cMaxMoves = cMoves;
@@ -2685,23 +3894,23 @@ SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[],
         if (cMoves < pml->cMaxMoves || cPip < pml->cMaxPips)
             return;
 
-        if (cMoves > pml->cMaxMoves || cPip > pml->cMaxPips)
+        if (cMoves > pml->cMaxMoves || cPip > pml->cMaxPips) {
             pml->cMoves = 0;
+            MoveHashClear(pmh);
+        }
 
         pml->cMaxMoves = cMoves;
         pml->cMaxPips = cPip;
     }
 
-    PositionKey(anBoard, &key);
+    for (h = MoveHashKey(pkey); pmh->anStamp[h] == pmh->nStamp; h = (h + 1) & (MOVE_HASH_SIZE - 1)) {
 
-    for (i = 0; i < pml->cMoves; i++) {
-
-        pm = &(pml->amMoves[i]);
+        pm = &(pml->amMoves[pmh->aiMove[h]]);
 
-        if (EqualKeys(key, pm->key)) {
+        if (EqualKeys(*pkey, pm->key)) {
             if (cMoves > pm->cMoves || cPip > pm->cPips) {
-                for (j = 0; j < cMoves * 2; j++)
-                    pm->anMove[j] = anMoves[j] > -1 ? anMoves[j] : -1;
+                for (i = 0; i < cMoves * 2; i++)
+                    pm->anMove[i] = anMoves[i] > -1 ? anMoves[i] : -1;
 
                 if (cMoves < 4)
                     pm->anMove[cMoves * 2] = -1;
@@ -2714,6 +3923,9 @@ SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[],
         }
     }
 
+    pmh->anStamp[h] = pmh->nStamp;
+    pmh->aiMove[h] = (unsigned short) pml->cMoves;
+
     pm = pml->amMoves + pml->cMoves;
 
     for (i = 0; i < cMoves * 2; i++)
@@ -2722,7 +3934,7 @@ SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[],
     if (cMoves < 4)
         pm->anMove[cMoves * 2] = -1;
 
-    CopyKey(key, pm->key);
+    CopyKey(*pkey, pm->key);
 
     pm->cMoves = cMoves;
     pm->cPips = cPip;
@@ -2736,75 +3948,115 @@ SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[],
     g_assert(pml->cMoves < MAX_INCOMPLETE_MOVES);
 }
 
-static int
-LegalMove(const TanBoard anBoard, int iSrc, int nPips)
+static inline int
+LegalMove(const movegen * pmg, int iSrc, int nPips)
 {
-
-    int nBack;
     const int iDest = iSrc - nPips;
 
     if (iDest >= 0) {           /* Here we can do the Chris rule check */
-        return (anBoard[0][23 - iDest] < 2);
+        return (pmg->anBoard[0][23 - iDest] < 2);
     }
     /* otherwise, attempting to bear off */
 
-    for (nBack = 24; nBack > 0; nBack--)
-        if (anBoard[1][nBack] > 0)
-            break;
+    return (pmg->iBack <= 5 && (iSrc == pmg->iBack || iDest == -1));
+}
+
+/* Move a chequer of a legal submove; returns whether it hit */
+static inline int
+MoveChequer(movegen * pmg, int iSrc, int nPips)
+{
+    const int iDest = iSrc - nPips;
+    int fHit = FALSE;
+
+    pmg->anBoard[1][iSrc]--;
+    KeyRemoveChequer(&pmg->key, 1, iSrc);
+
+    if (iDest >= 0) {
+        if (pmg->anBoard[0][23 - iDest]) {
+            pmg->anBoard[0][23 - iDest] = 0;
+            pmg->anBoard[0][24]++;
+            KeyRemoveChequer(&pmg->key, 0, 23 - iDest);
+            KeyAddChequer(&pmg->key, 0, 24);
+            fHit = TRUE;
+        }
+        pmg->anBoard[1][iDest]++;
+        KeyAddChequer(&pmg->key, 1, iDest);
+    }
 
-    return (nBack <= 5 && (iSrc == nBack || iDest == -1));
+    if (iSrc == pmg->iBack)
+        while (pmg->iBack > 0 && !pmg->anBoard[1][pmg->iBack])
+            pmg->iBack--;
+
+    return fHit;
+}
+
+/* Take back MoveChequer(); the caller restores iBack */
+static inline void
+UnmoveChequer(movegen * pmg, int iSrc, int nPips, int fHit)
+{
+    const int iDest = iSrc - nPips;
+
+    pmg->anBoard[1][iSrc]++;
+    KeyAddChequer(&pmg->key, 1, iSrc);
+
+    if (iDest >= 0) {
+        pmg->anBoard[1][iDest]--;
+        KeyRemoveChequer(&pmg->key, 1, iDest);
+        if (fHit) {
+            pmg->anBoard[0][23 - iDest] = 1;
+            pmg->anBoard[0][24]--;
+            KeyAddChequer(&pmg->key, 0, 23 - iDest);
+            KeyRemoveChequer(&pmg->key, 0, 24);
+        }
+    }
 }
 
 static int
-GenerateMovesSub(movelist * pml, int anRoll[], int nMoveDepth,
-                 int iPip, int cPip, const TanBoard anBoard, int anMoves[], int fPartial)
+GenerateMovesSub(movegen * pmg, int nMoveDepth, int iPip, int cPip)
 {
-    int i, fUsed = 0;
-    TanBoard anBoardNew;
+    int i, fHit, iBack, fUsed = 0;
+    int nRoll;
 
-    if (nMoveDepth > 3 || !anRoll[nMoveDepth])
+    if (nMoveDepth > 3 || !(nRoll = pmg->anRoll[nMoveDepth]))
         return TRUE;
 
-    if (anBoard[1][24]) {       /* on bar */
-        if (anBoard[0][anRoll[nMoveDepth] - 1] >= 2)
+    iBack = pmg->iBack;
+
+    if (pmg->anBoard[1][24]) {  /* on bar */
+        if (pmg->anBoard[0][nRoll - 1] >= 2)
             return TRUE;
 
-        anMoves[nMoveDepth * 2] = 24;
-        anMoves[nMoveDepth * 2 + 1] = 24 - anRoll[nMoveDepth];
+        pmg->anMoves[nMoveDepth * 2] = 24;
+        pmg->anMoves[nMoveDepth * 2 + 1] = 24 - nRoll;
 
-        for (i = 0; i < 25; i++) {
-            anBoardNew[0][i] = anBoard[0][i];
-            anBoardNew[1][i] = anBoard[1][i];
-        }
+        fHit = MoveChequer(pmg, 24, nRoll);
 
-        ApplySubMove(anBoardNew, 24, anRoll[nMoveDepth], TRUE);
+        if (GenerateMovesSub(pmg, nMoveDepth + 1, 23, cPip + nRoll))
+            SaveMoves(pmg, nMoveDepth + 1, cPip + nRoll);
 
-        if (GenerateMovesSub(pml, anRoll, nMoveDepth + 1, 23, cPip +
-                             anRoll[nMoveDepth], (ConstTanBoard) anBoardNew, anMoves, fPartial))
-            SaveMoves(pml, nMoveDepth + 1, cPip + anRoll[nMoveDepth], anMoves, (ConstTanBoard) anBoardNew, fPartial);
+        UnmoveChequer(pmg, 24, nRoll, fHit);
+        pmg->iBack = iBack;
 
-        return fPartial;
+        return pmg->fPartial;
     } else {
         for (i = iPip; i >= 0; i--)
-            if (anBoard[1][i] && LegalMove(anBoard, i, anRoll[nMoveDepth])) {
-                anMoves[nMoveDepth * 2] = i;
-                anMoves[nMoveDepth * 2 + 1] = i - anRoll[nMoveDepth];
+            if (pmg->anBoard[1][i] && LegalMove(pmg, i, nRoll)) {
+                pmg->anMoves[nMoveDepth * 2] = i;
+                pmg->anMoves[nMoveDepth * 2 + 1] = i - nRoll;
 
-                memcpy(anBoardNew, anBoard, sizeof(anBoardNew));
+                fHit = MoveChequer(pmg, i, nRoll);
 
-                ApplySubMove(anBoardNew, i, anRoll[nMoveDepth], TRUE);
+                if (GenerateMovesSub(pmg, nMoveDepth + 1, pmg->anRoll[0] == pmg->anRoll[1] ? i : 23, cPip + nRoll))
+                    SaveMoves(pmg, nMoveDepth + 1, cPip + nRoll);
 
-                if (GenerateMovesSub(pml, anRoll, nMoveDepth + 1,
-                                     anRoll[0] == anRoll[1] ? i : 23,
-                                     cPip + anRoll[nMoveDepth], (ConstTanBoard) anBoardNew, anMoves, fPartial))
-                    SaveMoves(pml, nMoveDepth + 1, cPip +
-                              anRoll[nMoveDepth], anMoves, (ConstTanBoard) anBoardNew, fPartial);
+                UnmoveChequer(pmg, i, nRoll, fHit);
+                pmg->iBack = iBack;
 
                 fUsed = 1;
             }
     }
 
-    return !fUsed || fPartial;
+    return !fUsed || pmg->fPartial;
 }
 
 extern int
@@ -2815,13 +4067,32 @@ CompareMoves(const move * pm0, const move * pm1)
     return (pm1->rScore > pm0->rScore || (pm1->rScore == pm0->rScore && pm1->rScore2 > pm0->rScore2)) ? 1 : -1;
 }
 
+/* The "back" chequer of the player who moved and the number of
+ * chequers they have left, read from the nibbles of the key of the
+ * position after the move rather than from the whole board */
+static void
+KeyBackChequer(const positionkey * pkey, int *pBack, int *pcLeft)
+{
+    unsigned int n;
+    int b;
+
+    *pBack = -1;
+    *pcLeft = 0;
+
+    for (b = 0; b <= 24; b++) {
+        n = (b < 24) ? (pkey->data[b >> 3] >> ((b & 7) << 2)) & 0x0f : (pkey->data[6] >> 4) & 0x0f;
+        if (n) {
+            *pBack = b;
+            *pcLeft += (int) n;
+        }
+    }
+}
+
 static int
 CompareMovesGeneral(const move * pm0, const move * pm1)
 {
-    TanBoard board[2];
-    int back[2] = { -1, -1 };
-    int cleft[2] = { 0, 0 };
-    int a, b;
+    int back[2];
+    int cleft[2];
 
     int i = cmp_evalsetup(&pm0->esMove, &pm1->esMove);
 
@@ -2829,16 +4100,8 @@ CompareMovesGeneral(const move * pm0, const move * pm1)
         return -i;              /* sort descending */
 
     /* find the "back" chequer and the number of chequers left */
-    PositionFromKey(board[0], &pm0->key);
-    PositionFromKey(board[1], &pm1->key);
-    for (a = 0; a < 2; a++) {
-        for (b = 0; b <= 24 ; b++) {
-            if (board[a][1][b] > 0) {
-                back[a] = b;
-                cleft[a] += board[a][1][b];
-            }
-        }
-    }
+    KeyBackChequer(&pm0->key, &back[0], &cleft[0]);
+    KeyBackChequer(&pm1->key, &back[1], &cleft[1]);
 
     /* Rounding errors when collating evaluations with lookahead make
      * comparing for equality unreliable. The first check below catches
@@ -2866,26 +4129,104 @@ CompareMovesGeneral(const move * pm0, const move * pm1)
     return (back[0] > back[1] ? 1 : -1);
 }
 
+/* What CompareMoves() looks at, small enough for the sort not to drag
+ * whole moves through the cache; equal scores keep their order */
+typedef struct {
+    float rScore, rScore2;
+    unsigned int i;
+} movesortkey;
+
+static int
+CompareMoveKeys(const movesortkey * pk0, const movesortkey * pk1)
+{
+    if (pk0->rScore != pk1->rScore || pk0->rScore2 != pk1->rScore2)
+        return (pk1->rScore > pk0->rScore || (pk1->rScore == pk0->rScore && pk1->rScore2 > pk0->rScore2)) ? 1 : -1;
+
+    return pk0->i < pk1->i ? -1 : 1;
+}
+
+/* Put the best k of the c moves of am in the order of CompareMoves() at
+ * its start; the moves after them are left undefined when k < c.  The
+ * scores are sorted apart from the moves, of which only the k are
+ * copied. */
+extern void
+SortBestMoves(move * am, unsigned int c, unsigned int k)
+{
+    movesortkey *ak;
+    move *amSorted;
+    scratchmark mark;
+    unsigned int i;
+
+    if (c < 2)
+        return;
+
+    mark = MT_ScratchMark();
+    ak = (movesortkey *) MT_ScratchAlloc(c * sizeof(movesortkey));
+    for (i = 0; i < c; i++) {
+        ak[i].rScore = am[i].rScore;
+        ak[i].rScore2 = am[i].rScore2;
+        ak[i].i = i;
+    }
+
+    qsort(ak, c, sizeof(movesortkey), (cfunc) CompareMoveKeys);
+
+    k = MIN(k, c);
+    amSorted = (move *) MT_ScratchAlloc(k * sizeof(move));
+    for (i = 0; i < k; i++)
+        memcpy(amSorted + i, am + ak[i].i, sizeof(move));
+    memcpy(am, amSorted, k * sizeof(move));
+
+    MT_ScratchRelease(mark);
+}
+
+/* Put the c moves of am in the order of CompareMoves() */
+extern void
+SortMoves(move * am, unsigned int c)
+{
+    SortBestMoves(am, c, c);
+}
+
+static int
+CompareMovePointersGeneral(const move * const *ppm0, const move * const *ppm1)
+{
+    return CompareMovesGeneral(*ppm0, *ppm1);
+}
+
 extern int
 GenerateMoves(movelist * pml, const TanBoard anBoard, int n0, int n1, int fPartial)
 {
 
-    int anRoll[4], anMoves[8];
-    anRoll[0] = n0;
-    anRoll[1] = n1;
+    ThreadLocalData *ptld = MT_GetTLD();
+    movegen mg;
+    guint64 tProfile;
+
+    PROFILE_START(tProfile);
 
-    anRoll[2] = anRoll[3] = ((n0 == n1) ? n0 : 0);
+    mg.pml = pml;
+    mg.pmh = ptld->pMoveHash;
+    mg.fPartial = fPartial;
+    memcpy(mg.anBoard, anBoard, sizeof(mg.anBoard));
+    PositionKey(anBoard, &mg.key);
+    for (mg.iBack = 24; mg.iBack > 0 && !mg.anBoard[1][mg.iBack]; mg.iBack--);
+
+    mg.anRoll[0] = n0;
+    mg.anRoll[1] = n1;
+
+    mg.anRoll[2] = mg.anRoll[3] = ((n0 == n1) ? n0 : 0);
 
     pml->cMoves = pml->cMaxMoves = pml->cMaxPips = pml->iMoveBest = 0;
-    pml->amMoves = MT_Get_aMoves();
-    GenerateMovesSub(pml, anRoll, 0, 23, 0, anBoard, anMoves, fPartial);
+    pml->amMoves = ptld->aMoves;
+    MoveHashClear(mg.pmh);
+    GenerateMovesSub(&mg, 0, 23, 0);
 
-    if (anRoll[0] != anRoll[1]) {
-        swap(anRoll, anRoll + 1);
+    if (mg.anRoll[0] != mg.anRoll[1]) {
+        swap(mg.anRoll, mg.anRoll + 1);
 
-        GenerateMovesSub(pml, anRoll, 0, 23, 0, anBoard, anMoves, fPartial);
+        GenerateMovesSub(&mg, 0, 23, 0);
     }
 
+    PROFILE_STOP(tProfile, PROFILE_MOVEGEN);
+
     return pml->cMoves;
 }
 
@@ -3021,7 +4362,7 @@ static void
 StatusHypergammon1(char *sz)
 {
 
-    BearoffStatus(apbcHyper[0], sz);
+    BearoffStatus(GetBearoffHyper(0), sz);
 
 }
 
@@ -3029,7 +4370,7 @@ static void
 StatusHypergammon2(char *sz)
 {
 
-    BearoffStatus(apbcHyper[1], sz);
+    BearoffStatus(GetBearoffHyper(1), sz);
 
 }
 
@@ -3037,7 +4378,7 @@ static void
 StatusHypergammon3(char *sz)
 {
 
-    BearoffStatus(apbcHyper[2], sz);
+    BearoffStatus(GetBearoffHyper(2), sz);
 
 }
 
@@ -3097,7 +4438,7 @@ StatusOS(char *sz)
 static void
 StatusTS(char *sz)
 {
-    BearoffStatus(pbcTS, sz);
+    BearoffStatus(GetBearoffTS(), sz);
 }
 
 static classstatusfunc acsf[N_CLASSES] = {
@@ -3176,10 +4517,214 @@ GetCubeRecommendation(const cubedecision cd)
 }
 
 
+static void CacheFileChecksum(unsigned char auch[16]);
+static int EvalCacheAttach(void);
+
 extern void
 EvalCacheFlush(void)
 {
+    if (cEval.szShared) {
+        unsigned char auch[16];
+
+        /* CacheFlush() leaves a shared cache alone, so change to a
+         * segment of the new weights and settings if they changed */
+        CacheFileChecksum(auch);
+        if (memcmp(auch, cEval.auchShared, sizeof(auch)))
+            EvalCacheAttach();
+    }
+
     CacheFlush(&cEval);
+    CubefulCacheFlush(&ccEval);
+    OpeningBookClear();
+    MT_SafeInc(&nCacheFlush);
+}
+
+/* The opening book: the move lists FindnSaveBestMoves() found for the
+ * first move of each side, while the player on roll still has the
+ * chequers where they started, by position, dice and everything the
+ * search depends on.  Each of them is searched once a session at a
+ * given strength, however many times analysis, hints and rollouts come
+ * back to it. */
+int fOpeningBook = TRUE;
+
+typedef struct {
+    bookkey bk;
+    unsigned int cMoves;        /* of which cOldMoves at nMaxPly */
+    unsigned int cOldMoves, nMaxPly;
+    unsigned int cMaxMoves, cMaxPips;
+    move *amMoves;
+} bookentry;
+
+static GMutex mutexBook;
+static GHashTable *phtBook;
+
+static guint
+BookKeyHash(gconstpointer p)
+{
+    const unsigned char *pch = (const unsigned char *) p;
+    guint n = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < sizeof(bookkey); i++)
+        n = (n ^ pch[i]) * 16777619u;
+
+    return n;
+}
+
+static gboolean
+BookKeyEqual(gconstpointer p0, gconstpointer p1)
+{
+    return !memcmp(p0, p1, sizeof(bookkey));
+}
+
+static void
+BookEntryFree(gpointer p)
+{
+    bookentry *pbe = (bookentry *) p;
+
+    MemFree(MEM_CACHE, pbe->amMoves, pbe->cMoves * sizeof(move));
+    MemFree(MEM_CACHE, pbe, sizeof(bookentry));
+}
+
+extern void
+OpeningBookClear(void)
+{
+    g_mutex_lock(&mutexBook);
+    if (phtBook)
+        g_hash_table_remove_all(phtBook);
+    g_mutex_unlock(&mutexBook);
+}
+
+/* The key of the search of the moves of anBoard for the book, FALSE if
+ * the book has no business with it: the book is off, the position is
+ * no opening, or the search depends on more than its settings */
+extern int
+OpeningBookKey(bookkey * pbk, const TanBoard anBoard, int nDice0, int nDice1, const cubeinfo * pci,
+               const evalcontext * pec, const movefilter amf[MAX_FILTER_PLIES])
+{
+    TanBoard anStart;
+    unsigned int i;
+
+    if (!fOpeningBook || pec->rNoise != 0.0f || rFilterBudget > 0.0)
+        return FALSE;
+
+    if (pci->bgv == VARIATION_STANDARD)
+        PositionFromID(anStart, "4HPwATDgc/ABMA");
+    else if (pci->bgv == VARIATION_NACKGAMMON)
+        PositionFromID(anStart, "4Dl4ADbgOXgANg");
+    else
+        return FALSE;
+
+    if (memcmp(anBoard[1], anStart[1], sizeof(anStart[1])))
+        return FALSE;
+
+    /* field by field, so that the padding is always zero */
+    memset(pbk, 0, sizeof(bookkey));
+    PositionKey(anBoard, &pbk->key);
+    pbk->anDice[0] = MAX(nDice0, nDice1);
+    pbk->anDice[1] = MIN(nDice0, nDice1);
+    pbk->nEvalKey = EvalKey(pec, (int) pec->nPlies, pci, TRUE);
+    pbk->nPlies = (int) pec->nPlies;
+    pbk->fCubeful = (int) pec->fCubeful;
+    pbk->fUsePrune = (int) pec->fUsePrune;
+    pbk->bgv = (int) pci->bgv;
+    pbk->fAdaptiveFilter = fAdaptiveFilter;
+    pbk->rEarlyExit = rEarlyExit;
+    for (i = 0; i < MAX_FILTER_PLIES; i++) {
+        pbk->anAccept[i] = amf[i].Accept;
+        pbk->anExtra[i] = amf[i].Extra;
+        pbk->arThreshold[i] = amf[i].Threshold;
+    }
+
+    return TRUE;
+}
+
+/* The moves of the search of pbk into pml, in memory of the thread's
+ * scratch arena with fScratch or of the heap otherwise, as
+ * FindnKeepBestMoves() keeps them.  FALSE if the book doesn't have
+ * them. */
+extern int
+OpeningBookLookup(const bookkey * pbk, movelist * pml, unsigned int *pcOldMoves, unsigned int *pnMaxPly,
+                  int fScratch)
+{
+    const bookentry *pbe;
+    size_t cb;
+
+    g_mutex_lock(&mutexBook);
+
+    if (!phtBook || !(pbe = (const bookentry *) g_hash_table_lookup(phtBook, pbk))) {
+        g_mutex_unlock(&mutexBook);
+        return FALSE;
+    }
+
+    cb = pbe->cMoves * sizeof(move);
+    pml->amMoves = (move *) (fScratch ? MT_ScratchAlloc(cb) : g_malloc(cb));
+    memcpy(pml->amMoves, pbe->amMoves, cb);
+    pml->cMoves = pbe->cMoves;
+    pml->cMaxMoves = pbe->cMaxMoves;
+    pml->cMaxPips = pbe->cMaxPips;
+    pml->iMoveBest = 0;
+    pml->rBestScore = pbe->amMoves[0].rScore;
+    *pcOldMoves = pbe->cOldMoves;
+    *pnMaxPly = pbe->nMaxPly;
+
+    g_mutex_unlock(&mutexBook);
+
+    return TRUE;
+}
+
+/* Keep the moves of pml, sorted and all of them there, the first
+ * cOldMoves of them scored at nMaxPly */
+extern void
+OpeningBookAdd(const bookkey * pbk, const movelist * pml, unsigned int cOldMoves, unsigned int nMaxPly)
+{
+    bookentry *pbe;
+
+    if (!pml->cMoves)
+        return;
+
+    pbe = (bookentry *) MemAlloc(MEM_CACHE, sizeof(bookentry));
+    memcpy(&pbe->bk, pbk, sizeof(bookkey));
+    pbe->cMoves = pml->cMoves;
+    pbe->cOldMoves = cOldMoves;
+    pbe->nMaxPly = nMaxPly;
+    pbe->cMaxMoves = pml->cMaxMoves;
+    pbe->cMaxPips = pml->cMaxPips;
+    pbe->amMoves = (move *) MemAlloc(MEM_CACHE, pml->cMoves * sizeof(move));
+    memcpy(pbe->amMoves, pml->amMoves, pml->cMoves * sizeof(move));
+
+    g_mutex_lock(&mutexBook);
+    if (!phtBook)
+        phtBook = g_hash_table_new_full(BookKeyHash, BookKeyEqual, NULL, BookEntryFree);
+    /* the same search on another thread may have been first */
+    g_hash_table_replace(phtBook, &pbe->bk, pbe);
+    g_mutex_unlock(&mutexBook);
+}
+
+extern unsigned int
+OpeningBookSize(void)
+{
+    unsigned int n;
+
+    g_mutex_lock(&mutexBook);
+    n = phtBook ? g_hash_table_size(phtBook) : 0;
+    g_mutex_unlock(&mutexBook);
+
+    return n;
+}
+
+extern int
+EvalGetOpeningBook(void)
+{
+    return fOpeningBook;
+}
+
+extern void
+EvalSetOpeningBook(int f)
+{
+    fOpeningBook = f;
+    if (!f)
+        OpeningBookClear();
 }
 
 void
@@ -3188,6 +4733,205 @@ CommandClearCache(char *UNUSED(sz))
     EvalCacheFlush();
 }
 
+/* The evaluation cache file: a header and the entries of cEval as
+ * written by CacheDump().  The entries only hold hashes of position
+ * and context, so the file is only usable with the same weights and
+ * settings of the evaluator, which are summed up in auchChecksum. */
+
+#define CACHEFILE_MAGIC "gnubgec"
+#define CACHEFILE_FORMAT 2
+
+typedef struct {
+    char szMagic[8];
+    uint32_t nFormat;
+    uint32_t cEntries;
+    unsigned char auchChecksum[16];
+} cachefileheader;
+
+static char *szCacheFile = NULL;
+
+static void
+CacheFileChecksum(unsigned char auch[16])
+{
+    struct md5_ctx ctx;
+    unsigned int i;
+    int an[2];
+
+    md5_init_ctx(&ctx);
+
+    /* all the weight sets, since the cache holds evaluations of each */
+    for (i = 0; i < MAX_WEIGHT_SETS * N_WEIGHT_NETS; i++) {
+        const neuralnet *pnn = aws[i / N_WEIGHT_NETS].apnn[i % N_WEIGHT_NETS];
+
+        if (!aws[i / N_WEIGHT_NETS].szName)
+            continue;
+
+        md5_process_bytes(&pnn->cInput, sizeof(pnn->cInput), &ctx);
+        md5_process_bytes(&pnn->cHidden, sizeof(pnn->cHidden), &ctx);
+        md5_process_bytes(&pnn->cOutput, sizeof(pnn->cOutput), &ctx);
+        md5_process_bytes(pnn->arHiddenWeight, pnn->cInput * pnn->cHidden * sizeof(float), &ctx);
+        md5_process_bytes(pnn->arOutputWeight, pnn->cHidden * pnn->cOutput * sizeof(float), &ctx);
+        md5_process_bytes(pnn->arHiddenThreshold, pnn->cHidden * sizeof(float), &ctx);
+        md5_process_bytes(pnn->arOutputThreshold, pnn->cOutput * sizeof(float), &ctx);
+    }
+
+    an[0] = CACHEFILE_FORMAT;
+    an[1] = fFastSigmoid;
+    md5_process_bytes(an, sizeof(an), &ctx);
+    if (pnbBackend)
+        md5_process_bytes(pnbBackend->szName, strlen(pnbBackend->szName), &ctx);
+
+    md5_finish_ctx(&ctx, auch);
+}
+
+/* The checksum of the weights and evaluator settings, which the results
+ * kept of the evaluations belong to */
+extern void
+EvalChecksum(unsigned char auch[16])
+{
+    CacheFileChecksum(auch);
+}
+
+/* Add the evaluation of the position after the move *pm to cEval as
+ * ScoreMove() found it for the player of *pci, as a saved analysis
+ * brings it back.  TRUE if it was added. */
+extern int
+EvalCacheSeedMove(const move * pm, const cubeinfo * pci)
+{
+    const evalcontext *pec = &pm->esMove.ec;
+    TanBoard anBoard;
+    float ar[NUM_ROLLOUT_OUTPUTS];
+    cubeinfo ci;
+    evalcache ec;
+    uint32_t l;
+
+    /* rollouts and noisy evaluations are not in the cache */
+    if (!cCache || pm->esMove.et != EVAL_EVAL || pec->rNoise != 0.0f)
+        return FALSE;
+
+    PositionFromKeySwapped(anBoard, &pm->key);
+    memcpy(&ci, pci, sizeof(ci));
+    ci.fMove = !ci.fMove;
+
+    /* undo what ScoreMove() did to the evaluation */
+    memcpy(ar, pm->arEvalMove, sizeof(ar));
+    if (pec->fCubeful && ci.nMatchTo)
+        ar[OUTPUT_CUBEFUL_EQUITY] = eq2mwc(ar[OUTPUT_CUBEFUL_EQUITY], pci);
+    InvertEvaluationR(ar, &ci);
+
+    PositionKey((ConstTanBoard) anBoard, &ec.key);
+    ec.nPlies = (int) pec->nPlies;
+    ec.nEvalContext = EvalKey(pec, (int) pec->nPlies, &ci, pec->fCubeful);
+    memcpy(ec.ar, ar, sizeof(float) * NUM_OUTPUTS);
+    ec.ar[5] = pec->fCubeful ? ar[OUTPUT_CUBEFUL_EQUITY] : 0.0f;
+
+    if ((l = CacheLookup(&cEval, &ec, ar, NULL)) == CACHEHIT)
+        return FALSE;
+
+    CacheAdd(&cEval, &ec, l);
+    return TRUE;
+}
+
+/* Add the entries of the cache file sz to cEval, replacing the ones
+ * there if fReplace.  Returns the number added, or -1 if sz is not a
+ * cache file for the current evaluator. */
+static int
+CacheFileRead(const char *sz, int fReplace)
+{
+    GMappedFile *pmf;
+    const cachefileheader *ph;
+    unsigned char auch[16];
+    size_t cb;
+    int n = -1;
+
+    if ((pmf = g_mapped_file_new(sz, FALSE, NULL)) == NULL)
+        return -1;
+
+    ph = (const cachefileheader *) g_mapped_file_get_contents(pmf);
+    cb = g_mapped_file_get_length(pmf);
+    CacheFileChecksum(auch);
+
+    if (cb >= sizeof(cachefileheader) && !strcmp(ph->szMagic, CACHEFILE_MAGIC)
+        && ph->nFormat == CACHEFILE_FORMAT && !memcmp(ph->auchChecksum, auch, sizeof(auch))
+        && ph->cEntries <= (cb - sizeof(cachefileheader)) / sizeof(cacheEntry))
+        n = (int) CacheRestore(&cEval, (const cacheEntry *) (ph + 1), ph->cEntries, fReplace);
+
+    g_mapped_file_unref(pmf);
+
+    return n;
+}
+
+/* Write cEval to the cache file, keeping what other processes saved
+ * there in the entries still unused.  The file is replaced at once so
+ * readers never see half of it. */
+static void
+CacheFileWrite(void)
+{
+    cachefileheader h;
+    char *szTemp;
+    FILE *pf;
+    int fd, n;
+
+    if (!szCacheFile || !cCache)
+        return;
+
+    CacheFileRead(szCacheFile, FALSE);
+
+    memset(&h, 0, sizeof(h));
+    strcpy(h.szMagic, CACHEFILE_MAGIC);
+    h.nFormat = CACHEFILE_FORMAT;
+    CacheFileChecksum(h.auchChecksum);
+
+    szTemp = g_strconcat(szCacheFile, ".XXXXXX", NULL);
+    if ((fd = g_mkstemp(szTemp)) < 0 || (pf = fdopen(fd, "wb")) == NULL) {
+        outputerrf(_("Couldn't write the evaluation cache file %s"), szCacheFile);
+        if (fd >= 0)
+            close(fd);
+        g_free(szTemp);
+        return;
+    }
+
+    if (fwrite(&h, sizeof(h), 1, pf) != 1 || (n = CacheDump(&cEval, pf)) < 0
+        || (h.cEntries = (uint32_t) n, fseek(pf, 0, SEEK_SET)) || fwrite(&h, sizeof(h), 1, pf) != 1) {
+        outputerrf(_("Couldn't write the evaluation cache file %s"), szCacheFile);
+        fclose(pf);
+        g_unlink(szTemp);
+    } else {
+        fclose(pf);
+#if defined(WIN32)
+        g_unlink(szCacheFile);
+#endif
+        if (g_rename(szTemp, szCacheFile))
+            g_unlink(szTemp);
+    }
+
+    g_free(szTemp);
+}
+
+extern const char *
+EvalGetCacheFile(void)
+{
+    return szCacheFile;
+}
+
+/* Use the evaluation cache file sz, or none if NULL.  The entries in it
+ * made with the current weights and settings are added to the cache
+ * now, and the cache is written back to it at shutdown.  Returns the
+ * number of entries added. */
+extern int
+EvalSetCacheFile(const char *sz)
+{
+    int n = 0;
+
+    g_free(szCacheFile);
+    szCacheFile = sz ? g_strdup(sz) : NULL;
+
+    if (szCacheFile && cCache && (n = CacheFileRead(szCacheFile, TRUE)) < 0)
+        n = 0;
+
+    return n;
+}
+
 extern double
 GetEvalCacheSize(void)
 {
@@ -3224,25 +4968,145 @@ GetCacheMB(int size)
     if (size <= 0)
         return 0;
     else
-        return (1 << (size + 15)) * (int) sizeof(cacheNode) / (1024 * 1024);
+        return (int) (CacheMemory(1u << (size + 16)) / (1024 * 1024));
 }
 
 extern int
 EvalCacheResize(unsigned int cNew)
 {
     cCache = CacheResize(&cEval, cNew);
+    EvalAccountMemory();
     return cCache;
 }
 
-#if CACHE_STATS
 extern int
-EvalCacheStats(unsigned int *pcUsed, unsigned int *pcLookup, unsigned int *pcHit)
+EvalGetCacheHugePages(void)
+{
+    return cEval.fHugePages;
+}
+
+/* Put the evaluation cache in huge pages if f, or not.  The cache is
+ * made again, empty.  Returns -1 if that fails. */
+extern int
+EvalSetCacheHugePages(int f)
+{
+    if (f == cEval.fHugePages)
+        return 0;
+
+    cEval.fHugePages = f;
+    if (!cEval.entries)
+        return 0;
+
+    CacheDestroy(&cEval);
+    if (CacheCreate(&cEval, cCache)) {
+        cCache = 0;
+        EvalAccountMemory();
+        return -1;
+    }
+
+    EvalAccountMemory();
+    return 0;
+}
+
+static char *szCacheShared = NULL;
+
+/* Make cEval again, in the shared segment szCacheShared if set.
+ * Returns -1 if that fails. */
+static int
+EvalCacheAttach(void)
+{
+    cEval.szShared = szCacheShared;
+    CacheFileChecksum(cEval.auchShared);
+
+    if (!cEval.entries)
+        return 0;
+
+    CacheDestroy(&cEval);
+    if (CacheCreate(&cEval, cCache)) {
+        cCache = 0;
+        EvalAccountMemory();
+        return -1;
+    }
+
+    cCache = cEval.size;
+    EvalAccountMemory();
+    return 0;
+}
+
+extern const char *
+EvalGetCacheShared(void)
+{
+    return szCacheShared;
+}
+
+/* Put the evaluation cache in the shared memory segment sz, or in
+ * memory of its own if NULL.  The cache then has the size of the
+ * segment if another process made it.  Returns -1 if the cache can't
+ * be made, 1 if it had to be made in memory of its own as the segment
+ * can't be used (see CacheCreate()) and 0 otherwise. */
+extern int
+EvalSetCacheShared(const char *sz)
+{
+    g_free(szCacheShared);
+    /* POSIX names start with a slash */
+    szCacheShared = !sz ? NULL : *sz == '/' ? g_strdup(sz) : g_strconcat("/", sz, NULL);
+
+    if (EvalCacheAttach())
+        return -1;
+
+    return szCacheShared && cEval.pages != CACHE_PAGES_SHARED;
+}
+
+extern cachepages
+EvalGetCachePages(void)
+{
+    return cEval.pages;
+}
+
+/* Spread the evaluation cache over cNodes NUMA nodes, page by page,
+ * or put it back under the default policy if cNodes < 2 */
+extern int
+EvalCacheInterleave(unsigned int cNodes)
+{
+    return CacheInterleave(&cEval, cNodes);
+}
+
+extern int
+EvalGetCacheStats(void)
+{
+    return fCacheStats;
+}
+
+/* Count cache lookups and hits from now on, or stop if !f */
+extern void
+EvalSetCacheStats(int f)
+{
+    if (f && !fCacheStats)
+        memset(aCacheStats, 0, sizeof(aCacheStats));
+
+    fCacheStats = f;
+}
+
+/* The sums of the statistics of all threads.  They are read while the
+ * threads may be counting, so they can be a little behind. */
+extern void
+EvalCacheStats(evalcachestats * pecs, unsigned int *pcUsed, unsigned int *pcUsedPruning)
 {
-    CacheStats(&cEval, pcLookup, pcHit, pcUsed);
-    CacheStats(&cpEval, pcLookup + 1, pcHit + 1, pcUsed + 1);
-    return 0;
+    unsigned int i, j, c = sizeof(evalcachestats) / sizeof(unsigned int);
+
+    memset(pecs, 0, sizeof(evalcachestats));
+    for (i = 0; i < G_N_ELEMENTS(aCacheStats); i++) {
+        const unsigned int *pc = (const unsigned int *) &aCacheStats[i].ecs;
+
+        for (j = 0; j < c; j++)
+            ((unsigned int *) pecs)[j] += pc[j];
+    }
+
+    if (pcUsed)
+        *pcUsed = CacheUsed(&cEval);
+    if (pcUsedPruning)
+        *pcUsedPruning = CacheUsed(&cpEval);
 }
-#endif
 
 extern int
 SetCubeInfoMoney(cubeinfo * pci, const int nCube, const int fCubeOwner,
@@ -3288,11 +5152,6 @@ SetCubeInfoMatch(cubeinfo * pci, const int nCube, const int fCubeOwner,
     pci->fCrawford = fCrawford;
     pci->bgv = bgv;
 
-    /*
-     * FIXME: calculate gammon price when initializing program
-     * instead of recalculating it again and again, or cache it.
-     */
-
     {
 
         int nAway0 = pci->nMatchTo - pci->anScore[0] - 1;
@@ -3300,14 +5159,13 @@ SetCubeInfoMatch(cubeinfo * pci, const int nCube, const int fCubeOwner,
 
         if ((!nAway0 || !nAway1) && !fCrawford) {
             if (!nAway0)
-                memcpy(pci->arGammonPrice, aaaafGammonPricesPostCrawford[LogCube(pci->nCube)]
-                       [nAway1][0], 4 * sizeof(float));
+                memcpy(pci->arGammonPrice, GammonPricesPostCrawford(LogCube(pci->nCube), nAway1, 0),
+                       4 * sizeof(float));
             else
-                memcpy(pci->arGammonPrice, aaaafGammonPricesPostCrawford[LogCube(pci->nCube)]
-                       [nAway0][1], 4 * sizeof(float));
+                memcpy(pci->arGammonPrice, GammonPricesPostCrawford(LogCube(pci->nCube), nAway0, 1),
+                       4 * sizeof(float));
         } else
-            memcpy(pci->arGammonPrice, aaaafGammonPrices[LogCube(pci->nCube)]
-                   [nAway0][nAway1], 4 * sizeof(float));
+            memcpy(pci->arGammonPrice, GammonPrices(LogCube(pci->nCube), nAway0, nAway1), 4 * sizeof(float));
 
     }
 
@@ -3704,8 +5562,39 @@ Cl2CfMoney(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
 }
 
+/* The match equities of the score and cube of pci, from the tables of
+ * the calling thread; a new match equity table flushes the evaluation
+ * cache, and them with it */
+static const scoremet *
+METTable(const cubeinfo * pci)
+{
+    scoremet *pmt = MT_GetTLD()->pMETTables;
+    int nFlush = MT_SafeGet(&nCacheFlush);
+
+    pmt += ((unsigned int) (pci->anScore[0] * 37 + pci->anScore[1]) * 5 + LogCube(pci->nCube) * 2
+            + pci->fCrawford) % MET_TABLES;
+
+    if (pmt->nFlush != nFlush || pmt->nMatchTo != pci->nMatchTo || pmt->anScore[0] != pci->anScore[0]
+        || pmt->anScore[1] != pci->anScore[1] || pmt->nCube != pci->nCube || pmt->fCrawford != pci->fCrawford) {
+        FillMETTable(pmt, pci);
+        pmt->nFlush = nFlush;
+    }
+
+    return pmt;
+}
+
+/* eq2mwc() with the match equities of pmt */
+static inline float
+Eq2MwcMET(const float rEq, const cubeinfo * pci, const scoremet * pmt)
+{
+    float rMwcWin = pmt->aarMwc[pci->fMove][0];
+    float rMwcLose = pmt->aarMwc[pci->fMove][1];
+
+    return 0.5f * (rEq * (rMwcWin - rMwcLose) + (rMwcWin + rMwcLose));
+}
+
 static float
-Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
+Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, const scoremet * pmt, float rCubeX)
 {
 
     /* normalized score */
@@ -3715,7 +5604,7 @@ Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     float rMWCDead, rMWCLive;
     float rMWCOppCash, rMWCCash, rOppTG, rTG;
-    float aarMETResult[2][DTLBP1 + 1];
+    const float (*aarMETResult)[DTLBP1 + 1] = pmt->aaarMET[0];
 
     /* Centered cube */
 
@@ -3739,14 +5628,11 @@ Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     /* MWC(dead cube) = cubeless equity */
 
-    rMWCDead = eq2mwc(Utility(arOutput, pci), pci);
+    rMWCDead = Eq2MwcMET(Utility(arOutput, pci), pci, pmt);
 
     /* Get live cube cash points */
 
-    GetPoints(arOutput, pci, arCP);
-
-    getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
-                  pci->nCube, -1, -1, pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResult[0], aarMETResult[1]);
+    GetPointsMET(arOutput, pci, pmt, arCP);
 
     rMWCCash = aarMETResult[pci->fMove][NDW];
 
@@ -3810,7 +5696,7 @@ Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 }
 
 static float
-Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
+Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, const scoremet * pmt, float rCubeX)
 {
 
     /* normalized score */
@@ -3820,7 +5706,7 @@ Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     float rMWCDead, rMWCLive;
     float rMWCCash, rTG;
-    float aarMETResult[2][DTLBP1 + 1];
+    const float (*aarMETResult)[DTLBP1 + 1] = pmt->aaarMET[0];
 
     /* I own cube */
 
@@ -3844,14 +5730,11 @@ Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     /* MWC(dead cube) = cubeless equity */
 
-    rMWCDead = eq2mwc(Utility(arOutput, pci), pci);
+    rMWCDead = Eq2MwcMET(Utility(arOutput, pci), pci, pmt);
 
     /* Get live cube cash points */
 
-    GetPoints(arOutput, pci, arCP);
-
-    getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
-                  pci->nCube, -1, -1, pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResult[0], aarMETResult[1]);
+    GetPointsMET(arOutput, pci, pmt, arCP);
 
     rMWCCash = aarMETResult[pci->fMove][NDW];
 
@@ -3911,7 +5794,7 @@ Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
 
 static float
-Cl2CfMatchUnavailable(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
+Cl2CfMatchUnavailable(float arOutput[NUM_OUTPUTS], cubeinfo * pci, const scoremet * pmt, float rCubeX)
 {
 
     /* normalized score */
@@ -3921,7 +5804,7 @@ Cl2CfMatchUnavailable(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     float rMWCDead, rMWCLive;
     float rMWCOppCash, rOppTG;
-    float aarMETResult[2][DTLBP1 + 1];
+    const float (*aarMETResult)[DTLBP1 + 1] = pmt->aaarMET[0];
 
     /* I own cube */
 
@@ -3945,14 +5828,11 @@ Cl2CfMatchUnavailable(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     /* MWC(dead cube) = cubeless equity */
 
-    rMWCDead = eq2mwc(Utility(arOutput, pci), pci);
+    rMWCDead = Eq2MwcMET(Utility(arOutput, pci), pci, pmt);
 
     /* Get live cube cash points */
 
-    GetPoints(arOutput, pci, arCP);
-
-    getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
-                  pci->nCube, -1, -1, pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResult[0], aarMETResult[1]);
+    GetPointsMET(arOutput, pci, pmt, arCP);
 
     rMWCOppCash = aarMETResult[pci->fMove][NDL];
 
@@ -4018,19 +5898,21 @@ Cl2CfMatch(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
         /* cubeless eval */
 
-        return eq2mwc(Utility(arOutput, pci), pci);
+        return Eq2MwcMET(Utility(arOutput, pci), pci, METTable(pci));
 
     } /* fDoCubeful */
     else {
 
         /* cubeful eval */
 
+        const scoremet *pmt = METTable(pci);
+
         if (pci->fCubeOwner == -1)
-            return Cl2CfMatchCentered(arOutput, pci, rCubeX);
+            return Cl2CfMatchCentered(arOutput, pci, pmt, rCubeX);
         else if (pci->fCubeOwner == pci->fMove)
-            return Cl2CfMatchOwned(arOutput, pci, rCubeX);
+            return Cl2CfMatchOwned(arOutput, pci, pmt, rCubeX);
         else
-            return Cl2CfMatchUnavailable(arOutput, pci, rCubeX);
+            return Cl2CfMatchUnavailable(arOutput, pci, pmt, rCubeX);
 
     }
 
@@ -4341,6 +6223,11 @@ cmp_evalcontext(const evalcontext * pec1, const evalcontext * pec2)
             return +1;
     }
 
+    if (pec1->iWeights < pec2->iWeights)
+        return -1;
+    else if (pec1->iWeights > pec2->iWeights)
+        return +1;
+
     return 0;
 
 }
@@ -4555,81 +6442,55 @@ getMoneyPoints(float aaarPoints[2][7][2], const int fJacoby, const int fBeavers,
 
 }
 
+/* The cubeful equities arCubeful of the cci cube positions from the
+ * equities arCf of their "no double" and "double, take" positions, as
+ * laid out by MakeCubePos(), and their double/pass equities arDP.
+ * Doubling is right when both of take and pass are at least as good as
+ * no double, and the opponent picks the smaller of the two, which comes
+ * to MAX(rND, MIN(rDT, rDP)).  arDP is -FLT_MAX where the cube can't be
+ * turned, so that reduces to rND without a branch and the loop
+ * vectorises. */
 extern void
-GetECF3(float arCubeful[], int cci, float arCf[], cubeinfo aci[])
+GetECF3(float arCubeful[], int cci, const float arCf[], const float arDP[], int fMoney)
 {
+    /* equities are normed to the cube before doubling */
+    const float rDTScale = fMoney ? 2.0f : 1.0f;
+    int ici;
 
-    int i, ici;
-    float rND, rDT, rDP;
-
-    for (ici = 0, i = 0; ici < cci; ici++, i += 2) {
-
-        if (aci[i + 1].nCube > 0) {
-
-            /* cube available */
-
-            rND = arCf[i];
-
-            if (aci[0].nMatchTo)
-                rDT = arCf[i + 1];
-            else
-                rDT = 2.0f * arCf[i + 1];
-
-            GetDPEq(NULL, &rDP, &aci[i]);
-
-            if (rDT >= rND && rDP >= rND) {
-
-                /* double */
-
-                if (rDT >= rDP)
-                    /* pass */
-                    arCubeful[ici] = rDP;
-                else
-                    /* take */
-                    arCubeful[ici] = rDT;
-
-            } else {
-
-                /* no double */
-
-                arCubeful[ici] = rND;
-
-            }
-
-
-        } else {
-
-            /* no cube available: always no double */
-
-            arCubeful[ici] = arCf[i];
-
-        }
+    for (ici = 0; ici < cci; ici++) {
+        const float rND = arCf[2 * ici];
+        const float rDT = rDTScale * arCf[2 * ici + 1];
+        const float rD = MIN(rDT, arDP[ici]);
 
+        arCubeful[ici] = MAX(rND, rD);
     }
-
 }
 
 
+/* Build the "no double" and "double" cube positions aci of each of
+ * aciCubePos, for the opponent if fInvert.  arDP is set to the
+ * double/pass equity of each of aciCubePos, or -FLT_MAX where it can't
+ * double, for GetECF3(). */
 extern void
-MakeCubePos(const cubeinfo aciCubePos[], const int cci, const int fTop, cubeinfo aci[], const int fInvert)
+MakeCubePos(const cubeinfo aciCubePos[], const int cci, const int fTop, cubeinfo aci[], const int fInvert,
+            float arDP[])
 {
     int i, ici;
 
     for (ici = 0, i = 0; ici < cci; ici++) {
+        const cubeinfo *pci = &aciCubePos[ici];
 
         /* no double */
 
-        if (aciCubePos[ici].nCube > 0) {
+        if (pci->nCube > 0) {
 
             SetCubeInfo(&aci[i],
-                        aciCubePos[ici].nCube,
-                        aciCubePos[ici].fCubeOwner,
+                        pci->nCube,
+                        pci->fCubeOwner,
                         fInvert ?
-                        !aciCubePos[ici].fMove : aciCubePos[ici].fMove,
-                        aciCubePos[ici].nMatchTo,
-                        aciCubePos[ici].anScore,
-                        aciCubePos[ici].fCrawford,
-                        aciCubePos[ici].fJacoby, aciCubePos[ici].fBeavers, aciCubePos[ici].bgv);
+                        !pci->fMove : pci->fMove,
+                        pci->nMatchTo,
+                        pci->anScore, pci->fCrawford, pci->fJacoby, pci->fBeavers, pci->bgv);
 
         } else {
 
@@ -4639,20 +6500,22 @@ MakeCubePos(const cubeinfo aciCubePos[], const int cci, const int fTop, cubeinfo
 
         i++;
 
-        if (!fTop && aciCubePos[ici].nCube > 0 && GetDPEq(NULL, NULL, &aciCubePos[ici]))
+        if (!fTop && pci->nCube > 0 && GetDPEq(NULL, NULL, pci)) {
             /* we may double */
             SetCubeInfo(&aci[i],
-                        2 * aciCubePos[ici].nCube,
-                        !aciCubePos[ici].fMove,
+                        2 * pci->nCube,
+                        !pci->fMove,
                         fInvert ?
-                        !aciCubePos[ici].fMove : aciCubePos[ici].fMove,
-                        aciCubePos[ici].nMatchTo,
-                        aciCubePos[ici].anScore,
-                        aciCubePos[ici].fCrawford,
-                        aciCubePos[ici].fJacoby, aciCubePos[ici].fBeavers, aciCubePos[ici].bgv);
-        else
+                        !pci->fMove : pci->fMove,
+                        pci->nMatchTo, pci->anScore, pci->fCrawford, pci->fJacoby, pci->fBeavers, pci->bgv);
+
+            /* the getME() of GetDPEq(), from the thread's tables */
+            arDP[ici] = pci->nMatchTo ? METTable(pci)->aarMwc[pci->fMove][0] : 1.0f;
+        } else {
             /* mark cube position as unavailable */
             aci[i].nCube = -1;
+            arDP[ici] = -FLT_MAX;
+        }
 
         i++;
 
@@ -5016,40 +6879,40 @@ getPercent(const cubedecision cd, const float arDouble[])
  *   pml: update movelist
  *   ai : the new ordering. Caller must allocate ai.
  *
- * FIXME: the construction of the ai-array is *very* ugly.
- *        We should probably write a substitute for qsort that
- *        updates ai on the fly.
+ * The moves are sorted through pointers, so each is copied only once
+ * and ai[] comes from where the pointers were.
  *
  */
 
 extern void
 RefreshMoveList(movelist * pml, int *ai)
 {
-    movelist ml;
+    move **apm;
+    move *amSorted;
+    scratchmark mark;
+    unsigned int i;
 
     if (!pml->cMoves)
         return;
 
-    if (ai)
-        CopyMoveList(&ml, pml);
-
-    qsort(pml->amMoves, pml->cMoves, sizeof(move), (cfunc) CompareMovesGeneral);
+    mark = MT_ScratchMark();
+    apm = (move **) MT_ScratchAlloc(pml->cMoves * sizeof(move *));
+    for (i = 0; i < pml->cMoves; i++)
+        apm[i] = pml->amMoves + i;
 
-    pml->rBestScore = pml->amMoves[0].rScore;
-
-    if (ai) {
-        for (unsigned int i = 0; i < pml->cMoves; i++) {
+    qsort(apm, pml->cMoves, sizeof(move *), (cfunc) CompareMovePointersGeneral);
 
-            for (unsigned int j = 0; j < pml->cMoves; j++) {
-
-                if (!memcmp(ml.amMoves[j].anMove, pml->amMoves[i].anMove, 8 * sizeof(int)))
-                    ai[j] = i;
+    amSorted = (move *) MT_ScratchAlloc(pml->cMoves * sizeof(move));
+    for (i = 0; i < pml->cMoves; i++) {
+        memcpy(amSorted + i, apm[i], sizeof(move));
+        if (ai)
+            ai[apm[i] - pml->amMoves] = (int) i;
+    }
+    memcpy(pml->amMoves, amSorted, pml->cMoves * sizeof(move));
 
-            }
-        }
+    MT_ScratchRelease(mark);
 
-        g_free(ml.amMoves);
-    }
+    pml->rBestScore = pml->amMoves[0].rScore;
 }
 
 
@@ -5256,13 +7119,18 @@ DoubleType(const int fDoubled, const int fMove, const int fTurn)
 #else
 
 #define FindnSaveBestMoves FindnSaveBestMovesWithLocking
+#define FindnSaveBestMovesStaged FindnSaveBestMovesStagedWithLocking
 #define FindBestMove FindBestMoveWithLocking
 #define EvaluatePosition EvaluatePositionWithLocking
 #define ScoreMove ScoreMoveWithLocking
 #define GeneralCubeDecisionE GeneralCubeDecisionEWithLocking
+#define GeneralCubeDecisionScores GeneralCubeDecisionScoresWithLocking
+#define GeneralCubeDecisionEPlies GeneralCubeDecisionEPliesWithLocking
 #define GeneralEvaluationE GeneralEvaluationEWithLocking
+#define PrefetchMoves PrefetchMovesWithLocking
 #define EvaluatePositionCache EvaluatePositionCacheWithLocking
 #define FindBestMovePlied FindBestMovePliedWithLocking
+#define FindnKeepBestMoves FindnKeepBestMovesWithLocking
 #define GeneralEvaluationEPlied GeneralEvaluationEPliedWithLocking
 #define EvaluatePositionCubeful3 EvaluatePositionCubeful3WithLocking
 #define ScoreMoves ScoreMovesWithLocking
@@ -5270,6 +7138,7 @@ DoubleType(const int fDoubled, const int fMove, const int fTurn)
 #define FindBestMoveInEval FindBestMoveInEvalWithLocking
 #define GeneralEvaluationEPliedCubeful GeneralEvaluationEPliedCubefulWithLocking
 #define EvaluatePositionCubeful4 EvaluatePositionCubeful4WithLocking
+#define EvaluatePositionCubefulPlies EvaluatePositionCubefulPliesWithLocking
 #define CacheAdd CacheAddWithLocking
 #define CacheLookup CacheLookupWithLocking
 
@@ -5279,9 +7148,27 @@ static int EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, flo
 static int FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
                              TanBoard anBoard, const cubeinfo * pci,
                              const evalcontext * pec, int nPlies, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
+static int FindnKeepBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoard, positionkey * keyMove,
+                              const float rThr, const cubeinfo * pci, const evalcontext * pec,
+                              movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], int fScratch,
+                              movestagefunc pfStage, void *pStage);
+
+extern cubefulCache ccEval;
+extern int nCacheFlush;
+extern int fCacheStats;
+extern threadcachestats aCacheStats[MAX_NUMTHREADS + 1];
+extern int fAdaptiveFilter;
+extern double rFilterBudget;
+extern float rEarlyExit;
 
 #endif
 
+static inline evalcachestats *
+ThreadCacheStats(void)
+{
+    return &aCacheStats[MT_GetTLD()->id + 1].ecs;
+}
+
 static int GeneralEvaluationEPlied(NNState * nnStates, float arOutput[NUM_ROLLOUT_OUTPUTS],
                                    const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec, int nPlies);
 static int EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard, float arOutput[NUM_OUTPUTS],
@@ -5313,6 +7200,16 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
     positionclass evalClass = CLASS_OVER;
     unsigned int bmovesi[MAX_PRUNE_MOVES];
     unsigned int prune_moves;
+    TanBoard aanBoard[NN_BATCH_BLOCK];
+    evalcache aec[NN_BATCH_BLOCK];
+    uint32_t al[NN_BATCH_BLOCK];
+    unsigned int ai[NN_BATCH_BLOCK];
+    SSE_ALIGN(float arInputs[NN_BATCH_BLOCK * NUM_PRUNING_INPUTS]);
+    SSE_ALIGN(float arOutputs[NN_BATCH_BLOCK * NUM_OUTPUTS]);
+    unsigned int j, c = 0;
+    int fSameClass = TRUE;
+
+    (void) nnStates;            /* silence compiler warning */
 
     GenerateMoves(&ml, anBoardIn, nDice0, nDice1, FALSE);
 
@@ -5339,76 +7236,107 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
 
     pci->fMove = !pci->fMove;
 
-    for (i = 0; i < ml.cMoves; i++) {
-        positionclass pc;
-        SSE_ALIGN(float arOutput[NUM_OUTPUTS]);
-        evalcache ec;
-        uint32_t l;
-        /* declared volatile to avoid wrong compiler optimization
-         * on some gcc systems. Remove with great care. */
-        move *const volatile pm = &ml.amMoves[i];
+    /* score the moves with the pruning net of their class, evaluating
+     * the ones missing from the cache in blocks of NN_BATCH_BLOCK;
+     * the moves must all be of the same class */
+
+    for (i = 0; i <= ml.cMoves; i++) {
+        if (i < ml.cMoves) {
+            positionclass pc;
+            SSE_ALIGN(float arOutput[NUM_OUTPUTS]);
+            /* declared volatile to avoid wrong compiler optimization
+             * on some gcc systems. Remove with great care. */
+            move *const volatile pm = &ml.amMoves[i];
+
+            PositionFromKeySwapped(aanBoard[c], &pm->key);
+
+            pc = ClassifyPositionStandard((ConstTanBoard) aanBoard[c]);
+            if (i == 0 && pc >= CLASS_RACE)
+                evalClass = pc;
+            else if (i == 0 || pc != evalClass) {
+                fSameClass = FALSE;
+                break;
+            }
+
+            if (EvalGetRaceApprox() && pc == CLASS_RACE) {
+                RaceApprox((ConstTanBoard) aanBoard[c], arOutput, VARIATION_STANDARD);
+                pm->rScore = UtilityME(arOutput, pci);
+                continue;
+            }
 
-        PositionFromKeySwapped(anBoardOut, &pm->key);
+            CopyKey(pm->key, aec[c].key);
+            aec[c].nEvalContext = (int) pec->iWeights;
+            aec[c].nPlies = 0;
+            al[c] = CacheLookup(&cpEval, &aec[c], arOutput, NULL);
+            if (fCacheStats) {
+                evalcachestats *pecs = ThreadCacheStats();
 
-        pc = ClassifyPosition((ConstTanBoard) anBoardOut, VARIATION_STANDARD);
-        if (i == 0) {
-            if (pc < CLASS_RACE)
-                break;
-            evalClass = pc;
-        } else if (pc != evalClass)
-            break;
+                pecs->acPruning[CACHESTATS_LOOKUP][pc]++;
+                if (al[c] == CACHEHIT)
+                    pecs->acPruning[CACHESTATS_HIT][pc]++;
+            }
+            if (al[c] == CACHEHIT) {
+                pm->rScore = UtilityME(arOutput, pci);
+                continue;
+            }
 
-        CopyKey(pm->key, ec.key);
-        ec.nEvalContext = 0;
-        if ((l = CacheLookup(&cpEval, &ec, arOutput, NULL)) != CACHEHIT) {
-            SSE_ALIGN(float arInput[NUM_PRUNING_INPUTS]);
+            baseInputs((ConstTanBoard) aanBoard[c], arInputs + c * NUM_PRUNING_INPUTS);
+            ai[c] = i;
 
-            baseInputs((ConstTanBoard) anBoardOut, arInput);
-            {
-                const neuralnet *nets[] = { &nnpRace, &nnpCrashed, &nnpContact };
-                const neuralnet *n = nets[pc - CLASS_RACE];
-#if defined(USE_SIMD_INSTRUCTIONS)
-                (void) nnStates;        /* silence compiler warning */
-                NeuralNetEvaluateSSE(n, arInput, arOutput, NULL);
-#else
-                if (nnStates)
-                    nnStates[pc - CLASS_RACE].state = (i == 0) ? NNSTATE_INCREMENTAL : NNSTATE_DONE;
-                NeuralNetEvaluate(n, arInput, arOutput, nnStates);
-#endif
-                if (pc == CLASS_RACE)
+            if (++c < NN_BATCH_BLOCK)
+                continue;
+        }
+
+        if (c) {
+            unsigned int k;
+
+            NeuralNetEvaluateBatch(EvalPruningNet(pec->iWeights, evalClass), arInputs, c, arOutputs);
+
+            for (k = 0; k < c; k++) {
+                float *arOutput = arOutputs + k * NUM_OUTPUTS;
+
+                if (evalClass == CLASS_RACE)
                     /* special evaluation of backgammons
                      * overrides net output */
-                    EvalRaceBG((ConstTanBoard) anBoardOut, arOutput, VARIATION_STANDARD);
+                    EvalRaceBG((ConstTanBoard) aanBoard[k], arOutput, VARIATION_STANDARD);
+
+                SanityCheck((ConstTanBoard) aanBoard[k], arOutput);
 
-                SanityCheck((ConstTanBoard) anBoardOut, arOutput);
+                memcpy(aec[k].ar, arOutput, sizeof(float) * NUM_OUTPUTS);
+                aec[k].ar[5] = 0.f;
+                CacheAdd(&cpEval, &aec[k], al[k]);
+                ml.amMoves[ai[k]].rScore = UtilityME(arOutput, pci);
             }
-            memcpy(ec.ar, arOutput, sizeof(float) * NUM_OUTPUTS);
-            ec.ar[5] = 0.f;
-            CacheAdd(&cpEval, &ec, l);
+            c = 0;
         }
-        pm->rScore = UtilityME(arOutput, pci);
-        if (i < prune_moves) {
-            bmovesi[i] = i;
+    }
+
+    /* keep the best prune_moves of them, the first in bmovesi[0] */
+    for (j = 0; fSameClass && j < ml.cMoves; j++) {
+        const move *pm = &ml.amMoves[j];
+
+        if (j < prune_moves) {
+            bmovesi[j] = j;
             if (pm->rScore > ml.amMoves[bmovesi[0]].rScore) {
-                bmovesi[i] = bmovesi[0];
-                bmovesi[0] = i;
+                bmovesi[j] = bmovesi[0];
+                bmovesi[0] = j;
             }
         } else if (pm->rScore < ml.amMoves[bmovesi[0]].rScore) {
             unsigned int m = 0, k;
-            bmovesi[0] = i;
+            bmovesi[0] = j;
             for (k = 1; k < prune_moves; ++k) {
                 if (ml.amMoves[bmovesi[k]].rScore > ml.amMoves[bmovesi[m]].rScore) {
                     m = k;
                 }
             }
             bmovesi[0] = bmovesi[m];
-            bmovesi[m] = i;
+            bmovesi[m] = j;
         }
     }
 
     pci->fMove = !pci->fMove;
 
-    if (i == ml.cMoves)
+    if (fSameClass)
         ScoreMovesPruned(&ml, pci, pec, bmovesi, prune_moves);
     else
         ScoreMoves(&ml, pci, pec, 0);
@@ -5416,66 +7344,143 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
     PositionFromKey(anBoardOut, &ml.amMoves[ml.iMoveBest].key);
 }
 
+/* Whether a plied evaluation should give up, with errno set why: the
+ * user interrupted it, its job was cancelled or the deadline of the
+ * thread has passed */
+static int
+EvalInterrupted(void)
+{
+    double rDeadline = MT_GetTLD()->rDeadline;
+
+    if (MT_Cancelled()) {
+        errno = EINTR;
+        return TRUE;
+    }
+
+    if (rDeadline > 0.0 && get_time() > rDeadline) {
+        errno = ETIMEDOUT;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* The 21 rolls of EvaluatePositionFull(), smaller die second */
+static const int aanRoll[21][2] = {
+    {1, 1}, {2, 1}, {2, 2}, {3, 1}, {3, 2}, {3, 3}, {4, 1},
+    {4, 2}, {4, 3}, {4, 4}, {5, 1}, {5, 2}, {5, 3}, {5, 4},
+    {5, 5}, {6, 1}, {6, 2}, {6, 3}, {6, 4}, {6, 5}, {6, 6}
+};
+
+/* Play the roll n0-n1 in anBoard as well as possible at 0 ply; the
+ * position it leads to goes in anBoardNew, from the opponent's side */
+static void
+PlayRollPlied(NNState * nnStates, const TanBoard anBoard, TanBoard anBoardNew,
+              cubeinfo * const pci, const evalcontext * pec, int n0, int n1)
+{
+    int const usePrune = pec->fUsePrune && pec->rNoise == 0.0f && pci->bgv == VARIATION_STANDARD;
+
+    memcpy(anBoardNew, anBoard, sizeof(TanBoard));
+
+    if (usePrune) {
+        FindBestMoveInEval(nnStates, n0, n1, anBoard, anBoardNew, pci, pec);
+    } else {
+
+        FindBestMovePlied(NULL, n0, n1, anBoardNew, pci, pec, 0, defaultFilters);
+    }
+
+    SwapSides(anBoardNew);
+}
+
+/* The different positions the rolls of one EvaluatePositionFull()
+ * lead to, evaluated by all the threads MT_RunShared() gives it; each
+ * takes the next one not started */
+typedef struct {
+    TanBoard aanBoard[21];
+    int cBoards;
+    cubeinfo ciOpp;
+    const evalcontext *pec;
+    unsigned int nPlies;
+    int iNext;
+    int fError;
+    float aarOutput[21][NUM_OUTPUTS];
+} rollsjob;
+
+static void
+EvaluateRollsShared(void *p)
+{
+    rollsjob *prj = (rollsjob *) p;
+    NNState *nnStates = MT_Get_nnState();
+    int i;
+
+    while (!MT_SafeGet(&prj->fError) && (i = MT_SafeIncCheck(&prj->iNext)) < prj->cBoards)
+        if (EvaluatePositionCache(nnStates, (ConstTanBoard) prj->aanBoard[i], prj->aarOutput[i], &prj->ciOpp,
+                                  prj->pec, prj->nPlies,
+                                  ClassifyPosition((ConstTanBoard) prj->aanBoard[i], prj->ciOpp.bgv)))
+            MT_SafeSet(&prj->fError, TRUE);
+}
+
 static int
 EvaluatePositionFull(NNState * nnStates, const TanBoard anBoard, float arOutput[],
                      cubeinfo * const pci, const evalcontext * pec, unsigned int nPlies, positionclass pc)
 {
-    SSE_ALIGN(float arVariationOutput[NUM_OUTPUTS]);
     int i;
 
     if (pc > CLASS_PERFECT && nPlies > 0) {
         /* internal node; recurse */
 
-        TanBoard anBoardNew;
-        /* int anMove[ 8 ]; */
-        cubeinfo ciOpp;
+        rollsjob rj;
+        positionkey akey[21];
+        float arWeight[21];
         float rTemp;
-        int n0, n1;
+        int j, k;
 
-        int const usePrune = pec->fUsePrune && pec->rNoise == 0.0f && pci->bgv == VARIATION_STANDARD;
+        /* play the rolls; those leading to the same position (bearoffs
+         * and blocked positions have many) share one evaluation,
+         * weighted by how many ways they are rolled */
 
-        for (i = 0; i < NUM_OUTPUTS; i++)
-            arOutput[i] = 0.0;
-
-        /* loop over rolls */
-
-        for (n0 = 1; n0 <= 6; n0++) {
-            for (n1 = 1; n1 <= n0; n1++) {
-                float w = (n0 == n1) ? 1.0f : 2.0f;
-
-                for (i = 0; i < 25; i++) {
-                    anBoardNew[0][i] = anBoard[0][i];
-                    anBoardNew[1][i] = anBoard[1][i];
-                }
-
-                if (MT_SafeGet(&fInterrupt)) {
-                    errno = EINTR;
-                    return -1;
-                }
+        rj.cBoards = 0;
+        for (j = 0; j < 21; j++) {
+            if (EvalInterrupted())
+                return -1;
 
-                if (usePrune) {
-                    FindBestMoveInEval(nnStates, n0, n1, anBoard, anBoardNew, pci, pec);
-                } else {
+            PlayRollPlied(nnStates, anBoard, rj.aanBoard[rj.cBoards], pci, pec, aanRoll[j][0], aanRoll[j][1]);
+            PositionKey((ConstTanBoard) rj.aanBoard[rj.cBoards], &akey[rj.cBoards]);
 
-                    FindBestMovePlied(NULL, n0, n1, anBoardNew, pci, pec, 0, defaultFilters);
-                }
+            for (k = 0; k < rj.cBoards && !EqualKeys(akey[k], akey[rj.cBoards]); k++);
+            if (k == rj.cBoards)
+                arWeight[rj.cBoards++] = 0.0f;
+            arWeight[k] += (aanRoll[j][0] == aanRoll[j][1]) ? 1.0f : 2.0f;
+        }
 
-                SwapSides(anBoardNew);
+        SetCubeInfo(&rj.ciOpp, pci->nCube, pci->fCubeOwner, !pci->fMove,
+                    pci->nMatchTo, pci->anScore, pci->fCrawford, pci->fJacoby, pci->fBeavers, pci->bgv);
 
-                SetCubeInfo(&ciOpp, pci->nCube, pci->fCubeOwner, !pci->fMove,
-                            pci->nMatchTo, pci->anScore, pci->fCrawford, pci->fJacoby, pci->fBeavers, pci->bgv);
+        /* evaluate them, at 2 plies or more on the other threads as
+         * well if they are free; the sum is taken in the same order
+         * either way */
 
-                /* Evaluate at 0-ply */
-                if (EvaluatePositionCache(nnStates, (ConstTanBoard) anBoardNew, arVariationOutput,
-                                          &ciOpp, pec, nPlies - 1,
-                                          ClassifyPosition((ConstTanBoard) anBoardNew, ciOpp.bgv)))
+        if (nPlies > 1) {
+            rj.pec = pec;
+            rj.nPlies = nPlies - 1;
+            rj.iNext = 0;
+            rj.fError = FALSE;
+            MT_RunShared(EvaluateRollsShared, &rj, (unsigned int) rj.cBoards - 1);
+            if (rj.fError)
+                return -1;
+        } else {
+            for (k = 0; k < rj.cBoards; k++)
+                if (EvaluatePositionCache(nnStates, (ConstTanBoard) rj.aanBoard[k], rj.aarOutput[k], &rj.ciOpp,
+                                          pec, 0, ClassifyPosition((ConstTanBoard) rj.aanBoard[k], rj.ciOpp.bgv)))
                     return -1;
+        }
 
-                for (i = 0; i < NUM_OUTPUTS; i++)
-                    arOutput[i] += w *arVariationOutput[i];
-            }
+        for (i = 0; i < NUM_OUTPUTS; i++)
+            arOutput[i] = 0.0;
 
-        }
+        for (k = 0; k < rj.cBoards; k++)
+            for (i = 0; i < NUM_OUTPUTS; i++)
+                arOutput[i] += arWeight[k] * rj.aarOutput[k][i];
 
         /* normalize */
         for (i = 0; i < NUM_OUTPUTS; i++)
@@ -5495,15 +7500,13 @@ EvaluatePositionFull(NNState * nnStates, const TanBoard anBoard, float arOutput[
     } else {
         /* at leaf node; use static evaluation */
 
+        EvalUseWeights(pec->iWeights);
+        MT_GetTLD()->ts.acEval[pc]++;
         if (acef[pc] (anBoard, arOutput, pci->bgv, nnStates))
             return -1;
 
         if (pec->rNoise > 0.0f && pc != CLASS_OVER) {
-            for (i = 0; i < NUM_OUTPUTS; i++) {
-                arOutput[i] += Noise(pec, anBoard, i);
-                arOutput[i] = MAX(arOutput[i], 0.0f);
-                arOutput[i] = MIN(arOutput[i], 1.0f);
-            }
+            AddNoise(pec, anBoard, arOutput);
         }
 
         if (pc > CLASS_GOOD || pec->rNoise > 0.0f)
@@ -5520,7 +7523,12 @@ EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput
                       cubeinfo * const pci, const evalcontext * pecx, int nPlies, positionclass pc)
 {
     evalcache ec;
+    ThreadLocalData *ptld;
+    evalCacheL1 *pl1;
+    unsigned int (*ac)[CACHESTATS_PLIES][N_CLASSES] = NULL;
+    uint64_t check;
     uint32_t l;
+    guint64 tProfile;
     /* This should be a part of the code that is called in all
      * time-consuming operations at a relatively steady rate, so is a
      * good choice for a callback function. */
@@ -5531,7 +7539,41 @@ EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput
     PositionKey(anBoard, &ec.key);
 
     ec.nEvalContext = EvalKey(pecx, nPlies, pci, FALSE);
-    if ((l = CacheLookup(&cEval, &ec, arOutput, NULL)) == CACHEHIT) {
+    ec.nPlies = nPlies;
+
+    ptld = MT_GetTLD();
+    if (fCacheStats) {
+        ac = aCacheStats[ptld->id + 1].ecs.acCubeless;
+        ac[CACHESTATS_LOOKUP][CACHESTATS_PLY(nPlies)][pc]++;
+    }
+
+    PROFILE_START(tProfile);
+
+    pl1 = ptld->pCacheL1;
+    if (pl1->nFlush != MT_SafeGet(&nCacheFlush))
+        CacheL1Flush(pl1, MT_SafeGet(&nCacheFlush));
+
+    if (!(check = CacheL1Lookup(pl1, &ec, arOutput))) {
+        PROFILE_STOP(tProfile, PROFILE_CACHE);
+        if (ac)
+            ac[CACHESTATS_HIT_THREAD][CACHESTATS_PLY(nPlies)][pc]++;
+        ptld->ts.cCacheHit++;
+        return 0;
+    }
+
+    if (ac && ptld->iNode >= 0)
+        aCacheStats[ptld->id + 1].ecs.acNode[CacheNodeOf(&cEval, &ec) != ptld->iNode]++;
+
+    l = CacheLookup(&cEval, &ec, arOutput, NULL);
+    PROFILE_STOP(tProfile, PROFILE_CACHE);
+
+    if (l == CACHEHIT) {
+        if (ac)
+            ac[CACHESTATS_HIT][CACHESTATS_PLY(nPlies)][pc]++;
+        ptld->ts.cCacheHit++;
+        memcpy(ec.ar, arOutput, sizeof(float) * NUM_OUTPUTS);
+        ec.ar[5] = 0.f;
+        CacheL1Add(pl1, &ec, check);
         return 0;
     }
 
@@ -5540,7 +7582,10 @@ EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput
 
     memcpy(ec.ar, arOutput, sizeof(float) * NUM_OUTPUTS);
     ec.ar[5] = 0.f;
-    CacheAdd(&cEval, &ec, l);
+    ptld->ts.cCacheAdd++;
+    if (CacheAdd(&cEval, &ec, l))
+        ptld->ts.cCacheEvict++;
+    CacheL1Add(pl1, &ec, check);
     return 0;
 }
 
@@ -5593,23 +7638,260 @@ ScoreMove(NNState * nnStates, move * pm, const cubeinfo * pci, const evalcontext
     return 0;
 }
 
+/* Positions missing from the evaluation cache, to be evaluated in one
+ * batch by FlushCacheBatch() and added to it */
+typedef struct {
+    TanBoard aanBoard[NN_BATCH_BLOCK];
+    positionclass apc[NN_BATCH_BLOCK];
+    evalcache aec[NN_BATCH_BLOCK];
+    uint32_t al[NN_BATCH_BLOCK];
+    unsigned int c;
+    unsigned int iWeights;      /* weight set to evaluate them with */
+} cachebatch;
+
+/* The cache context of the 0-ply evaluations of the candidates of a
+ * move with pci and pec, or -1 if they are not cached */
+static int
+CacheBatchContext(const cubeinfo * pci, const evalcontext * pec)
+{
+    cubeinfo ci;
+    evalcontext ec = ecBasic;
+
+    /* cubeless evaluations with noise are never cached; the cubeful
+     * ones look up the noiseless 0-ply evaluation with ecBasic */
+    if (!cCache || (!pec->fCubeful && pec->rNoise != 0.0f))
+        return -1;
+
+    memcpy(&ci, pci, sizeof(ci));
+    ci.fMove = !ci.fMove;
+    ec.iWeights = pec->iWeights;
+
+    return EvalKey(pec->fCubeful ? &ec : pec, 0, &ci, FALSE);
+}
+
+static void
+FlushCacheBatch(cachebatch * pcb, const bgvariation bgv)
+{
+    SSE_ALIGN(float aarOutput[NN_BATCH_BLOCK][NUM_OUTPUTS]);
+    threadstats *pts;
+    unsigned int k;
+
+    if (!pcb->c)
+        return;
+
+    EvaluateBatchNN((const TanBoard *) pcb->aanBoard, pcb->apc, pcb->c, bgv, pcb->iWeights, aarOutput);
+
+    pts = &MT_GetTLD()->ts;
+    for (k = 0; k < pcb->c; k++) {
+        memcpy(pcb->aec[k].ar, aarOutput[k], sizeof(float) * NUM_OUTPUTS);
+        pcb->aec[k].ar[5] = 0.f;
+        pts->cCacheAdd++;
+        if (CacheAdd(&cEval, &pcb->aec[k], pcb->al[k]))
+            pts->cCacheEvict++;
+    }
+
+    pcb->c = 0;
+}
+
+/* Add the position after candidate pm to pcb, if it is one for the
+ * nets and not in the cache yet */
+static void
+AddCacheBatch(cachebatch * pcb, const move * pm, int nContext, const bgvariation bgv)
+{
+    SSE_ALIGN(float arOutput[NUM_OUTPUTS]);
+    unsigned int c = pcb->c;
+
+    PositionFromKeySwapped(pcb->aanBoard[c], &pm->key);
+    pcb->apc[c] = ClassifyPosition((ConstTanBoard) pcb->aanBoard[c], bgv);
+    if (pcb->apc[c] < CLASS_RACE)
+        return;
+
+    PositionKeySwapped(&pcb->aec[c].key, &pm->key);
+    pcb->aec[c].nEvalContext = nContext;
+    pcb->aec[c].nPlies = 0;
+    pcb->al[c] = CacheLookup(&cEval, &pcb->aec[c], arOutput, NULL);
+    if (fCacheStats) {
+        evalcachestats *pecs = ThreadCacheStats();
+
+        pecs->acCubeless[CACHESTATS_LOOKUP][0][pcb->apc[c]]++;
+        if (pcb->al[c] == CACHEHIT)
+            pecs->acCubeless[CACHESTATS_HIT][0][pcb->apc[c]]++;
+    }
+    if (pcb->al[c] == CACHEHIT)
+        return;
+
+    if (++pcb->c == NN_BATCH_BLOCK)
+        FlushCacheBatch(pcb, bgv);
+}
+
+/* At 0-ply ScoreMoves() spends most of its time evaluating the
+ * candidate positions one by one with the neural nets.  Evaluate the
+ * ones missing from the evaluation cache in batches first and add
+ * them to the cache, so that the ScoreMove() calls only do lookups. */
+
+static void
+ScoreMovesBatch(const movelist * pml, const cubeinfo * pci, const evalcontext * pec)
+{
+    cachebatch cb;
+    int nContext = CacheBatchContext(pci, pec);
+    unsigned int i;
+
+    if (nContext < 0)
+        return;
+
+    cb.c = 0;
+    cb.iWeights = pec->iWeights;
+    for (i = 0; i < pml->cMoves; i++)
+        AddCacheBatch(&cb, pml->amMoves + i, nContext, pci->bgv);
+    FlushCacheBatch(&cb, pci->bgv);
+}
+
+/* The bearoff database of positions of class pc, if it has one
+ * that BearoffPrefetch() helps */
+static bearoffcontext *
+BearoffOfClass(const positionclass pc)
+{
+    switch (pc) {
+    case CLASS_BEAROFF2:
+        return pbc2;
+    case CLASS_BEAROFF_TS:
+        return GetBearoffTS();
+    case CLASS_BEAROFF1:
+        return pbc1;
+    case CLASS_BEAROFF_OS:
+        return pbcOS;
+    default:
+        return NULL;
+    }
+}
+
+/* In a bearoff position each candidate is a lookup at a place of its
+ * own in a large database.  Ask for all of them before ScoreMove()
+ * reads them one by one, so that the cache misses or disk reads
+ * overlap instead of being waited for in turn. */
+
+static void
+ScoreMovesPrefetch(const movelist * pml, const bgvariation bgv)
+{
+    TanBoard anBoard;
+    bearoffcontext *pbc;
+    unsigned int i;
+
+    for (i = 0; i < pml->cMoves; i++) {
+        PositionFromKeySwapped(anBoard, &pml->amMoves[i].key);
+        if (!(pbc = BearoffOfClass(ClassifyPosition((ConstTanBoard) anBoard, bgv))))
+            /* only done when they all are bearoff positions */
+            return;
+        BearoffPrefetch(pbc, (ConstTanBoard) anBoard);
+    }
+}
+
+/* The same for the n moves of positions aanBoard[] with dice
+ * aanDice[], which are then found by FindBestMove() at 0-ply with
+ * aci[] and apec[], in batches across all of them.  Rollouts play
+ * several games in lockstep to have these batches. */
+
+extern void
+PrefetchMoves(const TanBoard aanBoard[], const unsigned int aanDice[][2], const cubeinfo aci[],
+              const evalcontext * apec[], unsigned int n)
+{
+    cachebatch cb;
+    unsigned int i, j;
+
+    cb.c = 0;
+    cb.iWeights = 0;
+
+    for (i = 0; i < n; i++) {
+        int nContext = CacheBatchContext(aci + i, apec[i]);
+        movelist ml;
+
+        if (nContext < 0 || apec[i]->nPlies)
+            continue;
+
+        /* a batch is evaluated with one weight set */
+        if (apec[i]->iWeights != cb.iWeights) {
+            FlushCacheBatch(&cb, aci[0].bgv);
+            cb.iWeights = apec[i]->iWeights;
+        }
+
+        GenerateMoves(&ml, aanBoard[i], aanDice[i][0], aanDice[i][1], FALSE);
+
+        /* FindBestMove() doesn't evaluate a single legal move */
+        if (ml.cMoves > 1)
+            for (j = 0; j < ml.cMoves; j++)
+                AddCacheBatch(&cb, ml.amMoves + j, nContext, aci[i].bgv);
+    }
+
+    FlushCacheBatch(&cb, aci[0].bgv);
+}
+
+/* The candidates of one ScoreMoves() at 1 ply or more, scored by all
+ * the threads MT_RunShared() gives it; each takes the next one not
+ * started */
+typedef struct {
+    movelist *pml;
+    const cubeinfo *pci;
+    const evalcontext *pec;
+    int nPlies;
+    int iNext;
+    int fError;
+} scoremovesjob;
+
+static void
+ScoreMovesShared(void *p)
+{
+    scoremovesjob *psmj = (scoremovesjob *) p;
+    NNState *nnStates = MT_Get_nnState();
+    int i;
+
+    while (!MT_SafeGet(&psmj->fError) && (i = MT_SafeIncCheck(&psmj->iNext)) < (int) psmj->pml->cMoves)
+        if (ScoreMove(nnStates, psmj->pml->amMoves + i, psmj->pci, psmj->pec, psmj->nPlies) < 0)
+            MT_SafeSet(&psmj->fError, TRUE);
+}
+
 static int
 ScoreMoves(movelist * pml, const cubeinfo * pci, const evalcontext * pec, int nPlies)
 {
     unsigned int i;
     int r = 0;                  /* return value */
+    int fScored = FALSE;
     NNState *nnStates = MT_Get_nnState();
 
     pml->rBestScore = -99999.9f;
 
+    if (nPlies > 0 && pml->cMoves > 1) {
+        /* the candidates are independent; the results don't depend on
+         * which thread scores which */
+        scoremovesjob smj;
+
+        smj.pml = pml;
+        smj.pci = pci;
+        smj.pec = pec;
+        smj.nPlies = nPlies;
+        smj.iNext = 0;
+        smj.fError = FALSE;
+        MT_RunShared(ScoreMovesShared, &smj, pml->cMoves - 1);
+
+        if (smj.fError)
+            return -1;
+        fScored = TRUE;
+    }
+
     if (nPlies == 0) {
+        /* batch the net evaluations of the candidates, or the
+         * bearoff lookups */
+        if (pml->cMoves > 1) {
+            ScoreMovesBatch(pml, pci, pec);
+            ScoreMovesPrefetch(pml, pci->bgv);
+        }
+
         /* start incremental evaluations */
         nnStates[0].state = nnStates[1].state = nnStates[2].state = NNSTATE_INCREMENTAL;
     }
 
 
     for (i = 0; i < pml->cMoves; i++) {
-        if (ScoreMove(nnStates, pml->amMoves + i, pci, pec, nPlies) < 0) {
+        if (!fScored && ScoreMove(nnStates, pml->amMoves + i, pci, pec, nPlies) < 0) {
             r = -1;
             break;
         }
@@ -5668,6 +7950,74 @@ ScoreMovesPruned(movelist * pml, const cubeinfo * pci, const evalcontext * pec,
 
 static movefilter NullFilter = { -1, 0, 0.0 };
 
+/* The number of moves of pml, sorted, that the adaptive filter carries
+ * to the next ply: those before the first gap in the scores of more
+ * than half the threshold of pmf, but at least pmf->Accept of them */
+static unsigned int
+AdaptiveFilterCut(const movelist * pml, const movefilter * pmf)
+{
+    unsigned int i = MAX(pmf->Accept, 1);
+
+    for (; i < pml->cMoves; i++)
+        if (pml->amMoves[i - 1].rScore - pml->amMoves[i].rScore > pmf->Threshold / 2)
+            break;
+
+    return MIN(i, pml->cMoves);
+}
+
+/* Moves ScoreMovesEarlyExit() scores at a time; a constant, so that
+ * the moves it skips don't depend on the number of threads */
+#define EARLY_EXIT_BLOCK 4
+
+/* ScoreMoves() for the moves of pml, sorted by their scores at the ply
+ * before, scoring them EARLY_EXIT_BLOCK at a time.  The moves that
+ * gained most from the deeper look so far bound what the others can
+ * gain: once the next one would still trail the best by more than
+ * rEarlyExit with that gain, it and those after it keep their old
+ * scores and are left out of pml->cMoves. */
+static int
+ScoreMovesEarlyExit(movelist * pml, const cubeinfo * pci, const evalcontext * pec, int nPlies)
+{
+    float *arPrev;
+    float rBest = -99999.9f, rGain = -99999.9f;
+    unsigned int i, cScored = 0;
+
+    if (pml->cMoves <= EARLY_EXIT_BLOCK)
+        return ScoreMoves(pml, pci, pec, nPlies);
+
+    arPrev = (float *) g_alloca(pml->cMoves * sizeof(float));
+    for (i = 0; i < pml->cMoves; i++)
+        arPrev[i] = pml->amMoves[i].rScore;
+
+    while (cScored < pml->cMoves && (!cScored || arPrev[cScored] + rGain + rEarlyExit >= rBest)) {
+        movelist ml;
+
+        ml.cMoves = MIN(EARLY_EXIT_BLOCK, pml->cMoves - cScored);
+        ml.amMoves = pml->amMoves + cScored;
+        ml.iMoveBest = 0;
+        if (ScoreMoves(&ml, pci, pec, nPlies) < 0)
+            return -1;
+
+        for (i = cScored; i < cScored + ml.cMoves; i++) {
+            rBest = MAX(rBest, pml->amMoves[i].rScore);
+            rGain = MAX(rGain, pml->amMoves[i].rScore - arPrev[i]);
+        }
+        cScored += ml.cMoves;
+    }
+
+    pml->cMoves = cScored;
+    pml->rBestScore = -99999.9f;
+    for (i = 0; i < pml->cMoves; i++)
+        if ((pml->amMoves[i].rScore > pml->rBestScore) || ((pml->amMoves[i].rScore == pml->rBestScore)
+                                                           && (pml->amMoves[i].rScore2 >
+                                                               pml->amMoves[pml->iMoveBest].rScore2))) {
+            pml->iMoveBest = i;
+            pml->rBestScore = pml->amMoves[i].rScore;
+        }
+
+    return 0;
+}
+
 static int
 FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
                   TanBoard anBoard,
@@ -5677,6 +8027,7 @@ FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
 
     evalcontext ec;
     movelist ml;
+    scratchmark mark;
     unsigned int i;
 
     memcpy(&ec, pec, sizeof(evalcontext));
@@ -5686,8 +8037,21 @@ FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
         for (i = 0; i < 8; ++i)
             anMove[i] = -1;
 
-    if (FindnSaveBestMoves(&ml, nDice0, nDice1, (ConstTanBoard) anBoard, NULL, 0.0f, pci, &ec, aamf) < 0) {
-        g_free(ml.amMoves);
+    mark = MT_ScratchMark();
+
+    if (nPlies == 0) {
+        /* Scoring at 0 ply generates no moves of its own, so the moves
+         * can be scored where GenerateMoves() left them, and only the
+         * best one is looked for.  A single move needs no score. */
+        GenerateMoves(&ml, (ConstTanBoard) anBoard, nDice0, nDice1, FALSE);
+
+        if (ml.cMoves > 1 && ScoreMoves(&ml, pci, &ec, 0) < 0) {
+            MT_ScratchRelease(mark);
+            return -1;
+        }
+    } else if (FindnKeepBestMoves(&ml, nDice0, nDice1, (ConstTanBoard) anBoard, NULL, 0.0f, pci, &ec, aamf, TRUE,
+                                  NULL, NULL) < 0) {
+        MT_ScratchRelease(mark);
         return -1;
     }
 
@@ -5699,7 +8063,7 @@ FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
     if (ml.cMoves)
         PositionFromKey(anBoard, &ml.amMoves[ml.iMoveBest].key);
 
-    g_free(ml.amMoves);
+    MT_ScratchRelease(mark);
 
     return ml.cMaxMoves * 2;
 }
@@ -5720,6 +8084,30 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
                    float rThr, const cubeinfo * pci, const evalcontext * pec,
                    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
 {
+    return FindnKeepBestMoves(pml, nDice0, nDice1, anBoard, keyMove, rThr, pci, pec, aamf, FALSE, NULL, NULL);
+}
+
+/* As FindnSaveBestMoves(), handing the moves of each filter stage to
+ * pfStage, so that they can be shown before the deeper stages are done */
+extern int
+FindnSaveBestMovesStaged(movelist * pml, int nDice0, int nDice1, const TanBoard anBoard, positionkey * keyMove, const
+                         float rThr, const cubeinfo * pci, const evalcontext * pec,
+                         movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], movestagefunc pfStage, void *pStage)
+{
+    return FindnKeepBestMoves(pml, nDice0, nDice1, anBoard, keyMove, rThr, pci, pec, aamf, FALSE, pfStage, pStage);
+}
+
+/* As FindnSaveBestMoves(), but with fScratch the moves are kept in the
+ * thread's scratch arena instead of the heap; the caller releases them
+ * with MT_ScratchRelease() instead of g_free().  That caller wants the
+ * best move only: the others are left out of order, or undefined.
+ * pfStage, if not NULL, is called as for FindnSaveBestMovesStaged(). */
+static int
+FindnKeepBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoard, positionkey * keyMove, const
+                   float rThr, const cubeinfo * pci, const evalcontext * pec,
+                   movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], int fScratch,
+                   movestagefunc pfStage, void *pStage)
+{
 
     /* Find best moves. 
      * Ensure that keyMove is evaluated at the deepest ply. */
@@ -5730,6 +8118,24 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     movefilter *mFilters;
     unsigned int nMaxPly = 0;
     unsigned int cOldMoves;
+    int fSorted = FALSE;        /* by the scores of the last ply done */
+    double rStart = rFilterBudget > 0.0 ? get_time() : 0.0;
+    bookkey bk;
+    int fBook, fBookHit = FALSE, fBestOnly;
+
+    mFilters = (pec->nPlies > 0 && pec->nPlies <= MAX_FILTER_PLIES) ?
+        aamf[pec->nPlies - 1] : aamf[MAX_FILTER_PLIES - 1];
+
+    fBook = OpeningBookKey(&bk, anBoard, nDice0, nDice1, pci, pec, mFilters);
+    if (fBook && OpeningBookLookup(&bk, pml, &cOldMoves, &nMaxPly, fScratch)) {
+        fBookHit = TRUE;
+        nMoves = pml->cMoves;
+        pml->cMoves = cOldMoves;
+        goto finished;
+    }
+
+    /* the book wants all the moves, in order */
+    fBestOnly = fScratch && !fBook;
 
     /* Find all moves -- note that pml contains internal pointers to static
      * data, so we can't call GenerateMoves again (or anything that calls
@@ -5744,17 +8150,18 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     }
 
     /* Save moves */
+    if (fScratch) {
+        pm = (move *) MT_ScratchAlloc(pml->cMoves * sizeof(move));
+        memcpy(pm, pml->amMoves, pml->cMoves * sizeof(move));
+    } else
 #if GLIB_CHECK_VERSION (2,67,4)
-    pm = (move *) g_memdup2(pml->amMoves, pml->cMoves * sizeof(move));
+        pm = (move *) g_memdup2(pml->amMoves, pml->cMoves * sizeof(move));
 #else
-    pm = (move *) g_memdup(pml->amMoves, pml->cMoves * sizeof(move));
+        pm = (move *) g_memdup(pml->amMoves, pml->cMoves * sizeof(move));
 #endif
     pml->amMoves = pm;
     nMoves = pml->cMoves;
 
-    mFilters = (pec->nPlies > 0 && pec->nPlies <= MAX_FILTER_PLIES) ?
-        aamf[pec->nPlies - 1] : aamf[MAX_FILTER_PLIES - 1];
-
     for (iPly = 0; iPly < pec->nPlies; iPly++) {
 
         movefilter *mFilter = (iPly < MAX_FILTER_PLIES) ? &mFilters[iPly] : &NullFilter;
@@ -5765,15 +8172,26 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
             continue;
         }
 
-        if (ScoreMoves(pml, pci, pec, iPly) < 0) {
-            g_free(pm);
+        if ((fSorted && rEarlyExit > 0.0f ? ScoreMovesEarlyExit(pml, pci, pec, iPly)
+             : ScoreMoves(pml, pci, pec, iPly)) < 0) {
+            if (!fScratch)
+                g_free(pm);
             pml->cMoves = 0;
             pml->amMoves = NULL;
             return -1;
         }
 
-        qsort(pml->amMoves, pml->cMoves, sizeof(move), (cfunc) CompareMoves);
+        /* the best move alone is wanted of the moves in scratch, so
+         * only those the filter may keep are sorted out */
+        if (fBestOnly && !fAdaptiveFilter)
+            SortBestMoves(pml->amMoves, pml->cMoves, (unsigned int) (mFilter->Accept + mFilter->Extra));
+        else
+            SortMoves(pml->amMoves, pml->cMoves);
         pml->iMoveBest = 0;
+        fSorted = TRUE;
+
+        if (pfStage)
+            pfStage(pml, iPly, pStage);
 
         k = pml->cMoves;
         /* we check for mFilter->Accept < 0 above */
@@ -5789,19 +8207,28 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
             }
         }
 
+        if (fAdaptiveFilter)
+            pml->cMoves = AdaptiveFilterCut(pml, mFilter);
+
         nMaxPly = iPly;
 
         if (pml->cMoves == 1 && mFilter->Accept != 1)
             /* if there is only one move to evaluate there is no need to continue */
             goto finished;
 
+        if (rFilterBudget > 0.0 && get_time() - rStart > rFilterBudget * 1000.0)
+            /* out of time; the moves keep their scores at this ply */
+            goto finished;
+
 
     }
 
     /* evaluate moves on top ply */
 
-    if (ScoreMoves(pml, pci, pec, pec->nPlies) < 0) {
-        g_free(pm);
+    if ((fSorted && rEarlyExit > 0.0f ? ScoreMovesEarlyExit(pml, pci, pec, pec->nPlies)
+         : ScoreMoves(pml, pci, pec, pec->nPlies)) < 0) {
+        if (!fScratch)
+            g_free(pm);
         pml->cMoves = 0;
         pml->amMoves = NULL;
         return -1;
@@ -5810,7 +8237,10 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     nMaxPly = pec->nPlies;
 
     /* Resort the moves, in case the new evaluation reordered them. */
-    qsort(pml->amMoves, pml->cMoves, sizeof(move), (cfunc) CompareMoves);
+    if (fBestOnly)
+        SortBestMoves(pml->amMoves, pml->cMoves, 1);
+    else
+        SortMoves(pml->amMoves, pml->cMoves);
     pml->iMoveBest = 0;
 
     /* set the proper size of the movelist */
@@ -5820,6 +8250,9 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     cOldMoves = pml->cMoves;
     pml->cMoves = nMoves;
 
+    if (fBook && !fBookHit)
+        OpeningBookAdd(&bk, pml, cOldMoves, nMaxPly);
+
     /* Make sure that keyMove and top move are both  
      * evaluated at the deepest ply. */
     if (keyMove) {
@@ -5862,7 +8295,7 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
 
                     /* reorder moves evaluated on nMaxPly */
 
-                    qsort(pml->amMoves, cOldMoves + 1, sizeof(move), (cfunc) CompareMoves);
+                    SortMoves(pml->amMoves, cOldMoves + 1);
 
                 }
                 break;
@@ -5918,6 +8351,93 @@ GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
 
 }
 
+/* The most scores evaluated in one walk of the tree */
+#define MAX_SHARED_SCORES 32
+
+/* Whether the positions of pci0 and pci1 are played the same way, so
+ * that one walk of the tree below them serves both: a 0-ply evaluation
+ * only asks the net, but deeper the moves chosen depend on the score
+ * through the gammon prices */
+static int
+SameMoveContext(const cubeinfo * pci0, const cubeinfo * pci1, unsigned int nPlies)
+{
+    if (pci0->fMove != pci1->fMove || pci0->bgv != pci1->bgv)
+        return FALSE;
+
+    if (!nPlies)
+        return TRUE;
+
+    return pci0->nMatchTo == pci1->nMatchTo && pci0->anScore[0] == pci1->anScore[0]
+        && pci0->anScore[1] == pci1->anScore[1] && pci0->fCrawford == pci1->fCrawford
+        && pci0->nCube == pci1->nCube && pci0->fCubeOwner == pci1->fCubeOwner
+        && pci0->fJacoby == pci1->fJacoby && pci0->fBeavers == pci1->fBeavers;
+}
+
+/* GeneralCubeDecisionE() for the cci cube positions aci[], typically
+ * the same cube at many scores: the positions played alike share one
+ * evaluation of anBoard and only the conversion of its probabilities
+ * to cubeful equities (Cl2CfMatch() and the match equity table) is done
+ * for each of them.  The results are those of GeneralCubeDecisionE(). */
+
+extern int
+GeneralCubeDecisionScores(float aaarOutput[][2][NUM_ROLLOUT_OUTPUTS],
+                          const TanBoard anBoard, cubeinfo aci[], int cci, const evalcontext * pec)
+{
+    SSE_ALIGN(float arOutput[NUM_OUTPUTS]);
+    cubeinfo aciCubePos[2 * MAX_SHARED_SCORES];
+    float arCubeful[2 * MAX_SHARED_SCORES];
+    int aiScore[MAX_SHARED_SCORES];
+    int *afDone = (int *) g_alloca(cci * sizeof(int));
+    int i, j, k, n;
+
+    memset(afDone, 0, cci * sizeof(int));
+
+    for (i = 0; i < cci; i++) {
+
+        if (afDone[i])
+            continue;
+
+        /* gather the scores played like this one */
+
+        for (n = 0, j = i; j < cci && n < MAX_SHARED_SCORES; j++) {
+            if (afDone[j] || !SameMoveContext(&aci[i], &aci[j], pec->nPlies))
+                continue;
+
+            afDone[j] = TRUE;
+            aiScore[n] = j;
+
+            /* "no double" and "double, take" */
+
+            memcpy(&aciCubePos[2 * n], &aci[j], sizeof(cubeinfo));
+            memcpy(&aciCubePos[2 * n + 1], &aci[j], sizeof(cubeinfo));
+            aciCubePos[2 * n + 1].fCubeOwner = !aci[j].fMove;
+            aciCubePos[2 * n + 1].nCube *= 2;
+
+            n++;
+        }
+
+        if (EvaluatePositionCubeful3(NULL, anBoard, arOutput, arCubeful, aciCubePos, 2 * n, &aci[i], pec,
+                                     pec->nPlies, TRUE))
+            return -1;
+
+        for (j = 0; j < n; j++) {
+            float (*aarOutput)[NUM_ROLLOUT_OUTPUTS] = aaarOutput[aiScore[j]];
+
+            /* Scale double-take equity */
+            if (!aci[aiScore[j]].nMatchTo)
+                arCubeful[2 * j + 1] *= 2.0f;
+
+            for (k = 0; k < 2; k++) {
+                memcpy(aarOutput[k], arOutput, NUM_OUTPUTS * sizeof(float));
+                aarOutput[k][OUTPUT_EQUITY] = UtilityME(arOutput, &aciCubePos[2 * j + k]);
+                aarOutput[k][OUTPUT_CUBEFUL_EQUITY] = arCubeful[2 * j + k];
+            }
+        }
+    }
+
+    return 0;
+}
+
 extern int
 GeneralEvaluationE(float arOutput[NUM_ROLLOUT_OUTPUTS],
                    const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec)
@@ -5967,6 +8487,85 @@ GeneralEvaluationEPlied(NNState * nnStates, float arOutput[NUM_ROLLOUT_OUTPUTS],
 
 }
 
+/* Play the roll n0-n1 in anBoard as well as possible at 0 ply, giving
+ * the position anBoardNew and its cube pciMoveOpp from the opponent's
+ * side */
+static int
+PlayRollCubeful(NNState * nnStates, const TanBoard anBoard, TanBoard anBoardNew, cubeinfo * pciMoveOpp,
+                cubeinfo * const pciMove, const evalcontext * pec, int n0, int n1)
+{
+    int const usePrune = pec->fUsePrune && pec->rNoise == 0.0f && pciMove->bgv == VARIATION_STANDARD;
+
+    memcpy(anBoardNew, anBoard, sizeof(TanBoard));
+
+    if (EvalInterrupted())
+        return -1;
+
+    if (usePrune) {
+        FindBestMoveInEval(nnStates, n0, n1, anBoard, anBoardNew, pciMove, pec);
+    } else {
+
+        FindBestMovePlied(NULL, n0, n1, anBoardNew, pciMove, pec, 0, defaultFilters);
+    }
+
+    SwapSides(anBoardNew);
+
+    SetCubeInfo(pciMoveOpp,
+                pciMove->nCube, pciMove->fCubeOwner,
+                !pciMove->fMove, pciMove->nMatchTo,
+                pciMove->anScore, pciMove->fCrawford, pciMove->fJacoby, pciMove->fBeavers, pciMove->bgv);
+
+    return 0;
+}
+
+/* Play the roll n0-n1 in anBoard and evaluate the result from the
+ * opponent's side at nPlies - 1, cubeless and for the cci cube
+ * positions aci */
+static int
+EvaluateRollCubeful(NNState * nnStates, const TanBoard anBoard, float arOutput[NUM_OUTPUTS], float arCf[],
+                    const cubeinfo aci[], int cci, cubeinfo * const pciMove, const evalcontext * pec,
+                    unsigned int nPlies, int n0, int n1)
+{
+    TanBoard anBoardNew;
+    cubeinfo ciMoveOpp;
+
+    if (PlayRollCubeful(nnStates, anBoard, anBoardNew, &ciMoveOpp, pciMove, pec, n0, n1))
+        return -1;
+
+    /* Evaluate at 0-ply */
+    return EvaluatePositionCubeful3(nnStates, (ConstTanBoard) anBoardNew,
+                                    arOutput, arCf, aci, cci, &ciMoveOpp, pec, nPlies - 1, FALSE);
+}
+
+/* The rolls of one EvaluatePositionCubeful4(), as rollsjob; the cci
+ * cubeful equities of roll i are at aarCf + i * cci */
+typedef struct {
+    ConstTanBoard anBoard;
+    const cubeinfo *aci;
+    int cci;
+    cubeinfo *pciMove;
+    const evalcontext *pec;
+    unsigned int nPlies;
+    int iNext;
+    int fError;
+    float aarOutput[21][NUM_OUTPUTS];
+    float *aarCf;
+} cubefulrollsjob;
+
+static void
+EvaluateRollsCubefulShared(void *p)
+{
+    cubefulrollsjob *pcrj = (cubefulrollsjob *) p;
+    NNState *nnStates = MT_Get_nnState();
+    int i;
+
+    while (!MT_SafeGet(&pcrj->fError) && (i = MT_SafeIncCheck(&pcrj->iNext)) < 21)
+        if (EvaluateRollCubeful(nnStates, pcrj->anBoard, pcrj->aarOutput[i], pcrj->aarCf + i * pcrj->cci,
+                                pcrj->aci, pcrj->cci, pcrj->pciMove, pcrj->pec, pcrj->nPlies,
+                                aanRoll[i][0], aanRoll[i][1]))
+            MT_SafeSet(&pcrj->fError, TRUE);
+}
+
 static int
 EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
                          float arOutput[NUM_OUTPUTS],
@@ -5980,13 +8579,10 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
     int i;
     positionclass pc;
-    SSE_ALIGN(float ar[NUM_OUTPUTS]);
     float arEquity[4];
 
-    cubeinfo ciMoveOpp;
-
     float *arCf = (float *) g_alloca(2 * cci * sizeof(float));
-    float *arCfTemp = (float *) g_alloca(2 * cci * sizeof(float));
+    float *arDP = (float *) g_alloca(cci * sizeof(float));
     cubeinfo *aci = (cubeinfo *) g_alloca(2 * cci * sizeof(cubeinfo));
 
     pc = ClassifyPosition(anBoard, pciMove->bgv);
@@ -5994,12 +8590,10 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
     if (pc > CLASS_OVER && nPlies > 0 && !(pc <= CLASS_PERFECT && !pciMove->nMatchTo)) {
         /* internal node; recurse */
 
-        TanBoard anBoardNew;
-        int n0, n1;
+        cubefulrollsjob crj;
+        int j;
         float r;
 
-        int const usePrune = pec->fUsePrune && pec->rNoise == 0.0f && pciMove->bgv == VARIATION_STANDARD;
-
         for (i = 0; i < NUM_OUTPUTS; i++)
             arOutput[i] = 0.0;
 
@@ -6008,52 +8602,42 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         /* construct next level cube positions */
 
-        MakeCubePos(aciCubePos, cci, fTop, aci, TRUE);
-
-        /* loop over rolls */
-
-        for (n0 = 1; n0 <= 6; n0++) {
-            for (n1 = 1; n1 <= n0; n1++) {
-                float w = (n0 == n1) ? 1.0f : 2.0f;
-
-                for (i = 0; i < 25; i++) {
-                    anBoardNew[0][i] = anBoard[0][i];
-                    anBoardNew[1][i] = anBoard[1][i];
-                }
-
-                if (MT_SafeGet(&fInterrupt)) {
-                    errno = EINTR;
-                    return -1;
-                }
-
-                if (usePrune) {
-                    FindBestMoveInEval(nnStates, n0, n1, anBoard, anBoardNew, pciMove, pec);
-                } else {
-
-                    FindBestMovePlied(NULL, n0, n1, anBoardNew, pciMove, pec, 0, defaultFilters);
-                }
-
-                SwapSides(anBoardNew);
-
-                SetCubeInfo(&ciMoveOpp,
-                            pciMove->nCube, pciMove->fCubeOwner,
-                            !pciMove->fMove, pciMove->nMatchTo,
-                            pciMove->anScore, pciMove->fCrawford, pciMove->fJacoby, pciMove->fBeavers, pciMove->bgv);
-
-                /* Evaluate at 0-ply */
-                if (EvaluatePositionCubeful3(nnStates, (ConstTanBoard) anBoardNew,
-                                             ar, arCfTemp, aci, 2 * cci, &ciMoveOpp, pec, nPlies - 1, FALSE))
+        MakeCubePos(aciCubePos, cci, fTop, aci, TRUE, arDP);
+
+        /* loop over rolls, at 2 plies or more on the other threads as
+         * well if they are free; the sums are taken in the same order
+         * either way */
+
+        crj.aarCf = (float *) g_alloca(21 * 2 * cci * sizeof(float));
+
+        if (nPlies > 1) {
+            crj.anBoard = anBoard;
+            crj.aci = aci;
+            crj.cci = 2 * cci;
+            crj.pciMove = pciMove;
+            crj.pec = pec;
+            crj.nPlies = nPlies;
+            crj.iNext = 0;
+            crj.fError = FALSE;
+            MT_RunShared(EvaluateRollsCubefulShared, &crj, 20);
+            if (crj.fError)
+                return -1;
+        } else {
+            for (j = 0; j < 21; j++)
+                if (EvaluateRollCubeful(nnStates, anBoard, crj.aarOutput[j], crj.aarCf + j * 2 * cci,
+                                        aci, 2 * cci, pciMove, pec, nPlies, aanRoll[j][0], aanRoll[j][1]))
                     return -1;
+        }
 
-                /* Sum up cubeless winning chances and cubeful equities */
-
-                for (i = 0; i < NUM_OUTPUTS; i++)
-                    arOutput[i] += w *ar[i];
-                for (i = 0; i < 2 * cci; i++)
-                    arCf[i] += w *arCfTemp[i];
+        /* Sum up cubeless winning chances and cubeful equities */
 
-            }
+        for (j = 0; j < 21; j++) {
+            float w = (aanRoll[j][0] == aanRoll[j][1]) ? 1.0f : 2.0f;
 
+            for (i = 0; i < NUM_OUTPUTS; i++)
+                arOutput[i] += w * crj.aarOutput[j][i];
+            for (i = 0; i < 2 * cci; i++)
+                arCf[i] += w * crj.aarCf[j * 2 * cci + i];
         }
 
         /* Flip evals */
@@ -6069,22 +8653,17 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
         arOutput[OUTPUT_WINBACKGAMMON] = arOutput[OUTPUT_LOSEBACKGAMMON] / sumW;
         arOutput[OUTPUT_LOSEBACKGAMMON] = r;
 
-        for (i = 0; i < 2 * cci; i++)
-            if (pciMove->nMatchTo)
+        if (pciMove->nMatchTo)
+            for (i = 0; i < 2 * cci; i++)
                 arCf[i] = 1.0f - arCf[i] / sumW;
-            else
+        else
+            for (i = 0; i < 2 * cci; i++)
                 arCf[i] = -arCf[i] / sumW;
 #undef sumW
 
-        /* invert fMove */
-        /* Remember than fMove was inverted in the call to MakeCubePos */
-
-        for (i = 0; i < 2 * cci; i++)
-            aci[i].fMove = !aci[i].fMove;
-
         /* get cubeful equities */
 
-        GetECF3(arCubeful, cci, arCf, aci);
+        GetECF3(arCubeful, cci, arCf, arDP, !pciMove->nMatchTo);
 
     } else {
         /* at leaf node; use static evaluation */
@@ -6094,7 +8673,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         if (pc == CLASS_HYPERGAMMON1 || pc == CLASS_HYPERGAMMON2 || pc == CLASS_HYPERGAMMON3) {
 
-            bearoffcontext *pbc = apbcHyper[pc - CLASS_HYPERGAMMON1];
+            bearoffcontext *pbc = GetBearoffHyper((unsigned int) (pc - CLASS_HYPERGAMMON1));
             unsigned int nUs, nThem, iPos;
             unsigned int n;
 
@@ -6106,7 +8685,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
             n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
             iPos = nUs * n + nThem;
 
-            if (BearoffHyper(apbcHyper[pc - CLASS_HYPERGAMMON1], iPos, arOutput, arEquity))
+            if (BearoffHyper(GetBearoffHyper((unsigned int) (pc - CLASS_HYPERGAMMON1)), iPos, arOutput, arEquity))
                 return -1;
 
         } else if (pc > CLASS_OVER && pc <= CLASS_PERFECT /* && ! pciMove->nMatchTo */ ) {
@@ -6123,15 +8702,14 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
             /* evaluate with neural net */
 
-            if (EvaluatePosition(nnStates, anBoard, arOutput, pciMove, NULL))
+            evalcontext ec = ecBasic;
+
+            ec.iWeights = pec->iWeights;
+            if (EvaluatePosition(nnStates, anBoard, arOutput, pciMove, &ec))
                 return -1;
 
             if (pec->rNoise > 0.0f && pc != CLASS_OVER) {
-                for (i = 0; i < NUM_OUTPUTS; i++) {
-                    arOutput[i] += Noise(pec, anBoard, i);
-                    arOutput[i] = MAX(arOutput[i], 0.0f);
-                    arOutput[i] = MIN(arOutput[i], 1.0f);
-                }
+                AddNoise(pec, anBoard, arOutput);
             }
 
             if (pc > CLASS_GOOD || pec->rNoise > 0.0f)
@@ -6146,7 +8724,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         /* Build all possible cube positions */
 
-        MakeCubePos(aciCubePos, cci, fTop, aci, FALSE);
+        MakeCubePos(aciCubePos, cci, fTop, aci, FALSE, arDP);
 
         /* Calculate cubeful equity for each possible cube position */
 
@@ -6268,7 +8846,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         /* find optimal of "no double" and "double" */
 
-        GetECF3(arCubeful, cci, arCf, aci);
+        GetECF3(arCubeful, cci, arCf, arDP, !pciMove->nMatchTo);
 
     }
 
@@ -6279,6 +8857,12 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 /* EvaluatePositionCubeful3 is now just a wrapper for ....Cubeful4, which
  * first checks the cache, and then calls ...Cubeful3 */
 
+/* Kept apart from the contexts of the inner nodes in ccEval, the cube
+ * decisions at the top (GeneralCubeDecisionE() and the like, which the
+ * rollouts make every turn) are worked out without a redouble at the
+ * root and come to other equities */
+#define CUBEFUL_CACHE_TOP 0x15a5a5a5
+
 extern int
 EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
                          float arOutput[NUM_OUTPUTS],
@@ -6290,6 +8874,9 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
     int ici;
     int fAll;
     evalcache ec;
+    int fFound = FALSE;
+    uint64_t check = 0;
+    guint64 tProfile;
 
     if (!cCache || pec->rNoise != 0.0f)
         /* non-deterministic evaluation; never cache */
@@ -6299,12 +8886,32 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
     }
 
     PositionKey(anBoard, &ec.key);
+    ec.nPlies = nPlies;
 
     /* check cache for existence for earlier calculation */
 
     fAll = !fTop;               /* FIXME: fTop should be a part of EvalKey */
 
-    for (ici = 0; ici < cci && fAll; ++ici) {
+    PROFILE_START(tProfile);
+
+    /* all the cube positions at once first, then one by one; only
+     * ccEval tells the top apart */
+    if (cci <= CUBEFUL_CACHE_CUBES) {
+        int anContext[CUBEFUL_CACHE_CUBES];
+
+        for (ici = 0; ici < cci; ++ici) {
+            anContext[ici] = aciCubePos[ici].nCube < 0 ? -1 : EvalKey(pec, nPlies, &aciCubePos[ici], TRUE);
+            if (fTop)
+                anContext[ici] ^= CUBEFUL_CACHE_TOP;
+        }
+
+        check = CubefulCacheHash(&ec.key, anContext, (unsigned int) cci);
+        fFound = !CubefulCacheLookup(&ccEval, check, arOutput, arCubeful, (unsigned int) cci);
+        if (fFound)
+            fAll = TRUE;
+    }
+
+    for (ici = 0; ici < cci && fAll && !fFound; ++ici) {
 
         if (aciCubePos[ici].nCube < 0) {
             arCubeful[ici] = -99999.9f;
@@ -6318,6 +8925,17 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
         }
     }
 
+    PROFILE_STOP(tProfile, PROFILE_CACHE);
+
+    if (fCacheStats && !fTop) {
+        evalcachestats *pecs = ThreadCacheStats();
+        positionclass pc = ClassifyPosition(anBoard, pciMove->bgv);
+
+        pecs->acCubeful[CACHESTATS_LOOKUP][CACHESTATS_PLY(nPlies)][pc]++;
+        if (fAll)
+            pecs->acCubeful[CACHESTATS_HIT][CACHESTATS_PLY(nPlies)][pc]++;
+    }
+
     /* get equities */
 
     if (!fAll) {
@@ -6330,6 +8948,7 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
         /* add to cache */
 
         if (!fTop) {
+            threadstats *pts = &MT_GetTLD()->ts;
 
             for (ici = 0; ici < cci; ++ici) {
                 if (aciCubePos[ici].nCube < 0)
@@ -6339,12 +8958,219 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
                 ec.ar[5] = arCubeful[ici];      /* Cubeful equity stored in slot 5 */
                 ec.nEvalContext = EvalKey(pec, nPlies, &aciCubePos[ici], TRUE);
 
-                CacheAdd(&cEval, &ec, GetHashKey(cEval.hashMask, &ec));
+                pts->cCacheAdd++;
+                if (CacheAdd(&cEval, &ec, GetHashKey(cEval.hashMask, &ec)))
+                    pts->cCacheEvict++;
 
             }
         }
+
+        if (check)
+            CubefulCacheAdd(&ccEval, check, arOutput, arCubeful, (unsigned int) cci);
+    } else if (check && !fFound) {
+        /* found one by one, keep them together */
+        CubefulCacheAdd(&ccEval, check, arOutput, arCubeful, (unsigned int) cci);
     }
 
     return 0;
 
 }
+
+/* The rolls of one EvaluatePositionCubefulPlies(), as cubefulrollsjob;
+ * the results of roll i at its nPlies depths are at aarOutput + i *
+ * nPlies and aarCf + i * nPlies * cci */
+typedef struct {
+    ConstTanBoard anBoard;
+    const cubeinfo *aci;
+    int cci;
+    cubeinfo *pciMove;
+    const evalcontext *pec;
+    unsigned int nPlies;
+    int iNext;
+    int fError;
+    float (*aarOutput)[NUM_OUTPUTS];
+    float *aarCf;
+} cubefulpliesjob;
+
+static int EvaluatePositionCubefulPlies(NNState * nnStates, const TanBoard anBoard,
+                                        float aarOutput[][NUM_OUTPUTS], float aarCubeful[],
+                                        const cubeinfo aciCubePos[], int cci, cubeinfo * const pciMove,
+                                        const evalcontext * pec, unsigned int nPlies, int fTop);
+
+static int
+EvaluateRollCubefulPlies(NNState * nnStates, cubefulpliesjob * pcpj, int i)
+{
+    TanBoard anBoardNew;
+    cubeinfo ciMoveOpp;
+
+    if (PlayRollCubeful(nnStates, pcpj->anBoard, anBoardNew, &ciMoveOpp, pcpj->pciMove, pcpj->pec,
+                        aanRoll[i][0], aanRoll[i][1]))
+        return -1;
+
+    return EvaluatePositionCubefulPlies(nnStates, (ConstTanBoard) anBoardNew, pcpj->aarOutput + i * pcpj->nPlies,
+                                        pcpj->aarCf + i * pcpj->nPlies * pcpj->cci, pcpj->aci, pcpj->cci,
+                                        &ciMoveOpp, pcpj->pec, pcpj->nPlies - 1, FALSE);
+}
+
+static void
+EvaluateRollsCubefulPliesShared(void *p)
+{
+    cubefulpliesjob *pcpj = (cubefulpliesjob *) p;
+    NNState *nnStates = MT_Get_nnState();
+    int i;
+
+    while (!MT_SafeGet(&pcpj->fError) && (i = MT_SafeIncCheck(&pcpj->iNext)) < 21)
+        if (EvaluateRollCubefulPlies(nnStates, pcpj, i))
+            MT_SafeSet(&pcpj->fError, TRUE);
+}
+
+/* EvaluatePositionCubeful3() at every depth from 0 to nPlies at once,
+ * aarOutput[n] and aarCubeful + n * cci at n plies.  The moves of the
+ * rolls are chosen at 0 ply whatever the depth, so the tree of the
+ * deepest search holds the shallower ones: the value at n plies is
+ * the average of those of the rolls at n - 1, and only the static
+ * evaluation of the inner nodes is extra.  The leaves of a search take
+ * the cube efficiency of its total depth, so that of a node is made
+ * with pec->nPlies - nPlies, as the search ending there would. */
+static int
+EvaluatePositionCubefulPlies(NNState * nnStates, const TanBoard anBoard,
+                             float aarOutput[][NUM_OUTPUTS], float aarCubeful[],
+                             const cubeinfo aciCubePos[], int cci, cubeinfo * const pciMove,
+                             const evalcontext * pec, unsigned int nPlies, int fTop)
+{
+    positionclass pc = ClassifyPosition(anBoard, pciMove->bgv);
+    evalcontext ec = *pec;
+    unsigned int n;
+    int i;
+
+    ec.nPlies = pec->nPlies - nPlies;
+    if (EvaluatePositionCubeful3(nnStates, anBoard, aarOutput[0], aarCubeful, aciCubePos, cci, pciMove, &ec, 0, fTop))
+        return -1;
+
+    if (pc > CLASS_OVER && nPlies > 0 && !(pc <= CLASS_PERFECT && !pciMove->nMatchTo)) {
+        /* internal node; recurse */
+
+        cubefulpliesjob cpj;
+        float *arCf = (float *) g_alloca(2 * cci * sizeof(float));
+        float *arDP = (float *) g_alloca(cci * sizeof(float));
+        cubeinfo *aci = (cubeinfo *) g_alloca(2 * cci * sizeof(cubeinfo));
+        int j;
+
+        MakeCubePos(aciCubePos, cci, fTop, aci, TRUE, arDP);
+
+        cpj.anBoard = anBoard;
+        cpj.aci = aci;
+        cpj.cci = 2 * cci;
+        cpj.pciMove = pciMove;
+        cpj.pec = pec;
+        cpj.nPlies = nPlies;
+        cpj.iNext = 0;
+        cpj.fError = FALSE;
+        cpj.aarOutput = (float (*)[NUM_OUTPUTS]) g_alloca(21 * nPlies * sizeof(*cpj.aarOutput));
+        cpj.aarCf = (float *) g_alloca(21 * nPlies * 2 * cci * sizeof(float));
+
+        if (nPlies > 1) {
+            MT_RunShared(EvaluateRollsCubefulPliesShared, &cpj, 20);
+            if (cpj.fError)
+                return -1;
+        } else {
+            for (j = 0; j < 21; j++)
+                if (EvaluateRollCubefulPlies(nnStates, &cpj, j))
+                    return -1;
+        }
+
+        /* sum up each depth as EvaluatePositionCubeful4() does */
+
+        for (n = 1; n <= nPlies; n++) {
+            float *arOutput = aarOutput[n];
+            float r;
+
+            for (i = 0; i < NUM_OUTPUTS; i++)
+                arOutput[i] = 0.0;
+
+            for (i = 0; i < 2 * cci; i++)
+                arCf[i] = 0.0;
+
+            for (j = 0; j < 21; j++) {
+                float w = (aanRoll[j][0] == aanRoll[j][1]) ? 1.0f : 2.0f;
+                unsigned int k = (unsigned int) j * nPlies + n - 1;
+
+                for (i = 0; i < NUM_OUTPUTS; i++)
+                    arOutput[i] += w * cpj.aarOutput[k][i];
+                for (i = 0; i < 2 * cci; i++)
+                    arCf[i] += w * cpj.aarCf[k * 2 * cci + i];
+            }
+
+#define sumW 36
+
+            arOutput[OUTPUT_WIN] = 1.0f - arOutput[OUTPUT_WIN] / sumW;
+
+            r = arOutput[OUTPUT_WINGAMMON] / sumW;
+            arOutput[OUTPUT_WINGAMMON] = arOutput[OUTPUT_LOSEGAMMON] / sumW;
+            arOutput[OUTPUT_LOSEGAMMON] = r;
+
+            r = arOutput[OUTPUT_WINBACKGAMMON] / sumW;
+            arOutput[OUTPUT_WINBACKGAMMON] = arOutput[OUTPUT_LOSEBACKGAMMON] / sumW;
+            arOutput[OUTPUT_LOSEBACKGAMMON] = r;
+
+            if (pciMove->nMatchTo)
+                for (i = 0; i < 2 * cci; i++)
+                    arCf[i] = 1.0f - arCf[i] / sumW;
+            else
+                for (i = 0; i < 2 * cci; i++)
+                    arCf[i] = -arCf[i] / sumW;
+#undef sumW
+
+            GetECF3(aarCubeful + n * cci, cci, arCf, arDP, !pciMove->nMatchTo);
+        }
+
+    } else
+        /* a leaf at any depth */
+        for (n = 1; n <= nPlies; n++) {
+            memcpy(aarOutput[n], aarOutput[0], sizeof(aarOutput[0]));
+            memcpy(aarCubeful + n * cci, aarCubeful, cci * sizeof(float));
+        }
+
+    return 0;
+}
+
+/* GeneralCubeDecisionE() at every number of plies from 0 to
+ * pec->nPlies, aaarOutput[n] at n plies, in one search */
+extern int
+GeneralCubeDecisionEPlies(float aaarOutput[][2][NUM_ROLLOUT_OUTPUTS],
+                          const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec)
+{
+    const unsigned int nPlies = pec->nPlies;
+    float (*aarOutput)[NUM_OUTPUTS] = (float (*)[NUM_OUTPUTS]) g_alloca((nPlies + 1) * sizeof(*aarOutput));
+    float *arCubeful = (float *) g_alloca((nPlies + 1) * 2 * sizeof(float));
+    cubeinfo aciCubePos[2];
+    unsigned int n;
+    int i, j;
+
+    /* Setup cube for "no double" and "double, take" */
+
+    memcpy(&aciCubePos[0], pci, sizeof(cubeinfo));
+    memcpy(&aciCubePos[1], pci, sizeof(cubeinfo));
+    aciCubePos[1].fCubeOwner = !aciCubePos[1].fMove;
+    aciCubePos[1].nCube *= 2;
+
+    if (EvaluatePositionCubefulPlies(NULL, anBoard, aarOutput, arCubeful, aciCubePos, 2, pci, pec, nPlies, TRUE))
+        return -1;
+
+    for (n = 0; n <= nPlies; n++) {
+
+        /* Scale double-take equity */
+        if (!pci->nMatchTo)
+            arCubeful[2 * n + 1] *= 2.0f;
+
+        for (i = 0; i < 2; i++) {
+            for (j = 0; j < NUM_OUTPUTS; j++)
+                aaarOutput[n][i][j] = aarOutput[n][j];
+
+            aaarOutput[n][i][OUTPUT_EQUITY] = UtilityME(aarOutput[n], &aciCubePos[i]);
+            aaarOutput[n][i][OUTPUT_CUBEFUL_EQUITY] = arCubeful[2 * n + i];
+        }
+    }
+
+    return 0;
+}
@@ -93,6 +93,7 @@ typedef struct {
     unsigned int fDeterministic:1;
     unsigned int :25;		/* padding */
     float rNoise;               /* standard deviation */
+    unsigned int iWeights;      /* weight set, see EvalLoadWeights() */
 } evalcontext;
 
 /* identifies the format of evaluation info in .sgf files
@@ -126,6 +127,11 @@ typedef struct {
     unsigned int fStopOnJsd:1;
     unsigned int fStopMoveOnJsd:1;      /* stop multi-line rollout when jsd
                                          * is small enough */
+    unsigned int fQuickVarRedn:1;       /* variance reduction from 0-ply
+                                         * evaluations, if not fVarRedn */
+    unsigned int fAdaptiveJsd:1;        /* fewer games for moves JSDs
+                                         * behind the best one */
+    unsigned int fSobol:1;      /* quasi-random dice from a Sobol sequence */
     unsigned short nTruncate;   /* truncation */
     unsigned int nTrials;       /* number of rollouts */
     unsigned short nLate;       /* switch evaluations on move nLate of game */
@@ -138,6 +144,7 @@ typedef struct {
     unsigned int nGamesDone;
     float rStoppedOnJSD;
     int nSkip;
+    unsigned int nMaxSeconds;   /* stop after this long, 0 for no limit */
 } rolloutcontext;
 
 typedef struct {
@@ -286,6 +293,13 @@ extern bearoffcontext *pbc2;
 extern bearoffcontext *pbcOS;
 extern bearoffcontext *pbcTS;
 extern bearoffcontext *apbcHyper[3];
+/* where the heuristic bearoff database is kept for a pool of processes,
+ * which also map all databases with BO_POPULATE; NULL if not pooled */
+extern char *szBearoffShared;
+/* read pbcTS and apbcHyper[] only when first needed */
+extern int fLazyBearoff;
+extern bearoffcontext *GetBearoffTS(void);
+extern bearoffcontext *GetBearoffHyper(unsigned int i);
 
 typedef struct {
     unsigned int cMoves;        /* and current move when building list */
@@ -295,6 +309,16 @@ typedef struct {
     move *amMoves;
 } movelist;
 
+/* The moves found by GenerateMoves(), by position: an entry is used if
+ * its stamp is nStamp, so the set is emptied by a new stamp */
+#define MOVE_HASH_SIZE 8192     /* a power of 2, more than twice MAX_INCOMPLETE_MOVES */
+
+typedef struct {
+    unsigned int nStamp;
+    unsigned int anStamp[MOVE_HASH_SIZE];
+    unsigned short aiMove[MOVE_HASH_SIZE];
+} movehash;
+
 /* cube efficiencies */
 
 extern float rOSCubeX;
@@ -328,6 +352,23 @@ typedef enum {
 
 typedef int (*classevalfunc) (const TanBoard anBoard, float arOutput[], const bgvariation bgv, NNState * nnStates);
 
+/* Evaluation cache statistics, see EvalSetCacheStats() */
+typedef enum {
+    CACHESTATS_LOOKUP,
+    CACHESTATS_HIT_THREAD,      /* found in the cache of the thread */
+    CACHESTATS_HIT,             /* found in the shared cache */
+    N_CACHESTATS
+} cachestatstype;
+
+#define CACHESTATS_PLIES 4      /* 0, 1, 2, and 3 or more plies */
+
+typedef struct {
+    unsigned int acCubeless[N_CACHESTATS][CACHESTATS_PLIES][N_CLASSES];
+    unsigned int acCubeful[N_CACHESTATS][CACHESTATS_PLIES][N_CLASSES];  /* all cube positions of one position */
+    unsigned int acPruning[N_CACHESTATS][N_CLASSES];
+    unsigned int acNode[2];     /* shared cache lookups on the thread's own NUMA node, and on another */
+} evalcachestats;
+
 extern classevalfunc acef[N_CLASSES];
 
 /* Evaluation cache size is 2^SIZE entries */
@@ -371,6 +412,18 @@ EXP_LOCK_FUN(int, FindnSaveBestMoves, movelist * pml,
              positionkey * keyMove, const float rThr,
              const cubeinfo * pci, const evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
 
+/* Called by FindnSaveBestMovesStaged() as each move filter stage short
+ * of the last is done, with the pml->cMoves moves scored at nPlies,
+ * best first.  It runs on the thread doing the search and must copy
+ * what it keeps of pml. */
+typedef void (*movestagefunc) (const movelist * pml, unsigned int nPlies, void *p);
+
+EXP_LOCK_FUN(int, FindnSaveBestMovesStaged, movelist * pml,
+             int nDice0, int nDice1, const TanBoard anBoard,
+             positionkey * keyMove, const float rThr,
+             const cubeinfo * pci, const evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
+             movestagefunc pfStage, void *pStage);
+
 extern void
  PipCount(const TanBoard anBoard, unsigned int anPips[2]);
 
@@ -394,9 +447,47 @@ extern void
 extern int
  GameStatus(const TanBoard anBoard, const bgvariation bgv);
 
+extern int EvalGetAdaptiveFilter(void);
+extern void EvalSetAdaptiveFilter(int f);
+extern double EvalGetFilterBudget(void);
+extern void EvalSetFilterBudget(double r);
+extern float EvalGetEarlyExit(void);
+extern void EvalSetEarlyExit(float r);
+extern int EvalGetRaceApprox(void);
+extern void EvalSetRaceApprox(int f);
+extern int EvalGetOpeningBook(void);
+extern void EvalSetOpeningBook(int f);
+extern int EvalGetFastSigmoid(void);
+extern const nnbackend *EvalGetBackend(void);
+extern void EvalSetBackend(const nnbackend * pnb);
+extern void EvalSetFastSigmoid(int f);
+
+/* Weight sets: set 0 holds the nets EvalInitialise() read, the others
+ * are loaded by name with EvalLoadWeights() and used by the
+ * evaluations whose evalcontext has their number in iWeights */
+#define MAX_WEIGHT_SETS 4
+
+extern int EvalLoadWeights(const char *szName, const char *szFile);
+extern int EvalFindWeights(const char *szName);
+extern const char *EvalWeightsName(unsigned int iWeights);
+
 extern void EvalCacheFlush(void);
+/* incremented by EvalCacheFlush(), as when the weights or settings change */
+extern int nCacheFlush;
+extern void EvalChecksum(unsigned char auch[16]);
+extern int EvalCacheSeedMove(const move * pm, const cubeinfo * pci);
+extern const char *EvalGetCacheFile(void);
+extern int EvalGetCacheHugePages(void);
+extern int EvalSetCacheHugePages(int f);
+extern cachepages EvalGetCachePages(void);
+extern const char *EvalGetCacheShared(void);
+extern int EvalSetCacheShared(const char *sz);
+extern int EvalCacheInterleave(unsigned int cNodes);
+extern int EvalGetCacheStats(void);
+extern void EvalSetCacheStats(int f);
+extern int EvalSetCacheFile(const char *sz);
 extern int EvalCacheResize(unsigned int cNew);
-extern int EvalCacheStats(unsigned int *pcUsed, unsigned int *pcLookup, unsigned int *pcHit);
+extern void EvalCacheStats(evalcachestats * pecs, unsigned int *pcUsed, unsigned int *pcUsedPruning);
 extern double GetEvalCacheSize(void);
 void SetEvalCacheSize(unsigned int size);
 extern unsigned int GetEvalCacheEntries(void);
@@ -413,13 +504,21 @@ extern int ApplySubMove(TanBoard anBoard, const int iSrc, const int nRoll, const
 
 extern int ApplyMove(TanBoard anBoard, const int anMove[8], const int fCheckLegal);
 
+extern int CheckMove(const TanBoard anBoard, const int anMove[8], const unsigned int anDice[2]);
+
 extern positionclass ClassifyPosition(const TanBoard anBoard, const bgvariation bgv);
+extern positionclass ClassifyPositionStandard(const TanBoard anBoard);
 
 /* internal use only */
 extern void EvalRaceBG(const TanBoard anBoard, float arOutput[], const bgvariation bgv);
+extern void RaceApprox(const TanBoard anBoard, float arOutput[NUM_OUTPUTS], const bgvariation bgv);
+extern void EvaluateBatchNN(const TanBoard aanBoard[], const positionclass apc[], unsigned int n,
+                            const bgvariation bgv, unsigned int iWeights, float aarOutput[][NUM_OUTPUTS]);
+extern void EvalUseWeights(unsigned int iWeights);
+extern const neuralnet *EvalPruningNet(unsigned int iWeights, positionclass pc);
 
 extern float
- Utility(float ar[NUM_OUTPUTS], const cubeinfo * pci);
+ Utility(const float ar[NUM_OUTPUTS], const cubeinfo * pci);
 
 extern float
  UtilityME(float ar[NUM_OUTPUTS], const cubeinfo * pci);
@@ -471,6 +570,12 @@ extern cubedecision FindCubeDecision(float arDouble[], float aarOutput[][NUM_ROL
 EXP_LOCK_FUN(int, GeneralCubeDecisionE, float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
              const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec, const evalsetup * pes);
 
+EXP_LOCK_FUN(int, GeneralCubeDecisionScores, float aaarOutput[][2][NUM_ROLLOUT_OUTPUTS],
+             const TanBoard anBoard, cubeinfo aci[], int cci, const evalcontext * pec);
+
+EXP_LOCK_FUN(int, GeneralCubeDecisionEPlies, float aaarOutput[][2][NUM_ROLLOUT_OUTPUTS],
+             const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec);
+
 EXP_LOCK_FUN(int, GeneralEvaluationE, float arOutput[NUM_ROLLOUT_OUTPUTS],
              const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec);
 
@@ -508,6 +613,8 @@ extern void
  RefreshMoveList(movelist * pml, int *ai);
 
 EXP_LOCK_FUN(int, ScoreMove, NNState * nnStates, move * pm, const cubeinfo * pci, const evalcontext * pec, int nPlies);
+EXP_LOCK_FUN(void, PrefetchMoves, const TanBoard aanBoard[], const unsigned int aanDice[][2], const cubeinfo aci[],
+             const evalcontext * apec[], unsigned int n);
 
 extern void
  CopyMoveList(movelist * pmlDest, const movelist * pmlSrc);
@@ -536,14 +643,48 @@ extern int
 extern void
  baseInputs(const TanBoard anBoard, float arInput[]);
 
+extern unsigned int
+ baseInputsSparse(const TanBoard anBoard, unsigned int ai[], float ar[]);
+
+extern void
+ EvalNetInputs(const TanBoard anBoard, positionclass pc, float arInput[]);
+
+extern unsigned int
+ EvalNetInputCount(positionclass pc);
+
 extern int CompareMoves(const move * pm0, const move * pm1);
+extern void SortMoves(move * am, unsigned int c);
+extern void SortBestMoves(move * am, unsigned int c, unsigned int k);
+
+/* What a move search of the opening book depends on, see
+ * OpeningBookKey() */
+typedef struct {
+    positionkey key;
+    int anDice[2];
+    int nEvalKey;
+    int nPlies, fCubeful, fUsePrune, bgv;
+    int anAccept[MAX_FILTER_PLIES], anExtra[MAX_FILTER_PLIES];
+    float arThreshold[MAX_FILTER_PLIES];
+    int fAdaptiveFilter;
+    float rEarlyExit;
+} bookkey;
+
+extern int OpeningBookKey(bookkey * pbk, const TanBoard anBoard, int nDice0, int nDice1, const cubeinfo * pci,
+                          const evalcontext * pec, const movefilter amf[MAX_FILTER_PLIES]);
+extern int OpeningBookLookup(const bookkey * pbk, movelist * pml, unsigned int *pcOldMoves, unsigned int *pnMaxPly,
+                             int fScratch);
+extern void OpeningBookAdd(const bookkey * pbk, const movelist * pml, unsigned int cOldMoves, unsigned int nMaxPly);
+extern void OpeningBookClear(void);
+extern unsigned int OpeningBookSize(void);
 extern float EvalEfficiency(const TanBoard anBoard, positionclass pc, int ply);
 extern float Cl2CfMoney(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX);
 extern float Cl2CfMatch(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX);
 extern float Noise(const evalcontext * pec, const TanBoard anBoard, int iOutput);
+extern void AddNoise(const evalcontext * pec, const TanBoard anBoard, float arOutput[NUM_OUTPUTS]);
 extern int EvalKey(const evalcontext * pec, const int nPlies, const cubeinfo * pci, int fCubefulEquity);
-extern void MakeCubePos(const cubeinfo aciCubePos[], const int cci, const int fTop, cubeinfo aci[], const int fInvert);
-extern void GetECF3(float arCubeful[], int cci, float arCf[], cubeinfo aci[]);
+extern void MakeCubePos(const cubeinfo aciCubePos[], const int cci, const int fTop, cubeinfo aci[], const int fInvert,
+                        float arDP[]);
+extern void GetECF3(float arCubeful[], int cci, const float arCf[], const float arDP[], int fMoney);
 extern int EvaluatePerfectCubeful(const TanBoard anBoard, float arEquity[], const bgvariation bgv);
 
 extern neuralnet nnContact, nnRace, nnCrashed;
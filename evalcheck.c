@@ -0,0 +1,474 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* evalcheck: run a position corpus (see "benchmark save") through the
+ * evaluator and compare the outputs and speed with those of another
+ * build, to check that SIMD code or compiler flags change the speed
+ * and nothing else.
+ *
+ *   evalcheck -o base.txt positions.txt      with the reference build
+ *   evalcheck -b base.txt positions.txt      with the build to check
+ *
+ * The results file is text:
+ *
+ *   gnubg-evalcheck 1
+ *   plies <n>
+ *   time <class> <positions> <nanoseconds per position>
+ *   ...
+ *   <position ID> <dice> <5 outputs> <best move as 8 points>
+ *   ...
+ *
+ * The exit status is 0 if the outputs are within the tolerance and
+ * no class of position is slower by more than the allowed fraction,
+ * 1 if not, 2 on errors. */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <locale.h>
+
+#include "backgammon.h"
+#include "eval.h"
+#include "positionid.h"
+#include "matchequity.h"
+#include "multithread.h"
+#include "glib-ext.h"
+#include "util.h"
+
+#define CORPUS_MAGIC "gnubg-positions"
+#define RESULTS_MAGIC "gnubg-evalcheck"
+#define RESULTS_VERSION 1
+/* positions listed when the outputs differ */
+#define MAX_LISTED 10
+
+static const char *aszClass[N_CLASSES] = {
+    "over", "hypergammon-1", "hypergammon-2", "hypergammon-3", "bearoff2", "bearoff-ts",
+    "bearoff1", "bearoff-os", "race", "crashed", "contact"
+};
+
+typedef struct {
+    char szID[L_POSITIONID + 1];
+    unsigned int anDice[2];
+    positionclass pc;
+    float arOutput[NUM_OUTPUTS];
+    int anMove[8];
+} checkpos;
+
+typedef struct {
+    unsigned int nPlies;
+    unsigned int cPositions;
+    checkpos *acp;
+    unsigned int anClass[N_CLASSES];
+    double arTime[N_CLASSES];   /* nanoseconds per position */
+} checkresults;
+
+extern void
+outputerrf(const char *sz, ...)
+{
+    va_list val;
+    char *szMessage;
+
+    va_start(val, sz);
+    szMessage = g_strdup_vprintf(sz, val);
+    va_end(val);
+
+    g_printerr("%s\n", szMessage);
+    g_free(szMessage);
+}
+
+extern void
+MT_CloseThreads(void)
+{
+    return;
+}
+
+/* Read the positions of a corpus written by "benchmark save".  FALSE
+ * if it can't be read. */
+static int
+ReadCorpus(const char *sz, checkresults * pcr)
+{
+    FILE *pf;
+    char szLine[256];
+    GArray *a;
+    int nVersion;
+
+    if (!(pf = g_fopen(sz, "r"))) {
+        g_printerr(_("Can't open %s\n"), sz);
+        return FALSE;
+    }
+
+    if (!fgets(szLine, sizeof(szLine), pf) || sscanf(szLine, CORPUS_MAGIC " %d", &nVersion) != 1) {
+        g_printerr(_("%s is not a position corpus\n"), sz);
+        fclose(pf);
+        return FALSE;
+    }
+
+    a = g_array_new(FALSE, TRUE, sizeof(checkpos));
+
+    while (fgets(szLine, sizeof(szLine), pf)) {
+        checkpos cp;
+        TanBoard anBoard;
+
+        memset(&cp, 0, sizeof(cp));
+        if (*szLine == '#' || sscanf(szLine, "%14s %1u%1u", cp.szID, &cp.anDice[0], &cp.anDice[1]) != 3)
+            continue;
+
+        if (!PositionFromID(anBoard, cp.szID) || cp.anDice[0] < 1 || cp.anDice[0] > 6
+            || cp.anDice[1] < 1 || cp.anDice[1] > 6)
+            continue;
+
+        cp.pc = ClassifyPosition((ConstTanBoard) anBoard, VARIATION_STANDARD);
+        g_array_append_val(a, cp);
+    }
+
+    fclose(pf);
+
+    pcr->cPositions = a->len;
+    pcr->acp = (checkpos *) (void *) g_array_free(a, FALSE);
+
+    if (!pcr->cPositions) {
+        g_printerr(_("%s holds no positions\n"), sz);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Evaluate the positions and find the best move for their rolls, nRepeat
+ * times, keeping the fastest time of each class of position */
+static int
+RunCorpus(checkresults * pcr, unsigned int nRepeat)
+{
+    evalcontext ec = { FALSE, 0, TRUE, TRUE, 0.0f };
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    cubeinfo ci;
+    guint64 anTime[N_CLASSES];
+    unsigned int i, iRepeat;
+    int j;
+
+    ec.nPlies = pcr->nPlies;
+    memcpy(aamf, defaultFilters, sizeof(aamf));
+    SetCubeInfoMoney(&ci, 1, -1, 0, FALSE, FALSE, VARIATION_STANDARD);
+
+    for (i = 0; i < N_CLASSES; i++)
+        pcr->arTime[i] = HUGE_VAL;
+
+    for (iRepeat = 0; iRepeat < nRepeat; iRepeat++) {
+        /* each pass starts cold, as the first did */
+        EvalCacheFlush();
+        memset(anTime, 0, sizeof(anTime));
+
+        for (i = 0; i < pcr->cPositions; i++) {
+            checkpos *pcp = &pcr->acp[i];
+            TanBoard anBoard;
+            guint64 t = get_time_ns();
+
+            PositionFromID(anBoard, pcp->szID);
+            if (EvaluatePosition(NULL, (ConstTanBoard) anBoard, pcp->arOutput, &ci, &ec) < 0)
+                return -1;
+
+            for (j = 0; j < 8; j++)
+                pcp->anMove[j] = -1;
+            if (FindBestMove(pcp->anMove, (int) pcp->anDice[0], (int) pcp->anDice[1], anBoard, &ci, &ec, aamf) < 0)
+                return -1;
+
+            anTime[pcp->pc] += get_time_ns() - t;
+        }
+
+        for (i = 0; i < N_CLASSES; i++)
+            if (pcr->anClass[i])
+                pcr->arTime[i] = MIN(pcr->arTime[i], (double) anTime[i] / pcr->anClass[i]);
+    }
+
+    return 0;
+}
+
+static int
+WriteResults(const char *sz, const checkresults * pcr)
+{
+    FILE *pf;
+    char szNumber[G_ASCII_DTOSTR_BUF_SIZE];
+    unsigned int i;
+    int j;
+
+    if (!(pf = g_fopen(sz, "w"))) {
+        g_printerr(_("Can't write %s\n"), sz);
+        return -1;
+    }
+
+    fprintf(pf, RESULTS_MAGIC " %d\n", RESULTS_VERSION);
+    fprintf(pf, "plies %u\n", pcr->nPlies);
+    for (i = 0; i < N_CLASSES; i++)
+        if (pcr->anClass[i])
+            fprintf(pf, "time %s %u %s\n", aszClass[i], pcr->anClass[i],
+                    g_ascii_formatd(szNumber, sizeof(szNumber), "%.1f", pcr->arTime[i]));
+
+    for (i = 0; i < pcr->cPositions; i++) {
+        const checkpos *pcp = &pcr->acp[i];
+
+        fprintf(pf, "%s %u%u", pcp->szID, pcp->anDice[0], pcp->anDice[1]);
+        for (j = 0; j < NUM_OUTPUTS; j++)
+            fprintf(pf, " %s", g_ascii_formatd(szNumber, sizeof(szNumber), "%.9g", pcp->arOutput[j]));
+        for (j = 0; j < 8; j++)
+            fprintf(pf, " %d", pcp->anMove[j]);
+        fputc('\n', pf);
+    }
+
+    if (fclose(pf)) {
+        g_printerr(_("Can't write %s\n"), sz);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+ReadResults(const char *sz, checkresults * pcr)
+{
+    FILE *pf;
+    char szLine[512];
+    GArray *a;
+    int nVersion;
+
+    memset(pcr, 0, sizeof(*pcr));
+
+    if (!(pf = g_fopen(sz, "r"))) {
+        g_printerr(_("Can't open %s\n"), sz);
+        return -1;
+    }
+
+    if (!fgets(szLine, sizeof(szLine), pf) || sscanf(szLine, RESULTS_MAGIC " %d", &nVersion) != 1
+        || nVersion != RESULTS_VERSION) {
+        g_printerr(_("%s is not an evalcheck results file of version %d\n"), sz, RESULTS_VERSION);
+        fclose(pf);
+        return -1;
+    }
+
+    a = g_array_new(FALSE, TRUE, sizeof(checkpos));
+
+    while (fgets(szLine, sizeof(szLine), pf)) {
+        gchar **aszField = g_strsplit_set(g_strstrip(szLine), " ", -1);
+        guint cField = g_strv_length(aszField);
+
+        if (cField == 2 && !strcmp(aszField[0], "plies"))
+            pcr->nPlies = (unsigned int) atoi(aszField[1]);
+        else if (cField == 4 && !strcmp(aszField[0], "time")) {
+            int i;
+
+            for (i = 0; i < N_CLASSES; i++)
+                if (!strcmp(aszField[1], aszClass[i])) {
+                    pcr->anClass[i] = (unsigned int) atoi(aszField[2]);
+                    pcr->arTime[i] = g_ascii_strtod(aszField[3], NULL);
+                }
+        } else if (cField == 2 + NUM_OUTPUTS + 8 && strlen(aszField[1]) == 2) {
+            checkpos cp;
+            int j;
+
+            memset(&cp, 0, sizeof(cp));
+            g_strlcpy(cp.szID, aszField[0], sizeof(cp.szID));
+            cp.anDice[0] = (unsigned int) (aszField[1][0] - '0');
+            cp.anDice[1] = (unsigned int) (aszField[1][1] - '0');
+            for (j = 0; j < NUM_OUTPUTS; j++)
+                cp.arOutput[j] = (float) g_ascii_strtod(aszField[2 + j], NULL);
+            for (j = 0; j < 8; j++)
+                cp.anMove[j] = atoi(aszField[2 + NUM_OUTPUTS + j]);
+            g_array_append_val(a, cp);
+        }
+
+        g_strfreev(aszField);
+    }
+
+    fclose(pf);
+
+    pcr->cPositions = a->len;
+    pcr->acp = (checkpos *) (void *) g_array_free(a, FALSE);
+
+    return 0;
+}
+
+/* Report the differences from the baseline.  0 if there are none worth
+ * reporting, 1 if there are, -1 if the two can't be compared. */
+static int
+CompareResults(const checkresults * pcrBase, const checkresults * pcr, double rTolerance, double rSlower)
+{
+    unsigned int i, cDiffer = 0, cMoves = 0;
+    double rMaxDiff = 0.0;
+    int fRegression = FALSE;
+
+    if (pcrBase->nPlies != pcr->nPlies || pcrBase->cPositions != pcr->cPositions) {
+        g_printerr(_("The baseline is of %u positions at %u plies, not %u at %u\n"),
+                   pcrBase->cPositions, pcrBase->nPlies, pcr->cPositions, pcr->nPlies);
+        return -1;
+    }
+
+    for (i = 0; i < pcr->cPositions; i++) {
+        const checkpos *pcpBase = &pcrBase->acp[i];
+        const checkpos *pcp = &pcr->acp[i];
+        double rDiff = 0.0;
+        int j;
+
+        if (strcmp(pcpBase->szID, pcp->szID) || pcpBase->anDice[0] != pcp->anDice[0]
+            || pcpBase->anDice[1] != pcp->anDice[1]) {
+            g_printerr(_("Position %u is %s %u%u in the baseline, not %s %u%u\n"), i + 1,
+                       pcpBase->szID, pcpBase->anDice[0], pcpBase->anDice[1], pcp->szID, pcp->anDice[0],
+                       pcp->anDice[1]);
+            return -1;
+        }
+
+        for (j = 0; j < NUM_OUTPUTS; j++)
+            rDiff = MAX(rDiff, fabs((double) pcp->arOutput[j] - (double) pcpBase->arOutput[j]));
+        rMaxDiff = MAX(rMaxDiff, rDiff);
+
+        if (rDiff > rTolerance && cDiffer++ < MAX_LISTED)
+            g_print(_("%s %u%u: outputs differ by %g\n"), pcp->szID, pcp->anDice[0], pcp->anDice[1], rDiff);
+
+        if (memcmp(pcp->anMove, pcpBase->anMove, sizeof(pcp->anMove)) && cMoves++ < MAX_LISTED)
+            g_print(_("%s %u%u: best move differs\n"), pcp->szID, pcp->anDice[0], pcp->anDice[1]);
+    }
+
+    g_print(_("%u positions, largest difference in outputs %g, %u over %g, %u best moves differ\n"),
+            pcr->cPositions, rMaxDiff, cDiffer, rTolerance, cMoves);
+    if (cDiffer || cMoves)
+        fRegression = TRUE;
+
+    g_print("\n%-14s %9s %12s %12s %8s\n", _("Class"), _("Positions"), _("Baseline ns"), _("ns"), _("Change"));
+    for (i = 0; i < N_CLASSES; i++) {
+        double rChange;
+
+        if (!pcr->anClass[i] || !pcrBase->anClass[i] || pcrBase->arTime[i] <= 0.0)
+            continue;
+
+        rChange = pcr->arTime[i] / pcrBase->arTime[i] - 1.0;
+        g_print("%-14s %9u %12.0f %12.0f %+7.1f%%%s\n", aszClass[i], pcr->anClass[i], pcrBase->arTime[i],
+                pcr->arTime[i], 100.0 * rChange, rChange > rSlower ? _(" slower") : "");
+        if (rChange > rSlower)
+            fRegression = TRUE;
+    }
+
+    return fRegression ? 1 : 0;
+}
+
+extern int
+main(int argc, char **argv)
+{
+    static char *szDataDir = NULL;
+    static char *szOutput = NULL;
+    static char *szBaseline = NULL;
+    static int nPlies = 0;
+    static int nRepeat = 3;
+    static double rTolerance = 1e-5;
+    static double rSlower = 0.05;
+    checkresults cr, crBase;
+    char *szMET, *szWeights, *szWeightsBinary;
+    unsigned int i;
+    int n = 0;
+
+    GOptionEntry ao[] = {
+        {"datadir", 'd', 0, G_OPTION_ARG_FILENAME, &szDataDir,
+         N_("Read the weights and databases from DIR"), "DIR"},
+        {"plies", 'p', 0, G_OPTION_ARG_INT, &nPlies,
+         N_("Evaluate at N plies (default 0)"), "N"},
+        {"repeat", 'r', 0, G_OPTION_ARG_INT, &nRepeat,
+         N_("Time the best of N passes (default 3)"), "N"},
+        {"output", 'o', 0, G_OPTION_ARG_FILENAME, &szOutput,
+         N_("Write the results to FILE"), "FILE"},
+        {"baseline", 'b', 0, G_OPTION_ARG_FILENAME, &szBaseline,
+         N_("Compare with the results in FILE"), "FILE"},
+        {"tolerance", 't', 0, G_OPTION_ARG_DOUBLE, &rTolerance,
+         N_("Largest allowed difference in outputs (default 1e-5)"), "X"},
+        {"slower", 's', 0, G_OPTION_ARG_DOUBLE, &rSlower,
+         N_("Largest allowed slowdown as a fraction (default 0.05)"), "X"},
+        {NULL, 0, 0, (GOptionArg) 0, NULL, NULL, NULL}
+    };
+    GError *error = NULL;
+    GOptionContext *context;
+
+    setlocale(LC_ALL, "");
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+
+    context = g_option_context_new(_("corpus"));
+    g_option_context_add_main_entries(context, ao, PACKAGE);
+    g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (error) {
+        g_printerr("%s\n", error->message);
+        exit(2);
+    }
+
+    if (argc != 2 || (!szOutput && !szBaseline)) {
+        g_printerr(_("A position corpus and -o or -b should be given\n"
+                     "For more help try `evalcheck --help'\n"));
+        exit(2);
+    }
+
+    if (nPlies < 0 || nPlies >= MAX_FILTER_PLIES || nRepeat < 1) {
+        g_printerr(_("The plies must be from 0 to %d and the repeat count positive\n"), MAX_FILTER_PLIES - 1);
+        exit(2);
+    }
+
+    memset(&cr, 0, sizeof(cr));
+    cr.nPlies = (unsigned int) nPlies;
+    if (!ReadCorpus(argv[1], &cr))
+        exit(2);
+    for (i = 0; i < cr.cPositions; i++)
+        cr.anClass[cr.acp[i].pc]++;
+
+    if (szDataDir) {
+        g_free(pkg_datadir);
+        pkg_datadir = g_strdup(szDataDir);
+    }
+
+    glib_ext_init();
+    MT_InitThreads();
+
+    szMET = BuildFilename2("met", "Kazaross-XG2.xml");
+    InitMatchEquity(szMET);
+    g_free(szMET);
+
+    szWeights = BuildFilename("gnubg.weights");
+    szWeightsBinary = BuildFilename("gnubg.wd");
+    EvalInitialise(szWeights, szWeightsBinary, FALSE, NULL);
+    g_free(szWeights);
+    g_free(szWeightsBinary);
+
+    g_print(_("Evaluating %u positions at %d plies, best of %d passes\n"), cr.cPositions, nPlies, nRepeat);
+    if (RunCorpus(&cr, (unsigned int) nRepeat) < 0) {
+        g_printerr(_("Evaluation failed\n"));
+        exit(2);
+    }
+
+    if (szOutput && WriteResults(szOutput, &cr) < 0)
+        exit(2);
+
+    if (szBaseline) {
+        if (ReadResults(szBaseline, &crBase) < 0 || (n = CompareResults(&crBase, &cr, rTolerance, rSlower)) < 0)
+            exit(2);
+        g_free(crBase.acp);
+    }
+
+    g_free(cr.acp);
+    EvalShutdown();
+
+    return n;
+}
@@ -23,5 +23,7 @@
 #define LOCKING_VERSION 1
 
 #include "eval.c"
+#if !defined(LIBGNUBG)          /* the library and makedata have no rollouts */
 #include "rollout.c"
 #endif
+#endif
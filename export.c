@@ -42,6 +42,98 @@
 #include "boardpos.h"
 #include "boarddim.h"
 
+/* Whether the files szA and szB exist and have the same contents */
+static int
+SameContents(const char *szA, const char *szB)
+{
+    FILE *pfA, *pfB;
+    char achA[BUFSIZ], achB[BUFSIZ];
+    size_t cbA, cbB;
+    int fSame = FALSE;
+
+    if (!(pfA = g_fopen(szA, "rb")))
+        return FALSE;
+    if (!(pfB = g_fopen(szB, "rb"))) {
+        fclose(pfA);
+        return FALSE;
+    }
+
+    do {
+        cbA = fread(achA, 1, sizeof(achA), pfA);
+        cbB = fread(achB, 1, sizeof(achB), pfB);
+        if (cbA != cbB || memcmp(achA, achB, cbA))
+            break;
+        fSame = !cbA;
+    } while (cbA);
+
+    fclose(pfA);
+    fclose(pfB);
+
+    return fSame;
+}
+
+/*
+ * Open a file to export sz to.  The export is written to a temporary
+ * file beside sz, whose name is returned in *pszTemp (NULL for
+ * standard output, "-"), and CloseExportFile() puts it in place.
+ */
+
+extern FILE *
+OpenExportFile(const char *sz, char **pszTemp)
+{
+    FILE *pf;
+
+    if (!strcmp(sz, "-")) {
+        *pszTemp = NULL;
+        return stdout;
+    }
+
+    *pszTemp = g_strconcat(sz, ".tmp", NULL);
+    if (!(pf = g_fopen(*pszTemp, "w"))) {
+        outputerr(*pszTemp);
+        g_free(*pszTemp);
+        *pszTemp = NULL;
+    }
+
+    return pf;
+}
+
+/*
+ * Close pf, opened by OpenExportFile(), and replace sz by it unless sz
+ * already has the same contents; a page of a long session that is
+ * exported again is only rewritten if it has changed, and so keeps its
+ * time stamp otherwise.  Returns 0 on success.
+ */
+
+extern int
+CloseExportFile(FILE * pf, const char *sz, char *szTemp)
+{
+    int rc = 0;
+
+    if (!szTemp)
+        return fflush(pf);
+
+    if (fclose(pf)) {
+        outputerr(szTemp);
+        rc = -1;
+    } else if (SameContents(szTemp, sz))
+        g_unlink(szTemp);
+    else {
+        /* rename() doesn't replace an existing file everywhere */
+        g_unlink(sz);
+        if (g_rename(szTemp, sz)) {
+            outputerr(sz);
+            rc = -1;
+        }
+    }
+
+    if (rc)
+        g_unlink(szTemp);
+    g_free(szTemp);
+
+    return rc;
+}
+
 #if defined(HAVE_PANGOCAIRO)
 #include <cairo.h>
 #include <cairo-svg.h>
@@ -482,6 +574,49 @@ CommandExportMatchPS(char *sz)
 /* size of HTML images in steps of BOARD_WIDTH x BOARD_HEIGHT
  * as defined in boarddim.h */
 
+/* Write the image puch once the output of ppng is set up */
+static void
+WritePNGImage(png_structp ppng, png_infop pinfo, unsigned char *puch,
+              unsigned int nStride, unsigned int nSizeX, unsigned int nSizeY)
+{
+    png_text atext[3];
+
+    png_set_IHDR(ppng, pinfo, nSizeX, nSizeY, 8, PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+
+    /* text */
+
+    atext[0].key = "Title";
+    atext[0].text = "Backgammon board";
+    atext[0].compression = PNG_TEXT_COMPRESSION_NONE;
+
+    atext[1].key = "Author";
+    atext[1].text = VERSION_STRING;
+    atext[1].compression = PNG_TEXT_COMPRESSION_NONE;
+
+#ifdef PNG_iTXt_SUPPORTED
+    atext[0].lang = NULL;
+    atext[1].lang = NULL;
+#endif
+
+    png_set_text(ppng, pinfo, atext, 2);
+
+    png_write_info(ppng, pinfo);
+
+    {
+        png_bytep *aprow = (png_bytep *) g_alloca(nSizeY * sizeof(png_bytep));
+        unsigned int i;
+
+        for (i = 0; i < nSizeY; ++i)
+            aprow[i] = puch + nStride * i;
+
+        png_write_image(ppng, aprow);
+
+    }
+
+    png_write_end(ppng, pinfo);
+}
+
 extern int
 WritePNG(const char *sz, unsigned char *puch, unsigned int nStride, unsigned int nSizeX, unsigned int nSizeY)
 {
@@ -489,7 +624,6 @@ WritePNG(const char *sz, unsigned char *puch, unsigned int nStride, unsigned int
     FILE *pf;
     png_structp ppng;
     png_infop pinfo;
-    png_text atext[3];
 
     if (!(pf = g_fopen(sz, "wb")))
         return -1;
@@ -515,57 +649,74 @@ WritePNG(const char *sz, unsigned char *puch, unsigned int nStride, unsigned int
 
     png_init_io(ppng, pf);
 
-    png_set_IHDR(ppng, pinfo, nSizeX, nSizeY, 8, PNG_COLOR_TYPE_RGB,
-                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-
-    /* text */
+    WritePNGImage(ppng, pinfo, puch, nStride, nSizeX, nSizeY);
 
-    atext[0].key = "Title";
-    atext[0].text = "Backgammon board";
-    atext[0].compression = PNG_TEXT_COMPRESSION_NONE;
+    png_destroy_write_struct(&ppng, &pinfo);
 
-    atext[1].key = "Author";
-    atext[1].text = VERSION_STRING;
-    atext[1].compression = PNG_TEXT_COMPRESSION_NONE;
+    fclose(pf);
 
-#ifdef PNG_iTXt_SUPPORTED
-    atext[0].lang = NULL;
-    atext[1].lang = NULL;
-#endif
+    return 0;
 
-    png_set_text(ppng, pinfo, atext, 2);
+}
 
-    png_write_info(ppng, pinfo);
+static void
+AppendPNGData(png_structp ppng, png_bytep pb, png_size_t cb)
+{
+    g_byte_array_append((GByteArray *) png_get_io_ptr(ppng), pb, (guint) cb);
+}
 
-    {
-        png_bytep *aprow = (png_bytep *) g_alloca(nSizeY * sizeof(png_bytep));
-        unsigned int i;
+static void
+FlushPNGData(png_structp UNUSED(ppng))
+{
+}
 
-        for (i = 0; i < nSizeY; ++i)
-            aprow[i] = puch + nStride * i;
+/* As WritePNG(), but to memory: the PNG file, of *pcb bytes, or NULL */
+static guchar *
+EncodePNG(unsigned char *puch, unsigned int nStride, unsigned int nSizeX, unsigned int nSizeY, gsize * pcb)
+{
+    GByteArray *pba;
+    png_structp ppng;
+    png_infop pinfo;
 
-        png_write_image(ppng, aprow);
+    if (!(ppng = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL)))
+        return NULL;
 
+    if (!(pinfo = png_create_info_struct(ppng))) {
+        png_destroy_write_struct(&ppng, NULL);
+        return NULL;
     }
 
-    png_write_end(ppng, pinfo);
+    pba = g_byte_array_new();
 
-    png_destroy_write_struct(&ppng, &pinfo);
+    if (setjmp(png_jmpbuf(ppng))) {
+        png_destroy_write_struct(&ppng, &pinfo);
+        g_byte_array_free(pba, TRUE);
+        return NULL;
+    }
 
-    fclose(pf);
+    png_set_write_fn(ppng, pba, AppendPNGData, FlushPNGData);
 
-    return 0;
+    WritePNGImage(ppng, pinfo, puch, nStride, nSizeX, nSizeY);
+
+    png_destroy_write_struct(&ppng, &pinfo);
 
+    *pcb = pba->len;
+    return g_byte_array_free(pba, FALSE);
 }
 
-static int
-GenerateImage(renderimages * pri, renderdata * prd,
-              const TanBoard anBoard,
-              const char *szName,
-              const int nSize, const int nSizeX, const int nSizeY,
-              const int nOffsetX, const int nOffsetY,
-              const int fMove, const int fTurn, const int fCube,
-              const unsigned int anDice[2], const int nCube, const int fDoubled, const int fCubeOwner)
+/*
+ * Draw a board in a new image of BOARD_WIDTH x BOARD_HEIGHT units of
+ * nSize pixels, to be freed with g_free().  It needs nothing but its
+ * arguments and the images, which it only reads, so any number of
+ * threads may draw with the same images at once.
+ */
+
+static unsigned char *
+DrawBoardImage(renderimages * pri, renderdata * prd,
+               const TanBoard anBoard, const int nSize,
+               const int fMove, const int fTurn, const int fCube,
+               const unsigned int anDice[2], const int nCube, const int fDoubled, const int fCubeOwner,
+               const int fPlaying)
 {
     TanBoard anBoardTemp;
     unsigned char *puch;
@@ -586,10 +737,8 @@ GenerateImage(renderimages * pri, renderdata * prd,
 
     /* allocate memory for board */
 
-    if (!(puch = (unsigned char *) malloc(BOARD_WIDTH * BOARD_HEIGHT * nSize * nSize * 3))) {
-        outputerr("malloc");
-        return -1;
-    }
+    if (!(puch = g_try_malloc(BOARD_WIDTH * BOARD_HEIGHT * nSize * nSize * 3)))
+        return NULL;
 
     /* calculate cube position */
 
@@ -636,7 +785,28 @@ GenerateImage(renderimages * pri, renderdata * prd,
                   LogCube(nCube) + (doubled != 0),
                   nOrient,
                   anResignPosition, fResign, nResignOrientation,
-                  anArrowPosition, ms.gs != GAME_NONE, fMove == 1, 0, 0, BOARD_WIDTH * nSize, BOARD_HEIGHT * nSize);
+                  anArrowPosition, fPlaying, fMove == 1, 0, 0, BOARD_WIDTH * nSize, BOARD_HEIGHT * nSize);
+
+    return puch;
+}
+
+static int
+GenerateImage(renderimages * pri, renderdata * prd,
+              const TanBoard anBoard,
+              const char *szName,
+              const int nSize, const int nSizeX, const int nSizeY,
+              const int nOffsetX, const int nOffsetY,
+              const int fMove, const int fTurn, const int fCube,
+              const unsigned int anDice[2], const int nCube, const int fDoubled, const int fCubeOwner)
+{
+    unsigned char *puch;
+    int rc;
+
+    if (!(puch = DrawBoardImage(pri, prd, anBoard, nSize, fMove, fTurn, fCube,
+                                anDice, nCube, fDoubled, fCubeOwner, ms.gs != GAME_NONE))) {
+        outputerr("malloc");
+        return -1;
+    }
 
     /* crop */
 
@@ -658,11 +828,148 @@ GenerateImage(renderimages * pri, renderdata * prd,
 
     /* write png */
 
-    WritePNG(szName, puch, nSizeX * nSize * 3, nSizeX * nSize, nSizeY * nSize);
+    rc = WritePNG(szName, puch, nSizeX * nSize * 3, nSizeX * nSize, nSizeY * nSize);
 
-    free(puch);
+    g_free(puch);
 
-    return 0;
+    return rc;
+}
+
+/*
+ * The file in which the PNG image of a board is kept in the image
+ * cache, or NULL if there is no cache.  It is named after a digest of
+ * everything the image depends on, so a board that has been exported
+ * before, with the same appearance and size, is copied from the cache
+ * instead of being rendered again.
+ */
+
+static char *
+CachedImageName(renderdata * prd, const TanBoard anBoard,
+                const int fMove, const int fTurn, const int fCube,
+                const unsigned int anDice[2], const int nCube, const int fDoubled, const int fCubeOwner)
+{
+    positionkey key;
+    char *szSettings, *szKey, *szDigest, *szName, *sz;
+
+    if (!exsExport.szPNGCache)
+        return NULL;
+
+    PositionKey(anBoard, &key);
+    szSettings = RenderingSettingsString(prd);
+    szKey = g_strdup_printf("%s %u %u %u %u %u %u %u %u %d %d %d %u %u %d %d %d %d %d %s", VERSION,
+                            key.data[0], key.data[1], key.data[2], key.data[3], key.data[4], key.data[5],
+                            key.data[6], prd->nSize, fMove, fTurn, fCube, anDice[0], anDice[1], nCube,
+                            fDoubled, fCubeOwner, fClockwise, ms.gs != GAME_NONE, szSettings);
+    szDigest = g_compute_checksum_for_string(G_CHECKSUM_SHA256, szKey, -1);
+    szName = g_strconcat(szDigest, ".png", NULL);
+    sz = g_build_filename(exsExport.szPNGCache, szName, NULL);
+
+    g_free(szName);
+    g_free(szDigest);
+    g_free(szKey);
+    g_free(szSettings);
+
+    return sz;
+}
+
+/* Copy the file szFrom to szTo; g_file_set_contents() replaces szTo at
+ * once, so other exports sharing the cache never see half a file */
+static int
+CopyImage(const char *szFrom, const char *szTo)
+{
+    gchar *pch;
+    gsize cb;
+    int rc;
+
+    if (!g_file_get_contents(szFrom, &pch, &cb, NULL))
+        return -1;
+
+    rc = g_file_set_contents(szTo, pch, (gssize) cb, NULL) ? 0 : -1;
+    g_free(pch);
+
+    return rc;
+}
+
+/*
+ * The images of the last few appearances and sizes boards were drawn
+ * with, so that boards drawn one after another, or on several threads
+ * at once, render them only once.  LockBoardImages() returns those of
+ * the present appearance at nSize, which stay as they are until
+ * UnlockBoardImages().
+ */
+
+#define BOARD_IMAGES 4
+
+typedef struct {
+    char *szAppearance;         /* size and rendering settings */
+    renderdata rd;
+    renderimages ri;
+} boardimages;
+
+static GRWLock rwlBoardImages;
+static boardimages abi[BOARD_IMAGES];
+static unsigned int iBoardImages;       /* the next to replace */
+
+static boardimages *
+FindBoardImages(const char *szAppearance)
+{
+    unsigned int i;
+
+    for (i = 0; i < BOARD_IMAGES; i++)
+        if (abi[i].szAppearance && !strcmp(abi[i].szAppearance, szAppearance))
+            return &abi[i];
+
+    return NULL;
+}
+
+static boardimages *
+LockBoardImages(unsigned int nSize)
+{
+    renderdata rd;
+    char *szSettings, *szAppearance;
+    boardimages *pbi;
+
+    CopyAppearance(&rd);
+    rd.nSize = nSize;
+
+    szSettings = RenderingSettingsString(&rd);
+    szAppearance = g_strdup_printf("%u %d %s", nSize, rd.fClockwise, szSettings);
+    g_free(szSettings);
+
+    g_rw_lock_reader_lock(&rwlBoardImages);
+
+    while (!(pbi = FindBoardImages(szAppearance))) {
+        g_rw_lock_reader_unlock(&rwlBoardImages);
+        g_rw_lock_writer_lock(&rwlBoardImages);
+
+        /* another thread may have rendered them meanwhile */
+        if (!FindBoardImages(szAppearance)) {
+            pbi = &abi[iBoardImages];
+            iBoardImages = (iBoardImages + 1) % BOARD_IMAGES;
+
+            if (pbi->szAppearance) {
+                FreeImages(&pbi->ri);
+                g_free(pbi->szAppearance);
+            }
+
+            memcpy(&pbi->rd, &rd, sizeof(renderdata));
+            RenderImages(&pbi->rd, &pbi->ri);
+            pbi->szAppearance = g_strdup(szAppearance);
+        }
+
+        g_rw_lock_writer_unlock(&rwlBoardImages);
+        g_rw_lock_reader_lock(&rwlBoardImages);
+    }
+
+    g_free(szAppearance);
+
+    return pbi;
+}
+
+static void
+UnlockBoardImages(void)
+{
+    g_rw_lock_reader_unlock(&rwlBoardImages);
 }
 
 extern void
@@ -689,27 +996,137 @@ CommandExportPositionPNG(char *sz)
     } else
 #endif
     {
-        renderimages ri;
         renderdata rd;
+        char *szCache;
 
         CopyAppearance(&rd);
         rd.nSize = exsExport.nPNGSize;
 
         g_assert(rd.nSize >= 1);
 
-        RenderImages(&rd, &ri);
+        szCache = CachedImageName(&rd, msBoard(), ms.fMove, ms.fTurn, fCubeUse,
+                                  ms.anDice, ms.nCube, ms.fDoubled, ms.fCubeOwner);
 
-        GenerateImage(&ri, &rd, msBoard(), sz,
-                      exsExport.nPNGSize, BOARD_WIDTH, BOARD_HEIGHT, 0, 0,
-                      ms.fMove, ms.fTurn, fCubeUse, ms.anDice, ms.nCube, ms.fDoubled, ms.fCubeOwner);
+        if (!szCache || CopyImage(szCache, sz)) {
+            boardimages *pbi = LockBoardImages(rd.nSize);
+            int rc = GenerateImage(&pbi->ri, &pbi->rd, msBoard(), sz,
+                                   exsExport.nPNGSize, BOARD_WIDTH, BOARD_HEIGHT, 0, 0,
+                                   ms.fMove, ms.fTurn, fCubeUse, ms.anDice, ms.nCube, ms.fDoubled, ms.fCubeOwner);
 
-        FreeImages(&ri);
+            UnlockBoardImages();
+
+            if (!rc && szCache && g_mkdir_with_parents(exsExport.szPNGCache, 0755) == 0)
+                CopyImage(sz, szCache);
+        }
+
+        g_free(szCache);
     }
 }
 
 
 #endif                          /* HAVE_LIBPNG */
 
+#if defined(HAVE_PANGOCAIRO)
+static cairo_status_t
+AppendSVGData(void *p, const unsigned char *pb, unsigned int cb)
+{
+    g_byte_array_append((GByteArray *) p, pb, cb);
+    return CAIRO_STATUS_SUCCESS;
+}
+#endif
+
+/* The format called sz, or -1 if there is none */
+extern int
+BoardImageFormat(const char *sz)
+{
+    if (!g_ascii_strcasecmp(sz, "png"))
+        return BOARD_IMAGE_PNG;
+    else if (!g_ascii_strcasecmp(sz, "svg"))
+        return BOARD_IMAGE_SVG;
+    else
+        return -1;
+}
+
+/*
+ * The board of pms as an image file in memory, of *pcb bytes, to be
+ * freed with g_free(); NULL if it can't be made.  A PNG is drawn with
+ * the board appearance, nSize pixels a unit of boarddim.h, an SVG as
+ * the simple board of "export position svg", nSize points a unit.
+ * Nothing is shown and only copies of the settings are used, so it
+ * runs without a display and on several threads at once.
+ */
+extern guchar *
+BoardImage(const matchstate * pms, boardimageformat bif, unsigned int nSize, gsize * pcb)
+{
+    g_return_val_if_fail(nSize >= 1, NULL);
+
+    switch (bif) {
+    case BOARD_IMAGE_PNG:
+#if defined(HAVE_LIBPNG)
+        {
+            boardimages *pbi = LockBoardImages(nSize);
+            unsigned char *puch;
+            guchar *pb = NULL;
+
+            puch = DrawBoardImage(&pbi->ri, &pbi->rd, pms->anBoard, (int) nSize,
+                                  pms->fMove, pms->fTurn, pms->fCubeUse, pms->anDice, pms->nCube,
+                                  pms->fDoubled, pms->fCubeOwner, pms->gs != GAME_NONE);
+            UnlockBoardImages();
+
+            if (puch) {
+                pb = EncodePNG(puch, BOARD_WIDTH * nSize * 3, BOARD_WIDTH * nSize, BOARD_HEIGHT * nSize, pcb);
+                g_free(puch);
+            }
+
+            return pb;
+        }
+#else
+        return NULL;
+#endif
+
+    case BOARD_IMAGE_SVG:
+#if defined(HAVE_PANGOCAIRO)
+        {
+            matchstate msImage;
+            GByteArray *pba;
+            cairo_surface_t *surface;
+            cairo_t *cairo;
+            SimpleBoard *board;
+            double rSize = BOARD_WIDTH * nSize;
+
+            /* simple_board_new() takes a matchstate it may change */
+            memcpy(&msImage, pms, sizeof(matchstate));
+
+            pba = g_byte_array_new();
+            surface = cairo_svg_surface_create_for_stream(AppendSVGData, pba, rSize, rSize);
+
+            if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+                cairo_surface_destroy(surface);
+                g_byte_array_free(pba, TRUE);
+                return NULL;
+            }
+
+            cairo = cairo_create(surface);
+            board = simple_board_new(&msImage, cairo, (float) rSize);
+            simple_board_draw(board);
+            g_free(board);
+            cairo_destroy(cairo);
+
+            /* the surface writes out the rest of the SVG as it goes */
+            cairo_surface_destroy(surface);
+
+            *pcb = pba->len;
+            return g_byte_array_free(pba, FALSE);
+        }
+#else
+        return NULL;
+#endif
+
+    default:
+        return NULL;
+    }
+}
+
 
 /*
  * For documentation of format, see ImportSnowieTxt in import.c
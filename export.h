@@ -86,14 +86,26 @@ typedef struct {
     int nPNGSize;
     int nHtmlSize;
 
+    char *szPNGCache;           /* folder of the PNG image cache, or NULL */
+
 } exportsetup;
 
 extern exportsetup exsExport;
 
+typedef enum {
+    BOARD_IMAGE_PNG,
+    BOARD_IMAGE_SVG
+} boardimageformat;
+
 extern char *filename_from_iGame(const char *szBase, const int iGame);
+extern FILE *OpenExportFile(const char *sz, char **pszTemp);
+extern int CloseExportFile(FILE * pf, const char *sz, char *szTemp);
 extern int WritePNG(const char *sz, unsigned char *puch,
                     unsigned int nStride, unsigned int nSizeX, unsigned int nSizeY);
 
+extern int BoardImageFormat(const char *sz);
+extern guchar *BoardImage(const matchstate * pms, boardimageformat bif, unsigned int nSize, gsize * pcb);
+
 #if defined(USE_BOARD3D)
 void GenerateImage3d(const char *szName, unsigned int nSize, unsigned int nSizeX, unsigned int nSizeY);
 #endif
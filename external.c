@@ -41,6 +41,7 @@
 #if HAVE_SYS_SOCKET_H
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -117,8 +118,11 @@
 #include "external.h"
 #include "rollout.h"
 #include "eval.h"
+#include "export.h"
 #include "matchid.h"
+#include "positionid.h"
 #include "multithread.h"
+#include "metrics.h"
 #include "lib/gnubg-types.h"
 
 #if HAVE_SOCKETS
@@ -384,11 +388,16 @@ ExtEvaluation(scancontext * pec)
     SetCubeInfo(&ci, processedBoard.nCube, processedBoard.fCubeOwner, 1, processedBoard.nMatchTo,
                 anScore, processedBoard.fCrawford, processedBoard.fJacoby, nBeavers, bgvDefault);
 
-    ec.fCubeful = pec->fCubeful;
-    ec.nPlies = pec->nPlies;
-    ec.fUsePrune = pec->fUsePrune;
-    ec.fDeterministic = pec->fDeterministic;
-    ec.rNoise = pec->rNoise;
+    if (pec->pep)
+        ec = pec->pep->ecChequer;
+    else {
+        ec = GetEvalChequer()->ec;
+        ec.fCubeful = pec->fCubeful;
+        ec.nPlies = pec->nPlies;
+        ec.fUsePrune = pec->fUsePrune;
+        ec.fDeterministic = pec->fDeterministic;
+        ec.rNoise = pec->rNoise;
+    }
 
     if (GeneralEvaluationE(arOutput, (ConstTanBoard) processedBoard.anBoard, &ci, &ec))
         return NULL;
@@ -406,6 +415,60 @@ ExtEvaluation(scancontext * pec)
     return szResponse;
 }
 
+/* FindBestMove() with rTimeLimit seconds to move in, if not 0: search
+ * at 0, 1, ... up to pec->nPlies plies, each one finding the
+ * evaluations of the ones before in the cache, and answer with the
+ * move of the deepest search that completed in time */
+static int
+ExtFindBestMove(int anMove[8], int nDice0, int nDice1, TanBoard anBoard, const cubeinfo * pci,
+                evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], float rTimeLimit)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    evalcontext ec = *pec;
+    TanBoard anBoardBest;
+    int anMoveBest[8];
+    int cBest = -1;
+    unsigned int nPlies;
+
+    if (rTimeLimit <= 0.0f)
+        return FindBestMove(anMove, nDice0, nDice1, anBoard, pci, pec, aamf);
+
+    ptld->rDeadline = get_time() + rTimeLimit * 1000.0;
+
+    for (nPlies = 0; nPlies <= pec->nPlies; nPlies++) {
+        TanBoard anBoardTry;
+        int anMoveTry[8];
+        int c;
+
+        ec.nPlies = nPlies;
+        memcpy(anBoardTry, anBoard, sizeof(TanBoard));
+        if ((c = FindBestMove(anMoveTry, nDice0, nDice1, anBoardTry, pci, &ec, aamf)) < 0) {
+            /* out of time: the shallower move will do, unlike on an
+             * interrupt */
+            if (errno != ETIMEDOUT)
+                cBest = -1;
+            break;
+        }
+
+        memcpy(anBoardBest, anBoardTry, sizeof(TanBoard));
+        memcpy(anMoveBest, anMoveTry, sizeof(anMoveBest));
+        cBest = c;
+
+        /* no legal move needs no deeper look */
+        if (!c || get_time() > ptld->rDeadline)
+            break;
+    }
+
+    ptld->rDeadline = 0.0;
+
+    if (cBest < 0)
+        return -1;
+
+    memcpy(anBoard, anBoardBest, sizeof(TanBoard));
+    memcpy(anMove, anMoveBest, sizeof(anMoveBest));
+    return cBest;
+}
+
 static char *
 ExtFIBSBoard(scancontext * pec)
 {
@@ -413,13 +476,24 @@ ExtFIBSBoard(scancontext * pec)
     TanBoard anBoardOrig;
     int anScore[2], anMove[8], fTurn;
     float arDouble[NUM_CUBEFUL_OUTPUTS], aarOutput[2][NUM_ROLLOUT_OUTPUTS], aarStdDev[2][NUM_ROLLOUT_OUTPUTS];
-    rolloutstat aarsStatistics[2][2];
     cubeinfo ci;
     char *szResponse;
+    evalsetup esPreset;
+    evalsetup *pesCube = GetEvalCube();
+    evalcontext *pecChequer = &GetEvalChequer()->ec;
+    movefilter(*aamf)[MAX_FILTER_PLIES] = *GetEvalMoveFilter();
 
     if (ProcessFIBSBoardInfo(&pec->bi, &processedBoard))
         return g_strdup_printf("Error: badly formed board\n");
 
+    if (pec->pep) {
+        esPreset.et = EVAL_EVAL;
+        esPreset.ec = pec->pep->ecCube;
+        pesCube = &esPreset;
+        pecChequer = &pec->pep->ecChequer;
+        aamf = pec->pep->aamf;
+    }
+
     anScore[0] = processedBoard.nScore;
     anScore[1] = processedBoard.nScoreOpp;
 
@@ -447,7 +521,7 @@ ExtFIBSBoard(scancontext * pec)
                     processedBoard.fCrawford, processedBoard.fJacoby, nBeavers, bgvDefault);
 
         if (GeneralCubeDecision(aarOutput, aarStdDev,
-                                aarsStatistics, (ConstTanBoard) processedBoard.anBoard, &ci, GetEvalCube(), NULL,
+                                NULL, (ConstTanBoard) processedBoard.anBoard, &ci, pesCube, NULL,
                                 NULL) < 0)
             return NULL;
 
@@ -495,7 +569,7 @@ ExtFIBSBoard(scancontext * pec)
         float rEqBefore, rEqAfter;
         const float epsilon = 1.0e-6f;
 
-        getResignation(arOutput, processedBoard.anBoard, &ci, &esEvalCube);
+        getResignation(arOutput, processedBoard.anBoard, &ci, pesCube);
 
         getResignEquities(arOutput, &ci, pec->nResignation, &rEqBefore, &rEqAfter);
 
@@ -508,8 +582,8 @@ ExtFIBSBoard(scancontext * pec)
     } else if (processedBoard.anDice[0]) {
         /* move */
         char szMove[FORMATEDMOVESIZE];
-        if (FindBestMove(anMove, processedBoard.anDice[0], processedBoard.anDice[1],
-                         processedBoard.anBoard, &ci, &GetEvalChequer()->ec, *GetEvalMoveFilter()) < 0)
+        if (ExtFindBestMove(anMove, processedBoard.anDice[0], processedBoard.anDice[1],
+                            processedBoard.anBoard, &ci, pecChequer, aamf, pec->rTimeLimit) < 0)
             return NULL;
 
         FormatMovePlain(szMove, (ConstTanBoard)anBoardOrig, anMove);
@@ -517,7 +591,7 @@ ExtFIBSBoard(scancontext * pec)
     } else {
         /* double decision */
         if (GeneralCubeDecision(aarOutput, aarStdDev,
-                                aarsStatistics, (ConstTanBoard) processedBoard.anBoard, &ci, GetEvalCube(),
+                                NULL, (ConstTanBoard) processedBoard.anBoard, &ci, pesCube,
                                 NULL, NULL) < 0)
             return NULL;
 
@@ -548,7 +622,7 @@ ExtFIBSBoard(scancontext * pec)
         case OPTIONAL_REDOUBLE_TAKE:
         case OPTIONAL_DOUBLE_PASS:
         case OPTIONAL_REDOUBLE_PASS:
-            if (pec->nPlies == 0 && aarOutput[fTurn][0] > 0.001f)
+            if ((pec->pep ? pec->pep->ecCube.nPlies : pec->nPlies) == 0 && aarOutput[fTurn][0] > 0.001f)
                 /* double if 0-ply except when about to lose game */
                 szResponse = g_strdup("double\n");
             else
@@ -563,6 +637,1364 @@ ExtFIBSBoard(scancontext * pec)
 
     return szResponse;
 }
+
+/* The connections to the external controller server, see
+ * CommandExternal().
+ *
+ * A client need not wait for an answer before sending its next
+ * command.  The answers come in the order of the commands, except for
+ * those of commands starting with a tag, "@<id> <command>", which are
+ * sent as soon as they are ready, each line of them after "@<id> ".
+ * "batch <n>", tagged or not, takes the n lines that follow as board
+ * or evaluation commands and answers them together, one line each, in
+ * the order given.
+ *
+ * "set preset <name>", with the name quoted, or its number, makes the
+ * board and evaluation commands of the client evaluate with one of the
+ * presets of preset.h instead of gnubg's settings and the options of
+ * the command; "set preset ''" goes back to those.
+ *
+ * After "set binary on" the client sends and gets binary frames
+ * instead, until it disconnects.  All integers are little endian and
+ * each frame starts with a u32 size of what follows.  A request
+ * (EXT_BINARY_REQUEST bytes, or more with the rest ignored) is
+ *
+ *   0  u32 id, given back with the answer
+ *   4  u8  plies
+ *   5  u8  flags (EXT_BINARY_*)
+ *   6  u16 reserved (0)
+ *   8  f32 noise
+ *  12  position ID (L_POSITIONID characters)
+ *  26  match ID (L_MATCHID characters)
+ *
+ * evaluating the position for the player on roll; the answer
+ * (EXT_BINARY_ANSWER bytes) is
+ *
+ *   0  u32 id
+ *   4  u32 status (EXT_STATUS_*)
+ *   8  f32 win, win gammon, win backgammon, lose gammon, lose
+ *      backgammon and equity, as "evaluation" answers them
+ *
+ * sent as soon as it is ready, after the answers to the text commands
+ * before it.
+ *
+ * A client whose first line is an HTTP/1.x request line is served as
+ * an HTTP client instead, with keep-alive: POST /evaluate, /move or
+ * /cube with a JSON object of "position" and "match" (IDs) and
+ * optionally "preset" (the name or number of one of preset.h, which
+ * the fields after it may change), "plies", "cubeful", "prune",
+ * "deterministic" and "noise", or GET /version, or GET /metrics for
+ * the metrics of metrics.h in the Prometheus text format.  The answer
+ * is a JSON object, or 503 if EXT_HTTP_MAX_JOBS requests are being
+ * worked on already.  POST /board with "position", "match" and
+ * optionally "format" ("png" or "svg") and "size" (1 to 20, as "set
+ * export png size") answers with the image of the board, see
+ * BoardImage().
+ *
+ * POST /hint, with the fields of /move and optionally "moves" (1 to
+ * EXT_HTTP_MAX_MOVES, the best ones wanted) and "stream", answers with
+ * lines of JSON (application/x-ndjson) of "plies", "final" and "moves",
+ * the list of "move" and "equity": to HTTP/1.1 clients that don't set
+ * "stream" false, one line for each move filter stage as soon as it is
+ * done, in chunks, and then the final one; to the others, the final
+ * one alone. */
+
+#define EXT_BINARY_REQUEST 38
+#define EXT_BINARY_ANSWER 32
+/* The largest request, bigger ones end the connection */
+#define EXT_BINARY_MAX 4096
+
+#define EXT_BINARY_CUBEFUL 1
+#define EXT_BINARY_PRUNE 2
+#define EXT_BINARY_DETERMINISTIC 4
+
+#define EXT_STATUS_OK 0
+#define EXT_STATUS_BAD 1        /* badly formed request or IDs */
+#define EXT_STATUS_FAILED 2     /* the evaluation failed or was interrupted */
+
+#define EXT_HTTP_MAX_HEADER 8192
+#define EXT_HTTP_MAX_BODY 4096
+/* The HTTP requests of all the clients that may be worked on at once */
+#define EXT_HTTP_MAX_JOBS 256
+/* The most moves of an answer to POST /hint */
+#define EXT_HTTP_MAX_MOVES 20
+
+typedef enum {
+    HTTP_EVALUATE,
+    HTTP_MOVE,
+    HTTP_CUBE,
+    HTTP_BOARD,
+    HTTP_HINT
+} httpcall;
+
+/* An HTTP request, see ExtHttpRequest() */
+typedef struct {
+    httpcall hc;
+    TanBoard anBoard;
+    cubeinfo ci;
+    unsigned int anDice[2];
+    evalsetup es;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    matchstate ms;              /* for HTTP_BOARD */
+    boardimageformat bif;
+    unsigned int nSize;
+    unsigned int nMoves;        /* for HTTP_HINT */
+    int fStream;
+    GAsyncQueue *paqStream;     /* chunks of the answer ready to go, or NULL */
+    int fKeepAlive;
+} exthttp;
+
+/* A binary request, see ExtBinaryRequest() */
+typedef struct {
+    guint32 nId;
+    guint32 nStatus;
+    TanBoard anBoard;
+    cubeinfo ci;
+    evalcontext ec;
+    float arOutput[6];
+} extbinary;
+
+/* An answer to a request, from an evaluation or not */
+typedef struct {
+    scancontext scanctx;        /* the client's, as it was for the board */
+    char *szResponse;
+    gsize cbResponse;           /* of szResponse, if it is not a string */
+    extbinary *pxb;             /* a binary request instead */
+    exthttp *pxh;               /* or an HTTP one */
+} extanswer;
+
+/* A command of a client, or a batch of them */
+typedef struct {
+    char *szTag;                /* the "@<id>" it came with, or NULL */
+    GPtrArray *pAnswers;        /* extanswers, in the order asked for */
+    int fBatch;
+    unsigned int cBatch;        /* lines the batch has still to take */
+    int fBinary;
+    int fClose;                 /* the connection ends with the answer */
+    gint64 tStart;              /* g_get_monotonic_time() when it came */
+    taskgroup tg;               /* the evaluations for pAnswers */
+} extrequest;
+
+typedef struct {
+    int h;
+    scancontext scanctx;
+    GString *gsInput;           /* read and not handled yet */
+    GQueue *pqRequests;         /* not answered yet, in the order sent */
+    extrequest *perBatch;       /* the batch still taking lines */
+    int fBinary;                /* after "set binary on" */
+    int fHttp;
+    int fStarted;               /* the first line has been looked at */
+    int fClose;
+} extclient;
+
+/* The longest command line, longer ones are cut into pieces */
+#define EXT_MAX_LINE 255
+/* The requests a client may have going before it is read no more */
+#define EXT_MAX_REQUESTS 64
+/* The most boards in a batch */
+#define EXT_MAX_BATCH 1024
+
+static void
+ExtAnswerEvaluate(void *p)
+{
+    extanswer *pea = (extanswer *) p;
+
+    if (pea->scanctx.ct == COMMAND_EVALUATION)
+        pea->szResponse = ExtEvaluation(&pea->scanctx);
+    else
+        pea->szResponse = ExtFIBSBoard(&pea->scanctx);
+}
+
+static void
+ExtWriteDebug(extclient * pxc)
+{
+    scancontext *pScanCtx = &pxc->scanctx;
+    ProcessedFIBSBoard processedBoard;
+    GValue *optionsmapgv;
+    GValue *boarddatagv;
+    GString *dbgStr;
+    int anScore[2];
+    int fcrawford, fjacoby;
+    char *asz[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    char szBoard[10000];
+    char **aszLines, **aszLinesOrig;
+    char *szMatchID;
+
+    optionsmapgv = (GValue *) g_list_nth_data(g_value_get_boxed(pScanCtx->pCmdData), 1);
+    boarddatagv = (GValue *) g_list_nth_data(g_value_get_boxed(pScanCtx->pCmdData), 0);
+    dbgStr = g_string_new(DEBUG_PREFIX);
+    g_value_tostring(dbgStr, optionsmapgv, 0);
+    g_string_append(dbgStr, "\n" DEBUG_PREFIX);
+    g_value_tostring(dbgStr, boarddatagv, 0);
+    g_string_append(dbgStr, "\n" DEBUG_PREFIX "\n");
+    ExternalWrite(pxc->h, dbgStr->str, strlen(dbgStr->str));
+    ProcessFIBSBoardInfo(&pScanCtx->bi, &processedBoard);
+
+    anScore[0] = processedBoard.nScoreOpp;
+    anScore[1] = processedBoard.nScore;
+    /* If the session isn't using Crawford rule, set Crawford flag to false */
+    fcrawford = pScanCtx->fCrawfordRule ? processedBoard.fCrawford : FALSE;
+    /* Set the Jacoby flag appropriately from the external interface settings */
+    fjacoby = pScanCtx->fJacobyRule;
+
+    szMatchID = MatchID((unsigned int *) processedBoard.anDice, 1, processedBoard.nResignation,
+                        processedBoard.fDoubled, 1, processedBoard.fCubeOwner, fcrawford,
+                        processedBoard.nMatchTo, anScore, processedBoard.nCube, fjacoby, GAME_PLAYING);
+
+    DrawBoard(szBoard, (ConstTanBoard) & processedBoard.anBoard, 1, asz, szMatchID, 15);
+
+    aszLines = g_strsplit(&szBoard[0], "\n", 32);
+    aszLinesOrig = aszLines;
+    while (*aszLines) {
+        ExternalWrite(pxc->h, DEBUG_PREFIX, strlen(DEBUG_PREFIX));
+        ExternalWrite(pxc->h, *aszLines, strlen(*aszLines));
+        ExternalWrite(pxc->h, "\n", 1);
+        aszLines++;
+    }
+
+    dbgStr = g_string_assign(dbgStr, "");
+    g_string_append_printf(dbgStr, DEBUG_PREFIX "X is %s, O is %s\n", processedBoard.szPlayer, processedBoard.szOpp);
+    if (processedBoard.nMatchTo) {
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Match Play %s Crawford Rule\n",
+                               pScanCtx->fCrawfordRule ? "with" : "without");
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d/%d%s, ", processedBoard.nScore,
+                               processedBoard.nScoreOpp, processedBoard.nMatchTo, fcrawford ? "*" : "");
+    } else {
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Money Session %s Jacoby Rule, %s Beavers\n",
+                               pScanCtx->fJacobyRule ? "with" : "without", pScanCtx->fBeavers ? "with" : "without");
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d, ", processedBoard.nScore,
+                               processedBoard.nScoreOpp);
+    }
+    g_string_append_printf(dbgStr, "Roll: %d%d\n", processedBoard.anDice[0], processedBoard.anDice[1]);
+    g_string_append_printf(dbgStr,
+                           DEBUG_PREFIX
+                           "CubeOwner: %d, Cube: %d, Turn: %c, Doubled: %d, Resignation: %d\n",
+                           processedBoard.fCubeOwner, processedBoard.nCube, 'X',
+                           processedBoard.fDoubled, processedBoard.nResignation);
+    g_string_append(dbgStr, DEBUG_PREFIX "\n");
+    ExternalWrite(pxc->h, dbgStr->str, strlen(dbgStr->str));
+
+    g_string_free(dbgStr, TRUE);
+    g_strfreev(aszLinesOrig);
+}
+
+/* The HTTP requests forked and not answered yet */
+static unsigned int cHttpJobs;
+
+static extrequest *
+ExtRequestNew(char *szTag)
+{
+    extrequest *per = g_new0(extrequest, 1);
+
+    per->szTag = szTag;
+    per->pAnswers = g_ptr_array_new();
+    per->tStart = g_get_monotonic_time();
+
+    return per;
+}
+
+static void
+ExtRequestFree(extrequest * per)
+{
+    unsigned int i;
+
+    /* an evaluation still going needs its scancontext; with
+     * fInterrupt set it gives up soon */
+    MT_JoinTasks(&per->tg);
+
+    for (i = 0; i < per->pAnswers->len; i++) {
+        extanswer *pea = (extanswer *) g_ptr_array_index(per->pAnswers, i);
+
+        unset_scan_context(&pea->scanctx, FALSE);
+        g_free(pea->szResponse);
+        g_free(pea->pxb);
+        if (pea->pxh) {
+            cHttpJobs--;
+            if (pea->pxh->paqStream)
+                g_async_queue_unref(pea->pxh->paqStream);
+            g_free(pea->pxh);
+        }
+        g_free(pea);
+    }
+
+    g_ptr_array_free(per->pAnswers, TRUE);
+    g_free(per->szTag);
+    g_free(per);
+}
+
+static extanswer *
+ExtRequestAnswer(extrequest * per, char *szResponse)
+{
+    extanswer *pea = g_new0(extanswer, 1);
+
+    pea->szResponse = szResponse;
+    g_ptr_array_add(per->pAnswers, pea);
+
+    return pea;
+}
+
+static int
+ExtRequestDone(extrequest * per)
+{
+    return !(per->fBatch && per->cBatch) && MT_SafeCompare(&per->tg.cPending, 0);
+}
+
+static void
+ExtPutU32(GString * gs, guint32 n)
+{
+    guchar auch[4];
+
+    auch[0] = (guchar) (n & 0xff);
+    auch[1] = (guchar) ((n >> 8) & 0xff);
+    auch[2] = (guchar) ((n >> 16) & 0xff);
+    auch[3] = (guchar) (n >> 24);
+    g_string_append_len(gs, (const gchar *) auch, 4);
+}
+
+static guint32
+ExtGetU32(const guchar * puch)
+{
+    return (guint32) puch[0] | ((guint32) puch[1] << 8) | ((guint32) puch[2] << 16) | ((guint32) puch[3] << 24);
+}
+
+static void
+ExtPutFloat(GString * gs, float r)
+{
+    guint32 n;
+
+    memcpy(&n, &r, sizeof(n));
+    ExtPutU32(gs, n);
+}
+
+static float
+ExtGetFloat(const guchar * puch)
+{
+    guint32 n = ExtGetU32(puch);
+    float r;
+
+    memcpy(&r, &n, sizeof(r));
+    return r;
+}
+
+/* The answers of a done request, tagged as it was; NULL if there are
+ * none */
+static GString *
+ExtRequestResponse(const extrequest * per)
+{
+    GString *gs = g_string_new(NULL);
+    GString *gsTagged;
+    const char *pch;
+    unsigned int i;
+
+    for (i = 0; i < per->pAnswers->len; i++) {
+        const extanswer *pea = (const extanswer *) g_ptr_array_index(per->pAnswers, i);
+
+        if (pea->pxb) {
+            int j;
+
+            ExtPutU32(gs, EXT_BINARY_ANSWER);
+            ExtPutU32(gs, pea->pxb->nId);
+            ExtPutU32(gs, pea->pxb->nStatus);
+            for (j = 0; j < 6; j++)
+                ExtPutFloat(gs, pea->pxb->nStatus == EXT_STATUS_OK ? pea->pxb->arOutput[j] : 0.0f);
+        } else if (pea->szResponse)
+            g_string_append_len(gs, pea->szResponse, pea->cbResponse ? (gssize) pea->cbResponse : -1);
+        else if (per->fBatch)
+            /* a line for each board all the same */
+            g_string_append(gs, "Error: no answer\n");
+    }
+
+    if (!gs->len) {
+        g_string_free(gs, TRUE);
+        return NULL;
+    }
+
+    if (!per->szTag)
+        return gs;
+
+    gsTagged = g_string_new(NULL);
+    for (pch = gs->str; *pch;) {
+        const char *pchEnd = strchr(pch, '\n');
+        size_t cch = pchEnd ? (size_t) (pchEnd - pch) + 1 : strlen(pch);
+
+        g_string_append_printf(gsTagged, "%s ", per->szTag);
+        g_string_append_len(gsTagged, pch, (gssize) cch);
+        pch += cch;
+    }
+    g_string_free(gs, TRUE);
+
+    return gsTagged;
+}
+
+static void
+ExtBinaryEvaluate(void *p)
+{
+    extbinary *pxb = (extbinary *) p;
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+
+    if (GeneralEvaluationE(arOutput, (ConstTanBoard) pxb->anBoard, &pxb->ci, &pxb->ec)) {
+        pxb->nStatus = EXT_STATUS_FAILED;
+        return;
+    }
+
+    memcpy(pxb->arOutput, arOutput, 5 * sizeof(float));
+
+    /* the equity as ExtEvaluation() gives it */
+    if (pxb->ci.nMatchTo) {
+        if (pxb->ec.fCubeful)
+            pxb->arOutput[5] = arOutput[OUTPUT_CUBEFUL_EQUITY];
+        else
+            pxb->arOutput[5] = eq2mwc(arOutput[OUTPUT_EQUITY], &pxb->ci);
+    } else
+        pxb->arOutput[5] = pxb->ec.fCubeful ? arOutput[6] : arOutput[5];
+}
+
+/* Start evaluating the binary request of cb bytes at puch */
+static void
+ExtBinaryRequest(extclient * pxc, const guchar * puch, guint32 cb)
+{
+    extrequest *per = ExtRequestNew(NULL);
+    extbinary *pxb = g_new0(extbinary, 1);
+    char szMatchID[L_MATCHID + 1];
+    positionkey key;
+    unsigned int anDice[2];
+    int fTurn, fResigned, fDoubled, fMove, fCubeOwner, fCrawford, nMatchTo, anScore[2], nCube, fJacoby;
+    gamestate gs;
+
+    per->fBinary = TRUE;
+    ExtRequestAnswer(per, NULL)->pxb = pxb;
+    g_queue_push_tail(pxc->pqRequests, per);
+
+    if (cb >= 4)
+        pxb->nId = ExtGetU32(puch);
+
+    pxb->nStatus = EXT_STATUS_BAD;
+
+    if (cb < EXT_BINARY_REQUEST)
+        return;
+
+    memcpy(szMatchID, puch + 12 + L_POSITIONID, L_MATCHID);
+    szMatchID[L_MATCHID] = 0;
+
+    /* the position ID straight from the frame */
+    if (!PositionKeysFromIDs(&key, (const char *) puch + 12, L_POSITIONID, 1)
+        || MatchFromID(anDice, &fTurn, &fResigned, &fDoubled, &fMove, &fCubeOwner, &fCrawford, &nMatchTo, anScore,
+                       &nCube, &fJacoby, &gs, szMatchID) < 0
+        || SetCubeInfo(&pxb->ci, nCube, fCubeOwner, fMove, nMatchTo, anScore, fCrawford, fJacoby, nBeavers,
+                       bgvDefault))
+        return;
+
+    PositionFromKey(pxb->anBoard, &key);
+    pxb->ec.nPlies = puch[4];
+    pxb->ec.fCubeful = (puch[5] & EXT_BINARY_CUBEFUL) != 0;
+    pxb->ec.fUsePrune = (puch[5] & EXT_BINARY_PRUNE) != 0;
+    pxb->ec.fDeterministic = (puch[5] & EXT_BINARY_DETERMINISTIC) != 0;
+    pxb->ec.rNoise = ExtGetFloat(puch + 8);
+    pxb->nStatus = EXT_STATUS_OK;
+
+    MT_ForkTask(&per->tg, ExtBinaryEvaluate, pxb);
+}
+
+/* Take a binary frame off what the client has sent, if it is all
+ * there */
+static int
+ExtClientFrame(extclient * pxc)
+{
+    guint32 cb;
+
+    if (pxc->gsInput->len < 4)
+        return FALSE;
+
+    if ((cb = ExtGetU32((const guchar *) pxc->gsInput->str)) > EXT_BINARY_MAX) {
+        outputl(_("Badly formed binary request from external connection."));
+        pxc->fClose = TRUE;
+        return FALSE;
+    }
+
+    if (pxc->gsInput->len < 4 + cb)
+        return FALSE;
+
+    ExtBinaryRequest(pxc, (const guchar *) pxc->gsInput->str + 4, cb);
+    g_string_erase(pxc->gsInput, 0, (gssize) (4 + cb));
+
+    return TRUE;
+}
+
+/* An HTTP answer of nStatus with the cb bytes of pb, of szType, as
+ * *pcb bytes */
+static char *
+ExtHttpResponseData(int nStatus, const char *szReason, const char *szType, const guchar * pb, gsize cb,
+                    int fKeepAlive, gsize * pcb)
+{
+    char *szHeader = g_strdup_printf("HTTP/1.1 %d %s\r\n"
+                                     "Content-Type: %s\r\n"
+                                     "Content-Length: %lu\r\n"
+                                     "Connection: %s\r\n"
+                                     "%s"
+                                     "\r\n",
+                                     nStatus, szReason, szType, (unsigned long) cb,
+                                     fKeepAlive ? "keep-alive" : "close", nStatus == 503 ? "Retry-After: 1\r\n" : "");
+    gsize cbHeader = strlen(szHeader);
+    char *pch = g_malloc(cbHeader + cb + 1);
+
+    memcpy(pch, szHeader, cbHeader);
+    memcpy(pch + cbHeader, pb, cb);
+    pch[cbHeader + cb] = 0;
+    *pcb = cbHeader + cb;
+
+    g_free(szHeader);
+    return pch;
+}
+
+/* An HTTP answer of nStatus with szBody of szType */
+static char *
+ExtHttpResponseType(int nStatus, const char *szReason, const char *szType, const char *szBody, int fKeepAlive)
+{
+    gsize cb;
+
+    return ExtHttpResponseData(nStatus, szReason, szType, (const guchar *) szBody, strlen(szBody), fKeepAlive, &cb);
+}
+
+/* An HTTP answer of nStatus with szBody as its JSON */
+static char *
+ExtHttpResponse(int nStatus, const char *szReason, const char *szBody, int fKeepAlive)
+{
+    return ExtHttpResponseType(nStatus, szReason, "application/json", szBody, fKeepAlive);
+}
+
+static char *
+ExtHttpError(int nStatus, const char *szReason, const char *szError, int fKeepAlive)
+{
+    char *szBody = g_strdup_printf("{\"error\": \"%s\"}\n", szError);
+    char *sz = ExtHttpResponse(nStatus, szReason, szBody, fKeepAlive);
+
+    g_free(szBody);
+    return sz;
+}
+
+static void
+ExtJsonFloat(GString * gs, const char *szKey, float r)
+{
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_string_append_printf(gs, "%s\"%s\": %s", gs->len > 1 ? ", " : "", szKey,
+                           g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.6f", r));
+}
+
+/* A chunk of a chunked HTTP answer, with the terminating one if fLast */
+static char *
+ExtHttpChunk(const char *sz, int fLast)
+{
+    return g_strdup_printf("%lx\r\n%s\r\n%s", (unsigned long) strlen(sz), sz, fLast ? "0\r\n\r\n" : "");
+}
+
+/* The line of JSON answering POST /hint with the moves of pml, evaluated
+ * at nPlies */
+static char *
+ExtHintLine(const exthttp * pxh, const movelist * pml, unsigned int nPlies, int fFinal)
+{
+    GString *gs = g_string_new(NULL);
+    char szMove[FORMATEDMOVESIZE];
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+    unsigned int i;
+
+    g_string_append_printf(gs, "{\"plies\": %u, \"final\": %s, \"moves\": [", nPlies, fFinal ? "true" : "false");
+    for (i = 0; i < MIN(pml->cMoves, pxh->nMoves); i++) {
+        FormatMovePlain(szMove, (ConstTanBoard) pxh->anBoard, pml->amMoves[i].anMove);
+        g_string_append_printf(gs, "%s{\"move\": \"%s\", \"equity\": %s}", i ? ", " : "", szMove,
+                               g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.6f", pml->amMoves[i].rScore));
+    }
+    g_string_append(gs, "]}\n");
+
+    return g_string_free(gs, FALSE);
+}
+
+/* The moves of a move filter stage of POST /hint, sent on while the
+ * deeper stages are worked on */
+static void
+ExtHintStage(const movelist * pml, unsigned int nPlies, void *p)
+{
+    exthttp *pxh = (exthttp *) p;
+    char *sz = ExtHintLine(pxh, pml, nPlies, FALSE);
+
+    g_async_queue_push(pxh->paqStream, ExtHttpChunk(sz, FALSE));
+    g_free(sz);
+}
+
+static void
+ExtHttpCall(void *p)
+{
+    extanswer *pea = (extanswer *) p;
+    exthttp *pxh = pea->pxh;
+    GString *gs = g_string_new("{");
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS], aarStdDev[2][NUM_ROLLOUT_OUTPUTS];
+    float arDouble[NUM_CUBEFUL_OUTPUTS];
+    TanBoard anBoardOrig;
+    char szMove[FORMATEDMOVESIZE];
+    int anMove[8];
+    int fOK = FALSE;
+    guchar *pb;
+    gsize cb;
+    movelist ml;
+    char *sz;
+
+    switch (pxh->hc) {
+    case HTTP_EVALUATE:
+        if (GeneralEvaluationE(arOutput, (ConstTanBoard) pxh->anBoard, &pxh->ci, &pxh->es.ec))
+            break;
+
+        ExtJsonFloat(gs, "win", arOutput[OUTPUT_WIN]);
+        ExtJsonFloat(gs, "wingammon", arOutput[OUTPUT_WINGAMMON]);
+        ExtJsonFloat(gs, "winbackgammon", arOutput[OUTPUT_WINBACKGAMMON]);
+        ExtJsonFloat(gs, "losegammon", arOutput[OUTPUT_LOSEGAMMON]);
+        ExtJsonFloat(gs, "losebackgammon", arOutput[OUTPUT_LOSEBACKGAMMON]);
+        ExtJsonFloat(gs, "equity", arOutput[OUTPUT_EQUITY]);
+        if (pxh->es.ec.fCubeful)
+            ExtJsonFloat(gs, "cubefulequity", arOutput[OUTPUT_CUBEFUL_EQUITY]);
+        fOK = TRUE;
+        break;
+
+    case HTTP_MOVE:
+        memcpy(anBoardOrig, pxh->anBoard, sizeof(TanBoard));
+        if (FindBestMove(anMove, (int) pxh->anDice[0], (int) pxh->anDice[1], pxh->anBoard, &pxh->ci, &pxh->es.ec,
+                         pxh->aamf) < 0)
+            break;
+
+        FormatMovePlain(szMove, (ConstTanBoard) anBoardOrig, anMove);
+        g_string_append_printf(gs, "\"move\": \"%s\"", szMove);
+        fOK = TRUE;
+        break;
+
+    case HTTP_CUBE:
+        if (GeneralCubeDecision(aarOutput, aarStdDev, NULL, (ConstTanBoard) pxh->anBoard, &pxh->ci,
+                                &pxh->es, NULL, NULL) < 0)
+            break;
+
+        /* the decision in words for people, in booleans for programs */
+        g_string_append_printf(gs, "\"decision\": \"%s\"",
+                               GetCubeRecommendation(FindCubeDecision(arDouble, aarOutput, &pxh->ci)));
+        g_string_append_printf(gs, ", \"double\": %s, \"accept\": %s",
+                               MIN(arDouble[OUTPUT_TAKE], arDouble[OUTPUT_DROP]) > arDouble[OUTPUT_NODOUBLE]
+                               ? "true" : "false", arDouble[OUTPUT_TAKE] <= arDouble[OUTPUT_DROP] ? "true" : "false");
+        ExtJsonFloat(gs, "nodouble", arDouble[OUTPUT_NODOUBLE]);
+        ExtJsonFloat(gs, "take", arDouble[OUTPUT_TAKE]);
+        ExtJsonFloat(gs, "drop", arDouble[OUTPUT_DROP]);
+        fOK = TRUE;
+        break;
+
+    case HTTP_BOARD:
+        /* not JSON but the image itself */
+        g_string_free(gs, TRUE);
+
+        if ((pb = BoardImage(&pxh->ms, pxh->bif, pxh->nSize, &cb))) {
+            pea->szResponse = ExtHttpResponseData(200, "OK", pxh->bif == BOARD_IMAGE_SVG ? "image/svg+xml"
+                                                  : "image/png", pb, cb, pxh->fKeepAlive, &pea->cbResponse);
+            g_free(pb);
+        } else
+            pea->szResponse = ExtHttpError(500, "Internal Server Error", "the image could not be made",
+                                           pxh->fKeepAlive);
+        return;
+
+    case HTTP_HINT:
+        /* not a JSON object but lines of them */
+        g_string_free(gs, TRUE);
+
+        if (FindnSaveBestMovesStaged(&ml, (int) pxh->anDice[0], (int) pxh->anDice[1], (ConstTanBoard) pxh->anBoard,
+                                     NULL, arSkillLevel[SKILL_DOUBTFUL], &pxh->ci, &pxh->es.ec, pxh->aamf,
+                                     pxh->paqStream ? ExtHintStage : NULL, pxh) < 0)
+            sz = g_strdup("{\"error\": \"the evaluation failed or was interrupted\"}\n");
+        else {
+            sz = ExtHintLine(pxh, &ml, pxh->es.ec.nPlies, TRUE);
+            g_free(ml.amMoves);
+            fOK = TRUE;
+        }
+
+        if (pxh->paqStream)
+            /* the status went with the first chunk */
+            pea->szResponse = ExtHttpChunk(sz, TRUE);
+        else if (fOK)
+            pea->szResponse = ExtHttpResponseType(200, "OK", "application/x-ndjson", sz, pxh->fKeepAlive);
+        else
+            pea->szResponse = ExtHttpResponse(500, "Internal Server Error", sz, pxh->fKeepAlive);
+        g_free(sz);
+        return;
+    }
+
+    g_string_append(gs, "}\n");
+
+    if (fOK)
+        pea->szResponse = ExtHttpResponse(200, "OK", gs->str, pxh->fKeepAlive);
+    else
+        pea->szResponse = ExtHttpError(500, "Internal Server Error", "the evaluation failed or was interrupted",
+                                       pxh->fKeepAlive);
+
+    g_string_free(gs, TRUE);
+}
+
+/* Set the field szKey of an HTTP request from its JSON value, a string
+ * or a number; FALSE if it is not a good one */
+static int
+ExtJsonField(exthttp * pxh, const char *szKey, const char *sz, double r, char *szPosID, char *szMatchID)
+{
+    if (!strcmp(szKey, "position")) {
+        if (!sz || strlen(sz) != L_POSITIONID)
+            return FALSE;
+        strcpy(szPosID, sz);
+    } else if (!strcmp(szKey, "match")) {
+        if (!sz || strlen(sz) != L_MATCHID)
+            return FALSE;
+        strcpy(szMatchID, sz);
+    } else if (!strcmp(szKey, "format")) {
+        if (!sz || BoardImageFormat(sz) < 0)
+            return FALSE;
+        pxh->bif = (boardimageformat) BoardImageFormat(sz);
+    } else if (!strcmp(szKey, "preset")) {
+        char szNumber[16];
+        evalpreset *pep;
+
+        if (!sz && r >= 0 && r < PRESET_MAX) {
+            sprintf(szNumber, "%u", (unsigned int) r);
+            sz = szNumber;
+        }
+        if (!sz || !(pep = PresetLookup(sz)))
+            return FALSE;
+        pxh->es.et = EVAL_EVAL;
+        pxh->es.ec = pxh->hc == HTTP_CUBE ? pep->ecCube : pep->ecChequer;
+        memcpy(pxh->aamf, pep->aamf, sizeof(pxh->aamf));
+    } else if (sz)
+        /* strings are not wanted for anything else */
+        return FALSE;
+    else if (!strcmp(szKey, "plies")) {
+        if (r < 0 || r > 7)
+            return FALSE;
+        pxh->es.ec.nPlies = (unsigned int) r;
+    } else if (!strcmp(szKey, "cubeful"))
+        pxh->es.ec.fCubeful = r != 0.0;
+    else if (!strcmp(szKey, "prune"))
+        pxh->es.ec.fUsePrune = r != 0.0;
+    else if (!strcmp(szKey, "deterministic"))
+        pxh->es.ec.fDeterministic = r != 0.0;
+    else if (!strcmp(szKey, "noise")) {
+        if (r < 0.0)
+            return FALSE;
+        pxh->es.ec.rNoise = (float) r;
+    } else if (!strcmp(szKey, "size")) {
+        if (r < 1 || r > 20)
+            return FALSE;
+        pxh->nSize = (unsigned int) r;
+    } else if (!strcmp(szKey, "moves")) {
+        if (r < 1 || r > EXT_HTTP_MAX_MOVES)
+            return FALSE;
+        pxh->nMoves = (unsigned int) r;
+    } else if (!strcmp(szKey, "stream"))
+        pxh->fStream = r != 0.0;
+
+    return TRUE;
+}
+
+/* Read the JSON object of an HTTP request, a flat one of strings,
+ * numbers and booleans */
+static int
+ExtJsonParse(exthttp * pxh, const char *szBody, char *szPosID, char *szMatchID)
+{
+    GScanner *pScanner = g_scanner_new(NULL);
+    int fOK = FALSE;
+
+    g_scanner_input_text(pScanner, szBody, (guint) strlen(szBody));
+
+    if (g_scanner_get_next_token(pScanner) != G_TOKEN_LEFT_CURLY)
+        goto done;
+
+    if (g_scanner_peek_next_token(pScanner) == G_TOKEN_RIGHT_CURLY)
+        g_scanner_get_next_token(pScanner);
+    else
+        for (;;) {
+            char *szKey;
+            GTokenType t;
+            int fNegative = FALSE;
+            int fField;
+
+            if (g_scanner_get_next_token(pScanner) != G_TOKEN_STRING)
+                goto done;
+            szKey = g_strdup(pScanner->value.v_string);
+
+            if (g_scanner_get_next_token(pScanner) != ':') {
+                g_free(szKey);
+                goto done;
+            }
+
+            if ((t = g_scanner_get_next_token(pScanner)) == '-') {
+                fNegative = TRUE;
+                t = g_scanner_get_next_token(pScanner);
+            }
+
+            if (t == G_TOKEN_STRING && !fNegative)
+                fField = ExtJsonField(pxh, szKey, pScanner->value.v_string, 0.0, szPosID, szMatchID);
+            else if (t == G_TOKEN_INT)
+                fField = ExtJsonField(pxh, szKey, NULL, fNegative ? -(double) pScanner->value.v_int
+                                      : (double) pScanner->value.v_int, szPosID, szMatchID);
+            else if (t == G_TOKEN_FLOAT)
+                fField = ExtJsonField(pxh, szKey, NULL, fNegative ? -pScanner->value.v_float
+                                      : pScanner->value.v_float, szPosID, szMatchID);
+            else if (t == G_TOKEN_IDENTIFIER && !fNegative && (!strcmp(pScanner->value.v_identifier, "true")
+                                                               || !strcmp(pScanner->value.v_identifier, "false")))
+                fField = ExtJsonField(pxh, szKey, NULL, !strcmp(pScanner->value.v_identifier, "true"), szPosID,
+                                      szMatchID);
+            else
+                fField = FALSE;
+
+            g_free(szKey);
+
+            if (!fField)
+                goto done;
+
+            if ((t = g_scanner_get_next_token(pScanner)) == G_TOKEN_RIGHT_CURLY)
+                break;
+            else if (t != G_TOKEN_COMMA)
+                goto done;
+        }
+
+    fOK = g_scanner_get_next_token(pScanner) == G_TOKEN_EOF;
+
+  done:
+    g_scanner_destroy(pScanner);
+    return fOK;
+}
+
+/* Answer or start working on the HTTP request szMethod szPath with
+ * szBody; fChunked if the client takes chunked answers */
+static void
+ExtHttpRequest(extclient * pxc, const char *szMethod, const char *szPath, const char *szBody, int fKeepAlive,
+               int fChunked)
+{
+    extrequest *per = ExtRequestNew(NULL);
+    extanswer *pea;
+    exthttp *pxh;
+    char szPosID[L_POSITIONID + 1] = "", szMatchID[L_MATCHID + 1] = "";
+    int fTurn, fResigned, fDoubled, fMove, fCubeOwner, fCrawford, nMatchTo, anScore[2], nCube, fJacoby;
+    gamestate gs;
+    httpcall hc;
+
+    per->fClose = !fKeepAlive;
+    g_queue_push_tail(pxc->pqRequests, per);
+
+    if (!strcmp(szPath, "/version")) {
+        char *szBody = g_strdup_printf("{\"interface\": \"%s\", \"engine\": \"%s\", \"software\": \"%s\"}\n",
+                                       EXTERNAL_INTERFACE_VERSION, WEIGHTS_VERSION, VERSION);
+
+        if (strcmp(szMethod, "GET"))
+            ExtRequestAnswer(per, ExtHttpError(405, "Method Not Allowed", "use GET", fKeepAlive));
+        else
+            ExtRequestAnswer(per, ExtHttpResponse(200, "OK", szBody, fKeepAlive));
+        g_free(szBody);
+        return;
+    } else if (!strcmp(szPath, "/metrics")) {
+        GString *gs;
+
+        if (strcmp(szMethod, "GET")) {
+            ExtRequestAnswer(per, ExtHttpError(405, "Method Not Allowed", "use GET", fKeepAlive));
+            return;
+        }
+
+        gs = MetricsText();
+        ExtRequestAnswer(per, ExtHttpResponseType(200, "OK", "text/plain; version=0.0.4; charset=utf-8", gs->str,
+                                                  fKeepAlive));
+        g_string_free(gs, TRUE);
+        return;
+    } else if (!strcmp(szPath, "/evaluate"))
+        hc = HTTP_EVALUATE;
+    else if (!strcmp(szPath, "/move"))
+        hc = HTTP_MOVE;
+    else if (!strcmp(szPath, "/cube"))
+        hc = HTTP_CUBE;
+    else if (!strcmp(szPath, "/board"))
+        hc = HTTP_BOARD;
+    else if (!strcmp(szPath, "/hint"))
+        hc = HTTP_HINT;
+    else {
+        ExtRequestAnswer(per, ExtHttpError(404, "Not Found", "no such call", fKeepAlive));
+        return;
+    }
+
+    if (strcmp(szMethod, "POST")) {
+        ExtRequestAnswer(per, ExtHttpError(405, "Method Not Allowed", "use POST", fKeepAlive));
+        return;
+    }
+
+    if (cHttpJobs >= EXT_HTTP_MAX_JOBS) {
+        ExtRequestAnswer(per, ExtHttpError(503, "Service Unavailable", "too busy", fKeepAlive));
+        return;
+    }
+
+    /* the settings of the hints, which the request may change */
+    pxh = g_new0(exthttp, 1);
+    pxh->hc = hc;
+    pxh->fKeepAlive = fKeepAlive;
+    pxh->es = hc == HTTP_CUBE ? *GetEvalCube() : *GetEvalChequer();
+    memcpy(pxh->aamf, *GetEvalMoveFilter(), sizeof(pxh->aamf));
+    pxh->bif = BOARD_IMAGE_PNG;
+    pxh->nSize = (unsigned int) exsExport.nPNGSize;
+    pxh->nMoves = 5;
+    pxh->fStream = TRUE;
+
+    if (!ExtJsonParse(pxh, szBody, szPosID, szMatchID) || !*szPosID || !*szMatchID
+        || !PositionFromID(pxh->anBoard, szPosID)
+        || MatchFromID(pxh->anDice, &fTurn, &fResigned, &fDoubled, &fMove, &fCubeOwner, &fCrawford, &nMatchTo,
+                       anScore, &nCube, &fJacoby, &gs, szMatchID) < 0
+        || SetCubeInfo(&pxh->ci, nCube, fCubeOwner, fMove, nMatchTo, anScore, fCrawford, fJacoby, nBeavers,
+                       bgvDefault)) {
+        g_free(pxh);
+        ExtRequestAnswer(per, ExtHttpError(400, "Bad Request", "badly formed request or IDs", fKeepAlive));
+        return;
+    }
+
+    if (hc == HTTP_BOARD) {
+        matchstate *pms = &pxh->ms;
+
+        memcpy(pms->anBoard, pxh->anBoard, sizeof(TanBoard));
+        memcpy(pms->anDice, pxh->anDice, sizeof(pms->anDice));
+        memcpy(pms->anScore, anScore, sizeof(pms->anScore));
+        pms->fTurn = fTurn;
+        pms->fResigned = fResigned;
+        pms->fDoubled = fDoubled;
+        pms->fMove = fMove;
+        pms->fCubeOwner = fCubeOwner;
+        pms->fCrawford = fCrawford;
+        pms->nMatchTo = nMatchTo;
+        pms->nCube = nCube;
+        pms->fJacoby = fJacoby;
+        pms->fCubeUse = fCubeUse;
+        pms->bgv = bgvDefault;
+        pms->gs = gs;
+    }
+
+    if ((hc == HTTP_MOVE || hc == HTTP_HINT) && !pxh->anDice[0]) {
+        g_free(pxh);
+        ExtRequestAnswer(per, ExtHttpError(400, "Bad Request", "the match ID has no dice", fKeepAlive));
+        return;
+    }
+
+    if (hc == HTTP_HINT && pxh->fStream && fChunked) {
+        pxh->paqStream = g_async_queue_new_full(g_free);
+        g_async_queue_push(pxh->paqStream, g_strdup_printf("HTTP/1.1 200 OK\r\n"
+                                                           "Content-Type: application/x-ndjson\r\n"
+                                                           "Transfer-Encoding: chunked\r\n"
+                                                           "Connection: %s\r\n"
+                                                           "\r\n", fKeepAlive ? "keep-alive" : "close"));
+    }
+
+    pea = ExtRequestAnswer(per, NULL);
+    pea->pxh = pxh;
+    cHttpJobs++;
+    MT_ForkTask(&per->tg, ExtHttpCall, pea);
+}
+
+/* Take an HTTP request off what the client has sent, if it is all
+ * there */
+static int
+ExtClientHttp(extclient * pxc)
+{
+    char *pchEnd = g_strstr_len(pxc->gsInput->str, (gssize) pxc->gsInput->len, "\r\n\r\n");
+    char **aszLines, **aszRequest;
+    size_t cbHeader;
+    unsigned long cbBody = 0;
+    int fKeepAlive, fHttp11;
+    int i;
+
+    if (!pchEnd) {
+        if (pxc->gsInput->len > EXT_HTTP_MAX_HEADER) {
+            outputl(_("Badly formed HTTP request from external connection."));
+            pxc->fClose = TRUE;
+        }
+        return FALSE;
+    }
+
+    cbHeader = (size_t) (pchEnd - pxc->gsInput->str) + 4;
+    *pchEnd = 0;
+    aszLines = g_strsplit(pxc->gsInput->str, "\r\n", 0);
+    *pchEnd = '\r';
+
+    aszRequest = g_strsplit(aszLines[0], " ", 3);
+    /* HTTP/1.1 keeps the connection by default, 1.0 closes it */
+    fHttp11 = g_strv_length(aszRequest) == 3 && !strcmp(aszRequest[2], "HTTP/1.1");
+    fKeepAlive = fHttp11;
+
+    for (i = 1; aszLines[i]; i++) {
+        char *pch = strchr(aszLines[i], ':');
+
+        if (!pch)
+            continue;
+
+        *pch++ = 0;
+        pch += strspn(pch, " \t");
+
+        if (!g_ascii_strcasecmp(aszLines[i], "Content-Length"))
+            cbBody = strtoul(pch, NULL, 10);
+        else if (!g_ascii_strcasecmp(aszLines[i], "Connection")) {
+            if (!g_ascii_strcasecmp(pch, "close"))
+                fKeepAlive = FALSE;
+            else if (!g_ascii_strcasecmp(pch, "keep-alive"))
+                fKeepAlive = TRUE;
+        } else if (!g_ascii_strcasecmp(aszLines[i], "Transfer-Encoding"))
+            /* chunked bodies are not read */
+            cbBody = EXT_HTTP_MAX_BODY + 1;
+    }
+
+    g_strfreev(aszLines);
+
+    if (cbBody > EXT_HTTP_MAX_BODY || g_strv_length(aszRequest) != 3) {
+        g_strfreev(aszRequest);
+        outputl(_("Badly formed HTTP request from external connection."));
+        pxc->fClose = TRUE;
+        return FALSE;
+    }
+
+    if (pxc->gsInput->len < cbHeader + cbBody) {
+        g_strfreev(aszRequest);
+        return FALSE;
+    }
+
+    {
+        char *szBody = g_strndup(pxc->gsInput->str + cbHeader, cbBody);
+
+        ExtHttpRequest(pxc, aszRequest[0], aszRequest[1], szBody, fKeepAlive, fHttp11);
+        g_free(szBody);
+    }
+
+    g_strfreev(aszRequest);
+    g_string_erase(pxc->gsInput, 0, (gssize) (cbHeader + cbBody));
+
+    return TRUE;
+}
+
+/* Whether the line of cch characters at pch is an HTTP request line */
+static int
+ExtIsHttp(const char *pch, size_t cch)
+{
+    if (cch && pch[cch - 1] == '\r')
+        cch--;
+
+    return cch > 9 && (!strncmp(pch + cch - 9, " HTTP/1.1", 9) || !strncmp(pch + cch - 9, " HTTP/1.0", 9));
+}
+
+/* Handle a command line of the client as a part of per; the
+ * evaluations are left to the calculation threads, the rest answered
+ * at once */
+static void
+ExtClientCommand(extclient * pxc, extrequest * per, char *szCommand)
+{
+    scancontext *pScanCtx = &pxc->scanctx;
+    char *szResponse = NULL;
+    gchar *szOptStr;
+    extanswer *pea;
+
+    if (ExtParse(pScanCtx, szCommand) == 0) {
+        /* parse error */
+        ExtRequestAnswer(per, pScanCtx->szError);
+        pScanCtx->szError = NULL;
+        unset_scan_context(pScanCtx, FALSE);
+        return;
+    }
+
+    switch (pScanCtx->ct) {
+    case COMMAND_HELP:
+        szResponse = g_strdup("\tNo help information available\n");
+        break;
+
+    case COMMAND_SET:
+        szOptStr = g_value_get_gstring_gchar(g_list_nth_data(pScanCtx->pCmdData, 0));
+        if (g_ascii_strcasecmp(szOptStr, KEY_STR_DEBUG) == 0) {
+            pScanCtx->fDebug = g_value_get_int(g_list_nth_data(pScanCtx->pCmdData, 1));
+            szResponse = g_strdup_printf("Debug output %s\n", pScanCtx->fDebug ? "ON" : "OFF");
+        } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_NEWINTERFACE) == 0) {
+            pScanCtx->fNewInterface = g_value_get_int(g_list_nth_data(pScanCtx->pCmdData, 1));
+            szResponse = g_strdup_printf("New interface %s\n", pScanCtx->fNewInterface ? "ON" : "OFF");
+        } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_BINARY) == 0) {
+            /* the lines after this one are binary frames */
+            pxc->fBinary = g_value_get_int(g_list_nth_data(pScanCtx->pCmdData, 1));
+            szResponse = g_strdup_printf("Binary interface %s\n", pxc->fBinary ? "ON" : "OFF");
+        } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_PRESET) == 0) {
+            const char *sz = g_value_get_gstring_gchar(g_list_nth_data(pScanCtx->pCmdData, 1));
+
+            if (!*sz) {
+                pScanCtx->pep = NULL;
+                szResponse = g_strdup("Preset OFF\n");
+            } else if ((pScanCtx->pep = PresetLookup(sz)) != NULL)
+                szResponse = g_strdup_printf("Preset %s\n", pScanCtx->pep->szName);
+            else
+                szResponse = g_strdup_printf("Error: no preset '%s'\n", sz);
+        } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_TIMELIMIT) == 0) {
+            pScanCtx->rTimeLimit = g_value_get_float(g_list_nth_data(pScanCtx->pCmdData, 1));
+            if (pScanCtx->rTimeLimit > 0.0f)
+                szResponse = g_strdup_printf("Time limit %.3f seconds\n", pScanCtx->rTimeLimit);
+            else {
+                pScanCtx->rTimeLimit = 0.0f;
+                szResponse = g_strdup("Time limit OFF\n");
+            }
+        } else {
+            szResponse = g_strdup_printf("Error: set option '%s' not supported\n", szOptStr);
+        }
+        g_list_gv_boxed_free(pScanCtx->pCmdData);
+
+        break;
+
+    case COMMAND_VERSION:
+        szResponse = g_strdup("Interface: " EXTERNAL_INTERFACE_VERSION "\n"
+                              "RFBF: " RFBF_VERSION_SUPPORTED "\n"
+                              "Engine: " WEIGHTS_VERSION "\n" "Software: " VERSION "\n");
+
+        break;
+
+    case COMMAND_NONE:
+        szResponse = g_strdup("Error: no command given\n");
+        break;
+
+    case COMMAND_FIBSBOARD:
+    case COMMAND_EVALUATION:
+        if (pScanCtx->fDebug)
+            ExtWriteDebug(pxc);
+        g_value_unsetfree(pScanCtx->pCmdData);
+
+        /* the evaluation gets the scancontext as it is now, the board
+         * names with it, while the client's goes on to the next
+         * command */
+        pea = ExtRequestAnswer(per, NULL);
+        pea->scanctx = *pScanCtx;
+        pScanCtx->bi.gsName = NULL;
+        pScanCtx->bi.gsOpp = NULL;
+        MT_ForkTask(&per->tg, ExtAnswerEvaluate, pea);
+        return;
+
+    case COMMAND_EXIT:
+        pxc->fClose = TRUE;
+        break;
+
+    default:
+        szResponse = g_strdup("Unsupported Command\n");
+    }
+
+    ExtRequestAnswer(per, szResponse);
+    unset_scan_context(pScanCtx, FALSE);
+}
+
+/* Handle a line of the client: a command, a batch or a line of one */
+static void
+ExtClientLine(extclient * pxc, char *szLine)
+{
+    extrequest *per;
+    char *szTag = NULL;
+    char *pch = szLine;
+
+    if ((per = pxc->perBatch)) {
+        if (!--per->cBatch)
+            pxc->perBatch = NULL;
+        ExtClientCommand(pxc, per, szLine);
+        return;
+    }
+
+    if (*pch == '@') {
+        size_t cch = strcspn(pch, " \t\n");
+
+        szTag = g_strndup(pch, cch);
+        pch += cch;
+        pch += strspn(pch, " \t");
+    }
+
+    per = ExtRequestNew(szTag);
+    g_queue_push_tail(pxc->pqRequests, per);
+
+    if (!g_ascii_strncasecmp(pch, "batch", 5) && pch[5] && strchr(" \t\n", pch[5])) {
+        char *pchEnd;
+        long n = strtol(pch + 5, &pchEnd, 10);
+
+        if (n < 1 || n > EXT_MAX_BATCH || *pchEnd != '\n')
+            ExtRequestAnswer(per, g_strdup_printf("Error: batch takes a number of boards from 1 to %d\n",
+                                                  EXT_MAX_BATCH));
+        else {
+            per->fBatch = TRUE;
+            per->cBatch = (unsigned int) n;
+            pxc->perBatch = per;
+        }
+        return;
+    }
+
+    ExtClientCommand(pxc, per, pch);
+}
+
+/* Handle the lines the client has sent, as long as it may have more
+ * requests going */
+static void
+ExtClientLines(extclient * pxc)
+{
+    while (!pxc->fClose && g_queue_get_length(pxc->pqRequests) < EXT_MAX_REQUESTS) {
+        char szCommand[EXT_MAX_LINE + 2];
+        char *pch = memchr(pxc->gsInput->str, '\n', pxc->gsInput->len);
+        size_t cch, cchUsed;
+
+        if (pxc->fBinary) {
+            if (!ExtClientFrame(pxc))
+                break;
+            continue;
+        } else if (pxc->fHttp) {
+            if (!ExtClientHttp(pxc))
+                break;
+            continue;
+        }
+
+        if (pch && pch - pxc->gsInput->str <= EXT_MAX_LINE)
+            cchUsed = (cch = (size_t) (pch - pxc->gsInput->str)) + 1;
+        else if (pch || pxc->gsInput->len >= EXT_MAX_LINE)
+            cchUsed = cch = EXT_MAX_LINE;
+        else
+            break;
+
+        if (!pxc->fStarted) {
+            pxc->fStarted = TRUE;
+            if (pch && ExtIsHttp(pxc->gsInput->str, cch)) {
+                pxc->fHttp = TRUE;
+                continue;
+            }
+        }
+
+        memcpy(szCommand, pxc->gsInput->str, cch);
+        /* To keep lexer happy terminate each line with \n */
+        szCommand[cch] = '\n';
+        szCommand[cch + 1] = 0;
+        g_string_erase(pxc->gsInput, 0, (gssize) cchUsed);
+
+        ExtClientLine(pxc, szCommand);
+    }
+}
+
+/* Send what has been streamed of the answers of per so far */
+static void
+ExtRequestStream(extclient * pxc, const extrequest * per)
+{
+    unsigned int i;
+
+    for (i = 0; i < per->pAnswers->len && !pxc->fClose; i++) {
+        const extanswer *pea = (const extanswer *) g_ptr_array_index(per->pAnswers, i);
+        char *sz;
+
+        if (!pea->pxh || !pea->pxh->paqStream)
+            continue;
+
+        while (!pxc->fClose && (sz = g_async_queue_try_pop(pea->pxh->paqStream))) {
+            if (ExternalWrite(pxc->h, sz, strlen(sz)))
+                pxc->fClose = TRUE;
+            g_free(sz);
+        }
+    }
+}
+
+/* Send the answers that are ready and may go; TRUE if the client has
+ * requests left */
+static int
+ExtClientAnswers(extclient * pxc)
+{
+    GList *pl = pxc->pqRequests->head;
+    int fWaiting = FALSE;
+    int fText = FALSE;
+
+    while (pl && !pxc->fClose) {
+        extrequest *per = (extrequest *) pl->data;
+        GList *plNext = pl->next;
+
+        /* the untagged ones in the order they came, the binary ones
+         * after all the text */
+        if (ExtRequestDone(per) && (per->fBinary ? !fText : per->szTag || !fWaiting)) {
+            GString *gsResponse;
+
+            ExtRequestStream(pxc, per);
+            gsResponse = ExtRequestResponse(per);
+
+            if ((gsResponse && !pxc->fClose && ExternalWrite(pxc->h, gsResponse->str, gsResponse->len))
+                || per->fClose)
+                pxc->fClose = TRUE;
+
+            MetricsRequest(per->fBinary ? METRICS_BINARY : pxc->fHttp ? METRICS_HTTP : METRICS_TEXT,
+                           g_get_monotonic_time() - per->tStart);
+
+            if (gsResponse)
+                g_string_free(gsResponse, TRUE);
+            ExtRequestFree(per);
+            g_queue_delete_link(pxc->pqRequests, pl);
+        } else if (!per->fBinary) {
+            /* the answer going next may be sent as far as it is done */
+            if (!per->szTag && !fWaiting)
+                ExtRequestStream(pxc, per);
+            fText = TRUE;
+            if (!per->szTag)
+                fWaiting = TRUE;
+        }
+
+        pl = plNext;
+    }
+
+    return !g_queue_is_empty(pxc->pqRequests);
+}
+
+/* Read what the client has sent, FALSE if it has gone */
+static int
+ExtClientRead(extclient * pxc)
+{
+    char ach[1024];
+#ifndef WIN32
+    ssize_t n;
+    psighandler sh;
+
+    PortableSignal(SIGPIPE, SIG_IGN, &sh, FALSE);
+    n = read(pxc->h, ach, sizeof(ach));
+    PortableSignalRestore(SIGPIPE, &sh);
+#else
+    /* reading from sockets doesn't work on Windows
+     * use recv instead */
+    int n = recv((SOCKET) pxc->h, ach, sizeof(ach), 0);
+#endif
+
+    if (n == 0) {
+        outputl(_("External connection closed."));
+        return FALSE;
+    } else if (n < 0) {
+        if (errno == EINTR)
+            return TRUE;
+
+        SockErr(_("reading from external connection"));
+        return FALSE;
+    }
+
+    g_string_append_len(pxc->gsInput, ach, (gssize) n);
+    return TRUE;
+}
+
+static extclient *
+ExtClientNew(int h)
+{
+    extclient *pxc = g_new0(extclient, 1);
+
+    pxc->h = h;
+    pxc->gsInput = g_string_new(NULL);
+    pxc->pqRequests = g_queue_new();
+    ExtInitParse(&pxc->scanctx.scanner);
+
+    return pxc;
+}
+
+static void
+ExtClientFree(extclient * pxc)
+{
+    extrequest *per;
+
+    while ((per = (extrequest *) g_queue_pop_head(pxc->pqRequests)) != NULL)
+        ExtRequestFree(per);
+    g_queue_free(pxc->pqRequests);
+
+    closesocket(pxc->h);
+    unset_scan_context(&pxc->scanctx, TRUE);
+    g_string_free(pxc->gsInput, TRUE);
+    g_free(pxc);
+}
 #endif
 
 extern void
@@ -577,14 +2009,10 @@ CommandExternal(char *sz)
     int h, hPeer;
     socklen_t cb;
     struct sockaddr *psa;
-    char szCommand[256];
-    char *szResponse = NULL;
     struct sockaddr_in saRemote;
     socklen_t saLen;
-    scancontext scanctx;
-    int fExit;
-    int fRestart = TRUE;
-    int retval = 0;
+    GList *plClients = NULL, *pl;
+    unsigned int cClients = 0;
 
     sz = NextToken(&sz);
 
@@ -593,234 +2021,121 @@ CommandExternal(char *sz)
         return;
     }
 
-    memset(&scanctx, 0, sizeof(scanctx));
-    ExtInitParse(&scanctx.scanner);
-
-  listenloop:
-    {
-        fExit = FALSE;
-        scanctx.fDebug = FALSE;
-        scanctx.fNewInterface = FALSE;
+    if ((h = ExternalSocket(&psa, &cb, sz)) < 0) {
+        SockErr(sz);
+        return;
+    }
 
-        if ((h = ExternalSocket(&psa, &cb, sz)) < 0) {
-            SockErr(sz);
-            ExtDestroyParse(scanctx.scanner);
-            return;
-        }
+    if (bind(h, psa, cb) < 0) {
+        SockErr(sz);
+        closesocket(h);
+        g_free(psa);
+        return;
+    }
 
-        if (bind(h, psa, cb) < 0) {
-            SockErr(sz);
-            closesocket(h);
-            g_free(psa);
-            ExtDestroyParse(scanctx.scanner);
-            return;
-        }
+    g_free(psa);
 
-        g_free(psa);
+    if (listen(h, SOMAXCONN) < 0) {
+        SockErr("listen");
+        closesocket(h);
+        return;
+    }
+    outputf(_("Waiting for a connection from %s...\n"), sz);
+    outputx();
+
+    /* Serve any number of controllers at once: their commands are
+     * handled here as they come in, and their evaluations run on the
+     * calculation threads, each client with a scancontext of its own,
+     * until interrupted */
+    for (;;) {
+        fd_set fds;
+        struct timeval tv;
+        int hMax = h;
+        int fPending = FALSE;
+        int n;
 
-        if (listen(h, 1) < 0) {
-            SockErr("listen");
-            closesocket(h);
-            ExtDestroyParse(scanctx.scanner);
-            return;
-        }
-        outputf(_("Waiting for a connection from %s...\n"), sz);
-        outputx();
         ProcessEvents();
 
-        /* Must set length when using windows */
-        saLen = sizeof(struct sockaddr);
-        while ((hPeer = accept(h, (struct sockaddr *) &saRemote, &saLen)) < 0) {
-            if (errno == EINTR) {
-                ProcessEvents();
-
-                if (MT_SafeGet(&fInterrupt)) {
-                    closesocket(h);
-                    ExtDestroyParse(scanctx.scanner);
-                    return;
-                }
+        if (MT_SafeGet(&fInterrupt))
+            break;
 
-                continue;
+        FD_ZERO(&fds);
+        FD_SET(h, &fds);
+
+        for (pl = plClients; pl;) {
+            extclient *pxc = (extclient *) pl->data;
+            GList *plNext = pl->next;
+
+            ExtClientLines(pxc);
+            if (ExtClientAnswers(pxc))
+                fPending = TRUE;
+
+            if (pxc->fClose) {
+                ExtClientFree(pxc);
+                plClients = g_list_delete_link(plClients, pl);
+                cClients--;
+            } else if (g_queue_get_length(pxc->pqRequests) < EXT_MAX_REQUESTS) {
+                FD_SET(pxc->h, &fds);
+                if (pxc->h > hMax)
+                    hMax = pxc->h;
             }
 
-            SockErr("accept");
-            closesocket(h);
-            ExtDestroyParse(scanctx.scanner);
-            return;
+            pl = plNext;
         }
 
-        closesocket(h);
+        /* look for finished evaluations often, for events less so */
+        tv.tv_sec = 0;
+        tv.tv_usec = fPending ? 5000 : 100000;
 
-        /* print info about remove client */
+        if ((n = select(hMax + 1, &fds, NULL, NULL, &tv)) < 0) {
+            if (errno == EINTR)
+                continue;
 
-        outputf(_("Accepted connection from %s.\n"), inet_ntoa(saRemote.sin_addr));
-        outputx();
-        ProcessEvents();
+            SockErr("select");
+            break;
+        } else if (n == 0)
+            continue;
 
-        while (!fExit && !(retval = ExternalRead(hPeer, szCommand, sizeof(szCommand)))) {
-            /* To keep lexer happy terminate each line with \n */
-            if (szCommand[strlen(szCommand) - 1] != '\n')
-                strcat(szCommand, "\n");
-
-            if ((ExtParse(&scanctx, szCommand)) == 0) {
-                /* parse error */
-                szResponse = scanctx.szError;
-            } else {
-                ProcessedFIBSBoard processedBoard;
-                gchar *szOptStr;
-
-                switch (scanctx.ct) {
-                case COMMAND_HELP:
-                    szResponse = g_strdup("\tNo help information available\n");
-                    break;
-
-                case COMMAND_SET:
-                    szOptStr = g_value_get_gstring_gchar(g_list_nth_data(scanctx.pCmdData, 0));
-                    if (g_ascii_strcasecmp(szOptStr, KEY_STR_DEBUG) == 0) {
-                        scanctx.fDebug = g_value_get_int(g_list_nth_data(scanctx.pCmdData, 1));
-                        szResponse = g_strdup_printf("Debug output %s\n", scanctx.fDebug ? "ON" : "OFF");
-                    } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_NEWINTERFACE) == 0) {
-                        scanctx.fNewInterface = g_value_get_int(g_list_nth_data(scanctx.pCmdData, 1));
-                        szResponse = g_strdup_printf("New interface %s\n", scanctx.fNewInterface ? "ON" : "OFF");
-                    } else {
-                        szResponse = g_strdup_printf("Error: set option '%s' not supported\n", szOptStr);
-                    }
-                    g_list_gv_boxed_free(scanctx.pCmdData);
-
-                    break;
-
-                case COMMAND_VERSION:
-                    szResponse = g_strdup("Interface: " EXTERNAL_INTERFACE_VERSION "\n"
-                                          "RFBF: " RFBF_VERSION_SUPPORTED "\n"
-                                          "Engine: " WEIGHTS_VERSION "\n" "Software: " VERSION "\n");
-
-                    break;
-
-                case COMMAND_NONE:
-                    szResponse = g_strdup("Error: no command given\n");
-                    break;
-
-                case COMMAND_FIBSBOARD:
-                case COMMAND_EVALUATION:
-                    if (scanctx.fDebug) {
-                        GValue *optionsmapgv;
-                        GValue *boarddatagv;
-                        GString *dbgStr;
-                        int anScore[2];
-                        int fcrawford, fjacoby;
-                        char *asz[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-                        char szBoard[10000];
-                        char **aszLines, **aszLinesOrig;
-                        char *szMatchID;
-
-                        optionsmapgv = (GValue *) g_list_nth_data(g_value_get_boxed(scanctx.pCmdData), 1);
-                        boarddatagv = (GValue *) g_list_nth_data(g_value_get_boxed(scanctx.pCmdData), 0);
-                        dbgStr = g_string_new(DEBUG_PREFIX);
-                        g_value_tostring(dbgStr, optionsmapgv, 0);
-                        g_string_append(dbgStr, "\n" DEBUG_PREFIX);
-                        g_value_tostring(dbgStr, boarddatagv, 0);
-                        g_string_append(dbgStr, "\n" DEBUG_PREFIX "\n");
-                        ExternalWrite(hPeer, dbgStr->str, strlen(dbgStr->str));
-                        ProcessFIBSBoardInfo(&scanctx.bi, &processedBoard);
-
-                        anScore[0] = processedBoard.nScoreOpp;
-                        anScore[1] = processedBoard.nScore;
-                        /* If the session isn't using Crawford rule, set Crawford flag to false */
-                        fcrawford = scanctx.fCrawfordRule ? processedBoard.fCrawford : FALSE;
-                        /* Set the Jacoby flag appropriately from the external interface settings */
-                        fjacoby = scanctx.fJacobyRule;
-
-                        szMatchID = MatchID((unsigned int *) processedBoard.anDice, 1, processedBoard.nResignation,
-                                            processedBoard.fDoubled, 1, processedBoard.fCubeOwner, fcrawford,
-                                            processedBoard.nMatchTo, anScore, processedBoard.nCube, fjacoby,
-                                            GAME_PLAYING);
-
-                        DrawBoard(szBoard, (ConstTanBoard) & processedBoard.anBoard, 1, asz, szMatchID, 15);
-
-                        aszLines = g_strsplit(&szBoard[0], "\n", 32);
-                        aszLinesOrig = aszLines;
-                        while (*aszLines) {
-                            ExternalWrite(hPeer, DEBUG_PREFIX, strlen(DEBUG_PREFIX));
-                            ExternalWrite(hPeer, *aszLines, strlen(*aszLines));
-                            ExternalWrite(hPeer, "\n", 1);
-                            aszLines++;
-                        }
-
-                        dbgStr = g_string_assign(dbgStr, "");
-                        g_string_append_printf(dbgStr, DEBUG_PREFIX "X is %s, O is %s\n", processedBoard.szPlayer,
-                                               processedBoard.szOpp);
-                        if (processedBoard.nMatchTo) {
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Match Play %s Crawford Rule\n",
-                                                   scanctx.fCrawfordRule ? "with" : "without");
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d/%d%s, ", processedBoard.nScore,
-                                                   processedBoard.nScoreOpp, processedBoard.nMatchTo,
-                                                   fcrawford ? "*" : "");
-                        } else {
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Money Session %s Jacoby Rule, %s Beavers\n",
-                                                   scanctx.fJacobyRule ? "with" : "without",
-                                                   scanctx.fBeavers ? "with" : "without");
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d, ", processedBoard.nScore,
-                                                   processedBoard.nScoreOpp);
-                        }
-                        g_string_append_printf(dbgStr, "Roll: %d%d\n",
-                                               processedBoard.anDice[0], processedBoard.anDice[1]);
-                        g_string_append_printf(dbgStr,
-                                               DEBUG_PREFIX
-                                               "CubeOwner: %d, Cube: %d, Turn: %c, Doubled: %d, Resignation: %d\n",
-                                               processedBoard.fCubeOwner, processedBoard.nCube, 'X',
-                                               processedBoard.fDoubled, processedBoard.nResignation);
-                        g_string_append(dbgStr, DEBUG_PREFIX "\n");
-                        ExternalWrite(hPeer, dbgStr->str, strlen(dbgStr->str));
-
-                        g_string_free(dbgStr, TRUE);
-                        g_strfreev(aszLinesOrig);
-                    }
-                    g_value_unsetfree(scanctx.pCmdData);
-
-                    if (scanctx.ct == COMMAND_EVALUATION)
-                        szResponse = ExtEvaluation(&scanctx);
-                    else
-                        szResponse = ExtFIBSBoard(&scanctx);
-
-                    break;
-
-                case COMMAND_EXIT:
-                    closesocket(hPeer);
-                    fExit = TRUE;
-                    break;
-
-                default:
-                    szResponse = g_strdup("Unsupported Command\n");
-                }
-                unset_scan_context(&scanctx, FALSE);
-            }
+        for (pl = plClients; pl; pl = pl->next) {
+            extclient *pxc = (extclient *) pl->data;
 
-            if (szResponse) {
-                /* outputf("%s", szResponse); */
-                if (ExternalWrite(hPeer, szResponse, strlen(szResponse)))
-                    break;
+            if (FD_ISSET(pxc->h, &fds) && !ExtClientRead(pxc))
+                pxc->fClose = TRUE;
+        }
 
-                g_free(szResponse);
-                szResponse = NULL;
+        if (FD_ISSET(h, &fds)) {
+            /* Must set length when using windows */
+            saLen = sizeof(struct sockaddr);
+            if ((hPeer = accept(h, (struct sockaddr *) &saRemote, &saLen)) < 0) {
+                if (errno != EINTR)
+                    SockErr("accept");
+                continue;
             }
 
-        }
-        /* Interrupted : get out of listen loop */
-        if (retval == -2) {
-            ProcessEvents();
-            fRestart = FALSE;
-        }
+#ifndef WIN32
+            if (hPeer >= FD_SETSIZE) {
+#else
+            if (cClients + 1 >= FD_SETSIZE) {
+#endif
+                outputf(_("Too many external connections, refusing %s.\n"), inet_ntoa(saRemote.sin_addr));
+                closesocket(hPeer);
+                continue;
+            }
 
-        closesocket(hPeer);
-        if (szResponse)
-            g_free(szResponse);
+            /* print info about remove client */
 
-        szResponse = NULL;
-        scanctx.szError = NULL;
+            outputf(_("Accepted connection from %s.\n"), inet_ntoa(saRemote.sin_addr));
+            outputx();
+
+            plClients = g_list_append(plClients, ExtClientNew(hPeer));
+            cClients++;
+        }
     }
-    if (fRestart)
-        goto listenloop;
 
-    unset_scan_context(&scanctx, TRUE);
+    closesocket(h);
+
+    for (pl = plClients; pl; pl = pl->next)
+        ExtClientFree((extclient *) pl->data);
+    g_list_free(plClients);
 #endif
 }
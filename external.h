@@ -27,6 +27,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include "backgammon.h"
+#include "preset.h"
 
 /* Stuff for the yacc/lex parser */
 extern void ExtStartParse(void *scanner, const char *szCommand);
@@ -47,6 +48,9 @@ extern void ExtDestroyParse(void *scancontext);
 #define KEY_STR_NEWINTERFACE "newinterface"
 #define KEY_STR_DEBUG "debug"
 #define KEY_STR_PROMPT "prompt"
+#define KEY_STR_TIMELIMIT "timelimit"
+#define KEY_STR_BINARY "binary"
+#define KEY_STR_PRESET "preset"
 
 typedef enum {
     COMMAND_NONE = 0,
@@ -162,6 +166,8 @@ typedef struct scancontext {
     int fError;
     int fDebug;
     int fNewInterface;
+    float rTimeLimit;           /* seconds to find a move in, or 0 */
+    evalpreset *pep;            /* of "set preset", or NULL */
     char *szError;
 
     /* command type */
@@ -204,7 +210,7 @@ typedef struct scancontext {
 #include <ws2tcpip.h>
 #endif                          /* #ifndef WIN32 */
 
-#define EXTERNAL_INTERFACE_VERSION "2"
+#define EXTERNAL_INTERFACE_VERSION "4"
 #define RFBF_VERSION_SUPPORTED "0"
 
 extern int ExternalSocket(struct sockaddr **ppsa, socklen_t *pcb, char *sz);
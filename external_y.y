@@ -126,7 +126,7 @@ void yyerror(scancontext *scanner, const char *str)
 %}
 
 %token EOL EXIT DISABLED INTERFACEVERSION 
-%token DEBUG SET NEW OLD OUTPUT E_INTERFACE HELP PROMPT
+%token DEBUG SET NEW OLD OUTPUT E_INTERFACE HELP PROMPT TIMELIMIT BINARY PRESET
 %token E_STRING E_CHARACTER E_INTEGER E_FLOAT E_BOOLEAN
 %token FIBSBOARD FIBSBOARDEND EVALUATION
 %token CRAWFORDRULE JACOBYRULE RESIGNATION BEAVERS
@@ -276,6 +276,38 @@ setcommand:
         {
             $$ = create_str2gvalue_tuple (KEY_STR_PROMPT, $2);
         }
+    |
+    TIMELIMIT float_type
+        {
+            $$ = create_str2gvalue_tuple (KEY_STR_TIMELIMIT, $2);
+        }
+    |
+    TIMELIMIT integer_type
+        {
+            GVALUE_CREATE(G_TYPE_FLOAT, float, (float) g_value_get_int($2), gvfloat); 
+            $$ = create_str2gvalue_tuple (KEY_STR_TIMELIMIT, gvfloat); 
+            g_value_unsetfree($2);
+        }
+    |
+    BINARY boolean_type
+        {
+            $$ = create_str2gvalue_tuple (KEY_STR_BINARY, $2);
+        }
+    |
+    PRESET string_type
+        {
+            $$ = create_str2gvalue_tuple (KEY_STR_PRESET, $2);
+        }
+    |
+    PRESET integer_type
+        {
+            GString *str = g_string_new(NULL);
+            g_string_printf(str, "%d", g_value_get_int($2));
+            GVALUE_CREATE(G_TYPE_GSTRING, boxed, str, gvstr); 
+            g_string_free(str, TRUE); 
+            $$ = create_str2gvalue_tuple (KEY_STR_PRESET, gvstr);
+            g_value_unsetfree($2);
+        }
     ;
     
 command:
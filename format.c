@@ -339,7 +339,11 @@ OutputRolloutContext(const char *szIndent, const rolloutcontext * prc)
     else if (prc->fTruncBearoff2 && !prc->fCubeful)
         sprintf(strchr(sz, 0), " (%s)", _("truncated at exact bearoff"));
 
-    sprintf(strchr(sz, 0), " %s", prc->fVarRedn ? _("with variance reduction") : _("without variance reduction"));
+    if (prc->fVarRedn)
+        sprintf(strchr(sz, 0), " %s", _("with variance reduction"));
+    else
+        sprintf(strchr(sz, 0), " %s",
+                prc->fQuickVarRedn ? _("with quick variance reduction") : _("without variance reduction"));
 
     strcat(sz, "\n");
 
@@ -354,7 +358,9 @@ OutputRolloutContext(const char *szIndent, const rolloutcontext * prc)
     }
 
     strcat(sz, ", ");
-    if (prc->fRotate)
+    if (prc->fRotate && prc->fSobol)
+        sprintf(strchr(sz, 0), _("%s dice gen. with seed %lu and Sobol dice"), gettext(aszRNG[prc->rngRollout]), prc->nSeed);    /* seed may be unsigned long int */
+    else if (prc->fRotate)
         sprintf(strchr(sz, 0), _("%s dice gen. with seed %lu and quasi-random dice"), gettext(aszRNG[prc->rngRollout]), prc->nSeed);    /* seed may be unsigned long int */
     else
         sprintf(strchr(sz, 0), _("%s dice generator with seed %lu"), gettext(aszRNG[prc->rngRollout]), prc->nSeed);     /* seed may be unsigned long int */
@@ -382,6 +388,14 @@ OutputRolloutContext(const char *szIndent, const rolloutcontext * prc)
         strcat(sz, "\n");
     }
 
+    if (prc->fAdaptiveJsd) {
+        if (szIndent && *szIndent)
+            strcat(sz, szIndent);
+        sprintf(strchr(sz, 0), _("Fewer games of plays that are JSDs behind (min. %u games)"),
+                prc->nMinimumJsdGames);
+        strcat(sz, "\n");
+    }
+
     /* first play */
 
     OutputEvalContextsForRollout(sz, szIndent, prc->aecCube, prc->aecChequer, prc->aaamfChequer);
@@ -1062,8 +1076,8 @@ static int
 DumpBearoffTS(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(pbcTS);
-    return BearoffDump(pbcTS, anBoard, szOutput);
+    g_assert(GetBearoffTS());
+    return BearoffDump(GetBearoffTS(), anBoard, szOutput);
 
 }
 
@@ -1102,8 +1116,8 @@ static int
 DumpHypergammon1(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[0]);
-    return BearoffDump(apbcHyper[0], anBoard, szOutput);
+    g_assert(GetBearoffHyper(0));
+    return BearoffDump(GetBearoffHyper(0), anBoard, szOutput);
 
 }
 
@@ -1111,8 +1125,8 @@ static int
 DumpHypergammon2(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[1]);
-    return BearoffDump(apbcHyper[1], anBoard, szOutput);
+    g_assert(GetBearoffHyper(1));
+    return BearoffDump(GetBearoffHyper(1), anBoard, szOutput);
 
 }
 
@@ -1120,8 +1134,8 @@ static int
 DumpHypergammon3(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[2]);
-    return BearoffDump(apbcHyper[2], anBoard, szOutput);
+    g_assert(GetBearoffHyper(2));
+    return BearoffDump(GetBearoffHyper(2), anBoard, szOutput);
 
 }
 
@@ -1139,7 +1153,7 @@ DumpPosition(const TanBoard anBoard, char *szOutput,
              int UNUSED(fOutputWinPC), int fOutputInvert, const char *szMatchID)
 {
 
-    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+    float aaarOutput[10][2][NUM_ROLLOUT_OUTPUTS];
     positionclass pc = ClassifyPosition(anBoard, pci->bgv);
     int i, nPlies;
     int j;
@@ -1185,15 +1199,16 @@ DumpPosition(const TanBoard anBoard, char *szOutput,
     nPlies = pec->nPlies > 9 ? 9 : pec->nPlies;
 
     memcpy(&ec, pec, sizeof(evalcontext));
+    ec.nPlies = nPlies;
 
-    for (i = 0; i <= nPlies; i++) {
-        szOutput = strchr(szOutput, 0);
-
+    /* all the plies from one search */
+    if (GeneralCubeDecisionEPlies(aaarOutput, anBoard, pci, &ec) < 0)
+        return -1;
 
-        ec.nPlies = i;
+    for (i = 0; i <= nPlies; i++) {
+        float (*aarOutput)[NUM_ROLLOUT_OUTPUTS] = aaarOutput[i];
 
-        if (GeneralCubeDecisionE(aarOutput, anBoard, pci, &ec, 0) < 0)
-            return -1;
+        szOutput = strchr(szOutput, 0);
 
         if (!i)
             strcpy(szOutput, _("static"));
@@ -1239,7 +1254,7 @@ DumpPosition(const TanBoard anBoard, char *szOutput,
         es.ec = *pec;
 
         strcat(szOutput, "\n\n");
-        strcat(szOutput, OutputCubeAnalysis(aarOutput, NULL, &es, pci, -1));
+        strcat(szOutput, OutputCubeAnalysis(aaarOutput[nPlies], NULL, &es, pci, -1));
 
     }
 
@@ -68,6 +68,7 @@ static char szCommandSeparators[] = " \t\n\r\v\f";
 #include "analysis.h"
 #include "backgammon.h"
 #include "dice.h"
+#include "randomorg.h"
 #include "drawboard.h"
 #include "eval.h"
 #include "sgf.h"
@@ -78,6 +79,7 @@ static char szCommandSeparators[] = " \t\n\r\v\f";
 #include "render.h"
 #include "renderprefs.h"
 #include "rollout.h"
+#include "rolloutworker.h"
 #include "sound.h"
 #include "progress.h"
 #include "osr.h"
@@ -86,6 +88,7 @@ static char szCommandSeparators[] = " \t\n\r\v\f";
 #include "credits.h"
 #include "external.h"
 #include "neuralnet.h"
+#include "profile.h"
 #include "util.h"
 
 #if defined(LIBCURL_PROTOCOL_HTTPS)
@@ -182,6 +185,7 @@ matchinfo mi;
 
 float rRatingOffset = 2050;
 int fAnalyseCube = TRUE;
+int fAnalyseCubeScreen = FALSE;
 int fAnalyseDice = TRUE;
 int fAnalyseMove = TRUE;
 int fAutoBearoff = FALSE;
@@ -211,6 +215,7 @@ int fInvertMET = FALSE;
 int fJacoby = TRUE;
 int fOutputRawboard = FALSE;
 int fPlayersAreSame = TRUE;
+int fProgressiveHint = FALSE;
 int fRecord = TRUE;
 int fShowProgress;
 int fStyledGamelist = TRUE;
@@ -329,6 +334,9 @@ rolloutcontext rcRollout = {
     FALSE,                      /* no stop on STD */
     FALSE,                      /* no stop on JSD */
     FALSE,                      /* no move stop on JSD */
+    FALSE,                      /* no quick variance reduction */
+    FALSE,                      /* same games for all moves */
+    FALSE,                      /* permuted quasi-random dice */
     10,                         /* truncation */
     1296,                       /* number of trials */
     5,                          /* late evals start here */
@@ -341,6 +349,7 @@ rolloutcontext rcRollout = {
     0,                          /* nGamesDone */
     0.0,                        /* rStoppedOnJSD */
     0,                          /* nSkip */
+    0,                          /* no time limit */
 };
 
 /* parameters for `eval' and `hint' */
@@ -383,6 +392,9 @@ rolloutcontext rcRollout = {
   FALSE,  /* no stop on STD */ \
   FALSE,  /* no stop on JSD */ \
   FALSE,  /* no move stop on JSD */ \
+  FALSE,  /* no quick variance reduction */ \
+  FALSE,  /* same games for all moves */ \
+  FALSE,  /* permuted quasi-random dice */ \
   10, /* truncation */ \
   1296, /* number of trials */ \
   5,  /* late evals start here */ \
@@ -394,7 +406,8 @@ rolloutcontext rcRollout = {
   2.33f,  /* stop when best has j.s.d. for 99% confidence */ \
   0, \
   0.0, \
-  0 \
+  0, \
+  0   /* no time limit */ \
   } \
 }
 
@@ -438,6 +451,9 @@ rolloutcontext rcRollout = {
   FALSE,  /* no stop on STD */ \
   FALSE,  /* no stop on JSD */ \
   FALSE,  /* no move stop on JSD */ \
+  FALSE,  /* no quick variance reduction */ \
+  FALSE,  /* same games for all moves */ \
+  FALSE,  /* permuted quasi-random dice */ \
   10, /* truncation */ \
   1296, /* number of trials */ \
   5,  /* late evals start here */ \
@@ -449,7 +465,8 @@ rolloutcontext rcRollout = {
   2.33f,  /* stop when best has j.s.d. for 99% confidence */ \
   0, \
   0.0, \
-  0 \
+  0, \
+  0   /* no time limit */ \
   } \
 }
 
@@ -510,7 +527,9 @@ exportsetup exsExport = {
     HTML_EXPORT_CSS_HEAD,       /* write CSS stylesheet in <head> */
 
     4,                          /* PNG size */
-    4                           /* HTML size */
+    4,                          /* HTML size */
+
+    NULL                        /* no PNG image cache */
 };
 
 
@@ -524,10 +543,19 @@ char default_names[2][MAX_NAME_LEN] = { "gnubg", "user" };
 
 /* Usage strings */
 static char szDICE[] = N_("<die> <die>"),
+    szARCHIVEFILES[] = N_("<archive> <filename> ..."),
+    szARROWFILES[] = N_("<filename> <filename or folder> ..."),
     szCOMMAND[] = N_("<command>"),
     szCOMMENT[] = N_("<comment>"),
     szER[] = "evaluation|rollout",
     szFILENAME[] = N_("<filename>"),
+    szFILENAMES[] = N_("<filename> ..."),
+    szFILENAMEMATCH[] = N_("<filename> [match]"),
+    szFILESFOLDER[] = N_("<files> <folder>"),
+    szFILESORFOLDERS[] = N_("<filename or folder> ..."),
+    szFOLDERFILES[] = N_("<folder> <filename> ..."),
+    szHOSTPORT[] = N_("<host:port>"),
+    szHOSTPORTS[] = N_("<host:port> ...|none"),
     szKEYVALUE[] = N_("[<key>=<value> ...]"),
     szLENGTH[] = N_("<length>"),
     szLIMIT[] = N_("<limit>"),
@@ -536,6 +564,7 @@ static char szDICE[] = N_("<die> <die>"),
     szFILTER[] = N_("<ply> <num.xjoin to accept (0 = skip)> "
                     "[<num. of extra moves to accept> <tolerance>]"),
     szNAME[] = N_("<name>"),
+    szNAMEFILENAME[] = N_("<name> <filename>"),
     szQUIET[] = "[quiet]",
     szLANG[] = N_("system|<language code>"),
     szONOFF[] = "on|off",
@@ -543,12 +572,15 @@ static char szDICE[] = N_("<die> <die>"),
     szOPTDATE[] = N_("[yyyy-mm-dd]"),
     szOPTDEPTH[] = N_("[depth]"),
     szOPTFILENAME[] = N_("[filename]"),
+    szOPTINCREMENTAL[] = "[incremental|triage]",
     szOPTLENGTH[] = N_("[length]"),
+    szOPTLOWWATER[] = N_("[lowwater <dice>]"),
     szOPTMODULUSOPTSEED[] = N_("[modulus <modulus>|factors <factor> <factor>] "
                                "[seed]"),
     szOPTNAME[] = N_("[name]"),
     szOPTPOSITION[] = N_("[position]"),
     szOPTSEED[] = N_("[seed]"),
+    szOPTSTATISTICS[] = N_("[statistics]"),
     szOPTVALUE[] = N_("[value]"),
     szPLAYER[] = N_("<player>"),
     szPLAYEROPTRATING[] = N_("<player> [rating]"),
@@ -556,9 +588,14 @@ static char szDICE[] = N_("<die> <die>"),
     szPOSITION[] = N_("<position>"),
     szPRIORITY[] = N_("<priority>"),
     szPROMPT[] = N_("<prompt>"),
+    szROLLOUTLOG[] = N_("<filename> [trial [move]]"),
     szSCORE[] = N_("<score> [length]"),
+    szSCOREGRID[] = N_("[max away] [filename]"),
+    szSECONDS[] = N_("<seconds>"),
+    szSELFPLAY[] = N_("<matches> [length [seed]]"),
     szSIZE[] = N_("<size>"),
     szSTEP[] = N_("[game|roll|rolled|marked] <count>"),
+    szSUMMARY[] = N_("<filename> [player]"),
     szTRIALS[] = N_("<trials>"),
     szVALUE[] = N_("<value>"),
     szMATCHID[] = N_("<matchid>"),
@@ -566,6 +603,7 @@ static char szDICE[] = N_("<die> <die>"),
     szXGID[] = N_("<xgid>"),
     szURL[] = "<URL>",
     szMAXERR[] = N_("<fraction>"), szMINGAMES[] = N_("<minimum games to rollout>"), szFOLDER[] = N_("<folder>"),
+    szFOLDEROFF[] = N_("<folder>|off"),
 #if defined(USE_GTK)
     szWARN[] = N_("[<warning>]"), szWARNYN[] = N_("<warning> on|off"),
 #endif
@@ -596,6 +634,12 @@ static char const *aszBuildInfo[] = {
 #if defined(USE_SQLITE)
     N_("SQLite database supported."),
 #endif
+#if defined(USE_LIBPQ)
+    N_("PostgreSQL database supported."),
+#endif
+#if defined(USE_MYSQL)
+    N_("MySQL database supported."),
+#endif
 #if defined(USE_GTK)
 #if GTK_CHECK_VERSION(3,0,0)
     N_("GTK3 graphical interface supported."),
@@ -634,6 +678,12 @@ static char const *aszBuildInfo[] = {
 #else
     N_("NEON supported."),
 #endif
+#if defined(USE_SIMD_DISPATCH)
+    N_("AVX2/FMA and AVX-512 neural net kernels selected at runtime."),
+#endif
+#if defined(USE_SVE_DISPATCH)
+    N_("SVE neural net kernels selected at runtime."),
+#endif
 #endif
     NULL
 };
@@ -2322,6 +2372,107 @@ hint_take(int show, int did_take)
             (pmr->CubeDecPtr->aarOutput, pmr->CubeDecPtr->aarStdDev, &pmr->CubeDecPtr->esDouble, &ci, 1));
 }
 
+/* Progressive hints (set progressivehint, or a procrecorddata with a
+ * pfProcessStage): the moves of each move filter stage of the search are
+ * shown as soon as the stage is done, and replaced by those of the
+ * deeper stages.  The stages are found on the thread searching, and
+ * shown on the main one. */
+
+typedef struct {
+    movelist ml;                /* copy of the moves of the stage */
+    unsigned int nPlies;
+    unsigned int nSearch;
+} hintstage;
+
+static struct {
+    unsigned int nSearch;       /* of the hint searching, 0 if none */
+    unsigned int cSearches;
+    moverecord *pmr;
+    int hist;
+    cubeinfo ci;
+    procrecorddata *ppr;        /* NULL for the GUI or the terminal */
+    move *amShown;              /* moves of the stage in pmr->ml */
+} hsHint;
+
+static void
+HintStageShow(hintstage * phs)
+{
+    char szBuf[1024];
+
+    if (phs->nSearch != hsHint.nSearch || !phs->ml.cMoves) {
+        /* the search is over */
+        g_free(phs->ml.amMoves);
+        g_free(phs);
+        return;
+    }
+
+    if (hsHint.ppr) {
+        hsHint.ppr->avOutputData[PROCREC_HINT_ARGOUT_MATCHSTATE] = (void *) &ms;
+        hsHint.ppr->avOutputData[PROCREC_HINT_ARGOUT_CUBEINFO] = (void *) &hsHint.ci;
+        hsHint.ppr->avOutputData[PROCREC_HINT_ARGOUT_MOVELIST] = (void *) &phs->ml;
+        hsHint.ppr->avOutputData[PROCREC_HINT_ARGOUT_PLIES] = (void *) (ptrdiff_t) phs->nPlies;
+        hsHint.ppr->pfProcessStage(hsHint.ppr);
+        g_free(phs->ml.amMoves);
+#if defined(USE_GTK)
+    } else if (fX) {
+        /* the hint window shows pmr->ml, so the moves are kept until
+         * those of the next stage replace them */
+        hsHint.pmr->ml = phs->ml;
+        hsHint.pmr->n.iMove = UINT_MAX;
+        GTKHint(hsHint.pmr, hsHint.hist);
+        g_free(hsHint.amShown);
+        hsHint.amShown = phs->ml.amMoves;
+#endif
+    } else {
+        outputf(_("Best move after %u-ply:\n"), phs->nPlies);
+        outputl(FormatMoveHint(szBuf, &ms, &phs->ml, 0, TRUE, FALSE, FALSE));
+        outputx();
+        g_free(phs->ml.amMoves);
+    }
+
+    g_free(phs);
+}
+
+#if defined(USE_MULTITHREAD)
+static gboolean
+HintStageIdle(gpointer p)
+{
+    HintStageShow((hintstage *) p);
+
+    return FALSE;
+}
+#endif
+
+static void
+HintStage(const movelist * pml, unsigned int nPlies, void *p)
+{
+    hintstage *phs = g_new(hintstage, 1);
+
+    phs->ml = *pml;
+#if GLIB_CHECK_VERSION (2,67,4)
+    phs->ml.amMoves = (move *) g_memdup2(pml->amMoves, pml->cMoves * sizeof(move));
+#else
+    phs->ml.amMoves = (move *) g_memdup(pml->amMoves, pml->cMoves * sizeof(move));
+#endif
+    phs->nPlies = nPlies;
+    phs->nSearch = (unsigned int) (ptrdiff_t) p;
+
+#if defined(USE_MULTITHREAD)
+    g_idle_add(HintStageIdle, phs);
+#else
+    HintStageShow(phs);
+#endif
+}
+
+static void
+asyncFindMoveStaged(findData * pfd)
+{
+    if (FindnSaveBestMovesStaged(pfd->pml, ms.anDice[0], ms.anDice[1], pfd->pboard,
+                                 pfd->keyMove, pfd->rThr, pfd->pci, pfd->pec, pfd->aamf,
+                                 HintStage, (void *) (ptrdiff_t) hsHint.nSearch) < 0)
+        MT_SetResultFailed();
+}
+
 extern void
 hint_move(char *sz, gboolean show, procrecorddata * procdatarec)
 {
@@ -2335,6 +2486,8 @@ hint_move(char *sz, gboolean show, procrecorddata * procdatarec)
     movelist ml;
     findData fd;
     int fSaveShowProg = fShowProgress;
+    int fProgressive = FALSE;
+    int nRet;
 
     if (!ms.anDice[0])
         return;
@@ -2357,11 +2510,30 @@ hint_move(char *sz, gboolean show, procrecorddata * procdatarec)
             show = FALSE;
             fShowProgress = (procdatarec->avInputData[PROCREC_HINT_ARGIN_SHOWPROGRESS] != NULL);
         }
-        if ((RunAsyncProcess((AsyncFun) asyncFindMove, &fd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
-            fShowProgress = fSaveShowProg;
-            return;
+        if (procdatarec ? procdatarec->pfProcessStage != NULL : fProgressiveHint && show) {
+            g_free(hsHint.amShown);
+            hsHint.amShown = NULL;
+            if (++hsHint.cSearches == 0)
+                hsHint.cSearches = 1;
+            hsHint.nSearch = hsHint.cSearches;
+            hsHint.pmr = pmr;
+            hsHint.hist = hist;
+            hsHint.ci = ci;
+            hsHint.ppr = procdatarec;
+            fProgressive = TRUE;
         }
+        nRet = RunAsyncProcess((AsyncFun) (fProgressive ? asyncFindMoveStaged : asyncFindMove), &fd,
+                               _("Considering move..."));
         fShowProgress = fSaveShowProg;
+        if (fProgressive) {
+            /* stages still queued are dropped; if interrupted, the moves
+             * shown are left to pmr */
+            hsHint.nSearch = 0;
+            if (nRet != 0 || MT_SafeGet(&fInterrupt))
+                hsHint.amShown = NULL;
+        }
+        if (nRet != 0 || MT_SafeGet(&fInterrupt))
+            return;
 
         pmr_movelist_set(pmr, GetEvalChequer(), &ml);
     }
@@ -2405,6 +2577,9 @@ hint_move(char *sz, gboolean show, procrecorddata * procdatarec)
             ChangeGame(NULL);
         if (show)
             GTKHint(pmr, hist);
+        /* the hint window no longer shows the moves of a stage */
+        g_free(hsHint.amShown);
+        hsHint.amShown = NULL;
         return;
     } else
 #endif
@@ -2505,6 +2680,9 @@ Shutdown(void)
     MoveListDestroy();
 #endif
 
+#if defined(USE_MULTITHREAD)
+    StopSpeculation();
+#endif
     MT_Close();
 
     EvalShutdown();
@@ -2623,13 +2801,20 @@ CommandRollout(char *sz)
 {
     float arOutput[NUM_ROLLOUT_OUTPUTS];
     float arStdDev[NUM_ROLLOUT_OUTPUTS];
-    rolloutstat arsStatistics[2];
     TanBoard anBoard;
     cubeinfo ci;
     char asz[1][FORMATEDMOVESIZE];
     void *p;
 
     if (CountTokens(sz) > 0) {
+        char *szResume = sz;
+        char *pch = NextToken(&szResume);
+
+        if (pch && !StrNCaseCmp(pch, "resume", strlen(pch))) {
+            CommandRolloutResume(szResume);
+            return;
+        }
+
         outputerrf("%s", _("The rollout command takes no arguments and only rollouts the current position"));
         return;
     }
@@ -2646,9 +2831,78 @@ CommandRollout(char *sz)
     SetCubeInfo(&ci, ms.nCube, ms.fCubeOwner, ms.fMove, ms.nMatchTo, ms.anScore, ms.fCrawford, ms.fJacoby, nBeavers,
                 ms.bgv);
     RolloutProgressStart(&ci, 1, NULL, &rcRollout, asz, FALSE, &p);
-    GeneralEvaluationR(arOutput, arStdDev, arsStatistics, (ConstTanBoard) anBoard, &ci, &rcRollout, RolloutProgress, p);
+    GeneralEvaluationR(arOutput, arStdDev, NULL, (ConstTanBoard) anBoard, &ci, &rcRollout, RolloutProgress, p);
+    RolloutProgressEnd(&p, FALSE);
+
+}
+
+extern void
+CommandRolloutExtract(char *sz)
+{
+    char *szLog = NextToken(&sz);
+    char *pch;
+    int iTrial = -1, iAlt = -1;
+    int n;
+
+    if (!szLog || !*szLog) {
+        outputl(_("You must specify the rollout log to extract games from (see `help rollout extract')."));
+        return;
+    }
+
+    if (sz && *sz && (iTrial = ParseNumber(&sz)) < 0) {
+        outputl(_("You must specify the number of a trial (see `help rollout extract')."));
+        return;
+    }
+
+    if ((pch = NextToken(&sz)) != NULL) {
+        if (pch[0] < 'a' || pch[0] > 'z' || pch[1]) {
+            outputl(_("You must specify the move as the letter of its .sgf files (see `help rollout extract')."));
+            return;
+        }
+        iAlt = pch[0] - 'a';
+    }
+
+    if ((n = RolloutLogExtract(szLog, iTrial, iAlt)) < 0)
+        outputerrf(_("Couldn't extract the games of the rollout log %s"), szLog);
+    else
+        outputf(ngettext("%d game written.\n", "%d games written.\n", n), n);
+}
+
+extern void
+CommandRolloutResume(char *sz)
+{
+    rolloutcheckpoint rcp;
+    char (*asz)[FORMATEDMOVESIZE];
+    void *p;
+    int i;
+
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify the rollout checkpoint to resume (see `help rollout resume')."));
+        return;
+    }
+
+    if (RolloutCheckpointLoad(sz, &rcp)) {
+        outputerrf(_("%s is not a rollout checkpoint of this version of GNU Backgammon"), sz);
+        return;
+    }
+
+    /* the checkpoint doesn't know what the alternatives were called */
+    asz = g_malloc(rcp.cAlternatives * sizeof(*asz));
+    for (i = 0; i < rcp.cAlternatives; i++)
+        if (rcp.cAlternatives == 1)
+            g_strlcpy(asz[i], _("Position"), sizeof(asz[i]));
+        else
+            g_snprintf(asz[i], sizeof(asz[i]), _("Alternative %d"), i + 1);
+
+    RolloutProgressStart(&rcp.aci[0], rcp.cAlternatives, rcp.fStatistics && rcp.fCubeRollout ? rcp.aarsStatistics : NULL,
+                         &rcp.rc, asz, rcp.cAlternatives > 1, &p);
+    RolloutCheckpointResume(&rcp, sz, RolloutProgress, p);
     RolloutProgressEnd(&p, FALSE);
 
+    g_free(asz);
+    RolloutCheckpointFree(&rcp);
 }
 
 static void
@@ -2753,6 +3007,35 @@ CommandLoadCommands(char *sz)
 #endif
 }
 
+/* Load a weight set for "set evaluation weights", see EvalLoadWeights() */
+extern void
+CommandLoadWeights(char *sz)
+{
+    char *szName = NextToken(&sz);
+    char *szFile = NextToken(&sz);
+    int i;
+
+    if (!szName || !szFile || !*szFile) {
+        outputl(_("You must specify a name for the weights and a file to load them from "
+                  "(see `help load weights')."));
+        return;
+    }
+
+    /* the threads may still be evaluating with the set replaced or
+     * writing to the cache; the speculation stops at once, anything
+     * else has to finish first */
+#if defined(USE_MULTITHREAD)
+    StopSpeculation();
+#endif
+    if (!MT_WaitIdle(1000)) {
+        outputl(_("Weights can't be loaded while positions are being evaluated."));
+        return;
+    }
+
+    if ((i = EvalLoadWeights(szName, szFile)) > 0)
+        outputf(_("Weights `%s' loaded as set %d.\n"), szName, i);
+}
+
 
 extern void
 CommandCopy(char *UNUSED(sz))
@@ -2885,8 +3168,15 @@ SaveRNGSettings(FILE * pf, const char *sz, rng rngCurrent, rngcontext * rngctx)
     case RNG_MERSENNE:
         fprintf(pf, "%s rng mersenne\n", sz);
         break;
+    case RNG_PHILOX:
+        fprintf(pf, "%s rng philox\n", sz);
+        break;
     case RNG_RANDOM_DOT_ORG:
+#if defined(LIBCURL_PROTOCOL_HTTPS)
+        fprintf(pf, "%s rng random.org lowwater %u\n", sz, GetRandomDotOrgLowWater());
+#else
         fprintf(pf, "%s rng random.org\n", sz);
+#endif
         break;
     case RNG_FILE:
         fprintf(pf, "%s rng file \"%s\"\n", sz, GetDiceFileName(rngctx));
@@ -2950,7 +3240,9 @@ SaveRolloutSettings(FILE * pf, const char *sz, rolloutcontext * prc)
     fprintf(pf,
             "%s cubeful %s\n"
             "%s varredn %s\n"
+            "%s quickvarredn %s\n"
             "%s quasirandom %s\n"
+            "%s sobol %s\n"
             "%s initial %s\n"
             "%s truncation enable %s\n"
             "%s truncation plies %u\n"
@@ -2965,12 +3257,16 @@ SaveRolloutSettings(FILE * pf, const char *sz, rolloutcontext * prc)
             "%s limit enable %s\n"
             "%s limit minimumgames %u\n"
             "%s limit maxerror %s\n"
+            "%s limit time %u\n"
             "%s jsd stop %s\n"
             "%s jsd minimumgames %u\n"
-            "%s jsd limit %s\n",
+            "%s jsd limit %s\n"
+            "%s jsd adaptive %s\n",
             sz, prc->fCubeful ? "on" : "off",
             sz, prc->fVarRedn ? "on" : "off",
+            sz, prc->fQuickVarRedn ? "on" : "off",
             sz, prc->fRotate ? "on" : "off",
+            sz, prc->fSobol ? "on" : "off",
             sz, prc->fInitial ? "on" : "off",
             sz, prc->fDoTruncate ? "on" : "off",
             sz, prc->nTruncate,
@@ -2984,7 +3280,8 @@ SaveRolloutSettings(FILE * pf, const char *sz, rolloutcontext * prc)
             sz, fTruncEqualPlayer0 ? "on" : "off",
             sz, prc->fStopOnSTD ? "on" : "off",
             sz, prc->nMinimumGames,
-            sz, szTemp1, sz, prc->fStopOnJsd ? "on" : "off", sz, prc->nMinimumJsdGames, sz, szTemp2);
+            sz, szTemp1, sz, prc->nMaxSeconds, sz, prc->fStopOnJsd ? "on" : "off", sz, prc->nMinimumJsdGames, sz, szTemp2,
+            sz, prc->fAdaptiveJsd ? "on" : "off");
 
     SaveRNGSettings(pf, sz, prc->rngRollout, rngctxRollout);
 
@@ -3078,6 +3375,7 @@ SaveAnalysisSettings(FILE * pf)
     fprintf(pf, "set analysis threshold verylucky %s\n", aszThr[5]);
     fprintf(pf, "set analysis threshold veryunlucky %s\n", aszThr[6]);
     fprintf(pf, "set analysis cube %s\n", fAnalyseCube ? "on" : "off");
+    fprintf(pf, "set analysis cubescreen %s\n", fAnalyseCubeScreen ? "on" : "off");
     fprintf(pf, "set analysis luck %s\n", fAnalyseDice ? "on" : "off");
     fprintf(pf, "set analysis moves %s\n", fAnalyseMove ? "on" : "off");
     fprintf(pf, "set analysis player 0 analyse %s\n", afAnalysePlayers[0] ? "yes" : "no");
@@ -3085,6 +3383,11 @@ SaveAnalysisSettings(FILE * pf)
     fprintf(pf, "set automatic db %s\n", fAutoDB ? "on" : "off");
     fprintf(pf, "set analysis background %s\n", fBackgroundAnalysis ? "on" : "off");
     fprintf(pf, "set analysis filesetting %s\n", aszAnalyzeFileSettingCommands[AnalyzeFileSettingDef]);
+    fprintf(pf, "set analysis candidates %u\n", nAnalysisMoves);
+    if (szAnalysisSummary)
+        fprintf(pf, "set analysis summary \"%s\"\n", szAnalysisSummary);
+    if (szAnalysisJournal)
+        fprintf(pf, "set analysis journal \"%s\"\n", szAnalysisJournal);
 }
 
 static void
@@ -3141,6 +3444,10 @@ SaveImportExportSettings(FILE * pf)
     fprintf(pf, "set export html type \"%s\"\n", aszHTMLExportType[exsExport.het]);
     fprintf(pf, "set export html css %s\n", aszHTMLExportCSSCommand[exsExport.hecss]);
     fprintf(pf, "set export png size %d\n", exsExport.nPNGSize);
+    if (exsExport.szPNGCache)
+        fprintf(pf, "set export png cache \"%s\"\n", exsExport.szPNGCache);
+    else
+        fputs("set export png cache off\n", pf);
     fprintf(pf, "set export html size %d\n", exsExport.nHtmlSize);
 
 }
@@ -3286,15 +3593,38 @@ SaveRuleSettings(FILE * pf)
 static void
 SaveEvaluationSettings(FILE * pf)
 {
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
     fprintf(pf, "set eval sameasanalysis %s\n", fEvalSameAsAnalysis ? "on" : "off");
     SaveEvalSetupSettings(pf, "set evaluation chequerplay", &esEvalChequer);
     SaveEvalSetupSettings(pf, "set evaluation cubedecision", &esEvalCube);
     SaveMoveFilterSettings(pf, "set evaluation movefilter", aamfEval);
+    fprintf(pf, "set evaluation adaptivefilter %s\n", EvalGetAdaptiveFilter() ? "on" : "off");
+    fprintf(pf, "set evaluation filterbudget %s\n",
+            g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%0.3f", EvalGetFilterBudget()));
+    fprintf(pf, "set evaluation earlyexit %s\n",
+            g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%0.3f", EvalGetEarlyExit()));
+    fprintf(pf, "set evaluation openingbook %s\n", EvalGetOpeningBook() ? "on" : "off");
+    fprintf(pf, "set evaluation raceapprox %s\n", EvalGetRaceApprox() ? "on" : "off");
+    fprintf(pf, "set evaluation sigmoid %s\n", EvalGetFastSigmoid() ? "fast" : "table");
+    fprintf(pf, "set cachehugepages %s\n", EvalGetCacheHugePages() ? "on" : "off");
     fprintf(pf, "set cache %u\n", GetEvalCacheEntries());
+    if (EvalGetCacheFile())
+        fprintf(pf, "set cachefile \"%s\"\n", EvalGetCacheFile());
+    if (EvalGetCacheShared())
+        fprintf(pf, "set cacheshared \"%s\"\n", EvalGetCacheShared());
+    fprintf(pf, "set cachestats %s\n", EvalGetCacheStats() ? "on" : "off");
     fprintf(pf, "set matchequitytable \"%s\"\n", miCurrent.szFileName);
     fprintf(pf, "set invert matchequitytable %s\n", fInvertMET ? "on" : "off");
 #if defined(USE_MULTITHREAD)
-    fprintf(pf, "set threads %u\n", MT_GetNumThreads());
+    if (MT_GetAutoThreads())
+        fprintf(pf, "set threads auto\n");
+    else
+        fprintf(pf, "set threads %u\n", MT_GetNumThreads());
+    fprintf(pf, "set threads numa %s\n", MT_GetNuma() ? "on" : "off");
+    fprintf(pf, "set threads affinity %s\n", aszAffinity[MT_GetAffinity()]);
+    fprintf(pf, "set threads share %s\n", MT_GetShare() ? "on" : "off");
+    fprintf(pf, "set threads speculate %s\n", fSpeculate ? "on" : "off");
 #endif
 }
 
@@ -3337,6 +3667,7 @@ SaveMiscSettings(FILE * pf)
         fprintf(pf, "ask\n");
 
     fprintf(pf, "set gotofirstgame %s\n", fGotoFirstGame ? "on" : "off");
+    fprintf(pf, "set progressivehint %s\n", fProgressiveHint ? "on" : "off");
     fprintf(pf, "set output matchpc %s\n", fOutputMatchPC ? "on" : "off");
     fprintf(pf, "set output mwc %s\n", fOutputMWC ? "on" : "off");
     fprintf(pf, "set output rawboard %s\n", fOutputRawboard ? "on" : "off");
@@ -3428,6 +3759,12 @@ CommandSaveSettings(char *szParam)
     SavePlayerSettings(pf);
     SaveRNGSettings(pf, "set", rngCurrent, rngctxCurrent);
     SaveRolloutSettings(pf, "set rollout", &rcRollout);
+    if (szRolloutWorkers)
+        fprintf(pf, "set rollout workers %s\n", szRolloutWorkers);
+    if (szRolloutCheckpoint)
+        fprintf(pf, "set rollout checkpoint \"%s\"\n", szRolloutCheckpoint);
+    if (cRolloutLockstep > 1)
+        fprintf(pf, "set rollout lockstep %u\n", cRolloutLockstep);
     SaveImportExportSettings(pf);
     SaveSoundSettings(pf);
     RelationalSaveSettings(pf);
@@ -4602,14 +4939,21 @@ main(int argc, char *argv[])
 #endif
     char *pchMatch = NULL;
     char *met = NULL;
+    guint64 t;
 
     static char *pchCommands = NULL, *lang = NULL;
+    static int fFastStartup = FALSE;
     static int fNoBearoff = FALSE, fNoX = FALSE, fSplash = FALSE, fNoTTY = FALSE, show_version = FALSE, debug = FALSE;
     GOptionEntry ao[] = {
         {"no-bearoff", 'b', 0, G_OPTION_ARG_NONE, &fNoBearoff,
          N_("Do not use bearoff database"), NULL},
+        {"shared-bearoff", 0, 0, G_OPTION_ARG_FILENAME, &szBearoffShared,
+         N_("Keep the heuristic bearoff database in FILE and read all bearoff databases in whole, "
+            "for several gnubg processes to share"), "FILE"},
         {"commands", 'c', 0, G_OPTION_ARG_FILENAME, &pchCommands,
          N_("Evaluate commands in FILE and exit"), "FILE"},
+        {"fast-startup", 0, 0, G_OPTION_ARG_NONE, &fFastStartup,
+         N_("Load the race and hypergammon databases and Python when first needed"), NULL},
         {"lang", 'l', 0, G_OPTION_ARG_STRING, &lang,
          N_("Set language to LANG"), "LANG"},
         {"python", 'p', G_OPTION_FLAG_OPTIONAL_ARG, G_OPTION_ARG_CALLBACK, callback_parse_python_option,
@@ -4717,15 +5061,20 @@ main(int argc, char *argv[])
 
     init_autosave();
 
+    /* Each step is timed for "show startup" */
+    t = get_time_ns();
     RenderInitialise();
+    ProfileStartup(N_("Rendering"), get_time_ns() - t, FALSE);
 
 #ifdef WIN32
     fNoTTY = TRUE;
 #endif
 #if defined(USE_GTK)
     /* -t option not given */
+    t = get_time_ns();
     if (!fNoX)
         InitGTK(&argc, &argv);
+    ProfileStartup(N_("User interface"), get_time_ns() - t, FALSE);
     if (fX) {
         fTTY = !fNoTTY && isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
         fInteractive = fShowProgress = TRUE;
@@ -4744,19 +5093,31 @@ main(int argc, char *argv[])
     }
 
     PushSplash(pwSplash, _("Initialising"), _("Random number generator"));
+    t = get_time_ns();
     init_rng();
+    ProfileStartup(N_("Random number generators"), get_time_ns() - t, FALSE);
 
     PushSplash(pwSplash, _("Initialising"), _("match equity table"));
+    t = get_time_ns();
+    met = g_build_filename(szHomeDirectory, "metcache", NULL);
+    METSetCacheDirectory(met);
+    g_free(met);
     met = BuildFilename2("met", "Kazaross-XG2.xml");
     InitMatchEquity(met);
     g_free(met);
+    ProfileStartup(N_("Match equity table"), get_time_ns() - t, FALSE);
 
     PushSplash(pwSplash, _("Initialising"), _("neural nets"));
+    t = get_time_ns();
+    fLazyBearoff = fFastStartup;
     init_nets(fNoBearoff);
+    ProfileStartup(N_("Neural nets and bearoff databases"), get_time_ns() - t, FALSE);
 
     PushSplash(pwSplash, _("Initialising"), _("initialising thread data"));
+    t = get_time_ns();
     glib_ext_init();
     MT_InitThreads();
+    ProfileStartup(N_("Threads"), get_time_ns() - t, FALSE);
 
 #if defined(WIN32) && defined(HAVE_SOCKETS)
     PushSplash(pwSplash, _("Initialising"), _("Windows sockets"));
@@ -4765,7 +5126,10 @@ main(int argc, char *argv[])
 
 #if defined(USE_PYTHON)
     PushSplash(pwSplash, _("Initialising"), "Python");
-    PythonInitialise(argv[0]);
+    t = get_time_ns();
+    PythonInitialise(argv[0], fFastStartup);
+    if (!fFastStartup)
+        ProfileStartup(N_("Python"), get_time_ns() - t, FALSE);
 #endif
 
     SetExitSoundOff();
@@ -4773,7 +5137,9 @@ main(int argc, char *argv[])
     /* -r option given */
     if (!fNoRC) {
         PushSplash(pwSplash, _("Loading"), _("User Settings"));
+        t = get_time_ns();
         LoadRCFiles();
+        ProfileStartup(N_("User settings"), get_time_ns() - t, FALSE);
     }
 
     strcpy(ap[0].szName, default_names[0]);
@@ -5421,7 +5787,7 @@ EPC(const TanBoard anBoard, float *arEPC, float *arMu, float *arSigma, int *pfSo
         float ar[5];
         int i;
 
-        raceProbs(anBoard, nTrials, ar, arMux);
+        raceProbs(anBoard, nTrials, MT_GetNumThreads(), ar, arMux);
 
         for (i = 0; i < 2; ++i) {
             if (arEPC)
@@ -5528,7 +5894,7 @@ asyncEvalRoll(decisionData * pdd)
 void
 asyncAnalyzeMove(moveData * pmd)
 {
-    if (AnalyzeMove(pmd->pmr, pmd->pms, plGame, NULL, pmd->pesChequer, pmd->pesCube, pmd->aamf, NULL, NULL) < 0)
+    if (AnalyzeMove(pmd->pmr, pmd->pms, plGame, NULL, pmd->pac, NULL) < 0)
         MT_SetResultFailed();
 }
 
@@ -5571,6 +5937,8 @@ RunAsyncProcess(AsyncFun fun, void *data, const char *msg)
     pt->pLinkedTask = NULL;
     pt->fun = fun;
     pt->data = data;
+    pt->priority = TASK_INTERACTIVE;
+    pt->pct = MT_GetTLD()->pct;
     MT_AddTask(pt, TRUE);
 #endif
 
@@ -5615,50 +5983,120 @@ CheckGameExists(void)
     }
 }
 
-extern gboolean
-save_autosave(gpointer UNUSED(unused))
+/* Autosaves are written to a temporary file in the backup directory
+ * and renamed over the last one, so that a crash while writing never
+ * leaves a truncated file behind.  With the thread pool they are
+ * written by a thread of their own: the match is only locked with
+ * MT_LOCK_MATCH while it goes into the stdio buffer, and the main
+ * thread doesn't wait at all.  The autosave name is only changed by
+ * the main thread, once the writer has been joined. */
+
+#define AUTOSAVE_BUFFER (1 << 20)
+
+#if defined(USE_MULTITHREAD)
+static GThread *pthAutosave = NULL;
+#endif
+
+static gpointer
+WriteAutosave(gpointer p)
 {
+    char *szFile = (char *) p;
+    char *szTemp;
     int fd;
     FILE *pf;
     listOLD *pl;
+    int fOK;
 
-    g_return_val_if_fail(plGame, FALSE);
-
-    MT_Exclusive();
-    if (autosave)
-        g_unlink(autosave);
-
-    autosave = g_build_filename(szHomeDirectory, "backup", "XXXXXX.sgf", NULL);
-
-    fd = g_mkstemp(autosave);
+    szTemp = g_build_filename(szHomeDirectory, "backup", "XXXXXX.tmp", NULL);
+    fd = g_mkstemp(szTemp);
     if (fd < 0) {
-        g_free(autosave);
-        autosave = NULL;
-        MT_Release();
-        return FALSE;
+        g_free(szTemp);
+        g_free(szFile);
+        return NULL;
     }
-
     close(fd);
-    g_unlink(autosave);
 
-    pf = g_fopen(autosave, "w");
+    pf = g_fopen(szTemp, "w");
     if (!pf) {
-        autosave = NULL;
-        MT_Release();
-        return FALSE;
+        g_unlink(szTemp);
+        g_free(szTemp);
+        g_free(szFile);
+        return NULL;
     }
+    setvbuf(pf, NULL, _IOFBF, AUTOSAVE_BUFFER);
 
+    MT_Lock(MT_LOCK_MATCH);
     for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
         SaveGame(pf, pl->p);
+    MT_Unlock(MT_LOCK_MATCH);
+
+    fOK = !ferror(pf);
+    fOK = !fclose(pf) && fOK;
+
+#if defined(WIN32)
+    /* rename() doesn't replace an existing file here */
+    if (fOK)
+        g_unlink(szFile);
+#endif
+    if (!fOK || g_rename(szTemp, szFile))
+        g_unlink(szTemp);
+
+    g_free(szTemp);
+    g_free(szFile);
+    return NULL;
+}
+
+/* Wait for an autosave being written, if there is one */
+extern void
+FinishAutosave(void)
+{
+#if defined(USE_MULTITHREAD)
+    if (pthAutosave) {
+        g_thread_join(pthAutosave);
+        pthAutosave = NULL;
+    }
+#endif
+}
+
+extern gboolean
+save_autosave(gpointer UNUSED(unused))
+{
+    int fd;
+
+    g_return_val_if_fail(plGame, FALSE);
+
+#if defined(USE_MULTITHREAD)
+    /* The last one is still being written; catch up at the next */
+    if (pthAutosave)
+        return TRUE;
+#endif
+
+    if (!autosave) {
+        autosave = g_build_filename(szHomeDirectory, "backup", "XXXXXX.sgf", NULL);
+
+        fd = g_mkstemp(autosave);
+        if (fd < 0) {
+            g_free(autosave);
+            autosave = NULL;
+            return FALSE;
+        }
+        close(fd);
+    }
+#if defined(USE_MULTITHREAD)
+    pthAutosave = g_thread_try_new("autosave", WriteAutosave, g_strdup(autosave), NULL);
+    if (pthAutosave)
+        return TRUE;
+#endif
+    /* Without the thread pool the main thread plays the tasks itself */
+    WriteAutosave(g_strdup(autosave));
 
-    fclose(pf);
-    MT_Release();
     return TRUE;
 }
 
 extern void
 delete_autosave(void)
 {
+    FinishAutosave();
     if (autosave) {
         g_unlink(autosave);
         g_free(autosave);
@@ -5675,9 +6113,7 @@ get_input_discard(void)
     if (autosave && fAutoSaveConfirmDelete) {
         if (!GetInputYN(_("Are you sure you want to discard the current match and your existing autosave? ")))
             return FALSE;
-        g_unlink(autosave);
-        g_free(autosave);
-        autosave = NULL;
+        delete_autosave();
         return TRUE;
     }
     if (ms.gs == GAME_PLAYING && fConfirmNew)
@@ -47,6 +47,10 @@ CREATE UNIQUE INDEX iplayer ON player (
     player_id
 );
 
+CREATE INDEX iplayername ON player (
+    name
+);
+
 -- Table: session
 
 CREATE TABLE session (
@@ -86,6 +90,18 @@ CREATE UNIQUE INDEX isession ON session (
     session_id
 );
 
+CREATE INDEX isessionchecksum ON session (
+    checksum
+);
+
+CREATE INDEX isessionplayer0 ON session (
+    player_id0
+);
+
+CREATE INDEX isessionplayer1 ON session (
+    player_id1
+);
+
 -- Table: statistics
 -- Used from session and game tables to store match and game statistics,
 -- respectively.
@@ -185,6 +201,14 @@ CREATE UNIQUE INDEX ismatchstat ON matchstat (
     matchstat_id
 );
 
+CREATE INDEX imatchstatsession ON matchstat (
+    session_id
+);
+
+CREATE INDEX imatchstatplayer ON matchstat (
+    player_id
+);
+
 
 -- Table: game
 
@@ -222,6 +246,10 @@ CREATE UNIQUE INDEX igame ON game (
     game_id
 );
 
+CREATE INDEX igamesession ON game (
+    session_id
+);
+
 -- Table: statistics
 -- Used from match and game tables to store match and game statistics,
 -- respectively.
@@ -320,3 +348,95 @@ CREATE TABLE gamestat (
 CREATE UNIQUE INDEX isgamestat ON gamestat (
     gamestat_id
 );
+
+CREATE INDEX isgamestatgame ON gamestat (
+    game_id
+);
+
+CREATE INDEX isgamestatplayer ON gamestat (
+    player_id
+);
+
+-- Table: playerstat
+-- The sums of the matchstat rows of a player in the sessions against
+-- one opponent, kept up to date as matches are added and erased, so
+-- that the player statistics don't add up matchstat every time.
+-- Databases of version 1 get it, and the indexes above, the first
+-- time they are opened, see UpgradeDatabase() in relational.c.
+
+CREATE TABLE playerstat (
+    player_id                         INTEGER NOT NULL
+   ,opponent_id                       INTEGER NOT NULL
+   ,total_moves                       INTEGER DEFAULT 0 NOT NULL
+   ,unforced_moves                    INTEGER DEFAULT 0 NOT NULL
+   ,total_cube_decisions              INTEGER DEFAULT 0 NOT NULL
+   ,close_cube_decisions              INTEGER DEFAULT 0 NOT NULL
+   ,doubles                           INTEGER DEFAULT 0 NOT NULL
+   ,takes                             INTEGER DEFAULT 0 NOT NULL
+   ,passes                            INTEGER DEFAULT 0 NOT NULL
+   ,very_bad_moves                    INTEGER DEFAULT 0 NOT NULL
+   ,bad_moves                         INTEGER DEFAULT 0 NOT NULL
+   ,doubtful_moves                    INTEGER DEFAULT 0 NOT NULL
+   ,unmarked_moves                    INTEGER DEFAULT 0 NOT NULL
+   ,very_unlucky_rolls                INTEGER DEFAULT 0 NOT NULL
+   ,unlucky_rolls                     INTEGER DEFAULT 0 NOT NULL
+   ,unmarked_rolls                    INTEGER DEFAULT 0 NOT NULL
+   ,lucky_rolls                       INTEGER DEFAULT 0 NOT NULL
+   ,very_lucky_rolls                  INTEGER DEFAULT 0 NOT NULL
+   ,missed_doubles_below_cp           INTEGER DEFAULT 0 NOT NULL
+   ,missed_doubles_above_cp           INTEGER DEFAULT 0 NOT NULL
+   ,wrong_doubles_below_dp            INTEGER DEFAULT 0 NOT NULL
+   ,wrong_doubles_above_tg            INTEGER DEFAULT 0 NOT NULL
+   ,wrong_takes                       INTEGER DEFAULT 0 NOT NULL
+   ,wrong_passes                      INTEGER DEFAULT 0 NOT NULL
+   ,chequer_error_total_normalised    FLOAT   DEFAULT 0 NOT NULL
+   ,error_missed_doubles_below_cp_normalised     FLOAT   DEFAULT 0 NOT NULL
+   ,error_missed_doubles_above_cp_normalised     FLOAT   DEFAULT 0 NOT NULL
+   ,error_wrong_doubles_below_dp_normalised      FLOAT   DEFAULT 0 NOT NULL
+   ,error_wrong_doubles_above_tg_normalised      FLOAT   DEFAULT 0 NOT NULL
+   ,error_wrong_takes_normalised                 FLOAT   DEFAULT 0 NOT NULL
+   ,error_wrong_passes_normalised                FLOAT   DEFAULT 0 NOT NULL
+   ,luck_total_normalised             FLOAT   DEFAULT 0 NOT NULL
+   ,snowie_moves                      INTEGER DEFAULT 0 NOT NULL
+   ,cube_error_total_normalised       FLOAT   DEFAULT 0 NOT NULL
+   ,PRIMARY KEY (player_id, opponent_id)
+);
+
+CREATE INDEX iplayerstatopponent ON playerstat (
+    opponent_id
+);
+
+-- Table: gameposition
+-- The analysed chequer plays of the matches, indexed on the position ID
+-- for "relational find position".  Only filled in with relational setup
+-- storepositions=yes.
+
+CREATE TABLE gameposition (
+    gameposition_id INTEGER NOT NULL
+   ,session_id      INTEGER NOT NULL
+   ,game_number     INTEGER NOT NULL
+   -- which move of the game this is, counting the plays of both players
+   ,move_number     INTEGER NOT NULL
+   -- the player on roll
+   ,player_id       INTEGER NOT NULL
+   -- position ID of the position before the play, player on roll
+   ,gnubg_id        CHAR(14) NOT NULL
+   ,match_id        CHAR(12) NOT NULL
+   ,dice0           INTEGER NOT NULL
+   ,dice1           INTEGER NOT NULL
+   ,cube            INTEGER NOT NULL
+   -- -1 centred, 0 owned by the player on roll, 1 by the opponent
+   ,cube_owner      INTEGER NOT NULL
+   ,best_move       CHAR(32) NOT NULL
+   ,best_equity     FLOAT NOT NULL
+   ,played_equity   FLOAT NOT NULL
+   ,PRIMARY KEY (gameposition_id)
+   ,FOREIGN KEY (session_id) REFERENCES session (session_id)
+      ON DELETE CASCADE
+   ,FOREIGN KEY (player_id) REFERENCES player (player_id)
+      ON DELETE RESTRICT
+);
+
+CREATE INDEX igamepositionid ON gameposition (
+    gnubg_id
+);
@@ -29,10 +29,14 @@
 #include "backgammon.h"
 #include "drawboard.h"
 #include "eval.h"
+#include "export.h"
 #include "matchequity.h"
 #include "positionid.h"
 #include "matchid.h"
 #include "multithread.h"
+#include "preset.h"
+#include "profile.h"
+#include "scoregrid.h"
 #include "util.h"
 #include "lib/gnubg-types.h"
 #include "lib/simd.h"
@@ -629,6 +633,25 @@ EvalContextToPy(const evalcontext * pec)
 }
 
 
+/* The preset of preset.h named, or numbered, by the string p; NULL,
+ * with an exception raised, if there is none */
+static evalpreset *
+PyToPreset(PyObject * p)
+{
+    const char *sz = PyUnicode_AsUTF8(p);
+    evalpreset *pep;
+
+    if (!sz)
+        return NULL;
+
+    if (!(pep = PresetLookup(sz)))
+        PyErr_Format(PyExc_ValueError, _("no preset '%s' (see gnubg.presets())"), sz);
+
+    return pep;
+}
+
+/* An evalcontext from a dictionary, or the chequer one of a preset
+ * from its name */
 static int
 PyToEvalContext(PyObject * p, evalcontext * pec)
 {
@@ -640,6 +663,16 @@ PyToEvalContext(PyObject * p, evalcontext * pec)
     };
     int i;
 
+    if (PyUnicode_Check(p)) {
+        evalpreset *pep = PyToPreset(p);
+
+        if (!pep)
+            return -1;
+
+        *pec = pep->ecChequer;
+        return 0;
+    }
+
     while (PyDict_Next(p, &iPos, &pyKey, &pyValue)) {
         char *pchKey;
         int iKey;
@@ -849,17 +882,54 @@ PythonHint_Callback(procrecorddata * pr)
     return TRUE;
 }
 
+/* The moves of a stage of a progressive hint, handed to the progress
+ * callable of gnubg.hint() with the plies of the stage. */
+static int
+PythonHint_Stage(procrecorddata * pr)
+{
+    PyObject *list = PyList_New(0), *result;
+    PyObject *pvUserData = (PyObject *) pr->pvUserData;
+    const movelist *pml = pr->avOutputData[PROCREC_HINT_ARGOUT_MOVELIST];
+    unsigned int i;
+    unsigned int n = MIN(pml->cMoves, (unsigned int) (ptrdiff_t) pr->avInputData[PROCREC_HINT_ARGIN_MAXMOVES]);
+
+    pr->pvUserData = list;
+    for (i = 0; i < n; i++) {
+        pr->avOutputData[PROCREC_HINT_ARGOUT_INDEX] = (void *) (ptrdiff_t) i;
+        PythonHint_Callback(pr);
+    }
+    pr->pvUserData = pvUserData;
+
+    result = PyObject_CallFunction((PyObject *) pr->avInputData[PROCREC_HINT_ARGIN_STAGE], "iN",
+                                   (int) (ptrdiff_t) pr->avOutputData[PROCREC_HINT_ARGOUT_PLIES], list);
+    if (!result) {
+        PyErr_Print();
+        return FALSE;
+    }
+    Py_DECREF(result);
+
+    return TRUE;
+}
+
 SIMD_STACKALIGN static PyObject *
 PythonHint(PyObject * UNUSED(self), PyObject * args)
 {
     PyObject *retval = NULL, *gnubgid = NULL, *tmpobj;
+    PyObject *progress = NULL;
     procrecorddata prochint;
     char szNumber[11];
     char *szHintType = NULL;
     int nMaxMoves = -1;
 
-    if (!PyArg_ParseTuple(args, "|i", &nMaxMoves))
+    if (!PyArg_ParseTuple(args, "|iO", &nMaxMoves, &progress))
+        return NULL;
+
+    if (progress == Py_None)
+        progress = NULL;
+    else if (progress && !PyCallable_Check(progress)) {
+        PyErr_SetString(PyExc_TypeError, _("the progress argument must be callable"));
         return NULL;
+    }
 
     if (nMaxMoves < 0)
         nMaxMoves = MAX_MOVES;
@@ -888,6 +958,10 @@ PythonHint(PyObject * UNUSED(self), PyObject * args)
         prochint.pfProcessRecord = PythonHint_Callback;
         prochint.avInputData[PROCREC_HINT_ARGIN_SHOWPROGRESS] = (void *) (long) 0;
         prochint.avInputData[PROCREC_HINT_ARGIN_MAXMOVES] = (void *) (ptrdiff_t) nMaxMoves;
+        if (progress) {
+            prochint.pfProcessStage = PythonHint_Stage;
+            prochint.avInputData[PROCREC_HINT_ARGIN_STAGE] = (void *) progress;
+        }
         hint_move(szNumber, FALSE, (void *) &prochint);
         if (MT_SafeGet(&fInterrupt)) {
             ResetInterrupt();
@@ -1095,178 +1169,1307 @@ PythonBoard(PyObject * UNUSED(self), PyObject * args)
     return BoardToPy(msBoard());
 }
 
+static PyObject *
+PythonBoardImage(PyObject * UNUSED(self), PyObject * args)
+{
+    const char *szFormat = "png";
+    int nSize = exsExport.nPNGSize;
+    const char *szPosID = NULL, *szMatchID = NULL;
+    int bif;
+    matchstate msImage;
+    guchar *pb;
+    gsize cb;
+    PyObject *pyImage;
+
+    if (!PyArg_ParseTuple(args, "|siss:boardimage", &szFormat, &nSize, &szPosID, &szMatchID))
+        return NULL;
+
+    if ((bif = BoardImageFormat(szFormat)) < 0) {
+        PyErr_SetString(PyExc_ValueError, _("the format must be 'png' or 'svg'"));
+        return NULL;
+    }
+
+    if (nSize < 1 || nSize > 20) {
+        PyErr_SetString(PyExc_ValueError, _("the size must be between 1 and 20"));
+        return NULL;
+    }
+
+    memcpy(&msImage, &ms, sizeof(matchstate));
+
+    if (szPosID || szMatchID) {
+        if (!szPosID || !szMatchID || !PositionFromID(msImage.anBoard, szPosID)
+            || MatchFromID(msImage.anDice, &msImage.fTurn, &msImage.fResigned, &msImage.fDoubled,
+                           &msImage.fMove, &msImage.fCubeOwner, &msImage.fCrawford, &msImage.nMatchTo,
+                           msImage.anScore, &msImage.nCube, &msImage.fJacoby, &msImage.gs, szMatchID) < 0) {
+            PyErr_SetString(PyExc_ValueError, _("invalid position or match ID"));
+            return NULL;
+        }
+    } else if (ms.gs == GAME_NONE) {
+        /* no board available */
+        Py_INCREF(Py_None);
+        return Py_None;
+    } else
+        memcpy(msImage.anBoard, msBoard(), sizeof(TanBoard));
+
+    msImage.fCubeUse = fCubeUse;
+
+    /* The image is drawn from copies, so the other Python threads may
+     * run meanwhile */
+    Py_BEGIN_ALLOW_THREADS
+    pb = BoardImage(&msImage, (boardimageformat) bif, (unsigned int) nSize, &cb);
+    Py_END_ALLOW_THREADS
+
+    if (!pb) {
+        PyErr_SetString(PyExc_RuntimeError, _("the image could not be made"));
+        return NULL;
+    }
+
+    pyImage = PyBytes_FromStringAndSize((const char *) pb, (Py_ssize_t) cb);
+    g_free(pb);
+
+    return pyImage;
+}
+
 static PyObject *
 PythonLuckRating(PyObject * UNUSED(self), PyObject * args)
 {
 
-    float r;
-    if (!PyArg_ParseTuple(args, "f", &r))
+    float r;
+    if (!PyArg_ParseTuple(args, "f", &r))
+        return NULL;
+
+    return PyInt_FromLong(getLuckRating(r));
+
+}
+
+static PyObject *
+PythonClassifyPosition(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyBoard = NULL;
+    TanBoard anBoard;
+    bgvariation iVariant = ms.bgv;
+
+    memcpy(anBoard, msBoard(), sizeof(TanBoard));
+
+    if (!PyArg_ParseTuple(args, "|Oi", &pyBoard, &iVariant))
+        return NULL;
+
+    if (pyBoard && !PyToBoard(pyBoard, anBoard)) {
+        PyErr_SetString(PyExc_StandardError, _("Invalid board as argument "));
+        return NULL;
+    }
+
+    if (iVariant >= NUM_VARIATIONS) {
+        PyErr_SetString(PyExc_StandardError, _("Variation unknown "));
+        return NULL;
+    }
+
+    return PyInt_FromLong(ClassifyPosition((ConstTanBoard) anBoard, iVariant));
+}
+
+static PyObject *
+PythonErrorRating(PyObject * UNUSED(self), PyObject * args)
+{
+
+    float r;
+    if (!PyArg_ParseTuple(args, "f", &r))
+        return NULL;
+
+    return PyInt_FromLong(GetRating(r));
+
+}
+
+/* Convert Move tuple to a string
+ * A tuple can be expressed in two forms.
+ * form returned by findbestmove ie. (21,18,11,5)
+ * form returned by parsemove ie. ((21,18),(11,5))
+ *
+ * returns a string representing the move tuple.
+ */
+
+static PyObject *
+PythonMoveTuple2String(PyObject * UNUSED(self), PyObject * args)
+{
+
+    PyObject *pyBoard = NULL;
+    PyObject *pyMove = NULL;
+
+    char szMove[FORMATEDMOVESIZE];
+    signed int anMove[8];
+    TanBoard anBoard;
+
+    memset(anBoard, 0, sizeof(TanBoard));
+    memset(anMove, -1, sizeof(anMove));
+
+    if (!PyArg_ParseTuple(args, "|OO", &pyMove, &pyBoard))
+        return NULL;
+
+    if (!pyMove || !pyBoard) {
+        PyErr_SetString(PyExc_TypeError,
+                        _("requires 2 arguments (MoveTuple, Board). "
+                          "(see gnubg.findbestmove() and gnubg.board() for examples)"));
+        return NULL;
+    }
+
+    if (!PyToMove(pyMove, anMove)) {
+        PyErr_SetString(PyExc_StandardError, _("Invalid move tuple as argument"));
+        return NULL;
+    }
+
+    if (!PyToBoard(pyBoard, anBoard)) {
+        PyErr_SetString(PyExc_StandardError, _("Invalid board as argument "));
+        return NULL;
+    }
+
+    szMove[0] = '\0';
+    FormatMove(szMove, (ConstTanBoard) anBoard, anMove);
+
+    return PyUnicode_FromString(szMove);
+}
+
+static PyObject *
+PythonCalculateGammonPrice(PyObject * UNUSED(self), PyObject * pyCubeInfo)
+{
+    cubeinfo ci;
+    PyObject *gvObj = NULL;
+
+    if (PyToCubeInfo(pyCubeInfo, &ci) < 0)
+        return NULL;
+
+    if (SetCubeInfo(&ci, ci.nCube, ci.fCubeOwner, ci.fMove, ci.nMatchTo, ci.anScore,
+                    ci.fCrawford, ci.fJacoby, ci.fBeavers, ci.bgv)) {
+        PyErr_SetString(PyExc_StandardError, _("error in SetCubeInfo\n"));
+        return NULL;
+    }
+
+    gvObj = Py_BuildValue("(ff)(ff)", ci.arGammonPrice[0], ci.arGammonPrice[2],
+                          ci.arGammonPrice[1], ci.arGammonPrice[3]);
+    DictSetItemSteal(pyCubeInfo, "gammonprice", gvObj);
+
+    Py_INCREF(pyCubeInfo);
+    return (pyCubeInfo);
+}
+
+/* The thread gnubg and its interpreter run on */
+static GThread *pgtMain;
+
+static int
+EngineMoveDecision(void *p)
+{
+    decisionData *pdd = (decisionData *) p;
+
+    return GeneralEvaluationE(pdd->aarOutput[0], pdd->pboard, pdd->pci, pdd->pec);
+}
+
+static int
+EngineCubeDecision(void *p)
+{
+    decisionData *pdd = (decisionData *) p;
+
+    return GeneralCubeDecisionE(pdd->aarOutput, pdd->pboard, pdd->pci, pdd->pec, pdd->pes);
+}
+
+static int
+EngineFindBestMoves(void *p)
+{
+    findData *pfd = (findData *) p;
+
+    return FindnSaveBestMoves(pfd->pml, pfd->anDice[0], pfd->anDice[1], pfd->pboard,
+                              pfd->keyMove, pfd->rThr, pfd->pci, pfd->pec, pfd->aamf);
+}
+
+/* Run an engine call for Python.  On gnubg's own thread it is fun, run
+ * by RunAsyncProcess() as for the commands; on the threads of a Python
+ * program it is pfEngine, run on the calling thread without the Python
+ * lock so that they evaluate in parallel.  FALSE, with szError raised,
+ * if it failed or was interrupted. */
+static int
+PythonRunEngine(AsyncFun fun, int (*pfEngine) (void *), void *data, const char *szMessage, const char *szError)
+{
+    int fFailed;
+
+#if defined(USE_MULTITHREAD)
+    if (g_thread_self() != pgtMain) {
+        MT_AttachThread();
+
+        Py_BEGIN_ALLOW_THREADS
+        fFailed = pfEngine(data) < 0;
+        Py_END_ALLOW_THREADS
+    } else
+#else
+    (void) pfEngine;            /* the threads would share the evaluation data */
+#endif
+    {
+        int fSaveShowProg = fShowProgress;
+
+        fShowProgress = FALSE;
+        fFailed = RunAsyncProcess(fun, data, szMessage) != 0;
+        fShowProgress = fSaveShowProg;
+    }
+
+    if (fFailed || MT_SafeGet(&fInterrupt)) {
+        ResetInterrupt();
+        PyErr_SetString(PyExc_StandardError, szError);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+SIMD_STACKALIGN static PyObject *
+PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
+{
+
+    PyObject *pyBoard = NULL;
+    PyObject *pyCubeInfo = NULL;
+    PyObject *pyEvalContext = NULL;
+
+    decisionData dd;
+    TanBoard anBoard;
+    cubeinfo ci;
+    evalcontext ec;
+
+    memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
+    memcpy(anBoard, msBoard(), sizeof(TanBoard));
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    if (!PyArg_ParseTuple(args, "|OOO", &pyBoard, &pyCubeInfo, &pyEvalContext))
+        return NULL;
+
+    if (pyBoard && !PyToBoard(pyBoard, anBoard))
+        return NULL;
+
+    if (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &ci))
+        return NULL;
+
+    if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
+        return NULL;
+
+    dd.pboard = (ConstTanBoard) anBoard;
+    dd.pci = &ci;
+    dd.pec = &ec;
+
+    if (!PythonRunEngine((AsyncFun) asyncMoveDecisionE, EngineMoveDecision, &dd, _("Considering move..."),
+                         _("interrupted/errno in asyncMoveDecisionE")))
+        return NULL;
+
+    {
+        PyObject *p = PyTuple_New(6);
+        int k;
+        for (k = 0; k < 6; ++k) {
+            PyTuple_SET_ITEM(p, k, PyFloat_FromDouble(dd.aarOutput[0][k]));
+        }
+        return p;
+    }
+}
+
+/* A block of c rows of cItems items of szFormat ("f" or "I"), copied
+ * from p, as one object numpy takes without copying again: a
+ * memoryview of that shape on Python 3, a bytearray on Python 2 */
+static PyObject *
+PyFromBlock(const void *p, const char *szFormat, unsigned int c, unsigned int cItems)
+{
+    PyObject *py = PyByteArray_FromStringAndSize((const char *) p, (Py_ssize_t) c * cItems * 4);
+
+#if PY_MAJOR_VERSION >= 3
+    if (py) {
+        PyObject *pyView = PyMemoryView_FromObject(py);
+
+        Py_DECREF(py);
+        if (!pyView)
+            return NULL;
+
+        py = PyObject_CallMethod(pyView, "cast", "s(II)", szFormat, c, cItems);
+        Py_DECREF(pyView);
+    }
+#else
+    (void) szFormat;
+#endif
+
+    return py;
+}
+
+/* Positions are evaluated by gnubg.evaluate_many() in tasks of this
+ * many, spread over the threads */
+#define EVALUATE_MANY_CHUNK 32
+
+typedef struct {
+    const TanBoard *aanBoard;
+    float (*aarOutput)[6];
+    unsigned int c;
+    const cubeinfo *pci;
+    const evalcontext *pec;
+    int *pfFailed;
+} evaluatemanytask;
+
+SIMD_STACKALIGN static void
+EvaluateManyTask(void *p)
+{
+    evaluatemanytask *pemt = (evaluatemanytask *) p;
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    unsigned int i;
+
+    for (i = 0; i < pemt->c; i++) {
+        if (MT_SafeGet(pemt->pfFailed) || MT_SafeGet(&fInterrupt))
+            return;
+
+        if (GeneralEvaluationE(arOutput, (ConstTanBoard) pemt->aanBoard[i], pemt->pci, pemt->pec) < 0) {
+            MT_SafeSet(pemt->pfFailed, TRUE);
+            return;
+        }
+
+        memcpy(pemt->aarOutput[i], arOutput, sizeof(pemt->aarOutput[i]));
+    }
+}
+
+/* Read the boards for gnubg.evaluate_many(): either an object with the
+ * buffer interface holding n x 2 x 25 integers of 1, 4 or 8 bytes (a
+ * numpy array, say), or a sequence of boards.  NULL, with an exception
+ * raised, if they are not valid positions. */
+static TanBoard *
+PyToBoards(PyObject * p, unsigned int *pc)
+{
+    TanBoard *aanBoard;
+    Py_ssize_t c, i;
+    Py_buffer view;
+
+    if (PyObject_CheckBuffer(p) && !PyObject_GetBuffer(p, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+        const char *pch = view.format ? view.format + strlen(view.format) - 1 : "B";
+        const unsigned char *puch = (const unsigned char *) view.buf;
+        unsigned int *pn;
+
+        if (!strchr("bBhHiIlLqQ", *pch) || (view.itemsize != 1 && view.itemsize != 4 && view.itemsize != 8)
+            || view.len % (50 * view.itemsize)) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, _("boards must be n x 2 x 25 integers of 1, 4 or 8 bytes"));
+            return NULL;
+        }
+
+        c = view.len / (50 * view.itemsize);
+        aanBoard = g_new(TanBoard, c ? c : 1);
+
+        for (i = 0, pn = aanBoard[0][0]; i < c * 50; i++, puch += view.itemsize) {
+            gint64 n;
+
+            if (view.itemsize == 1)
+                n = *puch;
+            else if (view.itemsize == 4) {
+                gint32 n32;
+
+                memcpy(&n32, puch, 4);
+                n = n32;
+            } else
+                memcpy(&n, puch, 8);
+
+            if (n < 0 || n > 15) {
+                PyBuffer_Release(&view);
+                g_free(aanBoard);
+                PyErr_SetString(PyExc_ValueError, _("invalid number of chequers on a point"));
+                return NULL;
+            }
+
+            pn[i] = (unsigned int) n;
+        }
+
+        PyBuffer_Release(&view);
+    } else {
+        PyObject *pySeq;
+
+        PyErr_Clear();
+
+        if (!(pySeq = PySequence_Fast(p, "boards must be a sequence or an array")))
+            return NULL;
+
+        c = PySequence_Fast_GET_SIZE(pySeq);
+        aanBoard = g_new(TanBoard, c ? c : 1);
+
+        for (i = 0; i < c; i++)
+            if (!PyToBoard(PySequence_Fast_GET_ITEM(pySeq, i), aanBoard[i]) || PyErr_Occurred()) {
+                Py_DECREF(pySeq);
+                g_free(aanBoard);
+                if (!PyErr_Occurred())
+                    PyErr_SetString(PyExc_ValueError, _("invalid board"));
+                return NULL;
+            }
+
+        Py_DECREF(pySeq);
+    }
+
+    if (c > G_MAXINT / EVALUATE_MANY_CHUNK) {
+        g_free(aanBoard);
+        PyErr_SetString(PyExc_ValueError, _("too many boards"));
+        return NULL;
+    }
+
+    for (i = 0; i < c; i++)
+        if (!CheckPosition((ConstTanBoard) aanBoard[i])) {
+            g_free(aanBoard);
+            PyErr_Format(PyExc_ValueError, _("board %d is not a valid position"), (int) i);
+            return NULL;
+        }
+
+    *pc = (unsigned int) c;
+    return aanBoard;
+}
+
+static PyObject *
+PythonEvaluateMany(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyBoards;
+    PyObject *pyCubeInfo = NULL;
+    PyObject *pyEvalContext = NULL;
+    PyObject *pyResult;
+
+    TanBoard *aanBoard;
+    float (*aarOutput)[6];
+    evaluatemanytask *aemt;
+    unsigned int c, cTasks, i;
+    int fFailed = FALSE;
+    taskgroup tg = { 0 };
+    cubeinfo ci;
+    evalcontext ec;
+
+    memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    if (!PyArg_ParseTuple(args, "O|OO", &pyBoards, &pyCubeInfo, &pyEvalContext))
+        return NULL;
+
+    if (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &ci))
+        return NULL;
+
+    if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
+        return NULL;
+
+    if (!(aanBoard = PyToBoards(pyBoards, &c)))
+        return NULL;
+
+    aarOutput = g_malloc(c ? c * sizeof(*aarOutput) : sizeof(*aarOutput));
+    cTasks = (c + EVALUATE_MANY_CHUNK - 1) / EVALUATE_MANY_CHUNK;
+    aemt = g_new(evaluatemanytask, cTasks ? cTasks : 1);
+
+    /* The tasks only touch the copies above, so the other Python
+     * threads may run meanwhile; without threads they would share the
+     * evaluation data */
+#if defined(USE_MULTITHREAD)
+    if (g_thread_self() != pgtMain)
+        MT_AttachThread();
+
+    Py_BEGIN_ALLOW_THREADS
+#endif
+    for (i = 0; i < cTasks; i++) {
+        aemt[i].aanBoard = (const TanBoard *) aanBoard + i * EVALUATE_MANY_CHUNK;
+        aemt[i].aarOutput = aarOutput + i * EVALUATE_MANY_CHUNK;
+        aemt[i].c = MIN(EVALUATE_MANY_CHUNK, c - i * EVALUATE_MANY_CHUNK);
+        aemt[i].pci = &ci;
+        aemt[i].pec = &ec;
+        aemt[i].pfFailed = &fFailed;
+
+        MT_ForkTask(&tg, EvaluateManyTask, &aemt[i]);
+    }
+    MT_JoinTasks(&tg);
+#if defined(USE_MULTITHREAD)
+    Py_END_ALLOW_THREADS
+#endif
+
+    g_free(aemt);
+    g_free(aanBoard);
+
+    if (fFailed || MT_SafeGet(&fInterrupt)) {
+        ResetInterrupt();
+        g_free(aarOutput);
+        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in evaluate_many"));
+        return NULL;
+    }
+
+    pyResult = PyFromBlock(aarOutput, "f", c, 6);
+    g_free(aarOutput);
+
+    return pyResult;
+}
+
+/* The inputs of the nets are worked out by gnubg.netinputs() in tasks
+ * of this many boards, spread over the threads */
+#define NET_INPUTS_CHUNK 256
+
+typedef struct {
+    const TanBoard *aanBoard;
+    float *arInput;             /* cInputs for each board */
+    guint32 *anClass;
+    unsigned int c;
+    unsigned int cInputs;
+    positionclass pc;           /* of the net, N_CLASSES for that of each board */
+    bgvariation bgv;
+} netinputstask;
+
+static void
+NetInputsTask(void *p)
+{
+    netinputstask *pnit = (netinputstask *) p;
+    unsigned int i;
+
+    for (i = 0; i < pnit->c; i++) {
+        float *arInput = pnit->arInput + (gsize) i * pnit->cInputs;
+        positionclass pc = ClassifyPosition(pnit->aanBoard[i], pnit->bgv);
+
+        pnit->anClass[i] = (guint32) pc;
+
+        if (pnit->pc != N_CLASSES)
+            pc = pnit->pc;
+        else if (pc < CLASS_RACE)
+            /* positions over or in the bearoff databases are races */
+            pc = CLASS_RACE;
+
+        if (EvalNetInputCount(pc) < pnit->cInputs)
+            memset(arInput + EvalNetInputCount(pc), 0, (pnit->cInputs - EvalNetInputCount(pc)) * sizeof(float));
+        EvalNetInputs(pnit->aanBoard[i], pc, arInput);
+    }
+}
+
+/* Get a writable buffer of c rows of cItems 32 bit items, of a format
+ * in szFormats; FALSE, with an exception raised, if py isn't one */
+static int
+PyToWritableBlock(PyObject * py, Py_buffer * pview, const char *szFormats, unsigned int c, unsigned int cItems,
+                  const char *szError)
+{
+    const char *pch;
+
+    if (PyObject_GetBuffer(py, pview, PyBUF_WRITABLE | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS))
+        return FALSE;
+
+    pch = pview->format ? pview->format + strlen(pview->format) - 1 : "B";
+    if (!strchr(szFormats, *pch) || pview->itemsize != 4 || pview->len != (Py_ssize_t) c * cItems * 4) {
+        PyBuffer_Release(pview);
+        PyErr_Format(PyExc_ValueError, szError, c, cItems);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static PyObject *
+PythonNetInputs(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyBoards, *pyInputs = NULL, *pyClasses = NULL;
+    PyObject *pyResult = NULL;
+    const char *szNet = NULL;
+    Py_buffer viewInputs, viewClasses;
+    TanBoard *aanBoard;
+    float *arInput;
+    guint32 *anClass;
+    netinputstask *anit;
+    positionclass pc;
+    unsigned int c, cInputs, cTasks, i;
+    taskgroup tg = { 0 };
+
+    if (!PyArg_ParseTuple(args, "O|zOO:netinputs", &pyBoards, &szNet, &pyInputs, &pyClasses))
+        return NULL;
+
+    if (!szNet || !strcmp(szNet, "auto"))
+        pc = N_CLASSES;
+    else if (!strcmp(szNet, "contact"))
+        pc = CLASS_CONTACT;
+    else if (!strcmp(szNet, "crashed"))
+        pc = CLASS_CRASHED;
+    else if (!strcmp(szNet, "race"))
+        pc = CLASS_RACE;
+    else {
+        PyErr_SetString(PyExc_ValueError, _("the net must be \"contact\", \"crashed\", \"race\" or \"auto\""));
+        return NULL;
+    }
+    cInputs = EvalNetInputCount(pc == N_CLASSES ? CLASS_CONTACT : pc);
+
+    if (pyInputs == Py_None)
+        pyInputs = NULL;
+    if (pyClasses == Py_None)
+        pyClasses = NULL;
+
+    if (!(aanBoard = PyToBoards(pyBoards, &c)))
+        return NULL;
+
+    if (!pyInputs)
+        arInput = g_malloc((gsize) (c ? c : 1) * cInputs * sizeof(float));
+    else if (PyToWritableBlock(pyInputs, &viewInputs, "f", c, cInputs,
+                               _("inputs must be a writable array of %u x %u 32 bit floats")))
+        arInput = (float *) viewInputs.buf;
+    else
+        goto done;
+
+    if (!pyClasses)
+        anClass = g_new(guint32, c ? c : 1);
+    else if (PyToWritableBlock(pyClasses, &viewClasses, "iI", c, 1,
+                               _("classes must be a writable array of %u x %u 32 bit integers")))
+        anClass = (guint32 *) viewClasses.buf;
+    else {
+        if (pyInputs)
+            PyBuffer_Release(&viewInputs);
+        else
+            g_free(arInput);
+        goto done;
+    }
+
+    cTasks = (c + NET_INPUTS_CHUNK - 1) / NET_INPUTS_CHUNK;
+    anit = g_new(netinputstask, cTasks ? cTasks : 1);
+
+    /* the buffers are held until the tasks are done, so the other
+     * Python threads may run meanwhile */
+#if defined(USE_MULTITHREAD)
+    if (g_thread_self() != pgtMain)
+        MT_AttachThread();
+
+    Py_BEGIN_ALLOW_THREADS
+#endif
+    for (i = 0; i < cTasks; i++) {
+        anit[i].aanBoard = (const TanBoard *) aanBoard + i * NET_INPUTS_CHUNK;
+        anit[i].arInput = arInput + (gsize) i * NET_INPUTS_CHUNK * cInputs;
+        anit[i].anClass = anClass + i * NET_INPUTS_CHUNK;
+        anit[i].c = MIN(NET_INPUTS_CHUNK, c - i * NET_INPUTS_CHUNK);
+        anit[i].cInputs = cInputs;
+        anit[i].pc = pc;
+        anit[i].bgv = ms.bgv;
+
+        MT_ForkTask(&tg, NetInputsTask, &anit[i]);
+    }
+    MT_JoinTasks(&tg);
+#if defined(USE_MULTITHREAD)
+    Py_END_ALLOW_THREADS
+#endif
+
+    g_free(anit);
+
+    if (pyInputs) {
+        PyBuffer_Release(&viewInputs);
+        Py_INCREF(pyInputs);
+    } else {
+        pyInputs = PyFromBlock(arInput, "f", c, cInputs);
+        g_free(arInput);
+    }
+
+    if (pyClasses) {
+        PyBuffer_Release(&viewClasses);
+        Py_INCREF(pyClasses);
+    } else {
+        pyClasses = PyFromBlock(anClass, "I", c, 1);
+        g_free(anClass);
+    }
+
+    if (pyInputs && pyClasses)
+        pyResult = Py_BuildValue("(NN)", pyInputs, pyClasses);
+    else {
+        Py_XDECREF(pyInputs);
+        Py_XDECREF(pyClasses);
+    }
+
+  done:
+    g_free(aanBoard);
+    return pyResult;
+}
+
+/* gnubg.scoregrid(): the cells of each position as a list of tuples,
+ * only those of the scores the cube can be at */
+static PyObject *
+PyFromScoreGrid(const scoregridposition * psgp, unsigned int nMaxAway)
+{
+    PyObject *pyList = PyList_New(0);
+    unsigned int n0, n1;
+
+    for (n0 = 1; pyList && n0 <= nMaxAway; n0++)
+        for (n1 = 1; n1 <= nMaxAway; n1++) {
+            const scoregridcell *psgc = &psgp->asgc[(n0 - 1) * nMaxAway + n1 - 1];
+            PyObject *pyMove, *pyEquity, *pyCell;
+            char sz[FORMATEDMOVESIZE];
+
+            if (!psgc->fValid)
+                continue;
+
+            if (psgc->anMove[0] < 0) {
+                pyMove = Py_None;
+                pyEquity = Py_None;
+                Py_INCREF(Py_None);
+                Py_INCREF(Py_None);
+            } else {
+                pyMove = PyUnicode_FromString(FormatMove(sz, (ConstTanBoard) psgp->anBoard, psgc->anMove));
+                pyEquity = PyFloat_FromDouble(psgc->rMove);
+            }
+
+            pyCell = Py_BuildValue("(IIsfffNN)", n0, n1, ScoreGridAction(psgc), psgc->arDouble[OUTPUT_NODOUBLE],
+                                   psgc->arDouble[OUTPUT_TAKE], psgc->arDouble[OUTPUT_DROP], pyMove, pyEquity);
+            if (!pyCell || PyList_Append(pyList, pyCell) < 0) {
+                Py_XDECREF(pyCell);
+                Py_DECREF(pyList);
+                return NULL;
+            }
+            Py_DECREF(pyCell);
+        }
+
+    return pyList;
+}
+
+static PyObject *
+PythonScoreGrid(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyIDs, *pySeq, *pyResult = NULL;
+    PyObject *pyEvalCube = NULL, *pyEvalChequer = NULL;
+    unsigned int nMaxAway = SCOREGRID_MAX_AWAY;
+    scoregridposition *asgp;
+    evalcontext ecCube, ecChequer;
+    Py_ssize_t c, i;
+    int n;
+
+    memcpy(&ecCube, &GetEvalCube()->ec, sizeof(evalcontext));
+    memcpy(&ecChequer, &GetEvalChequer()->ec, sizeof(evalcontext));
+
+    if (!PyArg_ParseTuple(args, "O|IOO:scoregrid", &pyIDs, &nMaxAway, &pyEvalCube, &pyEvalChequer))
+        return NULL;
+
+    if (nMaxAway < 1 || nMaxAway > MAXSCORE - 1) {
+        PyErr_Format(PyExc_ValueError, _("the away scores go up to at most %d"), MAXSCORE - 1);
+        return NULL;
+    }
+
+    if (pyEvalCube && pyEvalCube != Py_None && PyToEvalContext(pyEvalCube, &ecCube))
+        return NULL;
+    if (pyEvalChequer && pyEvalChequer != Py_None && PyToEvalContext(pyEvalChequer, &ecChequer))
+        return NULL;
+
+    if (!(pySeq = PySequence_Fast(pyIDs, "the IDs must be a sequence of strings")))
+        return NULL;
+
+    c = PySequence_Fast_GET_SIZE(pySeq);
+    asgp = g_new0(scoregridposition, c ? c : 1);
+
+    for (i = 0; i < c; i++) {
+        PyObject *pyID = PySequence_Fast_GET_ITEM(pySeq, i);
+        const char *sz = PyUnicode_Check(pyID) ? PyUnicode_AsUTF8(pyID) : NULL;
+
+        if (!sz || ScoreGridFromID(&asgp[i], sz) < 0) {
+            PyErr_Clear();
+            PyErr_Format(PyExc_ValueError, _("ID %d is not a valid GNU Backgammon ID"), (int) i);
+            Py_DECREF(pySeq);
+            g_free(asgp);
+            return NULL;
+        }
+    }
+    Py_DECREF(pySeq);
+
+#if defined(USE_MULTITHREAD)
+    if (g_thread_self() != pgtMain)
+        MT_AttachThread();
+
+    Py_BEGIN_ALLOW_THREADS
+#endif
+    n = ScoreGrid(asgp, (unsigned int) c, nMaxAway, &ecCube, &ecChequer, aamfEval);
+#if defined(USE_MULTITHREAD)
+    Py_END_ALLOW_THREADS
+#endif
+
+    if (n < 0) {
+        ResetInterrupt();
+        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in scoregrid"));
+    } else if ((pyResult = PyList_New(c)) != NULL)
+        for (i = 0; i < c; i++) {
+            PyObject *pyGrid = PyFromScoreGrid(&asgp[i], nMaxAway);
+
+            if (!pyGrid) {
+                Py_CLEAR(pyResult);
+                break;
+            }
+            PyList_SET_ITEM(pyResult, i, pyGrid);
+        }
+
+    for (i = 0; i < c; i++)
+        g_free(asgp[i].asgc);
+    g_free(asgp);
+
+    return pyResult;
+}
+
+static PyObject *
+PythonPresets(PyObject * UNUSED(self), PyObject * args)
+{
+    const unsigned int c = PresetCount();
+    PyObject *pyList;
+    unsigned int i;
+
+    if (!PyArg_ParseTuple(args, ":presets"))
+        return NULL;
+
+    pyList = PyList_New(c);
+
+    for (i = 0; pyList && i < c; i++) {
+        evalpreset *pep = PresetGet(i);
+        PyObject *pyPreset = Py_BuildValue("(sNNN)", pep->szName, EvalContextToPy(&pep->ecChequer),
+                                           EvalContextToPy(&pep->ecCube),
+                                           MoveFiltersToPy((ConstTmoveFilter) pep->aamf));
+
+        if (!pyPreset) {
+            Py_CLEAR(pyList);
+            break;
+        }
+        PyList_SET_ITEM(pyList, i, pyPreset);
+    }
+
+    return pyList;
+}
+
+/* Evaluations, hints and rollouts a Python program starts and comes
+ * back for later, see gnubg.evaluate_async() and gnubg.job_status().
+ * Their tasks run in the background on the calculation threads, each
+ * job with its own cancel token, so that the program can go on, poll
+ * them or wait for them on another Python thread.  Without threads
+ * there is nothing to run them meanwhile, and they are done before
+ * the call starting them returns. */
+
+typedef enum {
+    JOB_EVALUATE,
+    JOB_HINT,
+    JOB_ROLLOUT
+} pythonjobtype;
+
+/* the trials of a rollout job are played in tasks of this many */
+#define JOB_ROLLOUT_CHUNK 36
+
+typedef struct {
+    canceltoken ct;
+    pythonjobtype jt;
+    int fFailed;
+    TanBoard anBoard;
+    cubeinfo ci;
+    evalcontext ec;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    int anDice[2];
+    int nMaxMoves;
+    movelist ml;
+    rolloutcontext rc;
+    /* the result of an evaluation, or the running mean and sum of
+     * squared deviations of the trials of a rollout */
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    float arM2[NUM_ROLLOUT_OUTPUTS];
+    unsigned int cDone;
+} pythonjob;
+
+typedef struct {
+    Task task;
+    pythonjob *pj;
+    unsigned int iFirst;        /* the trials of a rollout task */
+    unsigned int c;
+} pythonjobtask;
+
+/* the jobs by number, only touched with the Python lock held */
+static GHashTable *phtJobs;
+static int iNextJob;
+
+SIMD_STACKALIGN static void
+PythonJobEvaluate(void *p)
+{
+    pythonjob *pj = ((pythonjobtask *) p)->pj;
+
+    if (GeneralEvaluationE(pj->arOutput, (ConstTanBoard) pj->anBoard, &pj->ci, &pj->ec) < 0)
+        MT_SafeSet(&pj->fFailed, TRUE);
+}
+
+SIMD_STACKALIGN static void
+PythonJobHint(void *p)
+{
+    pythonjob *pj = ((pythonjobtask *) p)->pj;
+
+    if (FindnSaveBestMoves(&pj->ml, pj->anDice[0], pj->anDice[1], (ConstTanBoard) pj->anBoard, NULL,
+                           arSkillLevel[SKILL_DOUBTFUL], &pj->ci, &pj->ec, pj->aamf) < 0)
+        MT_SafeSet(&pj->fFailed, TRUE);
+}
+
+SIMD_STACKALIGN static void
+PythonJobRollout(void *p)
+{
+    pythonjobtask *pjt = (pythonjobtask *) p;
+    pythonjob *pj = pjt->pj;
+    rngcontext *rngctx = CopyRNGContext(rngctxRollout);
+    perArray dicePerms;
+    int afCubeDecTop[1] = { FALSE };
+    unsigned int i, j;
+
+    dicePerms.nPermutationSeed = -1;
+
+    for (i = 0; i < pjt->c && !MT_Cancelled(); i++) {
+        float aar[NUM_ROLLOUT_OUTPUTS];
+
+        if (RolloutTrial((ConstTanBoard) pj->anBoard, aar, (int) (pjt->iFirst + i), &pj->ci, afCubeDecTop, &pj->rc,
+                         NULL, pj->ci.nCube, &dicePerms, rngctx, NULL) < 0) {
+            if (!MT_Cancelled())
+                MT_SafeSet(&pj->fFailed, TRUE);
+            break;
+        }
+
+        /* Welford's update, as the rollouts do it */
+        MT_Lock(MT_LOCK_PYTHONJOB);
+        pj->cDone++;
+        for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+            float rDelta = aar[j] - pj->arOutput[j];
+
+            pj->arOutput[j] += rDelta / (float) pj->cDone;
+            pj->arM2[j] += rDelta * (aar[j] - pj->arOutput[j]);
+        }
+        MT_Unlock(MT_LOCK_PYTHONJOB);
+    }
+
+    free_rngctx(rngctx);
+}
+
+static void
+PythonJobAddTask(pythonjob * pj, AsyncFun fun, unsigned int iFirst, unsigned int c)
+{
+    pythonjobtask *pjt = g_new(pythonjobtask, 1);
+
+    pjt->task.fun = fun;
+    pjt->task.data = pjt;
+    pjt->task.pLinkedTask = NULL;
+    pjt->task.priority = TASK_BACKGROUND;
+    pjt->task.pct = &pj->ct;
+    pjt->pj = pj;
+    pjt->iFirst = iFirst;
+    pjt->c = c;
+
+#if defined(USE_MULTITHREAD)
+    MT_AddTask(&pjt->task, TRUE);
+#else
+    {
+        canceltoken *pctOld = MT_SetJob(&pj->ct);
+
+        fun(pjt);
+        MT_SetJob(pctOld);
+        g_free(pjt);
+    }
+#endif
+}
+
+/* Number the job pj and start its tasks */
+static PyObject *
+PythonJobStart(pythonjob * pj)
+{
+    int iJob = ++iNextJob;
+
+    if (!phtJobs)
+        phtJobs = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    g_hash_table_insert(phtJobs, GINT_TO_POINTER(iJob), pj);
+
+    switch (pj->jt) {
+    case JOB_EVALUATE:
+        PythonJobAddTask(pj, PythonJobEvaluate, 0, 1);
+        break;
+    case JOB_HINT:
+        PythonJobAddTask(pj, PythonJobHint, 0, 1);
+        break;
+    case JOB_ROLLOUT:{
+            unsigned int i;
+
+            for (i = 0; i < pj->rc.nTrials; i += JOB_ROLLOUT_CHUNK)
+                PythonJobAddTask(pj, PythonJobRollout, i, MIN(JOB_ROLLOUT_CHUNK, pj->rc.nTrials - i));
+            break;
+        }
+    }
+
+    return Py_BuildValue("i", iJob);
+}
+
+/* A new job for the board, cube and evaluation context of the match
+ * unless given.  NULL, with an exception raised, if they are not
+ * valid. */
+static pythonjob *
+PythonJobNew(pythonjobtype jt, PyObject * pyBoard, PyObject * pyCubeInfo, PyObject * pyEvalContext)
+{
+    pythonjob *pj = g_new0(pythonjob, 1);
+
+    pj->jt = jt;
+    memcpy(pj->anBoard, msBoard(), sizeof(TanBoard));
+    GetMatchStateCubeInfo(&pj->ci, &ms);
+    memcpy(&pj->ec, &GetEvalChequer()->ec, sizeof(evalcontext));
+    memcpy(pj->aamf, *GetEvalMoveFilter(), sizeof(pj->aamf));
+    pj->rc = rcRollout;
+
+    if ((pyBoard && !PyToBoard(pyBoard, pj->anBoard)) || (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &pj->ci))
+        || (pyEvalContext && PyToEvalContext(pyEvalContext, &pj->ec))) {
+        g_free(pj);
+        return NULL;
+    }
+
+    /* with the move filter of a preset */
+    if (pyEvalContext && PyUnicode_Check(pyEvalContext))
+        memcpy(pj->aamf, PyToPreset(pyEvalContext)->aamf, sizeof(pj->aamf));
+
+    if (!CheckPosition((ConstTanBoard) pj->anBoard)) {
+        g_free(pj);
+        PyErr_SetString(PyExc_ValueError, _("not a valid position"));
+        return NULL;
+    }
+
+    return pj;
+}
+
+static PyObject *
+PythonEvaluateAsync(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyBoard = NULL, *pyCubeInfo = NULL, *pyEvalContext = NULL;
+    pythonjob *pj;
+
+    if (!PyArg_ParseTuple(args, "|OOO", &pyBoard, &pyCubeInfo, &pyEvalContext))
+        return NULL;
+
+    if (!(pj = PythonJobNew(JOB_EVALUATE, pyBoard, pyCubeInfo, pyEvalContext)))
+        return NULL;
+
+    return PythonJobStart(pj);
+}
+
+static PyObject *
+PythonHintAsync(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyBoard, *pyCubeInfo = NULL, *pyEvalContext = NULL;
+    pythonjob *pj;
+    int anDice[2];
+    int nMaxMoves = MAX_MOVES;
+
+    if (!PyArg_ParseTuple(args, "O(ii)|OOi", &pyBoard, &anDice[0], &anDice[1], &pyCubeInfo, &pyEvalContext,
+                          &nMaxMoves))
+        return NULL;
+
+    if (anDice[0] < 1 || anDice[0] > 6 || anDice[1] < 1 || anDice[1] > 6) {
+        PyErr_SetString(PyExc_ValueError, _("invalid dice"));
+        return NULL;
+    }
+
+    if (!(pj = PythonJobNew(JOB_HINT, pyBoard, pyCubeInfo, pyEvalContext)))
         return NULL;
 
-    return PyInt_FromLong(getLuckRating(r));
+    pj->anDice[0] = anDice[0];
+    pj->anDice[1] = anDice[1];
+    pj->nMaxMoves = nMaxMoves < 0 ? MAX_MOVES : nMaxMoves;
 
+    return PythonJobStart(pj);
 }
 
 static PyObject *
-PythonClassifyPosition(PyObject * UNUSED(self), PyObject * args)
+PythonRolloutAsync(PyObject * UNUSED(self), PyObject * args)
 {
-    PyObject *pyBoard = NULL;
-    TanBoard anBoard;
-    bgvariation iVariant = ms.bgv;
+    PyObject *pyBoard = NULL, *pyCubeInfo = NULL;
+    pythonjob *pj;
+    int nTrials = -1, nTruncate = -1;
 
-    memcpy(anBoard, msBoard(), sizeof(TanBoard));
+    if (!PyArg_ParseTuple(args, "|OOii", &pyBoard, &pyCubeInfo, &nTrials, &nTruncate))
+        return NULL;
 
-    if (!PyArg_ParseTuple(args, "|Oi", &pyBoard, &iVariant))
+    if (!(pj = PythonJobNew(JOB_ROLLOUT, pyBoard, pyCubeInfo, NULL)))
         return NULL;
 
-    if (pyBoard && !PyToBoard(pyBoard, anBoard)) {
-        PyErr_SetString(PyExc_StandardError, _("Invalid board as argument "));
+    /* the dice of these can't be played off the main thread */
+    if (pj->rc.rngRollout == RNG_MANUAL || pj->rc.rngRollout == RNG_FILE) {
+        g_free(pj);
+        PyErr_SetString(PyExc_StandardError, _("rollouts with manual dice or dice from a file can't run "
+                                              "in the background"));
         return NULL;
     }
 
-    if (iVariant >= NUM_VARIATIONS) {
-        PyErr_SetString(PyExc_StandardError, _("Variation unknown "));
-        return NULL;
+    if (nTrials > 0)
+        pj->rc.nTrials = (unsigned int) nTrials;
+    if (nTruncate >= 0) {
+        pj->rc.fDoTruncate = nTruncate > 0;
+        pj->rc.nTruncate = (unsigned short) nTruncate;
     }
 
-    return PyInt_FromLong(ClassifyPosition((ConstTanBoard) anBoard, iVariant));
+    /* as RolloutGeneral() does */
+    if (pj->rc.fInitial && !pj->rc.fSobol)
+        pj->rc.fRotate = FALSE;
+
+    return PythonJobStart(pj);
 }
 
-static PyObject *
-PythonErrorRating(PyObject * UNUSED(self), PyObject * args)
+/* The job numbered by args, NULL with an exception raised if there is
+ * none */
+static pythonjob *
+PythonJobFind(PyObject * args, int *piJob, double *prTimeout)
 {
+    pythonjob *pj;
+    int iJob;
 
-    float r;
-    if (!PyArg_ParseTuple(args, "f", &r))
+    if (!(prTimeout ? PyArg_ParseTuple(args, "i|d", &iJob, prTimeout) : PyArg_ParseTuple(args, "i", &iJob)))
         return NULL;
 
-    return PyInt_FromLong(GetRating(r));
+    if (piJob)
+        *piJob = iJob;
 
-}
+    if (!phtJobs || !(pj = g_hash_table_lookup(phtJobs, GINT_TO_POINTER(iJob)))) {
+        PyErr_Format(PyExc_KeyError, _("no job %d"), iJob);
+        return NULL;
+    }
 
-/* Convert Move tuple to a string
- * A tuple can be expressed in two forms.
- * form returned by findbestmove ie. (21,18,11,5)
- * form returned by parsemove ie. ((21,18),(11,5))
- *
- * returns a string representing the move tuple.
- */
+    return pj;
+}
 
-static PyObject *
-PythonMoveTuple2String(PyObject * UNUSED(self), PyObject * args)
+/* Wait up to rTimeout seconds, for ever if negative, for the tasks of
+ * pj to finish, without the Python lock.  TRUE if they have. */
+static int
+PythonJobWait(pythonjob * pj, double rTimeout)
 {
+    gint64 tEnd = g_get_monotonic_time() + (gint64) (rTimeout * G_TIME_SPAN_SECOND);
+    int fBusy;
 
-    PyObject *pyBoard = NULL;
-    PyObject *pyMove = NULL;
-
-    char szMove[FORMATEDMOVESIZE];
-    signed int anMove[8];
-    TanBoard anBoard;
+    Py_BEGIN_ALLOW_THREADS
+    while ((fBusy = MT_JobBusy(&pj->ct)) && (rTimeout < 0.0 || g_get_monotonic_time() < tEnd))
+        g_usleep(1000);
+    Py_END_ALLOW_THREADS
 
-    memset(anBoard, 0, sizeof(TanBoard));
-    memset(anMove, -1, sizeof(anMove));
+    return !fBusy;
+}
 
-    if (!PyArg_ParseTuple(args, "|OO", &pyMove, &pyBoard))
-        return NULL;
+static void
+PythonJobFree(pythonjob * pj)
+{
+    MT_Cancel(&pj->ct);
+    PythonJobWait(pj, -1.0);
 
-    if (!pyMove || !pyBoard) {
-        PyErr_SetString(PyExc_TypeError,
-                        _("requires 2 arguments (MoveTuple, Board). "
-                          "(see gnubg.findbestmove() and gnubg.board() for examples)"));
-        return NULL;
-    }
+    if (pj->jt == JOB_HINT && pj->ml.cMoves)
+        g_free(pj->ml.amMoves);
 
-    if (!PyToMove(pyMove, anMove)) {
-        PyErr_SetString(PyExc_StandardError, _("Invalid move tuple as argument"));
-        return NULL;
-    }
+    g_free(pj);
+}
 
-    if (!PyToBoard(pyBoard, anBoard)) {
-        PyErr_SetString(PyExc_StandardError, _("Invalid board as argument "));
-        return NULL;
+/* The estimates of a rollout so far, ready for Python */
+static PyObject *
+PythonJobRolloutResult(pythonjob * pj)
+{
+    float ar[NUM_ROLLOUT_OUTPUTS], arStdDev[NUM_ROLLOUT_OUTPUTS];
+    unsigned int n, j;
+
+    MT_Lock(MT_LOCK_PYTHONJOB);
+    n = pj->cDone;
+    for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+        ar[j] = pj->arOutput[j];
+        arStdDev[j] = n > 1 ? sqrtf(pj->arM2[j] / (float) (n - 1) / (float) n) : 0.0f;
+        if (j < OUTPUT_EQUITY)
+            ar[j] = CLAMP(ar[j], 0.0f, 1.0f);
     }
+    MT_Unlock(MT_LOCK_PYTHONJOB);
 
-    szMove[0] = '\0';
-    FormatMove(szMove, (ConstTanBoard) anBoard, anMove);
-
-    return PyUnicode_FromString(szMove);
+    return Py_BuildValue("{s:i,s:(fffffff),s:(fffffff)}", "trials", n,
+                         "mean", ar[0], ar[1], ar[2], ar[3], ar[4], ar[5], ar[6],
+                         "stddev", arStdDev[0], arStdDev[1], arStdDev[2], arStdDev[3], arStdDev[4], arStdDev[5],
+                         arStdDev[6]);
 }
 
 static PyObject *
-PythonCalculateGammonPrice(PyObject * UNUSED(self), PyObject * pyCubeInfo)
+PythonJobStatus(PyObject * UNUSED(self), PyObject * args)
 {
-    cubeinfo ci;
-    PyObject *gvObj = NULL;
+    pythonjob *pj;
+    int fDone;
+    double rProgress;
 
-    if (PyToCubeInfo(pyCubeInfo, &ci) < 0)
+    if (!(pj = PythonJobFind(args, NULL, NULL)))
         return NULL;
 
-    if (SetCubeInfo(&ci, ci.nCube, ci.fCubeOwner, ci.fMove, ci.nMatchTo, ci.anScore,
-                    ci.fCrawford, ci.fJacoby, ci.fBeavers, ci.bgv)) {
-        PyErr_SetString(PyExc_StandardError, _("error in SetCubeInfo\n"));
-        return NULL;
-    }
+    fDone = !MT_JobBusy(&pj->ct);
 
-    gvObj = Py_BuildValue("(ff)(ff)", ci.arGammonPrice[0], ci.arGammonPrice[2],
-                          ci.arGammonPrice[1], ci.arGammonPrice[3]);
-    DictSetItemSteal(pyCubeInfo, "gammonprice", gvObj);
+    if (pj->jt == JOB_ROLLOUT) {
+        unsigned int cDone;
 
-    Py_INCREF(pyCubeInfo);
-    return (pyCubeInfo);
-}
+        MT_Lock(MT_LOCK_PYTHONJOB);
+        cDone = pj->cDone;
+        MT_Unlock(MT_LOCK_PYTHONJOB);
 
-SIMD_STACKALIGN static PyObject *
-PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
-{
+        rProgress = pj->rc.nTrials ? (double) cDone / pj->rc.nTrials : 1.0;
 
-    PyObject *pyBoard = NULL;
-    PyObject *pyCubeInfo = NULL;
-    PyObject *pyEvalContext = NULL;
+        return Py_BuildValue("{s:N,s:N,s:N,s:d,s:N}", "done", PyBool_FromLong(fDone),
+                             "cancelled", PyBool_FromLong(MT_SafeGet(&pj->ct.fCancelled)),
+                             "failed", PyBool_FromLong(MT_SafeGet(&pj->fFailed)), "progress", rProgress,
+                             "rollout", PythonJobRolloutResult(pj));
+    }
 
-    int fSaveShowProg;
-    decisionData dd;
-    TanBoard anBoard;
-    cubeinfo ci;
-    evalcontext ec;
+    return Py_BuildValue("{s:N,s:N,s:N,s:d}", "done", PyBool_FromLong(fDone),
+                         "cancelled", PyBool_FromLong(MT_SafeGet(&pj->ct.fCancelled)),
+                         "failed", PyBool_FromLong(MT_SafeGet(&pj->fFailed)), "progress", fDone ? 1.0 : 0.0);
+}
 
-    memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
-    memcpy(anBoard, msBoard(), sizeof(TanBoard));
-    GetMatchStateCubeInfo(&ci, &ms);
+static PyObject *
+PythonJobWaitPy(PyObject * UNUSED(self), PyObject * args)
+{
+    pythonjob *pj;
+    double rTimeout = -1.0;
 
-    if (!PyArg_ParseTuple(args, "|OOO", &pyBoard, &pyCubeInfo, &pyEvalContext))
+    if (!(pj = PythonJobFind(args, NULL, &rTimeout)))
         return NULL;
 
-    if (pyBoard && !PyToBoard(pyBoard, anBoard))
-        return NULL;
+    return PyBool_FromLong(PythonJobWait(pj, rTimeout));
+}
 
-    if (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &ci))
-        return NULL;
+static PyObject *
+PythonJobCancel(PyObject * UNUSED(self), PyObject * args)
+{
+    pythonjob *pj;
 
-    if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
+    if (!(pj = PythonJobFind(args, NULL, NULL)))
         return NULL;
 
-    dd.pboard = (ConstTanBoard) anBoard;
-    dd.pci = &ci;
-    dd.pec = &ec;
+    MT_Cancel(&pj->ct);
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncMoveDecisionE, &dd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
-        fShowProgress = fSaveShowProg;
-        ResetInterrupt();
-        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncMoveDecisionE"));
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject *
+PythonJobResult(PyObject * UNUSED(self), PyObject * args)
+{
+    pythonjob *pj;
+    PyObject *pyResult = NULL;
+    int iJob;
+
+    if (!(pj = PythonJobFind(args, &iJob, NULL)))
         return NULL;
-    }
-    fShowProgress = fSaveShowProg;
 
-    {
-        PyObject *p = PyTuple_New(6);
-        int k;
-        for (k = 0; k < 6; ++k) {
-            PyTuple_SET_ITEM(p, k, PyFloat_FromDouble(dd.aarOutput[0][k]));
+    PythonJobWait(pj, -1.0);
+
+    if (pj->fFailed)
+        PyErr_SetString(PyExc_StandardError, _("the job failed"));
+    else if (pj->ct.fCancelled && pj->jt != JOB_ROLLOUT)
+        PyErr_SetString(PyExc_StandardError, _("the job was cancelled"));
+    else
+        switch (pj->jt) {
+        case JOB_EVALUATE:
+            pyResult = Py_BuildValue("(ffffff)", pj->arOutput[0], pj->arOutput[1], pj->arOutput[2],
+                                     pj->arOutput[3], pj->arOutput[4], pj->arOutput[5]);
+            break;
+        case JOB_HINT:{
+                unsigned int i;
+
+                pyResult = PyList_New(0);
+                for (i = 0; pyResult && i < pj->ml.cMoves && (int) i < pj->nMaxMoves; i++) {
+                    const move *pm = &pj->ml.amMoves[i];
+                    char szMove[FORMATEDMOVESIZE];
+                    PyObject *pyMove;
+
+                    FormatMove(szMove, (ConstTanBoard) pj->anBoard, pm->anMove);
+                    pyMove = Py_BuildValue("{s:s,s:f,s:(fffff)}", "move", szMove, "equity", pm->rScore,
+                                           "probs", pm->arEvalMove[0], pm->arEvalMove[1], pm->arEvalMove[2],
+                                           pm->arEvalMove[3], pm->arEvalMove[4]);
+                    if (!pyMove || PyList_Append(pyResult, pyMove) < 0) {
+                        Py_XDECREF(pyMove);
+                        Py_DECREF(pyResult);
+                        pyResult = NULL;
+                        break;
+                    }
+                    Py_DECREF(pyMove);
+                }
+                break;
+            }
+        case JOB_ROLLOUT:
+            /* a cancelled rollout gives the trials it got through */
+            pyResult = PythonJobRolloutResult(pj);
+            break;
         }
-        return p;
-    }
+
+    /* the job is done with either way */
+    g_hash_table_remove(phtJobs, GINT_TO_POINTER(iJob));
+    PythonJobFree(pj);
+
+    return pyResult;
 }
 
 SIMD_STACKALIGN static PyObject *
@@ -1277,7 +2480,6 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     PyObject *pyCubeInfo = NULL;
     PyObject *pyEvalContext = NULL;
 
-    int fSaveShowProg;
     decisionData dd;
     TanBoard anBoard;
     float arCube[NUM_CUBEFUL_OUTPUTS];
@@ -1306,15 +2508,9 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     dd.pec = &ec;
     dd.pes = NULL;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncCubeDecisionE, &dd, _("Considering cube decision...")) != 0) || MT_SafeGet(&fInterrupt)) {
-        fShowProgress = fSaveShowProg;
-        ResetInterrupt();
-        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncCubeDecisionE"));
+    if (!PythonRunEngine((AsyncFun) asyncCubeDecisionE, EngineCubeDecision, &dd, _("Considering cube decision..."),
+                         _("interrupted/errno in asyncCubeDecisionE")))
         return NULL;
-    }
-    fShowProgress = fSaveShowProg;
 
     cp = FindCubeDecision(arCube, dd.aarOutput, &ci);
 
@@ -1346,7 +2542,7 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     evalcontext ec;
     movelist ml;
     findData fd;
-    int fSaveShowProg;
+    TmoveFilter aamfPreset;
 
     memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
     memcpy(anBoard, msBoard(), sizeof(TanBoard));
@@ -1374,6 +2570,13 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
         return NULL;
 
+    /* a copy of the move filter of a preset, which the move filters
+     * given may change */
+    if (pyEvalContext && PyUnicode_Check(pyEvalContext)) {
+        memcpy(aamfPreset, PyToPreset(pyEvalContext)->aamf, sizeof(aamfPreset));
+        fd.aamf = aamfPreset;
+    }
+
     if (pyMoveFilters && PyToMoveFilters(pyMoveFilters, fd.aamf))
         return NULL;
 
@@ -1384,15 +2587,9 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     fd.pci = &ci;
     fd.pec = &ec;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncFindBestMoves, &fd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
-        fShowProgress = fSaveShowProg;
-        ResetInterrupt();
-        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncFindBestMoves"));
+    if (!PythonRunEngine((AsyncFun) asyncFindBestMoves, EngineFindBestMoves, &fd, _("Considering move..."),
+                         _("interrupted/errno in asyncFindBestMoves")))
         return NULL;
-    }
-    fShowProgress = fSaveShowProg;
 
     {
         PyObject *p;
@@ -1597,6 +2794,93 @@ PythonEq2mwc(PyObject * UNUSED(self), PyObject * args)
 
 }
 
+static PyObject *
+CacheStatsToPy(unsigned int (*ac)[CACHESTATS_PLIES][N_CLASSES])
+{
+    static const char *aszStat[N_CACHESTATS] = { "lookups", "threadhits", "hits" };
+    PyObject *pyDict = PyDict_New();
+    int i, j, k;
+
+    for (k = 0; k < N_CACHESTATS; k++) {
+        PyObject *pyPlies = PyTuple_New(CACHESTATS_PLIES);
+
+        for (i = 0; i < CACHESTATS_PLIES; i++) {
+            PyObject *pyClasses = PyTuple_New(N_CLASSES);
+
+            for (j = 0; j < N_CLASSES; j++)
+                PyTuple_SET_ITEM(pyClasses, j, PyLong_FromUnsignedLong(ac[k][i][j]));
+            PyTuple_SET_ITEM(pyPlies, i, pyClasses);
+        }
+        DictSetItemSteal(pyDict, aszStat[k], pyPlies);
+    }
+
+    return pyDict;
+}
+
+static PyObject *
+PythonCacheStats(PyObject * UNUSED(self), PyObject * UNUSED(args))
+{
+    PyObject *pyDict = PyDict_New();
+    PyObject *pyPruning = PyDict_New();
+    PyObject *pyLookups = PyTuple_New(N_CLASSES);
+    PyObject *pyHits = PyTuple_New(N_CLASSES);
+    evalcachestats ecs;
+    unsigned int c, cPruning;
+    int j;
+
+    EvalCacheStats(&ecs, &c, &cPruning);
+
+    DictSetItemSteal(pyDict, "enabled", PyBool_FromLong(EvalGetCacheStats()));
+    DictSetItemSteal(pyDict, "used", PyLong_FromUnsignedLong(c));
+    DictSetItemSteal(pyDict, "cubeless", CacheStatsToPy(ecs.acCubeless));
+    DictSetItemSteal(pyDict, "cubeful", CacheStatsToPy(ecs.acCubeful));
+
+    for (j = 0; j < N_CLASSES; j++) {
+        PyTuple_SET_ITEM(pyLookups, j, PyLong_FromUnsignedLong(ecs.acPruning[CACHESTATS_LOOKUP][j]));
+        PyTuple_SET_ITEM(pyHits, j, PyLong_FromUnsignedLong(ecs.acPruning[CACHESTATS_HIT][j]));
+    }
+    DictSetItemSteal(pyPruning, "used", PyLong_FromUnsignedLong(cPruning));
+    DictSetItemSteal(pyPruning, "lookups", pyLookups);
+    DictSetItemSteal(pyPruning, "hits", pyHits);
+    DictSetItemSteal(pyDict, "pruning", pyPruning);
+    DictSetItemSteal(pyDict, "localnode", PyLong_FromUnsignedLong(ecs.acNode[0]));
+    DictSetItemSteal(pyDict, "remotenode", PyLong_FromUnsignedLong(ecs.acNode[1]));
+
+    return pyDict;
+}
+
+static PyObject *
+PythonThreadStats(PyObject * UNUSED(self), PyObject * UNUSED(args))
+{
+    PyObject *pyList = PyList_New(0);
+    int i, j;
+
+    for (i = -1; i < (int) MT_GetNumThreads(); i++) {
+        PyObject *pyDict, *pyEvals;
+        threadstats ts;
+
+        if (MT_GetThreadStats(i, &ts) < 0)
+            continue;
+
+        pyDict = PyDict_New();
+        pyEvals = PyTuple_New(N_CLASSES);
+        for (j = 0; j < N_CLASSES; j++)
+            PyTuple_SET_ITEM(pyEvals, j, PyLong_FromUnsignedLongLong(ts.acEval[j]));
+
+        DictSetItemSteal(pyDict, "thread", PyLong_FromLong(i));
+        DictSetItemSteal(pyDict, "tasks", PyLong_FromUnsignedLong(ts.cTasks));
+        DictSetItemSteal(pyDict, "busy", PyFloat_FromDouble((double) ts.tBusy / 1e6));
+        DictSetItemSteal(pyDict, "idle", PyFloat_FromDouble((double) ts.tIdle / 1e6));
+        DictSetItemSteal(pyDict, "exclusive", PyFloat_FromDouble((double) ts.tExclusive / 1e6));
+        DictSetItemSteal(pyDict, "evaluations", pyEvals);
+        DictSetItemSteal(pyDict, "cachehits", PyLong_FromUnsignedLongLong(ts.cCacheHit));
+        PyList_Append(pyList, pyDict);
+        Py_DECREF(pyDict);
+    }
+
+    return pyList;
+}
+
 static PyObject *
 PythonMatchChecksum(PyObject * UNUSED(self), PyObject * UNUSED(args))
 {
@@ -1853,6 +3137,113 @@ PythonPositionFromKey(PyObject * UNUSED(self), PyObject * args)
     return BoardToPy((ConstTanBoard) anBoard);
 }
 
+/* gnubg.positionkeysfromids(): the IDs come as one block of characters,
+ * L_POSITIONID each and cbStride apart (anything with the buffer
+ * interface, such as bytes or a numpy array), or as a sequence of
+ * strings */
+static PyObject *
+PythonPositionKeysFromIDs(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyIDs, *pyResult;
+    Py_ssize_t cbStride = L_POSITIONID, c;
+    positionkey *akey;
+    Py_buffer view;
+
+    if (!PyArg_ParseTuple(args, "O|n:positionkeysfromids", &pyIDs, &cbStride))
+        return NULL;
+
+    if (cbStride < L_POSITIONID) {
+        PyErr_SetString(PyExc_ValueError, _("the stride must be at least the length of an ID"));
+        return NULL;
+    }
+
+    if (!PyUnicode_Check(pyIDs) && PyObject_CheckBuffer(pyIDs)
+        && !PyObject_GetBuffer(pyIDs, &view, PyBUF_C_CONTIGUOUS)) {
+        /* the last one needs no room after it */
+        c = view.len < L_POSITIONID ? 0 : (view.len - L_POSITIONID) / cbStride + 1;
+        if (c > G_MAXINT) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, _("too many IDs"));
+            return NULL;
+        }
+        akey = g_new(positionkey, c ? c : 1);
+
+        Py_BEGIN_ALLOW_THREADS
+        PositionKeysFromIDs(akey, (const char *) view.buf, (size_t) cbStride, (unsigned int) c);
+        Py_END_ALLOW_THREADS
+
+        PyBuffer_Release(&view);
+    } else {
+        PyObject *pySeq;
+        Py_ssize_t i;
+
+        PyErr_Clear();
+
+        if (!(pySeq = PySequence_Fast(pyIDs, "IDs must be a sequence or a buffer")))
+            return NULL;
+
+        c = PySequence_Fast_GET_SIZE(pySeq);
+        akey = g_new(positionkey, c ? c : 1);
+
+        for (i = 0; i < c; i++) {
+            PyObject *py = PySequence_Fast_GET_ITEM(pySeq, i);
+#if PY_MAJOR_VERSION >= 3
+            const char *sz = PyUnicode_Check(py) ? PyUnicode_AsUTF8(py) : NULL;
+#else
+            const char *sz = PyString_Check(py) ? PyString_AsString(py) : NULL;
+#endif
+
+            if (!sz || strlen(sz) != L_POSITIONID || PositionKeysFromIDs(&akey[i], sz, L_POSITIONID, 1) != 1)
+                memset(&akey[i], 0, sizeof(positionkey));
+        }
+        PyErr_Clear();
+
+        Py_DECREF(pySeq);
+    }
+
+    pyResult = PyFromBlock(akey, "I", (unsigned int) c, 7);
+    g_free(akey);
+
+    return pyResult;
+}
+
+/* gnubg.positionidsfromkeys(): the IDs of the keys of a block of n x 7
+ * unsigned 32 bit integers, as one string */
+static PyObject *
+PythonPositionIDsFromKeys(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyKeys, *pyResult;
+    Py_buffer view;
+    unsigned int c;
+    char *pch;
+
+    if (!PyArg_ParseTuple(args, "O:positionidsfromkeys", &pyKeys))
+        return NULL;
+
+    if (PyObject_GetBuffer(pyKeys, &view, PyBUF_C_CONTIGUOUS))
+        return NULL;
+
+    if (view.len % sizeof(positionkey) || view.len / sizeof(positionkey) > G_MAXINT) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, _("keys must be n x 7 unsigned 32 bit integers"));
+        return NULL;
+    }
+
+    c = (unsigned int) (view.len / sizeof(positionkey));
+    pch = g_malloc((gsize) c * L_POSITIONID + 1);
+
+    Py_BEGIN_ALLOW_THREADS
+    PositionIDsFromKeys(pch, L_POSITIONID, (const positionkey *) view.buf, c);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&view);
+
+    pyResult = PyUnicode_FromStringAndSize(pch, (Py_ssize_t) c * L_POSITIONID);
+    g_free(pch);
+
+    return pyResult;
+}
+
 
 static PyObject *
 PythonPositionBearoff(PyObject * UNUSED(self), PyObject * args)
@@ -3166,6 +4557,28 @@ static PyMethodDef gnubgMethods[] = {
      "    arguments: none\n"
      "    returns: tuple of two lists of 25 ints:\n" "        pieces on points 1..24 and the bar"}
     ,
+    {"boardimage", PythonBoardImage, METH_VARARGS,
+     "Draw a board as an image, without a display\n"
+     "    arguments: [format ('png' or 'svg'), size (1 to 20, see 'set export\n"
+     "        png size'), position ID, match ID]; the current board\n"
+     "        if there are no IDs\n"
+     "    returns: bytes of the image file, or None if there is no board"}
+    ,
+    {"cachestats", PythonCacheStats, METH_VARARGS,
+     "Get the statistics of the evaluation cache (see 'set cachestats')\n"
+     "    arguments: none\n"
+     "    returns: dictionary with the entries used and, for cubeless and\n"
+     "        cubeful lookups, tuples of lookups, threadhits and hits\n"
+     "        indexed by plies (0, 1, 2, 3 or more) and position class;\n"
+     "        'pruning' is the same for the pruning cache by class"}
+    ,
+    {"threadstats", PythonThreadStats, METH_VARARGS,
+     "Get what each calculation thread has done (see 'show threads statistics')\n"
+     "    arguments: none\n"
+     "    returns: list of dictionaries, one per thread (thread -1 is the main\n"
+     "        thread), with tasks, busy, idle and exclusive seconds, cachehits\n"
+     "        and a tuple of evaluations by position class"}
+    ,
     {"calcgammonprice", (PyCFunction) PythonCalculateGammonPrice, METH_O,
      "return cube-info with updated gammon prices\n"
      "    arguments: [cube-info dictionary]\n"
@@ -3196,6 +4609,37 @@ static PyMethodDef gnubgMethods[] = {
      "classify a position for a given backammon variant and board\n"
      "    arguments: [board], [int variant]\n" "    returns: int posclass"}
     ,
+    {"netinputs", PythonNetInputs, METH_VARARGS,
+     "Inputs of the neural nets for many positions at once, spread over\n"
+     "the threads, for training nets elsewhere\n"
+     "    arguments: boards [net] [inputs] [classes]\n"
+     "         boards: as for 'evaluate_many'\n"
+     "         net: \"contact\", \"crashed\", \"race\", or \"auto\" (the\n"
+     "         default) for the net of each board's class, with the race\n"
+     "         inputs padded with zeros\n"
+     "         inputs: writable n x m float32 array to fill, m being 250\n"
+     "         (214 for the race net)\n"
+     "         classes: writable n int32 or uint32 array to fill with the\n"
+     "         classes of the boards, as 'classifypos' gives them\n"
+     "    returns (inputs, classes), new memoryviews for those not given"}
+    ,
+    {"scoregrid", PythonScoreGrid, METH_VARARGS,
+     "Cube decision and best move of many positions at every score of\n"
+     "matches up to a length, spread over the threads\n"
+     "    arguments: ids [max away] [cube eval context] [chequer eval context]\n"
+     "         ids: GNU Backgammon IDs, \"position ID:match ID\", or\n"
+     "         position IDs for a centred cube and no dice\n"
+     "         max away: the longest away score, 25 by default\n"
+     "    returns for each ID a list of tuples (int away, int opponent away,\n"
+     "         String action, floats nodouble, take, drop, String best move,\n"
+     "         float its equity), the move None without dice"}
+    ,
+    {"presets", PythonPresets, METH_VARARGS,
+     "The named evaluation settings, see 'set preset'; their names or\n"
+     "numbers may be given instead of an eval context\n"
+     "    returns: list of tuples (String name, chequer eval context,\n"
+     "         cube eval context, move filters), by number"}
+    ,
     {"dicerolls", PythonDiceRolls, METH_VARARGS,
      "return a list of dice rolls from current RNG\n"
      "   arguments: number of rolls\n" "    returns: list of tuples (2 elements each, one for each die)\n"}
@@ -3207,6 +4651,54 @@ static PyMethodDef gnubgMethods[] = {
      "    returns tuple(floats P(win), P(win gammon), P(win backgammnon)\n"
      "         P(lose gammon), P(lose backgammon), cubeless equity)"}
     ,
+    {"evaluate_many", PythonEvaluateMany, METH_VARARGS,
+     "Cubeless evaluation of many positions at once, spread over the threads\n"
+     "    arguments: boards [cube-info] [eval context]\n"
+     "         boards: sequence of boards, or an array of n x 2 x 25\n"
+     "         integers (a numpy uint8 array, say)\n"
+     "    returns n x 6 floats, for each board as for 'evaluate'\n"
+     "         (a memoryview that numpy.asarray() takes without copying)"}
+    ,
+    {"evaluate_async", PythonEvaluateAsync, METH_VARARGS,
+     "Start an 'evaluate' in the background\n"
+     "    arguments: [board] [cube-info] [eval context]\n"
+     "    returns: job number, see 'job_status' and 'job_result'"}
+    ,
+    {"hint_async", PythonHintAsync, METH_VARARGS,
+     "Start finding the best moves of a roll in the background\n"
+     "    arguments: board, tuple (die, die) [cube-info] [eval context]\n"
+     "         [max moves]\n"
+     "    returns: job number; its result is a list of dictionaries with\n"
+     "         the move, its equity and probabilities, best first"}
+    ,
+    {"rollout_async", PythonRolloutAsync, METH_VARARGS,
+     "Start a rollout of a position in the background, with the\n"
+     "    settings of 'set rollout'\n"
+     "    arguments: [board] [cube-info] [trials] [truncation plies, 0 for none]\n"
+     "    returns: job number; its result is a dictionary of the trials\n"
+     "         played and tuples of the mean and standard error of the\n"
+     "         7 rollout outputs"}
+    ,
+    {"job_status", PythonJobStatus, METH_VARARGS,
+     "Poll a job started by one of the '_async' functions\n"
+     "    arguments: job number\n"
+     "    returns: dictionary of done, cancelled, failed and progress (0 to 1);\n"
+     "         for rollouts, 'rollout' has the results so far"}
+    ,
+    {"job_wait", PythonJobWaitPy, METH_VARARGS,
+     "Wait for a job, without holding up the other Python threads\n"
+     "    arguments: job number [timeout in seconds]\n"
+     "    returns: True if it is done (run it in an executor to await it)"}
+    ,
+    {"job_cancel", PythonJobCancel, METH_VARARGS,
+     "Stop a job; a rollout keeps the trials it has played\n"
+     "    arguments: job number\n" "    returns: None"}
+    ,
+    {"job_result", PythonJobResult, METH_VARARGS,
+     "Wait for a job and get its result; the job number is free afterwards\n"
+     "    arguments: job number\n"
+     "    returns: as for the function that started it"}
+    ,
     {"evalcontext", PythonEvalContext, METH_VARARGS,
      "make an evalcontext\n"
      "    argument: [tuple ( 5 int, float )]\n" "    returns:  eval-context ( see 'cfevaluate' )"}
@@ -3231,7 +4723,9 @@ static PyMethodDef gnubgMethods[] = {
      "    returns: tuple( ints point from, point to, \n" "        unused moves are set to zero"}
     ,
     {"hint", PythonHint, METH_VARARGS,
-     "    arguments: [max moves]\n" "    returns: hint dictionary\n"}
+     "    arguments: [max moves], [progress]\n"
+     "    progress: callable given the plies and the hint list of each\n"
+     "         move filter stage as soon as it is done\n" "    returns: hint dictionary\n"}
     ,
     {"mwc2eq", PythonMwc2eq, METH_VARARGS,
      "convert MWC to equity\n"
@@ -3313,6 +4807,19 @@ static PyMethodDef gnubgMethods[] = {
     {"positionfromkey", PythonPositionFromKey, METH_VARARGS,
      "return position from key\n" "    arguments: [ list of 10 ints] \n" "    returns: board ( see 'cfevaluate' )"}
     ,
+    {"positionkeysfromids", PythonPositionKeysFromIDs, METH_VARARGS,
+     "return the packed keys of many position IDs at once\n"
+     "    arguments: IDs as a sequence of strings, or as one block of\n"
+     "       characters (bytes, numpy array) [ distance between IDs,\n"
+     "       14 if they follow each other ]\n"
+     "    returns: n x 7 unsigned ints, all 0 for an invalid ID\n"
+     "       (a memoryview that numpy.asarray() takes without copying)"}
+    ,
+    {"positionidsfromkeys", PythonPositionIDsFromKeys, METH_VARARGS,
+     "return the position IDs of many packed keys at once\n"
+     "    arguments: n x 7 unsigned ints, as 'positionkeysfromids' returns\n"
+     "    returns: string of the n IDs one after the other"}
+    ,
     {"match", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonMatch, METH_VARARGS | METH_KEYWORDS,
      "Get the current match\n"
      "    arguments: [ include-analysis = 0/1, include-boards = 0/1,\n"
@@ -3414,6 +4921,9 @@ static char *python_dir = NULL;
 #endif
 
 static PyObject *py_gnubg_module = NULL;
+static char *szPythonArgv0 = NULL;
+static int fPythonStarted = FALSE;
+static int fPythonLazy = FALSE;
 
 #if !defined(WIN32)
 extern gint
@@ -3445,6 +4955,7 @@ python_run_file(gpointer file)
 extern PyObject *
 PythonGnubgModule(void)
 {
+    PythonEnsure();
     return py_gnubg_module;
 }
 
@@ -3461,9 +4972,12 @@ MOD_INIT(gnubg)
     return MOD_SUCCESS_VAL(module);
 }
 
-extern void
-PythonInitialise(char *argv0)
+/* Start the interpreter and run the start up scripts */
+static void
+PythonStart(void)
 {
+    char *argv0 = szPythonArgv0;
+    guint64 t = get_time_ns();
 #if PY_MAJOR_VERSION >= 3
     wchar_t progname[FILENAME_MAX + 1];
     mbstowcs(progname, argv0, strlen(argv0) + 1);
@@ -3504,6 +5018,7 @@ PythonInitialise(char *argv0)
     PyImport_AppendInittab("gnubg", &initgnubg);
 #endif
 
+    pgtMain = g_thread_self();
     Py_Initialize();
 
     /* ensure that python know about our gnubg module */
@@ -3514,6 +5029,34 @@ PythonInitialise(char *argv0)
     LoadPythonFile("gnubg_user.py", TRUE);
 
     py_gnubg_module = PyImport_AddModule("__main__");
+
+    if (fPythonLazy)
+        ProfileStartup(N_("Python"), get_time_ns() - t, TRUE);
+}
+
+/* Start Python if it hasn't been, from the main thread */
+extern void
+PythonEnsure(void)
+{
+    if (fPythonStarted)
+        return;
+
+    /* Set first: the start up scripts come back through
+     * LoadPythonFile() */
+    fPythonStarted = TRUE;
+    PythonStart();
+}
+
+/* With fLazy, Python is only started by the first script, shell or
+ * database access */
+extern void
+PythonInitialise(char *argv0, int fLazy)
+{
+    szPythonArgv0 = g_strdup(argv0);
+    fPythonLazy = fLazy;
+
+    if (!fLazy)
+        PythonEnsure();
 }
 
 extern void
@@ -3526,8 +5069,15 @@ PythonShutdown(void)
     }
 #endif
 
+    g_free(szPythonArgv0);
+    szPythonArgv0 = NULL;
+
+    if (!fPythonStarted)
+        return;
+
     py_gnubg_module = NULL;
     Py_Finalize();
+    fPythonStarted = FALSE;
 }
 
 extern void
@@ -3538,6 +5088,8 @@ PythonRun(const char *sz)
     int success = FALSE;
 #endif
 
+    PythonEnsure();
+
     if (sz && *sz) {
         PyRun_SimpleString(sz);
     } else {
@@ -3575,6 +5127,8 @@ LoadPythonFile(const char *sz, int fQuiet)
     char *escpath = NULL;
     int ret = FALSE;
 
+    PythonEnsure();
+
     if (g_file_test(sz, G_FILE_TEST_EXISTS))
         path = g_strdup(sz);
     else {
@@ -37,7 +37,8 @@ extern PyObject *PythonGnubgModule(void);
 
 #include <glib.h>
 
-extern void PythonInitialise(char *argv0);
+extern void PythonInitialise(char *argv0, int fLazy);
+extern void PythonEnsure(void);
 extern void PythonShutdown(void);
 extern void PythonRun(const char *sz);
 extern int LoadPythonFile(const char *sz, int fQuiet);
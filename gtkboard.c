@@ -316,34 +316,10 @@ board_draw_area(cairo_t * cr, gint x, gint y, gint cx, gint cy, BoardData * bd)
     free(puch);
 }
 
-#if GTK_CHECK_VERSION(3,0,0)
-static gboolean
-board_draw(GtkWidget * drawing_area, cairo_t * cr, BoardData * bd)
-{
-    if (bd->rd->nSize == 0)
-        return TRUE;
-
-    board_draw_area(cr, 0, 0, gtk_widget_get_allocated_width(drawing_area),
-                    gtk_widget_get_allocated_height(drawing_area), bd);
-    return TRUE;
-}
-#else
-static gboolean
-board_expose(GtkWidget * drawing_area, GdkEventExpose * event, BoardData * bd)
+/* Render one dirty rectangle of the board, clipped to it */
+static void
+board_draw_rect(cairo_t * cr, int x, int y, int cx, int cy, BoardData * bd)
 {
-    int x, y, cx, cy;
-    cairo_t *cr;
-
-    g_assert(GTK_IS_DRAWING_AREA(drawing_area));
-
-    if (bd->rd->nSize == 0)
-        return TRUE;
-
-    x = event->area.x;
-    y = event->area.y;
-    cx = event->area.width;
-    cy = event->area.height;
-
     if (x < 0) {
         cx += x;
         x = 0;
@@ -361,12 +337,63 @@ board_expose(GtkWidget * drawing_area, GdkEventExpose * event, BoardData * bd)
         cx = BOARD_WIDTH * bd->rd->nSize - x;
 
     if (cx <= 0 || cy <= 0)
+        return;
+
+    board_draw_area(cr, x, y, cx, cy, bd);
+}
+
+/* Only the rectangles invalidated by the board_invalidate_*()
+ * functions are rendered, not their bounding box or the whole board,
+ * so moving a chequer or turning the cube redraws just those parts */
+#if GTK_CHECK_VERSION(3,0,0)
+static gboolean
+board_draw(GtkWidget * UNUSED(drawing_area), cairo_t * cr, BoardData * bd)
+{
+    cairo_rectangle_list_t *prl;
+    GdkRectangle r;
+    int i;
+
+    if (bd->rd->nSize == 0)
+        return TRUE;
+
+    prl = cairo_copy_clip_rectangle_list(cr);
+
+    if (prl->status == CAIRO_STATUS_SUCCESS) {
+        for (i = 0; i < prl->num_rectangles; i++) {
+            const cairo_rectangle_t *pr = prl->rectangles + i;
+            int x = (int) floor(pr->x), y = (int) floor(pr->y);
+
+            board_draw_rect(cr, x, y, (int) ceil(pr->x + pr->width) - x, (int) ceil(pr->y + pr->height) - y, bd);
+        }
+    } else if (gdk_cairo_get_clip_rectangle(cr, &r))
+        board_draw_rect(cr, r.x, r.y, r.width, r.height, bd);
+
+    cairo_rectangle_list_destroy(prl);
+
+    return TRUE;
+}
+#else
+static gboolean
+board_expose(GtkWidget * drawing_area, GdkEventExpose * event, BoardData * bd)
+{
+    GdkRectangle *ar;
+    gint i, n;
+    cairo_t *cr;
+
+    g_assert(GTK_IS_DRAWING_AREA(drawing_area));
+
+    if (bd->rd->nSize == 0)
         return TRUE;
 
+    gdk_region_get_rectangles(event->region, &ar, &n);
+
     cr = gdk_cairo_create(gtk_widget_get_window(drawing_area));
-    board_draw_area(cr, x, y, cx, cy, bd);
+    for (i = 0; i < n; i++)
+        board_draw_rect(cr, ar[i].x, ar[i].y, ar[i].width, ar[i].height, bd);
     cairo_destroy(cr);
 
+    g_free(ar);
+
     return TRUE;
 }
 #endif
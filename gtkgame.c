@@ -640,6 +640,7 @@ static guint idOutput, idProgress;
 int fTTY = TRUE;
 int fGUISetWindowPos = TRUE;
 int frozen = FALSE;
+int fHoldGames = FALSE;
 static GString *output_str = NULL;
 static int fullScreenOnStartup = FALSE;
 
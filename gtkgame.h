@@ -51,6 +51,7 @@ extern guint nNextTurn;         /* GTK idle function */
 extern int fEndDelay;
 extern int fNeedPrompt;
 extern int frozen;
+extern int fHoldGames;          /* a match is loading behind its first game */
 extern int fTTY;
 extern int fX;
 extern int fToolbarShowing;
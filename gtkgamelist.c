@@ -37,6 +37,16 @@ static GtkListStore *plsGameList;
 static GtkWidget *pwGameList;
 static GtkStyle *psGameList, *psCurrent, *psCubeErrors[3], *psChequerErrors[3], *psLucky[N_LUCKS];
 
+/* The styles of the cells of the moves, made as the cells are shown,
+ * by luck, chequer play and cube skill */
+static GtkStyle *apsCell[N_LUCKS][N_SKILLS][N_SKILLS];
+
+/* The row of each moverecord in the list, counting from 1 */
+static GHashTable *phtRows;
+
+/* The highlighted cell, -1 if there is none */
+static int iCurrentRow = -1, fCurrentPlayer = -1;
+
 static int
 gtk_compare_fonts(GtkStyle * psOne, GtkStyle * psTwo)
 {
@@ -56,8 +66,6 @@ enum ListStoreColumns {
     GL_COL_MOVE_STRING_1,
     GL_COL_MOVE_RECORD_0,
     GL_COL_MOVE_RECORD_1,
-    GL_COL_STYLE_0,
-    GL_COL_STYLE_1,
     GL_COL_COMBINED,
     GL_COL_NUM_COLUMNS
 };
@@ -66,6 +74,8 @@ extern void
 GTKClearMoveRecord(void)
 {
     gtk_list_store_clear(plsGameList);
+    g_hash_table_remove_all(phtRows);
+    iCurrentRow = fCurrentPlayer = -1;
 }
 
 static void
@@ -82,6 +92,9 @@ GameListSelectRow(GtkTreeView * tree_view, gpointer UNUSED(p))
     int *pPlayer;
     listOLD *pl;
 
+    if (fHoldGames)
+        return;
+
     gtk_tree_view_get_cursor(tree_view, &path, &column);
     if (!path)
         return;
@@ -240,33 +253,94 @@ GetStyleFromRCFile(GtkStyle ** ppStyle, const char *name, GtkStyle * psBase)
     g_object_unref(G_OBJECT(temp));
 }
 
+static void
+AddStyle(GtkStyle ** ppsComb, GtkStyle * psNew)
+{
+    if (!*ppsComb) {
+        *ppsComb = psNew;
+        g_object_ref(*ppsComb);
+    } else {
+        GtkStyle *copy = gtk_style_copy(*ppsComb);
+        g_object_unref(*ppsComb);
+        *ppsComb = copy;
+        UpdateStyle(*ppsComb, psNew, psGameList);
+    }
+}
+
+/* The style of the cell of pmr, not referenced */
+static GtkStyle *
+GetCellStyle(const moverecord * pmr)
+{
+    GtkStyle **ppStyle;
+
+    if (!fStyledGamelist)
+        return psGameList;
+
+    ppStyle = &apsCell[pmr->lt][pmr->n.stMove][pmr->stCube];
+
+    if (!*ppStyle) {
+        if (pmr->lt == LUCK_VERYGOOD)
+            AddStyle(ppStyle, psLucky[LUCK_VERYGOOD]);
+        else if (pmr->lt == LUCK_VERYBAD)
+            AddStyle(ppStyle, psLucky[LUCK_VERYBAD]);
+
+        if (pmr->n.stMove == SKILL_DOUBTFUL)
+            AddStyle(ppStyle, psChequerErrors[SKILL_DOUBTFUL]);
+        if (pmr->stCube == SKILL_DOUBTFUL)
+            AddStyle(ppStyle, psCubeErrors[SKILL_DOUBTFUL]);
+
+        if (pmr->n.stMove == SKILL_BAD)
+            AddStyle(ppStyle, psChequerErrors[SKILL_BAD]);
+        if (pmr->stCube == SKILL_BAD)
+            AddStyle(ppStyle, psCubeErrors[SKILL_BAD]);
+
+        if (pmr->n.stMove == SKILL_VERYBAD)
+            AddStyle(ppStyle, psChequerErrors[SKILL_VERYBAD]);
+        if (pmr->stCube == SKILL_VERYBAD)
+            AddStyle(ppStyle, psCubeErrors[SKILL_VERYBAD]);
+
+        if (!*ppStyle)
+            AddStyle(ppStyle, psGameList);
+    }
+
+    return *ppStyle;
+}
+
+/* The cells are styled as they are drawn, from the moverecords as they
+ * are then, so the list costs the same whatever its length and shows
+ * an analysis as soon as it is done */
 static void
 RenderMoveString(GtkTreeViewColumn * tree_column, GtkCellRenderer * cell, GtkTreeModel * tree_model,
                  GtkTreeIter * iter, gpointer UNUSED(p))
 {
     gchar *moveString;
+    moverecord *pmr;
     GtkStyle *style;
+    int moveNum;
     int *pPlayer = g_object_get_data(G_OBJECT(tree_column), "player");
 
-    gtk_tree_model_get(tree_model, iter, GL_COL_MOVE_STRING_0 + *pPlayer, &moveString,
-                       GL_COL_STYLE_0 + *pPlayer, &style, -1);
-    if (!style) {
+    gtk_tree_model_get(tree_model, iter, GL_COL_MOVE_NUMBER, &moveNum, GL_COL_MOVE_STRING_0 + *pPlayer, &moveString,
+                       GL_COL_MOVE_RECORD_0 + *pPlayer, &pmr, -1);
+
+    if (moveNum - 1 == iCurrentRow && *pPlayer == fCurrentPlayer)
+        style = psCurrent;
+    else if (pmr)
+        style = GetCellStyle(pmr);
+    else
         style = psGameList;
-        g_object_ref(style);
-    }
 
     g_object_set(cell, "text", moveString, "background-gdk", &style->base[GTK_STATE_NORMAL],
                  "foreground-gdk", &style->fg[GTK_STATE_NORMAL], "font-desc", style->font_desc, NULL);
 
     if (moveString)
         g_free(moveString);
-    g_object_unref(style);
 }
 
 static void
 CreateStyles(GtkWidget * UNUSED(widget), gpointer UNUSED(p))
 {
     GtkStyle *ps;
+    int i;
 
     gtk_widget_ensure_style(pwGameList);
     GetStyleFromRCFile(&ps, "gnubg", gtk_widget_get_style(pwGameList));
@@ -295,6 +369,13 @@ CreateStyles(GtkWidget * UNUSED(widget), gpointer UNUSED(p))
 
     GetStyleFromRCFile(&psLucky[LUCK_VERYBAD], "gamelist-luck-bad", psGameList);
     GetStyleFromRCFile(&psLucky[LUCK_VERYGOOD], "gamelist-luck-good", psGameList);
+
+    /* the cells get their styles afresh */
+    for (i = 0; i < N_LUCKS * N_SKILLS * N_SKILLS; i++)
+        if ((&apsCell[0][0][0])[i]) {
+            g_object_unref((&apsCell[0][0][0])[i]);
+            (&apsCell[0][0][0])[i] = NULL;
+        }
 }
 
 extern GtkWidget *
@@ -309,7 +390,9 @@ GL_Create(void)
     int i;
 
     plsGameList = gtk_list_store_new(GL_COL_NUM_COLUMNS, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING,
-                                     G_TYPE_POINTER, G_TYPE_POINTER, G_TYPE_OBJECT, G_TYPE_OBJECT, G_TYPE_BOOLEAN);
+                                     G_TYPE_POINTER, G_TYPE_POINTER, G_TYPE_BOOLEAN);
+    phtRows = g_hash_table_new(g_direct_hash, g_direct_equal);
+    iCurrentRow = fCurrentPlayer = -1;
 
     pwGameList = gtk_tree_view_new_with_model(GTK_TREE_MODEL(plsGameList));
     gtk_tree_view_set_headers_clickable(GTK_TREE_VIEW(pwGameList), FALSE);
@@ -362,59 +445,6 @@ GL_Create(void)
     return pwGameList;
 }
 
-static void
-AddStyle(GtkStyle ** ppsComb, GtkStyle * psNew)
-{
-    if (!*ppsComb) {
-        *ppsComb = psNew;
-        g_object_ref(*ppsComb);
-    } else {
-        GtkStyle *copy = gtk_style_copy(*ppsComb);
-        g_object_unref(*ppsComb);
-        *ppsComb = copy;
-        UpdateStyle(*ppsComb, psNew, psGameList);
-    }
-}
-
-static void
-SetCellStyle(GtkTreeIter * iter, int fPlayer, moverecord * pmr)
-{
-    GtkStyle *pStyle = NULL;
-
-    if (fStyledGamelist) {
-        if (pmr->lt == LUCK_VERYGOOD) {
-            pStyle = psLucky[LUCK_VERYGOOD];
-            g_object_ref(pStyle);
-        } else if (pmr->lt == LUCK_VERYBAD) {
-            pStyle = psLucky[LUCK_VERYBAD];
-            g_object_ref(pStyle);
-        }
-
-        if (pmr->n.stMove == SKILL_DOUBTFUL)
-            AddStyle(&pStyle, psChequerErrors[SKILL_DOUBTFUL]);
-        if (pmr->stCube == SKILL_DOUBTFUL)
-            AddStyle(&pStyle, psCubeErrors[SKILL_DOUBTFUL]);
-
-        if (pmr->n.stMove == SKILL_BAD)
-            AddStyle(&pStyle, psChequerErrors[SKILL_BAD]);
-        if (pmr->stCube == SKILL_BAD)
-            AddStyle(&pStyle, psCubeErrors[SKILL_BAD]);
-
-        if (pmr->n.stMove == SKILL_VERYBAD)
-            AddStyle(&pStyle, psChequerErrors[SKILL_VERYBAD]);
-        if (pmr->stCube == SKILL_VERYBAD)
-            AddStyle(&pStyle, psCubeErrors[SKILL_VERYBAD]);
-    }
-
-    if (!pStyle) {
-        pStyle = psGameList;
-        g_object_ref(pStyle);
-    }
-
-    gtk_list_store_set(plsGameList, iter, GL_COL_STYLE_0 + fPlayer, pStyle, -1);
-    g_object_unref(pStyle);
-}
-
 /* Add a moverecord to the game list window.  NOTE: This function must be
  * called _before_ applying the moverecord, so it can be displayed
  * correctly. */
@@ -425,15 +455,18 @@ GTKAddMoveRecord(moverecord * pmr)
     gboolean fCombined = TRUE;
     int fPlayer, moveNum = 0;
     GtkTreeIter iter;
-    const char *pch = GetMoveString(pmr, &fPlayer, TRUE);
-    if (!pch)
+    const char *pch;
+
+    /* the list keeps showing the first game of a match being loaded */
+    if (fHoldGames)
         return;
 
-    if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(plsGameList), &iter)) {
-        GtkTreeIter next = iter;
-        while (gtk_tree_model_iter_next(GTK_TREE_MODEL(plsGameList), &next))
-            iter = next;
+    if (!(pch = GetMoveString(pmr, &fPlayer, TRUE)))
+        return;
 
+    /* the last row, without walking the list */
+    if ((moveNum = gtk_tree_model_iter_n_children(GTK_TREE_MODEL(plsGameList), NULL)) > 0) {
+        gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(plsGameList), &iter, NULL, moveNum - 1);
         gtk_tree_model_get(GTK_TREE_MODEL(plsGameList), &iter, GL_COL_MOVE_NUMBER, &moveNum, GL_COL_MOVE_RECORD_0,
                            &apmr[0], GL_COL_MOVE_RECORD_1, &apmr[1], GL_COL_COMBINED, &fCombined, -1);
     }
@@ -453,7 +486,7 @@ GTKAddMoveRecord(moverecord * pmr)
     gtk_list_store_set(plsGameList, &iter, GL_COL_MOVE_NUMBER, moveNum, GL_COL_MOVE_STRING_0 + fPlayer, pch,
                        GL_COL_MOVE_RECORD_0 + fPlayer, pmr, GL_COL_COMBINED, fCombined, -1);
 
-    SetCellStyle(&iter, fPlayer, pmr);
+    g_hash_table_insert(phtRows, pmr, GINT_TO_POINTER(moveNum));
 }
 
 
@@ -464,12 +497,13 @@ GTKSetMoveRecord(moverecord * pmr)
 {
 
     /* highlighted row/col in game record */
-    static GtkTreePath *path = NULL;
-    static int fPlayer = -1;
+    GtkTreePath *path = NULL;
+    int fPlayer = -1;
 
     GtkTreeIter iter;
     moverecord *apmr[2];
     gboolean iterValid, lastRow = FALSE;
+    int iRow;
     /* Avoid lots of screen updates */
     if (!frozen)
         SetAnnotation(pmr);
@@ -485,23 +519,9 @@ GTKSetMoveRecord(moverecord * pmr)
     }
 #endif
 
-    if (path && fPlayer != -1) {
-        moverecord *pmrLast = NULL;
-        if (gtk_tree_model_get_iter(GTK_TREE_MODEL(plsGameList), &iter, path)) {
-            gtk_tree_model_get(GTK_TREE_MODEL(plsGameList), &iter, GL_COL_MOVE_RECORD_0, &apmr[0],
-                               GL_COL_MOVE_RECORD_1, &apmr[1], -1);
-            pmrLast = apmr[fPlayer];
-            if (pmrLast)
-                SetCellStyle(&iter, fPlayer, pmrLast);
-            else
-                gtk_list_store_set(plsGameList, &iter, GL_COL_STYLE_0 + fPlayer, psGameList, -1);
-        }
-    }
-
-    if (path)
-        gtk_tree_path_free(path);
-    path = NULL;
-    fPlayer = -1;
+    /* the cells are drawn with the highlight moved */
+    iCurrentRow = fCurrentPlayer = -1;
+    gtk_widget_queue_draw(pwGameList);
 
     if (!pmr)
         return;
@@ -520,24 +540,16 @@ GTKSetMoveRecord(moverecord * pmr)
         } else
             fPlayer = 0;
     } else {
-        iterValid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(plsGameList), &iter);
-        while (iterValid) {
+        iRow = GPOINTER_TO_INT(g_hash_table_lookup(phtRows, pmr));
+        iterValid = iRow && gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(plsGameList), &iter, NULL, iRow - 1);
+
+        if (iterValid) {
             gtk_tree_model_get(GTK_TREE_MODEL(plsGameList), &iter, GL_COL_MOVE_RECORD_0, &apmr[0],
                                GL_COL_MOVE_RECORD_1, &apmr[1], -1);
-            if (apmr[1] == pmr) {
-                fPlayer = 1;
-                break;
-            } else if (apmr[0] == pmr) {
-                fPlayer = 0;
-                break;
-            }
-            iterValid = gtk_tree_model_iter_next(GTK_TREE_MODEL(plsGameList), &iter);
-        }
+            fPlayer = apmr[1] == pmr ? 1 : 0;
 
-        if (iterValid) {
             path = gtk_tree_model_get_path(GTK_TREE_MODEL(plsGameList), &iter);
-            lastRow = !gtk_tree_model_iter_next(GTK_TREE_MODEL(plsGameList), &iter);
-            gtk_tree_model_get_iter(GTK_TREE_MODEL(plsGameList), &iter, path);
+            lastRow = iRow == gtk_tree_model_iter_n_children(GTK_TREE_MODEL(plsGameList), NULL);
         }
 
         if (path && !(pmr->mt == MOVE_SETDICE && lastRow)) {
@@ -565,34 +577,50 @@ GTKSetMoveRecord(moverecord * pmr)
     }
 
     /* Highlight current move */
-    if (path && gtk_tree_model_get_iter(GTK_TREE_MODEL(plsGameList), &iter, path)) {
-        gtk_list_store_set(plsGameList, &iter, GL_COL_STYLE_0 + fPlayer, psCurrent, -1);
+    if (path) {
+        iCurrentRow = *gtk_tree_path_get_indices(path);
+        fCurrentPlayer = fPlayer;
         gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(pwGameList), path, NULL, TRUE, 0.8f, 0.5f);
+        gtk_tree_path_free(path);
     }
 }
 
+/* Take the rows from the one of iter to the end off the list */
+static void
+RemoveRows(GtkTreeIter * iter)
+{
+    moverecord *apmr[2];
+
+    do {
+        gtk_tree_model_get(GTK_TREE_MODEL(plsGameList), iter, GL_COL_MOVE_RECORD_0, &apmr[0],
+                           GL_COL_MOVE_RECORD_1, &apmr[1], -1);
+        g_hash_table_remove(phtRows, apmr[0]);
+        g_hash_table_remove(phtRows, apmr[1]);
+    } while (gtk_list_store_remove(plsGameList, iter));
+}
+
 extern void
 GTKPopMoveRecord(moverecord * const pmr)
 {
     GtkTreeIter iter;
-    gboolean iterValid, recordFound = FALSE;
     moverecord *apmr[2];
+    int iRow = GPOINTER_TO_INT(g_hash_table_lookup(phtRows, pmr));
 
-    iterValid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(plsGameList), &iter);
-    while (iterValid) {
-        gtk_tree_model_get(GTK_TREE_MODEL(plsGameList), &iter, GL_COL_MOVE_RECORD_0, &apmr[0],
-                           GL_COL_MOVE_RECORD_1, &apmr[1], -1);
-        if (apmr[0] == pmr || recordFound) {
-            /* the left column matches; delete the row */
-            iterValid = gtk_list_store_remove(plsGameList, &iter);
-            recordFound = TRUE;
-        } else if (apmr[1] == pmr) {
-            /* the right column matches; delete that column only */
-            gtk_list_store_set(plsGameList, &iter, GL_COL_MOVE_STRING_1, NULL,
-                               GL_COL_MOVE_RECORD_1, NULL, GL_COL_STYLE_1, NULL, -1);
-            iterValid = gtk_tree_model_iter_next(GTK_TREE_MODEL(plsGameList), &iter);
-            recordFound = TRUE;
-        } else
-            iterValid = gtk_tree_model_iter_next(GTK_TREE_MODEL(plsGameList), &iter);
+    if (!iRow || !gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(plsGameList), &iter, NULL, iRow - 1))
+        return;
+
+    gtk_tree_model_get(GTK_TREE_MODEL(plsGameList), &iter, GL_COL_MOVE_RECORD_0, &apmr[0],
+                       GL_COL_MOVE_RECORD_1, &apmr[1], -1);
+
+    if (apmr[0] == pmr)
+        /* the left column matches; delete the row and those after */
+        RemoveRows(&iter);
+    else {
+        /* the right column matches; delete that column only, and the
+         * rows after */
+        g_hash_table_remove(phtRows, pmr);
+        gtk_list_store_set(plsGameList, &iter, GL_COL_MOVE_STRING_1, NULL, GL_COL_MOVE_RECORD_1, NULL, -1);
+        if (gtk_tree_model_iter_next(GTK_TREE_MODEL(plsGameList), &iter))
+            RemoveRows(&iter);
     }
 }
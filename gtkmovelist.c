@@ -27,9 +27,6 @@
 #include "gtkmovelistctrl.h"
 #include "drawboard.h"
 
-#define DETAIL_COLUMN_COUNT 11
-#define MIN_COLUMN_COUNT 5
-
 enum {
     ML_COL_RANK = 0,
     ML_COL_TYPE,
@@ -41,11 +38,96 @@ enum {
     ML_COL_BGLOSS,
     ML_COL_EQUITY,
     ML_COL_DIFF,
-    ML_COL_MOVE,
-    ML_COL_FGCOL,
-    ML_COL_DATA
+    ML_COL_MOVE
 };
 
+float rBest;
+
+GtkStyle *psHighlight = NULL;
+
+/* Draw the text of a cell from the move of its row.  Like the
+ * custom renderer of the detailed view, only the rows on show are
+ * formatted, so a long list costs no more than a short one. */
+static void
+RenderMoveListCell(GtkTreeViewColumn * column, GtkCellRenderer * cell, GtkTreeModel * model,
+                   GtkTreeIter * iter, gpointer p)
+{
+    const hintdata *phd = (const hintdata *) p;
+    int nColumn = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(column), "movelist-column"));
+    move *pm;
+    unsigned int i;
+    int fHighlight;
+    char sz[32], szColour[20];
+    const char *pch = NULL;
+    cubeinfo ci;
+
+    gtk_tree_model_get(model, iter, 0, &pm, -1);
+    if (!pm) {
+        g_object_set(cell, "text", NULL, "foreground", NULL, NULL);
+        return;
+    }
+
+    i = (unsigned int) (pm - phd->pml->amMoves);
+    fHighlight = phd->piHighlight && *phd->piHighlight == i;
+
+    switch (nColumn) {
+    case ML_COL_RANK:
+        if (i + 1 == GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(phd->pwMoves), "unknown-rank")))
+            sprintf(sz, "%s%s??", pm->cmark ? "+" : "", fHighlight ? "*" : "");
+        else
+            sprintf(sz, "%s%s%u", pm->cmark ? "+" : "", fHighlight ? "*" : "", i + 1);
+        pch = sz;
+        break;
+    case ML_COL_TYPE:
+        FormatEval(sz, &pm->esMove);
+        pch = sz;
+        break;
+    case ML_COL_WIN:
+    case ML_COL_GWIN:
+    case ML_COL_BGWIN:
+        pch = OutputPercent(pm->arEvalMove[nColumn - ML_COL_WIN]);
+        break;
+    case ML_COL_LOSS:
+        pch = OutputPercent(1.0f - pm->arEvalMove[OUTPUT_WIN]);
+        break;
+    case ML_COL_GLOSS:
+    case ML_COL_BGLOSS:
+        pch = OutputPercent(pm->arEvalMove[nColumn - ML_COL_WIN - 1]);
+        break;
+    case ML_COL_EQUITY:
+        GetMatchStateCubeInfo(&ci, &ms);
+        pch = OutputEquity(pm->rScore, &ci, TRUE);
+        break;
+    case ML_COL_DIFF:
+        GetMatchStateCubeInfo(&ci, &ms);
+        if (i != 0)
+            pch = OutputEquityDiff(pm->rScore, rBest, &ci);
+        break;
+    case ML_COL_MOVE:
+        pch = FormatMove(sz, msBoard(), pm->anMove);
+        break;
+    }
+
+    /* highlight row */
+    if (fHighlight)
+        sprintf(szColour, "#%02x%02x%02x", psHighlight->fg[GTK_STATE_SELECTED].red / 256,
+                psHighlight->fg[GTK_STATE_SELECTED].green / 256, psHighlight->fg[GTK_STATE_SELECTED].blue / 256);
+
+    g_object_set(cell, "text", pch, "foreground", fHighlight ? szColour : NULL, NULL);
+}
+
+static void
+MoveListAddColumn(GtkWidget * view, const char *szTitle, GtkCellRenderer * renderer, int nColumn, hintdata * phd)
+{
+    GtkTreeViewColumn *column = gtk_tree_view_column_new();
+
+    gtk_tree_view_column_set_title(column, szTitle);
+    gtk_tree_view_column_pack_start(column, renderer, TRUE);
+    g_object_set_data(G_OBJECT(column), "movelist-column", GINT_TO_POINTER(nColumn));
+    gtk_tree_view_column_set_cell_data_func(column, renderer, RenderMoveListCell, phd, NULL);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
 extern void
 MoveListCreate(hintdata * phd)
 {
@@ -70,7 +152,6 @@ MoveListCreate(hintdata * phd)
     GtkTreeIter iter;
     GtkTreeSelection *sel;
     GtkWidget *view = gtk_tree_view_new();
-    int offset = (phd->fDetails) ? 0 : MIN_COLUMN_COUNT - DETAIL_COLUMN_COUNT;
 
     if (showWLTree) {
         GtkStyle *psDefault = gtk_widget_get_style(view);
@@ -87,41 +168,19 @@ MoveListCreate(hintdata * phd)
         GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
         g_object_set(renderer, "ypad", 0, NULL);
 
-        gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_RANK]), renderer,
-                                                    "text", ML_COL_RANK, "foreground", ML_COL_FGCOL + offset, NULL);
-        gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, Q_(aszTitleDetails[ML_COL_TYPE]), renderer,
-                                                    "text", ML_COL_TYPE, "foreground", ML_COL_FGCOL + offset, NULL);
+        MoveListAddColumn(view, _(aszTitleDetails[ML_COL_RANK]), renderer, ML_COL_RANK, phd);
+        MoveListAddColumn(view, Q_(aszTitleDetails[ML_COL_TYPE]), renderer, ML_COL_TYPE, phd);
 
         if (phd->fDetails) {
-            gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_WIN]),
-                                                        renderer, "text", ML_COL_WIN, "foreground",
-                                                        ML_COL_FGCOL + offset, NULL);
-            gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_GWIN]),
-                                                        renderer, "text", ML_COL_GWIN, "foreground",
-                                                        ML_COL_FGCOL + offset, NULL);
-            gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_BGWIN]),
-                                                        renderer, "text", ML_COL_BGWIN, "foreground",
-                                                        ML_COL_FGCOL + offset, NULL);
-            gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_LOSS]),
-                                                        renderer, "text", ML_COL_LOSS, "foreground",
-                                                        ML_COL_FGCOL + offset, NULL);
-            gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_GLOSS]),
-                                                        renderer, "text", ML_COL_GLOSS, "foreground",
-                                                        ML_COL_FGCOL + offset, NULL);
-            gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_BGLOSS]),
-                                                        renderer, "text", ML_COL_BGLOSS, "foreground",
-                                                        ML_COL_FGCOL + offset, NULL);
+            int j;
+
+            for (j = ML_COL_WIN; j <= ML_COL_BGLOSS; j++)
+                MoveListAddColumn(view, _(aszTitleDetails[j]), renderer, j, phd);
         }
 
-        gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, aszTitleDetails[ML_COL_EQUITY],
-                                                    renderer, "text", ML_COL_EQUITY + offset, "foreground",
-                                                    ML_COL_FGCOL + offset, NULL);
-        gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, _(aszTitleDetails[ML_COL_DIFF]), renderer,
-                                                    "text", ML_COL_DIFF + offset, "foreground", ML_COL_FGCOL + offset,
-                                                    NULL);
-        gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, Q_(aszTitleDetails[ML_COL_MOVE]), renderer,
-                                                    "text", ML_COL_MOVE + offset, "foreground", ML_COL_FGCOL + offset,
-                                                    NULL);
+        MoveListAddColumn(view, aszTitleDetails[ML_COL_EQUITY], renderer, ML_COL_EQUITY, phd);
+        MoveListAddColumn(view, _(aszTitleDetails[ML_COL_DIFF]), renderer, ML_COL_DIFF, phd);
+        MoveListAddColumn(view, Q_(aszTitleDetails[ML_COL_MOVE]), renderer, ML_COL_MOVE, phd);
     }
 
     phd->pwMoves = view;
@@ -133,32 +192,21 @@ MoveListCreate(hintdata * phd)
     g_signal_connect(sel, "changed", G_CALLBACK(HintSelect), phd);
 
 
-    /* Add empty rows */
-    if (phd->fDetails)
-        store =
-            gtk_list_store_new(DETAIL_COLUMN_COUNT + 2, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
-                               G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
-                               G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER);
-    else {
-        if (showWLTree)
-            store = gtk_list_store_new(2, G_TYPE_POINTER, G_TYPE_INT);
-        else
-            store =
-                gtk_list_store_new(MIN_COLUMN_COUNT + 2, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
-                                   G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER);
-    }
+    /* Add empty rows; each holds only its move, the rest is drawn
+     * from it when the row is shown */
+    if (showWLTree)
+        store = gtk_list_store_new(2, G_TYPE_POINTER, G_TYPE_INT);
+    else
+        store = gtk_list_store_new(1, G_TYPE_POINTER);
 
     for (i = 0; i < phd->pml->cMoves; i++)
         gtk_list_store_append(store, &iter);
 
     gtk_tree_view_set_model(GTK_TREE_VIEW(view), GTK_TREE_MODEL(store));
+    g_object_unref(store);
     MoveListUpdate(phd);
 }
 
-float rBest;
-
-GtkStyle *psHighlight = NULL;
-
 extern void
 MoveListRefreshSize(void)
 {
@@ -177,14 +225,12 @@ MoveListRefreshSize(void)
 extern void
 MoveListUpdate(const hintdata * phd)
 {
-    unsigned int i, j, colNum;
-    char sz[32];
-    cubeinfo ci;
+    unsigned int i;
     movelist *pml = phd->pml;
     int col = phd->fDetails ? 8 : 2;
     int showWLTree = showMoveListDetail && !phd->fDetails;
+    unsigned int iUnknownRank = 0;
 
-    int offset = (phd->fDetails) ? 0 : MIN_COLUMN_COUNT - DETAIL_COLUMN_COUNT;
     GtkTreeIter iter;
     GtkListStore *store;
     store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(phd->pwMoves)));
@@ -207,93 +253,45 @@ MoveListUpdate(const hintdata * phd)
      * the move list. */
     g_assert(ms.fMove == 0 || ms.fMove == 1);
 
-    GetMatchStateCubeInfo(&ci, &ms);
     rBest = pml->amMoves[0].rScore;
 
     if (!showWLTree)
         gtk_tree_view_column_set_title(gtk_tree_view_get_column(GTK_TREE_VIEW(phd->pwMoves), col),
                                        (fOutputMWC && ms.nMatchTo) ? _("MWC") : _("Equity"));
 
-    for (i = 0; i < pml->cMoves; i++) {
-        float *ar = pml->amMoves[i].arEvalMove;
-        int rankKnown;
-        const char *highlight_sz;
-
-        if (showWLTree)
-            gtk_list_store_set(store, &iter, 0, pml->amMoves + i, -1);
-        else
-            gtk_list_store_set(store, &iter, ML_COL_DATA + offset, pml->amMoves + i, -1);
-
-        rankKnown = 1;
-        if (i && i == pml->cMoves - 1 && phd->piHighlight && i == *phd->piHighlight)
-            /* The move made is the last on the list.  Some moves might
-             * have been deleted to fit this one in */
-        {
-            /* Lets count how many moves are possible to see if this is the last move */
-            movelist ml;
-            int dice[2];
-            memcpy(dice, ms.anDice, sizeof(dice));
-            if (!dice[0]) {     /* If the dice have got lost, try to find them */
-                moverecord *pmr = (moverecord *) plLastMove->plNext->p;
-                if (pmr) {
-                    dice[0] = pmr->anDice[0];
-                    dice[1] = pmr->anDice[1];
-                }
+    i = pml->cMoves - 1;
+    if (pml->cMoves > 1 && phd->piHighlight && i == *phd->piHighlight) {
+        /* The move made is the last on the list.  Some moves might
+         * have been deleted to fit this one in */
+
+        /* Lets count how many moves are possible to see if this is the last move */
+        movelist ml;
+        int dice[2];
+        memcpy(dice, ms.anDice, sizeof(dice));
+        if (!dice[0]) {         /* If the dice have got lost, try to find them */
+            moverecord *pmr = (moverecord *) plLastMove->plNext->p;
+            if (pmr) {
+                dice[0] = pmr->anDice[0];
+                dice[1] = pmr->anDice[1];
             }
-            GenerateMoves(&ml, msBoard(), dice[0], dice[1], FALSE);
-            if (i < ml.cMoves - 1)
-                rankKnown = 0;
         }
+        GenerateMoves(&ml, msBoard(), dice[0], dice[1], FALSE);
+        if (i < ml.cMoves - 1)
+            iUnknownRank = i + 1;
+    }
+    g_object_set_data(G_OBJECT(phd->pwMoves), "unknown-rank", GUINT_TO_POINTER(iUnknownRank));
 
-        highlight_sz = (phd->piHighlight && *phd->piHighlight == i) ? "*" : "";
-
-        if (rankKnown)
-            sprintf(sz, "%s%s%u", pml->amMoves[i].cmark ? "+" : "", highlight_sz, i + 1);
+    for (i = 0; i < pml->cMoves; i++) {
+        if (showWLTree)
+            gtk_list_store_set(store, &iter, 0, pml->amMoves + i, 1, i + 1 == iUnknownRank ? -1 : (int) i + 1, -1);
         else
-            sprintf(sz, "%s%s??", pml->amMoves[i].cmark ? "+" : "", highlight_sz);
-
-        if (showWLTree) {
-            gtk_list_store_set(store, &iter, 1, rankKnown ? (int) i + 1 : -1, -1);
-            goto skipoldcode;
-        } else
-            gtk_list_store_set(store, &iter, ML_COL_RANK, sz, -1);
-        FormatEval(sz, &pml->amMoves[i].esMove);
-        gtk_list_store_set(store, &iter, ML_COL_TYPE, sz, -1);
-
-        /* gwc */
-        if (phd->fDetails) {
-            colNum = ML_COL_WIN;
-            for (j = 0; j < 5; j++) {
-                if (j == 3) {
-                    gtk_list_store_set(store, &iter, colNum, OutputPercent(1.0f - ar[OUTPUT_WIN]), -1);
-                    colNum++;
-                }
-                gtk_list_store_set(store, &iter, colNum, OutputPercent(ar[j]), -1);
-                colNum++;
-            }
-        }
-
-        /* cubeless equity */
-        gtk_list_store_set(store, &iter, ML_COL_EQUITY + offset, OutputEquity(pml->amMoves[i].rScore, &ci, TRUE), -1);
-        if (i != 0) {
-            gtk_list_store_set(store, &iter, ML_COL_DIFF + offset,
-                               OutputEquityDiff(pml->amMoves[i].rScore, rBest, &ci), -1);
-        }
+            gtk_list_store_set(store, &iter, 0, pml->amMoves + i, -1);
 
-        gtk_list_store_set(store, &iter, ML_COL_MOVE + offset, FormatMove(sz, msBoard(), pml->amMoves[i].anMove), -1);
-
-        /* highlight row */
-        if (phd->piHighlight && *phd->piHighlight == i) {
-            char buf[20];
-            sprintf(buf, "#%02x%02x%02x", psHighlight->fg[GTK_STATE_SELECTED].red / 256,
-                    psHighlight->fg[GTK_STATE_SELECTED].green / 256, psHighlight->fg[GTK_STATE_SELECTED].blue / 256);
-            gtk_list_store_set(store, &iter, ML_COL_FGCOL + offset, buf, -1);
-        } else
-            gtk_list_store_set(store, &iter, ML_COL_FGCOL + offset, NULL, -1);
-      skipoldcode:             /* Messy as 3 copies of code at moment... */
         gtk_tree_model_iter_next(GTK_TREE_MODEL(store), &iter);
     }
 
+    /* the text is drawn afresh for the rows on show */
+    gtk_widget_queue_draw(phd->pwMoves);
 }
 
 extern GList *
@@ -324,8 +322,6 @@ extern move *
 MoveListGetMove(const hintdata * phd, GList * pl)
 {
     move *m;
-    int showWLTree = showMoveListDetail && !phd->fDetails;
-    int col, offset = (phd->fDetails) ? 0 : MIN_COLUMN_COUNT - DETAIL_COLUMN_COUNT;
     GtkTreeIter iter;
     GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(phd->pwMoves));
 
@@ -336,12 +332,8 @@ MoveListGetMove(const hintdata * phd, GList * pl)
     (void)check;      /* silence warning about unused variable */
 #endif
 
-    if (showWLTree)
-        col = 0;
-    else
-        col = ML_COL_DATA + offset;
-
-    gtk_tree_model_get(model, &iter, col, &m, -1);
+    /* both kinds of list keep the move in the first column */
+    gtk_tree_model_get(model, &iter, 0, &m, -1);
 
     return m;
 }
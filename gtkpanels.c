@@ -758,6 +758,9 @@ GTKAddGame(moverecord * pmr)
     else
         sprintf(sz, _("Game %d: %d, %d"), pmr->g.i + 1, pmr->g.anScore[0], pmr->g.anScore[1]);
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(game_select_combo), sz);
+    if (fHoldGames)
+        return;                 /* listed, but the first game stays shown */
+
     model = gtk_combo_box_get_model(GTK_COMBO_BOX(game_select_combo));
     last_game = gtk_tree_model_iter_n_children(model, NULL);
     GTKSetGame(last_game - 1);
@@ -795,7 +798,7 @@ SelectGame(GtkWidget * pw, void *UNUSED(data))
     listOLD *pl;
     int i = 0;
 
-    if (!plGame)
+    if (!plGame || fHoldGames)
         return;
 
     i = gtk_combo_box_get_active(GTK_COMBO_BOX(pw));
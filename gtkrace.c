@@ -30,6 +30,7 @@
 #include "gtkrace.h"
 #include "osr.h"
 #include "format.h"
+#include "multithread.h"
 #include "gtkwindows.h"
 
 typedef struct {
@@ -277,7 +278,7 @@ PerformOSR(GtkWidget * UNUSED(pw), racewidget * prw)
     GtkTreeIter iter;
     GtkTreeModel *store;
 
-    raceProbs((ConstTanBoard) prw->anBoard, nTrials, ar, arMu);
+    raceProbs((ConstTanBoard) prw->anBoard, nTrials, MT_GetNumThreads(), ar, arMu);
 
     PipCount((ConstTanBoard) prw->anBoard, anPips);
 
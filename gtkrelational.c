@@ -82,7 +82,7 @@ static GtkListStore *dbStore;
 static GtkTreeIter selected_iter;
 static int optionsValid;
 static GtkWidget *playerTreeview = NULL;
-static GtkWidget  *adddb, *deldb, *gameStats, *dbList, *dbtype, *user, *password, *hostname, *login, *helptext;
+static GtkWidget  *adddb, *deldb, *gameStats, *gamePositions, *dbList, *dbtype, *user, *password, *hostname, *login, *helptext;
 
 static void CheckDatabase(const char *database);
 static void DBListSelected(GtkTreeView * treeview, gpointer userdata);
@@ -823,7 +823,7 @@ create_model(void)
                   "SUM(cube_error_total_normalised),"
                   "SUM(chequer_error_total_normalised),"
                   "SUM(luck_total_normalised) "
-                  "FROM matchstat NATURAL JOIN player group by name");
+                  "FROM playerstat NATURAL JOIN player group by name");
     if (!rs)
         return 0;
 
@@ -1260,7 +1260,7 @@ CheckDatabase(const char *database)
         int matchcount = RunQueryValue(pdb, "count(*) FROM session");
 
         char *dbString, *buf, *buf2 = NULL;
-        if (version < DB_VERSION)
+        if (version < DB_VERSION_UPGRADE)
             dbString = _("This database is from an old version of GNU Backgammon and cannot be used");
         else if (version > DB_VERSION)
             dbString = _("This database is from a new version of GNU Backgammon and cannot be used");
@@ -1389,6 +1389,7 @@ RelationalSaveOptions(void)
                       gtk_entry_get_text(GTK_ENTRY(password)), gtk_entry_get_text(GTK_ENTRY(hostname)));
 
         storeGameStats = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(gameStats));
+        storePositions = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(gamePositions));
     }
 }
 
@@ -1536,6 +1537,13 @@ RelationalOptions(void)
     gtk_box_pack_start(GTK_BOX(vb1), gameStats, FALSE, FALSE, 0);
     gtk_widget_set_tooltip_text(gameStats, _("Store individual games statistics in addition to global match ones"));
 
+    gamePositions = gtk_check_button_new_with_label(_("Store positions"));
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(gamePositions), storePositions);
+    gtk_box_pack_start(GTK_BOX(vb1), gamePositions, FALSE, FALSE, 0);
+    gtk_widget_set_tooltip_text(gamePositions,
+                                _("Store the analysed chequer plays under their position ID, "
+                                  "for \"relational find position\""));
+
     gtk_box_pack_start(GTK_BOX(hb2), vb1, FALSE, FALSE, 10);
 
     help = gtk_frame_new(_("Info"));
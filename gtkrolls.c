@@ -45,68 +45,106 @@ typedef struct {
 } rollswidget;
 
 
-static void
-add_level(GtkTreeStore * model, GtkTreeIter * iter,
-          const int n, const TanBoard anBoard,
-          evalcontext * pec, cubeinfo * pci, const gboolean fInvert, float arOutput[NUM_ROLLOUT_OUTPUTS])
-{
+/* The best move for a roll and what it leads to, worked out on the
+ * calculation threads and put into the tree afterwards */
+typedef struct _rollnode {
+    int anMove[8];
+    char szMove[FORMATEDMOVESIZE];
+    float rEquity;              /* shown for the roll */
+    float rAverage;             /* shown for the average of the next rolls */
+    struct _rollnode *arn;      /* the 21 rolls after it, or NULL */
+} rollnode;
 
-    int n0, n1;
-    GtkTreeIter child_iter;
+/* The rolls of the position shown, one task each */
+typedef struct {
+    TanBoard anBoard;
+    cubeinfo ci;
+    evalcontext *pec;
+    int n;
+    rollnode rn;
+    float aarOutput[21][NUM_ROLLOUT_OUTPUTS];
+} rollsjob;
+
+typedef struct {
+    Task task;
+    rollsjob *prj;
+    int i, n0, n1;
+} rolltask;
+
+/* positions evaluated so far, for the progress bar */
+static int cRollsDone;
+
+static int EvalLevel(rollnode * prnParent, const int n, const TanBoard anBoard,
+                     evalcontext * pec, const cubeinfo * pci, const gboolean fInvert,
+                     float arOutput[NUM_ROLLOUT_OUTPUTS]);
+
+static int
+EvalRoll(rollnode * prn, const int n0, const int n1, const int n, const TanBoard anBoard,
+         evalcontext * pec, const cubeinfo * pci, const gboolean fInvert, float arOutput[NUM_ROLLOUT_OUTPUTS])
+{
     cubeinfo ci;
     TanBoard an;
     SSE_ALIGN(float ar[NUM_ROLLOUT_OUTPUTS]);
-    int anMove[8];
-    int i;
-
-    char szRoll[3], szMove[FORMATEDMOVESIZE], *szEquity;
 
     /* cubeinfo for opponent on roll */
 
     memcpy(&ci, pci, sizeof(cubeinfo));
     ci.fMove = !pci->fMove;
 
-    for (i = 0; i < NUM_ROLLOUT_OUTPUTS; ++i)
-        arOutput[i] = 0.0f;
+    memcpy(an, anBoard, sizeof(an));
 
-    for (n0 = 0; n0 < 6; ++n0) {
-        for (n1 = 0; n1 <= n0; ++n1) {
+    if (FindBestMove(prn->anMove, n0 + 1, n1 + 1, an, pci, pec, defaultFilters) < 0)
+        return -1;
 
-            memcpy(an, anBoard, sizeof(an));
+    FormatMove(prn->szMove, anBoard, prn->anMove);
 
-            if (FindBestMove(anMove, n0 + 1, n1 + 1, an, pci, pec, defaultFilters) < 0)
-                return;
+    SwapSides(an);
 
-            SwapSides(an);
+    if (n) {
 
-            gtk_tree_store_append(model, &child_iter, iter);
+        if (EvalLevel(prn, n - 1, (ConstTanBoard) an, pec, &ci, !fInvert, ar) < 0)
+            return -1;
 
-            if (n) {
+    } else {
 
-                add_level(model, &child_iter, n - 1, (ConstTanBoard) an, pec, &ci, !fInvert, ar);
-                if (MT_SafeGet(&fInterrupt))
-                    return;
+        /* evaluate resulting position */
 
-            } else {
+        if (GeneralEvaluationE(ar, (ConstTanBoard) an, &ci, pec) < 0)
+            return -1;
 
-                /* evaluate resulting position */
+        MT_SafeInc(&cRollsDone);
 
-                ProgressValueAdd(1);
+    }
 
-                if (GeneralEvaluationE(ar, (ConstTanBoard) an, &ci, pec) < 0)
-                    return;
+    if (fInvert)
+        InvertEvaluationR(ar, &ci);
 
-            }
+    prn->rEquity = ar[OUTPUT_CUBEFUL_EQUITY];
+    memcpy(arOutput, ar, sizeof(ar));
 
-            if (fInvert)
-                InvertEvaluationR(ar, &ci);
+    return 0;
+}
 
-            sprintf(szRoll, "%d%d", n0 + 1, n1 + 1);
-            FormatMove(szMove, anBoard, anMove);
+static int
+EvalLevel(rollnode * prnParent, const int n, const TanBoard anBoard,
+          evalcontext * pec, const cubeinfo * pci, const gboolean fInvert, float arOutput[NUM_ROLLOUT_OUTPUTS])
+{
 
-            szEquity = OutputMWC(ar[OUTPUT_CUBEFUL_EQUITY], fInvert ? pci : &ci, TRUE);
+    int n0, n1, k = 0;
+    SSE_ALIGN(float ar[NUM_ROLLOUT_OUTPUTS]);
+    int i;
+
+    for (i = 0; i < NUM_ROLLOUT_OUTPUTS; ++i)
+        arOutput[i] = 0.0f;
+
+    prnParent->arn = g_new0(rollnode, 21);
+
+    for (n0 = 0; n0 < 6; ++n0) {
+        for (n1 = 0; n1 <= n0; ++n1, ++k) {
 
-            gtk_tree_store_set(model, &child_iter, 0, szRoll, 1, szMove, 2, szEquity, -1);
+            if (EvalRoll(&prnParent->arn[k], n0, n1, n, anBoard, pec, pci, fInvert, ar) < 0
+                || MT_SafeGet(&fInterrupt))
+                return -1;
 
             for (i = 0; i < NUM_ROLLOUT_OUTPUTS; ++i)
                 arOutput[i] += (n0 == n1) ? ar[i] : 2.0f * ar[i];
@@ -118,17 +156,140 @@ add_level(GtkTreeStore * model, GtkTreeIter * iter,
     for (i = 0; i < NUM_ROLLOUT_OUTPUTS; ++i)
         arOutput[i] /= 36.0f;
 
+    prnParent->rAverage = arOutput[OUTPUT_CUBEFUL_EQUITY];
+
+    if (!fInvert)
+        InvertEvaluationR(arOutput, pci);
+
+    return 0;
+}
+
+static void
+RollTask(rolltask * prt)
+{
+    rollsjob *prj = prt->prj;
+
+    if (EvalRoll(&prj->rn.arn[prt->i], prt->n0, prt->n1, prj->n - 1, (ConstTanBoard) prj->anBoard,
+                 prj->pec, &prj->ci, TRUE, prj->aarOutput[prt->i]) < 0)
+        MT_AbortTasks();
+}
+
+static void
+FreeLevel(rollnode * prn)
+{
+    int k;
+
+    if (!prn->arn)
+        return;
+
+    for (k = 0; k < 21; ++k)
+        FreeLevel(&prn->arn[k]);
+
+    g_free(prn->arn);
+}
+
+static void
+add_level(GtkTreeStore * model, GtkTreeIter * iter, const rollnode * prnParent,
+          const cubeinfo * pci, const gboolean fInvert)
+{
+
+    int n0, n1, k = 0;
+    GtkTreeIter child_iter;
+    cubeinfo ci;
+    const cubeinfo *pciShow;
+
+    char szRoll[3], *szEquity;
+
+    /* cubeinfo for opponent on roll */
+
+    memcpy(&ci, pci, sizeof(cubeinfo));
+    ci.fMove = !pci->fMove;
+    pciShow = fInvert ? pci : &ci;
+
+    for (n0 = 0; n0 < 6; ++n0) {
+        for (n1 = 0; n1 <= n0; ++n1, ++k) {
+
+            const rollnode *prn = &prnParent->arn[k];
+
+            gtk_tree_store_append(model, &child_iter, iter);
+
+            if (prn->arn)
+                add_level(model, &child_iter, prn, &ci, !fInvert);
+
+            sprintf(szRoll, "%d%d", n0 + 1, n1 + 1);
+
+            szEquity = OutputMWC(prn->rEquity, pciShow, TRUE);
+
+            gtk_tree_store_set(model, &child_iter, 0, szRoll, 1, prn->szMove, 2, szEquity, -1);
+
+        }
+
+    }
+
     /* add average equity */
 
-    szEquity = OutputMWC(arOutput[OUTPUT_CUBEFUL_EQUITY], fInvert ? pci : &ci, TRUE);
+    szEquity = OutputMWC(prnParent->rAverage, pciShow, TRUE);
 
     gtk_tree_store_append(model, &child_iter, iter);
 
     gtk_tree_store_set(model, &child_iter, 0, _("Average equity"), 1, "", 2, szEquity, -1);
 
-    if (!fInvert)
-        InvertEvaluationR(arOutput, pci);
+}
+
+static gboolean
+UpdateRollsProgress(gpointer UNUSED(unused))
+{
+    ProgressValue(MT_SafeGet(&cRollsDone));
+    return TRUE;
+}
+
+/* Work out the 21 rolls of the position on the calculation threads,
+ * each with everything after it.  The dialog stays responsive while
+ * they run.  FALSE if interrupted. */
+static int
+EvalRolls(rollsjob * prj)
+{
+    canceltoken ct = { FALSE };
+    canceltoken *pctOld;
+    int n0, n1, k = 0, ret;
+
+    prj->rn.arn = g_new0(rollnode, 21);
+    MT_SafeSet(&cRollsDone, 0);
+
+    pctOld = MT_SetJob(&ct);
+
+    for (n0 = 0; n0 < 6; ++n0)
+        for (n1 = 0; n1 <= n0; ++n1, ++k) {
+            rolltask *prt = g_new(rolltask, 1);
+
+            prt->task.fun = (AsyncFun) RollTask;
+            prt->task.data = prt;
+            prt->task.pLinkedTask = NULL;
+            prt->task.priority = TASK_INTERACTIVE;
+            prt->task.pct = MT_GetTLD()->pct;
+            prt->prj = prj;
+            prt->i = k;
+            prt->n0 = n0;
+            prt->n1 = n1;
+            MT_AddTask((Task *) prt, TRUE);
+        }
 
+    ret = MT_WaitForTasks(UpdateRollsProgress, UI_UPDATETIME, FALSE);
+    MT_SetJob(pctOld);
+
+    if (ret < 0 || ct.fCancelled || MT_SafeGet(&fInterrupt))
+        return FALSE;
+
+    /* the average of the first rolls, as EvalLevel() does for the
+     * others */
+    prj->rn.rAverage = 0.0f;
+    for (n0 = 0, k = 0; n0 < 6; ++n0)
+        for (n1 = 0; n1 <= n0; ++n1, ++k)
+            prj->rn.rAverage += (n0 == n1) ? prj->aarOutput[k][OUTPUT_CUBEFUL_EQUITY]
+                : 2.0f * prj->aarOutput[k][OUTPUT_CUBEFUL_EQUITY];
+    prj->rn.rAverage /= 36.0f;
+
+    return TRUE;
 }
 
 
@@ -157,33 +318,35 @@ sort_func(GtkTreeModel * model, GtkTreeIter * a, GtkTreeIter * b, gpointer UNUSE
 static GtkTreeModel *
 create_model(const int n, evalcontext * pec, const matchstate * pms)
 {
-    GtkTreeStore *model;
-    TanBoard anBoard;
-    cubeinfo ci;
-    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    GtkTreeStore *model = NULL;
+    rollsjob *prj = g_new0(rollsjob, 1);
     int i, j;
 
-    memcpy(anBoard, pms->anBoard, sizeof(anBoard));
-
-    /* create tree store */
-    model = gtk_tree_store_new(3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
-
-    GetMatchStateCubeInfo(&ci, pms);
+    memcpy(prj->anBoard, pms->anBoard, sizeof(prj->anBoard));
+    GetMatchStateCubeInfo(&prj->ci, pms);
+    prj->pec = pec;
+    prj->n = n;
 
     for (i = 0, j = 1; i < n; ++i, j *= 21);
 
     ProgressStartValue(_("Calculating equities"), j);
 
-    add_level(model, NULL, n - 1, (ConstTanBoard) anBoard, pec, &ci, TRUE, arOutput);
+    if (EvalRolls(prj)) {
+        /* create tree store */
+        model = gtk_tree_store_new(3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
 
-    ProgressEnd();
+        add_level(model, NULL, &prj->rn, &prj->ci, TRUE);
 
-    if (!MT_SafeGet(&fInterrupt)) {
         gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model), 2, sort_func, NULL, NULL);
         gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(model), 2, GTK_SORT_DESCENDING);
-        return GTK_TREE_MODEL(model);
-    } else
-        return NULL;
+    }
+
+    ProgressEnd();
+
+    FreeLevel(&prj->rn);
+    g_free(prj);
+
+    return model ? GTK_TREE_MODEL(model) : NULL;
 }
 
 
@@ -200,10 +363,8 @@ RollsTree(const int n, evalcontext * pec, const matchstate * pms)
     };
 
     pm = create_model(n, pec, pms);
-    if (MT_SafeGet(&fInterrupt)) {
-        g_object_unref(G_OBJECT(pm));
+    if (!pm)
         return NULL;
-    }
     ptv = gtk_tree_view_new_with_model(pm);
     g_object_unref(G_OBJECT(pm));
 
@@ -31,6 +31,10 @@
                     the equity of each decision and therefore the best decision as well,
                     and uses it to set the text for the corresponding quadrant (the best decision is stored in
                     psm->aaQuadrantData[i][j].decisionString). This text is displayed in step 5 below.
+                    In the cube scoremap, CalcCubeEquities() does this for a whole growing square of scores at
+                    once, evaluating the position only once for all of them.
+                    ScoreMapRun() runs these on the calculation threads, first at 0-ply then at the ply asked for,
+                    and keeps the results so that going back to earlier options evaluates nothing again.
                     In the move scoremap, FindMostFrequentMoves() finds the top-k most frequent distinct best moves
                     and assigns them distinct colors, as well as English descriptions (in the "alpha version" where
                     English description is allowed).
@@ -129,7 +133,9 @@ and come back, it works again. It may be a movelist construction issue.
 #include "gtkscoremap.h"
 #include "drawboard.h"
 #include "format.h"
+#include "gtkgame.h"
 #include "gtkwindows.h"
+#include "multithread.h"
 //#include "gtkoptions.h"  
 
 
@@ -337,6 +343,12 @@ typedef struct {
     char topKDecisions[TOP_K][FORMATEDMOVESIZE];            //top-k most frequent best-move decisions
     // char * topKClassifiedDecisions[TOP_K];  //top-k most frequent best-move decisions with "English" description
     int topKDecisionsLength;                //b/w 0 and K
+
+    // 4. computation (see ScoreMapRun()):
+    GHashTable *phtResults;     // results already found, by cubeinfo and ply
+    canceltoken *pct;           // the computation running, or NULL
+    int fRecalc;                // the settings changed while it ran: start again
+    int fClosing;               // the dialog was closed while it ran
 } scoremap;
 
 // *******************************************************************
@@ -455,7 +467,7 @@ mmwc2eq(const float rMwc, const cubeinfo *pci) {
 }
 
 static int
-CalcQuadrantEquities(quadrantdata * pq, const scoremap * psm, int recomputeFully) {
+CalcQuadrantEquities(quadrantdata * pq, const scoremap * psm, int recomputeFully, const evalcontext * pec) {
 /* In Cube ScoreMap: Calculates the DT and ND equities for the given quadrant. Updates data in pq accordingly.
 In Move ScoreMap: Calculates the ordered best moves and their equities.
 */
@@ -467,7 +479,7 @@ In Move ScoreMap: Calculates the ordered best moves and their equities.
         } else {
             if (recomputeFully) {
                 float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
-                if (GeneralCubeDecisionE(aarOutput, psm->pms->anBoard, & pq->ci, & psm->ec, NULL)) { 
+                if (GeneralCubeDecisionE(aarOutput, psm->pms->anBoard, & pq->ci, pec, NULL)) { 
                         //GeneralCubeDecisionE is from eval.c
                         // extern int GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const TanBoard anBoard,
                         // cubeinfo * const pci, const evalcontext * pec, const evalsetup * UNUSED(pes))
@@ -492,7 +504,7 @@ In Move ScoreMap: Calculates the ordered best moves and their equities.
         return 0;
     } else {  //move scoremap
         if (FindnSaveBestMoves(&(pq->ml),psm->pms->anDice[0],psm->pms->anDice[1], (ConstTanBoard) psm->pms->anBoard, NULL, //or pkey
-                                        arSkillLevel[SKILL_DOUBTFUL], &(pq->ci), &psm->ec, aamfAnalysis) <0) { 
+                                        arSkillLevel[SKILL_DOUBTFUL], &(pq->ci), pec, aamfAnalysis) <0) { 
             strcpy(pq->decisionString,"");
             pq->ml.cMoves=0; //also used for DestroyDialog
             pq->ml.amMoves = NULL;
@@ -511,6 +523,303 @@ In Move ScoreMap: Calculates the ordered best moves and their equities.
     }
 }
 
+static int
+CalcCubeEquities(quadrantdata * apq[], int c, const scoremap * psm, const evalcontext * pec) {
+/* In Cube ScoreMap: same as CalcQuadrantEquities() for the c quadrants apq[] at once. They all have the same
+position and cube, so GeneralCubeDecisionScores() evaluates the position once and applies the match equities
+of each score.
+*/
+    cubeinfo aci[2 * MAX_TABLE_SIZE];
+    float aaarOutput[2 * MAX_TABLE_SIZE][2][NUM_ROLLOUT_OUTPUTS];
+    quadrantdata *apqCube[2 * MAX_TABLE_SIZE];
+    int cCube = 0;
+    int fError;
+
+    for (int k = 0; k < c; k++)
+        if (GetDPEq(NULL, NULL, & apq[k]->ci)) { // the others have no cube available
+            aci[cCube] = apq[k]->ci;
+            apqCube[cCube++] = apq[k];
+        }
+
+    fError = cCube && GeneralCubeDecisionScores(aaarOutput, (ConstTanBoard) psm->pms->anBoard, aci, cCube, pec);
+
+    for (int k = 0; k < cCube; k++) {
+        if (fError) {
+            /*e.g. the user stopped the computation in the middle*/
+            apqCube[k]->ndEquity=-1000;
+            apqCube[k]->dtEquity=-1000;
+        } else {
+            // Convert MWC to equity, and store in the scoremap
+            apqCube[k]->ndEquity= mmwc2eq(aaarOutput[k][0][OUTPUT_CUBEFUL_EQUITY], & apqCube[k]->ci);
+            apqCube[k]->dtEquity= mmwc2eq(aaarOutput[k][1][OUTPUT_CUBEFUL_EQUITY], & apqCube[k]->ci);
+        }
+    }
+
+    // Now set the decisions, as CalcQuadrantEquities() does with equities already found
+    for (int k = 0; k < c; k++) {
+        if (fError && GetDPEq(NULL, NULL, & apq[k]->ci))
+            strcpy(apq[k]->decisionString,"");
+        else
+            CalcQuadrantEquities(apq[k], psm, FALSE, pec);
+    }
+
+    return fError ? -1 : 0;
+}
+
+/* The quadrants are worked out on the calculation threads, a task per unit: a growing square in cube
+scoremaps, as CalcCubeEquities() does, a single quadrant in move scoremaps. The tasks fill in copies, that
+ScoreMapRun() puts in place once all are done, since the quadrants are drawn meanwhile.
+Results are kept by cubeinfo and ply for the life of the dialog, so that going back to a match length,
+cube value or ply seen before does not evaluate anything again.
+*/
+
+typedef struct {
+    int nPlies;
+    int nCube, fCubeOwner, fMove, nMatchTo, anScore[2], fCrawford, fJacoby, fBeavers, bgv;
+} scoremapkey;
+
+typedef struct {
+    float ndEquity;
+    float dtEquity;
+    movelist ml;
+} scoremapresult;
+
+typedef struct {
+    quadrantdata *apq[2 * MAX_TABLE_SIZE];  // where the results go
+    quadrantdata *aqd;                      // and where they are worked out
+    int c;
+    int fDone;
+} scoremapunit;
+
+typedef struct {
+    Task task;
+    const scoremap *psm;
+    evalcontext ec;
+    scoremapunit *psu;
+} scoremaptask;
+
+static void
+ScoreMapKey(scoremapkey * pk, const cubeinfo * pci, int nPlies) {
+    memset(pk, 0, sizeof(scoremapkey));
+    pk->nPlies = nPlies;
+    pk->nCube = pci->nCube;
+    pk->fCubeOwner = pci->fCubeOwner;
+    pk->fMove = pci->fMove;
+    pk->nMatchTo = pci->nMatchTo;
+    pk->anScore[0] = pci->anScore[0];
+    pk->anScore[1] = pci->anScore[1];
+    pk->fCrawford = pci->fCrawford;
+    pk->fJacoby = pci->fJacoby;
+    pk->fBeavers = pci->fBeavers;
+    pk->bgv = (int) pci->bgv;
+}
+
+static guint
+ScoreMapKeyHash(gconstpointer p) {
+    const int *pi = (const int *) p;
+    guint h = 0;
+
+    for (size_t i = 0; i < sizeof(scoremapkey) / sizeof(int); i++)
+        h = h * 31 + (guint) pi[i];
+
+    return h;
+}
+
+static gboolean
+ScoreMapKeyEqual(gconstpointer p0, gconstpointer p1) {
+    return !memcmp(p0, p1, sizeof(scoremapkey));
+}
+
+static void
+FreeScoreMapResult(gpointer p) {
+    scoremapresult *psr = (scoremapresult *) p;
+
+    g_free(psr->ml.amMoves);
+    g_free(psr);
+}
+
+static void
+FreeUnits(scoremapunit * asu, int cUnits) {
+    for (int u = 0; u < cUnits; u++) {
+        for (int k = 0; k < asu[u].c; k++)
+            if (asu[u].aqd[k].ml.cMoves < IMPOSSIBLE_CMOVES)
+                g_free(asu[u].aqd[k].ml.amMoves);
+        g_free(asu[u].aqd);
+    }
+    g_free(asu);
+}
+
+static void
+ScoreMapTask(scoremaptask * pst) {
+    scoremapunit *psu = pst->psu;
+    quadrantdata *apq[2 * MAX_TABLE_SIZE];
+    int ret;
+
+    if (pst->psm->cubeScoreMap) {
+        for (int k = 0; k < psu->c; k++)
+            apq[k] = &psu->aqd[k];
+        ret = CalcCubeEquities(apq, psu->c, pst->psm, &pst->ec);
+    } else
+        ret = CalcQuadrantEquities(&psu->aqd[0], pst->psm, TRUE, &pst->ec);
+
+    // a move scoremap quadrant without moves is not an error
+    if (ret < 0 && MT_Cancelled())
+        MT_AbortTasks();
+    else
+        psu->fDone = TRUE;
+}
+
+/* Copy the result for the quadrant pq of a unit to where it goes */
+static void
+ApplyQuadrant(quadrantdata * pqDest, quadrantdata * pq, const scoremap * psm, const evalcontext * pec) {
+    if (psm->cubeScoreMap) {
+        pqDest->ndEquity = pq->ndEquity;
+        pqDest->dtEquity = pq->dtEquity;
+        CalcQuadrantEquities(pqDest, psm, FALSE, pec);
+        return;
+    }
+
+    if (pqDest->ml.cMoves < IMPOSSIBLE_CMOVES)
+        g_free(pqDest->ml.amMoves);
+    pqDest->ml = pq->ml;
+    pq->ml.cMoves = IMPOSSIBLE_CMOVES;
+    pq->ml.amMoves = NULL;
+
+    if (pqDest->ml.cMoves > 0)
+        FormatMove(pqDest->decisionString, (ConstTanBoard) psm->pms->anBoard, pqDest->ml.amMoves[0].anMove);
+    else
+        strcpy(pqDest->decisionString, "");
+}
+
+static gboolean
+UpdateScoreMapProgress(gpointer UNUSED(unused)) {
+    ProgressValue(MT_GetDoneTasks());
+    return TRUE;
+}
+
+static int
+ScoreMapRun(scoremap * psm, scoremapunit * asu, int cUnits, const evalcontext * pec, int fProgress) {
+/* Work out the cUnits units of asu[] with *pec, and put the results in place. -1 if interrupted or
+cancelled; the units done are kept for later all the same.
+*/
+    canceltoken ct = { FALSE };
+    canceltoken *pctOld;
+    scoremapkey key;
+    int cTasks = 0, ret = 0;
+    int fGrab = pwDialog && gtk_widget_get_visible(pwDialog);
+
+    for (int u = 0; u < cUnits; u++) {
+        scoremapunit *psu = &asu[u];
+        int fFound = TRUE;
+
+        for (int k = 0; k < psu->c && fFound; k++) {
+            ScoreMapKey(&key, &psu->aqd[k].ci, pec->nPlies);
+            fFound = g_hash_table_lookup(psm->phtResults, &key) != NULL;
+        }
+        if (!fFound)
+            continue;
+
+        for (int k = 0; k < psu->c; k++) {
+            const scoremapresult *psr;
+
+            ScoreMapKey(&key, &psu->aqd[k].ci, pec->nPlies);
+            psr = (const scoremapresult *) g_hash_table_lookup(psm->phtResults, &key);
+            psu->aqd[k].ndEquity = psr->ndEquity;
+            psu->aqd[k].dtEquity = psr->dtEquity;
+            if (!psm->cubeScoreMap)
+                CopyMoveList(&psu->aqd[k].ml, &psr->ml);
+        }
+        psu->fDone = TRUE;
+    }
+
+    if (fProgress)
+        ProgressStartValue(_("Finding correct decisions"), MAX(cUnits, 1));
+
+    pctOld = MT_SetJob(&ct);
+    for (int u = 0; u < cUnits; u++) {
+        scoremaptask *pst;
+
+        if (asu[u].fDone)
+            continue;
+
+        pst = g_new(scoremaptask, 1);
+        pst->task.fun = (AsyncFun) ScoreMapTask;
+        pst->task.data = pst;
+        pst->task.pLinkedTask = NULL;
+        pst->task.priority = TASK_INTERACTIVE;
+        pst->task.pct = MT_GetTLD()->pct;
+        pst->psm = psm;
+        pst->ec = *pec;
+        pst->psu = &asu[u];
+        MT_AddTask((Task *) pst, TRUE);
+        cTasks++;
+    }
+
+    if (cTasks) {
+        /* Let the options be changed meanwhile, once the dialog is up: that cancels this
+        computation, see CalcEquities() */
+        if (fGrab) {
+            pwOldGrab = pwGrab;
+            pwGrab = pwDialog;
+        }
+        psm->pct = &ct;
+
+        if (fProgress)
+            ProgressValue(cUnits - cTasks);
+        ret = MT_WaitForTasks(fProgress ? UpdateScoreMapProgress : NULL, UI_UPDATETIME, FALSE);
+
+        psm->pct = NULL;
+        if (fGrab)
+            pwGrab = pwOldGrab;
+    }
+    MT_SetJob(pctOld);
+
+    if (fProgress)
+        ProgressEnd();
+
+    for (int u = 0; u < cUnits; u++) {
+        scoremapunit *psu = &asu[u];
+
+        if (!psu->fDone)
+            continue;
+
+        for (int k = 0; k < psu->c; k++) {
+            ScoreMapKey(&key, &psu->aqd[k].ci, pec->nPlies);
+            if (!g_hash_table_lookup(psm->phtResults, &key)) {
+                scoremapresult *psr = g_new(scoremapresult, 1);
+
+                psr->ndEquity = psu->aqd[k].ndEquity;
+                psr->dtEquity = psu->aqd[k].dtEquity;
+                if (psm->cubeScoreMap)
+                    memset(&psr->ml, 0, sizeof(movelist));
+                else
+                    CopyMoveList(&psr->ml, &psu->aqd[k].ml);
+                scoremapkey *pk = g_new(scoremapkey, 1);
+
+                *pk = key;
+                g_hash_table_insert(psm->phtResults, pk, psr);
+            }
+        }
+
+        // the quadrants have moved on if the options were changed meanwhile
+        if (!ct.fCancelled)
+            for (int k = 0; k < psu->c; k++)
+                ApplyQuadrant(psu->apq[k], &psu->aqd[k], psm, pec);
+    }
+
+    return (ret < 0 || ct.fCancelled) ? -1 : 0;
+}
+
+static void
+AddUnit(scoremapunit * psu, quadrantdata * pq) {
+    quadrantdata *pqCopy = &psu->aqd[psu->c];
+
+    *pqCopy = *pq;
+    pqCopy->ml.cMoves = IMPOSSIBLE_CMOVES;
+    pqCopy->ml.amMoves = NULL;
+    psu->apq[psu->c++] = pq;
+}
+
 static int
 CompareDecisionFrequencies (const void *a, const void *b)
 {
@@ -1565,6 +1874,15 @@ InitQuadrantCubeInfo(scoremap * psm, int i, int j)
 // }
 
 
+static gboolean
+DestroyScoreMapIdle(gpointer UNUSED(p))
+{
+    if (pwDialog)
+        gtk_widget_destroy(gtk_widget_get_toplevel(pwDialog));
+
+    return FALSE;
+}
+
 static int
 CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
 
@@ -1575,22 +1893,29 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
         - Also, in the move scoremap, both players can double, so non-1 cube values could be negative to indicate
             the player who doubles (e.g. 2,-2,4,-4 etc.)
     2) Finds equities at each score, and use these to set the text for the corresponding box.
-        - Does not update the gui.
+        - Does not update the gui, but for showing a first 0-ply pass when a higher ply is asked for.
+        - Runs on the calculation threads, see ScoreMapRun(). If an option is changed meanwhile, the
+            computation is cancelled and started again with the new options once it has stopped.
         - Only does entries in the table >= oldSize. (scomputing old values when resizing the table.)
         - In the move scoremap, it also computes the most frequent best moves across the scoremap
     When calcOnly is set: only do the 2nd step (e.g. if we only changed the ply, no need to recompute the cubeinfo array)
 */
 {
-    /* first free the allocation in money quadrant if it's recomputed (in move scoremap, because 
-    findnSaveBestMoves does a malloc) 
-    */    
-        
-    if (!psm->cubeScoreMap && (oldSize==0 || updateMoneyOnly) && psm->moneyQuadrantData.ml.cMoves < IMPOSSIBLE_CMOVES) {
-        //g_message("money freed: cMoves=%d",psm->moneyQuadrantData.ml.cMoves);
-        g_free(psm->moneyQuadrantData.ml.amMoves);
-        psm->moneyQuadrantData.ml.cMoves = IMPOSSIBLE_CMOVES;
+    int ret = 0;
+
+    if (psm->fClosing)
+        return -1;
+
+    if (psm->pct) {
+        /* still working out the previous options: stop, and let that call start again */
+        MT_Cancel(psm->pct);
+        psm->fRecalc = TRUE;
+        return -1;
     }
 
+    /* the movelists found before, as in the money quadrant, are freed as the new ones are put in
+    place, see ApplyQuadrant() */
+
     if(!calcOnly) {
         // matchstate ams = (*psm->pms); // Make a copy of the "master" matchstate  
         //         //[note: backgammon.h defines an extern ms => using a different name]
@@ -1622,22 +1947,21 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
     }
     if (updateMoneyOnly) {
         //we only recompute the top-left money square, and don't bother with the progress bar
-        CalcQuadrantEquities(&(psm->moneyQuadrantData), psm, TRUE); // Recalculate money equity.
-        // g_message("new money cMoves=%d",psm->moneyQuadrantData.ml.cMoves);
+        scoremapunit *asu = g_new0(scoremapunit, 1);
+
+        asu[0].aqd = g_new(quadrantdata, 1);
+        AddUnit(&asu[0], &psm->moneyQuadrantData);
+        ret = ScoreMapRun(psm, asu, 1, &psm->ec, FALSE);
+        FreeUnits(asu, 1);
     } else {
-        //recompute fully (beyond oldSize); we only recompute the money equity when oldSize==0
-        ProgressStartValue(_("Finding correct decisions"), (oldSize==0)? psm->tableSize*psm->tableSize + 1 : MAX(psm->tableSize*psm->tableSize-oldSize*oldSize, 1) );
-        //g_print("Finding %d-ply cube equities:\n",pec->nPlies);
+        scoremapunit *asu = g_new0(scoremapunit, 1 + psm->tableSize * psm->tableSize);
+        int cUnits = 0;
 
         /* We start by computing the money-play value, since if the user stops the process
         in the middle, it's often the most useful to display and therefore to compute first*/
-        //if(oldSize == 0 || oldSize == psm->tableSize)  //causes bug: it colors the cell in dark grey, and doesn't show a move
-                            //maybe the moneyQuadrantData becomes empty?
         if (oldSize==0) {  //if the money square equity wasn't already computed [we are in the !updateMoneyOnly case]
-            CalcQuadrantEquities(&(psm->moneyQuadrantData), psm, TRUE);
-                    // g_message("new money cMoves=%d",psm->moneyQuadrantData.ml.cMoves);
-            /*careful: upon table scaling, ProgressValueAdd causes a redraw => a potential problem  in the pango markup text because it may not be ready yet!*/
-            ProgressValueAdd(1);//not sure if it should be included above, but probably minor
+            asu[cUnits].aqd = g_new(quadrantdata, 1);
+            AddUnit(&asu[cUnits++], &psm->moneyQuadrantData);
         }
 
         /*
@@ -1647,81 +1971,74 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
             - In move scoremap: i=0->1-away post Crawford; i=1->1-away Crawford; 
                 i=2+->i-away
 
-        In a first version, we incremented i from 1 to tableSize, then j similarly, 
-        i.e. row by row in (i,j) (or col by col as seen by the user with "away" labels).
-        
-        But if the user interrupts the process in the middle, maybe it's better to progress 
-        using growing squares or by computing the diagonal first. Here we implement the 
-        growing squares. (Thanks to Philippe Michel for the feedback!)
-
-        In a third version, instead of first initializing all of the cubeinfo values before starting a 
-        progress bar, which may upset the user since the bar doesn't seem to start, we now
-        compute both at the same : (1) the cubeinfo and (2) the resulting equity values; so we need 
-        to combine the (aux,aux2) indexation values (which are used for expanding squares) with the 
-        (i,j) ones. 
+        The quadrants are queued by growing squares, (aux2,aux) then (aux,aux2), so that the threads
+        get to the scores near 2-away 2-away first.
         */
-        if(!calcOnly) {
+        if(!calcOnly)
             psm->msTemp.nMatchTo = MATCH_SIZE(psm); // Set the match length
-            // psm->pmsTemp->nCube = abs(psm->signednCube); // Set the cube value
-            // if (psm->signednCube == 1) // Cube value 1: centre the cube
-            //     psm->pmsTemp->fCubeOwner = -1;
-            // else // Cube value > 1: Uncentre the cube. Ensure that the player on roll owns the cube (and thus can double)
-            //     psm->pmsTemp->fCubeOwner = (psm->signednCube > 0) ? (psm->pmsTemp->fMove) : (1 - psm->pmsTemp->fMove);
 
-        }
         for (int aux=oldSize; aux<psm->tableSize; aux++) {
-            for (int aux2=aux; aux2>=0; aux2--) {
-                /* first we free the malloc with the equity that may have been provided previously
+            scoremapunit *psu = NULL;
+
+            if (psm->cubeScoreMap) {
+                /* In cube scoremap, the squares of a whole growing square are found together, since
+                they share the evaluation of the position.
                 */
-                if(!psm->cubeScoreMap && psm->aaQuadrantData[aux2][aux].ml.cMoves < IMPOSSIBLE_CMOVES) {
-                    // g_message("DELETED+FREED: aux2=%d, aux=%d, tableSize=%d, moves=%d......",aux2,aux,psm->tableSize,psm->aaQuadrantData[aux2][aux].ml.cMoves);
-                    g_free(psm->aaQuadrantData[aux2][aux].ml.amMoves);
-                    psm->aaQuadrantData[aux2][aux].ml.cMoves = IMPOSSIBLE_CMOVES;
-                }
-                /*Note: in move scoremaps, we check a square validity in InitQuadrantCubeInfo() -> isAllowed();
-                    [and maybe do so again implicitly in  CalcQuadrantEquities()->FindnSaveBestMoves()]
-                However in cube scoremaps, we only do it later in CalcQuadrantEquities()->GetDPEq()
-                */               
-                if(!calcOnly) // skip with ScoreMapPlyToggled
-                    InitQuadrantCubeInfo(psm, aux2, aux);
-                if (psm->aaQuadrantData[aux2][aux].isAllowedScore == ALLOWED || psm->cubeScoreMap) {
-                    //Only running the line below when (i >= oldSize || j >= oldSize) 
-                    // [now aux>=oldSize] yields a bug with grey squares on resize
-                    // if(aux>=oldSize) {
-                        CalcQuadrantEquities(&psm->aaQuadrantData[aux2][aux], psm, (aux >= oldSize));
-                    // if (myDebug)
-                    //     g_print("i=%d,j=%d,FindnSaveBestMoves returned %d, %1.3f; decision: %s\n",i,j,psm->aaQuadrantData[i][j].ml.cMoves,psm->aaQuadrantData[i][j].ml.rBestScore,psm->aaQuadrantData[i][j].decisionString);
-                    // if (aux >= oldSize) // Only count the ones where equities are recomputed (other ones occur near-instantly)
-                        ProgressValueAdd(1);
-                    // }
-                }
-                else {
-                    strcpy(psm->aaQuadrantData[aux2][aux].decisionString, "");
-                    // psm->aaQuadrantData[aux2][aux].ml.cMoves=0; //also used for DestroyDialog
-                }
-                if (aux2<aux) {     //same as above but now doing the other side of the square, without the 
-                                    //(aux,aux) vertex on the diagonal
-                    if(!psm->cubeScoreMap && psm->aaQuadrantData[aux][aux2].ml.cMoves < IMPOSSIBLE_CMOVES) {
-                        // g_message("DELETED+FREED: aux=%d, aux2=%d, tableSize=%d, moves=%d......",aux,aux2,psm->tableSize,psm->aaQuadrantData[aux][aux2].ml.cMoves);
-                        g_free(psm->aaQuadrantData[aux][aux2].ml.amMoves);
-                        psm->aaQuadrantData[aux][aux2].ml.cMoves = IMPOSSIBLE_CMOVES;
-                    }
-                    if(!calcOnly) 
-                        InitQuadrantCubeInfo(psm, aux, aux2);
-                    if (psm->aaQuadrantData[aux][aux2].isAllowedScore == ALLOWED || psm->cubeScoreMap) {
-                        // if(aux>=oldSize) {
-                            CalcQuadrantEquities(&psm->aaQuadrantData[aux][aux2], psm, (aux >= oldSize));
-                        // if (aux >= oldSize)
-                            ProgressValueAdd(1);
-                        // }
-                    }
-                    else {
-                        strcpy(psm->aaQuadrantData[aux][aux2].decisionString, "");
-                        //psm->aaQuadrantData[aux][aux2].ml.cMoves=0; //also used for DestroyDialog                        
+                psu = &asu[cUnits++];
+                psu->aqd = g_new(quadrantdata, 2 * aux + 1);
+            }
+            for (int aux2=aux; aux2>=0; aux2--) {
+                for (int side = 0; side < 2 && (side == 0 || aux2 < aux); side++) {
+                    int i = side ? aux : aux2;
+                    int j = side ? aux2 : aux;
+                    quadrantdata *pq = &psm->aaQuadrantData[i][j];
+
+                    /*Note: in move scoremaps, we check a square validity in InitQuadrantCubeInfo() -> isAllowed();
+                    However in cube scoremaps, we only do it later in CalcQuadrantEquities()->GetDPEq()
+                    */
+                    if(!calcOnly) // skip with ScoreMapPlyToggled
+                        InitQuadrantCubeInfo(psm, i, j);
+                    if (psm->cubeScoreMap)
+                        AddUnit(psu, pq);
+                    else if (pq->isAllowedScore == ALLOWED) {
+                        asu[cUnits].aqd = g_new(quadrantdata, 1);
+                        AddUnit(&asu[cUnits++], pq);
+                    } else {
+                        if (pq->ml.cMoves < IMPOSSIBLE_CMOVES) {
+                            g_free(pq->ml.amMoves);
+                            pq->ml.cMoves = IMPOSSIBLE_CMOVES;
+                        }
+                        strcpy(pq->decisionString, "");
                     }
                 }
             }
         }
+
+        /* Above 0-ply, the whole map is shown at 0-ply first and then refined; a 0-ply pass takes
+        next to no time */
+        if (psm->ec.nPlies > 0) {
+            evalcontext ec0 = psm->ec;
+
+            ec0.nPlies = 0;
+            ret = ScoreMapRun(psm, asu, cUnits, &ec0, TRUE);
+            if (!ret) {
+                for (int i = 0; i < psm->tableSize; i++)
+                    for (int j = 0; j < psm->tableSize; j++)
+                        psm->aaQuadrantData[i][j].isTrueScore = UpdateIsTrueScore(psm, i, j);
+                if (!psm->cubeScoreMap)
+                    FindMostFrequentMoves(psm);
+                gtk_widget_show_all(pwDialog);
+                UpdateScoreMapVisual(psm);
+
+                for (int u = 0; u < cUnits; u++)
+                    asu[u].fDone = FALSE;
+            }
+        }
+        if (!ret)
+            ret = ScoreMapRun(psm, asu, cUnits, &psm->ec, TRUE);
+
+        FreeUnits(asu, cUnits);
+
         /* if we show the true score in the axes and not the away score: when we scale up a table, a "current" score in a 5-point match becomes a "similar" score
                 in a 7-pt match; but we don't currently check that, as DMP, GG, GS etc don't change => check this case only */
         for (int i = 0; i < psm->tableSize; i++) {
@@ -1729,9 +2046,6 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
                 psm->aaQuadrantData[i][j].isTrueScore = UpdateIsTrueScore(psm, i, j);
             }
         }
-        
-        ProgressEnd();
-
     }
 
     // if(!calcOnly) {
@@ -1745,8 +2059,21 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
 
     if (!psm->cubeScoreMap)
         FindMostFrequentMoves(psm);
-    
-    return 0;
+
+    if (psm->fClosing) {
+        /* once the caller is done with psm */
+        g_idle_add(DestroyScoreMapIdle, NULL);
+        return -1;
+    }
+
+    /* the options were changed while this ran: start again with them, cheaply where the results
+    are already known */
+    if (psm->fRecalc) {
+        psm->fRecalc = FALSE;
+        return CalcEquities(psm, 0, FALSE, FALSE);
+    }
+
+    return ret;
 }
 
 static void
@@ -2703,9 +3030,25 @@ Allows garbage collection.
             g_free(psm->moneyQuadrantData.ml.amMoves); 
         }
     } 
+    g_hash_table_destroy(psm->phtResults);
     g_free(psm);
 }
 
+static gboolean
+ScoreMapClose(GtkWidget * UNUSED(pw), GdkEvent * UNUSED(pev), scoremap * psm)
+/* Called by gtk when the user closes the window. In the middle of a computation, the window is only
+destroyed once it has stopped, see CalcEquities().
+*/
+{
+    if (!psm->pct)
+        return FALSE;
+
+    psm->fClosing = TRUE;
+    MT_Cancel(psm->pct);
+
+    return TRUE;
+}
+
 //Module to add text, based on AddTitle from gtkgame.c
 static void
 AddText(GtkWidget* pwBox, char* Text)
@@ -3160,6 +3503,11 @@ if needed (this was initially planned for some explanation text, which was then
     psm->moneyQuadrantData.isSpecialScore = REGULAR; 
     psm->moneyQuadrantData.ml.cMoves = IMPOSSIBLE_CMOVES;
 
+    psm->phtResults = g_hash_table_new_full(ScoreMapKeyHash, ScoreMapKeyEqual, g_free, FreeScoreMapResult);
+    psm->pct = NULL;
+    psm->fRecalc = FALSE;
+    psm->fClosing = FALSE;
+
 
 
 #if GTK_CHECK_VERSION(3,0,0)
@@ -3285,16 +3633,18 @@ if needed (this was initially planned for some explanation text, which was then
 // **************************************************************************************************
     /* calculate values and set colours/text in the table */
 
-    /* For each i,j, fill sm->aaQuadrantData[i][j].ci, find equities, and set the text*/
+    gtk_window_set_default_size(GTK_WINDOW(pwDialog), DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+    /* The DestroyDialog function frees the needed memory! */
+    g_object_weak_ref(G_OBJECT(pwDialog), DestroyDialog, psm);
+    g_signal_connect(G_OBJECT(pwDialog), "delete_event", G_CALLBACK(ScoreMapClose), psm);
+
+    /* For each i,j, fill sm->aaQuadrantData[i][j].ci, find equities, and set the text
+    (the dialog is shown as soon as a first pass is done)*/
     CalcEquities(psm,0,FALSE,FALSE);
     UpdateScoreMapVisual(psm);     //Update: (1) The color of each square (2) The hover text of each square
                                     //      (3) the row/col score labels (4) the gauge.
 
     /* modality */
 
-    gtk_window_set_default_size(GTK_WINDOW(pwDialog), DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
-    /* The DestroyDialog function frees the needed memory! */
-    g_object_weak_ref(G_OBJECT(pwDialog), DestroyDialog, psm);
-
     GTKRunDialog(pwDialog);
 }
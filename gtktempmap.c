@@ -43,6 +43,7 @@
 #include "gtkboard.h"
 #include "gtkwindows.h"
 #include "gtkcube.h"
+#include "multithread.h"
 
 #define SIZE_QUADRANT 52
 
@@ -87,92 +88,132 @@ typedef struct {
 static int fShowEquity = FALSE;
 static int fShowBestMove = FALSE;
 
-static int
-TempMapEquities(evalcontext * pec, const matchstate * pms,
-                float aarEquity[6][6], int aaanMove[6][6][8], const gchar * szTitle, const float rFac)
-{
+/* The equities of a map, filled in by its 21 tasks */
+typedef struct {
+    float aarEquity[6][6];
+    int aaanMove[6][6][8];
+} tempmapresult;
 
+/* One roll of one map, see CalcTempMapEquities() */
+typedef struct {
+    Task task;
+    const matchstate *pms;
+    evalcontext *pec;
+    cubeinfo ci;
+    float rFac;
     int i, j;
+    tempmapresult *ptmr;
+} tempmaptask;
+
+static void
+TempMapTask(tempmaptask * ptmt)
+{
+
     float arOutput[NUM_ROLLOUT_OUTPUTS];
     TanBoard anBoard;
-    int aaan[6][6][8];
-    float aar[6][6];
     cubeinfo ci;
-    cubeinfo cix;
+    int i = ptmt->i, j = ptmt->j;
+    tempmapresult *ptmr = ptmt->ptmr;
 
-    /* calculate equities */
+    memcpy(&ci, &ptmt->ci, sizeof ci);
 
-    GetMatchStateCubeInfo(&cix, pms);
+    /* find best move */
 
-    if (szTitle && *szTitle) {
-        gchar *sz = g_strdup_printf(_("Calculating equities for %s"), szTitle);
-        ProgressStartValue(sz, 21);
-        g_free(sz);
-    } else
-        ProgressStartValue(_("Calculating equities"), 21);
+    memcpy(anBoard, ptmt->pms->anBoard, sizeof(anBoard));
 
-    for (i = 0; i < 6; ++i)
-        for (j = 0; j <= i; ++j) {
-
-            memcpy(&ci, &cix, sizeof ci);
+    if (FindBestMove(ptmr->aaanMove[i][j], i + 1, j + 1, anBoard, &ci, ptmt->pec, defaultFilters) < 0) {
+        MT_AbortTasks();
+        return;
+    }
 
-            /* find best move */
+    /* evaluate resulting position */
 
-            memcpy(anBoard, pms->anBoard, sizeof(anBoard));
+    SwapSides(anBoard);
+    ci.fMove = !ci.fMove;
 
-            if (FindBestMove(aaan[i][j], i + 1, j + 1, anBoard, &ci, pec, defaultFilters) < 0) {
-                ProgressEnd();
-                return -1;
-            }
+    if (GeneralEvaluationE(arOutput, (ConstTanBoard) anBoard, &ci, ptmt->pec) < 0) {
+        MT_AbortTasks();
+        return;
+    }
 
-            /* evaluate resulting position */
+    InvertEvaluationR(arOutput, &ptmt->ci);
 
-            SwapSides(anBoard);
-            ci.fMove = !ci.fMove;
+    if (!ptmt->ci.nMatchTo && ptmt->rFac != 1.0f)
+        arOutput[OUTPUT_CUBEFUL_EQUITY] *= ptmt->rFac;
 
-            if (GeneralEvaluationE(arOutput, (ConstTanBoard) anBoard, &ci, pec) < 0) {
-                ProgressEnd();
-                return -1;
-            }
+    ptmr->aarEquity[i][j] = arOutput[OUTPUT_CUBEFUL_EQUITY];
+    ptmr->aarEquity[j][i] = arOutput[OUTPUT_CUBEFUL_EQUITY];
 
-            InvertEvaluationR(arOutput, &cix);
+    if (i != j)
+        memcpy(ptmr->aaanMove[j][i], ptmr->aaanMove[i][j], sizeof ptmr->aaanMove[0][0]);
 
-            if (!cix.nMatchTo && rFac != 1.0f)
-                arOutput[OUTPUT_CUBEFUL_EQUITY] *= rFac;
+}
 
-            aar[i][j] = arOutput[OUTPUT_CUBEFUL_EQUITY];
-            aar[j][i] = arOutput[OUTPUT_CUBEFUL_EQUITY];
 
-            if (i != j)
-                memcpy(aaan[j][i], aaan[i][j], sizeof aaan[0][0]);
+static gboolean
+UpdateTempMapProgress(gpointer UNUSED(unused))
+{
+    ProgressValue(MT_GetDoneTasks());
+    return TRUE;
+}
 
-            ProgressValueAdd(1);
 
-        }
+/* The rolls of all the maps are evaluated at once on the calculation
+ * threads; the maps are only changed if all of them are done */
+static int
+CalcTempMapEquities(evalcontext * pec, tempmapwidget * ptmw)
+{
 
-    ProgressEnd();
+    tempmapresult *atmr = g_new(tempmapresult, ptmw->n);
+    canceltoken ct = { FALSE };
+    canceltoken *pctOld;
+    int i, j, m, ret;
 
-    memcpy(aarEquity, aar, sizeof aar);
-    memcpy(aaanMove, aaan, sizeof aaan);
+    if (ptmw->n == 1 && ptmw->atm[0].szTitle && *ptmw->atm[0].szTitle) {
+        gchar *sz = g_strdup_printf(_("Calculating equities for %s"), ptmw->atm[0].szTitle);
+        ProgressStartValue(sz, 21);
+        g_free(sz);
+    } else
+        ProgressStartValue(_("Calculating equities"), 21 * ptmw->n);
 
-    return 0;
+    pctOld = MT_SetJob(&ct);
 
-}
+    for (m = 0; m < ptmw->n; ++m)
+        for (i = 0; i < 6; ++i)
+            for (j = 0; j <= i; ++j) {
+                tempmaptask *ptmt = g_new(tempmaptask, 1);
+
+                ptmt->task.fun = (AsyncFun) TempMapTask;
+                ptmt->task.data = ptmt;
+                ptmt->task.pLinkedTask = NULL;
+                ptmt->task.priority = TASK_INTERACTIVE;
+                ptmt->task.pct = MT_GetTLD()->pct;
+                ptmt->pms = ptmw->atm[m].pms;
+                ptmt->pec = pec;
+                GetMatchStateCubeInfo(&ptmt->ci, ptmt->pms);
+                ptmt->rFac = (float) (ptmw->atm[m].pms->nCube / ptmw->atm[0].pms->nCube);
+                ptmt->i = i;
+                ptmt->j = j;
+                ptmt->ptmr = &atmr[m];
+                MT_AddTask((Task *) ptmt, TRUE);
+            }
 
+    ret = MT_WaitForTasks(UpdateTempMapProgress, UI_UPDATETIME, FALSE);
+    MT_SetJob(pctOld);
 
-static int
-CalcTempMapEquities(evalcontext * pec, tempmapwidget * ptmw)
-{
+    ProgressEnd();
 
-    int i;
+    if (ret < 0 || ct.fCancelled) {
+        g_free(atmr);
+        return -1;
+    }
 
-    for (i = 0; i < ptmw->n; ++i)
-        if (TempMapEquities(pec, ptmw->atm[i].pms,
-                            ptmw->atm[i].aarEquity,
-                            ptmw->atm[i].aaanMove,
-                            ptmw->atm[i].szTitle, (float) (ptmw->atm[i].pms->nCube / ptmw->atm[0].pms->nCube)) < 0)
-            return -1;
+    for (m = 0; m < ptmw->n; ++m) {
+        memcpy(ptmw->atm[m].aarEquity, atmr[m].aarEquity, sizeof atmr[m].aarEquity);
+        memcpy(ptmw->atm[m].aaanMove, atmr[m].aaanMove, sizeof atmr[m].aaanMove);
+    }
 
+    g_free(atmr);
     return 0;
 
 }
@@ -34,6 +34,15 @@
 
 #define MAXPLY 4
 
+/* Changes closer together than this (ms) are shown together */
+#define THEORY_UPDATE_DELAY 40
+
+/* What the windows and prices shown depend on */
+typedef struct {
+    int nMatchTo, anScore[2], nCube, fCrawford, fJacoby, fBeavers;
+    float aarRates[2][2];
+} theorykey;
+
 typedef struct {
 
     cubeinfo ci;
@@ -86,6 +95,11 @@ typedef struct {
 
     GtkWidget *apwPly[MAXPLY+1];
 
+    /* pending update, and the values last shown */
+    guint idUpdate;
+    int fShown;
+    theorykey tkShown;
+
 } theorywidget;
 
 
@@ -299,11 +313,12 @@ add_mw_match_rows(theorywidget * ptw, const cubeinfo * pci, float aarRates[2][2]
     };
 
 
+    getMatchPoints(aaarPointsMatch, afAutoRedouble, afDead, pci, aarRates);
+
     for (i = 0; i < 2; i++) {
         GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(ptw->apwMW[i])));
         GtkTreeIter iter;
 
-        getMatchPoints(aaarPointsMatch, afAutoRedouble, afDead, pci, aarRates);
         for (j = 0; j < 4; j++) {
             asz[0] = g_strdup(gettext(aszMatchPlayLabel[j]));
             for (k = 0; k < 2; k++) {
@@ -328,10 +343,11 @@ add_mw_match_rows(theorywidget * ptw, const cubeinfo * pci, float aarRates[2][2]
 }
 
 static void
-TheoryUpdated(GtkWidget * UNUSED(pw), theorywidget * ptw)
+TheoryUpdate(theorywidget * ptw)
 {
-    cubeinfo ci;
+    cubeinfo ci = ptw->ci;
     float aarRates[2][2];
+    theorykey tk;
 
     int i, j;
     gchar *pch;
@@ -342,6 +358,25 @@ TheoryUpdated(GtkWidget * UNUSED(pw), theorywidget * ptw)
 
     TheoryGetValues(ptw, &ci, aarRates);
 
+    /* nothing to do if they are what is shown already, as when a
+     * spinner is dragged back and forth or its limit is set */
+
+    memset(&tk, 0, sizeof(tk));
+    tk.nMatchTo = ci.nMatchTo;
+    tk.anScore[0] = ci.anScore[0];
+    tk.anScore[1] = ci.anScore[1];
+    tk.nCube = ci.nCube;
+    tk.fCrawford = ci.fCrawford;
+    tk.fJacoby = ci.fJacoby;
+    tk.fBeavers = ci.fBeavers;
+    memcpy(tk.aarRates, aarRates, sizeof(tk.aarRates));
+
+    if (ptw->fShown && !memcmp(&tk, &ptw->tkShown, sizeof(tk)))
+        return;
+
+    ptw->tkShown = tk;
+    ptw->fShown = TRUE;
+
     /* set max on the gammon spinners */
 
     for (i = 0; i < 2; ++i)
@@ -462,6 +497,36 @@ TheoryUpdated(GtkWidget * UNUSED(pw), theorywidget * ptw)
 
 }
 
+static gboolean
+TheoryUpdateTimeout(gpointer p)
+{
+    theorywidget *ptw = p;
+
+    ptw->idUpdate = 0;
+    TheoryUpdate(ptw);
+
+    return FALSE;
+}
+
+/* A value was changed; the update waits for the next pause, so that
+ * scrolling through a spinner doesn't rebuild the windows for every
+ * step */
+static void
+TheoryUpdated(GtkWidget * UNUSED(pw), theorywidget * ptw)
+{
+    if (!ptw->idUpdate)
+        ptw->idUpdate = g_timeout_add(THEORY_UPDATE_DELAY, TheoryUpdateTimeout, ptw);
+}
+
+static void
+TheoryDestroy(GtkWidget * UNUSED(pw), theorywidget * ptw)
+{
+    if (ptw->idUpdate) {
+        g_source_remove(ptw->idUpdate);
+        ptw->idUpdate = 0;
+    }
+}
+
 static gboolean
 GraphDraw(GtkWidget * pwGraph, cairo_t * cr, theorywidget * ptw)
 {
@@ -588,7 +653,7 @@ PlyClicked(GtkWidget * pw, theorywidget * ptw)
         for (j = 0; j < 2; ++j)
             gtk_adjustment_set_value(GTK_ADJUSTMENT(ptw->aapwRates[i][j]), dd.aarRates[i][j] * 100.0f);
 
-    TheoryUpdated(NULL, ptw);
+    TheoryUpdate(ptw);
 
 }
 
@@ -632,8 +697,9 @@ GTKShowTheory(const int fActivePage)
 
     gtk_window_set_default_size(GTK_WINDOW(pwDialog), 660, 300);
 
-    ptw = g_malloc(sizeof(theorywidget));
+    ptw = g_malloc0(sizeof(theorywidget));
     g_object_set_data_full(G_OBJECT(pwDialog), "theorywidget", ptw, g_free);
+    g_signal_connect(G_OBJECT(pwDialog), "destroy", G_CALLBACK(TheoryDestroy), ptw);
 
 #if GTK_CHECK_VERSION(3,0,0)
     pwOuterHBox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
@@ -1075,7 +1141,7 @@ GTKShowTheory(const int fActivePage)
 
     ResetTheory(NULL, ptw);
     gtk_widget_show_all(pwDialog);
-    TheoryUpdated(NULL, ptw);
+    TheoryUpdate(ptw);
 
     gtk_notebook_set_current_page(GTK_NOTEBOOK(pwNotebook), fActivePage ? 2 /* prices */ : 0 /* market */ );
 
@@ -2904,7 +2904,7 @@ CommandExportGameHtml(char *sz)
 {
 
     FILE *pf;
-    int fDontClose = FALSE;
+    char *szTemp;
 
     sz = NextToken(&sz);
 
@@ -2921,13 +2921,8 @@ CommandExportGameHtml(char *sz)
     if (!confirmOverwrite(sz, fConfirmSave))
         return;
 
-    if (!strcmp(sz, "-")) {
-        pf = stdout;
-        fDontClose = TRUE;
-    } else if (!(pf = g_fopen(sz, "w"))) {
-        outputerr(sz);
+    if (!(pf = OpenExportFile(sz, &szTemp)))
         return;
-    }
 
     if (exsExport.het == HTML_EXPORT_TYPE_GNU)
         check_for_html_images(sz);
@@ -2936,9 +2931,7 @@ CommandExportGameHtml(char *sz)
                    exsExport.szHTMLPictureURL, exsExport.szHTMLExtension,
                    exsExport.het, exsExport.hecss, getGameNumber(plGame), FALSE, NULL);
 
-
-    if (!fDontClose)
-        fclose(pf);
+    CloseExportFile(pf, sz, szTemp);
 
     setDefaultFileName(sz);
 
@@ -2959,7 +2952,7 @@ CommandExportMatchHtml(char *sz)
     FILE *pf;
     listOLD *pl;
     int nGames;
-    char *aszLinks[4], *filenames[4];
+    char *aszLinks[4], *filenames[4], *szTemp;
     int i, j;
 
     sz = NextToken(&sz);
@@ -3011,10 +3004,7 @@ CommandExportMatchHtml(char *sz)
         }
 
 
-        if (!strcmp(szCurrent, "-"))
-            pf = stdout;
-        else if (!(pf = g_fopen(szCurrent, "w"))) {
-            outputerr(szCurrent);
+        if (!(pf = OpenExportFile(szCurrent, &szTemp))) {
             for (j = 0; j < 4; j++) {
                 g_free(aszLinks[j]);
                 g_free(filenames[j]);
@@ -3027,15 +3017,14 @@ CommandExportMatchHtml(char *sz)
                        exsExport.szHTMLPictureURL, exsExport.szHTMLExtension,
                        exsExport.het, exsExport.hecss, i, i == nGames - 1, aszLinks);
 
+        CloseExportFile(pf, szCurrent, szTemp);
+
         for (j = 0; j < 4; j++) {
             g_free(aszLinks[j]);
             g_free(filenames[j]);
         }
         g_free(szCurrent);
 
-        if (pf != stdout)
-            fclose(pf);
-
     }
 
     /* external stylesheet */
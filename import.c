@@ -29,7 +29,10 @@
 #include <glib/gstdio.h>
 #include <time.h>
 
+#include "archive.h"
+#include "arrow.h"
 #include "backgammon.h"
+#include "analysis.h"
 #include "drawboard.h"
 #if USE_GTK
 #include "gtkgame.h"
@@ -54,20 +57,9 @@ ParseSnowieTxt(char *sz,
 
 
 static int
-IsValidMove(const TanBoard anBoard, const int anMove[8])
+IsValidMove(const TanBoard anBoard, const int anMove[8], const unsigned int anDice[2])
 {
-
-    TanBoard anBoardTemp;
-    int anMoveTemp[8];
-
-    memcpy(anBoardTemp, anBoard, 2 * 25 * sizeof(int));
-    memcpy(anMoveTemp, anMove, 8 * sizeof(int));
-
-    if (!ApplyMove(anBoardTemp, anMoveTemp, TRUE))
-        return 1;
-    else
-        return 0;
-
+    return !CheckMove(anBoard, anMove, anDice);
 }
 
 
@@ -519,7 +511,7 @@ ExpandMatMove(const TanBoard anBoard, int anMove[8], int *pc, const unsigned int
                 if (anBoard[0][23 - an[1]] != 0)
                     continue;
 
-                if (IsValidMove(anBoard, an)) {
+                if (IsValidMove(anBoard, an, anDice)) {
                     memcpy(anMove, an, sizeof(an));
                     ++*pc;
                     break;
@@ -547,7 +539,7 @@ ExpandMatMove(const TanBoard anBoard, int anMove[8], int *pc, const unsigned int
                 if (anBoard[0][23 - an[1]] != 0)
                     continue;
 
-                if (IsValidMove(anBoard, an)) {
+                if (IsValidMove(anBoard, an, anDice)) {
                     memcpy(anMove, an, sizeof(an));
                     ++*pc;
                     break;
@@ -633,7 +625,7 @@ ParseMatMove(char *sz, int iPlayer, int *warned)
             pmr->mt = MOVE_TAKE;
             if (!(prev = LinkToDouble(pmr))) {
                 outputl(_("Take record found but doesn't follow a double"));
-                g_free(pmr);
+                ReleaseMoveRecord(pmr);
                 return;
             }
             pmr->fPlayer = !prev->fPlayer;
@@ -735,7 +727,7 @@ ParseMatMove(char *sz, int iPlayer, int *warned)
 
             /* check if move is valid */
 
-            if (!IsValidMove(msBoard(), pmr->n.anMove)) {
+            if (!IsValidMove(msBoard(), pmr->n.anMove, pmr->anDice)) {
                 if (*warned == -1)
                     outputf(_("WARNING: Invalid move: \"%s\" encountered\n"), sz + 3);
                 else
@@ -779,7 +771,7 @@ ParseMatMove(char *sz, int iPlayer, int *warned)
 
                 /* legal moves; just record roll */
 
-                g_free(pmr);    /* free movenormal from above */
+                ReleaseMoveRecord(pmr);    /* free movenormal from above */
 
                 pmr = NewMoveRecord();
                 pmr->mt = MOVE_SETDICE;
@@ -810,7 +802,7 @@ ParseMatMove(char *sz, int iPlayer, int *warned)
         pmr->fPlayer = iPlayer;
         if (!LinkToDouble(pmr)) {
             outputl(_("Take record found but doesn't follow a double"));
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
             return;
         }
         AddMoveRecord(pmr);
@@ -822,7 +814,7 @@ ParseMatMove(char *sz, int iPlayer, int *warned)
         pmr->fPlayer = iPlayer;
         if (!LinkToDouble(pmr)) {
             outputl(_("Drop record found but doesn't follow a double"));
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
             return;
         }
         AddMoveRecord(pmr);
@@ -1313,9 +1305,9 @@ ParseOldmove(char *sz, int fInvert)
 
             CanonicalMoveOrder(pmr->n.anMove);
 
-            if (!IsValidMove(msBoard(), pmr->n.anMove)) {
+            if (!IsValidMove(msBoard(), pmr->n.anMove, pmr->anDice)) {
                 outputf(_("WARNING! Illegal or invalid move: '%s'\n"), sz);
-                g_free(pmr);
+                ReleaseMoveRecord(pmr);
             } else {
 
                 /* Now we're ready */
@@ -1324,7 +1316,7 @@ ParseOldmove(char *sz, int fInvert)
 
             }
         } else
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
         return;
     } else if (!StrNCaseCmp(sz + 3, "doubles", 7)) {
         pmr = NewMoveRecord();
@@ -1345,7 +1337,7 @@ ParseOldmove(char *sz, int fInvert)
         pmr->fPlayer = iPlayer;
         if (!LinkToDouble(pmr)) {
             outputl(_("Take record found but doesn't follow a double"));
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
             return;
         }
         pmr->stCube = SKILL_NONE;
@@ -1358,7 +1350,7 @@ ParseOldmove(char *sz, int fInvert)
         pmr->fPlayer = iPlayer;
         if (!LinkToDouble(pmr)) {
             outputl(_("Drop record found but doesn't follow a double"));
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
             return;
         }
         pmr->stCube = SKILL_NONE;
@@ -1713,7 +1705,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                         pmr->fPlayer = fPlayer;
                         if (!LinkToDouble(pmr)) {
                             outputl(_("Beaver record found but doesn't follow a double"));
-                            g_free(pmr);
+                            ReleaseMoveRecord(pmr);
                             return;
                         }
 
@@ -1743,7 +1735,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
 
                         AddMoveRecord(pmr);
                     } else
-                        g_free(pmr);
+                        ReleaseMoveRecord(pmr);
 
                     anRoll[0] = 0;
                     szComment = NULL;
@@ -1786,7 +1778,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                                 pmr->fPlayer = fPlayer;
                                 if (!LinkToDouble(pmr)) {
                                     outputl(_("Take record found but doesn't follow a double"));
-                                    g_free(pmr);
+                                    ReleaseMoveRecord(pmr);
                                     return;
                                 }
 
@@ -1834,7 +1826,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                                 pmr->fPlayer = fPlayer;
                                 if (!LinkToDouble(pmr)) {
                                     outputl(_("Take record found but doesn't follow a double"));
-                                    g_free(pmr);
+                                    ReleaseMoveRecord(pmr);
                                     return;
                                 }
 
@@ -1888,7 +1880,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                             pmr->fPlayer = fPlayer;
                             if (!LinkToDouble(pmr)) {
                                 outputl(_("Beaver record found but doesn't follow a double"));
-                                g_free(pmr);
+                                ReleaseMoveRecord(pmr);
                                 return;
                             }
 
@@ -1908,7 +1900,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                             pmr->fPlayer = fPlayer;
                             if (!LinkToDouble(pmr)) {
                                 outputl(_("Raccoon record found but doesn't follow a double"));
-                                g_free(pmr);
+                                ReleaseMoveRecord(pmr);
                                 return;
                             }
 
@@ -1926,7 +1918,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                             pmr->fPlayer = fPlayer;
                             if (!LinkToDouble(pmr)) {
                                 outputl(_("Take record found but doesn't follow a double"));
-                                g_free(pmr);
+                                ReleaseMoveRecord(pmr);
                                 return;
                             }
 
@@ -1941,7 +1933,7 @@ ImportSGGGame(FILE * pf, int i, int nLength, int n0, int n1,
                             pmr->fPlayer = fPlayer;
                             if (!LinkToDouble(pmr)) {
                                 outputl(_("Drop record found but doesn't follow a double"));
-                                g_free(pmr);
+                                ReleaseMoveRecord(pmr);
                                 return;
                             }
 
@@ -2669,7 +2661,7 @@ ImportTMGGame(FILE * pf, int i, int nLength, int n0, int n1,
 
                     AddMoveRecord(pmr);
                 } else
-                    g_free(pmr);
+                    ReleaseMoveRecord(pmr);
 
                 break;
 
@@ -2692,7 +2684,7 @@ ImportTMGGame(FILE * pf, int i, int nLength, int n0, int n1,
                 if (!LinkToDouble(pmr)) {
 
                     outputl(_("Take record found but doesn't follow a double"));
-                    g_free(pmr);
+                    ReleaseMoveRecord(pmr);
                     return;
                 }
 
@@ -2708,7 +2700,7 @@ ImportTMGGame(FILE * pf, int i, int nLength, int n0, int n1,
                 if (!LinkToDouble(pmr)) {
 
                     outputl(_("Drop record found but doesn't follow a double"));
-                    g_free(pmr);
+                    ReleaseMoveRecord(pmr);
                     return;
                 }
 
@@ -3653,6 +3645,204 @@ CommandImportAuto(char *sz)
     g_free(fdp);
 }
 
+typedef enum {
+    BATCH_ARCHIVE,
+    BATCH_SGF,
+    BATCH_ARROW,
+    BATCH_CACHE
+} batchtarget;
+
+static int
+CompareFileNames(gconstpointer p0, gconstpointer p1)
+{
+    return strcmp(*(char *const *) p0, *(char *const *) p1);
+}
+
+/* Add sz to paFiles, or if it is a folder the files in it and in its
+ * subfolders, in name order */
+static void
+AddBatchFiles(GPtrArray * paFiles, const char *sz)
+{
+    GPtrArray *pa;
+    GDir *pd;
+    const char *szName;
+    guint i;
+
+    if (!g_file_test(sz, G_FILE_TEST_IS_DIR)) {
+        g_ptr_array_add(paFiles, g_strdup(sz));
+        return;
+    }
+
+    if (!(pd = g_dir_open(sz, 0, NULL))) {
+        outputerr(sz);
+        return;
+    }
+
+    pa = g_ptr_array_new();
+    while ((szName = g_dir_read_name(pd)) != NULL)
+        if (*szName != '.')
+            g_ptr_array_add(pa, g_build_filename(sz, szName, NULL));
+    g_dir_close(pd);
+
+    g_ptr_array_sort(pa, CompareFileNames);
+    for (i = 0; i < pa->len; i++) {
+        AddBatchFiles(paFiles, pa->pdata[i]);
+        g_free(pa->pdata[i]);
+    }
+    g_ptr_array_free(pa, TRUE);
+}
+
+/* Import each of the files in sz in turn and add it to the archive or
+ * Arrow stream, or save it as SGF in the folder, named by the first
+ * token, or (BATCH_CACHE, without a first token) keep its analyses in
+ * the caches.  Folders stand for all the files in them.  Every importer
+ * builds the match in the global match state, so the files are taken
+ * one at a time, but without any of the questions and updates of an
+ * interactive import. */
+static void
+ImportBatch(char *sz, batchtarget bt)
+{
+    char *szOut = bt == BATCH_CACHE ? sz : NextToken(&sz);
+    char *pch;
+    archive *pa = NULL;
+    arrowwriter *paw = NULL;
+    GPtrArray *paFiles;
+    int fConfirmNew_s = fConfirmNew, fGotoFirstGame_s = fGotoFirstGame;
+    int nDone = 0;
+    unsigned int cMoves = 0, cCubes = 0;
+    guint i;
+
+    if (!szOut || !*szOut || !sz || !*sz) {
+        switch (bt) {
+        case BATCH_ARCHIVE:
+            outputl(_("You must specify an archive and the files to import (see `help import batch archive')."));
+            break;
+        case BATCH_SGF:
+            outputl(_("You must specify a folder and the files to import (see `help import batch sgf')."));
+            break;
+        case BATCH_ARROW:
+            outputl(_("You must specify a file and the files to import (see `help import batch arrow')."));
+            break;
+        case BATCH_CACHE:
+            outputl(_("You must specify the files to import (see `help import batch cache')."));
+            break;
+        }
+        return;
+    }
+
+    switch (bt) {
+    case BATCH_ARCHIVE:
+        if (!(pa = ArchiveOpen(szOut)))
+            return;
+        break;
+    case BATCH_SGF:
+        if (!g_file_test(szOut, G_FILE_TEST_IS_DIR)) {
+            outputerrf(_("`%s' is not a folder"), szOut);
+            return;
+        }
+        break;
+    case BATCH_ARROW:
+        if (!(paw = ArrowOpen(szOut)))
+            return;
+        break;
+    case BATCH_CACHE:
+        break;
+    }
+
+    paFiles = g_ptr_array_new();
+    while ((pch = NextToken(&sz)) != NULL)
+        AddBatchFiles(paFiles, pch);
+
+    fConfirmNew = fGotoFirstGame = FALSE;
+
+    for (i = 0; i < paFiles->len; i++) {
+        char *file = g_strdup_printf("\"%s\"", (char *) paFiles->pdata[i]);
+
+        pch = paFiles->pdata[i];
+        g_free(szCurrentFileName);
+        szCurrentFileName = NULL;
+        CommandImportAuto(file);
+        g_free(file);
+
+        if (!szCurrentFileName || ListEmpty(&lMatch)) {
+            outputerrf(_("Failed to import `%s'"), pch);
+            continue;
+        }
+
+        if (bt == BATCH_ARCHIVE) {
+            if (!ArchiveAddMatch(pa))
+                break;
+        } else if (bt == BATCH_ARROW) {
+            if (!ArrowAddMatch(paw, pch))
+                break;
+        } else if (bt == BATCH_CACHE) {
+            if (!AnalysisCacheMatch(&cMoves, &cCubes)) {
+                outputl(_("The analysis cache is full."));
+                nDone++;
+                break;
+            }
+        } else {
+            char *szBase = g_path_get_basename(pch);
+            char *pchDot = strrchr(szBase, '.');
+            char *szName, *szPath;
+
+            if (pchDot && pchDot != szBase)
+                *pchDot = '\0';
+            szName = g_strdup_printf("%s.sgf", szBase);
+            szPath = g_build_filename(szOut, szName, NULL);
+            file = g_strdup_printf("\"%s\"", szPath);
+            CommandSaveMatch(file);
+            g_free(file);
+            g_free(szPath);
+            g_free(szName);
+            g_free(szBase);
+        }
+        nDone++;
+    }
+
+    fConfirmNew = fConfirmNew_s;
+    fGotoFirstGame = fGotoFirstGame_s;
+
+    if (pa && !ArchiveClose(pa))
+        nDone = 0;
+    if (paw && !ArrowClose(paw))
+        nDone = 0;
+
+    if (bt == BATCH_CACHE)
+        outputf(_("%d of %d files read, %u move and %u cube analyses kept.\n"), nDone, (int) paFiles->len,
+                cMoves, cCubes);
+    else
+        outputf(_("%d of %d files converted.\n"), nDone, (int) paFiles->len);
+
+    for (i = 0; i < paFiles->len; i++)
+        g_free(paFiles->pdata[i]);
+    g_ptr_array_free(paFiles, TRUE);
+}
+
+extern void
+CommandImportBatchArchive(char *sz)
+{
+    ImportBatch(sz, BATCH_ARCHIVE);
+}
+
+extern void
+CommandImportBatchArrow(char *sz)
+{
+    ImportBatch(sz, BATCH_ARROW);
+}
+
+extern void
+CommandImportBatchCache(char *sz)
+{
+    ImportBatch(sz, BATCH_CACHE);
+}
+
+extern void
+CommandImportBatchSGF(char *sz)
+{
+    ImportBatch(sz, BATCH_SGF);
+}
+
 #define BGR_STRING "BGF version"
 static int moveNumBGR;
 
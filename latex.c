@@ -519,6 +519,7 @@ CommandExportGameLaTeX(char *sz)
 {
 
     FILE *pf;
+    char *szTemp;
 
     sz = NextToken(&sz);
 
@@ -535,12 +536,8 @@ CommandExportGameLaTeX(char *sz)
         return;
     }
 
-    if (!strcmp(sz, "-"))
-        pf = stdout;
-    else if ((pf = g_fopen(sz, "w")) == 0) {
-        outputerr(sz);
+    if (!(pf = OpenExportFile(sz, &szTemp)))
         return;
-    }
 
     LaTeXPrologue(pf);
 
@@ -548,8 +545,7 @@ CommandExportGameLaTeX(char *sz)
 
     LaTeXEpilogue(pf);
 
-    if (pf != stdout)
-        fclose(pf);
+    CloseExportFile(pf, sz, szTemp);
 
     setDefaultFileName(sz);
 
@@ -561,7 +557,7 @@ CommandExportMatchLaTeX(char *sz)
 
     FILE *pf;
     listOLD *pl;
-    int fDontClose = FALSE;
+    char *szTemp;
 
     sz = NextToken(&sz);
 
@@ -573,13 +569,8 @@ CommandExportMatchLaTeX(char *sz)
     if (!confirmOverwrite(sz, fConfirmSave))
         return;
 
-    if (!strcmp(sz, "-")) {
-        pf = stdout;
-        fDontClose = TRUE;
-    } else if ((pf = g_fopen(sz, "w")) == 0) {
-        outputerr(sz);
+    if (!(pf = OpenExportFile(sz, &szTemp)))
         return;
-    }
 
     LaTeXPrologue(pf);
 
@@ -590,8 +581,7 @@ CommandExportMatchLaTeX(char *sz)
 
     LaTeXEpilogue(pf);
 
-    if (!fDontClose)
-        fclose(pf);
+    CloseExportFile(pf, sz, szTemp);
 
     setDefaultFileName(sz);
 
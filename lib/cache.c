@@ -20,14 +20,45 @@
 
 #include "config.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "cache.h"
 #include "positionid.h"
 
+#if defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#elif defined(WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__linux__) && defined(HAVE_LINUX_MEMPOLICY_H)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if CACHE_SHARED
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 #if defined(USE_MULTITHREAD)
 #include "multithread.h"
+#endif
+
+#if !defined(MIN)
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#if !defined(MAX)
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#if defined(USE_MULTITHREAD) && !CACHE_VERSIONED
 
 #if defined(__GNUC__) && ( \
     (( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 ) \
@@ -75,18 +106,149 @@ cache_unlock(evalCache * pc, uint32_t k)
 
 #endif
 
-#endif                          /* USE_MULTITHREAD */
+#endif                          /* USE_MULTITHREAD && !CACHE_VERSIONED */
 
 
-int
-CacheCreate(evalCache * pc, unsigned int s)
+/* Nodes of a cache of nominal size s, a power of 2 */
+static inline unsigned int
+CacheNodes(unsigned int s)
 {
-#if CACHE_STATS
-    pc->cLookup = 0;
-    pc->cHit = 0;
-    pc->nAdds = 0;
+    return (s >> 2) ? s >> 2 : 1;
+}
+
+static inline size_t
+RoundUp(size_t cb, size_t cbPage)
+{
+    return (cb + cbPage - 1) & ~(cbPage - 1);
+}
+
+/* Memory for cb bytes of nodes, in huge pages if fHugePages and it
+ * fills one, falling back to ordinary ones.  *ppages tells which. */
+static cacheNode *
+CacheAlloc(size_t cb, int fHugePages, cachepages * ppages)
+{
+    void *p;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_HUGETLB)
+    if (fHugePages && cb >= CACHE_HUGE_PAGE) {
+#if defined(MAP_HUGE_1GB)
+        if (cb >= 1u << 30) {
+            p = mmap(NULL, RoundUp(cb, 1u << 30), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+            if (p != MAP_FAILED) {
+                *ppages = CACHE_PAGES_HUGE_1G;
+                return (cacheNode *) p;
+            }
+        }
+#endif
+        p = mmap(NULL, RoundUp(cb, CACHE_HUGE_PAGE), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            *ppages = CACHE_PAGES_HUGE;
+            return (cacheNode *) p;
+        }
+    }
+#elif defined(WIN32)
+    if (fHugePages && cb >= CACHE_HUGE_PAGE) {
+        /* needs the "Lock pages in memory" privilege */
+        SIZE_T const cbLarge = GetLargePageMinimum();
+
+        if (cbLarge
+            && (p = VirtualAlloc(NULL, RoundUp(cb, cbLarge), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                 PAGE_READWRITE)) != NULL) {
+            *ppages = CACHE_PAGES_HUGE;
+            return (cacheNode *) p;
+        }
+    }
 #endif
 
+    *ppages = CACHE_PAGES_NORMAL;
+
+#if defined(HAVE_POSIX_MEMALIGN)
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_HUGEPAGE)
+    if (fHugePages && cb >= CACHE_HUGE_PAGE) {
+        if (posix_memalign(&p, CACHE_HUGE_PAGE, cb))
+            return NULL;
+        if (!madvise(p, cb, MADV_HUGEPAGE))
+            *ppages = CACHE_PAGES_TRANSPARENT;
+        return (cacheNode *) p;
+    }
+#endif
+    /* aligned to its size so a node shares no cache line with another */
+    return posix_memalign(&p, sizeof(cacheNode), cb) ? NULL : (cacheNode *) p;
+#else
+    (void) p;
+    return (cacheNode *) malloc(cb);
+#endif
+}
+
+#if CACHE_SHARED
+/* The nodes of the shared segment pc->szShared, making it for pc->size
+ * entries if it doesn't exist, else taking its size.  NULL if it can't
+ * be mapped or was made for another evaluator. */
+static cacheNode *
+CacheAttach(evalCache * pc)
+{
+    struct timespec const ts = { 0, 10000000 };
+    cacheSharedHeader *ph;
+    struct stat st;
+    size_t cb = sizeof(cacheNode) + CacheMemory(pc->size);
+    int fCreated = 1;
+    int fd, i;
+    void *p;
+
+    if ((fd = shm_open(pc->szShared, O_RDWR | O_CREAT | O_EXCL, 0600)) >= 0) {
+        /* the new pages read as zeroes, an empty cache */
+        if (ftruncate(fd, (off_t) cb)) {
+            close(fd);
+            shm_unlink(pc->szShared);
+            return NULL;
+        }
+    } else if (errno != EEXIST || (fd = shm_open(pc->szShared, O_RDWR, 0)) < 0)
+        return NULL;
+    else {
+        fCreated = 0;
+        /* its creator may not have sized it yet */
+        for (i = 0; !fstat(fd, &st) && (size_t) st.st_size < sizeof(cacheNode) && i < 100; i++)
+            nanosleep(&ts, NULL);
+        if (fstat(fd, &st) || (size_t) st.st_size < sizeof(cacheNode)) {
+            close(fd);
+            return NULL;
+        }
+        cb = (size_t) st.st_size;
+    }
+
+    p = mmap(NULL, cb, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    ph = (cacheSharedHeader *) p;
+    if (fCreated) {
+        memcpy(ph->szMagic, CACHE_SHARED_MAGIC, sizeof(ph->szMagic));
+        ph->size = pc->size;
+        ph->cbNode = sizeof(cacheNode);
+        memcpy(ph->auchChecksum, pc->auchShared, sizeof(ph->auchChecksum));
+        __atomic_store_n(&ph->nFormat, CACHE_SHARED_FORMAT, __ATOMIC_RELEASE);
+    } else {
+        for (i = 0; !__atomic_load_n(&ph->nFormat, __ATOMIC_ACQUIRE) && i < 100; i++)
+            nanosleep(&ts, NULL);
+        if (ph->nFormat != CACHE_SHARED_FORMAT || memcmp(ph->szMagic, CACHE_SHARED_MAGIC, sizeof(ph->szMagic))
+            || ph->cbNode != sizeof(cacheNode) || memcmp(ph->auchChecksum, pc->auchShared, sizeof(ph->auchChecksum))
+            || ph->size & (ph->size - 1) || sizeof(cacheNode) + CacheMemory(ph->size) != cb) {
+            munmap(p, cb);
+            return NULL;
+        }
+        pc->size = ph->size;
+    }
+
+    return (cacheNode *) p + 1;
+}
+#endif
+
+int
+CacheCreate(evalCache * pc, unsigned int s)
+{
     if (s > 1u << 31)
         return -1;
 
@@ -96,30 +258,50 @@ CacheCreate(evalCache * pc, unsigned int s)
         s &= (s - 1);
 
     pc->size = (s < pc->size) ? 2 * s : s;
-    pc->hashMask = (pc->size >> 1) - 1;
 
-    pc->entries = (cacheNode *) malloc((pc->size / 2) * sizeof(*pc->entries));
-    if (pc->entries == NULL)
+#if CACHE_SHARED
+    if (pc->szShared && (pc->entries = CacheAttach(pc)) != NULL)
+        pc->pages = CACHE_PAGES_SHARED;
+    else
+#endif
+    if ((pc->entries = CacheAlloc(CacheMemory(pc->size), pc->fHugePages, &pc->pages)) == NULL)
         return -1;
 
+    pc->hashMask = CacheNodes(pc->size) - 1;
+    pc->nPageShift = pc->pages == CACHE_PAGES_HUGE_1G ? 30
+        : pc->pages == CACHE_PAGES_NORMAL || pc->pages == CACHE_PAGES_SHARED ? 12 : 21;
+    if (pc->cNodes)
+        CacheInterleave(pc, pc->cNodes);
+
     CacheFlush(pc);
     return 0;
 }
 
-/* MurmurHash3  https://code.google.com/p/smhasher/wiki/MurmurHash */
+size_t
+CacheMemory(unsigned int s)
+{
+    return CacheNodes(s) * sizeof(cacheNode);
+}
 
-extern uint32_t
-GetHashKey(uint32_t hashMask, const cacheNodeDetail * restrict e)
+/* MurmurHash3  https://code.google.com/p/smhasher/wiki/MurmurHash
+ *
+ * Two of them with different seeds, run side by side.  The low half
+ * gives the node and the whole is kept as the check of the entry. */
+
+static inline uint64_t
+CacheHash(const cacheNodeDetail * restrict e)
 {
-    uint32_t hash = (uint32_t) e->nEvalContext;
-    int i;
+    uint32_t hash[2] = { (uint32_t) e->nEvalContext, (uint32_t) e->nEvalContext ^ 0x9e3779b9 };
+    int i, j;
 
-    hash *= 0xcc9e2d51;
-    hash = (hash << 15) | (hash >> (32 - 15));
-    hash *= 0x1b873593;
+    for (j = 0; j < 2; j++) {
+        hash[j] *= 0xcc9e2d51;
+        hash[j] = (hash[j] << 15) | (hash[j] >> (32 - 15));
+        hash[j] *= 0x1b873593;
 
-    hash = (hash << 13) | (hash >> (32 - 13));
-    hash = hash * 5 + 0xe6546b64;
+        hash[j] = (hash[j] << 13) | (hash[j] >> (32 - 13));
+        hash[j] = hash[j] * 5 + 0xe6546b64;
+    }
 
     for (i = 0; i < 7; i++) {
         uint32_t k = e->key.data[i];
@@ -128,172 +310,588 @@ GetHashKey(uint32_t hashMask, const cacheNodeDetail * restrict e)
         k = (k << 15) | (k >> (32 - 15));
         k *= 0x1b873593;
 
-        hash ^= k;
-        hash = (hash << 13) | (hash >> (32 - 13));
-        hash = hash * 5 + 0xe6546b64;
+        for (j = 0; j < 2; j++) {
+            hash[j] ^= k;
+            hash[j] = (hash[j] << 13) | (hash[j] >> (32 - 13));
+            hash[j] = hash[j] * 5 + 0xe6546b64;
+        }
     }
 
     /* Real MurmurHash3 has a "hash ^= len" here,
      * but for us len is constant. Skip it */
 
-    hash ^= hash >> 16;
-    hash *= 0x85ebca6b;
-    hash ^= hash >> 13;
-    hash *= 0xc2b2ae35;
-    hash ^= hash >> 16;
+    for (j = 0; j < 2; j++) {
+        hash[j] ^= hash[j] >> 16;
+        hash[j] *= 0x85ebca6b;
+        hash[j] ^= hash[j] >> 13;
+        hash[j] *= 0xc2b2ae35;
+        hash[j] ^= hash[j] >> 16;
+    }
 
-    return (hash & hashMask);
+    /* never 0, which marks unused entries; the low bits are the node */
+    return (uint64_t) (hash[1] | 1) << 32 | hash[0];
 }
 
+extern uint32_t
+GetHashKey(uint32_t hashMask, const cacheNodeDetail * restrict e)
+{
+    return (uint32_t) CacheHash(e) & hashMask;
+}
+
+static inline void
+CacheRead(const cacheEntry * restrict pe, float *restrict arOut, float *restrict arCubeful)
+{
+    int i;
+
+    for (i = 0; i < 5 /*NUM_OUTPUTS */ ; i++)
+        arOut[i] = pe->asOutput[i] * (1.0f / 65535.0f);
+    if (arCubeful)
+        *arCubeful = pe->rCubeful;
+}
+
+/* The entry of node pn matching check, or NULL */
+static inline cacheEntry *
+CacheFind(cacheNode * restrict pn, uint64_t check)
+{
+    int i;
+
+    for (i = 0; i < CACHE_WAYS; i++)
+        if (pn->ae[i].check == check)
+            return pn->ae + i;
+
+    return NULL;
+}
+
+static inline void
+CacheSet(cacheEntry * restrict pe, const cacheNodeDetail * restrict e, uint64_t check)
+{
+    int i;
+
+    pe->check = check;
+    pe->rCubeful = e->ar[5];
+    for (i = 0; i < 5 /*NUM_OUTPUTS */ ; i++)
+        pe->asOutput[i] = (uint16_t) (MAX(0.0f, MIN(e->ar[i], 1.0f)) * 65535.0f + 0.5f);
+    pe->nPlies = (uint8_t) MIN(e->nPlies, 255);
+}
+
+/* The entry of node pn an entry with check replaces: its own, an
+ * unused one, or the one of largest age halved by ply of depth */
+static inline cacheEntry *
+CacheVictim(cacheNode * restrict pn, uint64_t check)
+{
+    uint8_t const nNow = (uint8_t) (pn->version >> 1);
+    cacheEntry *pe = CacheFind(pn, check);
+    int i;
+
+    if (pe == NULL && (pe = CacheFind(pn, 0)) == NULL) {
+        unsigned int nWorst = 0;
+
+        pe = pn->ae;
+        for (i = 0; i < CACHE_WAYS; i++) {
+            unsigned int const nAge =
+                (unsigned int) (uint8_t) (nNow - pn->ae[i].nStamp) << (8 - MIN(pn->ae[i].nPlies, 8));
+
+            if (nAge > nWorst) {
+                nWorst = nAge;
+                pe = pn->ae + i;
+            }
+        }
+    }
+
+    return pe;
+}
+
+/* Returns 1 if another position had to make room */
+static inline int
+CacheWrite(cacheNode * restrict pn, const cacheNodeDetail * restrict e, uint64_t check)
+{
+    cacheEntry *pe = CacheVictim(pn, check);
+    int const fEvict = pe->check && pe->check != check;
+
+    CacheSet(pe, e, check);
+    pe->nStamp = (uint8_t) ((pn->version >> 1) + 1);
+
+    return fEvict;
+}
+
+#if CACHE_VERSIONED || CACHE_SHARED
+/* Lookup and add of node pn under the version protocol */
+static inline uint32_t
+CacheLookupVersioned(cacheNode * restrict pn, uint64_t check, uint32_t l, float *restrict arOut,
+                     float *restrict arCubeful)
+{
+    unsigned int const version = __atomic_load_n(&pn->version, __ATOMIC_ACQUIRE);
+    const cacheEntry *pe;
+    cacheEntry ce;
+
+    if (version & 1)
+        return l;               /* being written, take it as a miss */
+
+    if ((pe = CacheFind(pn, check)) == NULL)
+        return l;
+
+    ce = *pe;
+
+    /* the entry read above is only valid if no writer came in the
+     * meantime */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&pn->version, __ATOMIC_RELAXED) != version)
+        return l;
+
+    CacheRead(&ce, arOut, arCubeful);
+
+    return CACHEHIT;
+}
+
+static inline int
+CacheAddVersioned(cacheNode * restrict pn, const cacheNodeDetail * restrict e)
+{
+    unsigned int version = __atomic_load_n(&pn->version, __ATOMIC_RELAXED);
+    int fEvict;
+
+    if (version & 1
+        || !__atomic_compare_exchange_n(&pn->version, &version, version + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;               /* another thread is writing this node */
+
+    /* make the odd version visible before any of the new contents */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    fEvict = CacheWrite(pn, e, CacheHash(e));
+
+    __atomic_store_n(&pn->version, version + 2, __ATOMIC_RELEASE);
+
+    return fEvict;
+}
+#endif
 
 uint32_t
 CacheLookupWithLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, float * restrict arOut, float * restrict arCubeful)
 {
-    uint32_t const l = GetHashKey(pc->hashMask, e);
+    uint64_t const check = CacheHash(e);
+    uint32_t const l = (uint32_t) check & pc->hashMask;
+    cacheNode *const pn = &pc->entries[l];
 
-#if CACHE_STATS
-#if defined(USE_MULTITHREAD)
-    MT_SafeInc(&pc->cLookup);
+#if CACHE_VERSIONED
+    return CacheLookupVersioned(pn, check, l, arOut, arCubeful);
 #else
-    ++pc->cLookup;
-#endif
+    {
+        cacheEntry *pe;
+
+#if CACHE_SHARED
+        if (pc->pages == CACHE_PAGES_SHARED)
+            return CacheLookupVersioned(pn, check, l, arOut, arCubeful);
 #endif
 
 #if defined(USE_MULTITHREAD)
-    cache_lock(pc, l);
+        cache_lock(pc, l);
 #endif
 
-    if (!EqualKeys(pc->entries[l].nd_primary.key, e->key) || pc->entries[l].nd_primary.nEvalContext != e->nEvalContext) {       /* Not in primary slot */
-        if (!EqualKeys(pc->entries[l].nd_secondary.key, e->key) || pc->entries[l].nd_secondary.nEvalContext != e->nEvalContext) {       /* Cache miss */
+        if ((pe = CacheFind(pn, check)) == NULL) {
 #if defined(USE_MULTITHREAD)
             cache_unlock(pc, l);
 #endif
             return l;
-        } else {                /* Found in second slot, promote "hot" entry */
-            cacheNodeDetail tmp = pc->entries[l].nd_primary;
-
-            pc->entries[l].nd_primary = pc->entries[l].nd_secondary;
-            pc->entries[l].nd_secondary = tmp;
         }
-    }
-    /* Cache hit */
-    memcpy(arOut, pc->entries[l].nd_primary.ar, sizeof(float) * 5 /*NUM_OUTPUTS */ );
-    if (arCubeful)
-        *arCubeful = pc->entries[l].nd_primary.ar[5];   /* Cubeful equity stored in slot 5 */
 
-#if defined(USE_MULTITHREAD)
-    cache_unlock(pc, l);
-#endif
+        CacheRead(pe, arOut, arCubeful);
+        pe->nStamp = (uint8_t) (pn->version >> 1);
 
-#if CACHE_STATS
 #if defined(USE_MULTITHREAD)
-    MT_SafeInc(&pc->cHit);
-#else
-    ++pc->cHit;
-#endif
+        cache_unlock(pc, l);
 #endif
+    }
 
     return CACHEHIT;
+#endif                          /* CACHE_VERSIONED */
 }
 
 uint32_t
 CacheLookupNoLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, float *restrict arOut, float * restrict arCubeful)
 {
-    uint32_t const l = GetHashKey(pc->hashMask, e);
-
-#if CACHE_STATS
-    ++pc->cLookup;
+    uint64_t const check = CacheHash(e);
+    uint32_t const l = (uint32_t) check & pc->hashMask;
+    cacheNode *const pn = &pc->entries[l];
+    cacheEntry *pe;
+
+#if CACHE_SHARED
+    /* other processes may be writing it */
+    if (pc->pages == CACHE_PAGES_SHARED)
+        return CacheLookupVersioned(pn, check, l, arOut, arCubeful);
 #endif
-    if (!EqualKeys(pc->entries[l].nd_primary.key, e->key) || pc->entries[l].nd_primary.nEvalContext != e->nEvalContext) {       /* Not in primary slot */
-        if (!EqualKeys(pc->entries[l].nd_secondary.key, e->key) || pc->entries[l].nd_secondary.nEvalContext != e->nEvalContext) {       /* Cache miss */
-            return l;
-        } else {                /* Found in second slot, promote "hot" entry */
-            cacheNodeDetail tmp = pc->entries[l].nd_primary;
-
-            pc->entries[l].nd_primary = pc->entries[l].nd_secondary;
-            pc->entries[l].nd_secondary = tmp;
-        }
-    }
 
-    /* Cache hit */
-    memcpy(arOut, pc->entries[l].nd_primary.ar, sizeof(float) * 5 /*NUM_OUTPUTS */ );
-    if (arCubeful)
-        *arCubeful = pc->entries[l].nd_primary.ar[5];   /* Cubeful equity stored in slot 5 */
+    if ((pe = CacheFind(pn, check)) == NULL)
+        return l;               /* Cache miss */
 
-#if CACHE_STATS
-    ++pc->cHit;
-#endif
+    /* Cache hit, counts as young again */
+    CacheRead(pe, arOut, arCubeful);
+    pe->nStamp = (uint8_t) (pn->version >> 1);
 
     return CACHEHIT;
 }
 
-void
+int
 CacheAddWithLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, uint32_t l)
 {
+    cacheNode *const pn = &pc->entries[l];
+#if CACHE_VERSIONED
+    return CacheAddVersioned(pn, e);
+#else
+    int fEvict;
+
+#if CACHE_SHARED
+    if (pc->pages == CACHE_PAGES_SHARED)
+        return CacheAddVersioned(pn, e);
+#endif
+
 #if defined(USE_MULTITHREAD)
     cache_lock(pc, l);
 #endif
 
-    pc->entries[l].nd_secondary = pc->entries[l].nd_primary;
-    pc->entries[l].nd_primary = *e;
+    fEvict = CacheWrite(pn, e, CacheHash(e));
+    pn->version += 2;
 
 #if defined(USE_MULTITHREAD)
     cache_unlock(pc, l);
 #endif
 
-#if CACHE_STATS
-#if defined(USE_MULTITHREAD)
-    MT_SafeInc(&pc->nAdds);
-#else
-    ++pc->nAdds;
+    return fEvict;
 #endif
+}
+
+int
+CacheAddNoLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, uint32_t l)
+{
+    cacheNode *const pn = &pc->entries[l];
+    int fEvict;
+
+#if CACHE_SHARED
+    if (pc->pages == CACHE_PAGES_SHARED)
+        return CacheAddVersioned(pn, e);
 #endif
+
+    fEvict = CacheWrite(pn, e, CacheHash(e));
+    pn->version += 2;
+
+    return fEvict;
+}
+
+uint64_t
+CacheL1Lookup(evalCacheL1 * restrict pl1, const cacheNodeDetail * restrict e, float *restrict arOut)
+{
+    uint64_t const check = CacheHash(e);
+    const cacheEntry *pe = &pl1->ae[(uint32_t) check & (CACHE_L1_SIZE - 1)];
+
+    if (pe->check != check)
+        return check;
+
+    CacheRead(pe, arOut, NULL);
+
+    return 0;
+}
+
+void
+CacheL1Add(evalCacheL1 * restrict pl1, const cacheNodeDetail * restrict e, uint64_t check)
+{
+    CacheSet(&pl1->ae[(uint32_t) check & (CACHE_L1_SIZE - 1)], e, check);
+}
+
+void
+CacheL1Flush(evalCacheL1 * pl1, int nFlush)
+{
+    memset(pl1->ae, 0, sizeof(pl1->ae));
+    pl1->nFlush = nFlush;
+}
+
+unsigned int
+CacheRestore(evalCache * pc, const cacheEntry * ae, unsigned int c, int fReplace)
+{
+    unsigned int i, cRestored = 0;
+
+    if (pc->pages == CACHE_PAGES_SHARED)
+        return 0;
+
+    for (i = 0; i < c; i++) {
+        cacheNode *const pn = &pc->entries[(uint32_t) ae[i].check & pc->hashMask];
+        cacheEntry *pe;
+
+        if (!ae[i].check)
+            continue;
+
+        if (fReplace)
+            pe = CacheVictim(pn, ae[i].check);
+        else if ((pe = CacheFind(pn, 0)) == NULL || CacheFind(pn, ae[i].check))
+            continue;
+
+        *pe = ae[i];
+        pe->nStamp = (uint8_t) ((pn->version >> 1) + 1);
+        pn->version += 2;
+        cRestored++;
+    }
+
+    return cRestored;
 }
 
-/* CacheAddNoLocking() is inlined and in cache.h */
+int
+CacheDump(const evalCache * pc, FILE * pf)
+{
+    unsigned int i, c = 0;
+    int j;
+
+    for (i = 0; i <= pc->hashMask; i++)
+        for (j = 0; j < CACHE_WAYS; j++)
+            if (pc->entries[i].ae[j].check) {
+                if (fwrite(&pc->entries[i].ae[j], sizeof(cacheEntry), 1, pf) != 1)
+                    return -1;
+                c++;
+            }
+
+    return (int) c;
+}
+
+unsigned int
+CacheUsed(const evalCache * pc)
+{
+    unsigned int i, c = 0;
+    int j;
+
+    for (i = 0; pc->entries && i <= pc->hashMask; i++)
+        for (j = 0; j < CACHE_WAYS; j++)
+            c += pc->entries[i].ae[j].check != 0;
+
+    return c;
+}
 
 void
 CacheDestroy(const evalCache * pc)
 {
-    free(pc->entries);
+    switch (pc->pages) {
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_HUGETLB)
+    case CACHE_PAGES_HUGE:
+        munmap(pc->entries, RoundUp(CacheMemory(pc->size), CACHE_HUGE_PAGE));
+        break;
+    case CACHE_PAGES_HUGE_1G:
+        munmap(pc->entries, RoundUp(CacheMemory(pc->size), 1u << 30));
+        break;
+#elif defined(WIN32)
+    case CACHE_PAGES_HUGE:
+        VirtualFree(pc->entries, 0, MEM_RELEASE);
+        break;
+#endif
+#if CACHE_SHARED
+    case CACHE_PAGES_SHARED:
+        /* the segment itself stays for the other processes */
+        munmap(pc->entries - 1, sizeof(cacheNode) + CacheMemory(pc->size));
+        break;
+#endif
+    default:
+        free(pc->entries);
+        break;
+    }
 }
 
 void
 CacheFlush(const evalCache * pc)
 {
-    unsigned int k;
-    for (k = 0; k < pc->size / 2; ++k) {
-        pc->entries[k].nd_primary.key.data[0] = (unsigned int) -1;
-        pc->entries[k].nd_secondary.key.data[0] = (unsigned int) -1;
-#if defined(USE_MULTITHREAD)
-        pc->entries[k].lock = 0;
+    if (pc->pages != CACHE_PAGES_SHARED)
+        memset(pc->entries, 0, CacheMemory(pc->size));
+}
+
+int
+CacheInterleave(evalCache * pc, unsigned int cNodes)
+{
+#if defined(__linux__) && defined(HAVE_LINUX_MEMPOLICY_H) && defined(SYS_mbind)
+    unsigned long mask;
+    int const mode = cNodes < 2 ? MPOL_DEFAULT : MPOL_INTERLEAVE;
+    uintptr_t start, end;
+    long cbPage = sysconf(_SC_PAGESIZE);
+
+    pc->cNodes = 0;
+    if (cNodes > sizeof(mask) * 8)
+        return -1;
+    if (cbPage <= 0)
+        cbPage = 4096;
+
+    mask = cNodes >= sizeof(mask) * 8 ? ~0ul : (1ul << cNodes) - 1;
+    start = RoundUp((uintptr_t) pc->entries, (size_t) cbPage);
+    end = ((uintptr_t) pc->entries + CacheMemory(pc->size)) & ~(uintptr_t) (cbPage - 1);
+
+    /* moves the pages already touched */
+    if (end > start && syscall(SYS_mbind, start, end - start, mode, mode == MPOL_DEFAULT ? NULL : &mask,
+                               sizeof(mask) * 8, MPOL_MF_MOVE))
+        return -1;
+
+    if (mode == MPOL_INTERLEAVE)
+        pc->cNodes = cNodes;
+    return 0;
+#else
+    pc->cNodes = 0;
+    return cNodes < 2 ? 0 : -1;
 #endif
-    }
 }
 
+/* The kernel interleaves by page number, which is close enough to the
+ * offset in the mapping for counting */
 int
-CacheResize(evalCache * pc, unsigned int cNew)
+CacheNodeOf(const evalCache * pc, const cacheNodeDetail * e)
 {
-    if (cNew != pc->size) {
-        CacheDestroy(pc);
-        if (CacheCreate(pc, cNew) != 0)
-            return -1;
+    if (!pc->cNodes)
+        return -1;
+
+    return (int) (((uintptr_t) &pc->entries[GetHashKey(pc->hashMask, e)] >> pc->nPageShift) % pc->cNodes);
+}
+
+int
+CubefulCacheCreate(cubefulCache * pc, unsigned int size)
+{
+    /* a power of 2 no larger than size */
+    while ((size & (size - 1)) != 0)
+        size &= (size - 1);
+    if (size == 0)
+        size = 1;
+
+    pc->hashMask = size - 1;
+#if defined(HAVE_POSIX_MEMALIGN)
+    {
+        void *p;
+
+        pc->entries = posix_memalign(&p, sizeof(cubefulCacheEntry), size * sizeof(cubefulCacheEntry))
+            ? NULL : (cubefulCacheEntry *) p;
     }
+#else
+    pc->entries = (cubefulCacheEntry *) malloc(size * sizeof(cubefulCacheEntry));
+#endif
+    if (pc->entries == NULL)
+        return -1;
 
-    return (int) pc->size;
+    CubefulCacheFlush(pc);
+    return 0;
+}
+
+void
+CubefulCacheDestroy(const cubefulCache * pc)
+{
+    free(pc->entries);
 }
 
-#if CACHE_STATS
 void
-CacheStats(const evalCache * pc, unsigned int *pcLookup, unsigned int *pcHit, unsigned int *pcUsed)
+CubefulCacheFlush(const cubefulCache * pc)
+{
+    memset(pc->entries, 0, (pc->hashMask + 1) * sizeof(cubefulCacheEntry));
+}
+
+/* The two MurmurHash3 lanes of CacheHash() over the key, the number of
+ * cube positions and their contexts */
+uint64_t
+CubefulCacheHash(const positionkey * pkey, const int anContext[], unsigned int cCubes)
+{
+    uint32_t hash[2] = { cCubes, cCubes ^ 0x9e3779b9 };
+    unsigned int i;
+    int j;
+
+    for (i = 0; i < 7 + cCubes; i++) {
+        uint32_t k = i < 7 ? pkey->data[i] : (uint32_t) anContext[i - 7];
+
+        k *= 0xcc9e2d51;
+        k = (k << 15) | (k >> (32 - 15));
+        k *= 0x1b873593;
+
+        for (j = 0; j < 2; j++) {
+            hash[j] ^= k;
+            hash[j] = (hash[j] << 13) | (hash[j] >> (32 - 13));
+            hash[j] = hash[j] * 5 + 0xe6546b64;
+        }
+    }
+
+    for (j = 0; j < 2; j++) {
+        hash[j] ^= hash[j] >> 16;
+        hash[j] *= 0x85ebca6b;
+        hash[j] ^= hash[j] >> 13;
+        hash[j] *= 0xc2b2ae35;
+        hash[j] ^= hash[j] >> 16;
+    }
+
+    return (uint64_t) (hash[1] | 1) << 32 | hash[0];
+}
+
+/* Multi-threaded builds without the __atomic builtins have no way to
+ * guard the entries, so there the cache is never hit */
+
+int
+CubefulCacheLookup(cubefulCache * restrict pc, uint64_t check, float arOut[], float arCubeful[], unsigned int cCubes)
 {
-    if (pcLookup)
-        *pcLookup = pc->cLookup;
+    cubefulCacheEntry *const pe = &pc->entries[(uint32_t) check & pc->hashMask];
+#if CACHE_VERSIONED
+    unsigned int const version = __atomic_load_n(&pe->version, __ATOMIC_ACQUIRE);
+    cubefulCacheEntry ce;
+
+    if (version & 1 || pe->check != check)
+        return -1;
 
-    if (pcHit)
-        *pcHit = pc->cHit;
+    ce = *pe;
 
-    if (pcUsed)
-        *pcUsed = pc->nAdds;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&pe->version, __ATOMIC_RELAXED) != version || ce.check != check)
+        return -1;
+
+    memcpy(arOut, ce.ar, sizeof(ce.ar));
+    memcpy(arCubeful, ce.arCubeful, cCubes * sizeof(float));
+    return 0;
+#elif !defined(USE_MULTITHREAD)
+    if (pe->check != check)
+        return -1;
+
+    memcpy(arOut, pe->ar, sizeof(pe->ar));
+    memcpy(arCubeful, pe->arCubeful, cCubes * sizeof(float));
+    return 0;
+#else
+    (void) pe;
+    (void) arOut;
+    (void) arCubeful;
+    (void) cCubes;
+    return -1;
+#endif
 }
+
+void
+CubefulCacheAdd(cubefulCache * restrict pc, uint64_t check, const float arOut[], const float arCubeful[],
+                unsigned int cCubes)
+{
+    cubefulCacheEntry *const pe = &pc->entries[(uint32_t) check & pc->hashMask];
+#if CACHE_VERSIONED
+    unsigned int version = __atomic_load_n(&pe->version, __ATOMIC_RELAXED);
+
+    if (version & 1
+        || !__atomic_compare_exchange_n(&pe->version, &version, version + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    pe->check = check;
+    memcpy(pe->ar, arOut, sizeof(pe->ar));
+    memcpy(pe->arCubeful, arCubeful, cCubes * sizeof(float));
+
+    __atomic_store_n(&pe->version, version + 2, __ATOMIC_RELEASE);
+#elif !defined(USE_MULTITHREAD)
+    pe->check = check;
+    memcpy(pe->ar, arOut, sizeof(pe->ar));
+    memcpy(pe->arCubeful, arCubeful, cCubes * sizeof(float));
+#else
+    (void) pe;
+    (void) check;
+    (void) arOut;
+    (void) arCubeful;
+    (void) cCubes;
 #endif
+}
+
+int
+CacheResize(evalCache * pc, unsigned int cNew)
+{
+    if (cNew != pc->size) {
+        CacheDestroy(pc);
+        if (CacheCreate(pc, cNew) != 0)
+            return -1;
+    }
+
+    return (int) pc->size;
+}
@@ -23,28 +23,93 @@
 
 #include "config.h"
 
+#include <stddef.h>
+#include <stdio.h>
 #ifdef HAVE_STDINT_H
 #include <stdint.h>
 #else
 typedef unsigned int uint32_t;
+typedef unsigned long long uint64_t;
+typedef unsigned short uint16_t;
+typedef unsigned char uint8_t;
 #endif
 
 #include "gnubg-types.h"
 
-/* Set to calculate simple cache stats */
-#define CACHE_STATS 0
+/* Multi-threaded builds guard the nodes with a version number (a
+ * seqlock) when the compiler has the __atomic builtins, and with a
+ * spinlock otherwise.  A writer makes the version odd while it
+ * changes the node; a reader checks that it was even and unchanged
+ * around its copy and takes a miss otherwise, so lookups never write
+ * to the shared cache.  A writer finding the node busy drops its
+ * entry instead of waiting. */
+#if defined(USE_MULTITHREAD) && defined(__ATOMIC_ACQUIRE)
+#define CACHE_VERSIONED 1
+#else
+#define CACHE_VERSIONED 0
+#endif
+
+/* The nodes can be put in a named POSIX shared memory segment instead,
+ * for the gnubg processes of a host to share one cache.  Its nodes are
+ * then always guarded by their version as above, whatever the build,
+ * so this needs the __atomic builtins too. */
+#if defined(HAVE_SHM_OPEN) && defined(HAVE_SYS_MMAN_H) && defined(__ATOMIC_ACQUIRE)
+#define CACHE_SHARED 1
+#else
+#define CACHE_SHARED 0
+#endif
 
 typedef struct {
     positionkey key;
     int nEvalContext;
+    int nPlies;                 /* depth of the evaluation, for the replacement */
     float ar[6];
 } cacheNodeDetail;
 
+/* The nodes are sets of CACHE_WAYS entries, 128 bytes in all, the two
+ * cache lines the hardware prefetchers fetch together, so a lookup
+ * costs one memory access.  An entry keeps a 64 bit hash of the key
+ * and context instead of the key itself, the five outputs in 16 bit
+ * fixed point (a resolution of 1.5e-5, more than the evaluations are
+ * worth) and only the cubeful equity as a float.  Distinct positions
+ * of one set have the same hash with a probability of about 2^-44
+ * per lookup.  New entries replace the oldest of the set, age
+ * counting the writes to the set since the entry was written or last
+ * hit (lookups of CACHE_VERSIONED builds write nothing and leave it),
+ * halved for every ply of depth, so the expensive evaluations stay
+ * longer. */
+#define CACHE_WAYS 5
+
 typedef struct {
-    cacheNodeDetail nd_primary;
-    cacheNodeDetail nd_secondary;
-#if defined(USE_MULTITHREAD)
+    uint64_t check;             /* hash of key and nEvalContext, 0 if unused */
+    float rCubeful;
+    uint16_t asOutput[5];
+    uint8_t nPlies;
+    uint8_t nStamp;             /* number of writes to the set, modulo 256 */
+} cacheEntry;
+
+/* Large caches are looked up at random and miss the TLB most of the
+ * time with 4 kB pages, so they can be put in huge pages instead:
+ * explicit ones (MAP_HUGETLB on Linux, MEM_LARGE_PAGES on Windows)
+ * when the system has some reserved, else transparent huge pages. */
+typedef enum {
+    CACHE_PAGES_NORMAL,
+    CACHE_PAGES_TRANSPARENT,    /* madvise(MADV_HUGEPAGE) */
+    CACHE_PAGES_HUGE,           /* 2 MB pages, or whatever the Windows large page is */
+    CACHE_PAGES_HUGE_1G,
+    CACHE_PAGES_SHARED          /* a shared memory segment, see CacheCreate() */
+} cachepages;
+
+#define CACHE_HUGE_PAGE (2u << 20)
+
+typedef struct {
+    cacheEntry ae[CACHE_WAYS];
+    unsigned int version;       /* twice the number of writes, odd during one
+                                 * with CACHE_VERSIONED */
+#if defined(USE_MULTITHREAD) && !CACHE_VERSIONED
     int lock;
+#else
+    int unused;
 #endif
 } cacheNode;
 
@@ -57,16 +122,73 @@ typedef struct {
     unsigned int size;
     uint32_t hashMask;
 
-#if CACHE_STATS
-    unsigned int nAdds;
-    unsigned int cLookup;
-    unsigned int cHit;
-#endif
+    int fHugePages;             /* ask CacheCreate() for huge pages */
+    cachepages pages;           /* the pages entries got */
+    unsigned int nPageShift;    /* log2 of their size */
+    unsigned int cNodes;        /* NUMA nodes the pages are interleaved over, or 0 */
+    const char *szShared;       /* shared memory segment CacheCreate() attaches, or NULL */
+    unsigned char auchShared[16];       /* checksum of the evaluator the segment must have */
 } evalCache;
 
-/* Cache size will be adjusted to a power of 2 */
+/* A shared segment starts with this header, padded to a node.  Its
+ * creator writes nFormat last, so the others wait for it to be set
+ * before checking the rest. */
+#define CACHE_SHARED_MAGIC "gnubgsc"
+#define CACHE_SHARED_FORMAT 1
+
+typedef struct {
+    char szMagic[8];
+    uint32_t nFormat;
+    uint32_t size;
+    uint32_t cbNode;
+    unsigned char auchChecksum[16];
+} cacheSharedHeader;
+
+/* A small direct mapped cache private to one thread and put in front
+ * of the shared one.  The positions of one move search recur often
+ * within a thread, and a hit here costs no access to the shared
+ * table.  Entries are valid while nFlush matches the flush count of
+ * the shared cache. */
+#define CACHE_L1_SIZE 512
+
+typedef struct {
+    cacheEntry ae[CACHE_L1_SIZE];
+    int nFlush;
+} evalCacheL1;
+
+/* A direct mapped cache of cubeful evaluations: the cubeless outputs
+ * and the cubeful equities of all the cube positions evaluated
+ * together, up to CUBEFUL_CACHE_CUBES of them, keyed by a hash of the
+ * position and the EvalKey of every cube position.  An entry is one
+ * 64 byte cache line; its version works as the ones of cacheNode. */
+#define CUBEFUL_CACHE_CUBES 8
+
+typedef struct {
+    uint64_t check;             /* 0 if unused */
+    unsigned int version;
+    float ar[5];
+    float arCubeful[CUBEFUL_CACHE_CUBES];
+} cubefulCacheEntry;
+
+typedef struct {
+    cubefulCacheEntry *entries;
+    uint32_t hashMask;
+} cubefulCache;
+
+/* Cache size will be adjusted to a power of 2.  There is a node for
+ * every 4 entries of the size, so the cache holds CACHE_WAYS / 4
+ * times as many.  If szShared is set, the nodes are those of the
+ * shared memory segment of that name, which is made if it doesn't
+ * exist, and whose size is then the one of the cache.  An existing
+ * segment is only used if it was made for the same checksum; if it
+ * wasn't, or it can't be, the cache gets memory of its own and pages
+ * tells so.  Flushing a shared cache does nothing, as the entries are
+ * those of the other processes too: they stay valid as long as the
+ * checksum does.  The segment outlives the processes, until the
+ * system restarts or it is removed (from /dev/shm on Linux). */
 int CacheCreate(evalCache * pc, unsigned int size);
 int CacheResize(evalCache * pc, unsigned int cNew);
+size_t CacheMemory(unsigned int size);
 
 #define CACHEHIT ((uint32_t)-1)
 
@@ -74,24 +196,43 @@ int CacheResize(evalCache * pc, unsigned int cNew);
 unsigned int CacheLookupWithLocking(evalCache * pc, const cacheNodeDetail * e, float *arOut, float *arCubeful);
 unsigned int CacheLookupNoLocking(evalCache * pc, const cacheNodeDetail * e, float *arOut, float *arCubeful);
 
-void CacheAddWithLocking(evalCache * pc, const cacheNodeDetail * e, uint32_t l);
-
-static inline void
-CacheAddNoLocking(evalCache * pc, const cacheNodeDetail * e, const uint32_t l)
-{
-    pc->entries[l].nd_secondary = pc->entries[l].nd_primary;
-    pc->entries[l].nd_primary = *e;
-#if CACHE_STATS
-    ++pc->nAdds;
-#endif
-}
+/* returns 1 if the entry of another position was replaced */
+int CacheAddWithLocking(evalCache * pc, const cacheNodeDetail * e, uint32_t l);
+int CacheAddNoLocking(evalCache * pc, const cacheNodeDetail * e, uint32_t l);
 
 void CacheFlush(const evalCache * pc);
-void CacheDestroy(const evalCache * pc);
 
-#if CACHE_STATS
-void CacheStats(const evalCache * pc, unsigned int *pcLookup, unsigned int *pcHit, unsigned int *pcUsed);
-#endif
+/* Add c entries written by CacheDump(), replacing entries as CacheAdd
+ * does when fReplace and only into unused ones otherwise.  Returns the
+ * number added.  Not thread safe, so shared caches get none. */
+unsigned int CacheRestore(evalCache * pc, const cacheEntry * ae, unsigned int c, int fReplace);
+/* Write the used entries to pf, returns their number or -1 */
+int CacheDump(const evalCache * pc, FILE * pf);
+
+/* returns 0 on a hit, else a value which is passed to CacheL1Add */
+uint64_t CacheL1Lookup(evalCacheL1 * pl1, const cacheNodeDetail * e, float *arOut);
+void CacheL1Add(evalCacheL1 * pl1, const cacheNodeDetail * e, uint64_t check);
+void CacheL1Flush(evalCacheL1 * pl1, int nFlush);
+void CacheDestroy(const evalCache * pc);
+/* number of entries in use */
+unsigned int CacheUsed(const evalCache * pc);
+
+/* Spread the pages of the cache over NUMA nodes 0 to cNodes - 1, so
+ * that a hash picks the node of an entry as it picks the entry, or
+ * undo it if cNodes < 2.  CacheCreate() keeps doing it.  Returns -1
+ * if the system can't (only Linux can). */
+int CacheInterleave(evalCache * pc, unsigned int cNodes);
+/* The node the entry of e is on, or -1 if not interleaved */
+int CacheNodeOf(const evalCache * pc, const cacheNodeDetail * e);
+
+int CubefulCacheCreate(cubefulCache * pc, unsigned int size);
+void CubefulCacheDestroy(const cubefulCache * pc);
+void CubefulCacheFlush(const cubefulCache * pc);
+uint64_t CubefulCacheHash(const positionkey * pkey, const int anContext[], unsigned int cCubes);
+/* returns 0 on a hit */
+int CubefulCacheLookup(cubefulCache * pc, uint64_t check, float arOut[], float arCubeful[], unsigned int cCubes);
+void CubefulCacheAdd(cubefulCache * pc, uint64_t check, const float arOut[], const float arCubeful[],
+                     unsigned int cCubes);
 
 #if defined(HAVE_FUNC_ATTRIBUTE_PURE)
 uint32_t GetHashKey(uint32_t hashMask, const cacheNodeDetail * e) __attribute((pure));
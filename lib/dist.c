@@ -0,0 +1,88 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The products of the 32-roll distributions of the one-sided bearoff
+ * databases, see BearoffEvalOneSided() */
+
+#include "config.h"
+#include "common.h"
+#include "simd.h"
+
+#if defined(USE_SIMD_INSTRUCTIONS)
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#elif defined(USE_AVX)
+#include <immintrin.h>
+#elif defined(USE_SSE2)
+#include <emmintrin.h>
+#else
+#include <xmmintrin.h>
+#endif
+#endif /* USE_SIMD_INSTRUCTIONS */
+
+extern float
+DistProduct(const float ar0[32], const float ar1[32])
+{
+#if defined(USE_SIMD_INSTRUCTIONS) && defined(USE_AVX)
+    __m256 vec0 = _mm256_mul_ps(_mm256_load_ps(ar0), _mm256_load_ps(ar1));
+    __m256 vec1 = _mm256_mul_ps(_mm256_load_ps(ar0 + 8), _mm256_load_ps(ar1 + 8));
+    __m128 sum;
+
+    vec0 = _mm256_add_ps(vec0, _mm256_mul_ps(_mm256_load_ps(ar0 + 16), _mm256_load_ps(ar1 + 16)));
+    vec1 = _mm256_add_ps(vec1, _mm256_mul_ps(_mm256_load_ps(ar0 + 24), _mm256_load_ps(ar1 + 24)));
+    vec0 = _mm256_add_ps(vec0, vec1);
+
+    sum = _mm_add_ps(_mm256_castps256_ps128(vec0), _mm256_extractf128_ps(vec0, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+    return _mm_cvtss_f32(sum);
+#elif defined(USE_SIMD_INSTRUCTIONS) && defined(HAVE_SSE)
+    __m128 vec0 = _mm_mul_ps(_mm_load_ps(ar0), _mm_load_ps(ar1));
+    __m128 vec1 = _mm_mul_ps(_mm_load_ps(ar0 + 4), _mm_load_ps(ar1 + 4));
+    int i;
+
+    for (i = 8; i < 32; i += 8) {
+        vec0 = _mm_add_ps(vec0, _mm_mul_ps(_mm_load_ps(ar0 + i), _mm_load_ps(ar1 + i)));
+        vec1 = _mm_add_ps(vec1, _mm_mul_ps(_mm_load_ps(ar0 + i + 4), _mm_load_ps(ar1 + i + 4)));
+    }
+    vec0 = _mm_add_ps(vec0, vec1);
+
+    vec0 = _mm_add_ps(vec0, _mm_movehl_ps(vec0, vec0));
+    vec0 = _mm_add_ss(vec0, _mm_shuffle_ps(vec0, vec0, 1));
+
+    return _mm_cvtss_f32(vec0);
+#elif defined(USE_SIMD_INSTRUCTIONS) && defined(HAVE_NEON)
+    float32x4_t vec0 = vmulq_f32(vld1q_f32(ar0), vld1q_f32(ar1));
+    float32x4_t vec1 = vmulq_f32(vld1q_f32(ar0 + 4), vld1q_f32(ar1 + 4));
+    int i;
+
+    for (i = 8; i < 32; i += 8) {
+        vec0 = vmlaq_f32(vec0, vld1q_f32(ar0 + i), vld1q_f32(ar1 + i));
+        vec1 = vmlaq_f32(vec1, vld1q_f32(ar0 + i + 4), vld1q_f32(ar1 + i + 4));
+    }
+    vec0 = vaddq_f32(vec0, vec1);
+
+    return vgetq_lane_f32(vec0, 0) + vgetq_lane_f32(vec0, 1) + vgetq_lane_f32(vec0, 2) + vgetq_lane_f32(vec0, 3);
+#else
+    float r = 0.0f;
+    int i;
+
+    for (i = 0; i < 32; ++i)
+        r += ar0[i] * ar1[i];
+
+    return r;
+#endif
+}
@@ -236,3 +236,55 @@ baseInputs(const TanBoard anBoard, float arInput[])
     }
 }
 #endif
+
+/* baseInputs() as the list of its non-zero inputs, at most two per
+ * point: the indices in increasing order in ai[] and the values in
+ * ar[].  Returns their number. */
+extern unsigned int
+baseInputsSparse(const TanBoard anBoard, unsigned int ai[], float ar[])
+{
+    unsigned int j, i, c = 0;
+
+    for (j = 0; j < 2; ++j) {
+        const unsigned int *board = anBoard[j];
+        const unsigned int iBase = j * 25 * 4;
+
+        /* Points */
+        for (i = 0; i < 24; i++) {
+            const unsigned int nc = board[i];
+            const unsigned int k = iBase + i * 4;
+
+            if (!nc)
+                continue;
+
+            if (nc < 3) {
+                ai[c] = k + nc - 1;
+                ar[c++] = 1.0f;
+            } else {
+                ai[c] = k + 2;
+                ar[c++] = 1.0f;
+                if (nc > 3) {
+                    ai[c] = k + 3;
+                    ar[c++] = inpvec[nc][3];
+                }
+            }
+        }
+
+        /* Bar */
+        {
+            const unsigned int nc = board[24];
+            const unsigned int k = iBase + 24 * 4;
+
+            for (i = 0; i < 3 && i < nc; i++) {
+                ai[c] = k + i;
+                ar[c++] = 1.0f;
+            }
+            if (nc > 3) {
+                ai[c] = k + 3;
+                ar[c++] = inpvecb[nc][3];
+            }
+        }
+    }
+
+    return c;
+}
@@ -36,11 +36,56 @@ ListCreate(listOLD * pl)
     return 0;
 }
 
+/* Nodes come from chunks of LIST_CHUNK and go back to a free list
+ * rather than to the allocator, so building and tearing down the long
+ * lists of a match doesn't cost an allocation per element.  Each thread
+ * has its own free list, so that this takes no lock; the nodes left on
+ * it when the thread ends go to plSpare, for the next thread that runs
+ * out.  The chunks are kept for the next lists. */
+#define LIST_CHUNK 1024
+
+static void ListFreeThread(gpointer p);
+
+static GPrivate privFree = G_PRIVATE_INIT(ListFreeThread);
+static listOLD *plSpare;
+static GMutex mutexSpare;
+
+static void
+ListFreeThread(gpointer p)
+{
+    listOLD *pl = p;
+    listOLD *plLast = pl;
+
+    while (plLast->plNext)
+        plLast = plLast->plNext;
+
+    g_mutex_lock(&mutexSpare);
+    plLast->plNext = plSpare;
+    plSpare = pl;
+    g_mutex_unlock(&mutexSpare);
+}
+
 listOLD *
 ListInsert(listOLD * pl, void *p)
 {
 
-    listOLD *plNew = g_malloc(sizeof(listOLD));
+    listOLD *plNew = g_private_get(&privFree);
+
+    if (!plNew) {
+        g_mutex_lock(&mutexSpare);
+        plNew = plSpare;
+        plSpare = NULL;
+        g_mutex_unlock(&mutexSpare);
+    }
+    if (!plNew) {
+        int i;
+
+        plNew = g_new(listOLD, LIST_CHUNK);
+        for (i = 0; i < LIST_CHUNK - 1; i++)
+            plNew[i].plNext = &plNew[i + 1];
+        plNew[LIST_CHUNK - 1].plNext = NULL;
+    }
+    g_private_set(&privFree, plNew->plNext);
 
     plNew->p = p;
 
@@ -60,7 +105,8 @@ ListDelete(listOLD * pl)
     pl->plPrev->plNext = pl->plNext;
     pl->plNext->plPrev = pl->plPrev;
 
-    g_free(pl);
+    pl->plNext = g_private_get(&privFree);
+    g_private_set(&privFree, pl);
 }
 
 void
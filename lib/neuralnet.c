@@ -27,6 +27,7 @@
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "neuralnet.h"
 #include "simd.h"
@@ -42,6 +43,8 @@ NeuralNetCreate(neuralnet * pnn, unsigned int cInput, unsigned int cHidden,
     pnn->rBetaHidden = rBetaHidden;
     pnn->rBetaOutput = rBetaOutput;
     pnn->nTrained = 0;
+    pnn->fMapped = FALSE;
+    pnn->fFastSigmoid = FALSE;
 
     if ((pnn->arHiddenWeight = sse_malloc(cHidden * cInput * sizeof(float))) == NULL)
         return -1;
@@ -70,6 +73,14 @@ NeuralNetCreate(neuralnet * pnn, unsigned int cInput, unsigned int cHidden,
 extern void
 NeuralNetDestroy(neuralnet * pnn)
 {
+    if (pnn->fMapped) {
+        /* the mapping belongs to the caller of NeuralNetMapped() */
+        pnn->arHiddenWeight = pnn->arOutputWeight = NULL;
+        pnn->arHiddenThreshold = pnn->arOutputThreshold = NULL;
+        pnn->fMapped = FALSE;
+        return;
+    }
+
     sse_free(pnn->arHiddenWeight);
     pnn->arHiddenWeight = 0;
     sse_free(pnn->arOutputWeight);
@@ -118,6 +129,57 @@ NNevalAction(NNState * pnState)
     return NNEVAL_NONE;         /* for the picky compiler */
 }
 
+/* Hidden layer activation and output layer.  With NN_FUSED_OUTPUTS
+ * outputs each activation goes straight into the output sums instead
+ * of back to ar[] for one more pass per output. */
+static inline void
+EvaluateOutput(const neuralnet * pnn, float ar[], float arOutput[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const float *prWeight = pnn->arOutputWeight;
+    unsigned int i, j;
+
+    if (pnn->cOutput == NN_FUSED_OUTPUTS) {
+        float r0 = pnn->arOutputThreshold[0], r1 = pnn->arOutputThreshold[1];
+        float r2 = pnn->arOutputThreshold[2], r3 = pnn->arOutputThreshold[3];
+        float r4 = pnn->arOutputThreshold[4];
+
+        for (j = 0; j < cHidden; j++) {
+            float const h = pnn->fFastSigmoid ? sigmoid_fast(-pnn->rBetaHidden * ar[j])
+                : sigmoid(-pnn->rBetaHidden * ar[j]);
+
+            r0 += h * prWeight[j];
+            r1 += h * prWeight[cHidden + j];
+            r2 += h * prWeight[2 * cHidden + j];
+            r3 += h * prWeight[3 * cHidden + j];
+            r4 += h * prWeight[4 * cHidden + j];
+        }
+
+        arOutput[0] = sigmoid(-pnn->rBetaOutput * r0);
+        arOutput[1] = sigmoid(-pnn->rBetaOutput * r1);
+        arOutput[2] = sigmoid(-pnn->rBetaOutput * r2);
+        arOutput[3] = sigmoid(-pnn->rBetaOutput * r3);
+        arOutput[4] = sigmoid(-pnn->rBetaOutput * r4);
+        return;
+    }
+
+    if (pnn->fFastSigmoid)
+        for (j = 0; j < cHidden; j++)
+            ar[j] = sigmoid_fast(-pnn->rBetaHidden * ar[j]);
+    else
+        for (j = 0; j < cHidden; j++)
+            ar[j] = sigmoid(-pnn->rBetaHidden * ar[j]);
+
+    for (i = 0; i < pnn->cOutput; i++) {
+        float r = pnn->arOutputThreshold[i];
+
+        for (j = 0; j < cHidden; j++)
+            r += ar[j] * *prWeight++;
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * r);
+    }
+}
+
 static void
 Evaluate(const neuralnet * pnn, const float arInput[], float ar[], float arOutput[], float *saveAr)
 {
@@ -151,20 +213,7 @@ Evaluate(const neuralnet * pnn, const float arInput[], float ar[], float arOutpu
     if (saveAr)
         memcpy(saveAr, ar, cHidden * sizeof(*saveAr));
 
-    for (i = 0; i < cHidden; i++)
-        ar[i] = sigmoid(-pnn->rBetaHidden * ar[i]);
-
-    /* Calculate activity at output nodes */
-    prWeight = pnn->arOutputWeight;
-
-    for (i = 0; i < pnn->cOutput; i++) {
-        float r = pnn->arOutputThreshold[i];
-
-        for (j = 0; j < cHidden; j++)
-            r += ar[j] * *prWeight++;
-
-        arOutput[i] = sigmoid(-pnn->rBetaOutput * r);
-    }
+    EvaluateOutput(pnn, ar, arOutput);
 }
 
 static void
@@ -199,20 +248,7 @@ EvaluateFromBase(const neuralnet * pnn, const float arInputDif[], float ar[], fl
         }
     }
 
-    for (i = 0; i < pnn->cHidden; i++)
-        ar[i] = sigmoid(-pnn->rBetaHidden * ar[i]);
-
-    /* Calculate activity at output nodes */
-    prWeight = pnn->arOutputWeight;
-
-    for (i = 0; i < pnn->cOutput; i++) {
-        float r = pnn->arOutputThreshold[i];
-
-        for (j = 0; j < pnn->cHidden; j++)
-            r += ar[j] * *prWeight++;
-
-        arOutput[i] = sigmoid(-pnn->rBetaOutput * r);
-    }
+    EvaluateOutput(pnn, ar, arOutput);
 }
 
 extern int
@@ -259,6 +295,315 @@ NeuralNetEvaluate(const neuralnet * pnn, float arInput[], float arOutput[], NNSt
     }
     return 0;
 }
+
+extern void
+NeuralNetHiddenSums(const neuralnet * pnn, const float arInput[], unsigned int cInputBase, float arBase[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const float *prWeight = pnn->arHiddenWeight;
+    unsigned int i, j;
+
+    memcpy(arBase, pnn->arHiddenThreshold, cHidden * sizeof(float));
+
+    for (i = 0; i < cInputBase; i++, prWeight += cHidden) {
+        float const ari = arInput[i];
+
+        if (ari == 0.0f)
+            continue;
+        else if (ari == 1.0f)
+            for (j = 0; j < cHidden; j++)
+                arBase[j] += prWeight[j];
+        else
+            for (j = 0; j < cHidden; j++)
+                arBase[j] += prWeight[j] * ari;
+    }
+}
+
+extern int
+NeuralNetEvaluateDelta(const neuralnet * pnn, const float arBase[], unsigned int cInputBase,
+                       const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                       const float arInput[], float arOutput[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    float *ar = (float *) g_alloca(cHidden * sizeof(float));
+    const float *prWeight;
+    unsigned int i, j;
+
+    memcpy(ar, arBase, cHidden * sizeof(float));
+
+    for (i = 0; i < cDelta; i++) {
+        float const ari = arDelta[i];
+
+        prWeight = pnn->arHiddenWeight + aiDelta[i] * cHidden;
+        for (j = 0; j < cHidden; j++)
+            ar[j] += prWeight[j] * ari;
+    }
+
+    prWeight = pnn->arHiddenWeight + cInputBase * cHidden;
+
+    for (i = cInputBase; i < pnn->cInput; i++, prWeight += cHidden) {
+        float const ari = arInput[i];
+
+        if (ari == 0.0f)
+            continue;
+
+        for (j = 0; j < cHidden; j++)
+            ar[j] += prWeight[j] * ari;
+    }
+
+    EvaluateOutput(pnn, ar, arOutput);
+
+    return 0;
+}
+
+extern int
+NeuralNetEvaluateSparse(const neuralnet * pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                        float arOutput[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    float *arSum = (float *) g_alloca(cHidden * sizeof(float));
+    unsigned int i, j;
+
+    memcpy(arSum, pnn->arHiddenThreshold, cHidden * sizeof(float));
+
+    for (i = 0; i < c; i++) {
+        const float *prWeight = pnn->arHiddenWeight + ai[i] * cHidden;
+        float const ari = ar[i];
+
+        for (j = 0; j < cHidden; j++)
+            arSum[j] += prWeight[j] * ari;
+    }
+
+    EvaluateOutput(pnn, arSum, arOutput);
+
+    return 0;
+}
+
+/* Number of hidden units accumulated at a time by the batch
+ * evaluation; small enough for the partial sums to stay in registers */
+#define BATCH_HIDDEN 32
+
+static void
+EvaluateBlock(const neuralnet * pnn, const float arInputs[], unsigned int cBlock, float ar[], float arOutputs[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int i, j, k, iHidden;
+
+    /* Calculate activity at hidden nodes, one slice of hidden units
+     * at a time for all the positions of the block, so that the slice
+     * of weights is reused from cache */
+    for (iHidden = 0; iHidden < cHidden; iHidden += BATCH_HIDDEN) {
+        unsigned int const c = MIN(BATCH_HIDDEN, cHidden - iHidden);
+
+        for (k = 0; k < cBlock; k++) {
+            const float *arInput = arInputs + k * pnn->cInput;
+            const float *prWeight = pnn->arHiddenWeight + iHidden;
+            float acc[BATCH_HIDDEN];
+
+            for (j = 0; j < c; j++)
+                acc[j] = pnn->arHiddenThreshold[iHidden + j];
+
+            for (i = 0; i < pnn->cInput; i++, prWeight += cHidden) {
+                float const ari = arInput[i];
+
+                if (ari == 0.0f)
+                    continue;
+                else if (ari == 1.0f)
+                    for (j = 0; j < c; j++)
+                        acc[j] += prWeight[j];
+                else
+                    for (j = 0; j < c; j++)
+                        acc[j] += prWeight[j] * ari;
+            }
+
+            memcpy(ar + k * cHidden + iHidden, acc, c * sizeof(float));
+        }
+    }
+
+    for (k = 0; k < cBlock; k++)
+        EvaluateOutput(pnn, ar + k * cHidden, arOutputs + k * pnn->cOutput);
+}
+
+extern int
+NeuralNetEvaluateBatch(const neuralnet * pnn, const float arInputs[], unsigned int n, float arOutputs[])
+{
+    float *ar = (float *) g_alloca(NN_BATCH_BLOCK * pnn->cHidden * sizeof(float));
+    unsigned int i;
+
+    for (i = 0; i < n; i += NN_BATCH_BLOCK)
+        EvaluateBlock(pnn, arInputs + i * pnn->cInput, MIN(NN_BATCH_BLOCK, n - i), ar, arOutputs + i * pnn->cOutput);
+
+    return 0;
+}
+#endif
+
+extern int
+NeuralNetGradientCreate(const neuralnet * pnn, nngradient * png)
+{
+    png->cInput = pnn->cInput;
+    png->cHidden = pnn->cHidden;
+    png->cOutput = pnn->cOutput;
+    png->arHiddenWeight = sse_malloc(pnn->cInput * pnn->cHidden * sizeof(float));
+    png->arOutputWeight = sse_malloc(pnn->cOutput * pnn->cHidden * sizeof(float));
+    png->arHiddenThreshold = sse_malloc(pnn->cHidden * sizeof(float));
+    png->arOutputThreshold = sse_malloc(pnn->cOutput * sizeof(float));
+
+    if (!png->arHiddenWeight || !png->arOutputWeight || !png->arHiddenThreshold || !png->arOutputThreshold) {
+        NeuralNetGradientDestroy(png);
+        return -1;
+    }
+
+    NeuralNetGradientClear(png);
+    return 0;
+}
+
+extern void
+NeuralNetGradientDestroy(nngradient * png)
+{
+    sse_free(png->arHiddenWeight);
+    png->arHiddenWeight = NULL;
+    sse_free(png->arOutputWeight);
+    png->arOutputWeight = NULL;
+    sse_free(png->arHiddenThreshold);
+    png->arHiddenThreshold = NULL;
+    sse_free(png->arOutputThreshold);
+    png->arOutputThreshold = NULL;
+}
+
+extern void
+NeuralNetGradientClear(nngradient * png)
+{
+    memset(png->arHiddenWeight, 0, png->cInput * png->cHidden * sizeof(float));
+    memset(png->arOutputWeight, 0, png->cOutput * png->cHidden * sizeof(float));
+    memset(png->arHiddenThreshold, 0, png->cHidden * sizeof(float));
+    memset(png->arOutputThreshold, 0, png->cOutput * sizeof(float));
+    png->n = 0;
+    png->rError = 0.0;
+}
+
+static void
+AddScaled(float ar[], const float arOther[], unsigned int c, float r)
+{
+    unsigned int i;
+
+    for (i = 0; i < c; i++)
+        ar[i] += r * arOther[i];
+}
+
+extern void
+NeuralNetGradientAdd(nngradient * png, const nngradient * pngOther)
+{
+    AddScaled(png->arHiddenWeight, pngOther->arHiddenWeight, png->cInput * png->cHidden, 1.0f);
+    AddScaled(png->arOutputWeight, pngOther->arOutputWeight, png->cOutput * png->cHidden, 1.0f);
+    AddScaled(png->arHiddenThreshold, pngOther->arHiddenThreshold, png->cHidden, 1.0f);
+    AddScaled(png->arOutputThreshold, pngOther->arOutputThreshold, png->cOutput, 1.0f);
+    png->n += pngOther->n;
+    png->rError += pngOther->rError;
+}
+
+extern int
+NeuralNetTrain(neuralnet * pnn, const nngradient * png, float rAlpha)
+{
+    float r;
+
+    if (pnn->fMapped) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!png->n)
+        return 0;
+
+    r = -rAlpha / (float) png->n;
+    AddScaled(pnn->arHiddenWeight, png->arHiddenWeight, pnn->cInput * pnn->cHidden, r);
+    AddScaled(pnn->arOutputWeight, png->arOutputWeight, pnn->cOutput * pnn->cHidden, r);
+    AddScaled(pnn->arHiddenThreshold, png->arHiddenThreshold, pnn->cHidden, r);
+    AddScaled(pnn->arOutputThreshold, png->arOutputThreshold, pnn->cOutput, r);
+    pnn->nTrained += (int) png->n;
+
+    return 0;
+}
+
+#if !defined(USE_SIMD_INSTRUCTIONS) || !(defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON))
+/* One position of NeuralNetGradient().  The forward pass leaves the
+ * hidden activations in ar[], the backward pass the error at the
+ * hidden sums in arDelta[]. */
+static void
+Gradient(const neuralnet * pnn, const float arInput[], const float arTarget[], float ar[], float arDelta[],
+         nngradient * png)
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const float *prWeight;
+    float *prGrad;
+    unsigned int i, j, k;
+
+    memcpy(ar, pnn->arHiddenThreshold, cHidden * sizeof(float));
+    for (i = 0, prWeight = pnn->arHiddenWeight; i < pnn->cInput; i++, prWeight += cHidden) {
+        float const ari = arInput[i];
+
+        if (ari == 0.0f)
+            continue;
+
+        for (j = 0; j < cHidden; j++)
+            ar[j] += ari * prWeight[j];
+    }
+
+    for (j = 0; j < cHidden; j++) {
+        ar[j] = pnn->fFastSigmoid ? sigmoid_fast(-pnn->rBetaHidden * ar[j]) : sigmoid(-pnn->rBetaHidden * ar[j]);
+        arDelta[j] = 0.0f;
+    }
+
+    /* the output is sigmoid(-beta * sum), whose derivative by the sum
+     * is beta * output * (1 - output) */
+    for (k = 0; k < pnn->cOutput; k++) {
+        float r = pnn->arOutputThreshold[k], rOutput, rError, rDelta;
+
+        prWeight = pnn->arOutputWeight + k * cHidden;
+        for (j = 0; j < cHidden; j++)
+            r += ar[j] * prWeight[j];
+
+        rOutput = sigmoid(-pnn->rBetaOutput * r);
+        rError = rOutput - arTarget[k];
+        png->rError += rError * rError;
+        rDelta = rError * pnn->rBetaOutput * rOutput * (1.0f - rOutput);
+
+        png->arOutputThreshold[k] += rDelta;
+        prGrad = png->arOutputWeight + k * cHidden;
+        for (j = 0; j < cHidden; j++) {
+            prGrad[j] += rDelta * ar[j];
+            arDelta[j] += rDelta * prWeight[j];
+        }
+    }
+
+    for (j = 0; j < cHidden; j++) {
+        arDelta[j] *= pnn->rBetaHidden * ar[j] * (1.0f - ar[j]);
+        png->arHiddenThreshold[j] += arDelta[j];
+    }
+
+    for (i = 0, prGrad = png->arHiddenWeight; i < pnn->cInput; i++, prGrad += cHidden) {
+        float const ari = arInput[i];
+
+        if (ari == 0.0f)
+            continue;
+
+        for (j = 0; j < cHidden; j++)
+            prGrad[j] += ari * arDelta[j];
+    }
+
+    png->n++;
+}
+
+extern void
+NeuralNetGradient(const neuralnet * pnn, const float arInputs[], const float arTargets[], unsigned int n,
+                  nngradient * png)
+{
+    float *ar = (float *) g_alloca(pnn->cHidden * sizeof(float));
+    float *arDelta = (float *) g_alloca(pnn->cHidden * sizeof(float));
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+        Gradient(pnn, arInputs + i * pnn->cInput, arTargets + i * pnn->cOutput, ar, arDelta, png);
+}
 #endif
 
 extern int
@@ -359,14 +704,243 @@ NeuralNetSaveBinary(const neuralnet * pnn, FILE * pf)
     return 0;
 }
 
+/* Layout of the NeuralNetSaveMapped() files.  nByteOrder tells files
+ * written on a machine of the other endianness, which are refused. */
+#define NN_MAPPED_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char szMagic[8];
+    uint32_t nFormat;
+    uint32_t nByteOrder;
+    uint32_t cNets;
+    char szVersion[16];
+} nnmappedheader;
+
+typedef struct {
+    uint32_t cInput;
+    uint32_t cHidden;
+    uint32_t cOutput;
+    int32_t nTrained;
+    float rBetaHidden;
+    float rBetaOutput;
+    /* hidden weights, output weights, hidden and output thresholds */
+    uint32_t acb[4];
+    uint32_t aOffset[4];
+} nnmappednet;
+
+static inline uint32_t
+MappedAlign(uint32_t cb)
+{
+    return (cb + NN_MAPPED_ALIGN - 1) & ~(uint32_t) (NN_MAPPED_ALIGN - 1);
+}
+
+static void
+MappedArrays(const neuralnet * pnn, const float *apr[4], uint32_t acb[4])
+{
+    apr[0] = pnn->arHiddenWeight;
+    acb[0] = pnn->cInput * pnn->cHidden * sizeof(float);
+    apr[1] = pnn->arOutputWeight;
+    acb[1] = pnn->cHidden * pnn->cOutput * sizeof(float);
+    apr[2] = pnn->arHiddenThreshold;
+    acb[2] = pnn->cHidden * sizeof(float);
+    apr[3] = pnn->arOutputThreshold;
+    acb[3] = pnn->cOutput * sizeof(float);
+}
+
+extern int
+NeuralNetSaveMapped(const neuralnet * const apnn[], unsigned int cNets, const char *szVersion, FILE * pf)
+{
+    static const char achPad[NN_MAPPED_ALIGN];
+    nnmappedheader h;
+    nnmappednet *anm = g_alloca(cNets * sizeof(nnmappednet));
+    uint32_t cb;
+    unsigned int i, j;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.szMagic, NN_MAPPED_MAGIC, sizeof(NN_MAPPED_MAGIC));
+    h.nFormat = NN_MAPPED_FORMAT;
+    h.nByteOrder = NN_MAPPED_BYTE_ORDER;
+    h.cNets = cNets;
+    g_strlcpy(h.szVersion, szVersion, sizeof(h.szVersion));
+
+    cb = MappedAlign(sizeof(h) + cNets * sizeof(nnmappednet));
+
+    for (i = 0; i < cNets; i++) {
+        const float *apr[4];
+
+        memset(anm + i, 0, sizeof(nnmappednet));
+        anm[i].cInput = apnn[i]->cInput;
+        anm[i].cHidden = apnn[i]->cHidden;
+        anm[i].cOutput = apnn[i]->cOutput;
+        anm[i].nTrained = apnn[i]->nTrained;
+        anm[i].rBetaHidden = apnn[i]->rBetaHidden;
+        anm[i].rBetaOutput = apnn[i]->rBetaOutput;
+        MappedArrays(apnn[i], apr, anm[i].acb);
+
+        for (j = 0; j < 4; j++) {
+            anm[i].aOffset[j] = cb;
+            cb = MappedAlign(cb + anm[i].acb[j]);
+        }
+    }
+
+#define FWRITE( p, c ) \
+    if ( fwrite( (p), 1, (c), pf ) < (size_t)(c) ) return -1
+
+    FWRITE(&h, sizeof(h));
+    FWRITE(anm, cNets * sizeof(nnmappednet));
+    cb = sizeof(h) + cNets * sizeof(nnmappednet);
+
+    for (i = 0; i < cNets; i++) {
+        const float *apr[4];
+        uint32_t acb[4];
+
+        MappedArrays(apnn[i], apr, acb);
+
+        for (j = 0; j < 4; j++) {
+            FWRITE(achPad, anm[i].aOffset[j] - cb);
+            FWRITE(apr[j], acb[j]);
+            cb = anm[i].aOffset[j] + acb[j];
+        }
+    }
+#undef FWRITE
+
+    return 0;
+}
+
+/* Point the cNets nets of apnn[] into the cb bytes at p, a mapping of
+ * a NeuralNetSaveMapped() file of weights version szVersion.  The
+ * mapping must be at least NN_MAPPED_ALIGN aligned, which page aligned
+ * mappings are, and outlive the nets. */
+extern int
+NeuralNetMapped(const void *p, size_t cb, const char *szVersion, neuralnet * const apnn[], unsigned int cNets)
+{
+    const nnmappedheader *ph = p;
+    const nnmappednet *anm = (const nnmappednet *) (ph + 1);
+    unsigned int i, j;
+
+    if ((uintptr_t) p % NN_MAPPED_ALIGN || cb < sizeof(*ph)
+        || memcmp(ph->szMagic, NN_MAPPED_MAGIC, sizeof(NN_MAPPED_MAGIC)) || ph->nFormat != NN_MAPPED_FORMAT
+        || ph->nByteOrder != NN_MAPPED_BYTE_ORDER || ph->cNets != cNets
+        || cb < sizeof(*ph) + cNets * sizeof(nnmappednet)
+        || strncmp(ph->szVersion, szVersion, sizeof(ph->szVersion))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (i = 0; i < cNets; i++) {
+        const nnmappednet *pnm = anm + i;
+
+        if (pnm->cInput < 1 || pnm->cHidden < 1 || pnm->cOutput < 1 || pnm->rBetaHidden <= 0.0f
+            || pnm->rBetaOutput <= 0.0f || pnm->acb[0] != pnm->cInput * pnm->cHidden * sizeof(float)
+            || pnm->acb[1] != pnm->cHidden * pnm->cOutput * sizeof(float)
+            || pnm->acb[2] != pnm->cHidden * sizeof(float) || pnm->acb[3] != pnm->cOutput * sizeof(float)) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        for (j = 0; j < 4; j++)
+            if (pnm->aOffset[j] % NN_MAPPED_ALIGN || pnm->aOffset[j] > cb || pnm->acb[j] > cb - pnm->aOffset[j]) {
+                errno = EINVAL;
+                return -1;
+            }
+    }
+
+    for (i = 0; i < cNets; i++) {
+        const nnmappednet *pnm = anm + i;
+        neuralnet *pnn = apnn[i];
+
+        pnn->cInput = pnm->cInput;
+        pnn->cHidden = pnm->cHidden;
+        pnn->cOutput = pnm->cOutput;
+        pnn->nTrained = pnm->nTrained;
+        pnn->rBetaHidden = pnm->rBetaHidden;
+        pnn->rBetaOutput = pnm->rBetaOutput;
+        /* the nets are never written to, the mapping stays read-only */
+        pnn->arHiddenWeight = (float *) ((const char *) p + pnm->aOffset[0]);
+        pnn->arOutputWeight = (float *) ((const char *) p + pnm->aOffset[1]);
+        pnn->arHiddenThreshold = (float *) ((const char *) p + pnm->aOffset[2]);
+        pnn->arOutputThreshold = (float *) ((const char *) p + pnm->aOffset[3]);
+        pnn->fMapped = TRUE;
+        pnn->fFastSigmoid = FALSE;
+    }
+
+    return 0;
+}
+
 
 #if defined(USE_SIMD_INSTRUCTIONS)
 
+#if defined(USE_SIMD_DISPATCH)
+
+#include <cpuid.h>
+
+/* Pick the widest neural net kernel the CPU and the OS (saving the
+ * wider registers at context switch) both support */
+static void
+SelectKernel(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0;
+    int fFMA, fAVX512;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return;
+
+    /* OSXSAVE, AVX and FMA */
+    if ((ecx & (bit_OSXSAVE | bit_AVX | bit_FMA)) != (bit_OSXSAVE | bit_AVX | bit_FMA))
+        return;
+
+    __asm__ __volatile__("xgetbv":"=a"(xcr0), "=d"(edx):"c"(0));
+
+    if ((xcr0 & 0x06) != 0x06)  /* SSE and AVX state */
+        return;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return;
+
+    fFMA = (ebx & bit_AVX2) != 0;
+    /* AVX-512 also needs the opmask and upper ZMM state */
+    fAVX512 = (ebx & bit_AVX512F) && (xcr0 & 0xE6) == 0xE6;
+
+    if (fAVX512)
+        NeuralNetSetKernel(SIMD_KERNEL_AVX512);
+    else if (fFMA)
+        NeuralNetSetKernel(SIMD_KERNEL_FMA);
+}
+
+#elif defined(USE_SVE_DISPATCH)
+
+#include <sys/auxv.h>
+
+#if !defined(HWCAP_SVE)
+#define HWCAP_SVE (1 << 22)
+#endif
+
+/* The SVE kernels if the kernel reports SVE in the hwcaps, which also
+ * means it saves the SVE state at context switch; unlike CheckNEON()
+ * nothing has to trap */
+static void
+SelectKernel(void)
+{
+    if (getauxval(AT_HWCAP) & HWCAP_SVE)
+        NeuralNetSetKernel(SIMD_KERNEL_SVE);
+}
+
+#endif
+
 #if defined(DISABLE_SIMD_TEST)
 
 int
 SIMD_Supported(void)
 {
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+    static int fSelected = FALSE;
+
+    if (!fSelected) {
+        SelectKernel();
+        fSelected = TRUE;
+    }
+#endif
     return 1;
 }
 
@@ -561,6 +1135,10 @@ SIMD_Supported(void)
         state = CheckSSE();
 #else
         state = -2;
+#endif
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+        if (state == 1)
+            SelectKernel();
 #endif
     }
 
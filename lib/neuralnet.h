@@ -35,8 +35,29 @@ typedef struct {
     float *arOutputWeight;
     float *arHiddenThreshold;
     float *arOutputThreshold;
+    int fMapped;                /* arrays point into a NeuralNetMapped() file */
+    int fFastSigmoid;           /* hidden layer uses sigmoid_fast(), see sigmoid.h */
 } neuralnet;
 
+/* Number of outputs for which the evaluations accumulate the output
+ * layer during the hidden activation pass, in registers; that of all
+ * the gnubg nets */
+#define NN_FUSED_OUTPUTS 5
+
+/* Number of hidden units of the shipped contact, crashed and race nets,
+ * for which the SIMD evaluation has kernels with constant loop counts */
+#define NN_SHIPPED_HIDDEN 128
+
+/* Memory mappable weights container.  A header and one descriptor per
+ * net are followed by the weight arrays, each NN_MAPPED_ALIGN byte
+ * aligned and in the layout the evaluation uses, so NeuralNetMapped()
+ * points the nets into a read-only mapping of the file instead of
+ * reading and copying them.  Processes mapping the same file share one
+ * copy of the weights in the page cache. */
+#define NN_MAPPED_MAGIC "gnubgwm"
+#define NN_MAPPED_FORMAT 1
+#define NN_MAPPED_ALIGN 64
+
 typedef enum {
     NNEVAL_NONE,
     NNEVAL_SAVE,
@@ -64,11 +85,122 @@ extern int NeuralNetEvaluate(const neuralnet * pnn, float arInput[], float arOut
 #else
 extern int NeuralNetEvaluateSSE(const neuralnet * pnn, float arInput[], float arOutput[], NNState * pnState);
 #endif
+/* Evaluate n input vectors stored consecutively in arInputs (n *
+ * cInput floats), writing n * cOutput floats to arOutputs.  The
+ * positions are processed in blocks of NN_BATCH_BLOCK so that each
+ * row of hidden weights is loaded once per block instead of once per
+ * position. */
+#define NN_BATCH_BLOCK 16
+extern int NeuralNetEvaluateBatch(const neuralnet * pnn, const float arInputs[], unsigned int n, float arOutputs[]);
+
+/* Training by mini-batch gradient descent on the squared error of the
+ * outputs.  A gradient has the shape of its net: NeuralNetGradient()
+ * adds that of n positions (n * cInput inputs, n * cOutput targets) to
+ * it, NeuralNetGradientAdd() sums those of the threads a batch was
+ * shared out to, and NeuralNetTrain() steps the weights down the mean
+ * gradient by rAlpha.  The forward pass is that of the evaluation, so
+ * the weights stay in the form NeuralNetSaveBinary() and the
+ * evaluation use.  Mapped nets can't be trained. */
+typedef struct {
+    unsigned int cInput;
+    unsigned int cHidden;
+    unsigned int cOutput;
+    float *arHiddenWeight;
+    float *arOutputWeight;
+    float *arHiddenThreshold;
+    float *arOutputThreshold;
+    unsigned int n;             /* positions added */
+    double rError;              /* their summed squared error */
+} nngradient;
+
+extern int NeuralNetGradientCreate(const neuralnet * pnn, nngradient * png);
+extern void NeuralNetGradientDestroy(nngradient * png);
+extern void NeuralNetGradientClear(nngradient * png);
+extern void NeuralNetGradientAdd(nngradient * png, const nngradient * pngOther);
+extern void NeuralNetGradient(const neuralnet * pnn, const float arInputs[], const float arTargets[], unsigned int n,
+                              nngradient * png);
+extern int NeuralNetTrain(neuralnet * pnn, const nngradient * png, float rAlpha);
+/* Evaluator taking over NeuralNetEvaluateBatch() for large batches,
+ * typically offloading them to an accelerator.  pfEvaluateBatch() has
+ * the same contract and returns non zero if it could not evaluate the
+ * batch, which is then evaluated on the CPU.  Batches of fewer than
+ * cBatchMin positions are never handed over, as copying them to the
+ * device would cost more than evaluating them.  The nets are the
+ * same from one call to the next until the weights are reloaded, so
+ * their weights may be kept on the device keyed by pnn. */
+typedef struct {
+    const char *szName;
+    unsigned int cBatchMin;
+    int (*pfEvaluateBatch) (const neuralnet * pnn, const float arInputs[], unsigned int n, float arOutputs[]);
+} nnbackend;
+/* Incremental evaluation against a base position.  NeuralNetHiddenSums()
+ * stores in arBase the hidden node sums, thresholds included, of the
+ * first cInputBase inputs of the base.  NeuralNetEvaluateDelta() then
+ * evaluates a position whose first cInputBase inputs differ from the
+ * base's only at the cDelta indices aiDelta[], by arDelta[]; its other
+ * inputs are taken from arInput[cInputBase...].  arBase must have the
+ * alignment of SSE_ALIGN(). */
+extern void NeuralNetHiddenSums(const neuralnet * pnn, const float arInput[], unsigned int cInputBase, float arBase[]);
+extern int NeuralNetEvaluateDelta(const neuralnet * pnn, const float arBase[], unsigned int cInputBase,
+                                  const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                                  const float arInput[], float arOutput[]);
+/* Evaluation from the list of the c non-zero inputs only, their indices
+ * in increasing order in ai[] and their values in ar[], as made by
+ * baseInputsSparse(): only the weight rows of those inputs are read and
+ * there is no test on each input. */
+extern int NeuralNetEvaluateSparse(const neuralnet * pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                                   float arOutput[]);
 extern int NeuralNetLoad(neuralnet * pnn, FILE * pf);
 extern int NeuralNetLoadBinary(neuralnet * pnn, FILE * pf);
 extern int NeuralNetSaveBinary(const neuralnet * pnn, FILE * pf);
+extern int NeuralNetSaveMapped(const neuralnet * const apnn[], unsigned int cNets, const char *szVersion, FILE * pf);
+extern int NeuralNetMapped(const void *p, size_t cb, const char *szVersion, neuralnet * const apnn[],
+                           unsigned int cNets);
 extern int SIMD_Supported(void);
 
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+/* Kernels compiled for instruction sets wider than the build's own,
+ * chosen by SIMD_Supported() according to what the CPU reports */
+typedef enum {
+    SIMD_KERNEL_DEFAULT,
+    SIMD_KERNEL_FMA,
+    SIMD_KERNEL_AVX512,
+    SIMD_KERNEL_SVE
+} simdkernel;
+
+extern void NeuralNetSetKernel(simdkernel kernel);
+extern simdkernel NeuralNetGetKernel(void);
+extern const char *NeuralNetKernelName(simdkernel kernel);
+#endif
+
+#if defined(USE_SIMD_DISPATCH)
+extern int NeuralNetEvaluateFMA(const neuralnet * pnn, const float arInput[], float arOutput[]);
+extern int NeuralNetEvaluateBatchFMA(const neuralnet * pnn, const float arInputs[], unsigned int n, float arOutputs[]);
+extern int NeuralNetEvaluateAVX512(const neuralnet * pnn, const float arInput[], float arOutput[]);
+extern int NeuralNetEvaluateBatchAVX512(const neuralnet * pnn, const float arInputs[], unsigned int n,
+                                        float arOutputs[]);
+extern void NeuralNetHiddenSumsFMA(const neuralnet * pnn, const float arInput[], unsigned int cInputBase,
+                                   float arBase[]);
+extern int NeuralNetEvaluateDeltaFMA(const neuralnet * pnn, const float arBase[], unsigned int cInputBase,
+                                     const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                                     const float arInput[], float arOutput[]);
+extern void NeuralNetHiddenSumsAVX512(const neuralnet * pnn, const float arInput[], unsigned int cInputBase,
+                                      float arBase[]);
+extern int NeuralNetEvaluateDeltaAVX512(const neuralnet * pnn, const float arBase[], unsigned int cInputBase,
+                                        const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                                        const float arInput[], float arOutput[]);
+#endif
+
+#if defined(USE_SVE_DISPATCH)
+extern int NeuralNetEvaluateSVE(const neuralnet * pnn, const float arInput[], float arOutput[]);
+extern int NeuralNetEvaluateBatchSVE(const neuralnet * pnn, const float arInputs[], unsigned int n, float arOutputs[]);
+extern void NeuralNetHiddenSumsSVE(const neuralnet * pnn, const float arInput[], unsigned int cInputBase,
+                                   float arBase[]);
+extern int NeuralNetEvaluateDeltaSVE(const neuralnet * pnn, const float arBase[], unsigned int cInputBase,
+                                     const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                                     const float arInput[], float arOutput[]);
+#endif
+
 /* Try to determine whether we are 64-bit or 32-bit */
 #if defined(_WIN32) || defined(_WIN64)
 #if defined(_WIN64)
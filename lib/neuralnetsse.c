@@ -261,6 +261,80 @@ sigmoid_ps(float_vector xin)
 #endif
 }
 
+/* sigmoid_fast() of -xin, the counterpart of sigmoid_ps() without
+ * its table lookups; see sigmoid.h for the error */
+static inline float_vector
+sigmoid_fast_ps(float_vector xin)
+{
+#if defined(USE_AVX)
+    float_vector x = _mm256_mul_ps(xin, _mm256_set1_ps(-SIGMOID_FAST_LOG2E));
+    float_vector n, p, scale;
+
+    x = _mm256_min_ps(x, _mm256_set1_ps(SIGMOID_FAST_LIMIT));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-SIGMOID_FAST_LIMIT));
+    x = _mm256_add_ps(x, _mm256_set1_ps(SIGMOID_FAST_BIAS));
+    n = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(x));
+    x = _mm256_sub_ps(x, n);
+    scale = _mm256_add_ps(n, _mm256_set1_ps(127.0f - SIGMOID_FAST_BIAS));
+    scale = _mm256_castsi256_ps(_mm256_cvttps_epi32(_mm256_mul_ps(scale, _mm256_set1_ps(8388608.0f))));
+#if defined(USE_FMA3)
+    p = _mm256_fmadd_ps(_mm256_set1_ps(SIGMOID_FAST_C3), x, _mm256_set1_ps(SIGMOID_FAST_C2));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(SIGMOID_FAST_C1));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(SIGMOID_FAST_C0));
+    x = _mm256_fmadd_ps(p, scale, ones.ps);
+#else
+    p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIGMOID_FAST_C3), x), _mm256_set1_ps(SIGMOID_FAST_C2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(SIGMOID_FAST_C1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(SIGMOID_FAST_C0));
+    x = _mm256_add_ps(_mm256_mul_ps(p, scale), ones.ps);
+#endif
+#ifdef __FAST_MATH__
+    return _mm256_rcp_ps(x);
+#else
+    return _mm256_div_ps(ones.ps, x);
+#endif
+#elif defined(HAVE_SSE)
+    float_vector x = _mm_mul_ps(xin, _mm_set1_ps(-SIGMOID_FAST_LOG2E));
+    float_vector n, p, scale;
+
+    x = _mm_min_ps(x, _mm_set1_ps(SIGMOID_FAST_LIMIT));
+    x = _mm_max_ps(x, _mm_set1_ps(-SIGMOID_FAST_LIMIT));
+    x = _mm_add_ps(x, _mm_set1_ps(SIGMOID_FAST_BIAS));
+    n = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    x = _mm_sub_ps(x, n);
+    scale = _mm_add_ps(n, _mm_set1_ps(127.0f - SIGMOID_FAST_BIAS));
+    scale = _mm_castsi128_ps(_mm_cvttps_epi32(_mm_mul_ps(scale, _mm_set1_ps(8388608.0f))));
+    p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIGMOID_FAST_C3), x), _mm_set1_ps(SIGMOID_FAST_C2));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(SIGMOID_FAST_C1));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(SIGMOID_FAST_C0));
+    x = _mm_add_ps(_mm_mul_ps(p, scale), ones.ps);
+#ifdef __FAST_MATH__
+    return _mm_rcp_ps(x);
+#else
+    return _mm_div_ps(ones.ps, x);
+#endif
+#else
+    float_vector x = vmulq_f32(xin, vdupq_n_f32(-SIGMOID_FAST_LOG2E));
+    float_vector n, p, scale, rec;
+
+    x = vminq_f32(x, vdupq_n_f32(SIGMOID_FAST_LIMIT));
+    x = vmaxq_f32(x, vdupq_n_f32(-SIGMOID_FAST_LIMIT));
+    x = vaddq_f32(x, vdupq_n_f32(SIGMOID_FAST_BIAS));
+    n = vcvtq_f32_s32(vcvtq_s32_f32(x));
+    x = vsubq_f32(x, n);
+    scale = vaddq_f32(n, vdupq_n_f32(127.0f - SIGMOID_FAST_BIAS));
+    scale = vreinterpretq_f32_s32(vcvtq_s32_f32(vmulq_f32(scale, vdupq_n_f32(8388608.0f))));
+    p = vmlaq_f32(vdupq_n_f32(SIGMOID_FAST_C2), vdupq_n_f32(SIGMOID_FAST_C3), x);
+    p = vmlaq_f32(vdupq_n_f32(SIGMOID_FAST_C1), p, x);
+    p = vmlaq_f32(vdupq_n_f32(SIGMOID_FAST_C0), p, x);
+    x = vmlaq_f32(ones.ps, p, scale);
+
+    rec = vrecpeq_f32(x);
+    rec = vmulq_f32(vrecpsq_f32(x, rec), rec);
+    return vmulq_f32(vrecpsq_f32(x, rec), rec);
+#endif
+}
+
 #endif                          // USE_SSE2 or USE_AVX
 
 #if defined(USE_SSE2)
@@ -325,12 +399,96 @@ for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE
 }
 #endif
 
-static void
-EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[])
+#if defined(USE_AVX)
+#define VEC_LOAD(p) _mm256_load_ps(p)
+#define VEC_STORE(p, v) _mm256_store_ps(p, v)
+#define VEC_SET1(r) _mm256_set1_ps(r)
+#define VEC_MUL(a, b) _mm256_mul_ps(a, b)
+#define VEC_ADD(a, b) _mm256_add_ps(a, b)
+#define VEC_SUB(a, b) _mm256_sub_ps(a, b)
+#if defined(USE_FMA3)
+#define VEC_MADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define VEC_MADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+#elif defined(HAVE_SSE)
+#define VEC_LOAD(p) _mm_load_ps(p)
+#define VEC_STORE(p, v) _mm_store_ps(p, v)
+#define VEC_SET1(r) _mm_set1_ps(r)
+#define VEC_MUL(a, b) _mm_mul_ps(a, b)
+#define VEC_ADD(a, b) _mm_add_ps(a, b)
+#define VEC_SUB(a, b) _mm_sub_ps(a, b)
+#define VEC_MADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#else
+#define VEC_LOAD(p) vld1q_f32(p)
+#define VEC_STORE(p, v) vst1q_f32(p, v)
+#define VEC_SET1(r) vdupq_n_f32(r)
+#define VEC_MUL(a, b) vmulq_f32(a, b)
+#define VEC_ADD(a, b) vaddq_f32(a, b)
+#define VEC_SUB(a, b) vsubq_f32(a, b)
+#define VEC_MADD(a, b, c) vmlaq_f32(c, a, b)
+#endif
+
+#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
+static inline float
+HorizontalSumSSE(float_vector v)
+{
+#if defined(USE_AVX)
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(x);
+#elif defined(HAVE_SSE)
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(v);
+#else
+    float32x2_t x = vadd_f32(vget_high_f32(v), vget_low_f32(v));
+
+    return vget_lane_f32(vpadd_f32(x, x), 0);
+#endif
+}
+
+/* EvaluateOutputSSE() for NN_FUSED_OUTPUTS outputs: each vector of
+ * hidden activations goes straight into the five output sums, kept in
+ * registers, instead of being stored and read back once per output */
+static SIMD_INLINE void
+EvaluateOutputFusedSSE(const neuralnet * restrict pnn, const float ar[], float arOutput[],
+                       const unsigned int cHidden)
+{
+    const float_vector scalevec = VEC_SET1(pnn->rBetaHidden);
+    const float *prWeight = pnn->arOutputWeight;
+    float_vector sum0 = VEC_SET1(0.0f), sum1 = sum0, sum2 = sum0, sum3 = sum0, sum4 = sum0;
+    unsigned int j;
+
+    for (j = 0; j < cHidden; j += VEC_SIZE) {
+        float_vector vec = VEC_MUL(VEC_LOAD(ar + j), scalevec);
+
+        vec = pnn->fFastSigmoid ? sigmoid_fast_ps(vec) : sigmoid_ps(vec);
+        sum0 = VEC_MADD(vec, VEC_LOAD(prWeight + j), sum0);
+        sum1 = VEC_MADD(vec, VEC_LOAD(prWeight + cHidden + j), sum1);
+        sum2 = VEC_MADD(vec, VEC_LOAD(prWeight + 2 * cHidden + j), sum2);
+        sum3 = VEC_MADD(vec, VEC_LOAD(prWeight + 3 * cHidden + j), sum3);
+        sum4 = VEC_MADD(vec, VEC_LOAD(prWeight + 4 * cHidden + j), sum4);
+    }
+
+    arOutput[0] = sigmoid(-pnn->rBetaOutput * (HorizontalSumSSE(sum0) + pnn->arOutputThreshold[0]));
+    arOutput[1] = sigmoid(-pnn->rBetaOutput * (HorizontalSumSSE(sum1) + pnn->arOutputThreshold[1]));
+    arOutput[2] = sigmoid(-pnn->rBetaOutput * (HorizontalSumSSE(sum2) + pnn->arOutputThreshold[2]));
+    arOutput[3] = sigmoid(-pnn->rBetaOutput * (HorizontalSumSSE(sum3) + pnn->arOutputThreshold[3]));
+    arOutput[4] = sigmoid(-pnn->rBetaOutput * (HorizontalSumSSE(sum4) + pnn->arOutputThreshold[4]));
+}
+#endif
+
+/* Hidden layer activation and output layer, shared by the single and
+ * batch evaluations */
+static inline void
+EvaluateOutputSSE(const neuralnet * restrict pnn, float ar[], float arOutput[])
 {
     const unsigned int cHidden = pnn->cHidden;
     unsigned int i, j;
-    float *prWeight;
+    const float *prWeight;
 #if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
     float *par;
 #if defined(USE_FMA3)
@@ -338,6 +496,136 @@ EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], f
 #else
     float_vector vec0, vec1, vec3, scalevec, sum;
 #endif
+#endif
+
+#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
+    if (pnn->cOutput == NN_FUSED_OUTPUTS) {
+        EvaluateOutputFusedSSE(pnn, ar, arOutput, cHidden);
+        return;
+    }
+
+#if defined(USE_AVX)
+    scalevec = _mm256_set1_ps(pnn->rBetaHidden);
+#elif defined(HAVE_SSE)
+    scalevec = _mm_set1_ps(pnn->rBetaHidden);
+#else
+    scalevec = vdupq_n_f32(pnn->rBetaHidden);
+#endif
+
+    for (par = ar, i = (cHidden >> LOG2VEC_SIZE); i; i--, par += VEC_SIZE) {
+#if defined(USE_AVX)
+        float_vector vec = _mm256_load_ps(par);
+        vec = _mm256_mul_ps(vec, scalevec);
+        vec = pnn->fFastSigmoid ? sigmoid_fast_ps(vec) : sigmoid_ps(vec);
+        _mm256_store_ps(par, vec);
+#elif defined(HAVE_SSE)
+        float_vector vec = _mm_load_ps(par);
+        vec = _mm_mul_ps(vec, scalevec);
+        vec = pnn->fFastSigmoid ? sigmoid_fast_ps(vec) : sigmoid_ps(vec);
+        _mm_store_ps(par, vec);
+#else
+        float_vector vec = vld1q_f32(par);
+        vec = vmulq_f32(vec, scalevec);
+        vec = pnn->fFastSigmoid ? sigmoid_fast_ps(vec) : sigmoid_ps(vec);
+        vst1q_f32(par, vec);
+#endif
+    }
+#else
+    if (pnn->fFastSigmoid)
+        for (i = 0; i < cHidden; i++)
+            ar[i] = sigmoid_fast(-pnn->rBetaHidden * ar[i]);
+    else
+        for (i = 0; i < cHidden; i++)
+            ar[i] = sigmoid(-pnn->rBetaHidden * ar[i]);
+#endif
+
+    /* Calculate activity at output nodes */
+    prWeight = pnn->arOutputWeight;
+
+    for (i = 0; i < pnn->cOutput; i++) {
+
+#if defined(USE_AVX)
+        SSE_ALIGN(float r[8]);
+#else
+        float r;
+#endif
+        float *pr = ar;
+#if defined(USE_AVX)
+        sum = _mm256_setzero_ps();
+#elif defined(HAVE_SSE)
+        sum = _mm_setzero_ps();
+#else
+        sum = vdupq_n_f32(0.0f);
+#endif
+        for (j = (cHidden >> LOG2VEC_SIZE); j; j--, prWeight += VEC_SIZE, pr += VEC_SIZE) {
+#if defined(USE_AVX)
+            vec0 = _mm256_load_ps(pr);  /* Eight floats into vec0 */
+            vec1 = _mm256_load_ps(prWeight);    /* Eight weights into vec1 */
+#if defined(USE_FMA3)
+            sum = _mm256_fmadd_ps(vec0, vec1, sum);
+#else
+            vec3 = _mm256_mul_ps(vec0, vec1);   /* Multiply */
+            sum = _mm256_add_ps(sum, vec3);     /* Add */
+#endif
+#elif defined(HAVE_SSE)
+            vec0 = _mm_load_ps(pr);     /* Four floats into vec0 */
+            vec1 = _mm_load_ps(prWeight);       /* Four weights into vec1 */
+            vec3 = _mm_mul_ps(vec0, vec1);      /* Multiply */
+            sum = _mm_add_ps(sum, vec3);        /* Add */
+#else
+            vec0 = vld1q_f32(pr);     /* Four floats into vec0 */
+            vec1 = vld1q_f32(prWeight);       /* Four weights into vec1 */
+            vec3 = vmulq_f32(vec0, vec1);      /* Multiply */
+            sum = vaddq_f32(sum, vec3);        /* Add */
+#endif
+        }
+
+#if defined(USE_AVX)
+        vec0 = _mm256_hadd_ps(sum, sum);
+        vec1 = _mm256_hadd_ps(vec0, vec0);
+        _mm256_store_ps(r, vec1);
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r[0] + r[4] + pnn->arOutputThreshold[i]));
+#elif defined(HAVE_SSE)
+        vec0 = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+        vec1 = _mm_add_ps(sum, vec0);
+        vec0 = _mm_shuffle_ps(vec1, vec1, _MM_SHUFFLE(1, 1, 3, 3));
+        sum = _mm_add_ps(vec1, vec0);
+        _mm_store_ss(&r, sum);
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
+
+#else
+       {
+       float32x2_t vec0_h, vec0_l, vec1;
+
+       vec0_h = vget_high_f32(sum);
+       vec0_l = vget_low_f32(sum);
+       vec1 = vpadd_f32(vec0_h, vec0_l);
+       vec1 = vpadd_f32(vec1, vec1);
+       vst1_lane_f32(&r, vec1, 0);
+
+       arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
+       }
+#endif
+    }
+}
+
+/* Hidden and output layers for a net of cInput inputs and cHidden
+ * hidden units.  Always inlined, so that the callers passing constants
+ * get every loop over the hidden units with a constant trip count */
+static SIMD_INLINE void
+EvaluateDimsSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[],
+                const unsigned int cInput, const unsigned int cHidden)
+{
+    unsigned int i, j;
+    float *prWeight;
+#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
+#if defined(USE_FMA3)
+    float_vector vec0, vec1, scalevec, sum;
+#else
+    float_vector vec0, vec1, vec3, scalevec, sum;
+#endif
 #endif
 
     /* Calculate activity at hidden nodes */
@@ -345,7 +633,7 @@ EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], f
 
     prWeight = pnn->arHiddenWeight;
 
-    if (pnn->cInput != 214) {   /* everything but the racing net */
+    if (cInput != 214) {        /* everything but the racing net */
         for (i = 0; i < 200;) { /* base inputs */
             float ari = arInput[i++];
 
@@ -408,7 +696,7 @@ EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], f
             }                   /* base inputs are done */
         }
 
-        if (pnn->cInput == 250) /* Pruning nets are over, contact/crashed still have 2 * 25 floats */
+        if (cInput == 250)      /* Pruning nets are over, contact/crashed still have 2 * 25 floats */
             for (i = 200; i < 250; i++) {
                 float const ari = arInput[i];
 
@@ -430,7 +718,7 @@ EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], f
     }
 
     else                        /* racing net */
-        for (i = 0; i < pnn->cInput; i++) {
+        for (i = 0; i < cInput; i++) {
             float const ari = arInput[i];
 
             if (likely(ari == 0.0f))
@@ -459,126 +747,447 @@ EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], f
         }
 
 #if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
-#if defined(USE_AVX)
-    scalevec = _mm256_set1_ps(pnn->rBetaHidden);
-#elif defined(HAVE_SSE)
-    scalevec = _mm_set1_ps(pnn->rBetaHidden);
-#else
-    scalevec = vdupq_n_f32(pnn->rBetaHidden);
+    if (cHidden == NN_SHIPPED_HIDDEN && pnn->cOutput == NN_FUSED_OUTPUTS)
+        EvaluateOutputFusedSSE(pnn, ar, arOutput, cHidden);
+    else
 #endif
+        EvaluateOutputSSE(pnn, ar, arOutput);
 
-    for (par = ar, i = (cHidden >> LOG2VEC_SIZE); i; i--, par += VEC_SIZE) {
 #if defined(USE_AVX)
-        float_vector vec = _mm256_load_ps(par);
-        vec = _mm256_mul_ps(vec, scalevec);
-        vec = sigmoid_ps(vec);
-        _mm256_store_ps(par, vec);
-#elif defined(HAVE_SSE)
-        float_vector vec = _mm_load_ps(par);
-        vec = _mm_mul_ps(vec, scalevec);
-        vec = sigmoid_ps(vec);
-        _mm_store_ps(par, vec);
-#else
-        float_vector vec = vld1q_f32(par);
-        vec = vmulq_f32(vec, scalevec);
-        vec = sigmoid_ps(vec);
-        vst1q_f32(par, vec);
+    _mm256_zeroupper();
 #endif
+}
+
+/* The shipped contact and crashed (250 inputs) and race (214 inputs)
+ * nets get kernels of their own.  Anything else, such as the pruning
+ * nets or a net from the trainer, goes through the generic one */
+static void
+EvaluateContactSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[])
+{
+    EvaluateDimsSSE(pnn, arInput, ar, arOutput, 250, NN_SHIPPED_HIDDEN);
+}
+
+static void
+EvaluateRaceSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[])
+{
+    EvaluateDimsSSE(pnn, arInput, ar, arOutput, 214, NN_SHIPPED_HIDDEN);
+}
+
+static void
+EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[])
+{
+    if (pnn->cHidden == NN_SHIPPED_HIDDEN && pnn->cOutput == NN_FUSED_OUTPUTS) {
+        if (pnn->cInput == 250) {
+            EvaluateContactSSE(pnn, arInput, ar, arOutput);
+            return;
+        }
+        if (pnn->cInput == 214) {
+            EvaluateRaceSSE(pnn, arInput, ar, arOutput);
+            return;
+        }
     }
+
+    EvaluateDimsSSE(pnn, arInput, ar, arOutput, pnn->cInput, pnn->cHidden);
+}
+
+
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+static simdkernel simdKernel = SIMD_KERNEL_DEFAULT;
+
+extern void
+NeuralNetSetKernel(simdkernel kernel)
+{
+    simdKernel = kernel;
+}
+
+extern simdkernel
+NeuralNetGetKernel(void)
+{
+    return simdKernel;
+}
+
+extern const char *
+NeuralNetKernelName(simdkernel kernel)
+{
+    switch (kernel) {
+    case SIMD_KERNEL_FMA:
+        return "avx2/fma";
+    case SIMD_KERNEL_AVX512:
+        return "avx-512";
+    case SIMD_KERNEL_SVE:
+        return "sve";
+    default:
+#if defined(USE_NEON)
+        return "neon";
+#elif defined(USE_AVX)
+        return "avx";
 #else
-    for (i = 0; i < cHidden; i++)
-        ar[i] = sigmoid(-pnn->rBetaHidden * ar[i]);
+        return "sse";
+#endif
+    }
+}
 #endif
 
-    /* Calculate activity at output nodes */
-    prWeight = pnn->arOutputWeight;
+extern int
+NeuralNetEvaluateSSE(const neuralnet * restrict pnn, /*lint -e{818} */ float arInput[],
+                     float arOutput[], NNState * UNUSED(pnState))
+{
+    SSE_ALIGN(float ar[pnn->cHidden]);
 
-    for (i = 0; i < pnn->cOutput; i++) {
+#if defined(USE_SIMD_DISPATCH)
+    /* the wide kernels need whole vectors of hidden units */
+    if (simdKernel == SIMD_KERNEL_AVX512 && !(pnn->cHidden % 16))
+        return NeuralNetEvaluateAVX512(pnn, arInput, arOutput);
+    if (simdKernel != SIMD_KERNEL_DEFAULT && !(pnn->cHidden % 8))
+        return NeuralNetEvaluateFMA(pnn, arInput, arOutput);
+#endif
+#if defined(USE_SVE_DISPATCH)
+    /* predicated, so any number of hidden units */
+    if (simdKernel == SIMD_KERNEL_SVE)
+        return NeuralNetEvaluateSVE(pnn, arInput, arOutput);
+#endif
 
-#if defined(USE_AVX)
-        SSE_ALIGN(float r[8]);
-#else
-        float r;
+#if DEBUG_SSE
+    g_assert(sse_aligned(arOutput));
+    g_assert(sse_aligned(ar));
+    g_assert(sse_aligned(arInput));
 #endif
-        float *pr = ar;
+
+    EvaluateSSE(pnn, arInput, ar, arOutput);
+    return 0;
+}
+
+/* Number of vectors of hidden units kept in registers by the batch
+ * evaluation */
+#define BATCH_VECS 8
+
+/* Accumulate cVec vectors of hidden units starting at iHidden for one
+ * position.  The partial sums stay in registers for the whole pass
+ * over the inputs and the slice of weights they use (cInput * cVec *
+ * VEC_SIZE floats) stays in L1 from one position of the block to the
+ * next. */
+static inline void
+AccumulateHiddenSSE(const neuralnet * restrict pnn, const float arInput[], unsigned int iHidden,
+                    const unsigned int cVec, float ar[])
+{
+    const float *prWeight = pnn->arHiddenWeight + iHidden;
+    float_vector acc[BATCH_VECS];
+    unsigned int i, v;
+
+    for (v = 0; v < cVec; v++)
+        acc[v] = VEC_LOAD(pnn->arHiddenThreshold + iHidden + v * VEC_SIZE);
+
+    for (i = 0; i < pnn->cInput; i++, prWeight += pnn->cHidden) {
+        float const ari = arInput[i];
+        float_vector scalevec;
+
+        if (likely(ari == 0.0f))
+            continue;
+
+        scalevec = VEC_SET1(ari);
+        for (v = 0; v < cVec; v++)
+            acc[v] = VEC_MADD(VEC_LOAD(prWeight + v * VEC_SIZE), scalevec, acc[v]);
+    }
+
+    for (v = 0; v < cVec; v++)
+        VEC_STORE(ar + iHidden + v * VEC_SIZE, acc[v]);
+}
+
+static void
+EvaluateBlockSSE(const neuralnet * restrict pnn, const float arInputs[], unsigned int cBlock, float ar[],
+                 float arOutputs[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int iHidden, k;
+
+    /* Calculate activity at hidden nodes, one slice of hidden units
+     * at a time for all the positions of the block */
+    for (iHidden = 0; iHidden < cHidden;) {
+        if (cHidden - iHidden >= BATCH_VECS * VEC_SIZE) {
+            for (k = 0; k < cBlock; k++)
+                AccumulateHiddenSSE(pnn, arInputs + k * pnn->cInput, iHidden, BATCH_VECS, ar + k * cHidden);
+            iHidden += BATCH_VECS * VEC_SIZE;
+        } else {
+            for (k = 0; k < cBlock; k++)
+                AccumulateHiddenSSE(pnn, arInputs + k * pnn->cInput, iHidden, 1, ar + k * cHidden);
+            iHidden += VEC_SIZE;
+        }
+    }
+
+    for (k = 0; k < cBlock; k++)
+        EvaluateOutputSSE(pnn, ar + k * cHidden, arOutputs + k * pnn->cOutput);
+
 #if defined(USE_AVX)
-        sum = _mm256_setzero_ps();
-#elif defined(HAVE_SSE)
-        sum = _mm_setzero_ps();
-#else
-        sum = vdupq_n_f32(0.0f);
+    _mm256_zeroupper();
 #endif
-        for (j = (cHidden >> LOG2VEC_SIZE); j; j--, prWeight += VEC_SIZE, pr += VEC_SIZE) {
-#if defined(USE_AVX)
-            vec0 = _mm256_load_ps(pr);  /* Eight floats into vec0 */
-            vec1 = _mm256_load_ps(prWeight);    /* Eight weights into vec1 */
-#if defined(USE_FMA3)
-            sum = _mm256_fmadd_ps(vec0, vec1, sum);
-#else
-            vec3 = _mm256_mul_ps(vec0, vec1);   /* Multiply */
-            sum = _mm256_add_ps(sum, vec3);     /* Add */
+}
+
+extern int
+NeuralNetEvaluateBatch(const neuralnet * restrict pnn, const float arInputs[], unsigned int n, float arOutputs[])
+{
+    SSE_ALIGN(float ar[NN_BATCH_BLOCK * pnn->cHidden]);
+    unsigned int i;
+
+#if defined(USE_SIMD_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_AVX512 && !(pnn->cHidden % 16))
+        return NeuralNetEvaluateBatchAVX512(pnn, arInputs, n, arOutputs);
+    if (simdKernel != SIMD_KERNEL_DEFAULT && !(pnn->cHidden % 8))
+        return NeuralNetEvaluateBatchFMA(pnn, arInputs, n, arOutputs);
 #endif
-#elif defined(HAVE_SSE)
-            vec0 = _mm_load_ps(pr);     /* Four floats into vec0 */
-            vec1 = _mm_load_ps(prWeight);       /* Four weights into vec1 */
-            vec3 = _mm_mul_ps(vec0, vec1);      /* Multiply */
-            sum = _mm_add_ps(sum, vec3);        /* Add */
-#else
-            vec0 = vld1q_f32(pr);     /* Four floats into vec0 */
-            vec1 = vld1q_f32(prWeight);       /* Four weights into vec1 */
-            vec3 = vmulq_f32(vec0, vec1);      /* Multiply */
-            sum = vaddq_f32(sum, vec3);        /* Add */
+#if defined(USE_SVE_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_SVE)
+        return NeuralNetEvaluateBatchSVE(pnn, arInputs, n, arOutputs);
 #endif
+
+    for (i = 0; i < n; i += NN_BATCH_BLOCK)
+        EvaluateBlockSSE(pnn, arInputs + i * pnn->cInput, MIN(NN_BATCH_BLOCK, n - i), ar,
+                         arOutputs + i * pnn->cOutput);
+
+    return 0;
+}
+
+#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
+/* One position of NeuralNetGradient().  The forward pass is that of
+ * the batch evaluation and leaves the hidden activations in ar[]; the
+ * backward pass leaves the error at the hidden sums in arDelta[]. */
+static void
+GradientSSE(const neuralnet * restrict pnn, const float arInput[], const float arTarget[], float ar[],
+            float arDelta[], nngradient * restrict png)
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const float_vector betavec = VEC_SET1(pnn->rBetaHidden);
+    const float_vector onevec = VEC_SET1(1.0f);
+    float *prGrad;
+    unsigned int i, j, k;
+
+    for (j = 0; j < cHidden;) {
+        if (cHidden - j >= BATCH_VECS * VEC_SIZE) {
+            AccumulateHiddenSSE(pnn, arInput, j, BATCH_VECS, ar);
+            j += BATCH_VECS * VEC_SIZE;
+        } else {
+            AccumulateHiddenSSE(pnn, arInput, j, 1, ar);
+            j += VEC_SIZE;
         }
+    }
+
+    for (j = 0; j < cHidden; j += VEC_SIZE) {
+        float_vector vec = VEC_MUL(VEC_LOAD(ar + j), betavec);
+
+        VEC_STORE(ar + j, pnn->fFastSigmoid ? sigmoid_fast_ps(vec) : sigmoid_ps(vec));
+        VEC_STORE(arDelta + j, VEC_SET1(0.0f));
+    }
+
+    /* the output is sigmoid(-beta * sum), whose derivative by the sum
+     * is beta * output * (1 - output) */
+    for (k = 0; k < pnn->cOutput; k++) {
+        const float *prWeight = pnn->arOutputWeight + k * cHidden;
+        float_vector sum = VEC_SET1(0.0f), deltavec;
+        float rOutput, rError, rDelta;
+
+        for (j = 0; j < cHidden; j += VEC_SIZE)
+            sum = VEC_MADD(VEC_LOAD(ar + j), VEC_LOAD(prWeight + j), sum);
+
+        rOutput = sigmoid(-pnn->rBetaOutput * (HorizontalSumSSE(sum) + pnn->arOutputThreshold[k]));
+        rError = rOutput - arTarget[k];
+        png->rError += rError * rError;
+        rDelta = rError * pnn->rBetaOutput * rOutput * (1.0f - rOutput);
+
+        png->arOutputThreshold[k] += rDelta;
+        deltavec = VEC_SET1(rDelta);
+        prGrad = png->arOutputWeight + k * cHidden;
+        for (j = 0; j < cHidden; j += VEC_SIZE) {
+            VEC_STORE(prGrad + j, VEC_MADD(VEC_LOAD(ar + j), deltavec, VEC_LOAD(prGrad + j)));
+            VEC_STORE(arDelta + j, VEC_MADD(VEC_LOAD(prWeight + j), deltavec, VEC_LOAD(arDelta + j)));
+        }
+    }
+
+    for (j = 0; j < cHidden; j += VEC_SIZE) {
+        float_vector const act = VEC_LOAD(ar + j);
+        float_vector const vec = VEC_MUL(VEC_MUL(VEC_LOAD(arDelta + j), betavec), VEC_MUL(act, VEC_SUB(onevec, act)));
+
+        VEC_STORE(arDelta + j, vec);
+        VEC_STORE(png->arHiddenThreshold + j, VEC_ADD(VEC_LOAD(png->arHiddenThreshold + j), vec));
+    }
+
+    for (i = 0, prGrad = png->arHiddenWeight; i < pnn->cInput; i++, prGrad += cHidden) {
+        float const ari = arInput[i];
+        float_vector scalevec;
+
+        if (likely(ari == 0.0f))
+            continue;
+
+        scalevec = VEC_SET1(ari);
+        for (j = 0; j < cHidden; j += VEC_SIZE)
+            VEC_STORE(prGrad + j, VEC_MADD(VEC_LOAD(arDelta + j), scalevec, VEC_LOAD(prGrad + j)));
+    }
+
+    png->n++;
+}
+
+extern void
+NeuralNetGradient(const neuralnet * restrict pnn, const float arInputs[], const float arTargets[], unsigned int n,
+                  nngradient * restrict png)
+{
+    SSE_ALIGN(float ar[pnn->cHidden]);
+    SSE_ALIGN(float arDelta[pnn->cHidden]);
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+        GradientSSE(pnn, arInputs + i * pnn->cInput, arTargets + i * pnn->cOutput, ar, arDelta, png);
 
 #if defined(USE_AVX)
-        vec0 = _mm256_hadd_ps(sum, sum);
-        vec1 = _mm256_hadd_ps(vec0, vec0);
-        _mm256_store_ps(r, vec1);
+    _mm256_zeroupper();
+#endif
+}
+#endif
 
-        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r[0] + r[4] + pnn->arOutputThreshold[i]));
-#elif defined(HAVE_SSE)
-        vec0 = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
-        vec1 = _mm_add_ps(sum, vec0);
-        vec0 = _mm_shuffle_ps(vec1, vec1, _MM_SHUFFLE(1, 1, 3, 3));
-        sum = _mm_add_ps(vec1, vec0);
-        _mm_store_ss(&r, sum);
+/* Add the weight rows ai[0..c-1], scaled by ar[], to cVec vectors of
+ * hidden sums starting at iHidden, keeping the sums in registers */
+static inline void
+AccumulateRowsSSE(const neuralnet * restrict pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                  unsigned int iHidden, const unsigned int cVec, float arSum[])
+{
+    float_vector acc[BATCH_VECS];
+    unsigned int i, v;
 
-        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
+    for (v = 0; v < cVec; v++)
+        acc[v] = VEC_LOAD(arSum + iHidden + v * VEC_SIZE);
 
-#else
-       {
-       float32x2_t vec0_h, vec0_l, vec1;
+    for (i = 0; i < c; i++) {
+        const float *prWeight = pnn->arHiddenWeight + ai[i] * pnn->cHidden + iHidden;
+        float_vector const scalevec = VEC_SET1(ar[i]);
 
-       vec0_h = vget_high_f32(sum);
-       vec0_l = vget_low_f32(sum);
-       vec1 = vpadd_f32(vec0_h, vec0_l);
-       vec1 = vpadd_f32(vec1, vec1);
-       vst1_lane_f32(&r, vec1, 0);
+        for (v = 0; v < cVec; v++)
+            acc[v] = VEC_MADD(VEC_LOAD(prWeight + v * VEC_SIZE), scalevec, acc[v]);
+    }
 
-       arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
-       }
+    for (v = 0; v < cVec; v++)
+        VEC_STORE(arSum + iHidden + v * VEC_SIZE, acc[v]);
+}
+
+static void
+AccumulateListSSE(const neuralnet * restrict pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                  float arSum[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int iHidden;
+
+    for (iHidden = 0; iHidden < cHidden;) {
+        if (cHidden - iHidden >= BATCH_VECS * VEC_SIZE) {
+            AccumulateRowsSSE(pnn, ai, ar, c, iHidden, BATCH_VECS, arSum);
+            iHidden += BATCH_VECS * VEC_SIZE;
+        } else {
+            AccumulateRowsSSE(pnn, ai, ar, c, iHidden, 1, arSum);
+            iHidden += VEC_SIZE;
+        }
+    }
+}
+
+extern void
+NeuralNetHiddenSums(const neuralnet * restrict pnn, const float arInput[], unsigned int cInputBase, float arBase[])
+{
+    unsigned int *ai = g_alloca(cInputBase * sizeof(unsigned int));
+    float *ar = g_alloca(cInputBase * sizeof(float));
+    unsigned int i, c = 0;
+
+#if defined(USE_SIMD_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_AVX512 && !(pnn->cHidden % 16)) {
+        NeuralNetHiddenSumsAVX512(pnn, arInput, cInputBase, arBase);
+        return;
+    }
+    if (simdKernel != SIMD_KERNEL_DEFAULT && !(pnn->cHidden % 8)) {
+        NeuralNetHiddenSumsFMA(pnn, arInput, cInputBase, arBase);
+        return;
+    }
 #endif
+#if defined(USE_SVE_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_SVE) {
+        NeuralNetHiddenSumsSVE(pnn, arInput, cInputBase, arBase);
+        return;
     }
+#endif
+
+    for (i = 0; i < cInputBase; i++)
+        if (arInput[i] != 0.0f) {
+            ai[c] = i;
+            ar[c++] = arInput[i];
+        }
+
+    memcpy(arBase, pnn->arHiddenThreshold, pnn->cHidden * sizeof(float));
+    AccumulateListSSE(pnn, ai, ar, c, arBase);
+
 #if defined(USE_AVX)
     _mm256_zeroupper();
 #endif
 }
 
-
 extern int
-NeuralNetEvaluateSSE(const neuralnet * restrict pnn, /*lint -e{818} */ float arInput[],
-                     float arOutput[], NNState * UNUSED(pnState))
+NeuralNetEvaluateDelta(const neuralnet * restrict pnn, const float arBase[], unsigned int cInputBase,
+                       const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                       const float arInput[], float arOutput[])
 {
+    const unsigned int cRows = cDelta + pnn->cInput - cInputBase;
     SSE_ALIGN(float ar[pnn->cHidden]);
+    unsigned int *ai = g_alloca(cRows * sizeof(unsigned int));
+    float *arScale = g_alloca(cRows * sizeof(float));
+    unsigned int i, c;
 
-#if DEBUG_SSE
-    g_assert(sse_aligned(arOutput));
-    g_assert(sse_aligned(ar));
-    g_assert(sse_aligned(arInput));
+#if defined(USE_SIMD_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_AVX512 && !(pnn->cHidden % 16))
+        return NeuralNetEvaluateDeltaAVX512(pnn, arBase, cInputBase, aiDelta, arDelta, cDelta, arInput, arOutput);
+    if (simdKernel != SIMD_KERNEL_DEFAULT && !(pnn->cHidden % 8))
+        return NeuralNetEvaluateDeltaFMA(pnn, arBase, cInputBase, aiDelta, arDelta, cDelta, arInput, arOutput);
+#endif
+#if defined(USE_SVE_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_SVE)
+        return NeuralNetEvaluateDeltaSVE(pnn, arBase, cInputBase, aiDelta, arDelta, cDelta, arInput, arOutput);
 #endif
 
-    EvaluateSSE(pnn, arInput, ar, arOutput);
+    /* one list of rows: the changed base inputs, then the others */
+    memcpy(ai, aiDelta, cDelta * sizeof(unsigned int));
+    memcpy(arScale, arDelta, cDelta * sizeof(float));
+
+    for (c = cDelta, i = cInputBase; i < pnn->cInput; i++)
+        if (arInput[i] != 0.0f) {
+            ai[c] = i;
+            arScale[c++] = arInput[i];
+        }
+
+    memcpy(ar, arBase, pnn->cHidden * sizeof(float));
+    AccumulateListSSE(pnn, ai, arScale, c, ar);
+    EvaluateOutputSSE(pnn, ar, arOutput);
+
+#if defined(USE_AVX)
+    _mm256_zeroupper();
+#endif
+    return 0;
+}
+
+extern int
+NeuralNetEvaluateSparse(const neuralnet * restrict pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                        float arOutput[])
+{
+    SSE_ALIGN(float arSum[pnn->cHidden]);
+
+    /* the delta evaluation against nothing, for the wider kernels */
+#if defined(USE_SIMD_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_AVX512 && !(pnn->cHidden % 16))
+        return NeuralNetEvaluateDeltaAVX512(pnn, pnn->arHiddenThreshold, pnn->cInput, ai, ar, c, NULL, arOutput);
+    if (simdKernel != SIMD_KERNEL_DEFAULT && !(pnn->cHidden % 8))
+        return NeuralNetEvaluateDeltaFMA(pnn, pnn->arHiddenThreshold, pnn->cInput, ai, ar, c, NULL, arOutput);
+#endif
+#if defined(USE_SVE_DISPATCH)
+    if (simdKernel == SIMD_KERNEL_SVE)
+        return NeuralNetEvaluateDeltaSVE(pnn, pnn->arHiddenThreshold, pnn->cInput, ai, ar, c, NULL, arOutput);
+#endif
+
+    memcpy(arSum, pnn->arHiddenThreshold, pnn->cHidden * sizeof(float));
+    AccumulateListSSE(pnn, ai, ar, c, arSum);
+    EvaluateOutputSSE(pnn, arSum, arOutput);
+
+#if defined(USE_AVX)
+    _mm256_zeroupper();
+#endif
     return 0;
 }
 
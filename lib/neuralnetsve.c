@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+/*
+ * Neural net kernels for ARM CPUs with the Scalable Vector Extension.
+ * This file is compiled with -march=armv8-a+sve in a NEON build and
+ * NeuralNetEvaluateSSE() and friends hand over to it when
+ * SIMD_Supported() finds HWCAP_SVE in the hwcaps.  SVE2 adds nothing
+ * to the floating point the nets use, so CPUs with it run these too.
+ *
+ * The vector length is only known at run time (svcntw() floats, from
+ * 4 to 64); the tail of the hidden units is handled by predicates, so
+ * any number of hidden units works.  Loads are unaligned-safe, so the
+ * rest of gnubg keeps its ALIGN_SIZE.
+ */
+
+#include "config.h"
+#include "common.h"
+
+#if defined(USE_SVE_DISPATCH)
+
+#include <arm_sve.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+#include "neuralnet.h"
+#include "sigmoid.h"
+
+/* Number of vectors of hidden units kept in registers: 128 hidden
+ * units take one pass at 256 bits or more */
+#define SVE_VECS 4
+
+static inline svfloat32_t
+ReciprocalSVE(svbool_t pg, svfloat32_t x)
+{
+#ifdef __FAST_MATH__
+    svfloat32_t rec = svrecpe_f32(x);
+
+    rec = svmul_f32_x(pg, svrecps_f32(x, rec), rec);
+    return svmul_f32_x(pg, svrecps_f32(x, rec), rec);
+#else
+    return svdivr_n_f32_x(pg, x, 1.0f);
+#endif
+}
+
+/* Same approximation as sigmoid() and sigmoid_ps() in neuralnetsse.c:
+ * 1 / (1 + exp(x)) from a table of exp(k/10) and a linear step, the
+ * table read by a gather */
+static inline svfloat32_t
+sigmoid_sve(svbool_t pg, svfloat32_t xin)
+{
+    const svbool_t neg = svcmplt_n_f32(pg, xin, 0.0f);
+    svfloat32_t x1 = svmul_n_f32_x(pg, svmin_n_f32_x(pg, svabs_f32_x(pg, xin), 10.0f), 10.0f);
+    const svint32_t i = svcvt_s32_f32_x(pg, x1);
+    const svfloat32_t ex = svld1_gather_s32index_f32(pg, e, i);
+    svfloat32_t c;
+
+    x1 = svadd_n_f32_x(pg, svsub_f32_x(pg, x1, svcvt_f32_s32_x(pg, i)), 10.0f);
+    c = ReciprocalSVE(pg, svmad_n_f32_x(pg, x1, ex, 1.0f));
+    return svsel_f32(neg, c, svsubr_n_f32_x(pg, c, 1.0f));
+}
+
+/* sigmoid_fast_ps() of neuralnetsse.c at the full vector width */
+static inline svfloat32_t
+sigmoid_fast_sve(svbool_t pg, svfloat32_t xin)
+{
+    svfloat32_t x = svmul_n_f32_x(pg, xin, -SIGMOID_FAST_LOG2E);
+    svfloat32_t n, p, scale;
+
+    x = svmin_n_f32_x(pg, x, SIGMOID_FAST_LIMIT);
+    x = svmax_n_f32_x(pg, x, -SIGMOID_FAST_LIMIT);
+    x = svadd_n_f32_x(pg, x, SIGMOID_FAST_BIAS);
+    n = svcvt_f32_s32_x(pg, svcvt_s32_f32_x(pg, x));
+    x = svsub_f32_x(pg, x, n);
+    scale = svadd_n_f32_x(pg, n, 127.0f - SIGMOID_FAST_BIAS);
+    scale = svreinterpret_f32_s32(svcvt_s32_f32_x(pg, svmul_n_f32_x(pg, scale, 8388608.0f)));
+    p = svmad_n_f32_x(pg, svdup_n_f32(SIGMOID_FAST_C3), x, SIGMOID_FAST_C2);
+    p = svmad_n_f32_x(pg, p, x, SIGMOID_FAST_C1);
+    p = svmad_n_f32_x(pg, p, x, SIGMOID_FAST_C0);
+    return ReciprocalSVE(pg, svmad_n_f32_x(pg, p, scale, 1.0f));
+}
+
+/* The non-zero inputs from i0 on as a list of weight rows and scales */
+static inline unsigned int
+InputRowsSVE(const float arInput[], unsigned int i0, unsigned int cInput, unsigned int ai[], float ar[])
+{
+    unsigned int i, c = 0;
+
+    for (i = i0; i < cInput; i++)
+        if (arInput[i] != 0.0f) {
+            ai[c] = i;
+            ar[c++] = arInput[i];
+        }
+
+    return c;
+}
+
+/* Add the weight rows ai[0..c-1], scaled by ar[], to SVE_VECS vectors
+ * of hidden sums from iHidden on.  The sums stay in registers for the
+ * whole list of rows. */
+static inline void
+AccumulateSliceSVE(const neuralnet * restrict pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                   unsigned int iHidden, float arSum[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const unsigned int cLanes = (unsigned int) svcntw();
+    const svbool_t pg0 = svwhilelt_b32_u32(iHidden, cHidden);
+    const svbool_t pg1 = svwhilelt_b32_u32(iHidden + cLanes, cHidden);
+    const svbool_t pg2 = svwhilelt_b32_u32(iHidden + 2 * cLanes, cHidden);
+    const svbool_t pg3 = svwhilelt_b32_u32(iHidden + 3 * cLanes, cHidden);
+    float *pr = arSum + iHidden;
+    svfloat32_t acc0 = svld1_f32(pg0, pr);
+    svfloat32_t acc1 = svld1_f32(pg1, pr + cLanes);
+    svfloat32_t acc2 = svld1_f32(pg2, pr + 2 * cLanes);
+    svfloat32_t acc3 = svld1_f32(pg3, pr + 3 * cLanes);
+    unsigned int i;
+
+    for (i = 0; i < c; i++) {
+        const float *prWeight = pnn->arHiddenWeight + ai[i] * cHidden + iHidden;
+        const svfloat32_t scalevec = svdup_n_f32(ar[i]);
+
+        acc0 = svmla_f32_m(pg0, acc0, svld1_f32(pg0, prWeight), scalevec);
+        acc1 = svmla_f32_m(pg1, acc1, svld1_f32(pg1, prWeight + cLanes), scalevec);
+        acc2 = svmla_f32_m(pg2, acc2, svld1_f32(pg2, prWeight + 2 * cLanes), scalevec);
+        acc3 = svmla_f32_m(pg3, acc3, svld1_f32(pg3, prWeight + 3 * cLanes), scalevec);
+    }
+
+    svst1_f32(pg0, pr, acc0);
+    svst1_f32(pg1, pr + cLanes, acc1);
+    svst1_f32(pg2, pr + 2 * cLanes, acc2);
+    svst1_f32(pg3, pr + 3 * cLanes, acc3);
+}
+
+static inline void
+AccumulateRowsSVE(const neuralnet * restrict pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                  float arSum[])
+{
+    const unsigned int cSlice = SVE_VECS * (unsigned int) svcntw();
+    unsigned int iHidden;
+
+    for (iHidden = 0; iHidden < pnn->cHidden; iHidden += cSlice)
+        AccumulateSliceSVE(pnn, ai, ar, c, iHidden, arSum);
+}
+
+static inline void
+EvaluateOutputSVE(const neuralnet * restrict pnn, float ar[], float arOutput[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const unsigned int cLanes = (unsigned int) svcntw();
+    const float *prWeight = pnn->arOutputWeight;
+    const svbool_t all = svptrue_b32();
+    unsigned int i, j;
+
+    if (pnn->cOutput == NN_FUSED_OUTPUTS) {
+        /* as EvaluateOutputFusedSSE() */
+        svfloat32_t sum0 = svdup_n_f32(0.0f), sum1 = sum0, sum2 = sum0, sum3 = sum0, sum4 = sum0;
+
+        for (j = 0; j < cHidden; j += cLanes) {
+            const svbool_t pg = svwhilelt_b32_u32(j, cHidden);
+            svfloat32_t vec = svmul_n_f32_x(pg, svld1_f32(pg, ar + j), pnn->rBetaHidden);
+
+            vec = pnn->fFastSigmoid ? sigmoid_fast_sve(pg, vec) : sigmoid_sve(pg, vec);
+            sum0 = svmla_f32_m(pg, sum0, vec, svld1_f32(pg, prWeight + j));
+            sum1 = svmla_f32_m(pg, sum1, vec, svld1_f32(pg, prWeight + cHidden + j));
+            sum2 = svmla_f32_m(pg, sum2, vec, svld1_f32(pg, prWeight + 2 * cHidden + j));
+            sum3 = svmla_f32_m(pg, sum3, vec, svld1_f32(pg, prWeight + 3 * cHidden + j));
+            sum4 = svmla_f32_m(pg, sum4, vec, svld1_f32(pg, prWeight + 4 * cHidden + j));
+        }
+
+        arOutput[0] = sigmoid(-pnn->rBetaOutput * (svaddv_f32(all, sum0) + pnn->arOutputThreshold[0]));
+        arOutput[1] = sigmoid(-pnn->rBetaOutput * (svaddv_f32(all, sum1) + pnn->arOutputThreshold[1]));
+        arOutput[2] = sigmoid(-pnn->rBetaOutput * (svaddv_f32(all, sum2) + pnn->arOutputThreshold[2]));
+        arOutput[3] = sigmoid(-pnn->rBetaOutput * (svaddv_f32(all, sum3) + pnn->arOutputThreshold[3]));
+        arOutput[4] = sigmoid(-pnn->rBetaOutput * (svaddv_f32(all, sum4) + pnn->arOutputThreshold[4]));
+        return;
+    }
+
+    for (j = 0; j < cHidden; j += cLanes) {
+        const svbool_t pg = svwhilelt_b32_u32(j, cHidden);
+        svfloat32_t vec = svmul_n_f32_x(pg, svld1_f32(pg, ar + j), pnn->rBetaHidden);
+
+        svst1_f32(pg, ar + j, pnn->fFastSigmoid ? sigmoid_fast_sve(pg, vec) : sigmoid_sve(pg, vec));
+    }
+
+    for (i = 0; i < pnn->cOutput; i++, prWeight += cHidden) {
+        svfloat32_t sum = svdup_n_f32(0.0f);
+
+        for (j = 0; j < cHidden; j += cLanes) {
+            const svbool_t pg = svwhilelt_b32_u32(j, cHidden);
+
+            sum = svmla_f32_m(pg, sum, svld1_f32(pg, ar + j), svld1_f32(pg, prWeight + j));
+        }
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * (svaddv_f32(all, sum) + pnn->arOutputThreshold[i]));
+    }
+}
+
+extern int
+NeuralNetEvaluateSVE(const neuralnet * restrict pnn, const float arInput[], float arOutput[])
+{
+    float ar[pnn->cHidden];
+    unsigned int ai[pnn->cInput];
+    float arScale[pnn->cInput];
+    unsigned int c = InputRowsSVE(arInput, 0, pnn->cInput, ai, arScale);
+
+    memcpy(ar, pnn->arHiddenThreshold, pnn->cHidden * sizeof(float));
+    AccumulateRowsSVE(pnn, ai, arScale, c, ar);
+    EvaluateOutputSVE(pnn, ar, arOutput);
+
+    return 0;
+}
+
+/* Each slice of hidden units goes through the whole block of positions
+ * before the next, so its weights stay in L1 from one position to the
+ * next */
+extern int
+NeuralNetEvaluateBatchSVE(const neuralnet * restrict pnn, const float arInputs[], unsigned int n,
+                          float arOutputs[])
+{
+    const unsigned int cInput = pnn->cInput, cHidden = pnn->cHidden;
+    const unsigned int cSlice = SVE_VECS * (unsigned int) svcntw();
+    float ar[NN_BATCH_BLOCK * cHidden];
+    unsigned int ai[NN_BATCH_BLOCK * cInput];
+    float arScale[NN_BATCH_BLOCK * cInput];
+    unsigned int ac[NN_BATCH_BLOCK];
+    unsigned int i, k, iHidden;
+
+    for (i = 0; i < n; i += NN_BATCH_BLOCK) {
+        unsigned int cBlock = MIN(NN_BATCH_BLOCK, n - i);
+
+        for (k = 0; k < cBlock; k++) {
+            ac[k] = InputRowsSVE(arInputs + (i + k) * cInput, 0, cInput, ai + k * cInput, arScale + k * cInput);
+            memcpy(ar + k * cHidden, pnn->arHiddenThreshold, cHidden * sizeof(float));
+        }
+
+        for (iHidden = 0; iHidden < cHidden; iHidden += cSlice)
+            for (k = 0; k < cBlock; k++)
+                AccumulateSliceSVE(pnn, ai + k * cInput, arScale + k * cInput, ac[k], iHidden, ar + k * cHidden);
+
+        for (k = 0; k < cBlock; k++)
+            EvaluateOutputSVE(pnn, ar + k * cHidden, arOutputs + (i + k) * pnn->cOutput);
+    }
+
+    return 0;
+}
+
+extern void
+NeuralNetHiddenSumsSVE(const neuralnet * restrict pnn, const float arInput[], unsigned int cInputBase,
+                       float arBase[])
+{
+    unsigned int ai[cInputBase];
+    float ar[cInputBase];
+    unsigned int c = InputRowsSVE(arInput, 0, cInputBase, ai, ar);
+
+    memcpy(arBase, pnn->arHiddenThreshold, pnn->cHidden * sizeof(float));
+    AccumulateRowsSVE(pnn, ai, ar, c, arBase);
+}
+
+extern int
+NeuralNetEvaluateDeltaSVE(const neuralnet * restrict pnn, const float arBase[], unsigned int cInputBase,
+                          const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                          const float arInput[], float arOutput[])
+{
+    const unsigned int cRows = cDelta + pnn->cInput - cInputBase;
+    float ar[pnn->cHidden];
+    unsigned int ai[cRows];
+    float arScale[cRows];
+    unsigned int c;
+
+    memcpy(ai, aiDelta, cDelta * sizeof(unsigned int));
+    memcpy(arScale, arDelta, cDelta * sizeof(float));
+    c = cDelta + InputRowsSVE(arInput, cInputBase, pnn->cInput, ai + cDelta, arScale + cDelta);
+
+    memcpy(ar, arBase, pnn->cHidden * sizeof(float));
+    AccumulateRowsSVE(pnn, ai, arScale, c, ar);
+    EvaluateOutputSVE(pnn, ar, arOutput);
+
+    return 0;
+}
+
+#endif                          /* USE_SVE_DISPATCH */
@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2007-2021 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+/*
+ * Neural net kernels for instruction sets wider than the one gnubg is
+ * built for.  This file is compiled twice, once with -mavx2 -mfma and
+ * once with -mavx512f, and the compiler's own __AVX512F__ define picks
+ * the variant.  NeuralNetEvaluateSSE() and NeuralNetEvaluateBatch()
+ * hand over to these when SIMD_Supported() finds the CPU can run them.
+ *
+ * Everything here uses unaligned loads for the caller's buffers so the
+ * rest of gnubg keeps its ALIGN_SIZE.
+ */
+
+#include "config.h"
+#include "common.h"
+
+#if defined(USE_SIMD_DISPATCH)
+
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+#include "neuralnet.h"
+#include "sigmoid.h"
+
+#if defined(__AVX512F__)
+
+#define WIDE_SIZE 16
+#define WIDE_VECS 8
+#define wide_vector __m512
+#define WIDE_LOAD(p) _mm512_loadu_ps(p)
+#define WIDE_STORE(p, v) _mm512_storeu_ps(p, v)
+#define WIDE_SET1(r) _mm512_set1_ps(r)
+#define WIDE_MUL(a, b) _mm512_mul_ps(a, b)
+#define WIDE_MADD(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define WIDE_ZERO() _mm512_setzero_ps()
+#define WIDE_HSUM(v) _mm512_reduce_add_ps(v)
+#define WIDE_FUN(f) f ## AVX512
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+#define WIDE_SIZE 8
+#define WIDE_VECS 16
+#define wide_vector __m256
+#define WIDE_LOAD(p) _mm256_loadu_ps(p)
+#define WIDE_STORE(p, v) _mm256_storeu_ps(p, v)
+#define WIDE_SET1(r) _mm256_set1_ps(r)
+#define WIDE_MUL(a, b) _mm256_mul_ps(a, b)
+#define WIDE_MADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define WIDE_ZERO() _mm256_setzero_ps()
+#define WIDE_FUN(f) f ## FMA
+
+static inline float
+WIDE_HSUM(__m256 v)
+{
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(x);
+}
+
+#else
+#error "neuralnetwide.c must be compiled with -mavx2 -mfma or -mavx512f"
+#endif
+
+/* Same approximation as sigmoid() and sigmoid_ps() in neuralnetsse.c:
+ * 1 / (1 + exp(x)) from a table of exp(k/10) and a linear step, with
+ * the step done by an FMA.  The table lookups are scalar, as a gather
+ * was slower. */
+static inline wide_vector
+sigmoid_wide(wide_vector xin)
+{
+#if defined(__AVX512F__)
+    const __m512 tens = _mm512_set1_ps(10.0f);
+    const __m512 ones = _mm512_set1_ps(1.0f);
+    __mmask16 neg = _mm512_cmp_ps_mask(xin, _mm512_setzero_ps(), _CMP_LT_OS);
+    __m512 x1 = _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(xin), _mm512_set1_epi32(0x7FFFFFFF)));
+    union {
+        __m512i i;
+        int32_t i32[16];
+    } i;
+    union {
+        __m512 ps;
+        float f[16];
+    } ex;
+    __m512 c;
+    unsigned int k;
+
+    x1 = _mm512_mul_ps(_mm512_min_ps(x1, tens), tens);
+    i.i = _mm512_cvttps_epi32(x1);
+    for (k = 0; k < 16; k++)
+        ex.f[k] = e[i.i32[k]];
+    x1 = _mm512_add_ps(_mm512_sub_ps(x1, _mm512_cvtepi32_ps(i.i)), tens);
+    x1 = _mm512_fmadd_ps(x1, ex.ps, ones);
+#ifdef __FAST_MATH__
+    c = _mm512_rcp14_ps(x1);
+#else
+    c = _mm512_div_ps(ones, x1);
+#endif
+    return _mm512_mask_blend_ps(neg, _mm512_sub_ps(ones, c), c);
+#else
+    const __m256 tens = _mm256_set1_ps(10.0f);
+    const __m256 ones = _mm256_set1_ps(1.0f);
+    __m256 neg = _mm256_cmp_ps(xin, _mm256_setzero_ps(), _CMP_LT_OS);
+    __m256 x1 = _mm256_and_ps(xin, _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)));
+    union {
+        __m256i i;
+        int32_t i32[8];
+    } i;
+    union {
+        __m256 ps;
+        float f[8];
+    } ex;
+    __m256 c;
+    unsigned int k;
+
+    x1 = _mm256_mul_ps(_mm256_min_ps(x1, tens), tens);
+    i.i = _mm256_cvttps_epi32(x1);
+    for (k = 0; k < 8; k++)
+        ex.f[k] = e[i.i32[k]];
+    x1 = _mm256_add_ps(_mm256_sub_ps(x1, _mm256_cvtepi32_ps(i.i)), tens);
+    x1 = _mm256_fmadd_ps(x1, ex.ps, ones);
+#ifdef __FAST_MATH__
+    c = _mm256_rcp_ps(x1);
+#else
+    c = _mm256_div_ps(ones, x1);
+#endif
+    return _mm256_blendv_ps(_mm256_sub_ps(ones, c), c, neg);
+#endif
+}
+
+/* sigmoid_fast_ps() of neuralnetsse.c at the full vector width */
+static inline wide_vector
+sigmoid_fast_wide(wide_vector xin)
+{
+#if defined(__AVX512F__)
+    __m512 x = _mm512_mul_ps(xin, _mm512_set1_ps(-SIGMOID_FAST_LOG2E));
+    __m512 n, p, scale;
+
+    x = _mm512_min_ps(x, _mm512_set1_ps(SIGMOID_FAST_LIMIT));
+    x = _mm512_max_ps(x, _mm512_set1_ps(-SIGMOID_FAST_LIMIT));
+    x = _mm512_add_ps(x, _mm512_set1_ps(SIGMOID_FAST_BIAS));
+    n = _mm512_cvtepi32_ps(_mm512_cvttps_epi32(x));
+    x = _mm512_sub_ps(x, n);
+    scale = _mm512_add_ps(n, _mm512_set1_ps(127.0f - SIGMOID_FAST_BIAS));
+    scale = _mm512_castsi512_ps(_mm512_cvttps_epi32(_mm512_mul_ps(scale, _mm512_set1_ps(8388608.0f))));
+#else
+    __m256 x = _mm256_mul_ps(xin, _mm256_set1_ps(-SIGMOID_FAST_LOG2E));
+    __m256 n, p, scale;
+
+    x = _mm256_min_ps(x, _mm256_set1_ps(SIGMOID_FAST_LIMIT));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-SIGMOID_FAST_LIMIT));
+    x = _mm256_add_ps(x, _mm256_set1_ps(SIGMOID_FAST_BIAS));
+    n = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(x));
+    x = _mm256_sub_ps(x, n);
+    scale = _mm256_add_ps(n, _mm256_set1_ps(127.0f - SIGMOID_FAST_BIAS));
+    scale = _mm256_castsi256_ps(_mm256_cvttps_epi32(_mm256_mul_ps(scale, _mm256_set1_ps(8388608.0f))));
+#endif
+    p = WIDE_MADD(WIDE_SET1(SIGMOID_FAST_C3), x, WIDE_SET1(SIGMOID_FAST_C2));
+    p = WIDE_MADD(p, x, WIDE_SET1(SIGMOID_FAST_C1));
+    p = WIDE_MADD(p, x, WIDE_SET1(SIGMOID_FAST_C0));
+    x = WIDE_MADD(p, scale, WIDE_SET1(1.0f));
+#if defined(__AVX512F__)
+#ifdef __FAST_MATH__
+    return _mm512_rcp14_ps(x);
+#else
+    return _mm512_div_ps(WIDE_SET1(1.0f), x);
+#endif
+#else
+#ifdef __FAST_MATH__
+    return _mm256_rcp_ps(x);
+#else
+    return _mm256_div_ps(WIDE_SET1(1.0f), x);
+#endif
+#endif
+}
+
+/* Accumulate cVec vectors of hidden units starting at iHidden, keeping
+ * the partial sums in registers over the whole pass on the inputs.
+ * WIDE_VECS covers the 128 hidden units of the main nets in one pass. */
+static inline void
+AccumulateHiddenWide(const neuralnet * restrict pnn, const float arInput[], unsigned int iHidden,
+                     const unsigned int cVec, float ar[])
+{
+    const float *prWeight = pnn->arHiddenWeight + iHidden;
+    wide_vector acc[WIDE_VECS];
+    unsigned int i, v;
+
+    for (v = 0; v < cVec; v++)
+        acc[v] = WIDE_LOAD(pnn->arHiddenThreshold + iHidden + v * WIDE_SIZE);
+
+    for (i = 0; i < pnn->cInput; i++, prWeight += pnn->cHidden) {
+        float const ari = arInput[i];
+        wide_vector scalevec;
+
+        if (likely(ari == 0.0f))
+            continue;
+
+        scalevec = WIDE_SET1(ari);
+        for (v = 0; v < cVec; v++)
+            acc[v] = WIDE_MADD(WIDE_LOAD(prWeight + v * WIDE_SIZE), scalevec, acc[v]);
+    }
+
+    for (v = 0; v < cVec; v++)
+        WIDE_STORE(ar + iHidden + v * WIDE_SIZE, acc[v]);
+}
+
+static inline void
+AccumulateSliceWide(const neuralnet * restrict pnn, const float arInputs[], unsigned int cBlock, float ar[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int iHidden, k;
+
+    for (iHidden = 0; iHidden < cHidden;) {
+        unsigned int cVec = MIN(WIDE_VECS, (cHidden - iHidden) / WIDE_SIZE);
+
+        for (k = 0; k < cBlock; k++)
+            AccumulateHiddenWide(pnn, arInputs + k * pnn->cInput, iHidden, cVec, ar + k * cHidden);
+        iHidden += cVec * WIDE_SIZE;
+    }
+}
+
+static inline void
+EvaluateOutputWide(const neuralnet * restrict pnn, float ar[], float arOutput[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const wide_vector scalevec = WIDE_SET1(pnn->rBetaHidden);
+    const float *prWeight = pnn->arOutputWeight;
+    unsigned int i, j;
+
+    if (pnn->cOutput == NN_FUSED_OUTPUTS) {
+        /* as EvaluateOutputFusedSSE() */
+        wide_vector sum0 = WIDE_ZERO(), sum1 = sum0, sum2 = sum0, sum3 = sum0, sum4 = sum0;
+
+        for (j = 0; j < cHidden; j += WIDE_SIZE) {
+            wide_vector vec = WIDE_MUL(WIDE_LOAD(ar + j), scalevec);
+
+            vec = pnn->fFastSigmoid ? sigmoid_fast_wide(vec) : sigmoid_wide(vec);
+            sum0 = WIDE_MADD(vec, WIDE_LOAD(prWeight + j), sum0);
+            sum1 = WIDE_MADD(vec, WIDE_LOAD(prWeight + cHidden + j), sum1);
+            sum2 = WIDE_MADD(vec, WIDE_LOAD(prWeight + 2 * cHidden + j), sum2);
+            sum3 = WIDE_MADD(vec, WIDE_LOAD(prWeight + 3 * cHidden + j), sum3);
+            sum4 = WIDE_MADD(vec, WIDE_LOAD(prWeight + 4 * cHidden + j), sum4);
+        }
+
+        arOutput[0] = sigmoid(-pnn->rBetaOutput * (WIDE_HSUM(sum0) + pnn->arOutputThreshold[0]));
+        arOutput[1] = sigmoid(-pnn->rBetaOutput * (WIDE_HSUM(sum1) + pnn->arOutputThreshold[1]));
+        arOutput[2] = sigmoid(-pnn->rBetaOutput * (WIDE_HSUM(sum2) + pnn->arOutputThreshold[2]));
+        arOutput[3] = sigmoid(-pnn->rBetaOutput * (WIDE_HSUM(sum3) + pnn->arOutputThreshold[3]));
+        arOutput[4] = sigmoid(-pnn->rBetaOutput * (WIDE_HSUM(sum4) + pnn->arOutputThreshold[4]));
+        return;
+    }
+
+    if (pnn->fFastSigmoid)
+        for (j = 0; j < cHidden; j += WIDE_SIZE)
+            WIDE_STORE(ar + j, sigmoid_fast_wide(WIDE_MUL(WIDE_LOAD(ar + j), scalevec)));
+    else
+        for (j = 0; j < cHidden; j += WIDE_SIZE)
+            WIDE_STORE(ar + j, sigmoid_wide(WIDE_MUL(WIDE_LOAD(ar + j), scalevec)));
+
+    for (i = 0; i < pnn->cOutput; i++) {
+        wide_vector sum = WIDE_ZERO();
+
+        for (j = 0; j < cHidden; j += WIDE_SIZE, prWeight += WIDE_SIZE)
+            sum = WIDE_MADD(WIDE_LOAD(ar + j), WIDE_LOAD(prWeight), sum);
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * (WIDE_HSUM(sum) + pnn->arOutputThreshold[i]));
+    }
+}
+
+extern int
+WIDE_FUN(NeuralNetEvaluate) (const neuralnet * restrict pnn, const float arInput[], float arOutput[])
+{
+    float ar[pnn->cHidden];
+
+    AccumulateSliceWide(pnn, arInput, 1, ar);
+    EvaluateOutputWide(pnn, ar, arOutput);
+
+    _mm256_zeroupper();
+    return 0;
+}
+
+extern int
+WIDE_FUN(NeuralNetEvaluateBatch) (const neuralnet * restrict pnn, const float arInputs[], unsigned int n,
+                                  float arOutputs[])
+{
+    float ar[NN_BATCH_BLOCK * pnn->cHidden];
+    unsigned int i, k;
+
+    for (i = 0; i < n; i += NN_BATCH_BLOCK) {
+        unsigned int cBlock = MIN(NN_BATCH_BLOCK, n - i);
+
+        AccumulateSliceWide(pnn, arInputs + i * pnn->cInput, cBlock, ar);
+        for (k = 0; k < cBlock; k++)
+            EvaluateOutputWide(pnn, ar + k * pnn->cHidden, arOutputs + (i + k) * pnn->cOutput);
+    }
+
+    _mm256_zeroupper();
+    return 0;
+}
+
+/* Add the weight rows ai[0..c-1], scaled by ar[], to the hidden sums */
+static inline void
+AccumulateRowsWide(const neuralnet * restrict pnn, const unsigned int ai[], const float ar[], unsigned int c,
+                   float arSum[])
+{
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int iHidden, i, v;
+
+    for (iHidden = 0; iHidden < cHidden;) {
+        unsigned int cVec = MIN(WIDE_VECS, (cHidden - iHidden) / WIDE_SIZE);
+        wide_vector acc[WIDE_VECS];
+
+        for (v = 0; v < cVec; v++)
+            acc[v] = WIDE_LOAD(arSum + iHidden + v * WIDE_SIZE);
+
+        for (i = 0; i < c; i++) {
+            const float *prWeight = pnn->arHiddenWeight + ai[i] * cHidden + iHidden;
+            wide_vector const scalevec = WIDE_SET1(ar[i]);
+
+            for (v = 0; v < cVec; v++)
+                acc[v] = WIDE_MADD(WIDE_LOAD(prWeight + v * WIDE_SIZE), scalevec, acc[v]);
+        }
+
+        for (v = 0; v < cVec; v++)
+            WIDE_STORE(arSum + iHidden + v * WIDE_SIZE, acc[v]);
+        iHidden += cVec * WIDE_SIZE;
+    }
+}
+
+extern void
+WIDE_FUN(NeuralNetHiddenSums) (const neuralnet * restrict pnn, const float arInput[], unsigned int cInputBase,
+                               float arBase[])
+{
+    unsigned int ai[cInputBase];
+    float ar[cInputBase];
+    unsigned int i, c = 0;
+
+    for (i = 0; i < cInputBase; i++)
+        if (arInput[i] != 0.0f) {
+            ai[c] = i;
+            ar[c++] = arInput[i];
+        }
+
+    memcpy(arBase, pnn->arHiddenThreshold, pnn->cHidden * sizeof(float));
+    AccumulateRowsWide(pnn, ai, ar, c, arBase);
+
+    _mm256_zeroupper();
+}
+
+extern int
+WIDE_FUN(NeuralNetEvaluateDelta) (const neuralnet * restrict pnn, const float arBase[], unsigned int cInputBase,
+                                  const unsigned int aiDelta[], const float arDelta[], unsigned int cDelta,
+                                  const float arInput[], float arOutput[])
+{
+    const unsigned int cRows = cDelta + pnn->cInput - cInputBase;
+    float ar[pnn->cHidden];
+    unsigned int ai[cRows];
+    float arScale[cRows];
+    unsigned int i, c;
+
+    memcpy(ai, aiDelta, cDelta * sizeof(unsigned int));
+    memcpy(arScale, arDelta, cDelta * sizeof(float));
+
+    for (c = cDelta, i = cInputBase; i < pnn->cInput; i++)
+        if (arInput[i] != 0.0f) {
+            ai[c] = i;
+            arScale[c++] = arInput[i];
+        }
+
+    memcpy(ar, arBase, pnn->cHidden * sizeof(float));
+    AccumulateRowsWide(pnn, ai, arScale, c, ar);
+    EvaluateOutputWide(pnn, ar, arOutput);
+
+    _mm256_zeroupper();
+    return 0;
+}
+
+#endif                          /* USE_SIMD_DISPATCH */
@@ -20,6 +20,9 @@
 
 #ifndef SIGMOID_H
 #define SIGMOID_H
+
+#include <stdint.h>
+
 /* e[k] = exp(k/10) / 10 */
 static float e[101] = {
     0.10000000000000001f,
@@ -166,5 +169,49 @@ sigmoid(float const xin)
     }
 }
 
+/* Table free approximation of 1 / (1 + exp(x)) for the hidden layer of
+ * nets with fFastSigmoid set.  exp(x) is taken as 2^n * p(f), with n
+ * the integer and f the fractional part of x / ln 2 and p the minimax
+ * cubic for 2^f on [0, 1) (relative error 7.5e-5).  x is clamped to
+ * [-10, 10] like in sigmoid(), which gives the largest absolute error,
+ * 4.6e-5 beyond the clamp; inside it the error is below 2e-5.  The
+ * linear step of sigmoid() is off by up to 1.2e-3, so the two differ
+ * by about that much.  SIGMOID_FAST_BIAS keeps x / ln 2 positive so
+ * truncation gives the integer part; the scale 2^n is assembled in
+ * the exponent bits as (n + 127) << 23, written as a float to integer
+ * conversion so the vector versions need no integer shifts. */
+#define SIGMOID_FAST_LOG2E 1.44269504f
+#define SIGMOID_FAST_LIMIT 14.4269504f
+#define SIGMOID_FAST_BIAS 15.0f
+#define SIGMOID_FAST_EXP(n) (((n) + 127.0f - SIGMOID_FAST_BIAS) * 8388608.0f)
+#define SIGMOID_FAST_C0 0.99992522f
+#define SIGMOID_FAST_C1 0.69583354f
+#define SIGMOID_FAST_C2 0.22606716f
+#define SIGMOID_FAST_C3 0.07802452f
+
+static inline float
+sigmoid_fast(float const xin)
+{
+    union {
+        float r;
+        int32_t i;
+    } scale;
+    float x = xin * SIGMOID_FAST_LOG2E;
+    float n, f;
+
+    if (unlikely(x > SIGMOID_FAST_LIMIT))
+        x = SIGMOID_FAST_LIMIT;
+    else if (unlikely(x < -SIGMOID_FAST_LIMIT))
+        x = -SIGMOID_FAST_LIMIT;
+
+    x += SIGMOID_FAST_BIAS;
+    n = (float) (int) x;
+    f = x - n;
+    scale.i = (int32_t) SIGMOID_FAST_EXP(n);
+
+    return 1.0f / (1.0f + scale.r * (((SIGMOID_FAST_C3 * f + SIGMOID_FAST_C2) * f + SIGMOID_FAST_C1) * f
+                                     + SIGMOID_FAST_C0));
+}
+
 
 #endif
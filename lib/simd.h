@@ -58,6 +58,16 @@
 #define SSE_ALIGN(D) D __attribute__ ((aligned(ALIGN_SIZE)))
 #endif
 
+/* For the kernels that must be inlined into callers passing constant
+ * dimensions */
+#if defined(_MSC_VER)
+#define SIMD_INLINE __forceinline
+#elif defined(__GNUC__)
+#define SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define SIMD_INLINE inline
+#endif
+
 #if defined(__GNUC__) && defined(WIN32)
 /* Align stack pointer on 16 byte boundary so SSE variables work correctly */
 #define SIMD_STACKALIGN __attribute__((force_align_arg_pointer))
@@ -82,12 +92,18 @@ extern int CheckNEON(void);
 
 #else /* USE_SIMD_INSTRUCTIONS */
 
+/* what malloc() gives anyway, for the scratch space of mtsupport.c */
+#define ALIGN_SIZE sizeof(double)
 #define SSE_ALIGN(D) D
 #define sse_malloc malloc
 #define sse_free free
 #define SIMD_STACKALIGN
 #define SIMD_AVX_STACKALIGN
+#define SIMD_INLINE inline
 
 #endif
 
+/* sum of ar0[i] * ar1[i], both aligned as from sse_malloc() */
+extern float DistProduct(const float ar0[32], const float ar1[32]);
+
 #endif /* SIMD_H */
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The entry points of libgnubg, see libgnubg.h.  The library is built
+ * from the same sources as the utility programs: the evaluator and
+ * what it needs, without the match state, commands and user interface
+ * of gnubg.c. */
+
+#include "config.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <glib.h>
+
+#include "libgnubg.h"
+#include "eval.h"
+#include "glib-ext.h"
+#include "matchequity.h"
+#include "multithread.h"
+#include "output.h"
+#include "positionid.h"
+#include "util.h"
+
+struct _gnubgengine {
+    evalcontext ec;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+};
+
+static void (*pfGnubgMessage) (const char *sz);
+
+/* The evaluator reports problems through outputerrf(), which is all it
+ * needs of output.c */
+extern void
+outputerrf(const char *sz, ...)
+{
+    va_list val;
+    char *szMessage;
+
+    va_start(val, sz);
+    szMessage = g_strdup_vprintf(sz, val);
+    va_end(val);
+
+    if (pfGnubgMessage)
+        pfGnubgMessage(szMessage);
+    else
+        g_printerr("%s\n", szMessage);
+
+    g_free(szMessage);
+}
+
+/* There is no thread pool to close */
+extern void
+MT_CloseThreads(void)
+{
+    return;
+}
+
+extern int
+GnubgInitialise(const char *szDataDir, void (*pfMessage) (const char *sz))
+{
+    char *szWeights, *szWeightsBinary, *szMET;
+
+    pfGnubgMessage = pfMessage;
+
+    if (szDataDir) {
+        g_free(pkg_datadir);
+        pkg_datadir = g_strdup(szDataDir);
+    }
+
+    glib_ext_init();
+    MT_InitThreads();
+
+    szMET = BuildFilename2("met", "Kazaross-XG2.xml");
+    InitMatchEquity(szMET);
+    g_free(szMET);
+
+    szWeights = BuildFilename("gnubg.weights");
+    szWeightsBinary = BuildFilename("gnubg.wd");
+    EvalInitialise(szWeights, szWeightsBinary, FALSE, NULL);
+    g_free(szWeights);
+    g_free(szWeightsBinary);
+
+#if defined(USE_MULTITHREAD)
+    /* Callers may evaluate on several threads at once */
+    EvaluatePosition = EvaluatePositionWithLocking;
+    GeneralCubeDecisionE = GeneralCubeDecisionEWithLocking;
+    GeneralCubeDecisionScores = GeneralCubeDecisionScoresWithLocking;
+    GeneralCubeDecisionEPlies = GeneralCubeDecisionEPliesWithLocking;
+    GeneralEvaluationE = GeneralEvaluationEWithLocking;
+    ScoreMove = ScoreMoveWithLocking;
+    FindBestMove = FindBestMoveWithLocking;
+    FindnSaveBestMoves = FindnSaveBestMovesWithLocking;
+    FindnSaveBestMovesStaged = FindnSaveBestMovesStagedWithLocking;
+    PrefetchMoves = PrefetchMovesWithLocking;
+#endif
+
+    return 0;
+}
+
+extern gnubgengine *
+GnubgEngineNew(unsigned int nPlies, int fCubeful)
+{
+    gnubgengine *pge;
+
+    if (nPlies > MAX_FILTER_PLIES)
+        return NULL;
+
+    pge = g_new0(gnubgengine, 1);
+    pge->ec.nPlies = nPlies;
+    pge->ec.fCubeful = fCubeful ? 1 : 0;
+    pge->ec.fUsePrune = TRUE;
+    pge->ec.fDeterministic = TRUE;
+    memcpy(pge->aamf, defaultFilters, sizeof(pge->aamf));
+
+    return pge;
+}
+
+extern void
+GnubgEngineFree(gnubgengine * pge)
+{
+    g_free(pge);
+}
+
+extern void
+GnubgEngineSetNoise(gnubgengine * pge, float rNoise, int fDeterministic)
+{
+    pge->ec.rNoise = rNoise;
+    pge->ec.fDeterministic = fDeterministic ? 1 : 0;
+}
+
+/* Check the position and cube of a call and get the calling thread
+ * ready to evaluate.  FALSE if they are not valid. */
+static int
+GnubgPrepare(const unsigned int anBoard[2][25], const gnubgcube * pgc, cubeinfo * pci)
+{
+    if (!CheckPosition(anBoard))
+        return FALSE;
+
+    if (SetCubeInfo(pci, pgc->nCube, pgc->fCubeOwner, pgc->fMove, pgc->nMatchTo, pgc->anScore,
+                    pgc->fCrawford, pgc->fJacoby, pgc->fBeavers, VARIATION_STANDARD))
+        return FALSE;
+
+#if defined(USE_MULTITHREAD)
+    MT_AttachThread();
+#endif
+
+    return TRUE;
+}
+
+extern int
+GnubgEvaluate(const gnubgengine * pge, const unsigned int anBoard[2][25],
+              const gnubgcube * pgc, float arOutput[GNUBG_NUM_OUTPUTS])
+{
+    float ar[NUM_ROLLOUT_OUTPUTS];
+    cubeinfo ci;
+
+    if (!GnubgPrepare(anBoard, pgc, &ci))
+        return -1;
+
+    if (GeneralEvaluationE(ar, anBoard, &ci, &pge->ec) < 0)
+        return -1;
+
+    memcpy(arOutput, ar, GNUBG_NUM_OUTPUTS * sizeof(float));
+
+    return 0;
+}
+
+extern int
+GnubgBestMove(const gnubgengine * pge, const unsigned int anBoard[2][25], int nDie0, int nDie1,
+              const gnubgcube * pgc, int anMove[8])
+{
+    TanBoard anBoardMove;
+    evalcontext ec;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    cubeinfo ci;
+
+    if (nDie0 < 1 || nDie0 > 6 || nDie1 < 1 || nDie1 > 6 || !GnubgPrepare(anBoard, pgc, &ci))
+        return -1;
+
+    /* FindBestMove() takes everything writable */
+    memcpy(anBoardMove, anBoard, sizeof(TanBoard));
+    memcpy(&ec, &pge->ec, sizeof(evalcontext));
+    memcpy(aamf, pge->aamf, sizeof(aamf));
+
+    return FindBestMove(anMove, nDie0, nDie1, anBoardMove, &ci, &ec, aamf);
+}
+
+extern int
+GnubgCubeDecision(const gnubgengine * pge, const unsigned int anBoard[2][25],
+                  const gnubgcube * pgc, float arEquity[GNUBG_NUM_CUBE_OUTPUTS], int *pfDouble, int *pfTake)
+{
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+    float arDouble[4];
+    cubeinfo ci;
+    cubedecision cd;
+
+    if (!GnubgPrepare(anBoard, pgc, &ci))
+        return -1;
+
+    if (GeneralCubeDecisionE(aarOutput, anBoard, &ci, &pge->ec, NULL) < 0)
+        return -1;
+
+    cd = FindCubeDecision(arDouble, aarOutput, &ci);
+
+    if (arEquity)
+        memcpy(arEquity, arDouble, sizeof(arDouble));
+
+    switch (cd) {
+    case DOUBLE_TAKE:
+    case DOUBLE_PASS:
+    case DOUBLE_BEAVER:
+    case REDOUBLE_TAKE:
+    case REDOUBLE_PASS:
+    case OPTIONAL_DOUBLE_TAKE:
+    case OPTIONAL_REDOUBLE_TAKE:
+    case OPTIONAL_DOUBLE_BEAVER:
+    case OPTIONAL_DOUBLE_PASS:
+    case OPTIONAL_REDOUBLE_PASS:
+        *pfDouble = TRUE;
+        break;
+    default:
+        *pfDouble = FALSE;
+        break;
+    }
+
+    /* Pass when the equity after a take is worse for the opponent */
+    *pfTake = arDouble[OUTPUT_TAKE] <= arDouble[OUTPUT_DROP];
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBGNUBG_H
+#define LIBGNUBG_H
+
+/*
+ * libgnubg: the evaluator of GNU Backgammon as a library, for programs
+ * that want it in-process rather than driving gnubg over a socket.
+ *
+ * Call GnubgInitialise() once, then make engines with the settings
+ * wanted.  Engines hold no state between calls and may be shared:
+ * with thread support, any number of threads may evaluate at the same
+ * time, each with its own working data.  Without it, calls must not
+ * overlap.
+ *
+ * Boards are as in gnubg: anBoard[1] holds the chequers of the player
+ * on roll, anBoard[0] those of the opponent, each from their own side
+ * (points 0 to 23, then the bar at 24).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Probabilities of win, win gammon, win backgammon, lose gammon and
+ * lose backgammon, cubeless equity and cubeful equity */
+#define GNUBG_NUM_OUTPUTS 7
+
+/* Equities of the cube actions for the player on roll: the right one,
+ * no double, double/take and double/pass */
+#define GNUBG_NUM_CUBE_OUTPUTS 4
+
+typedef struct _gnubgengine gnubgengine;
+
+/* The state of the game around a position */
+typedef struct {
+    int nMatchTo;               /* match length, 0 for money */
+    int anScore[2];             /* score of the players before the game */
+    int fMove;                  /* which of the players is on roll */
+    int nCube;                  /* cube value */
+    int fCubeOwner;             /* player owning the cube, -1 centred */
+    int fCrawford;              /* Crawford game */
+    int fJacoby;                /* Jacoby rule (money) */
+    int fBeavers;               /* beavers allowed (money) */
+} gnubgcube;
+
+/* Load the neural nets, bearoff databases and match equity table from
+ * szDataDir, or from where gnubg is installed if it is NULL.  Warnings
+ * go to pfMessage, or standard error if it is NULL.  0 on success. */
+extern int GnubgInitialise(const char *szDataDir, void (*pfMessage) (const char *sz));
+
+/* An engine looking nPlies (0 to 4) ahead, cubeful or not.  NULL if
+ * nPlies is out of range. */
+extern gnubgengine *GnubgEngineNew(unsigned int nPlies, int fCubeful);
+extern void GnubgEngineFree(gnubgengine * pge);
+
+/* Add noise of standard deviation rNoise to the evaluations; if
+ * fDeterministic, the same for the same position */
+extern void GnubgEngineSetNoise(gnubgengine * pge, float rNoise, int fDeterministic);
+
+/* Evaluate a position, the player on roll before rolling.  0 on
+ * success, -1 if the position is not valid. */
+extern int GnubgEvaluate(const gnubgengine * pge, const unsigned int anBoard[2][25],
+                         const gnubgcube * pgc, float arOutput[GNUBG_NUM_OUTPUTS]);
+
+/* The best move for a roll, as up to four pairs of from and to points
+ * ending with -1.  The number of entries filled in, 0 if there is no
+ * legal move, -1 if the position is not valid. */
+extern int GnubgBestMove(const gnubgengine * pge, const unsigned int anBoard[2][25], int nDie0, int nDie1,
+                         const gnubgcube * pgc, int anMove[8]);
+
+/* The cube action of the player on roll, and whether the opponent
+ * should take.  0 on success, -1 if the position is not valid. */
+extern int GnubgCubeDecision(const gnubgengine * pge, const unsigned int anBoard[2][25],
+                             const gnubgcube * pgc, float arEquity[GNUBG_NUM_CUBE_OUTPUTS],
+                             int *pfDouble, int *pfTake);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                          /* LIBGNUBG_H */
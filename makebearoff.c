@@ -27,6 +27,9 @@
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <math.h>
 #include <errno.h>
 #include <locale.h>
@@ -48,7 +51,7 @@ MT_CloseThreads(void)
 
 typedef struct {
     void *p;
-    unsigned int iKey;
+    guint64 iKey;
 } xhashent;
 
 typedef struct {
@@ -61,10 +64,10 @@ typedef struct {
 static long cLookup;
 
 static int
-XhashPosition(xhash * ph, const int iKey)
+XhashPosition(xhash * ph, const guint64 iKey)
 {
 
-    return iKey % ph->nHashSize;
+    return (int) (iKey % (guint64) ph->nHashSize);
 
 }
 
@@ -116,7 +119,7 @@ XhashDestroy(xhash * ph)
 
 
 static void
-XhashAdd(xhash * ph, const unsigned int iKey, const void *data, const int size)
+XhashAdd(xhash * ph, const guint64 iKey, const void *data, const int size)
 {
 
     int l = XhashPosition(ph, iKey);
@@ -142,7 +145,7 @@ XhashAdd(xhash * ph, const unsigned int iKey, const void *data, const int size)
 
 
 static void *
-XhashLookup(xhash * ph, const unsigned int iKey)
+XhashLookup(xhash * ph, const guint64 iKey)
 {
 
 
@@ -161,6 +164,156 @@ XhashLookup(xhash * ph, const unsigned int iKey)
 }
 
 
+/*
+ * Results of the whole database, for generating with several threads.
+ * Where it can be done the table is a mapped temporary file, so that
+ * a database bigger than memory is paged out rather than failing.
+ */
+
+typedef struct {
+    void *p;
+    size_t cb;
+    FILE *pf;
+    char *szFile;
+} resulttable;
+
+static void *
+TableCreate(resulttable * prt, size_t cb)
+{
+    prt->cb = cb;
+    prt->pf = NULL;
+    prt->szFile = NULL;
+
+#if HAVE_SYS_MMAN_H
+    if ((prt->pf = GetTemporaryFile(NULL, &prt->szFile)) != NULL) {
+        if (ftruncate(fileno(prt->pf), (off_t) cb) == 0) {
+            prt->p = mmap(NULL, cb, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(prt->pf), 0);
+            if (prt->p != MAP_FAILED)
+                return prt->p;
+        }
+        fclose(prt->pf);
+        g_unlink(prt->szFile);
+        g_free(prt->szFile);
+        prt->pf = NULL;
+        prt->szFile = NULL;
+    }
+#endif
+
+    return prt->p = g_malloc(cb);
+}
+
+static void
+TableDestroy(resulttable * prt)
+{
+    if (prt->pf) {
+#if HAVE_SYS_MMAN_H
+        munmap(prt->p, prt->cb);
+#endif
+        fclose(prt->pf);
+        g_unlink(prt->szFile);
+        g_free(prt->szFile);
+    } else
+        g_free(prt->p);
+}
+
+/*
+ * Positions are generated level by level, where the positions of a
+ * level only depend on positions of lower levels, so the positions of
+ * one level can be shared out between the threads.
+ */
+
+typedef struct {
+    void (*pfnPosition) (const void *p, int iLevel, int iItem);
+    const void *p;
+    int iLevel;
+    int cItems;
+    int iNext;
+} levelwork;
+
+static void
+LevelPositions(levelwork * plw)
+{
+    int i;
+
+    while ((i = MT_SafeIncCheck(&plw->iNext)) < plw->cItems)
+        plw->pfnPosition(plw->p, plw->iLevel, i);
+}
+
+#if defined(USE_MULTITHREAD)
+typedef struct {
+    levelwork *plw;
+    ThreadLocalData *ptld;
+} levelthread;
+
+static gpointer
+LevelThread(gpointer p)
+{
+    levelthread *plt = (levelthread *) p;
+
+    TLSSetValue(td.tlsItem, (size_t) plt->ptld);
+    LevelPositions(plt->plw);
+
+    return NULL;
+}
+#endif
+
+static void
+GenerateLevels(int cLevels, int (*pfnCount) (const void *p, int iLevel),
+               void (*pfnPosition) (const void *p, int iLevel, int iItem), const void *p, int cThreads)
+{
+    levelwork lw;
+    int fTTY = isatty(STDERR_FILENO);
+#if defined(USE_MULTITHREAD)
+    levelthread alt[MAX_NUMTHREADS];
+    GThread *athread[MAX_NUMTHREADS];
+    int k;
+
+    /* the calling thread is one of them */
+    for (k = 0; k < cThreads - 1; k++) {
+        alt[k].plw = &lw;
+        alt[k].ptld = MT_CreateThreadLocalData(k);
+    }
+#endif
+
+    lw.pfnPosition = pfnPosition;
+    lw.p = p;
+
+    for (lw.iLevel = 0; lw.iLevel < cLevels; lw.iLevel++) {
+#if defined(USE_MULTITHREAD)
+        int c;
+#endif
+
+        lw.cItems = pfnCount(p, lw.iLevel);
+        lw.iNext = 0;
+
+#if defined(USE_MULTITHREAD)
+        c = MIN(cThreads, lw.cItems) - 1;
+        for (k = 0; k < c; k++)
+#if GLIB_CHECK_VERSION (2,32,0)
+            athread[k] = g_thread_new(NULL, LevelThread, &alt[k]);
+#else
+            athread[k] = g_thread_create(LevelThread, &alt[k], TRUE, NULL);
+#endif
+#endif
+
+        LevelPositions(&lw);
+
+#if defined(USE_MULTITHREAD)
+        for (k = 0; k < c; k++)
+            g_thread_join(athread[k]);
+#endif
+
+        if (fTTY)
+            g_printerr("%d/%d        \r", lw.iLevel + 1, cLevels);
+    }
+
+#if defined(USE_MULTITHREAD)
+    for (k = 0; k < cThreads - 1; k++)
+        MT_FreeThreadLocalData(alt[k].ptld);
+#endif
+}
+
+
 static int
 OSLookup(const unsigned int iPos,
          const int UNUSED(nPoints),
@@ -344,7 +497,8 @@ RollsOS(const unsigned short int aus[32])
 static void
 BearOff(int nId, unsigned int nPoints,
         unsigned short int aOutProb[64],
-        const int fGammon, xhash * ph, bearoffcontext * pbc, const int fCompress, FILE * pfOutput, FILE * pfTmp)
+        const int fGammon, xhash * ph, bearoffcontext * pbc, const int fCompress, FILE * pfOutput, FILE * pfTmp,
+        const unsigned short int *ausTable)
 {
 #if !defined(G_DISABLE_ASSERT)
     int iBest;
@@ -356,7 +510,7 @@ BearOff(int nId, unsigned int nPoints,
     int k;
     unsigned int us;
     unsigned int usBest;
-    unsigned short int *pusj;
+    const unsigned short int *pusj;
     unsigned short int ausj[64];
     unsigned short int ausBest[32];
 
@@ -429,14 +583,18 @@ BearOff(int nId, unsigned int nPoints,
 
                 if (!j) {
 
-                    memset(pusj = ausj, 0, fGammon ? 128 : 64);
-                    pusj[0] = 0xFFFF;
-                    pusj[32] = 0xFFFF;
+                    memset(ausj, 0, fGammon ? 128 : 64);
+                    ausj[0] = 0xFFFF;
+                    ausj[32] = 0xFFFF;
+                    pusj = ausj;
 
+                } else if (ausTable) {
+                    /* all lower levels are done */
+                    pusj = ausTable + 64 * (size_t) j;
                 } else if (!(pusj = XhashLookup(ph, j))) {
                     /* look up in file generated so far */
+                    OSLookup(j, nPoints, ausj, fGammon, fCompress, pfOutput, pfTmp);
                     pusj = ausj;
-                    OSLookup(j, nPoints, pusj, fGammon, fCompress, pfOutput, pfTmp);
 
                     XhashAdd(ph, j, pusj, fGammon ? 128 : 64);
                 }
@@ -582,31 +740,114 @@ WriteFloat(const float r, FILE * output)
  *   the tmp file is concatenated to the index when
  *   the generation is done.
  *
+ * With more than one thread the distributions are all calculated
+ * first, a pip count at a time, and written out afterwards.
+ *
  */
 
+typedef struct {
+    unsigned int nPoints;
+    int fGammon;
+    bearoffcontext *pbc;
+    unsigned short int *ausTable;
+    unsigned int *aiOrder;      /* positions sorted by pip count */
+    unsigned int *aiLevel;      /* start of each pip count in aiOrder */
+} osgenerate;
+
+static int
+OSLevelCount(const void *p, int iLevel)
+{
+    const osgenerate *pog = (const osgenerate *) p;
+
+    return (int) (pog->aiLevel[iLevel + 1] - pog->aiLevel[iLevel]);
+}
+
+static void
+OSLevelPosition(const void *p, int iLevel, int iItem)
+{
+    const osgenerate *pog = (const osgenerate *) p;
+    unsigned int i = pog->aiOrder[pog->aiLevel[iLevel] + (unsigned int) iItem];
+
+    BearOff((int) i, pog->nPoints, pog->ausTable + 64 * (size_t) i, pog->fGammon, NULL, pog->pbc, FALSE, NULL, NULL,
+            pog->ausTable);
+}
+
+static void
+GenerateOSTable(const int nOS, const int fGammon, bearoffcontext * pbc, const int cThreads, resulttable * prt)
+{
+    osgenerate og;
+    unsigned int n = Combination(nOS + 15, nOS);
+    unsigned int cPips = 15 * (unsigned int) nOS;
+    unsigned int *aiPips = g_new(unsigned int, n);
+    unsigned int i, j;
+
+    og.nPoints = (unsigned int) nOS;
+    og.fGammon = fGammon;
+    og.pbc = pbc;
+    og.ausTable = TableCreate(prt, (size_t) n * 128);
+    og.aiOrder = g_new(unsigned int, n);
+    og.aiLevel = g_new0(unsigned int, cPips + 2);
+
+    /* a move always lowers the pip count, so sort the positions by it */
+
+    for (i = 0; i < n; ++i) {
+        unsigned int an[25];
+
+        PositionFromBearoff(an, i, og.nPoints, 15);
+        for (aiPips[i] = 0, j = 0; j < og.nPoints; ++j)
+            aiPips[i] += (j + 1) * an[j];
+        og.aiLevel[aiPips[i] + 1]++;
+    }
+
+    for (j = 0; j <= cPips; ++j)
+        og.aiLevel[j + 1] += og.aiLevel[j];
+
+    for (i = 0; i < n; ++i)
+        og.aiOrder[og.aiLevel[aiPips[i]]++] = i;
+
+    /* filling in moved the starts along by one level */
+    for (j = cPips + 1; j > 0; --j)
+        og.aiLevel[j] = og.aiLevel[j - 1];
+    og.aiLevel[0] = 0;
+
+    g_free(aiPips);
+
+    GenerateLevels((int) cPips + 1, OSLevelCount, OSLevelPosition, &og, cThreads);
+
+    g_free(og.aiOrder);
+    g_free(og.aiLevel);
+}
 
 static int
 generate_os(const int nOS, const int fHeader,
-            const int fCompress, const int fGammon, const int nHashSize, bearoffcontext * pbc, FILE * output)
+            const int fCompress, const int fGammon, const int nHashSize, bearoffcontext * pbc, FILE * output,
+            const int cThreads)
 {
 
     int i;
     int n;
     unsigned short int aus[64];
     xhash h;
+    resulttable rt;
+    const unsigned short int *ausTable = NULL;
     FILE *pfTmp = NULL;
     unsigned int npos;
     char *tmpfile = NULL;
     int fTTY = isatty(STDERR_FILENO);
 
-    /* initialise xhash */
+    if (cThreads > 1) {
+        GenerateOSTable(nOS, fGammon, pbc, cThreads, &rt);
+        ausTable = rt.p;
+    } else {
+        /* initialise xhash */
 
-    if (XhashCreate(&h, nHashSize / (fGammon ? 128 : 64))) {
-        g_printerr(_("Error creating xhash with %d elements\n"), nHashSize / (fGammon ? 128 : 64));
-        exit(2);
-    }
+        if (XhashCreate(&h, nHashSize / (fGammon ? 128 : 64))) {
+            g_printerr(_("Error creating xhash with %d elements\n"), nHashSize / (fGammon ? 128 : 64));
+            exit(2);
+        }
 
-    XhashStatus(&h);
+        XhashStatus(&h);
+    }
 
     /* write header */
 
@@ -633,8 +874,10 @@ generate_os(const int nOS, const int fHeader,
 
     for (i = 0; i < n; ++i) {
 
-        if (i)
-            BearOff(i, nOS, aus, fGammon, &h, pbc, fCompress, output, pfTmp);
+        if (ausTable)
+            memcpy(aus, ausTable + 64 * (size_t) i, 128);
+        else if (i)
+            BearOff(i, nOS, aus, fGammon, &h, pbc, fCompress, output, pfTmp, NULL);
         else {
             memset(aus, 0, 128);
             aus[0] = 0xFFFF;
@@ -647,7 +890,8 @@ generate_os(const int nOS, const int fHeader,
         if (fGammon)
             WriteOS(aus + 32, fCompress, fCompress ? pfTmp : output);
 
-        XhashAdd(&h, i, aus, fGammon ? 128 : 64);
+        if (!ausTable)
+            XhashAdd(&h, i, aus, fGammon ? 128 : 64);
 
         if (fCompress)
             WriteIndex(&npos, aus, fGammon, output);
@@ -680,9 +924,13 @@ generate_os(const int nOS, const int fHeader,
     }
     putc('\n', stderr);
 
-    XhashStatus(&h);
+    if (ausTable)
+        TableDestroy(&rt);
+    else {
+        XhashStatus(&h);
 
-    XhashDestroy(&h);
+        XhashDestroy(&h);
+    }
 
     return 0;
 
@@ -903,16 +1151,16 @@ CubeEquity(const short int siND, const short int siDT, const short int siDP)
 
 }
 
-static int
+static guint64
 CalcPosition(const int i, const int j, const int n)
 {
 
-    int k;
+    guint64 k;
 
     if (i + j < n)
-        k = (i + j) * (i + j + 1) / 2 + j;
+        k = (guint64) (i + j) * (i + j + 1) / 2 + j;
     else
-        k = n * n - CalcPosition(n - 1 - i, n - 1 - j, n - 1) - 1;
+        k = (guint64) n * n - CalcPosition(n - 1 - i, n - 1 - j, n - 1) - 1;
 
 #if 0
     if (n == 6) {
@@ -928,19 +1176,34 @@ CalcPosition(const int i, const int j, const int n)
 
 
 
+/*
+ * The temporary file of a large two-sided database can be bigger than
+ * fseek() reaches with a long.
+ */
+
+static int
+SeekTmp(FILE * pf, const guint64 offset)
+{
+#if defined(WIN32)
+    return _fseeki64(pf, (__int64) offset, SEEK_SET);
+#else
+    return fseeko(pf, (off_t) offset, SEEK_SET);
+#endif
+}
+
 static void
 TSLookup(const int nUs, const int nThem,
          const int UNUSED(nTSP), const int UNUSED(nTSC),
          short int arEquity[4], const int n, const int fCubeful, FILE * pfTmp)
 {
 
-    int iPos = CalcPosition(nUs, nThem, n);
+    guint64 iPos = CalcPosition(nUs, nThem, n);
     unsigned char ac[8];
     int i;
 
     /* seek to position */
 
-    if (fseek(pfTmp, iPos * (fCubeful ? 8 : 2), SEEK_SET) < 0) {
+    if (SeekTmp(pfTmp, iPos * (fCubeful ? 8 : 2)) < 0) {
         perror("temporary file");
         exit(-1);
     }
@@ -980,7 +1243,8 @@ TSLookup(const int nUs, const int nThem,
 static void
 BearOff2(int nUs, int nThem,
          const int nTSP, const int nTSC,
-         short int asiEquity[4], const int n, const int fCubeful, xhash * ph, bearoffcontext * pbc, FILE * pfTmp)
+         short int asiEquity[4], const int n, const int fCubeful, xhash * ph, bearoffcontext * pbc, FILE * pfTmp,
+         const short int *asiTable)
 {
 
     int j, anRoll[2];
@@ -993,7 +1257,7 @@ BearOff2(int nUs, int nThem,
     int asiBest[4];
     int aiTotal[4];
     short int k;
-    short int *psij;
+    const short int *psij;
     short int asij[4];
     const short int EQUITY_P1 = 0x7FFF;
     const short int EQUITY_M1 = ~EQUITY_P1;
@@ -1026,7 +1290,7 @@ BearOff2(int nUs, int nThem,
         unsigned short int nUsL = (unsigned short) PositionBearoff(anBoard[1], pbc->nPoints, pbc->nChequers);
         unsigned short int nThemL = (unsigned short) PositionBearoff(anBoard[0], pbc->nPoints, pbc->nChequers);
         int nL = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
-        unsigned int iPos = nUsL * nL + nThemL;
+        guint64 iPos = (guint64) nUsL * nL + nThemL;
         unsigned short int aus[4];
 
         BearoffCubeful(pbc, iPos, NULL, aus);
@@ -1061,11 +1325,14 @@ BearOff2(int nUs, int nThem,
                 } else if (!j) {
                     asij[0] = asij[1] = asij[2] = asij[3] = EQUITY_M1;
                 }
-                if (!(psij = XhashLookup(ph, n * nThem + j))) {
+                if (asiTable) {
+                    /* all lower levels are done */
+                    psij = asiTable + 4 * ((size_t) n * nThem + j);
+                } else if (!(psij = XhashLookup(ph, (guint64) n * nThem + j))) {
                     /* lookup in file */
+                    TSLookup(nThem, j, nTSP, nTSC, asij, n, fCubeful, pfTmp);
                     psij = asij;
-                    TSLookup(nThem, j, nTSP, nTSC, psij, n, fCubeful, pfTmp);
-                    XhashAdd(ph, n * nThem + j, psij, fCubeful ? 8 : 2);
+                    XhashAdd(ph, (guint64) n * nThem + j, psij, fCubeful ? 8 : 2);
                 }
 
                 /* cubeless */
@@ -1147,14 +1414,242 @@ WriteEquity(FILE * pf, const short int si)
 
 }
 
+static void
+WriteTSHeader(FILE * pf, const int nTSP, const int nTSC, const int fCubeful, const unsigned int iShard,
+              const unsigned int cShards)
+{
+    char sz[41];
+
+    if (cShards > 1)
+        sprintf(sz, "gnubg-TS-%02d-%02d-%1d-S%03u-%03uxxxxxxxxxxxxxx\n", nTSP, nTSC, fCubeful, iShard, cShards);
+    else
+        sprintf(sz, "gnubg-TS-%02d-%02d-%1dxxxxxxxxxxxxxxxxxxxxxxx\n", nTSP, nTSC, fCubeful);
+    fputs(sz, pf);
+}
+
+/*
+ * Writes a two-sided database compressed in blocks of BEAROFF_BLOCK
+ * positions, in the format that bearoff.c describes.  The offsets of
+ * the blocks are kept until the end and then written after the
+ * header, where room is left for them.
+ */
+
+typedef struct {
+    FILE *pf;
+    int k;                      /* equities per position */
+    guint64 iPos;               /* positions so far */
+    guint64 *aiOffset;          /* of each block so far */
+    guint64 iOffset;            /* of the next block */
+    unsigned short int ausLast[4];
+    unsigned char ach[BEAROFF_BLOCK * 4 * 3];
+    unsigned int cb;            /* of the block so far */
+} tsblockwriter;
+
+static tsblockwriter *
+BlockWriterCreate(FILE * pf, const int n, const int fCubeful)
+{
+    tsblockwriter *ptbw = g_new0(tsblockwriter, 1);
+    guint64 i, cBlocks = ((guint64) n * n + BEAROFF_BLOCK - 1) / BEAROFF_BLOCK;
+
+    ptbw->pf = pf;
+    ptbw->k = fCubeful ? 4 : 1;
+    ptbw->aiOffset = g_new(guint64, cBlocks + 1);
+    ptbw->iOffset = 40 + 8 * (cBlocks + 1);
+
+    for (i = 0; i < 8 * (cBlocks + 1); ++i)
+        putc(0, pf);
+
+    return ptbw;
+}
+
+static void
+BlockWriterFlush(tsblockwriter * ptbw)
+{
+    if (fwrite(ptbw->ach, 1, ptbw->cb, ptbw->pf) != ptbw->cb) {
+        g_printerr(_("failed to read from or write to database file\n"));
+        exit(3);
+    }
+    ptbw->aiOffset[(ptbw->iPos - 1) / BEAROFF_BLOCK] = ptbw->iOffset;
+    ptbw->iOffset += ptbw->cb;
+    ptbw->cb = 0;
+    memset(ptbw->ausLast, 0, sizeof(ptbw->ausLast));
+}
+
+static void
+BlockWriterPut(tsblockwriter * ptbw, const unsigned char ac[8])
+{
+    int i;
+
+    for (i = 0; i < ptbw->k; ++i) {
+        unsigned short int us = ac[2 * i] | (unsigned short) (ac[2 * i + 1] << 8);
+        int d = (int) us - (int) ptbw->ausLast[i];
+        unsigned int z = d < 0 ? ((unsigned int) -d << 1) - 1 : (unsigned int) d << 1;
+
+        while (z >= 0x80) {
+            ptbw->ach[ptbw->cb++] = (unsigned char) (z | 0x80);
+            z >>= 7;
+        }
+        ptbw->ach[ptbw->cb++] = (unsigned char) z;
+        ptbw->ausLast[i] = us;
+    }
+
+    if (!(++ptbw->iPos % BEAROFF_BLOCK))
+        BlockWriterFlush(ptbw);
+}
+
+static void
+BlockWriterDestroy(tsblockwriter * ptbw)
+{
+    guint64 i, cBlocks = (ptbw->iPos + BEAROFF_BLOCK - 1) / BEAROFF_BLOCK;
+    int j;
+
+    if (ptbw->iPos % BEAROFF_BLOCK)
+        BlockWriterFlush(ptbw);
+    ptbw->aiOffset[cBlocks] = ptbw->iOffset;
+
+    if (fseek(ptbw->pf, 40L, SEEK_SET) < 0) {
+        perror("fseek'ing database file");
+        exit(3);
+    }
+    for (i = 0; i <= cBlocks; ++i)
+        for (j = 0; j < 8; ++j)
+            putc((int) ((ptbw->aiOffset[i] >> (8 * j)) & 0xFF), ptbw->pf);
+
+    g_free(ptbw->aiOffset);
+    g_free(ptbw);
+}
+
+static void
+PutTSPosition(FILE * pf, tsblockwriter * ptbw, const unsigned char ac[8], const unsigned int count)
+{
+    if (ptbw)
+        BlockWriterPut(ptbw, ac);
+    else if (fwrite(ac, 1, count, pf) != count) {
+        g_printerr(_("failed to read from or write to database file\n"));
+        exit(3);
+    }
+}
+
+/*
+ * A database split over cShards files has the rows of nShardRows
+ * positions of the player on roll in each; the first file is the
+ * output file and the others are named after it with ".1", ".2" and
+ * so on added.  Returns the file to write row i to.
+ */
+
+static FILE *
+TSShard(FILE * pf, FILE * output, const char *szOutput, const int i, const int nShardRows,
+        const int nTSP, const int nTSC, const int fCubeful, const unsigned int cShards)
+{
+    char *sz;
+    unsigned int iShard;
+
+    if (cShards <= 1 || !i || i % nShardRows)
+        return pf;
+
+    if (pf != output)
+        fclose(pf);
+
+    iShard = (unsigned int) (i / nShardRows);
+    sz = g_strdup_printf("%s.%u", szOutput, iShard);
+    if (!(pf = g_fopen(sz, "wb"))) {
+        perror(sz);
+        exit(3);
+    }
+    g_free(sz);
+
+    WriteTSHeader(pf, nTSP, nTSC, fCubeful, iShard, cShards);
+
+    return pf;
+}
+
+/*
+ * With more than one thread the positions are calculated a level at a
+ * time, where the level is the sum of the two one-sided positions: a
+ * move lowers the mover's position, and the opponent is on roll
+ * next, so each position only needs positions of lower levels.
+ */
+
+typedef struct {
+    int nTSP, nTSC, n;
+    int fCubeful;
+    bearoffcontext *pbc;
+    short int *asiTable;
+} tsgenerate;
+
+static int
+TSLevelCount(const void *p, int iLevel)
+{
+    const tsgenerate *ptg = (const tsgenerate *) p;
+
+    return MIN(iLevel, ptg->n - 1) - MAX(0, iLevel - ptg->n + 1) + 1;
+}
+
+static void
+TSLevelPosition(const void *p, int iLevel, int iItem)
+{
+    const tsgenerate *ptg = (const tsgenerate *) p;
+    int nUs = MAX(0, iLevel - ptg->n + 1) + iItem;
+    int nThem = iLevel - nUs;
+
+    BearOff2(nUs, nThem, ptg->nTSP, ptg->nTSC, ptg->asiTable + 4 * ((size_t) nUs * ptg->n + nThem), ptg->n, ptg->fCubeful,
+             NULL, ptg->pbc, NULL, ptg->asiTable);
+}
+
+static void
+generate_ts_table(const int nTSP, const int nTSC, const int fCubeful, bearoffcontext * pbc, FILE * output,
+                  const char *szOutput, const unsigned int cShards, const int nShardRows, tsblockwriter * ptbw,
+                  const int cThreads)
+{
+    tsgenerate tg;
+    resulttable rt;
+    FILE *pf = output;
+    unsigned char ac[8];
+    int i, j, k;
+
+    tg.nTSP = nTSP;
+    tg.nTSC = nTSC;
+    tg.n = Combination(nTSP + nTSC, nTSC);
+    tg.fCubeful = fCubeful;
+    tg.pbc = pbc;
+    tg.asiTable = TableCreate(&rt, (size_t) tg.n * (size_t) tg.n * 4 * sizeof(short int));
+
+    GenerateLevels(2 * tg.n - 1, TSLevelCount, TSLevelPosition, &tg, cThreads);
+    putc('\n', stderr);
+
+    /* the table is already in the order of the database */
+
+    for (i = 0; i < tg.n; ++i) {
+        pf = TSShard(pf, output, szOutput, i, nShardRows, nTSP, nTSC, fCubeful, cShards);
+        for (j = 0; j < tg.n; ++j) {
+            for (k = 0; k < (fCubeful ? 4 : 1); ++k) {
+                unsigned short int us = (unsigned short int) (tg.asiTable[4 * ((size_t) i * tg.n + j) + k] + 0x8000);
+
+                ac[2 * k] = us & 0xFF;
+                ac[2 * k + 1] = (us >> 8) & 0xFF;
+            }
+            PutTSPosition(pf, ptbw, ac, fCubeful ? 8 : 2);
+        }
+    }
+
+    if (pf != output)
+        fclose(pf);
+
+    TableDestroy(&rt);
+}
+
 static void
 generate_ts(const int nTSP, const int nTSC,
-            const int fHeader, const int fCubeful, const int nHashSize, bearoffcontext * pbc, FILE * output)
+            const int fHeader, const int fCubeful, const int nHashSize, bearoffcontext * pbc, FILE * output,
+            const char *szOutput, const unsigned int cShards, const int nShardRows, const int fBlocks,
+            const int cThreads)
 {
 
     int i, j, k;
-    int iPos;
+    guint64 iPos;
     int n;
+    FILE *pf = output;
+    tsblockwriter *ptbw = NULL;
     short int asiEquity[4];
     xhash h;
     FILE *pfTmp;
@@ -1162,6 +1657,23 @@ generate_ts(const int nTSP, const int nTSC,
     char *tmpfile;
     int fTTY = isatty(STDERR_FILENO);
 
+    /* write header information */
+
+    if (fBlocks) {
+        char sz[41];
+        sprintf(sz, "gnubg-TS-%02d-%02d-%1d-Z%05uxxxxxxxxxxxxxxxx\n", nTSP, nTSC, fCubeful, BEAROFF_BLOCK);
+        fputs(sz, output);
+        ptbw = BlockWriterCreate(output, Combination(nTSP + nTSC, nTSC), fCubeful);
+    } else if (fHeader)
+        WriteTSHeader(output, nTSP, nTSC, fCubeful, 0, cShards);
+
+    if (cThreads > 1) {
+        generate_ts_table(nTSP, nTSC, fCubeful, pbc, output, szOutput, cShards, nShardRows, ptbw, cThreads);
+        if (ptbw)
+            BlockWriterDestroy(ptbw);
+        return;
+    }
+
     pfTmp = GetTemporaryFile(NULL, &tmpfile);
     if (pfTmp == NULL) {
         g_printerr(_("Error creating temporary file\n"));
@@ -1177,14 +1689,6 @@ generate_ts(const int nTSP, const int nTSC,
 
     XhashStatus(&h);
 
-    /* write header information */
-
-    if (fHeader) {
-        char sz[41];
-        sprintf(sz, "gnubg-TS-%02d-%02d-%1dxxxxxxxxxxxxxxxxxxxxxxx\n", nTSP, nTSC, fCubeful);
-        fputs(sz, output);
-    }
-
 
     /* generate bearoff database */
 
@@ -1197,16 +1701,16 @@ generate_ts(const int nTSP, const int nTSC,
     for (i = 0; i < n; i++) {
         for (j = 0; j <= i; j++, ++iPos) {
 
-            BearOff2(i - j, j, nTSP, nTSC, asiEquity, n, fCubeful, &h, pbc, pfTmp);
+            BearOff2(i - j, j, nTSP, nTSC, asiEquity, n, fCubeful, &h, pbc, pfTmp, NULL);
 
             for (k = 0; k < (fCubeful ? 4 : 1); ++k)
                 WriteEquity(pfTmp, asiEquity[k]);
 
-            XhashAdd(&h, (i - j) * n + j, asiEquity, fCubeful ? 8 : 2);
+            XhashAdd(&h, (guint64) (i - j) * n + j, asiEquity, fCubeful ? 8 : 2);
 
         }
         if (fTTY)
-            g_printerr("%d/%d     \r", iPos, n * n);
+            g_printerr("%" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT "     \r", iPos, (guint64) n * n);
     }
 
     /* positions below diagonal */
@@ -1214,16 +1718,16 @@ generate_ts(const int nTSP, const int nTSC,
     for (i = 0; i < n; i++) {
         for (j = i + 1; j < n; j++, ++iPos) {
 
-            BearOff2(i + n - j, j, nTSP, nTSC, asiEquity, n, fCubeful, &h, pbc, pfTmp);
+            BearOff2(i + n - j, j, nTSP, nTSC, asiEquity, n, fCubeful, &h, pbc, pfTmp, NULL);
 
             for (k = 0; k < (fCubeful ? 4 : 1); ++k)
                 WriteEquity(pfTmp, asiEquity[k]);
 
-            XhashAdd(&h, (i + n - j) * n + j, asiEquity, fCubeful ? 8 : 2);
+            XhashAdd(&h, (guint64) (i + n - j) * n + j, asiEquity, fCubeful ? 8 : 2);
 
         }
         if (fTTY)
-            g_printerr("%d/%d     \r", iPos, n * n);
+            g_printerr("%" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT "     \r", iPos, (guint64) n * n);
     }
 
     putc('\n', stderr);
@@ -1240,20 +1744,26 @@ generate_ts(const int nTSP, const int nTSC,
      */
 
     for (i = 0; i < n; ++i) {
+        pf = TSShard(pf, output, szOutput, i, nShardRows, nTSP, nTSC, fCubeful, cShards);
         for (j = 0; j < n; ++j) {
             unsigned int count = fCubeful ? 8 : 2;
 
-            k = CalcPosition(i, j, n);
-
-            fseek(pfTmp, count * k, SEEK_SET);
-            if (fread(ac, 1, count, pfTmp) != count || fwrite(ac, 1, count, output) != count) {
+            SeekTmp(pfTmp, count * CalcPosition(i, j, n));
+            if (fread(ac, 1, count, pfTmp) != count) {
                 g_printerr(_("failed to read from or write to database file\n"));
                 exit(3);
             }
+            PutTSPosition(pf, ptbw, ac, count);
         }
 
     }
 
+    if (pf != output)
+        fclose(pf);
+
+    if (ptbw)
+        BlockWriterDestroy(ptbw);
+
     fclose(pfTmp);
 
     g_unlink(tmpfile);
@@ -1276,6 +1786,9 @@ main(int argc, char **argv)
     static int fND = FALSE;
     static char *szOutput = NULL;
     static char *szTwoSided = NULL;
+    static int cThreads = 1;
+    static int cShards = 1;
+    static int fBlocks = FALSE;
 
     bearoffcontext *pbc = NULL;
     FILE *outfile;
@@ -1303,6 +1816,12 @@ main(int argc, char **argv)
          N_("Approximate one-sided bearoff database with normal distributions"), NULL},
         {"outfile", 'f', 0, G_OPTION_ARG_STRING, &szOutput,
          N_("Required output filename"), "filename"},
+        {"threads", 'j', 0, G_OPTION_ARG_INT, &cThreads,
+         N_("Generate with N threads (one- and two-sided databases)"), "N"},
+        {"shards", 'S', 0, G_OPTION_ARG_INT, &cShards,
+         N_("Split two-sided database over N files"), "N"},
+        {"block-compress", 'z', 0, G_OPTION_ARG_NONE, &fBlocks,
+         N_("Compress two-sided database in blocks"), NULL},
         {NULL, 0, 0, (GOptionArg) 0, NULL, NULL, NULL}
     };
 
@@ -1336,6 +1855,11 @@ main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
+    if (cThreads < 1 || cThreads > MAX_NUMTHREADS) {
+        g_printerr(_("Number of threads must be between 1 and %d\n"), MAX_NUMTHREADS);
+        exit(EXIT_FAILURE);
+    }
+
     if (!(outfile = g_fopen(szOutput, "w+b"))) {
         perror(szOutput);
         return EXIT_FAILURE;
@@ -1358,6 +1882,7 @@ main(int argc, char **argv)
         g_printerr("%-37s: %12s\n", _("Use compression scheme"), fCompress ? _("yes") : _("no"));
         g_printerr("%-37s: %12s\n", _("Write header"), fHeader ? _("yes") : _("no"));
         g_printerr("%-37s: %12d\n", _("Size of cache"), nHashSize);
+        g_printerr("%-37s: %12d\n", _("Number of threads"), cThreads);
         g_printerr("%-37s: %12s %s\n", _("Reuse old bearoff database"), szOldBearoff ? _("yes") : _("no"),
                 szOldBearoff ? szOldBearoff : "");
 
@@ -1389,7 +1914,7 @@ main(int argc, char **argv)
         if (fND) {
             generate_nd(nOS, nHashSize, fHeader, pbc, outfile);
         } else {
-            generate_os(nOS, fHeader, fCompress, fGammon, nHashSize, pbc, outfile);
+            generate_os(nOS, fHeader, fCompress, fGammon, nHashSize, pbc, outfile, cThreads);
         }
 
         BearoffClose(pbc);
@@ -1404,12 +1929,34 @@ main(int argc, char **argv)
     if (nTSC && nTSP) {
 
         int n = Combination(nTSP + nTSC, nTSC);
+        int nShardRows;
 
         if (nTSC > 11) {
             g_printerr(_("Size of two-sided bearoff database must be at most 11 chequers\n"));
             exit(2);
         }
 
+        if (cShards < 1 || cShards > MIN(n, 999)) {
+            g_printerr(_("Number of files must be between 1 and %d\n"), MIN(n, 999));
+            exit(EXIT_FAILURE);
+        }
+
+        if (cShards > 1 && !fHeader) {
+            g_printerr(_("A database split over several files must have a header\n"));
+            exit(EXIT_FAILURE);
+        }
+
+        if (fBlocks && (cShards > 1 || !fHeader)) {
+            g_printerr(_("A compressed database must have a header and be in one file\n"));
+            exit(EXIT_FAILURE);
+        }
+
+        /* as many rows in each file as bearoff.c expects from the
+         * number of files */
+
+        nShardRows = (n + cShards - 1) / cShards;
+        cShards = (n + nShardRows - 1) / nShardRows;
+
         r = n;
         r = r * r * (fCubeful ? 8.0 : 2.0);
         g_printerr("%-37s\n", _("Two-sided database:\n"));
@@ -1419,9 +1966,12 @@ main(int argc, char **argv)
                 fCubeful ? _("cubeless and cubeful") : _("cubeless only"));
         g_printerr("%-37s: %12s\n", _("Write header"), fHeader ? _("yes") : _("no"));
         g_printerr("%-37s: %12d\n", _("Number of one-sided positions"), n);
-        g_printerr("%-37s: %12d\n", _("Total number of positions"), n * n);
+        g_printerr("%-37s: %12" G_GUINT64_FORMAT "\n", _("Total number of positions"), (guint64) n * n);
         g_printerr("%-37s: %.0f %s (%.1f MB)\n", _("Size of resulting file"), r, _("bytes"), r / 1048576.0);
         g_printerr("%-37s: %12d\n", _("Size of xhash"), nHashSize);
+        g_printerr("%-37s: %12d\n", _("Number of files"), cShards);
+        g_printerr("%-37s: %12s\n", _("Compress in blocks"), fBlocks ? _("yes") : _("no"));
+        g_printerr("%-37s: %12d\n", _("Number of threads"), cThreads);
         g_printerr("%-37s: %12s %s\n", _("Reuse old bearoff database"), szOldBearoff ? _("yes") : _("no"),
                 szOldBearoff ? szOldBearoff : "");
         /* initialise old bearoff database */
@@ -1438,7 +1988,8 @@ main(int argc, char **argv)
             exit(2);
         }
 
-        generate_ts(nTSP, nTSC, fHeader, fCubeful, nHashSize, pbc, outfile);
+        generate_ts(nTSP, nTSC, fHeader, fCubeful, nHashSize, pbc, outfile, szOutput, (unsigned int) cShards, nShardRows,
+                    fBlocks, cThreads);
 
         /* close old bearoff database */
 
@@ -0,0 +1,549 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* makedata: make training data for the neural nets.  Positions are
+ * taken from games the 0-ply player plays against itself; those of
+ * the class wanted that haven't been seen before are evaluated at
+ * some plies or rolled out, and written to the output as they are
+ * done.  An interrupted run is continued by running the same command
+ * again: the positions already in the file are read back and skipped.
+ *
+ *   makedata -n 100000 -c race -p 2 race.dat
+ *   makedata -n 100000 -c contact -r 1296 contact.dat
+ *
+ * The file starts with the text line
+ *
+ *   gnubg-data 1 <class> <plies> <trials>
+ *
+ * followed by records of RECORD_SIZE bytes: the key of the position,
+ * player on roll first (10 bytes, see oldPositionKey()), then its
+ * outputs for that player as IEEE floats, little-endian.  A partly
+ * written last record is written over when the run is continued. */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+
+#include "backgammon.h"
+#include "eval.h"
+#include "positionid.h"
+#include "matchequity.h"
+#include "multithread.h"
+#include "glib-ext.h"
+#include "util.h"
+
+#define DATA_MAGIC "gnubg-data"
+#define DATA_VERSION 1
+#define RECORD_SIZE (10 + NUM_OUTPUTS * 4)
+/* records between flushes of the output and progress reports */
+#define FLUSH_EVERY 1000
+
+static const char szStartID[] = "4HPwATDgc/ABMA";
+
+typedef struct {
+    /* what is made */
+    int iClass;                 /* class of the positions, -1 for all the net classes */
+    evalcontext ecTarget;       /* how the targets are evaluated, if not rolled out */
+    unsigned int cTrials;       /* rollout trials for each target, 0 to evaluate */
+    evalcontext ecPlay;         /* the player of the games and rollouts */
+    guint32 nSeed;
+
+    /* the positions written or being evaluated, guarded by mutex */
+    GMutex mutex;
+    GHashTable *phtSeen;
+    FILE *pf;
+    unsigned int cWanted, cClaimed, cWritten;
+    int fFailed;
+} datajob;
+
+typedef struct {
+    datajob *pdj;
+    unsigned int iThread;
+} datathread;
+
+extern void
+outputerrf(const char *sz, ...)
+{
+    va_list val;
+    char *szMessage;
+
+    va_start(val, sz);
+    szMessage = g_strdup_vprintf(sz, val);
+    va_end(val);
+
+    g_printerr("%s\n", szMessage);
+    g_free(szMessage);
+}
+
+extern void
+MT_CloseThreads(void)
+{
+    return;
+}
+
+static guint
+KeyHash(gconstpointer p)
+{
+    const unsigned char *auch = p;
+    guint h = 0;
+    int i;
+
+    for (i = 0; i < 10; i++)
+        h = (h ^ auch[i]) * 0x01000193u;
+
+    return h;
+}
+
+static gboolean
+KeyEqual(gconstpointer p0, gconstpointer p1)
+{
+    return !memcmp(p0, p1, 10);
+}
+
+static int
+WantedClass(const datajob * pdj, positionclass pc)
+{
+    return pdj->iClass < 0 ? pc >= CLASS_RACE : (int) pc == pdj->iClass;
+}
+
+/* Note the position as done; FALSE if it was already */
+static int
+AddSeen(datajob * pdj, const oldpositionkey * pkey)
+{
+    oldpositionkey *p;
+
+    if (g_hash_table_lookup(pdj->phtSeen, pkey))
+        return FALSE;
+
+    p = g_new(oldpositionkey, 1);
+    *p = *pkey;
+    g_hash_table_insert(pdj->phtSeen, p, p);
+
+    return TRUE;
+}
+
+/* Take the position for the calling thread to evaluate: 1 if it is
+ * its to do, 0 if it has been done already, -1 if no more are wanted */
+static int
+ClaimPosition(datajob * pdj, const oldpositionkey * pkey)
+{
+    int n;
+
+    g_mutex_lock(&pdj->mutex);
+    if (pdj->fFailed || pdj->cClaimed >= pdj->cWanted)
+        n = -1;
+    else if (!AddSeen(pdj, pkey))
+        n = 0;
+    else {
+        pdj->cClaimed++;
+        n = 1;
+    }
+    g_mutex_unlock(&pdj->mutex);
+
+    return n;
+}
+
+static void
+WriteRecord(datajob * pdj, const oldpositionkey * pkey, const float arOutput[NUM_OUTPUTS])
+{
+    unsigned char auch[RECORD_SIZE];
+    int i;
+
+    memcpy(auch, pkey->auch, 10);
+    for (i = 0; i < NUM_OUTPUTS; i++) {
+        guint32 n;
+
+        memcpy(&n, arOutput + i, 4);
+        n = GUINT32_TO_LE(n);
+        memcpy(auch + 10 + 4 * i, &n, 4);
+    }
+
+    g_mutex_lock(&pdj->mutex);
+    if (fwrite(auch, RECORD_SIZE, 1, pdj->pf) != 1)
+        pdj->fFailed = TRUE;
+    else if (!(++pdj->cWritten % FLUSH_EVERY)) {
+        fflush(pdj->pf);
+        g_print("\r%u/%u", pdj->cWritten, pdj->cWanted);
+    }
+    g_mutex_unlock(&pdj->mutex);
+}
+
+static void
+MakedataRollDice(GRand * pr, int anDice[2])
+{
+    anDice[0] = g_rand_int_range(pr, 1, 7);
+    anDice[1] = g_rand_int_range(pr, 1, 7);
+}
+
+/* Roll the position out without cube: play it to the end cTrials
+ * times, the outputs for the player on roll.  Positions the bearoff
+ * databases know exactly are looked up instead of played on. */
+static int
+RolloutPosition(const datajob * pdj, GRand * pr, const TanBoard anBoard,
+                movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], float arOutput[NUM_OUTPUTS])
+{
+    evalcontext ecPlay = pdj->ecPlay;
+    evalcontext ecExact = { FALSE, 0, FALSE, TRUE, 0.0f };
+    double arSum[NUM_OUTPUTS] = { 0.0 };
+    cubeinfo ci;
+    unsigned int i;
+    int j;
+
+    SetCubeInfoMoney(&ci, 1, -1, 0, FALSE, FALSE, VARIATION_STANDARD);
+
+    for (i = 0; i < pdj->cTrials; i++) {
+        TanBoard an;
+        float ar[NUM_OUTPUTS];
+        int fSwapped = FALSE, anDice[2], n;
+
+        memcpy(an, anBoard, sizeof(an));
+
+        for (;;) {
+            if (ClassifyPosition((ConstTanBoard) an, VARIATION_STANDARD) <= CLASS_PERFECT) {
+                if (EvaluatePosition(NULL, (ConstTanBoard) an, ar, &ci, &ecExact) < 0)
+                    return -1;
+                break;
+            }
+
+            MakedataRollDice(pr, anDice);
+            if (FindBestMove(NULL, anDice[0], anDice[1], an, &ci, &ecPlay, aamf) < 0)
+                return -1;
+
+            if ((n = GameStatus((ConstTanBoard) an, VARIATION_STANDARD))) {
+                /* the player who moved has won */
+                ar[OUTPUT_WIN] = 1.0f;
+                ar[OUTPUT_WINGAMMON] = n > 1 ? 1.0f : 0.0f;
+                ar[OUTPUT_WINBACKGAMMON] = n > 2 ? 1.0f : 0.0f;
+                ar[OUTPUT_LOSEGAMMON] = ar[OUTPUT_LOSEBACKGAMMON] = 0.0f;
+                break;
+            }
+
+            SwapSides(an);
+            fSwapped = !fSwapped;
+        }
+
+        if (fSwapped)
+            InvertEvaluation(ar);
+
+        for (j = 0; j < NUM_OUTPUTS; j++)
+            arSum[j] += ar[j];
+    }
+
+    for (j = 0; j < NUM_OUTPUTS; j++)
+        arOutput[j] = (float) (arSum[j] / pdj->cTrials);
+
+    return 0;
+}
+
+/* Play games until no more positions are wanted, evaluating and
+ * writing the new ones of the class wanted as they come up */
+static gpointer
+DataThread(gpointer p)
+{
+    const datathread *pdt = p;
+    datajob *pdj = pdt->pdj;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    evalcontext ecPlay = pdj->ecPlay;
+    evalcontext ecTarget = pdj->ecTarget;
+    GRand *pr = g_rand_new_with_seed(pdj->nSeed + pdt->iThread * 0x9e3779b9u);
+    cubeinfo ci;
+    int fDone = FALSE, fError = FALSE;
+
+#if defined(USE_MULTITHREAD)
+    MT_AttachThread();
+#endif
+
+    memcpy(aamf, defaultFilters, sizeof(aamf));
+    SetCubeInfoMoney(&ci, 1, -1, 0, FALSE, FALSE, VARIATION_STANDARD);
+
+    while (!fDone) {
+        TanBoard anBoard;
+        int anDice[2];
+
+        PositionFromID(anBoard, szStartID);
+
+        do {
+            if (WantedClass(pdj, ClassifyPosition((ConstTanBoard) anBoard, VARIATION_STANDARD))) {
+                oldpositionkey key;
+                float arOutput[NUM_OUTPUTS];
+                int n, nRet;
+
+                oldPositionKey((ConstTanBoard) anBoard, &key);
+
+                if ((n = ClaimPosition(pdj, &key)) < 0) {
+                    fDone = TRUE;
+                    break;
+                } else if (n) {
+                    if (pdj->cTrials)
+                        nRet = RolloutPosition(pdj, pr, (ConstTanBoard) anBoard, aamf, arOutput);
+                    else
+                        nRet = EvaluatePosition(NULL, (ConstTanBoard) anBoard, arOutput, &ci, &ecTarget);
+
+                    if (nRet < 0) {
+                        fError = TRUE;
+                        break;
+                    }
+
+                    WriteRecord(pdj, &key, arOutput);
+                }
+            }
+
+            MakedataRollDice(pr, anDice);
+            if (FindBestMove(NULL, anDice[0], anDice[1], anBoard, &ci, &ecPlay, aamf) < 0) {
+                fError = TRUE;
+                break;
+            }
+
+            SwapSides(anBoard);
+        } while (!GameStatus((ConstTanBoard) anBoard, VARIATION_STANDARD));
+
+        if (fError) {
+            g_mutex_lock(&pdj->mutex);
+            pdj->fFailed = TRUE;
+            g_mutex_unlock(&pdj->mutex);
+            fDone = TRUE;
+        }
+    }
+
+    g_rand_free(pr);
+
+    return NULL;
+}
+
+/* Open the output to add to it: the positions already in it are read
+ * back if it was made with the same settings.  NULL on errors. */
+static FILE *
+OpenData(const char *sz, const char *szHeader, datajob * pdj)
+{
+    FILE *pf;
+    char szLine[128];
+    unsigned char auch[RECORD_SIZE];
+    oldpositionkey key;
+
+    if (!(pf = g_fopen(sz, "r+b"))) {
+        if (!(pf = g_fopen(sz, "wb"))) {
+            g_printerr(_("Can't write %s\n"), sz);
+            return NULL;
+        }
+        fputs(szHeader, pf);
+        return pf;
+    }
+
+    if (!fgets(szLine, sizeof(szLine), pf) || strcmp(szLine, szHeader)) {
+        g_printerr(_("%s was not made by makedata with the same class, plies and trials\n"), sz);
+        fclose(pf);
+        return NULL;
+    }
+
+    while (fread(auch, RECORD_SIZE, 1, pf) == 1) {
+        memcpy(key.auch, auch, 10);
+        AddSeen(pdj, &key);
+        pdj->cWritten++;
+    }
+
+    /* write from the end of the last whole record */
+    if (fseek(pf, (long) (strlen(szHeader) + (size_t) pdj->cWritten * RECORD_SIZE), SEEK_SET)) {
+        g_printerr(_("Can't write %s\n"), sz);
+        fclose(pf);
+        return NULL;
+    }
+
+    return pf;
+}
+
+extern int
+main(int argc, char **argv)
+{
+    static char *szDataDir = NULL;
+    static char *szClass = NULL;
+    static int nPositions = 0;
+    static int nPlies = 0;
+    static int nTrials = 0;
+    static int nThreads = 1;
+    static int nSeed = 0;
+    static double rNoise = 0.0;
+    static const char *aszClass[] = { "race", "crashed", "contact", "all" };
+    static const int aiClass[] = { CLASS_RACE, CLASS_CRASHED, CLASS_CONTACT, -1 };
+    datajob dj;
+    unsigned int i;
+
+    GOptionEntry ao[] = {
+        {"datadir", 'd', 0, G_OPTION_ARG_FILENAME, &szDataDir,
+         N_("Read the weights and databases from DIR"), "DIR"},
+        {"positions", 'n', 0, G_OPTION_ARG_INT, &nPositions,
+         N_("Make N positions in all"), "N"},
+        {"class", 'c', 0, G_OPTION_ARG_STRING, &szClass,
+         N_("Positions of CLASS: race, crashed, contact or all (default)"), "CLASS"},
+        {"plies", 'p', 0, G_OPTION_ARG_INT, &nPlies,
+         N_("Evaluate the targets at N plies (default 0)"), "N"},
+        {"rollout", 'r', 0, G_OPTION_ARG_INT, &nTrials,
+         N_("Roll the targets out with N trials instead"), "N"},
+        {"noise", 'z', 0, G_OPTION_ARG_DOUBLE, &rNoise,
+         N_("Play the games with noise X, to vary them more"), "X"},
+        {"threads", 'j', 0, G_OPTION_ARG_INT, &nThreads,
+         N_("Calculate with N threads"), "N"},
+        {"seed", 's', 0, G_OPTION_ARG_INT, &nSeed,
+         N_("Seed the dice with N (default from the time)"), "N"},
+        {NULL, 0, 0, (GOptionArg) 0, NULL, NULL, NULL}
+    };
+    GError *error = NULL;
+    GOptionContext *context;
+
+    setlocale(LC_ALL, "");
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+
+    context = g_option_context_new(_("file"));
+    g_option_context_add_main_entries(context, ao, PACKAGE);
+    g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (error) {
+        g_printerr("%s\n", error->message);
+        exit(1);
+    }
+
+    if (argc != 2 || nPositions <= 0) {
+        g_printerr(_("An output file and the number of positions (-n) should be given\n"
+                     "For more help try `makedata --help'\n"));
+        exit(1);
+    }
+
+    memset(&dj, 0, sizeof(dj));
+
+    dj.iClass = -1;
+    if (szClass) {
+        for (i = 0; i < G_N_ELEMENTS(aszClass) && strcmp(szClass, aszClass[i]); i++);
+        if (i == G_N_ELEMENTS(aszClass)) {
+            g_printerr(_("Unknown class of position: %s\n"), szClass);
+            exit(1);
+        }
+        dj.iClass = aiClass[i];
+    }
+
+    if (nPlies < 0 || nPlies >= MAX_FILTER_PLIES || nTrials < 0 || rNoise < 0.0) {
+        g_printerr(_("The plies must be from 0 to %d, the trials and noise not negative\n"),
+                   MAX_FILTER_PLIES - 1);
+        exit(1);
+    }
+
+    dj.ecTarget.nPlies = (unsigned int) nPlies;
+    dj.ecTarget.fUsePrune = TRUE;
+    dj.ecTarget.fDeterministic = TRUE;
+    dj.cTrials = (unsigned int) nTrials;
+    dj.ecPlay.fDeterministic = TRUE;
+    dj.ecPlay.rNoise = (float) rNoise;
+    dj.cWanted = (unsigned int) nPositions;
+
+#if defined(USE_MULTITHREAD)
+    if (nThreads < 1 || nThreads > MAX_NUMTHREADS) {
+        g_printerr(_("Number of threads must be between 1 and %d\n"), MAX_NUMTHREADS);
+        exit(1);
+    }
+#else
+    nThreads = 1;
+#endif
+
+    if (szDataDir) {
+        g_free(pkg_datadir);
+        pkg_datadir = g_strdup(szDataDir);
+    }
+
+    glib_ext_init();
+    MT_InitThreads();
+
+    {
+        char *szMET = BuildFilename2("met", "Kazaross-XG2.xml");
+        char *szWeights = BuildFilename("gnubg.weights");
+        char *szWeightsBinary = BuildFilename("gnubg.wd");
+
+        InitMatchEquity(szMET);
+        EvalInitialise(szWeights, szWeightsBinary, FALSE, NULL);
+        g_free(szMET);
+        g_free(szWeights);
+        g_free(szWeightsBinary);
+    }
+
+#if defined(USE_MULTITHREAD)
+    EvaluatePosition = EvaluatePositionWithLocking;
+    FindBestMove = FindBestMoveWithLocking;
+    FindnSaveBestMoves = FindnSaveBestMovesWithLocking;
+    ScoreMove = ScoreMoveWithLocking;
+    PrefetchMoves = PrefetchMovesWithLocking;
+#endif
+
+    g_mutex_init(&dj.mutex);
+    dj.phtSeen = g_hash_table_new_full(KeyHash, KeyEqual, g_free, NULL);
+
+    {
+        char *szHeader = g_strdup_printf(DATA_MAGIC " %d %s %d %d\n", DATA_VERSION, szClass ? szClass : "all",
+                                         nPlies, nTrials);
+
+        if (!(dj.pf = OpenData(argv[1], szHeader, &dj)))
+            exit(1);
+        g_free(szHeader);
+    }
+
+    /* a continued run goes on with other dice */
+    dj.nSeed = (guint32) (nSeed ? nSeed : g_get_real_time()) + dj.cWritten;
+    dj.cClaimed = dj.cWritten;
+
+    if (dj.cWritten >= dj.cWanted)
+        g_print(_("%s holds %u positions already\n"), argv[1], dj.cWritten);
+    else {
+        g_print(_("Making %u positions with %d threads, %u in the file already\n"),
+                dj.cWanted - dj.cWritten, nThreads, dj.cWritten);
+
+#if defined(USE_MULTITHREAD)
+        GThread **apt = g_new(GThread *, nThreads);
+        datathread *adt = g_new(datathread, nThreads);
+
+        for (i = 0; i < (unsigned int) nThreads; i++) {
+            adt[i].pdj = &dj;
+            adt[i].iThread = i;
+            apt[i] = g_thread_new("makedata", DataThread, adt + i);
+        }
+        for (i = 0; i < (unsigned int) nThreads; i++)
+            g_thread_join(apt[i]);
+        g_free(apt);
+        g_free(adt);
+#else
+        /* the thread data is the main thread's */
+        datathread dt = { &dj, 0 };
+
+        DataThread(&dt);
+#endif
+
+        g_print("\r%u/%u\n", dj.cWritten, dj.cWanted);
+    }
+
+    if (fclose(dj.pf) || dj.fFailed) {
+        g_printerr(_("Making the positions failed\n"));
+        exit(1);
+    }
+
+    g_hash_table_destroy(dj.phtSeen);
+    g_mutex_clear(&dj.mutex);
+    EvalShutdown();
+
+    return 0;
+}
@@ -105,11 +105,46 @@ ClassifyHyper(TanBoard anBoard)
 
 }
 
+/*
+ * EvalOver() for nC chequers; there is no variation with four of
+ * them.
+ */
+
 static void
 HyperOver(const TanBoard anBoard, float ar[NUM_OUTPUTS], const int nC)
 {
 
-    EvalOver(anBoard, ar, VARIATION_HYPERGAMMON_1 + nC - 1, NULL);
+    int i, c;
+    int fLost;
+
+    if (nC <= 3) {
+        EvalOver(anBoard, ar, VARIATION_HYPERGAMMON_1 + nC - 1, NULL);
+        return;
+    }
+
+    for (i = 0; i < 25; i++)
+        if (anBoard[0][i])
+            break;
+
+    /* whether the player on roll has lost, and else the opponent has */
+    fLost = (i == 25);
+
+    for (i = 0, c = 0; i < 25; i++)
+        c += anBoard[fLost][i];
+
+    ar[OUTPUT_WIN] = fLost ? 0.0f : 1.0f;
+    ar[OUTPUT_WINGAMMON] = ar[OUTPUT_WINBACKGAMMON] = 0.0f;
+    ar[OUTPUT_LOSEGAMMON] = ar[OUTPUT_LOSEBACKGAMMON] = 0.0f;
+
+    if (c == nC) {
+        /* the loser has all chequers on the board: gammon, and
+         * backgammon with one in the winner's home board or on the bar */
+        ar[fLost ? OUTPUT_LOSEGAMMON : OUTPUT_WINGAMMON] = 1.0f;
+
+        for (i = 18; i < 25; i++)
+            if (anBoard[fLost][i])
+                ar[fLost ? OUTPUT_LOSEBACKGAMMON : OUTPUT_WINBACKGAMMON] = 1.0f;
+    }
 
 }
 
@@ -307,9 +342,10 @@ HyperEquity(const int nUs, const int nThem, hyperequity * phe, const int nC, con
     const hyperequity *phex;
     float r;
 
-    /* save old hyper equity */
+    /* save old hyper equity; phe is in aheOld itself unless the
+     * sweep is double-buffered */
 
-    memcpy(&heOld, phe, sizeof(hyperequity));
+    memcpy(&heOld, &aheOld[nPos * nUs + nThem], sizeof(hyperequity));
 
     /* generate board for position */
 
@@ -461,27 +497,109 @@ HyperEquity(const int nUs, const int nThem, hyperequity * phe, const int nC, con
 }
 
 
+/*
+ * One sweep over all positions.  With one thread the new equities
+ * replace the old ones as they are calculated (Gauss-Seidel), as
+ * makehyper always did.  With more, each thread takes the next row
+ * of positions of the player on roll, and they read aheOld and write
+ * aheNew (Jacobi), so that no thread reads what another is writing.
+ */
+
+typedef struct {
+    const hyperequity *aheOld;
+    hyperequity *aheNew;
+    int nC;
+    int nPos;
+    int iNext;
+} hypersweep;
+
+typedef struct {
+    hypersweep *phs;
+    float arNorm[10];
+#if defined(USE_MULTITHREAD)
+    ThreadLocalData *ptld;
+#endif
+} hyperthread;
+
 static void
-CalcNewEquity(hyperequity ahe[], const int nC, float arNorm[])
+SweepRows(hyperthread * pht, const int fProgress)
 {
 
+    hypersweep *phs = pht->phs;
     int i, j;
-    int nPos = Combination(25 + nC, nC);
 
     for (i = 0; i < 10; ++i)
-        arNorm[i] = 0.0f;
+        pht->arNorm[i] = 0.0f;
 
-    for (i = 0; i < nPos; ++i) {
+    while ((i = MT_SafeIncCheck(&phs->iNext)) < phs->nPos) {
 
-        g_print("\r%d/%d              ", i + 1, nPos);
-        fflush(stdout);
+        if (fProgress) {
+            g_print("\r%d/%d              ", i + 1, phs->nPos);
+            fflush(stdout);
+        }
 
-        for (j = 0; j < nPos; ++j) {
+        for (j = 0; j < phs->nPos; ++j)
+            HyperEquity(i, j, &phs->aheNew[(size_t) i * phs->nPos + j], phs->nC, phs->aheOld, pht->arNorm);
 
-            HyperEquity(i, j, &ahe[i * nPos + j], nC, ahe, arNorm);
+    }
 
-        }
+}
+
+#if defined(USE_MULTITHREAD)
+static gpointer
+SweepThread(gpointer p)
+{
+    hyperthread *pht = (hyperthread *) p;
+
+    TLSSetValue(td.tlsItem, (size_t) pht->ptld);
+    SweepRows(pht, FALSE);
 
+    return NULL;
+}
+#endif
+
+static void
+CalcNewEquity(const hyperequity aheOld[], hyperequity aheNew[], const int nC, float arNorm[], hyperthread aht[],
+              const int cThreads)
+{
+
+    hypersweep hs;
+    int i, k;
+#if defined(USE_MULTITHREAD)
+    GThread *athread[MAX_NUMTHREADS];
+#endif
+
+    hs.aheOld = aheOld;
+    hs.aheNew = aheNew;
+    hs.nC = nC;
+    hs.nPos = Combination(25 + nC, nC);
+    hs.iNext = 0;
+
+    for (k = 0; k < cThreads; ++k)
+        aht[k].phs = &hs;
+
+#if defined(USE_MULTITHREAD)
+    /* the calling thread is the last one */
+    for (k = 0; k < cThreads - 1; ++k)
+#if GLIB_CHECK_VERSION (2,32,0)
+        athread[k] = g_thread_new(NULL, SweepThread, &aht[k]);
+#else
+        athread[k] = g_thread_create(SweepThread, &aht[k], TRUE, NULL);
+#endif
+#endif
+
+    SweepRows(&aht[cThreads - 1], TRUE);
+
+#if defined(USE_MULTITHREAD)
+    for (k = 0; k < cThreads - 1; ++k)
+        g_thread_join(athread[k]);
+#endif
+
+    for (i = 0; i < 10; ++i) {
+        arNorm[i] = 0.0f;
+        for (k = 0; k < cThreads; ++k)
+            if (aht[k].arNorm[i] > arNorm[i])
+                arNorm[i] = aht[k].arNorm[i];
     }
 
     g_print("\n");
@@ -522,7 +640,8 @@ WriteHyperFile(const char *szFilename, const hyperequity ahe[], const int nC)
 {
 
     int nPos = Combination(25 + nC, nC);
-    int i, j, k;
+    size_t i, j;
+    int k;
     char sz[41];
     FILE *pf;
 
@@ -536,8 +655,8 @@ WriteHyperFile(const char *szFilename, const hyperequity ahe[], const int nC)
     fputs(sz, pf);
 
 
-    for (i = 0; i < nPos; ++i)
-        for (j = 0; j < nPos; ++j) {
+    for (i = 0; i < (size_t) nPos; ++i)
+        for (j = 0; j < (size_t) nPos; ++j) {
             for (k = 0; k < NUM_OUTPUTS; ++k)
                 WriteProb(pf, ahe[i * nPos + j].arOutput[k]);
             for (k = 1; k < 5; ++k)
@@ -557,28 +676,39 @@ main(int argc, char **argv)
 
     int nC = 3;
     hyperequity *aheEquity;
+    hyperequity *aheNew;
+    hyperthread *aht;
     int nPos;
     float rNorm;
     float rEpsilon = 1.0e-5f;
     gchar *szEpsilon = NULL;
     bearoffcontext *pbc = NULL;
     int it;
-    char szFilename[20];
+    char *szFilename;
     float arNorm[10];
     time_t t0, t1, t2, t3;
     char *szOutput = NULL;
     char *szRestart = NULL;
     int fCheckPoint = TRUE;
+    int nCheckPoint = 1;
+    int cThreads = 1;
+#if defined(USE_MULTITHREAD)
+    int k;
+#endif
 
     GOptionEntry ao[] = {
         {"chequers", 'c', 0, G_OPTION_ARG_INT, &nC,
-         N_("The number of chequers (0<C<4). Default is 3"), "C"},
+         N_("The number of chequers (0<C<5). Default is 3"), "C"},
         {"restart", 'r', 0, G_OPTION_ARG_FILENAME, &szRestart,
          N_("Restart calculation of database from \"filename\"."), "filename"},
         {"threshold", 't', 0, G_OPTION_ARG_STRING, &szEpsilon,
          N_("The convergence threshold (T). Default is 1e-5"), "T"},
         {"no-checkpoint", 'n', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &fCheckPoint,
          N_("Do not write a checkpoint file after each iteration"), NULL},
+        {"checkpoint-every", 'i', 0, G_OPTION_ARG_INT, &nCheckPoint,
+         N_("Write the checkpoint file every N iterations. Default is 1"), "N"},
+        {"threads", 'j', 0, G_OPTION_ARG_INT, &cThreads,
+         N_("Calculate with N threads"), "N"},
         {"outfile", 'f', 0, G_OPTION_ARG_STRING, &szOutput,
          N_("Output filename. Default is hyper<C>.bd"), "filename"},
         {NULL, 0, 0, (GOptionArg) 0, NULL, NULL, NULL}
@@ -616,11 +746,16 @@ main(int argc, char **argv)
         exit(1);
     }
 
-    if (nC < 1 || nC > 3) {
+    if (nC < 1 || nC > 4 || nCheckPoint < 1) {
         g_printerr(_("Illegal options. Try `makehyper --help' for usage information\n"));
         exit(1);
     }
 
+    if (cThreads < 1 || cThreads > MAX_NUMTHREADS) {
+        g_printerr(_("Number of threads must be between 1 and %d\n"), MAX_NUMTHREADS);
+        exit(1);
+    }
+
     if (!szOutput)
         szOutput = g_strdup_printf("hyper%d.bd", nC);
 
@@ -634,7 +769,9 @@ main(int argc, char **argv)
 
     g_print("%-40s: %d\n", _("Total number of one sided positions"), nPos);
     g_print("%-40s: %d\n", _("Total number of two sided positions"), nPos * nPos);
-    g_print("%-40s: %d %s\n", _("Estimated size of file"), nPos * nPos * 28 + 40,  _("bytes"));
+    g_print("%-40s: %" G_GUINT64_FORMAT " %s\n", _("Estimated size of file"), (guint64) nPos * nPos * 28 + 40,
+            _("bytes"));
+    g_print("%-40s: %d\n", _("Number of threads"), cThreads);
     g_print("%-40s: %s\n", _("Output file"), szOutput);
     g_print("%-40s: %e\n", _("Convergence threshold"), rEpsilon);
 
@@ -644,10 +781,11 @@ main(int argc, char **argv)
 
     g_print(_("*** Obtain start guess ***\n"));
 
-    SetCubeInfo(&ci, 1, -1, 0, 0, NULL, FALSE, FALSE, FALSE, VARIATION_HYPERGAMMON_1 + nC - 1);
-    SetCubeInfo(&ciJacoby, 1, -1, 0, 0, NULL, FALSE, TRUE, FALSE, VARIATION_HYPERGAMMON_1 + nC - 1);
+    /* money play, where the variation makes no difference to the cube */
+    SetCubeInfo(&ci, 1, -1, 0, 0, NULL, FALSE, FALSE, FALSE, VARIATION_HYPERGAMMON_1 + MIN(nC, 3) - 1);
+    SetCubeInfo(&ciJacoby, 1, -1, 0, 0, NULL, FALSE, TRUE, FALSE, VARIATION_HYPERGAMMON_1 + MIN(nC, 3) - 1);
 
-    aheEquity = (hyperequity *) g_malloc(nPos * nPos * sizeof(hyperequity));
+    aheEquity = (hyperequity *) g_malloc((size_t) nPos * nPos * sizeof(hyperequity));
 
     if (!szRestart) {
         g_print(_("0-vector start guess\n"));
@@ -661,6 +799,23 @@ main(int argc, char **argv)
 
     g_print(_("Time for start guess: %d seconds\n"), (int) (t1 - t0));
 
+    /* the illegal positions are never written, so start both buffers
+     * the same */
+
+    if (cThreads > 1) {
+        aheNew = (hyperequity *) g_malloc((size_t) nPos * nPos * sizeof(hyperequity));
+        memcpy(aheNew, aheEquity, (size_t) nPos * nPos * sizeof(hyperequity));
+    } else
+        aheNew = aheEquity;
+
+    aht = g_new0(hyperthread, cThreads);
+#if defined(USE_MULTITHREAD)
+    for (k = 0; k < cThreads - 1; ++k)
+        aht[k].ptld = MT_CreateThreadLocalData(k);
+#endif
+
+    szFilename = g_strdup_printf("%s.tmp", szOutput);
+
     it = 1;
 
     do {
@@ -669,7 +824,14 @@ main(int argc, char **argv)
 
         g_print(_("*** Iteration %03d *** \n"), it);
 
-        CalcNewEquity(aheEquity, nC, arNorm);
+        CalcNewEquity(aheEquity, aheNew, nC, arNorm, aht, cThreads);
+
+        if (aheNew != aheEquity) {
+            hyperequity *ahe = aheEquity;
+
+            aheEquity = aheNew;
+            aheNew = ahe;
+        }
 
         rNorm = NormOO(arNorm, 10);
 
@@ -677,11 +839,18 @@ main(int argc, char **argv)
 
         if (fCheckPoint) {
 
-            sprintf(szFilename, "%s.tmp", szOutput);
-            if (rNorm > rEpsilon)
-                WriteHyperFile(szFilename, aheEquity, nC);
-            else
-                unlink(szFilename);
+            /* written aside first, so that a run stopped while writing
+             * still has the last checkpoint to restart from */
+
+            if (rNorm > rEpsilon && !(it % nCheckPoint)) {
+                char *szPart = g_strdup_printf("%s.part", szFilename);
+
+                WriteHyperFile(szPart, aheEquity, nC);
+                g_unlink(szFilename);
+                g_rename(szPart, szFilename);
+                g_free(szPart);
+            } else if (rNorm <= rEpsilon)
+                g_unlink(szFilename);
 
         }
 
@@ -700,7 +869,15 @@ main(int argc, char **argv)
 
     g_print(_("Time for writing final file: %d seconds\n"), (int) (t1 - t0));
 
+#if defined(USE_MULTITHREAD)
+    for (k = 0; k < cThreads - 1; ++k)
+        MT_FreeThreadLocalData(aht[k].ptld);
+#endif
+    g_free(aht);
+    if (aheNew != aheEquity)
+        g_free(aheNew);
     g_free(aheEquity);
+    g_free(szFilename);
     g_free(szOutput);
 
     time(&t3);
@@ -32,7 +32,8 @@
 static void
 usage(char *prog)
 {
-    g_printerr(_("Usage: %s [[-f] outputfile [inputfile]]\n"
+    g_printerr(_("Usage: %s [-m] [[-f] outputfile [inputfile]]\n"
+            "  -m: Write memory mappable weights (gnubg.wm)\n"
             "  outputfile: Output to file instead of stdout\n"
             "  inputfile: Input from file instead of stdin\n"), prog);
     exit(1);
@@ -44,7 +45,9 @@ main(int argc, /*lint -e{818} */ char *argv[])
     neuralnet nn;
     char szFileVersion[16];
     static float ar[2] = { WEIGHTS_MAGIC_BINARY, WEIGHTS_VERSION_BINARY };
-    int c;
+    int c, i;
+    int fMapped = FALSE;
+    neuralnet *apnn[16];
     FILE *in = stdin, *out = stdout;
 
     if (!setlocale(LC_ALL, "C") || !bindtextdomain(PACKAGE, LOCALEDIR) || !textdomain(PACKAGE)) {
@@ -54,6 +57,13 @@ main(int argc, /*lint -e{818} */ char *argv[])
 
     g_set_printerr_handler(print_utf8_to_locale);
 
+    if (argc > 1 && !StrCaseCmp(argv[1], "-m")) {
+        fMapped = TRUE;
+        argv[1] = argv[0];
+        argc--;
+        argv++;
+    }
+
     if (argc > 1) {
         int arg = 1;
         if (!StrCaseCmp(argv[1], "-f"))
@@ -91,27 +101,50 @@ main(int argc, /*lint -e{818} */ char *argv[])
         return EXIT_FAILURE;
     }
 
-    if (fwrite(ar, sizeof(ar[0]), 2, out) != 2) {
-        g_printerr(_("Failed to write neural net!"));
-        fclose(in);
-        fclose(out);
-        return EXIT_FAILURE;
-    }
+    if (fMapped) {
+        /* all the nets come before the header can be written */
+        for (c = 0; !feof(in); c++)
+            if (c == G_N_ELEMENTS(apnn) || NeuralNetLoad(apnn[c] = g_new0(neuralnet, 1), in) == -1) {
+                g_printerr(_("Failed to load neural net!"));
+                fclose(in);
+                fclose(out);
+                return EXIT_FAILURE;
+            }
 
-    for (c = 0; !feof(in); c++) {
-        if (NeuralNetLoad(&nn, in) == -1) {
-            g_printerr(_("Failed to load neural net!"));
+        if (NeuralNetSaveMapped((const neuralnet * const *) apnn, c, szFileVersion, out) == -1) {
+            g_printerr(_("Failed to save neural net!"));
             fclose(in);
             fclose(out);
             return EXIT_FAILURE;
         }
-        if (NeuralNetSaveBinary(&nn, out) == -1) {
-            g_printerr(_("Failed to save neural net!"));
+
+        for (i = 0; i < c; i++) {
+            NeuralNetDestroy(apnn[i]);
+            g_free(apnn[i]);
+        }
+    } else {
+        if (fwrite(ar, sizeof(ar[0]), 2, out) != 2) {
+            g_printerr(_("Failed to write neural net!"));
             fclose(in);
             fclose(out);
             return EXIT_FAILURE;
         }
-        NeuralNetDestroy(&nn);
+
+        for (c = 0; !feof(in); c++) {
+            if (NeuralNetLoad(&nn, in) == -1) {
+                g_printerr(_("Failed to load neural net!"));
+                fclose(in);
+                fclose(out);
+                return EXIT_FAILURE;
+            }
+            if (NeuralNetSaveBinary(&nn, out) == -1) {
+                g_printerr(_("Failed to save neural net!"));
+                fclose(in);
+                fclose(out);
+                return EXIT_FAILURE;
+            }
+            NeuralNetDestroy(&nn);
+        }
     }
 
     g_printerr(_("%d nets converted\n"), c);
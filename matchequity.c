@@ -22,6 +22,7 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
@@ -29,6 +30,7 @@
 #include <stdarg.h>
 
 #include "list.h"
+#include "md5.h"
 #include "mec.h"
 #include "util.h"
 
@@ -78,12 +80,16 @@ typedef struct {
 float aafMET[MAXSCORE][MAXSCORE];
 float aafMETPostCrawford[2][MAXSCORE];
 
-/* gammon prices (calculated once for efficiency) */
+/* gammon prices, computed the first time GammonPrices() is asked for
+ * them; an entry is valid while its aan... entry is nGammonPrices */
 
-float aaaafGammonPrices[MAXCUBELEVEL]
+static float aaaafGammonPrices[MAXCUBELEVEL]
     [MAXSCORE][MAXSCORE][4];
-float aaaafGammonPricesPostCrawford[MAXCUBELEVEL]
+static float aaaafGammonPricesPostCrawford[MAXCUBELEVEL]
     [MAXSCORE][2][4];
+static gint aaanGammonPrices[MAXCUBELEVEL][MAXSCORE][MAXSCORE];
+static gint aaanGammonPricesPostCrawford[MAXCUBELEVEL][MAXSCORE][2];
+static gint nGammonPrices = 1;
 
 
 metinfo miCurrent;
@@ -226,10 +232,11 @@ initMETZadeh(float aafMET[MAXSCORE][MAXSCORE],
      * of player 2 (1) assuming semiefficient recubes.
      */
 
-    float aaafD1[MAXSCORE][MAXSCORE][MAXCUBELEVEL];
-    float aaafD2[MAXSCORE][MAXSCORE][MAXCUBELEVEL];
-    float aaafD1bar[MAXSCORE][MAXSCORE][MAXCUBELEVEL];
-    float aaafD2bar[MAXSCORE][MAXSCORE][MAXCUBELEVEL];
+    /* 1 MB each, too much for the stack */
+    float (*aaafD1)[MAXSCORE][MAXCUBELEVEL] = g_malloc(sizeof(float[MAXSCORE][MAXSCORE][MAXCUBELEVEL]));
+    float (*aaafD2)[MAXSCORE][MAXCUBELEVEL] = g_malloc(sizeof(float[MAXSCORE][MAXSCORE][MAXCUBELEVEL]));
+    float (*aaafD1bar)[MAXSCORE][MAXCUBELEVEL] = g_malloc(sizeof(float[MAXSCORE][MAXSCORE][MAXCUBELEVEL]));
+    float (*aaafD2bar)[MAXSCORE][MAXCUBELEVEL] = g_malloc(sizeof(float[MAXSCORE][MAXSCORE][MAXCUBELEVEL]));
 
 
     /*
@@ -373,18 +380,79 @@ initMETZadeh(float aafMET[MAXSCORE][MAXSCORE],
 
     }
 
+    g_free(aaafD1);
+    g_free(aaafD2);
+    g_free(aaafD1bar);
+    g_free(aaafD2bar);
+
+}
+
+extern void
+FillMETTable(scoremet * pmt, const cubeinfo * pci)
+{
+    /* normalize score */
+
+    int i = pci->nMatchTo - pci->anScore[0] - 1;
+    int j = pci->nMatchTo - pci->anScore[1] - 1;
+
+    int nDead, n, fMove;
+
+    pmt->nMatchTo = pci->nMatchTo;
+    pmt->anScore[0] = pci->anScore[0];
+    pmt->anScore[1] = pci->anScore[1];
+    pmt->nCube = pci->nCube;
+    pmt->fCrawford = pci->fCrawford;
+
+    /* Find out what value the cube has when you or your
+     * opponent give a dead cube. */
+
+    nDead = pci->nCube;
+    pmt->nMax = 0;
+
+    while ((i >= 2 * nDead) && (j >= 2 * nDead)) {
+        pmt->nMax++;
+        nDead *= 2;
+    }
+
+    /* Even though it's a dead cube we take account of the opponents
+     * automatic redouble. */
+
+    for (n = 0; n <= pmt->nMax; n++) {
+        int nCubeValue = pci->nCube << n;
+
+        getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo, nCubeValue, GetCubePrimeValue(i, j, nCubeValue),     /* 0 */
+                      GetCubePrimeValue(j, i, nCubeValue),      /* 1 */
+                      pci->fCrawford, aafMET, aafMETPostCrawford, pmt->aaarMET[n][0], pmt->aaarMET[n][1]);
+    }
+
+    for (fMove = 0; fMove < 2; fMove++) {
+        pmt->aarMwc[fMove][0] = getME(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
+                                      fMove, pci->nCube, fMove, pci->fCrawford, aafMET, aafMETPostCrawford);
+        pmt->aarMwc[fMove][1] = getME(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
+                                      fMove, pci->nCube, !fMove, pci->fCrawford, aafMET, aafMETPostCrawford);
+    }
 }
 
 extern int
 GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
+{
+    scoremet mt;
+
+    FillMETTable(&mt, pci);
+    GetPointsMET(arOutput, pci, &mt, arCP);
+
+    return 0;
+}
+
+extern void
+GetPointsMET(const float arOutput[5], const cubeinfo * pci, const scoremet * pmt, float arCP[2])
 {
 
     /*
      * Input:
      * - arOutput: we need the gammon and backgammon ratios
      *   (we assume arOutput is evaluate for pci -> fMove)
-     * - anScore: the current score.
-     * - nMatchTo: matchlength
+     * - pmt: the match equities of the score and cube of pci
      * - pci: value of cube, who's turn is it
      * 
      *
@@ -402,18 +470,13 @@ GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
     int i = pci->nMatchTo - pci->anScore[0] - 1;
     int j = pci->nMatchTo - pci->anScore[1] - 1;
 
-    int nCube = pci->nCube;
-
     float arCPLive[2][MAXCUBELEVEL];
     float arCPDead[2][MAXCUBELEVEL];
     float arG[2], arBG[2];
 
     float rDP, rRDP, rDTW, rDTL;
 
-    int nDead, n, nMax, nCubeValue, k;
-
-
-    float aarMETResults[2][DTLBP1 + 1];
+    int n, nCubeValue, k;
 
     /* Gammon and backgammon ratio's. 
      * Avoid division by zero in extreme cases. */
@@ -459,31 +522,15 @@ GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
         }
     }
 
-    /* Find out what value the cube has when you or your
-     * opponent give a dead cube. */
-
-    nDead = nCube;
-    nMax = 0;
-
-    while ((i >= 2 * nDead) && (j >= 2 * nDead)) {
-        nMax++;
-        nDead *= 2;
-    }
-
-    for (nCubeValue = nDead, n = nMax; n >= 0; nCubeValue >>= 1, n--) {
+    for (n = pmt->nMax; n >= 0; n--) {
 
         /* Calculate dead and live cube cash points.
          * See notes by me (Joern Thyssen) available from the
          * 'doc' directory.  (FIXME: write notes :-) ) */
 
-        /* Even though it's a dead cube we take account of the opponents
-         * automatic redouble. */
-
-        /* Dead cube cash point for player 0 */
+        const float (*aarMETResults)[DTLBP1 + 1] = pmt->aaarMET[n];
 
-        getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo, nCubeValue, GetCubePrimeValue(i, j, nCubeValue), /* 0 */
-                      GetCubePrimeValue(j, i, nCubeValue),      /* 1 */
-                      pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResults[0], aarMETResults[1]);
+        nCubeValue = pci->nCube << n;
 
         for (k = 0; k < 2; k++) {
 
@@ -539,7 +586,7 @@ GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
     arCP[1] = arCPLive[1][0];
 
 #if 0
-    for (n = nMax; n >= 0; n--) {
+    for (n = pmt->nMax; n >= 0; n--) {
 
         printf("Cube %i\n"
                "Dead cube:    cash point 0 %6.3f\n"
@@ -551,8 +598,6 @@ GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
     }
 #endif
 
-    return 0;
-
 }
 
 extern float
@@ -1464,41 +1509,207 @@ getGammonPrice(float arGammonPrice[4],
 }
 
 /*
- * Calculate all gammon and backgammon prices
+ * Gammon and backgammon prices at nAway0, nAway1 away with cube value
+ * 1 << iCube, and post-Crawford with fPlayer nAway away.
  *
- * Input:
- *   aafMET, aafMETPostCrawford: match equity tables
- *
- * Output:
- *   aaaafGammonPrices: all gammon prices
+ * They are computed when first asked for, as the tables for all scores
+ * up to MAXSCORE are large and a session only meets a few of them.
+ * Two threads may compute the same entry at once; they write the same
+ * values, and an entry is only read after its flag says it is there.
  *
  */
 
+extern const float *
+GammonPrices(const int iCube, const int nAway0, const int nAway1)
+{
+    float *ar = aaaafGammonPrices[iCube][nAway0][nAway1];
+    gint *pn = &aaanGammonPrices[iCube][nAway0][nAway1];
+    gint n = g_atomic_int_get(&nGammonPrices);
+
+    if (g_atomic_int_get(pn) != n) {
+        getGammonPrice(ar, MAXSCORE - nAway0 - 1, MAXSCORE - nAway1 - 1, MAXSCORE,
+                       1 << iCube, FALSE, aafMET, aafMETPostCrawford);
+        g_atomic_int_set(pn, n);
+    }
+
+    return ar;
+}
+
+extern const float *
+GammonPricesPostCrawford(const int iCube, const int nAway, const int fPlayer)
+{
+    float *ar = aaaafGammonPricesPostCrawford[iCube][nAway][fPlayer];
+    gint *pn = &aaanGammonPricesPostCrawford[iCube][nAway][fPlayer];
+    gint n = g_atomic_int_get(&nGammonPrices);
+
+    if (g_atomic_int_get(pn) != n) {
+        if (fPlayer)
+            getGammonPrice(ar, MAXSCORE - nAway - 1, MAXSCORE - 1, MAXSCORE, 1 << iCube, FALSE,
+                           aafMET, aafMETPostCrawford);
+        else
+            getGammonPrice(ar, MAXSCORE - 1, MAXSCORE - nAway - 1, MAXSCORE, 1 << iCube, FALSE,
+                           aafMET, aafMETPostCrawford);
+        g_atomic_int_set(pn, n);
+    }
+
+    return ar;
+}
+
+/* forget the gammon prices of the previous match equity table */
 static void
-calcGammonPrices(float aafMET[MAXSCORE][MAXSCORE],
-                 float aafMETPostCrawford[2][MAXSCORE], float aaaafGammonPrices[MAXCUBELEVEL]
-                 [MAXSCORE][MAXSCORE][4], float aaaafGammonPricesPostCrawford[MAXCUBELEVEL]
-                 [MAXSCORE][2][4])
+FlushGammonPrices(void)
 {
+    g_atomic_int_inc(&nGammonPrices);
+}
 
-    int i, j, k;
-    int nCube;
+/* The MET cache: the extended tables of each match equity file read, in a file named after the md5 checksum of its
+ * contents in szMETCacheDir.  The header is followed by the name and
+ * description of the table and the arrays as they are in memory. */
 
-    for (i = 0, nCube = 1; i < MAXCUBELEVEL; i++, nCube *= 2)
-        for (j = 0; j < MAXSCORE; j++)
-            for (k = 0; k < MAXSCORE; k++)
-                getGammonPrice(aaaafGammonPrices[i][j][k],
-                               MAXSCORE - j - 1, MAXSCORE - k - 1, MAXSCORE,
-                               nCube, (MAXSCORE == j) || (MAXSCORE == k), aafMET, aafMETPostCrawford);
-
-    for (i = 0, nCube = 1; i < MAXCUBELEVEL; i++, nCube *= 2)
-        for (j = 0; j < MAXSCORE; j++) {
-            getGammonPrice(aaaafGammonPricesPostCrawford[i][j][0],
-                           MAXSCORE - 1, MAXSCORE - j - 1, MAXSCORE, nCube, FALSE, aafMET, aafMETPostCrawford);
-            getGammonPrice(aaaafGammonPricesPostCrawford[i][j][1],
-                           MAXSCORE - j - 1, MAXSCORE - 1, MAXSCORE, nCube, FALSE, aafMET, aafMETPostCrawford);
-        }
+#define METCACHE_MAGIC "gnubgmc"
+#define METCACHE_FORMAT 2
+
+typedef struct {
+    char szMagic[8];
+    uint32_t nFormat;
+    uint32_t nMaxScore;
+    uint32_t nMaxCubeLevel;
+    int32_t nLength;
+    uint32_t cchName;
+    uint32_t cchDescription;
+    unsigned char auchKey[16];
+} metcacheheader;
+
+#define METCACHE_TABLES (sizeof(aafMET) + sizeof(aafMETPostCrawford))
+
+static char *szMETCacheDir = NULL;
+
+/* Keep the tables of the match equity files read in directory sz, or
+ * nowhere if NULL. */
+extern void
+METSetCacheDirectory(const char *sz)
+{
+    g_free(szMETCacheDir);
+    szMETCacheDir = sz ? g_strdup(sz) : NULL;
+}
+
+/* The name of the cache file for the match equity file szFileName, or
+ * NULL if there is none.  auchKey is set to the checksum it is named
+ * after. */
+static char *
+METCacheFile(const char *szFileName, unsigned char auchKey[16])
+{
+    gchar *pch, *sz, *szHex;
+    gsize cb;
+    unsigned int i;
+    int n = METCACHE_FORMAT;
+    struct md5_ctx ctx;
+
+    if (!szMETCacheDir || !g_file_get_contents(szFileName, &pch, &cb, NULL))
+        return NULL;
+
+    md5_init_ctx(&ctx);
+    md5_process_bytes(&n, sizeof(n), &ctx);
+    md5_process_bytes(pch, cb, &ctx);
+    md5_finish_ctx(&ctx, auchKey);
+    g_free(pch);
+
+    szHex = g_malloc(33);
+    for (i = 0; i < 16; i++)
+        sprintf(szHex + 2 * i, "%02x", auchKey[i]);
+    sz = g_strconcat(szHex, ".bin", NULL);
+    pch = g_build_filename(szMETCacheDir, sz, NULL);
+    g_free(szHex);
+    g_free(sz);
+
+    return pch;
+}
+
+/* Load the tables from the cache file sz into the current ones and
+ * pmi.  Returns 0 on success, -1 if the file is missing or was not made
+ * for auchKey by this version. */
+static int
+METCacheRead(const char *sz, const unsigned char auchKey[16], metinfo * pmi)
+{
+    gchar *pch;
+    const char *p;
+    metcacheheader h;
+    gsize cb;
+
+    if (!g_file_get_contents(sz, &pch, &cb, NULL))
+        return -1;
+
+    if (cb < sizeof(h)) {
+        g_free(pch);
+        return -1;
+    }
+
+    memcpy(&h, pch, sizeof(h));
+    if (strcmp(h.szMagic, METCACHE_MAGIC) || h.nFormat != METCACHE_FORMAT
+        || h.nMaxScore != MAXSCORE || h.nMaxCubeLevel != MAXCUBELEVEL
+        || memcmp(h.auchKey, auchKey, sizeof(h.auchKey))
+        || cb != sizeof(h) + h.cchName + h.cchDescription + METCACHE_TABLES) {
+        g_free(pch);
+        return -1;
+    }
+
+    p = pch + sizeof(h);
+    pmi->szName = g_strndup(p, h.cchName);
+    p += h.cchName;
+    pmi->szDescription = h.cchDescription ? g_strndup(p, h.cchDescription) : NULL;
+    p += h.cchDescription;
+    pmi->nLength = h.nLength;
+
+    memcpy(aafMET, p, sizeof(aafMET));
+    p += sizeof(aafMET);
+    memcpy(aafMETPostCrawford, p, sizeof(aafMETPostCrawford));
+
+    g_free(pch);
 
+    return 0;
+}
+
+/* Save the current tables described by pmi to the cache file sz.  A
+ * failure only costs the next start the time to compute them again, so
+ * it is not reported. */
+static void
+METCacheWrite(const char *sz, const unsigned char auchKey[16], const metinfo * pmi)
+{
+    metcacheheader h;
+    char *pch, *p;
+    gsize cb;
+
+    memset(&h, 0, sizeof(h));
+    strcpy(h.szMagic, METCACHE_MAGIC);
+    h.nFormat = METCACHE_FORMAT;
+    h.nMaxScore = MAXSCORE;
+    h.nMaxCubeLevel = MAXCUBELEVEL;
+    h.nLength = pmi->nLength;
+    h.cchName = pmi->szName ? (uint32_t) strlen(pmi->szName) : 0;
+    h.cchDescription = pmi->szDescription ? (uint32_t) strlen(pmi->szDescription) : 0;
+    memcpy(h.auchKey, auchKey, sizeof(h.auchKey));
+
+    cb = sizeof(h) + h.cchName + h.cchDescription + METCACHE_TABLES;
+    p = pch = g_malloc(cb);
+
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    if (h.cchName)
+        memcpy(p, pmi->szName, h.cchName);
+    p += h.cchName;
+    if (h.cchDescription)
+        memcpy(p, pmi->szDescription, h.cchDescription);
+    p += h.cchDescription;
+    memcpy(p, aafMET, sizeof(aafMET));
+    p += sizeof(aafMET);
+    memcpy(p, aafMETPostCrawford, sizeof(aafMETPostCrawford));
+
+    /* g_file_set_contents() replaces the file at once, so a gnubg
+     * starting meanwhile never reads half of it */
+    if (g_mkdir_with_parents(szMETCacheDir, 0700) == 0)
+        g_file_set_contents(sz, pch, (gssize) cb, NULL);
+
+    g_free(pch);
 }
 
 extern void
@@ -1506,10 +1717,29 @@ InitMatchEquity(const char *szFileName)
 {
     int i, j;
     metdata md;
+    metinfo mi;
+    unsigned char auchKey[16];
+    char *szCache = METCacheFile(szFileName, auchKey);
+
+    /* Tables computed before from the same file */
+    if (szCache && METCacheRead(szCache, auchKey, &mi) == 0) {
+        g_free(szCache);
+
+        g_free(miCurrent.szName);
+        g_free(miCurrent.szFileName);
+        g_free(miCurrent.szDescription);
+
+        miCurrent = mi;
+        miCurrent.szFileName = g_strdup(szFileName);
+        FlushGammonPrices();
+        return;
+    }
 
     /* Read match equity table from XML file */
     if (readMET(&md, szFileName) != 0) {        /* load failed - make default as must have a met */
         getDefaultMET(&md);
+        g_free(szCache);
+        szCache = NULL;
     }
 
     /* Copy met to current met, extend met (if needed) */
@@ -1539,6 +1769,7 @@ InitMatchEquity(const char *szFileName)
             if (initPostCrawfordMETFromParameters(aafMETPostCrawford[j], &md.ampPostCrawford[j]) < 0) {
 
                 fprintf(stderr, _("Error generating post-Crawford MET\n"));
+                g_free(szCache);
                 return;
 
             }
@@ -1556,6 +1787,7 @@ InitMatchEquity(const char *szFileName)
         if (initMETFromParameters(aafMET, aafMETPostCrawford, &md.mpPreCrawford) < 0) {
 
             fprintf(stderr, _("Error generating pre-Crawford MET\n"));
+            g_free(szCache);
             return;
         }
     }
@@ -1576,8 +1808,12 @@ InitMatchEquity(const char *szFileName)
     /* save match equity table information */
     memcpy(&miCurrent, &md.mi, sizeof(metinfo));
 
-    /* initialise gammon prices */
-    calcGammonPrices(aafMET, aafMETPostCrawford, aaaafGammonPrices, aaaafGammonPricesPostCrawford);
+    FlushGammonPrices();
+
+    if (szCache) {
+        METCacheWrite(szCache, auchKey, &miCurrent);
+        g_free(szCache);
+    }
 }
 
 
@@ -1707,7 +1943,7 @@ invertMET(void)
         }
     }
 
-    calcGammonPrices(aafMET, aafMETPostCrawford, aaaafGammonPrices, aaaafGammonPricesPostCrawford);
+    FlushGammonPrices();
 }
 
 /* given a match score, return a pair of arrays with the METs for
@@ -23,8 +23,11 @@
 
 #include "eval.h"
 
-#define MAXSCORE      64
-#define MAXCUBELEVEL  7
+/* The longest match played.  The gammon prices are only computed for
+ * the scores and cubes met, see GammonPrices(), so the tables cost
+ * little for shorter matches. */
+#define MAXSCORE      128
+#define MAXCUBELEVEL  8
 
 /* Structure for information about match equity table */
 
@@ -46,12 +49,10 @@ typedef struct {
 extern float aafMET[MAXSCORE][MAXSCORE];
 extern float aafMETPostCrawford[2][MAXSCORE];
 
-/* gammon prices (calculated once for efficiency) */
+/* gammon prices */
 
-extern float aaaafGammonPrices[MAXCUBELEVEL]
-    [MAXSCORE][MAXSCORE][4];
-extern float aaaafGammonPricesPostCrawford[MAXCUBELEVEL]
-    [MAXSCORE][2][4];
+extern const float *GammonPrices(const int iCube, const int nAway0, const int nAway1);
+extern const float *GammonPricesPostCrawford(const int iCube, const int nAway, const int fPlayer);
 
 extern metinfo miCurrent;
 
@@ -71,6 +72,9 @@ getMEAtScore(const int nScore0, const int nScore1, const int nMatchTo,
 void
  InitMatchEquity(const char *szFileName);
 
+extern void
+ METSetCacheDirectory(const char *sz);
+
 /* Get double points */
 
 extern int
@@ -104,6 +108,23 @@ typedef enum {
     NDLP1, DTLP1, NDLBP1, DTLGP1, DTLBP1
 } met_indices;
 
+/* The match equities of a score and cube that GetPoints() and the
+ * cubeful equities of match play need, from FillMETTable(): they do
+ * not depend on the position, so each thread keeps the MET_TABLES last
+ * ones it used */
+#define MET_TABLES 16
+
+typedef struct {
+    int nMatchTo;               /* 0 for none */
+    int anScore[2];
+    int nCube;
+    int fCrawford;
+    int nFlush;                 /* valid while it matches nCacheFlush */
+    int nMax;                   /* the cube levels GetPoints() looks at */
+    float aarMwc[2][2];         /* getME() of [fMove] [winning, losing] nCube */
+    float aaarMET[MAXCUBELEVEL][2][DTLBP1 + 1];        /* getMEMultiple() of nCube << n */
+} scoremet;
+
 extern void
 getMEMultiple(const int nScore0, const int nScore1, const int nMatchTo,
               const int nCube,
@@ -111,4 +132,10 @@ getMEMultiple(const int nScore0, const int nScore1, const int nMatchTo,
               const int fCrawford,
               float aafMET[MAXSCORE][MAXSCORE], float aafMETPostCrawford[2][MAXSCORE], float *player0, float *player1);
 
+extern void
+ FillMETTable(scoremet * pmt, const cubeinfo * pci);
+
+extern void
+ GetPointsMET(const float arOutput[5], const cubeinfo * pci, const scoremet * pmt, float arCP[2]);
+
 #endif
@@ -181,7 +181,7 @@ mec_pc(const float rGammonRate,
 
     /* match length */
 
-    const unsigned int ml = 64;
+    const unsigned int ml = MAXSCORE;
 
     /* gammon rate, i.e. how many of games won/lost will be gammons */
 
@@ -255,7 +255,7 @@ mec(const float rGammonRate, const float rWinRate,
 
     /* match length */
 
-    const unsigned int ml = 64;
+    const unsigned int ml = MAXSCORE;
 
     /* gammon rate, i.e. how many of games won/lost will be gammons */
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The memory accounting, see memusage.h */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#if !defined(__linux__) && defined(HAVE_SYS_RESOURCE_H)
+#include <sys/resource.h>
+#endif
+
+#include "memusage.h"
+
+typedef struct {
+    gsize cbCurrent;
+    gsize cbPeak;
+} memcount;
+
+/* Subsystems account from any thread, rarely enough for a lock */
+static GMutex mutex;
+static memcount amc[N_MEM];
+
+static const char *aszMem[N_MEM] = {
+    N_("Evaluation cache"), N_("Neural net weights"), N_("Bearoff databases"),
+    N_("Match and move lists"), N_("Board images")
+};
+
+/* cb more bytes held by ms, or -cb fewer */
+extern void
+MemAccount(memsubsystem ms, gssize cb)
+{
+    memcount *pmc = &amc[ms];
+
+    g_mutex_lock(&mutex);
+    if (cb < 0 && (gsize) - cb > pmc->cbCurrent)
+        pmc->cbCurrent = 0;
+    else
+        pmc->cbCurrent += (gsize) cb;
+    pmc->cbPeak = MAX(pmc->cbPeak, pmc->cbCurrent);
+    g_mutex_unlock(&mutex);
+}
+
+/* ms holds cb bytes, as measured */
+extern void
+MemSet(memsubsystem ms, gsize cb)
+{
+    memcount *pmc = &amc[ms];
+
+    g_mutex_lock(&mutex);
+    pmc->cbCurrent = cb;
+    pmc->cbPeak = MAX(pmc->cbPeak, cb);
+    g_mutex_unlock(&mutex);
+}
+
+extern void *
+MemAlloc(memsubsystem ms, gsize cb)
+{
+    MemAccount(ms, (gssize) cb);
+    return g_malloc(cb);
+}
+
+extern void *
+MemAlloc0(memsubsystem ms, gsize cb)
+{
+    MemAccount(ms, (gssize) cb);
+    return g_malloc0(cb);
+}
+
+/* Free p, of the cb bytes it was allocated with */
+extern void
+MemFree(memsubsystem ms, void *p, gsize cb)
+{
+    if (!p)
+        return;
+
+    MemAccount(ms, -(gssize) cb);
+    g_free(p);
+}
+
+extern const char *
+MemName(memsubsystem ms)
+{
+    return _(aszMem[ms]);
+}
+
+extern void
+MemUsage(memsubsystem ms, gsize * pcbCurrent, gsize * pcbPeak)
+{
+    g_mutex_lock(&mutex);
+    *pcbCurrent = amc[ms].cbCurrent;
+    *pcbPeak = amc[ms].cbPeak;
+    g_mutex_unlock(&mutex);
+}
+
+/* The resident size of the whole process and its peak, as the system
+ * sees it.  FALSE if they can't be found; the current size is 0 if
+ * only the peak can be. */
+extern int
+MemProcess(gsize * pcbResident, gsize * pcbPeak)
+{
+#if defined(__linux__)
+    FILE *pf = fopen("/proc/self/status", "r");
+    char sz[256];
+    unsigned long n;
+    int c = 0;
+
+    *pcbResident = *pcbPeak = 0;
+    if (!pf)
+        return FALSE;
+
+    while (fgets(sz, sizeof(sz), pf)) {
+        if (sscanf(sz, "VmRSS: %lu kB", &n) == 1) {
+            *pcbResident = (gsize) n * 1024;
+            c++;
+        } else if (sscanf(sz, "VmHWM: %lu kB", &n) == 1) {
+            *pcbPeak = (gsize) n * 1024;
+            c++;
+        }
+    }
+
+    fclose(pf);
+    return c == 2;
+#elif defined(HAVE_SYS_RESOURCE_H)
+    struct rusage ru;
+
+    *pcbResident = *pcbPeak = 0;
+    if (getrusage(RUSAGE_SELF, &ru))
+        return FALSE;
+
+#if defined(__APPLE__)
+    *pcbPeak = (gsize) ru.ru_maxrss;    /* bytes */
+#else
+    *pcbPeak = (gsize) ru.ru_maxrss * 1024;     /* kilobytes */
+#endif
+    return TRUE;
+#else
+    *pcbResident = *pcbPeak = 0;
+    return FALSE;
+#endif
+}
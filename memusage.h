@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMUSAGE_H
+#define MEMUSAGE_H
+
+#include <glib.h>
+
+/*
+ * The memory held by the big consumers of gnubg, for "show memory".
+ * Each subsystem counts what it allocates and frees with MemAccount(),
+ * or MemAlloc() and MemFree() where it knows the size of what it
+ * frees; the match tree, which is built and torn down in too many
+ * places for that, is measured with MemSet() when it is shown.
+ */
+
+typedef enum {
+    MEM_CACHE,                  /* evaluation caches */
+    MEM_WEIGHTS,                /* neural net weights, mapped or read in */
+    MEM_BEAROFF,                /* bearoff databases, mapped or read in */
+    MEM_MATCH,                  /* move records and their move lists */
+    MEM_RENDER,                 /* rendered board images */
+    N_MEM
+} memsubsystem;
+
+extern void MemAccount(memsubsystem ms, gssize cb);
+extern void MemSet(memsubsystem ms, gsize cb);
+extern void *MemAlloc(memsubsystem ms, gsize cb);
+extern void *MemAlloc0(memsubsystem ms, gsize cb);
+extern void MemFree(memsubsystem ms, void *p, gsize cb);
+
+extern const char *MemName(memsubsystem ms);
+extern void MemUsage(memsubsystem ms, gsize * pcbCurrent, gsize * pcbPeak);
+extern int MemProcess(gsize * pcbResident, gsize * pcbPeak);
+
+#endif                          /* MEMUSAGE_H */
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The metrics export, see metrics.h */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "backgammon.h"
+#include "eval.h"
+#include "memusage.h"
+#include "metrics.h"
+#include "multithread.h"
+
+/* The upper bounds of the latency buckets, in seconds */
+static const double arLatencyBucket[] = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+#define N_LATENCY_BUCKETS G_N_ELEMENTS(arLatencyBucket)
+
+typedef struct {
+    guint64 acBucket[N_LATENCY_BUCKETS + 1];    /* not cumulative, the last is +Inf */
+    guint64 c;
+    double rSum;                /* seconds */
+} latencyhistogram;
+
+static latencyhistogram alh[NUM_METRICS_REQUESTS];
+
+static const char *aszRequest[NUM_METRICS_REQUESTS] = { "text", "binary", "http" };
+
+static const char *aszMemLabel[N_MEM] = { "cache", "weights", "bearoff", "match", "render" };
+
+/* The classes as labels, which must not be translated */
+static const char *aszClassLabel[N_CLASSES] = {
+    "over", "hypergammon1", "hypergammon2", "hypergammon3", "bearoff2", "bearoff_ts", "bearoff1", "bearoff_os",
+    "race", "crashed", "contact"
+};
+
+/* Record a request answered tLatency microseconds after it came */
+extern void
+MetricsRequest(metricsrequest mr, gint64 tLatency)
+{
+    latencyhistogram *plh = &alh[mr];
+    double r = (double) tLatency / 1e6;
+    unsigned int i;
+
+    for (i = 0; i < N_LATENCY_BUCKETS && r > arLatencyBucket[i]; i++);
+
+    plh->acBucket[i]++;
+    plh->c++;
+    plh->rSum += r;
+}
+
+/* A number the way the format wants it, whatever the locale */
+static void
+MetricsDouble(GString * gs, double r)
+{
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_string_append(gs, g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.9g", r));
+}
+
+static void
+MetricsHeader(GString * gs, const char *szName, const char *szType, const char *szHelp)
+{
+    g_string_append_printf(gs, "# HELP %s %s\n# TYPE %s %s\n", szName, szHelp, szName, szType);
+}
+
+static void
+MetricsLatency(GString * gs)
+{
+    int i;
+    unsigned int j;
+
+    MetricsHeader(gs, "gnubg_external_request_duration_seconds", "histogram",
+                  "Time from a request to external coming in to its answer going out.");
+
+    for (i = 0; i < NUM_METRICS_REQUESTS; i++) {
+        const latencyhistogram *plh = &alh[i];
+        guint64 c = 0;
+
+        for (j = 0; j < N_LATENCY_BUCKETS; j++) {
+            c += plh->acBucket[j];
+            g_string_append_printf(gs, "gnubg_external_request_duration_seconds_bucket{kind=\"%s\",le=\"",
+                                   aszRequest[i]);
+            MetricsDouble(gs, arLatencyBucket[j]);
+            g_string_append_printf(gs, "\"} %" G_GUINT64_FORMAT "\n", c);
+        }
+
+        g_string_append_printf(gs, "gnubg_external_request_duration_seconds_bucket{kind=\"%s\",le=\"+Inf\"} %"
+                               G_GUINT64_FORMAT "\n", aszRequest[i], plh->c);
+        g_string_append_printf(gs, "gnubg_external_request_duration_seconds_sum{kind=\"%s\"} ", aszRequest[i]);
+        MetricsDouble(gs, plh->rSum);
+        g_string_append_printf(gs, "\ngnubg_external_request_duration_seconds_count{kind=\"%s\"} %"
+                               G_GUINT64_FORMAT "\n", aszRequest[i], plh->c);
+    }
+}
+
+/* The lookups and hits by ply and class, kept with "set cachestats on" */
+static void
+MetricsCacheStats(GString * gs)
+{
+    static const char *aszKind[2] = { "cubeless", "cubeful" };
+    static const char *aszName[2] = { "gnubg_cache_ply_lookups_total", "gnubg_cache_ply_hits_total" };
+    evalcachestats ecs;
+    int i, j, k, n;
+
+    EvalCacheStats(&ecs, NULL, NULL);
+
+    for (n = 0; n < 2; n++) {
+        MetricsHeader(gs, aszName[n], "counter",
+                      n ? "Evaluations found in a cache, by kind, ply and position class."
+                      : "Evaluations asked for, by kind, ply and position class (see set cachestats).");
+
+        for (k = 0; k < 2; k++) {
+            unsigned int (*ac)[CACHESTATS_PLIES][N_CLASSES] = k ? ecs.acCubeful : ecs.acCubeless;
+
+            for (i = 0; i < CACHESTATS_PLIES; i++)
+                for (j = 0; j < N_CLASSES; j++)
+                    if (ac[CACHESTATS_LOOKUP][i][j])
+                        g_string_append_printf(gs, "%s{kind=\"%s\",ply=\"%d%s\",class=\"%s\"} %u\n", aszName[n],
+                                               aszKind[k], i, i == CACHESTATS_PLIES - 1 ? "+" : "",
+                                               aszClassLabel[j], n ? ac[CACHESTATS_HIT_THREAD][i][j]
+                                               + ac[CACHESTATS_HIT][i][j] : ac[CACHESTATS_LOOKUP][i][j]);
+        }
+    }
+}
+
+/* The memory held by the subsystems, see "show memory" */
+static void
+MetricsMemory(GString * gs)
+{
+    gsize acbCurrent[N_MEM], acbPeak[N_MEM];
+    int i;
+
+    AccountMatchMemory();
+    for (i = 0; i < N_MEM; i++)
+        MemUsage((memsubsystem) i, &acbCurrent[i], &acbPeak[i]);
+
+    MetricsHeader(gs, "gnubg_memory_bytes", "gauge", "Memory held, by subsystem.");
+    for (i = 0; i < N_MEM; i++)
+        g_string_append_printf(gs, "gnubg_memory_bytes{subsystem=\"%s\"} %" G_GSIZE_FORMAT "\n", aszMemLabel[i],
+                               acbCurrent[i]);
+    MetricsHeader(gs, "gnubg_memory_peak_bytes", "gauge", "Most memory held, by subsystem.");
+    for (i = 0; i < N_MEM; i++)
+        g_string_append_printf(gs, "gnubg_memory_peak_bytes{subsystem=\"%s\"} %" G_GSIZE_FORMAT "\n",
+                               aszMemLabel[i], acbPeak[i]);
+}
+
+/* All the metrics as a Prometheus text exposition, to be freed by the
+ * caller */
+extern GString *
+MetricsText(void)
+{
+    GString *gs = g_string_new(NULL);
+    threadstats ts, tsSum;
+    lockstats als[NUM_MT_LOCKS];
+    unsigned int cThreads = MT_GetNumThreads();
+    int i, j;
+
+    /* the main thread and the calculation threads */
+    memset(&tsSum, 0, sizeof(tsSum));
+    for (i = -1; i < (int) cThreads; i++) {
+        if (MT_GetThreadStats(i, &ts) < 0)
+            continue;
+
+        for (j = 0; j < N_CLASSES; j++)
+            tsSum.acEval[j] += ts.acEval[j];
+        tsSum.cCacheHit += ts.cCacheHit;
+        tsSum.cCacheAdd += ts.cCacheAdd;
+        tsSum.cCacheEvict += ts.cCacheEvict;
+        tsSum.cTrials += ts.cTrials;
+        tsSum.cTasks += ts.cTasks;
+        tsSum.tBusy += ts.tBusy;
+    }
+
+    MetricsHeader(gs, "gnubg_evaluations_total", "counter", "Static evaluations, by position class.");
+    for (j = 0; j < N_CLASSES; j++)
+        g_string_append_printf(gs, "gnubg_evaluations_total{class=\"%s\"} %" G_GUINT64_FORMAT "\n",
+                               aszClassLabel[j], tsSum.acEval[j]);
+
+    MetricsHeader(gs, "gnubg_cache_entries", "gauge", "Size of the evaluation cache.");
+    g_string_append_printf(gs, "gnubg_cache_entries %u\n", GetEvalCacheEntries());
+    MetricsHeader(gs, "gnubg_cache_hits_total", "counter", "Evaluations found in the caches.");
+    g_string_append_printf(gs, "gnubg_cache_hits_total %" G_GUINT64_FORMAT "\n", tsSum.cCacheHit);
+    MetricsHeader(gs, "gnubg_cache_inserts_total", "counter", "Evaluations put in the shared cache.");
+    g_string_append_printf(gs, "gnubg_cache_inserts_total %" G_GUINT64_FORMAT "\n", tsSum.cCacheAdd);
+    MetricsHeader(gs, "gnubg_cache_evictions_total", "counter",
+                  "Evaluations put in the shared cache in place of another position.");
+    g_string_append_printf(gs, "gnubg_cache_evictions_total %" G_GUINT64_FORMAT "\n", tsSum.cCacheEvict);
+
+    if (EvalGetCacheStats())
+        MetricsCacheStats(gs);
+
+    MetricsHeader(gs, "gnubg_rollout_trials_total", "counter", "Rollout trials played.");
+    g_string_append_printf(gs, "gnubg_rollout_trials_total %" G_GUINT64_FORMAT "\n", tsSum.cTrials);
+
+    MetricsHeader(gs, "gnubg_threads", "gauge", "Calculation threads.");
+    g_string_append_printf(gs, "gnubg_threads %u\n", cThreads);
+    MetricsHeader(gs, "gnubg_tasks_queued", "gauge", "Tasks waiting for a thread.");
+    g_string_append_printf(gs, "gnubg_tasks_queued %u\n", MT_GetQueuedTasks());
+    MetricsHeader(gs, "gnubg_tasks_total", "counter", "Tasks run by the calculation threads.");
+    g_string_append_printf(gs, "gnubg_tasks_total %" G_GUINT64_FORMAT "\n", (guint64) tsSum.cTasks);
+    MetricsHeader(gs, "gnubg_thread_busy_seconds_total", "counter", "Time the calculation threads spent on tasks.");
+    g_string_append(gs, "gnubg_thread_busy_seconds_total ");
+    MetricsDouble(gs, (double) tsSum.tBusy / 1e6);
+    g_string_append_c(gs, '\n');
+
+    if (MT_GetLockStats(MT_LOCK_MATCH, &als[0]) == 0) {
+        for (i = 1; i < NUM_MT_LOCKS; i++)
+            MT_GetLockStats((mtlockid) i, &als[i]);
+
+        MetricsHeader(gs, "gnubg_lock_contended_total", "counter",
+                      "Times a thread found a lock held by another, by lock.");
+        for (i = 0; i < NUM_MT_LOCKS; i++)
+            g_string_append_printf(gs, "gnubg_lock_contended_total{lock=\"%s\"} %" G_GUINT64_FORMAT "\n",
+                                   aszLockName[i], als[i].cContended);
+        MetricsHeader(gs, "gnubg_lock_wait_seconds_total", "counter", "Time the threads waited for a lock, by lock.");
+        for (i = 0; i < NUM_MT_LOCKS; i++) {
+            g_string_append_printf(gs, "gnubg_lock_wait_seconds_total{lock=\"%s\"} ", aszLockName[i]);
+            MetricsDouble(gs, (double) als[i].tWait / 1e6);
+            g_string_append_c(gs, '\n');
+        }
+    }
+
+    MetricsLatency(gs);
+    MetricsMemory(gs);
+
+    return gs;
+}
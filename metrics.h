@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <glib.h>
+
+/*
+ * The operational metrics of gnubg, in the Prometheus text exposition
+ * format (which OpenMetrics scrapers read too), for alerting on a
+ * long-running evaluation server: GET /metrics on the HTTP interface of
+ * "external", or "show metrics".
+ *
+ * The counters of the engine are kept by each thread in its
+ * threadstats and only summed when asked for; the latencies of the
+ * requests to "external" are recorded by its loop, on the main thread.
+ */
+
+typedef enum {
+    METRICS_TEXT,               /* command lines */
+    METRICS_BINARY,             /* binary frames */
+    METRICS_HTTP,
+    NUM_METRICS_REQUESTS
+} metricsrequest;
+
+extern void MetricsRequest(metricsrequest mr, gint64 tLatency);
+extern GString *MetricsText(void);
+
+#endif                          /* METRICS_H */
@@ -33,12 +33,25 @@
 
 SSE_ALIGN(ThreadData td);
 
+/* Size of each thread's scratch arena.  Sorting a full list of
+ * incomplete moves takes a bit over half of it. */
+#define SCRATCH_SIZE (1024 * 1024)
+
 extern ThreadLocalData *
 MT_CreateThreadLocalData(int id)
 {
     ThreadLocalData *tld = (ThreadLocalData *) g_malloc(sizeof(ThreadLocalData));
     tld->id = id;
+    tld->iNode = -1;
+    tld->iCpu = -1;
+    tld->fShared = FALSE;
+    tld->rDeadline = 0.0;
+    tld->priority = TASK_INTERACTIVE;
+    tld->pct = NULL;
+    memset(&tld->ts, 0, sizeof(tld->ts));
+    tld->ppt = NULL;
     tld->pnnState = (NNState *) g_malloc(sizeof(NNState) * 3);
+    tld->iWeights = 0;
     memset(tld->pnnState, 0, sizeof(NNState) * 3);
     // cppcheck-suppress duplicateExpression
     tld->pnnState[CLASS_RACE - CLASS_RACE].savedBase = g_malloc(nnRace.cHidden * sizeof(float));
@@ -59,9 +72,180 @@ MT_CreateThreadLocalData(int id)
 
     tld->aMoves = (move *) g_malloc(sizeof(move) * MAX_INCOMPLETE_MOVES);
     memset(tld->aMoves, 0, sizeof(move) * MAX_INCOMPLETE_MOVES);
+
+    tld->pCacheL1 = (evalCacheL1 *) g_malloc(sizeof(evalCacheL1));
+    memset(tld->pCacheL1, 0, sizeof(evalCacheL1));
+
+    tld->pMETTables = g_new0(scoremet, MET_TABLES);
+
+    tld->pMoveHash = (movehash *) g_malloc(sizeof(movehash));
+    memset(tld->pMoveHash, 0, sizeof(movehash));
+
+    tld->pchScratch = (char *) g_malloc(SCRATCH_SIZE + ALIGN_SIZE);
+    tld->cbScratchUsed = 0;
+    tld->plScratchBig = NULL;
+    tld->cScratchBig = 0;
+
     return tld;
 }
 
+extern void
+MT_FreeThreadLocalData(ThreadLocalData * tld)
+{
+    NNState *pnnState = tld->pnnState;
+
+    g_free(tld->aMoves);
+    g_free(tld->pCacheL1);
+    g_free(tld->pMETTables);
+    g_free(tld->pMoveHash);
+    while (tld->plScratchBig) {
+        gpointer p = tld->plScratchBig->data;
+
+        tld->plScratchBig = g_slist_remove(tld->plScratchBig, p);
+        g_free(p);
+    }
+    g_free(tld->pchScratch);
+
+    for (int i = 0; i < 3; i++) {
+        g_free(pnnState[i].savedBase);
+        g_free(pnnState[i].savedIBase);
+    }
+
+    g_free(pnnState);
+    g_free(tld);
+}
+
+/*
+ * Short lived memory for the calling thread, taken from its arena
+ * without locking.  It is aligned for the SIMD code and stays valid
+ * until MT_ScratchRelease() is given a mark taken before it was
+ * allocated, or the thread's task ends.  What does not fit in the
+ * arena comes from the heap and goes back the same way.
+ *
+ *     scratchmark mark = MT_ScratchMark();
+ *     p = MT_ScratchAlloc(cb);
+ *     ...
+ *     MT_ScratchRelease(mark);
+ */
+
+extern void *
+MT_ScratchAlloc(size_t cb)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    size_t iStart = ptld->cbScratchUsed;
+    char *pch;
+
+    /* offsets from an aligned start, so that every block is aligned */
+    pch = ptld->pchScratch + (ALIGN_SIZE - (size_t) ptld->pchScratch % ALIGN_SIZE) % ALIGN_SIZE;
+
+    if (cb <= SCRATCH_SIZE - iStart) {
+        ptld->cbScratchUsed = MIN(iStart + (cb + ALIGN_SIZE - 1) / ALIGN_SIZE * ALIGN_SIZE, SCRATCH_SIZE);
+        return pch + iStart;
+    }
+
+    pch = (char *) g_malloc(cb + ALIGN_SIZE);
+    ptld->plScratchBig = g_slist_prepend(ptld->plScratchBig, pch);
+    ptld->cScratchBig++;
+
+    return pch + (ALIGN_SIZE - (size_t) pch % ALIGN_SIZE) % ALIGN_SIZE;
+}
+
+extern scratchmark
+MT_ScratchMark(void)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    scratchmark mark;
+
+    mark.cbUsed = ptld->cbScratchUsed;
+    mark.cBig = ptld->cScratchBig;
+
+    return mark;
+}
+
+extern void
+MT_ScratchRelease(scratchmark mark)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+
+    ptld->cbScratchUsed = mark.cbUsed;
+
+    while (ptld->cScratchBig > mark.cBig) {
+        gpointer p = ptld->plScratchBig->data;
+
+        ptld->plScratchBig = g_slist_remove(ptld->plScratchBig, p);
+        g_free(p);
+        ptld->cScratchBig--;
+    }
+}
+
+/* Free all of the calling thread's scratch memory.  The threads do
+ * this when each task is done, in case one of them returned without
+ * releasing what it took. */
+extern void
+MT_ScratchReset(void)
+{
+    scratchmark mark = { 0, 0 };
+
+    MT_ScratchRelease(mark);
+}
+
+/*
+ * Make pct the job of the calling thread and return the one it had.
+ * The tasks it queues from then on and the ones they fork are tasks
+ * of that job, so MT_Cancel(pct) stops them and no other.
+ *
+ *     canceltoken ct = { FALSE };
+ *     canceltoken *pctOld = MT_SetJob(&ct);
+ *     ...queue the tasks and wait for them...
+ *     MT_SetJob(pctOld);
+ */
+extern canceltoken *
+MT_SetJob(canceltoken * pct)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    canceltoken *pctOld = ptld->pct;
+
+    ptld->pct = pct;
+
+    return pctOld;
+}
+
+/* Stop the job of pct: the threads drop its queued tasks, and the
+ * running ones see MT_Cancelled() at their next check */
+extern void
+MT_Cancel(canceltoken * pct)
+{
+    MT_SafeSet(&pct->fCancelled, TRUE);
+}
+
+/* Whether the calling thread should give up on its task: the user
+ * interrupted everything, or its job has been cancelled */
+extern int
+MT_Cancelled(void)
+{
+    canceltoken *pct = MT_GetTLD()->pct;
+
+    /* asked in every ply, and nothing else is read by what sets them */
+    return MT_SafeGetRelaxed(&fInterrupt) || (pct && MT_SafeGetRelaxed(&pct->fCancelled));
+}
+
+/* Whether tasks of the job of pct are still queued or running, for
+ * waiting on that job alone while other ones go on */
+extern int
+MT_JobBusy(canceltoken * pct)
+{
+    return MT_SafeGet(&pct->cPending) != 0;
+}
+
+const char *const aszLockName[NUM_MT_LOCKS] = {
+    N_("match"),
+    N_("rollout"),
+    N_("Python jobs"),
+    N_("bearoff files"),
+    N_("profile"),
+    N_("calibration")
+};
+
 #if defined(USE_MULTITHREAD)
 
 #if defined(DEBUG_MULTITHREADED) && defined(WIN32)
@@ -123,9 +307,12 @@ FreeManualEvent(ManualEvent ME)
     g_free(ME);
 }
 
-extern void
-WaitForManualEvent(ManualEvent ME)
+/* Wait until ME is set or msec milliseconds have gone by.  Returns
+ * whether it is set. */
+extern int
+WaitForManualEventTimeout(ManualEvent ME, int msec)
 {
+    int fSignalled;
 #if GLIB_CHECK_VERSION (2,32,0)
     gint64 end_time;
 #else
@@ -134,9 +321,11 @@ WaitForManualEvent(ManualEvent ME)
     multi_debug("wait for manual event asks lock (condMutex)");
 #if GLIB_CHECK_VERSION (2,32,0)
     g_mutex_lock(&condMutex);
-    end_time = g_get_monotonic_time() + 10 * G_TIME_SPAN_SECOND;
+    end_time = g_get_monotonic_time() + (gint64) msec * G_TIME_SPAN_MILLISECOND;
 #else
     g_mutex_lock(condMutex);
+    g_get_current_time(&tv);
+    g_time_val_add(&tv, (glong) msec * 1000);
 #endif
     multi_debug("wait for manual event gets lock (condMutex)");
     while (!ME->signalled) {
@@ -144,15 +333,14 @@ WaitForManualEvent(ManualEvent ME)
 #if GLIB_CHECK_VERSION (2,32,0)
         if (!g_cond_wait_until(&ME->cond, &condMutex, end_time))
 #else
-        g_get_current_time(&tv);
-        g_time_val_add(&tv, 10 * 1000 * 1000);
-        if (g_cond_timed_wait(ME->cond, condMutex, &tv))
+        if (!g_cond_timed_wait(ME->cond, condMutex, &tv))
 #endif
             break;
         else {
             multi_debug("still waiting for manual event");
         }
     }
+    fSignalled = ME->signalled;
 
 #if GLIB_CHECK_VERSION (2,32,0)
     g_mutex_unlock(&condMutex);
@@ -160,6 +348,14 @@ WaitForManualEvent(ManualEvent ME)
     g_mutex_unlock(condMutex);
 #endif
     multi_debug("wait for manual event unlocks (condMutex)");
+
+    return fSignalled;
+}
+
+extern void
+WaitForManualEvent(ManualEvent ME)
+{
+    (void) WaitForManualEventTimeout(ME, 10 * 1000);
 }
 
 extern void
@@ -200,6 +396,28 @@ SetManualEvent(ManualEvent ME)
     multi_debug("set manual event unlocks (condMutex)");
 }
 
+/* Set ME like SetManualEvent(), but only wake up one of the threads
+ * waiting for it; for when there is work for one more thread */
+extern void
+SignalManualEvent(ManualEvent ME)
+{
+    multi_debug("signal manual event asks lock (condMutex)");
+#if GLIB_CHECK_VERSION (2,32,0)
+    g_mutex_lock(&condMutex);
+    multi_debug("signal manual event gets lock (condMutex)");
+    ME->signalled = TRUE;
+    g_cond_signal(&ME->cond);
+    g_mutex_unlock(&condMutex);
+#else
+    g_mutex_lock(condMutex);
+    multi_debug("signal manual event gets lock (condMutex)");
+    ME->signalled = TRUE;
+    g_cond_signal(ME->cond);
+    g_mutex_unlock(condMutex);
+#endif
+    multi_debug("signal manual event unlocks (condMutex)");
+}
+
 #if GLIB_CHECK_VERSION (2,32,0)
 extern void
 InitMutex(Mutex * pMutex)
@@ -251,16 +469,22 @@ Mutex_Release(Mutex * mutex)
 extern void
 MT_InitThreads(void)
 {
+    int i;
+
 #if !GLIB_CHECK_VERSION (2,32,0)
     if (!g_thread_supported())
         g_thread_init(NULL);
     g_assert(g_thread_supported());
 #endif
-    td.tasks = NULL;
+    for (int i = 0; i < NUM_TASKPRIORITIES; i++)
+        g_queue_init(&td.tasks[i]);
     MT_SafeSet(&td.doneTasks, 0);
     td.addedTasks = 0;
     td.totalTasks = -1;
+    td.cRunning = 0;
+    td.fShare = TRUE;
     InitManualEvent(&td.activity);
+    InitManualEvent(&td.allDone);
     TLSCreate(&td.tlsItem);
     TLSSetValue(td.tlsItem, (size_t) MT_CreateThreadLocalData(-1));
 
@@ -269,6 +493,8 @@ MT_InitThreads(void)
 #endif
     InitMutex(&td.multiLock);
     InitMutex(&td.queueLock);
+    for (i = 0; i < NUM_MT_LOCKS; i++)
+        InitMutex(&td.aLock[i]);
     InitManualEvent(&td.syncStart);
     InitManualEvent(&td.syncEnd);
 #if !GLIB_CHECK_VERSION (2,32,0)
@@ -281,53 +507,86 @@ MT_InitThreads(void)
 extern void
 CloseThread(void *UNUSED(unused))
 {
-    ThreadLocalData *pTLD;
-    NNState *pnnState;
-
     g_assert(MT_SafeCompare(&td.closingThreads, TRUE));
 
-    pTLD = (ThreadLocalData *) TLSGet(td.tlsItem);
-    pnnState = pTLD->pnnState;
-
-    g_free(pTLD->aMoves);
-
-    for (int i = 0; i < 3; i++) {
-        g_free(pnnState[i].savedBase);
-        g_free(pnnState[i].savedIBase);
-    }
-
-    g_free(pnnState);
-    g_free(pTLD);
+    MT_FreeThreadLocalData((ThreadLocalData *) TLSGet(td.tlsItem));
 
     MT_SafeInc(&td.result);
 }
 
+/* Give a thread that gnubg did not start, such as one of the Python
+ * interpreter's, the data it needs to evaluate positions itself.  It
+ * is kept until the end, as the thread may come back. */
+extern void
+MT_AttachThread(void)
+{
+    if (!g_private_get(td.tlsItem))
+        TLSSetValue(td.tlsItem, (size_t) MT_CreateThreadLocalData(-1));
+}
+
 extern void
 MT_Close(void)
 {
+    int i;
+
     MT_CloseThreads();
 
     FreeManualEvent(td.activity);
+    FreeManualEvent(td.allDone);
     FreeMutex(&td.multiLock);
     FreeMutex(&td.queueLock);
+    for (i = 0; i < NUM_MT_LOCKS; i++)
+        FreeMutex(&td.aLock[i]);
 
     FreeManualEvent(td.syncStart);
     FreeManualEvent(td.syncEnd);
 }
 
+/* Take lock, counting whether another thread held it and for how long
+ * this one waited */
 extern void
-MT_Exclusive(void)
+MT_Lock(mtlockid lock)
 {
-    multi_debug("exclusive asks lock (multiLock)");
-    Mutex_Lock(&td.multiLock);
-    multi_debug("exclusive gets lock (multiLock)");
+#if GLIB_CHECK_VERSION (2,32,0)
+    GMutex *pm = &td.aLock[lock];
+#else
+    GMutex *pm = td.aLock[lock];
+#endif
+    gint64 t = 0;
+
+    if (!g_mutex_trylock(pm)) {
+        t = g_get_monotonic_time();
+        multi_debug("lock %s contended", aszLockName[lock]);
+        g_mutex_lock(pm);
+        t = g_get_monotonic_time() - t;
+        td.als[lock].cContended++;
+        td.als[lock].tWait += t;
+        /* Helper threads, such as the autosave writer, have no data */
+        if (g_private_get(td.tlsItem))
+            MT_GetTLD()->ts.tExclusive += t;
+    }
+    td.als[lock].cTaken++;
 }
 
 extern void
-MT_Release(void)
+MT_Unlock(mtlockid lock)
 {
-    Mutex_Release(&td.multiLock);
-    multi_debug("release unlocks (multiLock)");
+#if GLIB_CHECK_VERSION (2,32,0)
+    g_mutex_unlock(&td.aLock[lock]);
+#else
+    g_mutex_unlock(td.aLock[lock]);
+#endif
+}
+
+/* Copy the counts of lock to *pls.  Returns -1 without threads. */
+extern int
+MT_GetLockStats(mtlockid lock, lockstats * pls)
+{
+    Mutex_Lock(&td.aLock[lock]);
+    *pls = td.als[lock];
+    Mutex_Release(&td.aLock[lock]);
+
+    return 0;
 }
 
 #if defined(DEBUG_MULTITHREADED)
@@ -392,20 +651,16 @@ MT_InitThreads(void)
 extern void
 MT_Close(void)
 {
-    int i;
-    NNState *pnnState;
-
     if (!td.tld)
         return;
 
-    g_free(td.tld->aMoves);
-    pnnState = td.tld->pnnState;
-    for (i = 0; i < 3; i++) {
-        g_free(pnnState[i].savedBase);
-        g_free(pnnState[i].savedIBase);
-    }
-    g_free(pnnState);
-    g_free(td.tld);
+    MT_FreeThreadLocalData(td.tld);
+}
+
+extern int
+MT_GetLockStats(mtlockid UNUSED(lock), lockstats * UNUSED(pls))
+{
+    return -1;
 }
 
 #endif
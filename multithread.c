@@ -21,6 +21,9 @@
 #if defined(WIN32)
 #include <process.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -35,9 +38,37 @@
 #include "drawboard.h" /*for FormatMove()*/
 #include "lib/simd.h"
 
+/* Take the next task off the queue of the first priority that has
+ * one, or return NULL */
+static Task *
+PopTask(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_TASKPRIORITIES; i++)
+        if (!g_queue_is_empty(&td.tasks[i]))
+            return (Task *) g_queue_pop_head(&td.tasks[i]);
+
+    return NULL;
+}
+
 #if defined(USE_MULTITHREAD)
 
 static GThread* thread[MAX_NUMTHREADS];
+/* kept when a thread stops, for the next one with its id */
+static ThreadLocalData *atld[MAX_NUMTHREADS];
+
+static gboolean
+TasksQueued(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_TASKPRIORITIES; i++)
+        if (!g_queue_is_empty(&td.tasks[i]))
+            return TRUE;
+
+    return FALSE;
+}
 
 extern unsigned int
 MT_GetNumThreads(void)
@@ -45,23 +76,388 @@ MT_GetNumThreads(void)
     return td.numThreads;
 }
 
+#if defined(__linux__) && defined(CPU_SET)
+
+#define MAX_NUMA_NODES 64
+
+/* The CPUs of each NUMA node, read from sysfs the first time; a
+ * system without the nodes there counts as one node */
+static unsigned int cNumaNodes = 0;
+static cpu_set_t acsNumaNode[MAX_NUMA_NODES];
+
+static unsigned int
+NumaNodes(void)
+{
+    while (!cNumaNodes) {
+        char *szPath, *szList, *pch;
+
+        szPath = g_strdup_printf("/sys/devices/system/node/node%u/cpulist", cNumaNodes);
+        if (!g_file_get_contents(szPath, &szList, NULL, NULL)) {
+            g_free(szPath);
+            break;
+        }
+        g_free(szPath);
+
+        /* a list like "0-7,16-23" */
+        CPU_ZERO(&acsNumaNode[cNumaNodes]);
+        for (pch = szList; *pch >= '0' && *pch <= '9';) {
+            unsigned long i = strtoul(pch, &pch, 10), j = i;
+
+            if (*pch == '-')
+                j = strtoul(pch + 1, &pch, 10);
+            for (; i <= j && i < CPU_SETSIZE; i++)
+                CPU_SET(i, &acsNumaNode[cNumaNodes]);
+            if (*pch == ',')
+                pch++;
+        }
+        g_free(szList);
+
+        if (++cNumaNodes == MAX_NUMA_NODES)
+            break;
+    }
+
+    return cNumaNodes ? cNumaNodes : 1;
+}
+
+static void
+NumaPin(ThreadLocalData * pTLD)
+{
+    if (NumaNodes() < 2)
+        return;
+
+    pTLD->iNode = pTLD->id % (int) NumaNodes();
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &acsNumaNode[pTLD->iNode]))
+        pTLD->iNode = -1;
+}
+
+/* The CPUs the quota of gnubg's cgroup is worth, rounded up, or 0
+ * without a quota: cpu.max of cgroup v2, else cpu.cfs_quota_us and
+ * cpu.cfs_period_us of v1 */
+static unsigned int
+CgroupCpus(void)
+{
+    char *sz;
+    long nQuota = -1, nPeriod = 0;
+
+    if (g_file_get_contents("/sys/fs/cgroup/cpu.max", &sz, NULL, NULL)) {
+        /* "max 100000" or "200000 100000" */
+        if (strncmp(sz, "max", 3))
+            (void) sscanf(sz, "%ld %ld", &nQuota, &nPeriod);
+        g_free(sz);
+    } else if (g_file_get_contents("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", &sz, NULL, NULL)) {
+        nQuota = atol(sz);
+        g_free(sz);
+        if (g_file_get_contents("/sys/fs/cgroup/cpu/cpu.cfs_period_us", &sz, NULL, NULL)) {
+            nPeriod = atol(sz);
+            g_free(sz);
+        }
+    }
+
+    if (nQuota <= 0 || nPeriod <= 0)
+        return 0;
+
+    return (unsigned int) ((nQuota + nPeriod - 1) / nPeriod);
+}
+
+static unsigned int
+AvailableCpus(void)
+{
+    cpu_set_t cs;
+    unsigned int c, cQuota = CgroupCpus();
+
+    c = sched_getaffinity(0, sizeof(cs), &cs) ? 1 : (unsigned int) CPU_COUNT(&cs);
+
+    return cQuota && cQuota < c ? cQuota : c;
+}
+
+#define MAX_CPUS 1024
+
+/* The CPUs gnubg may run on, with their package (socket) and core,
+ * read from sysfs the first time; none if the system doesn't say */
+typedef struct {
+    int iCpu;
+    int iPackage;
+    int iCore;
+    int iSibling;               /* SMT thread of the core */
+} cputopology;
+
+static cputopology actCpu[MAX_CPUS];
+static unsigned int cCpus = 0;
+static int fCpusRead = FALSE;
+
+/* the CPUs of actCpu[] the threads are pinned to in turn */
+static unsigned int aiCpuOrder[MAX_CPUS];
+static unsigned int cCpuOrder = 0;
+
+static int aiThreadCpu[MAX_NUMTHREADS];
+
+static int
+CpuTopologyValue(int iCpu, const char *szFile)
+{
+    char *szPath = g_strdup_printf("/sys/devices/system/cpu/cpu%d/topology/%s", iCpu, szFile);
+    char *sz;
+    int n = -1;
+
+    if (g_file_get_contents(szPath, &sz, NULL, NULL)) {
+        n = atoi(sz);
+        g_free(sz);
+    }
+    g_free(szPath);
+
+    return n;
+}
+
+static unsigned int
+CpuTopology(void)
+{
+    cpu_set_t cs;
+    int i;
+
+    if (fCpusRead)
+        return cCpus;
+    fCpusRead = TRUE;
+
+    if (sched_getaffinity(0, sizeof(cs), &cs))
+        return 0;
+
+    for (i = 0; i < CPU_SETSIZE && cCpus < MAX_CPUS; i++) {
+        cputopology *pct = &actCpu[cCpus];
+        unsigned int j;
+
+        if (!CPU_ISSET(i, &cs))
+            continue;
+
+        pct->iCpu = i;
+        pct->iPackage = CpuTopologyValue(i, "physical_package_id");
+        pct->iCore = CpuTopologyValue(i, "core_id");
+        if (pct->iPackage < 0 || pct->iCore < 0) {
+            cCpus = 0;
+            break;
+        }
+
+        /* the SMT threads of a core are numbered in the order of
+         * their CPUs */
+        pct->iSibling = 0;
+        for (j = 0; j < cCpus; j++)
+            if (actCpu[j].iPackage == pct->iPackage && actCpu[j].iCore == pct->iCore)
+                pct->iSibling++;
+        cCpus++;
+    }
+
+    return cCpus;
+}
+
+static int
+CompareCpuCompact(const void *p1, const void *p2)
+{
+    const cputopology *pct1 = &actCpu[*(const unsigned int *) p1];
+    const cputopology *pct2 = &actCpu[*(const unsigned int *) p2];
+
+    if (pct1->iPackage != pct2->iPackage)
+        return pct1->iPackage - pct2->iPackage;
+    if (pct1->iCore != pct2->iCore)
+        return pct1->iCore - pct2->iCore;
+    return pct1->iSibling - pct2->iSibling;
+}
+
+static int
+CompareCpuScatter(const void *p1, const void *p2)
+{
+    const cputopology *pct1 = &actCpu[*(const unsigned int *) p1];
+    const cputopology *pct2 = &actCpu[*(const unsigned int *) p2];
+
+    if (pct1->iSibling != pct2->iSibling)
+        return pct1->iSibling - pct2->iSibling;
+    if (pct1->iCore != pct2->iCore)
+        return pct1->iCore - pct2->iCore;
+    return pct1->iPackage - pct2->iPackage;
+}
+
+/* Put the CPUs in the order affinity pins the threads to them */
+static unsigned int
+CpuOrder(threadaffinity affinity)
+{
+    unsigned int i;
+
+    cCpuOrder = 0;
+    for (i = 0; i < CpuTopology(); i++)
+        if (affinity != AFFINITY_CORES || actCpu[i].iSibling == 0)
+            aiCpuOrder[cCpuOrder++] = i;
+
+    qsort(aiCpuOrder, cCpuOrder, sizeof(aiCpuOrder[0]),
+          affinity == AFFINITY_COMPACT ? CompareCpuCompact : CompareCpuScatter);
+
+    return cCpuOrder;
+}
+
+/* Pin the thread of pTLD to its CPU with td.affinity, else to its NUMA
+ * node with td.fNuma */
+static void
+ThreadPin(ThreadLocalData * pTLD)
+{
+    aiThreadCpu[pTLD->id] = -1;
+
+    if (td.affinity != AFFINITY_NONE && cCpuOrder) {
+        int iCpu = actCpu[aiCpuOrder[(unsigned int) pTLD->id % cCpuOrder]].iCpu;
+        cpu_set_t cs;
+
+        CPU_ZERO(&cs);
+        CPU_SET(iCpu, &cs);
+        if (!sched_setaffinity(0, sizeof(cs), &cs)) {
+            unsigned int i;
+
+            pTLD->iCpu = aiThreadCpu[pTLD->id] = iCpu;
+            /* the cache interleaved over the nodes goes with the CPU */
+            if (td.fNuma)
+                for (i = 0; i < NumaNodes(); i++)
+                    if (CPU_ISSET(iCpu, &acsNumaNode[i]))
+                        pTLD->iNode = (int) i;
+            return;
+        }
+    }
+
+    if (td.fNuma)
+        NumaPin(pTLD);
+}
+
+/* The CPU thread iThread is pinned to, and its package and core, or -1 */
+extern int
+MT_GetThreadCpu(unsigned int iThread, int *piPackage, int *piCore)
+{
+    unsigned int i;
+
+    if (iThread >= td.numThreads || aiThreadCpu[iThread] < 0)
+        return -1;
+
+    for (i = 0; i < cCpus; i++)
+        if (actCpu[i].iCpu == aiThreadCpu[iThread]) {
+            *piPackage = actCpu[i].iPackage;
+            *piCore = actCpu[i].iCore;
+            break;
+        }
+
+    return aiThreadCpu[iThread];
+}
+
+#else
+
+static unsigned int
+NumaNodes(void)
+{
+    return 1;
+}
+
+static unsigned int
+AvailableCpus(void)
+{
+#if GLIB_CHECK_VERSION (2,36,0)
+    return g_get_num_processors();
+#else
+    return 1;
+#endif
+}
+
+static void
+NumaPin(ThreadLocalData * UNUSED(pTLD))
+{
+}
+
+static unsigned int
+CpuOrder(threadaffinity UNUSED(affinity))
+{
+    return 0;
+}
+
+static void
+ThreadPin(ThreadLocalData * UNUSED(pTLD))
+{
+}
+
+extern int
+MT_GetThreadCpu(unsigned int UNUSED(iThread), int *UNUSED(piPackage), int *UNUSED(piCore))
+{
+    return -1;
+}
+
+#endif
+
+const char *const aszAffinity[NUM_AFFINITIES] = { "none", "compact", "scatter", "cores" };
+
 extern void
 MT_CloseThreads(void)
 {
     unsigned int i;
 
     MT_SafeSet(&td.closingThreads, TRUE);
-    mt_add_tasks(td.numThreads, CloseThread, NULL, NULL);
+    mt_add_tasks(td.numThreads, CloseThread, NULL, NULL, TASK_ROLLOUT);
     if (MT_WaitForTasks(NULL, 0, FALSE) != (int) td.numThreads)
         g_print(_("Error closing threads!\n"));
     for (i = 0; i < td.numThreads; i++)
         g_thread_join(thread[i]);
+
+    /* CloseThread() freed the data of the running threads */
+    for (i = 0; i < MAX_NUMTHREADS; i++) {
+        if (i >= td.numThreads && atld[i])
+            MT_FreeThreadLocalData(atld[i]);
+        atld[i] = NULL;
+    }
+}
+
+/* A task of a taskgroup, see MT_ForkTask() */
+typedef struct {
+    taskgroup *ptg;
+    AsyncFun fun;
+    void *data;
+    double rDeadline;           /* the forking thread's */
+} forkedtask;
+
+static void
+ForkedTask(void *p)
+{
+    forkedtask *pft = (forkedtask *) p;
+    ThreadLocalData *ptld = MT_GetTLD();
+    double rDeadline = ptld->rDeadline;
+
+    ptld->rDeadline = pft->rDeadline;
+    pft->fun(pft->data);
+    ptld->rDeadline = rDeadline;
+}
+
+/* A part of MT_RunShared(), handed to another thread */
+typedef struct {
+    AsyncFun fun;
+    void *data;
+} sharedjob;
+
+static void
+SharedTask(void *p)
+{
+    sharedjob *psj = (sharedjob *) p;
+    ThreadLocalData *ptld = MT_GetTLD();
+
+    ptld->fShared = TRUE;
+    psj->fun(psj->data);
+    ptld->fShared = FALSE;
 }
 
 static void
 MT_TaskDone(Task * pt)
 {
-    MT_SafeInc(&td.doneTasks);
+    /* the tasks of a taskgroup are not counted in the tasks
+     * MT_WaitForTasks() waits for */
+    if (pt && pt->fun == ForkedTask) {
+        forkedtask *pft = (forkedtask *) pt->data;
+        taskgroup *ptg = pft->ptg;
+
+        g_free(pft);
+        MT_SafeDec(&ptg->cPending);
+    } else {
+        if (pt && pt->pct)
+            MT_SafeDec(&pt->pct->cPending);
+        if ((!pt || pt->priority != TASK_BACKGROUND)
+            && MT_SafeIncValue(&td.doneTasks) == MT_SafeGet(&td.totalTasks))
+            SetManualEvent(td.allDone);
+    }
 
     if (pt) {
         g_free(pt->pLinkedTask);
@@ -78,12 +474,10 @@ MT_GetTask(void)
     Mutex_Lock(&td.queueLock);
     multi_debug("get task gets lock (queueLock)");
 
-    if (g_list_length(td.tasks) > 0) {
-        task = (Task *) g_list_first(td.tasks)->data;
-        td.tasks = g_list_delete_link(td.tasks, g_list_first(td.tasks));
-        if (g_list_length(td.tasks) == 0) {
+    if ((task = PopTask()) != NULL) {
+        MT_SafeInc(&td.cRunning);
+        if (!TasksQueued())
             ResetManualEvent(td.activity);
-        }
     }
 
     Mutex_Release(&td.queueLock);
@@ -92,13 +486,21 @@ MT_GetTask(void)
     return task;
 }
 
+/* Stop the job of the calling task, or without one all the tasks */
 extern void
 MT_AbortTasks(void)
 {
+    canceltoken *pct = MT_GetTLD()->pct;
     Task *task;
-    /* Remove tasks from list */
-    while ((task = MT_GetTask()) != NULL)
-        MT_TaskDone(task);
+
+    if (pct)
+        MT_Cancel(pct);
+    else
+        /* Remove tasks from list */
+        while ((task = MT_GetTask()) != NULL) {
+            MT_TaskDone(task);
+            MT_SafeDec(&td.cRunning);
+        }
 
     MT_SafeSet(&td.result, -1);
 }
@@ -123,7 +525,11 @@ MT_WorkerThreadFunction(void *tld)
 #endif
     {
         ThreadLocalData *pTLD = (ThreadLocalData *) tld;
+        int iThread = pTLD->id;
         TLSSetValue(td.tlsItem, (size_t) pTLD);
+        ThreadPin(pTLD);
+
+        gint64 t = g_get_monotonic_time();
 
         MT_SafeInc(&td.result);
         MT_TaskDone(NULL);      /* Thread created */
@@ -132,10 +538,22 @@ MT_WorkerThreadFunction(void *tld)
             WaitForManualEvent(td.activity);
             task = MT_GetTask();
             if (task) {
-                task->fun(task->data);
+                gint64 tStart = g_get_monotonic_time();
+
+                pTLD->ts.tIdle += tStart - t;
+                pTLD->priority = task->priority;
+                pTLD->pct = task->pct;
+                if (!task->pct || !MT_SafeGet(&task->pct->fCancelled))
+                    task->fun(task->data);
+                MT_ScratchReset();
                 MT_TaskDone(task);
+                MT_SafeDec(&td.cRunning);
+                t = g_get_monotonic_time();
+                pTLD->ts.tBusy += t - tStart;
+                pTLD->ts.cTasks++;
             }
-        } while (MT_SafeCompare(&td.closingThreads, FALSE));
+            /* StopThreads() lets the ones from cKeepThreads on go */
+        } while (MT_SafeCompare(&td.closingThreads, FALSE) && iThread < MT_SafeGet(&td.cKeepThreads));
 
 #if 0
 #if __GNUC__ && defined(WIN32)
@@ -154,21 +572,29 @@ WaitingForThreads(gpointer UNUSED(unused))
     return FALSE;
 }
 
+/* Start the threads iFirst to iLast - 1, with the thread local data
+ * the ones before them with their ids left if there is */
 static void
-MT_CreateThreads(void)
+StartThreads(unsigned int iFirst, unsigned int iLast)
 {
     unsigned int i;
 #if defined(DEBUG_MULTITHREADED)
     gchar *buf;
 
-    buf = g_strdup_printf("creating %u thread%s", td.numThreads, (td.numThreads > 1 ? "s" : ""));
+    buf = g_strdup_printf("creating %u thread%s", iLast - iFirst, (iLast - iFirst > 1 ? "s" : ""));
     multi_debug(buf);
     g_free(buf);
 #endif
     MT_SafeSet(&td.result, 0);
     MT_SafeSet(&td.closingThreads, FALSE);
-    for (i = 0; i < td.numThreads; i++) {
-        ThreadLocalData *pTLD = MT_CreateThreadLocalData(i);
+    MT_SafeSet(&td.cKeepThreads, (int) iLast);
+    for (i = iFirst; i < iLast; i++) {
+        ThreadLocalData *pTLD;
+
+        if (!atld[i])
+            atld[i] = MT_CreateThreadLocalData(i);
+        pTLD = atld[i];
+        pTLD->iNode = pTLD->iCpu = -1;
 
 #if GLIB_CHECK_VERSION (2,32,0)
         if (!(thread[i] = g_thread_try_new(NULL, MT_WorkerThreadFunction, pTLD, NULL)))
@@ -184,40 +610,192 @@ MT_CreateThreads(void)
         }
 #endif
     }
-    td.addedTasks = td.numThreads;
+    td.addedTasks = iLast - iFirst;
     /* Wait for all the threads to be created (timeout after 1 second) */
-    if (MT_WaitForTasks(WaitingForThreads, 1000, FALSE) != (int) td.numThreads)
+    if (MT_WaitForTasks(WaitingForThreads, 1000, FALSE) != (int) (iLast - iFirst))
         g_print(_("Error creating threads!\n"));
 }
 
+static void
+MT_CreateThreads(void)
+{
+    StartThreads(0, td.numThreads);
+}
+
+/* Stop the threads from iFirst on once they are done with their tasks,
+ * and keep their thread local data */
+static void
+StopThreads(unsigned int iFirst)
+{
+    unsigned int i;
+
+    MT_SafeSet(&td.cKeepThreads, (int) iFirst);
+
+    /* wake the waiting ones to see it; the others go back to waiting */
+    SetManualEvent(td.activity);
+    for (i = iFirst; i < td.numThreads; i++)
+        g_thread_join(thread[i]);
+
+    Mutex_Lock(&td.queueLock);
+    if (!TasksQueued())
+        ResetManualEvent(td.activity);
+    Mutex_Release(&td.queueLock);
+}
+
+/* Threads for all the CPUs gnubg may run on, no more than the CPU
+ * quota of its container or cgroup allows */
+extern unsigned int
+MT_AutoNumThreads(void)
+{
+    unsigned int c = AvailableCpus();
+
+    return CLAMP(c, 1, MAX_NUMTHREADS);
+}
+
+extern int
+MT_GetAutoThreads(void)
+{
+    return td.fAutoThreads;
+}
+
+/* Copy the statistics of calculation thread iThread, or with -1 of the
+ * calling thread, to *pts.  They are read while the thread may be
+ * counting, so they can be a little behind.  Returns -1 if there is
+ * no such thread. */
+extern int
+MT_GetThreadStats(int iThread, threadstats * pts)
+{
+    if (iThread >= (int) td.numThreads || (iThread >= 0 && !atld[iThread]))
+        return -1;
+
+    *pts = iThread < 0 ? MT_GetTLD()->ts : atld[iThread]->ts;
+
+    return 0;
+}
+
+extern void
+MT_SetAutoThreads(int f)
+{
+    td.fAutoThreads = f;
+    if (f)
+        MT_SetNumThreads(MT_AutoNumThreads());
+}
+
+/* Grow or shrink the pool to num threads.  The running threads carry
+ * on, and a thread stopped and started again gets back its thread
+ * local data; only the threads added or taken away start or stop. */
 void
 MT_SetNumThreads(unsigned int num)
 {
     if (num != td.numThreads) {
-        if (td.numThreads != 0)
-            MT_CloseThreads();
+        if (num > td.numThreads)
+            StartThreads(td.numThreads, num);
+        else
+            StopThreads(num);
         td.numThreads = num;
-        MT_CreateThreads();
         if (num == 1) {         /* No locking in evals */
             EvaluatePosition = EvaluatePositionNoLocking;
             GeneralCubeDecisionE = GeneralCubeDecisionENoLocking;
+            GeneralCubeDecisionScores = GeneralCubeDecisionScoresNoLocking;
+    GeneralCubeDecisionEPlies = GeneralCubeDecisionEPliesNoLocking;
+            GeneralCubeDecisionEPlies = GeneralCubeDecisionEPliesNoLocking;
             GeneralEvaluationE = GeneralEvaluationENoLocking;
             ScoreMove = ScoreMoveNoLocking;
             FindBestMove = FindBestMoveNoLocking;
             FindnSaveBestMoves = FindnSaveBestMovesNoLocking;
+            FindnSaveBestMovesStaged = FindnSaveBestMovesStagedNoLocking;
+            PrefetchMoves = PrefetchMovesNoLocking;
             BasicCubefulRollout = BasicCubefulRolloutNoLocking;
         } else {                /* Locking version of evals */
             EvaluatePosition = EvaluatePositionWithLocking;
             GeneralCubeDecisionE = GeneralCubeDecisionEWithLocking;
+            GeneralCubeDecisionScores = GeneralCubeDecisionScoresWithLocking;
+    GeneralCubeDecisionEPlies = GeneralCubeDecisionEPliesWithLocking;
+            GeneralCubeDecisionEPlies = GeneralCubeDecisionEPliesWithLocking;
             GeneralEvaluationE = GeneralEvaluationEWithLocking;
             ScoreMove = ScoreMoveWithLocking;
             FindBestMove = FindBestMoveWithLocking;
             FindnSaveBestMoves = FindnSaveBestMovesWithLocking;
+            FindnSaveBestMovesStaged = FindnSaveBestMovesStagedWithLocking;
+            PrefetchMoves = PrefetchMovesWithLocking;
             BasicCubefulRollout = BasicCubefulRolloutWithLocking;
         }
     }
 }
 
+extern int
+MT_GetShare(void)
+{
+    return td.fShare;
+}
+
+extern void
+MT_SetShare(int f)
+{
+    td.fShare = f;
+}
+
+extern int
+MT_GetNuma(void)
+{
+    return td.fNuma;
+}
+
+/* Pin the calculation threads round robin to the NUMA nodes, and
+ * interleave the evaluation cache over them, or stop if !f.  Running
+ * threads are restarted to move them.  Returns the number of nodes,
+ * or -1 if there is only one or the system can't. */
+extern int
+MT_SetNuma(int f)
+{
+    unsigned int const cNodes = NumaNodes();
+
+    if (f && (cNodes < 2 || EvalCacheInterleave(cNodes)))
+        return -1;
+
+    if (!f)
+        EvalCacheInterleave(0);
+
+    if (f != td.fNuma) {
+        td.fNuma = f;
+        if (td.numThreads) {
+            MT_CloseThreads();
+            MT_CreateThreads();
+        }
+    }
+
+    return (int) cNodes;
+}
+
+extern threadaffinity
+MT_GetAffinity(void)
+{
+    return td.affinity;
+}
+
+/* Pin the calculation threads to CPUs as affinity says, or let them
+ * run anywhere with AFFINITY_NONE.  Running threads are restarted to
+ * move them.  Returns the number of CPUs they go on, or -1 if the
+ * system doesn't tell its topology or can't pin them. */
+extern int
+MT_SetAffinity(threadaffinity affinity)
+{
+    int c = 0;
+
+    if (affinity != AFFINITY_NONE && (c = (int) CpuOrder(affinity)) == 0)
+        return -1;
+
+    if (affinity != td.affinity) {
+        td.affinity = affinity;
+        if (td.numThreads) {
+            MT_CloseThreads();
+            MT_CreateThreads();
+        }
+    }
+
+    return c;
+}
+
 extern void
 MT_StartThreads(void)
 {
@@ -240,13 +818,19 @@ MT_AddTask(Task * pt, gboolean lock)
         Mutex_Lock(&td.queueLock);
         multi_debug("add task gets lock (queueLock)");
     }
-    if (td.addedTasks == 0)
-        MT_SafeSet(&td.result, 0);          /* Reset result for new tasks */
-    td.addedTasks++;
-    td.tasks = g_list_append(td.tasks, pt);
-    if (g_list_length(td.tasks) == 1) { /* New tasks */
-        SetManualEvent(td.activity);
+    /* background tasks run when the threads have nothing else to do,
+     * and MT_WaitForTasks() does not wait for them nor gets their
+     * result */
+    if (pt->priority != TASK_BACKGROUND) {
+        if (td.addedTasks == 0)
+            MT_SafeSet(&td.result, 0);      /* Reset result for new tasks */
+        td.addedTasks++;
     }
+    if (pt->pct)
+        MT_SafeInc(&pt->pct->cPending);
+    g_queue_push_tail(&td.tasks[pt->priority], pt);
+    /* wake up a thread for it, if one is waiting */
+    SignalManualEvent(td.activity);
     if (lock) {
         Mutex_Release(&td.queueLock);
         multi_debug("add task unlocks");
@@ -254,7 +838,7 @@ MT_AddTask(Task * pt, gboolean lock)
 }
 
 extern void
-mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked)
+mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked, taskpriority priority)
 {
     unsigned int i;
     {
@@ -271,31 +855,133 @@ mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer lin
         pt->fun = pFun;
         pt->data = taskData;
         pt->pLinkedTask = linked;
+        pt->priority = priority;
+        pt->pct = MT_GetTLD()->pct;
         MT_AddTask(pt, FALSE);
     }
     Mutex_Release(&td.queueLock);
     multi_debug("add tasks unlocks (queueLock)");
 }
 
+/* Start pFun(data) as a task of ptg, ahead of the tasks waiting for a
+ * thread at the priority of the caller's task: the caller may be one
+ * of those, holding up its thread already.  Set ptg->cPending to 0
+ * before the first one. */
+extern void
+MT_ForkTask(taskgroup * ptg, AsyncFun pFun, void *data)
+{
+    Task *pt = (Task *) g_malloc(sizeof(Task));
+    forkedtask *pft = (forkedtask *) g_malloc(sizeof(forkedtask));
+
+    pft->ptg = ptg;
+    pft->fun = pFun;
+    pft->data = data;
+    pft->rDeadline = MT_GetTLD()->rDeadline;
+    pt->fun = ForkedTask;
+    pt->data = pft;
+    pt->pLinkedTask = NULL;
+    pt->priority = MT_GetTLD()->priority;
+    pt->pct = MT_GetTLD()->pct;
+    MT_SafeInc(&ptg->cPending);
+
+    Mutex_Lock(&td.queueLock);
+    g_queue_push_head(&td.tasks[pt->priority], pt);
+    SignalManualEvent(td.activity);
+    Mutex_Release(&td.queueLock);
+}
+
+/* Take a task of ptg that no thread has started off the queue, or
+ * return NULL */
+static Task *
+TakeForkedTask(const taskgroup * ptg)
+{
+    Task *pt = NULL;
+    GList *pl;
+    int i;
+
+    Mutex_Lock(&td.queueLock);
+    for (i = 0; i < NUM_TASKPRIORITIES && !pt; i++)
+        for (pl = td.tasks[i].head; pl; pl = pl->next) {
+            Task *ptQueued = (Task *) pl->data;
+
+            if (ptQueued->fun == ForkedTask && ((forkedtask *) ptQueued->data)->ptg == ptg) {
+                pt = ptQueued;
+                g_queue_delete_link(&td.tasks[i], pl);
+                break;
+            }
+        }
+    if (!TasksQueued())
+        ResetManualEvent(td.activity);
+    Mutex_Release(&td.queueLock);
+
+    return pt;
+}
+
+/* Wait for the tasks of ptg, playing the ones no thread has started
+ * here in the meantime.  So it makes no difference whether the other
+ * threads are busy, and a task can wait for the tasks it started.
+ * The tasks MT_AbortTasks() takes off the queue are not played. */
+extern void
+MT_JoinTasks(taskgroup * ptg)
+{
+    while (!MT_SafeCompare(&ptg->cPending, 0)) {
+        Task *pt = TakeForkedTask(ptg);
+
+        if (pt) {
+            pt->fun(pt->data);
+            MT_TaskDone(pt);
+        } else
+            g_usleep(100);
+    }
+}
+
+/* Call pFun(data) on this thread and on up to cHelpers other
+ * calculation threads at once, if they are idle, and return when all
+ * the calls are done.  pFun has to share out the work between the
+ * calls itself.  This can be called from within a task; none of the
+ * calls share their work any further. */
+extern void
+MT_RunShared(AsyncFun pFun, void *data, unsigned int cHelpers)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    sharedjob sj;
+    taskgroup tg;
+    Task *pt;
+    unsigned int i;
+
+    if (ptld->fShared || !td.fShare || td.numThreads < 2 || !cHelpers) {
+        pFun(data);
+        return;
+    }
+
+    sj.fun = pFun;
+    sj.data = data;
+    tg.cPending = 0;
+    for (i = 0; i < MIN(cHelpers, td.numThreads - 1); i++)
+        MT_ForkTask(&tg, SharedTask, &sj);
+
+    ptld->fShared = TRUE;
+    pFun(data);
+    ptld->fShared = FALSE;
+
+    /* take back the helpers no thread has started, the work is done */
+    while ((pt = TakeForkedTask(&tg)) != NULL)
+        MT_TaskDone(pt);
+
+    MT_JoinTasks(&tg);
+}
+
+/* Wait up to time milliseconds for the tasks; returns as soon as the
+ * last one is done, from MT_TaskDone() setting td.allDone */
 static gboolean
 WaitForAllTasks(int time)
 {
-    int j = 0;
+    if (MT_SafeCompare(&td.doneTasks, td.totalTasks))
+        return TRUE;
 
-    while (!MT_SafeCompare(&td.doneTasks, td.totalTasks)) {
-        
-        // if (pmrCurAnn != NULL) {
-        //     g_message("in the loop: pmrCurAnn exists");
-        // }
-        // SetAnnotation(pmrCurAnn);
-        // ChangeGame(NULL);
-        if (j == 10)
-            return FALSE;       /* Not done yet */
+    (void) WaitForManualEventTimeout(td.allDone, time);
 
-        j++;
-        g_usleep(100 * time);
-    }
-    return TRUE;
+    return MT_SafeCompare(&td.doneTasks, td.totalTasks);
 }
 
 int
@@ -317,7 +1003,8 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     int i=0;
 
     /* Set total tasks to wait for */
-    td.totalTasks = td.addedTasks;
+    ResetManualEvent(td.allDone);
+    MT_SafeSet(&td.totalTasks, td.addedTasks);
 #if defined(USE_GTK)
         // g_message("MT_WaitForTasks\n");
     GTKSuspendInput();
@@ -426,7 +1113,10 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     }
     if (autosave) {
         g_source_remove(as_source);
+        /* The final state, after any earlier save still being written */
+        FinishAutosave();
         save_autosave(NULL);
+        FinishAutosave();
     }
     multi_debug("done waiting for all tasks");
 
@@ -452,6 +1142,42 @@ MT_GetDoneTasks(void)
     return MT_SafeGet(&td.doneTasks);
 }
 
+/* The tasks waiting in the queue for a thread */
+extern unsigned int
+MT_GetQueuedTasks(void)
+{
+    unsigned int c = 0;
+    int i;
+
+    Mutex_Lock(&td.queueLock);
+    for (i = 0; i < NUM_TASKPRIORITIES; i++)
+        c += g_queue_get_length(&td.tasks[i]);
+    Mutex_Release(&td.queueLock);
+
+    return c;
+}
+
+/* Wait up to msec milliseconds for the threads to have no task queued
+ * or running, for changes to what they evaluate with.  Returns whether
+ * they got there; the caller must not add tasks meanwhile. */
+extern int
+MT_WaitIdle(int msec)
+{
+    gint64 tEnd = g_get_monotonic_time() + (gint64) msec * 1000;
+    int fIdle;
+
+    while (TRUE) {
+        Mutex_Lock(&td.queueLock);
+        fIdle = !TasksQueued() && MT_SafeGet(&td.cRunning) == 0;
+        Mutex_Release(&td.queueLock);
+
+        if (fIdle || g_get_monotonic_time() >= tEnd)
+            return fIdle;
+
+        g_usleep(10000);
+    }
+}
+
 /* Code below used in calibrate to try and get a resonable figure for multiple threads */
 
 static double start;            /* used for timekeeping */
@@ -512,11 +1238,13 @@ MT_AddTask(Task * pt, gboolean lock)
 {
     (void) lock;                /* silence compiler warning */
     td.result = 0;              /* Reset result for new tasks */
-    td.tasks = g_list_append(td.tasks, pt);
+    if (pt->pct)
+        MT_SafeInc(&pt->pct->cPending);
+    g_queue_push_tail(&td.tasks[pt->priority], pt);
 }
 
 void
-mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked)
+mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked, taskpriority priority)
 {
     unsigned int i;
     for (i = 0; i < num_tasks; i++) {
@@ -524,6 +1252,8 @@ mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer lin
         pt->fun = pFun;
         pt->data = taskData;
         pt->pLinkedTask = linked;
+        pt->priority = priority;
+        pt->pct = MT_GetTLD()->pct;
         MT_AddTask(pt, FALSE);
     }
 }
@@ -534,10 +1264,46 @@ MT_GetDoneTasks(void)
     return MT_SafeGet(&td.doneTasks);
 }
 
+extern unsigned int
+MT_GetQueuedTasks(void)
+{
+    unsigned int c = 0;
+    int i;
+
+    for (i = 0; i < NUM_TASKPRIORITIES; i++)
+        c += g_queue_get_length(&td.tasks[i]);
+
+    return c;
+}
+
+/* The tasks only run in MT_WaitForTasks(), on this thread */
+extern int
+MT_WaitIdle(int UNUSED(msec))
+{
+    return TRUE;
+}
+
+extern void
+MT_ForkTask(taskgroup * UNUSED(ptg), AsyncFun pFun, void *data)
+{
+    pFun(data);
+}
+
+extern void
+MT_JoinTasks(taskgroup * UNUSED(ptg))
+{
+}
+
+void
+MT_RunShared(AsyncFun pFun, void *data, unsigned int UNUSED(cHelpers))
+{
+    pFun(data);
+}
+
 int
 MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
 {
-    GList *member;
+    Task *task;
     guint as_source = 0, cb_source = 0;
 
     (void) callbackTime;        /* silence compiler warning */
@@ -555,21 +1321,31 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     cb_source = g_timeout_add(1000, pCallback, NULL);
     if (autosave)
         as_source = g_timeout_add(nAutoSaveTime * 60000, save_autosave, NULL);
-    for (member = g_list_first(td.tasks); member; member = member->next, MT_SafeInc(&td.doneTasks)) {
-        Task *task = member->data;
-        task->fun(task->data);
+    while ((task = PopTask()) != NULL) {
+        canceltoken *pctOld = MT_SetJob(task->pct);
+        gint64 t = g_get_monotonic_time();
+
+        if (!task->pct || !task->pct->fCancelled)
+            task->fun(task->data);
+        MT_SetJob(pctOld);
+        if (task->pct)
+            MT_SafeDec(&task->pct->cPending);
+        td.tld->ts.tBusy += g_get_monotonic_time() - t;
+        td.tld->ts.cTasks++;
         g_free(task->pLinkedTask);
         g_free(task);
+        MT_SafeInc(&td.doneTasks);
         ProcessEvents();
     }
-    g_list_free(td.tasks);
     if (autosave) {
         g_source_remove(as_source);
+        /* The final state, after any earlier save still being written */
+        FinishAutosave();
         save_autosave(NULL);
+        FinishAutosave();
     }
 
     g_source_remove(cb_source);
-    td.tasks = NULL;
 
 #if defined(USE_GTK)
     GTKResumeInput();
@@ -577,9 +1353,24 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     return td.result;
 }
 
+/* Only the one thread of this build */
+extern int
+MT_GetThreadStats(int iThread, threadstats * pts)
+{
+    if (iThread >= 0)
+        return -1;
+
+    *pts = td.tld->ts;
+
+    return 0;
+}
+
 extern void
 MT_AbortTasks(void)
 {
+    if (td.tld->pct)
+        MT_Cancel(td.tld->pct);
+
     td.result = -1;
 }
 
@@ -36,19 +36,41 @@
 #endif
 
 #include "backgammon.h"
+#include "matchequity.h"
+#include "profile.h"
 
 /* #define DEBUG_MULTITHREADED 1 */
 
 #if defined (USE_MULTITHREAD) && defined(DEBUG_MULTITHREADED)
 void multi_debug(const char *str, ...);
 #else
-#define multi_debug(x)
+#define multi_debug(...)
 #endif
 
+/* The threads take the queued tasks of the first priority before any
+ * of the next one, so that a hint does not wait for an analysis or a
+ * rollout to get through the tasks queued ahead of it. */
+typedef enum {
+    TASK_INTERACTIVE,           /* hints and evaluations the user waits for */
+    TASK_ANALYSIS,
+    TASK_ROLLOUT,
+    TASK_BACKGROUND,            /* not waited for, see MT_AddTask() */
+    NUM_TASKPRIORITIES
+} taskpriority;
+
+/* A rollout, an analysis or any other job whose tasks can be stopped
+ * on their own, see MT_Cancel() */
+typedef struct {
+    int fCancelled;
+    int cPending;               /* its tasks queued or running */
+} canceltoken;
+
 typedef struct Task {
     AsyncFun fun;
     void *data;
     struct Task *pLinkedTask;
+    taskpriority priority;
+    canceltoken *pct;           /* the job it is a task of, or NULL */
 } Task;
 
 typedef struct {
@@ -56,15 +78,51 @@ typedef struct {
     moverecord *pmr;
     listOLD *plGame;
     statcontext *psc;
+    const analysiscontext *pac;
     matchstate ms;
 } AnalyseMoveTask;
 
+/* What a thread has done since its data was made, see MT_GetThreadStats() */
+typedef struct {
+    guint64 acEval[N_CLASSES];  /* static evaluations of each class */
+    guint64 cCacheHit;          /* evaluations found in the caches */
+    guint64 cCacheAdd;          /* evaluations put in the shared cache */
+    guint64 cCacheEvict;        /* of which replaced another position */
+    guint64 cTrials;            /* rollout trials */
+    unsigned int cTasks;
+    gint64 tBusy;               /* microseconds running tasks */
+    gint64 tIdle;               /* waiting for tasks */
+    gint64 tExclusive;          /* waiting for the locks of MT_Lock() */
+} threadstats;
+
 typedef struct {
     int id;
     move *aMoves;
+    movehash *pMoveHash;
     NNState *pnnState;
+    unsigned int iWeights;      /* weight set of its evaluations, see EvalUseWeights() */
+    evalCacheL1 *pCacheL1;
+    scoremet *pMETTables;       /* MET_TABLES of them, see METTable() */
+    int iNode;                  /* NUMA node the thread is pinned to, or -1 */
+    int iCpu;                   /* CPU the thread is pinned to, or -1 */
+    int fShared;                /* running a part of MT_RunShared() */
+    double rDeadline;           /* get_time() when evaluations give up, or 0 */
+    taskpriority priority;      /* of the task the thread is running */
+    canceltoken *pct;           /* the job of that task, see MT_SetJob() */
+    char *pchScratch;           /* MT_ScratchAlloc() arena */
+    size_t cbScratchUsed;
+    GSList *plScratchBig;       /* blocks that did not fit in the arena */
+    guint cScratchBig;
+    threadstats ts;
+    profilethread *ppt;         /* see ProfileAdd() */
 } ThreadLocalData;
 
+/* how much of the scratch arena was in use, see MT_ScratchMark() */
+typedef struct {
+    size_t cbUsed;
+    guint cBig;
+} scratchmark;
+
 typedef struct {
 #if GLIB_CHECK_VERSION (2,32,0)
     GCond cond;
@@ -82,38 +140,99 @@ typedef GMutex Mutex;
 typedef GMutex *Mutex;
 #endif
 
+/* The locks of MT_Lock(), one for each kind of data the threads
+ * share, so that threads busy with unrelated things never wait for
+ * each other */
+typedef enum {
+    MT_LOCK_MATCH,              /* the move records of the match and their analysis statistics */
+    MT_LOCK_ROLLOUT,            /* the results, log and checkpoints of the rollout */
+    MT_LOCK_PYTHONJOB,          /* the results of the jobs of the Python module */
+    MT_LOCK_BEAROFF,            /* bearoff files read without pread() */
+    MT_LOCK_PROFILE,            /* the threads of the profile */
+    MT_LOCK_CALIBRATE,          /* the random positions of the calibration */
+    NUM_MT_LOCKS
+} mtlockid;
+
+/* How much a lock of MT_Lock() was waited for, see MT_GetLockStats() */
 typedef struct {
-    GList *tasks;
+    guint64 cTaken;
+    guint64 cContended;         /* held by another thread when asked for */
+    gint64 tWait;               /* microseconds waited for it */
+} lockstats;
+
+/* where MT_SetAffinity() pins the calculation threads */
+typedef enum {
+    AFFINITY_NONE,              /* anywhere */
+    AFFINITY_COMPACT,           /* the SMT threads of a core, then the next core */
+    AFFINITY_SCATTER,           /* a core of each package in turn */
+    AFFINITY_CORES,             /* as scatter, but one thread per core */
+    NUM_AFFINITIES
+} threadaffinity;
+
+typedef struct {
+    GQueue tasks[NUM_TASKPRIORITIES];   /* first in, first out within each */
     int doneTasks;
     int result;
     ThreadLocalData *tld;
 
 #if defined(USE_MULTITHREAD)
     ManualEvent activity;
+    ManualEvent allDone;        /* doneTasks has got to totalTasks */
     TLSItem tlsItem;
     Mutex queueLock;
-    Mutex multiLock;
+    Mutex multiLock;            /* serialises the multi_debug() output */
+    Mutex aLock[NUM_MT_LOCKS];
+    lockstats als[NUM_MT_LOCKS];        /* updated with the lock held */
     ManualEvent syncStart;
     ManualEvent syncEnd;
 
     int addedTasks;
     int totalTasks;
+    int cRunning;               /* tasks taken off the queue and not done yet */
 
     int closingThreads;
     unsigned int numThreads;
+    int fNuma;                  /* pin the threads to NUMA nodes, see MT_SetNuma() */
+    threadaffinity affinity;    /* pin them to CPUs, see MT_SetAffinity() */
+    int fShare;                 /* let MT_RunShared() use the other threads */
+    int fAutoThreads;           /* numThreads from MT_AutoNumThreads() */
+    int cKeepThreads;           /* the threads from this id on stop */
 #endif
 } ThreadData;
 
+/* tasks started with MT_ForkTask(), that MT_JoinTasks() waits for */
+typedef struct {
+    int cPending;               /* tasks not done yet */
+} taskgroup;
+
 extern int MT_GetDoneTasks(void);
+extern unsigned int MT_GetQueuedTasks(void);
+extern int MT_WaitIdle(int msec);
 extern void MT_AbortTasks(void);
 extern void MT_AddTask(Task * pt, gboolean lock);
-extern void mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked);
+extern void mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked,
+                         taskpriority priority);
 extern int MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave);
+extern void MT_ForkTask(taskgroup * ptg, AsyncFun pFun, void *data);
+extern void MT_JoinTasks(taskgroup * ptg);
+extern void MT_RunShared(AsyncFun pFun, void *data, unsigned int cHelpers);
 extern void MT_InitThreads(void);
 extern void MT_Close(void);
 extern void MT_CloseThreads(void);
 extern void CloseThread(void *unused);
 extern ThreadLocalData *MT_CreateThreadLocalData(int id);
+extern void MT_FreeThreadLocalData(ThreadLocalData * tld);
+extern void *MT_ScratchAlloc(size_t cb);
+extern scratchmark MT_ScratchMark(void);
+extern void MT_ScratchRelease(scratchmark mark);
+extern void MT_ScratchReset(void);
+extern int MT_GetThreadStats(int iThread, threadstats * pts);
+extern const char *const aszLockName[NUM_MT_LOCKS];
+extern int MT_GetLockStats(mtlockid lock, lockstats * pls);
+extern canceltoken *MT_SetJob(canceltoken * pct);
+extern void MT_Cancel(canceltoken * pct);
+extern int MT_Cancelled(void);
+extern int MT_JobBusy(canceltoken * pct);
 
 extern ThreadData td;
 
@@ -123,7 +242,9 @@ extern void ResetManualEvent(ManualEvent ME);
 extern void Mutex_Lock(Mutex *mutex);
 extern void Mutex_Release(Mutex *mutex);
 extern void WaitForManualEvent(ManualEvent ME);
+extern int WaitForManualEventTimeout(ManualEvent ME, int msec);
 extern void SetManualEvent(ManualEvent ME);
+extern void SignalManualEvent(ManualEvent ME);
 extern void TLSSetValue(TLSItem pItem, size_t value);
 extern void InitManualEvent(ManualEvent * pME);
 extern void FreeManualEvent(ManualEvent ME);
@@ -136,22 +257,52 @@ extern void FreeMutex(Mutex * mutex);
 #define MAX_NUMTHREADS 48
 #endif
 
-extern void MT_Release(void);
-extern void MT_Exclusive(void);
+extern void MT_Lock(mtlockid lock);
+extern void MT_Unlock(mtlockid lock);
 extern void MT_StartThreads(void);
+extern void MT_AttachThread(void);
 extern void MT_SetNumThreads(unsigned int num);
+extern unsigned int MT_AutoNumThreads(void);
+extern int MT_GetAutoThreads(void);
+extern void MT_SetAutoThreads(int f);
 extern void MT_SyncInit(void);
 extern void MT_SyncStart(void);
 extern double MT_SyncEnd(void);
 extern void MT_SetResultFailed(void);
 extern void TLSCreate(TLSItem * pItem);
 extern unsigned int MT_GetNumThreads(void);
+extern int MT_GetNuma(void);
+extern int MT_SetNuma(int f);
+extern const char *const aszAffinity[NUM_AFFINITIES];
+extern threadaffinity MT_GetAffinity(void);
+extern int MT_SetAffinity(threadaffinity affinity);
+extern int MT_GetThreadCpu(unsigned int iThread, int *piPackage, int *piCore);
+extern int MT_GetShare(void);
+extern void MT_SetShare(int f);
 
 #define MT_GetTLD() ((ThreadLocalData *)TLSGet(td.tlsItem))
 #define MT_GetThreadID() ((ThreadLocalData *)TLSGet(td.tlsItem))->id
 #define MT_Get_nnState() ((ThreadLocalData *)TLSGet(td.tlsItem))->pnnState
 #define MT_Get_aMoves() ((ThreadLocalData *)TLSGet(td.tlsItem))->aMoves
 
+#if defined(__ATOMIC_ACQUIRE)
+/*
+ * The GLib ones are full barriers.  The counters only need their own
+ * updates ordered with what they hand out or count, and flags such as
+ * fInterrupt that are polled over and over only need to be seen
+ * eventually, which is much cheaper on ARM and POWER.
+ */
+#define MT_SafeIncValue(x) __atomic_add_fetch(x, 1, __ATOMIC_ACQ_REL)
+#define MT_SafeIncCheck(x) __atomic_fetch_add(x, 1, __ATOMIC_ACQ_REL)
+#define MT_SafeInc(x) ((void) __atomic_add_fetch(x, 1, __ATOMIC_ACQ_REL))
+#define MT_SafeAdd(x, y) ((void) __atomic_add_fetch(x, y, __ATOMIC_ACQ_REL))
+#define MT_SafeDec(x) ((void) __atomic_sub_fetch(x, 1, __ATOMIC_ACQ_REL))
+#define MT_SafeDecCheck(x) (__atomic_sub_fetch(x, 1, __ATOMIC_ACQ_REL) == 0)
+#define MT_SafeGet(x) __atomic_load_n(x, __ATOMIC_ACQUIRE)
+#define MT_SafeGetRelaxed(x) __atomic_load_n(x, __ATOMIC_RELAXED)
+#define MT_SafeSet(x, y) __atomic_store_n(x, y, __ATOMIC_RELEASE)
+#define MT_SafeCompare(x, y) (__atomic_load_n(x, __ATOMIC_ACQUIRE) == (y))
+#else
 #if GLIB_CHECK_VERSION (2,30,0)
 #define MT_SafeIncValue(x) (g_atomic_int_add(x, 1) + 1)
 #define MT_SafeIncCheck(x) (g_atomic_int_add(x, 1))
@@ -168,17 +319,23 @@ extern unsigned int MT_GetNumThreads(void);
 #define MT_SafeDec(x) g_atomic_int_add(x, -1)
 #define MT_SafeDecCheck(x) g_atomic_int_dec_and_test(x)
 #define MT_SafeGet(x) g_atomic_int_get(x)
+#define MT_SafeGetRelaxed(x) g_atomic_int_get(x)
 #define MT_SafeSet(x, y) g_atomic_int_set(x, y)
 #define MT_SafeCompare(x, y) g_atomic_int_compare_and_exchange(x, y, y)
+#endif
 
 #else                           /*USE_MULTITHREAD */
 #if !defined(MAX_NUMTHREADS)
 #define MAX_NUMTHREADS 1
 #endif
 extern int asyncRet;
-#define MT_Exclusive() {}
-#define MT_Release() {}
+#define MT_Lock(lock) {}
+#define MT_Unlock(lock) {}
 #define MT_GetNumThreads() 1
+#define MT_GetNuma() 0
+#define MT_SetNuma(f) (-1)
+#define MT_GetShare() 0
+#define MT_SetShare(f)
 #define MT_SetResultFailed() asyncRet = -1
 #define MT_SafeInc(x) (++(*x))
 #define MT_SafeIncValue(x) (++(*x))
@@ -187,6 +344,7 @@ extern int asyncRet;
 #define MT_SafeDec(x) (--(*x))
 #define MT_SafeDecCheck(x) ((--(*x)) == 0)
 #define MT_SafeGet(x) (*x)
+#define MT_SafeGetRelaxed(x) (*x)
 #define MT_SafeSet(x, y) ((*x) = y)
 #define MT_SafeCompare(x, y) ((*x) == y)
 #define MT_GetThreadID() 0
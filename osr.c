@@ -26,20 +26,28 @@
 #include "config.h"
 
 #include <glib.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "eval.h"
 #include "positionid.h"
 #include "SFMT.h"
+#include "multithread.h"
 #include "osr.h"
 
 #define MAX_PROBS        32
 #define MAX_GAMMON_PROBS 15
 
-static sfmt_t sfmt;
+/* games are simulated in batches of OSR_BATCH, each with its own
+ * random number generator, so that the result does not depend on how
+ * many threads play them; a multiple of 1296 keeps the quasi random
+ * dice of the first two turns evenly spread over each batch */
+
+#define OSR_BATCH        1296
 
 static void
-OSRQuasiRandomDice(const unsigned int iTurn, const unsigned int iGame, const unsigned int cGames, unsigned int anDice[2])
+OSRQuasiRandomDice(sfmt_t * psfmt, const unsigned int iTurn, const unsigned int iGame, const unsigned int cGames,
+                   unsigned int anDice[2])
 {
     if (!iTurn && !(cGames % 36)) {
         anDice[0] = (iGame % 6) + 1;
@@ -48,8 +56,8 @@ OSRQuasiRandomDice(const unsigned int iTurn, const unsigned int iGame, const uns
         anDice[0] = ((iGame / 36) % 6) + 1;
         anDice[1] = ((iGame / 216) % 6) + 1;
     } else {
-        anDice[0] = (unsigned int) (sfmt_genrand_uint32(&sfmt) % 6) + 1;
-        anDice[1] = (unsigned int) (sfmt_genrand_uint32(&sfmt) % 6) + 1;
+        anDice[0] = (unsigned int) (sfmt_genrand_uint32(psfmt) % 6) + 1;
+        anDice[1] = (unsigned int) (sfmt_genrand_uint32(psfmt) % 6) + 1;
     }
 }
 
@@ -544,6 +552,7 @@ FindBestMoveOSR(unsigned int anBoard[25], const unsigned int anDice[2], unsigned
  * osr: one sided rollout.
  *
  * Input:
+ *   psfmt: random number generator
  *   anBoard: the board (reversed compared to normal convention)
  *   iGame: game#
  *   nGames: # of games.
@@ -554,7 +563,7 @@ FindBestMoveOSR(unsigned int anBoard[25], const unsigned int anDice[2], unsigned
  */
 
 static unsigned int
-osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGames, unsigned int nOut)
+osr(sfmt_t * psfmt, unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGames, unsigned int nOut)
 {
     unsigned int iTurn = 0;
     unsigned int anDice[2];
@@ -563,7 +572,7 @@ osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGame
 
     while (nOut) {
         /* roll dice */
-        OSRQuasiRandomDice(iTurn, iGame, nGames, anDice);
+        OSRQuasiRandomDice(psfmt, iTurn, iGame, nGames, anDice);
 
         if (anDice[0] < anDice[1])
             swap_us(anDice, anDice + 1);
@@ -579,46 +588,70 @@ osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGame
 
 
 /*
- * RollOSR: perform onesided rollout
- *
- * Input:
- *   nGames: number of simulations
- *   anBoard: the board 
- *   nOut: number of chequers outside home quadrant
- *
- * Output:
- *   arProbs[ nMaxProbs ]: probabilities
- *   arGammonProbs[ nMaxGammonProbs ]: gammon probabilities
- *
+ * A batch of one sided rollouts.  The games are played first and only
+ * the bearoff id and number of rolls of where each ended are kept;
+ * these are then sorted, so that the one sided database is read once
+ * for every distinct position the batch ends in rather than once for
+ * every game.  The probabilities are summed as integers to be exact
+ * whatever the order the batches are added in.
  */
 
-static void
-rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigned int nOut,
-        float arProbs[], const unsigned int nMaxProbs, float arGammonProbs[], const unsigned int nMaxGammonProbs)
+typedef struct {
+    unsigned int iPos;
+    unsigned int n;
+} osrgame;
+
+typedef struct {
+    const unsigned int *anBoard;
+    unsigned int nOut;
+    unsigned int nGames;
+    unsigned int cBatches;
+    unsigned int fSide;
+    int iNext;
+    /* results, summed over the batches */
+    guint64 aulProbs[MAX_PROBS];
+    unsigned int anCounts[MAX_GAMMON_PROBS];
+#if defined(USE_MULTITHREAD)
+    GMutex *pmutex;
+#endif
+} osrbatches;
+
+static int
+CompareOSRGames(const void *p0, const void *p1)
 {
+    const osrgame *pg0 = (const osrgame *) p0;
+    const osrgame *pg1 = (const osrgame *) p1;
+
+    return (pg0->iPos > pg1->iPos) - (pg0->iPos < pg1->iPos);
+}
 
+static void
+RollOSRBatch(osrbatches * pob, const unsigned int iBatch, guint64 aulProbs[MAX_PROBS],
+             unsigned int anCounts[MAX_GAMMON_PROBS])
+{
+    osrgame ag[OSR_BATCH];
     unsigned int an[25];
     unsigned short int anProb[32];
-    unsigned int i;
-    unsigned int iGame;
-
-    int *anCounts = (int *) g_alloca(nMaxGammonProbs * sizeof(int));
+    sfmt_t sfmt;
+    uint32_t anKey[2];
+    unsigned int i, iGame, cGames;
 
-    memset(anCounts, 0, sizeof(int) * nMaxGammonProbs);
+    /* seeded by side and batch so that OSR are reproducible */
 
-    for (i = 0; i < nMaxProbs; ++i)
-        arProbs[i] = 0.0f;
+    anKey[0] = iBatch;
+    anKey[1] = pob->fSide;
+    sfmt_init_by_array(&sfmt, anKey, 2);
 
-    /* perform rollouts */
+    cGames = MIN(OSR_BATCH, pob->nGames - iBatch * OSR_BATCH);
 
-    for (iGame = 0; iGame < nGames; ++iGame) {
-        unsigned int n, m;
+    for (iGame = 0; iGame < cGames; ++iGame) {
+        unsigned int m;
 
-        memcpy(an, anBoard, sizeof(an));
+        memcpy(an, pob->anBoard, sizeof(an));
 
         /* do actual rollout */
 
-        n = osr(an, iGame, nGames, nOut);
+        ag[iGame].n = osr(&sfmt, an, iBatch * OSR_BATCH + iGame, pob->nGames, pob->nOut);
 
         /* number of chequers in home quadrant */
 
@@ -628,29 +661,156 @@ rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigne
 
         /* update counts */
 
-        ++anCounts[MIN(m == 15 ? n + 1 : n, nMaxGammonProbs - 1)];
+        ++anCounts[MIN(m == 15 ? ag[iGame].n + 1 : ag[iGame].n, MAX_GAMMON_PROBS - 1)];
 
-        /* get prob. from bearoff1 */
+        ag[iGame].iPos = PositionBearoff(an, pbc1->nPoints, pbc1->nChequers);
 
-        getBearoffProbs(PositionBearoff(an, pbc1->nPoints, pbc1->nChequers), anProb);
+    }
+
+    /* get prob. from bearoff1 */
+
+    qsort(ag, cGames, sizeof(osrgame), CompareOSRGames);
+
+    for (iGame = 0; iGame < cGames; ++iGame) {
+
+        if (!iGame || ag[iGame].iPos != ag[iGame - 1].iPos)
+            getBearoffProbs(ag[iGame].iPos, anProb);
 
         for (i = 0; i < 32; ++i)
-            arProbs[MIN(n + i, nMaxProbs - 1)] += anProb[i] / 65535.0f;
+            aulProbs[MIN(ag[iGame].n + i, MAX_PROBS - 1)] += anProb[i];
 
     }
 
+}
+
+static void
+RollOSRBatches(osrbatches * pob)
+{
+    guint64 aulProbs[MAX_PROBS];
+    unsigned int anCounts[MAX_GAMMON_PROBS];
+    int iBatch;
+    unsigned int i;
+
+    memset(aulProbs, 0, sizeof(aulProbs));
+    memset(anCounts, 0, sizeof(anCounts));
+
+    while ((iBatch = MT_SafeIncCheck(&pob->iNext)) < (int) pob->cBatches)
+        RollOSRBatch(pob, (unsigned int) iBatch, aulProbs, anCounts);
+
+#if defined(USE_MULTITHREAD)
+    g_mutex_lock(pob->pmutex);
+#endif
+
+    for (i = 0; i < MAX_PROBS; ++i)
+        pob->aulProbs[i] += aulProbs[i];
+    for (i = 0; i < MAX_GAMMON_PROBS; ++i)
+        pob->anCounts[i] += anCounts[i];
+
+#if defined(USE_MULTITHREAD)
+    g_mutex_unlock(pob->pmutex);
+#endif
+}
+
+#if defined(USE_MULTITHREAD)
+static gpointer
+RollOSRThread(gpointer p)
+{
+    RollOSRBatches((osrbatches *) p);
+
+    return NULL;
+}
+#endif
+
+/*
+ * RollOSR: perform onesided rollout
+ *
+ * Input:
+ *   nGames: number of simulations
+ *   anBoard: the board 
+ *   nOut: number of chequers outside home quadrant
+ *   fSide: the side, to seed the dice with
+ *   cThreads: number of threads to play the batches with
+ *
+ * Output:
+ *   arProbs[ MAX_PROBS ]: probabilities
+ *   arGammonProbs[ MAX_GAMMON_PROBS ]: gammon probabilities
+ *
+ */
+
+static void
+rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigned int nOut,
+        const unsigned int fSide, const unsigned int cThreads,
+        float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
+{
+
+    osrbatches ob;
+    unsigned int i;
+#if defined(USE_MULTITHREAD)
+    GThread *athread[MAX_NUMTHREADS];
+    unsigned int k, cExtra;
+#if GLIB_CHECK_VERSION (2,32,0)
+    GMutex mutex;
+#endif
+#endif
+
+    memset(&ob, 0, sizeof(ob));
+
+#if defined(USE_MULTITHREAD)
+#if GLIB_CHECK_VERSION (2,32,0)
+    g_mutex_init(&mutex);
+    ob.pmutex = &mutex;
+#else
+    ob.pmutex = g_mutex_new();
+#endif
+#else
+    (void) cThreads;
+#endif
+
+    ob.anBoard = anBoard;
+    ob.nOut = nOut;
+    ob.nGames = nGames;
+    ob.cBatches = (nGames + OSR_BATCH - 1) / OSR_BATCH;
+    ob.fSide = fSide;
+
+    /* perform rollouts; the calling thread plays too */
+
+#if defined(USE_MULTITHREAD)
+    cExtra = MIN(MIN(cThreads, MAX_NUMTHREADS), ob.cBatches);
+    cExtra = cExtra ? cExtra - 1 : 0;
+
+    for (k = 0; k < cExtra; ++k)
+#if GLIB_CHECK_VERSION (2,32,0)
+        athread[k] = g_thread_new(NULL, RollOSRThread, &ob);
+#else
+        athread[k] = g_thread_create(RollOSRThread, &ob, TRUE, NULL);
+#endif
+#endif
+
+    RollOSRBatches(&ob);
+
+#if defined(USE_MULTITHREAD)
+    for (k = 0; k < cExtra; ++k)
+        g_thread_join(athread[k]);
+
+#if GLIB_CHECK_VERSION (2,32,0)
+    g_mutex_clear(&mutex);
+#else
+    g_mutex_free(ob.pmutex);
+#endif
+#endif
+
     /* scale resulting probabilities */
 
-    for (i = 0; i < (unsigned int) nMaxProbs; ++i) {
-        arProbs[i] /= (float)nGames;
+    for (i = 0; i < MAX_PROBS; ++i) {
+        arProbs[i] = (float) ((double) ob.aulProbs[i] / (65535.0 * nGames));
         /* printf ( "arProbs[%d]=%f\n", i, arProbs[ i ] ); */
     }
 
     /* calculate gammon probs. 
      * (prob. of getting inside home quadrant in i rolls */
 
-    for (i = 0; i < nMaxGammonProbs; ++i) {
-        arGammonProbs[i] = (float)anCounts[i] / (float)nGames;
+    for (i = 0; i < MAX_GAMMON_PROBS; ++i) {
+        arGammonProbs[i] = (float)ob.anCounts[i] / (float)nGames;
         /* printf ( "arGammonProbs[%d]=%f\n", i, arGammonProbs[ i ] ); */
     }
 
@@ -664,6 +824,8 @@ rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigne
  * Input:
  *   anBoard: one side of the board
  *   nGames: number of simulations
+ *   fSide: the side, to seed the dice with
+ *   cThreads: number of threads to simulate with
  *   
  * Output:
  *   an: ???
@@ -674,7 +836,7 @@ rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigne
  */
 
 static unsigned int
-osp(const unsigned int anBoard[25], const unsigned int nGames,
+osp(const unsigned int anBoard[25], const unsigned int nGames, const unsigned int fSide, const unsigned int cThreads,
     unsigned int an[25], float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
 {
 
@@ -698,7 +860,7 @@ osp(const unsigned int anBoard[25], const unsigned int nGames,
 
     if (nOut > 0)
         /* chequers outside home: do one sided rollout */
-        rollOSR(nGames, an, nOut, arProbs, MAX_PROBS, arGammonProbs, MAX_GAMMON_PROBS);
+        rollOSR(nGames, an, nOut, fSide, cThreads, arProbs, arGammonProbs);
     else {
         /* chequers inside home: use BEAROFF2 */
 
@@ -798,6 +960,7 @@ bgProb(const unsigned int anBoard[25],
  *   anBoard: the current board 
  *            (assumed to be a race position without contact)
  *   nGames:  the number of simulations to perform
+ *   cThreads: the number of threads to perform them with
  *
  * Output:
  *   arOutput: probabilities.
@@ -805,7 +968,8 @@ bgProb(const unsigned int anBoard[25],
  */
 
 extern void
-raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_OUTPUTS], float arMu[2])
+raceProbs(const TanBoard anBoard, const unsigned int nGames, const unsigned int cThreads, float arOutput[NUM_OUTPUTS],
+          float arMu[2])
 {
 
     TanBoard an;
@@ -819,15 +983,11 @@ raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_
 
     float w, s;
 
-    /* Seed set to ensure that OSR are reproducible */
-
-    sfmt_init_gen_rand(&sfmt, 0);
-
     for (i = 0; i < NUM_OUTPUTS; ++i)
         arOutput[i] = 0.0f;
 
     for (i = 0; i < 2; ++i)
-        anTotal[i] = osp(anBoard[i], nGames, an[i], aarProbs[i], aarGammonProbs[i]);
+        anTotal[i] = osp(anBoard[i], nGames, i, cThreads, an[i], aarProbs[i], aarGammonProbs[i]);
 
     /* calculate OUTPUT_WIN */
 
@@ -21,7 +21,8 @@
 #define OSR_H
 
 extern void
- raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_OUTPUTS], float arMu[2]);
+ raceProbs(const TanBoard anBoard, const unsigned int nGames, const unsigned int cThreads, float arOutput[NUM_OUTPUTS],
+           float arMu[2]);
 
 
 #endif                          /* OSR_H */
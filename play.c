@@ -51,6 +51,7 @@ today to correct the title manually.
 #include "sound.h"
 #include "renderprefs.h"
 #include "md5.h"
+#include "memusage.h"
 #include "lib/simd.h"
 
 #if defined (USE_GTK)
@@ -144,10 +145,45 @@ GetDice(unsigned int anDice[2], int fTurn, rng * prng, rngcontext * rngctx, TanB
     }
 }
 
+/* Move records come from chunks of MOVE_RECORD_CHUNK, on a free list
+ * when not in use; when the last one in use goes, as it does when a
+ * match is dropped, the chunks are all freed at once.  Loading and
+ * freeing a match is then an allocation per chunk rather than per
+ * record. */
+#define MOVE_RECORD_CHUNK 256
+
+typedef union _moverecordslot {
+    moverecord mr;
+    union _moverecordslot *pmrsNext;
+} moverecordslot;
+
+static GSList *plRecordChunks;
+static moverecordslot *pmrsFree;
+static unsigned int cRecordsInUse;
+static GMutex mutexRecords;
+
 extern moverecord *
 NewMoveRecord(void)
 {
-    moverecord *pmr = g_new0(moverecord, 1);
+    moverecord *pmr;
+
+    g_mutex_lock(&mutexRecords);
+    if (!pmrsFree) {
+        moverecordslot *pmrs = g_new(moverecordslot, MOVE_RECORD_CHUNK);
+        int i;
+
+        for (i = 0; i < MOVE_RECORD_CHUNK - 1; i++)
+            pmrs[i].pmrsNext = &pmrs[i + 1];
+        pmrs[MOVE_RECORD_CHUNK - 1].pmrsNext = NULL;
+        pmrsFree = pmrs;
+        plRecordChunks = g_slist_prepend(plRecordChunks, pmrs);
+    }
+    pmr = &pmrsFree->mr;
+    pmrsFree = pmrsFree->pmrsNext;
+    cRecordsInUse++;
+    g_mutex_unlock(&mutexRecords);
+
+    memset(pmr, 0, sizeof(moverecord));
 
     pmr->mt = (movetype) - 1;
     pmr->sz = NULL;
@@ -436,6 +472,26 @@ CalculateBoard(void)
     } while (pl != plLastMove);
 }
 
+/* Give back the record itself, not what it points to */
+extern void
+ReleaseMoveRecord(moverecord * pmr)
+{
+    moverecordslot *pmrs = (moverecordslot *) pmr;
+
+    if (!pmr)
+        return;
+
+    g_mutex_lock(&mutexRecords);
+    pmrs->pmrsNext = pmrsFree;
+    pmrsFree = pmrs;
+    if (!--cRecordsInUse) {
+        g_slist_free_full(plRecordChunks, g_free);
+        plRecordChunks = NULL;
+        pmrsFree = NULL;
+    }
+    g_mutex_unlock(&mutexRecords);
+}
+
 static void
 FreeMoveRecord(moverecord * pmr)
 {
@@ -458,7 +514,7 @@ FreeMoveRecord(moverecord * pmr)
 
     g_free(pmr->MoneyCubeDecPtr);
 
-    g_free(pmr);
+    ReleaseMoveRecord(pmr);
 }
 
 static void
@@ -1264,7 +1320,6 @@ ComputerTurn(void)
              * so only evaluate at 0 plies. */
 
             if (ClassifyPosition(msBoard(), ms.bgv) <= CLASS_RACE) {
-                float arResign[NUM_ROLLOUT_OUTPUTS];
                 int nResign;
 
                 evalcontext ecResign = { FALSE, 0, FALSE, TRUE, 0.0 };
@@ -1273,7 +1328,7 @@ ComputerTurn(void)
                 esResign.et = EVAL_EVAL;
                 esResign.ec = ecResign;
 
-                nResign = getResignation(arResign, anBoardMove, &ci, &esResign);
+                nResign = getResignation(NULL, anBoardMove, &ci, &esResign);
 
                 if (nResign > 0 && nResign > ms.fResignationDeclined) {
                     char ach[2];
@@ -1422,7 +1477,7 @@ ComputerTurn(void)
             fd.pec = &ap[ms.fTurn].esChequer.ec;
             fd.aamf = ap[ms.fTurn].aamf;
             if ((RunAsyncProcess((AsyncFun) asyncFindMove, &fd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
-                g_free(pmr);
+                ReleaseMoveRecord(pmr);
                 return -1;
             }
 
@@ -1702,12 +1757,137 @@ TryBearoff(void)
     return -1;
 }
 
+#if defined(USE_MULTITHREAD)
+/* Evaluations of the position the human player has to play, run on
+ * the idle threads while they think about it so that the hints and the
+ * analysis of the game find them in the evaluation cache, see "set
+ * threads speculate" */
+
+int fSpeculate = FALSE;
+
+typedef struct {
+    Task task;
+    TanBoard anBoard;
+    cubeinfo ci;
+    unsigned int anDice[2];     /* 0 for the cube decision */
+    evalsetup es;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+} SpeculationTask;
+
+/* the job of the running speculation, and the one before it whose
+ * cancelled tasks may not be done yet */
+static canceltoken actSpeculation[2];
+static int iSpeculation;
+
+static void
+SpeculateMT(SpeculationTask * pst)
+{
+    if (!pst->anDice[0]) {
+        float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+
+        (void) GeneralCubeDecisionE(aarOutput, (ConstTanBoard) pst->anBoard, &pst->ci, &pst->es.ec, &pst->es);
+    } else {
+        movelist ml;
+
+        if (FindnSaveBestMoves(&ml, (int) pst->anDice[0], (int) pst->anDice[1], (ConstTanBoard) pst->anBoard,
+                               NULL, arSkillLevel[SKILL_DOUBTFUL], &pst->ci, &pst->es.ec, pst->aamf) == 0
+            && ml.cMoves)
+            g_free(ml.amMoves);
+    }
+}
+
+static void
+AddSpeculation(const cubeinfo * pci, unsigned int n0, unsigned int n1, const evalsetup * pes,
+               ConstTmoveFilter aamf)
+{
+    SpeculationTask *pst;
+
+    /* rollouts take too long to be thrown away */
+    if (pes->et != EVAL_EVAL)
+        return;
+
+    pst = (SpeculationTask *) g_malloc(sizeof(SpeculationTask));
+    pst->task.fun = (AsyncFun) SpeculateMT;
+    pst->task.data = pst;
+    pst->task.pLinkedTask = NULL;
+    pst->task.priority = TASK_BACKGROUND;
+    pst->task.pct = &actSpeculation[iSpeculation];
+    memcpy(pst->anBoard, msBoard(), sizeof(TanBoard));
+    pst->ci = *pci;
+    pst->anDice[0] = n0;
+    pst->anDice[1] = n1;
+    pst->es = *pes;
+    memcpy(pst->aamf, aamf, sizeof(pst->aamf));
+
+    MT_AddTask(&pst->task, TRUE);
+}
+
+/* Stop evaluating the position the human player had */
+extern void
+StopSpeculation(void)
+{
+    MT_Cancel(&actSpeculation[iSpeculation]);
+}
+
+/* Start evaluating the position the human player has: the cube
+ * decision and all the rolls before they roll, the moves of their roll
+ * after it; with the settings of the hints first and those of the
+ * analysis if they differ */
+static void
+Speculate(void)
+{
+    const evalsetup *apesCube[2] = { GetEvalCube(), &esAnalysisCube };
+    const evalsetup *apesChequer[2] = { GetEvalChequer(), &esAnalysisChequer };
+    ConstTmoveFilter aaamf[2] = { (ConstTmoveFilter) *GetEvalMoveFilter(), (ConstTmoveFilter) aamfAnalysis };
+    int cSetups = fEvalSameAsAnalysis ? 1 : 2;
+    cubeinfo ci;
+    int i, n0, n1;
+
+    StopSpeculation();
+
+    if (!fSpeculate || ms.gs != GAME_PLAYING || ap[ms.fTurn].pt != PLAYER_HUMAN || ms.fDoubled || ms.fResigned)
+        return;
+
+    /* the job before the last one still has a task running: it will
+     * do for now */
+    if (MT_JobBusy(&actSpeculation[!iSpeculation]))
+        return;
+
+    iSpeculation = !iSpeculation;
+    actSpeculation[iSpeculation].fCancelled = FALSE;
+
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    for (i = 0; i < cSetups; i++) {
+        if (i && !cmp_evalsetup(apesCube[0], apesCube[1]) && !cmp_evalsetup(apesChequer[0], apesChequer[1])
+            && !memcmp(aaamf[0], aaamf[1], sizeof(aamfAnalysis)))
+            break;
+
+        if (ms.anDice[0]) {
+            AddSpeculation(&ci, ms.anDice[0], ms.anDice[1], apesChequer[i], aaamf[i]);
+            continue;
+        }
+
+        if (ms.fCubeUse && GetDPEq(NULL, NULL, &ci))
+            AddSpeculation(&ci, 0, 0, apesCube[i], aaamf[i]);
+
+        for (n0 = 6; n0 >= 1; n0--)
+            for (n1 = n0; n1 >= 1; n1--)
+                AddSpeculation(&ci, (unsigned int) n0, (unsigned int) n1, apesChequer[i], aaamf[i]);
+    }
+}
+#endif
+
 extern int
 NextTurn(int fPlayNext)
 {
 
     g_assert(!fComputing);
 
+#if defined(USE_MULTITHREAD)
+    StopSpeculation();
+#endif
+
 #if defined (USE_GTK)
     if (fX) {
         if (nNextTurn) {
@@ -1878,6 +2058,10 @@ NextTurn(int fPlayNext)
              (ms.fCubeOwner >= 0 && ms.fCubeOwner != ms.fTurn) ||
              (ms.nMatchTo > 0 && ms.anScore[ms.fTurn] + ms.nCube >= ms.nMatchTo)))
             CommandRoll(NULL);
+#if defined(USE_MULTITHREAD)
+        else
+            Speculate();
+#endif
 
         fComputing = FALSE;
         return -1;
@@ -2418,7 +2602,7 @@ CommandDouble(char *UNUSED(sz))
     pmr->mt = MOVE_DOUBLE;
     pmr->fPlayer = ms.fTurn;
     if (fTutor && fTutorCube && !GiveAdvice(tutor_double(TRUE))) {
-        g_free(pmr);
+        ReleaseMoveRecord(pmr);
         return;
     }
 
@@ -2479,12 +2663,12 @@ CommandDrop(char *UNUSED(sz))
     pmr->mt = MOVE_DROP;
     pmr->fPlayer = ms.fTurn;
     if (!LinkToDouble(pmr)) {
-        g_free(pmr);
+        ReleaseMoveRecord(pmr);
         return;
     }
 
     if (fTutor && fTutorCube && !GiveAdvice(tutor_take(FALSE))) {
-        g_free(pmr);            /* garbage collect */
+        ReleaseMoveRecord(pmr);            /* garbage collect */
         return;
     }
 
@@ -2722,14 +2906,14 @@ CommandMove(char *sz)
 
         if (!pmr_cur) {
             g_assert_not_reached();
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
             return;
         }
         /* update or set the move */
         memcpy(pmr_cur->n.anMove, an, sizeof an);
         hint_move("", FALSE, NULL);
         if (!GiveAdvice(pmr_cur->n.stMove)) {
-            g_free(pmr);
+            ReleaseMoveRecord(pmr);
             return;
         }
     }
@@ -2836,6 +3020,34 @@ FreeMatch(void)
     IniStatcontext(&scMatch);
 }
 
+/* Measure the move records of the match and their move lists and
+ * comments for MEM_MATCH, which is not counted as they come and go */
+extern void
+AccountMatchMemory(void)
+{
+    listOLD *pl, *plGame, *plm;
+    gsize cb = 0;
+
+    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+        plGame = pl->p;
+        cb += sizeof(listOLD);
+
+        for (plm = plGame->plNext; plm != plGame; plm = plm->plNext) {
+            const moverecord *pmr = plm->p;
+
+            cb += sizeof(listOLD) + sizeof(moverecord);
+            if (pmr->mt == MOVE_NORMAL && pmr->ml.amMoves)
+                cb += pmr->ml.cMoves * sizeof(move);
+            if (pmr->sz)
+                cb += strlen(pmr->sz) + 1;
+            if (pmr->MoneyCubeDecPtr)
+                cb += sizeof(cubedecisiondata);
+        }
+    }
+
+    MemSet(MEM_MATCH, cb);
+}
+
 extern void
 SetMatchDate(matchinfo * pmi)
 {
@@ -4014,6 +4226,10 @@ CommandRoll(char *UNUSED(sz))
 
     DiceRolled();
 
+#if defined(USE_MULTITHREAD)
+    Speculate();
+#endif
+
 #if defined (USE_GTK)
     if (fX) {
 
@@ -4089,14 +4305,14 @@ CommandTake(char *UNUSED(sz))
     pmr->mt = MOVE_TAKE;
     pmr->fPlayer = ms.fTurn;
     if (!LinkToDouble(pmr)) {
-        g_free(pmr);
+        ReleaseMoveRecord(pmr);
         return;
     }
 
     pmr->stCube = SKILL_NONE;
 
     if (fTutor && fTutorCube && !GiveAdvice(tutor_take(TRUE))) {
-        g_free(pmr);            /* garbage collect */
+        ReleaseMoveRecord(pmr);            /* garbage collect */
         return;
     }
 
@@ -125,6 +125,21 @@ PositionFromKeySwapped(TanBoard anBoard, const positionkey * pkey)
     anBoard[0][24] = (anpBoard[6] >> 4) & 0x0f;
 }
 
+/* The key of the position with the sides swapped, straight from the
+ * key: the two halves trade places, and so do the two bars */
+
+extern void
+PositionKeySwapped(positionkey * pkeySwapped, const positionkey * pkey)
+{
+    unsigned int i;
+
+    for (i = 0; i < 3; i++) {
+        pkeySwapped->data[i] = pkey->data[i + 3];
+        pkeySwapped->data[i + 3] = pkey->data[i];
+    }
+    pkeySwapped->data[6] = ((pkey->data[6] & 0x0f) << 4) | ((pkey->data[6] >> 4) & 0x0f);
+}
+
 static inline void
 addBits(unsigned char auchKey[10], unsigned int bitPos, unsigned int nBits)
 {
@@ -195,13 +210,14 @@ oldPositionFromKey(TanBoard anBoard, const oldpositionkey * pkey)
 }
 
 
+static const char aszBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
 static char *
 oldPositionIDFromKey(const oldpositionkey * pkey)
 {
     unsigned char const *puch = pkey->auch;
     static char szID[L_POSITIONID + 1];
     char *pch = szID;
-    static const char aszBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
     int i;
 
     for (i = 0; i < 3; i++) {
@@ -395,6 +411,159 @@ PositionFromID(TanBoard anBoard, const char *pchEnc)
     return CheckPosition((ConstTanBoard) anBoard);
 }
 
+/* The bulk conversions below go straight between IDs and positionkeys,
+ * without strings or boards in between, for the Python module and the
+ * external interface */
+
+static unsigned char auchBase64[256];
+static int fBase64 = 0;
+
+static void
+InitBase64(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < 256; i++)
+        auchBase64[i] = Base64((unsigned char) i);
+
+    fBase64 = 1;
+}
+
+/* The chequers of player i on point p in a positionkey, see
+ * PositionKey() */
+static inline unsigned int
+KeyPoint(const positionkey * pkey, unsigned int i, unsigned int p)
+{
+    if (p == 24)
+        return (pkey->data[6] >> (4 * i)) & 0x0f;
+
+    return (pkey->data[(i ? 0 : 3) + p / 8] >> (4 * (p & 7))) & 0x0f;
+}
+
+static inline void
+KeySetPoint(positionkey * pkey, unsigned int i, unsigned int p, unsigned int n)
+{
+    if (p == 24)
+        pkey->data[6] |= n << (4 * i);
+    else
+        pkey->data[(i ? 0 : 3) + p / 8] |= n << (4 * (p & 7));
+}
+
+/* CheckPosition() but for the chequer counts, which the caller checks */
+static int
+CheckKey(const positionkey * pkey)
+{
+    unsigned int i;
+
+    for (i = 0; i < 24; i++)
+        if (KeyPoint(pkey, 0, i) && KeyPoint(pkey, 1, 23 - i))
+            return 0;
+
+    for (i = 0; i < 6; i++)
+        if (KeyPoint(pkey, 0, i) < 2 || KeyPoint(pkey, 1, i) < 2)
+            return 1;
+
+    return !KeyPoint(pkey, 0, 24) || !KeyPoint(pkey, 1, 24);
+}
+
+/* PositionFromID() of the L_POSITIONID characters at pch to a key */
+static int
+KeyFromID(positionkey * pkey, const unsigned char *pch)
+{
+    unsigned char ach[L_POSITIONID], auch[10];
+    unsigned int i, k, iPlayer = 0, iPoint = 0, n = 0, ac[2] = { 0, 0 };
+
+    for (i = 0; i < L_POSITIONID; i++)
+        if ((ach[i] = auchBase64[pch[i]]) > 63)
+            return 0;
+
+    for (i = 0; i < 3; i++) {
+        auch[3 * i] = (unsigned char) (ach[4 * i] << 2) | (ach[4 * i + 1] >> 4);
+        auch[3 * i + 1] = (unsigned char) (ach[4 * i + 1] << 4) | (ach[4 * i + 2] >> 2);
+        auch[3 * i + 2] = (unsigned char) (ach[4 * i + 2] << 6) | ach[4 * i + 3];
+    }
+    auch[9] = (unsigned char) (ach[12] << 2) | (ach[13] >> 4);
+
+    memset(pkey, 0, sizeof(positionkey));
+
+    /* a run of ones for the chequers on each point, then a zero */
+    for (k = 0; k < 80 && iPlayer < 2; k++)
+        if (auch[k >> 3] & (1 << (k & 7)))
+            n++;
+        else {
+            if (n) {
+                if ((ac[iPlayer] += n) > 15)
+                    return 0;
+                KeySetPoint(pkey, iPlayer, iPoint, n);
+                n = 0;
+            }
+            if (++iPoint == 25) {
+                iPoint = 0;
+                iPlayer++;
+            }
+        }
+
+    if (n) {
+        if ((ac[iPlayer] += n) > 15)
+            return 0;
+        KeySetPoint(pkey, iPlayer, iPoint, n);
+    }
+
+    return CheckKey(pkey);
+}
+
+/* The keys of cIDs position IDs, of L_POSITIONID characters each and
+ * cbStride apart.  The number of valid ones; the key of an invalid one
+ * is all zeroes. */
+extern unsigned int
+PositionKeysFromIDs(positionkey akey[], const char *pchIDs, size_t cbStride, unsigned int cIDs)
+{
+    const unsigned char *pch = (const unsigned char *) pchIDs;
+    unsigned int i, cValid = 0;
+
+    if (!fBase64)
+        InitBase64();
+
+    for (i = 0; i < cIDs; i++, pch += cbStride)
+        if (KeyFromID(&akey[i], pch))
+            cValid++;
+        else
+            memset(&akey[i], 0, sizeof(positionkey));
+
+    return cValid;
+}
+
+/* The IDs of cKeys keys, L_POSITIONID characters each written cbStride
+ * apart (and a NUL after them if there is room) */
+extern void
+PositionIDsFromKeys(char *pchIDs, size_t cbStride, const positionkey akey[], unsigned int cKeys)
+{
+    unsigned int i, j, k, n, p;
+
+    for (i = 0; i < cKeys; i++, pchIDs += cbStride) {
+        unsigned char auch[12] = { 0 };
+        const unsigned char *puch = auch;
+        char *pch = pchIDs;
+
+        for (j = k = 0; j < 2; j++)
+            for (p = 0; p < 25; p++, k++)
+                for (n = KeyPoint(&akey[i], j, p); n && k < 80; n--, k++)
+                    auch[k >> 3] |= (unsigned char) (1 << (k & 7));
+
+        for (j = 0; j < 3; j++, puch += 3) {
+            *pch++ = aszBase64[puch[0] >> 2];
+            *pch++ = aszBase64[((puch[0] & 0x03) << 4) | (puch[1] >> 4)];
+            *pch++ = aszBase64[((puch[1] & 0x0F) << 2) | (puch[2] >> 6)];
+            *pch++ = aszBase64[puch[2] & 0x3F];
+        }
+        *pch++ = aszBase64[*puch >> 2];
+        *pch++ = aszBase64[(*puch & 0x03) << 4];
+
+        if (cbStride > L_POSITIONID)
+            *pch = 0;
+    }
+}
+
 extern int
 EqualBoards(const TanBoard anBoard0, const TanBoard anBoard1)
 {
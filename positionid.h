@@ -21,6 +21,7 @@
 #ifndef POSITIONID_H
 #define POSITIONID_H
 
+#include <stddef.h>
 #include "gnubg-types.h"
 
 #define L_POSITIONID 14
@@ -36,10 +37,15 @@ unsigned int PositionBearoff(const unsigned int anBoard[], unsigned int nPoints,
 
 extern void PositionFromKey(TanBoard anBoard, const positionkey * pkey);
 extern void PositionFromKeySwapped(TanBoard anBoard, const positionkey * pkey);
+extern void PositionKeySwapped(positionkey * pkeySwapped, const positionkey * pkey);
 
 /* Return 1 for success, 0 for invalid id */
 extern int PositionFromID(TanBoard anBoard, const char *szID);
 
+/* Many IDs at once, see positionid.c */
+extern unsigned int PositionKeysFromIDs(positionkey akey[], const char *pchIDs, size_t cbStride, unsigned int cIDs);
+extern void PositionIDsFromKeys(char *pchIDs, size_t cbStride, const positionkey akey[], unsigned int cKeys);
+
 extern void PositionFromBearoff(unsigned int anBoard[], unsigned int usID,
                                 unsigned int nPoints, unsigned int nChequers);
 
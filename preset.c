@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Named evaluation settings, see preset.h */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "preset.h"
+#include "backgammon.h"
+#include "format.h"
+#include "multithread.h"
+
+/* The names of the predefined settings, as aszSettings[] has them
+ * without spaces */
+static const char *aszPresetSettings[NUM_SETTINGS] = {
+    "beginner", "casual", "intermediate", "advanced", "expert", "worldclass", "supremo", "grandmaster", "4ply"
+};
+
+static evalpreset aep[PRESET_MAX];
+/* the presets in aep[] that are done, and may be looked up */
+static int cPresets;
+
+G_LOCK_DEFINE_STATIC(preset);
+
+static void
+PresetSet(evalpreset * pep, const char *szName, const evalcontext * pecChequer, const evalcontext * pecCube,
+          movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    pep->szName = szName;
+    pep->ecChequer = *pecChequer;
+    pep->ecCube = *pecCube;
+    memcpy(pep->aamf, aamf, sizeof(pep->aamf));
+}
+
+/* The predefined settings go first, the first time any preset is
+ * asked for */
+static void
+PresetInit(void)
+{
+    static gsize fInit = 0;
+    int i;
+
+    if (!g_once_init_enter(&fInit))
+        return;
+
+    for (i = 0; i < NUM_SETTINGS; i++)
+        PresetSet(&aep[i], aszPresetSettings[i], &aecSettings[i], &aecSettings[i],
+                  aiSettingsMoveFilter[i] < 0 ? defaultFilters : aaamfMoveFilterSettings[aiSettingsMoveFilter[i]]);
+
+    MT_SafeSet(&cPresets, NUM_SETTINGS);
+
+    g_once_init_leave(&fInit, 1);
+}
+
+extern unsigned int
+PresetCount(void)
+{
+    PresetInit();
+
+    return (unsigned int) MT_SafeGet(&cPresets);
+}
+
+extern evalpreset *
+PresetGet(unsigned int i)
+{
+    return i < PresetCount() ? &aep[i] : NULL;
+}
+
+/* The preset named sz, or numbered sz; NULL if there is none */
+extern evalpreset *
+PresetLookup(const char *sz)
+{
+    const unsigned int c = PresetCount();
+    unsigned int i;
+
+    if (!sz || !*sz)
+        return NULL;
+
+    for (i = 0; i < c; i++)
+        if (!g_ascii_strcasecmp(aep[i].szName, sz))
+            return &aep[i];
+
+    if (strspn(sz, "0123456789") == strlen(sz))
+        return PresetGet((unsigned int) strtoul(sz, NULL, 10));
+
+    return NULL;
+}
+
+/* Add a preset; its number, or -1 if the name is taken or there is no
+ * room for it */
+extern int
+PresetAdd(const char *szName, const evalcontext * pecChequer, const evalcontext * pecCube,
+          movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    int c;
+
+    PresetInit();
+
+    G_LOCK(preset);
+
+    c = MT_SafeGet(&cPresets);
+
+    if (c >= PRESET_MAX || PresetLookup(szName)) {
+        G_UNLOCK(preset);
+        return -1;
+    }
+
+    PresetSet(&aep[c], g_strdup(szName), pecChequer, pecCube, aamf);
+    MT_SafeSet(&cPresets, c + 1);
+
+    G_UNLOCK(preset);
+
+    return c;
+}
+
+extern void
+CommandSetPreset(char *sz)
+{
+    char *pch = NextToken(&sz);
+    int i;
+
+    if (!pch || !*pch) {
+        outputl(_("You must specify a name for the preset (see `help set preset')."));
+        return;
+    }
+
+    if (strspn(pch, "0123456789") == strlen(pch)) {
+        outputl(_("The name of a preset can't be a number."));
+        return;
+    }
+
+    if ((i = PresetAdd(pch, &GetEvalChequer()->ec, &GetEvalCube()->ec, *GetEvalMoveFilter())) < 0) {
+        if (PresetLookup(pch))
+            outputf(_("There is a preset `%s' already; presets can't be changed.\n"), pch);
+        else
+            outputf(_("There is no room for more than %d presets.\n"), PRESET_MAX);
+        return;
+    }
+
+    outputf(_("The current evaluation settings are preset %d, `%s'.\n"), i, pch);
+}
+
+extern void
+CommandShowPresets(char *UNUSED(sz))
+{
+    const unsigned int c = PresetCount();
+    unsigned int i;
+
+    for (i = 0; i < c; i++) {
+        outputf("%2u %-14s %s", i, aep[i].szName, OutputEvalContext(&aep[i].ecChequer, TRUE));
+        outputf(_(", cube %s\n"), OutputEvalContext(&aep[i].ecCube, FALSE));
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRESET_H
+#define PRESET_H
+
+#include "eval.h"
+
+/*
+ * Named evaluation settings for serving bots of several strengths: the
+ * chequer and cube contexts and the move filter that a request through
+ * "set preset" of the external interface, the "preset" of an HTTP
+ * request or a preset name given to gnubg.evaluate() and the like
+ * evaluates with, instead of building them from options each time.
+ *
+ * The predefined settings ("beginner" to "4ply") are there from the
+ * start, and "set preset <name>" adds the current evaluation settings
+ * under a new name.  A preset is never changed or freed once added, so
+ * that the threads can look them up and hold on to them without a
+ * lock, and that the evaluations of a preset always have the same
+ * cache keys.  They are found by name or by number, in the order of
+ * "show presets".
+ */
+
+#define PRESET_MAX 64
+
+typedef struct {
+    const char *szName;
+    evalcontext ecChequer;
+    evalcontext ecCube;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+} evalpreset;
+
+extern evalpreset *PresetLookup(const char *sz);
+extern evalpreset *PresetGet(unsigned int i);
+extern unsigned int PresetCount(void);
+extern int PresetAdd(const char *szName, const evalcontext * pecChequer, const evalcontext * pecCube,
+                     movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
+
+#endif                          /* PRESET_H */
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The counters of the profiling points of the engine, see profile.h */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "profile.h"
+#include "multithread.h"
+
+/* the events each thread keeps for a trace; the later ones are only
+ * counted */
+#define PROFILE_TRACE_EVENTS 65536
+
+typedef struct {
+    guint64 tStart;
+    guint64 tEnd;
+    profilephase pp;
+} profileevent;
+
+struct _profilethread {
+    int id;                     /* of the thread, -1 for the main one */
+    int iGeneration;            /* the profile its counts belong to */
+    guint64 acCalls[NUM_PROFILE_PHASES];
+    guint64 atTicks[NUM_PROFILE_PHASES];
+    int cEvents;
+    profileevent *ae;
+};
+
+const char *aszProfilePhase[NUM_PROFILE_PHASES] = {
+    "movegen", "inputs", "nn", "cache", "bearoff", "dice"
+};
+
+int fProfile = FALSE;
+int fProfileTrace = FALSE;
+
+/* Each "set profile" starts a new generation; the threads clear their
+ * counts when they see it */
+static int iGeneration;
+static GPtrArray *papt;         /* the data of all the threads */
+static guint64 tTicksStart, tTicksStop;
+static guint64 tStart, tStop;   /* get_time_ns() */
+
+#define MAX_STARTUP 32
+
+typedef struct {
+    const char *sz;             /* untranslated */
+    guint64 t;                  /* nanoseconds */
+    int fLazy;
+} startupitem;
+
+static startupitem asi[MAX_STARTUP];
+static unsigned int cStartup;
+static GMutex mutexStartup;     /* lazy starts come from any thread */
+
+extern void
+ProfileAdd(profilephase pp, guint64 tStartPhase)
+{
+    guint64 tEnd = ProfileTicks();
+    ThreadLocalData *ptld = MT_GetTLD();
+    profilethread *ppt;
+    int iGen;
+
+    if (!ptld)
+        return;
+
+    if (!(ppt = ptld->ppt)) {
+        ppt = g_new0(profilethread, 1);
+        ppt->id = ptld->id;
+        ppt->iGeneration = -1;
+        ptld->ppt = ppt;
+
+        MT_Lock(MT_LOCK_PROFILE);
+        g_ptr_array_add(papt, ppt);
+        MT_Unlock(MT_LOCK_PROFILE);
+    }
+
+    if (ppt->iGeneration != (iGen = MT_SafeGet(&iGeneration))) {
+        memset(ppt->acCalls, 0, sizeof(ppt->acCalls));
+        memset(ppt->atTicks, 0, sizeof(ppt->atTicks));
+        MT_SafeSet(&ppt->cEvents, 0);
+        MT_SafeSet(&ppt->iGeneration, iGen);
+    }
+
+    ppt->acCalls[pp]++;
+    ppt->atTicks[pp] += tEnd - tStartPhase;
+
+    if (fProfileTrace && ppt->cEvents < PROFILE_TRACE_EVENTS) {
+        if (!ppt->ae)
+            ppt->ae = g_new(profileevent, PROFILE_TRACE_EVENTS);
+
+        ppt->ae[ppt->cEvents].tStart = tStartPhase;
+        ppt->ae[ppt->cEvents].tEnd = tEnd;
+        ppt->ae[ppt->cEvents].pp = pp;
+        /* the event is complete before the readers see it */
+        MT_SafeInc(&ppt->cEvents);
+    }
+}
+
+/* Start counting from nothing, with a trace if fTrace */
+extern void
+ProfileStart(int fTrace)
+{
+    if (!papt)
+        papt = g_ptr_array_new();
+
+    fProfile = FALSE;
+    MT_SafeInc(&iGeneration);
+
+    tTicksStart = ProfileTicks();
+    tStart = get_time_ns();
+    tTicksStop = 0;
+    fProfileTrace = fTrace;
+    fProfile = TRUE;
+}
+
+extern void
+ProfileStop(void)
+{
+    if (!fProfile)
+        return;
+
+    fProfile = FALSE;
+    tTicksStop = ProfileTicks();
+    tStop = get_time_ns();
+}
+
+/* Nanoseconds the profile has run */
+static guint64
+ProfileElapsed(void)
+{
+    return (tTicksStop ? tStop : get_time_ns()) - tStart;
+}
+
+/* Ticks of ProfileTicks() per microsecond, calibrated against
+ * get_time_ns() over the profile */
+static double
+ProfileTicksPerMicrosecond(void)
+{
+    guint64 tTicks = (tTicksStop ? tTicksStop : ProfileTicks()) - tTicksStart;
+    guint64 t = ProfileElapsed();
+
+    return t > 0 ? (double) tTicks * 1e3 / (double) t : 1.0;
+}
+
+/* The calls and seconds of each phase summed over the threads.  The
+ * seconds the profile has run, 0 if it never has. */
+extern double
+ProfileTotals(guint64 acCalls[NUM_PROFILE_PHASES], double arSeconds[NUM_PROFILE_PHASES])
+{
+    double rTicksPerUs;
+    guint64 atTicks[NUM_PROFILE_PHASES] = { 0 };
+    guint i;
+    int j;
+
+    memset(acCalls, 0, NUM_PROFILE_PHASES * sizeof(guint64));
+
+    if (!papt)
+        return 0.0;
+
+    rTicksPerUs = ProfileTicksPerMicrosecond();
+
+    MT_Lock(MT_LOCK_PROFILE);
+    for (i = 0; i < papt->len; i++) {
+        const profilethread *ppt = g_ptr_array_index(papt, i);
+
+        if (MT_SafeGet(&ppt->iGeneration) != MT_SafeGet(&iGeneration))
+            continue;
+
+        for (j = 0; j < NUM_PROFILE_PHASES; j++) {
+            acCalls[j] += ppt->acCalls[j];
+            atTicks[j] += ppt->atTicks[j];
+        }
+    }
+    MT_Unlock(MT_LOCK_PROFILE);
+
+    for (j = 0; j < NUM_PROFILE_PHASES; j++)
+        arSeconds[j] = (double) atTicks[j] / rTicksPerUs / 1e6;
+
+    return (double) ProfileElapsed() / 1e9;
+}
+
+/* Write the events of the threads as a Chrome trace (JSON, the
+ * trace event format of chrome://tracing and Perfetto).  0 on success,
+ * -1 if the file could not be written. */
+extern int
+ProfileWriteTrace(FILE * pf)
+{
+    double rTicksPerUs = ProfileTicksPerMicrosecond();
+    const char *szSep = "";
+    guint i;
+
+    fputs("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n", pf);
+
+    MT_Lock(MT_LOCK_PROFILE);
+    for (i = 0; papt && i < papt->len; i++) {
+        const profilethread *ppt = g_ptr_array_index(papt, i);
+        int c, j;
+
+        if (MT_SafeGet(&ppt->iGeneration) != MT_SafeGet(&iGeneration) || !ppt->ae)
+            continue;
+
+        c = MT_SafeGet(&ppt->cEvents);
+
+        if (ppt->id < 0)
+            fprintf(pf, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, "
+                    "\"args\": {\"name\": \"main\"}}", szSep);
+        else
+            fprintf(pf, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+                    "\"args\": {\"name\": \"thread %d\"}}", szSep, ppt->id + 1, ppt->id);
+        szSep = ",\n";
+
+        for (j = 0; j < c; j++) {
+            const profileevent *pe = &ppt->ae[j];
+
+            fprintf(pf, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    aszProfilePhase[pe->pp], ppt->id + 1, (double) (gint64) (pe->tStart - tTicksStart) / rTicksPerUs,
+                    (double) (pe->tEnd - pe->tStart) / rTicksPerUs);
+        }
+    }
+    MT_Unlock(MT_LOCK_PROFILE);
+
+    fputs("\n]}\n", pf);
+
+    return ferror(pf) ? -1 : 0;
+}
+
+/* szSubsystem took tNs to start; fLazy if it was started when first
+ * needed rather than at startup */
+extern void
+ProfileStartup(const char *szSubsystem, guint64 tNs, int fLazy)
+{
+    g_mutex_lock(&mutexStartup);
+    if (cStartup < MAX_STARTUP) {
+        asi[cStartup].sz = szSubsystem;
+        asi[cStartup].t = tNs;
+        asi[cStartup].fLazy = fLazy;
+        cStartup++;
+    }
+    g_mutex_unlock(&mutexStartup);
+}
+
+extern unsigned int
+ProfileStartupCount(void)
+{
+    unsigned int c;
+
+    g_mutex_lock(&mutexStartup);
+    c = cStartup;
+    g_mutex_unlock(&mutexStartup);
+
+    return c;
+}
+
+/* The name of the i'th subsystem started, untranslated */
+extern const char *
+ProfileStartupItem(unsigned int i, double *prSeconds, int *pfLazy)
+{
+    const char *sz;
+
+    g_mutex_lock(&mutexStartup);
+    sz = asi[i].sz;
+    *prSeconds = (double) asi[i].t / 1e9;
+    *pfLazy = asi[i].fLazy;
+    g_mutex_unlock(&mutexStartup);
+
+    return sz;
+}
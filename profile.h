@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <glib.h>
+
+/*
+ * Where the engine spends its time, see "set profile".  The hot paths
+ * are timed with the time stamp counter where there is one, and only
+ * while fProfile is set:
+ *
+ *     guint64 tProfile;
+ *
+ *     PROFILE_START(tProfile);
+ *     ...
+ *     PROFILE_STOP(tProfile, PROFILE_NN);
+ *
+ * Each thread counts its own calls and ticks, and with fProfileTrace
+ * also keeps the last of them as events for a trace.
+ */
+
+typedef enum {
+    PROFILE_MOVEGEN,            /* GenerateMoves() */
+    PROFILE_INPUTS,             /* neural net inputs */
+    PROFILE_NN,                 /* neural net evaluations */
+    PROFILE_CACHE,              /* evaluation cache lookups */
+    PROFILE_BEAROFF,            /* bearoff database lookups */
+    PROFILE_DICE,               /* the dice of rollouts */
+    NUM_PROFILE_PHASES
+} profilephase;
+
+/* what a thread has counted, see ThreadLocalData */
+typedef struct _profilethread profilethread;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define ProfileTicks() ((guint64) __rdtsc())
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ProfileTicks() ((guint64) __rdtsc())
+#else
+#define ProfileTicks() get_time_ns()
+#endif
+
+#define PROFILE_START(t) ((t) = fProfile ? ProfileTicks() : 0)
+#define PROFILE_STOP(t, pp) do { if (t) ProfileAdd((pp), (t)); } while (0)
+
+extern int fProfile;
+extern int fProfileTrace;
+extern const char *aszProfilePhase[NUM_PROFILE_PHASES];
+
+extern void ProfileAdd(profilephase pp, guint64 tStart);
+extern void ProfileStart(int fTrace);
+extern void ProfileStop(void);
+extern double ProfileTotals(guint64 acCalls[NUM_PROFILE_PHASES], double arSeconds[NUM_PROFILE_PHASES]);
+extern int ProfileWriteTrace(FILE * pf);
+
+/* The time taken to start each subsystem, at startup or, for the ones
+ * started when first needed, then; see "show startup" */
+extern void ProfileStartup(const char *szSubsystem, guint64 tNs, int fLazy);
+extern unsigned int ProfileStartupCount(void);
+extern const char *ProfileStartupItem(unsigned int i, double *prSeconds, int *pfLazy);
+
+#endif                          /* PROFILE_H */
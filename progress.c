@@ -48,7 +48,8 @@ typedef struct {
     char **ppch;
     int iNextAlternative;
     int iNextGame;
-    time_t tStart;
+    guint64 tStart;             /* get_time_ns() */
+    rollouttelemetry *art;      /* of each alternative, see RolloutTelemetry() */
 #if defined(USE_GTK)
     rolloutstat *prs;
     GtkWidget *pwRolloutDialog;
@@ -63,6 +64,9 @@ typedef struct {
     GtkWidget *pwElapsed;
     GtkWidget *pwLeft;
     GtkWidget *pwSE;
+    GtkWidget *pwRate;
+    GtkWidget *pwBusy;
+    GtkWidget *pwToLimit;
     int nGamesDone;
     char ***pListText;
     int stopped;
@@ -99,14 +103,19 @@ FreeTextList(rolloutprogress * prp)
 }
 #endif
 
+/* Seconds since t_start */
+static double
+time_elapsed(guint64 t_start)
+{
+    return (double) (get_time_ns() - t_start) / 1e9;
+}
+
 static time_t
-time_left(unsigned int n_games_todo, unsigned int n_games_done, unsigned int initial_game_count, time_t t_start)
+time_left(unsigned int n_games_todo, unsigned int n_games_done, unsigned int initial_game_count, guint64 t_start)
 {
-    float pt;
-    time_t t_now;
-    time(&t_now);
-    pt = (float) n_games_todo / (float) (n_games_done - initial_game_count);
-    return (time_t) (pt * (float) (t_now - t_start));
+    double pt = (double) n_games_todo / (double) (n_games_done - initial_game_count);
+
+    return (time_t) (pt * time_elapsed(t_start));
 }
 
 static char *
@@ -129,6 +138,27 @@ formatDelta(const time_t t)
 
 }
 
+/* Bring the telemetry of alternative iAlternative up to date; with the
+ * last one, the games per second of all of them and the time until
+ * they are all down to the STD limit, -1 if unknown */
+static void
+UpdateTelemetry(rolloutprogress * prp, int iAlternative, double *prGamesPerSec, double *prSecondsToLimit)
+{
+    int i;
+
+    if (RolloutTelemetry(iAlternative, &prp->art[iAlternative]))
+        memset(&prp->art[iAlternative], 0, sizeof(rollouttelemetry));
+
+    *prGamesPerSec = 0.0;
+    *prSecondsToLimit = 0.0;
+    for (i = 0; i < prp->n; i++) {
+        *prGamesPerSec += prp->art[i].rGamesPerSec;
+        if (*prSecondsToLimit >= 0.0)
+            *prSecondsToLimit = prp->art[i].rSecondsToLimit < 0.0 ? -1.0
+                : MAX(*prSecondsToLimit, prp->art[i].rSecondsToLimit);
+    }
+}
+
 
 static float
 estimatedSE(const float rSE, const int iGame, const int nTrials)
@@ -762,6 +792,7 @@ GTKRolloutProgressStart(const cubeinfo * UNUSED(pci), const int n,
     if (aars)
         memset(aars, 0, 2 * n * sizeof(rolloutstat));
     prp->n = n;
+    prp->art = g_new0(rollouttelemetry, n);
     prp->nGamesDone = 0;
     prp->stopped = 0;
     MT_SafeSet(&fInterrupt, FALSE);
@@ -844,11 +875,27 @@ GTKRolloutProgressStart(const cubeinfo * UNUSED(pci), const int n,
     g_free(sz);
     gtk_box_pack_start(GTK_BOX(pwhbox), prp->pwSE = gtk_label_new(_("n/a")), FALSE, FALSE, 4);
 
+    /* throughput */
+
+#if GTK_CHECK_VERSION(3,0,0)
+    pwhbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
+#else
+    pwhbox = gtk_hbox_new(FALSE, 4);
+#endif
+    gtk_box_pack_start(GTK_BOX(pwVbox), pwhbox, FALSE, FALSE, 0);
+
+    gtk_box_pack_start(GTK_BOX(pwhbox), gtk_label_new(_("Games per second")), FALSE, FALSE, 4);
+    gtk_box_pack_start(GTK_BOX(pwhbox), prp->pwRate = gtk_label_new(_("n/a")), FALSE, FALSE, 4);
+    gtk_box_pack_start(GTK_BOX(pwhbox), gtk_label_new(_("Threads busy")), FALSE, FALSE, 4);
+    gtk_box_pack_start(GTK_BOX(pwhbox), prp->pwBusy = gtk_label_new(_("n/a")), FALSE, FALSE, 4);
+    gtk_box_pack_start(GTK_BOX(pwhbox), gtk_label_new(_("STD limit in")), FALSE, FALSE, 4);
+    gtk_box_pack_start(GTK_BOX(pwhbox), prp->pwToLimit = gtk_label_new(_("n/a")), FALSE, FALSE, 4);
+
     gtk_container_add(GTK_CONTAINER(DialogArea(prp->pwRolloutDialog, DA_MAIN)), pwVbox);
     gtk_widget_show_all(prp->pwRolloutDialog);
 
     /* record start time */
-    time(&prp->tStart);
+    prp->tStart = get_time_ns();
 
 }
 
@@ -869,6 +916,7 @@ GTKRolloutProgress(const float aarOutput[][NUM_ROLLOUT_OUTPUTS],
     static int min_games_done = 0;
     char sz[32];
     int i;
+    double rGamesPerSec, rSecondsToLimit;
     GtkTreeIter iter;
 
     if (!prp || !prp->pwRolloutResult)
@@ -930,11 +978,23 @@ GTKRolloutProgress(const float aarOutput[][NUM_ROLLOUT_OUTPUTS],
 
     if ((iAlternative == (prp->n - 1)) && n_games_done > initial_game_count) {
         time_t t = time_left(n_games_todo, n_games_done, initial_game_count, prp->tStart);
-        gtk_label_set_text(GTK_LABEL(prp->pwElapsed), formatDelta(time(NULL) - prp->tStart));
+        gtk_label_set_text(GTK_LABEL(prp->pwElapsed), formatDelta((time_t) time_elapsed(prp->tStart)));
         gtk_label_set_text(GTK_LABEL(prp->pwLeft), formatDelta(t));
 
     }
 
+    /* throughput, and when the STD limit will be reached */
+
+    UpdateTelemetry(prp, iAlternative, &rGamesPerSec, &rSecondsToLimit);
+    if (iAlternative == (prp->n - 1)) {
+        sprintf(sz, "%.1f", rGamesPerSec);
+        gtk_label_set_text(GTK_LABEL(prp->pwRate), sz);
+        sprintf(sz, "%.0f%%", 100.0 * prp->art[iAlternative].rUtilisation);
+        gtk_label_set_text(GTK_LABEL(prp->pwBusy), sz);
+        gtk_label_set_text(GTK_LABEL(prp->pwToLimit),
+                           rSecondsToLimit < 0.0 ? _("n/a") : formatDelta((time_t) rSecondsToLimit));
+    }
+
     /* calculate estimated SE */
 
     if (!iAlternative && iGame > 10) {
@@ -971,6 +1031,7 @@ GTKRolloutProgressEnd(void **pp, gboolean destroy)
     /* if they cancelled the rollout early, prp->pwRolloutDialog has
      * already been destroyed */
     if (!prp->pwRolloutDialog) {
+        g_free(prp->art);
         g_free(*pp);
         return stopped;
     }
@@ -993,6 +1054,7 @@ GTKRolloutProgressEnd(void **pp, gboolean destroy)
 
     prp->pwRolloutProgress = NULL;
 
+    g_free(prp->art);
     g_free(*pp);
     return stopped;
 }
@@ -1014,11 +1076,12 @@ TextRolloutProgressStart(const cubeinfo * UNUSED(pci), const int n,
     for (i = 0; i < n; ++i)
         prp->ppch[i] = (char *) asz[i];
     prp->n = n;
+    prp->art = g_new0(rollouttelemetry, n);
     prp->iNextAlternative = 0;
     prp->iNextGame = prc->nTrials / 10;
 
     /* record start time */
-    time(&prp->tStart);
+    prp->tStart = get_time_ns();
 
 }
 
@@ -1029,6 +1092,7 @@ TextRolloutProgressEnd(void * const *pp)
     rolloutprogress *prp = *pp;
 
     g_free(prp->ppch);
+    g_free(prp->art);
     g_free(prp);
 
     output("\r\n");
@@ -1047,6 +1111,8 @@ TextRolloutProgress(float aarOutput[][NUM_ROLLOUT_OUTPUTS],
 
     char *pch, *pc;
     time_t t;
+    double rGamesPerSec, rSecondsToLimit;
+    int i;
     static unsigned int n_games_todo = 0;
     static unsigned int n_games_done = 0;
     static int min_games_done = 0;
@@ -1098,6 +1164,7 @@ TextRolloutProgress(float aarOutput[][NUM_ROLLOUT_OUTPUTS],
         if (iGame < min_games_done)
             min_games_done = iGame + 1;
     }
+    UpdateTelemetry(prp, iAlternative, &rGamesPerSec, &rSecondsToLimit);
     if (iAlternative != (prp->n - 1))
         return;
 
@@ -1106,10 +1173,25 @@ TextRolloutProgress(float aarOutput[][NUM_ROLLOUT_OUTPUTS],
     t = time_left(n_games_todo, n_games_done, initial_game_count, prp->tStart);
 
     outputf(_("Time elapsed"));
-    outputf(" %s ",formatDelta(time(NULL) - prp->tStart));
+    outputf(" %s ",formatDelta((time_t) time_elapsed(prp->tStart)));
     outputf(_("Estimated time left"));
     outputf(" %s\n", formatDelta(t));
 
+    /* throughput, of each alternative if there are several */
+
+    outputf(_("Games per second"));
+    outputf(" %.1f", rGamesPerSec);
+    if (prp->n > 1) {
+        output(" (");
+        for (i = 0; i < prp->n; i++)
+            outputf(i ? " %.1f" : "%.1f", prp->art[i].rGamesPerSec);
+        output(")");
+    }
+    outputf(", %s %.0f%%", _("threads busy"), 100.0 * prp->art[iAlternative].rUtilisation);
+    if (rSecondsToLimit >= 0.0)
+        outputf(", %s %s", _("STD limit in"), formatDelta((time_t) rSecondsToLimit));
+    output("\n");
+
     /* estimated SE */
 
     /* calculate estimated SE */
@@ -78,23 +78,53 @@ RandomOrgCallBack(void *pvRawData, size_t nSize, size_t nNumMemb, void *pvUserDa
     return nNewDataLen;
 }
 
-static RandomData randomData = { 0, -1, {0} };
+/*
+ * The dice are read from one buffer while a thread fetches the next
+ * block into the other, asked to as soon as fewer dice than the
+ * low-water mark are left, so play only waits for random.org when it
+ * deals the dice faster than the site answers.  The thread keeps its
+ * curl handle, and with it the connection, between blocks.
+ */
 
-unsigned int
-getDiceRandomDotOrg(void)
+static RandomData ardBuffer[2] = { {0, -1, {0}}, {0, -1, {0}} };
+static int iRead;               /* the buffer the dice are read from */
+static int fFetching;           /* the thread is filling the other one */
+static int fFetched;            /* the other one holds a new block */
+static int fQuit;
+static CURLcode nError = CURLE_OK;      /* of the last fetch */
+static unsigned int nLowWater = BUFLENGTH / 2;
+static GThread *pThread;
+static GMutex mutex;
+static GCond cond;
+
+static CURLcode
+FetchBlock(CURL * curl_handle, RandomData * prd)
 {
-    CURL *curl_handle;
     CURLcode nRetVal;
+
+    prd->nNumRolls = 0;
+    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) prd);
+
+    nRetVal = curl_easy_perform(curl_handle);
+#if defined(RANDOMORG_DEBUG)
+    outputf("\n\n");
+#endif
+
+    if (nRetVal == CURLE_OK && !prd->nNumRolls)
+        nRetVal = CURLE_GOT_NOTHING;
+
+    return nRetVal;
+}
+
+static gpointer
+FetchThread(gpointer p)
+{
+    CURL *curl_handle;
 #if defined(WIN32)
     gchar *szWIN32_cert_path = NULL;
 #endif
-    if ((randomData.nCurrent >= 0) && ((unsigned int) randomData.nCurrent < randomData.nNumRolls)) {
-        return randomData.anBuf[randomData.nCurrent++];
-    }
 
-    randomData.nNumRolls = 0;
-    outputf(_("Fetching %d random numbers from <%s>\n"), BUFLENGTH, RANDOMORGSITE);
-    outputx();
+    (void) p;
 
     /* Initialize the curl session */
     curl_handle = curl_easy_init();
@@ -111,31 +141,136 @@ getDiceRandomDotOrg(void)
     curl_easy_setopt(curl_handle, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(curl_handle, CURLOPT_URL, RANDOMORG_URL);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, RandomOrgCallBack);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &randomData);
     curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, RANDOMORG_USERAGENT);
 
-    nRetVal = curl_easy_perform(curl_handle);
-#if defined(RANDOMORG_DEBUG)
-    outputf("\n\n");
-#endif
+    g_mutex_lock(&mutex);
+
+    while (TRUE) {
+        RandomData *prd;
+        CURLcode nRetVal;
+
+        while (!fQuit && !fFetching)
+            g_cond_wait(&cond, &mutex);
+
+        if (fQuit)
+            break;
 
+        /* only this thread touches the other buffer while fetching */
+        prd = &ardBuffer[!iRead];
+        g_mutex_unlock(&mutex);
+
+        nRetVal = FetchBlock(curl_handle, prd);
+
+        g_mutex_lock(&mutex);
+        nError = nRetVal;
+        fFetched = nRetVal == CURLE_OK;
+        fFetching = FALSE;
+        g_cond_broadcast(&cond);
+    }
+
+    g_mutex_unlock(&mutex);
+
+    /* Cleanup curl session */
+    curl_easy_cleanup(curl_handle);
 #if defined(WIN32)
     g_free(szWIN32_cert_path);
 #endif
 
-    /* check if an error condition exists */
-    if (nRetVal != CURLE_OK) {
-        curl_easy_cleanup(curl_handle);
-        outputerrf("curl_easy_perform() failed: %s\n", curl_easy_strerror(nRetVal));
-        randomData.nCurrent = -1;
-        return 0;
+    return NULL;
+}
+
+/* Ask for the next block, with the mutex held */
+static void
+RequestBlock(void)
+{
+    if (!pThread)
+        pThread = g_thread_new("random.org", FetchThread, NULL);
+
+    fFetching = TRUE;
+    g_cond_broadcast(&cond);
+}
+
+unsigned int
+getDiceRandomDotOrg(void)
+{
+    RandomData *prd;
+    unsigned int n, cLeft;
+
+    g_mutex_lock(&mutex);
+
+    prd = &ardBuffer[iRead];
+
+    if (prd->nCurrent < 0 || (unsigned int) prd->nCurrent >= prd->nNumRolls) {
+
+        if (!fFetched && !fFetching) {
+            outputf(_("Fetching %d random numbers from <%s>\n"), BUFLENGTH, RANDOMORGSITE);
+            outputx();
+            RequestBlock();
+        }
+
+        while (fFetching)
+            g_cond_wait(&cond, &mutex);
+
+        /* check if an error condition exists */
+        if (!fFetched) {
+            CURLcode nRetVal = nError;
+
+            g_mutex_unlock(&mutex);
+            outputerrf("curl_easy_perform() failed: %s\n", curl_easy_strerror(nRetVal));
+            return 0;
+        }
+
+        prd->nCurrent = -1;
+        iRead = !iRead;
+        fFetched = FALSE;
+        prd = &ardBuffer[iRead];
+        prd->nCurrent = 0;
     }
 
-    /* Cleanup curl session */
-    curl_easy_cleanup(curl_handle);
+    n = prd->anBuf[prd->nCurrent++];
+    cLeft = (unsigned int) (prd->nNumRolls - (size_t) prd->nCurrent);
+
+    /* a failed prefetch is only tried again when the dice run out */
+    if (cLeft < nLowWater && !fFetched && !fFetching && nError == CURLE_OK)
+        RequestBlock();
+
+    g_mutex_unlock(&mutex);
+
+    return n;
+}
+
+/* Start fetching the next block with fewer than n dice left in the
+ * current one; 0 fetches only when they run out */
+extern void
+SetRandomDotOrgLowWater(unsigned int n)
+{
+    nLowWater = MIN(n, BUFLENGTH);
+}
+
+extern unsigned int
+GetRandomDotOrgLowWater(void)
+{
+    return nLowWater;
+}
+
+/* Stop the fetching thread and drop the dice fetched */
+extern void
+CloseRandomDotOrg(void)
+{
+    g_mutex_lock(&mutex);
+    fQuit = TRUE;
+    g_cond_broadcast(&cond);
+    g_mutex_unlock(&mutex);
+
+    if (pThread) {
+        g_thread_join(pThread);
+        pThread = NULL;
+    }
 
-    randomData.nCurrent = 1;
-    return randomData.anBuf[0];
+    ardBuffer[0].nNumRolls = ardBuffer[1].nNumRolls = 0;
+    ardBuffer[0].nCurrent = ardBuffer[1].nCurrent = -1;
+    iRead = fFetching = fFetched = fQuit = FALSE;
+    nError = CURLE_OK;
 }
 
 #endif
@@ -44,5 +44,8 @@ typedef struct {
 } RandomData;
 
 extern unsigned int getDiceRandomDotOrg(void);
+extern void SetRandomDotOrgLowWater(unsigned int n);
+extern unsigned int GetRandomDotOrgLowWater(void);
+extern void CloseRandomDotOrg(void);
 
 #endif
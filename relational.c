@@ -32,6 +32,8 @@
 #include "relational.h"
 #include "backgammon.h"
 #include "positionid.h"
+#include "matchid.h"
+#include "drawboard.h"
 #include "rollout.h"
 #include "analysis.h"
 #include "util.h"
@@ -72,29 +74,38 @@ GameOver(void)
     return FALSE;
 }
 
+/* Reserve n consecutive ids for table and return the first.  The
+ * increment is done in place, so the row stays locked until the
+ * transaction commits and concurrent loaders cannot hand out the same
+ * ids; a whole match only needs one reservation per table. */
 static int
-GetNextId(DBProvider * pdb, const char *table)
+GetNextIds(DBProvider * pdb, const char *table, int n)
 {
     int next_id;
+    char szN[16];
+    const char *values[2];
+    char *buf;
+
+    g_snprintf(szN, sizeof(szN), "%d", n);
+    values[0] = szN;
+    values[1] = table;
+    if (!pdb->UpdateCommandBind("UPDATE control SET next_id = next_id + ? WHERE tablename = ?", 2, values))
+        return -1;
+
     /* fetch next_id from control table */
-    char *buf = g_strdup_printf("next_id FROM control WHERE tablename = '%s'", table);
+    buf = g_strdup_printf("next_id FROM control WHERE tablename = '%s'", table);
     next_id = RunQueryValue(pdb, buf);
     g_free(buf);
 
-    if (next_id != -1) {        /* update control data with new next id */
-        next_id++;
-        buf = g_strdup_printf("UPDATE control SET next_id = %d WHERE tablename = '%s'", next_id, table);
-        if (!pdb->UpdateCommand(buf))
-            next_id = -1;
-        g_free(buf);
-    } else {                    /* insert new id */
-        next_id = 1;
-        buf = g_strdup_printf("INSERT INTO control (tablename,next_id) VALUES ('%s',%d)", table, next_id);
-        if (!pdb->UpdateCommand(buf))
-            next_id = -1;
-        g_free(buf);
-    }
-    return next_id;
+    if (next_id != -1)
+        return next_id - n + 1;
+
+    /* insert new id */
+    values[0] = table;
+    values[1] = szN;
+    if (!pdb->UpdateCommandBind("INSERT INTO control (tablename,next_id) VALUES (?,?)", 2, values))
+        return -1;
+    return 1;
 }
 
 static int
@@ -111,12 +122,16 @@ AddPlayer(DBProvider * pdb, const char *name)
 {
     int id = GetPlayerId(pdb, name);
     if (id == -1) {             /* Add new player to database */
-        id = GetNextId(pdb, "player");
+        id = GetNextIds(pdb, "player", 1);
         if (id != -1) {
-            char *buf = g_strdup_printf("INSERT INTO player(player_id,name,notes) VALUES (%d, '%s', '')", id, name);
-            if (!pdb->UpdateCommand(buf))
+            char szId[16];
+            const char *values[2];
+
+            g_snprintf(szId, sizeof(szId), "%d", id);
+            values[0] = szId;
+            values[1] = name;
+            if (!pdb->UpdateCommandBind("INSERT INTO player(player_id,name,notes) VALUES (?, ?, '')", 2, values))
                 id = -1;
-            g_free(buf);
         }
     }
     return id;
@@ -136,19 +151,147 @@ MatchResult(int nMatchTo)
     return result;
 }
 
-#define NS(x) (x == NULL) ? "NULL" : x
-#define APPENDF(x,y) {g_string_append_printf(column, "%s, ", x); \
-	g_string_append_printf(value, "'%s', ", g_ascii_dtostr(tmpf, G_ASCII_DTOSTR_BUF_SIZE, y));}
-#define APPENDI(x,y) {g_string_append_printf(column, "%s, ", x); \
-	g_string_append_printf(value, "'%i', ", y);}
-#define APPENDU(x,y) {g_string_append_printf(column, "%s, ", x); \
-        g_string_append_printf(value, "'%u', ", y);}
+/* The columns of matchstat summed in playerstat, for each player and
+ * opponent.  Those ending in _normalised are FLOAT, the others
+ * INTEGER. */
+static const char *const aszPlayerStat[] = {
+    "total_moves", "unforced_moves", "total_cube_decisions", "close_cube_decisions", "doubles", "takes", "passes",
+    "very_bad_moves", "bad_moves", "doubtful_moves", "unmarked_moves", "very_unlucky_rolls", "unlucky_rolls",
+    "unmarked_rolls", "lucky_rolls", "very_lucky_rolls", "missed_doubles_below_cp", "missed_doubles_above_cp",
+    "wrong_doubles_below_dp", "wrong_doubles_above_tg", "wrong_takes", "wrong_passes",
+    "chequer_error_total_normalised", "error_missed_doubles_below_cp_normalised",
+    "error_missed_doubles_above_cp_normalised", "error_wrong_doubles_below_dp_normalised",
+    "error_wrong_doubles_above_tg_normalised", "error_wrong_takes_normalised", "error_wrong_passes_normalised",
+    "luck_total_normalised", "snowie_moves", "cube_error_total_normalised"
+};
+
+/* The playerstat columns joined by commas, each one printed with
+ * szFormat, which takes its name twice */
+static char *
+PlayerStatColumns(const char *szFormat)
+{
+    GString *gs = g_string_new(NULL);
+    unsigned int i;
+
+    for (i = 0; i < G_N_ELEMENTS(aszPlayerStat); i++) {
+        if (i)
+            g_string_append(gs, ", ");
+        g_string_append_printf(gs, szFormat, aszPlayerStat[i], aszPlayerStat[i]);
+    }
+
+    return g_string_free(gs, FALSE);
+}
+
+/* The opponent of matchstat.player_id in a matchstat NATURAL JOIN
+ * session */
+#define OPPONENT_ID "CASE WHEN matchstat.player_id = session.player_id0 " \
+    "THEN session.player_id1 ELSE session.player_id0 END"
 
+/* Make the playerstat rows of the two players against each other
+ * again from matchstat, or all of them if player_id0 is -1 */
 static int
-AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *table, int nMatchTo, statcontext * sc)
+RebuildPlayerStats(DBProvider * pdb, int player_id0, int player_id1)
+{
+    char *szWhere, *szSums, *buf;
+    int ret;
+
+    if (player_id0 == -1)
+        szWhere = g_strdup("");
+    else
+        szWhere = g_strdup_printf("WHERE (session.player_id0 = %d AND session.player_id1 = %d) "
+                                  "OR (session.player_id0 = %d AND session.player_id1 = %d) ",
+                                  player_id0, player_id1, player_id1, player_id0);
+
+    if (player_id0 == -1)
+        buf = g_strdup("DELETE FROM playerstat");
+    else
+        buf = g_strdup_printf("DELETE FROM playerstat WHERE (player_id = %d AND opponent_id = %d) "
+                              "OR (player_id = %d AND opponent_id = %d)", player_id0, player_id1, player_id1,
+                              player_id0);
+    ret = pdb->UpdateCommand(buf);
+    g_free(buf);
+
+    if (ret) {
+        char *szColumns = PlayerStatColumns("%s");
+
+        szSums = PlayerStatColumns("SUM(%s)");
+        buf = g_strdup_printf("INSERT INTO playerstat (player_id, opponent_id, %s) "
+                              "SELECT matchstat.player_id, " OPPONENT_ID ", %s "
+                              "FROM matchstat NATURAL JOIN session %s"
+                              "GROUP BY matchstat.player_id, " OPPONENT_ID, szColumns, szSums, szWhere);
+        ret = pdb->UpdateCommand(buf);
+        g_free(buf);
+        g_free(szSums);
+        g_free(szColumns);
+    }
+
+    g_free(szWhere);
+    return ret;
+}
+
+/* Add the stats just added to matchstat to those of player_id against
+ * opponent_id in playerstat.  names and values are the columns and
+ * values of the matchstat row. */
+static int
+AddPlayerStats(DBProvider * pdb, int player_id, int opponent_id, const GPtrArray * names, const GPtrArray * values)
+{
+    const char *apch[G_N_ELEMENTS(aszPlayerStat) + 2];
+    char aszId[2][16];
+    char *buf, *szColumns;
+    unsigned int i, j;
+    int n, ret;
+
+    g_snprintf(aszId[0], sizeof(aszId[0]), "%d", player_id);
+    g_snprintf(aszId[1], sizeof(aszId[1]), "%d", opponent_id);
+
+    buf = g_strdup_printf("COUNT(*) FROM playerstat WHERE player_id = %d AND opponent_id = %d", player_id,
+                          opponent_id);
+    n = RunQueryValue(pdb, buf);
+    g_free(buf);
+
+    apch[0] = aszId[0];
+    apch[1] = aszId[1];
+    if (n < 0 || (!n && !pdb->UpdateCommandBind("INSERT INTO playerstat (player_id, opponent_id) VALUES (?, ?)",
+                                                 2, apch)))
+        return FALSE;
+
+    for (i = 0; i < G_N_ELEMENTS(aszPlayerStat); i++) {
+        for (j = 0; j < names->len && strcmp(g_ptr_array_index(names, j), aszPlayerStat[i]); j++);
+        g_assert(j < names->len);
+        apch[i] = g_ptr_array_index(values, j);
+    }
+    apch[i++] = aszId[0];
+    apch[i++] = aszId[1];
+
+    szColumns = PlayerStatColumns("%s = %s + ?");
+    buf = g_strdup_printf("UPDATE playerstat SET %s WHERE player_id = ? AND opponent_id = ?", szColumns);
+    ret = pdb->UpdateCommandBind(buf, i, apch);
+    g_free(buf);
+    g_free(szColumns);
+
+    return ret;
+}
+
+#define NS(x) (x == NULL) ? "NULL" : x
+#define APPENDF(x,y) {g_string_append_printf(column, "%s, ", x); g_string_append(value, "?, "); \
+	g_ptr_array_add(names, (gpointer) x); \
+	g_ptr_array_add(values, g_strdup(g_ascii_dtostr(tmpf, G_ASCII_DTOSTR_BUF_SIZE, y)));}
+#define APPENDI(x,y) {g_string_append_printf(column, "%s, ", x); g_string_append(value, "?, "); \
+	g_ptr_array_add(names, (gpointer) x); \
+	g_ptr_array_add(values, g_strdup_printf("%i", y));}
+#define APPENDU(x,y) {g_string_append_printf(column, "%s, ", x); g_string_append(value, "?, "); \
+	g_ptr_array_add(names, (gpointer) x); \
+        g_ptr_array_add(values, g_strdup_printf("%u", y));}
+
+/* The stats of a match also go to playerstat, those of player_id
+ * against opponent_id */
+static int
+AddStats(DBProvider * pdb, int gms_id, int gm_id, int player_id, int opponent_id, int player, const char *table,
+         int nMatchTo, statcontext * sc)
 {
     gchar *buf;
     GString *column, *value;
+    GPtrArray *names, *values;
     int totalmoves, unforced;
     float errorcost, errorskill;
     float aaaar[3][2][2][2];
@@ -156,10 +299,6 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
     int ret;
     char tmpf[G_ASCII_DTOSTR_BUF_SIZE];
 
-    int gms_id = GetNextId(pdb, table);
-    if (gms_id == -1)
-        return FALSE;
-
     totalmoves = sc->anTotalMoves[player];
     unforced = sc->anUnforcedMoves[player];
 
@@ -169,6 +308,8 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
 
     column = g_string_new(NULL);
     value = g_string_new(NULL);
+    names = g_ptr_array_new();
+    values = g_ptr_array_new_with_free_func(g_free);
 
 
     if (strcmp("matchstat", table) == 0) {
@@ -281,11 +422,17 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
 
     g_string_truncate(column, column->len - 2);
     g_string_truncate(value, value->len - 2);
+    /* the columns present vary only with the match type, so the few
+     * distinct statements are prepared once and then reused */
     buf = g_strdup_printf("INSERT INTO %s (%s) VALUES(%s)", table, column->str, value->str);
-    ret = pdb->UpdateCommand(buf);
+    ret = pdb->UpdateCommandBind(buf, values->len, (const char *const *) values->pdata);
+    if (ret && !strcmp("matchstat", table))
+        ret = AddPlayerStats(pdb, player_id, opponent_id, names, values);
     g_free(buf);
     g_string_free(column, TRUE);
     g_string_free(value, TRUE);
+    g_ptr_array_free(names, TRUE);
+    g_ptr_array_free(values, TRUE);
     return ret;
 }
 
@@ -351,6 +498,93 @@ CreateDatabase(DBProvider * pdb)
     return TRUE;
 }
 
+/* What version 2 adds to the tables of version 1, as in gnubg.sql:
+ * indexes on the join keys and the playerstat sums */
+static const char *const aszSchema2[] = {
+    "CREATE INDEX iplayername ON player (name)",
+    "CREATE INDEX isessionchecksum ON session (checksum)",
+    "CREATE INDEX isessionplayer0 ON session (player_id0)",
+    "CREATE INDEX isessionplayer1 ON session (player_id1)",
+    "CREATE INDEX imatchstatsession ON matchstat (session_id)",
+    "CREATE INDEX imatchstatplayer ON matchstat (player_id)",
+    "CREATE INDEX igamesession ON game (session_id)",
+    "CREATE INDEX isgamestatgame ON gamestat (game_id)",
+    "CREATE INDEX isgamestatplayer ON gamestat (player_id)"
+};
+
+/* What version 3 adds: the positions of the analysed chequer plays */
+static const char *const aszSchema3[] = {
+    "CREATE TABLE gameposition (gameposition_id INTEGER NOT NULL, session_id INTEGER NOT NULL, "
+        "game_number INTEGER NOT NULL, move_number INTEGER NOT NULL, player_id INTEGER NOT NULL, "
+        "gnubg_id CHAR(14) NOT NULL, match_id CHAR(12) NOT NULL, dice0 INTEGER NOT NULL, dice1 INTEGER NOT NULL, "
+        "cube INTEGER NOT NULL, cube_owner INTEGER NOT NULL, best_move CHAR(32) NOT NULL, "
+        "best_equity FLOAT NOT NULL, played_equity FLOAT NOT NULL, PRIMARY KEY (gameposition_id), "
+        "FOREIGN KEY (session_id) REFERENCES session (session_id) ON DELETE CASCADE, "
+        "FOREIGN KEY (player_id) REFERENCES player (player_id) ON DELETE RESTRICT)",
+    "CREATE INDEX igamepositionid ON gameposition (gnubg_id)"
+};
+
+/* Version 1 to version 2 */
+static int
+UpgradeDatabase2(DBProvider * pdb)
+{
+    GString *gs;
+    unsigned int i;
+    int ret;
+
+    gs = g_string_new("CREATE TABLE playerstat (player_id INTEGER NOT NULL, opponent_id INTEGER NOT NULL");
+    for (i = 0; i < G_N_ELEMENTS(aszPlayerStat); i++)
+        g_string_append_printf(gs, ", %s %s DEFAULT 0 NOT NULL", aszPlayerStat[i],
+                               g_str_has_suffix(aszPlayerStat[i], "_normalised") ? "FLOAT" : "INTEGER");
+    g_string_append(gs, ", PRIMARY KEY (player_id, opponent_id))");
+
+    ret = pdb->UpdateCommand(gs->str)
+        && pdb->UpdateCommand("CREATE INDEX iplayerstatopponent ON playerstat (opponent_id)");
+    g_string_free(gs, TRUE);
+
+    for (i = 0; ret && i < G_N_ELEMENTS(aszSchema2); i++)
+        ret = pdb->UpdateCommand(aszSchema2[i]);
+
+    return ret && RebuildPlayerStats(pdb, -1, -1);
+}
+
+/* Bring a database of an older version up to DB_VERSION, one version
+ * after the other, in a single transaction */
+static int
+UpgradeDatabase(DBProvider * pdb)
+{
+    int version = RunQueryValue(pdb, "next_id FROM control WHERE tablename = 'version'");
+    char *buf;
+    unsigned int i;
+    int ret;
+
+    if (version < DB_VERSION_UPGRADE || version >= DB_VERSION)
+        return TRUE;
+
+    ret = pdb->BeginTransaction();
+
+    if (ret && version < 2)
+        ret = UpgradeDatabase2(pdb);
+
+    for (i = 0; ret && version < 3 && i < G_N_ELEMENTS(aszSchema3); i++)
+        ret = pdb->UpdateCommand(aszSchema3[i]);
+
+    if (ret) {
+        buf = g_strdup_printf("UPDATE control SET next_id = %d WHERE tablename = 'version'", DB_VERSION);
+        ret = pdb->UpdateCommand(buf);
+        g_free(buf);
+    }
+
+    if (ret)
+        pdb->Commit();
+    else {
+        pdb->Rollback();
+        outputerrf(_("Failed to upgrade the database to version %d"), DB_VERSION);
+    }
+
+    return ret;
+}
+
 DBProvider *
 ConnectToDB(DBProviderType dbType)
 {
@@ -360,23 +594,40 @@ ConnectToDB(DBProviderType dbType)
         if (con < 0)
             return NULL;
 
-        if (con > 0 || CreateDatabase(pdb))
+        if (con > 0 ? UpgradeDatabase(pdb) : CreateDatabase(pdb))
             return pdb;
     }
     return NULL;
 }
 
-static void
+static int
 AddGames(DBProvider * pdb, int session_id, int player_id0, int player_id1)
 {
-    int gamenum = 0;
-    listOLD *plg, *pl = lMatch.plNext;
+    int gamenum = 0, nGames = 0;
+    int game_id, gamestat_id;
+    char aszValues[9][16];
+    const char *values[9];
+    int i;
+    listOLD *plg, *pl;
+
+    for (pl = lMatch.plNext; pl->p; pl = pl->plNext)
+        nGames++;
+
+    if (!nGames)
+        return TRUE;
+
+    if ((game_id = GetNextIds(pdb, "game", nGames)) == -1
+        || (gamestat_id = GetNextIds(pdb, "gamestat", 2 * nGames)) == -1)
+        return FALSE;
+
+    for (i = 0; i < 9; i++)
+        values[i] = aszValues[i];
+
+    pl = lMatch.plNext;
     while ((plg = pl->p) != NULL) {
-        int game_id = GetNextId(pdb, "game");
         int result = 0;
         moverecord *pmr = plg->plNext->p;
         xmovegameinfo *pmgi = &pmr->g;
-        char *buf;
 
         switch(pmgi->fWinner) {
             case 0:
@@ -391,62 +642,155 @@ AddGames(DBProvider * pdb, int session_id, int player_id0, int player_id1)
                 g_assert_not_reached();
         }
 
-        buf = g_strdup_printf("INSERT INTO game(game_id, session_id, player_id0, player_id1, "
+        g_snprintf(aszValues[0], sizeof(aszValues[0]), "%d", game_id);
+        g_snprintf(aszValues[1], sizeof(aszValues[1]), "%d", session_id);
+        g_snprintf(aszValues[2], sizeof(aszValues[2]), "%d", player_id0);
+        g_snprintf(aszValues[3], sizeof(aszValues[3]), "%d", player_id1);
+        g_snprintf(aszValues[4], sizeof(aszValues[4]), "%d", pmgi->anScore[0]);
+        g_snprintf(aszValues[5], sizeof(aszValues[5]), "%d", pmgi->anScore[1]);
+        g_snprintf(aszValues[6], sizeof(aszValues[6]), "%d", result);
+        g_snprintf(aszValues[7], sizeof(aszValues[7]), "%d", ++gamenum);
+        g_snprintf(aszValues[8], sizeof(aszValues[8]), "%d", pmr->g.fCrawfordGame);
+
+        if (!pdb->UpdateCommandBind("INSERT INTO game(game_id, session_id, player_id0, player_id1, "
                                     "score_0, score_1, result, added, game_number, crawford) "
-                                    "VALUES (%d, %d, %d, %d, %d, %d, %d, CURRENT_TIMESTAMP, %d, %d )",
-                                    game_id, session_id, player_id0, player_id1,
-                                    pmgi->anScore[0], pmgi->anScore[1], result, ++gamenum, pmr->g.fCrawfordGame);
-
-        if (pdb->UpdateCommand(buf)) {
-            AddStats(pdb, game_id, player_id0, 0, "gamestat", ms.nMatchTo, &(pmgi->sc));
-            AddStats(pdb, game_id, player_id1, 1, "gamestat", ms.nMatchTo, &(pmgi->sc));
-        }
-        g_free(buf);
+                                    "VALUES (?, ?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP, ?, ?)", 9, values)
+            || !AddStats(pdb, gamestat_id, game_id, player_id0, player_id1, 0, "gamestat", ms.nMatchTo,
+                         &(pmgi->sc))
+            || !AddStats(pdb, gamestat_id + 1, game_id, player_id1, player_id0, 1, "gamestat", ms.nMatchTo,
+                         &(pmgi->sc)))
+            return FALSE;
+
+        game_id++;
+        gamestat_id += 2;
         pl = pl->plNext;
     }
+    return TRUE;
 }
 
-extern void
-CommandRelationalAddMatch(char *sz)
+/* Log one analysed chequer play, pms being the position before it */
+static int
+AddPosition(DBProvider * pdb, int gameposition_id, int session_id, int game_number, int move_number,
+            int player_id, const matchstate * pms, const moverecord * pmr)
 {
-    DBProvider *pdb;
-    char *buf, *date;
-    char warnings[1024] = "";
-    int session_id, existing_id, player_id0, player_id1;
-    char *arg = NULL;
-    gboolean quiet = FALSE;
+    char aszValues[9][16];
+    char aszEquity[2][G_ASCII_DTOSTR_BUF_SIZE];
+    char szPositionID[L_POSITIONID + 1], szMatchID[L_MATCHID + 1];
+    char szMove[FORMATEDMOVESIZE];
+    const char *values[14];
+    int cube_owner = pms->fCubeOwner == -1 ? -1 : pms->fCubeOwner != pms->fMove;
+    int i;
 
-    arg = NextToken(&sz);
-    if (arg)
-        quiet = !strcmp(arg, "quiet");
+    g_strlcpy(szPositionID, PositionID((ConstTanBoard) pms->anBoard), sizeof(szPositionID));
+    g_strlcpy(szMatchID, MatchIDFromMatchState(pms), sizeof(szMatchID));
+    FormatMove(szMove, (ConstTanBoard) pms->anBoard, pmr->ml.amMoves[0].anMove);
+    g_ascii_dtostr(aszEquity[0], sizeof(aszEquity[0]), pmr->ml.amMoves[0].rScore);
+    g_ascii_dtostr(aszEquity[1], sizeof(aszEquity[1]), pmr->ml.amMoves[pmr->n.iMove].rScore);
+
+    g_snprintf(aszValues[0], sizeof(aszValues[0]), "%d", gameposition_id);
+    g_snprintf(aszValues[1], sizeof(aszValues[1]), "%d", session_id);
+    g_snprintf(aszValues[2], sizeof(aszValues[2]), "%d", game_number);
+    g_snprintf(aszValues[3], sizeof(aszValues[3]), "%d", move_number);
+    g_snprintf(aszValues[4], sizeof(aszValues[4]), "%d", player_id);
+    g_snprintf(aszValues[5], sizeof(aszValues[5]), "%u", pms->anDice[0]);
+    g_snprintf(aszValues[6], sizeof(aszValues[6]), "%u", pms->anDice[1]);
+    g_snprintf(aszValues[7], sizeof(aszValues[7]), "%d", pms->nCube);
+    g_snprintf(aszValues[8], sizeof(aszValues[8]), "%d", cube_owner);
+
+    for (i = 0; i < 5; i++)
+        values[i] = aszValues[i];
+    values[5] = szPositionID;
+    values[6] = szMatchID;
+    for (i = 5; i < 9; i++)
+        values[i + 2] = aszValues[i];
+    values[11] = szMove;
+    values[12] = aszEquity[0];
+    values[13] = aszEquity[1];
+
+    return pdb->UpdateCommandBind("INSERT INTO gameposition(gameposition_id, session_id, game_number, move_number, "
+                                  "player_id, gnubg_id, match_id, dice0, dice1, cube, cube_owner, best_move, "
+                                  "best_equity, played_equity) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                                  14, values);
+}
 
-    if (ListEmpty(&lMatch)) {
-        outputl(_("No match is being played."));
-        return;
-    }
+/* Log the analysed chequer plays of the match under the position ID
+ * of their positions, for "relational find position".  Cube decisions
+ * are not logged. */
+static int
+AddPositions(DBProvider * pdb, int session_id, int player_id0, int player_id1)
+{
+    int game_number = 0, nPositions = 0;
+    int gameposition_id;
+    listOLD *plg, *pl;
 
-    /* Warn if match is not finished or fully analysed */
-    if (!quiet && !GameOver())
-        strcat(warnings, _("The match is not finished\n"));
-    if (!quiet && !MatchAnalysed())
-        strcat(warnings, _("All of the match is not analysed\n"));
+    for (plg = lMatch.plNext; plg->p; plg = plg->plNext)
+        for (pl = ((listOLD *) plg->p)->plNext; pl->p; pl = pl->plNext) {
+            const moverecord *pmr = pl->p;
 
-    if (*warnings) {
-        strcat(warnings, _("\nAdd match anyway?"));
-        if (!GetInputYN(warnings))
-            return;
-    }
+            if (pmr->mt == MOVE_NORMAL && pmr->n.iMove < pmr->ml.cMoves)
+                nPositions++;
+        }
 
-    if ((pdb = ConnectToDB(dbProviderType)) == NULL) {
-        outputerrf(_("Error opening database"));
-        return;
+    if (!nPositions)
+        return TRUE;
+
+    if ((gameposition_id = GetNextIds(pdb, "gameposition", nPositions)) == -1)
+        return FALSE;
+
+    for (plg = lMatch.plNext; plg->p; plg = plg->plNext) {
+        listOLD *plGame = plg->p;
+        matchstate msPosition;
+        int move_number = 0;
+
+        game_number++;
+        for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
+            moverecord *pmr = pl->p;
+
+            FixMatchState(&msPosition, pmr);
+            if (pmr->mt == MOVE_NORMAL) {
+                if (pmr->fPlayer != msPosition.fMove)
+                    SwapSides(msPosition.anBoard);
+                msPosition.fTurn = msPosition.fMove = pmr->fPlayer;
+                msPosition.anDice[0] = pmr->anDice[0];
+                msPosition.anDice[1] = pmr->anDice[1];
+                move_number++;
+
+                if (pmr->n.iMove < pmr->ml.cMoves
+                    && !AddPosition(pdb, gameposition_id++, session_id, game_number, move_number,
+                                    pmr->fPlayer ? player_id1 : player_id0, &msPosition, pmr))
+                    return FALSE;
+            }
+            ApplyMoveRecord(&msPosition, plGame, pmr);
+        }
     }
+    return TRUE;
+}
+
+/* Log the current match to an open database.  The caller wraps this
+ * in a transaction, so that a failure part way leaves nothing behind. */
+static int
+RelationalAddMatch(DBProvider * pdb, gboolean quiet)
+{
+    char *buf, *date;
+    char aszValues[5][16];
+    const char *values[14];
+    int session_id, matchstat_id, existing_id, player_id0, player_id1;
+    int ret;
+
     existing_id = RelationalMatchExists(pdb);
     if (existing_id != -1) {
         char *buf2;
+        int old_id0, old_id1;
 
         if (!quiet && !GetInputYN(_("Match exists in database, overwrite?")))
-            return;
+            return FALSE;
+
+        buf = g_strdup_printf("player_id0 FROM session WHERE session_id = %d", existing_id);
+        old_id0 = RunQueryValue(pdb, buf);
+        g_free(buf);
+        buf = g_strdup_printf("player_id1 FROM session WHERE session_id = %d", existing_id);
+        old_id1 = RunQueryValue(pdb, buf);
+        g_free(buf);
 
         /* Remove any game stats and games */
         buf2 = g_strdup_printf("FROM game WHERE session_id = %d", existing_id);
@@ -458,21 +802,29 @@ CommandRelationalAddMatch(char *sz)
         g_free(buf);
         g_free(buf2);
 
-        /* Remove any match stats and session */
+        /* Remove any positions, match stats and session */
+        buf = g_strdup_printf("DELETE FROM gameposition WHERE session_id = %d", existing_id);
+        pdb->UpdateCommand(buf);
+        g_free(buf);
         buf = g_strdup_printf("DELETE FROM matchstat WHERE session_id = %d", existing_id);
         pdb->UpdateCommand(buf);
         g_free(buf);
         buf = g_strdup_printf("DELETE FROM session WHERE session_id = %d", existing_id);
         pdb->UpdateCommand(buf);
         g_free(buf);
+
+        /* the sums of the two without this session */
+        if (old_id0 != -1 && old_id1 != -1 && !RebuildPlayerStats(pdb, old_id0, old_id1))
+            return FALSE;
     }
 
-    session_id = GetNextId(pdb, "session");
+    session_id = GetNextIds(pdb, "session", 1);
+    matchstat_id = GetNextIds(pdb, "matchstat", 2);
     player_id0 = AddPlayer(pdb, ap[0].szName);
     player_id1 = AddPlayer(pdb, ap[1].szName);
-    if (session_id == -1 || player_id0 == -1 || player_id1 == -1) {
+    if (session_id == -1 || matchstat_id == -1 || player_id0 == -1 || player_id1 == -1) {
         outputl(_("Error adding match."));
-        return;
+        return FALSE;
     }
 
     if (mi.nYear)
@@ -480,27 +832,130 @@ CommandRelationalAddMatch(char *sz)
     else
         date = NULL;
 
-    buf = g_strdup_printf("INSERT INTO session(session_id, checksum, player_id0, player_id1, "
-                          "result, length, added, rating0, rating1, event, round, place, annotator, comment, date) "
-                          "VALUES (%d, '%s', %d, %d, %d, %d, CURRENT_TIMESTAMP, '%s', '%s', '%s', '%s', '%s', '%s', '%s', '%s')",
-                          session_id, GetMatchCheckSum(), player_id0, player_id1,
-                          MatchResult(ms.nMatchTo), ms.nMatchTo, NS(mi.pchRating[0]), NS(mi.pchRating[1]),
-                          NS(mi.pchEvent), NS(mi.pchRound), NS(mi.pchPlace), NS(mi.pchAnnotator), NS(mi.pchComment),
-                          NS(date));
+    g_snprintf(aszValues[0], sizeof(aszValues[0]), "%d", session_id);
+    g_snprintf(aszValues[1], sizeof(aszValues[1]), "%d", player_id0);
+    g_snprintf(aszValues[2], sizeof(aszValues[2]), "%d", player_id1);
+    g_snprintf(aszValues[3], sizeof(aszValues[3]), "%d", MatchResult(ms.nMatchTo));
+    g_snprintf(aszValues[4], sizeof(aszValues[4]), "%d", ms.nMatchTo);
+    values[0] = aszValues[0];
+    values[1] = GetMatchCheckSum();
+    values[2] = aszValues[1];
+    values[3] = aszValues[2];
+    values[4] = aszValues[3];
+    values[5] = aszValues[4];
+    values[6] = NS(mi.pchRating[0]);
+    values[7] = NS(mi.pchRating[1]);
+    values[8] = NS(mi.pchEvent);
+    values[9] = NS(mi.pchRound);
+    values[10] = NS(mi.pchPlace);
+    values[11] = NS(mi.pchAnnotator);
+    values[12] = NS(mi.pchComment);
+    values[13] = date;
 
     updateStatisticsMatch(&lMatch);
 
-    if (pdb->UpdateCommand(buf)) {
-        if (AddStats(pdb, session_id, player_id0, 0, "matchstat", ms.nMatchTo, &scMatch) &&
-            AddStats(pdb, session_id, player_id1, 1, "matchstat", ms.nMatchTo, &scMatch)) {
-            if (storeGameStats)
-                AddGames(pdb, session_id, player_id0, player_id1);
+    ret = pdb->UpdateCommandBind("INSERT INTO session(session_id, checksum, player_id0, player_id1, "
+                                 "result, length, added, rating0, rating1, event, round, place, annotator, comment, date) "
+                                 "VALUES (?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP, ?, ?, ?, ?, ?, ?, ?, ?)", 14, values)
+        && AddStats(pdb, matchstat_id, session_id, player_id0, player_id1, 0, "matchstat", ms.nMatchTo, &scMatch)
+        && AddStats(pdb, matchstat_id + 1, session_id, player_id1, player_id0, 1, "matchstat", ms.nMatchTo,
+                    &scMatch)
+        && (!storeGameStats || AddGames(pdb, session_id, player_id0, player_id1))
+        && (!storePositions || AddPositions(pdb, session_id, player_id0, player_id1));
+
+    g_free(date);
+    return ret;
+}
+
+extern void
+CommandRelationalAddMatch(char *sz)
+{
+    DBProvider *pdb;
+    char warnings[1024] = "";
+    char *arg = NULL;
+    gboolean quiet = FALSE;
+
+    arg = NextToken(&sz);
+    if (arg)
+        quiet = !strcmp(arg, "quiet");
+
+    if (ListEmpty(&lMatch)) {
+        outputl(_("No match is being played."));
+        return;
+    }
+
+    /* Warn if match is not finished or fully analysed */
+    if (!quiet && !GameOver())
+        strcat(warnings, _("The match is not finished\n"));
+    if (!quiet && !MatchAnalysed())
+        strcat(warnings, _("All of the match is not analysed\n"));
+
+    if (*warnings) {
+        strcat(warnings, _("\nAdd match anyway?"));
+        if (!GetInputYN(warnings))
+            return;
+    }
+
+    if ((pdb = ConnectToDB(dbProviderType)) == NULL) {
+        outputerrf(_("Error opening database"));
+        return;
+    }
+
+    if (pdb->BeginTransaction() && RelationalAddMatch(pdb, quiet))
+        pdb->Commit();
+    else
+        pdb->Rollback();
+
+    pdb->Disconnect();
+}
+
+extern void
+CommandRelationalAddMatches(char *sz)
+{
+    DBProvider *pdb;
+    char *pch;
+    int fConfirmNew_s = fConfirmNew;
+    int nFiles = 0, nAdded = 0;
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify the files to add (see `help relational add matches')."));
+        return;
+    }
+
+    if ((pdb = ConnectToDB(dbProviderType)) == NULL) {
+        outputerrf(_("Error opening database"));
+        return;
+    }
+
+    /* One connection and one transaction per match, instead of a
+     * commit after every statement */
+    fConfirmNew = FALSE;
+    while ((pch = NextToken(&sz)) != NULL) {
+        char *file = g_strdup_printf("\"%s\"", pch);
+
+        nFiles++;
+        g_free(szCurrentFileName);
+        szCurrentFileName = NULL;
+        CommandImportAuto(file);
+        g_free(file);
+
+        if (!szCurrentFileName || ListEmpty(&lMatch)) {
+            outputerrf(_("Failed to import `%s'"), pch);
+            continue;
+        }
+
+        if (pdb->BeginTransaction() && RelationalAddMatch(pdb, TRUE)) {
             pdb->Commit();
+            nAdded++;
+        } else {
+            pdb->Rollback();
+            outputerrf(_("Error adding `%s' to the database"), pch);
         }
     }
-    g_free(buf);
-    g_free(date);
+    fConfirmNew = fConfirmNew_s;
+
     pdb->Disconnect();
+    outputf(_("%d of %d matches added to the database.\n"), nAdded, nFiles);
 }
 
 const char *
@@ -542,6 +997,7 @@ relational_player_stats_get(const char *player0, const char *player1)
     DBProvider *pdb = NULL;
     char *query[2];
     int i;
+    char *szSums;
     statcontext *psc;
 
     g_return_val_if_fail(player0, NULL);
@@ -559,63 +1015,30 @@ relational_player_stats_get(const char *player0, const char *player1)
 
     psc = g_new0(statcontext, 1);
 
+    /* the player against everybody, or against player1, and the other
+     * side of the same sessions */
     if (!player1) {
-        query[0] = g_strdup_printf("where matchstat.player_id = %d", id0);
-        query[1] =
-            g_strdup_printf("NATURAL JOIN session WHERE "
-                            "(session.player_id0 = %d OR session.player_id1 = %d) "
-                            "AND matchstat.player_id != %d", id0, id0, id0);
+        query[0] = g_strdup_printf("WHERE player_id = %d", id0);
+        query[1] = g_strdup_printf("WHERE opponent_id = %d AND player_id != %d", id0, id0);
     } else {
-        query[0] = g_strdup_printf("NATURAL JOIN session WHERE "
-                                   "((session.player_id0 = %d OR session.player_id1 = %d) "
-                                   " AND "
-                                   " (session.player_id0 = %d OR session.player_id1 = %d))"
-                                   "AND matchstat.player_id = %d", id0, id0, id1, id1, id0);
-        query[1] =
-            g_strdup_printf("NATURAL JOIN session WHERE "
-                            "((session.player_id0 = %d OR session.player_id1 = %d) "
-                            " AND "
-                            " (session.player_id0 = %d OR session.player_id1 = %d))"
-                            "AND matchstat.player_id = %d", id0, id0, id1, id1, id1);
+        query[0] = g_strdup_printf("WHERE player_id = %d AND opponent_id = %d", id0, id1);
+        query[1] = g_strdup_printf("WHERE player_id = %d AND opponent_id = %d", id1, id0);
     }
 
+    szSums = PlayerStatColumns("SUM(%s)");
     IniStatcontext(psc);
     for (i = 0; i < 2; ++i) {
-        char *buf = g_strdup_printf("SUM(total_moves),"
-                              "SUM(unforced_moves),"
-                              "SUM(total_cube_decisions),"
-                              "SUM(close_cube_decisions),"
-                              "SUM(doubles),"
-                              "SUM(takes),"
-                              "SUM(passes),"
-                              "SUM(very_bad_moves),"
-                              "SUM(bad_moves),"
-                              "SUM(doubtful_moves),"
-                              "SUM(unmarked_moves),"
-                              "SUM(very_unlucky_rolls),"
-                              "SUM(unlucky_rolls),"
-                              "SUM(unmarked_rolls),"
-                              "SUM(lucky_rolls),"
-                              "SUM(very_lucky_rolls),"
-                              "SUM(missed_doubles_below_cp),"
-                              "SUM(missed_doubles_above_cp),"
-                              "SUM(wrong_doubles_below_dp),"
-                              "SUM(wrong_doubles_above_tg),"
-                              "SUM(wrong_takes),"
-                              "SUM(wrong_passes),"
-                              "SUM(chequer_error_total_normalised),"
-                              "SUM(error_missed_doubles_below_cp_normalised),"
-                              "SUM(error_missed_doubles_above_cp_normalised),"
-                              "SUM(error_wrong_doubles_below_dp_normalised),"
-                              "SUM(error_wrong_doubles_above_tg_normalised),"
-                              "SUM(error_wrong_takes_normalised),"
-                              "SUM(error_wrong_passes_normalised),"
-                              "SUM(luck_total_normalised)" "from matchstat " "%s", query[i]);
+        char *buf = g_strdup_printf("%s FROM playerstat %s", szSums, query[i]);
         RowSet *rs = pdb->Select(buf);
         g_free(buf);
         g_free(query[i]);
 
-        if ((!rs) || !strtol(rs->data[1][0], NULL, 0)) {
+        if ((!rs) || rs->rows < 2 || !rs->data[1][0] || !strtol(rs->data[1][0], NULL, 0)) {
+            FreeRowset(rs);
+            if (i == 0)
+                g_free(query[1]);
+            g_free(szSums);
+            g_free(psc);
             pdb->Disconnect();
             return NULL;
         }
@@ -651,6 +1074,7 @@ relational_player_stats_get(const char *player0, const char *player1)
         psc->arLuck[i][0] = (float) g_ascii_strtod(rs->data[1][29], NULL);
         FreeRowset(rs);
     }
+    g_free(szSums);
     psc->fMoves = 1;
     psc->fCube = 1;
     psc->fDice = 1;
@@ -703,6 +1127,40 @@ CommandRelationalShowPlayers(char *UNUSED(sz))
     CommandRelationalSelect("name AS Player FROM player ORDER BY name");
 }
 
+/* The plays stored for a position, by its position ID or the position
+ * part of a GNUbg ID, through the index on gameposition */
+extern void
+CommandRelationalFindPosition(char *sz)
+{
+    TanBoard anBoard;
+    char *pchID, *pch, *buf;
+
+    if (!sz || !*sz || ((pchID = NextToken(&sz)) == NULL)) {
+        outputl(_("You must specify a position ID (see `help relational find position')."));
+        return;
+    }
+    if ((pch = strchr(pchID, ':')) != NULL)
+        *pch = '\0';
+
+    if (!PositionFromID(anBoard, pchID)) {
+        outputerrf(_("Illegal position ID: %s"), pchID);
+        return;
+    }
+
+    buf = g_strdup_printf("player.name AS Player, session.event AS Event, gameposition.game_number AS Game, "
+                          "gameposition.move_number AS Move, gameposition.dice0 AS Die1, gameposition.dice1 AS Die2, "
+                          "gameposition.cube AS Cube, gameposition.cube_owner AS Owner, "
+                          "gameposition.match_id AS MatchID, gameposition.best_move AS BestMove, "
+                          "gameposition.best_equity AS Best, gameposition.played_equity AS Played "
+                          "FROM gameposition JOIN session ON gameposition.session_id = session.session_id "
+                          "JOIN player ON gameposition.player_id = player.player_id "
+                          "WHERE gameposition.gnubg_id = '%s' "
+                          "ORDER BY gameposition.session_id, gameposition.game_number, gameposition.move_number",
+                          PositionID((ConstTanBoard) anBoard));
+    CommandRelationalSelect(buf);
+    g_free(buf);
+}
+
 extern void
 CommandRelationalErase(char *sz)
 {
@@ -733,7 +1191,9 @@ CommandRelationalErase(char *sz)
     sprintf(buf, "DELETE %s", gq);
     pdb->UpdateCommand(buf);
 
-    /* Now remove any matchstats */
+    /* Now remove any positions and matchstats */
+    sprintf(buf, "DELETE FROM gameposition WHERE session_id in (select session_id %s)", mq);
+    pdb->UpdateCommand(buf);
     sprintf(buf, "DELETE FROM matchstat WHERE session_id in (select session_id %s)", mq);
     pdb->UpdateCommand(buf);
 
@@ -741,6 +1201,10 @@ CommandRelationalErase(char *sz)
     sprintf(buf, "DELETE %s", mq);
     pdb->UpdateCommand(buf);
 
+    /* and the sums of the player and the opponents */
+    sprintf(buf, "DELETE FROM playerstat WHERE player_id = %d OR opponent_id = %d", player_id, player_id);
+    pdb->UpdateCommand(buf);
+
     /* then the player */
     sprintf(buf, "DELETE FROM player WHERE player_id = %d", player_id);
     pdb->UpdateCommand(buf);
@@ -762,7 +1226,9 @@ CommandRelationalEraseAll(char *UNUSED(sz))
     if ((pdb = ConnectToDB(dbProviderType)) == NULL)
         return;
 
-    /* first remove all matchstats */
+    /* first remove all positions, matchstats and their sums */
+    pdb->UpdateCommand("DELETE FROM gameposition");
+    pdb->UpdateCommand("DELETE FROM playerstat");
     pdb->UpdateCommand("DELETE FROM matchstat");
 
     /* then remove all matches */
@@ -870,6 +1336,8 @@ CommandRelationalSetup(char *sz)
             SetDBType(apch[1]);
         if (!StrCaseCmp(apch[0], "storegamestats"))
             storeGameStats = !StrCaseCmp(apch[1], "yes");
+        else if (!StrCaseCmp(apch[0], "storepositions"))
+            storePositions = !StrCaseCmp(apch[1], "yes");
         else {
             char *pc = apch[0];
             char *db = NextTokenGeneral(&pc, "-");
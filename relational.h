@@ -24,7 +24,9 @@
 #include "analysis.h"
 #include "dbprovider.h"
 
-#define DB_VERSION 1
+#define DB_VERSION 3
+/* The oldest version ConnectToDB() upgrades to DB_VERSION */
+#define DB_VERSION_UPGRADE 1
 
 extern int RelationalUpdatePlayerDetails(const char *oldName, const char *newName, const char *newNotes);
 extern statcontext *relational_player_stats_get(const char *player0, const char *player1);
@@ -39,12 +39,24 @@
 #include "boardpos.h"
 #include "backgammon.h"
 #include "util.h"
+#include "memusage.h"
+#include "profile.h"
 
 #if defined(USE_GTK)
 #include <gtk/gtk.h>
 #include <cairo.h>
 #endif
 
+/* The blends below work on several pixels at once with SSE2 or NEON,
+ * which the compilers use by default on x86-64 and AArch64 */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BLEND_PIXELS 4
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BLEND_PIXELS 8
+#endif
+
 #if defined(USE_BOARD3D)
 #include "inc3d.h"
 #endif
@@ -128,6 +140,28 @@ int positions[2][30][3] = { {
 
 #if defined(HAVE_FREETYPE)
 static FT_Library ftl;
+static GOnce onceFreeType = G_ONCE_INIT;
+
+/* FreeType is started when the first label is drawn, see
+ * RenderInitialise() */
+static gpointer
+InitFreeType(gpointer UNUSED(p))
+{
+    guint64 t = get_time_ns();
+
+    if (FT_Init_FreeType(&ftl))
+        return NULL;
+
+    ProfileStartup(N_("Fonts"), get_time_ns() - t, TRUE);
+    return &ftl;
+}
+
+static FT_Library
+FontLibrary(void)
+{
+    g_once(&onceFreeType, InitFreeType, NULL);
+    return ftl;
+}
 #endif
 
 static renderdata rdDefault = {
@@ -218,6 +252,108 @@ iclamp(unsigned int u)
         return (unsigned char) u;
 }
 
+#if defined(BLEND_PIXELS)
+/*
+ * BlendPixels() does BLEND_PIXELS pixels of AlphaBlendBase(), or of
+ * AlphaBlend2() if fMask, with the same results as their loops:
+ * products of bytes are divided by 255 exactly, as (x + 1 + (x >> 8))
+ * >> 8 is x / 255 for any product of two bytes, and iclamp() is a
+ * saturated add.
+ */
+#if defined(__SSE2__)
+static inline __m128i
+Div255(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+/* v * a / 255 for each byte */
+static inline __m128i
+MulDiv255(__m128i v, __m128i a)
+{
+    const __m128i z = _mm_setzero_si128();
+    __m128i lo = Div255(_mm_mullo_epi16(_mm_unpacklo_epi8(v, z), _mm_unpacklo_epi8(a, z)));
+    __m128i hi = Div255(_mm_mullo_epi16(_mm_unpackhi_epi8(v, z), _mm_unpackhi_epi8(a, z)));
+
+    return _mm_packus_epi16(lo, hi);
+}
+
+/* Four RGBA pixels as four RGB pixels, in the low 12 bytes */
+static inline __m128i
+PackRGB(__m128i v)
+{
+    const __m128i m0 = _mm_setr_epi8(-1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i m1 = _mm_slli_si128(m0, 3);
+    const __m128i m2 = _mm_slli_si128(m0, 6);
+    const __m128i m3 = _mm_slli_si128(m0, 9);
+
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(v, m0), _mm_and_si128(_mm_srli_si128(v, 1), m1)),
+                        _mm_or_si128(_mm_and_si128(_mm_srli_si128(v, 2), m2), _mm_and_si128(_mm_srli_si128(v, 3), m3)));
+}
+
+/* Pixels are loaded and stored 12 bytes at a time, so as never to touch
+ * the pixels beyond them */
+static inline __m128i
+LoadRGB(const unsigned char *puch)
+{
+    int n;
+
+    memcpy(&n, puch + 8, 4);
+    return _mm_or_si128(_mm_loadl_epi64((const __m128i *) (const void *) puch),
+                        _mm_slli_si128(_mm_cvtsi32_si128(n), 8));
+}
+
+static inline void
+StoreRGB(unsigned char *puch, __m128i v)
+{
+    int n = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+
+    _mm_storel_epi64((__m128i *) (void *) puch, v);
+    memcpy(puch + 8, &n, 4);
+}
+
+static inline void
+BlendPixels(unsigned char *puchDest, const unsigned char *puchBack, const unsigned char *puchFore, int fMask)
+{
+    __m128i f = _mm_loadu_si128((const __m128i *) (const void *) puchFore);
+    __m128i a = _mm_srli_epi32(f, 24);
+    __m128i b = LoadRGB(puchBack);
+
+    /* the alpha of each pixel in its three colour bytes */
+    a = PackRGB(_mm_or_si128(_mm_or_si128(a, _mm_slli_epi32(a, 8)), _mm_slli_epi32(a, 16)));
+    f = PackRGB(f);
+
+    if (fMask)
+        StoreRGB(puchDest, _mm_adds_epu8(MulDiv255(b, _mm_xor_si128(a, _mm_set1_epi8(-1))), MulDiv255(f, a)));
+    else
+        StoreRGB(puchDest, _mm_adds_epu8(MulDiv255(b, a), f));
+}
+#else
+static inline uint8x8_t
+MulDiv255(uint8x8_t v, uint8x8_t a)
+{
+    uint16x8_t x = vmull_u8(v, a);
+
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+static inline void
+BlendPixels(unsigned char *puchDest, const unsigned char *puchBack, const unsigned char *puchFore, int fMask)
+{
+    uint8x8x4_t f = vld4_u8(puchFore);
+    uint8x8x3_t b = vld3_u8(puchBack);
+    uint8x8_t na = vmvn_u8(f.val[3]);
+    int i;
+
+    for (i = 0; i < 3; i++)
+        b.val[i] = fMask ? vqadd_u8(MulDiv255(b.val[i], na), MulDiv255(f.val[i], f.val[3]))
+            : vqadd_u8(MulDiv255(b.val[i], f.val[3]), f.val[i]);
+
+    vst3_u8(puchDest, b);
+}
+#endif
+#endif
+
 static int
 intersects(int x0, int y0, int cx0, int cy0, int x1, int y1, int cx1, int cy1)
 {
@@ -234,17 +370,9 @@ ssqrt(float x)
 extern void
 CopyArea(unsigned char *puchDest, int nDestStride, unsigned char *puchSrc, int nSrcStride, int cx, int cy)
 {
-    int x;
-
-    nDestStride -= cx * 3;
-    nSrcStride -= cx * 3;
-
+    /* the rows are contiguous, and the C library copies them fastest */
     for (; cy; cy--) {
-        for (x = cx; x; x--) {
-            *puchDest++ = *puchSrc++;
-            *puchDest++ = *puchSrc++;
-            *puchDest++ = *puchSrc++;
-        }
+        memmove(puchDest, puchSrc, (size_t) cx * 3);
         puchDest += nDestStride;
         puchSrc += nSrcStride;
     }
@@ -397,7 +525,16 @@ AlphaBlendBase(unsigned char *puchDest, int nDestStride,
     nForeStride -= cx * 4;
 
     for (; cy; cy--) {
-        for (x = cx; x; x--) {
+        x = cx;
+#if defined(BLEND_PIXELS)
+        for (; x >= BLEND_PIXELS; x -= BLEND_PIXELS) {
+            BlendPixels(puchDest, puchBack, puchFore, FALSE);
+            puchDest += BLEND_PIXELS * 3;
+            puchBack += BLEND_PIXELS * 3;
+            puchFore += BLEND_PIXELS * 4;
+        }
+#endif
+        for (; x; x--) {
             unsigned int a = puchFore[3];
 
             *puchDest++ = iclamp((*puchBack++ * a) / 0xFF + *puchFore++);
@@ -473,7 +610,16 @@ AlphaBlend2(unsigned char *puchDest, int nDestStride,
     nForeStride -= cx * 4;
 
     for (; cy; cy--) {
-        for (x = cx; x; x--) {
+        x = cx;
+#if defined(BLEND_PIXELS)
+        for (; x >= BLEND_PIXELS; x -= BLEND_PIXELS) {
+            BlendPixels(puchDest, puchBack, puchFore, TRUE);
+            puchDest += BLEND_PIXELS * 3;
+            puchBack += BLEND_PIXELS * 3;
+            puchFore += BLEND_PIXELS * 4;
+        }
+#endif
+        for (; x; x--) {
             unsigned int a = puchFore[3];
 
             *puchDest++ = iclamp((*puchBack++ * (0xFF - a)) / 0xFF + (*puchFore++ * a) / 0xFF);
@@ -549,7 +695,23 @@ RefractBlend(unsigned char *puchDest, int nDestStride,
     nRefractStride -= cx;
 
     for (; cy; cy--) {
-        for (x = cx; x; x--) {
+        x = cx;
+#if defined(BLEND_PIXELS)
+        for (; x >= BLEND_PIXELS; x -= BLEND_PIXELS) {
+            unsigned char auchBack[BLEND_PIXELS * 3];
+            int i;
+
+            /* gather the refracted background, then blend as usual */
+            for (i = 0; i < BLEND_PIXELS; i++)
+                memcpy(auchBack + i * 3, puchBack + (psRefract[i] >> 8) * nBackStride + (psRefract[i] & 0xFF) * 3, 3);
+
+            BlendPixels(puchDest, auchBack, puchFore, FALSE);
+            puchDest += BLEND_PIXELS * 3;
+            puchFore += BLEND_PIXELS * 4;
+            psRefract += BLEND_PIXELS;
+        }
+#endif
+        for (; x; x--) {
             unsigned int a = puchFore[3];
             unsigned char *puch = puchBack + (*psRefract >> 8) * nBackStride + (*psRefract & 0xFF) * 3;
 
@@ -1489,7 +1651,7 @@ RenderLabels(renderdata * prd, unsigned char *puch, int nStride, const int iStar
     char *file;
 
     file = BuildFilename(FONT_VERA);
-    if (FT_New_Face(ftl, file, 0, &ftf)) {
+    if (FT_New_Face(FontLibrary(), file, 0, &ftf)) {
         RenderBasicLabels(prd, puch, nStride, iStart, iEnd, iDelta);
         g_free(file);
         return;
@@ -1777,7 +1939,7 @@ RenderChequerLabels(renderdata * prd, unsigned char *puch, int nStride)
     char *file;
 
     file = BuildFilename(FONT_VERA);
-    if (!FT_New_Face(ftl, file, 0, &ftf) && !FT_Set_Pixel_Sizes(ftf, 0, 2 * prd->nSize)) {
+    if (!FT_New_Face(FontLibrary(), file, 0, &ftf) && !FT_Set_Pixel_Sizes(ftf, 0, 2 * prd->nSize)) {
         fFreetype = TRUE;
         for (i = 0; i < 10; i++) {
             FT_Load_Char(ftf, '0' + i, FT_LOAD_RENDER);
@@ -1946,7 +2108,7 @@ RenderCubeFaces(renderdata * prd, unsigned char *puch, int nStride, unsigned cha
     char *file;
 
     file = BuildFilename(FONT_VERA_SERIF_BOLD);
-    if (!FT_New_Face(ftl, file, 0, &ftf) && !FT_Set_Pixel_Sizes(ftf, 0, 3 * prd->nSize)) {
+    if (!FT_New_Face(FontLibrary(), file, 0, &ftf) && !FT_Set_Pixel_Sizes(ftf, 0, 3 * prd->nSize)) {
         fFreetype = TRUE;
 
         for (i = 0; i < 10; i++) {
@@ -2050,7 +2212,7 @@ RenderResignFaces(renderdata * prd, unsigned char *puch, int nStride, unsigned c
     char *file;
 
     file = BuildFilename(FONT_VERA_SERIF_BOLD);
-    if (!FT_New_Face(ftl, file, 0, &ftf) && !FT_Set_Pixel_Sizes(ftf, 0, 4 * prd->nSize)) {
+    if (!FT_New_Face(FontLibrary(), file, 0, &ftf) && !FT_Set_Pixel_Sizes(ftf, 0, 4 * prd->nSize)) {
         fFreetype = TRUE;
 
         for (i = 0; i < 10; i++) {
@@ -2625,49 +2787,270 @@ RenderBoardLabels(renderdata * prd, unsigned char *achLo, unsigned char *achHi,
 
 }
 
+/*
+ * The board, the chequer labels and the cube faces take a while to
+ * render at large sizes, and come out the same for the same size and
+ * appearance.  The last ones rendered are kept in memory, up to
+ * LAYER_CACHE_SIZE bytes, and in the folder szBoardCache if it is set,
+ * named after a digest of everything they depend on; window resizes
+ * and later sessions copy them instead of rendering them again.
+ */
+
+#define LAYER_CACHE_SIZE (64 * 1024 * 1024)
+
+typedef struct {
+    char *szKey;
+    gsize cb;
+    unsigned char *puch;
+} renderlayer;
+
+char *szBoardCache = NULL;
+
+static GMutex mutexLayers;
+static GMutex mutexRender;      /* held by RenderImages() */
+static GQueue qLayers = G_QUEUE_INIT;   /* most recently used first */
+static gsize cbLayers;
+
+/* The digest naming the layer szLayer of prd; the fields it depends
+ * on are in szFields */
+static char *
+LayerKey(const char *szLayer, const renderdata * prd, const char *szFields)
+{
+    char *szKey = g_strdup_printf("%s %s %u %d %s", VERSION, szLayer, prd->nSize,
+#if defined(HAVE_FREETYPE)
+                                  TRUE,
+#else
+                                  FALSE,
+#endif
+                                  szFields);
+    char *szDigest = g_compute_checksum_for_string(G_CHECKSUM_SHA256, szKey, -1);
+
+    g_free(szKey);
+
+    return szDigest;
+}
+
+static char *
+BoardLayerKey(const renderdata * prd)
+{
+    char *szFields = g_strdup_printf("%d %d %a %a %a "
+                                     "%u %u %u %u %u %u %u %u %u %u %u %u %u %u %u %u "
+                                     "%d %d %d %d", prd->wt, prd->fHinges,
+                                     prd->arLight[0], prd->arLight[1], prd->arLight[2],
+                                     prd->aanBoardColour[0][0], prd->aanBoardColour[0][1],
+                                     prd->aanBoardColour[0][2], prd->aanBoardColour[0][3],
+                                     prd->aanBoardColour[1][0], prd->aanBoardColour[1][1],
+                                     prd->aanBoardColour[1][2], prd->aanBoardColour[1][3],
+                                     prd->aanBoardColour[2][0], prd->aanBoardColour[2][1],
+                                     prd->aanBoardColour[2][2], prd->aanBoardColour[2][3],
+                                     prd->aanBoardColour[3][0], prd->aanBoardColour[3][1],
+                                     prd->aanBoardColour[3][2], prd->aanBoardColour[3][3],
+                                     prd->aSpeckle[0], prd->aSpeckle[1], prd->aSpeckle[2], prd->aSpeckle[3]);
+    char *szKey = LayerKey("board", prd, szFields);
+
+    g_free(szFields);
+
+    return szKey;
+}
+
+static char *
+CubeFacesLayerKey(const renderdata * prd)
+{
+    char *szFields = g_strdup_printf("%a %a %a %a %a %a %a",
+                                     prd->arLight[0], prd->arLight[1], prd->arLight[2],
+                                     prd->arCubeColour[0], prd->arCubeColour[1],
+                                     prd->arCubeColour[2], prd->arCubeColour[3]);
+    char *szKey = LayerKey("cubefaces", prd, szFields);
+
+    g_free(szFields);
+
+    return szKey;
+}
+
+static char *
+ChequerLabelsLayerKey(const renderdata * prd)
+{
+    char *szFields = g_strdup_printf("%a %a %a", prd->arLight[0], prd->arLight[1], prd->arLight[2]);
+    char *szKey = LayerKey("chequerlabels", prd, szFields);
+
+    g_free(szFields);
+
+    return szKey;
+}
+
+static void
+FreeLayer(renderlayer * prl)
+{
+    cbLayers -= prl->cb;
+    MemFree(MEM_RENDER, prl->puch, prl->cb);
+    g_free(prl->szKey);
+    g_free(prl);
+}
+
+/* Keep a copy of the cb bytes at puch as szKey, dropping the least
+ * recently used layers beyond LAYER_CACHE_SIZE.  Called with
+ * mutexLayers held. */
+static void
+KeepLayer(const char *szKey, const unsigned char *puch, gsize cb)
+{
+    renderlayer *prl = g_new(renderlayer, 1);
+
+    prl->szKey = g_strdup(szKey);
+    prl->cb = cb;
+    prl->puch = MemAlloc(MEM_RENDER, cb);
+    memcpy(prl->puch, puch, cb);
+
+    g_queue_push_head(&qLayers, prl);
+    cbLayers += cb;
+
+    while (cbLayers > LAYER_CACHE_SIZE && qLayers.length > 1)
+        FreeLayer(g_queue_pop_tail(&qLayers));
+}
+
+/* Copy the layer szKey of cb bytes to puch, from memory or from the
+ * board cache folder.  FALSE if it has not been rendered before. */
+static int
+FindLayer(const char *szKey, unsigned char *puch, gsize cb)
+{
+    GList *pl;
+    int f = FALSE;
+
+    g_mutex_lock(&mutexLayers);
+
+    for (pl = qLayers.head; pl; pl = pl->next) {
+        renderlayer *prl = pl->data;
+
+        if (prl->cb == cb && !strcmp(prl->szKey, szKey)) {
+            memcpy(puch, prl->puch, cb);
+            g_queue_unlink(&qLayers, pl);
+            g_queue_push_head_link(&qLayers, pl);
+            f = TRUE;
+            break;
+        }
+    }
+
+    if (!f && szBoardCache) {
+        char *szFile = g_build_filename(szBoardCache, szKey, NULL);
+        gchar *pch;
+        gsize cbFile;
+
+        if (g_file_get_contents(szFile, &pch, &cbFile, NULL)) {
+            if (cbFile == cb) {
+                memcpy(puch, pch, cb);
+                KeepLayer(szKey, puch, cb);
+                f = TRUE;
+            }
+            g_free(pch);
+        }
+        g_free(szFile);
+    }
+
+    g_mutex_unlock(&mutexLayers);
+
+    return f;
+}
+
+/* The layer szKey of cb bytes at puch has just been rendered */
+static void
+StoreLayer(const char *szKey, const unsigned char *puch, gsize cb)
+{
+    g_mutex_lock(&mutexLayers);
+
+    KeepLayer(szKey, puch, cb);
+
+    /* g_file_set_contents() replaces the file at once, so sessions
+     * sharing the folder never see half a layer */
+    if (szBoardCache && g_mkdir_with_parents(szBoardCache, 0755) == 0) {
+        char *szFile = g_build_filename(szBoardCache, szKey, NULL);
+
+        g_file_set_contents(szFile, (const gchar *) puch, (gssize) cb, NULL);
+        g_free(szFile);
+    }
+
+    g_mutex_unlock(&mutexLayers);
+}
+
+/* The images are counted in MEM_RENDER until FreeImages() */
+static void *
+ImageAlloc(renderimages * pri, gsize cb)
+{
+    pri->cb += cb;
+    return MemAlloc(MEM_RENDER, cb);
+}
+
+static void *
+ImageAlloc0(renderimages * pri, gsize cb)
+{
+    pri->cb += cb;
+    return MemAlloc0(MEM_RENDER, cb);
+}
+
 extern void
 RenderImages(renderdata * prd, renderimages * pri)
 {
 
     int i;
     int nSize = prd->nSize;
+    char *szKey;
+
+    pri->cb = 0;
 
     /* Initialise this one else valgrind reports
      * use of uninitialised values in libpng
      */
-    pri->ach = g_malloc0(nSize * nSize * BOARD_WIDTH * BOARD_HEIGHT * 3);
-
-    pri->achChequer[0] = g_malloc(nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 4);
-    pri->achChequer[1] = g_malloc(nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 4);
-    pri->achChequerLabels = g_malloc(nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 3 * 12);
-    pri->achDice[0] = g_malloc(nSize * nSize * DIE_WIDTH * DIE_HEIGHT * 4);
-    pri->achDice[1] = g_malloc(nSize * nSize * DIE_WIDTH * DIE_HEIGHT * 4);
-    pri->achPip[0] = g_malloc(nSize * nSize * 3);
-    pri->achPip[1] = g_malloc(nSize * nSize * 3);
-    pri->achCube = g_malloc(nSize * nSize * CUBE_WIDTH * CUBE_HEIGHT * 4);
-    pri->achCubeFaces = g_malloc(nSize * nSize * CUBE_WIDTH * CUBE_HEIGHT * 3 * 12);
-    pri->asRefract[0] = g_malloc(nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * sizeof(unsigned short));
-    pri->asRefract[1] = g_malloc(nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * sizeof(unsigned short));
-    pri->achResign = g_malloc(nSize * nSize * RESIGN_WIDTH * RESIGN_HEIGHT * 4);
-    pri->achResignFaces = g_malloc(nSize * nSize * RESIGN_WIDTH * RESIGN_HEIGHT * 3 * 3);
+    pri->ach = ImageAlloc0(pri, nSize * nSize * BOARD_WIDTH * BOARD_HEIGHT * 3);
+
+    pri->achChequer[0] = ImageAlloc(pri, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 4);
+    pri->achChequer[1] = ImageAlloc(pri, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 4);
+    pri->achChequerLabels = ImageAlloc(pri, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 3 * 12);
+    pri->achDice[0] = ImageAlloc(pri, nSize * nSize * DIE_WIDTH * DIE_HEIGHT * 4);
+    pri->achDice[1] = ImageAlloc(pri, nSize * nSize * DIE_WIDTH * DIE_HEIGHT * 4);
+    pri->achPip[0] = ImageAlloc(pri, nSize * nSize * 3);
+    pri->achPip[1] = ImageAlloc(pri, nSize * nSize * 3);
+    pri->achCube = ImageAlloc(pri, nSize * nSize * CUBE_WIDTH * CUBE_HEIGHT * 4);
+    pri->achCubeFaces = ImageAlloc(pri, nSize * nSize * CUBE_WIDTH * CUBE_HEIGHT * 3 * 12);
+    pri->asRefract[0] = ImageAlloc(pri, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * sizeof(unsigned short));
+    pri->asRefract[1] = ImageAlloc(pri, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * sizeof(unsigned short));
+    pri->achResign = ImageAlloc(pri, nSize * nSize * RESIGN_WIDTH * RESIGN_HEIGHT * 4);
+    pri->achResignFaces = ImageAlloc(pri, nSize * nSize * RESIGN_WIDTH * RESIGN_HEIGHT * 3 * 3);
 #if defined(USE_GTK)
-    pri->auchArrow[0] = g_malloc(prd->nSize * prd->nSize * ARROW_WIDTH * ARROW_HEIGHT * 4);
-    pri->auchArrow[1] = g_malloc(prd->nSize * prd->nSize * ARROW_WIDTH * ARROW_HEIGHT * 4);
+    pri->auchArrow[0] = ImageAlloc(pri, prd->nSize * prd->nSize * ARROW_WIDTH * ARROW_HEIGHT * 4);
+    pri->auchArrow[1] = ImageAlloc(pri, prd->nSize * prd->nSize * ARROW_WIDTH * ARROW_HEIGHT * 4);
 #else
     pri->auchArrow[0] = NULL;
     pri->auchArrow[1] = NULL;
 #endif
     for (i = 0; i < 2; ++i)
-        pri->achLabels[i] = g_malloc(nSize * nSize * BOARD_WIDTH * BORDER_HEIGHT * 4);
+        pri->achLabels[i] = ImageAlloc(pri, nSize * nSize * BOARD_WIDTH * BORDER_HEIGHT * 4);
 
-    RenderBoard(prd, pri->ach, BOARD_WIDTH * nSize * 3);
+    /* The textures are drawn with the shared random number generator
+     * and the labels with FreeType, neither of which may be used by two
+     * threads at once */
+    g_mutex_lock(&mutexRender);
+
+    szKey = BoardLayerKey(prd);
+    if (!FindLayer(szKey, pri->ach, nSize * nSize * BOARD_WIDTH * BOARD_HEIGHT * 3)) {
+        RenderBoard(prd, pri->ach, BOARD_WIDTH * nSize * 3);
+        StoreLayer(szKey, pri->ach, nSize * nSize * BOARD_WIDTH * BOARD_HEIGHT * 3);
+    }
+    g_free(szKey);
     RenderChequers(prd, pri->achChequer[0], pri->achChequer[1],
                    pri->asRefract[0], pri->asRefract[1], nSize * CHEQUER_WIDTH * 4);
-    RenderChequerLabels(prd, pri->achChequerLabels, nSize * CHEQUER_LABEL_WIDTH * 3);
+    szKey = ChequerLabelsLayerKey(prd);
+    if (!FindLayer(szKey, pri->achChequerLabels, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 3 * 12)) {
+        RenderChequerLabels(prd, pri->achChequerLabels, nSize * CHEQUER_LABEL_WIDTH * 3);
+        StoreLayer(szKey, pri->achChequerLabels, nSize * nSize * CHEQUER_WIDTH * CHEQUER_HEIGHT * 3 * 12);
+    }
+    g_free(szKey);
     RenderDice(prd, pri->achDice[0], pri->achDice[1], nSize * DIE_WIDTH * 4, TRUE);
     RenderPips(prd, pri->achPip[0], pri->achPip[1], nSize * 3);
     RenderCube(prd, pri->achCube, nSize * CUBE_WIDTH * 4);
-    RenderCubeFaces(prd, pri->achCubeFaces, nSize * CUBE_LABEL_WIDTH * 3, pri->achCube, nSize * CUBE_WIDTH * 4);
+    szKey = CubeFacesLayerKey(prd);
+    if (!FindLayer(szKey, pri->achCubeFaces, nSize * nSize * CUBE_WIDTH * CUBE_HEIGHT * 3 * 12)) {
+        RenderCubeFaces(prd, pri->achCubeFaces, nSize * CUBE_LABEL_WIDTH * 3, pri->achCube, nSize * CUBE_WIDTH * 4);
+        StoreLayer(szKey, pri->achCubeFaces, nSize * nSize * CUBE_WIDTH * CUBE_HEIGHT * 3 * 12);
+    }
+    g_free(szKey);
     RenderResign(prd, pri->achResign, nSize * RESIGN_WIDTH * 4);
     RenderResignFaces(prd, pri->achResignFaces, nSize * RESIGN_LABEL_WIDTH * 3,
                       pri->achResign, nSize * RESIGN_WIDTH * 4);
@@ -2678,6 +3061,7 @@ RenderImages(renderdata * prd, renderimages * pri)
 
     RenderBoardLabels(prd, pri->achLabels[0], pri->achLabels[1], BOARD_WIDTH * nSize * 4);
 
+    g_mutex_unlock(&mutexRender);
 }
 
 extern void
@@ -2706,6 +3090,9 @@ FreeImages(renderimages * pri)
 #endif
     for (i = 0; i < 2; ++i)
         g_free(pri->achLabels[i]);
+
+    MemAccount(MEM_RENDER, -(gssize) pri->cb);
+    pri->cb = 0;
 }
 
 extern void
@@ -2716,16 +3103,21 @@ RenderInitialise(void)
 
     irandinit(&rc, FALSE);
 
-#if defined(HAVE_FREETYPE)
-    FT_Init_FreeType(&ftl);
-#endif
+    /* FreeType is only started when first needed, which is never in
+     * many sessions on the command line */
 }
 
 extern void
 RenderFinalise(void)
 {
+    renderlayer *prl;
+
+    while ((prl = g_queue_pop_head(&qLayers)) != NULL)
+        FreeLayer(prl);
+
 #if defined(HAVE_FREETYPE)
-    FT_Done_FreeType(ftl);
+    if (onceFreeType.status == G_ONCE_STATUS_READY && onceFreeType.retval)
+        FT_Done_FreeType(ftl);
 #endif
 }
 
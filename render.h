@@ -99,11 +99,15 @@ typedef struct {
     unsigned short *asRefract[2];
     unsigned char *auchArrow[2];
     unsigned char *achLabels[2];
+    gsize cb;                   /* counted in MEM_RENDER, see memusage.h */
 } renderimages;
 
 extern void GrayScaleColC(unsigned char *pCols);
 extern int showingGray;
 
+/* Folder in which rendered boards are kept for later sessions, or NULL */
+extern char *szBoardCache;
+
 extern void RenderInitialise(void);
 extern void RenderFinalise(void);
 
@@ -591,14 +591,16 @@ WriteMaterialDice(renderdata * prd, int num)
 }
 
 #endif
-extern void
-SaveRenderingSettings(FILE * pf)
+
+/* The appearance prd as a "set appearance" command */
+extern char *
+RenderingSettingsString(renderdata * prd)
 {
+    GString *gs = g_string_new(NULL);
     gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
     gchar buf1[G_ASCII_DTOSTR_BUF_SIZE];
     gchar buf2[G_ASCII_DTOSTR_BUF_SIZE];
     gchar buf3[G_ASCII_DTOSTR_BUF_SIZE];
-    renderdata *prd = GetMainAppearance();
     float rElevation = asinf(prd->arLight[2]) * 180.0f / F_PI;
     float rAzimuth = (fabsf(prd->arLight[2] - 1.0f) < 1e-5f) ? 0.0f :
         acosf(prd->arLight[0] / sqrtf(1.0f - prd->arLight[2] * prd->arLight[2])) * 180.0f / F_PI;
@@ -607,117 +609,132 @@ SaveRenderingSettings(FILE * pf)
         rAzimuth = 360 - rAzimuth;
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", (float) prd->aSpeckle[0] / 128.0f);
-    fprintf(pf, "set appearance board=#%02X%02X%02X;%s ",
-            prd->aanBoardColour[0][0], prd->aanBoardColour[0][1], prd->aanBoardColour[0][2], buf);
+    g_string_append_printf(gs, "set appearance board=#%02X%02X%02X;%s ",
+                           prd->aanBoardColour[0][0], prd->aanBoardColour[0][1], prd->aanBoardColour[0][2], buf);
 
-    fprintf(pf, "border=#%02X%02X%02X ", prd->aanBoardColour[1][0],
-            prd->aanBoardColour[1][1], prd->aanBoardColour[1][2]);
-    fprintf(pf, "moveindicator=%c ", prd->showMoveIndicator ? 'y' : 'n');
+    g_string_append_printf(gs, "border=#%02X%02X%02X ", prd->aanBoardColour[1][0],
+                           prd->aanBoardColour[1][1], prd->aanBoardColour[1][2]);
+    g_string_append_printf(gs, "moveindicator=%c ", prd->showMoveIndicator ? 'y' : 'n');
 
 #if defined(USE_BOARD3D)
-    fprintf(pf, "boardtype=%c ", display_is_2d(prd) ? '2' : '3');
-    fprintf(pf, "hinges3d=%c ", prd->fHinges3d ? 'y' : 'n');
-    fprintf(pf, "boardshadows=%c ", prd->showShadows ? 'y' : 'n');
-    fprintf(pf, "shadowdarkness=%d ", prd->shadowDarkness);
-    fprintf(pf, "animateroll=%c ", prd->animateRoll ? 'y' : 'n');
-    fprintf(pf, "animateflag=%c ", prd->animateFlag ? 'y' : 'n');
-    fprintf(pf, "curveaccuracy=%u ", prd->curveAccuracy);
-    fprintf(pf, "lighttype=%c ", prd->lightType == LT_POSITIONAL ? 'p' : 'd');
+    g_string_append_printf(gs, "boardtype=%c ", display_is_2d(prd) ? '2' : '3');
+    g_string_append_printf(gs, "hinges3d=%c ", prd->fHinges3d ? 'y' : 'n');
+    g_string_append_printf(gs, "boardshadows=%c ", prd->showShadows ? 'y' : 'n');
+    g_string_append_printf(gs, "shadowdarkness=%d ", prd->shadowDarkness);
+    g_string_append_printf(gs, "animateroll=%c ", prd->animateRoll ? 'y' : 'n');
+    g_string_append_printf(gs, "animateflag=%c ", prd->animateFlag ? 'y' : 'n');
+    g_string_append_printf(gs, "curveaccuracy=%u ", prd->curveAccuracy);
+    g_string_append_printf(gs, "lighttype=%c ", prd->lightType == LT_POSITIONAL ? 'p' : 'd');
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->lightPos[0]);
-    fprintf(pf, "lightposx=%s ", buf);
+    g_string_append_printf(gs, "lightposx=%s ", buf);
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->lightPos[1]);
-    fprintf(pf, "lightposy=%s ", buf);
+    g_string_append_printf(gs, "lightposy=%s ", buf);
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->lightPos[2]);
-    fprintf(pf, "lightposz=%s ", buf);
-    fprintf(pf, "lightambient=%d ", prd->lightLevels[0]);
-    fprintf(pf, "lightdiffuse=%d ", prd->lightLevels[1]);
-    fprintf(pf, "lightspecular=%d ", prd->lightLevels[2]);
-    fprintf(pf, "boardangle=%.0f ", prd->boardAngle);
-    fprintf(pf, "skewfactor=%.0f ", prd->skewFactor);
-    fprintf(pf, "planview=%c ", prd->planView ? 'y' : 'n');
+    g_string_append_printf(gs, "lightposz=%s ", buf);
+    g_string_append_printf(gs, "lightambient=%d ", prd->lightLevels[0]);
+    g_string_append_printf(gs, "lightdiffuse=%d ", prd->lightLevels[1]);
+    g_string_append_printf(gs, "lightspecular=%d ", prd->lightLevels[2]);
+    g_string_append_printf(gs, "boardangle=%.0f ", prd->boardAngle);
+    g_string_append_printf(gs, "skewfactor=%.0f ", prd->skewFactor);
+    g_string_append_printf(gs, "planview=%c ", prd->planView ? 'y' : 'n');
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->diceSize);
-    fprintf(pf, "dicesize=%s ", buf);
-
-    fprintf(pf, "roundededges=%c ", prd->roundedEdges ? 'y' : 'n');
-    fprintf(pf, "bgintrays=%c ", prd->bgInTrays ? 'y' : 'n');
-    fprintf(pf, "roundedpoints=%c ", prd->roundedPoints ? 'y' : 'n');
-    fprintf(pf, "piecetype=%d ", prd->pieceType);
-    fprintf(pf, "piecetexturetype=%d ", prd->pieceTextureType);
-    fprintf(pf, "chequers3d0=%s ", WriteMaterial(&prd->ChequerMat[0]));
-    fprintf(pf, "chequers3d1=%s ", WriteMaterial(&prd->ChequerMat[1]));
-    fprintf(pf, "dice3d0=%s ", WriteMaterialDice(prd, 0));
-    fprintf(pf, "dice3d1=%s ", WriteMaterialDice(prd, 1));
-    fprintf(pf, "dot3d0=%s ", WriteMaterial(&prd->DiceDotMat[0]));
-    fprintf(pf, "dot3d1=%s ", WriteMaterial(&prd->DiceDotMat[1]));
-    fprintf(pf, "cube3d=%s ", WriteMaterial(&prd->CubeMat));
-    fprintf(pf, "cubetext3d=%s ", WriteMaterial(&prd->CubeNumberMat));
-    fprintf(pf, "base3d=%s ", WriteMaterial(&prd->BaseMat));
-    fprintf(pf, "points3d0=%s ", WriteMaterial(&prd->PointMat[0]));
-    fprintf(pf, "points3d1=%s ", WriteMaterial(&prd->PointMat[1]));
-    fprintf(pf, "border3d=%s ", WriteMaterial(&prd->BoxMat));
-    fprintf(pf, "hinge3d=%s ", WriteMaterial(&prd->HingeMat));
-    fprintf(pf, "numbers3d=%s ", WriteMaterial(&prd->PointNumberMat));
-    fprintf(pf, "background3d=%s ", WriteMaterial(&prd->BackGroundMat));
+    g_string_append_printf(gs, "dicesize=%s ", buf);
+
+    g_string_append_printf(gs, "roundededges=%c ", prd->roundedEdges ? 'y' : 'n');
+    g_string_append_printf(gs, "bgintrays=%c ", prd->bgInTrays ? 'y' : 'n');
+    g_string_append_printf(gs, "roundedpoints=%c ", prd->roundedPoints ? 'y' : 'n');
+    g_string_append_printf(gs, "piecetype=%d ", prd->pieceType);
+    g_string_append_printf(gs, "piecetexturetype=%d ", prd->pieceTextureType);
+    g_string_append_printf(gs, "chequers3d0=%s ", WriteMaterial(&prd->ChequerMat[0]));
+    g_string_append_printf(gs, "chequers3d1=%s ", WriteMaterial(&prd->ChequerMat[1]));
+    g_string_append_printf(gs, "dice3d0=%s ", WriteMaterialDice(prd, 0));
+    g_string_append_printf(gs, "dice3d1=%s ", WriteMaterialDice(prd, 1));
+    g_string_append_printf(gs, "dot3d0=%s ", WriteMaterial(&prd->DiceDotMat[0]));
+    g_string_append_printf(gs, "dot3d1=%s ", WriteMaterial(&prd->DiceDotMat[1]));
+    g_string_append_printf(gs, "cube3d=%s ", WriteMaterial(&prd->CubeMat));
+    g_string_append_printf(gs, "cubetext3d=%s ", WriteMaterial(&prd->CubeNumberMat));
+    g_string_append_printf(gs, "base3d=%s ", WriteMaterial(&prd->BaseMat));
+    g_string_append_printf(gs, "points3d0=%s ", WriteMaterial(&prd->PointMat[0]));
+    g_string_append_printf(gs, "points3d1=%s ", WriteMaterial(&prd->PointMat[1]));
+    g_string_append_printf(gs, "border3d=%s ", WriteMaterial(&prd->BoxMat));
+    g_string_append_printf(gs, "hinge3d=%s ", WriteMaterial(&prd->HingeMat));
+    g_string_append_printf(gs, "numbers3d=%s ", WriteMaterial(&prd->PointNumberMat));
+    g_string_append_printf(gs, "background3d=%s ", WriteMaterial(&prd->BackGroundMat));
 #endif
-    fprintf(pf, "labels=%c ", prd->fLabels ? 'y' : 'n');
-    fprintf(pf, "dynamiclabels=%c ", prd->fDynamicLabels ? 'y' : 'n');
-    fprintf(pf, "wood=%s ", aszWoodName[prd->wt]);
-    fprintf(pf, "hinges=%c ", prd->fHinges ? 'y' : 'n');
+    g_string_append_printf(gs, "labels=%c ", prd->fLabels ? 'y' : 'n');
+    g_string_append_printf(gs, "dynamiclabels=%c ", prd->fDynamicLabels ? 'y' : 'n');
+    g_string_append_printf(gs, "wood=%s ", aszWoodName[prd->wt]);
+    g_string_append_printf(gs, "hinges=%c ", prd->fHinges ? 'y' : 'n');
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.1f", rAzimuth);
     g_ascii_formatd(buf1, G_ASCII_DTOSTR_BUF_SIZE, "%.1f", rElevation);
-    fprintf(pf, "light=%s;%s ", buf, buf1);
+    g_string_append_printf(gs, "light=%s;%s ", buf, buf1);
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%0.1f", (1.0f - prd->rRound));
-    fprintf(pf, "shape=%s ", buf);
+    g_string_append_printf(gs, "shape=%s ", buf);
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->aarColour[0][3]);
     g_ascii_formatd(buf1, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arRefraction[0]);
     g_ascii_formatd(buf2, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arCoefficient[0]);
     g_ascii_formatd(buf3, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arExponent[0]);
-    fprintf(pf, "chequers0=#%02X%02X%02X;%s;%s;%s;%s ",
-            (int) (prd->aarColour[0][0] * 0xFF),
-            (int) (prd->aarColour[0][1] * 0xFF), (int) (prd->aarColour[0][2] * 0xFF), buf, buf1, buf2, buf3);
+    g_string_append_printf(gs, "chequers0=#%02X%02X%02X;%s;%s;%s;%s ",
+                           (int) (prd->aarColour[0][0] * 0xFF),
+                           (int) (prd->aarColour[0][1] * 0xFF), (int) (prd->aarColour[0][2] * 0xFF), buf, buf1, buf2, buf3);
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->aarColour[1][3]);
     g_ascii_formatd(buf1, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arRefraction[1]);
     g_ascii_formatd(buf2, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arCoefficient[1]);
     g_ascii_formatd(buf3, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arExponent[1]);
-    fprintf(pf, "chequers1=#%02X%02X%02X;%s;%s;%s;%s ",
-            (int) (prd->aarColour[1][0] * 0xFF),
-            (int) (prd->aarColour[1][1] * 0xFF), (int) (prd->aarColour[1][2] * 0xFF), buf, buf1, buf2, buf3);
+    g_string_append_printf(gs, "chequers1=#%02X%02X%02X;%s;%s;%s;%s ",
+                           (int) (prd->aarColour[1][0] * 0xFF),
+                           (int) (prd->aarColour[1][1] * 0xFF), (int) (prd->aarColour[1][2] * 0xFF), buf, buf1, buf2, buf3);
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arDiceCoefficient[0]);
     g_ascii_formatd(buf1, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arDiceExponent[0]);
-    fprintf(pf, "dice0=#%02X%02X%02X;%s;%s;%c ",
-            (int) (prd->aarDiceColour[0][0] * 0xFF),
-            (int) (prd->aarDiceColour[0][1] * 0xFF),
-            (int) (prd->aarDiceColour[0][2] * 0xFF), buf, buf1, prd->afDieColour[0] ? 'y' : 'n');
+    g_string_append_printf(gs, "dice0=#%02X%02X%02X;%s;%s;%c ",
+                           (int) (prd->aarDiceColour[0][0] * 0xFF),
+                           (int) (prd->aarDiceColour[0][1] * 0xFF),
+                           (int) (prd->aarDiceColour[0][2] * 0xFF), buf, buf1, prd->afDieColour[0] ? 'y' : 'n');
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arDiceCoefficient[1]);
     g_ascii_formatd(buf1, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->arDiceExponent[1]);
-    fprintf(pf, "dice1=#%02X%02X%02X;%s;%s;%c ",
-            (int) (prd->aarDiceColour[1][0] * 0xFF),
-            (int) (prd->aarDiceColour[1][1] * 0xFF),
-            (int) (prd->aarDiceColour[1][2] * 0xFF), buf, buf1, prd->afDieColour[1] ? 'y' : 'n');
-
-    fprintf(pf, "dot0=#%02X%02X%02X ",
-            (int) (prd->aarDiceDotColour[0][0] * 0xFF),
-            (int) (prd->aarDiceDotColour[0][1] * 0xFF), (int) (prd->aarDiceDotColour[0][2] * 0xFF));
-    fprintf(pf, "dot1=#%02X%02X%02X ",
-            (int) (prd->aarDiceDotColour[1][0] * 0xFF),
-            (int) (prd->aarDiceDotColour[1][1] * 0xFF), (int) (prd->aarDiceDotColour[1][2] * 0xFF));
-    fprintf(pf, "cube=#%02X%02X%02X ", (int) (prd->arCubeColour[0] * 0xFF),
-            (int) (prd->arCubeColour[1] * 0xFF), (int) (prd->arCubeColour[2] * 0xFF));
+    g_string_append_printf(gs, "dice1=#%02X%02X%02X;%s;%s;%c ",
+                           (int) (prd->aarDiceColour[1][0] * 0xFF),
+                           (int) (prd->aarDiceColour[1][1] * 0xFF),
+                           (int) (prd->aarDiceColour[1][2] * 0xFF), buf, buf1, prd->afDieColour[1] ? 'y' : 'n');
+
+    g_string_append_printf(gs, "dot0=#%02X%02X%02X ",
+                           (int) (prd->aarDiceDotColour[0][0] * 0xFF),
+                           (int) (prd->aarDiceDotColour[0][1] * 0xFF), (int) (prd->aarDiceDotColour[0][2] * 0xFF));
+    g_string_append_printf(gs, "dot1=#%02X%02X%02X ",
+                           (int) (prd->aarDiceDotColour[1][0] * 0xFF),
+                           (int) (prd->aarDiceDotColour[1][1] * 0xFF), (int) (prd->aarDiceDotColour[1][2] * 0xFF));
+    g_string_append_printf(gs, "cube=#%02X%02X%02X ", (int) (prd->arCubeColour[0] * 0xFF),
+                           (int) (prd->arCubeColour[1] * 0xFF), (int) (prd->arCubeColour[2] * 0xFF));
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->aSpeckle[2] / 128.0);
-    fprintf(pf, "points0=#%02X%02X%02X;%s ", prd->aanBoardColour[2][0],
-            prd->aanBoardColour[2][1], prd->aanBoardColour[2][2], buf);
+    g_string_append_printf(gs, "points0=#%02X%02X%02X;%s ", prd->aanBoardColour[2][0],
+                           prd->aanBoardColour[2][1], prd->aanBoardColour[2][2], buf);
 
     g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.2f", prd->aSpeckle[3] / 128.0);
-    fprintf(pf, "points1=#%02X%02X%02X;%s\n", prd->aanBoardColour[3][0],
-            prd->aanBoardColour[3][1], prd->aanBoardColour[3][2], buf);
+    g_string_append_printf(gs, "points1=#%02X%02X%02X;%s\n", prd->aanBoardColour[3][0],
+                           prd->aanBoardColour[3][1], prd->aanBoardColour[3][2], buf);
 
+    return g_string_free(gs, FALSE);
+}
+
+extern void
+SaveRenderingSettings(FILE * pf)
+{
+    char *sz = RenderingSettingsString(GetMainAppearance());
+
+    fputs(sz, pf);
+    g_free(sz);
+
+    if (szBoardCache)
+        fprintf(pf, "set boardcache \"%s\"\n", szBoardCache);
+    else
+        fputs("set boardcache off\n", pf);
 }
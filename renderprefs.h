@@ -30,6 +30,7 @@ extern renderdata *GetMainAppearance(void);
 extern void CopyAppearance(renderdata * prd);
 
 extern void RenderPreferencesParam(renderdata * prd, const char *szParam, char *szValue);
+extern char *RenderingSettingsString(renderdata * prd);
 extern void SaveRenderingSettings(FILE * pf);
 
 #if defined(USE_BOARD3D)
@@ -27,6 +27,9 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <time.h>
+#if defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
 
 #include "backgammon.h"
 #if defined(USE_GTK)
@@ -36,7 +39,9 @@
 #include "positionid.h"
 #include "format.h"
 #include "multithread.h"
+#include "memusage.h"
 #include "rollout.h"
+#include "rolloutworker.h"
 #include "lib/simd.h"
 
 #define LogCubeClamped(n) (n < (1 << STAT_MAXCUBE) ? LogCube(n) : (STAT_MAXCUBE - 1))
@@ -48,74 +53,175 @@ f_BasicCubefulRollout BasicCubefulRollout = BasicCubefulRolloutNoLocking;
 
 int log_rollouts = 0;
 char *log_file_name = 0;
+unsigned int cRolloutLockstep = 1;
+char *szRolloutCheckpoint = NULL;
+char *szRolloutProgressLog = NULL;
+/* the means of QuickVarRedn() */
+cubefulCache ccVarRedn;
 static unsigned int initial_game_count;
 
 /* make sgf files of rollouts if log_rollouts is true and we have a file 
  * name template to work with
  */
 
+/* With fRolloutLogStream the games go to the single file
+ * <log_file_name>.rlog instead of a file each.  There a game is a line
+ * "game <trial> <move> <bytes>", its .sgf text and a newline.  The
+ * rollout threads collect their games in buffers of about
+ * ROLLOUT_LOG_BUFFER bytes and a thread of its own writes them. */
+#define ROLLOUT_LOG_BUFFER (64 * 1024)
+#define ROLLOUT_LOG_SUFFIX ".rlog"
+
+int fRolloutLogStream = FALSE;
+static FILE *pfRolloutLog;
+#if defined(USE_MULTITHREAD)
+static GAsyncQueue *pqRolloutLog;
+static GThread *ptRolloutLog;
+/* pushed to stop the writer */
+static GString gsRolloutLogEnd;
+
+static gpointer
+RolloutLogWriter(gpointer UNUSED(p))
+{
+    GString *pgs;
+
+    while ((pgs = (GString *) g_async_queue_pop(pqRolloutLog)) != &gsRolloutLogEnd) {
+        fwrite(pgs->str, 1, pgs->len, pfRolloutLog);
+        g_string_free(pgs, TRUE);
+    }
+
+    return NULL;
+}
+#endif
+
+static int
+RolloutLogOpen(void)
+{
+    char *sz = g_strconcat(log_file_name, ROLLOUT_LOG_SUFFIX, NULL);
+
+    if ((pfRolloutLog = g_fopen(sz, "ab")) == NULL) {
+        outputerr(sz);
+        g_free(sz);
+        return -1;
+    }
+
+    g_free(sz);
+
+#if defined(USE_MULTITHREAD)
+    pqRolloutLog = g_async_queue_new();
+    /* without it the rollout threads write themselves */
+    ptRolloutLog = g_thread_try_new("rollout log", RolloutLogWriter, NULL, NULL);
+#endif
+
+    return 0;
+}
+
+/* Write and free a buffer of games */
+static void
+RolloutLogWrite(GString * pgs)
+{
+#if defined(USE_MULTITHREAD)
+    if (ptRolloutLog) {
+        g_async_queue_push(pqRolloutLog, pgs);
+        return;
+    }
+
+    multi_debug("exclusive lock: rollout log");
+    MT_Lock(MT_LOCK_ROLLOUT);
+#endif
+
+    fwrite(pgs->str, 1, pgs->len, pfRolloutLog);
+
+#if defined(USE_MULTITHREAD)
+    MT_Unlock(MT_LOCK_ROLLOUT);
+    multi_debug("exclusive release: rollout log");
+#endif
+
+    g_string_free(pgs, TRUE);
+}
+
+static void
+RolloutLogClose(void)
+{
+#if defined(USE_MULTITHREAD)
+    if (ptRolloutLog) {
+        g_async_queue_push(pqRolloutLog, &gsRolloutLogEnd);
+        g_thread_join(ptRolloutLog);
+        ptRolloutLog = NULL;
+    }
+
+    g_async_queue_unref(pqRolloutLog);
+    pqRolloutLog = NULL;
+#endif
+
+    if (fclose(pfRolloutLog))
+        outputerr(log_file_name);
+
+    pfRolloutLog = NULL;
+}
+
 extern void
-log_cube(FILE * logfp, const char *action, int side)
+log_cube(GString * pgsLog, const char *action, int side)
 {
-    if (!logfp)
+    if (!pgsLog)
         return;
-    fprintf(logfp, ";%s[%s]\n", side ? "B" : "W", action);
+    g_string_append_printf(pgsLog, ";%s[%s]\n", side ? "B" : "W", action);
 }
 
 extern void
-log_move(FILE * logfp, const int *anMove, int side, int die0, int die1)
+log_move(GString * pgsLog, const int *anMove, int side, int die0, int die1)
 {
     int i;
-    if (!logfp)
+    if (!pgsLog)
         return;
 
-    fprintf(logfp, ";%s[%d%d", side ? "B" : "W", die0, die1);
+    g_string_append_printf(pgsLog, ";%s[%d%d", side ? "B" : "W", die0, die1);
 
     for (i = 0; i < 8; i += 2) {
         if (anMove[i] < 0)
             break;
 
         if (anMove[i] > 23)
-            fprintf(logfp, "y");
+            g_string_append_c(pgsLog, 'y');
         else if (!side)
-            fprintf(logfp, "%c", 'a' + anMove[i]);
+            g_string_append_c(pgsLog, (char) ('a' + anMove[i]));
         else
-            fprintf(logfp, "%c", 'x' - anMove[i]);
+            g_string_append_c(pgsLog, (char) ('x' - anMove[i]));
 
         if (anMove[i + 1] < 0)
-            fprintf(logfp, "z");
+            g_string_append_c(pgsLog, 'z');
         else if (!side)
-            fprintf(logfp, "%c", 'a' + anMove[i + 1]);
+            g_string_append_c(pgsLog, (char) ('a' + anMove[i + 1]));
         else
-            fprintf(logfp, "%c", 'x' - anMove[i + 1]);
+            g_string_append_c(pgsLog, (char) ('x' - anMove[i + 1]));
 
     }
 
-    fprintf(logfp, "%s", "]\n");
+    g_string_append(pgsLog, "]\n");
 
 }
 
 static void
-board_to_sgf(FILE * logfp, const unsigned int anBoard[25], int direction)
+board_to_sgf(GString * pgsLog, const unsigned int anBoard[25], int direction)
 {
     unsigned int i, j;
     int c = direction > 0 ? 'a' : 'x';
-    if (!logfp)
+    if (!pgsLog)
         return;
 
     for (i = 0; i < 24; ++i) {
         for (j = 0; j < anBoard[i]; ++j)
-            fprintf(logfp, "[%c]", c);
+            g_string_append_printf(pgsLog, "[%c]", c);
 
         c += direction;
     }
 
     for (j = 0; j < anBoard[24]; ++j)
-        fprintf(logfp, "[y]");
+        g_string_append(pgsLog, "[y]");
 }
 
-static FILE *
-log_game_start(const char *name, const cubeinfo * pci, int fCubeful, TanBoard anBoard)
+static GString *
+log_game_start(const cubeinfo * pci, int fCubeful, TanBoard anBoard)
 {
     time_t t = time(0);
 #if defined(USE_MULTITHREAD) && defined(HAVE_LOCALTIME_R)
@@ -123,7 +229,7 @@ log_game_start(const char *name, const cubeinfo * pci, int fCubeful, TanBoard an
 #endif
     struct tm *now;
     const char *rule;
-    FILE *logfp = NULL;
+    GString *pgsLog;
 
 #if defined(USE_MULTITHREAD) && defined(HAVE_LOCALTIME_R)
     localtime_r(&t, &result);
@@ -150,40 +256,237 @@ log_game_start(const char *name, const cubeinfo * pci, int fCubeful, TanBoard an
         }
     }
 
-    if ((logfp = g_fopen(name, "w")) == 0)
-        return NULL;
+    pgsLog = g_string_sized_new(1024);
 
-    fprintf(logfp, "(;FF[4]GM[6]CA[UTF-8]AP[GNU Backgammon:%s]MI"
-            "[length:%d][game:0][ws:%d][bs:%d][wtime:0][btime:0]"
-            "[wtimeouts:0][btimeouts:0]PW[White]PB[Black]DT[%d-%02d-%02d]"
-            "%s\n", VERSION, pci->nMatchTo, pci->anScore[0], pci->anScore[1],
-            1900 + now->tm_year, 1 + now->tm_mon, now->tm_mday, rule);
+    g_string_append_printf(pgsLog, "(;FF[4]GM[6]CA[UTF-8]AP[GNU Backgammon:%s]MI"
+                           "[length:%d][game:0][ws:%d][bs:%d][wtime:0][btime:0]"
+                           "[wtimeouts:0][btimeouts:0]PW[White]PB[Black]DT[%d-%02d-%02d]"
+                           "%s\n", VERSION, pci->nMatchTo, pci->anScore[0], pci->anScore[1],
+                           1900 + now->tm_year, 1 + now->tm_mon, now->tm_mday, rule);
 
     /* set the rest of the things up */
-    fprintf(logfp, ";PL[%s]\n", pci->fMove ? "B" : "W");
-    fprintf(logfp, ";CP[%s]\n", pci->fCubeOwner == 0 ? "w" : pci->fCubeOwner == 1 ? "b" : "c");
-    fprintf(logfp, ";CV[%d]\n", pci->nCube);
-    fprintf(logfp, ";AE[a:y]AW");
+    g_string_append_printf(pgsLog, ";PL[%s]\n", pci->fMove ? "B" : "W");
+    g_string_append_printf(pgsLog, ";CP[%s]\n", pci->fCubeOwner == 0 ? "w" : pci->fCubeOwner == 1 ? "b" : "c");
+    g_string_append_printf(pgsLog, ";CV[%d]\n", pci->nCube);
+    g_string_append(pgsLog, ";AE[a:y]AW");
     if (!pci->fMove) {
-        board_to_sgf(logfp, anBoard[1], 1);
-        fprintf(logfp, "AB");
-        board_to_sgf(logfp, anBoard[0], -1);
+        board_to_sgf(pgsLog, anBoard[1], 1);
+        g_string_append(pgsLog, "AB");
+        board_to_sgf(pgsLog, anBoard[0], -1);
     } else {
-        board_to_sgf(logfp, anBoard[0], 1);
-        fprintf(logfp, "AB");
-        board_to_sgf(logfp, anBoard[1], -1);
+        board_to_sgf(pgsLog, anBoard[0], 1);
+        g_string_append(pgsLog, "AB");
+        board_to_sgf(pgsLog, anBoard[1], -1);
     }
-    fprintf(logfp, "\n");
-    return logfp;
+    g_string_append_c(pgsLog, '\n');
+    return pgsLog;
 }
 
+/* Write the game of trial iTrial of move iAlt to its .sgf file, or
+ * add it to the buffer *ppgsBuffer of the rollout log and write that
+ * when it is full */
 static void
-log_game_over(FILE * logfp)
+log_game_over(GString * pgsLog, int iTrial, int iAlt, GString ** ppgsBuffer)
 {
-    if (!logfp)
+    if (!pgsLog)
         return;
-    fprintf(logfp, ")");
-    fclose(logfp);
+
+    g_string_append_c(pgsLog, ')');
+
+    if (pfRolloutLog) {
+        if (!*ppgsBuffer)
+            *ppgsBuffer = g_string_sized_new(ROLLOUT_LOG_BUFFER + 4096);
+
+        g_string_append_printf(*ppgsBuffer, "game %d %c %lu\n", iTrial, 'a' + iAlt, (unsigned long) pgsLog->len);
+        g_string_append_len(*ppgsBuffer, pgsLog->str, (gssize) pgsLog->len);
+        g_string_append_c(*ppgsBuffer, '\n');
+
+        if ((*ppgsBuffer)->len >= ROLLOUT_LOG_BUFFER) {
+            RolloutLogWrite(*ppgsBuffer);
+            *ppgsBuffer = NULL;
+        }
+    } else {
+        char *sz = g_strdup_printf("%s-%7.7d-%c.sgf", log_file_name, iTrial, iAlt + 'a');
+
+        g_file_set_contents(sz, pgsLog->str, (gssize) pgsLog->len, NULL);
+        g_free(sz);
+    }
+
+    g_string_free(pgsLog, TRUE);
+}
+
+/* Write the games of trial iTrial (all of them if negative) of move
+ * iAlt (all if negative) in the rollout log szLog to the .sgf files
+ * the rollout would have written without fRolloutLogStream.  Returns
+ * the number of games written, or -1 if the log is cut short or a file
+ * can't be written. */
+extern int
+RolloutLogExtract(const char *szLog, int iTrial, int iAlt)
+{
+    FILE *pf = g_fopen(szLog, "rb");
+    char *szBase;
+    char sz[64];
+    int n = 0;
+
+    if (!pf)
+        return -1;
+
+    szBase = g_strdup(szLog);
+    if (g_str_has_suffix(szBase, ROLLOUT_LOG_SUFFIX))
+        szBase[strlen(szBase) - strlen(ROLLOUT_LOG_SUFFIX)] = 0;
+
+    while (fgets(sz, sizeof(sz), pf)) {
+        int trial;
+        char c;
+        unsigned long cb;
+
+        if (sscanf(sz, "game %d %c %lu", &trial, &c, &cb) != 3) {
+            n = -1;
+            break;
+        }
+
+        if ((iTrial < 0 || trial == iTrial) && (iAlt < 0 || c - 'a' == iAlt)) {
+            char *pch = g_malloc(cb);
+            char *szFile = g_strdup_printf("%s-%7.7d-%c.sgf", szBase, trial, c);
+            int f = fread(pch, 1, cb, pf) == cb && g_file_set_contents(szFile, pch, (gssize) cb, NULL);
+
+            g_free(szFile);
+            g_free(pch);
+
+            if (!f) {
+                n = -1;
+                break;
+            }
+
+            n++;
+        } else if (fseek(pf, (long) cb, SEEK_CUR)) {
+            n = -1;
+            break;
+        }
+
+        if (getc(pf) != '\n') {
+            n = -1;
+            break;
+        }
+    }
+
+    fclose(pf);
+    g_free(szBase);
+
+    return n;
+}
+
+/* a * b modulo the polynomial p of degree d over GF(2) */
+static unsigned int
+PolyMulMod(unsigned int a, unsigned int b, unsigned int p, unsigned int d)
+{
+    unsigned int r = 0;
+
+    for (; b; b >>= 1) {
+        if (b & 1)
+            r ^= a;
+        a <<= 1;
+        if (a >> d & 1)
+            a ^= p;
+    }
+
+    return r;
+}
+
+/* x^e modulo p */
+static unsigned int
+PolyPowMod(unsigned int e, unsigned int p, unsigned int d)
+{
+    unsigned int r = 1, a = d > 1 ? 2 : 2 ^ p;
+
+    for (; e; e >>= 1) {
+        if (e & 1)
+            r = PolyMulMod(r, a, p, d);
+        a = PolyMulMod(a, a, p, d);
+    }
+
+    return r;
+}
+
+/* Is p of degree d primitive, that is, is the order of x 2^d - 1? */
+static int
+PolyPrimitive(unsigned int p, unsigned int d)
+{
+    unsigned int n = (1u << d) - 1, m = n, q;
+
+    if (PolyPowMod(n, p, d) != 1)
+        return FALSE;
+
+    /* no x^(n/q) may be 1 for a prime factor q of n */
+    for (q = 2; m > 1; q++)
+        if (m % q == 0) {
+            if (PolyPowMod(n / q, p, d) == 1)
+                return FALSE;
+            while (m % q == 0)
+                m /= q;
+        }
+
+    return TRUE;
+}
+
+/* The direction numbers of the first QRLEN dimensions of a Sobol
+ * sequence.  The first is the van der Corput sequence, the others take
+ * the primitive polynomials in order of degree (Bratley and Fox's
+ * recurrence).  The initial numbers only have to be odd and less than
+ * 2^k; they come from a fixed generator, so all rollouts use the same
+ * sequence and the seed only picks its shift. */
+static void
+SobolInit(perArray * pArray)
+{
+    unsigned int i, k, d = 1, p = 1;
+    unsigned int nInit = 20260214;
+
+    for (k = 0; k < SOBOL_BITS; k++)
+        pArray->aanSobol[0][k] = 1u << (SOBOL_BITS - 1 - k);
+
+    for (i = 1; i < QRLEN; i++) {
+        unsigned int *an = pArray->aanSobol[i];
+        unsigned int am[SOBOL_BITS];
+
+        /* the next primitive polynomial; they have a constant term */
+        do {
+            p += 2;
+            if (p >> (d + 1)) {
+                d++;
+                p = (1u << d) | 1;
+            }
+        } while (!PolyPrimitive(p, d));
+
+        for (k = 0; k < SOBOL_BITS; k++) {
+            if (k < d) {
+                nInit = nInit * 1103515245u + 12345u;
+                am[k] = ((nInit >> 16) & ((2u << k) - 1)) | 1;
+            } else {
+                unsigned int j;
+
+                am[k] = am[k - d] ^ (am[k - d] << d);
+                for (j = 1; j < d; j++)
+                    if (p >> (d - j) & 1)
+                        am[k] ^= am[k - j] << j;
+            }
+
+            an[k] = am[k] << (SOBOL_BITS - 1 - k);
+        }
+    }
+}
+
+/* The Sobol roll of turn iTurn of trial iGame among c outcomes */
+static unsigned int
+SobolRoll(const perArray * pArray, int iTurn, unsigned int iGame, unsigned int c)
+{
+    unsigned int x = pArray->anSobolShift[iTurn];
+    const unsigned int *an = pArray->aanSobol[iTurn];
+
+    for (; iGame; iGame >>= 1, an++)
+        if (iGame & 1)
+            x ^= *an;
+
+    return (unsigned int) (((unsigned long long) x * c) >> SOBOL_BITS);
 }
 
 static void
@@ -214,18 +517,36 @@ QuasiRandomSeed(perArray * pArray, int n)
             }
         }
 
+    SobolInit(pArray);
+    for (i = 0; i < QRLEN; i++)
+        pArray->anSobolShift[i] = (unsigned int) irand(&rc);
+
     pArray->nPermutationSeed = n;
 }
 
 static int nSkip;
 
-extern int
-RolloutDice(int iTurn, int iGame,
-            int fInitial,
-            unsigned int anDice[2], rng * rngx, void *rngctx, const int fRotate, const perArray * dicePerms)
+static int
+RolloutDiceSub(int iTurn, int iGame,
+               int fInitial,
+               unsigned int anDice[2], rng * rngx, void *rngctx, const int fRotate, const int fSobol,
+               const perArray * dicePerms)
 {
 
-    if (fInitial && !iTurn) {
+    if (fRotate && fSobol && iTurn < QRLEN) {
+        unsigned int j;
+
+        if (fInitial && !iTurn) {
+            /* the j-th of the 30 rolls that aren't doubles */
+            j = SobolRoll(dicePerms, iTurn, (unsigned int) iGame, 30);
+            j += j / 6 + 1;
+        } else
+            j = SobolRoll(dicePerms, iTurn, (unsigned int) iGame, 36);
+
+        anDice[0] = j / 6 + 1;
+        anDice[1] = j % 6 + 1;
+        return 0;
+    } else if (fInitial && !iTurn) {
         /* rollout of initial position: no doubles allowed */
         if (fRotate) {
 
@@ -246,7 +567,7 @@ RolloutDice(int iTurn, int iGame,
         } else {
             do {
                 int n;
-                if ((n = RollDice(anDice, rngx, rngctx)) != 0)
+                if ((n = RollDiceBuffered(anDice, rngx, rngctx)) != 0)
                     return n;
             } while (anDice[0] == anDice[1]);
 
@@ -264,7 +585,23 @@ RolloutDice(int iTurn, int iGame,
         anDice[1] = j % 6 + 1;
         return 0;
     } else
-        return RollDice(anDice, rngx, rngctx);
+        return RollDiceBuffered(anDice, rngx, rngctx);
+}
+
+extern int
+RolloutDice(int iTurn, int iGame,
+            int fInitial,
+            unsigned int anDice[2], rng * rngx, void *rngctx, const int fRotate, const int fSobol,
+            const perArray * dicePerms)
+{
+    guint64 tProfile;
+    int n;
+
+    PROFILE_START(tProfile);
+    n = RolloutDiceSub(iTurn, iGame, fInitial, anDice, rngx, rngctx, fRotate, fSobol, dicePerms);
+    PROFILE_STOP(tProfile, PROFILE_DICE);
+
+    return n;
 }
 
 
@@ -292,6 +629,7 @@ ClosedBoard(int afClosedBoard[2], const TanBoard anBoard)
 
 #define BasicCubefulRollout BasicCubefulRolloutWithLocking
 
+extern cubefulCache ccVarRedn;
 static volatile unsigned int initial_game_count;
 
 #endif
@@ -300,21 +638,110 @@ static volatile unsigned int initial_game_count;
 static void initRolloutstat(rolloutstat * prs);
 #endif
 
+/* The 0-ply evaluation ar, for the opponent, of the best 0-ply move
+ * of the roll n0, n1 for the player on roll; anBoardMove gets the
+ * position after it */
+static int
+VarRednRoll(float ar[NUM_ROLLOUT_OUTPUTS], int anMove[8], TanBoard anBoardMove, const TanBoard anBoard,
+            unsigned int n0, unsigned int n1, cubeinfo * pci, evalcontext aecZero[2])
+{
+    int n;
+
+    memcpy(anBoardMove, anBoard, sizeof(TanBoard));
+
+    if (FindBestMove(anMove, (int) n0, (int) n1, anBoardMove, pci, &aecZero[pci->fMove],
+                     defaultFilters) < 0)
+        return -1;
+
+    SwapSides(anBoardMove);
+
+    pci->fMove = !pci->fMove;
+    n = GeneralEvaluationE(ar, (ConstTanBoard) anBoardMove, pci, &aecZero[pci->fMove]);
+    pci->fMove = !pci->fMove;
+
+    return n;
+}
+
+/* Quick variance reduction: ar is VarRednRoll() for anDice and arMean
+ * its mean over all the rolls.  That mean only depends on the position,
+ * the cube and the evaluation contexts, and the positions near the
+ * start of the rollout come up again in many trials, so it is kept in
+ * ccVarRedn.  The move of anDice ends up in anMove and anBoardMove. */
+static int
+QuickVarRedn(float arMean[NUM_ROLLOUT_OUTPUTS], float ar[NUM_ROLLOUT_OUTPUTS], int anMove[8],
+             TanBoard anBoardMove, const TanBoard anBoard, const unsigned int anDice[2], cubeinfo * pci,
+             evalcontext aecZero[2], int fNoDoubles)
+{
+    positionkey key;
+    int anContext[2];
+    uint64_t check = 0;
+    float arOther[NUM_ROLLOUT_OUTPUTS];
+    int anMoveOther[8];
+    TanBoard anBoardOther;
+    unsigned int i, j, k;
+
+    if (ccVarRedn.entries) {
+        PositionKey(anBoard, &key);
+        anContext[0] = EvalKey(&aecZero[pci->fMove], 0, pci, TRUE);
+        anContext[1] = (int) (((unsigned int) EvalKey(&aecZero[!pci->fMove], 0, pci, TRUE) << 1) | (fNoDoubles != 0));
+        check = CubefulCacheHash(&key, anContext, 2);
+
+        /* the five outputs, then the two equities */
+        if (!CubefulCacheLookup(&ccVarRedn, check, arMean, arMean + OUTPUT_EQUITY, 2))
+            return VarRednRoll(ar, anMove, anBoardMove, anBoard, anDice[0], anDice[1], pci, aecZero);
+    }
+
+    for (k = 0; k < NUM_ROLLOUT_OUTPUTS; k++)
+        arMean[k] = 0.0f;
+
+    for (i = 0; i < 6; i++)
+        for (j = 0; j <= i; j++) {
+            /* keep the move of the roll itself */
+            int f = i + 1 == anDice[0] && j + 1 == anDice[1];
+            float *pr = f ? ar : arOther;
+
+            if (fNoDoubles && j == i)
+                continue;
+
+            if (VarRednRoll(pr, f ? anMove : anMoveOther, f ? anBoardMove : anBoardOther, anBoard, i + 1, j + 1,
+                            pci, aecZero) < 0)
+                return -1;
+
+            for (k = 0; k < NUM_ROLLOUT_OUTPUTS; k++)
+                arMean[k] += (i == j) ? pr[k] : pr[k] * 2.0f;
+        }
+
+    for (k = 0; k < NUM_ROLLOUT_OUTPUTS; k++)
+        arMean[k] /= fNoDoubles ? 30.0f : 36.0f;
+
+    if (ccVarRedn.entries)
+        CubefulCacheAdd(&ccVarRedn, check, arMean, arMean + OUTPUT_EQUITY, 2);
+
+    return 0;
+}
+
 /* called with 
  * cube decision                  move rollout
  * aanBoard       2 copies of same board         1 board
  * aarOutput      2 arrays for eval              1 array
  * iTurn          player on roll                 same
- * iGame          game number                    same
+ * aiGame         game number                    same
  * cubeinfo       2 structs for double/nodouble  1 cubeinfo
  * or take/pass
  * CubeDecTop     array of 2 boolean             1 boolean
  * (TRUE if a cube decision is valid on turn 0)
  * cci            2 (number of rollouts to do)   1
+ * fSameDice      TRUE                           same
  * prc            1 rollout context              same
  * aarsStatistics 2 arrays of stats for the      NULL
  * two alternatives of 
- * cube rollouts 
+ * cube rollouts, only
+ * written by this thread
+ * argctxRollout  1 RNG                          same
+ *
+ * or, without fSameDice, with cci games of their own (aiGame[] and
+ * argctxRollout[] for each) played in lockstep, so that the 0-ply
+ * evaluations of their moves can be batched with PrefetchMoves()
  * 
  * returns -1 on error/interrupt, fInterrupt TRUE if stopped by user
  * aarOutput array(s) contain results
@@ -323,14 +750,13 @@ static void initRolloutstat(rolloutstat * prs);
 extern int
 BasicCubefulRollout(unsigned int aanBoard[][2][25],
                     float aarOutput[][NUM_ROLLOUT_OUTPUTS],
-                    int iTurn, int iGame,
-                    const cubeinfo aci[], int afCubeDecTop[], unsigned int cci,
+                    int iTurn, const int aiGame[],
+                    const cubeinfo aci[], int afCubeDecTop[], unsigned int cci, int fSameDice,
                     rolloutcontext * prc,
                     rolloutstat aarsStatistics[][2],
-                    int nBasisCube, perArray * dicePerms, rngcontext * rngctxRollout, FILE * logfp)
+                    int nBasisCube, perArray * dicePerms, rngcontext * argctxRollout[], GString * pgsLog)
 {
 
-    unsigned int anDice[2];
     unsigned int cUnfinished = cci;
     cubeinfo *pci;
     cubedecision cd;
@@ -348,9 +774,6 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
     unsigned int aiBar[2];
 
-    int afClosedOut[2] = { FALSE, FALSE };
-    int afHit[2] = { FALSE, FALSE };
-
     float rDP;
     float r;
 
@@ -359,18 +782,23 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
     int nLateEvals = prc->fLateEvals ? prc->nLate : 0x7fffffff;
 
     int useVarRedn = prc->fVarRedn;
+    int useQuickVarRedn = !useVarRedn && prc->fQuickVarRedn;
 
     /* Make local copy of cubeinfo struct, since it
      * may be modified */
     cubeinfo *pciLocal = g_alloca(cci * sizeof(cubeinfo));
     int *pfFinished = g_alloca(cci * sizeof(int));
     float (*aarVarRedn)[NUM_ROLLOUT_OUTPUTS] = g_alloca(cci * NUM_ROLLOUT_OUTPUTS * sizeof(float));
+    unsigned int (*aanDice)[2] = g_alloca(cci * sizeof(*aanDice));
+    int (*aafClosedOut)[2] = g_alloca(cci * sizeof(*aafClosedOut));
+    int (*aafHit)[2] = g_alloca(cci * sizeof(*aafHit));
 
     /* variables for variance reduction */
 
     evalcontext aecVarRedn[2];
     evalcontext aecZero[2];
     float arMean[NUM_ROLLOUT_OUTPUTS];
+    float arQuick[NUM_ROLLOUT_OUTPUTS];
     unsigned int aaanBoard[6][6][2][25];
     int aanMoves[6][6][8];
 #if defined(USE_SIMD_INSTRUCTIONS)
@@ -386,7 +814,7 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
     /* local pointers to the eval contexts to use */
     evalcontext *pecCube[2], *pecChequer[2];
 
-    if (useVarRedn) {
+    if (useVarRedn || useQuickVarRedn) {
 
         /*
          * Create evaluation context one ply deep
@@ -407,8 +835,11 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
     }
 
-    for (ici = 0; ici < cci; ici++)
+    for (ici = 0; ici < cci; ici++) {
         pfFinished[ici] = TRUE;
+        aafClosedOut[ici][0] = aafClosedOut[ici][1] = FALSE;
+        aafHit[ici][0] = aafHit[ici][1] = FALSE;
+    }
 
     memcpy(pciLocal, aci, cci * sizeof(cubeinfo));
 
@@ -480,14 +911,14 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
                     case DOUBLE_TAKE:
                     case DOUBLE_BEAVER:
                     case REDOUBLE_TAKE:
-                        if (logfp) {
-                            log_cube(logfp, "double", pci->fMove);
-                            log_cube(logfp, "take", !pci->fMove);
+                        if (pgsLog) {
+                            log_cube(pgsLog, "double", pci->fMove);
+                            log_cube(pgsLog, "take", !pci->fMove);
                         }
 
                         /* update statistics */
                         if (aarsStatistics)
-                            MT_SafeInc(&aarsStatistics[ici][pci->fMove].acDoubleTake[LogCubeClamped(pci->nCube)]);
+                            aarsStatistics[ici][pci->fMove].acDoubleTake[LogCubeClamped(pci->nCube)]++;
 
                         SetCubeInfo(pci, 2 * pci->nCube, !pci->fMove, pci->fMove, pci->nMatchTo,
                                     pci->anScore, pci->fCrawford, pci->fJacoby, pci->fBeavers, pci->bgv);
@@ -496,9 +927,9 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
                     case DOUBLE_PASS:
                     case REDOUBLE_PASS:
-                        if (logfp) {
-                            log_cube(logfp, "double", pci->fMove);
-                            log_cube(logfp, "drop", !pci->fMove);
+                        if (pgsLog) {
+                            log_cube(pgsLog, "double", pci->fMove);
+                            log_cube(pgsLog, "drop", !pci->fMove);
                         }
 
                         *pf = FALSE;
@@ -525,8 +956,8 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
                         /* update statistics */
 
                         if (aarsStatistics) {
-                            MT_SafeInc(&aarsStatistics[ici][pci->fMove].acDoubleDrop[LogCubeClamped(pci->nCube)]);
-                            MT_SafeInc(&aarsStatistics[ici][pci->fMove].acWin[LogCubeClamped(pci->nCube)]);
+                            aarsStatistics[ici][pci->fMove].acDoubleDrop[LogCubeClamped(pci->nCube)]++;
+                            aarsStatistics[ici][pci->fMove].acWin[LogCubeClamped(pci->nCube)]++;
                         }
 
                         break;
@@ -559,17 +990,48 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
         /* Chequer play */
 
-        if (RolloutDice(iTurn, iGame, prc->fInitial, anDice,
-                        &prc->rngRollout, rngctxRollout, prc->fRotate, dicePerms) < 0)
-            return -1;
+        for (ici = 0; ici < cci; ici++) {
+            if (fSameDice ? ici > 0 : !pfFinished[ici])
+                continue;
+
+            if (RolloutDice(iTurn, aiGame[ici], prc->fInitial, aanDice[ici],
+                            &prc->rngRollout, argctxRollout[ici], prc->fRotate, prc->fSobol, dicePerms) < 0)
+                return -1;
 
-        if (anDice[0] < anDice[1])
-            swap_us(anDice, anDice + 1);
+            if (aanDice[ici][0] < aanDice[ici][1])
+                swap_us(aanDice[ici], aanDice[ici] + 1);
+        }
+
+        if (fSameDice)
+            for (ici = 1; ici < cci; ici++)
+                memcpy(aanDice[ici], aanDice[0], sizeof(aanDice[0]));
+        else if (cci > 1 && !useVarRedn) {
+            /* batch the evaluations of the candidates of all the games */
+            TanBoard *aanBoardPrefetch = g_alloca(cci * sizeof(TanBoard));
+            unsigned int (*aanDicePrefetch)[2] = g_alloca(cci * sizeof(*aanDicePrefetch));
+            cubeinfo *aciPrefetch = g_alloca(cci * sizeof(cubeinfo));
+            const evalcontext **apecPrefetch = g_alloca(cci * sizeof(evalcontext *));
+            unsigned int c = 0;
+
+            for (ici = 0; ici < cci; ici++)
+                if (pfFinished[ici]) {
+                    memcpy(aanBoardPrefetch[c], aanBoard[ici], sizeof(TanBoard));
+                    memcpy(aanDicePrefetch[c], aanDice[ici], sizeof(aanDice[ici]));
+                    aciPrefetch[c] = pciLocal[ici];
+                    apecPrefetch[c++] = pecChequer[pciLocal[ici].fMove];
+                }
 
+            if (c > 1)
+                PrefetchMoves((const TanBoard *) aanBoardPrefetch, (const unsigned int (*)[2]) aanDicePrefetch,
+                              aciPrefetch, apecPrefetch, c);
+        }
 
         for (ici = 0, pci = pciLocal, pf = pfFinished; ici < cci; ici++, pci++, pf++) {
 
             if (*pf) {
+                const unsigned int *anDice = aanDice[ici];
+                int *afClosedOut = aafClosedOut[ici];
+                int *afHit = aafHit[ici];
 
                 /* Save number of chequers on bar */
 
@@ -586,56 +1048,80 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
                 /* Find best move :-) */
 
-                if (useVarRedn) {
+                if (useVarRedn || useQuickVarRedn) {
+                    const float *arRoll;
+
+                    if (useVarRedn) {
+
+                        /* Variance reduction */
+
+                        for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
+                            arMean[i] = 0.0f;
+
+                        for (i = 0; i < 6; i++)
+                            for (j = 0; j <= i; j++) {
+
+                                if (prc->fInitial && !iTurn && j == i)
+                                    /* no doubles possible for first roll when rolling
+                                     * out as initial position */
+                                    continue;
+
+                                memcpy(&aaanBoard[i][j][0][0], &aanBoard[ici][0][0], 2 * 25 * sizeof(int));
+
+                                /* Find the best move for each roll on ply 0 only */
 
-                    /* Variance reduction */
+                                if (FindBestMove(aanMoves[i][j], i + 1, j + 1,
+                                                 aaanBoard[i][j], pci, &aecZero[pci->fMove], defaultFilters) < 0)
+                                    return -1;
 
-                    for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
-                        arMean[i] = 0.0f;
+                                SwapSides(aaanBoard[i][j]);
 
-                    for (i = 0; i < 6; i++)
-                        for (j = 0; j <= i; j++) {
+                                /* re-evaluate the chosen move at ply n-1 */
 
-                            if (prc->fInitial && !iTurn && j == i)
-                                /* no doubles possible for first roll when rolling
-                                 * out as initial position */
-                                continue;
+                                pci->fMove = !pci->fMove;
+                                if (GeneralEvaluationE(aaar[i][j],
+                                                       (ConstTanBoard) aaanBoard[i][j], pci,
+                                                       &aecVarRedn[pci->fMove]) < 0)
+                                    return -1;
+                                pci->fMove = !pci->fMove;
 
-                            memcpy(&aaanBoard[i][j][0][0], &aanBoard[ici][0][0], 2 * 25 * sizeof(int));
+                                if (!(iTurn & 1))
+                                    InvertEvaluationR(aaar[i][j], pci);
 
-                            /* Find the best move for each roll on ply 0 only */
+                                /* Calculate arMean: the n-ply evaluation of the position */
 
-                            if (FindBestMove(aanMoves[i][j], i + 1, j + 1,
-                                             aaanBoard[i][j], pci, &aecZero[pci->fMove], defaultFilters) < 0)
-                                return -1;
+                                for (k = 0; k < NUM_ROLLOUT_OUTPUTS; k++)
+                                    arMean[k] += ((i == j) ? aaar[i][j][k] : (aaar[i][j][k] * 2.0f));
 
-                            SwapSides(aaanBoard[i][j]);
+                            }
 
-                            /* re-evaluate the chosen move at ply n-1 */
+                        if (prc->fInitial && !iTurn)
+                            /* no doubles ... */
+                            for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
+                                arMean[i] /= 30.0f;
+                        else
+                            for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
+                                arMean[i] /= 36.0f;
 
-                            pci->fMove = !pci->fMove;
-                            if (GeneralEvaluationE(aaar[i][j],
-                                                   (ConstTanBoard) aaanBoard[i][j], pci, &aecVarRedn[pci->fMove]) < 0)
-                                return -1;
-                            pci->fMove = !pci->fMove;
+                        arRoll = aaar[anDice[0] - 1][anDice[1] - 1];
 
-                            if (!(iTurn & 1))
-                                InvertEvaluationR(aaar[i][j], pci);
+                    } else {
 
-                            /* Calculate arMean: the n-ply evaluation of the position */
+                        /* Quick variance reduction: 0-ply only, and the
+                         * mean may come from the cache */
 
-                            for (k = 0; k < NUM_ROLLOUT_OUTPUTS; k++)
-                                arMean[k] += ((i == j) ? aaar[i][j][k] : (aaar[i][j][k] * 2.0f));
+                        if (QuickVarRedn(arMean, arQuick, aanMoves[anDice[0] - 1][anDice[1] - 1],
+                                         aaanBoard[anDice[0] - 1][anDice[1] - 1], (ConstTanBoard) aanBoard[ici],
+                                         anDice, pci, aecZero, prc->fInitial && !iTurn) < 0)
+                            return -1;
 
+                        if (!(iTurn & 1)) {
+                            InvertEvaluationR(arMean, pci);
+                            InvertEvaluationR(arQuick, pci);
                         }
 
-                    if (prc->fInitial && !iTurn)
-                        /* no doubles ... */
-                        for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
-                            arMean[i] /= 30.0f;
-                    else
-                        for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
-                            arMean[i] /= 36.0f;
+                        arRoll = arQuick;
+                    }
 
                     /* Find best move */
 
@@ -667,13 +1153,12 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
                     if (pci->nMatchTo)
                         for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
-                            aarVarRedn[ici][i] += arMean[i] - aaar[anDice[0] - 1][anDice[1] - 1][i];
+                            aarVarRedn[ici][i] += arMean[i] - arRoll[i];
                     else {
                         for (i = 0; i <= OUTPUT_EQUITY; i++)
-                            aarVarRedn[ici][i] += arMean[i] - aaar[anDice[0] - 1][anDice[1] - 1][i];
+                            aarVarRedn[ici][i] += arMean[i] - arRoll[i];
 
-                        r = arMean[OUTPUT_CUBEFUL_EQUITY] - aaar[anDice[0] - 1][anDice[1] - 1]
-                            [OUTPUT_CUBEFUL_EQUITY];
+                        r = arMean[OUTPUT_CUBEFUL_EQUITY] - arRoll[OUTPUT_CUBEFUL_EQUITY];
                         aarVarRedn[ici][OUTPUT_CUBEFUL_EQUITY] += r * (float) (pci->nCube / aci[ici].nCube);
                     }
 
@@ -689,8 +1174,8 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
                 }
 
-                if (logfp) {
-                    log_move(logfp, aanMoves[anDice[0] - 1][anDice[1] - 1], pci->fMove, anDice[0], anDice[1]);
+                if (pgsLog) {
+                    log_move(pgsLog, aanMoves[anDice[0] - 1][anDice[1] - 1], pci->fMove, anDice[0], anDice[1]);
                 }
 
                 /* Save hit statistics */
@@ -698,13 +1183,13 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
                 /* FIXME: record double hit, triple hits etc. ? */
 
                 if (aarsStatistics && !afHit[pci->fMove] && (aiBar[0] < aanBoard[ici][0][24])) {
-                    MT_SafeInc(&aarsStatistics[ici][pci->fMove].nOpponentHit);
-                    MT_SafeAdd(&aarsStatistics[ici][pci->fMove].rOpponentHitMove, iTurn);
+                    aarsStatistics[ici][pci->fMove].nOpponentHit++;
+                    aarsStatistics[ici][pci->fMove].rOpponentHitMove += iTurn;
                     afHit[pci->fMove] = TRUE;
 
                 }
 
-                if (MT_SafeGet(&fInterrupt))
+                if (MT_Cancelled())
                     return -1;
 
                 /* Calculate number of wasted pips */
@@ -719,9 +1204,8 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
                     if (anDice[0] == anDice[1])
                         nPipsDice *= 2;
 
-                    MT_SafeInc(&aarsStatistics[ici][pci->fMove].nBearoffMoves);
-                    MT_SafeAdd(&aarsStatistics[ici][pci->fMove].nBearoffPipsLost,
-                               nPipsDice - (nPipsBefore - nPipsAfter));
+                    aarsStatistics[ici][pci->fMove].nBearoffMoves++;
+                    aarsStatistics[ici][pci->fMove].nBearoffPipsLost += nPipsDice - (nPipsBefore - nPipsAfter);
 
                 }
 
@@ -735,8 +1219,8 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
                     ClosedBoard(afClosedBoard, (ConstTanBoard) aanBoard[ici]);
 
                     if (afClosedBoard[pci->fMove]) {
-                        MT_SafeInc(&aarsStatistics[ici][pci->fMove].nOpponentClosedOut);
-                        MT_SafeAdd(&aarsStatistics[ici][pci->fMove].rOpponentClosedOutMove, iTurn);
+                        aarsStatistics[ici][pci->fMove].nOpponentClosedOut++;
+                        aarsStatistics[ici][pci->fMove].rOpponentClosedOutMove += iTurn;
                         afClosedOut[pci->fMove] = TRUE;
                     }
 
@@ -766,13 +1250,13 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
                     if (aarsStatistics)
                         switch (GameStatus((ConstTanBoard) aanBoard[ici], pci->bgv)) {
                         case 1:
-                            MT_SafeInc(&aarsStatistics[ici][pci->fMove].acWin[LogCubeClamped(pci->nCube)]);
+                            aarsStatistics[ici][pci->fMove].acWin[LogCubeClamped(pci->nCube)]++;
                             break;
                         case 2:
-                            MT_SafeInc(&aarsStatistics[ici][pci->fMove].acWinGammon[LogCubeClamped(pci->nCube)]);
+                            aarsStatistics[ici][pci->fMove].acWinGammon[LogCubeClamped(pci->nCube)]++;
                             break;
                         case 3:
-                            MT_SafeInc(&aarsStatistics[ici][pci->fMove].acWinBackgammon[LogCubeClamped(pci->nCube)]);
+                            aarsStatistics[ici][pci->fMove].acWinBackgammon[LogCubeClamped(pci->nCube)]++;
                             break;
                         }
 
@@ -806,7 +1290,12 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
 
             /* evaluation at truncation */
 
-            if (GeneralEvaluationE(aarOutput[ici], (ConstTanBoard) aanBoard[ici], pci, &ec) < 0)
+            if (!prc->fCubeful && EvalGetRaceApprox()
+                && ClassifyPosition((ConstTanBoard) aanBoard[ici], pci->bgv) == CLASS_RACE) {
+                RaceApprox((ConstTanBoard) aanBoard[ici], aarOutput[ici], pci->bgv);
+                aarOutput[ici][OUTPUT_EQUITY] = UtilityME(aarOutput[ici], pci);
+                aarOutput[ici][OUTPUT_CUBEFUL_EQUITY] = 0.0f;
+            } else if (GeneralEvaluationE(aarOutput[ici], (ConstTanBoard) aanBoard[ici], pci, &ec) < 0)
                 return -1;
 
             if (iTurn & 1)
@@ -820,7 +1309,7 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
         if (!pci->nMatchTo)
             aarOutput[ici][OUTPUT_CUBEFUL_EQUITY] *= (float) (pci->nCube / aci[ici].nCube);
 
-        if (useVarRedn)
+        if (useVarRedn || useQuickVarRedn)
             for (i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
                 aarOutput[ici][i] += aarVarRedn[ici][i];
 
@@ -891,33 +1380,18 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
  * that position.
  */
 
-static int
-comp_jsdinfo_equity(const void *a, const void *b)
-{
-    const jsdinfo *aa = a;
-    const jsdinfo *bb = b;
-
-    if (aa->rEquity < bb->rEquity)
-        return 1;
-    else if (aa->rEquity > bb->rEquity)
-        return -1;
-
-    return 0;
-}
-
-static int
-comp_jsdinfo_order(const void *a, const void *b)
-{
-    const jsdinfo *aa = a;
-    const jsdinfo *bb = b;
-
-    if (aa->nOrder < bb->nOrder)
-        return -1;
-    else if (aa->nOrder > bb->nOrder)
-        return 1;
+/* With ro_aiJob the alternatives are the plays of ro_cJobs decisions,
+ * rolled out together so that the threads have trials to play until
+ * the last decision is done.  JSDs are only taken between the plays of
+ * a decision. */
+static const int *ro_aiJob;
+static int ro_cJobs;
+static const char *const *ro_aszJob;
+/* 0 while a decision is being rolled out, its games once it is done
+ * and -1 once that has been reported */
+static int *ro_anJobDone;
 
-    return 0;
-}
+#define JOB(alt) (ro_aiJob ? ro_aiJob[alt] : 0)
 
 /* Lots of shared variables - should probably not be globals... */
 static int cGames;
@@ -930,6 +1404,10 @@ static float (*aarResult)[NUM_ROLLOUT_OUTPUTS];
 static float (*aarVariance)[NUM_ROLLOUT_OUTPUTS];
 static int *fNoMore;
 static jsdinfo *ajiJSD;
+/* The alternatives by decision and decreasing equity, kept from one
+ * check of the JSDs to the next: the order hardly changes between
+ * them, so an insertion sort puts it right in about one pass */
+static int *ro_aiByEquity;
 
 static int ro_alternatives = -1;
 static evalsetup **ro_apes;
@@ -942,11 +1420,40 @@ static int ro_fInvert;
 static int ro_NextTrial;
 static unsigned int *altGameCount;
 static int *altTrialCount;
+/* with rcRollout.fAdaptiveJsd an alternative is only played every
+ * altRollEvery[] cycles */
+static unsigned int *altRollEvery;
+/* the games of each alternative when this rollout started, and when */
+static unsigned int *altStartCount;
+static gint64 ro_tStart;
+/* the time the threads had spent on tasks when it started */
+static gint64 ro_tBusyStart;
+/* "set rollout progresslog" */
+static FILE *pfProgressLog;
+/* the rollout's job, which MT_Cancel() stops */
+static canceltoken ro_ct;
+
+/* Adaptive rollouts halve the games of a move for every JSD it is
+ * behind the best one, down to one in 1 << ROLLOUT_ADAPTIVE_SHIFT */
+#define ROLLOUT_ADAPTIVE_SHIFT 4
+
+/* Whether alternative a comes before b in ro_aiByEquity */
+static int
+JsdBefore(int a, int b)
+{
+    if (JOB(a) != JOB(b))
+        return JOB(a) < JOB(b);
+
+    if (ajiJSD[a].rEquity != ajiJSD[b].rEquity)
+        return ajiJSD[a].rEquity > ajiJSD[b].rEquity;
+
+    return a < b;
+}
 
 static void
 check_jsds(int *active)
 {
-    int alt;
+    int alt, i, j, iBest, iEnd;
     float v, s, denominator;
 
     for (alt = 0; alt < ro_alternatives; ++alt) {
@@ -980,57 +1487,84 @@ check_jsds(int *active)
     }
 
     if (!ro_fCubeRollout) {
-        /* 2 sort the list in order of decreasing equity (best move first) */
-        qsort((void *) ajiJSD, ro_alternatives, sizeof(jsdinfo), comp_jsdinfo_equity);
+        /* 2 bring the order of decreasing equity (best move first), a
+         * decision at a time, up to date */
+        for (i = 1; i < ro_alternatives; ++i) {
+            alt = ro_aiByEquity[i];
+            for (j = i; j > 0 && JsdBefore(alt, ro_aiByEquity[j - 1]); --j)
+                ro_aiByEquity[j] = ro_aiByEquity[j - 1];
+            ro_aiByEquity[j] = alt;
+        }
 
-        /* 3 replace the equities with the equity difference from the best move (ajiJSD[0]), the JSDs
-         * with the number of JSDs the equity difference represents and decide if we should either stop 
-         * or resume rolling a move out */
-        v = ajiJSD[0].rEquity;
-        s = ajiJSD[0].rJSD;
-        s *= s;
-        for (alt = ro_alternatives - 1; alt > 0; --alt) {
+        for (iBest = 0; iBest < ro_alternatives; iBest = iEnd) {
+            int fAllStopped = TRUE;
+            int best = ro_aiByEquity[iBest];
 
-            ajiJSD[alt].nRank = alt;
-            ajiJSD[alt].rEquity = v - ajiJSD[alt].rEquity;
+            for (iEnd = iBest + 1; iEnd < ro_alternatives && JOB(ro_aiByEquity[iEnd]) == JOB(best); ++iEnd);
 
-            denominator = sqrtf(s + ajiJSD[alt].rJSD * ajiJSD[alt].rJSD);
+            /* 3 replace the equities with the equity difference from the best move (ajiJSD[best]), the JSDs
+             * with the number of JSDs the equity difference represents and decide if we should either stop 
+             * or resume rolling a move out */
+            v = ajiJSD[best].rEquity;
+            s = ajiJSD[best].rJSD;
+            s *= s;
+            for (i = iEnd - 1; i > iBest; --i) {
+                alt = ro_aiByEquity[i];
 
-            if (denominator < 1e-8f)
-                denominator = 1e-8f;
+                ajiJSD[alt].nRank = i - iBest;
+                ajiJSD[alt].rEquity = v - ajiJSD[alt].rEquity;
 
-            ajiJSD[alt].rJSD = ajiJSD[alt].rEquity / denominator;
+                denominator = sqrtf(s + ajiJSD[alt].rJSD * ajiJSD[alt].rJSD);
 
-            if ((rcRollout.fStopOnJsd) && (altGameCount[ajiJSD[alt].nOrder] >= (rcRollout.nMinimumJsdGames))) {
-                if (ajiJSD[alt].rJSD > rcRollout.rJsdLimit) {
-                    /* This move is no longer worth rolling out */
+                if (denominator < 1e-8f)
+                    denominator = 1e-8f;
 
-                    fNoMore[ajiJSD[alt].nOrder] = 1;
-                    ro_apes[alt]->rc.rStoppedOnJSD = ajiJSD[alt].rJSD;
+                ajiJSD[alt].rJSD = ajiJSD[alt].rEquity / denominator;
 
-                    (*active)--;
+                if (rcRollout.fAdaptiveJsd && altGameCount[alt] >= rcRollout.nMinimumJsdGames)
+                    altRollEvery[alt] = ajiJSD[alt].rJSD < 1.0f ? 1 :
+                        1u << (ajiJSD[alt].rJSD < ROLLOUT_ADAPTIVE_SHIFT ? (unsigned int) ajiJSD[alt].rJSD :
+                               ROLLOUT_ADAPTIVE_SHIFT);
 
-                } else {
-                    /* this move needs to roll out further. It may need to be caught up
-                     * with other moves, because it's been stopped for a few trials */
-                    if (fNoMore[ajiJSD[alt].nOrder]) {
-                        /* it was stopped, catch it up to the other moves and resume
-                         * rolling it out. While we're catching up, we don't want to do 
-                         * these calculations any more so we'll change the minimum
-                         * games to do */
-                        fNoMore[ajiJSD[alt].nOrder] = 0;
-                        (*active)++;
+                if ((rcRollout.fStopOnJsd) && (altGameCount[alt] >= (rcRollout.nMinimumJsdGames))) {
+                    if (ajiJSD[alt].rJSD > rcRollout.rJsdLimit) {
+                        /* This move is no longer worth rolling out */
+
+                        fNoMore[alt] = 1;
+                        ro_apes[alt]->rc.rStoppedOnJSD = ajiJSD[alt].rJSD;
+
+                        (*active)--;
+
+                    } else {
+                        /* this move needs to roll out further. It may need to be caught up
+                         * with other moves, because it's been stopped for a few trials */
+                        if (fNoMore[alt]) {
+                            /* it was stopped, catch it up to the other moves and resume
+                             * rolling it out. While we're catching up, we don't want to do 
+                             * these calculations any more so we'll change the minimum
+                             * games to do */
+                            fNoMore[alt] = 0;
+                            (*active)++;
+                        }
                     }
                 }
+                if (!fNoMore[alt])
+                    fAllStopped = FALSE;
             }
-        }
 
-        /* fill out details of best move */
-        ajiJSD[0].rEquity = ajiJSD[0].rJSD = 0.0f;
-        ajiJSD[0].nRank = 0;
-
-        /* rearrange ajiJSD in move order rather than equity order */
-        qsort((void *) ajiJSD, ro_alternatives, sizeof(jsdinfo), comp_jsdinfo_order);
+            /* fill out details of best move */
+            ajiJSD[best].rEquity = ajiJSD[best].rJSD = 0.0f;
+            ajiJSD[best].nRank = 0;
+            altRollEvery[best] = 1;
+
+            /* without a play left to tell it from, the best one of a
+             * decision is done too; a single decision just ends */
+            if (ro_aiJob && rcRollout.fStopOnJsd && fAllStopped) {
+                fNoMore[best] = 1;
+                (*active)--;
+            } else if (ro_aiJob)
+                fNoMore[best] = 0;
+        }
 
     } else {
         float eq_dp = fOutputMWC ? eq2mwc(1.0, &aciLocal[0]) : 1.0f;
@@ -1069,85 +1603,374 @@ check_jsds(int *active)
     }
 }
 
+/* The largest of the cubeless and cubeful equity STDs of alternative
+ * alt, the ones rcRollout.rStdLimit applies to */
+static float
+RolloutStdErr(int alt)
+{
+    const rolloutcontext *prc = &ro_apes[alt]->rc;
+    float rMax = 0.0f;
+    int ioutput;
+
+    for (ioutput = OUTPUT_EQUITY; ioutput < NUM_ROLLOUT_OUTPUTS; ioutput++) {
+        float s;
+
+        if (ioutput == OUTPUT_EQUITY) {     /* cubeless */
+            if (!ms.nMatchTo) {     /* money game */
+                s = fabsf(aarSigma[alt][ioutput]);
+                if (ro_fCubeRollout) {
+                    s *= (float) (aciLocal[alt].nCube / aciLocal[0].nCube);
+                }
+            } else {        /* match play */
+                s = fabsf(se_mwc2eq(se_eq2mwc(aarSigma[alt][ioutput],
+                                              &aciLocal[alt]), &aciLocal[(ro_fCubeRollout ? 0 : alt)]));
+            }
+        } else {
+            if (!prc->fCubeful)
+                continue;
+            /* cubeful */
+            if (!ms.nMatchTo) {     /* money game */
+                s = fabsf(aarSigma[alt][ioutput]);
+            } else {
+                s = fabsf(se_mwc2eq(aarSigma[alt][ioutput], &aciLocal[(ro_fCubeRollout ? 0 : alt)]));
+            }
+        }
+
+        if (s > rMax)
+            rMax = s;
+    }
+
+    return rMax;
+}
+
 static void
 check_sds(int *active)
 {
     int alt;
     for (alt = 0; alt < ro_alternatives; ++alt) {
-        float s;
-        int ioutput;
-        int err_too_big = 0;
-        rolloutcontext *prc;
         if (fNoMore[alt] || altGameCount[alt] < (rcRollout.nMinimumGames))
             continue;
-        prc = &ro_apes[alt]->rc;
-        for (ioutput = OUTPUT_EQUITY; ioutput < NUM_ROLLOUT_OUTPUTS; ioutput++) {
-            if (ioutput == OUTPUT_EQUITY) {     /* cubeless */
-                if (!ms.nMatchTo) {     /* money game */
-                    s = fabsf(aarSigma[alt][ioutput]);
-                    if (ro_fCubeRollout) {
-                        s *= (float) (aciLocal[alt].nCube / aciLocal[0].nCube);
-                    }
-                } else {        /* match play */
-                    s = fabsf(se_mwc2eq(se_eq2mwc(aarSigma[alt][ioutput],
-                                                  &aciLocal[alt]), &aciLocal[(ro_fCubeRollout ? 0 : alt)]));
-                }
-            } else {
-                if (!prc->fCubeful)
-                    continue;
-                /* cubeful */
-                if (!ms.nMatchTo) {     /* money game */
-                    s = fabsf(aarSigma[alt][ioutput]);
-                } else {
-                    s = fabsf(se_mwc2eq(aarSigma[alt][ioutput], &aciLocal[(ro_fCubeRollout ? 0 : alt)]));
-                }
-            }
-
-            if (rcRollout.rStdLimit < s) {
-                err_too_big = 1;
-                break;
-            }
-        }                       /* for (ioutput = OUTPUT_EQUITY; ioutput < NUM_ROLLOUT_OUTPUTS; ioutput++) */
 
-        if (!err_too_big) {
+        if (RolloutStdErr(alt) <= rcRollout.rStdLimit) {
             fNoMore[alt] = 1;
             (*active)--;
         }
 
     }                           /* alt = 0; alt < ro_alternatives; ++alt) */
-    if (ro_fCubeRollout && (!fNoMore[0] || !fNoMore[1])) {
-        /* cube rollouts should run the same number
-         * of trials for nd and dt */
-        fNoMore[0] = fNoMore[1] = 0;
-        *active = 2;
-    }
 
 }
 
-extern void
-RolloutLoopMT(void *UNUSED(unused))
+/* Roll out the cTrials trials aiTrial[] of an alternative, in
+ * lockstep.  The dice and the random numbers of a trial only depend on
+ * prc and its number, so it comes out the same whichever thread, or
+ * rollout worker, plays it and whichever trials it is played with.
+ * aarsStatistics, if not NULL, and argctx have one entry per trial. */
+static int
+RolloutTrials(const TanBoard anBoard, float aar[][NUM_ROLLOUT_OUTPUTS], const int aiTrial[], unsigned int cTrials,
+              const cubeinfo * pci, int fCubeDecTop, rolloutcontext * prc, rolloutstat aarsStatistics[][2],
+              int nBasisCube, perArray * pdicePerms, rngcontext * argctx[], GString * pgsLog)
 {
-    TanBoard anBoardEval;
-    float aar[NUM_ROLLOUT_OUTPUTS];
-    int active_alternatives;
-    unsigned int j;
-    int alt;
-    FILE *logfp = NULL;
-    rolloutcontext *prc = NULL;
-    /* Each thread gets a copy of the rngctxRollout */
-    rngcontext *rngctxMTRollout = CopyRNGContext(rngctxRollout);
-    perArray dicePerms;
-    dicePerms.nPermutationSeed = -1;
+    TanBoard *aanBoardEval = g_alloca(cTrials * sizeof(TanBoard));
+    cubeinfo *aci = g_alloca(cTrials * sizeof(cubeinfo));
+    int *afCubeDecTop = g_alloca(cTrials * sizeof(int));
+    unsigned int i;
 
-    /* ============ begin rollout loop ============= */
+    /* get the dice generator set up... */
+    if (prc->fRotate)
+        QuasiRandomSeed(pdicePerms, (int) prc->nSeed);
 
-    while (MT_SafeIncValue(&ro_NextTrial) <= cGames) {
-        active_alternatives = ro_alternatives;
+    MT_SafeSet(&nSkip, 0);      /* not multi-thread safe do quasi random dice for initial positions */
 
-        for (alt = 0; alt < ro_alternatives; ++alt) {
-            int trial = MT_SafeIncValue(&altTrialCount[alt]) - 1;
-            /* skip this one if it's already finished */
-            if (fNoMore[alt] || (trial > cGames)) {
+    for (i = 0; i < cTrials; i++) {
+        /* ... and the RNG */
+        if (prc->rngRollout != RNG_MANUAL)
+            InitRNGSeedTrial((unsigned int) prc->nSeed, (unsigned int) aiTrial[i], prc->rngRollout, argctx[i]);
+
+        memcpy(aanBoardEval[i], anBoard, sizeof(TanBoard));
+        aci[i] = *pci;
+        afCubeDecTop[i] = fCubeDecTop;
+    }
+
+    MT_GetTLD()->ts.cTrials += cTrials;
+
+    /* roll something out */
+    return BasicCubefulRollout(aanBoardEval, aar, 0, aiTrial, aci, afCubeDecTop, cTrials, FALSE,
+                               prc, aarsStatistics, nBasisCube, pdicePerms, argctx, pgsLog);
+}
+
+/* Roll out trial iTrial of an alternative on its own */
+extern int
+RolloutTrial(const TanBoard anBoard, float aar[NUM_ROLLOUT_OUTPUTS], int iTrial, const cubeinfo * pci,
+             int afCubeDecTop[], rolloutcontext * prc, rolloutstat aarsStatistics[][2], int nBasisCube,
+             perArray * pdicePerms, rngcontext * rngctx, GString * pgsLog)
+{
+    return RolloutTrials(anBoard, (float (*)[NUM_ROLLOUT_OUTPUTS]) aar, &iTrial, 1, pci, afCubeDecTop[0], prc,
+                         aarsStatistics, nBasisCube, pdicePerms, &rngctx, pgsLog);
+}
+
+static void
+AddRolloutstat(rolloutstat * prsDest, const rolloutstat * prs)
+{
+    int *pn = (int *) prsDest;
+    const int *pnAdd = (const int *) prs;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(rolloutstat) / sizeof(int); i++)
+        pn[i] += pnAdd[i];
+}
+
+/* Each thread sums up its trials on its own and adds them to the
+ * shared results every ROLLOUT_MERGE_CYCLES trials of each
+ * alternative, or ROLLOUT_MERGE_TIME microseconds, whichever comes
+ * first, so that they don't all queue up for MT_LOCK_ROLLOUT after
+ * every trial of fast, truncated, rollouts.  The stopping rules look
+ * at the results after the first merge from any thread that comes as
+ * many cycles or as long after they last did. */
+#define ROLLOUT_MERGE_CYCLES 8
+#define ROLLOUT_MERGE_TIME (G_TIME_SPAN_SECOND / 4)
+
+/* the cycle and time the stopping rules were last looked at */
+static int ro_iChecked;
+static gint64 ro_tChecked;
+
+/* Welford's running mean and sum of squared deviations */
+typedef struct {
+    unsigned int n;
+    float arMu[NUM_ROLLOUT_OUTPUTS];
+    float arM2[NUM_ROLLOUT_OUTPUTS];
+    /* the statistics of these trials, when ro_aarsStatistics is kept */
+    rolloutstat ars[2];
+} rolloutacc;
+
+static void
+AddRolloutAcc(rolloutacc * pra, const float aar[NUM_ROLLOUT_OUTPUTS])
+{
+    unsigned int j;
+
+    pra->n++;
+
+    for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+        float rDelta = aar[j] - pra->arMu[j];
+
+        pra->arMu[j] += rDelta / (float) pra->n;
+        pra->arM2[j] += rDelta * (aar[j] - pra->arMu[j]);
+    }
+}
+
+/* Add the trials of pra to the results of alternative alt and clear
+ * it (Chan et al.'s pairwise update).  Must be called with
+ * MT_LOCK_ROLLOUT held. */
+static void
+MergeRolloutAcc(int alt, rolloutacc * pra)
+{
+    unsigned int nOld = altGameCount[alt];
+    unsigned int n = nOld + pra->n;
+    rolloutcontext *prc = &ro_apes[alt]->rc;
+    unsigned int j;
+
+    if (!pra->n)
+        return;
+
+    for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+        /* aarVariance is the sample variance, so for nOld < 2 there
+         * are no squared deviations yet */
+        float rMuOld = nOld ? aarResult[alt][j] / (float) nOld : 0.0f;
+        float rDelta = pra->arMu[j] - rMuOld;
+        float rM2 = (nOld > 1 ? aarVariance[alt][j] * (float) (nOld - 1) : 0.0f) + pra->arM2[j] +
+            rDelta * rDelta * (float) nOld * (float) pra->n / (float) n;
+
+        aarResult[alt][j] += pra->arMu[j] * (float) pra->n;
+        aarVariance[alt][j] = n > 1 ? rM2 / (float) (n - 1) : 0.0f;
+        aarMu[alt][j] = aarResult[alt][j] / (float) n;
+
+        if (j < OUTPUT_EQUITY) {
+            if (aarMu[alt][j] < 0.0f)
+                aarMu[alt][j] = 0.0f;
+            else if (aarMu[alt][j] > 1.0f)
+                aarMu[alt][j] = 1.0f;
+        }
+
+        aarSigma[alt][j] = sqrtf(aarVariance[alt][j] / (float) n);
+    }
+
+    altGameCount[alt] = n;
+
+    if (ro_aarsStatistics) {
+        AddRolloutstat(&ro_aarsStatistics[alt][0], &pra->ars[0]);
+        AddRolloutstat(&ro_aarsStatistics[alt][1], &pra->ars[1]);
+    }
+
+    prc->nGamesDone = altGameCount[alt];
+
+    memset(pra, 0, sizeof(*pra));
+}
+
+/* A rollout checkpoint is a header and, for each alternative, what
+ * RolloutGeneral() was given and the sums of the trials played so far.
+ * The dice of a trial only depend on the seed and the trial number, so
+ * that is all it takes to go on where the rollout stopped.  The structs
+ * are written as they are, so a checkpoint is only usable by the same
+ * build of gnubg. */
+
+#define ROLLOUT_CHECKPOINT_MAGIC "gnubgrc"
+#define ROLLOUT_CHECKPOINT_FORMAT 1
+
+/* how often to write the checkpoint, in microseconds */
+#define ROLLOUT_CHECKPOINT_TIME (5 * G_TIME_SPAN_SECOND)
+
+typedef struct {
+    char szMagic[8];
+    uint32_t nFormat;
+    uint32_t cbAlternative;
+    int cAlternatives;
+    int fCubeRollout;
+    int fInvert;
+    int fStatistics;
+    rolloutcontext rc;
+} checkpointheader;
+
+typedef struct {
+    TanBoard anBoard;
+    cubeinfo ci;
+    int fCubeDecTop;
+    rolloutcontext rc;
+    unsigned int nGames;
+    float arSum[NUM_ROLLOUT_OUTPUTS];
+    float arM2[NUM_ROLLOUT_OUTPUTS];    /* sum of squared deviations */
+    rolloutstat ars[2];
+} checkpointalternative;
+
+static gint64 ro_tCheckpoint;
+
+/* Write the state of the current rollout to szFile.  Must be called
+ * with MT_LOCK_ROLLOUT held, or when no trials are being played. */
+static int
+WriteRolloutCheckpoint(const char *szFile)
+{
+    checkpointheader h;
+    checkpointalternative ca;
+    char *szTemp;
+    FILE *pf;
+    int fd, alt, fOK;
+    unsigned int j;
+
+    szTemp = g_strconcat(szFile, ".XXXXXX", NULL);
+    if ((fd = g_mkstemp(szTemp)) < 0 || (pf = fdopen(fd, "wb")) == NULL) {
+        if (fd >= 0)
+            close(fd);
+        g_free(szTemp);
+        return -1;
+    }
+
+    memset(&h, 0, sizeof(h));
+    strcpy(h.szMagic, ROLLOUT_CHECKPOINT_MAGIC);
+    h.nFormat = ROLLOUT_CHECKPOINT_FORMAT;
+    h.cbAlternative = sizeof(ca);
+    h.cAlternatives = ro_alternatives;
+    h.fCubeRollout = ro_fCubeRollout;
+    h.fInvert = ro_fInvert;
+    h.fStatistics = ro_aarsStatistics != NULL;
+    h.rc = rcRollout;
+
+    fOK = fwrite(&h, sizeof(h), 1, pf) == 1;
+
+    for (alt = 0; fOK && alt < ro_alternatives; alt++) {
+        unsigned int n = altGameCount[alt];
+
+        memset(&ca, 0, sizeof(ca));
+        memcpy(ca.anBoard, ro_apBoard[alt], sizeof(ca.anBoard));
+        ca.ci = *ro_apci[alt];
+        ca.fCubeDecTop = *ro_apCubeDecTop[alt];
+        ca.rc = ro_apes[alt]->rc;
+        /* nGamesDone may be ahead of the trials merged for cube decisions */
+        ca.rc.nGamesDone = n;
+        ca.nGames = n;
+
+        for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+            ca.arSum[j] = aarResult[alt][j];
+            ca.arM2[j] = n > 1 ? aarVariance[alt][j] * (float) (n - 1) : 0.0f;
+        }
+
+        if (ro_aarsStatistics)
+            memcpy(ca.ars, ro_aarsStatistics[alt], sizeof(ca.ars));
+
+        fOK = fwrite(&ca, sizeof(ca), 1, pf) == 1;
+    }
+
+    if (fclose(pf))
+        fOK = FALSE;
+
+    if (fOK) {
+#if defined(WIN32)
+        g_unlink(szFile);
+#endif
+        fOK = !g_rename(szTemp, szFile);
+    }
+
+    if (!fOK)
+        g_unlink(szTemp);
+
+    g_free(szTemp);
+
+    return fOK ? 0 : -1;
+}
+
+/* The trials of RolloutGeneral(), played here or, if prw is not NULL,
+ * by that rollout worker; trials it cannot play once its connection is
+ * lost are played here */
+static void
+RolloutLoop(rolloutworker * prw)
+{
+    TanBoard anBoardEval;
+    float aar[NUM_ROLLOUT_OUTPUTS];
+    int active_alternatives;
+    int alt;
+    GString *pgsLog = NULL;
+    /* the games for the rollout log */
+    GString *pgsLogBuffer = NULL;
+    rolloutcontext *prc = NULL;
+    /* Each thread gets a copy of the rngctxRollout */
+    rngcontext *rngctxMTRollout = CopyRNGContext(rngctxRollout);
+    perArray dicePerms;
+    rolloutacc *arAcc = g_new0(rolloutacc, ro_alternatives);
+    /* with a single thread there is nobody to wait for the lock */
+    const int cMergeCycles = MT_GetNumThreads() > 1 || prw ? ROLLOUT_MERGE_CYCLES : 1;
+    int cCycles = 0;
+    gint64 tMerged = g_get_monotonic_time();
+    /* the trials of an alternative played at once by this thread; the
+     * .sgf files are written one game at a time */
+    const unsigned int cLanes = log_rollouts && log_file_name ? 1 : cRolloutLockstep;
+    int *aiTrial = g_new(int, cLanes);
+    float (*aarLanes)[NUM_ROLLOUT_OUTPUTS] = g_malloc(cLanes * sizeof(*aarLanes));
+    rolloutstat(*aarsLanes)[2] = g_malloc(cLanes * sizeof(*aarsLanes));
+    rngcontext **argctxLanes = g_new(rngcontext *, cLanes);
+    unsigned int iLane;
+    int iCycle;
+
+    argctxLanes[0] = rngctxMTRollout;
+    for (iLane = 1; iLane < cLanes; iLane++)
+        argctxLanes[iLane] = CopyRNGContext(rngctxRollout);
+    dicePerms.nPermutationSeed = -1;
+
+    /* ============ begin rollout loop ============= */
+
+    while ((iCycle = MT_SafeIncValue(&ro_NextTrial)) <= cGames) {
+        /* this cycle is up to cLanes trials of each alternative */
+        if (cLanes > 1)
+            MT_SafeAdd(&ro_NextTrial, (int) cLanes - 1);
+        iCycle /= (int) cLanes;
+
+        for (alt = 0; alt < ro_alternatives; ++alt) {
+            int trial;
+            int nBasisCube = aciLocal[ro_fCubeRollout ? 0 : alt].nCube;
+
+            /* a move far behind the best one rests for this cycle */
+            if (altRollEvery[alt] > 1 && iCycle % altRollEvery[alt])
+                continue;
+
+            trial = MT_SafeIncValue(&altTrialCount[alt]) - 1;
+            /* skip this one if it's already finished */
+            if (fNoMore[alt] || (trial > cGames)) {
                 MT_SafeDec(&altTrialCount[alt]);
                 continue;
             }
@@ -1155,146 +1978,404 @@ RolloutLoopMT(void *UNUSED(unused))
 
             prc = &ro_apes[alt]->rc;
 
-            /* get the dice generator set up... */
-            if (prc->fRotate)
-                QuasiRandomSeed(&dicePerms, (int) prc->nSeed);
-
-            MT_SafeSet(&nSkip, 0);      /* not multi-thread safe do quasi random dice for initial positions */
+#if defined(USE_MULTITHREAD) && HAVE_SOCKETS
+            /* manual dice and dice from a file are only found here */
+            if (prw && prc->rngRollout != RNG_MANUAL && prc->rngRollout != RNG_FILE) {
+                rolloutstat ars[2];
 
-            /* ... and the RNG */
-            if (prc->rngRollout != RNG_MANUAL)
-                InitRNGSeed((unsigned int) (prc->nSeed + (trial << 8)), prc->rngRollout, rngctxMTRollout);
-
-            memcpy(&anBoardEval, ro_apBoard[alt], sizeof(anBoardEval));
+                if (!RolloutWorkerTrial(prw, ro_apBoard[alt], aar, trial, ro_apci[alt], ro_apCubeDecTop[alt][0],
+                                        prc, ro_aarsStatistics ? ars : NULL, nBasisCube)) {
+                    if (ro_aarsStatistics) {
+                        AddRolloutstat(&arAcc[alt].ars[0], &ars[0]);
+                        AddRolloutstat(&arAcc[alt].ars[1], &ars[1]);
+                    }
+                    goto played;
+                }
 
-            /* roll something out */
-            if (log_rollouts && log_file_name) {
-                char *log_name = g_strdup_printf("%s-%7.7d-%c.sgf", log_file_name, trial, alt + 'a');
-                logfp = log_game_start(log_name, ro_apci[alt], prc->fCubeful, anBoardEval);
-                g_free(log_name);
+                /* the connection is lost; the caller closes it */
+                prw = NULL;
             }
-            BasicCubefulRollout(&anBoardEval, &aar, 0, trial, ro_apci[alt],
-                                ro_apCubeDecTop[alt], 1, prc,
-                                ro_aarsStatistics ? ro_aarsStatistics + alt : NULL,
-                                aciLocal[ro_fCubeRollout ? 0 : alt].nCube, &dicePerms, rngctxMTRollout, logfp);
+#endif
 
-            if (logfp) {
-                log_game_over(logfp);
-            }
+            /* manual dice and dice from a file come in the order they are asked for */
+            if (cLanes > 1 && prc->rngRollout != RNG_MANUAL && prc->rngRollout != RNG_FILE) {
+                unsigned int c = 1;
 
-            if (MT_SafeGet(&fInterrupt))
-                break;
+                aiTrial[0] = trial;
+                for (; c < cLanes; c++) {
+                    if ((aiTrial[c] = MT_SafeIncValue(&altTrialCount[alt]) - 1) > cGames) {
+                        MT_SafeDec(&altTrialCount[alt]);
+                        break;
+                    }
+                }
 
-            multi_debug("exclusive lock: update result for alternative");
-            MT_Exclusive();
-            altGameCount[alt]++;
+                if (ro_aarsStatistics)
+                    memset(aarsLanes, 0, c * sizeof(*aarsLanes));
 
-            if (ro_fInvert)
-                InvertEvaluationR(aar, ro_apci[alt]);
+                RolloutTrials(ro_apBoard[alt], aarLanes, aiTrial, c, ro_apci[alt], ro_apCubeDecTop[alt][0], prc,
+                              ro_aarsStatistics ? aarsLanes : NULL, nBasisCube, &dicePerms, argctxLanes, NULL);
 
-            /* apply the results */
-            for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
-                float rMuNew;
+                if (MT_Cancelled())
+                    break;
 
-                aarResult[alt][j] += aar[j];
-                rMuNew = aarResult[alt][j] / (float) altGameCount[alt];
+                for (iLane = 0; iLane < c; iLane++) {
+                    if (ro_aarsStatistics) {
+                        AddRolloutstat(&arAcc[alt].ars[0], &aarsLanes[iLane][0]);
+                        AddRolloutstat(&arAcc[alt].ars[1], &aarsLanes[iLane][1]);
+                    }
 
-                if (altGameCount[alt] > 1) {    /* for i == 0 aarVariance is not defined */
-                    float rDelta = rMuNew - aarMu[alt][j];
+                    if (ro_fInvert)
+                        InvertEvaluationR(aarLanes[iLane], ro_apci[alt]);
 
-                    aarVariance[alt][j] =
-                        aarVariance[alt][j] * (1.0f - 1.0f / (float) (altGameCount[alt] - 1)) +
-                        (float) (altGameCount[alt]) * rDelta * rDelta;
+                    AddRolloutAcc(&arAcc[alt], aarLanes[iLane]);
                 }
 
-                aarMu[alt][j] = rMuNew;
+                continue;
+            }
 
-                if (j < OUTPUT_EQUITY) {
-                    if (aarMu[alt][j] < 0.0f)
-                        aarMu[alt][j] = 0.0f;
-                    else if (aarMu[alt][j] > 1.0f)
-                        aarMu[alt][j] = 1.0f;
-                }
+            if (log_rollouts && log_file_name) {
+                memcpy(anBoardEval, ro_apBoard[alt], sizeof(anBoardEval));
+                pgsLog = log_game_start(ro_apci[alt], prc->fCubeful, anBoardEval);
+            }
+            RolloutTrial(ro_apBoard[alt], aar, trial, ro_apci[alt], ro_apCubeDecTop[alt], prc,
+                         ro_aarsStatistics ? &arAcc[alt].ars : NULL, nBasisCube, &dicePerms,
+                         rngctxMTRollout, pgsLog);
 
-                aarSigma[alt][j] = sqrtf(aarVariance[alt][j] / (float) altGameCount[alt]);
-            }                   /* for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++ ) */
+            if (pgsLog) {
+                log_game_over(pgsLog, trial, alt, &pgsLogBuffer);
+                pgsLog = NULL;
+            }
 
-            /* For normal alternatives nGamesDone and altGameCount will be equal. For cube decisions,
-             * however, the two may differ by the number of threads minus 1. So we cheat a little bit, but
-             * it would be better if the double and nodouble alternatives weren't linked */
-            if (prc->nGamesDone < altGameCount[alt])
-                prc->nGamesDone = altGameCount[alt];
+#if defined(USE_MULTITHREAD) && HAVE_SOCKETS
+          played:
+#endif
+            if (MT_Cancelled())
+                break;
 
-            MT_Release();
-            multi_debug("exclusive release: update result for alternative");
+            if (ro_fInvert)
+                InvertEvaluationR(aar, ro_apci[alt]);
 
+            AddRolloutAcc(&arAcc[alt], aar);
         }                       /* for (alt = 0; alt < ro_alternatives; ++alt) */
 
-        if (MT_SafeGet(&fInterrupt))
+        if (MT_Cancelled())
             break;
 
-        /* we've rolled everything out for this trial, check stopping conditions */
-        /* Stop rolling out moves whose Equity is more than a user selected multiple of the joint standard
-         * deviation of the equity difference with the best move in the list. */
-
 #if !defined(USE_MULTITHREAD)
         ProcessEvents();
 #endif
 
+        if (++cCycles < cMergeCycles && g_get_monotonic_time() - tMerged < ROLLOUT_MERGE_TIME)
+            continue;
+
+        /* we've rolled everything out for these trials, check stopping conditions */
+        /* Stop rolling out moves whose Equity is more than a user selected multiple of the joint standard
+         * deviation of the equity difference with the best move in the list. */
+
         multi_debug("exclusive lock: rollout cycle update");
-        MT_Exclusive();
-        if (show_jsds) {
-            check_jsds(&active_alternatives);
+        MT_Lock(MT_LOCK_ROLLOUT);
+        for (alt = 0; alt < ro_alternatives; ++alt)
+            MergeRolloutAcc(alt, &arAcc[alt]);
+        cCycles = 0;
+        tMerged = g_get_monotonic_time();
+
+        /* errors are reported at the end of the rollout */
+        if (szRolloutCheckpoint && tMerged - ro_tCheckpoint >= ROLLOUT_CHECKPOINT_TIME) {
+            WriteRolloutCheckpoint(szRolloutCheckpoint);
+            ro_tCheckpoint = tMerged;
         }
-        if (rcRollout.fStopOnSTD) {
-            check_sds(&active_alternatives);
+
+        if (iCycle - ro_iChecked >= ROLLOUT_MERGE_CYCLES || tMerged - ro_tChecked >= ROLLOUT_MERGE_TIME) {
+            ro_iChecked = iCycle;
+            ro_tChecked = tMerged;
+
+            active_alternatives = ro_alternatives;
+            if (show_jsds) {
+                check_jsds(&active_alternatives);
+            }
+            if (rcRollout.fStopOnSTD) {
+                check_sds(&active_alternatives);
+            }
+            if ((active_alternatives < 2 && rcRollout.fStopOnJsd && !ro_aiJob) || active_alternatives < 1) {
+                multi_debug("exclusive release: rollout done early");
+                MT_Unlock(MT_LOCK_ROLLOUT);
+                break;
+            }
         }
-        if ((active_alternatives < 2 && rcRollout.fStopOnJsd) || active_alternatives < 1) {
-            multi_debug("exclusive release: rollout done early");
-            MT_Release();
+        if (rcRollout.nMaxSeconds && tMerged - ro_tStart >= (gint64) rcRollout.nMaxSeconds * G_TIME_SPAN_SECOND) {
+            /* the other threads stop after the trials they are playing */
+            MT_SafeSet(&ro_NextTrial, cGames + 1);
+            multi_debug("exclusive release: rollout out of time");
+            MT_Unlock(MT_LOCK_ROLLOUT);
             break;
         }
         multi_debug("exclusive release: rollout cycle update");
-        MT_Release();
+        MT_Unlock(MT_LOCK_ROLLOUT);
     }
+
+    /* the trials played since the last merge */
+    multi_debug("exclusive lock: rollout final update");
+    MT_Lock(MT_LOCK_ROLLOUT);
+    for (alt = 0; alt < ro_alternatives; ++alt)
+        MergeRolloutAcc(alt, &arAcc[alt]);
+    MT_Unlock(MT_LOCK_ROLLOUT);
+    multi_debug("exclusive release: rollout final update");
+
+    if (pgsLogBuffer)
+        RolloutLogWrite(pgsLogBuffer);
+
+    for (iLane = 1; iLane < cLanes; iLane++)
+        g_free(argctxLanes[iLane]);
+    g_free(argctxLanes);
+    g_free(aarsLanes);
+    g_free(aarLanes);
+    g_free(aiTrial);
+    g_free(arAcc);
     g_free(rngctxMTRollout);
 }
 
+extern void
+RolloutLoopMT(void *UNUSED(unused))
+{
+    RolloutLoop(NULL);
+}
+
+#if defined(USE_MULTITHREAD) && HAVE_SOCKETS
+/* A thread of its own for each rollout worker connection, next to the
+ * ones of mt_add_tasks() */
+static gpointer
+RolloutWorkerThread(gpointer p)
+{
+    rolloutworker *prw = (rolloutworker *) p;
+    ThreadLocalData *pTLD = MT_CreateThreadLocalData(-1);
+
+    /* for the trials played here if the worker goes away */
+    TLSSetValue(td.tlsItem, (size_t) pTLD);
+    MT_SetJob(&ro_ct);
+
+    RolloutLoop(prw);
+
+    RolloutWorkerClose(prw);
+    MT_FreeThreadLocalData(pTLD);
+
+    return NULL;
+}
+#endif
+
 static rolloutprogressfunc *ro_pfProgress;
 static void *ro_pUserData;
 
+/* The trials alternative alt is expected to end with: the ones played
+ * once it has stopped, else as many as it takes for its STDs to come
+ * down to rcRollout.rStdLimit, and no more than the time limit leaves
+ * room for.  The STDs go down as one over the square root of the
+ * trials. */
+static unsigned int
+ProjectedTrials(int alt)
+{
+    const unsigned int nDone = altGameCount[alt];
+    unsigned int n = (unsigned int) cGames;
+
+    if (fNoMore[alt] && nDone > 1)
+        return nDone;
+
+    if (rcRollout.fStopOnSTD && nDone > 1 && rcRollout.rStdLimit > 0.0f) {
+        double r = RolloutStdErr(alt) / rcRollout.rStdLimit;
+
+        r = MAX(ceil(nDone * r * r), rcRollout.nMinimumGames);
+        if (r < n)
+            n = (unsigned int) r;
+    }
+
+    if (rcRollout.nMaxSeconds && nDone > altStartCount[alt]) {
+        gint64 t = g_get_monotonic_time() - ro_tStart;
+
+        if (t > 0) {
+            double r = altStartCount[alt] + (double) (nDone - altStartCount[alt]) *
+                rcRollout.nMaxSeconds * G_TIME_SPAN_SECOND / t;
+
+            if (r < n)
+                n = (unsigned int) r;
+        }
+    }
+
+    return MAX(n, MIN(nDone + 1, (unsigned int) cGames));
+}
+
+/* The time all the threads have spent on tasks */
+static gint64
+ThreadsBusy(void)
+{
+    threadstats ts;
+    gint64 t = 0;
+    int i;
+
+    for (i = -1; i < (int) MT_GetNumThreads(); i++)
+        if (!MT_GetThreadStats(i, &ts))
+            t += ts.tBusy;
+
+    return t;
+}
+
+/* How alternative alt of the rollout going on is doing: its games per
+ * second, how busy the threads are and how long until its STDs are
+ * down to rcRollout.rStdLimit at that rate.  -1 if there is no such
+ * alternative. */
+extern int
+RolloutTelemetry(int alt, rollouttelemetry * prt)
+{
+    gint64 t;
+    unsigned int nDone;
+
+    if (alt < 0 || alt >= ro_alternatives)
+        return -1;
+
+    t = g_get_monotonic_time() - ro_tStart;
+    nDone = altGameCount[alt];
+
+    prt->rGamesPerSec = t > 0 ? (double) (nDone - altStartCount[alt]) * G_TIME_SPAN_SECOND / (double) t : 0.0;
+    prt->rUtilisation = t > 0 ? (double) (ThreadsBusy() - ro_tBusyStart) / ((double) t * MT_GetNumThreads()) : 0.0;
+    prt->rUtilisation = MIN(prt->rUtilisation, 1.0);
+    prt->rStdErr = nDone > 1 ? RolloutStdErr(alt) : -1.0;
+    prt->rSecondsToLimit = -1.0;
+
+    if (fNoMore[alt])
+        prt->rSecondsToLimit = 0.0;
+    else if (rcRollout.fStopOnSTD && nDone > 1 && rcRollout.rStdLimit > 0.0f && prt->rGamesPerSec > 0.0) {
+        double r = prt->rStdErr / rcRollout.rStdLimit;
+        double n = MAX(ceil(nDone * r * r), rcRollout.nMinimumGames);
+
+        prt->rSecondsToLimit = MAX(n - nDone, 0.0) / prt->rGamesPerSec;
+    }
+
+    return 0;
+}
+
+/* A line of the progress log for each alternative: seconds since the
+ * start, alternative, trials, games per second, thread utilisation,
+ * STD and seconds to the STD limit */
+static void
+LogProgress(void)
+{
+    char buf[5][G_ASCII_DTOSTR_BUF_SIZE];
+    double rElapsed = (double) (g_get_monotonic_time() - ro_tStart) / G_TIME_SPAN_SECOND;
+    int alt;
+
+    for (alt = 0; alt < ro_alternatives; ++alt) {
+        rollouttelemetry rt;
+
+        if (RolloutTelemetry(alt, &rt))
+            continue;
+
+        fprintf(pfProgressLog, "%s\t%d\t%u\t%s\t%s\t%s\t%s\n",
+                g_ascii_formatd(buf[0], G_ASCII_DTOSTR_BUF_SIZE, "%.3f", rElapsed), alt, altGameCount[alt],
+                g_ascii_formatd(buf[1], G_ASCII_DTOSTR_BUF_SIZE, "%.2f", rt.rGamesPerSec),
+                g_ascii_formatd(buf[2], G_ASCII_DTOSTR_BUF_SIZE, "%.3f", rt.rUtilisation),
+                g_ascii_formatd(buf[3], G_ASCII_DTOSTR_BUF_SIZE, "%.6f", rt.rStdErr),
+                g_ascii_formatd(buf[4], G_ASCII_DTOSTR_BUF_SIZE, "%.1f", rt.rSecondsToLimit));
+    }
+
+    fflush(pfProgressLog);
+}
+
+/* Tell about the decisions of a rollout of several that are done */
+static void
+ReportJobs(void)
+{
+    int iJob, alt;
+
+    multi_debug("exclusive lock: report jobs");
+    MT_Lock(MT_LOCK_ROLLOUT);
+    for (iJob = 0; iJob < ro_cJobs; iJob++) {
+        unsigned int nGames = 0;
+
+        if (ro_anJobDone[iJob])
+            continue;
+
+        for (alt = 0; alt < ro_alternatives; alt++) {
+            if (ro_aiJob[alt] != iJob)
+                continue;
+            if (!fNoMore[alt] && altGameCount[alt] < (unsigned int) cGames)
+                break;
+            nGames = MAX(nGames, altGameCount[alt]);
+        }
+
+        if (alt == ro_alternatives)
+            ro_anJobDone[iJob] = (int) MAX(nGames, 1);
+    }
+    MT_Unlock(MT_LOCK_ROLLOUT);
+    multi_debug("exclusive release: report jobs");
+
+    for (iJob = 0; iJob < ro_cJobs; iJob++)
+        if (ro_anJobDone[iJob] > 0) {
+            outputf(_("Rollout of %s done after %d games.\n"), ro_aszJob[iJob], ro_anJobDone[iJob]);
+            ro_anJobDone[iJob] = -1;
+        }
+}
+
 static gboolean
 UpdateProgress(gpointer UNUSED(unused))
 {
+    if (ro_aiJob && ro_alternatives > 0)
+        ReportJobs();
+
+    if (pfProgressLog && ro_alternatives > 0) {
+        MT_Lock(MT_LOCK_ROLLOUT);
+        LogProgress();
+        MT_Unlock(MT_LOCK_ROLLOUT);
+    }
+
     if (fShowProgress && ro_alternatives > 0) {
         int alt;
 
         multi_debug("exclusive lock: update progress");
-        MT_Exclusive();
+        MT_Lock(MT_LOCK_ROLLOUT);
 
         for (alt = 0; alt < ro_alternatives; ++alt) {
-            rolloutcontext *prc = &ro_apes[alt]->rc;
+            /* the progress and time left are shown for where the
+             * alternative is expected to stop */
+            rolloutcontext rc = ro_apes[alt]->rc;
+            rolloutcontext *prc = &rc;
 
+            rc.nTrials = ProjectedTrials(alt);
             (*ro_pfProgress) (aarMu, aarSigma, prc, aciLocal, initial_game_count, altGameCount[alt] - 1, alt,
                               ajiJSD[alt].nRank + 1, ajiJSD[alt].rJSD, fNoMore[alt], show_jsds, ro_fCubeRollout,
                               ro_pUserData);
         }
 
-        MT_Release();
+        MT_Unlock(MT_LOCK_ROLLOUT);
         multi_debug("exclusive release: update progress");
     }
     return TRUE;
 }
 
-extern int
-RolloutGeneral(ConstTanBoard * apBoard,
-               float (*apOutput[])[NUM_ROLLOUT_OUTPUTS],
-               float (*apStdDev[])[NUM_ROLLOUT_OUTPUTS],
-               rolloutstat aarsStatistics[][2],
-               evalsetup(*apes[]),
-               const cubeinfo(*apci[]),
-               int (*apCubeDecTop[]), int alternatives,
-               int fInvert, int fCubeRollout, rolloutprogressfunc * pfProgress, void *pUserData)
+/* Get ccVarRedn ready for some rollouts.  The means in it depend on
+ * the neural nets, which may have been changed since the last ones.
+ * Without the memory for it the means are worked out every time. */
+extern void
+InitVarRednCache(void)
+{
+    if (ccVarRedn.entries)
+        CubefulCacheFlush(&ccVarRedn);
+    else if (CubefulCacheCreate(&ccVarRedn, 1u << 16) < 0)
+        ccVarRedn.entries = NULL;
+    else
+        MemAccount(MEM_CACHE, (gssize) ((ccVarRedn.hashMask + 1) * sizeof(cubefulCacheEntry)));
+}
+
+/* RolloutGeneral() of the plays of cJobs decisions at once; aiJob[]
+ * is the decision of each alternative and aszJob[] their names, or
+ * aiJob is NULL for a single decision */
+static int
+RolloutJobs(ConstTanBoard * apBoard,
+            float (*apOutput[])[NUM_ROLLOUT_OUTPUTS],
+            float (*apStdDev[])[NUM_ROLLOUT_OUTPUTS],
+            rolloutstat aarsStatistics[][2],
+            evalsetup(*apes[]),
+            const cubeinfo(*apci[]),
+            int (*apCubeDecTop[]), int alternatives,
+            int fInvert, int fCubeRollout, const int aiJob[], int cJobs, const char *const aszJob[],
+            rolloutprogressfunc * pfProgress, void *pUserData)
 {
     unsigned int j;
     int alt;
@@ -1308,6 +2389,7 @@ RolloutGeneral(ConstTanBoard * apBoard,
     int fOutputMWCSave = fOutputMWC;
     int active_alternatives;
     int previous_rollouts = 0;
+    canceltoken *pctOld;
 
     show_jsds = 1;
 
@@ -1317,10 +2399,13 @@ RolloutGeneral(ConstTanBoard * apBoard,
     }
 
     ajiJSD = g_alloca(alternatives * sizeof(jsdinfo));
+    ro_aiByEquity = g_alloca(alternatives * sizeof(int));
     fNoMore = g_alloca(alternatives * sizeof(int));
     aciLocal = g_alloca(alternatives * sizeof(cubeinfo));
     altGameCount = g_alloca(alternatives * sizeof(int));
     altTrialCount = g_alloca(alternatives * sizeof(int));
+    altRollEvery = g_alloca(alternatives * sizeof(unsigned int));
+    altStartCount = g_alloca(alternatives * sizeof(unsigned int));
 
     aarMu = g_alloca(alternatives * NUM_ROLLOUT_OUTPUTS * sizeof(float));
     aarSigma = g_alloca(alternatives * NUM_ROLLOUT_OUTPUTS * sizeof(float));
@@ -1345,7 +2430,7 @@ RolloutGeneral(ConstTanBoard * apBoard,
 
     /* quasi random dice may not be thread safe when we need to skip
      * some rolls for initial positions */
-    if (rcRollout.fInitial)
+    if (rcRollout.fInitial && !rcRollout.fSobol)
         rcRollout.fRotate = FALSE;
 
     /* nFirstTrial will be the smallest number of trials done for an alternative */
@@ -1359,6 +2444,7 @@ RolloutGeneral(ConstTanBoard * apBoard,
         ajiJSD[alt].rEquity = ajiJSD[alt].rJSD = 0.0f;
         ajiJSD[alt].nRank = 0;
         ajiJSD[alt].nOrder = alt;
+        ro_aiByEquity[alt] = alt;
 
         /* save input cubeinfo */
         memcpy(&aciLocal[alt], apci[alt], sizeof(cubeinfo));
@@ -1423,6 +2509,8 @@ RolloutGeneral(ConstTanBoard * apBoard,
 
         /* force all moves/cube decisions to be considered and reset the upper bound on trials */
         fNoMore[alt] = 0;
+        altRollEvery[alt] = 1;
+        altStartCount[alt] = altGameCount[alt];
         prc->nTrials = cGames;
 
         pes->et = EVAL_ROLLOUT;
@@ -1456,9 +2544,30 @@ RolloutGeneral(ConstTanBoard * apBoard,
     ro_aarsStatistics = aarsStatistics;
     ro_fCubeRollout = fCubeRollout;
     ro_fInvert = fInvert;
+    ro_aiJob = aiJob;
+    ro_cJobs = aiJob ? cJobs : 1;
+    ro_aszJob = aszJob;
+    ro_anJobDone = g_alloca(ro_cJobs * sizeof(int));
+    memset(ro_anJobDone, 0, ro_cJobs * sizeof(int));
     ro_NextTrial = nFirstTrial;
     ro_pfProgress = pfProgress;
     ro_pUserData = pUserData;
+    ro_tStart = ro_tCheckpoint = ro_tChecked = g_get_monotonic_time();
+    ro_iChecked = 0;
+    ro_tBusyStart = ThreadsBusy();
+
+    if (szRolloutProgressLog) {
+        if ((pfProgressLog = g_fopen(szRolloutProgressLog, "a")) != NULL)
+            fputs("# seconds\talternative\ttrials\tgames/s\tutilisation\tstd\tseconds to limit\n", pfProgressLog);
+        else
+            outputerr(szRolloutProgressLog);
+    }
+
+    for (alt = 0; alt < alternatives; ++alt)
+        if (!apes[alt]->rc.fVarRedn && apes[alt]->rc.fQuickVarRedn) {
+            InitVarRednCache();
+            break;
+        }
 
     active_alternatives = ro_alternatives;
 
@@ -1475,29 +2584,75 @@ RolloutGeneral(ConstTanBoard * apBoard,
 
     UpdateProgress(NULL);
 
-    if (active_alternatives > 1 || (!rcRollout.fStopOnJsd && active_alternatives > 0)) {
+    /* without it the games go to .sgf files of their own */
+    if (log_rollouts && log_file_name && fRolloutLogStream)
+        RolloutLogOpen();
+
+    ro_ct.fCancelled = FALSE;
+    pctOld = MT_SetJob(&ro_ct);
+
+    if (active_alternatives > 1 || ((!rcRollout.fStopOnJsd || ro_aiJob) && active_alternatives > 0)) {
+#if defined(USE_MULTITHREAD) && HAVE_SOCKETS
+        /* the .sgf files of the games are written here */
+        GList *plWorkers = log_rollouts ? NULL : RolloutWorkersConnect();
+        GList *plThreads = NULL;
+        GList *pl;
+
+        for (pl = plWorkers; pl; pl = pl->next) {
+            GThread *pt = g_thread_try_new("rollout worker", RolloutWorkerThread, pl->data, NULL);
+
+            if (pt)
+                plThreads = g_list_prepend(plThreads, pt);
+            else
+                RolloutWorkerClose((rolloutworker *) pl->data);
+        }
+        g_list_free(plWorkers);
+#endif
+
         multi_debug("rollout adding tasks");
-        mt_add_tasks(MT_GetNumThreads(), RolloutLoopMT, NULL, NULL);
+        mt_add_tasks(MT_GetNumThreads(), RolloutLoopMT, NULL, NULL, TASK_ROLLOUT);
 
         multi_debug("rollout waiting for tasks to complete");
         MT_WaitForTasks(UpdateProgress, 2000, fAutoSaveRollout);
         multi_debug("rollout finished waiting for tasks to complete");
+
+#if defined(USE_MULTITHREAD) && HAVE_SOCKETS
+        /* the last trials given to the workers */
+        for (pl = plThreads; pl; pl = pl->next)
+            g_thread_join((GThread *) pl->data);
+        g_list_free(plThreads);
+#endif
     }
 
+    if (pfRolloutLog)
+        RolloutLogClose();
+
+    /* also when interrupted, so it can be resumed */
+    if (szRolloutCheckpoint && WriteRolloutCheckpoint(szRolloutCheckpoint))
+        outputerrf(_("Couldn't write the rollout checkpoint %s"), szRolloutCheckpoint);
+
     /* Make sure final output is up to date */
 #if defined(USE_GTK)
     if (!fX)
 #endif
-        if (!MT_SafeGet(&fInterrupt))
+        if (!MT_Cancelled())
             outputf(_("\nRollout done. Printing final results.\n"));
 
-    if (!MT_SafeGet(&fInterrupt))
+    if (!MT_Cancelled())
         UpdateProgress(NULL);
 
+    if (pfProgressLog) {
+        fclose(pfProgressLog);
+        pfProgressLog = NULL;
+    }
+
+    MT_SetJob(pctOld);
+
     /* Signal to UpdateProgress() called from pending events that no
      * more progress should be displayed.
      */
     ro_alternatives = -1;
+    ro_aiJob = NULL;
 
     for (alt = 0, trialsDone = 0; alt < alternatives; ++alt) {
         if (apes[alt]->rc.nGamesDone > trialsDone)
@@ -1537,6 +2692,144 @@ RolloutGeneral(ConstTanBoard * apBoard,
     return trialsDone;
 }
 
+extern int
+RolloutGeneral(ConstTanBoard * apBoard,
+               float (*apOutput[])[NUM_ROLLOUT_OUTPUTS],
+               float (*apStdDev[])[NUM_ROLLOUT_OUTPUTS],
+               rolloutstat aarsStatistics[][2],
+               evalsetup(*apes[]),
+               const cubeinfo(*apci[]),
+               int (*apCubeDecTop[]), int alternatives,
+               int fInvert, int fCubeRollout, rolloutprogressfunc * pfProgress, void *pUserData)
+{
+    return RolloutJobs(apBoard, apOutput, apStdDev, aarsStatistics, apes, apci, apCubeDecTop, alternatives,
+                       fInvert, fCubeRollout, NULL, 1, NULL, pfProgress, pUserData);
+}
+
+/* Read the rollout checkpoint szFile into prcp.  Returns 0, or -1 if
+ * szFile is not a checkpoint of this build. */
+extern int
+RolloutCheckpointLoad(const char *szFile, rolloutcheckpoint * prcp)
+{
+    GMappedFile *pmf;
+    const checkpointheader *ph;
+    const checkpointalternative *pca;
+    size_t cb;
+    int alt;
+    unsigned int j;
+
+    memset(prcp, 0, sizeof(*prcp));
+
+    if (!(pmf = g_mapped_file_new(szFile, FALSE, NULL)))
+        return -1;
+
+    cb = g_mapped_file_get_length(pmf);
+    ph = (const checkpointheader *) g_mapped_file_get_contents(pmf);
+
+    if (cb < sizeof(*ph) || strcmp(ph->szMagic, ROLLOUT_CHECKPOINT_MAGIC)
+        || ph->nFormat != ROLLOUT_CHECKPOINT_FORMAT || ph->cbAlternative != sizeof(*pca)
+        || ph->cAlternatives < 1 || cb != sizeof(*ph) + (size_t) ph->cAlternatives * sizeof(*pca)) {
+        g_mapped_file_unref(pmf);
+        errno = EINVAL;
+        return -1;
+    }
+
+    prcp->cAlternatives = ph->cAlternatives;
+    prcp->fCubeRollout = ph->fCubeRollout;
+    prcp->fInvert = ph->fInvert;
+    prcp->fStatistics = ph->fStatistics;
+    prcp->rc = ph->rc;
+
+    prcp->aanBoard = g_new(TanBoard, prcp->cAlternatives);
+    prcp->aci = g_new(cubeinfo, prcp->cAlternatives);
+    prcp->afCubeDecTop = g_new(int, prcp->cAlternatives);
+    prcp->aes = g_new0(evalsetup, prcp->cAlternatives);
+    prcp->aarOutput = g_malloc(prcp->cAlternatives * sizeof(*prcp->aarOutput));
+    prcp->aarStdDev = g_malloc(prcp->cAlternatives * sizeof(*prcp->aarStdDev));
+    prcp->aarsStatistics = g_malloc(prcp->cAlternatives * sizeof(*prcp->aarsStatistics));
+
+    pca = (const checkpointalternative *) (ph + 1);
+
+    for (alt = 0; alt < prcp->cAlternatives; alt++, pca++) {
+        unsigned int n = pca->nGames;
+
+        memcpy(prcp->aanBoard[alt], pca->anBoard, sizeof(TanBoard));
+        prcp->aci[alt] = pca->ci;
+        prcp->afCubeDecTop[alt] = pca->fCubeDecTop;
+        prcp->aes[alt].et = n ? EVAL_ROLLOUT : EVAL_NONE;
+        prcp->aes[alt].rc = pca->rc;
+        memcpy(prcp->aarsStatistics[alt], pca->ars, sizeof(pca->ars));
+
+        /* the mean and standard error RolloutGeneral() picks up
+         * extended rollouts with */
+        for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+            float rVariance = n > 1 ? pca->arM2[j] / (float) (n - 1) : 0.0f;
+
+            prcp->aarOutput[alt][j] = n ? pca->arSum[j] / (float) n : 0.0f;
+            prcp->aarStdDev[alt][j] = n ? sqrtf(rVariance / (float) n) : 0.0f;
+        }
+    }
+
+    g_mapped_file_unref(pmf);
+
+    return 0;
+}
+
+extern void
+RolloutCheckpointFree(rolloutcheckpoint * prcp)
+{
+    g_free(prcp->aanBoard);
+    g_free(prcp->aci);
+    g_free(prcp->afCubeDecTop);
+    g_free(prcp->aes);
+    g_free(prcp->aarOutput);
+    g_free(prcp->aarStdDev);
+    g_free(prcp->aarsStatistics);
+}
+
+/* Go on with the rollout of prcp, with the settings it was started
+ * with, writing the checkpoint to szFile again */
+extern int
+RolloutCheckpointResume(rolloutcheckpoint * prcp, const char *szFile, rolloutprogressfunc * pf, void *p)
+{
+    ConstTanBoard *apBoard = g_new(ConstTanBoard, prcp->cAlternatives);
+    float (**apOutput)[NUM_ROLLOUT_OUTPUTS] = g_malloc(prcp->cAlternatives * sizeof(*apOutput));
+    float (**apStdDev)[NUM_ROLLOUT_OUTPUTS] = g_malloc(prcp->cAlternatives * sizeof(*apStdDev));
+    evalsetup **apes = g_new(evalsetup *, prcp->cAlternatives);
+    const cubeinfo **apci = g_new(const cubeinfo *, prcp->cAlternatives);
+    int **apCubeDecTop = g_new(int *, prcp->cAlternatives);
+    rolloutcontext rcRolloutSave = rcRollout;
+    char *szCheckpointSave = szRolloutCheckpoint;
+    int alt, n;
+
+    for (alt = 0; alt < prcp->cAlternatives; alt++) {
+        apBoard[alt] = (ConstTanBoard) prcp->aanBoard[alt];
+        apOutput[alt] = &prcp->aarOutput[alt];
+        apStdDev[alt] = &prcp->aarStdDev[alt];
+        apes[alt] = &prcp->aes[alt];
+        apci[alt] = &prcp->aci[alt];
+        apCubeDecTop[alt] = &prcp->afCubeDecTop[alt];
+    }
+
+    rcRollout = prcp->rc;
+    szRolloutCheckpoint = (char *) szFile;
+
+    n = RolloutGeneral(apBoard, apOutput, apStdDev, prcp->fStatistics ? prcp->aarsStatistics : NULL,
+                       apes, apci, apCubeDecTop, prcp->cAlternatives, prcp->fInvert, prcp->fCubeRollout, pf, p);
+
+    rcRollout = rcRolloutSave;
+    szRolloutCheckpoint = szCheckpointSave;
+
+    g_free(apBoard);
+    g_free(apOutput);
+    g_free(apStdDev);
+    g_free(apes);
+    g_free(apci);
+    g_free(apCubeDecTop);
+
+    return n;
+}
+
 /*
  * General evaluation functions.
  */
@@ -1650,6 +2943,7 @@ GeneralCubeDecisionR(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
                      cubeinfo * pci, rolloutcontext * prc, evalsetup * pes, rolloutprogressfunc * pf, void *p)
 {
     evalsetup esLocal;
+    evalsetup aes[2];
     evalsetup(*apes[2]);
     cubeinfo aci[2];
     const cubeinfo(*apci[2]);
@@ -1678,7 +2972,11 @@ GeneralCubeDecisionR(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
         pes->rc.nGamesDone = 0;
     }
 
-    apes[0] = apes[1] = pes;
+    /* no double and double, take are rolled out, and stopped, on their
+     * own; they share the seed, and so the dice of each trial */
+    aes[0] = aes[1] = *pes;
+    apes[0] = &aes[0];
+    apes[1] = &aes[1];
 
     SetCubeInfo(&aci[0], pci->nCube, pci->fCubeOwner, pci->fMove,
                 pci->nMatchTo, pci->anScore, pci->fCrawford, pci->fJacoby, pci->fBeavers, pci->bgv);
@@ -1700,6 +2998,9 @@ GeneralCubeDecisionR(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
                                   aarsStatistics, apes, apci, apCubeDecTop, 2, FALSE, TRUE, pf, p)) <= 0)
         return -1;
 
+    /* the decision is stored with the games of the longer of the two */
+    pes->et = EVAL_ROLLOUT;
+    pes->rc = aes[1].rc;
     pes->rc.nGamesDone = nTrials;
     pes->rc.nSkip = MT_SafeGet(&nSkip);
 
@@ -1732,6 +3033,61 @@ initRolloutstat(rolloutstat * prs)
 
 
 
+/* Whether the player on roll in the race anBoard wins some games: when
+ * rolling 66 every time bears off no later than the opponent rolling 21
+ * every time */
+static int
+RaceCanWin(const TanBoard anBoard)
+{
+    unsigned int i, nSixes = 0, nPips = 0, nChequers = 0;
+    unsigned int nRolls, nRollsOpponent;
+
+    for (i = 0; i < 25; i++) {
+        nSixes += anBoard[1][i] * ((i + 6) / 6);
+        nPips += anBoard[0][i] * (i + 1);
+        nChequers += anBoard[0][i];
+    }
+
+    nRolls = (nSixes + 3) / 4;
+    nRollsOpponent = MAX((nPips + 2) / 3, (nChequers + 1) / 2);
+
+    return nRolls <= nRollsOpponent;
+}
+
+/* The resignation the outputs arResign call for: 0 for none, or 1, 2 or 3
+ * for a normal, gammon or backgammon one */
+extern int
+ResignDecision(const float arResign[NUM_ROLLOUT_OUTPUTS], const cubeinfo * pci)
+{
+    float ar[NUM_OUTPUTS] = { 0.0, 0.0, 0.0, 1.0, 1.0 };
+    float rPlay = Utility(arResign, pci);
+
+    if (arResign[OUTPUT_LOSEBACKGAMMON] > 0.0f && Utility(ar, pci) == rPlay)
+        /* resign backgammon */
+        return (!pci->nMatchTo && pci->fJacoby && pci->fCubeOwner == -1) ? 1 : 3;
+    else {
+
+        /* worth trying to escape the backgammon */
+
+        ar[OUTPUT_LOSEBACKGAMMON] = 0.0f;
+
+        if (arResign[OUTPUT_LOSEGAMMON] > 0.0f && Utility(ar, pci) == rPlay)
+            /* resign gammon */
+            return (!pci->nMatchTo && pci->fJacoby && pci->fCubeOwner == -1) ? 1 : 2;
+        else {
+
+            /* worth trying to escape gammon */
+
+            ar[OUTPUT_LOSEGAMMON] = 0.0f;
+
+            return Utility(ar, pci) == rPlay;
+
+        }
+
+    }
+
+}
+
 /*
  * Calculate whether we should resign or not
  *
@@ -1741,7 +3097,7 @@ initRolloutstat(rolloutstat * prs)
  *    pesResign - evaluation parameters
  *
  * Output:
- *    arResign  - evaluation
+ *    arResign  - evaluation, or NULL if only the decision is wanted
  *
  * Returns:
  *    -1 on error
@@ -1749,6 +3105,10 @@ initRolloutstat(rolloutstat * prs)
  *     1,2, or 3 if we should resign normal, gammon, or backgammon,
  *     respectively.  
  *
+ * Positions in the exact bearoff databases are looked up at 0 plies
+ * whatever pesResign asks for, and without arResign a race the player
+ * can still win isn't evaluated at all.
+ *
  */
 
 extern int
@@ -1756,43 +3116,35 @@ getResignation(float arResign[NUM_ROLLOUT_OUTPUTS], TanBoard anBoard, cubeinfo *
 {
 
     float arStdDev[NUM_ROLLOUT_OUTPUTS];
-    rolloutstat arsStatistics[2];
-    float ar[NUM_OUTPUTS] = { 0.0, 0.0, 0.0, 1.0, 1.0 };
+    float ar[NUM_ROLLOUT_OUTPUTS];
+    positionclass pc = ClassifyPosition((ConstTanBoard) anBoard, pci->bgv);
 
-    float rPlay;
+    if (!arResign) {
+        if (pc == CLASS_RACE && RaceCanWin((ConstTanBoard) anBoard))
+            return 0;
+        arResign = ar;
+    }
 
     /* Evaluate current position */
 
-    if (GeneralEvaluation(arResign, arStdDev, arsStatistics, anBoard, pci, pesResign, NULL, NULL) < 0)
-        return -1;
-
-    /* check if we want to resign */
-
-    rPlay = Utility(arResign, pci);
-
-    if (arResign[OUTPUT_LOSEBACKGAMMON] > 0.0f && Utility(ar, pci) == rPlay)
-        /* resign backgammon */
-        return (!pci->nMatchTo && pci->fJacoby && pci->fCubeOwner == -1) ? 1 : 3;
-    else {
-
-        /* worth trying to escape the backgammon */
-
-        ar[OUTPUT_LOSEBACKGAMMON] = 0.0f;
-
-        if (arResign[OUTPUT_LOSEGAMMON] > 0.0f && Utility(ar, pci) == rPlay)
-            /* resign gammon */
-            return (!pci->nMatchTo && pci->fJacoby && pci->fCubeOwner == -1) ? 1 : 2;
-        else {
-
-            /* worth trying to escape gammon */
+    if (pc <= CLASS_PERFECT && pesResign->et != EVAL_NONE) {
+        evalsetup esExact = *pesResign;
 
-            ar[OUTPUT_LOSEGAMMON] = 0.0f;
+        esExact.et = EVAL_EVAL;
+        esExact.ec.fCubeful = pesResign->et == EVAL_EVAL ? pesResign->ec.fCubeful : pesResign->rc.fCubeful;
+        esExact.ec.nPlies = 0;
+        esExact.ec.fUsePrune = FALSE;
+        esExact.ec.fDeterministic = TRUE;
+        esExact.ec.rNoise = 0.0f;
 
-            return Utility(ar, pci) == rPlay;
+        if (GeneralEvaluation(arResign, arStdDev, NULL, anBoard, pci, &esExact, NULL, NULL) < 0)
+            return -1;
+    } else if (GeneralEvaluation(arResign, arStdDev, NULL, anBoard, pci, pesResign, NULL, NULL) < 0)
+        return -1;
 
-        }
+    /* check if we want to resign */
 
-    }
+    return ResignDecision(arResign, pci);
 
 }
 
@@ -1817,6 +3169,15 @@ getResignEquities(float arResign[NUM_ROLLOUT_OUTPUTS], cubeinfo * pci, int nResi
 
 extern int
 ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves, rolloutprogressfunc * pfRolloutProgress, void * pUserData)
+{
+    return ScoreMoveRolloutJobs(ppm, ppci, cMoves, NULL, 1, NULL, pfRolloutProgress, pUserData);
+}
+
+/* ScoreMoveRollout() of the plays of cJobs decisions, aiJob[] being the
+ * decision of each play in ppm and aszJob[] their names */
+extern int
+ScoreMoveRolloutJobs(move ** ppm, cubeinfo ** ppci, int cMoves, const int aiJob[], int cJobs,
+                     const char *const aszJob[], rolloutprogressfunc * pfRolloutProgress, void *pUserData)
 {
     int fCubeDecTop = TRUE;
     int i;
@@ -1849,9 +3210,9 @@ ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves, rolloutprogressfunc
         aci[i].fMove = !aci[i].fMove;
     }
 
-    nGamesDone = RolloutGeneral(apBoard,
-                                apOutput, apStdDev, NULL, apes, apci, apCubeDecTop, cMoves, TRUE, FALSE,
-                                pfRolloutProgress, pUserData);
+    nGamesDone = RolloutJobs(apBoard,
+                             apOutput, apStdDev, NULL, apes, apci, apCubeDecTop, cMoves, TRUE, FALSE,
+                             aiJob, cJobs, aszJob, pfRolloutProgress, pUserData);
     /* put fMove back again */
     for (i = 0; i < cMoves; ++i) {
         aci[i].fMove = !aci[i].fMove;
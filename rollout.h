@@ -79,6 +79,44 @@ RolloutGeneral(ConstTanBoard * apBoard,
                int *apCubeDecTop[], int alternatives,
                int fInvert, int fCubeRollout, rolloutprogressfunc * pfRolloutProgress, void *pUserData);
 
+/* "set rollout checkpoint": where rollouts save their state, or NULL */
+extern char *szRolloutCheckpoint;
+
+/* "set rollout progresslog": where rollouts log their telemetry, or
+ * NULL */
+extern char *szRolloutProgressLog;
+
+/* How a rollout is doing, see RolloutTelemetry() */
+typedef struct {
+    double rGamesPerSec;        /* of the alternative, since the rollout started */
+    double rUtilisation;        /* of the calculation threads, from 0 to 1 */
+    double rStdErr;             /* the STD rStdLimit applies to, or -1 */
+    double rSecondsToLimit;     /* until it is down to rStdLimit, or -1 if unknown */
+} rollouttelemetry;
+
+extern int RolloutTelemetry(int alt, rollouttelemetry * prt);
+
+/* a rollout read back from its checkpoint */
+typedef struct {
+    int cAlternatives;
+    int fCubeRollout;
+    int fInvert;
+    int fStatistics;
+    rolloutcontext rc;          /* rcRollout of the rollout */
+    TanBoard *aanBoard;
+    cubeinfo *aci;
+    int *afCubeDecTop;
+    evalsetup *aes;
+    float (*aarOutput)[NUM_ROLLOUT_OUTPUTS];
+    float (*aarStdDev)[NUM_ROLLOUT_OUTPUTS];
+    rolloutstat(*aarsStatistics)[2];
+} rolloutcheckpoint;
+
+extern int RolloutCheckpointLoad(const char *szFile, rolloutcheckpoint * prcp);
+extern void RolloutCheckpointFree(rolloutcheckpoint * prcp);
+extern int RolloutCheckpointResume(rolloutcheckpoint * prcp, const char *szFile,
+                                   rolloutprogressfunc * pfRolloutProgress, void *pUserData);
+
 extern int
 GeneralEvaluation(float arOutput[NUM_ROLLOUT_OUTPUTS],
                   float arStdDev[NUM_ROLLOUT_OUTPUTS],
@@ -115,6 +153,8 @@ GeneralCubeDecisionR(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
 
 /* Resignations */
 
+extern int ResignDecision(const float arResign[NUM_ROLLOUT_OUTPUTS], const cubeinfo * pci);
+
 extern int
 getResignation(float arResign[NUM_ROLLOUT_OUTPUTS],
                TanBoard anBoard, cubeinfo * const pci, const evalsetup * pesResign);
@@ -126,29 +166,48 @@ extern int
 ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves,
                  rolloutprogressfunc * pfRolloutProgress, void *pUserData);
 
+extern int
+ScoreMoveRolloutJobs(move ** ppm, cubeinfo ** ppci, int cMoves, const int aiJob[], int cJobs,
+                     const char *const aszJob[], rolloutprogressfunc * pfRolloutProgress, void *pUserData);
+
 extern void RolloutLoopMT(void *unused);
 
 /* Quasi-random permutation array: the first index is the "generation" of the
  * permutation (0 permutes each set of 36 rolls, 1 permutes those sets of 36
  * into 1296, etc.); the second is the roll within the game (limited to QRLEN,
  * so we use pseudo-random dice after that); the last is the permutation
- * itself.  6 generations are enough for 36^6 > 2^31 trials. */
+ * itself.  6 generations are enough for 36^6 > 2^31 trials.
+ * With fSobol the roll of a turn is instead the turn's coordinate of a
+ * point of a digitally shifted Sobol sequence, one point per trial and
+ * one dimension per turn up to QRLEN. */
 #define QRLEN 128
+#define SOBOL_BITS 32
 typedef struct {
     unsigned char aaanPermutation[6][QRLEN][36];
+    unsigned int aanSobol[QRLEN][SOBOL_BITS];   /* direction numbers */
+    unsigned int anSobolShift[QRLEN];
     int nPermutationSeed;
 } perArray;
 
 EXP_LOCK_FUN(int, BasicCubefulRollout, unsigned int aanBoard[][2][25], float aarOutput[][NUM_ROLLOUT_OUTPUTS],
-             int iTurn, int iGame, const cubeinfo aci[], int afCubeDecTop[], unsigned int cci, rolloutcontext * prc,
-             rolloutstat aarsStatistics[][2], int nBasisCube, perArray * dicePerms, rngcontext * rngctxRollout,
-             FILE * logfp);
+             int iTurn, const int aiGame[], const cubeinfo aci[], int afCubeDecTop[], unsigned int cci, int fSameDice,
+             rolloutcontext * prc, rolloutstat aarsStatistics[][2], int nBasisCube, perArray * dicePerms,
+             rngcontext * argctxRollout[], GString * pgsLog);
+
+/* "set rollout lockstep": games of an alternative each thread plays at once */
+#define MAX_ROLLOUT_LOCKSTEP 64
+extern unsigned int cRolloutLockstep;
 
+extern int RolloutTrial(const TanBoard anBoard, float aar[NUM_ROLLOUT_OUTPUTS], int iTrial, const cubeinfo * pci,
+                        int afCubeDecTop[], rolloutcontext * prc, rolloutstat aarsStatistics[][2], int nBasisCube,
+                        perArray * pdicePerms, rngcontext * rngctx, GString * pgsLog);
 
-extern void log_cube(FILE * logfp, const char *action, int side);
-extern void log_move(FILE * logfp, const int *anMove, int side, int die0, int die1);
+extern void log_cube(GString * pgsLog, const char *action, int side);
+extern void log_move(GString * pgsLog, const int *anMove, int side, int die0, int die1);
+extern int RolloutLogExtract(const char *szLog, int iTrial, int iAlt);
 extern int RolloutDice(int iTurn, int iGame, int fInitial, unsigned int anDice[2], rng * rngx, void *rngctx,
-                       const int fRotate, const perArray * dicePerms);
+                       const int fRotate, const int fSobol, const perArray * dicePerms);
 extern void ClosedBoard(int afClosedBoard[2], const TanBoard anBoard);
 extern void InvertStdDev(float ar[NUM_ROLLOUT_OUTPUTS]);
+extern void InitVarRednCache(void);
 #endif
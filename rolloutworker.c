@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+/*
+ * The trials go over the wire as they are in memory, so the workers
+ * have to run the same build of gnubg, or at least one for the same
+ * platform with the same weights and evaluation settings.  The worker
+ * says what it is running when a rollout connects and the rollout
+ * hangs up if it doesn't match.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <glib.h>
+
+#if HAVE_SOCKETS
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif                          /* #if HAVE_UNISTD_H */
+
+#ifndef WIN32
+
+#include <signal.h>
+
+#if HAVE_SYS_SOCKET_H
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#endif                          /* #if HAVE_SYS_SOCKET_H */
+
+#else                           /* #ifndef WIN32 */
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#endif                          /* #ifndef WIN32 */
+
+#endif                          /* HAVE_SOCKETS */
+
+#include "backgammon.h"
+#include "external.h"
+#include "multithread.h"
+#include "rollout.h"
+#include "rolloutworker.h"
+
+/* "set rollout workers": host:port ..., or NULL */
+char *szRolloutWorkers = NULL;
+
+#if HAVE_SOCKETS
+
+#define RW_MAGIC "gnubgrw2"
+
+/* how long to wait for a worker before giving it up, in seconds */
+#define RW_TIMEOUT 60
+
+/* what the worker tells a rollout when it connects */
+typedef struct {
+    char szMagic[8];
+    unsigned int cbJob;
+    char szWeights[8];
+    int fFastSigmoid;
+    unsigned int cThreads;
+} rwhello;
+
+/* one trial to play */
+typedef struct {
+    int iTrial;
+    int fCubeDecTop;
+    int nBasisCube;
+    int fStatistics;
+    TanBoard anBoard;
+    cubeinfo ci;
+    rolloutcontext rc;
+} rwjob;
+
+/* ...and what came of it */
+typedef struct {
+    int nResult;
+    float ar[NUM_ROLLOUT_OUTPUTS];
+    rolloutstat ars[2];
+} rwresult;
+
+struct _rolloutworker {
+    int h;
+};
+
+static void
+RWHello(rwhello * prwh)
+{
+    memset(prwh, 0, sizeof(*prwh));
+
+    memcpy(prwh->szMagic, RW_MAGIC, sizeof(prwh->szMagic));
+    prwh->cbJob = sizeof(rwjob);
+    g_strlcpy(prwh->szWeights, WEIGHTS_VERSION, sizeof(prwh->szWeights));
+    prwh->fFastSigmoid = EvalGetFastSigmoid();
+    prwh->cThreads = MT_GetNumThreads();
+}
+
+/* Wait until h can be read from (fWrite FALSE) or written to and
+ * return 0, -1 on errors or time out */
+static int
+RWWait(int h, int fWrite, int nTimeout)
+{
+    int nWaited = 0;
+
+    /* look at MT_Cancelled() every second, so that a rollout
+     * can be stopped while a worker is busy */
+    while (nWaited < nTimeout) {
+        fd_set fds;
+        struct timeval tv;
+        int n;
+
+        if (MT_Cancelled()) {
+            errno = EINTR;
+            return -1;
+        }
+
+        FD_ZERO(&fds);
+        FD_SET(h, &fds);
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+
+        n = select(h + 1, fWrite ? NULL : &fds, fWrite ? &fds : NULL, NULL, &tv);
+
+        if (n > 0)
+            return 0;
+        else if (n < 0 && errno != EINTR)
+            return -1;
+
+        nWaited++;
+    }
+
+    errno = ETIMEDOUT;
+    return -1;
+}
+
+static int
+RWSend(int h, const void *p, size_t cb, int nTimeout)
+{
+    const char *pch = (const char *) p;
+#ifndef WIN32
+    psighandler sh;
+#endif
+
+    while (cb) {
+        ssize_t n;
+
+        if (RWWait(h, TRUE, nTimeout))
+            return -1;
+
+#ifndef WIN32
+        PortableSignal(SIGPIPE, SIG_IGN, &sh, FALSE);
+#endif
+        n = send(h, pch, cb, 0);
+#ifndef WIN32
+        PortableSignalRestore(SIGPIPE, &sh);
+#endif
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        cb -= (size_t) n;
+        pch += n;
+    }
+
+    return 0;
+}
+
+static int
+RWRecv(int h, void *p, size_t cb, int nTimeout)
+{
+    char *pch = (char *) p;
+
+    while (cb) {
+        ssize_t n;
+
+        if (RWWait(h, FALSE, nTimeout))
+            return -1;
+
+        n = recv(h, pch, cb, 0);
+
+        if (n == 0) {
+            /* connection closed */
+            errno = ECONNRESET;
+            return -1;
+        } else if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        cb -= (size_t) n;
+        pch += n;
+    }
+
+    return 0;
+}
+
+/* Open a connection to the worker at sz and read its hello */
+static int
+RWConnect(const char *sz, rwhello * prwh)
+{
+    struct sockaddr *psa;
+    socklen_t cb;
+    char *szAddress = g_strdup(sz);
+    rwhello rwhOurs;
+    int h;
+
+    h = ExternalSocket(&psa, &cb, szAddress);
+    g_free(szAddress);
+
+    if (h < 0) {
+        SockErr(sz);
+        return -1;
+    }
+
+    if (connect(h, psa, cb) < 0) {
+        SockErr(sz);
+        g_free(psa);
+        closesocket(h);
+        return -1;
+    }
+
+    g_free(psa);
+
+    if (RWRecv(h, prwh, sizeof(*prwh), RW_TIMEOUT)) {
+        SockErr(sz);
+        closesocket(h);
+        return -1;
+    }
+
+    RWHello(&rwhOurs);
+
+    if (memcmp(prwh->szMagic, rwhOurs.szMagic, sizeof(rwhOurs.szMagic)) || prwh->cbJob != rwhOurs.cbJob
+        || strncmp(prwh->szWeights, rwhOurs.szWeights, sizeof(rwhOurs.szWeights))
+        || prwh->fFastSigmoid != rwhOurs.fFastSigmoid) {
+        outputerrf(_("The rollout worker at %s does not run the same build and settings "
+                     "of GNU Backgammon as this one; it will not be used."), sz);
+        closesocket(h);
+        return -1;
+    }
+
+    return h;
+}
+
+extern GList *
+RolloutWorkersConnect(void)
+{
+    GList *pl = NULL;
+    char **aszWorkers, **psz;
+
+    if (!szRolloutWorkers)
+        return NULL;
+
+    aszWorkers = g_strsplit_set(szRolloutWorkers, " \t,", -1);
+
+    for (psz = aszWorkers; *psz; psz++) {
+        rwhello rwh;
+        unsigned int i, cThreads = 1;
+
+        if (!**psz)
+            continue;
+
+        /* the first connection tells how many threads the worker
+         * has; one more for each of the others */
+        for (i = 0; i < cThreads; i++) {
+            rolloutworker *prw;
+            int h = RWConnect(*psz, &rwh);
+
+            if (h < 0)
+                break;
+
+            if (!i)
+                cThreads = rwh.cThreads;
+
+            prw = g_malloc(sizeof(*prw));
+            prw->h = h;
+            pl = g_list_prepend(pl, prw);
+        }
+    }
+
+    g_strfreev(aszWorkers);
+
+    return pl;
+}
+
+extern void
+RolloutWorkerClose(rolloutworker * prw)
+{
+    closesocket(prw->h);
+    g_free(prw);
+}
+
+extern int
+RolloutWorkerTrial(rolloutworker * prw, const TanBoard anBoard, float aar[NUM_ROLLOUT_OUTPUTS], int iTrial,
+                   const cubeinfo * pci, int fCubeDecTop, const rolloutcontext * prc, rolloutstat ars[2],
+                   int nBasisCube)
+{
+    rwjob job;
+    rwresult res;
+
+    memset(&job, 0, sizeof(job));
+    job.iTrial = iTrial;
+    job.fCubeDecTop = fCubeDecTop;
+    job.nBasisCube = nBasisCube;
+    job.fStatistics = ars != NULL;
+    memcpy(job.anBoard, anBoard, sizeof(job.anBoard));
+    job.ci = *pci;
+    job.rc = *prc;
+
+    /* a trial can take a while with a slow evaluation... */
+    if (RWSend(prw->h, &job, sizeof(job), RW_TIMEOUT) || RWRecv(prw->h, &res, sizeof(res), 10 * RW_TIMEOUT)
+        || res.nResult < 0)
+        return -1;
+
+    memcpy(aar, res.ar, sizeof(res.ar));
+
+    if (ars)
+        memcpy(ars, res.ars, sizeof(res.ars));
+
+    return 0;
+}
+
+/* Play the trials a rollout sends over h until it hangs up */
+static void
+RWServe(int h)
+{
+    rngcontext *rngctx = CopyRNGContext(rngctxRollout);
+    perArray dicePerms;
+    rwhello rwh;
+    rwjob job;
+
+    dicePerms.nPermutationSeed = -1;
+
+    RWHello(&rwh);
+
+    if (RWSend(h, &rwh, sizeof(rwh), RW_TIMEOUT))
+        goto done;
+
+    /* wait for as long as the rollout keeps the connection open */
+    while (!RWRecv(h, &job, sizeof(job), G_MAXINT)) {
+        rwresult res;
+        int afCubeDecTop[1];
+
+        memset(&res, 0, sizeof(res));
+
+        afCubeDecTop[0] = job.fCubeDecTop;
+
+        /* the dice of these can't be played over here */
+        if (job.rc.rngRollout == RNG_MANUAL || job.rc.rngRollout == RNG_FILE)
+            res.nResult = -1;
+        else
+            res.nResult = RolloutTrial((ConstTanBoard) job.anBoard, res.ar, job.iTrial, &job.ci, afCubeDecTop, &job.rc,
+                                       job.fStatistics ? &res.ars : NULL, job.nBasisCube, &dicePerms, rngctx, NULL);
+
+        if (RWSend(h, &res, sizeof(res), RW_TIMEOUT))
+            break;
+    }
+
+  done:
+    closesocket(h);
+    free_rngctx(rngctx);
+}
+
+#if defined(USE_MULTITHREAD)
+static void
+RWServeTask(void *p)
+{
+    RWServe(GPOINTER_TO_INT(p));
+}
+#endif
+
+#endif                          /* HAVE_SOCKETS */
+
+extern void
+CommandRolloutWorker(char *sz)
+{
+#if !defined(HAVE_SOCKETS)
+    (void) sz;                  /* silence compiler warning */
+    outputl(_("This installation of GNU Backgammon was compiled without\n"
+              "socket support, and cannot be a rollout worker."));
+#else
+    int h, hPeer;
+    socklen_t cb;
+    struct sockaddr *psa;
+    struct sockaddr_in saRemote;
+    socklen_t saLen;
+
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify the socket to wait for rollouts on (see `help rolloutworker')."));
+        return;
+    }
+
+    if ((h = ExternalSocket(&psa, &cb, sz)) < 0) {
+        SockErr(sz);
+        return;
+    }
+
+    if (bind(h, psa, cb) < 0) {
+        SockErr(sz);
+        closesocket(h);
+        g_free(psa);
+        return;
+    }
+
+    g_free(psa);
+
+    if (listen(h, (int) MT_GetNumThreads()) < 0) {
+        SockErr("listen");
+        closesocket(h);
+        return;
+    }
+
+    InitVarRednCache();
+
+    outputf(_("Waiting for rollouts to connect to %s...\n"), sz);
+    outputx();
+    ProcessEvents();
+
+    for (;;) {
+        /* Must set length when using windows */
+        saLen = sizeof(struct sockaddr);
+
+        if ((hPeer = accept(h, (struct sockaddr *) &saRemote, &saLen)) < 0) {
+            if (errno == EINTR) {
+                ProcessEvents();
+
+                if (MT_SafeGet(&fInterrupt))
+                    break;
+
+                continue;
+            }
+
+            SockErr("accept");
+            break;
+        }
+
+        outputf(_("Accepted connection from %s.\n"), inet_ntoa(saRemote.sin_addr));
+        outputx();
+
+#if defined(USE_MULTITHREAD)
+        /* each connection keeps one of the threads busy for as long as
+         * the rollout lasts; the rollout asks for no more than that */
+        mt_add_tasks(1, RWServeTask, GINT_TO_POINTER(hPeer), NULL, TASK_ROLLOUT);
+#else
+        RWServe(hPeer);
+#endif
+    }
+
+    closesocket(h);
+
+#if defined(USE_MULTITHREAD)
+    MT_WaitForTasks(NULL, 1000, FALSE);
+#endif
+#endif                          /* HAVE_SOCKETS */
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+/*
+ * Rollout trials played by other gnubg processes.  A gnubg running
+ * "rolloutworker <host:port>" waits for rollouts to connect; the one
+ * with "set rollout workers <host:port> ..." opens as many connections
+ * to each worker as it has threads and hands them trials, one at a
+ * time.  A trial only depends on the rollout context and its number,
+ * so it comes out the same whichever process plays it.
+ */
+
+#ifndef ROLLOUTWORKER_H
+#define ROLLOUTWORKER_H
+
+#include <glib.h>
+#include "eval.h"
+#include "rollout.h"
+
+/* one connection to a worker */
+typedef struct _rolloutworker rolloutworker;
+
+extern char *szRolloutWorkers;
+
+extern GList *RolloutWorkersConnect(void);
+extern int RolloutWorkerTrial(rolloutworker * prw, const TanBoard anBoard, float aar[NUM_ROLLOUT_OUTPUTS], int iTrial,
+                              const cubeinfo * pci, int fCubeDecTop, const rolloutcontext * prc,
+                              rolloutstat ars[2], int nBasisCube);
+extern void RolloutWorkerClose(rolloutworker * prw);
+
+#endif
@@ -0,0 +1,542 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Cube decisions and best moves at every score, see scoregrid.h */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "scoregrid.h"
+#include "backgammon.h"
+#include "drawboard.h"
+#include "matchequity.h"
+#include "matchid.h"
+#include "multithread.h"
+#include "positionid.h"
+#include "lib/simd.h"
+
+typedef struct {
+    int anMove[8];
+    TanBoard anBoard;           /* after it, with the opponent on roll */
+    float arOutput[NUM_OUTPUTS];        /* cubeless, for the opponent */
+    float rCubeX;
+    int fCandidate;             /* kept by the move filter at some score */
+} scoregridmove;
+
+typedef struct {
+    scoregridposition *psgp;
+    unsigned int nMaxAway;
+    const evalcontext *pecCube;
+    const evalcontext *pecChequer;
+    movefilter(*aamf)[MAX_FILTER_PLIES];
+    int *pfFailed;
+} scoregridtask;
+
+/* The cube of psgp at away scores n0, of the player on roll, and n1 in
+ * a match to nMaxAway; FALSE if the cube can't be there */
+static int
+ScoreGridCubeInfo(cubeinfo * pci, const scoregridposition * psgp, unsigned int nMaxAway, unsigned int n0,
+                  unsigned int n1)
+{
+    int fCrawford = (n0 == 1) != (n1 == 1);
+    int anScore[2];
+
+    if (fCrawford && (psgp->nCube > 1 || psgp->fCubeOwner != -1))
+        return FALSE;
+
+    anScore[psgp->fMove] = (int) (nMaxAway - n0);
+    anScore[!psgp->fMove] = (int) (nMaxAway - n1);
+
+    return SetCubeInfo(pci, psgp->nCube, psgp->fCubeOwner, psgp->fMove, (int) nMaxAway, anScore, fCrawford, FALSE,
+                       FALSE, psgp->bgv) == 0;
+}
+
+/* The cubeful equity, or match winning chance, of the player on roll
+ * with *pci from the cubeless evaluation arOutput, as at a leaf of
+ * EvaluatePositionCubeful4(): with the choice of doubling unless fTop */
+static float
+Cubeful(float arOutput[NUM_OUTPUTS], const cubeinfo * pci, float rCubeX, int fTop)
+{
+    cubeinfo aci[2];
+    float arCf[2] = { 0.0f, 0.0f };
+    float arDP[1];
+    float rCubeful;
+    int i;
+
+    MakeCubePos(pci, 1, fTop, aci, FALSE, arDP);
+
+    for (i = 0; i < 2; i++)
+        if (aci[i].nCube > 0)
+            arCf[i] = pci->nMatchTo ? Cl2CfMatch(arOutput, &aci[i], rCubeX) : Cl2CfMoney(arOutput, &aci[i], rCubeX);
+
+    GetECF3(&rCubeful, 1, arCf, arDP, !pci->nMatchTo);
+
+    return rCubeful;
+}
+
+static void
+CubeDecision(scoregridcell * psgc, float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const cubeinfo * pci)
+{
+    psgc->fCube = GetDPEq(NULL, NULL, pci);
+    FindCubeDecision(psgc->arDouble, aarOutput, pci);
+}
+
+/* The cube decisions at all the scores, from one cubeless evaluation;
+ * the positions of the bearoff databases are cheap enough to evaluate
+ * at each score, and only there the cubeful evaluation is exact */
+static int
+ScoreGridCube(scoregridtask * psgt, cubeinfo aci[], int afValid[])
+{
+    scoregridposition *psgp = psgt->psgp;
+    const unsigned int cCells = psgt->nMaxAway * psgt->nMaxAway;
+    positionclass pc = ClassifyPosition((ConstTanBoard) psgp->anBoard, psgp->bgv);
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    float rCubeX;
+    evalcontext ec;
+    cubeinfo ci;
+    unsigned int i;
+    int k;
+
+    if (pc <= CLASS_PERFECT) {
+        float (*aaarOutput)[2][NUM_ROLLOUT_OUTPUTS] = g_malloc(cCells * sizeof(*aaarOutput));
+        cubeinfo *aciValid = g_new(cubeinfo, cCells);
+        int c = 0;
+
+        for (i = 0; i < cCells; i++)
+            if (afValid[i])
+                aciValid[c++] = aci[i];
+
+        if (c && GeneralCubeDecisionScores(aaarOutput, (ConstTanBoard) psgp->anBoard, aciValid, c, psgt->pecCube) < 0) {
+            g_free(aciValid);
+            g_free(aaarOutput);
+            return -1;
+        }
+
+        for (i = 0, c = 0; i < cCells; i++)
+            if (afValid[i])
+                CubeDecision(&psgp->asgc[i], aaarOutput[c++], &aci[i]);
+
+        g_free(aciValid);
+        g_free(aaarOutput);
+        return 0;
+    }
+
+    ec = *psgt->pecCube;
+    ec.fCubeful = FALSE;
+    SetCubeInfoMoney(&ci, 1, -1, psgp->fMove, FALSE, FALSE, psgp->bgv);
+    if (GeneralEvaluationE(arOutput, (ConstTanBoard) psgp->anBoard, &ci, &ec) < 0)
+        return -1;
+
+    rCubeX = EvalEfficiency((ConstTanBoard) psgp->anBoard, pc, ec.nPlies);
+
+    for (i = 0; i < cCells; i++) {
+        float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+        cubeinfo aciCubePos[2];
+
+        if (!afValid[i])
+            continue;
+
+        /* "no double" and "double, take" */
+        aciCubePos[0] = aciCubePos[1] = aci[i];
+        aciCubePos[1].fCubeOwner = !aci[i].fMove;
+        aciCubePos[1].nCube *= 2;
+
+        for (k = 0; k < 2; k++) {
+            memcpy(aarOutput[k], arOutput, NUM_OUTPUTS * sizeof(float));
+            aarOutput[k][OUTPUT_EQUITY] = UtilityME(arOutput, &aciCubePos[k]);
+            aarOutput[k][OUTPUT_CUBEFUL_EQUITY] = Cubeful(arOutput, &aciCubePos[k], rCubeX, TRUE);
+        }
+
+        /* Scale double-take equity */
+        if (!aci[i].nMatchTo)
+            aarOutput[1][OUTPUT_CUBEFUL_EQUITY] *= 2.0f;
+
+        CubeDecision(&psgp->asgc[i], aarOutput, &aci[i]);
+    }
+
+    return 0;
+}
+
+/* Evaluate the move for the opponent, cubeless */
+static int
+EvaluateMove(scoregridmove * psgm, const cubeinfo * pciOpponent, const evalcontext * pec, bgvariation bgv)
+{
+    if (GeneralEvaluationE(psgm->arOutput, (ConstTanBoard) psgm->anBoard, (cubeinfo *) pciOpponent, pec) < 0)
+        return -1;
+
+    psgm->rCubeX = EvalEfficiency((ConstTanBoard) psgm->anBoard, ClassifyPosition((ConstTanBoard) psgm->anBoard, bgv),
+                                  pec->nPlies);
+    return 0;
+}
+
+/* The equity of the player on roll with *pci after the move, the
+ * opponent having the cube */
+static float
+MoveEquity(scoregridmove * psgm, const cubeinfo * pci)
+{
+    cubeinfo ciOpponent;
+    float r;
+
+    SetCubeInfo(&ciOpponent, pci->nCube, pci->fCubeOwner, !pci->fMove, pci->nMatchTo, pci->anScore, pci->fCrawford,
+                pci->fJacoby, pci->fBeavers, pci->bgv);
+
+    r = Cubeful(psgm->arOutput, &ciOpponent, psgm->rCubeX, FALSE);
+
+    return pci->nMatchTo ? 1.0f - r : -r;
+}
+
+static int
+CompareScores(const void *p0, const void *p1)
+{
+    const float r0 = *(const float *) p0, r1 = *(const float *) p1;
+
+    return r0 < r1 ? 1 : r0 > r1 ? -1 : 0;
+}
+
+/* The best moves at all the scores: every move is evaluated at 0 plies,
+ * the ones any score keeps through the filter of aamf once more at the
+ * plies asked for */
+static int
+ScoreGridMoves(scoregridtask * psgt, cubeinfo aci[], int afValid[])
+{
+    scoregridposition *psgp = psgt->psgp;
+    const unsigned int cCells = psgt->nMaxAway * psgt->nMaxAway;
+    const evalcontext *pec = psgt->pecChequer;
+    scoregridmove *asgm;
+    float (*arScore)[2];        /* the equity at a score, and the move */
+    evalcontext ec;
+    cubeinfo ciOpponent;
+    movelist ml;
+    unsigned int i, j, cMoves;
+
+    for (i = 0; i < cCells; i++)
+        psgp->asgc[i].anMove[0] = -1;
+
+    if (!psgp->anDice[0] || !(cMoves = (unsigned int) GenerateMoves(&ml, (ConstTanBoard) psgp->anBoard,
+                                                                     (int) psgp->anDice[0], (int) psgp->anDice[1],
+                                                                     FALSE)))
+        return 0;
+
+    /* the moves of GenerateMoves() are the thread's, that the
+     * evaluations below generate again */
+    asgm = g_new(scoregridmove, cMoves);
+    for (j = 0; j < cMoves; j++) {
+        memcpy(asgm[j].anMove, ml.amMoves[j].anMove, sizeof(asgm[j].anMove));
+        PositionFromKey(asgm[j].anBoard, &ml.amMoves[j].key);
+        SwapSides(asgm[j].anBoard);
+        asgm[j].fCandidate = cMoves == 1 || pec->nPlies == 0;
+    }
+
+    ec = *pec;
+    ec.fCubeful = FALSE;
+    ec.nPlies = 0;
+    SetCubeInfoMoney(&ciOpponent, 1, -1, !psgp->fMove, FALSE, FALSE, psgp->bgv);
+
+    for (j = 0; j < cMoves; j++)
+        if (EvaluateMove(&asgm[j], &ciOpponent, &ec, psgp->bgv) < 0) {
+            g_free(asgm);
+            return -1;
+        }
+
+    arScore = g_malloc(cMoves * sizeof(*arScore));
+
+    if (cMoves > 1 && pec->nPlies > 0) {
+        const movefilter *pmf = &psgt->aamf[pec->nPlies - 1][0];
+
+        for (i = 0; i < cCells; i++) {
+            unsigned int cKeep;
+
+            if (!afValid[i])
+                continue;
+
+            for (j = 0; j < cMoves; j++) {
+                arScore[j][0] = MoveEquity(&asgm[j], &aci[i]);
+                arScore[j][1] = (float) j;
+            }
+            qsort(arScore, cMoves, sizeof(*arScore), CompareScores);
+
+            if (pmf->Accept < 0)
+                cKeep = cMoves;
+            else {
+                cKeep = MIN((unsigned int) pmf->Accept, cMoves);
+                for (j = cKeep; j < cMoves && j < cKeep + (unsigned int) pmf->Extra; j++)
+                    if (arScore[0][0] - arScore[j][0] > pmf->Threshold)
+                        break;
+                cKeep = MAX(j, 1);
+            }
+
+            for (j = 0; j < cKeep; j++)
+                asgm[(int) arScore[j][1]].fCandidate = TRUE;
+        }
+
+        ec.nPlies = pec->nPlies;
+        for (j = 0; j < cMoves; j++)
+            if (asgm[j].fCandidate && EvaluateMove(&asgm[j], &ciOpponent, &ec, psgp->bgv) < 0) {
+                g_free(arScore);
+                g_free(asgm);
+                return -1;
+            }
+    }
+
+    for (i = 0; i < cCells; i++) {
+        scoregridcell *psgc = &psgp->asgc[i];
+        float rBest = 0.0f;
+        int iBest = -1;
+
+        if (!afValid[i])
+            continue;
+
+        for (j = 0; j < cMoves; j++)
+            if (asgm[j].fCandidate) {
+                float r = MoveEquity(&asgm[j], &aci[i]);
+
+                if (iBest < 0 || r > rBest) {
+                    rBest = r;
+                    iBest = (int) j;
+                }
+            }
+
+        memcpy(psgc->anMove, asgm[iBest].anMove, sizeof(psgc->anMove));
+        psgc->rMove = aci[i].nMatchTo ? mwc2eq(rBest, &aci[i]) : rBest;
+    }
+
+    g_free(arScore);
+    g_free(asgm);
+
+    return 0;
+}
+
+SIMD_STACKALIGN static void
+ScoreGridTask(void *p)
+{
+    scoregridtask *psgt = (scoregridtask *) p;
+    scoregridposition *psgp = psgt->psgp;
+    const unsigned int nMaxAway = psgt->nMaxAway;
+    cubeinfo *aci = g_new(cubeinfo, nMaxAway * nMaxAway);
+    int *afValid = g_new(int, nMaxAway * nMaxAway);
+    unsigned int n0, n1;
+
+    if (MT_SafeGet(psgt->pfFailed) || MT_SafeGet(&fInterrupt)) {
+        g_free(afValid);
+        g_free(aci);
+        return;
+    }
+
+    for (n0 = 1; n0 <= nMaxAway; n0++)
+        for (n1 = 1; n1 <= nMaxAway; n1++) {
+            unsigned int i = (n0 - 1) * nMaxAway + n1 - 1;
+
+            memset(&psgp->asgc[i], 0, sizeof(scoregridcell));
+            psgp->asgc[i].fValid = afValid[i] = ScoreGridCubeInfo(&aci[i], psgp, nMaxAway, n0, n1);
+        }
+
+    if (ScoreGridCube(psgt, aci, afValid) < 0 || ScoreGridMoves(psgt, aci, afValid) < 0)
+        MT_SafeSet(psgt->pfFailed, TRUE);
+
+    g_free(afValid);
+    g_free(aci);
+}
+
+/* Read a position from its GNU Backgammon ID, "position ID:match ID",
+ * or a position ID alone for a centred cube and no dice */
+extern int
+ScoreGridFromID(scoregridposition * psgp, const char *sz)
+{
+    char *szPosition = g_strstrip(g_strdup(sz));
+    char *pchMatch = strchr(szPosition, ':');
+    int fTurn, fResigned, fDoubled, fCrawford, nMatchTo, anScore[2], fJacoby;
+    gamestate gs;
+
+    if (pchMatch)
+        *pchMatch++ = 0;
+
+    memset(psgp, 0, sizeof(scoregridposition));
+    psgp->nCube = 1;
+    psgp->fCubeOwner = -1;
+    psgp->bgv = bgvDefault;
+
+    if (strlen(szPosition) != L_POSITIONID || !PositionFromID(psgp->anBoard, szPosition)
+        || (pchMatch && (strlen(pchMatch) != L_MATCHID
+                         || MatchFromID(psgp->anDice, &fTurn, &fResigned, &fDoubled, &psgp->fMove,
+                                        &psgp->fCubeOwner, &fCrawford, &nMatchTo, anScore, &psgp->nCube, &fJacoby,
+                                        &gs, pchMatch) < 0))) {
+        g_free(szPosition);
+        return -1;
+    }
+
+    g_free(szPosition);
+    return 0;
+}
+
+/* Work out the cells of the c positions asgp[], allocating them; -1 if
+ * interrupted */
+extern int
+ScoreGrid(scoregridposition asgp[], unsigned int c, unsigned int nMaxAway, const evalcontext * pecCube,
+          const evalcontext * pecChequer, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    scoregridtask *asgt = g_new(scoregridtask, c ? c : 1);
+    taskgroup tg = { 0 };
+    int fFailed = FALSE;
+    unsigned int i;
+
+    for (i = 0; i < c; i++) {
+        asgp[i].asgc = g_new0(scoregridcell, nMaxAway * nMaxAway);
+        asgt[i].psgp = &asgp[i];
+        asgt[i].nMaxAway = nMaxAway;
+        asgt[i].pecCube = pecCube;
+        asgt[i].pecChequer = pecChequer;
+        asgt[i].aamf = aamf;
+        asgt[i].pfFailed = &fFailed;
+
+        MT_ForkTask(&tg, ScoreGridTask, &asgt[i]);
+    }
+    MT_JoinTasks(&tg);
+
+    g_free(asgt);
+
+    return fFailed || MT_SafeGet(&fInterrupt) ? -1 : 0;
+}
+
+/* "ND", "D/T", "D/P" or "TG", as the score map has it, or "-" if the
+ * cube can't be turned */
+extern const char *
+ScoreGridAction(const scoregridcell * psgc)
+{
+    const float rND = psgc->arDouble[OUTPUT_NODOUBLE];
+    const float rDT = psgc->arDouble[OUTPUT_TAKE];
+    const float rDP = psgc->arDouble[OUTPUT_DROP];
+
+    if (!psgc->fCube)
+        return "-";
+    else if (rND < MIN(rDT, rDP))
+        return rDT < rDP ? "D/T" : "D/P";
+    else if (rDT < rDP || rND < rDP)
+        return "ND";
+    else
+        return "TG";
+}
+
+static void
+PrintScoreGrid(const char *szID, const scoregridposition * psgp, unsigned int nMaxAway)
+{
+    unsigned int n0, n1;
+
+    for (n0 = 1; n0 <= nMaxAway; n0++)
+        for (n1 = 1; n1 <= nMaxAway; n1++) {
+            const scoregridcell *psgc = &psgp->asgc[(n0 - 1) * nMaxAway + n1 - 1];
+            char sz[FORMATEDMOVESIZE];
+            char asz[4][G_ASCII_DTOSTR_BUF_SIZE];
+            int i;
+
+            if (!psgc->fValid)
+                continue;
+
+            for (i = 0; i < 3; i++)
+                g_ascii_formatd(asz[i], sizeof(asz[i]), "%.4f", psgc->arDouble[OUTPUT_NODOUBLE + i]);
+
+            if (psgc->anMove[0] < 0)
+                strcpy(sz, "-");
+            else
+                FormatMove(sz, (ConstTanBoard) psgp->anBoard, psgc->anMove);
+            if (psgc->anMove[0] < 0)
+                strcpy(asz[3], "-");
+            else
+                g_ascii_formatd(asz[3], sizeof(asz[3]), "%.4f", psgc->rMove);
+
+            outputf("%s\t%u\t%u\t%s\t%s\t%s\t%s\t%s\t%s\n", szID, n0, n1, ScoreGridAction(psgc), asz[0], asz[1],
+                    asz[2], sz, asz[3]);
+        }
+}
+
+/* show scoregrid [<max away>] [<file>]: the grid of the current
+ * position, or of the GNU Backgammon IDs in the file, one to a line,
+ * as a table of tab separated columns */
+extern void
+CommandShowScoreGrid(char *sz)
+{
+    unsigned int nMaxAway = SCOREGRID_MAX_AWAY;
+    GPtrArray *pID = g_ptr_array_new_with_free_func(g_free);
+    scoregridposition *asgp;
+    char *pch;
+    unsigned int i, c;
+
+    if ((pch = NextToken(&sz)) != NULL && *pch && strspn(pch, "0123456789") == strlen(pch)) {
+        nMaxAway = (unsigned int) atoi(pch);
+        if (nMaxAway < 1 || nMaxAway > MAXSCORE - 1) {
+            outputf(_("The away scores go up to at most %d.\n"), MAXSCORE - 1);
+            g_ptr_array_free(pID, TRUE);
+            return;
+        }
+        pch = NextToken(&sz);
+    }
+
+    if (pch && *pch) {
+        char szLine[256];
+        FILE *pf;
+
+        if ((pf = g_fopen(pch, "r")) == NULL) {
+            outputerr(pch);
+            g_ptr_array_free(pID, TRUE);
+            return;
+        }
+
+        while (fgets(szLine, sizeof(szLine), pf)) {
+            g_strstrip(szLine);
+            if (*szLine && *szLine != '#')
+                g_ptr_array_add(pID, g_strdup(szLine));
+        }
+        fclose(pf);
+    } else if (ms.gs == GAME_PLAYING)
+        g_ptr_array_add(pID, g_strdup_printf("%s:%s", PositionID(msBoard()), MatchIDFromMatchState(&ms)));
+    else {
+        outputl(_("No game in progress (type `new game' to start one)."));
+        g_ptr_array_free(pID, TRUE);
+        return;
+    }
+
+    c = pID->len;
+    asgp = g_new0(scoregridposition, c ? c : 1);
+
+    for (i = 0; i < c; i++)
+        if (ScoreGridFromID(&asgp[i], g_ptr_array_index(pID, i)) < 0) {
+            outputf(_("`%s' is not a valid GNU Backgammon ID.\n"), (char *) g_ptr_array_index(pID, i));
+            g_free(asgp);
+            g_ptr_array_free(pID, TRUE);
+            return;
+        }
+
+    ProgressStart(_("Evaluating the score grids..."));
+    if (ScoreGrid(asgp, c, nMaxAway, &GetEvalCube()->ec, &GetEvalChequer()->ec, aamfEval) < 0) {
+        ProgressEnd();
+        ResetInterrupt();
+    } else {
+        ProgressEnd();
+        outputl("# id\taway\topponent away\tcube\tno double\tdouble, take\tdouble, pass\tbest move\tequity");
+        for (i = 0; i < c; i++)
+            PrintScoreGrid(g_ptr_array_index(pID, i), &asgp[i], nMaxAway);
+    }
+
+    for (i = 0; i < c; i++)
+        g_free(asgp[i].asgc);
+    g_free(asgp);
+    g_ptr_array_free(pID, TRUE);
+}
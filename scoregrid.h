@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOREGRID_H
+#define SCOREGRID_H
+
+#include "eval.h"
+
+/*
+ * The cube decision and the best move of positions at every pair of
+ * away scores up to nMaxAway, for preparing matches: what "show
+ * scoregrid" and gnubg.scoregrid() print and return.
+ *
+ * Each position is evaluated cubeless once at the plies asked for (and
+ * each candidate move once), and only the cubeful equities are worked
+ * out for each score from those probabilities, with the match equity
+ * table and Janowski's formulae as at the leaves of a cubeful
+ * evaluation: at 0 plies the cube decisions are those of
+ * GeneralCubeDecisionE().  The candidates are the moves any of the
+ * scores keeps through the move filter.  The positions are spread
+ * over the threads.
+ */
+
+#define SCOREGRID_MAX_AWAY 25
+
+typedef struct {
+    int fValid;                 /* a score the cube can be at */
+    int fCube;                  /* the cube can be turned */
+    float arDouble[4];          /* FindCubeDecision(): optimal, no double,
+                                 * take and pass, as equities */
+    int anMove[8];              /* the best move, -1 in anMove[0] for none */
+    float rMove;                /* its equity */
+} scoregridcell;
+
+typedef struct {
+    TanBoard anBoard;           /* with the player on roll in anBoard[1] */
+    unsigned int anDice[2];     /* 0 for only the cube decision */
+    int fMove;
+    int nCube;
+    int fCubeOwner;
+    bgvariation bgv;
+    /* nMaxAway x nMaxAway, by the away scores of the player on roll
+     * and of the opponent; 1-away against more is the Crawford game */
+    scoregridcell *asgc;
+} scoregridposition;
+
+extern int ScoreGridFromID(scoregridposition * psgp, const char *sz);
+extern int ScoreGrid(scoregridposition asgp[], unsigned int c, unsigned int nMaxAway, const evalcontext * pecCube,
+                     const evalcontext * pecChequer, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
+extern const char *ScoreGridAction(const scoregridcell * psgc);
+
+#endif                          /* SCOREGRID_H */
@@ -153,3 +153,8 @@ def PyUpdateCommandReturn(stmt):
 def PyCommit():
     global connection
     connection.commit()
+
+
+def PyRollback():
+    global connection
+    connection.rollback()
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* "selfplay": a series of matches between the evaluation settings of
+ * the two players (see "set player"), played on the calculation
+ * threads without going through the match state, for comparing
+ * settings over many games.
+ *
+ *   selfplay <matches> [length [seed]]
+ *
+ * The length is 7 if not given; 0 plays money games, one per
+ * "match".  The matches are played in pairs on the same dice, with
+ * the players in each other's seats, so that less of the result is
+ * luck.  Each pair has its own dice, seeded from the seed of the
+ * series and the number of the pair: the same seed plays the same
+ * series whatever the number of threads.  Jacoby, beavers and
+ * resignations are not used. */
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+#include <glib.h>
+
+#include "backgammon.h"
+#include "multithread.h"
+
+typedef struct {
+    int fDone;                  /* played to the end */
+    float r;                    /* for player 0: 1 or 0 for the match, or points */
+    int cGames;
+    int acWins[2], acGammons[2], acBackgammons[2];      /* by player */
+} selfplayresult;
+
+typedef struct {
+    int nMatchTo;
+    guint32 nSeed;
+    /* the players' settings when the series was started */
+    evalcontext aecChequer[2];
+    evalcontext aecCube[2];
+    movefilter aaamf[2][MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    selfplayresult *asr;        /* by match, pair after pair */
+} selfplayjob;
+
+typedef struct {
+    Task task;
+    selfplayjob *psj;
+    unsigned int iMatch;
+} selfplaytask;
+
+/* matches done, for the progress bar */
+static int cSelfPlayDone;
+
+static void
+SelfPlayDice(GRand * pr, unsigned int anDice[2])
+{
+    anDice[0] = (unsigned int) g_rand_int_range(pr, 1, 7);
+    anDice[1] = (unsigned int) g_rand_int_range(pr, 1, 7);
+}
+
+static int
+DoublesOut(cubedecision cd)
+{
+    switch (cd) {
+    case DOUBLE_TAKE:
+    case DOUBLE_PASS:
+    case DOUBLE_BEAVER:
+    case REDOUBLE_TAKE:
+    case REDOUBLE_PASS:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/* Play one game at anScore, seat i being player aiPlayer[i].  The
+ * winning seat, with the points won in *pnPoints and 1 to 3 for a
+ * single game, gammon or backgammon in *pnStatus; -1 if cancelled. */
+static int
+SelfPlayGame(selfplayjob * psj, GRand * pr, const int aiPlayer[2], const int anScore[2], int fCrawford,
+             int *pnPoints, int *pnStatus)
+{
+    TanBoard anBoard;
+    unsigned int anDice[2];
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+    float arDouble[4];
+    cubeinfo ci;
+    int fMove, nCube = 1, fCubeOwner = -1, iTurn;
+
+    InitBoard(anBoard, VARIATION_STANDARD);
+
+    /* the opening roll decides who moves first */
+    do
+        SelfPlayDice(pr, anDice);
+    while (anDice[0] == anDice[1]);
+    fMove = anDice[1] > anDice[0];
+
+    for (iTurn = 0;; ++iTurn) {
+        int iPlayer = aiPlayer[fMove];
+
+        if (MT_Cancelled())
+            return -1;
+
+        SetCubeInfo(&ci, nCube, fCubeOwner, fMove, psj->nMatchTo, anScore, fCrawford, FALSE, FALSE,
+                    VARIATION_STANDARD);
+
+        if (iTurn && nCube < MAX_CUBE && GetDPEq(NULL, NULL, &ci)) {
+            if (GeneralCubeDecisionE(aarOutput, (ConstTanBoard) anBoard, &ci, &psj->aecCube[iPlayer], NULL) < 0)
+                return -1;
+
+            if (DoublesOut(FindCubeDecision(arDouble, aarOutput, &ci))) {
+                /* and the opponent takes or drops on their own settings */
+                if (GeneralCubeDecisionE(aarOutput, (ConstTanBoard) anBoard, &ci,
+                                         &psj->aecCube[aiPlayer[!fMove]], NULL) < 0)
+                    return -1;
+                FindCubeDecision(arDouble, aarOutput, &ci);
+
+                if (arDouble[OUTPUT_TAKE] > arDouble[OUTPUT_DROP]) {
+                    *pnPoints = nCube;
+                    *pnStatus = 1;
+                    return fMove;
+                }
+
+                nCube *= 2;
+                fCubeOwner = !fMove;
+                SetCubeInfo(&ci, nCube, fCubeOwner, fMove, psj->nMatchTo, anScore, fCrawford, FALSE, FALSE,
+                            VARIATION_STANDARD);
+            }
+        }
+
+        if (iTurn)
+            SelfPlayDice(pr, anDice);
+
+        if (FindBestMove(NULL, (int) anDice[0], (int) anDice[1], anBoard, &ci, &psj->aecChequer[iPlayer],
+                         psj->aaamf[iPlayer]) < 0)
+            return -1;
+
+        if (ClassifyPosition((ConstTanBoard) anBoard, VARIATION_STANDARD) == CLASS_OVER) {
+            *pnStatus = GameStatus((ConstTanBoard) anBoard, VARIATION_STANDARD);
+            *pnPoints = nCube * *pnStatus;
+            return fMove;
+        }
+
+        SwapSides(anBoard);
+        fMove = !fMove;
+    }
+}
+
+static void
+SelfPlayMatch(selfplaytask * pst)
+{
+    selfplayjob *psj = pst->psj;
+    selfplayresult *psr = &psj->asr[pst->iMatch];
+    guint32 anSeed[2] = { psj->nSeed, pst->iMatch / 2 };
+    GRand *pr = g_rand_new_with_seed_array(anSeed, 2);
+    /* the second match of a pair has the players the other way round */
+    int fSwap = pst->iMatch & 1;
+    int aiPlayer[2] = { fSwap, !fSwap };
+    int anScore[2] = { 0, 0 };
+    int fCrawford = FALSE, fPostCrawford = FALSE;
+
+    memset(psr, 0, sizeof(selfplayresult));
+
+    do {
+        int nPoints, nStatus, fWinner, iWinner;
+
+        fWinner = SelfPlayGame(psj, pr, aiPlayer, anScore, fCrawford, &nPoints, &nStatus);
+        if (fWinner < 0) {
+            g_rand_free(pr);
+            return;
+        }
+
+        iWinner = aiPlayer[fWinner];
+        psr->cGames++;
+        psr->acWins[iWinner]++;
+        if (nStatus == 2)
+            psr->acGammons[iWinner]++;
+        else if (nStatus == 3)
+            psr->acBackgammons[iWinner]++;
+
+        if (!psj->nMatchTo) {
+            psr->r = iWinner ? (float) -nPoints : (float) nPoints;
+            break;
+        }
+
+        anScore[fWinner] += nPoints;
+
+        /* the game after a player first gets to one away is Crawford */
+        fPostCrawford = fPostCrawford || fCrawford;
+        fCrawford = !fPostCrawford && (anScore[0] == psj->nMatchTo - 1 || anScore[1] == psj->nMatchTo - 1);
+
+        if (anScore[fWinner] >= psj->nMatchTo)
+            psr->r = iWinner ? 0.0f : 1.0f;
+    } while (anScore[0] < psj->nMatchTo && anScore[1] < psj->nMatchTo);
+
+    psr->fDone = TRUE;
+    g_rand_free(pr);
+    MT_SafeInc(&cSelfPlayDone);
+}
+
+static gboolean
+UpdateSelfPlayProgress(gpointer UNUSED(unused))
+{
+    ProgressValue(MT_SafeGet(&cSelfPlayDone));
+    return TRUE;
+}
+
+static void
+ShowSelfPlay(const selfplayjob * psj, unsigned int cMatches)
+{
+    selfplayresult sr;
+    double rSum = 0.0, rSumSquares = 0.0, rMean, rHalfWidth;
+    unsigned int i, cPairs = 0;
+    int j;
+
+    memset(&sr, 0, sizeof(sr));
+
+    /* the two matches of a pair are not independent; the interval is
+     * found from the pairs */
+    for (i = 0; i + 1 < cMatches; i += 2) {
+        const selfplayresult *psr = &psj->asr[i];
+        double r;
+
+        if (!psr[0].fDone || !psr[1].fDone)
+            continue;
+
+        r = (psr[0].r + psr[1].r) / 2.0;
+        rSum += r;
+        rSumSquares += r * r;
+        cPairs++;
+
+        for (j = 0; j < 2; ++j) {
+            sr.cGames += psr[j].cGames;
+            sr.acWins[0] += psr[j].acWins[0];
+            sr.acWins[1] += psr[j].acWins[1];
+            sr.acGammons[0] += psr[j].acGammons[0];
+            sr.acGammons[1] += psr[j].acGammons[1];
+            sr.acBackgammons[0] += psr[j].acBackgammons[0];
+            sr.acBackgammons[1] += psr[j].acBackgammons[1];
+            if (psj->nMatchTo)
+                sr.r += psr[j].r;
+        }
+    }
+
+    if (!cPairs) {
+        outputl(_("No matches were completed."));
+        return;
+    }
+
+    rMean = rSum / cPairs;
+    rHalfWidth = cPairs > 1 ? 1.96 * sqrt(MAX(rSumSquares / cPairs - rMean * rMean, 0.0) / (cPairs - 1)) : 0.0;
+
+    outputf(_("%u matches played, %d games (seed %u)\n\n"), 2 * cPairs, sr.cGames, psj->nSeed);
+    outputf("%-20s %12s %12s\n", "", ap[0].szName, ap[1].szName);
+    if (psj->nMatchTo)
+        outputf("%-20s %12d %12d\n", _("Matches won"), (int) sr.r, 2 * (int) cPairs - (int) sr.r);
+    outputf("%-20s %12d %12d\n", _("Games won"), sr.acWins[0], sr.acWins[1]);
+    outputf("%-20s %12d %12d\n", _("Gammons won"), sr.acGammons[0], sr.acGammons[1]);
+    outputf("%-20s %12d %12d\n\n", _("Backgammons won"), sr.acBackgammons[0], sr.acBackgammons[1]);
+
+    if (psj->nMatchTo)
+        outputf(_("%s won %.2f%% of the matches (95%% confidence interval %.2f%% to %.2f%%)\n"),
+                ap[0].szName, 100.0 * rMean, 100.0 * (rMean - rHalfWidth), 100.0 * (rMean + rHalfWidth));
+    else
+        outputf(_("%s won %+.4f points per game (95%% confidence interval %+.4f to %+.4f)\n"),
+                ap[0].szName, rMean, rMean - rHalfWidth, rMean + rHalfWidth);
+
+    if (2 * cPairs < cMatches)
+        outputf(_("(%u matches were not completed)\n"), cMatches - 2 * cPairs);
+}
+
+extern void
+CommandSelfPlay(char *sz)
+{
+    selfplayjob sj;
+    canceltoken ct = { FALSE };
+    canceltoken *pctOld;
+    char *pch;
+    unsigned int i, cMatches;
+    int n, i0;
+
+    if ((n = ParseNumber(&sz)) <= 0) {
+        outputl(_("You must specify how many matches to play (see `help selfplay')."));
+        return;
+    }
+    /* whole pairs */
+    cMatches = (unsigned int) n + ((unsigned int) n & 1);
+
+    sj.nMatchTo = 7;
+    if ((pch = NextToken(&sz)) && (sj.nMatchTo = ParseNumber(&pch)) < 0) {
+        outputl(_("You must specify a valid match length, or 0 for money games."));
+        return;
+    }
+
+    sj.nSeed = g_random_int();
+    if ((pch = NextToken(&sz))) {
+        if ((n = ParseNumber(&pch)) < 0) {
+            outputl(_("You must specify a valid seed."));
+            return;
+        }
+        sj.nSeed = (guint32) n;
+    }
+
+    for (i0 = 0; i0 < 2; ++i0) {
+        if (ap[i0].esChequer.et != EVAL_EVAL || ap[i0].esCube.et != EVAL_EVAL) {
+            outputf(_("The settings of %s use rollouts; self-play only uses evaluations.\n"), ap[i0].szName);
+            return;
+        }
+        sj.aecChequer[i0] = ap[i0].esChequer.ec;
+        sj.aecCube[i0] = ap[i0].esCube.ec;
+        memcpy(sj.aaamf[i0], ap[i0].aamf, sizeof(sj.aaamf[i0]));
+    }
+
+    sj.asr = g_new0(selfplayresult, cMatches);
+    MT_SafeSet(&cSelfPlayDone, 0);
+
+    ProgressStartValue(_("Playing matches"), (int) cMatches);
+    pctOld = MT_SetJob(&ct);
+
+    for (i = 0; i < cMatches; ++i) {
+        selfplaytask *pst = g_new(selfplaytask, 1);
+
+        pst->task.fun = (AsyncFun) SelfPlayMatch;
+        pst->task.data = pst;
+        pst->task.pLinkedTask = NULL;
+        pst->task.priority = TASK_ANALYSIS;
+        pst->task.pct = MT_GetTLD()->pct;
+        pst->psj = &sj;
+        pst->iMatch = i;
+        MT_AddTask((Task *) pst, TRUE);
+    }
+
+    MT_WaitForTasks(UpdateSelfPlayProgress, UI_UPDATETIME, FALSE);
+    MT_SetJob(pctOld);
+    ProgressEnd();
+
+    ShowSelfPlay(&sj, cMatches);
+
+    g_free(sj.asr);
+}
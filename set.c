@@ -55,6 +55,7 @@
 
 #include "backgammon.h"
 #include "dice.h"
+#include "randomorg.h"
 #include "eval.h"
 #include "external.h"
 #include "export.h"
@@ -82,6 +83,7 @@
 #include "inc3d.h"
 #endif
 #include "multithread.h"
+#include "rolloutworker.h"
 
 static int iPlayerSet, iPlayerLateSet;
 
@@ -227,6 +229,26 @@ SetRNG(rng * prng, rngcontext * rngctx, rng rngNew, char *szSeed)
         abort();
 #endif                          /* HAVE_LIBGMP */
 
+#if defined(LIBCURL_PROTOCOL_HTTPS)
+    case RNG_RANDOM_DOT_ORG:
+        if (*szSeed) {
+            int n;
+
+            if (StrNCaseCmp(szSeed, "lowwater", strcspn(szSeed, " \t\n\r\v\f"))) {
+                outputl(_("You can only set the low-water mark of random.org dice (see `help set rng random.org')."));
+                return;
+            }
+            NextToken(&szSeed);     /* skip "lowwater" keyword */
+            if ((n = ParseNumber(&szSeed)) < 0 || n > BUFLENGTH) {
+                outputf(_("You must specify a number of dice from 0 to %d (see `help set rng random.org').\n"),
+                        BUFLENGTH);
+                return;
+            }
+            SetRandomDotOrgLowWater((unsigned int) n);
+        }
+        break;
+#endif
+
     case RNG_FILE:
         {
             char *sz = NextToken(&szSeed);
@@ -236,7 +258,7 @@ SetRNG(rng * prng, rngcontext * rngctx, rng rngNew, char *szSeed)
                 return;
             }
 
-            if (!OpenDiceFile(rngctx, sz)) {
+            if (OpenDiceFile(rngctx, sz) < 0) {
                 outputf(_("File %s does not exist or is not readable\n"), sz);
                 return;
             }
@@ -332,6 +354,24 @@ CommandSetAnalysisBackground(char *sz)
 }
 
 
+extern void
+CommandSetAnalysisCandidates(char *sz)
+{
+    int n = ParseNumber(&sz);
+
+    if (n < 0) {
+        outputl(_("You must specify how many moves to keep (see `help set analysis candidates')."));
+        return;
+    }
+
+    nAnalysisMoves = (unsigned int) n;
+
+    if (nAnalysisMoves)
+        outputf(_("The analysis will keep the %u best moves and the one played.\n"), nAnalysisMoves);
+    else
+        outputl(_("The analysis will keep all the moves it evaluates."));
+}
+
 extern void
 CommandSetAnalysisCube(char *sz)
 {
@@ -341,6 +381,14 @@ CommandSetAnalysisCube(char *sz)
         UpdateSetting(&fAnalyseCube);
 }
 
+extern void
+CommandSetAnalysisCubeScreen(char *sz)
+{
+    SetToggle("analysis cubescreen", &fAnalyseCubeScreen, sz,
+              _("Cube decisions will be looked at with 0-ply first, and only analysed further when they may be close."),
+              _("Cube decisions will be analysed without looking at them with 0-ply first."));
+}
+
 extern void
 CommandSetAnalysisLuck(char *sz)
 {
@@ -362,6 +410,34 @@ CommandSetAnalysisLuckAnalysis(char *sz)
 }
 
 
+extern void
+CommandSetAnalysisJournal(char *sz)
+{
+    char *pch = NextToken(&sz);
+
+    g_free(szAnalysisJournal);
+    szAnalysisJournal = pch && *pch ? g_strdup(pch) : NULL;
+
+    if (szAnalysisJournal)
+        outputf(_("Match analyses will keep a journal in `%s', to resume them from.\n"), szAnalysisJournal);
+    else
+        outputl(_("Match analyses will not keep a journal."));
+}
+
+extern void
+CommandSetAnalysisSummary(char *sz)
+{
+    char *pch = NextToken(&sz);
+
+    g_free(szAnalysisSummary);
+    szAnalysisSummary = pch && *pch ? g_strdup(pch) : NULL;
+
+    if (szAnalysisSummary)
+        outputf(_("The statistics of analysed matches will be appended to `%s'.\n"), szAnalysisSummary);
+    else
+        outputl(_("The statistics of analysed matches will not be saved."));
+}
+
 extern void
 CommandSetAnalysisMoves(char *sz)
 {
@@ -672,12 +748,183 @@ CommandSetCache(char *sz)
         outputerr(_("Evaluation cache allocation failed"));
 }
 
+extern void
+CommandSetCacheFile(char *sz)
+{
+    char *szFile = NextToken(&sz);
+    int n;
+
+    if (!szFile || !*szFile) {
+        EvalSetCacheFile(NULL);
+        outputl(_("The evaluation cache will not be kept in a file."));
+        return;
+    }
+
+    n = EvalSetCacheFile(szFile);
+    outputf(ngettext("The evaluation cache will be kept in %s (%d entry read).\n",
+                     "The evaluation cache will be kept in %s (%d entries read).\n", n), szFile, n);
+}
+
+extern void
+CommandSetCacheHugePages(char *sz)
+{
+    int f = EvalGetCacheHugePages();
+
+    if (SetToggle("cachehugepages", &f, sz, _("The evaluation cache will be put in huge pages when possible."),
+                  _("The evaluation cache will be put in ordinary pages.")) >= 0 && EvalSetCacheHugePages(f))
+        outputerr(_("Evaluation cache allocation failed"));
+}
+
+extern void
+CommandSetCacheShared(char *sz)
+{
+    char *szName = NextToken(&sz);
+    int n;
+
+    if (!szName || !*szName) {
+        if (EvalSetCacheShared(NULL) < 0)
+            outputerr(_("Evaluation cache allocation failed"));
+        else
+            outputl(_("The evaluation cache will be private to this process."));
+        return;
+    }
+
+    if ((n = EvalSetCacheShared(szName)) < 0)
+        outputerr(_("Evaluation cache allocation failed"));
+    else if (n > 0)
+        outputerrf(_("The shared memory segment %s can't be used, or was made for other weights or settings; "
+                     "the evaluation cache is private to this process."), EvalGetCacheShared());
+    else
+        outputf(_("The evaluation cache is shared in %s (%u entries).\n"), EvalGetCacheShared(),
+                GetEvalCacheEntries());
+}
+
+extern void
+CommandSetCacheStats(char *sz)
+{
+    int f = EvalGetCacheStats();
+
+    if (SetToggle("cachestats", &f, sz, _("Evaluation cache statistics will be kept."),
+                  _("Evaluation cache statistics will not be kept.")) >= 0)
+        EvalSetCacheStats(f);
+}
+
 #if defined(USE_MULTITHREAD)
+extern void
+CommandSetThreadsNuma(char *sz)
+{
+    int f = MT_GetNuma();
+
+    if (SetToggle("threads numa", &f, sz, _("The threads will be pinned to NUMA nodes."),
+                  _("The threads may run on any NUMA node.")) < 0)
+        return;
+
+    if (MT_SetNuma(f) < 0)
+        outputl(_("Unable to pin the threads: this system has a single NUMA node, or can't do it."));
+}
+
+extern void
+CommandSetThreadsAffinity(char *sz)
+{
+    char *pch = NextToken(&sz);
+    int i;
+
+    for (i = 0; i < NUM_AFFINITIES; i++)
+        if (pch && !StrCaseCmp(pch, aszAffinity[i]))
+            break;
+
+    if (i == NUM_AFFINITIES) {
+        outputl(_("You must specify where to pin the threads: none, compact, scatter or cores "
+                  "(see `help set threads')."));
+        return;
+    }
+
+    if (MT_SetAffinity((threadaffinity) i) < 0) {
+        outputl(_("Unable to pin the threads: this system doesn't tell which CPUs it has, or can't do it."));
+        return;
+    }
+
+    switch (i) {
+    case AFFINITY_NONE:
+        outputl(_("The threads may run on any CPU."));
+        break;
+    case AFFINITY_COMPACT:
+        outputl(_("The threads will be pinned to the SMT threads of a core before going on to the next core."));
+        break;
+    case AFFINITY_SCATTER:
+        outputl(_("The threads will be pinned to a core of each package in turn, SMT threads last."));
+        break;
+    default:
+        outputl(_("The threads will be pinned to a core of each package in turn, one thread per core."));
+        break;
+    }
+}
+
+extern void
+CommandSetThreadsShare(char *sz)
+{
+    int f = MT_GetShare();
+
+    if (SetToggle("threads share", &f, sz,
+                  _("Idle threads will help with the candidate moves and the rolls of a single evaluation."),
+                  _("Each evaluation will run on a single thread.")) >= 0)
+        MT_SetShare(f);
+}
+
+extern void
+CommandSetThreadsSpeculate(char *sz)
+{
+    if (SetToggle("threads speculate", &fSpeculate, sz,
+                  _("Idle threads will evaluate your position while you think about it."),
+                  _("Threads will not evaluate your position while you think about it.")) >= 0 && !fSpeculate)
+        StopSpeculation();
+}
+
+/* sz, past szKeyword if it starts with that word, or NULL */
+static char *
+ThreadsKeyword(char *sz, const char *szKeyword)
+{
+    size_t cch = strlen(szKeyword);
+
+    if (!sz || StrNCaseCmp(sz, szKeyword, cch) || (sz[cch] && !isspace((unsigned char) sz[cch])))
+        return NULL;
+
+    return sz + cch;
+}
+
 extern void
 CommandSetThreads(char *sz)
 {
+    char *pch;
     int n;
 
+    if ((pch = ThreadsKeyword(sz, "numa"))) {
+        CommandSetThreadsNuma(pch);
+        return;
+    }
+
+    if ((pch = ThreadsKeyword(sz, "affinity"))) {
+        CommandSetThreadsAffinity(pch);
+        return;
+    }
+
+    if ((pch = ThreadsKeyword(sz, "share"))) {
+        CommandSetThreadsShare(pch);
+        return;
+    }
+
+    if ((pch = ThreadsKeyword(sz, "speculate"))) {
+        CommandSetThreadsSpeculate(pch);
+        return;
+    }
+
+    if (ThreadsKeyword(sz, "auto")) {
+        MT_SetAutoThreads(TRUE);
+        n = (int) MT_GetNumThreads();
+        outputf(_("The number of threads has been set to %d, from the CPUs gnubg may use.\n"), n);
+        return;
+    }
+
     if ((n = ParseNumber(&sz)) <= 0) {
         outputl(_("You must specify the number of threads to use."));
 
@@ -690,6 +937,7 @@ CommandSetThreads(char *sz)
         n = MAX_NUMTHREADS;
     }
 
+    MT_SetAutoThreads(FALSE);
     MT_SetNumThreads(n);
     outputf(_("The number of threads has been set to %d.\n"), n);
 }
@@ -715,6 +963,29 @@ CommandSetVsync3d(char *sz)
 #endif
 }
 
+extern void
+CommandSetBoardCache(char *sz)
+{
+
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a folder or `off' (see `help set boardcache')."));
+        return;
+    }
+
+    g_free(szBoardCache);
+
+    if (!StrCaseCmp(sz, "off")) {
+        szBoardCache = NULL;
+        outputl(_("Rendered boards will only be kept for this session."));
+    } else {
+        szBoardCache = g_strdup(sz);
+        outputf(_("Rendered boards will be kept in %s\n"), szBoardCache);
+    }
+
+}
+
 extern void
 CommandSetBrowser(char *sz)
 {
@@ -1087,6 +1358,27 @@ CommandSetEvalPrune(char *sz)
     g_free(asz0);
 }
 
+extern void
+CommandSetEvalWeights(char *sz)
+{
+    char *szName = NextToken(&sz);
+    int i;
+
+    if (!szName) {
+        outputf(_("You must specify the name of a weight set (see `help set\n%s weights').\n"), szSetCommand);
+        return;
+    }
+
+    if ((i = EvalFindWeights(szName)) < 0) {
+        outputf(_("No weights `%s' are loaded (see `help load weights').\n"), szName);
+        return;
+    }
+
+    pecSet->iWeights = (unsigned int) i;
+
+    outputf(_("%s will use the weights `%s'.\n"), szSet, szName);
+}
+
 extern void
 CommandSetEvalDeterministic(char *sz)
 {
@@ -1706,6 +1998,27 @@ CommandSetDefaultNames(char *sz)
             default_names[0], default_names[1]);
 }
 
+extern void
+CommandSetProfile(char *sz)
+{
+    int f = fProfile;
+
+    if (sz && !StrNCaseCmp(sz, "trace", 5)) {
+        ProfileStart(TRUE);
+        outputl(_("The engine will be profiled and its calls kept for a trace (see `show profile')."));
+        return;
+    }
+
+    if (SetToggle("profile", &f, sz, _("The engine will be profiled (see `show profile')."),
+                  _("The engine will not be profiled.")) < 0)
+        return;
+
+    if (f)
+        ProfileStart(FALSE);
+    else
+        ProfileStop();
+}
+
 extern void
 CommandSetPrompt(char *szParam)
 {
@@ -1774,6 +2087,12 @@ CommandSetRNGMersenne(char *sz)
     SetRNG(rngSet, rngctxSet, RNG_MERSENNE, sz);
 }
 
+extern void
+CommandSetRNGPhilox(char *sz)
+{
+    SetRNG(rngSet, rngctxSet, RNG_PHILOX, sz);
+}
+
 extern void
 CommandSetRNGRandomDotOrg(char *sz)
 {
@@ -1816,6 +2135,78 @@ CommandSetRolloutLogFile(char *sz)
     log_file_name = g_strdup(sz);
 }
 
+extern void
+CommandSetRolloutLogStream(char *sz)
+{
+    SetToggle("rollout logstream", &fRolloutLogStream, sz,
+              _("Rolled out games will be recorded in a single file (see `help rollout extract')."),
+              _("Rolled out games will be recorded in an .sgf file each."));
+}
+
+extern void
+CommandSetRolloutLockstep(char *sz)
+{
+    int n = ParseNumber(&sz);
+
+    if (n < 1 || n > MAX_ROLLOUT_LOCKSTEP) {
+        outputf(_("You must specify how many games to play at once, from 1 to %d "
+                  "(see `help set rollout lockstep').\n"), MAX_ROLLOUT_LOCKSTEP);
+        return;
+    }
+
+    cRolloutLockstep = (unsigned int) n;
+
+    if (cRolloutLockstep > 1)
+        outputf(_("Each rollout thread will play %u games of a move at once.\n"), cRolloutLockstep);
+    else
+        outputl(_("Each rollout thread will play one game at a time."));
+}
+
+extern void
+CommandSetRolloutCheckpoint(char *sz)
+{
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file for the rollout checkpoint, or `none' "
+                  "(see `help set rollout checkpoint')."));
+        return;
+    }
+
+    g_free(szRolloutCheckpoint);
+
+    if (!g_ascii_strcasecmp(sz, "none")) {
+        szRolloutCheckpoint = NULL;
+        outputl(_("Rollouts will not save their state."));
+    } else {
+        szRolloutCheckpoint = g_strdup(sz);
+        outputf(_("Rollouts will save their state to %s and can be resumed with `rollout resume %s'.\n"),
+                szRolloutCheckpoint, szRolloutCheckpoint);
+    }
+}
+
+extern void
+CommandSetRolloutProgressLog(char *sz)
+{
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file for the rollout progress log, or `none' "
+                  "(see `help set rollout progresslog')."));
+        return;
+    }
+
+    g_free(szRolloutProgressLog);
+
+    if (!g_ascii_strcasecmp(sz, "none")) {
+        szRolloutProgressLog = NULL;
+        outputl(_("Rollouts will not log their progress."));
+    } else {
+        szRolloutProgressLog = g_strdup(sz);
+        outputf(_("Rollouts will log their progress to %s.\n"), szRolloutProgressLog);
+    }
+}
+
 extern void
 CommandSetRolloutLateEnable(char *sz)
 {
@@ -1892,6 +2283,25 @@ CommandSetRolloutLimitMinGames(char *sz)
     outputf(_("After %d games, rollouts will stop if the STDs are small enough" ".\n"), n);
 }
 
+extern void
+CommandSetRolloutLimitTime(char *sz)
+{
+
+    int n = ParseNumber(&sz);
+
+    if (n < 0) {
+        outputl(_("You must specify a valid number of seconds " "(see `help set rollout limit time')."));
+        return;
+    }
+
+    prcSet->nMaxSeconds = n;
+
+    if (n)
+        outputf(_("Rollouts will stop after %d seconds.\n"), n);
+    else
+        outputl(_("Rollouts will not stop on time."));
+}
+
 extern void
 CommandSetRolloutMaxError(char *sz)
 {
@@ -1916,6 +2326,18 @@ CommandSetRolloutJsd(char *sz)
 
 }
 
+extern void
+CommandSetRolloutJsdAdaptive(char *sz)
+{
+    int f = prcSet->fAdaptiveJsd;
+
+    SetToggle("rollout jsd adaptive", &f, sz,
+              _("Rollouts will play fewer games of the moves that are JSDs behind the best one."),
+              _("Rollouts will play the same number of games of every move."));
+
+    prcSet->fAdaptiveJsd = f;
+}
+
 extern void
 CommandSetRolloutJsdEnable(char *sz)
 {
@@ -2354,6 +2776,20 @@ CommandSetRolloutTruncationCube(char *sz)
 }
 
 
+extern void
+CommandSetRolloutQuickVarRedn(char *sz)
+{
+
+    int f = prcSet->fQuickVarRedn;
+
+    SetToggle("rollout quickvarredn", &f, sz,
+              _("Will reduce the variance of rollouts with 0-ply evaluations of the rolls "
+                "when lookahead variance reduction is off."),
+              _("Will not use quick variance reduction during rollouts."));
+
+    prcSet->fQuickVarRedn = f;
+}
+
 extern void
 CommandSetRolloutVarRedn(char *sz)
 {
@@ -2367,6 +2803,46 @@ CommandSetRolloutVarRedn(char *sz)
     prcSet->fVarRedn = f;
 }
 
+extern void
+CommandSetRolloutWorkers(char *sz)
+{
+#if !defined(USE_MULTITHREAD) || !HAVE_SOCKETS
+    (void) sz;                  /* silence compiler warning */
+    outputl(_("This installation of GNU Backgammon was compiled without\n"
+              "thread or socket support, and cannot use rollout workers."));
+#else
+    if (!sz || !*sz) {
+        outputl(_("You must specify the rollout workers as host:port, or `none' "
+                  "(see `help set rollout workers')."));
+        return;
+    }
+
+    g_free(szRolloutWorkers);
+
+    if (!g_ascii_strcasecmp(sz, "none")) {
+        szRolloutWorkers = NULL;
+        outputl(_("Rollouts will be played on this host only."));
+    } else {
+        szRolloutWorkers = g_strdup(sz);
+        outputf(_("Rollouts will hand trials to the workers %s\n"), szRolloutWorkers);
+    }
+#endif
+}
+
+
+extern void
+CommandSetRolloutSobol(char *sz)
+{
+
+    int f = prcSet->fSobol;
+
+    SetToggle("rollout sobol", &f, sz,
+              _("Quasi-random dice in rollouts will come from a Sobol sequence"),
+              _("Quasi-random dice in rollouts will be permutations of the rolls"));
+
+    prcSet->fSobol = f;
+
+}
 
 extern void
 CommandSetRolloutRotate(char *sz)
@@ -3196,6 +3672,89 @@ CommandSetEvalParamRollout(char *sz)
 
 }
 
+extern void
+CommandSetEvalAdaptiveFilter(char *sz)
+{
+    int f = EvalGetAdaptiveFilter();
+
+    if (SetToggle("evaluation adaptivefilter", &f, sz,
+                  _("Move filters will carry fewer moves to the next ply when the scores show a clear break."),
+                  _("Move filters will carry the moves their settings allow.")) >= 0)
+        EvalSetAdaptiveFilter(f);
+}
+
+extern void
+CommandSetEvalEarlyExit(char *sz)
+{
+    float r = ParseReal(&sz);
+
+    if (r < 0.0f) {
+        outputl(_("You must specify an equity, or 0 to score all moves (see `help set evaluation earlyexit')."));
+        return;
+    }
+
+    EvalSetEarlyExit(r);
+
+    if (r > 0.0f)
+        outputf(_("Move decisions will stop scoring the moves of a ply once the rest trail by %.3f.\n"), r);
+    else
+        outputl(_("Move decisions will score all the moves their filters keep."));
+}
+
+extern void
+CommandSetEvalOpeningBook(char *sz)
+{
+    int f = EvalGetOpeningBook();
+
+    if (SetToggle("evaluation openingbook", &f, sz,
+                  _("The moves found for the first move of each side will be kept and reused."),
+                  _("The first moves of each side will be searched every time.")) >= 0)
+        EvalSetOpeningBook(f);
+}
+
+extern void
+CommandSetEvalRaceApprox(char *sz)
+{
+    int f = EvalGetRaceApprox();
+
+    if (SetToggle("evaluation raceapprox", &f, sz,
+                  _("Race moves will be pruned, and cubeless rollouts truncated in races, with a pip count estimate."),
+                  _("Race positions will be evaluated with the race net throughout.")) >= 0)
+        EvalSetRaceApprox(f);
+}
+
+extern void
+CommandSetEvalFilterBudget(char *sz)
+{
+    float r = ParseReal(&sz);
+
+    if (r < 0.0f) {
+        outputl(_("You must specify a time in seconds, or 0 for no limit (see `help set evaluation filterbudget')."));
+        return;
+    }
+
+    EvalSetFilterBudget(r);
+
+    if (r > 0.0f)
+        outputf(_("Move decisions will stop looking deeper after %.2f seconds.\n"), r);
+    else
+        outputl(_("Move decisions will always look as deep as their settings say."));
+}
+
+extern void
+CommandSetEvalSigmoidFast(char *UNUSED(sz))
+{
+    EvalSetFastSigmoid(TRUE);
+    outputl(_("The neural net hidden layers will use the fast sigmoid approximation."));
+}
+
+extern void
+CommandSetEvalSigmoidTable(char *UNUSED(sz))
+{
+    EvalSetFastSigmoid(FALSE);
+    outputl(_("The neural net hidden layers will use the table sigmoid."));
+}
+
 extern void
 CommandSetEvalSameAsAnalysis(char *sz)
 {
@@ -4280,6 +4839,29 @@ CommandSetExportHtmlSize(char *sz)
 
 }
 
+extern void
+CommandSetExportPNGCache(char *sz)
+{
+
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a folder or `off' (see `help set export png cache')."));
+        return;
+    }
+
+    g_free(exsExport.szPNGCache);
+
+    if (!StrCaseCmp(sz, "off")) {
+        exsExport.szPNGCache = NULL;
+        outputl(_("Exported PNG boards will not be cached."));
+    } else {
+        exsExport.szPNGCache = g_strdup(sz);
+        outputf(_("Exported PNG boards will be cached in %s\n"), exsExport.szPNGCache);
+    }
+
+}
+
 extern void
 CommandSetExportPNGSize(char *sz)
 {
@@ -4358,6 +4940,16 @@ CommandSetVariationStandard(char *UNUSED(sz))
 }
 
 
+extern void
+CommandSetProgressiveHint(char *sz)
+{
+
+    SetToggle("progressivehint", &fProgressiveHint, sz,
+              _("Hints will show the best moves of each move filter stage as it is done."),
+              _("Hints will show the moves once the deepest stage is done."));
+
+}
+
 extern void
 CommandSetGotoFirstGame(char *sz)
 {
@@ -39,122 +39,27 @@
 #include "positionid.h"
 #include "sgf.h"
 
+#define SGF_BUFFER_SIZE (1 << 18)
+
 static const char *szFile;
 static int fError;
+static int fSyntaxError;        /* the file is not valid SGF */
+static long cbLoad;             /* size of the match file, 0 if unknown */
 
 static int CheckSGFVersion(char **sz);
 static void
-ErrorHandler(const char *sz, int UNUSED(fParseError))
+ErrorHandler(const char *sz, int fParseError)
 {
 
+    if (fParseError)
+        fSyntaxError = TRUE;
+
     if (!fError) {
         fError = TRUE;
         outputerrf("%s: %s", szFile, sz);
     }
 }
 
-static void
-FreeList(listOLD * pl, int nLevel)
-{
-    /* Levels are:
-     *  0 - GameTreeSeq
-     *  1 - GameTree
-     *  2 - Sequence
-     *  3 - Node
-     *  4 - Property
-     */
-
-    if (nLevel == 1) {
-        FreeList(pl->plNext->p, 2);     /* initial sequence */
-        ListDelete(pl->plNext);
-        nLevel = 0;             /* remainder of list is more GameTreeSeqs */
-    }
-
-    while (pl->plNext != pl) {
-        if (nLevel == 3) {
-            FreeList(((property *) pl->plNext->p)->pl, 4);
-            free(pl->plNext->p);
-        } else if (nLevel == 4)
-            free(pl->plNext->p);
-        else
-            FreeList(pl->plNext->p, nLevel + 1);
-
-        ListDelete(pl->plNext);
-    }
-
-    free(pl);
-}
-
-static void
-FreeGameTreeSeq(listOLD * pl)
-{
-
-    FreeList(pl, 0);
-}
-
-static listOLD *
-LoadCollection(char *sz)
-{
-
-    listOLD *plCollection, *pl, *plRoot, *plProp;
-    FILE *pf;
-
-    fError = FALSE;
-    SGFErrorHandler = ErrorHandler;
-
-    if (strcmp(sz, "-")) {
-        if (!(pf = g_fopen(sz, "r"))) {
-            outputerr(sz);
-            return NULL;
-        }
-        szFile = sz;
-    } else {
-        /* FIXME does it really make sense to try to load from stdin? */
-        pf = stdin;
-        szFile = "(stdin)";
-    }
-
-    plCollection = SGFParse(pf);
-
-    if (pf != stdin)
-        fclose(pf);
-
-    /* Traverse collection, looking for backgammon games. */
-    if (plCollection) {
-        pl = plCollection->plNext;
-        while (pl != plCollection) {
-            int fBackgammon = FALSE;
-
-            plRoot = ((listOLD *) ((listOLD *) pl->p)->plNext->p)->plNext->p;
-
-            for (plProp = plRoot->plNext; plProp != plRoot; plProp = plProp->plNext) {
-                property *pp = plProp->p;
-
-                if (pp->ach[0] == 'G' && pp->ach[1] == 'M' && pp->pl->plNext->p && atoi((char *)
-                                                                                        pp->pl->plNext->p) == 6) {
-                    fBackgammon = TRUE;
-                    break;
-                }
-            }
-
-            pl = pl->plNext;
-
-            if (!fBackgammon) {
-                FreeList(pl->plPrev->p, 1);
-                ListDelete(pl->plPrev);
-            }
-        }
-
-        if (ListEmpty(plCollection)) {
-            ErrorHandler(_("warning: no backgammon games in SGF file"), TRUE);
-            free(plCollection);
-            plCollection = NULL;
-        }
-    }
-
-    return plCollection;
-}
-
 static void
 CopyName(int i, char *sz)
 {
@@ -1165,7 +1070,7 @@ RestoreNode(listOLD * pl)
 
                 if (pmr->anDice[0] < 1 || pmr->anDice[0] > 6 || pmr->anDice[1] < 1 || pmr->anDice[1] > 6) {
                     /* illegal roll -- ignore */
-                    g_free(pmr);
+                    ReleaseMoveRecord(pmr);
                     pmr = NULL;
                 }
             }
@@ -1218,7 +1123,7 @@ RestoreNode(listOLD * pl)
                 pmr->scp.fCubeOwner = 0;
                 break;
             default:
-                g_free(pmr);
+                ReleaseMoveRecord(pmr);
                 pmr = NULL;
             }
 
@@ -1335,39 +1240,8 @@ RestoreNode(listOLD * pl)
 }
 
 static void
-RestoreSequence(listOLD * pl, int fRoot)
-{
-
-    pl = pl->plNext;
-    if (fRoot)
-        RestoreRootNode(pl->p);
-    else
-        RestoreNode(pl->p);
-
-    while (pl = pl->plNext, pl->p)
-        RestoreNode(pl->p);
-}
-
-static void
-RestoreTree(listOLD * pl, int fRoot)
-{
-
-    pl = pl->plNext;
-    RestoreSequence(pl->p, fRoot);
-
-    pl = pl->plNext;
-    if (pl->p)
-        RestoreTree(pl->p, FALSE);
-
-    /* FIXME restore other variations, once we can handle them */
-}
-
-static void
-RestoreGame(listOLD * pl)
+BeginGame(void)
 {
-
-    moverecord *pmr;
-
     InitBoard(ms.anBoard, ms.bgv);
 
     /* FIXME should anything be done with the current game? */
@@ -1381,8 +1255,12 @@ RestoreGame(listOLD * pl)
     ms.nCube = 1;
     ms.fTurn = ms.fMove = ms.fCubeOwner = -1;
     ms.gs = GAME_NONE;
+}
 
-    RestoreTree(pl, TRUE);
+static void
+EndGame(void)
+{
+    moverecord *pmr;
 
     pmr = plGame->plNext->p;
     g_assert(pmr->mt == MOVE_GAMEINFO);
@@ -1411,38 +1289,416 @@ RestoreGame(listOLD * pl)
 
 }
 
-extern void
-CommandLoadGame(char *sz)
+/* The SGF reader.  Rather than building a syntax tree of the whole
+ * collection and walking it afterwards, the file is scanned once and
+ * each node is restored as soon as it is complete, so only one node's
+ * properties are held in memory at a time.  Only the main line of each
+ * game tree (its sequence followed by the main line of its first
+ * variation) is restored, and collections may hold games other than
+ * backgammon, which are skipped. */
+
+static int
+SkipSpace(FILE * pf)
 {
+    int ch;
 
-    listOLD *pl;
+    while ((ch = getc(pf)) != EOF && isspace(ch));
 
-    sz = NextToken(&sz);
+    return ch;
+}
 
-    if (!sz || !*sz) {
-        outputl(_("You must specify a file to load from (see `help load " "game')."));
-        return;
+/* Read a property value; the opening '[' has been consumed */
+static char *
+ReadValue(FILE * pf)
+{
+    GString *gs = g_string_new(NULL);
+    int ch;
+
+    while ((ch = getc(pf)) != EOF && ch != ']') {
+        if (ch == '\\') {
+            if ((ch = getc(pf)) == EOF)
+                break;
+            if (ch == ']') {
+                g_string_append_c(gs, ']');
+                continue;
+            } else if (ch == '\n')
+                continue;
+            g_string_append_c(gs, '\\');
+        }
+        if (ch)                 /* we want value strings null-terminated */
+            g_string_append_c(gs, (char) ch);
     }
 
-    if ((pl = LoadCollection(sz))) {
-        if (!get_input_discard())
-            return;
+    if (ch == EOF)
+        ErrorHandler(_("unterminated property value in SGF file"), TRUE);
+
+    return g_string_free(gs, FALSE);
+}
+
+static void
+FreeNode(listOLD * pl)
+{
+    while (pl->plNext != pl) {
+        property *pp = pl->plNext->p;
+
+        while (pp->pl->plNext != pp->pl) {
+            g_free(pp->pl->plNext->p);
+            ListDelete(pp->pl->plNext);
+        }
+        g_free(pp->pl);
+        g_free(pp);
+        ListDelete(pl->plNext);
+    }
+}
+
+/* Read the properties of a node into pl; the ';' has been consumed.
+ * Returns the first character after the node. */
+static int
+ReadNode(FILE * pf, listOLD * pl)
+{
+    int ch = SkipSpace(pf);
+
+    while (ch != EOF && ch != ';' && ch != '(' && ch != ')') {
+        property *pp;
+        char ach[2] = { 0, 0 };
+        int c = 0;
+
+        if (!isalpha(ch)) {
+            ErrorHandler(_("illegal character in SGF file"), FALSE);
+            ch = SkipSpace(pf);
+            continue;
+        }
+
+        /* property identifiers may carry lower case letters, which
+         * are ignored */
+        for (; ch != EOF && isalpha(ch); ch = getc(pf))
+            if (isupper(ch) && c < 2)
+                ach[c++] = (char) ch;
+
+        if (isspace(ch))
+            ch = SkipSpace(pf);
+
+        if (!c) {
+            while (ch == '[') {
+                g_free(ReadValue(pf));
+                ch = SkipSpace(pf);
+            }
+            continue;
+        }
+
+        if (ch != '[') {
+            ErrorHandler(_("property without value in SGF file"), TRUE);
+            continue;
+        }
+
+        pp = g_malloc(sizeof(property));
+        pp->ach[0] = ach[0];
+        pp->ach[1] = ach[1];
+        pp->pl = g_malloc(sizeof(listOLD));
+        ListCreate(pp->pl);
+
+        while (ch == '[') {
+            ListInsert(pp->pl, ReadValue(pf));
+            ch = SkipSpace(pf);
+        }
+
+        ListInsert(pl, pp);
+    }
+
+    return ch;
+}
+
+static int
+IsBackgammon(listOLD * pl)
+{
+    listOLD *plProp;
+
+    for (plProp = pl->plNext; plProp != pl; plProp = plProp->plNext) {
+        property *pp = plProp->p;
+
+        if (pp->ach[0] == 'G' && pp->ach[1] == 'M' && pp->pl->plNext->p && atoi((char *) pp->pl->plNext->p) == 6)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Discard the current match before the first game is restored */
+static int
+StartLoad(void)
+{
+    if (!get_input_discard())
+        return FALSE;
+#if USE_GTK
+    if (fX) {                   /* Clear record to avoid ugly updates */
+        GTKClearMoveRecord();
+        GTKFreeze();
+    }
+#endif
+
+    FreeMatch();
+    ClearMatch();
+
+    return TRUE;
+}
+
+#if USE_GTK
+/* Show the first game of a match while the rest of it is read: the
+ * games after it are listed as they are restored, but the board and
+ * move list stay on the first until the whole match is in */
+static void
+ShowFirstGame(void)
+{
+    UpdateSettings();
+    GTKThaw();
+    GTKSet(ap);
+    GTKFreeze();
+    fHoldGames = TRUE;
+}
+
+/* Move the display on to the last game read, as if it had been shown
+ * all along */
+static void
+ReleaseGames(int nGames)
+{
+    listOLD *pl;
+
+    fHoldGames = FALSE;
+
+    GTKSetGame(nGames - 1);
+    GTKClearMoveRecord();
+    for (pl = plGame->plNext; pl->p; pl = pl->plNext)
+        GTKAddMoveRecord(pl->p);
+}
+#endif
+
+/* Restore the backgammon games read from pf (all of them if fAll,
+ * otherwise the first), discarding the current match before the first
+ * one unless *pfStarted is already set.  Without fRestore the games
+ * are only read, see CheckGames().  Returns the number of games
+ * restored, 0 if none were, or -1 if the user chose to keep the
+ * current match. */
+static int
+ReadGames(FILE * pf, int fAll, int *pfStarted, int fRestore)
+{
+    listOLD lNode;
+    int ch, nDepth = 0, nMain = 0, fMainHasChild = FALSE;
+    int fGame = FALSE, fRoot = FALSE, nGames = 0;
+    unsigned int cNodes = 0;
+
+    ListCreate(&lNode);
+
+    ch = SkipSpace(pf);
+    while (ch != EOF) {
+        switch (ch) {
+        case '(':
+            if (nDepth == 0) {  /* a new game */
+                nMain = 1;
+                fMainHasChild = FALSE;
+                fRoot = TRUE;
+            } else if (nDepth == nMain && !fMainHasChild) {
+                nMain++;        /* first variation continues the main line */
+                fMainHasChild = FALSE;
+            }
+            nDepth++;
+            ch = SkipSpace(pf);
+            break;
+
+        case ')':
+            if (nDepth == 0) {
+                ErrorHandler(_("unbalanced ')' in SGF file"), TRUE);
+                ch = SkipSpace(pf);
+                break;
+            }
+            if (nDepth == nMain) {
+                nMain--;
+                fMainHasChild = TRUE;
+            }
+            if (--nDepth == 0 && fGame) {
+                if (fRestore)
+                    EndGame();
+                fGame = FALSE;
+                nGames++;
+                if (!fAll)
+                    return nGames;
 #if USE_GTK
-        if (fX) {               /* Clear record to avoid ugly updates */
-            GTKClearMoveRecord();
-            GTKFreeze();
+                if (fX && nGames == 1 && cbLoad && fRestore)
+                    ShowFirstGame();
+#endif
+            }
+            ch = SkipSpace(pf);
+            break;
+
+        case ';':
+            ch = ReadNode(pf, &lNode);
+
+            if (nDepth == 0)
+                ErrorHandler(_("node outside game tree in SGF file"), TRUE);
+            else if (fRoot) {
+                fRoot = FALSE;
+                fGame = IsBackgammon(&lNode);
+                if (fGame && fRestore) {
+                    if (!*pfStarted) {
+                        if (!StartLoad()) {
+                            FreeNode(&lNode);
+                            return -1;
+                        }
+                        *pfStarted = TRUE;
+                        if (cbLoad)
+                            ProgressStartValue(_("Loading match"), (int) ((cbLoad + 1023) / 1024));
+                    }
+                    BeginGame();
+                    RestoreRootNode(&lNode);
+                }
+            } else if (fGame && nDepth == nMain && !fMainHasChild && fRestore)
+                RestoreNode(&lNode);
+
+            FreeNode(&lNode);
+
+            /* let the window redraw now and then */
+            if (cbLoad && *pfStarted && fRestore && !(++cNodes % 256))
+                ProgressValue((int) (ftell(pf) / 1024));
+            break;
+
+        default:
+            ErrorHandler(_("illegal character in SGF file"), FALSE);
+            ch = SkipSpace(pf);
+            break;
         }
+    }
+
+    if (nDepth)
+        ErrorHandler(_("unexpected end of SGF file"), TRUE);
+    if (fGame) {
+        if (fRestore)
+            EndGame();
+        nGames++;
+    }
+
+    return nGames;
+}
+
+/* Read the games of pf as ReadGames() does, without restoring them,
+ * and go back to where that started, so that a file that isn't valid
+ * SGF is refused before the current match is discarded, as the games
+ * are restored while they are read.  Returns -1 if pf can't be read
+ * twice (a pipe), otherwise whether the games were valid. */
+static int
+CheckGames(FILE * pf, int fAll)
+{
+    long l = ftell(pf);
+    int fStarted = TRUE;
+
+    if (l < 0)
+        return -1;
+
+    ReadGames(pf, fAll, &fStarted, FALSE);
+
+    if (fseek(pf, l, SEEK_SET)) {
+        outputerr(szFile);
+        return FALSE;
+    }
+
+    return !fSyntaxError;
+}
+
+/* Restore the games of pf if they are valid, as ReadGames().  When pf
+ * couldn't be checked first, tell if the match was only loaded in
+ * part. */
+static int
+CheckAndReadGames(FILE * pf, int fAll, int *pfStarted)
+{
+    int fChecked, nGames;
+
+    fSyntaxError = FALSE;
+
+    if (!(fChecked = CheckGames(pf, fAll)))
+        return 0;
+
+    nGames = ReadGames(pf, fAll, pfStarted, TRUE);
+
+    if (fChecked < 0 && fSyntaxError && nGames > 0)
+        outputerrf(_("%s: the match was only loaded in part"), szFile);
+
+    return nGames;
+}
+
+/* Restore the backgammon games in the SGF file sz (all of them if fAll,
+ * otherwise the first).  Returns as ReadGames(). */
+static int
+LoadGames(char *sz, int fAll)
+{
+    FILE *pf;
+    int fStarted = FALSE, nGames;
+
+    fError = FALSE;
+    cbLoad = 0;
+
+    if (strcmp(sz, "-")) {
+        if (!(pf = g_fopen(sz, "r"))) {
+            outputerr(sz);
+            return 0;
+        }
+        szFile = sz;
+
+        /* progress is only worth showing for whole matches */
+        if (fAll && !fseek(pf, 0, SEEK_END)) {
+            cbLoad = MAX(ftell(pf), 0);
+            rewind(pf);
+        }
+    } else {
+        /* FIXME does it really make sense to try to load from stdin? */
+        pf = stdin;
+        szFile = "(stdin)";
+    }
+
+    nGames = CheckAndReadGames(pf, fAll, &fStarted);
+
+    if (pf != stdin)
+        fclose(pf);
+
+    if (cbLoad && fStarted) {
+#if USE_GTK
+        if (fHoldGames)
+            ReleaseGames(nGames);
 #endif
+        ProgressEnd();
+    }
+    cbLoad = 0;
+
+    if (nGames == 0 && !fSyntaxError)
+        ErrorHandler(_("warning: no backgammon games in SGF file"), TRUE);
+
+    return nGames;
+}
+
+/* Restore the next game in the SGF text at the current position of pf
+ * (szName is used in error messages).  The current match is discarded
+ * first unless *pfStarted is set, so that several games can be added
+ * to one match.  Returns as ReadGames(). */
+extern int
+SGFReadGame(FILE * pf, const char *szName, int *pfStarted)
+{
+    fError = FALSE;
+    szFile = szName;
+
+    return CheckAndReadGames(pf, FALSE, pfStarted);
+}
 
-        FreeMatch();
-        ClearMatch();
+extern void
+CommandLoadGame(char *sz)
+{
 
-        /* FIXME if pl contains multiple games, ask which one to load */
+    sz = NextToken(&sz);
 
-        RestoreGame(pl->plNext->p);
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to load from (see `help load " "game')."));
+        return;
+    }
 
-        FreeGameTreeSeq(pl);
+    /* FIXME if the file contains multiple games, ask which one to load */
 
+    if (LoadGames(sz, FALSE) > 0) {
         UpdateSettings();
 
 #if USE_GTK
@@ -1470,8 +1726,6 @@ extern void
 CommandLoadPosition(char *sz)
 {
 
-    listOLD *pl;
-
     sz = NextToken(&sz);
 
     if (!sz || !*sz) {
@@ -1479,25 +1733,9 @@ CommandLoadPosition(char *sz)
         return;
     }
 
-    if ((pl = LoadCollection(sz))) {
-        if (!get_input_discard())
-            return;
-#if USE_GTK
-        if (fX) {               /* Clear record to avoid ugly updates */
-            GTKClearMoveRecord();
-            GTKFreeze();
-        }
-#endif
-
-        FreeMatch();
-        ClearMatch();
-
-        /* FIXME if pl contains multiple games, ask which one to load */
-
-        RestoreGame(pl->plNext->p);
-
-        FreeGameTreeSeq(pl);
+    /* FIXME if the file contains multiple games, ask which one to load */
 
+    if (LoadGames(sz, FALSE) > 0) {
         UpdateSettings();
 
 #if USE_GTK
@@ -1520,6 +1758,7 @@ extern void
 CommandLoadMatch(char *sz)
 {
     listOLD *pl;
+    int nGames;
 
     sz = NextToken(&sz);
 
@@ -1528,29 +1767,11 @@ CommandLoadMatch(char *sz)
         return;
     }
 
-    if ((pl = LoadCollection(sz))) {
-        int nGames = 0, nMoves = 0;
-
-        /* FIXME make sure the root nodes have MI properties; if not,
-         * we're loading a session. */
-        if (!get_input_discard())
-            return;
-#if USE_GTK
-        if (fX) {               /* Clear record to avoid ugly updates */
-            GTKClearMoveRecord();
-            GTKFreeze();
-        }
-#endif
-
-        FreeMatch();
-        ClearMatch();
+    /* FIXME make sure the root nodes have MI properties; if not,
+     * we're loading a session. */
 
-        for (pl = pl->plNext; pl->p; pl = pl->plNext) {
-            RestoreGame(pl->p);
-            nGames++;
-        }
-
-        FreeGameTreeSeq(pl);
+    if ((nGames = LoadGames(sz, TRUE)) > 0) {
+        int nMoves = 0;
 
         UpdateSettings();
 
@@ -1603,41 +1824,91 @@ static void
 WriteEscapedString(FILE * pf, char *pch, int fEscapeColons)
 {
 
-    char *sz, *pc;
-
-    sz = (char *) g_malloc(2 * strlen(pch) + 1);
-
-    for (pc = sz; *pch; pch++)
+    for (; *pch; pch++)
         switch (*pch) {
         case '\\':
-            *pc++ = '\\';
-            *pc++ = '\\';
+            putc('\\', pf);
+            putc('\\', pf);
             break;
         case ':':
             if (fEscapeColons)
-                *pc++ = '\\';
-            *pc++ = ':';
+                putc('\\', pf);
+            putc(':', pf);
             break;
         case ']':
-            *pc++ = '\\';
-            *pc++ = ']';
+            putc('\\', pf);
+            putc(']', pf);
             break;
         default:
-            *pc++ = *pch;
+            putc(*pch, pf);
             break;
         }
+}
+
+/* Format r with nDigits decimals (at most 6), as "%.*f" would in the C
+ * locale, without the snprintf and locale handling of
+ * g_ascii_formatd().  A float times 10^6 is exact in a double, so
+ * rounding the product (to even on ties, as printf does) rounds the
+ * decimal expansion correctly. */
+static char *
+FormatFloat(char sz[G_ASCII_DTOSTR_BUF_SIZE], float r, int nDigits)
+{
+    static const double arPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+    double x = fabs((double) r) * arPow10[nDigits];
+    unsigned long long n;
+    char ach[24], *pch = ach + sizeof(ach), *pc = sz;
+    int i;
+
+    if (!(x < 1e15)) {          /* large, infinite or NaN */
+        char szFormat[8];
+        sprintf(szFormat, "%%.%df", nDigits);
+        return g_ascii_formatd(sz, G_ASCII_DTOSTR_BUF_SIZE, szFormat, r);
+    }
+
+    n = (unsigned long long) rint(x);
 
+    /* digits, least significant first */
+    for (i = 0; i < nDigits || n || i == nDigits; i++) {
+        *--pch = (char) ('0' + n % 10);
+        n /= 10;
+        if (i + 1 == nDigits)
+            *--pch = '.';
+    }
+
+    if (signbit(r))
+        *pc++ = '-';
+    while (pch < ach + sizeof(ach))
+        *pc++ = *pch++;
     *pc = 0;
 
-    fputs(sz, pf);
-    g_free(sz);
+    return sz;
+}
+
+/* Give a file being saved a large buffer; analysed matches are written
+ * in many small pieces */
+static char *
+SetSaveBuffer(FILE * pf)
+{
+    char *pch = g_malloc(SGF_BUFFER_SIZE);
+
+    setvbuf(pf, pch, _IOFBF, SGF_BUFFER_SIZE);
+    return pch;
+}
+
+static void
+WriteFloat(FILE * pf, float r, int nDigits, const char *szSuffix)
+{
+    char sz[G_ASCII_DTOSTR_BUF_SIZE];
+
+    fputs(FormatFloat(sz, r, nDigits), pf);
+    fputs(szSuffix, pf);
 }
 
 static void
 WriteEvalContext(FILE * pf, const evalcontext * pec)
 {
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
-    g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pec->rNoise);
+    FormatFloat(buffer, pec->rNoise, 6);
     fprintf(pf, "ver %d %u%s %u %s %u",
             SGF_FORMAT_VER, pec->nPlies, pec->fCubeful ? "C" : "", pec->fDeterministic, buffer, pec->fUsePrune);
 }
@@ -1649,7 +1920,7 @@ WriteMoveFilters(FILE * pf, movefilter mf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], i
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
 
     for (i = 0; i < nPlies; ++i) {
-        g_ascii_formatd(buffer, sizeof(buffer), "%.5f", mf[nPlies - 1][i].Threshold);
+        FormatFloat(buffer, mf[nPlies - 1][i].Threshold, 5);
         fprintf(pf, "%d %d %s ", mf[nPlies - 1][i].Accept, mf[nPlies - 1][i].Extra, buffer);
     }
 }
@@ -1773,15 +2044,15 @@ WriteDoubleAnalysis(FILE * pf,
 
     switch (pes->et) {
     case EVAL_EVAL:
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pes->ec.rNoise);
+        FormatFloat(buffer, pes->ec.rNoise, 6);
         fprintf(pf, "E ver %d %u%s %u %s %u",
                 SGF_FORMAT_VER,
                 pes->ec.nPlies, pes->ec.fCubeful ? "C" : "", pes->ec.fDeterministic, buffer, pes->ec.fUsePrune);
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 7; j++) {
-                g_ascii_formatd(buffer, sizeof(buffer), "%.6f", aarOutput[i][j]);
-                fprintf(pf, " %s", buffer);
+                fputc(' ', pf);
+                WriteFloat(pf, aarOutput[i][j], 6, "");
             }
         }
 
@@ -1843,19 +2114,14 @@ WriteMoveAnalysis(FILE * pf, int fPlayer, movelist * pml, unsigned int iMove)
             break;
 
         case EVAL_EVAL:
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].arEvalMove[0]);
+            FormatFloat(buffer, pml->amMoves[i].arEvalMove[0], 6);
             fprintf(pf, "E ver %d %s ", SGF_FORMAT_VER, buffer);
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].arEvalMove[1]);
-            fprintf(pf, "%s ", buffer);
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].arEvalMove[2]);
-            fprintf(pf, "%s ", buffer);
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].arEvalMove[3]);
-            fprintf(pf, "%s ", buffer);
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].arEvalMove[4]);
-            fprintf(pf, "%s ", buffer);
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].rScore);
-            fprintf(pf, "%s ", buffer);
-            g_ascii_formatd(buffer, sizeof(buffer), "%.6f", pml->amMoves[i].esMove.ec.rNoise);
+            WriteFloat(pf, pml->amMoves[i].arEvalMove[1], 6, " ");
+            WriteFloat(pf, pml->amMoves[i].arEvalMove[2], 6, " ");
+            WriteFloat(pf, pml->amMoves[i].arEvalMove[3], 6, " ");
+            WriteFloat(pf, pml->amMoves[i].arEvalMove[4], 6, " ");
+            WriteFloat(pf, pml->amMoves[i].rScore, 6, " ");
+            FormatFloat(buffer, pml->amMoves[i].esMove.ec.rNoise, 6);
             fprintf(pf, "%u%s %d %u %s %u",
                     pml->amMoves[i].esMove.ec.nPlies,
                     pml->amMoves[i].esMove.ec.fCubeful ? "C" : "",
@@ -1896,7 +2162,7 @@ WriteLuck(FILE * pf, int fPlayer, float rLuck, lucktype lt)
 {
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
     if (rLuck != ERR_VAL) {
-        g_ascii_formatd(buffer, sizeof(buffer), "%.5f", rLuck);
+        FormatFloat(buffer, rLuck, 5);
         fprintf(pf, "LU[%s]", buffer);
     }
 
@@ -1973,7 +2239,6 @@ WriteStatContext(FILE * pf, statcontext * psc)
 
     lucktype lt;
     skilltype st;
-    gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
 
     fputs("GS", pf);
 
@@ -1982,14 +2247,10 @@ WriteStatContext(FILE * pf, statcontext * psc)
                 psc->anUnforcedMoves[1], psc->anTotalMoves[0], psc->anTotalMoves[1]);
         for (st = SKILL_VERYBAD; st <= SKILL_NONE; st++)
             fprintf(pf, "%d %d ", psc->anMoves[0][st], psc->anMoves[1][st]);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorCheckerplay[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorCheckerplay[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorCheckerplay[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorCheckerplay[1][1]);
-        fprintf(pf, "%s]", buffer);
+        WriteFloat(pf, psc->arErrorCheckerplay[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorCheckerplay[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorCheckerplay[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorCheckerplay[1][1], 6, "]");
     }
 
     if (psc->fCube) {
@@ -2004,68 +2265,40 @@ WriteStatContext(FILE * pf, statcontext * psc)
                 psc->anCubeWrongDoubleDP[0], psc->anCubeWrongDoubleDP[1],
                 psc->anCubeWrongDoubleTG[0], psc->anCubeWrongDoubleTG[1],
                 psc->anCubeWrongTake[0], psc->anCubeWrongTake[1], psc->anCubeWrongPass[0], psc->anCubeWrongPass[1]);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleDP[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleDP[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleTG[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleTG[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleDP[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleDP[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleTG[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleTG[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongTake[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongTake[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongPass[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongPass[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleDP[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleDP[1][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleTG[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorMissedDoubleTG[1][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleDP[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleDP[1][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleTG[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongDoubleTG[1][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongTake[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongTake[1][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongPass[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arErrorWrongPass[1][1]);
-        fprintf(pf, "%s]", buffer);
+        WriteFloat(pf, psc->arErrorMissedDoubleDP[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleDP[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleTG[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleTG[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleDP[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleDP[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleTG[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleTG[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongTake[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongTake[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongPass[0][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongPass[0][1], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleDP[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleDP[1][1], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleTG[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorMissedDoubleTG[1][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleDP[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleDP[1][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleTG[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongDoubleTG[1][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongTake[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongTake[1][1], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongPass[1][0], 6, " ");
+        WriteFloat(pf, psc->arErrorWrongPass[1][1], 6, "]");
     }
 
     if (psc->fDice) {
         fputs("[D:", pf);
         for (lt = LUCK_VERYBAD; lt <= LUCK_VERYGOOD; lt++)
             fprintf(pf, "%d %d ", psc->anLuck[0][lt], psc->anLuck[1][lt]);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arLuck[0][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arLuck[0][1]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arLuck[1][0]);
-        fprintf(pf, "%s ", buffer);
-        g_ascii_formatd(buffer, sizeof(buffer), "%.6f", psc->arLuck[1][1]);
-        fprintf(pf, "%s]", buffer);
+        WriteFloat(pf, psc->arLuck[0][0], 6, " ");
+        WriteFloat(pf, psc->arLuck[0][1], 6, " ");
+        WriteFloat(pf, psc->arLuck[1][0], 6, " ");
+        WriteFloat(pf, psc->arLuck[1][1], 6, "]");
     }
 }
 
@@ -2331,6 +2564,7 @@ CommandSaveGame(char *sz)
 {
 
     FILE *pf;
+    char *pchBuffer = NULL;
 
     sz = NextToken(&sz);
 
@@ -2352,12 +2586,14 @@ CommandSaveGame(char *sz)
     else if (!(pf = g_fopen(sz, "w"))) {
         outputerr(sz);
         return;
-    }
+    } else
+        pchBuffer = SetSaveBuffer(pf);
 
     SaveGame(pf, plGame);
 
     if (pf != stdout)
         fclose(pf);
+    g_free(pchBuffer);
 
     setDefaultFileName(sz);
 
@@ -2370,6 +2606,7 @@ CommandSaveMatch(char *sz)
     FILE *pf;
     listOLD *pl;
     int fDontClose = FALSE;
+    char *pchBuffer = NULL;
 
     sz = NextToken(&sz);
 
@@ -2394,13 +2631,15 @@ CommandSaveMatch(char *sz)
     } else if (!(pf = g_fopen(sz, "w"))) {
         outputerr(sz);
         return;
-    }
+    } else
+        pchBuffer = SetSaveBuffer(pf);
 
     for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
         SaveGame(pf, pl->p);
 
     if (!fDontClose)
         fclose(pf);
+    g_free(pchBuffer);
 
     setDefaultFileName(sz);
 
@@ -2526,11 +2765,11 @@ CommandSavePosition(char *sz)
     while (l.plNext->p)
         ListDelete(l.plNext);
 
-    g_free(pmgi);
-    g_free(pmsb);
-    g_free(pmsd);
-    g_free(pmscv);
-    g_free(pmscp);
+    ReleaseMoveRecord(pmgi);
+    ReleaseMoveRecord(pmsb);
+    ReleaseMoveRecord(pmsd);
+    ReleaseMoveRecord(pmscv);
+    ReleaseMoveRecord(pmscp);
 
     setDefaultFileName(sz);
 }
@@ -29,19 +29,11 @@ typedef struct {
     listOLD *pl;                /* Values */
 } property;
 
-extern void (*SGFErrorHandler) (const char *szMessage, int fParseError);
+extern int SGFReadGame(FILE * pf, const char *szName, int *pfStarted);
 
-/* Parse an SGF file, and return a syntax tree.  The tree is saved as a list
- * of game trees; each game tree is a list where the first element is the
- * initial sequence of SGF nodes and any other elements are alternate
- * variations (each variation is itself a game tree).  Sequences of SGF
- * nodes are also stored as lists; each element is a single SGF node.
- * Nodes consist of yet MORE lists; each element is a "property" struct
- * as defined above.
- * 
- * If there are any errors in the file, SGFParse calls SGFErrorHandler
- * (if set), or complains to stderr (otherwise). */
-extern listOLD *SGFParse(FILE * pf);
+/* The SGF reader in sgf.c restores each node as soon as it has been
+ * read; a node is passed on as a list whose elements are "property"
+ * structs as defined above. */
 
 /* The following properties are defined for GNU Backgammon SGF files:
  * 
@@ -25,6 +25,7 @@
 #include <unistd.h>
 #endif
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <ctype.h>
 #include <math.h>
 
@@ -43,7 +44,10 @@
 #include "credits.h"
 #include "util.h"
 #include "openurl.h"
+#include "memusage.h"
+#include "metrics.h"
 #include "multithread.h"
+#include "rolloutworker.h"
 
 #if defined(USE_GTK)
 #include "gtkboard.h"
@@ -124,6 +128,10 @@ ShowEvaluation(const evalcontext * pec)
         outputl(pec->fDeterministic ? _(" (deterministic noise).\n") : _(" (pseudo-random noise).\n"));
     } else
         outputf("%s%s", "        ", _("Noiseless evaluations.\n"));
+
+    if (pec->iWeights)
+        outputf(_("        Using the weights `%s'.\n"),
+                EvalWeightsName(pec->iWeights) ? EvalWeightsName(pec->iWeights) : _("(not loaded)"));
 }
 
 extern int
@@ -243,7 +251,15 @@ ShowRollout(rolloutcontext * prc)
 
     outputl(prc->fVarRedn ?
             _("Lookahead variance reduction is enabled.") : _("Lookahead variance reduction is disabled."));
+    if (!prc->fVarRedn)
+        outputl(prc->fQuickVarRedn ?
+                _("Quick variance reduction is enabled.") : _("Quick variance reduction is disabled."));
+    if (prc->fAdaptiveJsd)
+        outputf(_("After %u games, moves that are JSDs behind the best one get fewer games.\n"),
+                prc->nMinimumJsdGames);
     outputl(prc->fRotate ? _("Quasi-random dice are enabled.") : _("Quasi-random dice are disabled."));
+    if (prc->fRotate && prc->fSobol)
+        outputl(_("Quasi-random dice come from a Sobol sequence."));
     outputl(prc->fCubeful ? _("Cubeful rollout.") : _("Cubeless rollout."));
     outputl(prc->fInitial ? _("Rollout as opening move enabled.") : _("Rollout as opening move disabled."));
     outputf(_("%s dice generator with seed %lu.\n"), gettext(aszRNG[prc->rngRollout]), prc->nSeed);
@@ -295,6 +311,9 @@ ShowRollout(rolloutcontext * prc)
             outputf(_("Rollouts may stop after %u games if equity STD"
                       " is less than %5.4f\n"), prc->nMinimumGames, prc->rStdLimit);
     }
+
+    if (prc->nMaxSeconds)
+        outputf(_("Rollouts stop after %u seconds\n"), prc->nMaxSeconds);
 }
 
 static void
@@ -370,6 +389,9 @@ CommandShowAnalysis(char *UNUSED(sz))
 
     outputl(fAnalyseCube ? _("Cube action will be analysed.") : _("Cube action will not be analysed."));
 
+    if (fAnalyseCube && fAnalyseCubeScreen)
+        outputl(_("Cube decisions clearly no double at 0-ply will not be analysed further."));
+
     outputl(fAnalyseDice ? _("Dice rolls will be analysed.") : _("Dice rolls will not be analysed."));
 
     if (fAnalyseMove) {
@@ -377,6 +399,15 @@ CommandShowAnalysis(char *UNUSED(sz))
     } else
         outputl(_("Chequer play will not be analysed."));
 
+    if (nAnalysisMoves)
+        outputf(_("The %u best moves and the one played are kept.\n"), nAnalysisMoves);
+
+    if (szAnalysisSummary)
+        outputf(_("The statistics of analysed matches are appended to `%s'.\n"), szAnalysisSummary);
+
+    if (szAnalysisJournal)
+        outputf(_("Match analyses keep a journal in `%s'.\n"), szAnalysisJournal);
+
     outputl("");
     for (i = 0; i < 2; ++i)
         outputf(_("Analyse %s's chequerplay and cube decisions: %s\n"),
@@ -517,33 +548,87 @@ CommandShowDelay(char *UNUSED(sz))
 #endif
 }
 
-#if CACHE_STATS
+static void
+ShowCacheLine(const char *sz, unsigned int cLookup, unsigned int cHitThread, unsigned int cHit)
+{
+    outputf("%-24s %12u %12u %12u", sz, cLookup, cHitThread, cHit);
+
+    if (cLookup)
+        outputf(" %6.1f%%\n", (float) (cHitThread + cHit) * 100.0f / (float) cLookup);
+    else
+        outputc('\n');
+}
+
 extern void
 CommandShowCache(char *UNUSED(sz))
 {
-    unsigned int c[2], cHit[2], cLookup[2];
+    static const char *aszClass[N_CLASSES] = {
+        N_("Over"),
+        N_("Hypergammon-1"),
+        N_("Hypergammon-2"),
+        N_("Hypergammon-3"),
+        N_("Bearoff2"),
+        N_("Bearoff-TS"),
+        N_("Bearoff1"),
+        N_("Bearoff-OS"),
+        N_("Race"),
+        N_("Crashed"),
+        N_("Contact")
+    };
+    static const char *aszPages[] = {
+        N_("ordinary pages"),
+        N_("transparent huge pages"),
+        N_("huge pages"),
+        N_("1 GB huge pages"),
+        N_("a shared memory segment")
+    };
+    const char *aszKind[2] = { N_("cubeless"), N_("cubeful") };
+    evalcachestats ecs;
+    unsigned int c, cPruning;
+    int i, j, k;
+
+    EvalCacheStats(&ecs, &c, &cPruning);
+
+    outputf(_("%u evaluation cache entries used, %u pruning cache entries used.\n"), c, cPruning);
+    outputf(_("The evaluation cache is in %s.\n"), gettext(aszPages[EvalGetCachePages()]));
+    if (EvalGetCachePages() == CACHE_PAGES_SHARED)
+        outputf(_("It is shared in %s with the processes using the same weights and settings.\n"),
+                EvalGetCacheShared());
+
+    if (!EvalGetCacheStats()) {
+        outputl(_("No statistics are kept (see `help set cachestats')."));
+        return;
+    }
 
-    EvalCacheStats(c, cLookup, cHit);
+    outputf("%-24s %12s %12s %12s %7s\n", "", _("lookups"), _("thread hits"), _("shared hits"), _("rate"));
 
-    outputf(_("%10u regular eval entries used %10u lookups %10u hits"), c[0], cLookup[0], cHit[0]);
+    for (k = 0; k < 2; k++) {
+        unsigned int (*ac)[CACHESTATS_PLIES][N_CLASSES] = k ? ecs.acCubeful : ecs.acCubeless;
 
-    if (cLookup[0])
-        outputf(" (%4.1f%%).", (float) cHit[0] * 100.0f / (float) cLookup[0]);
-    else
-        outputc('.');
+        for (i = 0; i < CACHESTATS_PLIES; i++)
+            for (j = 0; j < N_CLASSES; j++)
+                if (ac[CACHESTATS_LOOKUP][i][j]) {
+                    char sz[64];
 
-    outputc('\n');
+                    sprintf(sz, "%s %d%s-%s %s", gettext(aszKind[k]), i, i == CACHESTATS_PLIES - 1 ? "+" : "",
+                            _("ply"), gettext(aszClass[j]));
+                    ShowCacheLine(sz, ac[CACHESTATS_LOOKUP][i][j], ac[CACHESTATS_HIT_THREAD][i][j],
+                                  ac[CACHESTATS_HIT][i][j]);
+                }
+    }
 
-    outputf(_("%10u pruning eval entries used %10u lookups %10u hits"), c[1], cLookup[1], cHit[1]);
+    for (j = 0; j < N_CLASSES; j++)
+        if (ecs.acPruning[CACHESTATS_LOOKUP][j]) {
+            char sz[64];
 
-    if (cLookup[1])
-        outputf(" (%4.1f%%).", (float) cHit[1] * 100.0f / (float) cLookup[1]);
-    else
-        outputc('.');
+            sprintf(sz, "%s %s", _("pruning"), gettext(aszClass[j]));
+            ShowCacheLine(sz, ecs.acPruning[CACHESTATS_LOOKUP][j], 0, ecs.acPruning[CACHESTATS_HIT][j]);
+        }
 
-    outputc('\n');
+    if (ecs.acNode[0] + ecs.acNode[1])
+        outputf(_("%u shared cache lookups on the thread's own NUMA node, %u on another.\n"), ecs.acNode[0],
+                ecs.acNode[1]);
 }
-#endif
 
 extern void
 CommandShowCalibration(char *UNUSED(sz))
@@ -721,8 +806,23 @@ CommandShowEvaluation(char *UNUSED(sz))
     ShowEvalSetup(GetEvalChequer());
     outputl(_("    Move filters:"));
     ShowMoveFilters(*GetEvalMoveFilter());
+    if (EvalGetAdaptiveFilter())
+        outputl(_("      fewer moves are carried on when the scores show a clear break"));
+    if (EvalGetFilterBudget() > 0.0)
+        outputf(_("      no deeper plies after %.2f seconds\n"), EvalGetFilterBudget());
+    if (EvalGetEarlyExit() > 0.0f)
+        outputf(_("      moves trailing by more than %.3f are not scored deeper\n"), EvalGetEarlyExit());
+    if (EvalGetRaceApprox())
+        outputl(_("      race moves are pruned with a pip count estimate"));
+    if (EvalGetOpeningBook())
+        outputf(_("      the first moves of each side are kept in an opening book (%u of them)\n"),
+                OpeningBookSize());
     outputl(_("    Cube decisions:"));
     ShowEvalSetup(GetEvalCube());
+    outputf(_("Neural net hidden sigmoid: %s\n"),
+            EvalGetFastSigmoid() ? _("fast approximation") : _("table"));
+    outputf(_("Neural net batch backend: %s\n"), EvalGetBackend() ? EvalGetBackend()->szName : _("built in"));
+    outputf(_("Evaluation cache file: %s\n"), EvalGetCacheFile() ? EvalGetCacheFile() : _("none"));
 
 }
 
@@ -872,6 +972,51 @@ CommandShowPostCrawford(char *UNUSED(sz))
 
 }
 
+extern void
+CommandShowProfile(char *sz)
+{
+    guint64 acCalls[NUM_PROFILE_PHASES];
+    double arSeconds[NUM_PROFILE_PHASES];
+    double rElapsed = ProfileTotals(acCalls, arSeconds);
+    char *szFile = NextToken(&sz);
+    FILE *pf;
+    int i;
+
+    if (rElapsed <= 0.0) {
+        outputl(_("The engine has not been profiled (see `help set profile')."));
+        return;
+    }
+
+    outputf(_("%s for %.3f seconds (summed over the threads):\n"),
+            fProfile ? _("The engine has been profiled") : _("The engine was profiled"), rElapsed);
+    outputf("%-10s %14s %12s %10s %9s\n", "", _("calls"), _("ms"), _("ns/call"), _("elapsed"));
+
+    for (i = 0; i < NUM_PROFILE_PHASES; i++)
+        outputf("%-10s %14" G_GUINT64_FORMAT " %12.1f %10.1f %8.1f%%\n", aszProfilePhase[i], acCalls[i],
+                arSeconds[i] * 1e3, acCalls[i] ? arSeconds[i] * 1e9 / (double) acCalls[i] : 0.0,
+                100.0 * arSeconds[i] / rElapsed);
+
+    if (!szFile)
+        return;
+
+    if (!fProfileTrace) {
+        outputl(_("No trace has been kept (see `help set profile')."));
+        return;
+    }
+
+    if (!(pf = g_fopen(szFile, "w"))) {
+        outputerr(szFile);
+        return;
+    }
+
+    if (ProfileWriteTrace(pf) < 0)
+        outputerr(szFile);
+    else
+        outputf(_("The trace has been written to `%s'.\n"), szFile);
+
+    fclose(pf);
+}
+
 extern void
 CommandShowPrompt(char *UNUSED(sz))
 {
@@ -894,6 +1039,15 @@ CommandShowRollout(char *UNUSED(sz))
     outputl(_("`rollout' will use:"));
     ShowRollout(&rcRollout);
 
+    if (szRolloutWorkers)
+        outputf(_("Trials are also played by the rollout workers %s\n"), szRolloutWorkers);
+
+    if (szRolloutCheckpoint)
+        outputf(_("Rollouts save their state to %s\n"), szRolloutCheckpoint);
+
+    if (cRolloutLockstep > 1)
+        outputf(_("Each thread plays %u games of a move at once\n"), cRolloutLockstep);
+
 }
 
 extern void
@@ -1135,11 +1289,85 @@ CommandShowKleinman(char *sz)
 }
 
 #if USE_MULTITHREAD
+/* What each thread has done: its tasks, how much of the time it was
+ * busy with them, waiting for work or for the locks of MT_Lock(), and
+ * its evaluations, then how much each of those locks was waited for */
+static void
+ShowThreadStats(void)
+{
+    int i, j;
+
+    outputf("%-8s %8s %7s %10s %10s %12s %12s\n", _("thread"), _("tasks"), _("busy"), _("idle s"),
+            _("locked ms"), _("evaluations"), _("cache hits"));
+
+    for (i = -1; i < (int) MT_GetNumThreads(); i++) {
+        threadstats ts;
+        guint64 cEval = 0;
+        gint64 tAll;
+        char sz[16];
+
+        if (MT_GetThreadStats(i, &ts) < 0)
+            continue;
+
+        for (j = 0; j < N_CLASSES; j++)
+            cEval += ts.acEval[j];
+        tAll = ts.tBusy + ts.tIdle;
+
+        if (i < 0)
+            g_strlcpy(sz, _("main"), sizeof(sz));
+        else
+            sprintf(sz, "%d", i);
+
+        outputf("%-8s %8u %6.1f%% %10.1f %10.1f %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT "\n", sz,
+                ts.cTasks, tAll ? 100.0 * (double) ts.tBusy / (double) tAll : 0.0, (double) ts.tIdle / 1e6,
+                (double) ts.tExclusive / 1e3, cEval, ts.cCacheHit);
+    }
+
+    outputf("\n%-16s %12s %12s %10s\n", _("lock"), _("taken"), _("contended"), _("waited ms"));
+    for (i = 0; i < NUM_MT_LOCKS; i++) {
+        lockstats ls;
+
+        if (MT_GetLockStats((mtlockid) i, &ls) < 0)
+            continue;
+
+        outputf("%-16s %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT " %10.1f\n", gettext(aszLockName[i]),
+                ls.cTaken, ls.cContended, (double) ls.tWait / 1e3);
+    }
+}
+
 extern void
-CommandShowThreads(char *UNUSED(sz))
+CommandShowThreads(char *sz)
 {
     int c = MT_GetNumThreads();
+    char *pch = NextToken(&sz);
+
+    if (pch && !StrNCaseCmp(pch, "statistics", strlen(pch))) {
+        ShowThreadStats();
+        return;
+    }
+
     outputf(ngettext("%d calculation thread.\n", "%d calculation threads.\n", c), c);
+    if (MT_GetAutoThreads())
+        outputl(_("The number of threads is set from the CPUs and CPU quota gnubg has."));
+    if (MT_GetNuma())
+        outputl(_("The threads are pinned to NUMA nodes and the evaluation cache is interleaved over them."));
+    if (MT_GetShare())
+        outputl(_("Idle threads help with the candidate moves and the rolls of a single evaluation."));
+    if (fSpeculate)
+        outputl(_("Idle threads evaluate the position of a human player while they think about it."));
+    if (MT_GetAffinity() != AFFINITY_NONE) {
+        int i, iPackage = -1, iCore = -1;
+
+        outputf(_("The threads are pinned to CPUs (%s):\n"), aszAffinity[MT_GetAffinity()]);
+        for (i = 0; i < c; i++) {
+            int iCpu = MT_GetThreadCpu((unsigned int) i, &iPackage, &iCore);
+
+            if (iCpu < 0)
+                outputf(_("  thread %d: not pinned\n"), i);
+            else
+                outputf(_("  thread %d: CPU %d (package %d, core %d)\n"), i, iCpu, iPackage, iCore);
+        }
+    }
 }
 #endif
 
@@ -1446,7 +1674,7 @@ CommandShowOneSidedRollout(char *sz)
 
     outputf(_("One sided rollout with %d trials (%s on roll):\n"), nTrials, ap[ms.fMove].szName);
 
-    raceProbs((ConstTanBoard) anBoard, nTrials, ar, arMu);
+    raceProbs((ConstTanBoard) anBoard, nTrials, MT_GetNumThreads(), ar, arMu);
     outputl(OutputPercents(ar, TRUE));
 
     PipCount((ConstTanBoard) anBoard, anPips);
@@ -1960,6 +2188,9 @@ CommandShowExport(char *UNUSED(sz))
     outputf(_("- size of exported PNG pictures: %dx%d\n"),
             exsExport.nPNGSize * BOARD_WIDTH, exsExport.nPNGSize * BOARD_HEIGHT);
 
+    outputf(_("- cache of exported PNG pictures: %s\n"),
+            exsExport.szPNGCache ? exsExport.szPNGCache : _("none"));
+
     outputl("\n");
 
 }
@@ -2020,6 +2251,28 @@ CommandShowSound(char *UNUSED(sz))
     }
 }
 
+extern void
+CommandShowStartup(char *UNUSED(sz))
+{
+    unsigned int i, c = ProfileStartupCount();
+    double r, rTotal = 0.0;
+    int fLazy;
+
+    outputf("%-36s %10s\n", _("Started"), _("seconds"));
+    for (i = 0; i < c; i++) {
+        const char *szSubsystem = ProfileStartupItem(i, &r, &fLazy);
+
+        outputf("%-36s %10.3f%s\n", _(szSubsystem), r, fLazy ? _(" (when first needed)") : "");
+        if (!fLazy)
+            rTotal += r;
+    }
+    outputf("%-36s %10.3f\n", _("Total at startup"), rTotal);
+
+    if (!fLazyBearoff)
+        outputl(_("\nStart with --fast-startup to load the race and hypergammon databases\n"
+                  "and Python only when they are first needed."));
+}
+
 
 
 extern void
@@ -2222,8 +2475,8 @@ show_bearoff(TanBoard an, char *szTemp)
     switch (ms.bgv) {
     case VARIATION_STANDARD:
     case VARIATION_NACKGAMMON:
-        if (isBearoff(pbcTS, (ConstTanBoard) an)) {
-            BearoffDump(pbcTS, (ConstTanBoard) an, szTemp);
+        if (isBearoff(GetBearoffTS(), (ConstTanBoard) an)) {
+            BearoffDump(GetBearoffTS(), (ConstTanBoard) an, szTemp);
         } else if (isBearoff(pbc2, (ConstTanBoard) an)) {
             BearoffDump(pbc2, (ConstTanBoard) an, szTemp);
         } else
@@ -2234,8 +2487,8 @@ show_bearoff(TanBoard an, char *szTemp)
     case VARIATION_HYPERGAMMON_2:
     case VARIATION_HYPERGAMMON_3:
 
-        if (isBearoff(apbcHyper[ms.bgv - VARIATION_HYPERGAMMON_1], (ConstTanBoard) an)) {
-            BearoffDump(apbcHyper[ms.bgv - VARIATION_HYPERGAMMON_1], (ConstTanBoard) an, szTemp);
+        if (isBearoff(GetBearoffHyper((unsigned int) (ms.bgv - VARIATION_HYPERGAMMON_1)), (ConstTanBoard) an)) {
+            BearoffDump(GetBearoffHyper((unsigned int) (ms.bgv - VARIATION_HYPERGAMMON_1)), (ConstTanBoard) an, szTemp);
             outputl(szTemp);
         }
 
@@ -2341,6 +2594,49 @@ CommandShowMatchResult(char *UNUSED(sz))
 
 }
 
+static void
+ShowMemoryLine(const char *szName, gsize cbCurrent, gsize cbPeak)
+{
+    if (cbCurrent)
+        outputf("%-28s %10.1f", szName, (double) cbCurrent / 1048576.0);
+    else
+        outputf("%-28s %10s", szName, "-");
+    outputf(" %10.1f\n", (double) cbPeak / 1048576.0);
+}
+
+extern void
+CommandShowMemory(char *UNUSED(sz))
+{
+    gsize cbCurrent, cbPeak, cbTotal = 0;
+    int i;
+
+    AccountMatchMemory();
+
+    outputf("%-28s %10s %10s\n", _("Memory (MB)"), _("Current"), _("Peak"));
+    for (i = 0; i < N_MEM; i++) {
+        MemUsage((memsubsystem) i, &cbCurrent, &cbPeak);
+        ShowMemoryLine(MemName((memsubsystem) i), cbCurrent, cbPeak);
+        cbTotal += cbCurrent;
+    }
+    outputf("%-28s %10.1f\n", _("Total of the above"), (double) cbTotal / 1048576.0);
+
+    if (MemProcess(&cbCurrent, &cbPeak))
+        ShowMemoryLine(_("Process resident"), cbCurrent, cbPeak);
+
+    outputl(_("\nMapped weights and bearoff databases are counted in full, though\n"
+              "their pages are shared with other processes using the same files.\n"
+              "The match is measured when shown, so its peak is the largest seen."));
+}
+
+extern void
+CommandShowMetrics(char *UNUSED(sz))
+{
+    GString *gs = MetricsText();
+
+    output(gs->str);
+    g_string_free(gs, TRUE);
+}
+
 
 
 extern void
@@ -18,8 +18,13 @@
 
 #include "config.h"
 
+#include <string.h>
+#include <glib/gstdio.h>
+
 #include "backgammon.h"
 #include "multithread.h"
+#include "positionid.h"
+#include "util.h"
 
 #if defined(USE_GTK)
 #include "gtkgame.h"
@@ -37,6 +42,225 @@
 static randctx rc;
 static double timeTaken;
 
+static void
+SeedBoards(ub4 seed)
+{
+    unsigned int i;
+
+    rc.randrsl[0] = seed;
+    for (i = 1; i < RANDSIZ; i++)
+        rc.randrsl[i] = rc.randrsl[0];
+    irandinit(&rc, TRUE);
+}
+
+/* The position corpus: positions and rolls from real games, saved by
+ * "benchmark save" and read by "benchmark load", that calibrate and
+ * benchmark use instead of making up their own.  The file is text:
+ *
+ *   gnubg-positions 1
+ *   <position ID> <dice> <class>
+ *   ...
+ *
+ * with the dice as two digits and the class, as ClassifyPosition()
+ * gave it when the file was written, for information only.  Lines
+ * starting with # are comments. */
+
+#define CORPUS_MAGIC "gnubg-positions"
+#define CORPUS_VERSION 1
+#define CORPUS_MAX 65536
+/* read at the first calibrate or benchmark, if there */
+#define CORPUS_DEFAULT "positions.txt"
+
+static const char *aszCorpusClass[N_CLASSES] = {
+    "over", "hypergammon-1", "hypergammon-2", "hypergammon-3", "bearoff2", "bearoff-ts",
+    "bearoff1", "bearoff-os", "race", "crashed", "contact"
+};
+
+static TanBoard *aanCorpus;
+static unsigned int (*aanCorpusDice)[2];
+static unsigned int cCorpus;
+static int fCorpusTried;
+
+/* Read the corpus in sz.  The number of positions, or -1 if the file
+ * can't be read or is not a corpus. */
+static int
+CorpusLoad(const char *sz)
+{
+    FILE *pf;
+    char szLine[256];
+    TanBoard *aanBoard;
+    unsigned int (*aanDice)[2];
+    unsigned int c = 0, anCount[N_CLASSES] = { 0 };
+    int nVersion, i;
+
+    if (!(pf = g_fopen(sz, "r"))) {
+        outputerr(sz);
+        return -1;
+    }
+
+    if (!fgets(szLine, sizeof(szLine), pf) || sscanf(szLine, CORPUS_MAGIC " %d", &nVersion) != 1) {
+        outputerrf(_("%s is not a position corpus"), sz);
+        fclose(pf);
+        return -1;
+    }
+
+    if (nVersion > CORPUS_VERSION) {
+        outputerrf(_("%s is a position corpus of a later version (%d)"), sz, nVersion);
+        fclose(pf);
+        return -1;
+    }
+
+    aanBoard = g_new(TanBoard, CORPUS_MAX);
+    aanDice = g_malloc(CORPUS_MAX * sizeof(*aanDice));
+
+    while (c < CORPUS_MAX && fgets(szLine, sizeof(szLine), pf)) {
+        char szID[L_POSITIONID + 1];
+        unsigned int n0, n1;
+
+        if (*szLine == '#' || sscanf(szLine, "%14s %1u%1u", szID, &n0, &n1) != 3)
+            continue;
+
+        if (!PositionFromID(aanBoard[c], szID) || n0 < 1 || n0 > 6 || n1 < 1 || n1 > 6)
+            continue;
+
+        aanDice[c][0] = n0;
+        aanDice[c][1] = n1;
+        anCount[ClassifyPosition((ConstTanBoard) aanBoard[c], VARIATION_STANDARD)]++;
+        c++;
+    }
+
+    fclose(pf);
+
+    if (!c) {
+        outputerrf(_("%s holds no positions"), sz);
+        g_free(aanBoard);
+        g_free(aanDice);
+        return -1;
+    }
+
+    g_free(aanCorpus);
+    g_free(aanCorpusDice);
+    aanCorpus = aanBoard;
+    aanCorpusDice = aanDice;
+    cCorpus = c;
+
+    outputf(_("%u positions read from %s:"), c, sz);
+    for (i = 0; i < N_CLASSES; i++)
+        if (anCount[i])
+            outputf(" %s %u", aszCorpusClass[i], anCount[i]);
+    outputc('\n');
+
+    return (int) c;
+}
+
+/* Read the corpus that comes with gnubg, once, unless one has been
+ * loaded already */
+static void
+CorpusDefault(void)
+{
+    char *sz;
+
+    if (cCorpus || fCorpusTried)
+        return;
+
+    fCorpusTried = TRUE;
+    sz = BuildFilename(CORPUS_DEFAULT);
+    if (g_file_test(sz, G_FILE_TEST_EXISTS))
+        (void) CorpusLoad(sz);
+    g_free(sz);
+}
+
+typedef struct {
+    char szID[L_POSITIONID + 1];
+    unsigned int anDice[2];
+} corpusentry;
+
+/* Write up to CORPUS_MAX positions of the games of the match to sz,
+ * taken in turn from each class in a random order so that the first
+ * positions of the file are a fair sample of all of them */
+static void
+CorpusSave(const char *sz)
+{
+    GArray *aa[N_CLASSES];
+    listOLD *plGame, *pl;
+    unsigned int c = 0, cTotal = 0, i;
+    FILE *pf;
+
+    for (i = 0; i < N_CLASSES; i++)
+        aa[i] = g_array_new(FALSE, FALSE, sizeof(corpusentry));
+
+    for (plGame = lMatch.plNext; plGame != &lMatch; plGame = plGame->plNext) {
+        listOLD *plMoves = plGame->p;
+        matchstate msGame;
+
+        memset(&msGame, 0, sizeof(msGame));
+
+        for (pl = plMoves->plNext; pl != plMoves; pl = pl->plNext) {
+            moverecord *pmr = pl->p;
+
+            FixMatchState(&msGame, pmr);
+            if ((pmr->fPlayer != msGame.fMove)
+                && (pmr->mt == MOVE_NORMAL || pmr->mt == MOVE_RESIGN || pmr->mt == MOVE_SETDICE)) {
+                SwapSides(msGame.anBoard);
+                msGame.fMove = pmr->fPlayer;
+            }
+
+            if (pmr->mt == MOVE_NORMAL && msGame.bgv == VARIATION_STANDARD) {
+                corpusentry ce;
+                positionclass pc = ClassifyPosition((ConstTanBoard) msGame.anBoard, VARIATION_STANDARD);
+
+                strcpy(ce.szID, PositionID((ConstTanBoard) msGame.anBoard));
+                ce.anDice[0] = pmr->anDice[0];
+                ce.anDice[1] = pmr->anDice[1];
+                g_array_append_val(aa[pc], ce);
+                cTotal++;
+            }
+
+            ApplyMoveRecord(&msGame, plMoves, pmr);
+        }
+    }
+
+    if (!cTotal) {
+        outputl(_("There are no moves in the match to save."));
+        goto done;
+    }
+
+    if (!(pf = g_fopen(sz, "w"))) {
+        outputerr(sz);
+        goto done;
+    }
+
+    fprintf(pf, "%s %d\n", CORPUS_MAGIC, CORPUS_VERSION);
+    fprintf(pf, "# %s\n", VERSION_STRING);
+
+    SeedBoards((ub4) time(NULL));
+
+    while (c < MIN(cTotal, CORPUS_MAX))
+        for (i = 0; i < N_CLASSES && c < CORPUS_MAX; i++) {
+            corpusentry *pce;
+            unsigned int j;
+
+            if (!aa[i]->len)
+                continue;
+
+            /* take a random one of those left */
+            j = irand(&rc) % aa[i]->len;
+            pce = &g_array_index(aa[i], corpusentry, j);
+            fprintf(pf, "%s %u%u %s\n", pce->szID, pce->anDice[0], pce->anDice[1], aszCorpusClass[i]);
+            g_array_remove_index_fast(aa[i], j);
+            c++;
+        }
+
+    if (fclose(pf))
+        outputerr(sz);
+    else
+        outputf(_("%u positions written to %s.\n"), c, sz);
+
+  done:
+    for (i = 0; i < N_CLASSES; i++)
+        g_array_free(aa[i], TRUE);
+}
+
 static void
 RunEvals(void *UNUSED(notused))
 {
@@ -46,9 +270,19 @@ RunEvals(void *UNUSED(notused))
     SSE_ALIGN(float ar[NUM_OUTPUTS]);
 
 #if defined(USE_MULTITHREAD)
-    MT_Exclusive();
+    MT_Lock(MT_LOCK_CALIBRATE);
 #endif
     for (i = 0; i < EVALS_PER_ITERATION; i++) {
+        if (cCorpus) {
+            const TanBoard *pan = &aanCorpus[irand(&rc) % cCorpus];
+
+            for (j = 0; j < 25; j++) {
+                aanBoard[i][0][j] = (int) (*pan)[0][j];
+                aanBoard[i][1][j] = (int) (*pan)[1][j];
+            }
+            continue;
+        }
+
         /* Generate a random board.  Don't allow chequers on the bar
          * or borne off, so we can trivially guarantee the position
          * is legal. */
@@ -69,7 +303,7 @@ RunEvals(void *UNUSED(notused))
     }
 
 #if defined(USE_MULTITHREAD)
-    MT_Release();
+    MT_Unlock(MT_LOCK_CALIBRATE);
     MT_SyncStart();
 #else
     t = get_time();
@@ -91,7 +325,7 @@ extern void
 CommandCalibrate(char *sz)
 {
     int n = -1;
-    unsigned int i, iIter, iCacheSize;
+    unsigned int iIter, iCacheSize;
 #if defined(USE_GTK)
     void *pcc = NULL;
 #endif
@@ -117,10 +351,9 @@ CommandCalibrate(char *sz)
         return;
     }
 
-    rc.randrsl[0] = (ub4) time(NULL);
-    for (i = 0; i < RANDSIZ; i++)
-        rc.randrsl[i] = rc.randrsl[0];
-    irandinit(&rc, TRUE);
+    CorpusDefault();
+
+    SeedBoards((ub4) time(NULL));
 
 #if defined(USE_GTK)
     if (fX)
@@ -134,7 +367,7 @@ CommandCalibrate(char *sz)
             break;
 
 #if defined(USE_MULTITHREAD)
-        mt_add_tasks(MT_GetNumThreads(), RunEvals, NULL, NULL);
+        mt_add_tasks(MT_GetNumThreads(), RunEvals, NULL, NULL, TASK_INTERACTIVE);
         (void) MT_WaitForTasks(NULL, 0, FALSE);
         iIter += MT_GetNumThreads();
 #else
@@ -177,3 +410,540 @@ CommandCalibrate(char *sz)
         outputl(_("Calibration incomplete."));
     }
 }
+
+/* "benchmark [n]", "benchmark load|save <file>", "benchmark scaling
+ * [threads]": the speed of the main parts of the engine on the
+ * same positions every time, for comparing builds and releases.  Each
+ * benchmark times its operations one by one, on the main thread and
+ * with the evaluation cache off, and reports them as tab separated
+ * lines of the number of operations, operations per second and
+ * latency percentiles; n scales the number of operations.  When a
+ * wider neural net kernel was selected at runtime, eval-0ply-default
+ * repeats the 0-ply evaluations with the build's own one. */
+
+/* the positions benchmarked: the first ones of the position corpus,
+ * or positions of games gnubg plays against itself if there is none */
+#define BENCH_POSITIONS 512
+#define BENCH_SEED 1
+
+typedef struct {
+    unsigned int cPositions;
+    TanBoard aanBoard[BENCH_POSITIONS];
+    unsigned int aanDice[BENCH_POSITIONS][2];
+    TanBoard aanBearoff[BENCH_POSITIONS];
+    rolloutcontext rc;
+    rngcontext *rngctx;
+    perArray dicePerms;
+} benchcorpus;
+
+typedef struct {
+    const char *sz;
+    unsigned int cOps;          /* for n = 1 */
+    int (*pfOp) (benchcorpus * pbc, unsigned int i);
+} benchmark;
+
+static const evalcontext ecBench0 = { FALSE, 0, TRUE, TRUE, 0.0f };
+static const evalcontext ecBench0Cubeful = { TRUE, 0, TRUE, TRUE, 0.0f };
+
+static void
+BenchRoll(unsigned int anDice[2])
+{
+    anDice[0] = irand(&rc) % 6 + 1;
+    anDice[1] = irand(&rc) % 6 + 1;
+}
+
+/* Take the positions of the corpus or else play 0-ply games from the
+ * starting position with dice from BENCH_SEED, keeping each position
+ * and roll before the move; and make BENCH_POSITIONS random positions
+ * of the one-sided bearoff database */
+static void
+BenchCorpus(benchcorpus * pbc)
+{
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    TanBoard anBoard;
+    unsigned int i, nIDs = Combination(6 + 15, 6);
+    int anMove[8];
+
+    memcpy(aamf, defaultFilters, sizeof(aamf));
+
+    SeedBoards(BENCH_SEED);
+    InitBoard(anBoard, VARIATION_STANDARD);
+
+    pbc->cPositions = cCorpus ? MIN(cCorpus, BENCH_POSITIONS) : BENCH_POSITIONS;
+
+    for (i = 0; i < pbc->cPositions && cCorpus; i++) {
+        memcpy(pbc->aanBoard[i], aanCorpus[i], sizeof(TanBoard));
+        pbc->aanDice[i][0] = aanCorpusDice[i][0];
+        pbc->aanDice[i][1] = aanCorpusDice[i][1];
+    }
+
+    for (i = 0; i < pbc->cPositions && !cCorpus; i++) {
+        evalcontext ec = ecBench0;
+
+        if (GameStatus((ConstTanBoard) anBoard, VARIATION_STANDARD))
+            InitBoard(anBoard, VARIATION_STANDARD);
+
+        memcpy(pbc->aanBoard[i], anBoard, sizeof(TanBoard));
+        BenchRoll(pbc->aanDice[i]);
+
+        if (FindBestMove(anMove, (int) pbc->aanDice[i][0], (int) pbc->aanDice[i][1], anBoard, &ciCubeless, &ec,
+                         aamf) < 0)
+            InitBoard(anBoard, VARIATION_STANDARD);
+
+        SwapSides(anBoard);
+    }
+
+    for (i = 0; i < BENCH_POSITIONS; i++) {
+        PositionFromBearoff(pbc->aanBearoff[i][0], irand(&rc) % nIDs, 6, 15);
+        PositionFromBearoff(pbc->aanBearoff[i][1], irand(&rc) % nIDs, 6, 15);
+    }
+
+    /* rollouts at 0-ply with the same dice every time */
+    pbc->rc = rcRollout;
+    for (i = 0; i < 2; i++) {
+        pbc->rc.aecCube[i] = pbc->rc.aecChequer[i] = ecBench0;
+        pbc->rc.aecCubeLate[i] = pbc->rc.aecChequerLate[i] = ecBench0;
+    }
+    pbc->rc.aecCubeTrunc = pbc->rc.aecChequerTrunc = ecBench0;
+    pbc->rc.fLateEvals = pbc->rc.fVarRedn = pbc->rc.fQuickVarRedn = pbc->rc.fInitial = FALSE;
+    pbc->rc.fTruncBearoff2 = pbc->rc.fTruncBearoffOS = FALSE;
+    pbc->rc.rngRollout = RNG_MERSENNE;
+    pbc->rc.nSeed = BENCH_SEED;
+    pbc->rngctx = CopyRNGContext(rngctxRollout);
+    pbc->dicePerms.nPermutationSeed = -1;
+}
+
+static int
+BenchMoveGen(benchcorpus * pbc, unsigned int i)
+{
+    movelist ml;
+    unsigned int iPos = i % pbc->cPositions;
+
+    return GenerateMoves(&ml, (ConstTanBoard) pbc->aanBoard[iPos], (int) pbc->aanDice[iPos][0],
+                         (int) pbc->aanDice[iPos][1], FALSE) < 0 ? -1 : 0;
+}
+
+static int
+BenchEvalPlies(benchcorpus * pbc, unsigned int i, int nPlies)
+{
+    evalcontext ec = ecBench0;
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+
+    ec.nPlies = nPlies;
+
+    return GeneralEvaluationE(arOutput, (ConstTanBoard) pbc->aanBoard[i % pbc->cPositions], &ciCubeless, &ec);
+}
+
+static int
+BenchEval0(benchcorpus * pbc, unsigned int i)
+{
+    return BenchEvalPlies(pbc, i, 0);
+}
+
+static int
+BenchEval1(benchcorpus * pbc, unsigned int i)
+{
+    return BenchEvalPlies(pbc, i, 1);
+}
+
+static int
+BenchEval2(benchcorpus * pbc, unsigned int i)
+{
+    return BenchEvalPlies(pbc, i, 2);
+}
+
+static int
+BenchEval3(benchcorpus * pbc, unsigned int i)
+{
+    return BenchEvalPlies(pbc, i, 3);
+}
+
+/* 0-ply cubeful evaluations at a few scores of a 7 point match */
+static int
+BenchCubefulMatch(benchcorpus * pbc, unsigned int i)
+{
+    static const int aanScore[][2] = { {0, 0}, {2, 4}, {4, 4}, {5, 3}, {6, 5} };
+    const int *anScore = aanScore[i % G_N_ELEMENTS(aanScore)];
+    evalcontext ec = ecBench0Cubeful;
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    cubeinfo ci;
+    /* the cube centred, or turned to 2 or 4, but not in the Crawford game */
+    int iCube = anScore[0] == 6 ? 0 : (int) (i % 3);
+
+    if (SetCubeInfo(&ci, 1 << iCube, iCube - 1, 0, 7, anScore, anScore[0] == 6, FALSE, FALSE, VARIATION_STANDARD))
+        return -1;
+
+    return GeneralEvaluationE(arOutput, (ConstTanBoard) pbc->aanBoard[i % pbc->cPositions], &ci, &ec);
+}
+
+static int
+BenchBearoff(benchcorpus * pbc, unsigned int i)
+{
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    evalcontext ec = ecBench0;
+
+    return GeneralEvaluationE(arOutput, (ConstTanBoard) pbc->aanBearoff[i % BENCH_POSITIONS], &ciCubeless, &ec);
+}
+
+/* A trial of a rollout of a position of the corpus with the settings
+ * of prc, cubeful for money or not, truncated after nTruncate plies if
+ * it is not 0 */
+static int
+BenchTrial(const benchcorpus * pbc, unsigned int i, rolloutcontext * prc, int fCubeful, unsigned int nTruncate,
+           perArray * pdicePerms, rngcontext * rngctx)
+{
+    float aar[NUM_ROLLOUT_OUTPUTS];
+    int afCubeDecTop[1] = { FALSE };
+    cubeinfo ci;
+    int j;
+
+    prc->fCubeful = prc->aecCubeTrunc.fCubeful = prc->aecChequerTrunc.fCubeful = fCubeful;
+    for (j = 0; j < 2; j++)
+        prc->aecCube[j].fCubeful = prc->aecChequer[j].fCubeful = fCubeful;
+    prc->fDoTruncate = nTruncate > 0;
+    prc->nTruncate = (unsigned short) nTruncate;
+
+    if (fCubeful)
+        SetCubeInfoMoney(&ci, 1, -1, 0, FALSE, FALSE, VARIATION_STANDARD);
+    else
+        ci = ciCubeless;
+
+    return RolloutTrial((ConstTanBoard) pbc->aanBoard[(i / 4) % pbc->cPositions], aar, (int) i, &ci, afCubeDecTop,
+                        prc, NULL, ci.nCube, pdicePerms, rngctx, NULL);
+}
+
+static int
+BenchRollout(benchcorpus * pbc, unsigned int i, int fCubeful, unsigned int nTruncate)
+{
+    return BenchTrial(pbc, i, &pbc->rc, fCubeful, nTruncate, &pbc->dicePerms, pbc->rngctx);
+}
+
+static int
+BenchRolloutCubeless(benchcorpus * pbc, unsigned int i)
+{
+    return BenchRollout(pbc, i, FALSE, 0);
+}
+
+static int
+BenchRolloutCubeful(benchcorpus * pbc, unsigned int i)
+{
+    return BenchRollout(pbc, i, TRUE, 0);
+}
+
+static int
+BenchRolloutTruncated(benchcorpus * pbc, unsigned int i)
+{
+    return BenchRollout(pbc, i, TRUE, 7);
+}
+
+/* What the analysis does for a move: the cube decision before the roll
+ * and the moves of the roll, with the analysis settings (evaluations
+ * only) */
+static int
+BenchAnalysis(benchcorpus * pbc, unsigned int i)
+{
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+    unsigned int iPos = i % pbc->cPositions;
+    evalcontext ecCube = esAnalysisCube.ec, ecChequer = esAnalysisChequer.ec;
+    movelist ml;
+    cubeinfo ci;
+
+    SetCubeInfoMoney(&ci, 1, -1, 0, FALSE, FALSE, VARIATION_STANDARD);
+
+    if (GeneralCubeDecisionE(aarOutput, (ConstTanBoard) pbc->aanBoard[iPos], &ci, &ecCube, NULL) < 0)
+        return -1;
+
+    if (FindnSaveBestMoves(&ml, (int) pbc->aanDice[iPos][0], (int) pbc->aanDice[iPos][1],
+                           (ConstTanBoard) pbc->aanBoard[iPos], NULL, arSkillLevel[SKILL_DOUBTFUL], &ci, &ecChequer,
+                           aamfAnalysis) < 0)
+        return -1;
+
+    if (ml.cMoves)
+        g_free(ml.amMoves);
+
+    return 0;
+}
+
+static const benchmark abm[] = {
+    {"movegen", 16384, BenchMoveGen},
+    {"eval-0ply", 16384, BenchEval0},
+    {"eval-1ply", 512, BenchEval1},
+    {"eval-2ply", 64, BenchEval2},
+    {"eval-3ply", 8, BenchEval3},
+    {"cubeful-match", 16384, BenchCubefulMatch},
+    {"bearoff", 16384, BenchBearoff},
+    {"rollout-cubeless", 256, BenchRolloutCubeless},
+    {"rollout-cubeful", 256, BenchRolloutCubeful},
+    {"rollout-truncated", 1024, BenchRolloutTruncated},
+    {"analysis", 32, BenchAnalysis}
+};
+
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+/* the 0-ply evaluation again with the build's own kernel (SSE, AVX or
+ * NEON), for comparison when a wider one was selected at runtime */
+static const benchmark bmEvalDefault = { "eval-0ply-default", 16384, BenchEval0 };
+#endif
+
+static int
+CompareTimes(const void *p0, const void *p1)
+{
+    double r0 = *(const double *) p0, r1 = *(const double *) p1;
+
+    return r0 < r1 ? -1 : r0 > r1;
+}
+
+/* The latency of percentile rPercent of the sorted times, in
+ * microseconds */
+static double
+BenchPercentile(const double *ar, unsigned int c, double rPercent)
+{
+    unsigned int i = (unsigned int) (rPercent / 100.0 * (double) (c - 1) + 0.5);
+
+    return ar[i] * 1000.0;
+}
+
+/* Time the c operations of pbm one by one and output a line of the
+ * results */
+static void
+BenchRun(const benchmark * pbm, benchcorpus * pbc, int n)
+{
+    unsigned int c = pbm->cOps * (unsigned int) n, i;
+    double *ar = g_new(double, c);
+    double rTotal = 0.0;
+
+    for (i = 0; i < c && !MT_SafeGet(&fInterrupt); i++) {
+        guint64 t = get_time_ns();
+
+        if (pbm->pfOp(pbc, i) < 0)
+            break;
+
+        ar[i] = (double) (get_time_ns() - t) / 1e6;
+        rTotal += ar[i];
+    }
+
+    if (i < c) {
+        outputf("%s\tfailed\n", pbm->sz);
+    } else {
+        qsort(ar, c, sizeof(double), CompareTimes);
+        outputf("%s\t%u\t%.1f\t%.2f\t%.2f\t%.2f\n", pbm->sz, c,
+                rTotal > 0.0 ? c * 1000.0 / rTotal : 0.0,
+                BenchPercentile(ar, c, 50.0), BenchPercentile(ar, c, 90.0), BenchPercentile(ar, c, 99.0));
+    }
+
+    outputx();
+    g_free(ar);
+}
+
+#if defined(USE_MULTITHREAD)
+/* "benchmark scaling [threads]": the throughput of 0-ply evaluations,
+ * 2-ply evaluations and rollout trials with 1, 2, ... threads, and how
+ * it scales.  The threads share the same work, handed out in chunks,
+ * and the evaluation cache is flushed before each run. */
+
+#define SCALING_CHUNK 16
+
+typedef enum {
+    SCALING_EVAL0,
+    SCALING_EVAL2,
+    SCALING_ROLLOUT,
+    NUM_SCALINGS
+} scalingkind;
+
+static const struct {
+    const char *sz;
+    unsigned int cOps;
+} asc[NUM_SCALINGS] = {
+    {"eval-0ply", 65536},
+    {"eval-2ply", 512},
+    {"rollout-cubeful", 1024}
+};
+
+typedef struct {
+    const benchcorpus *pbc;
+    scalingkind sk;
+    unsigned int cOps;
+    int iNextChunk;
+    int fFailed;
+} scalingjob;
+
+SIMD_STACKALIGN static void
+ScalingTask(void *p)
+{
+    scalingjob *psj = (scalingjob *) p;
+    const benchcorpus *pbc = psj->pbc;
+    rolloutcontext rc = pbc->rc;
+    rngcontext *rngctx = CopyRNGContext(rngctxRollout);
+    perArray dicePerms;
+    evalcontext ec = ecBench0;
+    unsigned int i, iChunk;
+
+    dicePerms.nPermutationSeed = -1;
+    ec.nPlies = psj->sk == SCALING_EVAL2 ? 2 : 0;
+
+    while ((iChunk = (unsigned int) MT_SafeIncValue(&psj->iNextChunk) - 1) * SCALING_CHUNK < psj->cOps) {
+        for (i = iChunk * SCALING_CHUNK; i < MIN((iChunk + 1) * SCALING_CHUNK, psj->cOps); i++) {
+            float arOutput[NUM_ROLLOUT_OUTPUTS];
+            int n;
+
+            if (MT_Cancelled())
+                goto done;
+
+            if (psj->sk == SCALING_ROLLOUT)
+                n = BenchTrial(pbc, i, &rc, TRUE, 0, &dicePerms, rngctx);
+            else
+                n = GeneralEvaluationE(arOutput, (ConstTanBoard) pbc->aanBoard[i % pbc->cPositions], &ciCubeless,
+                                       &ec);
+
+            if (n < 0) {
+                MT_SafeSet(&psj->fFailed, TRUE);
+                goto done;
+            }
+        }
+    }
+
+  done:
+    free_rngctx(rngctx);
+}
+
+static void
+BenchmarkScaling(benchcorpus * pbc, unsigned int cMaxThreads, unsigned int n)
+{
+    const unsigned int cThreadsSaved = MT_GetNumThreads();
+    double arRate[NUM_SCALINGS] = { 0.0 };
+    unsigned int cThreads;
+    int sk;
+
+    outputf("# threads\tbenchmark\toperations\tper second\tspeedup\tefficiency\n");
+
+    for (cThreads = 1; cThreads <= cMaxThreads && !MT_SafeGet(&fInterrupt); cThreads++) {
+        MT_SetNumThreads(cThreads);
+
+        for (sk = 0; sk < NUM_SCALINGS && !MT_SafeGet(&fInterrupt); sk++) {
+            scalingjob sj;
+            guint64 t;
+            double rRate;
+
+            sj.pbc = pbc;
+            sj.sk = (scalingkind) sk;
+            sj.cOps = asc[sk].cOps * n;
+            sj.iNextChunk = 0;
+            sj.fFailed = FALSE;
+
+            EvalCacheFlush();
+
+            t = get_time_ns();
+            mt_add_tasks(cThreads, ScalingTask, &sj, NULL, TASK_INTERACTIVE);
+            (void) MT_WaitForTasks(NULL, 0, FALSE);
+            t = get_time_ns() - t;
+
+            if (sj.fFailed || MT_SafeGet(&fInterrupt)) {
+                outputf("%u\t%s\tfailed\n", cThreads, asc[sk].sz);
+                continue;
+            }
+
+            rRate = t > 0 ? sj.cOps * 1e9 / (double) t : 0.0;
+            if (cThreads == 1)
+                arRate[sk] = rRate;
+
+            outputf("%u\t%s\t%u\t%.1f\t%.2f\t%.2f\n", cThreads, asc[sk].sz, sj.cOps, rRate,
+                    arRate[sk] > 0.0 ? rRate / arRate[sk] : 0.0,
+                    arRate[sk] > 0.0 ? rRate / arRate[sk] / cThreads : 0.0);
+            outputx();
+        }
+    }
+
+    MT_SetNumThreads(cThreadsSaved);
+}
+#endif
+
+extern void
+CommandBenchmark(char *sz)
+{
+    benchcorpus *pbc;
+    unsigned int iCacheSize, ibm;
+    int n = 1;
+#if defined(USE_MULTITHREAD)
+    int fScaling = FALSE;
+    unsigned int cMaxThreads = 1;
+#endif
+
+    if (sz && (!StrNCaseCmp(sz, "load", 4) || !StrNCaseCmp(sz, "save", 4))) {
+        int fSave = !StrNCaseCmp(sz, "save", 4);
+        char *szFile;
+
+        sz += 4;
+        if (!(szFile = NextToken(&sz))) {
+            outputl(_("You must specify a file for the position corpus."));
+            return;
+        }
+
+        if (fSave)
+            CorpusSave(szFile);
+        else
+            (void) CorpusLoad(szFile);
+        return;
+    }
+
+    if (sz && !StrNCaseCmp(sz, "scaling", 7)) {
+#if defined(USE_MULTITHREAD)
+        int cThreads = (int) MT_GetNumThreads();
+
+        sz += 7;
+        if (sz && *sz && (cThreads = ParseNumber(&sz)) < 1) {
+            outputl(_("If you specify a parameter to `benchmark scaling', "
+                      "it must be the largest number of threads to run."));
+            return;
+        }
+        fScaling = TRUE;
+        cMaxThreads = (unsigned int) cThreads;
+#else
+        outputl(_("This installation of GNU Backgammon was compiled without thread support."));
+        return;
+#endif
+    } else if (sz && *sz && (n = ParseNumber(&sz)) < 1) {
+        outputl(_("If you specify a parameter to `benchmark', " "it must be a number to scale the operations by."));
+        return;
+    }
+
+    CorpusDefault();
+
+    pbc = g_new(benchcorpus, 1);
+    BenchCorpus(pbc);
+
+#if defined(USE_MULTITHREAD)
+    if (fScaling) {
+        outputf("# %s\n", cCorpus ? _("positions of the corpus") : _("positions of 0-ply games"));
+        BenchmarkScaling(pbc, cMaxThreads, 1);
+        free_rngctx(pbc->rngctx);
+        g_free(pbc);
+        return;
+    }
+#endif
+
+    iCacheSize = GetEvalCacheEntries();
+    EvalCacheResize(0);
+
+    outputf("# %s\n", cCorpus ? _("positions of the corpus") : _("positions of 0-ply games"));
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+    outputf("# %s %s\n", _("neural net kernel"), NeuralNetKernelName(NeuralNetGetKernel()));
+#endif
+    outputf("# benchmark\toperations\tper second\tp50 us\tp90 us\tp99 us\n");
+
+    for (ibm = 0; ibm < G_N_ELEMENTS(abm) && !MT_SafeGet(&fInterrupt); ibm++)
+        BenchRun(&abm[ibm], pbc, n);
+
+#if defined(USE_SIMD_DISPATCH) || defined(USE_SVE_DISPATCH)
+    if (NeuralNetGetKernel() != SIMD_KERNEL_DEFAULT && !MT_SafeGet(&fInterrupt)) {
+        simdkernel kernel = NeuralNetGetKernel();
+
+        NeuralNetSetKernel(SIMD_KERNEL_DEFAULT);
+        BenchRun(&bmEvalDefault, pbc, n);
+        NeuralNetSetKernel(kernel);
+    }
+#endif
+
+    free_rngctx(pbc->rngctx);
+    g_free(pbc);
+
+    EvalCacheResize(iCacheSize);
+}
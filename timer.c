@@ -22,65 +22,56 @@
 
 #include <time.h>
 
-#if !HAVE_CLOCK_GETTIME
-#if HAVE_SYS_TIME_H
-#include <sys/time.h>
-#endif
-#endif
-
 #include "backgammon.h"
 
+/* The one clock of gnubg: monotonic nanoseconds from an arbitrary
+ * start, for timings, progress and the profiler */
+
 #ifdef WIN32
 #include <windows.h>
 
-static double perFreq = 0;
-
-static int
-setup_timer()
+extern guint64
+get_time_ns(void)
 {
-    LARGE_INTEGER freq;
-    if (!QueryPerformanceFrequency(&freq)) {    /* Timer not supported */
-        return 0;
-    } else {
-        perFreq = ((double) freq.QuadPart) / 1000;
-        return 1;
-    }
-}
-
-double
-get_time()
-{                               /* Return elapsed time in milliseconds */
-    LARGE_INTEGER timer;
+    static LONGLONG nFreq;
+    LARGE_INTEGER li;
 
-    if (!perFreq) {
-        if (!setup_timer())
-            return clock() / 1000.0;
+    if (!nFreq) {
+        if (!QueryPerformanceFrequency(&li) || !li.QuadPart)   /* Timer not supported */
+            return (guint64) g_get_monotonic_time() * 1000;
+        nFreq = li.QuadPart;
     }
 
-    QueryPerformanceCounter(&timer);
-    return timer.QuadPart / perFreq;
+    QueryPerformanceCounter(&li);
+
+    /* in two parts, as the counter times 10^9 would overflow */
+    return (guint64) (li.QuadPart / nFreq) * 1000000000u + (guint64) (li.QuadPart % nFreq) * 1000000000u / (guint64) nFreq;
 }
 
 #elif HAVE_CLOCK_GETTIME
 
-extern double
-get_time(void)
-{                               /* Return elapsed time in milliseconds */
+extern guint64
+get_time_ns(void)
+{
     struct timespec ts;
+
     clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    return 1000.0 * (double) ts.tv_sec + 0.000001 * (double) ts.tv_nsec;
+    return (guint64) ts.tv_sec * 1000000000u + (guint64) ts.tv_nsec;
 }
 
 #else
 
+extern guint64
+get_time_ns(void)
+{
+    return (guint64) g_get_monotonic_time() * 1000;
+}
+
+#endif
+
 extern double
 get_time(void)
 {                               /* Return elapsed time in milliseconds */
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-
-    return 1000.0 * tv.tv_sec + 0.001 * tv.tv_usec;
+    return (double) get_time_ns() / 1e6;
 }
-
-#endif
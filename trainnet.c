@@ -0,0 +1,499 @@
+/*
+ * Copyright (C) 2024 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* trainnet: train one of the nets of a weights file on the data
+ * makedata makes.  The positions of the class of the net are read
+ * from the data files and the net is trained on them by mini-batch
+ * gradient descent for some epochs, each batch shared out between the
+ * threads (see NeuralNetGradient()).  The weights, those of the other
+ * nets unchanged, are written in the binary format of gnubg.wd after
+ * each epoch, ready for EvalInitialise() or "load weights".
+ *
+ *   trainnet -c race -e 20 -o race.wd race.dat
+ *   trainnet -c contact -w contact.wd -j 8 -o contact.wd contact.dat
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <locale.h>
+
+#include "backgammon.h"
+#include "eval.h"
+#include "positionid.h"
+#include "matchequity.h"
+#include "multithread.h"
+#include "glib-ext.h"
+#include "util.h"
+
+/* see makedata.c */
+#define DATA_MAGIC "gnubg-data"
+#define DATA_VERSION 1
+#define RECORD_SIZE (10 + NUM_OUTPUTS * 4)
+
+/* The nets of a weights file: contact, race and crashed, then their
+ * pruning nets */
+#define N_NETS 6
+
+typedef struct {
+    oldpositionkey key;
+    float arTarget[NUM_OUTPUTS];
+} trainrecord;
+
+typedef struct {
+    const neuralnet *pnn;
+    positionclass pc;
+    const trainrecord *atr;
+    const unsigned int *ai;     /* the records in the order of the epoch */
+
+    /* the slices of the batch still being worked on */
+    GMutex mutex;
+    GCond cond;
+    unsigned int cPending;
+} trainjob;
+
+typedef struct {
+    trainjob *ptj;
+    unsigned int iFirst, c;     /* the slice of the batch, in ai[] */
+    float *arInputs;
+    float *arTargets;
+    nngradient ng;
+} trainslice;
+
+extern void
+outputerrf(const char *sz, ...)
+{
+    va_list val;
+    char *szMessage;
+
+    va_start(val, sz);
+    szMessage = g_strdup_vprintf(sz, val);
+    va_end(val);
+
+    g_printerr("%s\n", szMessage);
+    g_free(szMessage);
+}
+
+extern void
+MT_CloseThreads(void)
+{
+    return;
+}
+
+/* Read the nets of a text or binary weights file */
+static int
+ReadWeights(const char *sz, neuralnet ann[N_NETS])
+{
+    FILE *pf;
+    float ar[2];
+    char szVersion[16];
+    int i, fRead = TRUE;
+
+    if (!(pf = g_fopen(sz, "rb"))) {
+        g_printerr(_("Can't read %s\n"), sz);
+        return -1;
+    }
+
+    if (fread(ar, sizeof(ar[0]), 2, pf) == 2 && ar[0] == WEIGHTS_MAGIC_BINARY) {
+        if (ar[1] != WEIGHTS_VERSION_BINARY)
+            fRead = FALSE;
+        for (i = 0; fRead && i < N_NETS; i++)
+            fRead = !NeuralNetLoadBinary(ann + i, pf);
+    } else {
+        rewind(pf);
+        setlocale(LC_ALL, "C");
+        if (fscanf(pf, "GNU Backgammon %15s\n", szVersion) != 1 || strcmp(szVersion, WEIGHTS_VERSION))
+            fRead = FALSE;
+        for (i = 0; fRead && i < N_NETS; i++)
+            fRead = !NeuralNetLoad(ann + i, pf);
+        setlocale(LC_ALL, "");
+    }
+
+    fclose(pf);
+
+    if (!fRead)
+        g_printerr(_("%s is not a weights file of version %s\n"), sz, WEIGHTS_VERSION);
+
+    return fRead ? 0 : -1;
+}
+
+/* Write the nets as gnubg.wd, through a temporary file so that an
+ * interrupted run leaves the last epoch's */
+static int
+WriteWeights(const char *sz, const neuralnet ann[N_NETS])
+{
+    static float ar[2] = { WEIGHTS_MAGIC_BINARY, WEIGHTS_VERSION_BINARY };
+    char *szTemp = g_strconcat(sz, ".tmp", NULL);
+    FILE *pf;
+    int i, fWritten;
+
+    if (!(pf = g_fopen(szTemp, "wb"))) {
+        g_printerr(_("Can't write %s\n"), szTemp);
+        g_free(szTemp);
+        return -1;
+    }
+
+    fWritten = fwrite(ar, sizeof(ar[0]), 2, pf) == 2;
+    for (i = 0; fWritten && i < N_NETS; i++)
+        fWritten = !NeuralNetSaveBinary(ann + i, pf);
+    fWritten = !fclose(pf) && fWritten;
+
+    if (!fWritten || g_rename(szTemp, sz)) {
+        g_printerr(_("Can't write %s\n"), sz);
+        g_unlink(szTemp);
+        fWritten = FALSE;
+    }
+
+    g_free(szTemp);
+    return fWritten ? 0 : -1;
+}
+
+/* Add the positions of class pc in the data file sz to pa */
+static int
+ReadData(const char *sz, positionclass pc, GArray * pa)
+{
+    FILE *pf;
+    char szLine[128];
+    unsigned char auch[RECORD_SIZE];
+    int nVersion;
+
+    if (!(pf = g_fopen(sz, "rb"))) {
+        g_printerr(_("Can't read %s\n"), sz);
+        return -1;
+    }
+
+    if (!fgets(szLine, sizeof(szLine), pf) || sscanf(szLine, DATA_MAGIC " %d", &nVersion) != 1
+        || nVersion != DATA_VERSION) {
+        g_printerr(_("%s was not made by makedata\n"), sz);
+        fclose(pf);
+        return -1;
+    }
+
+    while (fread(auch, RECORD_SIZE, 1, pf) == 1) {
+        trainrecord tr;
+        TanBoard anBoard;
+        int i;
+
+        memcpy(tr.key.auch, auch, 10);
+        oldPositionFromKey(anBoard, &tr.key);
+        if (ClassifyPosition((ConstTanBoard) anBoard, VARIATION_STANDARD) != pc)
+            continue;
+
+        for (i = 0; i < NUM_OUTPUTS; i++) {
+            guint32 n;
+
+            memcpy(&n, auch + 10 + 4 * i, 4);
+            n = GUINT32_FROM_LE(n);
+            memcpy(tr.arTarget + i, &n, 4);
+        }
+
+        g_array_append_val(pa, tr);
+    }
+
+    fclose(pf);
+    return 0;
+}
+
+static void
+SliceGradient(trainslice * pts)
+{
+    const trainjob *ptj = pts->ptj;
+    const neuralnet *pnn = ptj->pnn;
+    unsigned int i;
+
+    for (i = 0; i < pts->c; i++) {
+        const trainrecord *ptr = ptj->atr + ptj->ai[pts->iFirst + i];
+        TanBoard anBoard;
+
+        oldPositionFromKey(anBoard, &ptr->key);
+        EvalNetInputs((ConstTanBoard) anBoard, ptj->pc, pts->arInputs + i * pnn->cInput);
+        memcpy(pts->arTargets + i * NUM_OUTPUTS, ptr->arTarget, sizeof(ptr->arTarget));
+    }
+
+    NeuralNetGradientClear(&pts->ng);
+    NeuralNetGradient(pnn, pts->arInputs, pts->arTargets, pts->c, &pts->ng);
+}
+
+static void
+SliceThread(gpointer p, gpointer UNUSED(user_data))
+{
+    trainslice *pts = p;
+    trainjob *ptj = pts->ptj;
+
+    SliceGradient(pts);
+
+    g_mutex_lock(&ptj->mutex);
+    if (!--ptj->cPending)
+        g_cond_signal(&ptj->cond);
+    g_mutex_unlock(&ptj->mutex);
+}
+
+/* One pass over the cRecord records in the order ptj->ai, a step of
+ * the net for each batch of cBatch.  Returns the RMS error of the
+ * outputs over the pass, or a negative number on errors. */
+static double
+TrainEpoch(trainjob * ptj, neuralnet * pnn, trainslice ats[], unsigned int cSlice, GThreadPool * pool,
+           unsigned int cRecord, unsigned int cBatch, float rAlpha)
+{
+    nngradient *png = &ats[0].ng;
+    double rError = 0.0;
+    unsigned int i, j;
+
+    for (i = 0; i < cRecord; i += cBatch) {
+        unsigned int const c = MIN(cBatch, cRecord - i);
+
+        for (j = 0; j < cSlice; j++) {
+            ats[j].iFirst = i + c * j / cSlice;
+            ats[j].c = i + c * (j + 1) / cSlice - ats[j].iFirst;
+        }
+
+        /* the first slice is this thread's */
+        ptj->cPending = cSlice - 1;
+        for (j = 1; j < cSlice; j++)
+            g_thread_pool_push(pool, ats + j, NULL);
+
+        SliceGradient(ats);
+
+        g_mutex_lock(&ptj->mutex);
+        while (ptj->cPending)
+            g_cond_wait(&ptj->cond, &ptj->mutex);
+        g_mutex_unlock(&ptj->mutex);
+
+        for (j = 1; j < cSlice; j++)
+            NeuralNetGradientAdd(png, &ats[j].ng);
+
+        rError += png->rError;
+        if (NeuralNetTrain(pnn, png, rAlpha))
+            return -1.0;
+    }
+
+    return sqrt(rError / ((double) cRecord * NUM_OUTPUTS));
+}
+
+extern int
+main(int argc, char **argv)
+{
+    static char *szDataDir = NULL;
+    static char *szClass = NULL;
+    static char *szWeightsIn = NULL;
+    static char *szOutput = NULL;
+    static int nEpochs = 10;
+    static int nBatch = 256;
+    static double rAlpha = 0.1;
+    static int nThreads = 1;
+    static int nSeed = 0;
+    static const char *aszClass[] = { "race", "crashed", "contact" };
+    static const positionclass apc[] = { CLASS_RACE, CLASS_CRASHED, CLASS_CONTACT };
+    static const int aiNet[] = { 1, 2, 0 };     /* their nets in the weights file */
+    neuralnet ann[N_NETS];
+    neuralnet *pnn;
+    trainjob tj;
+    trainslice *ats;
+    GThreadPool *pool = NULL;
+    GArray *pa;
+    GRand *pr;
+    unsigned int *ai;
+    char *szMET, *szWeights, *szWeightsBinary;
+    unsigned int i, j, cRecord;
+    int iClass, nEpoch;
+
+    GOptionEntry ao[] = {
+        {"datadir", 'd', 0, G_OPTION_ARG_FILENAME, &szDataDir,
+         N_("Read the weights and databases from DIR"), "DIR"},
+        {"class", 'c', 0, G_OPTION_ARG_STRING, &szClass,
+         N_("Train the net of CLASS: race, crashed or contact"), "CLASS"},
+        {"weights", 'w', 0, G_OPTION_ARG_FILENAME, &szWeightsIn,
+         N_("Start from the weights in FILE (default gnubg.weights)"), "FILE"},
+        {"output", 'o', 0, G_OPTION_ARG_FILENAME, &szOutput,
+         N_("Write the trained weights to FILE"), "FILE"},
+        {"epochs", 'e', 0, G_OPTION_ARG_INT, &nEpochs,
+         N_("Train for N passes over the data (default 10)"), "N"},
+        {"batch", 'b', 0, G_OPTION_ARG_INT, &nBatch,
+         N_("Step the weights every N positions (default 256)"), "N"},
+        {"alpha", 'a', 0, G_OPTION_ARG_DOUBLE, &rAlpha,
+         N_("Learning rate X (default 0.1)"), "X"},
+        {"threads", 'j', 0, G_OPTION_ARG_INT, &nThreads,
+         N_("Calculate with N threads"), "N"},
+        {"seed", 's', 0, G_OPTION_ARG_INT, &nSeed,
+         N_("Seed the order of the positions with N (default from the time)"), "N"},
+        {NULL, 0, 0, (GOptionArg) 0, NULL, NULL, NULL}
+    };
+    GError *error = NULL;
+    GOptionContext *context;
+
+    setlocale(LC_ALL, "");
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+
+    context = g_option_context_new(_("datafile..."));
+    g_option_context_add_main_entries(context, ao, PACKAGE);
+    g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (error) {
+        g_printerr("%s\n", error->message);
+        exit(1);
+    }
+
+    if (argc < 2 || !szClass || !szOutput) {
+        g_printerr(_("A class (-c), an output file (-o) and the data files should be given\n"
+                     "For more help try `trainnet --help'\n"));
+        exit(1);
+    }
+
+    for (iClass = 0; iClass < (int) G_N_ELEMENTS(aszClass) && strcmp(szClass, aszClass[iClass]); iClass++);
+    if (iClass == (int) G_N_ELEMENTS(aszClass)) {
+        g_printerr(_("Unknown class of position: %s\n"), szClass);
+        exit(1);
+    }
+
+    if (nEpochs < 1 || nBatch < 1 || rAlpha <= 0.0) {
+        g_printerr(_("The epochs, batch size and learning rate must be positive\n"));
+        exit(1);
+    }
+
+#if defined(USE_MULTITHREAD)
+    if (nThreads < 1 || nThreads > MAX_NUMTHREADS) {
+        g_printerr(_("Number of threads must be between 1 and %d\n"), MAX_NUMTHREADS);
+        exit(1);
+    }
+#else
+    nThreads = 1;
+#endif
+
+    if (szDataDir) {
+        g_free(pkg_datadir);
+        pkg_datadir = g_strdup(szDataDir);
+    }
+
+    glib_ext_init();
+    MT_InitThreads();
+
+    /* the input tables and bearoff databases, for classifying the
+     * positions as gnubg does */
+    szMET = BuildFilename2("met", "Kazaross-XG2.xml");
+    InitMatchEquity(szMET);
+    g_free(szMET);
+
+    szWeights = BuildFilename("gnubg.weights");
+    szWeightsBinary = BuildFilename("gnubg.wd");
+    EvalInitialise(szWeights, szWeightsBinary, FALSE, NULL);
+    g_free(szWeightsBinary);
+
+    if (ReadWeights(szWeightsIn ? szWeightsIn : szWeights, ann))
+        exit(1);
+    g_free(szWeights);
+
+    pnn = ann + aiNet[iClass];
+    if (pnn->cOutput != NUM_OUTPUTS) {
+        g_printerr(_("The %s net has %u outputs, not %d\n"), szClass, pnn->cOutput, NUM_OUTPUTS);
+        exit(1);
+    }
+
+    pa = g_array_new(FALSE, FALSE, sizeof(trainrecord));
+    for (i = 1; i < (unsigned int) argc; i++)
+        if (ReadData(argv[i], apc[iClass], pa))
+            exit(1);
+
+    if (!(cRecord = pa->len)) {
+        g_printerr(_("The data holds no %s positions\n"), szClass);
+        exit(1);
+    }
+
+    ai = g_new(unsigned int, cRecord);
+    for (i = 0; i < cRecord; i++)
+        ai[i] = i;
+
+    memset(&tj, 0, sizeof(tj));
+    tj.pnn = pnn;
+    tj.pc = apc[iClass];
+    tj.atr = (const trainrecord *) (void *) pa->data;
+    tj.ai = ai;
+    g_mutex_init(&tj.mutex);
+    g_cond_init(&tj.cond);
+
+    /* no more slices than positions in a batch */
+    nThreads = MIN(nThreads, nBatch);
+    ats = g_new0(trainslice, nThreads);
+    for (j = 0; j < (unsigned int) nThreads; j++) {
+        unsigned int const c = (unsigned int) nBatch / (unsigned int) nThreads + 1;
+
+        ats[j].ptj = &tj;
+        ats[j].arInputs = g_new(float, c * pnn->cInput);
+        ats[j].arTargets = g_new(float, c * NUM_OUTPUTS);
+        if (NeuralNetGradientCreate(pnn, &ats[j].ng)) {
+            g_printerr(_("Out of memory\n"));
+            exit(1);
+        }
+    }
+
+    if (nThreads > 1)
+        pool = g_thread_pool_new(SliceThread, NULL, nThreads - 1, TRUE, NULL);
+
+    pr = g_rand_new_with_seed((guint32) (nSeed ? nSeed : g_get_real_time()));
+
+    g_print(_("Training the %s net on %u positions with %d threads\n"), szClass, cRecord, nThreads);
+
+    for (nEpoch = 1; nEpoch <= nEpochs; nEpoch++) {
+        double rError;
+
+        for (i = cRecord - 1; i > 0; i--) {
+            unsigned int const k = (unsigned int) g_rand_int_range(pr, 0, (gint32) i + 1);
+            unsigned int const n = ai[i];
+
+            ai[i] = ai[k];
+            ai[k] = n;
+        }
+
+        if ((rError = TrainEpoch(&tj, pnn, ats, (unsigned int) nThreads, pool, cRecord, (unsigned int) nBatch,
+                                 (float) rAlpha)) < 0.0) {
+            g_printerr(_("Failed to train the net\n"));
+            exit(1);
+        }
+
+        if (WriteWeights(szOutput, ann))
+            exit(1);
+
+        g_print(_("Epoch %d: RMS error %.6f\n"), nEpoch, rError);
+    }
+
+    if (pool)
+        g_thread_pool_free(pool, FALSE, TRUE);
+
+    for (j = 0; j < (unsigned int) nThreads; j++) {
+        NeuralNetGradientDestroy(&ats[j].ng);
+        g_free(ats[j].arInputs);
+        g_free(ats[j].arTargets);
+    }
+    g_free(ats);
+
+    for (i = 0; i < N_NETS; i++)
+        NeuralNetDestroy(ann + i);
+
+    g_rand_free(pr);
+    g_free(ai);
+    g_array_free(pa, TRUE);
+    g_mutex_clear(&tj.mutex);
+    g_cond_clear(&tj.cond);
+
+    return 0;
+}